@@ -9,6 +9,8 @@
  */
 
 #include <common.h>
+#include <div64.h>
+#include <asm/barriers.h>
 #include <asm/system.h>
 #include <asm/armv8/mmu.h>
 
@@ -444,12 +446,153 @@ inline void flush_dcache_all(void)
 		pr_debug("flushing dcache successfully.\n");
 }
 
+enum {
+	DCACHE_OP_FLUSH,
+	DCACHE_OP_INVALIDATE,
+	DCACHE_OP_COUNT,
+};
+
+#ifdef CONFIG_ARMV8_DCACHE_STATS
+struct dcache_stat {
+	ulong calls;
+	ulong full;		/* done on the whole cache */
+	u64 bytes;
+	u64 ticks;
+};
+
+/* In .data, cache maintenance runs before BSS is usable */
+static struct dcache_stat dcache_stats[DCACHE_OP_COUNT] __section(".data");
+
+static inline u64 dcache_stat_start(void)
+{
+	return get_ticks();
+}
+
+static void dcache_stat_add(int op, u64 start, ulong bytes, bool full)
+{
+	struct dcache_stat *st = &dcache_stats[op];
+
+	st->calls++;
+	st->full += full;
+	st->bytes += bytes;
+	st->ticks += get_ticks() - start;
+}
+
+void dcache_stats_show(void)
+{
+	static const char *const names[DCACHE_OP_COUNT] = {
+		"flush", "invalidate",
+	};
+	ulong rate = get_tbclk() / 1000000 ? : 1;
+	int i;
+
+	printf("%-10s %10s %8s %12s %10s\n", "Op", "Calls", "Whole",
+	       "Bytes", "Time(us)");
+	for (i = 0; i < DCACHE_OP_COUNT; i++)
+		printf("%-10s %10lu %8lu %12llu %10llu\n", names[i],
+		       dcache_stats[i].calls, dcache_stats[i].full,
+		       dcache_stats[i].bytes,
+		       lldiv(dcache_stats[i].ticks, rate));
+}
+
+void dcache_stats_reset(void)
+{
+	memset(dcache_stats, 0, sizeof(dcache_stats));
+}
+#else
+static inline u64 dcache_stat_start(void)
+{
+	return 0;
+}
+
+static inline void dcache_stat_add(int op, u64 start, ulong bytes, bool full)
+{
+}
+#endif
+
+/*
+ * Whether set/way maintenance is safe: it only reaches the caches of the
+ * CPU running it, so not while others run U-Boot code.
+ */
+__weak bool dcache_flush_all_allowed(void)
+{
+	return true;
+}
+
+static bool dcache_use_flush_all(ulong size)
+{
+	return CONFIG_ARMV8_DCACHE_FLUSH_ALL_SIZE &&
+	       size >= CONFIG_ARMV8_DCACHE_FLUSH_ALL_SIZE &&
+	       dcache_flush_all_allowed();
+}
+
+static inline ulong dcache_line_size(void)
+{
+	ulong ctr;
+
+	asm volatile("mrs %0, ctr_el0" : "=r" (ctr));
+
+	return 4UL << ((ctr >> 16) & 0xf);
+}
+
+/* Cache maintenance of @count ranges, with no barrier */
+static void dcache_ranges_op(const struct dcache_range *ranges, int count,
+			     int op)
+{
+	ulong line = dcache_line_size();
+	ulong addr;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		addr = ranges[i].start & ~(line - 1);
+		if (op == DCACHE_OP_FLUSH) {
+			for (; addr < ranges[i].stop; addr += line)
+				asm volatile("dc civac, %0" : : "r" (addr)
+					     : "memory");
+		} else {
+			for (; addr < ranges[i].stop; addr += line)
+				asm volatile("dc ivac, %0" : : "r" (addr)
+					     : "memory");
+		}
+	}
+}
+
+static void dcache_ranges(const struct dcache_range *ranges, int count, int op)
+{
+	u64 start = dcache_stat_start();
+	ulong size = 0;
+	bool full;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (ranges[i].stop > ranges[i].start)
+			size += ranges[i].stop - ranges[i].start;
+	}
+
+	full = dcache_use_flush_all(size);
+	if (full) {
+		flush_dcache_all();
+	} else if (count == 1 && op == DCACHE_OP_FLUSH) {
+		__asm_flush_dcache_range(ranges->start, ranges->stop);
+	} else if (count == 1) {
+		__asm_invalidate_dcache_range(ranges->start, ranges->stop);
+	} else {
+		dcache_ranges_op(ranges, count, op);
+		dsb();
+		isb();
+	}
+
+	dcache_stat_add(op, start, size, full);
+}
+
 /*
  * Invalidates range in all levels of D-cache/unified cache
  */
 void invalidate_dcache_range(unsigned long start, unsigned long stop)
 {
-	__asm_invalidate_dcache_range(start, stop);
+	struct dcache_range range = { start, stop };
+
+	dcache_ranges(&range, 1, DCACHE_OP_INVALIDATE);
 }
 
 /*
@@ -457,7 +600,27 @@ void invalidate_dcache_range(unsigned long start, unsigned long stop)
  */
 void flush_dcache_range(unsigned long start, unsigned long stop)
 {
-	__asm_flush_dcache_range(start, stop);
+	struct dcache_range range = { start, stop };
+
+	dcache_ranges(&range, 1, DCACHE_OP_FLUSH);
+}
+
+/*
+ * Invalidate several ranges, e.g. the buffers of a scatter list, with one
+ * barrier for all of them
+ */
+void invalidate_dcache_ranges(const struct dcache_range *ranges, int count)
+{
+	dcache_ranges(ranges, count, DCACHE_OP_INVALIDATE);
+}
+
+/*
+ * Flush several ranges, e.g. the buffers and descriptors of a scatter
+ * list, with one barrier for all of them
+ */
+void flush_dcache_ranges(const struct dcache_range *ranges, int count)
+{
+	dcache_ranges(ranges, count, DCACHE_OP_FLUSH);
 }
 
 void dcache_enable(void)
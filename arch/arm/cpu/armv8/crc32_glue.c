@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * crc32_glue.c - CRC32 and CRC32C using the ARMv8 CRC32 instructions
+ *
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd
+ */
+
+#include <common.h>
+#include <asm/system.h>
+#include <u-boot/crc.h>
+
+extern uint32_t crc32_armv8_le(uint32_t crc, const void *data, size_t len);
+extern uint32_t crc32c_armv8_le(uint32_t crc, const void *data, size_t len);
+
+/* Optional in ARMv8.0, though all of the Cortex-A cores implement it */
+static bool crc32_armv8_supported(void)
+{
+	return (read_id_aa64isar0() >> ID_AA64ISAR0_CRC32_SHIFT) & 0xf;
+}
+
+uint32_t crc32_no_comp(uint32_t crc, const unsigned char *buf, uint len)
+{
+	if (crc32_armv8_supported())
+		return crc32_armv8_le(crc, buf, len);
+
+	return crc32_no_comp_generic(crc, buf, len);
+}
+
+#ifdef CONFIG_CRC32C
+/* Bit-reflected CRC32C polynomial, which crc32c_init() puts at [128] */
+#define CRC32C_POLY_LE	0x82f63b78
+
+uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
+		    uint32_t *crc32c_table)
+{
+	if (crc32_armv8_supported() && crc32c_table[128] == CRC32C_POLY_LE)
+		return crc32c_armv8_le(crc, data, length);
+
+	return crc32c_cal_generic(crc, data, length, crc32c_table);
+}
+#endif
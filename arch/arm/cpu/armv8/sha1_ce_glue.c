@@ -6,16 +6,26 @@
  */
 
 #include <common.h>
+#include <asm/system.h>
 #include <u-boot/sha1.h>
 
 extern void sha1_armv8_ce_process(uint32_t state[5], uint8_t const *src,
 				  uint32_t blocks);
 
+/* The Crypto Extensions are optional, e.g. left out of some Cortex-A55s */
+static bool sha1_ce_supported(void)
+{
+	return (read_id_aa64isar0() >> ID_AA64ISAR0_SHA1_SHIFT) & 0xf;
+}
+
 void sha1_process(sha1_context *ctx, const unsigned char *data,
 		  unsigned int blocks)
 {
 	if (!blocks)
 		return;
 
-	sha1_armv8_ce_process(ctx->state, data, blocks);
+	if (sha1_ce_supported())
+		sha1_armv8_ce_process(ctx->state, data, blocks);
+	else
+		sha1_process_generic(ctx, data, blocks);
 }
@@ -6,16 +6,26 @@
  */
 
 #include <common.h>
+#include <asm/system.h>
 #include <u-boot/sha256.h>
 
 extern void sha256_armv8_ce_process(uint32_t state[8], uint8_t const *src,
 				    uint32_t blocks);
 
+static bool sha256_ce_supported(void)
+{
+	return ((read_id_aa64isar0() >> ID_AA64ISAR0_SHA2_SHIFT) & 0xf) >=
+		ID_AA64ISAR0_SHA2_SHA256;
+}
+
 void sha256_process(sha256_context *ctx, const unsigned char *data,
 		    unsigned int blocks)
 {
 	if (!blocks)
 		return;
 
-	sha256_armv8_ce_process(ctx->state, data, blocks);
+	if (sha256_ce_supported())
+		sha256_armv8_ce_process(ctx->state, data, blocks);
+	else
+		sha256_process_generic(ctx, data, blocks);
 }
@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * sha512_ce_glue.c - SHA-512 secure hash using ARMv8.2 Crypto Extensions
+ */
+
+#include <common.h>
+#include <asm/system.h>
+#include <u-boot/sha512.h>
+
+extern void sha512_armv8_ce_process(uint64_t state[8], uint8_t const *src,
+				    uint32_t blocks);
+
+/* SHA-512 is an ARMv8.2 addition, many v8.2 cores still leave it out */
+static bool sha512_ce_supported(void)
+{
+	return ((read_id_aa64isar0() >> ID_AA64ISAR0_SHA2_SHIFT) & 0xf) >=
+		ID_AA64ISAR0_SHA2_SHA512;
+}
+
+void sha512_process(sha512_context *ctx, const unsigned char *data,
+		    unsigned int blocks)
+{
+	if (!blocks)
+		return;
+
+	if (sha512_ce_supported())
+		sha512_armv8_ce_process(ctx->state, data, blocks);
+	else
+		sha512_process_generic(ctx, data, blocks);
+}
@@ -165,6 +165,28 @@ rockchip_get_cpu_settings(struct rockchip_cpu_rate_table *cpu_table,
 			  ulong rate);
 #endif
 
+#ifdef CONFIG_ROCKCHIP_CLK_PLL_BATCH
+/**
+ * rockchip_pll_batch_begin() - Set PLLs up without waiting for each to lock
+ *
+ * Until the matching rockchip_pll_batch_end(), rockchip_pll_set_rate()
+ * leaves each PLL in slow mode to lock while the next ones are set up, and
+ * rockchip_pll_get_rate() returns the rate it was set to. Nothing may be
+ * clocked from such a PLL until the batch ends. Batches may nest.
+ */
+void rockchip_pll_batch_begin(void);
+
+/**
+ * rockchip_pll_batch_end() - Wait for the PLLs of a batch to lock
+ *
+ * This switches them to normal mode, once the outermost batch ends.
+ */
+void rockchip_pll_batch_end(void);
+#else
+static inline void rockchip_pll_batch_begin(void) { }
+static inline void rockchip_pll_batch_end(void) { }
+#endif
+
 static inline int rk_pll_id(enum rk_clk_id clk_id)
 {
 	return clk_id - 1;
@@ -17,4 +17,74 @@ int fit_image_fail_process(const void *fit);
 int fit_image_read_dtb(void *fdt_addr);
 ulong fit_image_init_resource(struct blk_desc *dev_desc);
 
+#ifdef CONFIG_ROCKCHIP_FIT_DIGEST
+/*
+ * fit_digest_set_atags - pass the images SPL has verified on to U-Boot
+ *
+ * @bootdevice: BOOT_DEVICE_* the images were read from
+ *
+ * return: 0 on success, others failed.
+ */
+int fit_digest_set_atags(int bootdevice);
+
+/*
+ * fit_digest_add_source - note where a FIT buffer was read from
+ *
+ * Images inside @buf that SPL has already verified in the same place on
+ * @dev_desc are not hashed again.
+ *
+ * @buf: FIT buffer
+ * @size: size of @buf
+ * @dev_desc: device @buf was read from
+ * @offset: byte offset of @buf from the start of the device
+ */
+void fit_digest_add_source(const void *buf, size_t size,
+			   struct blk_desc *dev_desc, u64 offset);
+void fit_digest_del_source(const void *buf);
+
+/*
+ * fit_digest_hash_verified - check an image against the digests from SPL
+ *
+ * See board_fit_hash_verified().
+ */
+int fit_digest_hash_verified(const void *data, size_t size, const char *algo,
+			     const uint8_t *value, int value_len);
+#else
+static inline int fit_digest_set_atags(int bootdevice) { return 0; }
+static inline void fit_digest_add_source(const void *buf, size_t size,
+					 struct blk_desc *dev_desc,
+					 u64 offset) { }
+static inline void fit_digest_del_source(const void *buf) { }
+static inline int fit_digest_hash_verified(const void *data, size_t size,
+					   const char *algo,
+					   const uint8_t *value,
+					   int value_len) { return 0; }
+#endif
+
+#ifdef CONFIG_ROCKCHIP_FIT_STREAM_VERIFY
+/*
+ * fit_stream_is_loaded - check if an image was read to its load address
+ *
+ * fit_image_pre_process() reads the fdt, kernel and ramdisk of a FIT on
+ * storage straight to their load address, hashing them on the way, and
+ * leaves their place in the FIT buffer empty.
+ *
+ * @data: image data in the FIT buffer, from fit_image_get_data()
+ * @size: size of @data
+ * @load: load address of the image
+ *
+ * return: true if the image is at @load already.
+ */
+bool fit_stream_is_loaded(const void *data, size_t size, ulong load);
+
+/*
+ * fit_stream_reset - forget the images read by an earlier boot attempt
+ */
+void fit_stream_reset(void);
+#else
+static inline bool fit_stream_is_loaded(const void *data, size_t size,
+					ulong load) { return false; }
+static inline void fit_stream_reset(void) { }
+#endif
+
 #endif
@@ -12,6 +12,7 @@ enum hotkey_t {
 	HK_CLI_OS_PRE,
 	HK_CLI_OS_GO,
 	HK_CMDLINE,
+	HK_CONSOLE_VERBOSE,
 	HK_FASTBOOT,
 	HK_FDT,
 	HK_INITCALL,
@@ -10,4 +10,11 @@
 void putc_to_ram(const char c);
 void puts_to_ram(const char *str);
 
+/**
+ * pstore_replay() - hand the log of this stage to a function
+ *
+ * @out:	Called with each character recorded, oldest first
+ */
+void pstore_replay(void (*out)(const char c));
+
 #endif
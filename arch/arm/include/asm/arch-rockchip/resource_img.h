@@ -22,6 +22,7 @@ struct resource_file {
 	uint32_t	size;		/* in byte */
 	bool		in_ram;
 	struct list_head link;
+	struct hlist_node hnode;
 };
 
 extern struct list_head entry_head;
@@ -48,6 +49,29 @@ int resource_setup_ram_list(struct blk_desc *dev_desc, void *hdr);
  */
 int rockchip_read_resource_file(void *buf, const char *name, int blk_offset, int len);
 
+/*
+ * rockchip_get_resource_file_size() - get the size of a file in resource.
+ *
+ * @name: file name
+ *
+ * return the size(by bytes) of the file, or negative on error.
+ */
+int rockchip_get_resource_file_size(const char *name);
+
+/*
+ * rockchip_get_resource_file_data() - use a file in memory without a copy.
+ *
+ * The files of a resource image in memory, and the ones preloaded with the
+ * entries when the image is on the block device, need not be read again.
+ *
+ * @name: file name
+ * @len: returns the size(by bytes) of the file
+ *
+ * return the file data, or NULL if the file must be read by
+ * rockchip_read_resource_file().
+ */
+const void *rockchip_get_resource_file_data(const char *name, int *len);
+
 /*
  * rockchip_read_resource_dtb() - read dtb file
  *
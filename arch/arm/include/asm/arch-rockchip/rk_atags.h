@@ -22,6 +22,11 @@
 #define ATAG_BOOT1_PARAM	0x54410058
 #define ATAG_PSTORE		0x54410059
 #define ATAG_FWVER		0x5441005a
+#define ATAG_FIT_DIGEST		0x5441005b
+#define ATAG_MTD_BBT		0x5441005c
+#define ATAG_MMC		0x5441005d
+#define ATAG_AMP		0x5441005e
+#define ATAG_AB			0x5441005f
 #define ATAG_MAX		0x544100ff
 
 /* Tag size and offset */
@@ -84,6 +89,21 @@
 /* tag_fwver.ver[fwid][] */
 #define FWVER_LEN		36
 
+/* tag_fit_digest.digest[] */
+#define FIT_DIGEST_MAX		8
+#define FIT_DIGEST_LEN		32	/* sha256 */
+
+/* tag_mtd_bbt.bad[] */
+#define MTD_BBT_MAX_BAD		128
+
+/* tag_amp.cpu[] */
+#define AMP_CPU_MAX		4
+#define AMP_NAME_LEN		16
+
+/* tag_ab.ab_data[], a struct AvbABData */
+#define AB_DATA_LEN		32
+#define AB_FLG_DIRTY		(1 << 0)	/* not on the device yet */
+
 enum fwid {
 	FW_DDR,
 	FW_SPL,
@@ -206,6 +226,94 @@ struct tag_fwver {
 	u32 hash;
 } __packed;
 
+/*
+ * Images whose hashes were verified by a pre-loader, so they need not be
+ * hashed again if read from the same place on the boot device.
+ */
+struct tag_fit_digest {
+	u32 version;
+	u32 devtype;	/* tag_bootdev.devtype the images were read from */
+	u32 count;
+	u32 reserved[3];
+	struct {
+		u64 offset;	/* bytes from the start of the device */
+		u32 size;
+		u32 reserved;
+		u8 sha256[FIT_DIGEST_LEN];
+	} digest[FIT_DIGEST_MAX];
+	u32 hash;
+} __packed;
+
+/*
+ * Bad blocks of the whole mtd_blk device SPL booted from, so that U-Boot
+ * need not check the bad block markers again to build its map table.
+ */
+struct tag_mtd_bbt {
+	u32 version;
+	u32 devnum;	/* BLK_MTD_NAND or BLK_MTD_SPI_NAND */
+	u32 blk_total;
+	u32 erasesize;
+	u32 count;
+	u32 reserved[3];
+	u32 bad[MTD_BBT_MAX_BAD];	/* ascending block numbers */
+	u32 hash;
+} __packed;
+
+/*
+ * The eMMC as SPL left it, so that U-Boot can go on in the mode SPL
+ * selected rather than set the card up again from CMD0.
+ */
+struct tag_mmc {
+	u32 version;
+	u32 reg;	/* base address of the host */
+	u32 rca;
+	u32 ocr;
+	u32 cid[4];
+	u32 csd[4];
+	u32 high_capacity;
+	u32 timing;	/* MMC_TIMING_* */
+	u32 bus_width;
+	u32 clock;
+	u32 card_caps;
+	u32 reserved[3];
+	u8 ext_csd[512];
+	u32 hash;
+} __packed;
+
+/*
+ * Firmwares SPL has loaded and verified for non-boot cpus, so that U-Boot
+ * can start the cpus before it relocates and leave the memory alone.
+ */
+struct tag_amp {
+	u32 version;
+	u32 count;
+	u32 reserved[4];
+	struct {
+		u32 cpu;	/* mpidr */
+		u32 pe_state;	/* PE_STATE() */
+		u32 entry;
+		u32 load;
+		u32 size;
+		u32 udelay;	/* after the cpu is started */
+		char name[AMP_NAME_LEN];
+	} cpu[AMP_CPU_MAX];
+	u32 hash;
+} __packed;
+
+/*
+ * The A/B metadata of misc as SPL read, checked and maybe reset it, so
+ * that U-Boot need not read and check it again.
+ */
+struct tag_ab {
+	u32 version;
+	u32 flags;	/* AB_FLG_* */
+	u64 dev_lba;	/* size of the device, with misc_start the key */
+	u64 misc_start;
+	u32 reserved[2];
+	u8 ab_data[AB_DATA_LEN];	/* CPU byte order, crc32 included */
+	u32 hash;
+} __packed;
+
 struct tag_core {
 	u32 flags;
 	u32 pagesize;
@@ -233,6 +341,11 @@ struct tag {
 		struct tag_boot1p	boot1p;
 		struct tag_pstore	pstore;
 		struct tag_fwver	fwver;
+		struct tag_fit_digest	fit_digest;
+		struct tag_mtd_bbt	mtd_bbt;
+		struct tag_mmc		mmc;
+		struct tag_amp		amp;
+		struct tag_ab		ab;
 	} u;
 } __aligned(4);
 
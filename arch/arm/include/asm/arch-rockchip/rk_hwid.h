@@ -11,6 +11,41 @@
 #define KEY_WORDS_ADC_CH	"_ch"
 #define KEY_WORDS_GPIO		"#gpio"
 
+/*
+ * hwid index: the conditions of all hwid dtbs in resource.img, parsed from
+ * their file names by resource_tool at pack time. Little endian.
+ */
+#define HWID_INDEX_FILE		"hwid-dtb.idx"
+#define HWID_INDEX_MAGIC	"HWID"
+#define HWID_INDEX_VERSION	0
+#define HWID_INDEX_MAX_CONDS	8
+
+/* hwid_index_cond.type */
+#define HWID_COND_ADC		1
+#define HWID_COND_GPIO		2
+
+struct hwid_index_cond {
+	char		adc_ctrl[32];	/* adc controller name */
+	uint8_t		type;
+	uint8_t		id;		/* adc channel, or gpio port */
+	uint8_t		bank;		/* gpio only */
+	uint8_t		pin;		/* gpio only */
+	uint32_t	value;		/* adc value, or gpio level */
+};
+
+struct hwid_index_dtb {
+	char		name[220];	/* entry name in resource.img */
+	uint32_t	nr_conds;
+	struct hwid_index_cond conds[HWID_INDEX_MAX_CONDS];
+};
+
+struct hwid_index_hdr {
+	char		magic[4];
+	uint16_t	version;
+	uint16_t	nr_dtbs;
+	struct hwid_index_dtb dtbs[0];
+};
+
 /*
  * hwid_init_data() - init data about hwid.
  *
@@ -26,4 +61,18 @@ void hwid_init_data(void);
  */
 bool hwid_dtb_is_available(const char *file_name);
 
+/*
+ * hwid_index_find_dtb() - find dtb by HW(adc or gpio) from a hwid index.
+ *
+ * Same result as hwid_dtb_is_available() on each dtb in turn, but without
+ * parsing any file names.
+ *
+ * @index: content of HWID_INDEX_FILE
+ * @size: size of @index
+ * @name: returns the name of the matching dtb, NULL if none matches
+ *
+ * return 0 on success, -EINVAL if @index is invalid.
+ */
+int hwid_index_find_dtb(const void *index, int size, const char **name);
+
 #endif /* __RK_HWID_H_ */
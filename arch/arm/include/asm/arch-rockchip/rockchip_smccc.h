@@ -227,6 +227,16 @@ int psci_cpu_on(unsigned long cpuid, unsigned long entry_point);
  */
 int psci_cpu_off(uint32_t state);
 
+/*
+ * psci_affinity_info() - Standard ARM PSCI affinity info call.
+ *
+ * @cpuid:		cpu id
+ * @level:		lowest affinity level, 0 for a single cpu
+ *
+ * @return PSCI_AFFINITY_LEVEL_ON/OFF/ON_PENDING, otherwise failed.
+ */
+int psci_affinity_info(unsigned long cpuid, unsigned long level);
+
 #ifdef CONFIG_ARM_CPU_SUSPEND
 /*
  * psci_system_suspend() - Standard ARM PSCI system suspend call.
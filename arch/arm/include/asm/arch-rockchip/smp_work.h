@@ -0,0 +1,141 @@
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:     GPL-2.0+
+ */
+
+#ifndef __ASM_ARCH_SMP_WORK_H
+#define __ASM_ARCH_SMP_WORK_H
+
+#define SMP_WORK_MAX_CPUS		8
+
+/* struct smp_work_slot layout, used by smp_work_entry with the MMU off */
+#define SMP_WORK_SLOT_MPIDR		0
+#define SMP_WORK_SLOT_SP		8
+#define SMP_WORK_SLOT_GD		16
+#define SMP_WORK_SLOT_SIZE		64
+
+#ifndef __ASSEMBLY__
+/**
+ * typedef smp_work_fn - Work function run by smp_work_run()
+ *
+ * @arg:	Argument given to smp_work_run()
+ * @cpu:	Index of the CPU running the function, 0 is the boot CPU
+ * @nr_cpus:	Number of CPUs running the function
+ */
+typedef void (*smp_work_fn)(void *arg, int cpu, int nr_cpus);
+
+struct smp_work_slot {
+	u64 mpidr;
+	u64 sp;
+	u64 gd;
+	int cpu;
+	int done;
+} __aligned(SMP_WORK_SLOT_SIZE);
+
+/**
+ * typedef mp_task_fn - Task function run by the worker pool
+ *
+ * @arg:	Argument given to mp_task_submit()
+ */
+typedef void (*mp_task_fn)(void *arg);
+
+enum mp_task_state {
+	MP_TASK_IDLE,
+	MP_TASK_QUEUED,
+	MP_TASK_RUNNING,
+	MP_TASK_DONE,
+};
+
+/**
+ * struct mp_task - A unit of work for the worker pool
+ *
+ * The storage belongs to the caller and must stay valid until
+ * mp_task_wait() returned for it.
+ *
+ * @fn:		Function to run
+ * @arg:	Argument to pass to @fn
+ * @state:	enum mp_task_state
+ * @next:	Next task in the pool queue
+ */
+struct mp_task {
+	mp_task_fn fn;
+	void *arg;
+	int state;
+	struct mp_task *next;
+};
+
+/**
+ * mp_task_pool_start() - Bring up the secondary CPUs as pool workers
+ *
+ * All CPUs listed under /cpus in the U-Boot device tree that PSCI agrees to
+ * power on are started with their MMU and caches set up like the boot CPU,
+ * each on its own stack carved from sysmem. They then sleep in WFE until a
+ * task is queued. This is done on the first mp_task_submit() if not called
+ * before; calling it again does nothing.
+ *
+ * @return number of workers, 0 if there is none and tasks run inline
+ */
+int mp_task_pool_start(void);
+
+/**
+ * mp_task_pool_stop() - Drain the task queue and power the workers off
+ *
+ * Waits for all submitted tasks, then lets every worker call PSCI CPU_OFF
+ * and waits until PSCI reports it off, so the kernel can bring the CPUs up
+ * as usual. Must be called before leaving U-Boot.
+ */
+void mp_task_pool_stop(void);
+
+/**
+ * mp_task_submit() - Queue a task on the worker pool
+ *
+ * Tasks are taken in submission order by the first idle worker. Without
+ * workers @fn runs inline before this returns. @fn runs concurrently with
+ * the caller, so it must not use the console, malloc or anything else only
+ * the boot CPU may touch.
+ *
+ * @task:	Caller-owned task storage
+ * @fn:		Function to run
+ * @arg:	Argument to pass to @fn
+ */
+void mp_task_submit(struct mp_task *task, mp_task_fn fn, void *arg);
+
+/**
+ * mp_task_wait() - Wait until a task has run
+ *
+ * While the task is still queued the boot CPU runs queued tasks itself
+ * rather than spinning, so this never waits on a CPU that failed to start.
+ * A task that was never submitted counts as done.
+ *
+ * @task:	Task given to mp_task_submit()
+ */
+void mp_task_wait(struct mp_task *task);
+
+/**
+ * mp_task_wait_all() - Wait until every submitted task has run
+ */
+void mp_task_wait_all(void);
+
+
+/**
+ * smp_work_run() - Run a function on the boot CPU and the idle secondary CPUs
+ *
+ * @fn is called once for each CPU index, the boot CPU taking index 0 and
+ * the others going to the mp_task worker pool, so it runs concurrently on
+ * as many CPUs as the pool could start. The work should be split by the
+ * @cpu index.
+ *
+ * @fn runs concurrently on all CPUs, so it must not use the console, malloc
+ * or anything else only the boot CPU may touch.
+ *
+ * @fn:		Function to run
+ * @arg:	Argument to pass to @fn
+ * @return number of CPU indexes @fn was called for (1 if there is no worker)
+ */
+int smp_work_run(smp_work_fn fn, void *arg);
+
+void smp_work_entry(void);
+#endif
+
+#endif
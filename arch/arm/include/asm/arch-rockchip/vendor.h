@@ -25,6 +25,10 @@
 #define LAN_RGMII_DL_ID			16
 #define EINK_VCOM_ID			17
 #define FIRMWARE_VER_ID			18
+#define EDID_CACHE_ID			19	/* to 22, one per connector */
+#define EDID_CACHE_NUM			4
+#define MMC_TUNING_ID			23	/* to 24, one per card */
+#define MMC_TUNING_NUM			2
 
 struct vendor_item {
 	u16  id;
@@ -34,8 +38,11 @@ struct vendor_item {
 };
 
 int vendor_storage_test(void);
+int vendor_storage_ready(void);
 int vendor_storage_read(u16 id, void *pbuf, u16 size);
 int vendor_storage_write(u16 id, void *pbuf, u16 size);
+int vendor_storage_begin(void);
+int vendor_storage_commit(void);
 int flash_vendor_dev_ops_register(int (*read)(struct blk_desc *dev_desc,
 					      u32 sec,
 					      u32 n_sec,
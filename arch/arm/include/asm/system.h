@@ -179,6 +179,22 @@ static inline unsigned long read_mpidr(void)
 	return val;
 }
 
+/* ID_AA64ISAR0_EL1 fields */
+#define ID_AA64ISAR0_SHA1_SHIFT		8
+#define ID_AA64ISAR0_SHA2_SHIFT		12
+#define ID_AA64ISAR0_SHA2_SHA256	1
+#define ID_AA64ISAR0_SHA2_SHA512	2
+#define ID_AA64ISAR0_CRC32_SHIFT	16
+
+static inline unsigned long read_id_aa64isar0(void)
+{
+	unsigned long val;
+
+	asm volatile("mrs %0, id_aa64isar0_el1" : "=r" (val));
+
+	return val;
+}
+
 static inline unsigned long get_daif(void)
 {
 	unsigned long daif;
@@ -21,6 +21,8 @@
 #include <u-boot/zlib.h>
 #include <asm/byteorder.h>
 #include <linux/libfdt.h>
+#include <linux/mtd/ubi.h>
+#include <malloc_track.h>
 #include <mapmem.h>
 #include <mp_boot.h>
 #include <fdt_support.h>
@@ -90,11 +92,19 @@ static void announce_and_cleanup(bootm_headers_t *images, int fake)
 #ifdef CONFIG_BOOTSTAGE_REPORT
 	bootstage_report();
 #endif
+#if CONFIG_IS_ENABLED(MALLOC_TRACK)
+	malloc_track_dump(10);
+#endif
 
 #ifdef CONFIG_USB_DEVICE
 	udc_disconnect();
 #endif
 
+#ifdef CONFIG_MTD_UBI_FASTMAP
+	/* Let the kernel attach UBI by fastmap too */
+	ubi_sync_fastmap();
+#endif
+
 	board_quiesce_devices(images);
 
 	/* Flush all console data */
@@ -46,6 +46,23 @@ __weak void flush_dcache_range(unsigned long start, unsigned long stop)
 	/* An empty stub, real implementation should be in platform code */
 }
 
+__weak void flush_dcache_ranges(const struct dcache_range *ranges, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		flush_dcache_range(ranges[i].start, ranges[i].stop);
+}
+
+__weak void invalidate_dcache_ranges(const struct dcache_range *ranges,
+				     int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+		invalidate_dcache_range(ranges[i].start, ranges[i].stop);
+}
+
 int check_cache_range(unsigned long start, unsigned long stop)
 {
 	int ok = 1;
@@ -22,6 +22,8 @@
  */
 
 #include <common.h>
+#include <android_ab.h>
+#include <blk.h>
 
 __weak void reset_misc(void)
 {
@@ -31,6 +33,9 @@ int do_reset(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	puts ("resetting ...\n");
 
+	android_misc_flush();
+	blkcache_flush_all();
+
 	udelay (50000);				/* wait 50 ms */
 
 	disable_interrupts();
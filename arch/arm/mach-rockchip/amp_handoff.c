@@ -0,0 +1,175 @@
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:     GPL-2.0+
+ *
+ * SPL loads and verifies the firmwares of amp.img for the non-boot cpus
+ * right after DDR init, and passes them on in ATAG_AMP. The cpus can't be
+ * started by SPL, which runs before the trust, so U-Boot starts them first
+ * thing, before relocation and DM init, instead of in amp_cpus_on(). The
+ * memory of the firmwares is reserved, so neither U-Boot nor Linux (whose
+ * /memory is fixed up from bidram) touch it.
+ */
+
+#include <common.h>
+#include <amp.h>
+#include <bidram.h>
+#include <fdtdec.h>
+#include <image.h>
+#include <spl.h>
+#include <asm/arch/rk_atags.h>
+#include <asm/arch/rockchip_smccc.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#ifdef CONFIG_SPL_BUILD
+static struct tag_amp amp_handoff;
+
+/* The cpus of the os amp-dispatcher are started by Linux */
+static bool amp_handoff_dispatcher_cpu(u32 cpu)
+{
+	const void *fdt = gd->fdt_blob;
+	int node, subnode;
+
+	node = fdt_path_offset(fdt, "/rockchip-amp");
+	if (node < 0 || !fdtdec_get_is_enabled(fdt, node))
+		return false;
+
+	node = fdt_subnode_offset(fdt, node, "amp-cpus");
+	if (node < 0)
+		return false;
+
+	fdt_for_each_subnode(subnode, fdt, node) {
+		if (fdtdec_get_uint64(fdt, subnode, "id", 0xffffffff) == cpu)
+			return true;
+	}
+
+	return false;
+}
+
+bool amp_handoff_wanted(const void *fit, int node)
+{
+	u32 cpu;
+	u8 type;
+
+	if (amp_handoff.count >= AMP_CPU_MAX)
+		return false;
+
+	/* Linux, standalones and the boot cpu are left to U-Boot */
+	if (fit_image_get_type(fit, node, &type) || type != IH_TYPE_FIRMWARE)
+		return false;
+	if (!fdt_getprop(fit, node, "description", NULL) ||
+	    !fdt_getprop(fit, node, "cpu", NULL) ||
+	    !fdt_getprop(fit, node, "load", NULL))
+		return false;
+	if (!fdtdec_get_int(fit, node, "boot-on", 1))
+		return false;
+
+	cpu = fdtdec_get_uint(fit, node, "cpu", 0);
+	if ((read_mpidr() & 0x0fff) == cpu)
+		return false;
+
+	return !amp_handoff_dispatcher_cpu(cpu);
+}
+
+void amp_handoff_add(const void *fit, int node, struct spl_image_info *image)
+{
+	u32 aarch64, hyp, thumb;
+	u8 arch = IH_ARCH_DEFAULT;
+	int i = amp_handoff.count;
+
+	if (i >= AMP_CPU_MAX)
+		return;
+
+	fit_image_get_arch(fit, node, &arch);
+	aarch64 = (arch == IH_ARCH_ARM) ? 0 : 1;
+	hyp = fdtdec_get_uint(fit, node, "hyp", 0);
+	thumb = fdtdec_get_uint(fit, node, "thumb", 0);
+
+	amp_handoff.cpu[i].cpu = fdtdec_get_uint(fit, node, "cpu", 0);
+	amp_handoff.cpu[i].pe_state = PE_STATE(aarch64, hyp, thumb, 0);
+	amp_handoff.cpu[i].entry = image->load_addr;
+	amp_handoff.cpu[i].load = image->load_addr;
+	amp_handoff.cpu[i].size = image->size;
+	amp_handoff.cpu[i].udelay = fdtdec_get_uint(fit, node, "udelay", 0);
+	strlcpy(amp_handoff.cpu[i].name,
+		fdt_getprop(fit, node, "description", NULL), AMP_NAME_LEN);
+	amp_handoff.count++;
+}
+
+int amp_handoff_set_atags(void)
+{
+	if (!amp_handoff.count)
+		return 0;
+
+	return atags_set_tag(ATAG_AMP, &amp_handoff);
+}
+#else
+/* Set before relocation, so not in bss */
+static struct tag_amp *amp_handoff __section(".data");
+static u32 amp_handoff_up __section(".data");	/* bit n: cpu[n] is up */
+
+static bool is_default_pe_state(u32 pe_state)
+{
+#ifdef CONFIG_ARM64
+	return pe_state == PE_STATE(1, 1, 0, 0);
+#else
+	return pe_state == PE_STATE(0, 0, 0, 0);
+#endif
+}
+
+void amp_handoff_cpus_on(void)
+{
+	struct tag *t;
+	int i;
+
+	t = atags_get_tag(ATAG_AMP);
+	if (!t || t->u.amp.count > AMP_CPU_MAX)
+		return;
+
+	/* No console yet, amp_cpus_on() tells how it went */
+	amp_handoff = &t->u.amp;
+	for (i = 0; i < amp_handoff->count; i++) {
+		if (!is_default_pe_state(amp_handoff->cpu[i].pe_state) &&
+		    sip_smc_amp_cfg(AMP_PE_STATE, amp_handoff->cpu[i].cpu,
+				    amp_handoff->cpu[i].pe_state, 0))
+			continue;
+		if (psci_cpu_on(amp_handoff->cpu[i].cpu,
+				amp_handoff->cpu[i].entry))
+			continue;
+
+		amp_handoff_up |= BIT(i);
+		if (amp_handoff->cpu[i].udelay)
+			udelay(amp_handoff->cpu[i].udelay);
+	}
+}
+
+int amp_handoff_reserve(void)
+{
+	int i, ret;
+
+	for (i = 0; amp_handoff && i < amp_handoff->count; i++) {
+		if (!(amp_handoff_up & BIT(i)))
+			continue;
+		ret = bidram_reserve_by_name(amp_handoff->cpu[i].name,
+					     amp_handoff->cpu[i].load,
+					     amp_handoff->cpu[i].size);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+int amp_handoff_cpu(u32 cpu)
+{
+	int i;
+
+	for (i = 0; amp_handoff && i < amp_handoff->count; i++) {
+		if (amp_handoff->cpu[i].cpu == cpu)
+			return (amp_handoff_up & BIT(i)) ? 0 : -EIO;
+	}
+
+	return -ENOENT;
+}
+#endif
@@ -9,6 +9,7 @@
 #include <abuf.h>
 #include <amp.h>
 #include <android_ab.h>
+#include <cmdline.h>
 #include <android_bootloader.h>
 #include <android_image.h>
 #include <bidram.h>
@@ -52,6 +53,7 @@
 #include <asm/arch/periph.h>
 #include <asm/arch/resource_img.h>
 #include <asm/arch/rk_atags.h>
+#include <asm/arch/smp_work.h>
 #include <asm/arch/vendor.h>
 #ifdef CONFIG_ROCKCHIP_EINK_DISPLAY
 #include <rk_eink.h>
@@ -472,6 +474,10 @@ int board_late_init(void)
 	rk_minidump_init();
 #endif
 
+#ifdef CONFIG_ROCKCHIP_VENDOR_PARTITION
+	/* One vendor write for the EDID caches of all connectors */
+	vendor_storage_begin();
+#endif
 #ifdef CONFIG_DRM_ROCKCHIP
 	if (rockchip_get_boot_mode() != BOOT_MODE_QUIESCENT)
 		rockchip_show_logo();
@@ -479,6 +485,10 @@ int board_late_init(void)
 #ifdef CONFIG_ROCKCHIP_EINK_DISPLAY
 	rockchip_eink_show_uboot_logo();
 #endif
+#ifdef CONFIG_ROCKCHIP_VENDOR_PARTITION
+	if (vendor_storage_commit())
+		printf("%s: vendor_storage_commit failed\n", __func__);
+#endif
 #if (CONFIG_ROCKCHIP_BOOT_MODE_REG > 0)
 	setup_boot_mode();
 #endif
@@ -520,6 +530,7 @@ static void board_debug_init(void)
 		gd->console_evt = getc();
 		if (gd->console_evt <= 0x1a) /* 'z' */
 			printf("Hotkey: ctrl+%c\n", gd->console_evt + 'a' - 1);
+		hotkey_run(HK_CONSOLE_VERBOSE);
 	}
 
 	if (IS_ENABLED(CONFIG_CONSOLE_DISABLE_CLI))
@@ -549,6 +560,7 @@ int board_init(void)
 #endif
 	set_armclk_rate();
 #ifdef CONFIG_DM_DVFS
+	boot_dvfs_raise();
 	dvfs_init(true);
 #endif
 #ifdef CONFIG_ANDROID_AB
@@ -799,6 +811,11 @@ int board_bidram_reserve(struct bidram *bidram)
 	if (ret)
 		return ret;
 
+	/* AMP firmwares SPL loaded, their cpus are up */
+	ret = amp_handoff_reserve();
+	if (ret)
+		return ret;
+
 	return 0;
 }
 
@@ -833,6 +850,7 @@ int board_init_f_boot_flags(void)
 	param_parse_pstore();
 #endif
 	param_parse_pre_serial(&boot_flags);
+	amp_handoff_cpus_on();
 
 	/* The highest priority to turn off (override) console */
 #if defined(CONFIG_DISABLE_CONSOLE)
@@ -1175,6 +1193,15 @@ void board_quiesce_devices(void *images)
 		       orig_images_ep, bootm_images->ep);
 	}
 #endif
+#ifdef CONFIG_ROCKCHIP_SMP_WORK
+	/* All offloaded work is done, hand the secondary CPUs to the kernel */
+	mp_task_pool_stop();
+#endif
+	rockchip_display_sync();
+#ifdef CONFIG_DM_DVFS
+	/* Linux starts its cpufreq from the rate the loader left */
+	boot_dvfs_restore();
+#endif
 
 	hotkey_run(HK_CMDLINE);
 	hotkey_run(HK_CLI_OS_GO);
@@ -1220,7 +1247,7 @@ int board_rng_seed(struct abuf *buf)
 /*
  * Pass fwver when any available.
  */
-static void bootargs_add_fwver(bool verbose)
+static void bootargs_add_fwver(struct cmdline *cl, bool verbose)
 {
 #ifdef CONFIG_ROCKCHIP_PRELOADER_ATAGS
 	struct tag *t;
@@ -1276,7 +1303,7 @@ static void bootargs_add_fwver(bool verbose)
 		}
 		if (verbose)
 			printf("## fwver: %s\n\n", fwver);
-		env_update("bootargs", fwver);
+		cmdline_update(cl, fwver, NULL);
 		env_set("fwver", fwver + strlen("androidboot."));
 	}
 out:
@@ -1289,35 +1316,39 @@ out:
 #endif
 }
 
-static void bootargs_add_android(bool verbose)
+static void bootargs_add_android(struct cmdline *cl, bool verbose)
 {
 #ifdef CONFIG_ANDROID_AB
-	ab_update_root_partition();
+	ab_update_root_partition(cl);
 #endif
 
 	/* Android header v4+ need this handle */
 #ifdef CONFIG_ANDROID_BOOT_IMAGE
 	struct andr_img_hdr *hdr;
+	char *andr_bootargs;
 	char *fwver;
 
 	hdr = (void *)env_get_ulong("android_addr_r", 16, 0);
 	if (hdr && !android_image_check_header(hdr) && hdr->header_version >= 4) {
-		if (env_update_extract_subset("bootargs", "andr_bootargs", "androidboot."))
+		andr_bootargs = cmdline_extract(cl, "androidboot.");
+		if (!andr_bootargs)
 			printf("extract androidboot.xxx error\n");
+		env_set("andr_bootargs", andr_bootargs);
+		free(andr_bootargs);
 		if (verbose)
 			printf("## bootargs(android): %s\n\n", env_get("andr_bootargs"));
 
 		/* for kernel cmdline can be read */
 		fwver = env_get("fwver");
 		if (fwver) {
-			env_update("bootargs", fwver);
+			cmdline_update(cl, fwver, NULL);
 			env_set("fwver", NULL);
 		}
 	}
 #endif
 }
 
-static void bootargs_add_partition(bool verbose)
+static void bootargs_add_partition(struct cmdline *cl, bool verbose)
 {
 #if defined(CONFIG_ENVF) || defined(CONFIG_ENV_PARTITION)
 	char *part_type[] = { "mtdparts", "blkdevparts" };
@@ -1339,14 +1370,14 @@ static void bootargs_add_partition(bool verbose)
 		} else {
 			part_list = env;
 		}
-		env_update("bootargs", part_list);
+		cmdline_update(cl, part_list, NULL);
 		if (verbose)
 			printf("## parts: %s\n\n", part_list);
 	}
 
 	env = env_get("sys_bootargs");
 	if (env) {
-		env_update("bootargs", env);
+		cmdline_update(cl, env, NULL);
 		if (verbose)
 			printf("## sys_bootargs: %s\n\n", env);
 	}
@@ -1358,13 +1389,13 @@ static void bootargs_add_partition(bool verbose)
 
 		if (mtd_par_info) {
 			if (memcmp(env_get("devtype"), "mtd", 3) == 0)
-				env_update("bootargs", mtd_par_info);
+				cmdline_update(cl, mtd_par_info, NULL);
 		}
 	}
 #endif
 }
 
-static void bootargs_add_dtb_dtbo(void *fdt, bool verbose)
+static void bootargs_add_dtb_dtbo(struct cmdline *cl, void *fdt, bool verbose)
 {
 	/* bootargs_ext is used when dtbo is applied. */
 	const char *arr_bootargs[] = { "bootargs", "bootargs_ext" };
@@ -1392,9 +1423,9 @@ static void bootargs_add_dtb_dtbo(void *fdt, bool verbose)
 		 * to cmdline. The format is "roo=PARTUUID=xxxx...".
 		 */
 #ifdef CONFIG_ANDROID_AB
-		env_update_filter("bootargs", bootargs, "root=");
+		cmdline_update(cl, bootargs, "root=");
 #else
-		env_update("bootargs", bootargs);
+		cmdline_update(cl, bootargs, NULL);
 #endif
 	}
 }
@@ -1402,6 +1433,7 @@ static void bootargs_add_dtb_dtbo(void *fdt, bool verbose)
 char *board_fdt_chosen_bootargs(void *fdt)
 {
 	int verbose = is_hotkey(HK_CMDLINE);
+	struct cmdline cl;
 	const char *bootargs;
 
 	/* debug */
@@ -1409,16 +1441,25 @@ char *board_fdt_chosen_bootargs(void *fdt)
 	if (verbose)
 		printf("## bootargs(u-boot): %s\n\n", env_get("bootargs"));
 
-	bootargs_add_dtb_dtbo(fdt, verbose);
-	bootargs_add_partition(verbose);
-	bootargs_add_fwver(verbose);
-	bootargs_add_android(verbose);
+	/*
+	 * Merge everything as separate items and set "bootargs" once at the
+	 * end, rather than rewriting the whole variable for every item.
+	 */
+	if (cmdline_init(&cl, env_get("bootargs"))) {
+		cmdline_uninit(&cl);
+		return env_get("bootargs");
+	}
+
+	bootargs_add_dtb_dtbo(&cl, fdt, verbose);
+	bootargs_add_partition(&cl, verbose);
+	bootargs_add_fwver(&cl, verbose);
+	bootargs_add_android(&cl, verbose);
 
 	/*
 	 * Initrd fixup: remove unused "initrd=0x...,0x...",
 	 * this for compatible with legacy parameter.txt
 	 */
-	env_delete("bootargs", "initrd=", 0);
+	cmdline_delete(&cl, "initrd=");
 
 	/*
 	 * If uart is required to be disabled during
@@ -1434,7 +1475,12 @@ char *board_fdt_chosen_bootargs(void *fdt)
 	 * So let's remove earlycon from commandline.
 	 */
 	if (gd->flags & GD_FLG_DISABLE_CONSOLE)
-		env_delete("bootargs", "earlycon=", 0);
+		cmdline_delete(&cl, "earlycon=");
+
+	bootargs = cmdline_str(&cl);
+	if (bootargs)
+		env_set("bootargs", bootargs);
+	cmdline_uninit(&cl);
 
 	bootargs = env_get("bootargs");
 	if (verbose)
@@ -1447,12 +1493,13 @@ int ft_verify_fdt(void *fdt)
 {
 	/* for android header v4+, we load bootparams and fixup initrd */
 #if defined(CONFIG_ANDROID_BOOT_IMAGE) && defined(CONFIG_XBC)
+	struct BootConfigBuilder xbc;
 	struct andr_img_hdr *hdr;
 	uint64_t initrd_start, initrd_end;
-	char *bootargs, *p;
+	char *bootargs;
 	int nodeoffset;
 	int is_u64, err;
-	u32 len;
+	int len;
 
 	hdr = (void *)env_get_ulong("android_addr_r", 16, 0);
 	if (!hdr || android_image_check_header(hdr) ||
@@ -1463,13 +1510,6 @@ int ft_verify_fdt(void *fdt)
 	if (!bootargs)
 		return 1;
 
-	/* trans character: space to new line */
-	p = bootargs;
-	while (*p++) {
-		if (*p == ' ')
-			*p = '\n';
-	}
-
 	debug("## andr_bootargs: %s\n", bootargs);
 
 	/*
@@ -1478,15 +1518,18 @@ int ft_verify_fdt(void *fdt)
 	 * because we can get final full bootargs in board_fdt_chosen_bootargs(),
 	 * android_image_get_ramdisk() is early than that.
 	 *
-	 * we have to add boot params by now.
+	 * we have to add boot params by now, one per line, then the trailer.
 	 */
-	len = addBootConfigParameters((char *)bootargs, strlen(bootargs),
-		(u64)hdr->ramdisk_addr + hdr->ramdisk_size +
-		hdr->vendor_ramdisk_size, hdr->vendor_bootconfig_size);
-	if (len < 0) {
-		printf("error: addBootConfigParameters\n");
+	if (bootConfigBuilderInit(&xbc, (u64)hdr->ramdisk_addr +
+				  hdr->ramdisk_size + hdr->vendor_ramdisk_size,
+				  hdr->vendor_bootconfig_size,
+				  hdr->vendor_bootconfig_size +
+				  ANDROID_ADDITION_BOOTCONFIG_PARAMS_MAX_SIZE) ||
+	    bootConfigBuilderAddCmdline(&xbc, bootargs)) {
+		printf("error: add bootconfig params\n");
 		return 0;
 	}
+	len = bootConfigBuilderFinish(&xbc) - hdr->vendor_bootconfig_size;
 
 	nodeoffset = fdt_subnode_offset(fdt, 0, "chosen");
 	if (nodeoffset < 0) {
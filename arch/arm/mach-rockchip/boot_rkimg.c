@@ -6,6 +6,7 @@
 
 #include <common.h>
 #include <adc.h>
+#include <android_ab.h>
 #include <android_bootloader.h>
 #include <android_image.h>
 #include <bidram.h>
@@ -119,6 +120,10 @@ static void boot_devtype_init(void)
 	/* scan list */
 #ifdef CONFIG_MMC
 	mmc_initialize(gd->bd);
+#endif
+#ifdef CONFIG_MMC_PARALLEL_INIT
+	/* Identify all cards at once, the scan then takes them in order */
+	mmc_start_init_all();
 #endif
 	ret = rk_board_scan_bootdev();
 	if (ret) {
@@ -364,7 +369,10 @@ void board_run_recovery_wipe_data(void)
 #else
 	u32 bcb_offset = BCB_MESSAGE_BLK_OFFSET;
 #endif
-	int cnt, ret;
+#ifndef CONFIG_ANDROID_AB
+	int cnt;
+#endif
+	int ret;
 
 	printf("Rebooting into recovery to do wipe_data\n");
 	dev_desc = rockchip_get_bootdev();
@@ -384,10 +392,18 @@ void board_run_recovery_wipe_data(void)
 	strcpy(bmsg.command, "boot-recovery");
 	strcpy(bmsg.recovery, "recovery\n--wipe_data");
 	bmsg.status[0] = 0;
+#ifdef CONFIG_ANDROID_AB
+	ret = android_misc_write(dev_desc, &part_info,
+				 bcb_offset * dev_desc->blksz,
+				 sizeof(bmsg), &bmsg);
+	if (ret)
+		printf("Wipe data failed, ret=%d\n", ret);
+#else
 	cnt = DIV_ROUND_UP(sizeof(struct bootloader_message), dev_desc->blksz);
 	ret = blk_dwrite(dev_desc, part_info.start + bcb_offset, cnt, &bmsg);
 	if (ret != cnt)
 		printf("Wipe data failed, ret=%d\n", ret);
+#endif
 out:
 	/* now reboot to recovery */
 	env_set("reboot_mode", "recovery");
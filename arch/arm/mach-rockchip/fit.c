@@ -10,6 +10,10 @@
 #include <sysmem.h>
 #include <asm/arch/fit.h>
 #include <asm/arch/resource_img.h>
+#ifdef CONFIG_ROCKCHIP_FIT_STREAM_VERIFY
+#include <image-pipe.h>
+#include <linux/err.h>
+#endif
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -243,6 +247,261 @@ static int fit_image_fixup_alloc(const void *fit, const char *prop_name,
 	return 0;
 }
 
+#ifdef CONFIG_ROCKCHIP_FIT_STREAM_VERIFY
+/*
+ * The fdt, kernel and ramdisk are read from storage straight to their load
+ * address, a chunk at a time, and each chunk is hashed while the next one
+ * is read. bootm then finds each image where it would copy it to, and
+ * takes its hash from fit_streams[] instead of going over it again.
+ */
+#define FIT_STREAM_CHUNK		SZ_1M
+
+struct fit_stream {
+	const void *data;	/* place of the image in the FIT buffer */
+	size_t size;
+	ulong load;
+	const char *algo;	/* NULL if the image has no hash */
+	u8 value[FIT_MAX_HASH_LEN];
+	int value_len;
+};
+
+static const char * const fit_stream_props[] = {
+	FIT_FDT_PROP, FIT_KERNEL_PROP, FIT_RAMDISK_PROP,
+};
+
+static struct fit_stream fit_streams[ARRAY_SIZE(fit_stream_props)];
+static int fit_stream_count;
+static struct blk_desc *fit_stream_dev;
+static lbaint_t fit_stream_start;
+
+/*
+ * Read @size bytes from block @blk to @dst, which is where the data of @p
+ * starts, and run @p over each chunk while the next one is read. The last
+ * partial block goes through a bounce buffer so that nothing after
+ * @dst + @size is written.
+ */
+static int fit_stream_read(struct blk_desc *dev_desc, lbaint_t blk, u8 *dst,
+			   size_t size, struct img_pipe *p)
+{
+	lbaint_t chunk = FIT_STREAM_CHUNK / dev_desc->blksz;
+	lbaint_t total = size / dev_desc->blksz;
+	size_t tail = size % dev_desc->blksz;
+	size_t done_len = 0;
+	lbaint_t done = 0;
+	u8 *bounce;
+	ulong n;
+	int ret;
+
+	while (done < total) {
+		n = blk_dread_async(dev_desc, blk + done,
+				    min(chunk, total - done), dst + done_len);
+		if (!n || IS_ERR_VALUE(n))
+			return -EIO;
+		ret = img_pipe_feed(p, done_len);
+		if (blk_wait(dev_desc))
+			return -EIO;
+		if (ret)
+			return ret;
+
+		done += n;
+		done_len += n * dev_desc->blksz;
+	}
+
+	if (!tail)
+		return img_pipe_finish(p);
+
+	bounce = memalign(ARCH_DMA_MINALIGN, dev_desc->blksz);
+	if (!bounce)
+		return -ENOMEM;
+	if (blk_dread(dev_desc, blk + total, 1, bounce) != 1) {
+		free(bounce);
+		return -EIO;
+	}
+	memcpy(dst + done_len, bounce, tail);
+	free(bounce);
+
+	return img_pipe_finish(p);
+}
+
+/*
+ * Read an image to its load address. Returns -EAGAIN for one which bootm
+ * has to find in the FIT buffer: a compressed image, one with a signature
+ * or more than one hash, or the fdt when the kernel dtb is in use already.
+ */
+static int fit_stream_image(const void *fit, int noffset)
+{
+	struct fit_stream *s = &fit_streams[fit_stream_count];
+	struct img_hash_stage h;
+	struct img_pipe p;
+	const void *data;
+	int sub, nhash = 0;
+	ulong load, offset;
+	size_t size;
+	char *algo;
+	u8 comp;
+	int ret;
+
+	if (fit_image_get_data(fit, noffset, &data, &size) ||
+	    fit_image_get_load(fit, noffset, &load) ||
+	    fit_image_addr_is_placeholder(load))
+		return -EAGAIN;
+
+	if (!fit_image_get_comp(fit, noffset, &comp) && comp != IH_COMP_NONE)
+		return -EAGAIN;
+
+#ifdef CONFIG_USING_KERNEL_DTB
+	/* bootm takes the kernel dtb, which may be at the fdt load address */
+	if (fit_image_check_type(fit, noffset, IH_TYPE_FLATDT) &&
+	    (gd->flags & GD_FLG_KDTB_READY) && !gd->fdt_blob_kern)
+		return -EAGAIN;
+#endif
+
+	/* The FIT buffer holds the partition from its first block */
+	offset = (ulong)data - (ulong)fit;
+	if (offset < FIT_ALIGN(fdt_totalsize(fit)) ||
+	    offset % fit_stream_dev->blksz)
+		return -EAGAIN;
+
+	s->algo = NULL;
+	fdt_for_each_subnode(sub, fit, noffset) {
+		const char *name = fit_get_name(fit, sub, NULL);
+
+		if (!strncmp(name, FIT_SIG_NODENAME, strlen(FIT_SIG_NODENAME)))
+			return -EAGAIN;
+		if (strncmp(name, FIT_HASH_NODENAME, strlen(FIT_HASH_NODENAME)))
+			continue;
+		if (++nhash > 1 || fit_image_hash_get_algo(fit, sub, &algo))
+			return -EAGAIN;
+		s->algo = algo;
+	}
+	img_pipe_init(&p, (void *)load, size);
+	if (s->algo) {
+		if (img_hash_stage_init(&h, s->algo, size))
+			return -EAGAIN;
+		img_pipe_add(&p, &h.st);
+	}
+
+	ret = fit_stream_read(fit_stream_dev,
+			      fit_stream_start + offset / fit_stream_dev->blksz,
+			      (u8 *)load, size, &p);
+	if (ret)
+		return ret;
+
+	if (s->algo) {
+		s->value_len = h.value_len;
+		memcpy(s->value, h.value, h.value_len);
+	}
+
+	s->data = data;
+	s->size = size;
+	s->load = load;
+	fit_stream_count++;
+
+	return 0;
+}
+
+void fit_stream_reset(void)
+{
+	fit_stream_dev = NULL;
+	fit_stream_count = 0;
+}
+
+static int fit_stream_images(const void *fit)
+{
+	struct blk_desc *dev_desc = fit_stream_dev;
+	int i, noffset, ret = 0;
+	ulong offset;
+	lbaint_t blk, cnt;
+	const void *data;
+	size_t size;
+
+	if (!dev_desc)
+		return 0;
+
+	for (i = 0; i < ARRAY_SIZE(fit_stream_props); i++) {
+		noffset = fit_default_conf_get_node(fit, fit_stream_props[i]);
+		if (noffset < 0)
+			continue;
+
+		ret = fit_stream_image(fit, noffset);
+		if (ret != -EAGAIN)
+			goto next;
+
+		/* Fill in its place in the FIT buffer for bootm instead */
+		ret = fit_image_get_data(fit, noffset, &data, &size);
+		if (ret)
+			goto next;
+		offset = (ulong)data - (ulong)fit;
+		if (offset < FIT_ALIGN(fdt_totalsize(fit)))
+			goto next;	/* embedded, read with the FIT */
+		blk = offset / dev_desc->blksz;
+		cnt = DIV_ROUND_UP(offset + size, dev_desc->blksz) - blk;
+		if (blk_dread(dev_desc, fit_stream_start + blk, cnt,
+			      (void *)fit + blk * dev_desc->blksz) != cnt)
+			ret = -EIO;
+next:
+		if (ret) {
+			FIT_I("Failed to load %s, ret=%d\n",
+			      fit_stream_props[i], ret);
+			fit_stream_reset();
+			return ret;
+		}
+	}
+
+	fit_stream_dev = NULL;
+
+	return 0;
+}
+
+bool fit_stream_is_loaded(const void *data, size_t size, ulong load)
+{
+	int i;
+
+	for (i = 0; i < fit_stream_count; i++) {
+		if (fit_streams[i].data == data &&
+		    fit_streams[i].size == size &&
+		    fit_streams[i].load == load)
+			return true;
+	}
+
+	return false;
+}
+
+static int fit_stream_hash_verified(const void *data, size_t size,
+				    const char *algo, const uint8_t *value,
+				    int value_len)
+{
+	struct fit_stream *s;
+	int i;
+
+	for (i = 0; i < fit_stream_count; i++) {
+		s = &fit_streams[i];
+		if (s->data == data && s->size == size && s->algo &&
+		    !strcmp(s->algo, algo) && s->value_len == value_len &&
+		    !memcmp(s->value, value, value_len))
+			return 1;
+	}
+
+	return 0;
+}
+#else
+static inline int fit_stream_images(const void *fit) { return 0; }
+static inline int fit_stream_hash_verified(const void *data, size_t size,
+					   const char *algo,
+					   const uint8_t *value,
+					   int value_len) { return 0; }
+#endif
+
+#if defined(CONFIG_ROCKCHIP_FIT_DIGEST) || \
+    defined(CONFIG_ROCKCHIP_FIT_STREAM_VERIFY)
+int board_fit_hash_verified(const void *data, size_t size, const char *algo,
+			    const uint8_t *value, int value_len)
+{
+	return fit_stream_hash_verified(data, size, algo, value, value_len) ||
+	       fit_digest_hash_verified(data, size, algo, value, value_len);
+}
+#endif
+
 int fit_image_pre_process(const void *fit)
 {
 	int ret;
@@ -291,8 +550,12 @@ int fit_image_pre_process(const void *fit)
 	if (ret < 0)
 		return ret;
 
-	return fit_image_fixup_alloc(fit, FIT_RAMDISK_PROP,
-				     "ramdisk_addr_r", MEM_RAMDISK);
+	ret = fit_image_fixup_alloc(fit, FIT_RAMDISK_PROP,
+				    "ramdisk_addr_r", MEM_RAMDISK);
+	if (ret < 0)
+		return ret;
+
+	return fit_stream_images(fit);
 }
 
 int fit_image_fail_process(const void *fit)
@@ -303,6 +566,7 @@ int fit_image_fail_process(const void *fit)
 	kaddr = env_get_ulong("kernel_addr_r", 16, 0);
 	faddr = env_get_ulong("fdt_addr_r", 16, 0);
 
+	fit_digest_del_source(fit);
 	sysmem_free((phys_addr_t)fit);
 	sysmem_free((phys_addr_t)raddr);
 	sysmem_free((phys_addr_t)kaddr);
@@ -355,7 +619,11 @@ static int fit_image_load_one(const void *fit, struct blk_desc *dev_desc,
 			return hash_noffset;
 
 		printf("%s: ", fdt_get_name(fit, noffset, NULL));
+		fit_digest_add_source(data, size, dev_desc,
+				      (u64)(part->start + blk_off) *
+				      dev_desc->blksz);
 		ret = fit_image_check_hash(fit, hash_noffset, data, size, &msg);
+		fit_digest_del_source(data);
 		if (ret)
 			return ret;
 
@@ -396,9 +664,12 @@ void *fit_image_load_bootables(ulong *size)
 {
 	struct blk_desc *dev_desc;
 	disk_partition_t part;
+	__maybe_unused ulong fit_size;
 	int blk_num;
 	void *fit;
 
+	bootstage_mark_name(BOOTSTAGE_ID_BOOT_FLOW, "fit_boot_flow");
+	fit_stream_reset();
 	dev_desc = rockchip_get_bootdev();
 	if (!dev_desc)
 		return NULL;
@@ -415,16 +686,29 @@ void *fit_image_load_bootables(ulong *size)
 		return NULL;
 	}
 
+	fit_size = FIT_ALIGN(fdt_totalsize(fit));
 	blk_num = DIV_ROUND_UP(*size, dev_desc->blksz);
 	fit = sysmem_alloc(MEM_FIT, blk_num * dev_desc->blksz);
 	if (!fit)
 		return NULL;
 
+#ifdef CONFIG_ROCKCHIP_FIT_STREAM_VERIFY
+	/* Only the FIT itself, fit_image_pre_process() reads the images */
+	fit_stream_dev = dev_desc;
+	fit_stream_start = part.start;
+	fit_stream_count = 0;
+	blk_num = DIV_ROUND_UP(fit_size, dev_desc->blksz);
+#endif
 	if (blk_dread(dev_desc, part.start, blk_num, fit) != blk_num) {
 		FIT_I("Failed to load bootable images\n");
+		fit_stream_reset();
 		return NULL;
 	}
 
+	/* Images SPL has verified in place need not be hashed again */
+	fit_digest_add_source(fit, *size, dev_desc,
+			      (u64)part.start * dev_desc->blksz);
+
 	return fit;
 }
 
@@ -0,0 +1,207 @@
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:     GPL-2.0+
+ *
+ * SPL records the sha256 of each image it verified on the boot device in
+ * ATAG_FIT_DIGEST. U-Boot reads the boot FIT from the same device again,
+ * and skips hashing any image whose device offset, size and sha256 match
+ * an entry, e.g. the kernel on thunder-boot.
+ *
+ * The data U-Boot hashes is a new copy read from storage, not the buffer
+ * SPL checked, so a match says nothing about what is in RAM now. Never
+ * take the shortcut when signatures or secure boot are enforced.
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <image.h>
+#include <asm/arch/fit.h>
+#include <asm/arch/rk_atags.h>
+
+#ifdef CONFIG_SPL_BUILD
+static struct tag_fit_digest fit_digest;
+
+void board_fit_image_verified(const void *fit, int node, u64 offset,
+			      size_t size)
+{
+	const char *name;
+	const int *ignore;
+	uint8_t *value;
+	char *algo;
+	int noffset, len;
+
+	if (fit_digest.count >= FIT_DIGEST_MAX)
+		return;
+
+	fdt_for_each_subnode(noffset, fit, node) {
+		name = fit_get_name(fit, noffset, NULL);
+		if (strncmp(name, FIT_HASH_NODENAME,
+			    strlen(FIT_HASH_NODENAME)))
+			continue;
+		if (fit_image_hash_get_algo(fit, noffset, &algo) ||
+		    strcmp(algo, "sha256"))
+			continue;
+		/* Not checked, so not worth passing on */
+		ignore = fdt_getprop(fit, noffset, FIT_IGNORE_PROP, NULL);
+		if (IMAGE_ENABLE_IGNORE && ignore && *ignore)
+			continue;
+		if (fit_image_hash_get_value(fit, noffset, &value, &len) ||
+		    len != FIT_DIGEST_LEN)
+			continue;
+
+		fit_digest.digest[fit_digest.count].offset = offset;
+		fit_digest.digest[fit_digest.count].size = size;
+		memcpy(fit_digest.digest[fit_digest.count].sha256, value, len);
+		fit_digest.count++;
+		return;
+	}
+}
+
+int fit_digest_set_atags(int bootdevice)
+{
+	int devtype;
+
+	if (!fit_digest.count)
+		return 0;
+
+	devtype = get_bootdev_by_spl_bootdevice(bootdevice);
+	if (devtype <= 0)
+		return -ENODEV;
+
+	fit_digest.devtype = devtype;
+
+	return atags_set_tag(ATAG_FIT_DIGEST, &fit_digest);
+}
+#else
+/* Max FIT buffers whose device location is known at a time */
+#define FIT_DIGEST_SRC_MAX	4
+
+struct fit_digest_src {
+	const void *buf;
+	size_t size;
+	u64 offset;	/* bytes from the start of the device */
+};
+
+static const struct {
+	u32 devtype;
+	u8 if_type;
+	u8 devnum;
+} fit_digest_devs[] = {
+	{ BOOT_TYPE_EMMC,		IF_TYPE_MMC,	 0 },
+	{ BOOT_TYPE_SD0,		IF_TYPE_MMC,	 1 },
+	{ BOOT_TYPE_SD1,		IF_TYPE_MMC,	 1 },
+	{ BOOT_TYPE_NAND,		IF_TYPE_RKNAND,	 0 },
+	{ BOOT_TYPE_SPI_NAND,		IF_TYPE_SPINAND, 0 },
+	{ BOOT_TYPE_SPI_NOR,		IF_TYPE_SPINOR,	 1 },
+	{ BOOT_TYPE_MTD_BLK_NAND,	IF_TYPE_MTD,	 BLK_MTD_NAND },
+	{ BOOT_TYPE_MTD_BLK_SPI_NAND,	IF_TYPE_MTD,	 BLK_MTD_SPI_NAND },
+	{ BOOT_TYPE_MTD_BLK_SPI_NOR,	IF_TYPE_MTD,	 BLK_MTD_SPI_NOR },
+	{ BOOT_TYPE_UFS,		IF_TYPE_SCSI,	 0 },
+};
+
+static struct fit_digest_src fit_digest_src[FIT_DIGEST_SRC_MAX];
+
+static struct tag_fit_digest *fit_digest_get(void)
+{
+	struct tag *t;
+
+	t = atags_get_tag(ATAG_FIT_DIGEST);
+	if (!t || t->u.fit_digest.count > FIT_DIGEST_MAX)
+		return NULL;
+
+	return &t->u.fit_digest;
+}
+
+/* Is @dev_desc the device SPL read the images from? */
+static bool fit_digest_dev_match(struct blk_desc *dev_desc, u32 devtype)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(fit_digest_devs); i++) {
+		if (fit_digest_devs[i].devtype == devtype &&
+		    fit_digest_devs[i].if_type == dev_desc->if_type &&
+		    fit_digest_devs[i].devnum == dev_desc->devnum)
+			return true;
+	}
+
+	return false;
+}
+
+void fit_digest_add_source(const void *buf, size_t size,
+			   struct blk_desc *dev_desc, u64 offset)
+{
+	struct tag_fit_digest *fd;
+	struct fit_digest_src *src = NULL;
+	int i;
+
+	fd = fit_digest_get();
+	if (!fd || !fd->count || !fit_digest_dev_match(dev_desc, fd->devtype))
+		return;
+
+	for (i = 0; i < FIT_DIGEST_SRC_MAX; i++) {
+		if (fit_digest_src[i].buf == buf) {
+			src = &fit_digest_src[i];
+			break;
+		}
+		if (!src && !fit_digest_src[i].buf)
+			src = &fit_digest_src[i];
+	}
+	if (!src)
+		return;
+
+	src->buf = buf;
+	src->size = size;
+	src->offset = offset;
+}
+
+void fit_digest_del_source(const void *buf)
+{
+	int i;
+
+	for (i = 0; i < FIT_DIGEST_SRC_MAX; i++) {
+		if (fit_digest_src[i].buf == buf)
+			fit_digest_src[i].buf = NULL;
+	}
+}
+
+int fit_digest_hash_verified(const void *data, size_t size, const char *algo,
+			     const uint8_t *value, int value_len)
+{
+	struct tag_fit_digest *fd;
+	struct fit_digest_src *src;
+	u64 offset;
+	int i;
+
+	if (value_len != FIT_DIGEST_LEN || strcmp(algo, "sha256"))
+		return 0;
+
+	/* The storage may have changed since SPL read it */
+	if (IS_ENABLED(CONFIG_FIT_SIGNATURE) ||
+	    fit_board_verify_required_sigs())
+		return 0;
+
+	for (i = 0; i < FIT_DIGEST_SRC_MAX; i++) {
+		src = &fit_digest_src[i];
+		if (src->buf && data >= src->buf &&
+		    data + size <= src->buf + src->size)
+			break;
+	}
+	if (i == FIT_DIGEST_SRC_MAX)
+		return 0;
+
+	fd = fit_digest_get();
+	if (!fd)
+		return 0;
+
+	offset = src->offset + (data - src->buf);
+	for (i = 0; i < fd->count; i++) {
+		if (fd->digest[i].offset == offset &&
+		    fd->digest[i].size == size &&
+		    !memcmp(fd->digest[i].sha256, value, value_len))
+			return 1;
+	}
+
+	return 0;
+}
+#endif
@@ -12,8 +12,10 @@
 #include <spl.h>
 #endif
 #include <lzma/LzmaTools.h>
+#include <u-boot/zstd.h>
 #include <optee_include/OpteeClientInterface.h>
 #include <optee_include/tee_api_defines.h>
+#include <asm/arch/fit.h>
 #include <asm/arch/rk_atags.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -26,7 +28,8 @@ DECLARE_GLOBAL_DATA_PTR;
 #if CONFIG_IS_ENABLED(FIT_IMAGE_POST_PROCESS)
 
 #define FIT_UNCOMP_HASH_NODENAME	"digest"
-#if CONFIG_IS_ENABLED(MISC_DECOMPRESS) || CONFIG_IS_ENABLED(GZIP) || CONFIG_IS_ENABLED(LZMA)
+#if CONFIG_IS_ENABLED(MISC_DECOMPRESS) || CONFIG_IS_ENABLED(GZIP) || \
+    CONFIG_IS_ENABLED(LZMA) || CONFIG_IS_ENABLED(ZSTD)
 static int fit_image_get_uncomp_digest(const void *fit, int parent_noffset)
 {
 	const char *name;
@@ -56,31 +59,17 @@ static int fit_image_check_uncomp_hash(const void *fit, int parent_noffset,
 	return 0;
 }
 
-static int fit_decomp_image(void *fit, int node, ulong *load_addr,
-			    ulong **src_addr, size_t *src_len, void *spec)
-{
-	u64 len = *src_len;
-	int ret = -ENOSYS;
-	u8 comp;
 #if CONFIG_IS_ENABLED(MISC_DECOMPRESS)
+static u32 fit_decomp_flags(void *fit, int node, void *spec)
+{
 	u32 flags = 0;
-#endif
 
-	if (fit_image_get_comp(fit, node, &comp))
-		return 0;
+	/* not waited for by misc_decompress_cleanup() */
+	if (fdt_getprop(fit, node, "decomp-async", NULL))
+		flags |= DCOMP_FLG_BOOT_ASYNC;
 
-	if (comp != IH_COMP_GZIP && comp != IH_COMP_LZMA)
-		return 0;
-
-#ifndef CONFIG_SPL_BUILD
-	/*
-	 * U-Boot:
-	 *	handled late in bootm_decomp_image()
-	 */
-	if (fit_image_check_type(fit, node, IH_TYPE_KERNEL))
-		return 0;
-#elif defined(CONFIG_SPL_MTD_SUPPORT) && defined(CONFIG_SPL_MISC_DECOMPRESS) && \
-      defined(CONFIG_SPL_KERNEL_BOOT)
+#if defined(CONFIG_SPL_BUILD) && defined(CONFIG_SPL_MTD_SUPPORT) && \
+    defined(CONFIG_SPL_MISC_DECOMPRESS) && defined(CONFIG_SPL_KERNEL_BOOT)
 	/*
 	 * SPL Thunder-boot policty on spi-nand:
 	 *	enable and use interrupt status as a sync signal for
@@ -97,6 +86,101 @@ static int fit_decomp_image(void *fit, int node, ulong *load_addr,
 			flags |= DCOMP_FLG_IRQ_ONESHOT;
 		}
 	}
+#endif
+	return flags;
+}
+#endif
+
+#if defined(CONFIG_SPL_BUILD) && defined(CONFIG_SPL_FIT_IMAGE_STREAM) && \
+    CONFIG_IS_ENABLED(MISC_DECOMPRESS)
+/*
+ * The image whose data is being fed to the decompressor while it is read,
+ * there is only one engine.
+ */
+static int fit_stream_node = -1;
+static size_t fit_stream_fed;
+
+int board_fit_image_stream(void *fit, int node, ulong load_addr,
+			   const void *src, size_t avail, size_t total,
+			   void *spec)
+{
+	int ret;
+	u8 comp;
+
+	if (fit_stream_node >= 0 && (!src || fit_stream_node != node)) {
+		misc_decompress_stream_abort(DECOM_GZIP);
+		fit_stream_node = -1;
+	}
+	if (!src)
+		return 0;
+
+	if (fit_stream_node < 0) {
+		/* Only what fit_decomp_image() hands to the engine */
+		if (fit_image_get_comp(fit, node, &comp) ||
+		    comp != IH_COMP_GZIP)
+			return -ENOSYS;
+
+		ret = misc_decompress_stream_start(load_addr, (ulong)src, avail,
+						   total, DECOM_GZIP,
+						   fit_decomp_flags(fit, node,
+								    spec));
+		if (ret)
+			return ret;
+
+		fit_stream_node = node;
+		fit_stream_fed = avail;
+
+		return 0;
+	}
+
+	ret = misc_decompress_stream_feed((ulong)src + fit_stream_fed,
+					  avail - fit_stream_fed, DECOM_GZIP);
+	if (ret) {
+		misc_decompress_stream_abort(DECOM_GZIP);
+		fit_stream_node = -1;
+		return ret;
+	}
+	fit_stream_fed = avail;
+
+	return 0;
+}
+
+static bool fit_decomp_is_streamed(int node)
+{
+	bool streamed = fit_stream_node == node;
+
+	fit_stream_node = -1;
+
+	return streamed;
+}
+#elif CONFIG_IS_ENABLED(MISC_DECOMPRESS)
+static bool fit_decomp_is_streamed(int node)
+{
+	return false;
+}
+#endif
+
+static int fit_decomp_image(void *fit, int node, ulong *load_addr,
+			    ulong **src_addr, size_t *src_len, void *spec)
+{
+	u64 len = *src_len;
+	int ret = -ENOSYS;
+	u8 comp;
+
+	if (fit_image_get_comp(fit, node, &comp))
+		return 0;
+
+	if (comp != IH_COMP_GZIP && comp != IH_COMP_LZMA &&
+	    comp != IH_COMP_ZSTD)
+		return 0;
+
+#ifndef CONFIG_SPL_BUILD
+	/*
+	 * U-Boot:
+	 *	handled late in bootm_decomp_image()
+	 */
+	if (fit_image_check_type(fit, node, IH_TYPE_KERNEL))
+		return 0;
 #endif
 	if (comp == IH_COMP_LZMA) {
 #if CONFIG_IS_ENABLED(LZMA)
@@ -104,6 +188,17 @@ static int fit_decomp_image(void *fit, int node, ulong *load_addr,
 		ret = lzmaBuffToBuffDecompress((uchar *)(*load_addr), &lzma_len,
 					       (uchar *)(*src_addr), *src_len);
 		len = lzma_len;
+#endif
+	} else if (comp == IH_COMP_ZSTD) {
+#if CONFIG_IS_ENABLED(ZSTD)
+		size_t zstd_len = zstd_get_content_size(*src_addr, *src_len);
+
+		/* Not recorded when zstd compressed a pipe */
+		if (!zstd_len)
+			zstd_len = ALIGN(len, FIT_MAX_SPL_IMAGE_SZ);
+		ret = zstd_decompress(*src_addr, *src_len, (void *)(*load_addr),
+				      &zstd_len);
+		len = zstd_len;
 #endif
 	} else if (comp == IH_COMP_GZIP) {
 		/*
@@ -111,21 +206,22 @@ static int fit_decomp_image(void *fit, int node, ulong *load_addr,
 		 * inside the gunzip().
 		 */
 #if CONFIG_IS_ENABLED(MISC_DECOMPRESS)
-		const void *prop;
 		bool sync = true;
 
 		if (fit_image_get_uncomp_digest(fit, node) < 0)
 			sync = false;
 
-		ret = misc_decompress_process((ulong)(*load_addr),
-					      (ulong)(*src_addr), (ulong)(*src_len),
-					      DECOM_GZIP, sync, &len, flags);
-		/* mark for misc_decompress_cleanup() */
-		prop = fdt_getprop(fit, node, "decomp-async", NULL);
-		if (prop)
-			misc_decompress_async(comp);
+		if (fit_decomp_is_streamed(node))
+			ret = misc_decompress_stream_end((ulong)(*src_addr),
+							 (ulong)(*src_len),
+							 DECOM_GZIP, sync, &len);
 		else
-			misc_decompress_sync(comp);
+			ret = misc_decompress_process((ulong)(*load_addr),
+						      (ulong)(*src_addr),
+						      (ulong)(*src_len),
+						      DECOM_GZIP, sync, &len,
+						      fit_decomp_flags(fit, node,
+								       spec));
 #else
 #if CONFIG_IS_ENABLED(GZIP)
 		ret = gunzip((void *)(*load_addr), ALIGN(len, FIT_MAX_SPL_IMAGE_SZ),
@@ -157,7 +253,14 @@ static int fit_decomp_image(void *fit, int node, ulong *load_addr,
 void board_fit_image_post_process(void *fit, int node, ulong *load_addr,
 				  ulong **src_addr, size_t *src_len, void *spec)
 {
-#if CONFIG_IS_ENABLED(MISC_DECOMPRESS) || CONFIG_IS_ENABLED(GZIP) || CONFIG_IS_ENABLED(LZMA)
+#if defined(CONFIG_ROCKCHIP_FIT_STREAM_VERIFY) && !defined(CONFIG_SPL_BUILD)
+	/* Read to the load address by fit_image_pre_process() */
+	if (fit_stream_is_loaded(*src_addr, *src_len, *load_addr))
+		*src_addr = (ulong *)*load_addr;
+#endif
+
+#if CONFIG_IS_ENABLED(MISC_DECOMPRESS) || CONFIG_IS_ENABLED(GZIP) || \
+    CONFIG_IS_ENABLED(LZMA) || CONFIG_IS_ENABLED(ZSTD)
 	fit_decomp_image(fit, node, load_addr, src_addr, src_len, spec);
 #endif
 
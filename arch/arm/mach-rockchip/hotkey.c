@@ -22,6 +22,7 @@ DECLARE_GLOBAL_DATA_PTR;
 #define CTRL_P		0x10	/* parameter(cmdline) dump */
 #define CTRL_R		0x12	/* regulator initial state dump */
 #define CTRL_T		0x14	/* print fdt */
+#define CTRL_V		0x16	/* verbose console, if it is quiet */
 
 bool is_hotkey(enum hotkey_t id)
 {
@@ -62,6 +63,10 @@ void hotkey_run(enum hotkey_t id)
 		if (gd->console_evt == CTRL_P)
 			printf("cmdline: %s\n", env_get("bootargs"));
 		break;
+	case HK_CONSOLE_VERBOSE:
+		if (gd->console_evt == CTRL_V)
+			console_quiet_exit();
+		break;
 	case HK_INITCALL:
 		if (gd->console_evt == CTRL_I)
 			env_update("bootargs", "initcall_debug debug");
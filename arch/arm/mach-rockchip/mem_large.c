@@ -0,0 +1,128 @@
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:     GPL-2.0+
+ */
+
+#include <common.h>
+#include <mem_large.h>
+#include <asm/arch/smp_work.h>
+#include <asm/system.h>
+#include <linux/sizes.h>
+
+/* Below this the pool wake-up costs more than it saves */
+#define MEM_LARGE_MIN_SIZE		SZ_1M
+/* Split at page boundaries so no two CPUs write the same cache line */
+#define MEM_LARGE_SPLIT_ALIGN		SZ_4K
+
+/* DCZID_EL0 */
+#define DCZID_DZP			BIT(4)
+#define DCZID_BS_MASK			0xf
+
+struct mem_large_op {
+	void *dst;
+	const void *src;
+	size_t n;
+	int c;
+	bool zva;
+};
+
+static size_t mem_large_part(size_t n, int cpu, int nr_cpus, size_t *len)
+{
+	size_t part = ALIGN(DIV_ROUND_UP(n, nr_cpus), MEM_LARGE_SPLIT_ALIGN);
+	size_t start = min_t(size_t, part * cpu, n);
+
+	*len = min_t(size_t, part, n - start);
+
+	return start;
+}
+
+static ulong dc_zva_block_size(void)
+{
+	ulong dczid;
+
+	asm volatile("mrs %0, dczid_el0" : "=r" (dczid));
+	if (dczid & DCZID_DZP)
+		return 0;
+
+	/* Log2 of the block size in words */
+	return 4UL << (dczid & DCZID_BS_MASK);
+}
+
+static void mem_large_zero(void *s, size_t n)
+{
+	ulong bs = dc_zva_block_size();
+	ulong p = (ulong)s, end = p + n;
+	ulong head;
+
+	if (!bs || n < 2 * bs) {
+		memset(s, 0, n);
+		return;
+	}
+
+	head = ALIGN(p, bs) - p;
+	memset(s, 0, head);
+	for (p += head; p + bs <= end; p += bs)
+		asm volatile("dc zva, %0" : : "r" (p) : "memory");
+	memset((void *)p, 0, end - p);
+}
+
+static void mem_large_set_fn(void *arg, int cpu, int nr_cpus)
+{
+	struct mem_large_op *op = arg;
+	size_t start, len;
+
+	start = mem_large_part(op->n, cpu, nr_cpus, &len);
+	if (!len)
+		return;
+
+	if (op->zva)
+		mem_large_zero(op->dst + start, len);
+	else
+		memset(op->dst + start, op->c, len);
+}
+
+static void mem_large_copy_fn(void *arg, int cpu, int nr_cpus)
+{
+	struct mem_large_op *op = arg;
+	size_t start, len;
+
+	start = mem_large_part(op->n, cpu, nr_cpus, &len);
+	if (len)
+		memcpy(op->dst + start, op->src + start, len);
+}
+
+void *memset_large(void *s, int c, size_t n)
+{
+	struct mem_large_op op = {
+		.dst = s,
+		.n = n,
+		.c = c,
+		/* DC ZVA faults on device memory, i.e. with the MMU off */
+		.zva = !(c & 0xff) && dcache_status(),
+	};
+
+	if (n < MEM_LARGE_MIN_SIZE)
+		return memset(s, c, n);
+
+	smp_work_run(mem_large_set_fn, &op);
+
+	return s;
+}
+
+void *memcpy_large(void *dst, const void *src, size_t n)
+{
+	struct mem_large_op op = {
+		.dst = dst,
+		.src = src,
+		.n = n,
+	};
+
+	if (n < MEM_LARGE_MIN_SIZE ||
+	    (dst < src + n && src < dst + n))
+		return memmove(dst, src, n);
+
+	smp_work_run(mem_large_copy_fn, &op);
+
+	return dst;
+}
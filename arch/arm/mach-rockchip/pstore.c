@@ -150,8 +150,30 @@ void putc_to_ram(const char c)
 		rb->size = pstore_size;
 
 	rb->start++;
+	gd->pstore_written++;
 }
 
+#ifdef CONFIG_CONSOLE_QUIET
+void pstore_replay(void (*out)(const char c))
+{
+	struct persistent_ram_buffer *rb = (struct persistent_ram_buffer *)gd->pstore_addr;
+	u32 pstore_size = gd->pstore_size;
+	u32 n, pos;
+
+	if (!rb || pstore_size == 0)
+		return;
+
+	/* Only what this stage wrote, the oldest of it may be overwritten */
+	n = min(gd->pstore_written, rb->size);
+	pos = (rb->start + pstore_size - n) % pstore_size;
+	while (n--) {
+		out(rb->data[pos]);
+		if (++pos == pstore_size)
+			pos = 0;
+	}
+}
+#endif
+
 void puts_to_ram(const char *str)
 {
 	while (*str) {
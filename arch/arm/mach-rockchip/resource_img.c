@@ -7,6 +7,7 @@
 #include <boot_rkimg.h>
 #include <bmp_layout.h>
 #include <malloc.h>
+#include <rk_logo.h>
 #include <asm/unaligned.h>
 #include <linux/libfdt.h>
 #include <linux/list.h>
@@ -25,6 +26,7 @@ DECLARE_GLOBAL_DATA_PTR;
 #define MAX_FILE_NAME_LEN		220
 #define MAX_HASH_LEN			32
 #define DEFAULT_DTB_FILE		"rk-kernel.dtb"
+#define RESOURCE_HASH_SIZE		64
 
 /*
  *         resource image structure
@@ -94,6 +96,32 @@ struct resource_entry {
 };
 
 LIST_HEAD(entry_head);
+/* entry_head again, hashed by name for the lookups */
+static struct hlist_head resource_hash[RESOURCE_HASH_SIZE];
+
+static u32 resource_name_hash(const char *name)
+{
+	u32 hash = 0;
+
+	while (*name)
+		hash = hash * 31 + *name++;
+
+	return hash % RESOURCE_HASH_SIZE;
+}
+
+static struct resource_file *resource_find_file(const char *name)
+{
+	struct resource_file *f;
+	struct hlist_node *node;
+
+	hlist_for_each_entry(f, node, &resource_hash[resource_name_hash(name)],
+			     hnode) {
+		if (!strcmp(f->name, name))
+			return f;
+	}
+
+	return NULL;
+}
 
 static int resource_check_header(struct resource_img_hdr *hdr)
 {
@@ -116,27 +144,20 @@ static int resource_add_file(const char *name, u32 size,
 			     bool in_ram)
 {
 	struct resource_file *f;
-	struct list_head *node;
-	bool _new = true;
 
 	/* old one ? */
-	list_for_each(node, &entry_head) {
-		f = list_entry(node, struct resource_file, link);
-		if (!strcmp(f->name, name)) {
-			_new = false;
-			break;
-		}
-	}
-
-	if (_new) {
+	f = resource_find_file(name);
+	if (!f) {
 		f = calloc(1, sizeof(*f));
 		if (!f)
 			return -ENOMEM;
 
+		strcpy(f->name, name);
 		list_add_tail(&f->link, &entry_head);
+		hlist_add_head(&f->hnode,
+			       &resource_hash[resource_name_hash(name)]);
 	}
 
-	strcpy(f->name, name);
 	f->size       = size;
 	f->in_ram     = in_ram;
 	f->blk_start  = blk_start;
@@ -167,6 +188,9 @@ static int resource_add_file(const char *name, u32 size,
  *
  * N: the sector count of logo.bmp
  *
+ * Either may be a raw logo from bmp2rawlogo instead, see <rk_logo.h>. A
+ * raw logo.bmp is also what CONFIG_SPL_DRM_ROCKCHIP_SPLASH shows.
+ *
  * How to generate:
  * 	cat logo.bmp > logo.img && truncate -s %512 logo.img && cat logo_kernel.bmp >> logo.img
  */
@@ -192,12 +216,19 @@ static int resource_setup_logo_bmp(struct blk_desc *desc)
 			break;
 		}
 
-		if (header->signature[0] != 'B' || header->signature[1] != 'M') {
+		if (!memcmp(header, RK_RAW_LOGO_MAGIC, 4)) {
+			struct rk_raw_logo_header *raw = (void *)header;
+
+			filesz = le32_to_cpu(raw->data_offset) +
+				 le32_to_cpu(raw->data_size);
+		} else if (header->signature[0] == 'B' &&
+			   header->signature[1] == 'M') {
+			filesz = get_unaligned_le32(&header->file_size);
+		} else {
 			ret = -EINVAL;
 			break;
 		}
 
-		filesz = get_unaligned_le32(&header->file_size);
 		ret = resource_add_file(name[i], filesz, part.start, blk_offset,
 					NULL, 0, false);
 		if (ret)
@@ -216,12 +247,20 @@ static int resource_setup_logo_bmp(struct blk_desc *desc)
 }
 #endif
 
+/*
+ * @ram_blks: blocks of the image present at @resc_hdr. Files within them
+ * are used from memory, the others are read from @blk_start on @desc.
+ *
+ * Return the number of files in memory.
+ */
 static int resource_setup_list(struct blk_desc *desc, ulong blk_start,
-			       void *resc_hdr, bool in_ram)
+			       void *resc_hdr, u32 ram_blks)
 {
 	struct resource_img_hdr *hdr = resc_hdr;
 	struct resource_entry *et;
-	u32 i, stride;
+	u32 i, stride, end;
+	int nr_ram = 0;
+	bool in_ram;
 	void *pos;
 
 	pos = (void *)hdr + hdr->c_offset * desc->blksz;
@@ -232,14 +271,20 @@ static int resource_setup_list(struct blk_desc *desc, ulong blk_start,
 		if (memcmp(et->tag, ENTRY_TAG, ENTRY_TAG_SIZE))
 			continue;
 
+		end = et->blk_offset + DIV_ROUND_UP(et->size, desc->blksz);
+		in_ram = end <= ram_blks;
+		if (in_ram)
+			nr_ram++;
+
 		resource_add_file(et->name, et->size,
-				  blk_start, et->blk_offset,
-				  et->hash, et->hash_size, in_ram);
+				  in_ram ? (ulong)hdr : blk_start,
+				  et->blk_offset, et->hash, et->hash_size,
+				  in_ram);
 	}
 #ifdef CONFIG_ANDROID_BOOT_IMAGE
 	resource_setup_logo_bmp(desc);
 #endif
-	return 0;
+	return nr_ram;
 }
 
 int resource_setup_ram_list(struct blk_desc *desc, void *hdr)
@@ -253,16 +298,23 @@ int resource_setup_ram_list(struct blk_desc *desc, void *hdr)
 	}
 
 	/* @blk_start: set as 'hdr' point addr, to be used in byte */
-	return resource_setup_list(desc, (ulong)hdr, hdr, true);
+	resource_setup_list(desc, (ulong)hdr, hdr, U32_MAX);
+
+	return 0;
 }
 
 #ifdef CONFIG_ANDROID_BOOT_IMAGE
-static int resource_setup_blk_list(struct blk_desc *desc, ulong blk_start)
+/*
+ * The entries and the files packed right after them (usually the DTBs and
+ * the small logo/charge images) are read at once, and those files are then
+ * used from memory instead of being read again for each lookup.
+ */
+static int resource_setup_blk_list(struct blk_desc *desc, ulong blk_start,
+				   ulong blk_max)
 {
 	struct resource_img_hdr *hdr;
-	int blk_cnt;
+	ulong blk_cnt;
 	int ret = 0;
-	void *buf;
 
 	hdr = memalign(ARCH_DMA_MINALIGN, desc->blksz);
 	if (!hdr)
@@ -288,20 +340,22 @@ static int resource_setup_blk_list(struct blk_desc *desc, ulong blk_start)
 		}
 	}
 
-	blk_cnt = hdr->e_blks * hdr->e_nums;
-	hdr = realloc(hdr, (1 + blk_cnt) * desc->blksz);
-	if (!hdr) {
-		ret = -ENOMEM;
-		goto out;
-	}
+	blk_cnt = hdr->c_offset + hdr->e_blks * hdr->e_nums;
+	blk_cnt = max(blk_cnt, min(blk_max, blk_cnt +
+		      CONFIG_ROCKCHIP_RESOURCE_PRELOAD_SIZE / desc->blksz));
+	free(hdr);
+	hdr = memalign(ARCH_DMA_MINALIGN, blk_cnt * desc->blksz);
+	if (!hdr)
+		return -ENOMEM;
 
-	buf = (void *)hdr + desc->blksz;
-	if (blk_dread(desc, blk_start + hdr->c_offset, blk_cnt, buf) != blk_cnt) {
+	if (blk_dread(desc, blk_start, blk_cnt, hdr) != blk_cnt) {
 		ret = -EIO;
 		goto out;
 	}
 
-	resource_setup_list(desc, blk_start, hdr, false);
+	/* Keep the buffer if any file is used from it */
+	if (resource_setup_list(desc, blk_start, hdr, blk_cnt) > 0)
+		return 0;
 out:
 	free(hdr);
 
@@ -340,7 +394,8 @@ static int resource_init(struct blk_desc *desc,
 	}
 #endif
 
-	return resource_setup_blk_list(desc, part->start + blk_offset);
+	return resource_setup_blk_list(desc, part->start + blk_offset,
+				       part->size - blk_offset);
 }
 
 static int resource_default(struct blk_desc *desc,
@@ -412,20 +467,39 @@ static int resource_scan(void)
 }
 
 static struct resource_file *resource_get_file(const char *name)
+{
+	if (resource_scan())
+		return NULL;
+
+	return resource_find_file(name);
+}
+
+int rockchip_get_resource_file_size(const char *name)
 {
 	struct resource_file *f;
-	struct list_head *node;
 
-	if (resource_scan())
+	f = resource_get_file(name);
+	if (!f)
+		return -ENOENT;
+
+	return f->size;
+}
+
+const void *rockchip_get_resource_file_data(const char *name, int *len)
+{
+	struct blk_desc *desc = rockchip_get_bootdev();
+	struct resource_file *f;
+
+	if (!desc)
 		return NULL;
 
-	list_for_each(node, &entry_head) {
-		f = list_entry(node, struct resource_file, link);
-		if (!strcmp(f->name, name))
-			return f;
-	}
+	f = resource_get_file(name);
+	if (!f || !f->in_ram)
+		return NULL;
 
-	return NULL;
+	*len = f->size;
+
+	return (void *)(ulong)f->blk_start + f->blk_offset * desc->blksz;
 }
 
 int rockchip_read_resource_file(void *buf, const char *name, int blk_offset, int len)
@@ -462,6 +536,41 @@ int rockchip_read_resource_file(void *buf, const char *name, int blk_offset, int
 }
 
 #ifdef CONFIG_ROCKCHIP_HWID_DTB
+/*
+ * resource_tool packs HWID_INDEX_FILE with the conditions of all hwid dtbs,
+ * return 0 and the matching dtb (or NULL) if it is there.
+ */
+static int resource_read_hwid_index(struct resource_file **file)
+{
+	struct blk_desc *desc = rockchip_get_bootdev();
+	const char *name;
+	const void *index;
+	void *buf = NULL;
+	int ret, size;
+
+	index = rockchip_get_resource_file_data(HWID_INDEX_FILE, &size);
+	if (!index) {
+		size = rockchip_get_resource_file_size(HWID_INDEX_FILE);
+		if (size <= 0 || !desc)
+			return -ENOENT;
+
+		buf = memalign(ARCH_DMA_MINALIGN, ALIGN(size, desc->blksz));
+		if (!buf)
+			return -ENOMEM;
+
+		size = rockchip_read_resource_file(buf, HWID_INDEX_FILE, 0, size);
+		index = buf;
+	}
+
+	ret = size > 0 ? hwid_index_find_dtb(index, size, &name) : size;
+	if (!ret)
+		*file = name ? resource_find_file(name) : NULL;
+
+	free(buf);
+
+	return ret;
+}
+
 static struct resource_file *resource_read_hwid_dtb(void)
 {
 	struct resource_file *file;
@@ -469,6 +578,9 @@ static struct resource_file *resource_read_hwid_dtb(void)
 
 	hwid_init_data();
 
+	if (!resource_read_hwid_index(&file))
+		return file;
+
 	list_for_each(node, &entry_head) {
 		file = list_entry(node, struct resource_file, link);
 		if (!strstr(file->name, DTB_SUFFIX))
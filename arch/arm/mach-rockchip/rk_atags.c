@@ -264,6 +264,21 @@ int atags_set_tag(u32 magic, void *tagdata)
 	case ATAG_FWVER:
 		size = tag_size(tag_fwver);
 		break;
+	case ATAG_FIT_DIGEST:
+		size = tag_size(tag_fit_digest);
+		break;
+	case ATAG_MTD_BBT:
+		size = tag_size(tag_mtd_bbt);
+		break;
+	case ATAG_MMC:
+		size = tag_size(tag_mmc);
+		break;
+	case ATAG_AMP:
+		size = tag_size(tag_amp);
+		break;
+	case ATAG_AB:
+		size = tag_size(tag_ab);
+		break;
 	};
 
 	if (!size)
@@ -20,9 +20,23 @@
 #define MAX_ADC_CH_NR		10
 #define MAX_GPIO_NR		10
 
+#ifndef CONFIG_ROCKCHIP_HWID_ADC_SAMPLES
+#define CONFIG_ROCKCHIP_HWID_ADC_SAMPLES	1
+#endif
+
+/*
+ * Every adc channel and gpio pin is sampled once, all the dtb names are
+ * matched against what was read.
+ */
 static fdt_addr_t gpio_base_addr[MAX_GPIO_NR];
-static uint32_t gpio_record[MAX_GPIO_NR];
-static int adc_record[MAX_ADC_CH_NR];
+static struct {
+	uint32_t sampled;	/* pins read so far */
+	uint32_t val;
+} gpio_record[MAX_GPIO_NR];
+static struct {
+	int state;		/* 0: not read, 1: read, -ve: read failed */
+	u32 val;
+} adc_record[MAX_ADC_CH_NR];
 
 #ifdef CONFIG_ROCKCHIP_GPIO_V2
 #define GPIO_SWPORT_DDR		0x08
@@ -93,11 +107,113 @@ static int gpio_parse_base_address(fdt_addr_t *gpio_base_addr)
 	return 0;
 }
 
+/* Forget what was sampled, the gpio addresses from the DT are kept */
 void hwid_init_data(void)
 {
 	memset(adc_record, 0, sizeof(adc_record));
 	memset(gpio_record, 0, sizeof(gpio_record));
-	memset(gpio_base_addr, 0, sizeof(gpio_base_addr));
+}
+
+/* Average of CONFIG_ROCKCHIP_HWID_ADC_SAMPLES conversions, against noise */
+static int hwid_adc_sample(const char *dev_name, int channel, u32 *val)
+{
+	u32 raw_adc, sum = 0;
+	int i, ret;
+
+	for (i = 0; i < CONFIG_ROCKCHIP_HWID_ADC_SAMPLES; i++) {
+		ret = adc_channel_single_shot(dev_name, channel, &raw_adc);
+		if (ret)
+			ret = adc_channel_single_shot("adc", channel, &raw_adc);
+		if (ret)
+			return ret;
+		sum += raw_adc;
+	}
+
+	*val = DIV_ROUND_CLOSEST(sum, CONFIG_ROCKCHIP_HWID_ADC_SAMPLES);
+
+	return 0;
+}
+
+/*
+ * Read adc @channel once, later calls return what was read the first time,
+ * or the same error.
+ */
+static int hwid_adc_read(const char *dev_name, int channel, u32 *val)
+{
+	int ret;
+
+	if (adc_record[channel].state == 0) {
+		ret = hwid_adc_sample(dev_name, channel,
+				      &adc_record[channel].val);
+		if (ret)
+			debug("   - failed to read adc, ret=%d\n", ret);
+		adc_record[channel].state = ret ? ret : 1;
+	}
+
+	if (adc_record[channel].state < 0)
+		return adc_record[channel].state;
+
+	*val = adc_record[channel].val;
+
+	return 0;
+}
+
+static bool hwid_adc_match(const char *dev_name, int channel, ulong dtb_adc)
+{
+	int margin = 30;
+	u32 raw_adc;
+
+	if (hwid_adc_read(dev_name, channel, &raw_adc))
+		return false;
+
+	return abs(dtb_adc - raw_adc) <= margin;
+}
+
+/*
+ * Read each gpio pin once, later calls return what was read the first
+ * time. Only the pins read are valid in *@val.
+ */
+static int hwid_gpio_read(int port, int bank, int pin, u32 *val)
+{
+	u32 bit = BIT(bank * 8 + pin);
+	int ret;
+
+	if (gpio_base_addr[0] == 0) {
+		ret = gpio_parse_base_address(gpio_base_addr);
+		if (ret) {
+			debug("[HW-GPIO]: Can't parse gpio base, ret=%d\n", ret);
+			return ret;
+		}
+	}
+
+	if (!(gpio_record[port].sampled & bit)) {
+		if (!gpio_base_addr[port]) {
+			debug("   - can't find gpio%d base\n", port);
+			return -ENODEV;
+		}
+		/* The pin is only made an input when it is read */
+		if (gpio_read(gpio_base_addr[port], bank, pin) & bit)
+			gpio_record[port].val |= bit;
+		gpio_record[port].sampled |= bit;
+	}
+
+	*val = gpio_record[port].val;
+
+	return 0;
+}
+
+static bool hwid_gpio_match(int port, int bank, int pin, int lvl)
+{
+	u32 bit, val;
+
+	if (hwid_gpio_read(port, bank, pin, &val))
+		return false;
+
+	bit = bank * 8 + pin;
+	val = val & (1 << bit) ? 1 : 0;
+	debug("   - gpio%d%c%d=%d, read=%d\n", port, bank + 'a', pin, lvl, val);
+
+	return val == !!lvl;
 }
 
 /*
@@ -119,12 +235,11 @@ static int hwid_adc_find_dtb(const char *file_name)
 {
 	char *cell_name, *adc_tail, *adc_head, *p;
 	int prefix_len, chn_len, len;
-	int found = 0, margin = 30;
-	int ret, channel;
+	int found = 0;
+	int channel;
 	char dev_name[32];
 	char adc_val[10];
 	ulong dtb_adc;
-	u32 raw_adc;
 
 	debug("[HW-ADC]: %s\n", file_name);
 
@@ -147,24 +262,6 @@ static int hwid_adc_find_dtb(const char *file_name)
 			return 0;
 		}
 
-		/*
-		 * Read raw adc value
-		 *
-		 * It doesn't need to read adc value every loop, reading once
-		 * is enough. We use adc_record[] to save what we have read, zero
-		 * means not read before.
-		 */
-		if (adc_record[channel] == 0) {
-			ret = adc_channel_single_shot(dev_name, channel, &raw_adc);
-			if (ret)
-				ret = adc_channel_single_shot("adc", channel, &raw_adc);
-			if (ret) {
-				debug("   - failed to read adc, ret=%d\n", ret);
-				return 0;
-			}
-			adc_record[channel] = raw_adc;
-		}
-
 		/* Parse dtb adc value */
 		p = adc_tail + chn_len + 2;	/* 2: channel and '=' */
 		while (*p && is_digit(*p)) {
@@ -173,9 +270,9 @@ static int hwid_adc_find_dtb(const char *file_name)
 		}
 		strlcpy(adc_val, adc_tail + chn_len + 2, len + 1);
 		dtb_adc = simple_strtoul(adc_val, NULL, 10);
-		found = (abs(dtb_adc - adc_record[channel]) <= margin) ? 1 : 0;
+		found = hwid_adc_match(dev_name, channel, dtb_adc);
 		debug("   - dev=%s, channel=%d, dtb_adc=%ld, read=%d, found=%d\n",
-		      dev_name, channel, dtb_adc, adc_record[channel], found);
+		      dev_name, channel, dtb_adc, adc_record[channel].val, found);
 		if (!found)
 			break;
 		cell_name = strstr(p, KEY_WORDS_ADC_CTRL);
@@ -201,22 +298,13 @@ static int hwid_adc_find_dtb(const char *file_name)
  */
 static int hwid_gpio_find_dtb(const char *file_name)
 {
-	uint8_t port, pin, bank, lvl, val;
+	uint8_t port, pin, bank, lvl;
 	char *cell_name, *p;
-	int ret, prefix_len;
+	int prefix_len;
 	int found = 0;
-	u32 bit;
 
 	debug("[HW-GPIO]: %s\n", file_name);
 
-	if (gpio_base_addr[0] == 0) {
-		ret = gpio_parse_base_address(gpio_base_addr);
-		if (ret) {
-			debug("[HW-GPIO]: Can't parse gpio base, ret=%d\n", ret);
-			return 0;
-		}
-	}
-
 	prefix_len = strlen(KEY_WORDS_GPIO);
 	cell_name = strstr(file_name, KEY_WORDS_GPIO);
 	while (cell_name) {
@@ -236,26 +324,8 @@ static int hwid_gpio_find_dtb(const char *file_name)
 		pin  = *(p + 2) - '0';
 		lvl  = *(p + 4) - '0';
 
-		/*
-		 * It doesn't need to read gpio value every loop, reading once
-		 * is enough. We use gpio_record[] to save what we have read, zero
-		 * means not read before.
-		 */
-		if (gpio_record[port] == 0) {
-			if (!gpio_base_addr[port]) {
-				debug("   - can't find gpio%d base\n", port);
-				return 0;
-			}
-			gpio_record[port] =
-				gpio_read(gpio_base_addr[port], bank, pin);
-		}
-
 		/* Verify result */
-		bit = bank * 8 + pin;
-		val = gpio_record[port] & (1 << bit) ? 1 : 0;
-		found = (val == !!lvl) ? 1 : 0;
-		debug("   - gpio%d%c%d=%d, read=%d, found=%d\n",
-		      port, bank + 'a', pin, lvl, val, found);
+		found = hwid_gpio_match(port, bank, pin, lvl);
 		if (!found)
 			break;
 		cell_name = strstr(p, KEY_WORDS_GPIO);
@@ -284,3 +354,74 @@ bool hwid_dtb_is_available(const char *file_name)
 
 	return 0;
 }
+
+/* All conditions of @type must match, as in hwid_*_find_dtb() */
+static bool hwid_index_match(const struct hwid_index_dtb *dtb, int type)
+{
+	const struct hwid_index_cond *cond;
+	bool found = false;
+	int i;
+
+	for (i = 0; i < dtb->nr_conds; i++) {
+		cond = &dtb->conds[i];
+		if (cond->type != type)
+			continue;
+
+		if (type == HWID_COND_ADC)
+			found = hwid_adc_match(cond->adc_ctrl, cond->id,
+					       cond->value);
+		else
+			found = hwid_gpio_match(cond->id, cond->bank,
+						cond->pin, cond->value);
+		if (!found)
+			break;
+	}
+
+	return found;
+}
+
+int hwid_index_find_dtb(const void *index, int size, const char **name)
+{
+	const struct hwid_index_hdr *hdr = index;
+	const struct hwid_index_dtb *dtb;
+	const struct hwid_index_cond *cond;
+	int i, j;
+
+	if (size < sizeof(*hdr) ||
+	    memcmp(hdr->magic, HWID_INDEX_MAGIC, sizeof(hdr->magic)) ||
+	    hdr->version != HWID_INDEX_VERSION ||
+	    size < sizeof(*hdr) + hdr->nr_dtbs * sizeof(*dtb))
+		return -EINVAL;
+
+	/* Reject what the hardware read helpers can't take */
+	for (i = 0; i < hdr->nr_dtbs; i++) {
+		dtb = &hdr->dtbs[i];
+		if (dtb->nr_conds > HWID_INDEX_MAX_CONDS ||
+		    strnlen(dtb->name, sizeof(dtb->name)) == sizeof(dtb->name))
+			return -EINVAL;
+		for (j = 0; j < dtb->nr_conds; j++) {
+			cond = &dtb->conds[j];
+			if ((cond->type == HWID_COND_ADC &&
+			     (cond->id >= MAX_ADC_CH_NR ||
+			      strnlen(cond->adc_ctrl, sizeof(cond->adc_ctrl)) ==
+			      sizeof(cond->adc_ctrl))) ||
+			    (cond->type == HWID_COND_GPIO &&
+			     (cond->id >= MAX_GPIO_NR || cond->bank > 3 ||
+			      cond->pin > 7)))
+				return -EINVAL;
+		}
+	}
+
+	*name = NULL;
+	for (i = 0; i < hdr->nr_dtbs; i++) {
+		dtb = &hdr->dtbs[i];
+		debug("[HW-INDEX]: %s\n", dtb->name);
+		if (hwid_index_match(dtb, HWID_COND_ADC) ||
+		    hwid_index_match(dtb, HWID_COND_GPIO)) {
+			*name = dtb->name;
+			break;
+		}
+	}
+
+	return 0;
+}
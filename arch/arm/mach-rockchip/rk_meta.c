@@ -86,7 +86,6 @@ static int rk_meta_iq_decom(unsigned long dst, unsigned long src,
 #if CONFIG_IS_ENABLED(MISC_DECOMPRESS)
 
 	ret = misc_decompress_process(dst, src, src_len, DECOM_GZIP, true, len, 0);
-	misc_decompress_sync(IH_COMP_GZIP);
 #else
 	ret = gunzip((void *)&dst, ALIGN(len, FIT_MAX_SPL_IMAGE_SZ),
 		     (void *)&src, (void *)len);
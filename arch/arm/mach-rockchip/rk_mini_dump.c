@@ -5,9 +5,13 @@
  */
 
 #include <common.h>
+#include <blk.h>
+#include <boot_rkimg.h>
+#include <part.h>
 #include <linux/types.h>
 #include <asm/io.h>
 #include <rk_mini_dump.h>
+#include <u-boot/lz4.h>
 
 /* don't modify it, it is behind pstore memory space */
 #ifdef CONFIG_ROCKCHIP_MINIDUMP_SMEM_BASE
@@ -183,6 +187,107 @@ struct md_region *md_get_region(char *name)
 }
 
 #ifdef CONFIG_ARM64
+#ifdef CONFIG_ROCKCHIP_MINIDUMP_LZ4
+/* Copy a region into the elf, return the length it takes there */
+static unsigned int md_copy_segment(void *dst, void *src, unsigned int size)
+{
+	struct md_seg_lz4 *hdr = dst;
+	int len = 0;
+
+	if (size > sizeof(*hdr))
+		len = LZ4_compress_default(src, (char *)(hdr + 1), size,
+					   size - sizeof(*hdr));
+	/* Keep what doesn't get smaller as it is */
+	if (!len) {
+		memcpy(dst, src, size);
+		return size;
+	}
+
+	hdr->magic = MD_SEG_LZ4_MAGIC;
+	hdr->size = len;
+	hdr->raw_size = size;
+	hdr->reserved = 0;
+
+	return sizeof(*hdr) + len;
+}
+#else
+static unsigned int md_copy_segment(void *dst, void *src, unsigned int size)
+{
+	memcpy(dst, src, size);
+	return size;
+}
+#endif
+
+#ifdef CONFIG_ROCKCHIP_MINIDUMP_STORAGE
+static struct blk_desc *md_desc;
+static disk_partition_t md_part;
+static ulong md_written;	/* bytes of the elf in the partition */
+
+static void md_stream_open(void)
+{
+	md_desc = rockchip_get_bootdev();
+	if (!md_desc)
+		return;
+	if (part_get_info_by_name(md_desc, CONFIG_ROCKCHIP_MINIDUMP_PART_NAME,
+				  &md_part) < 0) {
+		printf("Minidump no %s partition\n",
+		       CONFIG_ROCKCHIP_MINIDUMP_PART_NAME);
+		md_desc = NULL;
+		return;
+	}
+	md_written = 0;
+}
+
+/*
+ * Write the elf from what is written up to @end. Only whole blocks are
+ * written, the rest with what follows it, unless it is the @last part.
+ */
+static void md_stream_write(void *ram_image, ulong end, bool last)
+{
+	ulong blksz, start, cnt;
+
+	if (!md_desc)
+		return;
+
+	blksz = md_desc->blksz;
+	start = md_written / blksz;
+	cnt = (last ? DIV_ROUND_UP(end, blksz) : end / blksz) - start;
+	if (!cnt)
+		return;
+
+	if (start + cnt > md_part.size) {
+		printf("Minidump elf 0x%lx is larger than partition %s\n", end,
+		       CONFIG_ROCKCHIP_MINIDUMP_PART_NAME);
+		md_desc = NULL;
+		return;
+	}
+	if (blk_dwrite(md_desc, md_part.start + start, cnt,
+		       ram_image + start * blksz) != cnt) {
+		printf("Minidump write partition %s failed\n",
+		       CONFIG_ROCKCHIP_MINIDUMP_PART_NAME);
+		md_desc = NULL;
+		return;
+	}
+	md_written = (start + cnt) * blksz;
+}
+
+/* Write the tail and then the headers, which are complete only now */
+static void md_stream_close(void *ram_image, ulong size, ulong ehsize)
+{
+	md_stream_write(ram_image, size, true);
+	md_written = 0;
+	md_stream_write(ram_image, ehsize, true);
+	if (md_desc)
+		printf("Minidump.elf written to partition %s\n",
+		       CONFIG_ROCKCHIP_MINIDUMP_PART_NAME);
+}
+#else
+static inline void md_stream_open(void) {}
+static inline void md_stream_write(void *ram_image, ulong end, bool last) {}
+static inline void md_stream_close(void *ram_image, ulong size,
+				   ulong ehsize) {}
+#endif
+
 static Elf64_Xword rk_dump_elf64_image_phdr(void *ram_image,
 					    Elf64_Addr ehaddr, Elf64_Xword ehsize)
 {
@@ -191,6 +296,7 @@ static Elf64_Xword rk_dump_elf64_image_phdr(void *ram_image,
 	Elf64_Shdr *shdr = NULL, *shdr_next = NULL;
 	unsigned int i = 0, error = 0, phdr_off = 0, strtbl_off = 0;
 	unsigned int size = 0, elf_size = ehsize;
+	unsigned int file_off, filesz;
 
 	if (!md_is_uboot_addr((void *)ehdr))
 		return 0;
@@ -343,6 +449,14 @@ static Elf64_Xword rk_dump_elf64_image_phdr(void *ram_image,
 		return 0;
 	}
 
+	/*
+	 * elf_size follows the layout Linux set up, which the checks below
+	 * go by; file_off is where the segments actually go, which is before
+	 * that once a segment is compressed.
+	 */
+	file_off = elf_size;
+	md_stream_open();
+
 	/* save phdr space */
 	for (i = 1; i < MAX_NUM_ENTRIES; i++) {
 		void *src = NULL;
@@ -419,8 +533,11 @@ static Elf64_Xword rk_dump_elf64_image_phdr(void *ram_image,
 		}
 
 		elf_size += size;
+		phdr->p_offset = file_off;
+		shdr->sh_offset = file_off;
+		filesz = size;
 		src = (void *)(Elf64_Addr)phdr->p_paddr;
-		dst = ram_image + phdr->p_offset;
+		dst = ram_image + file_off;
 
 		if (size > MAX_ELF_SIZE / 2)
 			goto donot_cpy;
@@ -433,9 +550,14 @@ static Elf64_Xword rk_dump_elf64_image_phdr(void *ram_image,
 			printf("Minidump error dst 0x%p-0x%p\n", dst, dst + size - 1);
 			goto donot_cpy;
 		}
-		if (size)
-			memcpy(dst, src, size);
+		if (size) {
+			filesz = md_copy_segment(dst, src, size);
+			phdr->p_filesz = filesz;
+			shdr->sh_size = filesz;
+		}
+		md_stream_write(ram_image, file_off + filesz, false);
 donot_cpy:
+		file_off += filesz;
 		phdr++;
 		shdr++;
 		phdr_next++;
@@ -449,9 +571,14 @@ donot_cpy:
 
 	/* copy ehdr to ram image */
 	memcpy(ram_image, (void *)ehdr, ehsize);
-	flush_cache((unsigned long)ram_image, elf_size);
-	printf("Minidump.elf 0x%x@0x%p\n", elf_size, ram_image);
-	return elf_size;
+	flush_cache((unsigned long)ram_image, file_off);
+	if (file_off != elf_size)
+		printf("Minidump.elf 0x%x@0x%p, 0x%x uncompressed\n", file_off,
+		       ram_image, elf_size);
+	else
+		printf("Minidump.elf 0x%x@0x%p\n", elf_size, ram_image);
+	md_stream_close(ram_image, file_off, ehsize);
+	return file_off;
 }
 #else
 static Elf32_Word rk_dump_elf32_image_phdr(void *ram_image, Elf32_Addr ehaddr,
@@ -14,10 +14,12 @@
 #define ARM_PSCI_1_0_SYSTEM_SUSPEND	ARM_PSCI_1_0_FN64_SYSTEM_SUSPEND
 #define ARM_PSCI_0_2_CPU_ON		ARM_PSCI_0_2_FN64_CPU_ON
 #define ARM_PSCI_0_2_CPU_OFF		ARM_PSCI_0_2_FN_CPU_OFF
+#define ARM_PSCI_0_2_AFFINITY_INFO	ARM_PSCI_0_2_FN64_AFFINITY_INFO
 #else
 #define ARM_PSCI_1_0_SYSTEM_SUSPEND	ARM_PSCI_1_0_FN_SYSTEM_SUSPEND
 #define ARM_PSCI_0_2_CPU_ON		ARM_PSCI_0_2_FN_CPU_ON
 #define ARM_PSCI_0_2_CPU_OFF		ARM_PSCI_0_2_FN_CPU_OFF
+#define ARM_PSCI_0_2_AFFINITY_INFO	ARM_PSCI_0_2_FN_AFFINITY_INFO
 #endif
 
 #define SIZE_PAGE(n)	((n) << 12)
@@ -51,6 +53,15 @@ int psci_cpu_off(uint32_t state)
 	return res.a0;
 }
 
+int psci_affinity_info(unsigned long cpuid, unsigned long level)
+{
+	struct arm_smccc_res res;
+
+	res = __invoke_sip_fn_smc(ARM_PSCI_0_2_AFFINITY_INFO, cpuid, level, 0);
+
+	return res.a0;
+}
+
 #ifdef CONFIG_ARM_CPU_SUSPEND
 int psci_system_suspend(unsigned long unused)
 {
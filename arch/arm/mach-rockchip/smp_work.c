@@ -0,0 +1,359 @@
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:     GPL-2.0+
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <fdtdec.h>
+#include <malloc.h>
+#include <sysmem.h>
+#include <asm/armv8/mmu.h>
+#include <asm/arch/rockchip_smccc.h>
+#include <asm/arch/smp_work.h>
+#include <asm/psci.h>
+#include <asm/system.h>
+#include <linux/compiler.h>
+#include <linux/sizes.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define SMP_WORK_STACK_SIZE		SZ_16K
+#define SMP_WORK_TIMEOUT_MS		5000
+#define MPIDR_AFF_MASK			0xffffff
+
+struct smp_work_slot smp_work_slots[SMP_WORK_MAX_CPUS];
+
+static struct {
+	struct mp_task *head;
+	struct mp_task *tail;
+	int lock;
+	int pending;
+	int stop;
+	int nr_slots;
+	int nr_workers;
+	bool started;
+} mp_pool;
+
+/*
+ * The stacks are never freed: a secondary CPU is still using its stack for
+ * the CPU_OFF call after it has reported itself as done, and the pool may
+ * be started again.
+ */
+static void *smp_work_stacks;
+
+/* Set/way cache maintenance would miss the caches of the workers */
+bool dcache_flush_all_allowed(void)
+{
+	return !mp_pool.started;
+}
+
+static void mp_pool_lock(void)
+{
+	while (__atomic_exchange_n(&mp_pool.lock, 1, __ATOMIC_ACQUIRE))
+		while (READ_ONCE(mp_pool.lock))
+			;
+}
+
+static void mp_pool_unlock(void)
+{
+	__atomic_store_n(&mp_pool.lock, 0, __ATOMIC_RELEASE);
+}
+
+static struct mp_task *mp_task_dequeue(void)
+{
+	struct mp_task *task;
+
+	/* Cheap check so idle CPUs do not bounce the lock around */
+	if (!READ_ONCE(mp_pool.head))
+		return NULL;
+
+	mp_pool_lock();
+	task = mp_pool.head;
+	if (task) {
+		mp_pool.head = task->next;
+		if (!mp_pool.head)
+			mp_pool.tail = NULL;
+		task->state = MP_TASK_RUNNING;
+	}
+	mp_pool_unlock();
+
+	return task;
+}
+
+static void mp_task_run(struct mp_task *task)
+{
+	task->fn(task->arg);
+
+	__atomic_store_n(&task->state, MP_TASK_DONE, __ATOMIC_RELEASE);
+	__atomic_sub_fetch(&mp_pool.pending, 1, __ATOMIC_RELEASE);
+	dsb();
+	asm volatile("sev");
+}
+
+static void mp_task_worker(void)
+{
+	struct mp_task *task;
+
+	while (1) {
+		task = mp_task_dequeue();
+		if (task) {
+			mp_task_run(task);
+			continue;
+		}
+
+		if (READ_ONCE(mp_pool.stop))
+			break;
+
+		/* A sev after the checks above still ends this wfe */
+		asm volatile("wfe");
+	}
+}
+
+void __noreturn smp_work_secondary(struct smp_work_slot *slot)
+{
+	int el = current_el();
+
+	/* Share the page tables of the boot CPU */
+	__asm_invalidate_tlb_all();
+	set_ttbr_tcr_mair(el, gd->arch.tlb_addr, get_tcr(el, NULL, NULL),
+			  MEMORY_ATTRIBUTES);
+	set_sctlr(get_sctlr() | CR_M | CR_C | CR_I);
+
+	mp_task_worker();
+
+	dsb();
+	WRITE_ONCE(slot->done, 1);
+	dsb();
+	asm volatile("sev");
+
+	psci_cpu_off(0);
+	while (1)
+		asm volatile("wfi");
+}
+
+static int smp_work_get_cpus(void)
+{
+	const void *blob = gd->fdt_blob;
+	u64 self = read_mpidr() & MPIDR_AFF_MASK;
+	const fdt32_t *reg;
+	int cpus, node, cells, len;
+	int nr = 0;
+	u64 mpidr;
+
+	cpus = fdt_path_offset(blob, "/cpus");
+	if (cpus < 0)
+		return 0;
+
+	cells = fdt_address_cells(blob, cpus);
+	fdt_for_each_subnode(node, blob, cpus) {
+		if (nr >= SMP_WORK_MAX_CPUS)
+			break;
+
+		if (strcmp(fdt_getprop(blob, node, "device_type", NULL) ? :
+			   "", "cpu"))
+			continue;
+
+		reg = fdt_getprop(blob, node, "reg", &len);
+		if (!reg || len < cells * sizeof(*reg))
+			continue;
+
+		mpidr = fdt_read_number(reg, cells) & MPIDR_AFF_MASK;
+		if (mpidr == self)
+			continue;
+
+		smp_work_slots[nr].mpidr = mpidr;
+		smp_work_slots[nr].sp = (ulong)smp_work_stacks +
+					(nr + 1) * SMP_WORK_STACK_SIZE;
+		smp_work_slots[nr].gd = (ulong)gd;
+		nr++;
+	}
+
+	return nr;
+}
+
+static void *smp_work_alloc_stacks(void)
+{
+	ulong size = SMP_WORK_MAX_CPUS * SMP_WORK_STACK_SIZE;
+
+	if (sysmem_has_init())
+		return sysmem_alloc_by_name("smp-work", size);
+
+	return memalign(16, size);
+}
+
+int mp_task_pool_start(void)
+{
+	struct smp_work_slot *slot;
+	int i, ret;
+
+	if (mp_pool.started)
+		return mp_pool.nr_workers;
+	mp_pool.started = true;
+
+	/* The lock and the task states need cacheable memory */
+	if (!dcache_status())
+		return 0;
+
+	if (!smp_work_stacks)
+		smp_work_stacks = smp_work_alloc_stacks();
+	if (!smp_work_stacks)
+		return 0;
+
+	memset(smp_work_slots, 0, sizeof(smp_work_slots));
+	for (i = 0; i < SMP_WORK_MAX_CPUS; i++)
+		smp_work_slots[i].mpidr = ~0ULL;
+	mp_pool.stop = 0;
+	mp_pool.nr_workers = 0;
+	mp_pool.nr_slots = smp_work_get_cpus();
+
+	/* The secondary CPUs start with the MMU off, reading from memory */
+	if (mp_pool.nr_slots)
+		flush_dcache_all();
+
+	for (i = 0; i < mp_pool.nr_slots; i++) {
+		slot = &smp_work_slots[i];
+		ret = psci_cpu_on(slot->mpidr, (ulong)smp_work_entry);
+		if (ret) {
+			debug("%s: cpu %llx not started, ret=%d\n",
+			      __func__, slot->mpidr, ret);
+			continue;
+		}
+		slot->cpu = ++mp_pool.nr_workers;
+	}
+
+	debug("%s: %d workers\n", __func__, mp_pool.nr_workers);
+
+	return mp_pool.nr_workers;
+}
+
+void mp_task_pool_stop(void)
+{
+	struct smp_work_slot *slot;
+	ulong start;
+	int i;
+
+	if (!mp_pool.started)
+		return;
+
+	mp_task_wait_all();
+
+	dsb();
+	WRITE_ONCE(mp_pool.stop, 1);
+	dsb();
+	asm volatile("sev");
+
+	start = get_timer(0);
+	for (i = 0; i < mp_pool.nr_slots; i++) {
+		slot = &smp_work_slots[i];
+		if (!slot->cpu)
+			continue;
+
+		while (!READ_ONCE(slot->done) ||
+		       psci_affinity_info(slot->mpidr, 0) !=
+		       PSCI_AFFINITY_LEVEL_OFF) {
+			if (get_timer(start) > SMP_WORK_TIMEOUT_MS) {
+				printf("%s: cpu %llx not off\n",
+				       __func__, slot->mpidr);
+				break;
+			}
+		}
+	}
+
+	mp_pool.nr_workers = 0;
+	mp_pool.started = false;
+}
+
+void mp_task_submit(struct mp_task *task, mp_task_fn fn, void *arg)
+{
+	task->fn = fn;
+	task->arg = arg;
+	task->next = NULL;
+
+	if (!mp_task_pool_start()) {
+		fn(arg);
+		task->state = MP_TASK_DONE;
+		return;
+	}
+
+	task->state = MP_TASK_QUEUED;
+	__atomic_add_fetch(&mp_pool.pending, 1, __ATOMIC_RELAXED);
+
+	mp_pool_lock();
+	if (mp_pool.tail)
+		mp_pool.tail->next = task;
+	else
+		mp_pool.head = task;
+	mp_pool.tail = task;
+	mp_pool_unlock();
+
+	dsb();
+	asm volatile("sev");
+}
+
+/* Run queued tasks on this CPU until @done says to stop */
+static void mp_task_help(int *word, int done)
+{
+	struct mp_task *task;
+
+	while (__atomic_load_n(word, __ATOMIC_ACQUIRE) != done) {
+		task = mp_task_dequeue();
+		if (task)
+			mp_task_run(task);
+		else
+			asm volatile("wfe");
+	}
+}
+
+void mp_task_wait(struct mp_task *task)
+{
+	if (task->state == MP_TASK_IDLE)
+		return;
+
+	mp_task_help(&task->state, MP_TASK_DONE);
+}
+
+void mp_task_wait_all(void)
+{
+	mp_task_help(&mp_pool.pending, 0);
+}
+
+struct smp_work_task {
+	struct mp_task task;
+	smp_work_fn fn;
+	void *arg;
+	int cpu;
+	int nr_cpus;
+};
+
+static void smp_work_task_fn(void *arg)
+{
+	struct smp_work_task *work = arg;
+
+	work->fn(work->arg, work->cpu, work->nr_cpus);
+}
+
+int smp_work_run(smp_work_fn fn, void *arg)
+{
+	struct smp_work_task work[SMP_WORK_MAX_CPUS];
+	int nr, i;
+
+	nr = mp_task_pool_start() + 1;
+
+	for (i = 1; i < nr; i++) {
+		work[i - 1].fn = fn;
+		work[i - 1].arg = arg;
+		work[i - 1].cpu = i;
+		work[i - 1].nr_cpus = nr;
+		mp_task_submit(&work[i - 1].task, smp_work_task_fn,
+			       &work[i - 1]);
+	}
+
+	fn(arg, 0, nr);
+
+	for (i = 1; i < nr; i++)
+		mp_task_wait(&work[i - 1].task);
+
+	return nr;
+}
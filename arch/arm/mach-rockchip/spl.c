@@ -6,6 +6,7 @@
 
 #include <common.h>
 #include <version.h>
+#include <amp.h>
 #include <boot_rkimg.h>
 #include <debug_uart.h>
 #include <dm.h>
@@ -17,6 +18,7 @@
 #include <optee_include/OpteeClientInterface.h>
 #include <power/fuel_gauge.h>
 #include <asm/arch/bootrom.h>
+#include <asm/arch/fit.h>
 #ifdef CONFIG_ROCKCHIP_PRELOADER_ATAGS
 #include <asm/arch/rk_atags.h>
 #endif
@@ -233,6 +235,12 @@ void board_init_f(ulong dummy)
 		printf("DRAM init failed: %d\n", ret);
 		return;
 	}
+#endif
+#if !defined(CONFIG_SPL_SYS_DCACHE_OFF) && defined(CONFIG_SPL_SYS_DCACHE_LATE)
+	/* DRAM works from here, so it can be mapped cached */
+	ret = spl_dcache_enable();
+	if (ret)
+		printf("spl: dcache disabled, error %d\n", ret);
 #endif
 	preloader_console_init();
 #else
@@ -508,8 +516,7 @@ static void spl_fdt_fixup_memory(struct spl_image_info *spl_image)
 #if defined(CONFIG_SPL_ROCKCHIP_HWID_DTB)
 int spl_find_hwid_dtb(const char *fdt_name)
 {
-	hwid_init_data();
-
+	/* What was sampled for the names before is used again */
 	return hwid_dtb_is_available(fdt_name);
 }
 #endif
@@ -519,6 +526,8 @@ void spl_perform_fixups(struct spl_image_info *spl_image)
 {
 #ifdef CONFIG_ROCKCHIP_PRELOADER_ATAGS
 	atags_set_bootdev_by_spl_bootdevice(spl_image->boot_device);
+	fit_digest_set_atags(spl_image->boot_device);
+	amp_handoff_set_atags();
   #ifdef BUILD_SPL_TAG
 	atags_set_shared_fwver(FW_SPL, "spl-"BUILD_SPL_TAG);
   #endif
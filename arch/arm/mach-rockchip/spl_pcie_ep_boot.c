@@ -29,21 +29,29 @@
 #define PCIE_SNPS_IATU_BASE	0xa40300000
 
 #define PCI_RESBAR		0x2e8
+#define RKEP_EDMA_CHANNELS	2
 #elif CONFIG_ROCKCHIP_RK3568
 #define PCIE_SNPS_DBI_BASE	0xf6000000
 #define PCIE_SNPS_APB_BASE	0xfe280000
 #define PCIE_SNPS_IATU_BASE	0x3c0b00000
 
 #define PCI_RESBAR		0x2b8
+#define RKEP_EDMA_CHANNELS	2
 #else
 #error "this soc is not support pcie ep!"
 #endif
 
 #define RKEP_BAR0_ADDR		0x3c000000
 #define RKEP_BAR2_ADDR		CONFIG_SPL_LOAD_FIT_ADDRESS
+#define RKEP_BAR2_SIZE		0x4000000
 #define RKEP_BAR0_CMD_ADDR	(RKEP_BAR0_ADDR + 0x400)
+#define RKEP_BAR0_IMAGE_ADDR	(RKEP_BAR0_ADDR + 0x800)
 #define RKEP_BOOT_MAGIC		0x524b4550 /* RKEP */
 #define RKEP_CMD_LOADER_RUN	0x524b4501
+#define RKEP_CMD_EDMA_LOAD	0x524b4502
+
+/* features */
+#define RKEP_FEATURE_EDMA	BIT(0)
 
 #define PCI_EXP_LNKCAP		12	/* Link Capabilities */
 #define PCI_EXP_LNKCTL2		48	/* Link Control 2 */
@@ -80,6 +88,26 @@
 #define PCIE_ATU_CPU_ADDR_LOW		0x14
 #define PCIE_ATU_CPU_ADDR_HIGH		0x18
 
+/* Synopsys eDMA, unrolled registers behind the iATU ones */
+#define PCIE_SNPS_EDMA_BASE		(PCIE_SNPS_IATU_BASE + 0x80000)
+#define PCIE_DMA_RD_ENGINE_EN		0x2c
+#define PCIE_DMA_RD_DOORBELL		0x30
+#define PCIE_DMA_RD_INT_STATUS		0xa0
+#define PCIE_DMA_RD_INT_CLEAR		0xac
+#define PCIE_DMA_INT_DONE(ch)		BIT(ch)
+#define PCIE_DMA_INT_ABORT(ch)		BIT(16 + (ch))
+#define PCIE_DMA_RD_CH(ch)		(0x300 + (ch) * 0x200)
+#define PCIE_DMA_CH_CTRL1		0x00
+#define PCIE_DMA_CH_CTRL1_LIE		BIT(3)
+#define PCIE_DMA_CH_SIZE		0x08
+#define PCIE_DMA_CH_SAR_LOW		0x0c
+#define PCIE_DMA_CH_SAR_HIGH		0x10
+#define PCIE_DMA_CH_DAR_LOW		0x14
+#define PCIE_DMA_CH_DAR_HIGH		0x18
+
+#define RKEP_EDMA_MAX_IMAGES		16
+#define RKEP_EDMA_TIMEOUT_MS		5000
+
 /* SRNS: Use Separate refclk(internal clock) instead of from RC */
 // #define PCIE_ENABLE_SRNS_PLL_REFCLK
 
@@ -89,6 +117,31 @@ struct rkpcie_cmd {
 	u32 data[6];
 };
 
+/*
+ * An image for the eDMA to read from the RC, in the table at BAR0 + 0x800.
+ * The RC fills the entries in, sends CMD_EDMA_LOAD with the number of them
+ * in data[0], and may raise data[0] as it posts more, up to the one with
+ * RKEP_IMAGE_LAST. The EP sets the status of each entry as it is done, so
+ * the RC knows when it may reuse the host buffer.
+ */
+struct rkpcie_image {
+	u64 host_addr;
+	u32 size;
+	/* Offset in BAR2 to load to */
+	u32 offset;
+	u32 flags;
+	u32 status;
+	u32 reserved[2];
+};
+
+/* image flags */
+#define RKEP_IMAGE_LAST		BIT(0)
+
+/* image status */
+#define RKEP_IMAGE_PENDING	0
+#define RKEP_IMAGE_DONE		1
+#define RKEP_IMAGE_ERR		0xff
+
 /* rkep device mode status definition */
 #define RKEP_MODE_BOOTROM	1
 #define RKEP_MODE_LOADER	2
@@ -121,7 +174,9 @@ struct rkpcie_boot {
 		/* Error code for current CMD */
 		u16 opcode;
 	} cmd_status;
-	u32 reserved[2];
+	/* RKEP_FEATURE_* */
+	u32 features;
+	u32 reserved;
 	/* RK ATAGS, for mem and other info */
 	struct tag cap;
 	/* offset 0x400 */
@@ -235,6 +290,12 @@ static void pcie_bar0_header_init(void)
 	bh->devmode.mode = RKEP_MODE_LOADER;
 	bh->devmode.submode = RKEP_SMODE_INIT;
 	bh->cap_size = 0;
+	bh->features = 0;
+#ifdef CONFIG_SPL_PCIE_EP_EDMA
+	bh->features |= RKEP_FEATURE_EDMA;
+	memset((char *)RKEP_BAR0_IMAGE_ADDR, 0,
+	       sizeof(struct rkpcie_image) * RKEP_EDMA_MAX_IMAGES);
+#endif
 
 	memset((char *)RKEP_BAR0_CMD_ADDR, 0, sizeof(struct rkpcie_cmd));
 }
@@ -308,6 +369,131 @@ static void pcie_devmode_update(int mode, int submode)
 }
 
 #ifdef CONFIG_SPL_RAM_DEVICE
+#ifdef CONFIG_SPL_PCIE_EP_EDMA
+static void pcie_image_set_status(struct rkpcie_image *image, u32 status)
+{
+	writel(status, &image->status);
+	flush_dcache_range((ulong)image, (ulong)(image + 1));
+}
+
+static int pcie_edma_start(int ch, struct rkpcie_image *image)
+{
+	u64 base = PCIE_SNPS_EDMA_BASE + PCIE_DMA_RD_CH(ch);
+	u64 dst = RKEP_BAR2_ADDR + image->offset;
+
+	if (!image->size || image->offset > RKEP_BAR2_SIZE ||
+	    image->size > RKEP_BAR2_SIZE - image->offset) {
+		printep("Image 0x%x@0x%x is outside BAR2\n", image->size,
+			image->offset);
+		return -EINVAL;
+	}
+
+	writel(PCIE_DMA_CH_CTRL1_LIE, base + PCIE_DMA_CH_CTRL1);
+	writel(image->size, base + PCIE_DMA_CH_SIZE);
+	writel(lower_32_bits(image->host_addr), base + PCIE_DMA_CH_SAR_LOW);
+	writel(upper_32_bits(image->host_addr), base + PCIE_DMA_CH_SAR_HIGH);
+	writel(lower_32_bits(dst), base + PCIE_DMA_CH_DAR_LOW);
+	writel(upper_32_bits(dst), base + PCIE_DMA_CH_DAR_HIGH);
+	writel(ch, PCIE_SNPS_EDMA_BASE + PCIE_DMA_RD_DOORBELL);
+
+	return 0;
+}
+
+/*
+ * Read the images of the table from the RC with the eDMA read channels,
+ * one image per channel. A channel starts the next image posted as soon as
+ * it is done, so the RC can post the later loader stages while the earlier
+ * ones are read.
+ */
+static int pcie_edma_load(struct rkpcie_cmd *cmd)
+{
+	struct rkpcie_image *table = (struct rkpcie_image *)RKEP_BAR0_IMAGE_ADDR;
+	struct rkpcie_image *image;
+	ulong start[RKEP_EDMA_CHANNELS];
+	int busy[RKEP_EDMA_CHANNELS];
+	u32 posted, next = 0, status;
+	bool last = false, last_done = false;
+	int ch, ret = 0, nr_busy = 0;
+
+	for (ch = 0; ch < RKEP_EDMA_CHANNELS; ch++)
+		busy[ch] = -1;
+
+	/* Nothing dirty may be written back over what the DMA brings */
+	flush_dcache_range(RKEP_BAR2_ADDR, RKEP_BAR2_ADDR + RKEP_BAR2_SIZE);
+	writel(0x1, PCIE_SNPS_EDMA_BASE + PCIE_DMA_RD_ENGINE_EN);
+	writel(0xffffffff, PCIE_SNPS_EDMA_BASE + PCIE_DMA_RD_INT_CLEAR);
+
+	while (!last_done || nr_busy) {
+		invalidate_dcache_range(RKEP_BAR0_CMD_ADDR,
+					RKEP_BAR0_CMD_ADDR + 32);
+		posted = min_t(u32, readl(&cmd->data[0]), RKEP_EDMA_MAX_IMAGES);
+
+		for (ch = 0; ch < RKEP_EDMA_CHANNELS && !last; ch++) {
+			if (busy[ch] >= 0 || next >= posted)
+				continue;
+			image = &table[next];
+			invalidate_dcache_range((ulong)image, (ulong)(image + 1));
+			if (pcie_edma_start(ch, image)) {
+				pcie_image_set_status(image, RKEP_IMAGE_ERR);
+				ret = -EINVAL;
+				goto out;
+			}
+			last = image->flags & RKEP_IMAGE_LAST;
+			start[ch] = get_timer(0);
+			busy[ch] = next++;
+			nr_busy++;
+		}
+		if (!last && next >= RKEP_EDMA_MAX_IMAGES && !nr_busy) {
+			printep("No last image in %d\n", RKEP_EDMA_MAX_IMAGES);
+			ret = -EINVAL;
+			goto out;
+		}
+
+		status = readl(PCIE_SNPS_EDMA_BASE + PCIE_DMA_RD_INT_STATUS);
+		for (ch = 0; ch < RKEP_EDMA_CHANNELS; ch++) {
+			if (busy[ch] < 0)
+				continue;
+			image = &table[busy[ch]];
+			if (status & PCIE_DMA_INT_ABORT(ch)) {
+				printep("eDMA abort on image %d\n", busy[ch]);
+				ret = -EIO;
+			} else if (get_timer(start[ch]) > RKEP_EDMA_TIMEOUT_MS &&
+				   !(status & PCIE_DMA_INT_DONE(ch))) {
+				printep("eDMA timeout on image %d\n", busy[ch]);
+				ret = -ETIMEDOUT;
+			} else if (!(status & PCIE_DMA_INT_DONE(ch))) {
+				continue;
+			}
+			writel(PCIE_DMA_INT_DONE(ch) | PCIE_DMA_INT_ABORT(ch),
+			       PCIE_SNPS_EDMA_BASE + PCIE_DMA_RD_INT_CLEAR);
+			if (ret) {
+				pcie_image_set_status(image, RKEP_IMAGE_ERR);
+				goto out;
+			}
+			pcie_image_set_status(image, RKEP_IMAGE_DONE);
+			if (image->flags & RKEP_IMAGE_LAST)
+				last_done = true;
+			busy[ch] = -1;
+			nr_busy--;
+		}
+	}
+	printep("eDMA loaded %d images\n", next);
+
+out:
+	if (ret) {
+		/* Stop what is still running before the RC tries again */
+		for (ch = 0; ch < RKEP_EDMA_CHANNELS; ch++) {
+			if (busy[ch] >= 0)
+				writel(BIT(31) | ch, PCIE_SNPS_EDMA_BASE +
+				       PCIE_DMA_RD_DOORBELL);
+		}
+		writel(0xffffffff, PCIE_SNPS_EDMA_BASE + PCIE_DMA_RD_INT_CLEAR);
+	}
+
+	return ret;
+}
+#endif
+
 static void pcie_wait_for_fw(void)
 {
 	struct rkpcie_cmd *cmd = (struct rkpcie_cmd *)(RKEP_BAR0_CMD_ADDR);
@@ -324,13 +510,23 @@ static void pcie_wait_for_fw(void)
 		val = readl(&cmd->cmd);
 		if (val == RKEP_CMD_LOADER_RUN)
 			break;
+#ifdef CONFIG_SPL_PCIE_EP_EDMA
+		if (val == RKEP_CMD_EDMA_LOAD) {
+			if (!pcie_edma_load(cmd))
+				break;
+			/* The RC finds the image that failed and can retry */
+			writel(0, &cmd->cmd);
+			flush_dcache_range(RKEP_BAR0_CMD_ADDR,
+					   RKEP_BAR0_CMD_ADDR + 32);
+		}
+#endif
 		i++;
 		if (!(i % 10))
 			printep("Waiting for FW, CMD: %x\n", val);
 		mdelay(100);
 	}
 	/* Invalidate Cache for firmware area: BAR2, 64MB */
-	invalidate_dcache_range(RKEP_BAR2_ADDR, RKEP_BAR2_ADDR + 0x4000000);
+	invalidate_dcache_range(RKEP_BAR2_ADDR, RKEP_BAR2_ADDR + RKEP_BAR2_SIZE);
 	printep("Firmware Download complete!\n");
 }
 
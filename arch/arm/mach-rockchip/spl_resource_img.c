@@ -4,6 +4,7 @@
  */
 
 #include <common.h>
+#include <spl.h>
 #include <linux/list.h>
 #include <asm/arch/spl_resource_img.h>
 
@@ -30,11 +31,15 @@ int spl_resource_image_check_header(const struct resource_img_hdr *hdr)
 	return ret;
 }
 
+/*
+ * The dtb matching the board HW-ID if there is one, otherwise the default
+ * one. @hdr must hold the header and all the entries.
+ */
 struct resource_entry *spl_resource_image_get_dtb_entry(const struct
 							resource_img_hdr *hdr)
 {
+	struct resource_entry *entry, *dtb = NULL;
 	int i;
-	struct resource_entry *entry = NULL;
 
 	if (!hdr)
 		return NULL;
@@ -42,9 +47,16 @@ struct resource_entry *spl_resource_image_get_dtb_entry(const struct
 	for (i = 0; i < hdr->e_nums; i++) {
 		entry = (struct resource_entry *)((char *)hdr
 				+ (hdr->blks + hdr->e_blks * i) * 512);
-		if (!memcmp(entry->name, DEFAULT_DTB_FILE, strlen(DEFAULT_DTB_FILE)))
-			break;
+#if defined(CONFIG_SPL_ROCKCHIP_HWID_DTB)
+		if (spl_find_hwid_dtb(entry->name)) {
+			printf("HWID DTB: %s\n", entry->name);
+			return entry;
+		}
+#endif
+		if (!dtb && !memcmp(entry->name, DEFAULT_DTB_FILE,
+				    strlen(DEFAULT_DTB_FILE)))
+			dtb = entry;
 	}
 
-	return entry;
+	return dtb;
 }
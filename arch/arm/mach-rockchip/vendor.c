@@ -132,6 +132,17 @@ static struct vendor_info vendor_info;
 /* The storage type of the device */
 static int bootdev_type;
 
+/*
+ * Item slot + 1 of each id below VENDOR_INDEX_IDS, 0 if it has no item, so
+ * that the ids in use don't need a walk through the item table.
+ */
+#define VENDOR_INDEX_IDS	64
+static u8 vendor_index[VENDOR_INDEX_IDS];
+
+/* Nesting of vendor_storage_begin(), and items changed in RAM only */
+static int vendor_batch;
+static bool vendor_dirty;
+
 #ifdef CONFIG_MTD_BLK
 static struct mtd_flash_info s_flash_info;
 static const char *vendor_mtd_name = "vnvm";
@@ -311,6 +322,34 @@ re_write:
 /**********************************************************/
 /*              vendor API implementation                 */
 /**********************************************************/
+static void vendor_index_build(void)
+{
+	int i;
+
+	memset(vendor_index, 0, sizeof(vendor_index));
+	/* Backwards, so the first item of a repeated id wins as in a walk */
+	for (i = vendor_info.hdr->item_num - 1; i >= 0; i--) {
+		if (vendor_info.item[i].id < VENDOR_INDEX_IDS)
+			vendor_index[vendor_info.item[i].id] = i + 1;
+	}
+}
+
+/* The slot of the item of @id, -1 if there is none */
+static int vendor_find_item(u16 id)
+{
+	u32 i;
+
+	if (id < VENDOR_INDEX_IDS)
+		return vendor_index[id] - 1;
+
+	for (i = 0; i < vendor_info.hdr->item_num; i++) {
+		if (vendor_info.item[i].id == id)
+			return i;
+	}
+
+	return -1;
+}
+
 static int vendor_ops(u8 *buffer, u32 addr, u32 n_sec, int write)
 {
 	struct blk_desc *dev_desc;
@@ -570,6 +609,8 @@ int vendor_storage_init(void)
 out:
 	if (ret)
 		bootdev_type = 0;
+	else
+		vendor_index_build();
 
 	return ret;
 }
@@ -597,6 +638,16 @@ void vendor_storage_fixup(void *blob)
 	}
 }
 
+/*
+ * Whether vendor storage is loaded already. For the drivers of the boot
+ * device, which can't have vendor_storage_read() load it from the device
+ * they are still setting up.
+ */
+int vendor_storage_ready(void)
+{
+	return bootdev_type != 0;
+}
+
 /*
  * @id: item id, first 4 id is occupied:
  *	VENDOR_SN_ID
@@ -611,8 +662,7 @@ void vendor_storage_fixup(void *blob)
 int vendor_storage_read(u16 id, void *pbuf, u16 size)
 {
 	int ret = 0;
-	u32 i;
-	u16 offset;
+	int i;
 	struct vendor_item *item;
 
 	/* init vendor storage */
@@ -622,21 +672,109 @@ int vendor_storage_read(u16 id, void *pbuf, u16 size)
 			return ret;
 	}
 
-	item = vendor_info.item;
-	for (i = 0; i < vendor_info.hdr->item_num; i++) {
-		if ((item + i)->id == id) {
-			debug("[Vendor INFO]:Find the matching item, id=%d\n", id);
-			/* Correct the size value */
-			if (size > (item + i)->size)
-				size = (item + i)->size;
-			offset = (item + i)->offset;
-			memcpy(pbuf, (vendor_info.data + offset), size);
-			return size;
-		}
+	i = vendor_find_item(id);
+	if (i < 0) {
+		debug("[Vendor ERROR]:No matching item, id=%d\n", id);
+		return -EINVAL;
 	}
-	debug("[Vendor ERROR]:No matching item, id=%d\n", id);
 
-	return -EINVAL;
+	debug("[Vendor INFO]:Find the matching item, id=%d\n", id);
+	item = vendor_info.item + i;
+	/* Correct the size value */
+	if (size > item->size)
+		size = item->size;
+	memcpy(pbuf, (vendor_info.data + item->offset), size);
+
+	return size;
+}
+
+/* Write the vendor info in RAM to the next of the vendor parts */
+static int vendor_save(void)
+{
+	u16 part_size, part_num;
+	u32 next_index;
+	int cnt;
+
+	switch (bootdev_type) {
+	case IF_TYPE_MMC:
+	case IF_TYPE_SCSI:
+		part_size = EMMC_VENDOR_PART_BLKS;
+		part_num = VENDOR_PART_NUM;
+		break;
+	case IF_TYPE_RKNAND:
+	case IF_TYPE_SPINAND:
+		part_size = NAND_VENDOR_PART_BLKS;
+		part_num = NAND_VENDOR_PART_NUM;
+		break;
+	case IF_TYPE_SPINOR:
+		part_size = FLASH_VENDOR_PART_BLKS;
+		part_num = VENDOR_PART_NUM;
+		break;
+#ifdef CONFIG_MTD_BLK
+	case IF_TYPE_MTD:
+		part_size = FLASH_VENDOR_PART_BLKS;
+		part_num = MTD_VENDOR_PART_NUM;
+		break;
+#endif
+	default:
+		return -ENODEV;
+	}
+
+	next_index = vendor_info.hdr->next_index;
+	vendor_info.hdr->version++;
+	*(vendor_info.version2) = vendor_info.hdr->version;
+	vendor_info.hdr->next_index++;
+	if (vendor_info.hdr->next_index >= part_num)
+		vendor_info.hdr->next_index = 0;
+	cnt = vendor_ops((u8 *)vendor_info.hdr, part_size * next_index, part_size, 1);
+
+	return (cnt == part_size) ? 0 : -EIO;
+}
+
+/* An item of @size bytes changed in RAM: write it now or at the commit */
+static int vendor_update(u16 size)
+{
+	int ret;
+
+	if (vendor_batch) {
+		vendor_dirty = true;
+		return size;
+	}
+
+	ret = vendor_save();
+
+	return ret < 0 ? ret : size;
+}
+
+/*
+ * Group the writes of several items into one write of the vendor part:
+ * vendor_storage_write() after this only changes the items in RAM, the
+ * matching vendor_storage_commit() writes them out. Pairs may nest, the
+ * outermost commit writes.
+ *
+ * return: 0;
+ */
+int vendor_storage_begin(void)
+{
+	/* Loaded by the first write, a group without any costs nothing */
+	vendor_batch++;
+
+	return 0;
+}
+
+/*
+ * End a group of writes started by vendor_storage_begin().
+ *
+ * return: 0 on success or if nothing changed, other fail;
+ */
+int vendor_storage_commit(void)
+{
+	if (!vendor_batch || --vendor_batch || !vendor_dirty)
+		return 0;
+
+	vendor_dirty = false;
+
+	return vendor_save();
 }
 
 /*
@@ -652,10 +790,10 @@ int vendor_storage_read(u16 id, void *pbuf, u16 size)
  */
 int vendor_storage_write(u16 id, void *pbuf, u16 size)
 {
-	u32 i, j, next_index, align_size, alloc_size, next_size;
-	u16 part_size, max_item_num, offset, part_num;
+	u32 j, align_size, alloc_size, next_size;
+	u16 max_item_num, offset;
 	struct vendor_item *item;
-	int cnt, ret = 0;
+	int i, ret = 0;
 
 	/* init vendor storage */
 	if (!bootdev_type) {
@@ -667,26 +805,18 @@ int vendor_storage_write(u16 id, void *pbuf, u16 size)
 	switch (bootdev_type) {
 	case IF_TYPE_MMC:
 	case IF_TYPE_SCSI:
-		part_size = EMMC_VENDOR_PART_BLKS;
 		max_item_num = EMMC_VENDOR_ITEM_NUM;
-		part_num = VENDOR_PART_NUM;
 		break;
 	case IF_TYPE_RKNAND:
 	case IF_TYPE_SPINAND:
-		part_size = NAND_VENDOR_PART_BLKS;
 		max_item_num = NAND_VENDOR_ITEM_NUM;
-		part_num = NAND_VENDOR_PART_NUM;
 		break;
 	case IF_TYPE_SPINOR:
-		part_size = FLASH_VENDOR_PART_BLKS;
 		max_item_num = FLASH_VENDOR_ITEM_NUM;
-		part_num = VENDOR_PART_NUM;
 		break;
 #ifdef CONFIG_MTD_BLK
 	case IF_TYPE_MTD:
-		part_size = FLASH_VENDOR_PART_BLKS;
 		max_item_num = FLASH_VENDOR_ITEM_NUM;
-		part_num = MTD_VENDOR_PART_NUM;
 		break;
 #endif
 	default:
@@ -697,7 +827,6 @@ int vendor_storage_write(u16 id, void *pbuf, u16 size)
 	if (ret < 0)
 		return ret;
 
-	next_index = vendor_info.hdr->next_index;
 	/* algin to 64 bytes*/
 	align_size = (size + VENDOR_BTYE_ALIGN) & (~VENDOR_BTYE_ALIGN);
 	if (size > align_size)
@@ -705,45 +834,41 @@ int vendor_storage_write(u16 id, void *pbuf, u16 size)
 
 	item = vendor_info.item;
 	/* If item already exist, update the item data */
-	for (i = 0; i < vendor_info.hdr->item_num; i++) {
-		if ((item + i)->id == id) {
-			alloc_size = ((item + i)->size + VENDOR_BTYE_ALIGN) & (~VENDOR_BTYE_ALIGN);
-			if (size > alloc_size) {
-				if (vendor_info.hdr->free_size < align_size)
-					return -EINVAL;
-				debug("[Vendor INFO]:Find the matching item, id=%d and resize\n", id);
-				offset = (item + i)->offset;
-				for (j = i; j < vendor_info.hdr->item_num - 1; j++) {
-					(item + j)->id = (item + j + 1)->id;
-					(item + j)->size = (item + j + 1)->size;
-					(item + j)->offset = offset;
-
-					next_size = ((item + j + 1)->size + VENDOR_BTYE_ALIGN) & (~VENDOR_BTYE_ALIGN);
-					memcpy((vendor_info.data + offset),
-					       (vendor_info.data + (item + j + 1)->offset),
-					       next_size);
-					offset += next_size;
-				}
-				(item + j)->id = id;
+	i = vendor_find_item(id);
+	if (i >= 0) {
+		alloc_size = ((item + i)->size + VENDOR_BTYE_ALIGN) & (~VENDOR_BTYE_ALIGN);
+		if (size > alloc_size) {
+			if (vendor_info.hdr->free_size < align_size)
+				return -EINVAL;
+			debug("[Vendor INFO]:Find the matching item, id=%d and resize\n", id);
+			offset = (item + i)->offset;
+			for (j = i; j < vendor_info.hdr->item_num - 1; j++) {
+				(item + j)->id = (item + j + 1)->id;
+				(item + j)->size = (item + j + 1)->size;
 				(item + j)->offset = offset;
-				(item + j)->size = size;
-				memcpy((vendor_info.data + offset), pbuf, size);
-				vendor_info.hdr->free_offset = offset + align_size;
-				vendor_info.hdr->free_size -= align_size - alloc_size;
-			} else {
-				debug("[Vendor INFO]:Find the matching item, id=%d\n", id);
-				offset = (item + i)->offset;
-				memcpy((vendor_info.data + offset), pbuf, size);
-				(item + i)->size = size;
+
+				next_size = ((item + j + 1)->size + VENDOR_BTYE_ALIGN) & (~VENDOR_BTYE_ALIGN);
+				memcpy((vendor_info.data + offset),
+				       (vendor_info.data + (item + j + 1)->offset),
+				       next_size);
+				offset += next_size;
 			}
-			vendor_info.hdr->version++;
-			*(vendor_info.version2) = vendor_info.hdr->version;
-			vendor_info.hdr->next_index++;
-			if (vendor_info.hdr->next_index >= part_num)
-				vendor_info.hdr->next_index = 0;
-			cnt = vendor_ops((u8 *)vendor_info.hdr, part_size * next_index, part_size, 1);
-			return (cnt == part_size) ? size : -EIO;
+			(item + j)->id = id;
+			(item + j)->offset = offset;
+			(item + j)->size = size;
+			memcpy((vendor_info.data + offset), pbuf, size);
+			vendor_info.hdr->free_offset = offset + align_size;
+			vendor_info.hdr->free_size -= align_size - alloc_size;
+			/* The items after it moved down a slot */
+			vendor_index_build();
+		} else {
+			debug("[Vendor INFO]:Find the matching item, id=%d\n", id);
+			offset = (item + i)->offset;
+			memcpy((vendor_info.data + offset), pbuf, size);
+			(item + i)->size = size;
 		}
+
+		return vendor_update(size);
 	}
 	/*
 	 * If item does not exist, and free size is enough,
@@ -761,14 +886,10 @@ int vendor_storage_write(u16 id, void *pbuf, u16 size)
 		vendor_info.hdr->free_size -= align_size;
 		memcpy((vendor_info.data + item->offset), pbuf, size);
 		vendor_info.hdr->item_num++;
-		vendor_info.hdr->version++;
-		vendor_info.hdr->next_index++;
-		*(vendor_info.version2) = vendor_info.hdr->version;
-		if (vendor_info.hdr->next_index >= part_num)
-			vendor_info.hdr->next_index = 0;
+		if (id < VENDOR_INDEX_IDS)
+			vendor_index[id] = vendor_info.hdr->item_num;
 
-		cnt = vendor_ops((u8 *)vendor_info.hdr, part_size * next_index, part_size, 1);
-		return (cnt == part_size) ? size : -EIO;
+		return vendor_update(size);
 	}
 	debug("[Vendor ERROR]:Vendor has no space left!\n");
 
@@ -818,6 +939,7 @@ static void vendor_test_reset(void)
 	vendor_info.hdr->free_size = (unsigned long)vendor_info.hash -
 				     (unsigned long)vendor_info.data;
 	*(vendor_info.version2) = vendor_info.hdr->version;
+	vendor_index_build();
 	/* write to flash. */
 	for (i = 0; i < part_num; i++)
 		vendor_ops((u8 *)vendor_info.hdr, part_size * i, part_size, 1);
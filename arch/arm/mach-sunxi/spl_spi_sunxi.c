@@ -285,7 +285,7 @@ static int spl_spi_load_image(struct spl_image_info *spl_image,
 
         if (IS_ENABLED(CONFIG_SPL_LOAD_FIT) &&
 		image_get_magic(header) == FDT_MAGIC) {
-		struct spl_load_info load;
+		struct spl_load_info load = { 0 };
 
 		debug("Found FIT image\n");
 		load.dev = NULL;
@@ -187,6 +187,38 @@ static void atags_print_tag(struct tag *t)
 		for (i = 0; i < FW_MAX; i++)
 			printf("    ver[%d] = %s\n", i, t->u.fwver.ver[i]);
 		break;
+	case ATAG_FIT_DIGEST:
+		printf("[fit digest]:\n");
+		printf("     magic = 0x%x\n", t->hdr.magic);
+		printf("      size = 0x%x\n\n", t->hdr.size << 2);
+		printf("   version = 0x%x\n", t->u.fit_digest.version);
+		printf("   devtype = 0x%x\n", t->u.fit_digest.devtype);
+		printf("     count = %d\n", t->u.fit_digest.count);
+		for (i = 0; i < t->u.fit_digest.count && i < FIT_DIGEST_MAX; i++)
+			printf(" digest[%d] = 0x%x@0x%llx\n", i,
+			       t->u.fit_digest.digest[i].size,
+			       t->u.fit_digest.digest[i].offset);
+		break;
+	case ATAG_AMP:
+		printf("[amp]:\n");
+		printf("     magic = 0x%x\n", t->hdr.magic);
+		printf("      size = 0x%x\n\n", t->hdr.size << 2);
+		printf("   version = 0x%x\n", t->u.amp.version);
+		printf("     count = %d\n", t->u.amp.count);
+		for (i = 0; i < t->u.amp.count && i < AMP_CPU_MAX; i++)
+			printf("    cpu[%x] = %.*s, 0x%x@0x%08x, state 0x%x\n",
+			       t->u.amp.cpu[i].cpu, AMP_NAME_LEN,
+			       t->u.amp.cpu[i].name, t->u.amp.cpu[i].size,
+			       t->u.amp.cpu[i].load, t->u.amp.cpu[i].pe_state);
+		break;
+	case ATAG_AB:
+		printf("[ab]:\n");
+		printf("     magic = 0x%x\n", t->hdr.magic);
+		printf("      size = 0x%x\n\n", t->hdr.size << 2);
+		printf("   version = 0x%x\n", t->u.ab.version);
+		printf("     flags = 0x%x\n", t->u.ab.flags);
+		printf("      misc = 0x%llx\n", t->u.ab.misc_start);
+		break;
 	default:
 		printf("%s: magic(%x) is not support\n", __func__, t->hdr.magic);
 	}
@@ -0,0 +1,455 @@
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ *
+ * Throughput of the hash algorithms and decompressors on the target, in
+ * software and on the crypto and decompression engines, for choosing the
+ * kernel compression and image hash of a SoC.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <crypto.h>
+#include <div64.h>
+#include <hash.h>
+#include <malloc.h>
+#include <misc.h>
+#include <linux/lzo.h>
+#include <linux/sizes.h>
+#include <lzma/LzmaTools.h>
+#include <u-boot/lz4.h>
+#include <asm/unaligned.h>
+
+#define BENCH_MIN_MS		200	/* each test runs at least this long */
+#define BENCH_MAX_ALIGN		64
+#define BENCH_DECOMP_SIZE	SZ_8M
+#define BENCH_DECOMP_MAX	SZ_32M
+#define BENCH_LZ4_BLOCK		SZ_4M
+#define BENCH_DIGEST_MAX	64	/* sha512 */
+
+static const ulong bench_hash_sizes[] = { SZ_4K, SZ_64K, SZ_1M, SZ_16M };
+
+/* Error, or bytes made in one run */
+typedef long (*bench_fn)(void *arg);
+
+struct bench_buf {
+	u8 *src;
+	ulong src_len;
+	u8 *dst;
+	ulong dst_len;
+};
+
+/* Run @fn as often as fits in BENCH_MIN_MS and print the MB/s */
+static void bench_run(const char *name, ulong size, bench_fn fn, void *arg)
+{
+	ulong start, ms, runs = 0;
+	u64 bytes = 0;
+	long ret;
+
+	start = get_timer(0);
+	do {
+		ret = fn(arg);
+		if (ret < 0) {
+			printf("%-18s %8luK  failed (%ld)\n", name, size >> 10,
+			       ret);
+			return;
+		}
+		bytes += ret;
+		runs++;
+		ms = get_timer(start);
+	} while (ms < BENCH_MIN_MS);
+
+	/* MB/s is bytes per us */
+	bytes = lldiv(bytes * 100, ms * 1000);
+	printf("%-18s %8luK %6lu %7llu.%02llu MB/s\n", name, size >> 10, runs,
+	       bytes / 100, bytes % 100);
+}
+
+/* Text-like data, so that the decompressors have something to do */
+static void bench_fill(u8 *buf, ulong len)
+{
+	static const char words[] = "the boot image and its kernel ";
+	u32 x = 0x2545f491;
+	ulong i;
+
+	for (i = 0; i < len; i++) {
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		buf[i] = (x & 0x30) ? words[i % (sizeof(words) - 1)] : x >> 24;
+	}
+}
+
+static struct hash_algo *bench_algo;
+
+static long bench_sw_hash(void *arg)
+{
+	struct bench_buf *b = arg;
+	u8 out[BENCH_DIGEST_MAX];
+
+	bench_algo->hash_func_ws(b->src, b->src_len, out,
+				 bench_algo->chunk_size);
+
+	return b->src_len;
+}
+
+#ifdef CONFIG_DM_CRYPTO
+static struct udevice *bench_crypto;
+static u32 bench_crypto_algo;
+
+static long bench_hw_hash(void *arg)
+{
+	struct bench_buf *b = arg;
+	u8 out[BENCH_DIGEST_MAX];
+	sha_context ctx = {
+		.algo = bench_crypto_algo,
+		.length = b->src_len,
+	};
+	int ret;
+
+	ret = crypto_sha_csum(bench_crypto, &ctx, (char *)b->src, b->src_len,
+			      out);
+
+	return ret ? ret : b->src_len;
+}
+
+static const struct {
+	u32 algo;
+	const char *name;
+} bench_crypto_algos[] = {
+	{ CRYPTO_MD5, "md5" },
+	{ CRYPTO_SHA1, "sha1" },
+	{ CRYPTO_SHA256, "sha256" },
+	{ CRYPTO_SHA512, "sha512" },
+	{ CRYPTO_SM3, "sm3" },
+};
+#endif
+
+static void bench_hash(struct bench_buf *b)
+{
+	static const char *const names[] = {
+		"crc32", "md5", "sha1", "sha256", "sha384", "sha512",
+	};
+	char name[32];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		if (hash_lookup_algo(names[i], &bench_algo))
+			continue;
+		snprintf(name, sizeof(name), "%s (cpu)", names[i]);
+		bench_run(name, b->src_len, bench_sw_hash, b);
+	}
+
+#ifdef CONFIG_DM_CRYPTO
+	for (i = 0; i < ARRAY_SIZE(bench_crypto_algos); i++) {
+		bench_crypto_algo = bench_crypto_algos[i].algo;
+		bench_crypto = crypto_get_device(bench_crypto_algo);
+		if (!bench_crypto)
+			continue;
+		snprintf(name, sizeof(name), "%s (%s)",
+			 bench_crypto_algos[i].name, bench_crypto->name);
+		bench_run(name, b->src_len, bench_hw_hash, b);
+	}
+#endif
+}
+
+static int do_bench_hash(cmd_tbl_t *cmdtp, int flag, int argc,
+			 char * const argv[])
+{
+	ulong size = 0, align = 0, max = bench_hash_sizes[3];
+	struct bench_buf b;
+	u8 *mem;
+	int i;
+
+	if (argc > 1)
+		size = max = ustrtoul(argv[1], NULL, 0);
+	if (argc > 2)
+		align = simple_strtoul(argv[2], NULL, 0);
+	if ((argc > 1 && !size) || align >= BENCH_MAX_ALIGN)
+		return CMD_RET_USAGE;
+
+	mem = memalign(BENCH_MAX_ALIGN, max + BENCH_MAX_ALIGN);
+	if (!mem) {
+		printf("No memory for %luK\n", max >> 10);
+		return CMD_RET_FAILURE;
+	}
+	b.src = mem + align;
+	bench_fill(b.src, max);
+
+	printf("%-18s %9s %6s %12s (buffer offset %lu)\n", "Hash", "Size",
+	       "Runs", "Speed", align);
+	for (i = 0; i < ARRAY_SIZE(bench_hash_sizes); i++) {
+		b.src_len = size ? size : bench_hash_sizes[i];
+		bench_hash(&b);
+		if (size)
+			break;
+	}
+	free(mem);
+
+	return CMD_RET_SUCCESS;
+}
+
+#ifdef CONFIG_GZIP
+static long bench_gunzip(void *arg)
+{
+	struct bench_buf *b = arg;
+	unsigned long len = b->src_len;
+	int offset, ret;
+
+	/* zunzip() is the decoder, gunzip() may hand it to the engine */
+	offset = gzip_parse_header(b->src, len);
+	if (offset < 0)
+		return offset;
+	ret = zunzip(b->dst, b->dst_len, b->src, &len, 1, offset);
+
+	return ret ? -EINVAL : len;
+}
+#endif
+
+#ifdef CONFIG_LZ4
+static long bench_unlz4(void *arg)
+{
+	struct bench_buf *b = arg;
+	size_t len = b->dst_len;
+	int ret;
+
+	ret = ulz4fn(b->src, b->src_len, b->dst, &len);
+
+	return ret ? ret : len;
+}
+#endif
+
+#ifdef CONFIG_LZMA
+static long bench_unlzma(void *arg)
+{
+	struct bench_buf *b = arg;
+	SizeT len = b->dst_len;
+	int ret;
+
+	ret = lzmaBuffToBuffDecompress(b->dst, &len, b->src, b->src_len);
+
+	return ret ? -EINVAL : len;
+}
+#endif
+
+#ifdef CONFIG_LZO
+static long bench_unlzo(void *arg)
+{
+	struct bench_buf *b = arg;
+	size_t len = b->dst_len;
+	int ret;
+
+	ret = lzop_decompress(b->src, b->src_len, b->dst, &len);
+
+	return ret ? -EINVAL : len;
+}
+#endif
+
+#ifdef CONFIG_MISC_DECOMPRESS
+static u32 bench_decom_cap;
+
+static long bench_hw_decomp(void *arg)
+{
+	struct bench_buf *b = arg;
+	u64 len = b->dst_len;
+	int ret;
+
+	ret = misc_decompress_process((ulong)b->dst, (ulong)b->src,
+				      b->src_len, bench_decom_cap, true, &len,
+				      0);
+
+	return ret ? ret : len;
+}
+#endif
+
+static const struct {
+	const char *name;
+	bench_fn fn;
+	u32 decom_cap;		/* of the engine, 0 if it has none */
+} bench_decomps[] = {
+#ifdef CONFIG_GZIP
+	{ "gzip", bench_gunzip, DECOM_GZIP },
+#endif
+#ifdef CONFIG_LZ4
+	{ "lz4", bench_unlz4, DECOM_LZ4 },
+#endif
+#ifdef CONFIG_LZMA
+	{ "lzma", bench_unlzma, 0 },
+#endif
+#ifdef CONFIG_LZO
+	{ "lzo", bench_unlzo, 0 },
+#endif
+};
+
+/* Decompress @b with the CPU and with the engine, if it takes @name */
+static void bench_decomp(const char *name, struct bench_buf *b, ulong size)
+{
+	char label[32];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bench_decomps); i++) {
+		if (strcmp(bench_decomps[i].name, name))
+			continue;
+		snprintf(label, sizeof(label), "%s (cpu)", name);
+		bench_run(label, size, bench_decomps[i].fn, b);
+#ifdef CONFIG_MISC_DECOMPRESS
+		bench_decom_cap = bench_decomps[i].decom_cap;
+		if (bench_decom_cap &&
+		    misc_get_device_by_capability(bench_decom_cap)) {
+			snprintf(label, sizeof(label), "%s (engine)", name);
+			bench_run(label, size, bench_hw_decomp, b);
+		}
+#endif
+		return;
+	}
+	printf("%-18s not built in\n", name);
+}
+
+#if defined(CONFIG_LZ4) && defined(CONFIG_LZ4_COMPRESS)
+/*
+ * An LZ4 frame of independent blocks: version 1, 4M blocks and no
+ * checksums, which makes the header checksum byte 0x73.
+ */
+static long bench_lz4_frame(u8 *dst, ulong cap, const u8 *src, ulong len)
+{
+	static const u8 hdr[] = { 0x04, 0x22, 0x4d, 0x18, 0x60, 0x70, 0x73 };
+	u8 *p = dst, *end = dst + cap;
+	ulong n;
+	int clen;
+
+	if (cap < sizeof(hdr) + 4)
+		return -ENOSPC;
+	memcpy(p, hdr, sizeof(hdr));
+	p += sizeof(hdr);
+	while (len) {
+		n = min_t(ulong, len, BENCH_LZ4_BLOCK);
+		if (end - p < 8)
+			return -ENOSPC;
+		clen = LZ4_compress_default((const char *)src, (char *)p + 4,
+					    n, end - p - 8);
+		if (!clen)
+			return -ENOSPC;
+		put_unaligned_le32(clen, p);
+		p += 4 + clen;
+		src += n;
+		len -= n;
+	}
+	put_unaligned_le32(0, p);	/* end mark */
+
+	return p + 4 - dst;
+}
+#endif
+
+/* Compress @size bytes of generated data for each format U-Boot can make */
+static int bench_decomp_generated(ulong size)
+{
+	struct bench_buf b;
+	u8 *raw;
+	long len;
+
+	raw = memalign(ARCH_DMA_MINALIGN, size);
+	b.src = memalign(ARCH_DMA_MINALIGN, size + SZ_64K);
+	b.dst = memalign(ARCH_DMA_MINALIGN, size);
+	b.dst_len = size;
+	if (!raw || !b.src || !b.dst) {
+		printf("No memory for %luK\n", size >> 10);
+		len = -ENOMEM;
+		goto out;
+	}
+	bench_fill(raw, size);
+
+	printf("%-18s %9s %6s %12s (decompressed)\n", "Decompressor", "Size",
+	       "Runs", "Speed");
+#if defined(CONFIG_GZIP) && defined(CONFIG_GZIP_COMPRESSED)
+	b.src_len = size + SZ_64K;
+	if (!gzip(b.src, &b.src_len, raw, size))
+		bench_decomp("gzip", &b, size);
+	else
+		printf("%-18s can't compress\n", "gzip");
+#endif
+#if defined(CONFIG_LZ4) && defined(CONFIG_LZ4_COMPRESS)
+	len = bench_lz4_frame(b.src, size + SZ_64K, raw, size);
+	if (len > 0) {
+		b.src_len = len;
+		bench_decomp("lz4", &b, size);
+	} else {
+		printf("%-18s can't compress\n", "lz4");
+	}
+#endif
+	len = 0;
+out:
+	free(b.dst);
+	free(b.src);
+	free(raw);
+
+	return len ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
+
+static int do_bench_decomp(cmd_tbl_t *cmdtp, int flag, int argc,
+			   char * const argv[])
+{
+	struct bench_buf b;
+	ulong size;
+
+	if (argc <= 2) {
+		size = argc > 1 ? ustrtoul(argv[1], NULL, 0) : BENCH_DECOMP_SIZE;
+		if (!size)
+			return CMD_RET_USAGE;
+		return bench_decomp_generated(size);
+	}
+	if (argc < 4)
+		return CMD_RET_USAGE;
+
+	/* Data from elsewhere, e.g. a kernel in each of the formats */
+	b.src = (u8 *)simple_strtoul(argv[2], NULL, 16);
+	b.src_len = simple_strtoul(argv[3], NULL, 16);
+	b.dst_len = argc > 4 ? ustrtoul(argv[4], NULL, 0) : BENCH_DECOMP_MAX;
+	b.dst = memalign(ARCH_DMA_MINALIGN, b.dst_len);
+	if (!b.dst) {
+		printf("No memory for %luK\n", b.dst_len >> 10);
+		return CMD_RET_FAILURE;
+	}
+
+	printf("%-18s %9s %6s %12s (decompressed)\n", "Decompressor",
+	       "Input", "Runs", "Speed");
+	bench_decomp(argv[1], &b, b.src_len);
+	free(b.dst);
+
+	return CMD_RET_SUCCESS;
+}
+
+static cmd_tbl_t cmd_bench_sub[] = {
+	U_BOOT_CMD_MKENT(hash, 3, 0, do_bench_hash, "", ""),
+	U_BOOT_CMD_MKENT(decomp, 5, 0, do_bench_decomp, "", ""),
+};
+
+static int do_bench(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
+{
+	cmd_tbl_t *c;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	/* Strip off leading argument */
+	argc--;
+	argv++;
+
+	c = find_cmd_tbl(argv[0], &cmd_bench_sub[0], ARRAY_SIZE(cmd_bench_sub));
+	if (!c)
+		return CMD_RET_USAGE;
+
+	return c->cmd(cmdtp, flag, argc, argv);
+}
+
+U_BOOT_CMD(
+	bench, 6, 0, do_bench,
+	"time the hash algorithms and decompressors",
+	"hash [<size> [<offset>]]  - every hash on the CPU and the crypto\n"
+	"                                  engines, 4K to 16M or <size> bytes\n"
+	"bench decomp [<size>]           - gzip and lz4 of <size> generated bytes,\n"
+	"                                  8M by default\n"
+	"bench decomp <alg> <addr> <len> [<max>]\n"
+	"                                - decompress <len> bytes of gzip, lz4, lzma\n"
+	"                                  or lzo at <addr>, on the CPU and engine"
+);
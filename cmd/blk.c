@@ -5,6 +5,7 @@
  */
 
 #include <common.h>
+#include <blk.h>
 #include <dm.h>
 
 static int blk_curr_iftype;  /* 0: IF_TYPE_UNKNOWN */
@@ -15,6 +16,18 @@ static int do_blk(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	int curr_iftype;
 	int curr_dev;
 
+#if CONFIG_IS_ENABLED(BLK_STATS)
+	if (argc >= 2 && !strcmp(argv[1], "stat")) {
+		if (argc == 2)
+			blk_stats_show();
+		else if (argc == 3 && !strcmp(argv[2], "reset"))
+			blk_stats_reset();
+		else
+			return CMD_RET_USAGE;
+		return CMD_RET_SUCCESS;
+	}
+#endif
+
 	if (argc < 4)
 		return CMD_RET_USAGE;
 
@@ -46,5 +59,8 @@ U_BOOT_CMD(
 	"blk read  <addr> <blk#> cnt\n"
 	"blk write <addr> <blk#> cnt\n"
 	"blk erase <blk#> cnt\n"
+#if CONFIG_IS_ENABLED(BLK_STATS)
+	"blk stat [reset] - show or clear the I/O counts of all devices\n"
+#endif
 );
 
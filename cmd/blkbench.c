@@ -0,0 +1,301 @@
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ *
+ * Block device benchmark: sequential and random reads and writes in a
+ * partition over a range of transfer sizes, with the latency spread of the
+ * transfers, for comparing storage parts and catching driver regressions.
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <command.h>
+#include <console.h>
+#include <div64.h>
+#include <malloc.h>
+#include <part.h>
+#include <linux/err.h>
+#include <linux/sizes.h>
+
+#define BLKBENCH_MIN_BS		SZ_4K
+#define BLKBENCH_MAX_BS		SZ_8M
+#define BLKBENCH_TOTAL		SZ_32M	/* bytes per run */
+#define BLKBENCH_UNALIGN	4	/* buffer offset of -u */
+#define BLKBENCH_SEED		0x2545f491
+
+enum {
+	BLKBENCH_SEQ_READ,
+	BLKBENCH_RAND_READ,
+	BLKBENCH_SEQ_WRITE,
+	BLKBENCH_RAND_WRITE,
+	BLKBENCH_TESTS,
+};
+
+static const char *const blkbench_names[BLKBENCH_TESTS] = {
+	"seqread", "randread", "seqwrite", "randwrite",
+};
+
+struct blkbench {
+	struct blk_desc *desc;
+	lbaint_t start;		/* first block of the partition */
+	lbaint_t size;		/* blocks in the partition */
+	u8 *buf;
+	ulong total;		/* bytes per run */
+	u32 *lat;		/* timer ticks of each transfer */
+	bool async;
+	bool machine;
+};
+
+static inline bool blkbench_is_write(int test)
+{
+	return test == BLKBENCH_SEQ_WRITE || test == BLKBENCH_RAND_WRITE;
+}
+
+static inline bool blkbench_is_rand(int test)
+{
+	return test == BLKBENCH_RAND_READ || test == BLKBENCH_RAND_WRITE;
+}
+
+/* xorshift32, the same offsets on every run for comparable numbers */
+static u32 blkbench_rand(u32 *seed)
+{
+	u32 x = *seed;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*seed = x;
+
+	return x;
+}
+
+static int blkbench_xfer(struct blkbench *b, lbaint_t blk, lbaint_t cnt,
+			 bool write)
+{
+	u8 *buf = b->buf;
+	ulong n;
+
+	if (write)
+		return blk_dwrite(b->desc, blk, cnt, buf) == cnt ? 0 : -EIO;
+	if (!b->async)
+		return blk_dread(b->desc, blk, cnt, buf) == cnt ? 0 : -EIO;
+
+	/* The device may take less than @cnt per read */
+	while (cnt) {
+		n = blk_dread_async(b->desc, blk, cnt, buf);
+		if (!n || IS_ERR_VALUE(n) || blk_wait(b->desc))
+			return -EIO;
+		blk += n;
+		cnt -= n;
+		buf += n * b->desc->blksz;
+	}
+
+	return 0;
+}
+
+static ulong blkbench_us(u64 ticks)
+{
+	return lldiv(ticks * 1000000, get_tbclk());
+}
+
+static int blkbench_cmp(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a, y = *(const u32 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void blkbench_report(struct blkbench *b, int test, ulong bs, ulong ops,
+			    u64 ticks)
+{
+	u64 bytes = (u64)bs * ops;
+	ulong kibps, iops, p50, p90, p99, max;
+
+	qsort(b->lat, ops, sizeof(*b->lat), blkbench_cmp);
+	p50 = blkbench_us(b->lat[(ops - 1) * 50 / 100]);
+	p90 = blkbench_us(b->lat[(ops - 1) * 90 / 100]);
+	p99 = blkbench_us(b->lat[(ops - 1) * 99 / 100]);
+	max = blkbench_us(b->lat[ops - 1]);
+	ticks = ticks ? : 1;
+	kibps = lldiv(bytes * get_tbclk() / 1024, ticks);
+	iops = lldiv((u64)ops * get_tbclk(), ticks);
+
+	if (b->machine)
+		printf("blkbench: test=%s bs=%lu ops=%lu bytes=%llu us=%lu kibps=%lu iops=%lu p50=%lu p90=%lu p99=%lu max=%lu\n",
+		       blkbench_names[test], bs, ops, bytes,
+		       blkbench_us(ticks), kibps, iops, p50, p90, p99, max);
+	else
+		printf("%-10s %7luK %7lu %9lu %7lu %8lu %8lu %8lu %8lu\n",
+		       blkbench_names[test], bs >> 10, ops, kibps, iops, p50,
+		       p90, p99, max);
+}
+
+static int blkbench_run(struct blkbench *b, int test, ulong bs)
+{
+	lbaint_t cnt = bs / b->desc->blksz;
+	lbaint_t slots = b->size / cnt;
+	bool write = blkbench_is_write(test);
+	u32 seed = BLKBENCH_SEED;
+	ulong i, ops;
+	lbaint_t blk;
+	u64 start, t;
+	int ret;
+
+	if (!slots)
+		return 0;
+	ops = max(b->total / bs, 1UL);
+	/* A sequential run doesn't go over the same blocks twice */
+	if (!blkbench_is_rand(test))
+		ops = min_t(ulong, ops, slots);
+
+	start = get_ticks();
+	for (i = 0; i < ops; i++) {
+		if (blkbench_is_rand(test))
+			blk = (blkbench_rand(&seed) % slots) * cnt;
+		else
+			blk = i * cnt;
+
+		t = get_ticks();
+		ret = blkbench_xfer(b, b->start + blk, cnt, write);
+		b->lat[i] = get_ticks() - t;
+		if (ret) {
+			printf("%s: %luK transfer failed at block " LBAF "\n",
+			       blkbench_names[test], bs >> 10, b->start + blk);
+			return ret;
+		}
+		if (ctrlc())
+			return -EINTR;
+	}
+
+	blkbench_report(b, test, bs, ops, get_ticks() - start);
+
+	return 0;
+}
+
+static int do_blkbench(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	struct blkbench b = { .total = BLKBENCH_TOTAL };
+	ulong bs_min = 0, bs_max = BLKBENCH_MAX_BS, bs;
+	bool write = false, unalign = false, nocache = false;
+	disk_partition_t part;
+	int test, ret = 0;
+	u8 *mem;
+	int i;
+
+	if (argc < 4)
+		return CMD_RET_USAGE;
+
+	for (i = 4; i < argc; i++) {
+		if (argv[i][0] != '-' || strlen(argv[i]) != 2)
+			return CMD_RET_USAGE;
+		switch (argv[i][1]) {
+		case 'w':
+			write = true;
+			break;
+		case 'a':
+			b.async = true;
+			break;
+		case 'u':
+			unalign = true;
+			break;
+		case 'c':
+			nocache = true;
+			break;
+		case 'm':
+			b.machine = true;
+			break;
+		case 'b':
+			if (++i == argc)
+				return CMD_RET_USAGE;
+			bs_min = bs_max = ustrtoul(argv[i], NULL, 0);
+			if (!bs_min)
+				return CMD_RET_USAGE;
+			break;
+		case 's':
+			if (++i == argc)
+				return CMD_RET_USAGE;
+			b.total = ustrtoul(argv[i], NULL, 0);
+			break;
+		default:
+			return CMD_RET_USAGE;
+		}
+	}
+
+	b.desc = blk_get_dev(argv[1], simple_strtoul(argv[2], NULL, 16));
+	if (!b.desc) {
+		printf("Block device %s %s not supported\n", argv[1], argv[2]);
+		return CMD_RET_FAILURE;
+	}
+	if (part_get_info_by_name(b.desc, argv[3], &part) < 0) {
+		printf("No partition %s\n", argv[3]);
+		return CMD_RET_FAILURE;
+	}
+	b.start = part.start;
+	b.size = part.size;
+
+	/* The sweep starts at a block if that's above 4K */
+	if (!bs_min)
+		bs_min = max_t(ulong, BLKBENCH_MIN_BS, b.desc->blksz);
+	if (bs_min % b.desc->blksz || !b.total) {
+		printf("Transfer size must be a multiple of %lu bytes\n",
+		       b.desc->blksz);
+		return CMD_RET_FAILURE;
+	}
+
+	mem = memalign(ARCH_DMA_MINALIGN, bs_max + BLKBENCH_UNALIGN);
+	b.lat = malloc(max(b.total / bs_min, 1UL) * sizeof(*b.lat));
+	if (!mem || !b.lat) {
+		printf("No memory for a %luK buffer\n", bs_max >> 10);
+		ret = -ENOMEM;
+		goto out;
+	}
+	b.buf = mem + (unalign ? BLKBENCH_UNALIGN : 0);
+	for (i = 0; i < bs_max; i++)
+		b.buf[i] = i * 0x9d;
+
+	if (!b.machine)
+		printf("%s %s %s: " LBAF " blocks of %lu, %s buffer, dcache %s%s\n"
+		       "%-10s %8s %7s %9s %7s %8s %8s %8s %8s\n",
+		       argv[1], argv[2], argv[3], b.size, b.desc->blksz,
+		       unalign ? "unaligned" : "aligned",
+		       nocache || !dcache_status() ? "off" : "on",
+		       b.async ? ", async reads" : "", "Test", "Size", "Ops",
+		       "KiB/s", "IOPS", "p50(us)", "p90(us)", "p99(us)",
+		       "max(us)");
+
+	if (nocache && dcache_status())
+		dcache_disable();
+	else
+		nocache = false;
+
+	for (test = 0; test < BLKBENCH_TESTS && !ret; test++) {
+		if (blkbench_is_write(test) && !write)
+			continue;
+		for (bs = bs_min; bs <= bs_max && !ret; bs *= 2)
+			ret = blkbench_run(&b, test, bs);
+	}
+
+	if (nocache)
+		dcache_enable();
+out:
+	free(b.lat);
+	free(mem);
+
+	return ret ? CMD_RET_FAILURE : CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	blkbench, 12, 0, do_blkbench,
+	"benchmark a block device",
+	"<interface> <dev> <partition> [-w] [-a] [-u] [-c] [-m] [-b <size>] [-s <size>]\n"
+	"    - sequential and random reads in <partition>, 4K to 8M transfers\n"
+	"    -w: also write, which destroys the data in <partition>\n"
+	"    -a: read through blk_dread_async() and blk_wait()\n"
+	"    -u: transfer to and from a buffer that is not cache aligned\n"
+	"    -c: run with the dcache disabled\n"
+	"    -m: print a key=value line per run, for scripts\n"
+	"    -b: only this transfer size\n"
+	"    -s: bytes moved per run, 32M by default"
+);
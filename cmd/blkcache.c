@@ -10,27 +10,45 @@
 #include <malloc.h>
 #include <part.h>
 
+static void blkc_show_dev(int iftype, int devnum, void *priv)
+{
+	struct block_cache_stats stats;
+
+	if (blkcache_dev_stats(iftype, devnum, &stats))
+		return;
+
+	printf("%s %d: hits %u, misses %u, read ahead %u blocks, entries %u\n",
+	       blk_get_if_type_name(iftype), devnum, stats.hits, stats.misses,
+	       stats.prefetched, stats.entries);
+}
+
 static int blkc_show(cmd_tbl_t *cmdtp, int flag,
 		     int argc, char * const argv[])
 {
 	struct block_cache_stats stats;
+
+	/* per-device counters are reset along with the totals */
+	blkcache_for_each_dev(blkc_show_dev, NULL);
 	blkcache_stats(&stats);
 
 	printf("hits: %u\n"
 	       "misses: %u\n"
+	       "blocks read ahead: %u\n"
 	       "entries: %u\n"
 	       "max blocks/entry: %u\n"
-	       "max cache entries: %u\n",
-	       stats.hits, stats.misses, stats.entries,
-	       stats.max_blocks_per_entry, stats.max_entries);
+	       "max cache entries: %u\n"
+	       "max read-ahead entries: %u\n",
+	       stats.hits, stats.misses, stats.prefetched, stats.entries,
+	       stats.max_blocks_per_entry, stats.max_entries,
+	       stats.read_ahead);
 	return 0;
 }
 
 static int blkc_configure(cmd_tbl_t *cmdtp, int flag,
 			  int argc, char * const argv[])
 {
-	unsigned blocks_per_entry, max_entries;
-	if (argc != 3)
+	unsigned blocks_per_entry, max_entries, read_ahead;
+	if (argc != 3 && argc != 4)
 		return CMD_RET_USAGE;
 
 	blocks_per_entry = simple_strtoul(argv[1], 0, 0);
@@ -38,12 +56,18 @@ static int blkc_configure(cmd_tbl_t *cmdtp, int flag,
 	blkcache_configure(blocks_per_entry, max_entries);
 	printf("changed to max of %u entries of %u blocks each\n",
 	       max_entries, blocks_per_entry);
+
+	if (argc == 4) {
+		read_ahead = simple_strtoul(argv[3], 0, 0);
+		blkcache_set_read_ahead(read_ahead);
+		printf("read-ahead of up to %u entries\n", read_ahead);
+	}
 	return 0;
 }
 
 static cmd_tbl_t cmd_blkc_sub[] = {
 	U_BOOT_CMD_MKENT(show, 0, 0, blkc_show, "", ""),
-	U_BOOT_CMD_MKENT(configure, 3, 0, blkc_configure, "", ""),
+	U_BOOT_CMD_MKENT(configure, 4, 0, blkc_configure, "", ""),
 };
 
 static __maybe_unused void blkc_reloc(void)
@@ -80,8 +104,8 @@ static int do_blkcache(cmd_tbl_t *cmdtp, int flag,
 }
 
 U_BOOT_CMD(
-	blkcache, 4, 0, do_blkcache,
+	blkcache, 5, 0, do_blkcache,
 	"block cache diagnostics and control",
 	"show - show and reset statistics\n"
-	"blkcache configure blocks entries\n"
+	"blkcache configure blocks entries [read-ahead entries]\n"
 );
@@ -69,6 +69,8 @@ static int do_boot_fit(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 
 	printf("## Booting FIT Image ");
 
+	/* Nothing from a previous boot_fit may count as read and hashed */
+	fit_stream_reset();
 	if (argc == 1)
 		fit = do_boot_fit_storage(&size);
 	else
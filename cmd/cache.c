@@ -86,6 +86,12 @@ static int do_dcache(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		case 3:
 			printf("error: dcache invalidate require [start] [size]\n");
 			break;
+#ifdef CONFIG_ARMV8_DCACHE_STATS
+		case 4:
+			dcache_stats_show();
+			dcache_stats_reset();
+			break;
+#endif
 		}
 		break;
 	case 1:			/* get status */
@@ -100,7 +106,9 @@ static int do_dcache(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 
 static int parse_argv(const char *s)
 {
-	if (strcmp(s, "invalidate") == 0)
+	if (strcmp(s, "stats") == 0)
+		return 4;
+	else if (strcmp(s, "invalidate") == 0)
 		return 3;
 	else if (strcmp(s, "flush") == 0)
 		return 2;
@@ -125,4 +133,8 @@ U_BOOT_CMD(
 	"enable or disable data cache",
 	"[on, off, flush, invalidate] [start] [size]\n"
 	"    - enable, disable, or flush data (writethrough) cache"
+#ifdef CONFIG_ARMV8_DCACHE_STATS
+	"\ndcache stats\n"
+	"    - show and reset the time spent in data cache maintenance"
+#endif
 );
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: GPL-2.0+ OR BSD-3-Clause
+/*
+ * Copyright (C) 2024 Rockchip Electronics Co., Ltd.
+ *
+ * DDR bandwidth of reading, writing and copying with 1 cpu up to all of
+ * them at once, each on its own buffers well beyond the size of the caches.
+ */
+
+#include <common.h>
+#include <command.h>
+#include "../ddr_tool_common.h"
+
+#define BW_SIZE_MB		64	/* of each buffer of each cpu */
+#define BW_LOOPS		4
+#define BW_WAIT_MS		60000
+
+enum bw_op {
+	BW_READ,
+	BW_WRITE,
+	BW_COPY,
+	BW_OPS,
+};
+
+static const char * const bw_names[BW_OPS] = {
+	[BW_READ] = "read",
+	[BW_WRITE] = "write",
+	[BW_COPY] = "copy",
+};
+
+static const ulong bw_pattern[8] __aligned(16) = {
+	0x5555555555555555UL, 0xaaaaaaaaaaaaaaaaUL,
+	0x3333333333333333UL, 0xccccccccccccccccUL,
+	0x0f0f0f0f0f0f0f0fUL, 0xf0f0f0f0f0f0f0f0UL,
+	0x00ff00ff00ff00ffUL, 0xff00ff00ff00ff00UL,
+};
+
+static ulong bw_base;
+static ulong bw_size;
+static ulong bw_loops;
+static enum bw_op bw_op;
+static int bw_cpus;
+
+/* cpu n reads and copies from the n-th pair of buffers, writes the second */
+static void bw_run(int cpu)
+{
+	ulong *src = (ulong *)(bw_base + cpu * 2 * bw_size);
+	ulong *dst = (ulong *)((ulong)src + bw_size);
+	ulong i;
+
+	if (cpu >= bw_cpus)
+		return;
+
+	for (i = 0; i < bw_loops; i++) {
+		switch (bw_op) {
+		case BW_READ:
+			ddr_read_block(src, bw_size);
+			break;
+		case BW_WRITE:
+			ddr_fill_block(dst, bw_pattern, sizeof(bw_pattern),
+				       bw_size);
+			break;
+		default:
+			memcpy(dst, src, bw_size);
+			break;
+		}
+	}
+}
+
+/* MB/s of all of @cpus doing @op at once, 0 if one of them got stuck */
+static ulong bw_measure(enum bw_op op, int cpus, int cpus_on)
+{
+	ulong start, us;
+	int cpu;
+
+	bw_op = op;
+	bw_cpus = cpus;
+	flush_dcache_all();
+
+	start = timer_get_us();
+	if (cpus_on > 1)
+		ddr_tool_cpus_run(bw_run);
+	bw_run(0);
+	for (cpu = 1; cpu < cpus_on; cpu++) {
+		if (ddr_tool_cpu_wait(cpu, BW_WAIT_MS)) {
+			printf("CPU%d did not finish\n", cpu);
+			return 0;
+		}
+	}
+	us = timer_get_us() - start ? : 1;
+
+	return bw_size * bw_loops * cpus / us;
+}
+
+static int do_ddr_bw(cmd_tbl_t *cmdtp, int flag, int argc,
+		     char *const argv[])
+{
+	ulong start_adr[CONFIG_NR_DRAM_BANKS], length[CONFIG_NR_DRAM_BANKS];
+	ulong size_mb = BW_SIZE_MB, mbps;
+	int cpus_on, max_cpus = 0, cpus, op, i;
+
+	bw_loops = BW_LOOPS;
+	if (argc > 1 && strict_strtoul(argv[1], 0, &size_mb) < 0)
+		return CMD_RET_USAGE;
+	if (argc > 2 && strict_strtoul(argv[2], 0, &bw_loops) < 0)
+		return CMD_RET_USAGE;
+	if (!size_mb || !bw_loops)
+		return CMD_RET_USAGE;
+	bw_size = size_mb << 20;
+
+	cpus_on = ddr_tool_cpus_on();
+
+	/* the bank with room for the buffers of the most cpus */
+	get_print_available_addr(start_adr, length, 0);
+	for (i = 0; i < CONFIG_NR_DRAM_BANKS; i++) {
+		cpus = min_t(ulong, cpus_on, length[i] / (2 * bw_size));
+		if (cpus > max_cpus) {
+			max_cpus = cpus;
+			bw_base = ALIGN(start_adr[i], 64);
+		}
+	}
+	if (!max_cpus) {
+		printf("No room for 2 x %lu MB buffers\n", size_mb);
+		return CMD_RET_FAILURE;
+	}
+
+	printf("2 x %lu MB buffers per CPU at 0x%lx, %lu loops\n", size_mb,
+	       bw_base, bw_loops);
+	printf("CPUs");
+	for (op = 0; op < BW_OPS; op++)
+		printf(" %6s MB/s", bw_names[op]);
+	printf("\n");
+	for (cpus = 1; cpus <= max_cpus; cpus++) {
+		printf("%4d", cpus);
+		for (op = 0; op < BW_OPS; op++) {
+			mbps = bw_measure(op, cpus, cpus_on);
+			if (!mbps)
+				return CMD_RET_FAILURE;
+			printf(" %11lu", mbps);
+		}
+		printf("\n");
+	}
+
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(ddr_bw, 3, 1, do_ddr_bw,
+	   "DDR bandwidth with 1 to all CPUs",
+	   "[size_mb [loops]]\n"
+	   "size_mb: size of each of the 2 buffers of each CPU, default 64\n"
+	   "loops: passes over the buffers, default 4\n"
+	   "read and write count the bytes read or written with NEON, copy the\n"
+	   "bytes copied by memcpy(), all CPUs together\n");
@@ -15,7 +15,7 @@
 #include <asm/arch/sdram_rk3568.h>
 #endif
 
-#define __version__	"0.0.6"
+#define __version__	"0.0.7"
 
 #define PRINT_LENGTH	64
 #ifndef PRINT_STEP
@@ -165,6 +165,133 @@ static u16 cs_eye_width_min(struct cs_rw_trn_result *result, u8 byte_en,
 	return cs_eye_width;
 }
 
+/* Get the eye width references of @mhz, return the name of the DDR type */
+static const char *get_width_ref(u32 ddr_type, u16 mhz, u16 *rd_width_ref,
+				 u16 *wr_width_ref, u16 *width_ref_mhz)
+{
+	switch (ddr_type) {
+	case LPDDR4X:
+	case LPDDR4:
+		if (mhz < (LP4_WIDTH_REF_MHZ_L + LP4_WIDTH_REF_MHZ_H) / 2) {
+			*rd_width_ref = LP4_RD_WIDTH_REF_L;
+			*wr_width_ref = LP4_WR_WIDTH_REF_L;
+			*width_ref_mhz = LP4_WIDTH_REF_MHZ_L;
+		} else {
+			*rd_width_ref = LP4_RD_WIDTH_REF_H;
+			*wr_width_ref = LP4_WR_WIDTH_REF_H;
+			*width_ref_mhz = LP4_WIDTH_REF_MHZ_H;
+		}
+		return ddr_type == LPDDR4X ? "LPDDR4X" : "LPDDR4";
+	case LPDDR3:
+		if (mhz < (LP4_WIDTH_REF_MHZ_L + LP4_WIDTH_REF_MHZ_H) / 2) {
+			*rd_width_ref = LP3_RD_WIDTH_REF_L;
+			*wr_width_ref = LP3_WR_WIDTH_REF_L;
+			*width_ref_mhz = LP3_WIDTH_REF_MHZ_L;
+		} else {
+			*rd_width_ref = LP3_RD_WIDTH_REF_H;
+			*wr_width_ref = LP3_WR_WIDTH_REF_H;
+			*width_ref_mhz = LP3_WIDTH_REF_MHZ_H;
+		}
+		return "LPDDR3";
+	case DDR4:
+		if (mhz < (DDR4_WIDTH_REF_MHZ_L + DDR4_WIDTH_REF_MHZ_H) / 2) {
+			*rd_width_ref = DDR4_RD_WIDTH_REF_L;
+			*wr_width_ref = DDR4_WR_WIDTH_REF_L;
+			*width_ref_mhz = DDR4_WIDTH_REF_MHZ_L;
+		} else {
+			*rd_width_ref = DDR4_RD_WIDTH_REF_H;
+			*wr_width_ref = DDR4_WR_WIDTH_REF_H;
+			*width_ref_mhz = DDR4_WIDTH_REF_MHZ_H;
+		}
+		return "DDR4";
+	case DDR3:
+	default:
+		if (mhz < (DDR3_WIDTH_REF_MHZ_L + DDR3_WIDTH_REF_MHZ_H) / 2) {
+			*rd_width_ref = DDR3_RD_WIDTH_REF_L;
+			*wr_width_ref = DDR3_WR_WIDTH_REF_L;
+			*width_ref_mhz = DDR3_WIDTH_REF_MHZ_L;
+		} else {
+			*rd_width_ref = DDR3_RD_WIDTH_REF_H;
+			*wr_width_ref = DDR3_WR_WIDTH_REF_H;
+			*width_ref_mhz = DDR3_WIDTH_REF_MHZ_H;
+		}
+		return "DDR3";
+	} /* switch (ddr_type) */
+}
+
+/*
+ * One line per DQ of the eye of @cs, in the same numbers as
+ * print_ddr_dq_eye() shows:
+ * eye,<MHz>,<rd|wr>,<cs>,<dq>,<margin_l>,<sample>,<margin_r>,<width>,<dqs>
+ */
+static void print_ddr_dq_eye_csv(struct fsp_rw_trn_result *fsp_result,
+				 u16 mhz, const char *dir, u8 cs, u8 byte_en)
+{
+	struct cs_rw_trn_result *result = &fsp_result->cs[cs];
+	u16 sample;
+	u16 min;
+	u16 max;
+	u8 dqs;
+	u8 dq;
+
+	for (dqs = 0; dqs < BYTE_NUM; dqs++) {
+		if ((byte_en & BIT(dqs)) == 0)
+			continue;
+
+		for (dq = 0; dq < 8; dq++) {
+			sample = fsp_result->min_val +
+				 result->dqs[dqs].dq_deskew[dq];
+			min = result->dqs[dqs].dq_min[dq];
+			max = result->dqs[dqs].dq_max[dq];
+			printf("eye,%d,%s,%d,%d,%d,%d,%d,%d,%d\n", mhz, dir, cs,
+			       dqs * 8 + dq, sample > min ? sample - min : 0,
+			       sample, max > sample ? max - sample : 0,
+			       max >= min ? max - min + 1 : 0,
+			       fsp_result->min_val +
+			       result->dqs[dqs].dqs_deskew);
+		}
+	}
+}
+
+/*
+ * The eyes of @fsp for scripts, with a last line of the minimum widths
+ * against the references:
+ * min,<MHz>,<read>,<write>,<read ref>,<write ref>,<pass|fail>
+ */
+static void print_fsp_csv(u32 ddr_type, u8 fsp)
+{
+	u16 mhz = result.fsp_mhz[fsp];
+	u16 rd_width = RD_DESKEW_NUM;
+	u16 wr_width = WR_DESKEW_NUM;
+	u16 rd_width_ref;
+	u16 wr_width_ref;
+	u16 width_ref_mhz;
+	u16 cs_eye_width;
+	u8 cs;
+
+	get_width_ref(ddr_type, mhz, &rd_width_ref, &wr_width_ref,
+		      &width_ref_mhz);
+	for (cs = 0; cs < result.cs_num; cs++) {
+		print_ddr_dq_eye_csv(&result.rd_fsp[fsp], mhz, "rd", cs,
+				     result.byte_en);
+		cs_eye_width = cs_eye_width_min(&result.rd_fsp[fsp].cs[cs],
+						result.byte_en, RD_DESKEW_NUM);
+		if (rd_width > cs_eye_width)
+			rd_width = cs_eye_width;
+
+		print_ddr_dq_eye_csv(&result.wr_fsp[fsp], mhz, "wr", cs,
+				     result.byte_en);
+		cs_eye_width = cs_eye_width_min(&result.wr_fsp[fsp].cs[cs],
+						result.byte_en, WR_DESKEW_NUM);
+		if (wr_width > cs_eye_width)
+			wr_width = cs_eye_width;
+	}
+	printf("min,%d,%d,%d,%d,%d,%s\n", mhz, rd_width, wr_width,
+	       rd_width_ref, wr_width_ref,
+	       rd_width < rd_width_ref || wr_width < wr_width_ref ?
+	       "fail" : "pass");
+}
+
 static int do_ddr_dq_eye(cmd_tbl_t *cmdtp, int flag, int argc,
 			 char * const argv[])
 {
@@ -180,9 +307,17 @@ static int do_ddr_dq_eye(cmd_tbl_t *cmdtp, int flag, int argc,
 	u8 fsp = 0;
 	u8 cs;
 	int i;
+	bool csv = false;
 	struct print_border print_border;
 
-	printf("Rockchip DDR DQ Eye Tool v" __version__ "\n");
+	if (argc > 1 && !strcmp(argv[1], "-c")) {
+		csv = true;
+		argc--;
+		argv++;
+	}
+
+	if (!csv)
+		printf("Rockchip DDR DQ Eye Tool v" __version__ "\n");
 
 #if defined(CONFIG_ROCKCHIP_RV1126)
 	ddr_type = (readl(0xfe020208) >> 13) & 0x7;
@@ -202,6 +337,16 @@ static int do_ddr_dq_eye(cmd_tbl_t *cmdtp, int flag, int argc,
 		return CMD_RET_FAILURE;
 	}
 
+	if (csv && (argc == 1 || !strcmp(argv[1], "all"))) {
+		/* all the freqs trained by the Loader, in one go */
+		for (i = 0; i < FSP_NUM; i++) {
+			if (result.fsp_mhz[i])
+				print_fsp_csv(ddr_type, i);
+		}
+
+		return CMD_RET_SUCCESS;
+	}
+
 	if (argc == 1) {
 		/* use the max freq if no arg */
 		for (i = 0; i < FSP_NUM; i++) {
@@ -228,76 +373,14 @@ static int do_ddr_dq_eye(cmd_tbl_t *cmdtp, int flag, int argc,
 		return CMD_RET_FAILURE;
 	}
 
-	printf("DDR type: ");
-	switch (ddr_type) {
-	case LPDDR4X:
-		if (result.fsp_mhz[fsp] <
-			(LP4_WIDTH_REF_MHZ_L + LP4_WIDTH_REF_MHZ_H) / 2) {
-			rd_width_ref = LP4_RD_WIDTH_REF_L;
-			wr_width_ref = LP4_WR_WIDTH_REF_L;
-			width_ref_mhz = LP4_WIDTH_REF_MHZ_L;
-		} else {
-			rd_width_ref = LP4_RD_WIDTH_REF_H;
-			wr_width_ref = LP4_WR_WIDTH_REF_H;
-			width_ref_mhz = LP4_WIDTH_REF_MHZ_H;
-		}
-		printf("LPDDR4X");
-		break;
-	case LPDDR4:
-		if (result.fsp_mhz[fsp] <
-			(LP4_WIDTH_REF_MHZ_L + LP4_WIDTH_REF_MHZ_H) / 2) {
-			rd_width_ref = LP4_RD_WIDTH_REF_L;
-			wr_width_ref = LP4_WR_WIDTH_REF_L;
-			width_ref_mhz = LP4_WIDTH_REF_MHZ_L;
-		} else {
-			rd_width_ref = LP4_RD_WIDTH_REF_H;
-			wr_width_ref = LP4_WR_WIDTH_REF_H;
-			width_ref_mhz = LP4_WIDTH_REF_MHZ_H;
-		}
-		printf("LPDDR4");
-		break;
-	case LPDDR3:
-		if (result.fsp_mhz[fsp] <
-			(LP4_WIDTH_REF_MHZ_L + LP4_WIDTH_REF_MHZ_H) / 2) {
-			rd_width_ref = LP3_RD_WIDTH_REF_L;
-			wr_width_ref = LP3_WR_WIDTH_REF_L;
-			width_ref_mhz = LP3_WIDTH_REF_MHZ_L;
-		} else {
-			rd_width_ref = LP3_RD_WIDTH_REF_H;
-			wr_width_ref = LP3_WR_WIDTH_REF_H;
-			width_ref_mhz = LP3_WIDTH_REF_MHZ_H;
-		}
-		printf("LPDDR3");
-		break;
-	case DDR4:
-		if (result.fsp_mhz[fsp] <
-			(DDR4_WIDTH_REF_MHZ_L + DDR4_WIDTH_REF_MHZ_H) / 2) {
-			rd_width_ref = DDR4_RD_WIDTH_REF_L;
-			wr_width_ref = DDR4_WR_WIDTH_REF_L;
-			width_ref_mhz = DDR4_WIDTH_REF_MHZ_L;
-		} else {
-			rd_width_ref = DDR4_RD_WIDTH_REF_H;
-			wr_width_ref = DDR4_WR_WIDTH_REF_H;
-			width_ref_mhz = DDR4_WIDTH_REF_MHZ_H;
-		}
-		printf("DDR4");
-		break;
-	case DDR3:
-	default:
-		if (result.fsp_mhz[fsp] <
-			(DDR3_WIDTH_REF_MHZ_L + DDR3_WIDTH_REF_MHZ_H) / 2) {
-			rd_width_ref = DDR3_RD_WIDTH_REF_L;
-			wr_width_ref = DDR3_WR_WIDTH_REF_L;
-			width_ref_mhz = DDR3_WIDTH_REF_MHZ_L;
-		} else {
-			rd_width_ref = DDR3_RD_WIDTH_REF_H;
-			wr_width_ref = DDR3_WR_WIDTH_REF_H;
-			width_ref_mhz = DDR3_WIDTH_REF_MHZ_H;
-		}
-		printf("DDR3");
-		break;
-	} /* switch (ddr_type) */
-	printf("\n");
+	if (csv) {
+		print_fsp_csv(ddr_type, fsp);
+		return CMD_RET_SUCCESS;
+	}
+
+	printf("DDR type: %s\n",
+	       get_width_ref(ddr_type, result.fsp_mhz[fsp], &rd_width_ref,
+			     &wr_width_ref, &width_ref_mhz));
 
 	for (cs = 0; cs < result.cs_num; cs++) {
 		calc_print_border(&result.rd_fsp[fsp].cs[cs], result.byte_en,
@@ -331,11 +414,17 @@ static int do_ddr_dq_eye(cmd_tbl_t *cmdtp, int flag, int argc,
 	return CMD_RET_SUCCESS;
 }
 
-U_BOOT_CMD(ddr_dq_eye,	2,	1,	do_ddr_dq_eye,
+U_BOOT_CMD(ddr_dq_eye,	3,	1,	do_ddr_dq_eye,
 	   "Rockchip DDR DQ Eye Tool\n",
-	   "arg1: DDR freq in MHz, null for the max freq.\n"
+	   "[-c] [arg1]\n"
+	   "-c: print comma separated values for scripts, one line per DQ:\n"
+	   "	eye,MHz,rd|wr,cs,dq,margin_l,sample,margin_r,width,dqs\n"
+	   "	and one line per freq:\n"
+	   "	min,MHz,read width,write width,read ref,write ref,pass|fail\n"
+	   "arg1: DDR freq in MHz, null for the max freq, or all freqs with -c.\n"
 	   "example:\n"
-	   "	ddr_dq_eye 1056: show the DDR DQ eye in 1056MHz."
+	   "	ddr_dq_eye 1056: show the DDR DQ eye in 1056MHz.\n"
+	   "	ddr_dq_eye -c all: the DQ eyes of all freqs for a script."
 );
 
 #endif /* if defined(CONFIG_ROCKCHIP_RV1126) || defined(CONFIG_ROCKCHIP_RK3568) */
@@ -4,6 +4,7 @@
  */
 
 #include <common.h>
+#include <asm/arch/rockchip_smccc.h>
 #include <power/regulator.h>
 #include "ddr_tool_common.h"
 #include <bidram.h>
@@ -17,12 +18,45 @@ struct bi_dram {
 };
 static struct bi_dram post_dram[CONFIG_NR_DRAM_BANKS];
 
+ulong __sp;		/* set sp of secondary cpu */
+u32 print_mutex;	/* 0: unlock, 1: lock */
+
+#if (CPU_NUM_MAX > 1)
+static ulong __gd;	/* set r9/x18 of secondary cpu to gd addr */
+#endif
+static int cpu_num = 1;	/* cpus running, cpu0 included */
+static bool cpu_init_finish[CPU_NUM_MAX];
+
+/*
+ * Once up, the secondary cpus wait here for a job: each new one bumps
+ * cpu_job_seq, and a cpu is done with it when its cpu_job_done catches up.
+ */
+static void (*cpu_job)(int cpu);
+static ulong cpu_job_seq;
+static ulong cpu_job_done[CPU_NUM_MAX];
+
+#ifdef CONFIG_ARM64
+/* if the NEON kernels can take the whole of it */
+static bool ddr_block_ok(u32 *buf, u32 buf_len, ulong start_adr,
+			 ulong length)
+{
+	return !((ulong)buf & 0xf) && buf_len >= 64 && !(buf_len & 0x3f) &&
+	       !(start_adr & 0x3f) && !(length & 0x3f);
+}
+#endif
+
 void write_buf_to_ddr(u32 *buf, u32 buf_len, ulong start_adr, ulong length)
 {
 	ulong *buful = (ulong *)buf;
 	ulong *p = (ulong *)start_adr;
 	u32 i, j;
 
+#ifdef CONFIG_ARM64
+	if (ddr_block_ok(buf, buf_len, start_adr, length)) {
+		ddr_fill_block(p, buful, buf_len, length);
+		return;
+	}
+#endif
 	buf_len = buf_len / sizeof(ulong) - 1;
 
 	for (i = 0, j = 0; i < length / sizeof(p[0]); i++) {
@@ -37,15 +71,21 @@ ulong cmp_buf_data(u32 *buf, u32 buf_len, ulong start_adr, ulong length,
 {
 	ulong *buful = (ulong *)buf;
 	volatile unsigned long *p = (volatile unsigned long *)start_adr;
-	u32 i, j;
+	u32 i = 0, j;
 	ulong reread = 0;
 	ulong wr_val = 0;
 	ulong val = 0;
 	ulong err_adr = 0;
 
+#ifdef CONFIG_ARM64
+	/* the NEON compare leaves the 64 bytes with a mismatch to the loop */
+	if (ddr_block_ok(buf, buf_len, start_adr, length))
+		i = ddr_cmp_block((ulong *)start_adr, buful, buf_len, length) /
+		    sizeof(p[0]);
+#endif
 	buf_len = buf_len / sizeof(ulong) - 1;
 	err_adr = 0;
-	for (i = 0, j = 0; i < length / sizeof(p[0]); i++) {
+	for (j = i & buf_len; i < length / sizeof(p[0]); i++) {
 		val = p[i];
 		if (val != buful[j]) {
 			flush_dcache_range((ulong)&p[i],
@@ -196,3 +236,97 @@ int set_vdd_logic(u32 uv)
 	return ret;
 }
 
+void secondary_main(void)
+{
+#if (CPU_NUM_MAX > 1)
+	ulong seq = 0;
+	int cpu_id;
+
+#ifndef CONFIG_ARM64
+	asm volatile("mov r9, %0" : : "r" (__gd));	/* set r9 to gd addr */
+#else
+	asm volatile("mov x18, %0" : : "r" (__gd));	/* set x18 to gd addr */
+#endif
+	dcache_enable();
+	icache_enable();
+
+	udelay(100);
+
+	flush_dcache_all();
+
+	cpu_id = cpu_num;
+	cpu_init_finish[cpu_id] = 1;
+	printf("CPU%d start OK.\n", cpu_id);
+
+	while (1) {
+		udelay(100);
+		flush_dcache_all();
+		if (seq == cpu_job_seq)
+			continue;
+		seq = cpu_job_seq;
+		cpu_job(cpu_id);
+		cpu_job_done[cpu_id] = seq;
+		flush_dcache_all();
+	}
+#else
+	return;
+#endif
+}
+
+/*
+ * Bring up the secondary cpus, the first time only as they never go back
+ * to ATF. Return the number of cpus running, cpu0 included.
+ */
+int ddr_tool_cpus_on(void)
+{
+#if (CPU_NUM_MAX > 1)
+	if (cpu_num > 1)
+		return cpu_num;
+
+	__gd = (ulong)gd;
+	asm volatile("mov %0, sp" : "=r" (__sp));
+	printf("CPU0 sp is at 0x%lx now.\n", __sp);
+	__sp &= ~(ulong)0xffff;
+	for (cpu_num = 1; cpu_num < CPU_NUM_MAX; cpu_num++) {
+		__sp -= CPU_STACK_SIZE;
+		flush_dcache_all();
+		if (psci_cpu_on(cpu_num, (ulong)secondary_init) == 0) {
+			mdelay(10);
+			printf("Calling CPU%d, sp = 0x%lx\n", cpu_num, __sp);
+		} else {
+			break;
+		}
+		while (cpu_init_finish[cpu_num] == 0) {
+			udelay(1000);
+			flush_dcache_all();
+		}
+	}
+#endif
+
+	return cpu_num;
+}
+
+/* Start @job(cpu) on each secondary cpu, cpu0 runs its own share itself */
+void ddr_tool_cpus_run(void (*job)(int cpu))
+{
+	cpu_job = job;
+	cpu_job_seq++;
+	flush_dcache_all();
+}
+
+/* Wait for @cpu to finish the job, return -ETIMEDOUT if it doesn't */
+int ddr_tool_cpu_wait(int cpu, ulong timeout_ms)
+{
+	ulong start = get_timer(0);
+
+	while (cpu_job_done[cpu] != cpu_job_seq) {
+		if (get_timer(start) > timeout_ms)
+			return -ETIMEDOUT;
+		mdelay(1);
+		flush_dcache_range((ulong)&cpu_job_done[cpu],
+				   (ulong)&cpu_job_done[cpu + 1]);
+	}
+
+	return 0;
+}
+
@@ -10,6 +10,16 @@
 /* reserved 1MB for stack */
 #define RESERVED_SP_SIZE		0x100000
 
+/* secondary cpu stacks are carved out of RESERVED_SP_SIZE below cpu0's */
+#define CPU_NUM_MAX			16
+#define CPU_STACK_SIZE			0x10000
+
+extern u32 print_mutex;	/* 0: unlock, 1: lock */
+
+extern void secondary_init(void);
+extern void lock_byte_mutex(u32 *flag);
+extern u32 unlock_byte_mutex(u32 *flag);
+
 void write_buf_to_ddr(u32 *buf, u32 buf_len, ulong start_adr, ulong length);
 ulong cmp_buf_data(u32 *buf, u32 buf_len, ulong start_adr,
 		   ulong length, u32 prt_en);
@@ -17,4 +27,15 @@ void print_memory(void *addr, ulong size);
 void get_print_available_addr(ulong *start_adr, ulong *length, int print_en);
 int judge_test_addr(ulong *arg, ulong *start_adr, ulong *length);
 int set_vdd_logic(u32 uv);
+#ifdef CONFIG_ARM64
+/* NEON kernels of ddr_tool_neon.S */
+void ddr_fill_block(ulong *dst, const ulong *pattern, ulong pattern_len,
+		    ulong len);
+ulong ddr_cmp_block(const ulong *src, const ulong *pattern,
+		    ulong pattern_len, ulong len);
+void ddr_read_block(const ulong *src, ulong len);
+#endif
+int ddr_tool_cpus_on(void);
+void ddr_tool_cpus_run(void (*job)(int cpu));
+int ddr_tool_cpu_wait(int cpu, ulong timeout_ms);
 #endif /* __CMD_DDR_TOOL_DDR_TOOL_COMMON_H */
@@ -17,6 +17,8 @@
 
 #include <common.h>
 #include <console.h>
+#include <div64.h>
+#include "memtester.h"
 #include "sizes.h"
 #include "types.h"
 #include "tests.h"
@@ -27,6 +29,10 @@
 #define EXIT_FAIL_ADDRESSLINES  0x02
 #define EXIT_FAIL_OTHERTEST     0x04
 
+#define TEST_STUCK_ADDRESS	BIT(17)	/* in testenable */
+/* how long the others may take after cpu0 finished a pass */
+#define MP_WAIT_MS		60000
+
 struct test tests[] = {
 	{"Random Value", test_random_value},
 	{"Compare XOR", test_xor_comparison},
@@ -52,6 +58,38 @@ struct test tests[] = {
 
 int use_phys;
 off_t physaddrbase;
+int memtester_mp;
+
+/*
+ * struct memtester_cpu - part of the range a cpu tests in the multi-core mode
+ *
+ * @fail: tests failed by the last pass, bits as in testenable
+ * @bytes: size tested by the last pass, the range times the tests run
+ * @time_us: time of the last pass
+ */
+struct memtester_cpu {
+	u32v *bufa[CONFIG_NR_DRAM_BANKS];
+	u32v *bufb[CONFIG_NR_DRAM_BANKS];
+	ul count[CONFIG_NR_DRAM_BANKS];
+	ul fail;
+	u64 bytes;
+	ulong time_us;
+};
+
+static struct memtester_cpu mp_cpu[CPU_NUM_MAX];
+static int mp_test_banks;
+static ul mp_testenable, mp_err_exit, mp_fix_bit, mp_fix_level;
+static volatile int mp_abort;
+
+static void print_exit_code(int exit_code)
+{
+	if (exit_code & EXIT_FAIL_NONSTARTER)
+		printf("Fail: EXIT_FAIL_NONSTARTER\n");
+	if (exit_code & EXIT_FAIL_ADDRESSLINES)
+		printf("Fail: EXIT_FAIL_ADDRESSLINES\n");
+	if (exit_code & EXIT_FAIL_OTHERTEST)
+		printf("Fail: EXIT_FAIL_OTHERTEST\n");
+}
 
 /*
  * arg[0]: test start address
@@ -99,7 +137,7 @@ int doing_memtester(ul *arg, ul testenable, ul loops, ul err_exit,
 			if (loops)
 				printf("/%lu", loops);
 			printf(":\n");
-			if (testenable && ((1 << 17) & testenable)) {
+			if (testenable && (TEST_STUCK_ADDRESS & testenable)) {
 				printf("  %-20s: ", "Stuck Address");
 				if (!test_stuck_address(bufa[j], count[j] * 2))
 					printf("ok\n");
@@ -139,12 +177,169 @@ int doing_memtester(ul *arg, ul testenable, ul loops, ul err_exit,
 	}
 
 out:
-	if (exit_code & EXIT_FAIL_NONSTARTER)
-		printf("Fail: EXIT_FAIL_NONSTARTER\n");
-	if (exit_code & EXIT_FAIL_ADDRESSLINES)
-		printf("Fail: EXIT_FAIL_ADDRESSLINES\n");
-	if (exit_code & EXIT_FAIL_OTHERTEST)
-		printf("Fail: EXIT_FAIL_OTHERTEST\n");
+	print_exit_code(exit_code);
+
+	if (exit_code)
+		return -1;
+	return 0;
+}
+
+static void memtester_mp_abort(void)
+{
+	mp_abort = 1;
+	flush_dcache_range((ulong)&mp_abort, (ulong)&mp_abort + sizeof(mp_abort));
+}
+
+/* One pass of the tests over the part of the range of @cpu */
+static void memtester_mp_pass(int cpu)
+{
+	struct memtester_cpu *c = &mp_cpu[cpu];
+	ulong start = timer_get_us();
+	ul i, j;
+
+	c->fail = 0;
+	c->bytes = 0;
+	for (j = 0; j < mp_test_banks && !mp_abort; j++) {
+		if (!c->count[j])
+			continue;
+		if (mp_testenable && (TEST_STUCK_ADDRESS & mp_testenable)) {
+			if (test_stuck_address(c->bufa[j], c->count[j] * 2))
+				c->fail |= TEST_STUCK_ADDRESS;
+			c->bytes += (u64)c->count[j] * 2 * sizeof(u32);
+		}
+		for (i = 0; tests[i].name; i++) {
+			if (mp_testenable && (!((1 << i) & mp_testenable)))
+				continue;
+			if (tests[i].fp(c->bufa[j], c->bufb[j], c->count[j],
+					mp_fix_bit, mp_fix_level)) {
+				c->fail |= 1 << i;
+				if (mp_err_exit)
+					memtester_mp_abort();
+			}
+			c->bytes += (u64)c->count[j] * 2 * sizeof(u32);
+			/* only cpu0 may use the console */
+			if (!cpu && ctrlc())
+				memtester_mp_abort();
+			if (mp_abort)
+				break;
+		}
+	}
+	c->time_us = timer_get_us() - start;
+	flush_dcache_range((ulong)c, (ulong)(c + 1));
+}
+
+static void memtester_mp_result(const char *name, int cpus, ul bit)
+{
+	int cpu, failed = 0;
+
+	printf("  %-20s: ", name);
+	for (cpu = 0; cpu < cpus; cpu++) {
+		if (mp_cpu[cpu].fail & bit) {
+			printf(failed ? " %d" : "FAIL on CPU %d", cpu);
+			failed = 1;
+		}
+	}
+	printf(failed ? "\n" : "ok\n");
+}
+
+/*
+ * The same as doing_memtester(), but the range is split between all the cpus
+ * and they test their part of it at once.
+ */
+int doing_memtester_mp(ul *arg, ul testenable, ul loops, ul err_exit,
+		       ul fix_bit, ul fix_level)
+{
+	ul start_adr[CONFIG_NR_DRAM_BANKS], length[CONFIG_NR_DRAM_BANKS];
+	ul loop, slice, len, fail, i;
+	ulong ms;
+	u64 bytes;
+	int exit_code = 0;
+	int cpus, cpu, j;
+
+	get_print_available_addr(start_adr, length, 0);
+
+	mp_test_banks = judge_test_addr(arg, start_adr, length);
+
+	if (!mp_test_banks) {
+		printf("unavailable test address\n");
+		return -1;
+	}
+
+	cpus = ddr_tool_cpus_on();
+	memset(mp_cpu, 0, sizeof(mp_cpu));
+	for (j = 0; j < mp_test_banks; j++) {
+		/* a 4k aligned part of each bank, the last cpu takes the rest */
+		slice = (length[j] / cpus) & ~0xfffUL;
+		for (cpu = 0; cpu < cpus; cpu++) {
+			len = cpu == cpus - 1 ? length[j] - slice * cpu : slice;
+			mp_cpu[cpu].bufa[j] = (u32v *)(start_adr[j] + slice * cpu);
+			mp_cpu[cpu].bufb[j] = (u32v *)(start_adr[j] + slice * cpu +
+						       len / 2);
+			mp_cpu[cpu].count[j] = len / 2 / sizeof(u32);
+		}
+		if (length[j])
+			printf("testing:0x%lx - 0x%lx on %d CPUs\n", start_adr[j],
+			       start_adr[j] + length[j], cpus);
+	}
+
+	mp_testenable = testenable;
+	mp_err_exit = err_exit;
+	mp_fix_bit = fix_bit;
+	mp_fix_level = fix_level;
+	mp_abort = 0;
+	print_mutex = 0;
+	memtester_mp = 1;
+
+	data_cpu_2_io_init();
+
+	for (loop = 1; ((!loops) || loop <= loops) && !mp_abort; loop++) {
+		flush_dcache_all();
+		if (cpus > 1)
+			ddr_tool_cpus_run(memtester_mp_pass);
+		memtester_mp_pass(0);
+		for (cpu = 1; cpu < cpus; cpu++) {
+			if (ddr_tool_cpu_wait(cpu, MP_WAIT_MS)) {
+				printf("CPU%d did not finish the tests\n", cpu);
+				exit_code |= EXIT_FAIL_NONSTARTER;
+				mp_abort = 1;
+			}
+		}
+		if (exit_code & EXIT_FAIL_NONSTARTER)
+			break;
+
+		printf("Loop %lu", loop);
+		if (loops)
+			printf("/%lu", loops);
+		printf(":\n");
+		fail = 0;
+		for (cpu = 0; cpu < cpus; cpu++)
+			fail |= mp_cpu[cpu].fail;
+		if (testenable && (TEST_STUCK_ADDRESS & testenable))
+			memtester_mp_result("Stuck Address", cpus,
+					    TEST_STUCK_ADDRESS);
+		for (i = 0; tests[i].name; i++) {
+			if (testenable && (!((1 << i) & testenable)))
+				continue;
+			memtester_mp_result(tests[i].name, cpus, 1 << i);
+		}
+		if (fail & TEST_STUCK_ADDRESS)
+			exit_code |= EXIT_FAIL_ADDRESSLINES;
+		if (fail & ~TEST_STUCK_ADDRESS)
+			exit_code |= EXIT_FAIL_OTHERTEST;
+
+		bytes = 0;
+		for (cpu = 0; cpu < cpus; cpu++) {
+			bytes += mp_cpu[cpu].bytes;
+			ms = max(mp_cpu[cpu].time_us / 1000, 1UL);
+			printf("  CPU%-2d %8lu ms %6lu MB/s\n", cpu, ms,
+			       (ulong)lldiv(mp_cpu[cpu].bytes, ms) / 1000);
+		}
+		printf("  total %8lu MB tested\n\n",
+		       (ulong)lldiv(bytes, 1000000));
+	}
+	memtester_mp = 0;
+
+	print_exit_code(exit_code);
 
 	if (exit_code)
 		return -1;
@@ -161,6 +356,7 @@ static int do_memtester(cmd_tbl_t *cmdtp, int flag, int argc,
 	ul err_exit = 0;
 	ul fix_bit = 0;
 	ul fix_level = 0;
+	int mp = 0;
 
 	printf("memtester version " __version__ " (%d-bit)\n", UL_LEN);
 	printf("Copyright (C) 2001-2012 Charles Cazabon.\n");
@@ -169,6 +365,12 @@ static int do_memtester(cmd_tbl_t *cmdtp, int flag, int argc,
 
 	get_print_available_addr(start_adr, length, 1);
 
+	if (argc > 1 && !strcmp(argv[1], "-m")) {
+		mp = 1;
+		argc--;
+		argv++;
+	}
+
 	if (argc < 2)
 		return CMD_RET_USAGE;
 
@@ -199,15 +401,21 @@ static int do_memtester(cmd_tbl_t *cmdtp, int flag, int argc,
 		if (strict_strtoul(argv[7], 0, &loops) < 0)
 			return CMD_RET_USAGE;
 
-	doing_memtester(arg, testenable, loops, err_exit, fix_bit, fix_level);
+	if (mp)
+		doing_memtester_mp(arg, testenable, loops, err_exit, fix_bit,
+				   fix_level);
+	else
+		doing_memtester(arg, testenable, loops, err_exit, fix_bit,
+				fix_level);
 
 	printf("Done.\n");
 	return 0;
 }
 
-U_BOOT_CMD(memtester, 8, 1, do_memtester,
+U_BOOT_CMD(memtester, 9, 1, do_memtester,
 	   "do memtester",
-	   "[start length [testenable err_exit fix_bit fix_level [loop]]]\n"
+	   "[-m] [start length [testenable err_exit fix_bit fix_level [loop]]]\n"
+	   "-m: test on all CPUs at once, each CPU tests a part of the range\n"
 	   "start: start address, should be 4k align\n"
 	   "length: test length, should be 4k align, if 0 testing full space\n"
 	   "testenable[option]: enable pattern by set bit to 1, null or 0"
@@ -240,4 +448,5 @@ U_BOOT_CMD(memtester, 8, 1, do_memtester,
 	   "0x1000000, enable all pattern, endless loop\n"
 	   "	memtester 0x200000 0x1000000 0x1000 100: start address:0x200000"
 	   " length:0x1000000, Bit Flip only, loop 100 times\n"
-	   "	memtester 0 0: testing full space\n");
+	   "	memtester 0 0: testing full space\n"
+	   "	memtester -m 0 0 0 0 0 0 1: testing full space once on all CPUs\n");
@@ -21,8 +21,12 @@
 
 extern int use_phys;
 extern off_t physaddrbase;
+extern int memtester_mp;
 
 int doing_memtester(unsigned long *arg, unsigned long testenable,
 		    unsigned long loops, unsigned long err_exit,
 		    unsigned long fix_bit, unsigned long fix_level);
+int doing_memtester_mp(unsigned long *arg, unsigned long testenable,
+		       unsigned long loops, unsigned long err_exit,
+		       unsigned long fix_bit, unsigned long fix_level);
 #endif /* __CMD_DDR_TOOL_MEMTESTER_MEMTESTER_H */
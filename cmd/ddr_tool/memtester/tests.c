@@ -18,6 +18,15 @@
 #include "sizes.h"
 #include "types.h"
 #include "../io_map.h"
+#include "../ddr_tool_common.h"
+
+/*
+ * In the multi-core mode every cpu runs the tests at once, so the progress
+ * is not shown and the failures are printed one cpu at a time, with their
+ * address as the offset is into the part of the range of that cpu.
+ */
+#define printf(fmt...)	do { if (!memtester_mp) printf(fmt); } while (0)
+#define putc(c)		do { if (!memtester_mp) putc(c); } while (0)
 
 union {
 	unsigned char bytes[UL_LEN / 8];
@@ -47,7 +56,14 @@ int compare_regions(u32v *bufa, u32v *bufb, size_t count)
 
 	for (i = 0; i < count; i++, p1++, p2++) {
 		if (*p1 != *p2) {
-			if (use_phys) {
+			if (memtester_mp) {
+				lock_byte_mutex(&print_mutex);
+				fprintf(stderr,
+					"FAILURE: 0x%08lx != 0x%08lx at address "
+					"0x%08lx.\n",
+					(ul)*p1, (ul)*p2, (ul)p1);
+				unlock_byte_mutex(&print_mutex);
+			} else if (use_phys) {
 				physaddr = physaddrbase + (i * sizeof(u32v));
 				fprintf(stderr,
 					"FAILURE: 0x%08lx != 0x%08lx at physical address "
@@ -91,7 +107,13 @@ int test_stuck_address(u32v *bufa, size_t count)
 		for (i = 0; i < count; i++, p1++) {
 			if (*p1 != (((j + i) % 2) == 0 ?
 				    (u32)(ul)p1 : ~((u32)(ul)p1))) {
-				if (use_phys) {
+				if (memtester_mp) {
+					lock_byte_mutex(&print_mutex);
+					fprintf(stderr,
+						"FAILURE: possible bad address line at "
+						"address 0x%08lx.\n", (ul)p1);
+					unlock_byte_mutex(&print_mutex);
+				} else if (use_phys) {
 					physaddr =
 					    physaddrbase + (i * sizeof(u32v));
 					fprintf(stderr,
@@ -20,7 +20,6 @@
 #include <amp.h>
 #include <div64.h>
 #include <malloc.h>
-#include <asm/arch/rockchip_smccc.h>
 #include "stressapptest.h"
 #include "../ddr_tool_common.h"
 
@@ -34,8 +33,6 @@
 #define PAT_NUM			26
 #define PATTERN_LIST_SIZE	(PAT_NUM * 2 * 4)
 
-#define CPU_NUM_MAX		16
-
 static u32 walking_1_data[] = {
 	0x00000001, 0x00000002, 0x00000004, 0x00000008,
 	0x00000010, 0x00000020, 0x00000040, 0x00000080,
@@ -418,17 +415,6 @@ static u32 cpu_inv_err[CPU_NUM_MAX];
 static u64 start_time_us;
 static u64 test_time_us;
 
-static bool cpu_init_finish[CPU_NUM_MAX];
-static bool cpu_test_finish[CPU_NUM_MAX];
-static bool pattern_page_init_finish;
-
-#if (CPU_NUM_MAX > 1)
-static ulong test_count = 0;
-static ulong __gd;	/* set r9/x18 of secondary cpu to gd addr */
-#endif
-ulong __sp;		/* set sp of secondary cpu */
-
-u32 print_mutex;	/* 0: unlock, 1: lock */
 
 static u64 get_time_us(void)
 {
@@ -955,58 +941,21 @@ static u32 page_copy(struct stressapptest_params *sat, u8 cpu_id)
 	return err;
 }
 
-void secondary_main(void)
+/* The test of a secondary cpu, run by ddr_tool_cpus_run() */
+static void secondary_test(int cpu)
 {
-#if (CPU_NUM_MAX > 1)
-	u8 cpu_id;
-	ulong test = 0;
-
-#ifndef CONFIG_ARM64
-	asm volatile("mov r9, %0" : : "r" (__gd));	/* set r9 to gd addr */
-#else
-	asm volatile("mov x18, %0" : : "r" (__gd));	/* set x18 to gd addr */
-#endif
-	dcache_enable();
-	icache_enable();
-
-	udelay(100);
-
-	flush_dcache_all();
-
-	cpu_id = sat.cpu_num;
-	cpu_init_finish[cpu_id] = 1;
-	printf("CPU%d start OK.\n", cpu_id);
-
-	while (pattern_page_init_finish == 0) {
-		udelay(100);
-		flush_dcache_all();
-	}
+	u8 cpu_id = cpu;
 
-	while (1) {
-		udelay(100);
-		flush_dcache_all();
-		while (test < test_count) {
-			cpu_test_finish[cpu_id] = 0;
-			flush_dcache_all();
-			while (run_time_us() < test_time_us) {
-				if (rand() % 2 == 0)
-					cpu_copy_err[cpu_id] += page_copy(&sat, cpu_id);
-				else
-					cpu_inv_err[cpu_id] += page_inv(&sat, cpu_id);
-			}
-			test++;
-			cpu_test_finish[cpu_id] = 1;
-			flush_dcache_range((ulong)&cpu_test_finish[cpu_id],
-					   (ulong)&cpu_test_finish[cpu_id + 1]);
-			flush_dcache_range((ulong)&cpu_copy_err[cpu_id],
-					   (ulong)&cpu_copy_err[cpu_id + 1]);
-			flush_dcache_range((ulong)&cpu_inv_err[cpu_id],
-					   (ulong)&cpu_inv_err[cpu_id + 1]);
-		}
+	while (run_time_us() < test_time_us) {
+		if (rand() % 2 == 0)
+			cpu_copy_err[cpu_id] += page_copy(&sat, cpu_id);
+		else
+			cpu_inv_err[cpu_id] += page_inv(&sat, cpu_id);
 	}
-#else
-	return;
-#endif
+	flush_dcache_range((ulong)&cpu_copy_err[cpu_id],
+			   (ulong)&cpu_copy_err[cpu_id + 1]);
+	flush_dcache_range((ulong)&cpu_inv_err[cpu_id],
+			   (ulong)&cpu_inv_err[cpu_id + 1]);
 }
 
 static int doing_stressapptest(void)
@@ -1027,37 +976,11 @@ static int doing_stressapptest(void)
 	for (i = 0; i < CPU_NUM_MAX; i++) {
 		cpu_copy_err[i] = 0;
 		cpu_inv_err[i] = 0;
-		cpu_init_finish[i] = 0;
-		cpu_test_finish[i] = 0;
 	}
-	pattern_page_init_finish = 0;
 	print_mutex = 0;
 	asm volatile("clrex");
 
-#if (CPU_NUM_MAX > 1)
-	if (test_count == 0) {
-		__gd = (ulong)gd;
-		asm volatile("mov %0, sp" : "=r" (__sp));
-		printf("CPU0 sp is at 0x%lx now.\n", __sp);
-		__sp &= ~(ulong)0xffff;
-		for (sat.cpu_num = 1; sat.cpu_num < CPU_NUM_MAX; sat.cpu_num++) {
-			__sp -= 0x10000;
-			flush_dcache_all();
-			if (psci_cpu_on(sat.cpu_num, (ulong)secondary_init) == 0) {
-				mdelay(10);
-				printf("Calling CPU%d, sp = 0x%lx\n", sat.cpu_num, __sp);
-			} else {
-				break;
-			}
-			while (cpu_init_finish[sat.cpu_num] == 0) {
-				udelay(1000);
-				flush_dcache_all();
-			}
-		}
-	}
-#else
-	sat.cpu_num = 1;
-#endif
+	sat.cpu_num = ddr_tool_cpus_on();
 
 	if (sat.total_test_size_mb == 0)
 		sat.page_num = get_max_page_num(sat.page_size_byte);
@@ -1084,13 +1007,8 @@ static int doing_stressapptest(void)
 	pattern_list_init(pattern_list, &sat);
 	page_init(pattern_list, &sat);
 
-#if (CPU_NUM_MAX > 1)
-	if (sat.cpu_num > 1) {
-		pattern_page_init_finish = 1;
-		test_count++;
-		flush_dcache_all();
-	}
-#endif
+	if (sat.cpu_num > 1)
+		ddr_tool_cpus_run(secondary_test);
 
 	pre_10s = (u32)(run_time_us() / 1000000 / 10);
 	lock_byte_mutex(&print_mutex);
@@ -1115,25 +1033,17 @@ static int doing_stressapptest(void)
 		}
 	}
 
-#if (CPU_NUM_MAX > 1)
 	for (i = 1; i < sat.cpu_num; i++) {
-		while (cpu_test_finish[i] == 0) {
-			if ((u32)(run_time_us() / 1000000 / 10) > pre_10s + 6) {
-				/* wait for secondary CPU in 60s */
-				lock_byte_mutex(&print_mutex);
-				print_time_stamp();
-				printf("ERROR: Cannot wait for CPU%d to finish!\n", i);
-				unlock_byte_mutex(&print_mutex);
-				cpu_no_response_err++;
-				break;
-			}
-			mdelay(1);
-			flush_dcache_range((ulong)&cpu_test_finish[i],
-					   (ulong)&cpu_test_finish[i + 1]);
+		/* wait for secondary CPU in 60s */
+		if (ddr_tool_cpu_wait(i, 60000)) {
+			lock_byte_mutex(&print_mutex);
+			print_time_stamp();
+			printf("ERROR: Cannot wait for CPU%d to finish!\n", i);
+			unlock_byte_mutex(&print_mutex);
+			cpu_no_response_err++;
 		}
 	}
 	flush_dcache_all();
-#endif
 
 	for (i = 0; i < sat.cpu_num; i++) {
 		all_copy_err += cpu_copy_err[i];
@@ -63,8 +63,4 @@ struct page {
 	bool valid;	/* 1: valid, 0: empty */
 } *page_list;
 
-extern void secondary_init(void);
-extern void lock_byte_mutex(u32 *flag);
-extern u32 unlock_byte_mutex(u32 *flag);
-
 #endif /* __CMD_DDR_TOOL_STRESSAPPTEST_STRESSAPPTEST_H */
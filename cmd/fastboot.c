@@ -10,6 +10,7 @@
 #include <common.h>
 #include <command.h>
 #include <console.h>
+#include <fastboot.h>
 #include <g_dnl.h>
 #include <net.h>
 #include <usb.h>
@@ -75,6 +76,8 @@ static int do_fastboot(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 	printf("OK\n");
 
 	while (1) {
+		/* Before detaching, the host has been told it is written */
+		fastboot_flash_run(controller_index);
 		if (g_dnl_detach())
 			break;
 		if (ctrlc())
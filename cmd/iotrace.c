@@ -12,7 +12,8 @@ static void do_print_stats(void)
 {
 	ulong start, size, offset, count;
 
-	printf("iotrace is %sabled\n", iotrace_get_enabled() ? "en" : "dis");
+	printf("iotrace is %sabled%s\n", iotrace_get_enabled() ? "en" : "dis",
+	       iotrace_get_ring() ? ", ring mode" : "");
 	iotrace_get_buffer(&start, &size, &offset, &count);
 	printf("Start:  %08lx\n", start);
 	printf("Size:   %08lx\n", size);
@@ -20,6 +21,7 @@ static void do_print_stats(void)
 	printf("Output: %08lx\n", start + offset);
 	printf("Count:  %08lx\n", count);
 	printf("CRC32:  %08lx\n", (ulong)iotrace_get_checksum());
+	iotrace_print_filters();
 }
 
 static int do_set_buffer(int argc, char * const argv[])
@@ -38,6 +40,43 @@ static int do_set_buffer(int argc, char * const argv[])
 	return 0;
 }
 
+static int do_set_filter(int argc, char * const argv[])
+{
+	ulong addr, size;
+	int ret;
+
+	if (argc == 0) {
+		iotrace_clear_filters();
+		return 0;
+	} else if (argc != 2) {
+		return CMD_RET_USAGE;
+	}
+
+	addr = simple_strtoul(argv[0], NULL, 16);
+	size = simple_strtoul(argv[1], NULL, 16);
+	ret = iotrace_add_filter(addr, size);
+	if (ret) {
+		printf("Can't add filter (err=%d)\n", ret);
+		return CMD_RET_FAILURE;
+	}
+
+	return 0;
+}
+
+static int do_set_ring(int argc, char * const argv[])
+{
+	if (argc != 1)
+		return CMD_RET_USAGE;
+	if (!strcmp(argv[0], "on"))
+		iotrace_set_ring(1);
+	else if (!strcmp(argv[0], "off"))
+		iotrace_set_ring(0);
+	else
+		return CMD_RET_USAGE;
+
+	return 0;
+}
+
 int do_iotrace(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	const char *cmd = argc < 2 ? NULL : argv[1];
@@ -47,14 +86,22 @@ int do_iotrace(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 	switch (*cmd) {
 	case 'b':
 		return do_set_buffer(argc - 2, argv + 2);
+	case 'f':
+		return do_set_filter(argc - 2, argv + 2);
 	case 'p':
 		iotrace_set_enabled(0);
 		break;
 	case 'r':
+		if (!strcmp(cmd, "ring"))
+			return do_set_ring(argc - 2, argv + 2);
 		iotrace_set_enabled(1);
 		break;
 	case 's':
-		do_print_stats();
+		if (!strcmp(cmd, "summary"))
+			iotrace_print_summary(argc > 2 ?
+				simple_strtoul(argv[2], NULL, 10) : 10);
+		else
+			do_print_stats();
 		break;
 	default:
 		return CMD_RET_USAGE;
@@ -69,5 +116,11 @@ U_BOOT_CMD(
 	"stats                        - display iotrace stats\n"
 	"iotrace buffer <address> <size>      - set iotrace buffer\n"
 	"iotrace pause                        - pause tracing\n"
-	"iotrace resume                       - resume tracing"
+	"iotrace resume                       - resume tracing\n"
+	"iotrace ring on|off                  - overwrite the oldest records\n"
+	"                                       when the buffer is full\n"
+	"iotrace filter [<address> <size>]    - only trace this range, up to 4;\n"
+	"                                       no range traces all again\n"
+	"iotrace summary [<n>]                - list the <n> registers accessed\n"
+	"                                       and polled most"
 );
@@ -0,0 +1,116 @@
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <command.h>
+#include <mapmem.h>
+#include <mem_large.h>
+
+struct membench {
+	const char *name;
+	void (*fn)(void *dst, void *src, size_t n);
+};
+
+/* The word-at-a-time loop of the generic lib/string.c memcpy() */
+static void bench_word_copy(void *dst, void *src, size_t n)
+{
+	ulong *dl = dst, *sl = src;
+
+	for (; n >= sizeof(*dl); n -= sizeof(*dl))
+		*dl++ = *sl++;
+}
+
+static void bench_memcpy(void *dst, void *src, size_t n)
+{
+	memcpy(dst, src, n);
+}
+
+static void bench_memmove(void *dst, void *src, size_t n)
+{
+	/* Overlapping move up by a cache line */
+	memmove(src + 64, src, n - 64);
+}
+
+static void bench_memset(void *dst, void *src, size_t n)
+{
+	memset(dst, 0, n);
+}
+
+#ifdef CONFIG_ROCKCHIP_MEM_LARGE
+static void bench_memcpy_large(void *dst, void *src, size_t n)
+{
+	memcpy_large(dst, src, n);
+}
+
+static void bench_memset_large(void *dst, void *src, size_t n)
+{
+	memset_large(dst, 0, n);
+}
+#endif
+
+static const struct membench membench_list[] = {
+	{ "word loop", bench_word_copy },
+	{ "memcpy", bench_memcpy },
+	{ "memmove", bench_memmove },
+	{ "memset", bench_memset },
+#ifdef CONFIG_ROCKCHIP_MEM_LARGE
+	{ "memcpy_large", bench_memcpy_large },
+	{ "memset_large", bench_memset_large },
+#endif
+};
+
+static int do_membench(cmd_tbl_t *cmdtp, int flag, int argc,
+		       char * const argv[])
+{
+	const struct membench *b;
+	ulong dst, src, size, loops = 1;
+	ulong start, us, i;
+	void *d, *s;
+
+	if (argc < 4)
+		return CMD_RET_USAGE;
+
+	dst = simple_strtoul(argv[1], NULL, 16);
+	src = simple_strtoul(argv[2], NULL, 16);
+	size = simple_strtoul(argv[3], NULL, 16);
+	if (argc > 4)
+		loops = simple_strtoul(argv[4], NULL, 10) ? : 1;
+
+	if (size <= 64 || (dst < src + size && src < dst + size)) {
+		printf("Need two distinct regions of more than 64 bytes\n");
+		return CMD_RET_FAILURE;
+	}
+
+	d = map_sysmem(dst, size);
+	s = map_sysmem(src, size);
+
+	for (b = membench_list; b < membench_list + ARRAY_SIZE(membench_list);
+	     b++) {
+		/* Warm up, so the first variant gets no unfair TLB misses */
+		b->fn(d, s, size);
+
+		start = timer_get_us();
+		for (i = 0; i < loops; i++)
+			b->fn(d, s, size);
+		us = timer_get_us() - start ? : 1;
+
+		printf("%-14s %8lu us  %6llu MB/s\n", b->name, us / loops,
+		       (u64)size * loops / us);
+	}
+
+	unmap_sysmem(s);
+	unmap_sysmem(d);
+
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_CMD(
+	membench,	5,	0,	do_membench,
+	"compare the memory copy and fill routines",
+	"dst src size [loops]\n"
+	"    - time each variant on 'size' bytes from 'src' to 'dst' (hex),\n"
+	"      averaged over 'loops' runs"
+);
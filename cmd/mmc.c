@@ -295,7 +295,7 @@ int do_authenticatedread(struct s_rpmb *requestpackets, uint16_t block_count)
 	return ret;
 }
 
-int do_authenticatedwrite(struct s_rpmb *requestpackets)
+int do_authenticatedwrite(struct s_rpmb *requestpackets, uint16_t block_count)
 {
 	int ret;
 	struct mmc *mmc = find_mmc_device(curr_device);
@@ -305,7 +305,7 @@ int do_authenticatedwrite(struct s_rpmb *requestpackets)
 	if (init_rpmb() != 0)
 		return -1;
 
-	ret = authenticated_write(mmc, requestpackets);
+	ret = authenticated_write(mmc, requestpackets, block_count);
 
 	if (finish_rpmb() != 0)
 		return -1;
@@ -945,6 +945,29 @@ static int do_mmc_rst_func(cmd_tbl_t *cmdtp, int flag,
 	return mmc_set_rst_n_function(mmc, enable);
 }
 #endif
+#if CONFIG_IS_ENABLED(MMC_STATS)
+static int do_mmc_stat(cmd_tbl_t *cmdtp, int flag,
+		       int argc, char * const argv[])
+{
+	struct mmc *mmc;
+
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "reset")))
+		return CMD_RET_USAGE;
+
+	mmc = find_mmc_device(curr_device);
+	if (!mmc) {
+		printf("no mmc device at slot %x\n", curr_device);
+		return CMD_RET_FAILURE;
+	}
+	if (argc == 2)
+		mmc_stats_reset(mmc);
+	else
+		mmc_stats_show(mmc);
+
+	return CMD_RET_SUCCESS;
+}
+#endif
+
 static int do_mmc_setdsr(cmd_tbl_t *cmdtp, int flag,
 			 int argc, char * const argv[])
 {
@@ -1022,6 +1045,9 @@ static cmd_tbl_t cmd_mmc[] = {
 	U_BOOT_CMD_MKENT(rpmb, CONFIG_SYS_MAXARGS, 1, do_mmcrpmb, "", ""),
 #endif
 	U_BOOT_CMD_MKENT(setdsr, 2, 0, do_mmc_setdsr, "", ""),
+#if CONFIG_IS_ENABLED(MMC_STATS)
+	U_BOOT_CMD_MKENT(stat, 2, 1, do_mmc_stat, "", ""),
+#endif
 #ifdef CONFIG_CMD_BKOPS_ENABLE
 	U_BOOT_CMD_MKENT(bkops-enable, 2, 0, do_mmc_bkops_enable, "", ""),
 #endif
@@ -1093,6 +1119,9 @@ U_BOOT_CMD(
 	"mmc rpmb counter - read the value of the write counter\n"
 #endif
 	"mmc setdsr <value> - set DSR register value\n"
+#if CONFIG_IS_ENABLED(MMC_STATS)
+	"mmc stat [reset] - show or clear the command latencies of current device\n"
+#endif
 #ifdef CONFIG_CMD_BKOPS_ENABLE
 	"mmc bkops-enable <dev> - enable background operations handshake on device\n"
 	"   WARNING: This is a write-once setting.\n"
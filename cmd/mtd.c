@@ -445,6 +445,29 @@ static int do_mtd(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		for (off = 0; off < mtd->size; off += mtd->erasesize)
 			if (mtd_block_isbad(mtd, off))
 				printf("\t0x%08llx\n", off);
+#ifdef CONFIG_MTD_ECC_STATS
+	} else if (!strcmp(cmd, "stat")) {
+		const struct mtd_eb_stats *st;
+		loff_t off;
+
+		if (argc > 0 && !strcmp(argv[0], "reset")) {
+			mtd_ecc_stats_reset(mtd);
+			return CMD_RET_SUCCESS;
+		}
+
+		printf("MTD device %s ECC stats, bitflip threshold %u:\n",
+		       mtd->name, mtd->bitflip_threshold);
+		printf("\toffset          reads  corrected  max  failed\n");
+		for (off = 0; off < mtd->size; off += mtd->erasesize) {
+			st = mtd_ecc_stats_get(mtd, off);
+			if (!st || !st->reads)
+				continue;
+			printf("\t0x%08llx %10u %10u %4u %7u%s\n", off,
+			       st->reads, st->corrected, st->max_bitflips,
+			       st->failed, mtd_block_needs_refresh(mtd, off) ?
+			       "  refresh" : "");
+		}
+#endif
 	} else {
 		return CMD_RET_USAGE;
 	}
@@ -464,6 +487,9 @@ U_BOOT_CMD(
 	"\n"
 	"Specific functions:\n"
 	"mtd bad                               <name>\n"
+#ifdef CONFIG_MTD_ECC_STATS
+	"mtd stat                              <name> [reset]\n"
+#endif
 	"\n"
 	"With:\n"
 	"\t<name>: NAND partition/chip name\n"
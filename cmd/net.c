@@ -12,8 +12,10 @@
 #include <command.h>
 #include <net.h>
 #include <boot_rkimg.h>
+#include <linux/sizes.h>
 
 static int netboot_common(enum proto_t, cmd_tbl_t *, int, char * const []);
+static void netboot_update_env(void);
 
 static int do_bootp(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
@@ -80,15 +82,37 @@ U_BOOT_CMD(
 #endif
 
 #ifdef CONFIG_CMD_TFTP_FLASH
+/* Flash what has been received every this much, while the rest comes in */
+#define TFTP_FLASH_CHUNK	SZ_1M
+
+static int tftpflash_write(struct blk_desc *dev_desc, disk_partition_t *part,
+			   lbaint_t *written, lbaint_t end)
+{
+	lbaint_t blknum;
+
+	if (end <= *written)
+		return 0;
+	if (end > part->size)
+		return -ENOSPC;
+
+	blknum = end - *written;
+	if (blk_dwrite(dev_desc, part->start + *written, blknum,
+		       (void *)(load_addr + *written * dev_desc->blksz)) != blknum)
+		return -EIO;
+
+	*written = end;
+
+	return 0;
+}
+
 int do_tftpflash(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
-	char *tftp_argv[] = { "tftp", NULL, NULL };
 	struct blk_desc *dev_desc;
 	disk_partition_t part;
-	ulong fileaddr;
-	ulong filesize;
+	lbaint_t written = 0;
+	lbaint_t __maybe_unused end;
 	char *part_name;
-	int ret, blknum;
+	int ret = 0, size;
 
 	if (argc != 4)
 		return CMD_RET_USAGE;
@@ -106,37 +130,57 @@ int do_tftpflash(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		printf("No partition '%s'\n", part_name);
 		return -EINVAL;
 	}
+	ret = 0;
 
-	/* tftp download */
-	tftp_argv[1] = argv[1];
-	tftp_argv[2] = argv[2];
-	if (do_tftpb(cmdtp, 0, ARRAY_SIZE(tftp_argv), tftp_argv))
-		return -ENOENT;
+	load_addr = simple_strtoul(argv[1], NULL, 16);
+	copy_filename(net_boot_file_name, argv[2], sizeof(net_boot_file_name));
 
-	fileaddr = env_get_ulong("fileaddr", 16, 0);
-	filesize = env_get_ulong("filesize", 16, 0);
-	if (!fileaddr || !filesize)
-		return -ENOENT;
+	if (dev_desc->if_type == IF_TYPE_MTD)
+		dev_desc->op_flag |= BLK_MTD_CONT_WRITE;
 
-	/* flash */
-	blknum = DIV_ROUND_UP(filesize, dev_desc->blksz);
-	if (blknum > part.size) {
-		printf("File size 0x%lx is too large to flash\n", filesize);
-		return -EINVAL;
+	/*
+	 * tftp download, flashing as it goes. TFTP stores blocks in order,
+	 * so all of the file below net_boot_file_size is in. With multicast
+	 * it is not, so that has to wait for the end.
+	 */
+	size = net_loop_start(TFTPGET);
+	if (!size) {
+		do {
+			size = net_loop_poll();
+#ifndef CONFIG_MCAST_TFTP
+			end = net_boot_file_size / dev_desc->blksz;
+			if (size == -EAGAIN && !ret &&
+			    end >= written + TFTP_FLASH_CHUNK / dev_desc->blksz)
+				ret = tftpflash_write(dev_desc, &part, &written,
+						      end);
+#endif
+		} while (size == -EAGAIN);
 	}
 
-	printf("## TFTP flash %s to partititon '%s' size 0x%lx ... ",
-	       argv[2], part_name, filesize);
+	/* flash the rest */
+	if (size > 0 && !ret)
+		ret = tftpflash_write(dev_desc, &part, &written,
+				      DIV_ROUND_UP(size, dev_desc->blksz));
 
-	if (dev_desc->if_type == IF_TYPE_MTD)
-		dev_desc->op_flag |= BLK_MTD_CONT_WRITE;
-	ret = blk_dwrite(dev_desc, part.start, blknum, (void *)fileaddr);
 	if (dev_desc->if_type == IF_TYPE_MTD)
 		dev_desc->op_flag &= ~(BLK_MTD_CONT_WRITE);
-	if (ret != blknum)
+
+	if (size <= 0)
+		return -ENOENT;
+
+	netboot_update_env();
+
+	printf("## TFTP flash %s to partititon '%s' size 0x%x ... ",
+	       argv[2], part_name, size);
+
+	if (ret == -ENOSPC) {
+		printf("File size 0x%x is too large to flash\n", size);
+		return -EINVAL;
+	} else if (ret) {
 		printf("Failed(%d)\n", ret);
-	else
+	} else {
 		printf("OK\n");
+	}
 
 	return 0;
 }
@@ -0,0 +1,259 @@
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ *
+ * Statistical profiler: the generic timer interrupts the CPU at a fixed
+ * rate and the PC it interrupted is recorded, so the functions which most
+ * samples land in are where the time goes. Unlike the function tracer it
+ * needs no instrumented build.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <irq-generic.h>
+#include <malloc.h>
+#include <asm/sections.h>
+
+#define PROFILE_TIMER_IRQ	27	/* PPI of the virtual timer */
+#define PROFILE_HZ		1000
+#define PROFILE_MAX_HZ		10000
+#define PROFILE_SAMPLES		65536
+#define PROFILE_TOP		20
+
+struct profile {
+	u32 *pcs;		/* offsets into the U-Boot image */
+	ulong size;
+	ulong count;
+	ulong outside;		/* samples of code outside the image */
+	ulong dropped;		/* samples after the buffer was full */
+	ulong period;		/* timer ticks between samples */
+	ulong hz;
+	ulong start;
+	ulong time;		/* ms it ran for */
+	bool running;
+};
+
+struct profile_hit {
+	ulong addr;
+	const char *name;
+	ulong count;
+};
+
+static struct profile prof;
+
+static void profile_timer_set(ulong ticks, int enable)
+{
+	asm volatile("msr cntv_tval_el0, %0" : : "r" (ticks));
+	asm volatile("msr cntv_ctl_el0, %0" : : "r" ((ulong)enable));
+	isb();
+}
+
+static void profile_irq(int irq, void *data)
+{
+	struct pt_regs *regs = get_irq_regs();
+	ulong start = (ulong)__image_copy_start;
+	ulong pc = regs ? regs->elr : 0;
+
+	/* Writing the next interval clears the timer condition */
+	profile_timer_set(prof.period, 1);
+
+	if (pc < start || pc >= (ulong)__image_copy_end)
+		prof.outside++;
+	else if (prof.count < prof.size)
+		prof.pcs[prof.count++] = pc - start;
+	else
+		prof.dropped++;
+}
+
+static int profile_cmp_pc(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a, y = *(const u32 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static int profile_cmp_hits(const void *a, const void *b)
+{
+	const struct profile_hit *x = a, *y = b;
+
+	return x->count < y->count ? 1 : -(x->count > y->count);
+}
+
+/*
+ * Count the samples of each function. The samples are sorted by address,
+ * so those of one function are next to each other.
+ */
+static int profile_group(struct profile_hit *hits)
+{
+	int nr = 0;
+	ulong i;
+
+	for (i = 0; i < prof.count; i++) {
+		ulong pc = CONFIG_SYS_TEXT_BASE + prof.pcs[i];
+		ulong addr = pc;
+		const char *func = NULL;
+
+#ifdef CONFIG_KALLSYMS
+		ulong base;
+
+		func = symbol_lookup(pc, &base);
+		if (func)
+			addr = base;
+#endif
+		if (nr && hits[nr - 1].addr == addr) {
+			hits[nr - 1].count++;
+			continue;
+		}
+		hits[nr].addr = addr;
+		hits[nr].name = func;
+		hits[nr].count = 1;
+		nr++;
+	}
+
+	return nr;
+}
+
+static int do_profile_start(cmd_tbl_t *cmdtp, int flag, int argc,
+			    char * const argv[])
+{
+	ulong hz = PROFILE_HZ, size = PROFILE_SAMPLES;
+
+	if (prof.running) {
+		printf("Profiling is running already\n");
+		return CMD_RET_FAILURE;
+	}
+	if (argc > 1)
+		hz = simple_strtoul(argv[1], NULL, 10);
+	if (argc > 2)
+		size = simple_strtoul(argv[2], NULL, 10);
+	if (!hz || hz > PROFILE_MAX_HZ || !size)
+		return CMD_RET_USAGE;
+
+	if (irq_is_busy(PROFILE_TIMER_IRQ)) {
+		printf("Timer interrupt %d is in use\n", PROFILE_TIMER_IRQ);
+		return CMD_RET_FAILURE;
+	}
+
+	free(prof.pcs);
+	memset(&prof, 0, sizeof(prof));
+	prof.pcs = malloc(size * sizeof(*prof.pcs));
+	if (!prof.pcs) {
+		printf("No memory for %lu samples\n", size);
+		return CMD_RET_FAILURE;
+	}
+	prof.size = size;
+	prof.hz = hz;
+	prof.period = get_tbclk() / hz;
+
+	irq_install_handler(PROFILE_TIMER_IRQ, profile_irq, NULL);
+	profile_timer_set(prof.period, 1);
+	if (irq_handler_enable(PROFILE_TIMER_IRQ)) {
+		irq_free_handler(PROFILE_TIMER_IRQ);
+		profile_timer_set(0, 0);
+		printf("Can't enable timer interrupt %d\n", PROFILE_TIMER_IRQ);
+		return CMD_RET_FAILURE;
+	}
+	prof.start = get_timer(0);
+	prof.running = true;
+
+	return CMD_RET_SUCCESS;
+}
+
+static int do_profile_stop(cmd_tbl_t *cmdtp, int flag, int argc,
+			   char * const argv[])
+{
+	if (!prof.running)
+		return CMD_RET_SUCCESS;
+
+	/* The handler would start the timer again */
+	irq_free_handler(PROFILE_TIMER_IRQ);
+	profile_timer_set(0, 0);
+	prof.time = get_timer(prof.start);
+	prof.running = false;
+	printf("%lu samples in %lu ms\n", prof.count, prof.time);
+
+	return CMD_RET_SUCCESS;
+}
+
+static int do_profile_report(cmd_tbl_t *cmdtp, int flag, int argc,
+			     char * const argv[])
+{
+	struct profile_hit *hits;
+	ulong top = PROFILE_TOP, pct;
+	int i, nr;
+
+	if (prof.running) {
+		printf("Stop profiling first\n");
+		return CMD_RET_FAILURE;
+	}
+	if (!prof.count) {
+		printf("No samples\n");
+		return CMD_RET_SUCCESS;
+	}
+	if (argc > 1)
+		top = simple_strtoul(argv[1], NULL, 10);
+
+	hits = malloc(prof.count * sizeof(*hits));
+	if (!hits) {
+		printf("No memory for the report\n");
+		return CMD_RET_FAILURE;
+	}
+	qsort(prof.pcs, prof.count, sizeof(*prof.pcs), profile_cmp_pc);
+	nr = profile_group(hits);
+	qsort(hits, nr, sizeof(*hits), profile_cmp_hits);
+
+	printf("%lu samples at %lu Hz in %lu ms", prof.count, prof.hz,
+	       prof.time);
+	if (prof.outside)
+		printf(", %lu outside U-Boot", prof.outside);
+	if (prof.dropped)
+		printf(", %lu lost to a full buffer", prof.dropped);
+	printf("\n\n Samples       %%  Function\n");
+	for (i = 0; i < nr && i < top; i++) {
+		pct = hits[i].count * 10000 / prof.count;
+		printf("%8lu %3lu.%02lu%%  ", hits[i].count, pct / 100,
+		       pct % 100);
+		if (hits[i].name)
+			printf("%s\n", hits[i].name);
+		else
+			printf("%08lx\n", hits[i].addr);
+	}
+	free(hits);
+
+	return CMD_RET_SUCCESS;
+}
+
+static cmd_tbl_t cmd_profile_sub[] = {
+	U_BOOT_CMD_MKENT(start, 3, 0, do_profile_start, "", ""),
+	U_BOOT_CMD_MKENT(stop, 1, 0, do_profile_stop, "", ""),
+	U_BOOT_CMD_MKENT(report, 2, 0, do_profile_report, "", ""),
+};
+
+static int do_profile(cmd_tbl_t *cmdtp, int flag, int argc,
+		      char * const argv[])
+{
+	cmd_tbl_t *c;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+
+	/* Strip off leading argument */
+	argc--;
+	argv++;
+
+	c = find_cmd_tbl(argv[0], &cmd_profile_sub[0],
+			 ARRAY_SIZE(cmd_profile_sub));
+	if (!c)
+		return CMD_RET_USAGE;
+
+	return c->cmd(cmdtp, flag, argc, argv);
+}
+
+U_BOOT_CMD(
+	profile, 4, 0, do_profile,
+	"sample where the CPU spends its time",
+	"start [<hz> [<samples>]] - sample the PC, default 1000 Hz, 65536 samples\n"
+	"profile stop                     - stop sampling\n"
+	"profile report [<n>]             - list the <n> functions sampled most"
+);
@@ -7,6 +7,7 @@
 
 #include <errno.h>
 #include <common.h>
+#include <android_ab.h>
 #include <command.h>
 #include <console.h>
 #include <dm/device.h>
@@ -90,10 +91,17 @@ static int rkusb_erase_sector(struct ums *ums_dev,
 
 static void rkusb_fini(void)
 {
+	struct blk_desc *desc;
 	int i;
 
-	for (i = 0; i < g_rkusb->ums_cnt; i++)
+	for (i = 0; i < g_rkusb->ums_cnt; i++) {
+		/* The host may have rewritten the partition table */
+		desc = blk_get_devnum_by_type(g_rkusb->ums[i].block_dev.if_type,
+					      g_rkusb->ums[i].block_dev.devnum);
+		if (desc)
+			part_init(desc);
 		free((void *)g_rkusb->ums[i].name);
+	}
 	free(g_rkusb->ums);
 	g_rkusb->ums = NULL;
 	g_rkusb->ums_cnt = 0;
@@ -240,6 +248,9 @@ static int do_rkusb(cmd_tbl_t *cmdtp, int flag, int argc, char *const argv[])
 		devnum = "0:0";
 	}
 
+	/* The host writes misc behind the cache */
+	android_misc_invalidate();
+
 	g_rkusb = &rkusb;
 	rc = rkusb_init(devtype, devnum);
 	if (rc < 0)
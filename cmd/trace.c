@@ -78,6 +78,47 @@ static int create_call_list(int argc, char * const argv[])
 	return 0;
 }
 
+#ifdef CONFIG_TRACE_RING
+static int create_chrome_list(int argc, char * const argv[])
+{
+	size_t buff_size, avail, buff_ptr, used;
+	unsigned int needed;
+	char *buff;
+	int err;
+
+	if (get_args(argc, argv, &buff, &buff_ptr, &buff_size))
+		return -1;
+
+	avail = buff_size - buff_ptr;
+	err = trace_list_chrome(buff + buff_ptr, avail, &needed);
+	if (err)
+		printf("Error: truncated (%#x bytes needed)\n", needed);
+	used = min(avail, (size_t)needed);
+	printf("Chrome trace dumped to %08lx, size %#zx\n",
+	       (ulong)map_to_sysmem(buff + buff_ptr), used);
+
+	env_set_hex("profbase", map_to_sysmem(buff));
+	env_set_hex("profsize", buff_size);
+	env_set_hex("profoffset", buff_ptr + used);
+
+	return 0;
+}
+
+static int set_filter(int argc, char * const argv[])
+{
+	ulong start = 0, end = 0;
+
+	if (argc == 4) {
+		start = simple_strtoul(argv[2], NULL, 16);
+		end = simple_strtoul(argv[3], NULL, 16);
+	} else if (argc != 2) {
+		return -1;
+	}
+
+	return trace_set_filter(start, end);
+}
+#endif
+
 int do_trace(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 {
 	const char *cmd = argc < 2 ? NULL : argv[1];
@@ -89,6 +130,13 @@ int do_trace(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		trace_set_enabled(0);
 		break;
 	case 'c':
+#ifdef CONFIG_TRACE_RING
+		if (!strcmp(cmd, "chrome")) {
+			if (create_chrome_list(argc, argv))
+				return cmd_usage(cmdtp);
+			break;
+		}
+#endif
 		if (create_call_list(argc, argv))
 			return cmd_usage(cmdtp);
 		break;
@@ -96,6 +144,13 @@ int do_trace(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[])
 		trace_set_enabled(1);
 		break;
 	case 'f':
+#ifdef CONFIG_TRACE_RING
+		if (!strcmp(cmd, "filter")) {
+			if (set_filter(argc, argv))
+				return cmd_usage(cmdtp);
+			break;
+		}
+#endif
 		if (create_func_list(argc, argv))
 			return cmd_usage(cmdtp);
 		break;
@@ -118,4 +173,10 @@ U_BOOT_CMD(
 	"trace funclist [<addr> <size>]     - dump function list into buffer\n"
 	"trace calls  [<addr> <size>]       "
 		"- dump function call trace into buffer"
+#ifdef CONFIG_TRACE_RING
+	"\ntrace chrome [<addr> <size>]       "
+		"- dump call trace as Chrome/Perfetto JSON\n"
+	"trace filter [<start> <end>]       "
+		"- only trace functions in [start, end), link addresses"
+#endif
 );
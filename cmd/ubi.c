@@ -330,7 +330,8 @@ int ubi_volume_write(char *volume, void *buf, size_t size)
 int ubi_volume_read(char *volume, char *buf, size_t size)
 {
 	int err, lnum, off, len, tbuf_size;
-	void *tbuf;
+	void *tbuf = NULL;
+	bool direct;
 	unsigned long long tmp;
 	struct ubi_volume *vol;
 	loff_t offp = 0;
@@ -363,11 +364,6 @@ int ubi_volume_read(char *volume, char *buf, size_t size)
 	tbuf_size = vol->usable_leb_size;
 	if (size < tbuf_size)
 		tbuf_size = ALIGN(size, ubi->min_io_size);
-	tbuf = malloc_cache_aligned(tbuf_size);
-	if (!tbuf) {
-		printf("NO MEM\n");
-		return ENOMEM;
-	}
 	len = size > tbuf_size ? tbuf_size : size;
 
 	tmp = offp;
@@ -377,7 +373,22 @@ int ubi_volume_read(char *volume, char *buf, size_t size)
 		if (off + len >= vol->usable_leb_size)
 			len = vol->usable_leb_size - off;
 
-		err = ubi_eba_read_leb(ubi, vol, lnum, tbuf, off, len, 0);
+		/*
+		 * Cache aligned pieces, i.e. all but the tail of a read to a
+		 * load address, go straight to the destination
+		 */
+		direct = IS_ALIGNED((ulong)buf, ARCH_DMA_MINALIGN) &&
+			 IS_ALIGNED(len, ARCH_DMA_MINALIGN);
+		if (!direct && !tbuf) {
+			tbuf = malloc_cache_aligned(tbuf_size);
+			if (!tbuf) {
+				printf("NO MEM\n");
+				return ENOMEM;
+			}
+		}
+
+		err = ubi_eba_read_leb(ubi, vol, lnum, direct ? buf : tbuf,
+				       off, len, 0);
 		if (err) {
 			printf("read err %x\n", err);
 			err = -err;
@@ -392,7 +403,8 @@ int ubi_volume_read(char *volume, char *buf, size_t size)
 		size -= len;
 		offp += len;
 
-		memcpy(buf, tbuf, len);
+		if (!direct)
+			memcpy(buf, tbuf, len);
 
 		buf += len;
 		len = size > tbuf_size ? tbuf_size : size;
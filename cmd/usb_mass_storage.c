@@ -9,6 +9,7 @@
 
 #include <errno.h>
 #include <common.h>
+#include <android_ab.h>
 #include <command.h>
 #include <console.h>
 #include <g_dnl.h>
@@ -39,10 +40,17 @@ static int ums_count;
 
 static void ums_fini(void)
 {
+	struct blk_desc *desc;
 	int i;
 
-	for (i = 0; i < ums_count; i++)
+	for (i = 0; i < ums_count; i++) {
+		/* The host may have rewritten the partition table */
+		desc = blk_get_devnum_by_type(ums[i].block_dev.if_type,
+					      ums[i].block_dev.devnum);
+		if (desc)
+			part_init(desc);
 		free((void *)ums[i].name);
+	}
 	free(ums);
 	ums = NULL;
 	ums_count = 0;
@@ -155,6 +163,9 @@ static int do_usb_mass_storage(cmd_tbl_t *cmdtp, int flag,
 		devnum  = argv[2];
 	}
 
+	/* The host writes misc behind the cache */
+	android_misc_invalidate();
+
 	rc = ums_init(devtype, devnum);
 	if (rc < 0)
 		return CMD_RET_FAILURE;
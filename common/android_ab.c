@@ -9,6 +9,7 @@
 #include <android_bootloader_message.h>
 #include <android_image.h>
 #include <boot_rkimg.h>
+#include <cmdline.h>
 #include <common.h>
 #include <malloc.h>
 #include <android_avb/avb_ops_user.h>
@@ -53,6 +54,147 @@ void android_boot_control_default(struct android_bootloader_control *abc)
 	abc->crc32_le = android_boot_control_compute_crc(abc);
 }
 
+/*
+ * The head of misc, from the BCB to the virtual A/B message, is read with one
+ * access at first use and kept for the rest of the boot, so that the boot mode
+ * check, the slot selection and the tries update don't each go to the device.
+ * Writes go through to the device at once: a reset, watchdog or hang before
+ * the OS is booted must not lose the tries update or the BCB.
+ */
+static struct {
+	struct blk_desc *dev_desc;
+	lbaint_t start;
+	lbaint_t blks;
+	lbaint_t dirty_start;
+	lbaint_t dirty_end;
+	void *buf;
+} misc_view;
+
+static int android_misc_view_load(struct blk_desc *dev_desc,
+				  const disk_partition_t *part_info)
+{
+	lbaint_t blks;
+	void *buf;
+
+	if (misc_view.buf && misc_view.dev_desc == dev_desc &&
+	    misc_view.start == part_info->start)
+		return 0;
+
+	android_misc_invalidate();
+
+	blks = (ANDROID_VIRTUAL_AB_METADATA_OFFSET_IN_MISC >> 9) +
+	       DIV_ROUND_UP(sizeof(struct misc_virtual_ab_message),
+			    part_info->blksz);
+	blks = min_t(lbaint_t, blks, part_info->size);
+	buf = memalign(ARCH_DMA_MINALIGN, blks * part_info->blksz);
+	if (!buf)
+		return -ENOMEM;
+
+	if (blk_dread(dev_desc, part_info->start, blks, buf) != blks) {
+		printf("ANDROID: Could not read from misc partition\n");
+		free(buf);
+		return -EIO;
+	}
+
+	misc_view.dev_desc = dev_desc;
+	misc_view.start = part_info->start;
+	misc_view.blks = blks;
+	misc_view.dirty_start = 0;
+	misc_view.dirty_end = 0;
+	misc_view.buf = buf;
+	debug("ANDROID: Loaded misc, " LBAFU " blocks.\n", blks);
+
+	return 0;
+}
+
+static int android_misc_view_rw(struct blk_desc *dev_desc,
+				const disk_partition_t *part_info,
+				ulong offset, size_t size, void *buf,
+				bool write)
+{
+	ulong blksz = part_info->blksz;
+	lbaint_t start, end;
+	int ret;
+
+	ret = android_misc_view_load(dev_desc, part_info);
+	if (ret)
+		return ret;
+
+	if (offset + size > misc_view.blks * blksz) {
+		printf("ANDROID: misc 0x%lx+0x%zx is out of the cached 0x%lx\n",
+		       offset, size, (ulong)(misc_view.blks * blksz));
+		return -ERANGE;
+	}
+
+	if (!write) {
+		memcpy(buf, misc_view.buf + offset, size);
+		return 0;
+	}
+
+	memcpy(misc_view.buf + offset, buf, size);
+	start = offset / blksz;
+	end = DIV_ROUND_UP(offset + size, blksz);
+	if (misc_view.dirty_start == misc_view.dirty_end) {
+		misc_view.dirty_start = start;
+		misc_view.dirty_end = end;
+	} else {
+		misc_view.dirty_start = min(misc_view.dirty_start, start);
+		misc_view.dirty_end = max(misc_view.dirty_end, end);
+	}
+
+	return android_misc_flush();
+}
+
+int android_misc_read(struct blk_desc *dev_desc,
+		      const disk_partition_t *part_info,
+		      ulong offset, size_t size, void *buf)
+{
+	return android_misc_view_rw(dev_desc, part_info, offset, size,
+				    buf, false);
+}
+
+int android_misc_write(struct blk_desc *dev_desc,
+		       const disk_partition_t *part_info,
+		       ulong offset, size_t size, const void *buf)
+{
+	return android_misc_view_rw(dev_desc, part_info, offset, size,
+				    (void *)buf, true);
+}
+
+int android_misc_flush(void)
+{
+	lbaint_t blks = misc_view.dirty_end - misc_view.dirty_start;
+	ulong blksz;
+
+	if (!misc_view.buf || !blks)
+		return 0;
+
+	blksz = misc_view.dev_desc->blksz;
+	if (blk_dwrite(misc_view.dev_desc,
+		       misc_view.start + misc_view.dirty_start, blks,
+		       misc_view.buf + misc_view.dirty_start * blksz) != blks ||
+	    blk_flush(misc_view.dev_desc)) {
+		printf("ANDROID: Could not write back the misc partition\n");
+		return -EIO;
+	}
+	debug("ANDROID: Wrote misc, " LBAFU " blocks at " LBAFU ".\n",
+	      blks, misc_view.dirty_start);
+	misc_view.dirty_start = 0;
+	misc_view.dirty_end = 0;
+
+	return 0;
+}
+
+void android_misc_invalidate(void)
+{
+	if (!misc_view.buf)
+		return;
+
+	android_misc_flush();
+	free(misc_view.buf);
+	misc_view.buf = NULL;
+}
+
 /** android_boot_control_create_from_disk
  * Load the boot_control struct from disk into newly allocated memory. This
  * function allocates and returns an integer number of disk blocks, based on the
@@ -90,8 +232,9 @@ static void *android_boot_control_create_from_disk(
 	if (!buf)
 		return NULL;
 
-	if (blk_dread(dev_desc, part_info->start + abc_offset, abc_blocks,
-		      buf) != abc_blocks) {
+	if (android_misc_read(dev_desc, part_info,
+			      abc_offset * part_info->blksz,
+			      abc_blocks * part_info->blksz, buf)) {
 		printf("ANDROID: Could not read from boot control partition\n");
 		free(buf);
 		return NULL;
@@ -120,8 +263,9 @@ static int android_boot_control_store(void *abc_data_block,
 			      slot_suffix) / part_info->blksz;
 	abc_blocks = DIV_ROUND_UP(sizeof(struct android_bootloader_control),
 				  part_info->blksz);
-	if (blk_dwrite(dev_desc, part_info->start + abc_offset, abc_blocks,
-		       abc_data_block) != abc_blocks) {
+	if (android_misc_write(dev_desc, part_info,
+			       abc_offset * part_info->blksz,
+			       abc_blocks * part_info->blksz, abc_data_block)) {
 		printf("ANDROID: Could not write back the misc partition\n");
 		return -1;
 	}
@@ -275,7 +419,7 @@ int read_misc_virtual_ab_message(struct misc_virtual_ab_message *message)
 	struct blk_desc *dev_desc;
 	disk_partition_t part_info;
 	u32 bcb_offset = (ANDROID_VIRTUAL_AB_METADATA_OFFSET_IN_MISC >> 9);
-	int cnt, ret;
+	int ret;
 
 	if (!message) {
 		debug("%s: message is NULL!\n", __func__);
@@ -295,8 +439,8 @@ int read_misc_virtual_ab_message(struct misc_virtual_ab_message *message)
 		return -1;
 	}
 
-	cnt = DIV_ROUND_UP(sizeof(struct misc_virtual_ab_message), dev_desc->blksz);
-	if (blk_dread(dev_desc, part_info.start + bcb_offset, cnt, message) != cnt) {
+	if (android_misc_read(dev_desc, &part_info, bcb_offset * dev_desc->blksz,
+			      sizeof(*message), message)) {
 		debug("%s: could not read from misc partition\n", __func__);
 		return -1;
 	}
@@ -309,7 +453,7 @@ int write_misc_virtual_ab_message(struct misc_virtual_ab_message *message)
 	struct blk_desc *dev_desc;
 	disk_partition_t part_info;
 	u32 bcb_offset = (ANDROID_VIRTUAL_AB_METADATA_OFFSET_IN_MISC >> 9);
-	int cnt, ret;
+	int ret;
 
 	if (!message) {
 		debug("%s: message is NULL!\n", __func__);
@@ -329,10 +473,11 @@ int write_misc_virtual_ab_message(struct misc_virtual_ab_message *message)
 		return -1;
 	}
 
-	cnt = DIV_ROUND_UP(sizeof(struct misc_virtual_ab_message), dev_desc->blksz);
-	ret = blk_dwrite(dev_desc, part_info.start + bcb_offset, cnt, message);
-	if (ret != cnt)
-		debug("%s: blk_dwrite write failed, ret=%d\n", __func__, ret);
+	ret = android_misc_write(dev_desc, &part_info,
+				 bcb_offset * dev_desc->blksz,
+				 sizeof(*message), message);
+	if (ret)
+		debug("%s: misc write failed, ret=%d\n", __func__, ret);
 
 	return 0;
 }
@@ -406,7 +551,7 @@ static int get_partition_unique_uuid(char *partition,
 	return 0;
 }
 
-static void ab_update_root_uuid(void)
+static void ab_update_root_uuid(struct cmdline *cl)
 {
 	/*
 	 * In android a/b & avb process, the system.img is mandory and the
@@ -420,7 +565,6 @@ static void ab_update_root_uuid(void)
 	 * "root=" and create it for linux ab & avb.
 	 */
 	char root_partuuid[70] = "root=PARTUUID=";
-	char *boot_args = env_get("bootargs");
 	char guid_buf[UUID_SIZE] = {0};
 	struct blk_desc *dev_desc;
 
@@ -433,17 +577,16 @@ static void ab_update_root_uuid(void)
 	if (ab_is_support_dynamic_partition(dev_desc))
 		return;
 
-	if (!strstr(boot_args, "root=")) {
+	if (!cmdline_find(cl, "root=")) {
 		get_partition_unique_uuid(ANDROID_PARTITION_SYSTEM,
 					  guid_buf, UUID_SIZE);
 		strcat(root_partuuid, guid_buf);
-		env_update("bootargs", root_partuuid);
+		cmdline_update(cl, root_partuuid, NULL);
 	}
 }
 
-void ab_update_root_partition(void)
+void ab_update_root_partition(struct cmdline *cl)
 {
-	char *boot_args = env_get("bootargs");
 	char root_part_dev[64] = {0};
 	disk_partition_t part_info;
 	struct blk_desc *dev_desc;
@@ -475,20 +618,20 @@ void ab_update_root_partition(void)
 		if (strstr(part_type, "ENV"))
 			snprintf(root_part_dev, 64, "root=/dev/mmcblk0p%d", part_num);
 		else if (strstr(part_type, "EFI"))
-			ab_update_root_uuid();
+			ab_update_root_uuid(cl);
 		break;
 	case IF_TYPE_SPINAND:
 		if (strstr(part_type, "ENV"))
 			/* TODO */
 			printf("%s: TODO: ENV partition for 'IF_TYPE_SPINAND'.\n", __func__);
 		else if (strstr(part_type, "EFI"))
-			ab_update_root_uuid();
+			ab_update_root_uuid(cl);
 		break;
 	case IF_TYPE_MTD:
 		if (dev_desc->devnum == BLK_MTD_NAND || dev_desc->devnum == BLK_MTD_SPI_NAND) {
-			if (strstr(boot_args, "rootfstype=squashfs") || strstr(boot_args, "rootfstype=erofs"))
+			if (cmdline_find(cl, "rootfstype=squashfs") || cmdline_find(cl, "rootfstype=erofs"))
 				snprintf(root_part_dev, 64, "ubi.mtd=%d root=/dev/ubiblock0_0", part_num - 1);
-			else if (strstr(boot_args, "rootfstype=ubifs"))
+			else if (cmdline_find(cl, "rootfstype=ubifs"))
 				snprintf(root_part_dev, 64, "ubi.mtd=%d root=ubi0:system", part_num - 1);
 		} else if (dev_desc->devnum == BLK_MTD_SPI_NOR) {
 			snprintf(root_part_dev, 64, "root=/dev/mtdblock%d", part_num - 1);
@@ -499,7 +642,7 @@ void ab_update_root_partition(void)
 		return;
 	}
 
-	env_update("bootargs", root_part_dev);
+	cmdline_update(cl, root_part_dev, NULL);
 }
 
 int ab_get_slot_suffix(char *slot_suffix)
@@ -14,6 +14,7 @@
 #include <bootm.h>
 #include <asm/arch/hotkey.h>
 #include <cli.h>
+#include <cmdline.h>
 #include <common.h>
 #include <dt_table.h>
 #include <image-android-dt.h>
@@ -44,9 +45,15 @@ int android_bootloader_message_load(
 		return -1;
 	}
 
+#ifdef CONFIG_ANDROID_AB
+	if (android_misc_read(dev_desc, part_info,
+			      android_bcb_msg_sector_offset() * part_info->blksz,
+			      sizeof(*message), message)) {
+#else
 	if (blk_dread(dev_desc, part_info->start + android_bcb_msg_sector_offset(),
 	     message_blocks, message) !=
 	    message_blocks) {
+#endif
 		printf("Could not read from misc partition\n");
 		return -1;
 	}
@@ -67,8 +74,15 @@ static int android_bootloader_message_write(
 		return -1;
 	}
 
+#ifdef CONFIG_ANDROID_AB
+	/* At the BCB offset, where android_bootloader_message_load() reads */
+	if (android_misc_write(dev_desc, part_info,
+			       android_bcb_msg_sector_offset() * part_info->blksz,
+			       sizeof(*message), message)) {
+#else
 	if (blk_dwrite(dev_desc, part_info->start, message_blocks, message) !=
-	    message_blocks) {
+	    message_blocks || blk_flush(dev_desc)) {
+#endif
 		printf("Could not write to misc partition\n");
 		return -1;
 	}
@@ -273,6 +287,8 @@ static int sysmem_alloc_uncomp_kernel(ulong andr_hdr,
 			ksize = hdr->kernel_size * 100 / 50;
 		else if (comp == IH_COMP_LZO)
 			ksize = hdr->kernel_size * 100 / 45;
+		else if (comp == IH_COMP_ZSTD)
+			ksize = hdr->kernel_size * 100 / 35;
 		else if (comp == IH_COMP_GZIP)
 			ksize = hdr->kernel_size * 100 / 40;
 		else if (comp == IH_COMP_BZIP2)
@@ -308,6 +324,7 @@ int android_bootloader_boot_kernel(unsigned long kernel_address)
 		[IH_COMP_LZO]   = "LZO",
 		[IH_COMP_LZ4]   = "LZ4",
 		[IH_COMP_ZIMAGE]= "ZIMAGE",
+		[IH_COMP_ZSTD]  = "ZSTD",
 	};
 	char *bootm_args[] = {
 		kernel_addr_str, kernel_addr_str, fdt_addr, NULL };
@@ -353,36 +370,17 @@ int android_bootloader_boot_kernel(unsigned long kernel_address)
 		BOOTM_STATE_OS_GO, &images, 1);
 }
 
-static char *strjoin(const char **chunks, char separator)
+static char *strconcat(const char *a, const char *b)
 {
-	int len, joined_len = 0;
-	char *ret, *current;
-	const char **p;
+	size_t a_len = strlen(a), b_len = strlen(b);
+	char *ret;
 
-	for (p = chunks; *p; p++)
-		joined_len += strlen(*p) + 1;
-
-	if (!joined_len) {
-		ret = malloc(1);
-		if (ret)
-			ret[0] = '\0';
-		return ret;
-	}
-
-	ret = malloc(joined_len);
-	current = ret;
+	ret = malloc(a_len + b_len + 1);
 	if (!ret)
-		return ret;
+		return NULL;
+	memcpy(ret, a, a_len);
+	memcpy(ret + a_len, b, b_len + 1);
 
-	for (p = chunks; *p; p++) {
-		len = strlen(*p);
-		memcpy(current, *p, len);
-		current += len;
-		*current = separator;
-		current++;
-	}
-	/* Replace the last separator by a \0. */
-	current[-1] = '\0';
 	return ret;
 }
 
@@ -392,66 +390,60 @@ static char *strjoin(const char **chunks, char separator)
 char *android_assemble_cmdline(const char *slot_suffix,
 				      const char *extra_args)
 {
-	const char *cmdline_chunks[16];
-	const char **current_chunk = cmdline_chunks;
-	char *env_cmdline, *cmdline, *rootdev_input, *serialno;
-	char *allocated_suffix = NULL;
-	char *allocated_serialno = NULL;
-	char *allocated_rootdev = NULL;
+	char *rootdev_input, *serialno, *arg;
+	char *cmdline = NULL;
 	unsigned long rootdev_len;
+	struct cmdline cl;
 
-	env_cmdline = env_get("bootargs");
-	if (env_cmdline)
-		*(current_chunk++) = env_cmdline;
+	/* Arguments already in "bootargs" are replaced, not repeated */
+	if (cmdline_init(&cl, env_get("bootargs")))
+		goto out;
 
 	/* The |slot_suffix| needs to be passed to the kernel to know what
 	 * slot to boot from.
 	 */
 #ifdef CONFIG_ANDROID_AB
 	if (slot_suffix) {
-		allocated_suffix = malloc(strlen(ANDROID_ARG_SLOT_SUFFIX) +
-					  strlen(slot_suffix) + 1);
-		memset(allocated_suffix, 0, strlen(ANDROID_ARG_SLOT_SUFFIX)
-		       + strlen(slot_suffix) + 1);
-		strcpy(allocated_suffix, ANDROID_ARG_SLOT_SUFFIX);
-		strcat(allocated_suffix, slot_suffix);
-		*(current_chunk++) = allocated_suffix;
+		arg = strconcat(ANDROID_ARG_SLOT_SUFFIX, slot_suffix);
+		if (arg)
+			cmdline_update(&cl, arg, NULL);
+		free(arg);
 	}
 #endif
 	serialno = env_get("serial#");
 	if (serialno) {
-		allocated_serialno = malloc(strlen(ANDROID_ARG_SERIALNO) +
-					  strlen(serialno) + 1);
-		memset(allocated_serialno, 0, strlen(ANDROID_ARG_SERIALNO) +
-				strlen(serialno) + 1);
-		strcpy(allocated_serialno, ANDROID_ARG_SERIALNO);
-		strcat(allocated_serialno, serialno);
-		*(current_chunk++) = allocated_serialno;
+		arg = strconcat(ANDROID_ARG_SERIALNO, serialno);
+		if (arg)
+			cmdline_update(&cl, arg, NULL);
+		free(arg);
 	}
 
 	rootdev_input = env_get("android_rootdev");
 	if (rootdev_input) {
 		rootdev_len = strlen(ANDROID_ARG_ROOT) + CONFIG_SYS_CBSIZE + 1;
-		allocated_rootdev = malloc(rootdev_len);
-		strcpy(allocated_rootdev, ANDROID_ARG_ROOT);
-		cli_simple_process_macros(rootdev_input,
-					  allocated_rootdev +
-					  strlen(ANDROID_ARG_ROOT));
-		/* Make sure that the string is null-terminated since the
-		 * previous could not copy to the end of the input string if it
-		 * is too big.
-		 */
-		allocated_rootdev[rootdev_len - 1] = '\0';
-		*(current_chunk++) = allocated_rootdev;
+		arg = malloc(rootdev_len);
+		if (arg) {
+			strcpy(arg, ANDROID_ARG_ROOT);
+			cli_simple_process_macros(rootdev_input,
+						  arg + strlen(ANDROID_ARG_ROOT));
+			/* Make sure that the string is null-terminated since
+			 * the previous could not copy to the end of the input
+			 * string if it is too big.
+			 */
+			arg[rootdev_len - 1] = '\0';
+			cmdline_update(&cl, arg, NULL);
+			free(arg);
+		}
 	}
 
 	if (extra_args)
-		*(current_chunk++) = extra_args;
+		cmdline_update(&cl, extra_args, NULL);
 
-	*(current_chunk++) = NULL;
-	cmdline = strjoin(cmdline_chunks, ' ');
-	free(allocated_suffix);
-	free(allocated_rootdev);
+	/* Keep the string, free the rest */
+	cmdline = (char *)cmdline_str(&cl);
+	cl.buf = NULL;
+out:
+	cmdline_uninit(&cl);
 	return cmdline;
 }
 
@@ -498,6 +490,46 @@ bail:
 	return size;
 }
 
+#ifdef CONFIG_ANDROID_AVB_PRELOAD_IMAGE_SIZE
+/*
+ * The length AVB hashes and so reads of a partition is the signed image,
+ * recorded by the footer at its end. Fall back to the partition size if
+ * there is no valid footer.
+ */
+static size_t get_image_size(AvbOps *ops, char *name,
+			     const char *slot_suffix)
+{
+	size_t size = get_partition_size(ops, name, slot_suffix);
+	u8 buf[AVB_FOOTER_SIZE];
+	char *partition_name;
+	AvbFooter footer;
+	size_t num_read;
+	AvbIOResult res;
+
+	if (!size)
+		return 0;
+
+	partition_name = join_str(name, slot_suffix);
+	if (!partition_name)
+		return size;
+
+	res = ops->read_from_partition(ops, partition_name, -AVB_FOOTER_SIZE,
+				       AVB_FOOTER_SIZE, buf, &num_read);
+	if (res == AVB_IO_RESULT_OK && num_read == AVB_FOOTER_SIZE &&
+	    avb_footer_validate_and_byteswap((AvbFooter *)buf, &footer) &&
+	    footer.original_image_size <= size) {
+		debug("avb: %s: %llu of %zu bytes signed\n", partition_name,
+		      (unsigned long long)footer.original_image_size, size);
+		size = ALIGN(footer.original_image_size, 512);
+	}
+	free(partition_name);
+
+	return size;
+}
+#else
+#define get_image_size	get_partition_size
+#endif
+
 static struct AvbOpsData preload_user_data;
 
 static int avb_image_distribute_prepare(AvbSlotVerifyData *slot_data,
@@ -510,13 +542,13 @@ static int avb_image_distribute_prepare(AvbSlotVerifyData *slot_data,
 	size_t boot_size;
 	void *image_buf;
 
-	boot_size = max(get_partition_size(ops, ANDROID_PARTITION_BOOT, slot_suffix),
-		get_partition_size(ops, ANDROID_PARTITION_RECOVERY, slot_suffix));
-	init_boot_size = get_partition_size(ops,
+	boot_size = max(get_image_size(ops, ANDROID_PARTITION_BOOT, slot_suffix),
+		get_image_size(ops, ANDROID_PARTITION_RECOVERY, slot_suffix));
+	init_boot_size = get_image_size(ops,
 				ANDROID_PARTITION_INIT_BOOT, slot_suffix);
-	vendor_boot_size = get_partition_size(ops,
+	vendor_boot_size = get_image_size(ops,
 				ANDROID_PARTITION_VENDOR_BOOT, slot_suffix);
-	resource_size = get_partition_size(ops,
+	resource_size = get_image_size(ops,
 				ANDROID_PARTITION_RESOURCE, slot_suffix);
 	image_buf = sysmem_alloc(MEM_AVB_ANDROID,
 				 boot_size + init_boot_size +
@@ -530,12 +562,16 @@ static int avb_image_distribute_prepare(AvbSlotVerifyData *slot_data,
 	data->slot_suffix = slot_suffix;
 	data->boot.addr = image_buf;
 	data->boot.size = 0;
+	data->boot.max = boot_size;
 	data->vendor_boot.addr = data->boot.addr + boot_size;
 	data->vendor_boot.size = 0;
+	data->vendor_boot.max = vendor_boot_size;
 	data->init_boot.addr = data->vendor_boot.addr + vendor_boot_size;
 	data->init_boot.size = 0;
+	data->init_boot.max = init_boot_size;
 	data->resource.addr = data->init_boot.addr + init_boot_size;
 	data->resource.size = 0;
+	data->resource.max = resource_size;
 
 	return 0;
 }
@@ -850,6 +886,11 @@ static AvbSlotVerifyResult android_slot_verify(char *boot_partname,
 			printf("avb image distribute prepare failed %d\n", ret);
 			return AVB_SLOT_VERIFY_RESULT_ERROR_OOM;
 		}
+
+		/* Sections not planned are just copied by the finish */
+		if (!(flags & AVB_SLOT_VERIFY_FLAGS_ALLOW_VERIFICATION_ERROR))
+			android_image_place_prepare(hdr, boot_partname,
+						    slot_suffix, load_address);
 	}
 
 retry_verify:
@@ -966,6 +1007,8 @@ out:
 #endif
 
 #if defined(CONFIG_CMD_DTIMG) && defined(CONFIG_OF_LIBFDT_OVERLAY)
+/* dtbo.img entries applied at most */
+#define ANDROID_DTBO_MAX	16
 
 /*
  * Default return index 0.
@@ -990,9 +1033,23 @@ __weak int board_select_fdt_index(ulong dt_table_hdr)
 	return 0;
 }
 
-static int android_get_dtbo(ulong *fdt_dtbo,
+/*
+ * Default: the one entry of board_select_fdt_index().
+ *
+ * Boards with overlays per feature can return several entries, they are
+ * applied in the order of @indexes. Return the number of entries, at most
+ * @max, or -ve on error.
+ */
+__weak int board_select_fdt_indexes(ulong dt_table_hdr, int *indexes, int max)
+{
+	indexes[0] = board_select_fdt_index(dt_table_hdr);
+
+	return indexes[0] < 0 ? indexes[0] : 1;
+}
+
+static int android_get_dtbo(ulong *fdt_dtbos, int *indexes, int max,
 			    const struct andr_img_hdr *hdr,
-			    int *index, const char *part_dtbo)
+			    const char *part_dtbo)
 {
 	struct dt_table_header *dt_hdr = NULL;
 	struct blk_desc *dev_desc;
@@ -1001,7 +1058,7 @@ static int android_get_dtbo(ulong *fdt_dtbo,
 	void *buf;
 	ulong e_addr;
 	u32 e_size;
-	int e_idx;
+	int i, count;
 	int ret;
 
 	/* Get partition info */
@@ -1053,30 +1110,30 @@ static int android_get_dtbo(ulong *fdt_dtbo,
 	if (ret != blk_cnt)
 		goto out2;
 
-	e_idx = board_select_fdt_index((ulong)buf);
-	if (e_idx < 0) {
+	count = board_select_fdt_indexes((ulong)buf, indexes, max);
+	if (count <= 0 || count > max) {
 		printf("%s: failed to select board fdt index\n", __func__);
 		ret = -EINVAL;
 		goto out2;
 	}
 
-	ret = android_dt_get_fdt_by_index((ulong)buf, e_idx, &e_addr, &e_size);
-	if (!ret) {
-		printf("%s: failed to get fdt, index=%d\n", __func__, e_idx);
-		ret = -EINVAL;
-		goto out2;
+	for (i = 0; i < count; i++) {
+		if (indexes[i] < 0 ||
+		    !android_dt_get_fdt_by_index((ulong)buf, indexes[i],
+						 &e_addr, &e_size)) {
+			printf("%s: failed to get fdt, index=%d\n",
+			       __func__, indexes[i]);
+			ret = -EINVAL;
+			goto out2;
+		}
+		fdt_dtbos[i] = e_addr;
+		debug("ANDROID: Loading dt entry to 0x%lx size 0x%x idx %d from \"%s\" part\n",
+		      e_addr, e_size, indexes[i], part_dtbo);
 	}
 
-	if (fdt_dtbo)
-		*fdt_dtbo = e_addr;
-	if (index)
-		*index = e_idx;
-
 	free(dt_hdr);
-	debug("ANDROID: Loading dt entry to 0x%lx size 0x%x idx %d from \"%s\" part\n",
-	      e_addr, e_size, e_idx, part_dtbo);
 
-	return 0;
+	return count;
 
 out2:
 	free(buf);
@@ -1094,10 +1151,12 @@ int android_fdt_overlay_apply(void *fdt_addr)
 	disk_partition_t part_info;
 	char *fdt_backup;
 	char *part_dtbo = PART_DTBO;
-	char buf[32] = {0};
-	ulong fdt_dtbo = -1;
-	u32 totalsize;
-	int index = -1;
+	char buf[32 + ANDROID_DTBO_MAX * 4] = {0};
+	void *fdt_dtbos[ANDROID_DTBO_MAX];
+	ulong dtbo_addrs[ANDROID_DTBO_MAX];
+	int indexes[ANDROID_DTBO_MAX];
+	u32 totalsize, dtbo_size = 0;
+	int i, len, count;
 	int ret;
 
 	if (rockchip_get_boot_mode() == BOOT_MODE_RECOVERY) {
@@ -1144,13 +1203,17 @@ int android_fdt_overlay_apply(void *fdt_addr)
 	    (hdr->header_version >= 3 && !strcmp(part_boot, PART_RECOVERY)))
 		goto out;
 
-	ret = android_get_dtbo(&fdt_dtbo, (void *)hdr, &index, part_dtbo);
-	if (!ret) {
+	count = android_get_dtbo(dtbo_addrs, indexes, ANDROID_DTBO_MAX,
+				 (void *)hdr, part_dtbo);
+	if (count > 0) {
 		phys_size_t fdt_size;
 
-		/* Must incease size before overlay */
-		fdt_size = fdt_totalsize((void *)fdt_addr) +
-				fdt_totalsize((void *)fdt_dtbo);
+		/* Must incease size before overlay, once for all of them */
+		for (i = 0; i < count; i++) {
+			fdt_dtbos[i] = (void *)dtbo_addrs[i];
+			dtbo_size += fdt_totalsize(fdt_dtbos[i]);
+		}
+		fdt_size = fdt_totalsize((void *)fdt_addr) + dtbo_size;
 		if (sysmem_free((phys_addr_t)fdt_addr))
 			goto out;
 
@@ -1168,10 +1231,14 @@ int android_fdt_overlay_apply(void *fdt_addr)
 			goto out;
 
 		memcpy(fdt_backup, fdt_addr, totalsize);
-		fdt_increase_size(fdt_addr, fdt_totalsize((void *)fdt_dtbo));
-		ret = fdt_overlay_apply(fdt_addr, (void *)fdt_dtbo);
+		fdt_increase_size(fdt_addr, dtbo_size);
+		ret = fdt_overlay_apply_multi(fdt_addr, fdt_dtbos, count);
 		if (!ret) {
-			snprintf(buf, 32, "%s%d", "androidboot.dtbo_idx=", index);
+			len = snprintf(buf, sizeof(buf), "%s%d",
+				       "androidboot.dtbo_idx=", indexes[0]);
+			for (i = 1; i < count; i++)
+				len += snprintf(buf + len, sizeof(buf) - len,
+						",%d", indexes[i]);
 			env_update("bootargs", buf);
 			printf("ANDROID: fdt overlay OK\n");
 		} else {
@@ -1226,6 +1293,8 @@ int android_bootloader_boot_flow(struct blk_desc *dev_desc,
 	const char *mode_cmdline = NULL;
 	char *boot_partname = ANDROID_PARTITION_BOOT;
 
+	bootstage_mark_name(BOOTSTAGE_ID_BOOT_FLOW, "android_boot_flow");
+
 	/*
 	 * 1. Load MISC partition and determine the boot mode
 	 *   clear its value for the next boot if needed.
@@ -1303,6 +1372,7 @@ int android_bootloader_boot_flow(struct blk_desc *dev_desc,
 #ifdef CONFIG_ANDROID_AVB
 	uint8_t vboot_flag = 0;
 	disk_partition_t vbmeta_part_info;
+	int ret;
 
 #ifdef CONFIG_OPTEE_CLIENT
 	if (trusty_read_vbootkey_enable_flag(&vboot_flag)) {
@@ -1312,8 +1382,11 @@ int android_bootloader_boot_flow(struct blk_desc *dev_desc,
 #endif
 	if (vboot_flag) {
 		printf("Vboot=1, SecureBoot enabled, AVB verify\n");
-		if (android_slot_verify(boot_partname, &load_address,
-					slot_suffix)) {
+		bootstage_start(BOOTSTAGE_ID_ACCUM_VERIFY, "verify");
+		ret = android_slot_verify(boot_partname, &load_address,
+					  slot_suffix);
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_VERIFY);
+		if (ret) {
 			printf("AVB verify failed\n");
 
 			return -1;
@@ -1334,8 +1407,11 @@ int android_bootloader_boot_flow(struct blk_desc *dev_desc,
 			}
 		} else {
 			printf("Vboot=0, AVB images, AVB verify\n");
-			if (android_slot_verify(boot_partname, &load_address,
-						slot_suffix)) {
+			bootstage_start(BOOTSTAGE_ID_ACCUM_VERIFY, "verify");
+			ret = android_slot_verify(boot_partname, &load_address,
+						  slot_suffix);
+			bootstage_accum(BOOTSTAGE_ID_ACCUM_VERIFY);
+			if (ret) {
 				printf("AVB verify failed\n");
 
 				return -1;
@@ -1375,7 +1451,9 @@ int android_bootloader_boot_flow(struct blk_desc *dev_desc,
 
 	/* Assemble the command line */
 	command_line = android_assemble_cmdline(slot_suffix, mode_cmdline);
-	env_update("bootargs", command_line);
+	/* Already merged with "bootargs" */
+	if (command_line)
+		env_set("bootargs", command_line);
 
 	debug("ANDROID: bootargs: \"%s\"\n", command_line);
 
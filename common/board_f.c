@@ -289,6 +289,28 @@ __weak ulong board_get_usable_ram_top(ulong total_size)
 	return gd->ram_top;
 }
 
+#if defined(CONFIG_SKIP_RELOCATE_UBOOT) && defined(CONFIG_ARM)
+/*
+ * U-Boot keeps running where it was loaded. When that is in the upper
+ * half of RAM, as SPL puts it on some boards, lay out the reservations
+ * below the image instead of over it, giving up the few pages above.
+ * Otherwise they go from the top of RAM as usual.
+ */
+static ulong skip_reloc_reserve_top(void)
+{
+	ulong base = 0;
+
+#ifdef CONFIG_SYS_SDRAM_BASE
+	base = CONFIG_SYS_SDRAM_BASE;
+#endif
+	if ((ulong)_start < gd->ram_top &&
+	    (ulong)_start - base >= (gd->ram_top - base) / 2)
+		return (ulong)_start & ~(4096 - 1);
+
+	return gd->ram_top;
+}
+#endif
+
 static int setup_dest_addr(void)
 {
 	debug("Monitor len: %08lX\n", gd->mon_len);
@@ -315,6 +337,9 @@ static int setup_dest_addr(void)
 	gd->ram_top += get_effective_memsize();
 	gd->ram_top = board_get_usable_ram_top(gd->mon_len);
 	gd->relocaddr = gd->ram_top;
+#if defined(CONFIG_SKIP_RELOCATE_UBOOT) && defined(CONFIG_ARM)
+	gd->relocaddr = skip_reloc_reserve_top();
+#endif
 	debug("Ram top: %08lX\n", (ulong)gd->ram_top);
 #if defined(CONFIG_MP) && (defined(CONFIG_MPC86xx) || defined(CONFIG_E500))
 	/*
@@ -423,6 +448,12 @@ static int reserve_trace(void)
 
 static int reserve_uboot(void)
 {
+#if defined(CONFIG_SKIP_RELOCATE_UBOOT) && defined(CONFIG_ARM)
+	/* Nothing to make room for, the image stays where it runs */
+	gd->start_addr_sp = gd->relocaddr;
+	gd->relocaddr = (ulong)_start;
+	debug("Not relocating, U-Boot stays at: %08lx\n", gd->relocaddr);
+#else
 	/*
 	 * reserve memory for U-Boot code, data & bss
 	 * round down to next 4 kB limit
@@ -438,6 +469,7 @@ static int reserve_uboot(void)
 	      gd->relocaddr);
 
 	gd->start_addr_sp = gd->relocaddr;
+#endif
 
 	return 0;
 }
@@ -695,6 +727,15 @@ static int setup_reloc(void)
 
 #else
 	gd->reloc_off = 0;
+#ifdef CONFIG_ARM
+	/* Reserved from the top of RAM down to a low loaded image? */
+	if (skip_reloc_reserve_top() > (ulong)_start &&
+	    gd->start_addr_sp < (ulong)_start + gd->mon_len) {
+		printf("Reservations at %08lx overlap U-Boot at %08lx\n",
+		       gd->start_addr_sp, (ulong)_start);
+		return -ENOMEM;
+	}
+#endif
 #endif
 	memcpy(gd->new_gd, (char *)gd, sizeof(gd_t));
 
@@ -7,6 +7,8 @@
 
 #ifndef USE_HOSTCC
 #include <common.h>
+#include <android_ab.h>
+#include <blk.h>
 #include <bootstage.h>
 #include <bzlib.h>
 #include <errno.h>
@@ -19,6 +21,7 @@
 #include <lzma/LzmaTypes.h>
 #include <lzma/LzmaDec.h>
 #include <lzma/LzmaTools.h>
+#include <u-boot/zstd.h>
 #if defined(CONFIG_CMD_USB)
 #include <usb.h>
 #endif
@@ -327,6 +330,7 @@ static void print_decomp_msg(int comp_type, int type, bool is_xip,
 		[IH_COMP_LZO]   = "LZO",
 		[IH_COMP_LZ4]   = "LZ4",
 		[IH_COMP_ZIMAGE]= "ZIMAGE",
+		[IH_COMP_ZSTD]  = "ZSTD",
 	};
 
 	if (comp_type == IH_COMP_NONE)
@@ -386,6 +390,10 @@ int bootm_parse_comp(const unsigned char *hdr)
 	if (lz4_is_valid_header(hdr))
 		return IH_COMP_LZ4;
 #endif
+#if defined(CONFIG_ZSTD)
+	if (zstd_is_valid_header(hdr))
+		return IH_COMP_ZSTD;
+#endif
 #if defined(CONFIG_LZO)
 	if (lzop_is_valid_header(hdr))
 		return IH_COMP_LZO;
@@ -402,6 +410,10 @@ int bootm_parse_comp(const unsigned char *hdr)
 	if (lzma_is_valid(hdr))
 		return IH_COMP_LZMA;
 #endif
+#if defined(CONFIG_LZMA_XZ)
+	if (xz_is_valid(hdr))
+		return IH_COMP_LZMA;
+#endif
 
 	return IH_COMP_NONE;
 }
@@ -456,6 +468,14 @@ int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
 	case IH_COMP_LZMA: {
 		SizeT lzma_len = unc_len;
 
+#ifdef CONFIG_LZMA_XZ
+		if (xz_is_valid(image_buf)) {
+			ret = xz_decompress(image_buf, image_len, load_buf,
+					    &lzma_len);
+			image_len = lzma_len;
+			break;
+		}
+#endif
 		ret = lzmaBuffToBuffDecompress(load_buf, &lzma_len,
 					       image_buf, image_len);
 		image_len = lzma_len;
@@ -480,6 +500,15 @@ int bootm_decomp_image(int comp, ulong load, ulong image_start, int type,
 		break;
 	}
 #endif /* CONFIG_LZ4 */
+#ifdef CONFIG_ZSTD
+	case IH_COMP_ZSTD: {
+		size_t size = unc_len;
+
+		ret = zstd_decompress(image_buf, image_len, load_buf, &size);
+		image_len = size;
+		break;
+	}
+#endif /* CONFIG_ZSTD */
 	default:
 		printf("Unimplemented compression type %d\n", comp);
 		return BOOTM_ERR_UNIMPLEMENTED;
@@ -513,9 +542,11 @@ static int bootm_load_os(bootm_headers_t *images, unsigned long *load_end,
 
 	load_buf = map_sysmem(load, 0);
 	image_buf = map_sysmem(os.image_start, image_len);
+	bootstage_start(BOOTSTAGE_ID_ACCUM_DECOMP, "decompress");
 	err = bootm_decomp_image(os.comp, load, os.image_start, os.type,
 				 load_buf, image_buf, image_len,
 				 CONFIG_SYS_BOOTM_LEN, load_end);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_DECOMP);
 	if (err) {
 		bootstage_error(BOOTSTAGE_ID_DECOMP_IMAGE);
 		return err;
@@ -802,9 +833,12 @@ int do_bootm_states(cmd_tbl_t *cmdtp, int flag, int argc, char * const argv[],
 	}
 
 	/* Now run the OS! We hope this doesn't return */
-	if (!ret && (states & BOOTM_STATE_OS_GO))
+	if (!ret && (states & BOOTM_STATE_OS_GO)) {
+		android_misc_flush();
+		blkcache_flush_all();
 		ret = boot_selected_os(argc, argv, BOOTM_STATE_OS_GO,
 				images, boot_fn);
+	}
 
 	/* Deal with any fallout */
 err:
@@ -11,6 +11,8 @@
  */
 
 #include <common.h>
+#include <blk.h>
+#include <fdt_support.h>
 #include <linux/libfdt.h>
 #include <malloc.h>
 #include <linux/compiler.h>
@@ -250,7 +252,8 @@ static int h_compare_record(const void *r1, const void *r2)
 static int add_bootstages_devicetree(struct fdt_header *blob)
 {
 	struct bootstage_data *data = gd->bootstage;
-	int bootstage;
+	const char *name = "bootstage";
+	int bootstage, parent = 0;
 	char buf[20];
 	int recnum;
 	int i;
@@ -258,11 +261,18 @@ static int add_bootstages_devicetree(struct fdt_header *blob)
 	if (!blob)
 		return 0;
 
+	if (IS_ENABLED(CONFIG_BOOTSTAGE_FDT_CHOSEN)) {
+		parent = fdt_find_or_add_subnode(blob, 0, "chosen");
+		if (parent < 0)
+			return -EINVAL;
+		name = "u-boot,bootstage";
+	}
+
 	/*
 	 * Create the node for bootstage.
 	 * The address of flat device tree is set up by the command bootm.
 	 */
-	bootstage = fdt_add_subnode(blob, 0, "bootstage");
+	bootstage = fdt_add_subnode(blob, parent, name);
 	if (bootstage < 0)
 		return -EINVAL;
 
@@ -335,6 +345,9 @@ void bootstage_report(void)
 		if (rec->start_us)
 			prev = print_time_record(rec, -1);
 	}
+#if CONFIG_IS_ENABLED(BLK_STATS)
+	blk_stats_bootstage(BOOTSTAGE_DIGITS);
+#endif
 }
 
 /**
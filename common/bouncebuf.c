@@ -7,9 +7,53 @@
  */
 
 #include <common.h>
+#include <arena.h>
 #include <malloc.h>
 #include <errno.h>
 #include <bouncebuf.h>
+#include <linux/sizes.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Bounce buffers up to this size come from a slab instead of memalign() */
+#define BOUNCE_SLAB_OBJ_SIZE	SZ_64K
+#define BOUNCE_SLAB_COUNT	4
+
+#if CONFIG_IS_ENABLED(ARENA)
+static struct slab *bounce_slab;
+static bool bounce_slab_tried;
+#endif
+
+static void *bounce_alloc(size_t len)
+{
+#if CONFIG_IS_ENABLED(ARENA)
+	void *buf;
+
+	if (len <= BOUNCE_SLAB_OBJ_SIZE && (gd->flags & GD_FLG_RELOC)) {
+		if (!bounce_slab_tried) {
+			bounce_slab = slab_create("bounce-buffer",
+						  BOUNCE_SLAB_OBJ_SIZE,
+						  BOUNCE_SLAB_COUNT);
+			bounce_slab_tried = true;
+		}
+		buf = slab_alloc(bounce_slab);
+		if (buf)
+			return buf;
+	}
+#endif
+	return memalign(ARCH_DMA_MINALIGN, len);
+}
+
+static void bounce_free(void *buf)
+{
+#if CONFIG_IS_ENABLED(ARENA)
+	if (slab_owns(bounce_slab, buf)) {
+		slab_free(bounce_slab, buf);
+		return;
+	}
+#endif
+	free(buf);
+}
 
 static int addr_aligned(struct bounce_buffer *state)
 {
@@ -41,8 +85,7 @@ int bounce_buffer_start(struct bounce_buffer *state, void *data,
 	state->flags = flags;
 
 	if (!addr_aligned(state)) {
-		state->bounce_buffer = memalign(ARCH_DMA_MINALIGN,
-						state->len_aligned);
+		state->bounce_buffer = bounce_alloc(state->len_aligned);
 		if (!state->bounce_buffer)
 			return -ENOMEM;
 
@@ -77,7 +120,7 @@ int bounce_buffer_stop(struct bounce_buffer *state)
 	if (state->flags & GEN_BB_WRITE)
 		memcpy(state->user_buffer, state->bounce_buffer, state->len);
 
-	free(state->bounce_buffer);
+	bounce_free(state->bounce_buffer);
 
 	return 0;
 }
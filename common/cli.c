@@ -218,6 +218,8 @@ err:
 #ifndef CONFIG_CONSOLE_DISABLE_CLI
 void cli_loop(void)
 {
+	/* Whoever is at the command line wants to see the console */
+	console_quiet_exit();
 #ifdef CONFIG_HUSH_PARSER
 	parse_file_outer();
 	/* This point is never reached */
@@ -1589,6 +1589,8 @@ static int run_pipe_real(struct pipe *pi)
 #endif
 		return rcode;
 	} else if (pi->num_progs == 1 && pi->progs[0].argv != NULL) {
+		int sp = child->sp;	/* the pipe may run again, keep it */
+
 		for (i=0; is_assignment(child->argv[i]); i++) { /* nothing */ }
 		if (i!=0 && child->argv[i]==NULL) {
 			/* assignments, but no command: set the local environment */
@@ -1627,11 +1629,11 @@ static int run_pipe_real(struct pipe *pi)
 			set_local_var(p, 0);
 #endif
 			if (p != child->argv[i]) {
-				child->sp--;
+				sp--;
 				free(p);
 			}
 		}
-		if (child->sp) {
+		if (sp) {
 			char * str = NULL;
 
 			str = make_string(child->argv + i,
@@ -1764,6 +1766,7 @@ static int run_list_real(struct pipe *pi)
 	char *save_name = NULL;
 	char **list = NULL;
 	char **save_list = NULL;
+	struct pipe *save_pipe = NULL;
 	struct pipe *rpipe;
 	int flag_rep = 0;
 #ifndef __U_BOOT__
@@ -1803,7 +1806,8 @@ static int run_list_real(struct pipe *pi)
 				/* check Ctrl-C */
 				ctrlc();
 				if ((had_ctrlc())) {
-					return 1;
+					rcode = 1;
+					goto out;
 				}
 #endif
 				flag_restore = 0;
@@ -1832,6 +1836,7 @@ static int run_list_real(struct pipe *pi)
 				list = make_list_in(pi->next->progs->argv,
 					pi->progs->argv[0]);
 				save_list = list;
+				save_pipe = pi;
 				save_name = pi->progs->argv[0];
 				pi->progs->argv[0] = NULL;
 				flag_rep = 1;
@@ -1903,7 +1908,8 @@ static int run_list_real(struct pipe *pi)
 #else
 		if (rcode < -1) {
 			last_return_code = -rcode - 2;
-			return -2;	/* exit */
+			rcode = -2;	/* exit */
+			goto out;
 		}
 		last_return_code=(rcode == 0) ? 0 : 1;
 #endif
@@ -1923,6 +1929,17 @@ static int run_list_real(struct pipe *pi)
 		checkjobs(NULL);
 #endif
 	}
+#ifdef __U_BOOT__
+out:
+	/* Put back a "for" left half way, a cached list runs again */
+	if (list) {
+		while (*list)
+			free(*list++);
+		free(save_pipe->progs->argv[0]);
+		free(save_list);
+		save_pipe->progs->argv[0] = save_name;
+	}
+#endif
 	return rcode;
 }
 
@@ -3180,6 +3197,131 @@ static void update_ifs_map(void)
 	mapset(ifs, 2);            /* also flow through if quoted */
 }
 
+#ifdef CONFIG_HUSH_CACHE
+/*
+ * Parsed scripts, for "run" and boot scripts which run the same text time
+ * and again. Only the parse is kept: a command with $variables is still
+ * expanded and parsed afresh each time it runs.
+ */
+#define HUSH_CACHE_SIZE		8
+
+struct hush_cache {
+	char *text;		/* the script, NULL until it is complete */
+	int flag;		/* flags it was parsed with */
+	u32 hash;
+	ulong stamp;		/* last run, the oldest is replaced */
+	int busy;		/* running, it can't be run again nested */
+	int bad;		/* a syntax error or exit, don't keep it */
+	int nr_lists;
+	struct pipe **lists;	/* one per line, as parse_stream_outer() runs */
+};
+
+static struct hush_cache hush_cache[HUSH_CACHE_SIZE];
+static struct hush_cache *hush_cache_fill;
+static ulong hush_cache_stamp;
+
+static u32 hush_cache_hash(const char *s)
+{
+	u32 hash = 2166136261U;		/* FNV-1a */
+
+	while (*s)
+		hash = (hash ^ (uchar)*s++) * 16777619U;
+
+	return hash;
+}
+
+static void hush_cache_free(struct hush_cache *c)
+{
+	int i;
+
+	for (i = 0; i < c->nr_lists; i++)
+		free_pipe_list(c->lists[i], 0);
+	free(c->lists);
+	free(c->text);
+	memset(c, 0, sizeof(*c));
+}
+
+/*
+ * The entry with the parse of @s, or a free one for parse_stream_outer() to
+ * fill while it runs @s for the first time. NULL if it has to run uncached.
+ */
+static struct hush_cache *hush_cache_get(const char *s, int flag)
+{
+	struct hush_cache *victim = NULL;
+	u32 hash = hush_cache_hash(s);
+	int i;
+
+	for (i = 0; i < HUSH_CACHE_SIZE; i++) {
+		struct hush_cache *c = &hush_cache[i];
+
+		if (c->text && c->hash == hash && c->flag == flag &&
+		    !strcmp(c->text, s))
+			return c->busy ? NULL : c;
+		if (c->busy)
+			continue;
+		if (!victim || !c->text ||
+		    (victim->text && c->stamp < victim->stamp))
+			victim = c;
+	}
+
+	if (victim) {
+		hush_cache_free(victim);
+		victim->hash = hash;
+		victim->flag = flag;
+		victim->busy = 1;
+	}
+
+	return victim;
+}
+
+/* Run a line of the entry being filled, and keep it */
+static int hush_cache_add(struct hush_cache *c, struct pipe *list)
+{
+	int code;
+
+	c->lists = xrealloc(c->lists, sizeof(*c->lists) * (c->nr_lists + 1));
+	c->lists[c->nr_lists++] = list;
+	code = run_list_real(list);
+	/* The lines after it were not parsed */
+	if (code == -2)
+		c->bad = 1;
+
+	return code;
+}
+
+static void hush_cache_done(struct hush_cache *c, const char *s)
+{
+	if (c->bad) {
+		hush_cache_free(c);
+		return;
+	}
+	c->text = xstrdup(s);
+	c->stamp = ++hush_cache_stamp;
+	c->busy = 0;
+}
+
+/* Run the parse of a script as parse_stream_outer() runs it */
+static int hush_cache_exec(struct hush_cache *c)
+{
+	int i, code = 1;
+
+	c->stamp = ++hush_cache_stamp;
+	c->busy = 1;
+	for (i = 0; i < c->nr_lists; i++) {
+		code = run_list_real(c->lists[i]);
+		if (code == -2) {	/* exit */
+			code = 0;
+			break;
+		}
+		if (code == -1)
+			flag_repeat = 0;
+	}
+	c->busy = 0;
+
+	return (code != 0) ? 1 : 0;
+}
+#endif /* CONFIG_HUSH_CACHE */
+
 /* most recursion does not come through here, the exeception is
  * from builtin_source() */
 static int parse_stream_outer(struct in_str *inp, int flag)
@@ -3190,6 +3332,12 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 	int rcode;
 #ifdef __U_BOOT__
 	int code = 1;
+#endif
+#ifdef CONFIG_HUSH_CACHE
+	/* Only for this level, not the commands it runs */
+	struct hush_cache *c = hush_cache_fill;
+
+	hush_cache_fill = NULL;
 #endif
 	do {
 		ctx.type = flag;
@@ -3214,6 +3362,11 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 #ifndef __U_BOOT__
 			run_list(ctx.list_head);
 #else
+#ifdef CONFIG_HUSH_CACHE
+			if (c)
+				code = hush_cache_add(c, ctx.list_head);
+			else
+#endif
 			code = run_list(ctx.list_head);
 			if (code == -2) {	/* exit */
 				b_free(&temp);
@@ -3241,6 +3394,10 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 			temp.quote = 0;
 			inp->p = NULL;
 			free_pipe_list(ctx.list_head,0);
+#ifdef CONFIG_HUSH_CACHE
+			if (c)
+				c->bad = 1;
+#endif
 		}
 		b_free(&temp);
 	/* loop on syntax errors, return on EOF */
@@ -3253,6 +3410,7 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 #endif /* __U_BOOT__ */
 }
 
+
 #ifndef __U_BOOT__
 static int parse_string_outer(const char *s, int flag)
 #else
@@ -3263,10 +3421,21 @@ int parse_string_outer(const char *s, int flag)
 #ifdef __U_BOOT__
 	char *p = NULL;
 	int rcode;
+#ifdef CONFIG_HUSH_CACHE
+	struct hush_cache *c = NULL;
+#endif
 	if (!s)
 		return 1;
 	if (!*s)
 		return 0;
+#ifdef CONFIG_HUSH_CACHE
+	if (!(flag & FLAG_REPARSING)) {
+		c = hush_cache_get(s, flag);
+		if (c && c->text)
+			return hush_cache_exec(c);
+		hush_cache_fill = c;
+	}
+#endif
 	if (!(p = strchr(s, '\n')) || *++p) {
 		p = xmalloc(strlen(s) + 2);
 		strcpy(p, s);
@@ -3274,13 +3443,18 @@ int parse_string_outer(const char *s, int flag)
 		setup_string_in_str(&input, p);
 		rcode = parse_stream_outer(&input, flag);
 		free(p);
-		return rcode;
 	} else {
+		setup_string_in_str(&input, s);
+		rcode = parse_stream_outer(&input, flag);
+	}
+#ifdef CONFIG_HUSH_CACHE
+	if (c)
+		hush_cache_done(c, s);
 #endif
+	return rcode;
+#else
 	setup_string_in_str(&input, s);
 	return parse_stream_outer(&input, flag);
-#ifdef __U_BOOT__
-	}
 #endif
 }
 
@@ -410,6 +410,51 @@ int fprintf(int file, const char *fmt, ...)
 
 /** U-Boot INITIAL CONSOLE-COMPATIBLE FUNCTION *****************************/
 
+#if CONFIG_IS_ENABLED(CONSOLE_TX_BUFFER)
+/*
+ * Output waiting for the debug UART. putc() only queues it, and the FIFO is
+ * topped up whenever it has room: from putc(), udelay() and tstc(), so a
+ * long message costs the time to copy it rather than the time to send it.
+ * The buffer is in BSS, it is only used after relocation.
+ */
+#define CONSOLE_TX_IDX(idx)	((idx) % (ulong)CONFIG_CONSOLE_TX_BUFFER_SIZE)
+
+static char console_tx_buf[CONFIG_CONSOLE_TX_BUFFER_SIZE];
+static ulong console_tx_head, console_tx_tail;	/* free-running */
+
+void console_tx_poll(void)
+{
+	while (console_tx_tail != console_tx_head) {
+		if (debug_uart_putc_nowait(
+			console_tx_buf[CONSOLE_TX_IDX(console_tx_tail)]))
+			break;
+		console_tx_tail++;
+	}
+}
+
+static void console_tx_putc(const char c)
+{
+	if (c == '\n')
+		console_tx_putc('\r');
+
+	/* Full: wait for the UART, as printch() would have */
+	while (console_tx_head - console_tx_tail >=
+	       CONFIG_CONSOLE_TX_BUFFER_SIZE)
+		console_tx_poll();
+
+	console_tx_buf[CONSOLE_TX_IDX(console_tx_head++)] = c;
+	console_tx_poll();
+}
+
+static void console_tx_flush(void)
+{
+	while (console_tx_tail != console_tx_head)
+		console_tx_poll();
+}
+#else
+static inline void console_tx_flush(void) {}
+#endif
+
 int getc(void)
 {
 	if (!gd || gd->flags & GD_FLG_DISABLE_CONSOLE)
@@ -441,6 +486,9 @@ int tstc(void)
 	if (!gd || gd->flags & GD_FLG_DISABLE_CONSOLE)
 		return 0;
 
+	/* The command line polls this while it waits for a key */
+	console_tx_poll();
+
 	if (!gd->have_console)
 		return 0;
 #ifdef CONFIG_CONSOLE_RECORD
@@ -463,6 +511,7 @@ void flushc(void)
 	if (!gd || gd->flags & GD_FLG_DISABLE_CONSOLE)
 		return;
 
+	console_tx_flush();
 #ifdef CONFIG_DEBUG_UART_NS16550
 	debug_uart_flushc();
 #endif
@@ -515,6 +564,35 @@ static inline void pre_console_putc(const char c) {}
 static inline void print_pre_console_buffer(int flushpoint) {}
 #endif
 
+/* Write to the console devices, after putc() has recorded the character */
+static void console_putc_out(const char c)
+{
+#ifdef CONFIG_DEBUG_UART
+	/* if we don't have a console yet, use the debug UART */
+	if (!gd || !(gd->flags & GD_FLG_SERIAL_READY)) {
+#if CONFIG_IS_ENABLED(CONSOLE_TX_BUFFER)
+		if (gd && gd->flags & GD_FLG_RELOC) {
+			console_tx_putc(c);
+			return;
+		}
+#endif
+		printch(c);
+		return;
+	}
+#endif
+	if (!gd->have_console)
+		return pre_console_putc(c);
+
+	if (gd->flags & GD_FLG_DEVINIT) {
+		/* Send to the standard output */
+		fputc(stdout, c);
+	} else {
+		/* Send directly to the handler */
+		pre_console_putc(c);
+		serial_putc(c);
+	}
+}
+
 void putc(const char c)
 {
 	if (!gd || gd->flags & GD_FLG_DISABLE_CONSOLE)
@@ -532,26 +610,51 @@ void putc(const char c)
 	if (gd->flags & GD_FLG_SILENT)
 		return;
 #endif
-
-#ifdef CONFIG_DEBUG_UART
-	/* if we don't have a console yet, use the debug UART */
-	if (!gd || !(gd->flags & GD_FLG_SERIAL_READY)) {
-		printch(c);
+#if CONFIG_IS_ENABLED(CONSOLE_QUIET)
+	/* Only in the pstore buffer until the console is verbose */
+	if (!(gd->flags & GD_FLG_CONSOLE_VERBOSE))
 		return;
-	}
 #endif
-	if (!gd->have_console)
-		return pre_console_putc(c);
 
-	if (gd->flags & GD_FLG_DEVINIT) {
-		/* Send to the standard output */
-		fputc(stdout, c);
-	} else {
-		/* Send directly to the handler */
-		pre_console_putc(c);
-		serial_putc(c);
+	console_putc_out(c);
+}
+
+#if CONFIG_IS_ENABLED(CONSOLE_QUIET)
+void console_quiet_exit(void)
+{
+	if (!gd || gd->flags & GD_FLG_CONSOLE_VERBOSE)
+		return;
+
+	gd->flags |= GD_FLG_CONSOLE_VERBOSE;
+	/* What was only recorded so far, errors shown already included */
+	pstore_replay(console_putc_out);
+}
+
+int printk_level(int level, const char *fmt, ...)
+{
+	char printbuffer[CONFIG_SYS_PBSIZE];
+	va_list args;
+	ulong verbose;
+	uint i;
+
+	va_start(args, fmt);
+	i = vscnprintf(printbuffer, sizeof(printbuffer), fmt, args);
+	va_end(args);
+
+	if (!gd || level >= CONFIG_CONSOLE_QUIET_LOGLEVEL) {
+		puts(printbuffer);
+		return i;
 	}
+
+	/* Severe enough to be shown on a quiet console too */
+	verbose = gd->flags & GD_FLG_CONSOLE_VERBOSE;
+	gd->flags |= GD_FLG_CONSOLE_VERBOSE;
+	puts(printbuffer);
+	gd->flags = (gd->flags & ~GD_FLG_CONSOLE_VERBOSE) | verbose;
+
+	return i;
 }
+#endif
 
 #if ((!defined(CONFIG_SPL_BUILD) || !defined(CONFIG_USE_TINY_PRINTF)) && \
 	defined(CONFIG_BOOTSTAGE_PRINTF_TIMESTAMP))
@@ -99,6 +99,7 @@ int run_usb_dnl_gadget(int usbctrl_index, char *usb_dnl_gadget)
 		}
 
 		WATCHDOG_RESET();
+		dfu_write_background();
 		usb_gadget_handle_interrupts(usbctrl_index);
 	}
 exit:
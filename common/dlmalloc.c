@@ -19,6 +19,32 @@ void malloc_stats();
 
 DECLARE_GLOBAL_DATA_PTR;
 
+#if CONFIG_IS_ENABLED(MALLOC_TRACK)
+/*
+ * Build the allocator under internal names, so that the public routines
+ * at the end of this file record each call once, however the allocator
+ * calls itself on the way.
+ */
+#include <malloc_track.h>
+
+#undef mALLOc
+#undef fREe
+#undef rEALLOc
+#undef mEMALIGn
+#undef cALLOc
+#define mALLOc		dl_malloc
+#define fREe		dl_free
+#define rEALLOc		dl_realloc
+#define mEMALIGn	dl_memalign
+#define cALLOc		dl_calloc
+
+static Void_t *mALLOc(size_t);
+static void fREe(Void_t *);
+static Void_t *rEALLOc(Void_t *, size_t);
+static Void_t *mEMALIGn(size_t, size_t);
+static Void_t *cALLOc(size_t, size_t);
+#endif
+
 /*
   Emulation of sbrk for WIN32
   All code within the ifdef WIN32 is untested by me.
@@ -2128,6 +2154,54 @@ void cfree(mem) Void_t *mem;
 }
 #endif
 
+#if CONFIG_IS_ENABLED(MALLOC_TRACK)
+Void_t *malloc(size_t bytes)
+{
+	Void_t *mem = mALLOc(bytes);
+
+	malloc_track_alloc(mem, bytes, __builtin_return_address(0));
+
+	return mem;
+}
+
+void free(Void_t *mem)
+{
+	malloc_track_free(mem);
+	fREe(mem);
+}
+
+Void_t *realloc(Void_t *oldmem, size_t bytes)
+{
+	Void_t *mem = rEALLOc(oldmem, bytes);
+
+	/* On failure the old buffer is left as it was */
+	if (mem) {
+		malloc_track_free(oldmem);
+		malloc_track_alloc(mem, bytes, __builtin_return_address(0));
+	}
+
+	return mem;
+}
+
+Void_t *memalign(size_t alignment, size_t bytes)
+{
+	Void_t *mem = mEMALIGn(alignment, bytes);
+
+	malloc_track_alloc(mem, bytes, __builtin_return_address(0));
+
+	return mem;
+}
+
+Void_t *calloc(size_t n, size_t elem_size)
+{
+	Void_t *mem = cALLOc(n, elem_size);
+
+	malloc_track_alloc(mem, n * elem_size, __builtin_return_address(0));
+
+	return mem;
+}
+#endif
+
 
 
 /*
@@ -25,6 +25,10 @@
 #include <linux/fb.h>
 #include <linux/hdmi.h>
 #include <linux/string.h>
+#include <u-boot/crc.h>
+#ifdef CONFIG_DRM_ROCKCHIP_EDID_CACHE
+#include <asm/arch/vendor.h>
+#endif
 
 #define EDID_EST_TIMINGS 16
 #define EDID_STD_TIMINGS 8
@@ -6815,6 +6819,7 @@ void drm_rk_select_mode(struct hdmi_edid_data *edid_data,
  * @adap: ddc adapter
  * @buf: EDID data buffer to be filled
  * @block: 128 byte EDID block to start fetching from
+ * @offset: byte offset within @block to start fetching from
  * @len: EDID data buffer length to fetch
  *
  * Try to fetch EDID information by calling I2C driver functions.
@@ -6823,9 +6828,9 @@ void drm_rk_select_mode(struct hdmi_edid_data *edid_data,
  */
 static int
 drm_do_probe_ddc_edid(struct ddc_adapter *adap, u8 *buf, unsigned int block,
-		      size_t len)
+		      u8 offset, size_t len)
 {
-	unsigned char start = block * HDMI_EDID_BLOCK_SIZE;
+	unsigned char start = block * HDMI_EDID_BLOCK_SIZE + offset;
 	unsigned char segment = block >> 1;
 	unsigned char xfers = segment ? 3 : 2;
 	int ret, retries = 5;
@@ -6874,7 +6879,7 @@ int drm_do_get_edid(struct ddc_adapter *adap, u8 *edid)
 
 	/* base block fetch */
 	for (i = 0; i < 4; i++) {
-		if (drm_do_probe_ddc_edid(adap, edid, 0, HDMI_EDID_BLOCK_SIZE))
+		if (drm_do_probe_ddc_edid(adap, edid, 0, 0, HDMI_EDID_BLOCK_SIZE))
 			goto err;
 		if (drm_edid_block_valid(edid, 0, true,
 					 &edid_corrupt))
@@ -6894,7 +6899,7 @@ int drm_do_get_edid(struct ddc_adapter *adap, u8 *edid)
 
 	for (j = 1; j <= block_num; j++) {
 		for (i = 0; i < 4; i++) {
-			if (drm_do_probe_ddc_edid(adap, &edid[0x80 * j], j,
+			if (drm_do_probe_ddc_edid(adap, &edid[0x80 * j], j, 0,
 						  HDMI_EDID_BLOCK_SIZE))
 				goto err;
 			if (drm_edid_block_valid(&edid[0x80 * j], j,
@@ -6929,6 +6934,103 @@ err:
 	return -EFAULT;
 }
 
+#ifdef CONFIG_DRM_ROCKCHIP_EDID_CACHE
+#define EDID_CACHE_MAGIC	0x44494445	/* "EDID" */
+#define EDID_CACHE_BLOCKS	4
+
+/* Vendor storage item EDID_CACHE_ID + slot, stored up to the last block */
+struct edid_cache {
+	u32 magic;
+	u32 key;
+	u8 edid[EDID_SIZE * EDID_CACHE_BLOCKS];
+};
+
+#define EDID_CACHE_HDR_SIZE	offsetof(struct edid_cache, edid)
+
+/* The slot cached for @key, or else the one to cache it in */
+static int edid_cache_find(u32 key, struct edid_cache *cache, bool *hit)
+{
+	int i, ret, size, slot = -1;
+
+	*hit = false;
+	for (i = 0; i < EDID_CACHE_NUM; i++) {
+		ret = vendor_storage_read(EDID_CACHE_ID + i, cache,
+					  sizeof(*cache));
+		size = EDID_CACHE_HDR_SIZE + (cache->edid[0x7e] + 1) * EDID_SIZE;
+		if (ret < (int)(EDID_CACHE_HDR_SIZE + EDID_SIZE) ||
+		    cache->magic != EDID_CACHE_MAGIC ||
+		    cache->edid[0x7e] >= EDID_CACHE_BLOCKS || ret != size ||
+		    !drm_edid_block_valid(cache->edid, 0, false, NULL)) {
+			if (slot < 0)
+				slot = i;
+			continue;
+		}
+		if (cache->key == key) {
+			*hit = true;
+			return i;
+		}
+	}
+
+	return slot < 0 ? key % EDID_CACHE_NUM : slot;
+}
+
+/*
+ * The vendor, product, serial and manufacture date, then the extension
+ * count and checksum, which covers all the rest of the base block.
+ */
+static bool edid_cache_match(struct ddc_adapter *adap, const u8 *edid)
+{
+	u8 ident[12];
+
+	if (drm_do_probe_ddc_edid(adap, ident, 0, 0x08, 10) ||
+	    drm_do_probe_ddc_edid(adap, ident + 10, 0, 0x7e, 2))
+		return false;
+
+	return !memcmp(ident, edid + 0x08, 10) &&
+	       !memcmp(ident + 10, edid + 0x7e, 2);
+}
+
+int drm_do_get_edid_cached(struct ddc_adapter *adap, u8 *edid,
+			   const char *key)
+{
+	struct edid_cache *cache;
+	u32 hash = crc32(0, (const u8 *)key, strlen(key));
+	int ret, slot, size;
+	bool hit;
+
+	cache = malloc(sizeof(*cache));
+	if (!cache)
+		return drm_do_get_edid(adap, edid);
+
+	slot = edid_cache_find(hash, cache, &hit);
+	if (hit && edid_cache_match(adap, cache->edid)) {
+		memcpy(edid, cache->edid, (cache->edid[0x7e] + 1) * EDID_SIZE);
+		debug("%s: edid from cache slot %d\n", key, slot);
+		free(cache);
+		return 0;
+	}
+
+	ret = drm_do_get_edid(adap, edid);
+	if (ret || edid[0x7e] >= EDID_CACHE_BLOCKS)
+		goto out;
+
+	size = (edid[0x7e] + 1) * EDID_SIZE;
+	if (hit && !memcmp(cache->edid, edid, size))
+		goto out;
+
+	cache->magic = EDID_CACHE_MAGIC;
+	cache->key = hash;
+	memcpy(cache->edid, edid, size);
+	if (vendor_storage_write(EDID_CACHE_ID + slot, cache,
+				 EDID_CACHE_HDR_SIZE + size) < 0)
+		printf("%s: failed to cache edid\n", key);
+out:
+	free(cache);
+
+	return ret;
+}
+#endif
+
 static ssize_t hdmi_ddc_read(struct ddc_adapter *adap, u16 addr, u8 offset,
 			     void *buffer, size_t size)
 {
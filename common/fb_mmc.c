@@ -6,6 +6,7 @@
 
 #include <config.h>
 #include <common.h>
+#include <android_ab.h>
 #include <blk.h>
 #include <fastboot.h>
 #include <fb_mmc.h>
@@ -14,6 +15,8 @@
 #include <mmc.h>
 #include <div64.h>
 #include <linux/compat.h>
+#include <linux/sizes.h>
+#include <asm/unaligned.h>
 #include <android_image.h>
 #ifdef CONFIG_RKIMG_BOOTLOADER
 #include <boot_rkimg.h>
@@ -90,6 +93,7 @@ static lbaint_t fb_mmc_blk_write(struct blk_desc *block_dev, lbaint_t start,
 		}
 		blk += blks_written;
 		blks += blks_written;
+		fastboot_flash_poll();
 	}
 	return blks;
 }
@@ -109,6 +113,29 @@ static lbaint_t fb_mmc_sparse_reserve(struct sparse_storage *info,
 	return blkcnt;
 }
 
+static lbaint_t fb_mmc_sparse_erase(struct sparse_storage *info,
+		lbaint_t blk, lbaint_t blkcnt)
+{
+	struct fb_mmc_sparse *sparse = info->priv;
+
+	return fb_mmc_blk_write(sparse->dev_desc, blk, blkcnt, NULL);
+}
+
+/* Erase group size, or 0 if erased blocks do not read back as zero */
+static lbaint_t fb_mmc_zero_erase_grp(struct blk_desc *dev_desc)
+{
+	struct mmc *mmc;
+
+	if (dev_desc->if_type != IF_TYPE_MMC)
+		return 0;
+
+	mmc = find_mmc_device(dev_desc->devnum);
+	if (!mmc || IS_SD(mmc) || !mmc->esr.mmc_erase_zero)
+		return 0;
+
+	return mmc->erase_grp_size;
+}
+
 static void write_raw_image(struct blk_desc *dev_desc, disk_partition_t *info,
 		const char *part_name, void *buffer,
 		unsigned int download_bytes, char *response)
@@ -140,6 +167,47 @@ static void write_raw_image(struct blk_desc *dev_desc, disk_partition_t *info,
 	fastboot_okay("", response);
 }
 
+#ifdef CONFIG_FASTBOOT_FLASH_GZIP
+/* Bytes inflated per write, a multiple of any erase group */
+#define FASTBOOT_GZIP_WRITE_SIZE	SZ_4M
+
+static bool is_gzip_image(const u8 *buffer, unsigned int download_bytes)
+{
+	return download_bytes > 18 && buffer[0] == 0x1f && buffer[1] == 0x8b;
+}
+
+/*
+ * Inflate a gzip image straight into the partition. The size comes from
+ * the gzip trailer, so the image must be under 4GiB uncompressed.
+ */
+static void write_gzip_image(struct blk_desc *dev_desc,
+		disk_partition_t *info, const char *part_name, void *buffer,
+		unsigned int download_bytes, char *response)
+{
+	u32 size;
+
+	size = get_unaligned_le32(buffer + download_bytes - 4);
+	if (!size || DIV_ROUND_UP(size, info->blksz) > info->size) {
+		pr_err("too large for partition: '%s'\n", part_name);
+		fastboot_fail("too large for partition", response);
+		return;
+	}
+
+	puts("Flashing Gzip Image\n");
+
+	if (gzwrite(buffer, download_bytes, dev_desc,
+		    FASTBOOT_GZIP_WRITE_SIZE, (u64)info->start * info->blksz,
+		    size)) {
+		pr_err("failed writing to device %d\n", dev_desc->devnum);
+		fastboot_fail("failed writing to device", response);
+		return;
+	}
+
+	printf("........ wrote %u bytes to '%s'\n", size, part_name);
+	fastboot_okay("", response);
+}
+#endif
+
 #ifdef CONFIG_ANDROID_BOOT_IMAGE
 /**
  * Read Android boot image header from boot partition.
@@ -308,6 +376,9 @@ void fb_mmc_flash_write(const char *cmd, void *download_buffer,
 	u64 disksize = 0;
 	char reason[128] = {0};
 #endif
+
+	/* The partition table or misc may change under the cached misc */
+	android_misc_invalidate();
 #ifdef CONFIG_RKIMG_BOOTLOADER
 	dev_desc = rockchip_get_bootdev();
 	if (!dev_desc) {
@@ -405,6 +476,8 @@ download:
 		sparse.size = info.size;
 		sparse.write = fb_mmc_sparse_write;
 		sparse.reserve = fb_mmc_sparse_reserve;
+		sparse.erase_grp = fb_mmc_zero_erase_grp(dev_desc);
+		sparse.erase = fb_mmc_sparse_erase;
 
 		printf("Flashing sparse image at offset " LBAFU "\n",
 		       sparse.start);
@@ -412,6 +485,11 @@ download:
 		sparse.priv = &sparse_priv;
 		write_sparse_image(&sparse, cmd, download_buffer,
 				   download_bytes, response);
+#ifdef CONFIG_FASTBOOT_FLASH_GZIP
+	} else if (is_gzip_image(download_buffer, download_bytes)) {
+		write_gzip_image(dev_desc, &info, cmd, download_buffer,
+				 download_bytes, response);
+#endif
 	} else {
 		write_raw_image(dev_desc, &info, cmd, download_buffer,
 				download_bytes, response);
@@ -426,6 +504,7 @@ void fb_mmc_erase(const char *cmd, char *response)
 	lbaint_t blks, blks_start, blks_size, grp_size;
 	struct mmc *mmc = find_mmc_device(CONFIG_FASTBOOT_FLASH_MMC_DEV);
 
+	android_misc_invalidate();
 	if (mmc == NULL) {
 		pr_err("invalid mmc device");
 		fastboot_fail("invalid mmc device", response);
@@ -336,6 +336,7 @@ __weak char *board_fdt_chosen_bootargs(void *fdt)
 
 int fdt_chosen(void *fdt)
 {
+	struct fdt_batch batch;
 	struct abuf buf = {};
 	int   nodeoffset;
 	int   err;
@@ -352,28 +353,39 @@ int fdt_chosen(void *fdt)
 	if (nodeoffset < 0)
 		return nodeoffset;
 
+	/* Both before /chosen moves, as the bootargs can be long */
+	fdt_batch_begin(&batch, fdt);
 	if (IS_ENABLED(CONFIG_BOARD_RNG_SEED) && !board_rng_seed(&buf)) {
-		err = fdt_setprop(fdt, nodeoffset, "rng-seed",
-				  abuf_data(&buf), abuf_size(&buf));
+		err = fdt_batch_setprop(&batch, nodeoffset, "rng-seed",
+					abuf_data(&buf), abuf_size(&buf));
 		abuf_uninit(&buf);
 		if (err < 0) {
 			printf("WARNING: could not set rng-seed %s.\n",
 			       fdt_strerror(err));
+			fdt_batch_commit(&batch);
 			return err;
 		}
 	}
 
 	str = board_fdt_chosen_bootargs(fdt);
 	if (str) {
-		err = fdt_setprop(fdt, nodeoffset, "bootargs", str,
-				  strlen(str) + 1);
+		err = fdt_batch_setprop(&batch, nodeoffset, "bootargs", str,
+					strlen(str) + 1);
 		if (err < 0) {
 			printf("WARNING: could not set bootargs %s.\n",
 			       fdt_strerror(err));
+			fdt_batch_commit(&batch);
 			return err;
 		}
 	}
 
+	err = fdt_batch_commit(&batch);
+	if (err < 0) {
+		printf("WARNING: could not set /chosen %s.\n",
+		       fdt_strerror(err));
+		return err;
+	}
+
 	return fdt_fixup_stdout(fdt, nodeoffset);
 }
 
@@ -405,6 +417,7 @@ void do_fixup_by_prop(void *fdt,
 		      const char *prop, const void *val, int len,
 		      int create)
 {
+	struct fdt_batch b;
 	int off;
 #if defined(DEBUG)
 	int i;
@@ -413,12 +426,17 @@ void do_fixup_by_prop(void *fdt,
 		debug(" %.2x", *(u8*)(val+i));
 	debug("\n");
 #endif
+	fdt_batch_begin(&b, fdt);
 	off = fdt_node_offset_by_prop_value(fdt, -1, pname, pval, plen);
 	while (off != -FDT_ERR_NOTFOUND) {
 		if (create || (fdt_get_property(fdt, off, prop, NULL) != NULL))
-			fdt_setprop(fdt, off, prop, val, len);
+			fdt_batch_setprop(&b, off, prop, val, len);
 		off = fdt_node_offset_by_prop_value(fdt, off, pname, pval, plen);
 	}
+	off = fdt_batch_commit(&b);
+	if (off)
+		printf("Unable to update property %s, err=%s\n",
+		       prop, fdt_strerror(off));
 }
 
 void do_fixup_by_prop_u32(void *fdt,
@@ -432,6 +450,7 @@ void do_fixup_by_prop_u32(void *fdt,
 void do_fixup_by_compat(void *fdt, const char *compat,
 			const char *prop, const void *val, int len, int create)
 {
+	struct fdt_batch b;
 	int off = -1;
 #if defined(DEBUG)
 	int i;
@@ -440,12 +459,17 @@ void do_fixup_by_compat(void *fdt, const char *compat,
 		debug(" %.2x", *(u8*)(val+i));
 	debug("\n");
 #endif
+	fdt_batch_begin(&b, fdt);
 	off = fdt_node_offset_by_compatible(fdt, -1, compat);
 	while (off != -FDT_ERR_NOTFOUND) {
 		if (create || (fdt_get_property(fdt, off, prop, NULL) != NULL))
-			fdt_setprop(fdt, off, prop, val, len);
+			fdt_batch_setprop(&b, off, prop, val, len);
 		off = fdt_node_offset_by_compatible(fdt, off, compat);
 	}
+	off = fdt_batch_commit(&b);
+	if (off)
+		printf("Unable to update property %s, err=%s\n",
+		       prop, fdt_strerror(off));
 }
 
 void do_fixup_by_compat_u32(void *fdt, const char *compat,
@@ -829,6 +853,238 @@ int fdt_increase_size(void *fdt, int add_len)
 	return fdt_open_into(fdt, fdt, newlen);
 }
 
+#define ALIGN_TAG(x)	ALIGN(x, FDT_TAGSIZE)
+
+struct fdt_batch_op {
+	int pos;		/* struct block offset to write at */
+	int old_size;		/* bytes replaced there, 0 for a new property */
+	int nodeoffset;
+	const char *name;
+	int nameoff;
+	void *val;
+	int len;
+};
+
+void fdt_batch_begin(struct fdt_batch *b, void *fdt)
+{
+	b->fdt = fdt;
+	b->ops = NULL;
+	b->count = 0;
+	b->max = 0;
+}
+
+static void fdt_batch_free(struct fdt_batch *b)
+{
+	int i;
+
+	for (i = 0; i < b->count; i++)
+		free(b->ops[i].val);
+	free(b->ops);
+	b->ops = NULL;
+	b->count = 0;
+	b->max = 0;
+}
+
+int fdt_batch_setprop(struct fdt_batch *b, int nodeoffset, const char *name,
+		      const void *val, int len)
+{
+	struct fdt_property *prop;
+	struct fdt_batch_op *op = NULL;
+	void *fdt = b->fdt;
+	int i, oldlen;
+
+	if (len < 0)
+		return -FDT_ERR_BADVALUE;
+
+	for (i = 0; i < b->count; i++) {
+		if (b->ops[i].nodeoffset == nodeoffset &&
+		    !strcmp(b->ops[i].name, name)) {
+			op = &b->ops[i];
+			break;
+		}
+	}
+
+	prop = fdt_get_property_w(fdt, nodeoffset, name, &oldlen);
+	if (!prop && oldlen != -FDT_ERR_NOTFOUND)
+		return oldlen;
+
+	/* Same room as before, no need to move anything */
+	if (!op && prop && ALIGN_TAG(oldlen) == ALIGN_TAG(len)) {
+		memcpy(prop->data, val, len);
+		memset(prop->data + len, 0, ALIGN_TAG(len) - len);
+		prop->len = cpu_to_fdt32(len);
+		return 0;
+	}
+
+	if (!op) {
+		if (b->count == b->max) {
+			op = realloc(b->ops, (b->max + 8) * sizeof(*op));
+			if (!op)
+				return -FDT_ERR_NOSPACE;
+			b->ops = op;
+			b->max += 8;
+		}
+		op = &b->ops[b->count++];
+		op->nodeoffset = nodeoffset;
+		op->name = name;
+		if (prop) {
+			op->pos = (char *)prop - (char *)fdt -
+				  fdt_off_dt_struct(fdt);
+			op->old_size = sizeof(*prop) + ALIGN_TAG(oldlen);
+		} else {
+			/* Right behind the node name, as fdt_setprop() does */
+			op->pos = fdt_first_property_offset(fdt, nodeoffset);
+			if (op->pos < 0) {
+				const char *nodename;
+				int namelen;
+
+				nodename = fdt_get_name(fdt, nodeoffset,
+							&namelen);
+				if (!nodename) {
+					b->count--;
+					return namelen;
+				}
+				op->pos = nodeoffset + FDT_TAGSIZE +
+					  ALIGN_TAG(namelen + 1);
+			}
+			op->old_size = 0;
+		}
+	} else {
+		free(op->val);
+	}
+
+	op->val = malloc(len ? len : 1);
+	if (!op->val) {
+		*op = b->ops[--b->count];
+		return -FDT_ERR_NOSPACE;
+	}
+	memcpy(op->val, val, len);
+	op->len = len;
+
+	return 0;
+}
+
+/* Offset of @name in the strings block, or -1 */
+static int fdt_batch_find_string(const char *strtab, int tabsize,
+				 const char *name)
+{
+	int len = strlen(name) + 1;
+	const char *p;
+
+	for (p = strtab; p + len <= strtab + tabsize; p += strlen(p) + 1) {
+		if (!memcmp(p, name, len))
+			return p - strtab;
+	}
+
+	return -1;
+}
+
+int fdt_batch_commit(struct fdt_batch *b)
+{
+	void *fdt = b->fdt;
+	int off_struct = fdt_off_dt_struct(fdt);
+	int off_strings = fdt_off_dt_strings(fdt);
+	int size_struct = fdt_size_dt_struct(fdt);
+	int size_strings = fdt_size_dt_strings(fdt);
+	int grow = 0, new_strings = 0, cur = 0, i, j, n, ret = 0;
+	struct fdt_batch_op *op, tmp;
+	struct fdt_property *prop;
+	char *strtab, *buf, *p;
+
+	if (!b->count)
+		goto out;
+
+	/* As fdt_open_into() leaves it, the strings block last */
+	if (off_struct + size_struct != off_strings ||
+	    off_strings + size_strings > fdt_totalsize(fdt)) {
+		ret = -FDT_ERR_BADLAYOUT;
+		goto out;
+	}
+
+	/* In struct block order, new ones before a replaced one there */
+	for (i = 1; i < b->count; i++) {
+		tmp = b->ops[i];
+		for (j = i; j > 0 && (b->ops[j - 1].pos > tmp.pos ||
+				      (b->ops[j - 1].pos == tmp.pos &&
+				       b->ops[j - 1].old_size > tmp.old_size));
+		     j--)
+			b->ops[j] = b->ops[j - 1];
+		b->ops[j] = tmp;
+	}
+
+	strtab = fdt + off_strings;
+	for (i = 0; i < b->count; i++) {
+		op = &b->ops[i];
+		grow += sizeof(*prop) + ALIGN_TAG(op->len) - op->old_size;
+		op->nameoff = fdt_batch_find_string(strtab, size_strings,
+						    op->name);
+		if (op->nameoff >= 0)
+			continue;
+		/* A name new to the blob, maybe queued already */
+		for (j = 0; j < i; j++) {
+			if (b->ops[j].nameoff >= size_strings &&
+			    !strcmp(b->ops[j].name, op->name)) {
+				op->nameoff = b->ops[j].nameoff;
+				break;
+			}
+		}
+		if (op->nameoff < 0) {
+			op->nameoff = size_strings + new_strings;
+			new_strings += strlen(op->name) + 1;
+		}
+	}
+
+	if (off_strings + grow + size_strings + new_strings >
+	    fdt_totalsize(fdt)) {
+		ret = -FDT_ERR_NOSPACE;
+		goto out;
+	}
+
+	buf = malloc(size_struct + grow);
+	if (!buf) {
+		ret = -FDT_ERR_NOSPACE;
+		goto out;
+	}
+
+	/* Lay out the new struct block aside, then move the blob once */
+	p = buf;
+	for (i = 0; i < b->count; i++) {
+		op = &b->ops[i];
+		n = op->pos - cur;
+		memcpy(p, fdt + off_struct + cur, n);
+		p += n;
+		prop = (struct fdt_property *)p;
+		prop->tag = cpu_to_fdt32(FDT_PROP);
+		prop->len = cpu_to_fdt32(op->len);
+		prop->nameoff = cpu_to_fdt32(op->nameoff);
+		memcpy(prop->data, op->val, op->len);
+		memset(prop->data + op->len, 0,
+		       ALIGN_TAG(op->len) - op->len);
+		p += sizeof(*prop) + ALIGN_TAG(op->len);
+		cur = op->pos + op->old_size;
+	}
+	memcpy(p, fdt + off_struct + cur, size_struct - cur);
+
+	memmove(fdt + off_strings + grow, strtab, size_strings);
+	strtab = fdt + off_strings + grow;
+	for (i = 0; i < b->count; i++) {
+		op = &b->ops[i];
+		if (op->nameoff >= size_strings)
+			strcpy(strtab + op->nameoff, op->name);
+	}
+	memcpy(fdt + off_struct, buf, size_struct + grow);
+	free(buf);
+
+	fdt_set_size_dt_struct(fdt, size_struct + grow);
+	fdt_set_off_dt_strings(fdt, off_strings + grow);
+	fdt_set_size_dt_strings(fdt, size_strings + new_strings);
+
+out:
+	fdt_batch_free(b);
+
+	return ret;
+}
+
 #ifdef CONFIG_FDT_FIXUP_PARTITIONS
 #include <jffs2/load_kernel.h>
 #include <mtd_node.h>
@@ -16,6 +16,13 @@
 #include <sysmem.h>
 #include <mp_boot.h>
 #include <u-boot/sha1.h>
+#include <linux/sizes.h>
+#include <asm/unaligned.h>
+#ifdef CONFIG_ANDROID_BOOT_IMAGE_STREAM_DECOMP
+#include <memalign.h>
+#include <u-boot/zlib.h>
+#include <linux/err.h>
+#endif
 #ifdef CONFIG_RKIMG_BOOTLOADER
 #include <asm/arch/resource_img.h>
 #endif
@@ -180,6 +187,44 @@ static ulong android_image_get_kernel_addr(const struct andr_img_hdr *hdr)
 
 }
 
+#ifdef CONFIG_ARM64
+/* See Documentation/arm64/booting.txt in the Linux kernel */
+#define ARM64_IMAGE_HDR_SIZE	64
+#define ARM64_IMAGE_MAGIC	0x644d5241
+
+/*
+ * Where an arm64 Image meant for @addr must run from so that it is never
+ * moved again: by booti_setup(), or by board_prep_linux() which has
+ * board_quiesce_devices() memmove() it. That is the 2MB aligned base at or
+ * above @addr - text_offset, plus text_offset. @image is the start of the
+ * Image, ARM64_IMAGE_HDR_SIZE bytes at least. Images without a usable
+ * text_offset stay at @addr.
+ */
+static ulong android_image_kernel_place(ulong addr, const void *image)
+{
+	const u8 *ih = image;
+	u64 text_offset;
+
+	/* Before Linux commit a2c1d73b94ed: image_size 0, unknown endianness */
+	if (get_unaligned_le32(ih + 56) != ARM64_IMAGE_MAGIC ||
+	    !get_unaligned_le64(ih + 16))
+		return addr;
+
+	text_offset = get_unaligned_le64(ih + 8);
+	if (addr < text_offset)
+		return addr;
+
+	return ALIGN(addr - text_offset, SZ_2M) + text_offset;
+}
+#else
+#define ARM64_IMAGE_HDR_SIZE	0
+
+static inline ulong android_image_kernel_place(ulong addr, const void *image)
+{
+	return addr;
+}
+#endif
+
 void android_image_set_comp(struct andr_img_hdr *hdr, u32 comp)
 {
 	android_kernel_comp_type = comp;
@@ -421,6 +466,363 @@ typedef enum {
 static sha1_context sha1_ctx;
 #endif
 
+#ifdef CONFIG_ANDROID_BOOT_IMAGE_STREAM_DECOMP
+/* Compressed kernel read at a time, while the previous chunk is decoded */
+#define KERNEL_STREAM_CHUNK		SZ_1M
+/* Room for the largest LZ4 block waiting for its tail, plus two chunks */
+#define KERNEL_STREAM_WIN		(SZ_4M + 2 * KERNEL_STREAM_CHUNK + SZ_4K)
+
+#ifndef CONFIG_SYS_BOOTM_LEN
+/* same default max decompressed size as bootm */
+#define CONFIG_SYS_BOOTM_LEN		0x800000
+#endif
+
+struct kernel_stream {
+	int comp;
+	bool done;
+#ifdef CONFIG_GZIP
+	bool zs_init;
+	z_stream zs;
+#endif
+#ifdef CONFIG_LZ4
+	struct ulz4f_stream lz;
+#endif
+};
+
+/* Set by android_image_load() around android_image_load_separate() */
+static int kernel_stream_comp = IH_COMP_NONE;
+static ulong kernel_stream_size;
+static ulong kernel_stream_addr;
+
+static bool kernel_stream_supported(int comp)
+{
+#ifdef CONFIG_GZIP
+	if (comp == IH_COMP_GZIP)
+		return true;
+#endif
+#ifdef CONFIG_LZ4
+	if (comp == IH_COMP_LZ4)
+		return true;
+#endif
+	return false;
+}
+
+static void kernel_stream_init(struct kernel_stream *ks, int comp,
+			       void *dst, ulong dstlen)
+{
+	memset(ks, 0, sizeof(*ks));
+	ks->comp = comp;
+#ifdef CONFIG_GZIP
+	ks->zs.zalloc = gzalloc;
+	ks->zs.zfree = gzfree;
+	ks->zs.next_out = dst;
+	ks->zs.avail_out = dstlen;
+#endif
+#ifdef CONFIG_LZ4
+	ulz4f_stream_init(&ks->lz, dst, dstlen);
+#endif
+}
+
+/* Return: number of bytes consumed from @in, or -ve on error */
+static int kernel_stream_feed(struct kernel_stream *ks, u8 *in, ulong len)
+{
+#ifdef CONFIG_LZ4
+	if (ks->comp == IH_COMP_LZ4) {
+		int ret = ulz4f_stream_decode(&ks->lz, in, len);
+
+		ks->done = ks->lz.done;
+		return ret;
+	}
+#endif
+#ifdef CONFIG_GZIP
+	if (ks->comp == IH_COMP_GZIP) {
+		int off = 0;
+		int r;
+
+		/* The first chunk always holds the whole gzip header */
+		if (!ks->zs_init) {
+			off = gzip_parse_header(in, len);
+			if (off < 0)
+				return -EINVAL;
+			if (inflateInit2(&ks->zs, -MAX_WBITS) != Z_OK)
+				return -ENOMEM;
+			ks->zs_init = true;
+		}
+
+		ks->zs.next_in = in + off;
+		ks->zs.avail_in = len - off;
+		r = inflate(&ks->zs, Z_NO_FLUSH);
+		if (r == Z_STREAM_END)
+			ks->done = true;
+		else if (r != Z_OK && r != Z_BUF_ERROR)
+			return -EPROTO;
+		else if (!ks->zs.avail_out)
+			return -ENOBUFS;
+
+		return len - ks->zs.avail_in;
+	}
+#endif
+	return -EPROTONOSUPPORT;
+}
+
+/* Bytes decoded to @dst so far */
+static ulong kernel_stream_out(struct kernel_stream *ks, void *dst)
+{
+#ifdef CONFIG_LZ4
+	if (ks->comp == IH_COMP_LZ4)
+		return ks->lz.out - dst;
+#endif
+#ifdef CONFIG_GZIP
+	if (ks->comp == IH_COMP_GZIP)
+		return ks->zs.total_out;
+#endif
+	return 0;
+}
+
+/*
+ * Move what is decoded so far from @dst to @new_dst, and go on decoding
+ * there. LZ4 blocks are independent and zlib keeps its own window, so
+ * nothing refers to the old place past the call that decoded it.
+ */
+static void kernel_stream_move(struct kernel_stream *ks, void *dst,
+			       void *new_dst)
+{
+	ulong out = kernel_stream_out(ks, dst);
+
+	memmove(new_dst, dst, out);
+#ifdef CONFIG_LZ4
+	ks->lz.out = new_dst + out;
+	ks->lz.end += new_dst - dst;
+#endif
+#ifdef CONFIG_GZIP
+	ks->zs.next_out = new_dst + out;
+#endif
+}
+
+static ulong kernel_stream_end(struct kernel_stream *ks, void *dst)
+{
+#ifdef CONFIG_LZ4
+	if (ks->comp == IH_COMP_LZ4)
+		return ks->lz.out - dst;
+#endif
+#ifdef CONFIG_GZIP
+	if (ks->comp == IH_COMP_GZIP && ks->zs_init) {
+		inflateEnd(&ks->zs);
+		return ks->zs.total_out;
+	}
+#endif
+	return 0;
+}
+
+/*
+ * Read the compressed kernel chunk by chunk and decompress it straight to
+ * "kernel_addr_r" while the next chunk is being read, rather than staging
+ * the whole compressed kernel at "android_addr_r" for bootm to decompress.
+ * Only a small window is needed for the data not consumed by the decoder.
+ * As soon as the Image header is decoded, the output goes on where the
+ * Image runs from, see android_image_kernel_place(), which only costs
+ * moving the first piece rather than the whole kernel before booting.
+ *
+ * Return: 0 if the kernel has been decompressed, 1 if streaming is not
+ * possible and the kernel should be loaded as usual, or -ve on error.
+ */
+static int image_load_kernel_stream(struct blk_desc *desc,
+				    struct andr_img_hdr *hdr, ulong blkstart)
+{
+	ulong pgsz = hdr->page_size;
+	ulong blksz = desc->blksz;
+	lbaint_t chunk_blks = KERNEL_STREAM_CHUNK / blksz;
+	lbaint_t blkcnt, queued, pending = 0;
+	ulong got = 0, have = 0, bytes, pad, size;
+	struct kernel_stream ks;
+	u32 ksize = hdr->kernel_size;
+	bool placed = !ARM64_IMAGE_HDR_SIZE;
+	u8 *win, *data;
+	void *dst, *place;
+	ulong n;
+	int ret;
+
+	if (!kernel_stream_supported(kernel_stream_comp))
+		return 1;
+
+	dst = (void *)env_get_ulong("kernel_addr_r", 16, 0);
+	if (!dst || !ksize || !IS_ALIGNED(pgsz, blksz))
+		return 1;
+
+	win = memalign(ARCH_DMA_MINALIGN, KERNEL_STREAM_WIN);
+	if (!win)
+		return 1;
+
+	kernel_stream_init(&ks, kernel_stream_comp, dst, CONFIG_SYS_BOOTM_LEN);
+
+	/* skip the image header page, it's copied by android_image_load() */
+	blkstart += pgsz / blksz;
+	blkcnt = DIV_ROUND_UP(ksize, blksz);
+	data = win;
+
+	n = blk_dread_async(desc, blkstart, min(blkcnt, chunk_blks), win);
+	if (!n || IS_ERR_VALUE(n)) {
+		ret = -EIO;
+		goto out;
+	}
+	queued = pending = n;
+
+	while (pending) {
+		ret = blk_wait(desc);
+		bytes = min_t(ulong, pending * blksz, ksize - got);
+		pending = 0;
+		if (ret)
+			goto out;
+
+#ifdef CONFIG_ANDROID_BOOT_IMAGE_HASH
+		if (hdr->header_version < 3)
+			sha1_update(&sha1_ctx, data + have, bytes);
+#endif
+		got += bytes;
+		have += bytes;
+
+		/* only the trailer is left after the end of the stream */
+		if (ks.done) {
+			data = win;
+			have = 0;
+		}
+
+		if (queued < blkcnt) {
+			n = min(blkcnt - queued, chunk_blks);
+			/*
+			 * Reads always end DMA aligned, so the next one can be
+			 * issued right behind the unconsumed bytes, unless the
+			 * window is full: then move those bytes to the start,
+			 * keeping them right below an aligned address.
+			 */
+			if (data + have + n * blksz > win + KERNEL_STREAM_WIN) {
+				pad = ALIGN(have, ARCH_DMA_MINALIGN) - have;
+				if (pad + have + n * blksz > KERNEL_STREAM_WIN) {
+					ret = -EFBIG;
+					goto out;
+				}
+				memmove(win + pad, data, have);
+				data = win + pad;
+			}
+			n = blk_dread_async(desc, blkstart + queued, n,
+					    data + have);
+			if (!n || IS_ERR_VALUE(n)) {
+				ret = -EIO;
+				goto out;
+			}
+			queued += n;
+			pending = n;
+		}
+
+		if (ks.done)
+			continue;
+
+		bootstage_start(BOOTSTAGE_ID_ACCUM_DECOMP, "decompress");
+		ret = kernel_stream_feed(&ks, data, have);
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_DECOMP);
+		if (ret < 0)
+			goto out;
+		data += ret;
+		have -= ret;
+
+		if (!placed &&
+		    kernel_stream_out(&ks, dst) >= ARM64_IMAGE_HDR_SIZE) {
+			place = (void *)android_image_kernel_place((ulong)dst,
+								   dst);
+			if (place != dst) {
+				kernel_stream_move(&ks, dst, place);
+				dst = place;
+			}
+			placed = true;
+		}
+	}
+
+	ret = ks.done ? 0 : -EINVAL;
+out:
+	if (pending)
+		blk_wait(desc);
+	size = kernel_stream_end(&ks, dst);
+	free(win);
+
+	if (ret) {
+		printf("Failed to decompress kernel while reading, ret=%d\n", ret);
+		return ret;
+	}
+
+	if (!sysmem_alloc_base(MEM_KERNEL, (phys_addr_t)dst - pgsz,
+			       ALIGN(pgsz + size, blksz)))
+		return -ENOMEM;
+
+#ifdef CONFIG_ANDROID_BOOT_IMAGE_HASH
+	if (hdr->header_version < 3)
+		sha1_update(&sha1_ctx, (void *)&ksize, sizeof(ksize));
+#endif
+	kernel_stream_size = size;
+	kernel_stream_addr = (ulong)dst;
+	printf("ANDROID: kernel decompressed while reading: %u -> %lu bytes\n",
+	       ksize, size);
+
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_ANDROID_AVB_PRELOAD_IN_PLACE
+/*
+ * Sections that AVB reads straight to where image_load() would copy them
+ * from the verified image, see android_image_place_prepare().
+ */
+static struct android_place places[ANDROID_PLACE_MAX];
+static int places_num;
+
+/* Is the sysmem region at @base reserved for a section in place */
+static bool image_mem_claimed(ulong base)
+{
+	int i;
+
+	for (i = 0; i < places_num; i++) {
+		if (places[i].claimed && places[i].mem_base == base)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * 1 if @img is in place at @dst, 0 if it is to be copied, or -EINVAL if
+ * the verified header doesn't describe what was planned from the header
+ * before it was verified.
+ */
+static int image_placed(img_t img, void *dst, ulong len)
+{
+	int i;
+
+	for (i = 0; i < places_num; i++) {
+		if (places[i].img != img || !places[i].claimed)
+			continue;
+
+		if (places[i].dst != (ulong)dst || places[i].len != len) {
+			printf("img(%d) is in place at 0x%08lx, 0x%lx bytes, not at 0x%08lx, 0x%lx bytes\n",
+			       img, places[i].dst, places[i].len, (ulong)dst, len);
+			return -EINVAL;
+		}
+
+		return 1;
+	}
+
+	return 0;
+}
+#else
+static inline bool image_mem_claimed(ulong base)
+{
+	return false;
+}
+
+static inline int image_placed(img_t img, void *dst, ulong len)
+{
+	return 0;
+}
+#endif
+
 static int image_load(img_t img, struct andr_img_hdr *hdr,
 		      ulong blkstart, void *ram_base)
 {
@@ -442,12 +844,21 @@ static int image_load(img_t img, struct andr_img_hdr *hdr,
 
 	switch (img) {
 	case IMG_KERNEL:
+#ifdef CONFIG_ANDROID_BOOT_IMAGE_STREAM_DECOMP
+		if (!ram_base) {
+			ret = image_load_kernel_stream(desc, hdr, blkstart);
+			if (ret <= 0)
+				return ret;
+			ret = 0;
+		}
+#endif
 		bsoffs = 0; /* include a page_size(image header) */
 		length = hdr->kernel_size + pgsz;
 		buffer = (void *)env_get_ulong("android_addr_r", 16, 0);
 		blkcnt = DIV_ROUND_UP(hdr->kernel_size + pgsz, blksz);
 		typesz = sizeof(hdr->kernel_size);
-		if (!sysmem_alloc_base(MEM_KERNEL,
+		if (!image_mem_claimed((ulong)buffer) &&
+		    !sysmem_alloc_base(MEM_KERNEL,
 			(phys_addr_t)buffer, blkcnt * blksz))
 			return -ENOMEM;
 		break;
@@ -484,7 +895,8 @@ static int image_load(img_t img, struct andr_img_hdr *hdr,
 		if (hdr->header_version >= 4)
 			extra += ALIGN(hdr->vendor_bootconfig_size, blksz) +
 				 ANDROID_ADDITION_BOOTCONFIG_PARAMS_MAX_SIZE;
-		if (length && !sysmem_alloc_base(MEM_RAMDISK,
+		if (length && !image_mem_claimed((ulong)buffer) &&
+		    !sysmem_alloc_base(MEM_RAMDISK,
 			(phys_addr_t)buffer, blkcnt * blksz + extra))
 			return -ENOMEM;
 		break;
@@ -543,7 +955,8 @@ static int image_load(img_t img, struct andr_img_hdr *hdr,
 		}
 		/* sysmem has been alloced by vendor ramdisk */
 		if (hdr->header_version < 3) {
-			if (length && !sysmem_alloc_base(MEM_RAMDISK,
+			if (length && !image_mem_claimed((ulong)buffer) &&
+			    !sysmem_alloc_base(MEM_RAMDISK,
 				(phys_addr_t)buffer, blkcnt * blksz))
 				return -ENOMEM;
 		}
@@ -632,7 +1045,19 @@ static int image_load(img_t img, struct andr_img_hdr *hdr,
 
 	/* load */
 	if (ram_base) {
-		memcpy(buffer, (char *)((ulong)ram_base + bsoffs), length);
+		if (img == IMG_KERNEL)
+			ret = image_placed(img, buffer + pgsz, length - pgsz);
+		else
+			ret = image_placed(img, buffer, length);
+		if (ret < 0)
+			return ret;
+
+		/* In place but for the header in front of the kernel */
+		if (!ret)
+			memcpy(buffer, (char *)((ulong)ram_base + bsoffs), length);
+		else if (img == IMG_KERNEL)
+			memcpy(buffer, ram_base, pgsz);
+		ret = 0;
 	} else {
 		blkoff = DIV_ROUND_UP(bsoffs, blksz);
 		ret = blk_dread(desc, blkstart + blkoff, blkcnt, buffer);
@@ -896,13 +1321,202 @@ static int android_image_load_separate(struct andr_img_hdr *hdr,
 		return android_image_separate_v34(hdr, part, load_addr, NULL);
 }
 
+#ifdef CONFIG_ANDROID_AVB_PRELOAD_IN_PLACE
+static void image_place_add(const char *part, const char *slot_suffix,
+			    img_t img, ulong offset, ulong len, ulong dst,
+			    enum memblk_id mem, ulong mem_base, ulong mem_size)
+{
+	struct blk_desc *desc = rockchip_get_bootdev();
+	struct android_place *place;
+
+	/* Read with whole blocks and DMA right to @dst, or not at all */
+	if (!len || !IS_ALIGNED(offset, desc->blksz) ||
+	    !IS_ALIGNED(dst, ARCH_DMA_MINALIGN) ||
+	    places_num == ANDROID_PLACE_MAX)
+		return;
+
+	place = &places[places_num++];
+	snprintf(place->part, sizeof(place->part), "%s%s", part, slot_suffix);
+	place->img = img;
+	place->offset = offset;
+	place->len = len;
+	place->dst = dst;
+	place->mem = mem;
+	place->mem_base = mem_base;
+	place->mem_size = mem_size;
+	place->claimed = false;
+}
+
+int android_image_place_prepare(struct andr_img_hdr *hdr,
+				const char *boot_part,
+				const char *slot_suffix,
+				ulong load_address)
+{
+	struct blk_desc *desc = rockchip_get_bootdev();
+	u32 andr_version = (hdr->os_version >> 25) & 0x7f;
+	ulong pgsz = hdr->page_size;
+	disk_partition_t part;
+	ulong blksz, comp_addr;
+	ulong rd_addr, rd_size;
+	void *blk;
+	int comp;
+
+	android_image_place_reset();
+
+	if (!desc || part_get_info_by_name(desc, boot_part, &part) < 0)
+		return -ENODEV;
+	blksz = desc->blksz;
+
+	/*
+	 * The same addresses as avb_image_distribute_finish() gets from
+	 * android_image_memcpy_separate(), which parses the compression of
+	 * the kernel from its first block.
+	 */
+	blk = memalign(ARCH_DMA_MINALIGN, blksz);
+	if (!blk)
+		return -ENOMEM;
+	if (blk_dread(desc, part.start + pgsz / blksz, 1, blk) != 1) {
+		free(blk);
+		return -EIO;
+	}
+	comp = bootm_parse_comp(blk);
+	comp_addr = android_image_get_comp_addr(hdr, comp);
+	if (comp_addr)
+		load_address = comp_addr;
+	else
+		load_address = android_image_kernel_place(load_address, blk) -
+			       pgsz;
+	free(blk);
+
+	image_place_add(boot_part, slot_suffix, IMG_KERNEL, pgsz,
+			hdr->kernel_size, load_address + pgsz,
+			MEM_KERNEL, load_address,
+			ALIGN(hdr->kernel_size + pgsz, blksz));
+
+	rd_addr = env_get_ulong("ramdisk_addr_r", 16, 0);
+	if (!rd_addr)
+		return places_num;
+
+	if (hdr->header_version < 3) {
+		image_place_add(boot_part, slot_suffix, IMG_RAMDISK,
+				pgsz + ALIGN(hdr->kernel_size, pgsz),
+				hdr->ramdisk_size, rd_addr, MEM_RAMDISK,
+				rd_addr, ALIGN(hdr->ramdisk_size, blksz));
+		return places_num;
+	}
+
+	/* See image_load(IMG_VENDOR_RAMDISK) for the layout at ramdisk_addr_r */
+	if (!hdr->vendor_ramdisk_size)
+		return places_num;
+
+	rd_size = ALIGN(hdr->vendor_ramdisk_size, blksz) +
+		  ALIGN(hdr->ramdisk_size, blksz) + blksz;
+	if (hdr->header_version >= 4)
+		rd_size += ALIGN(hdr->vendor_bootconfig_size, blksz) +
+			   ANDROID_ADDITION_BOOTCONFIG_PARAMS_MAX_SIZE;
+
+	image_place_add(ANDROID_PARTITION_VENDOR_BOOT, slot_suffix,
+			IMG_VENDOR_RAMDISK,
+			ALIGN(VENDOR_BOOT_HDRv3_SIZE, hdr->vendor_page_size),
+			hdr->vendor_ramdisk_size, rd_addr, MEM_RAMDISK,
+			rd_addr, rd_size);
+
+	/* Concatenated right after the vendor ramdisk */
+	if (!IS_ALIGNED(hdr->vendor_ramdisk_size, blksz))
+		return places_num;
+
+	if (hdr->header_version >= 4 && andr_version >= 13)
+		image_place_add(ANDROID_PARTITION_INIT_BOOT, slot_suffix,
+				IMG_RAMDISK, pgsz, hdr->ramdisk_size,
+				rd_addr + hdr->vendor_ramdisk_size,
+				MEM_RAMDISK, rd_addr, rd_size);
+	else
+		image_place_add(boot_part, slot_suffix, IMG_RAMDISK,
+				pgsz + ALIGN(hdr->kernel_size, pgsz),
+				hdr->ramdisk_size,
+				rd_addr + hdr->vendor_ramdisk_size,
+				MEM_RAMDISK, rd_addr, rd_size);
+
+	return places_num;
+}
+
+struct android_place *android_image_place_next(const char *part,
+					       ulong offset)
+{
+	struct android_place *next = NULL;
+	int i;
+
+	for (i = 0; i < places_num; i++) {
+		if (strcmp(places[i].part, part) || places[i].offset < offset)
+			continue;
+		if (!next || places[i].offset < next->offset)
+			next = &places[i];
+	}
+
+	return next;
+}
+
+int android_image_place_claim(struct android_place *place)
+{
+	if (place->claimed)
+		return 0;
+
+	/* Sections sharing a region, the ramdisks, reserve it once */
+	if (!image_mem_claimed(place->mem_base) &&
+	    !sysmem_alloc_base(place->mem, place->mem_base, place->mem_size))
+		return -ENOMEM;
+
+	place->claimed = true;
+
+	return 0;
+}
+
+void android_image_place_reset(void)
+{
+	int i;
+
+	for (i = 0; i < places_num; i++) {
+		if (!places[i].claimed)
+			continue;
+
+		/* The last section of a region frees it */
+		places[i].claimed = false;
+		if (!image_mem_claimed(places[i].mem_base))
+			sysmem_free(places[i].mem_base);
+	}
+	places_num = 0;
+}
+
+/* The kernel is not behind the header if it was read in place */
+static void *image_kernel(struct andr_img_hdr *hdr)
+{
+	int i;
+
+	for (i = 0; i < places_num; i++) {
+		if (places[i].img == IMG_KERNEL && places[i].claimed)
+			return (void *)places[i].dst;
+	}
+
+	return (void *)(ulong)hdr + hdr->page_size;
+}
+#else
+static inline void *image_kernel(struct andr_img_hdr *hdr)
+{
+	return (void *)(ulong)hdr + hdr->page_size;
+}
+#endif
+
 int android_image_memcpy_separate(struct andr_img_hdr *hdr, ulong *load_addr)
 {
 	ulong comp_addr;
 	int comp;
 
-	comp = bootm_parse_comp((void *)(ulong)hdr + hdr->page_size);
+	comp = bootm_parse_comp(image_kernel(hdr));
 	comp_addr = android_image_get_comp_addr(hdr, comp);
+	if (!comp_addr)
+		*load_addr = android_image_kernel_place(*load_addr +
+					hdr->page_size, image_kernel(hdr)) -
+			     hdr->page_size;
 
 	/* non-compressed image: already in-place */
 	if ((ulong)hdr == *load_addr)
@@ -984,13 +1598,39 @@ long android_image_load(struct blk_desc *dev_desc,
 	if (comp_addr)
 		load_address = comp_addr;
 	else
-		load_address -= hdr->page_size;
+		load_address = android_image_kernel_place(load_address,
+					(void *)hdr + hdr->page_size) -
+			       hdr->page_size;
 
+#ifdef CONFIG_ANDROID_BOOT_IMAGE_STREAM_DECOMP
+	kernel_stream_comp = comp;
+	kernel_stream_size = 0;
+#endif
 	ret = android_image_load_separate(hdr, part_info, (void *)load_address);
+#ifdef CONFIG_ANDROID_BOOT_IMAGE_STREAM_DECOMP
+	kernel_stream_comp = IH_COMP_NONE;
+#endif
 	if (ret) {
 		printf("Failed to load android image\n");
 		goto fail;
 	}
+
+#ifdef CONFIG_ANDROID_BOOT_IMAGE_STREAM_DECOMP
+	/*
+	 * The kernel is decompressed at kernel_addr_r already, put the header
+	 * right in front of it and treat it as a non-compressed image.
+	 */
+	if (kernel_stream_size) {
+		struct andr_img_hdr *khdr;
+
+		load_address = kernel_stream_addr - hdr->page_size;
+		khdr = (struct andr_img_hdr *)load_address;
+		memcpy(khdr, hdr, hdr->page_size);
+		khdr->kernel_size = kernel_stream_size;
+		khdr->kernel_addr = ANDROID_IMAGE_DEFAULT_KERNEL_ADDR;
+		comp = IH_COMP_NONE;
+	}
+#endif
 	android_image_set_decomp((void *)load_address, comp);
 
 	debug("Loading Android Image to 0x%08lx\n", load_address);
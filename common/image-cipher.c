@@ -0,0 +1,188 @@
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ *
+ * Decryption of encrypted FIT images with the crypto engine, a chunk at a
+ * time while they are read from storage. The hashes and signatures of an
+ * encrypted image cover its decrypted data, so it is verified as usual
+ * once it has been decrypted in place.
+ */
+
+#include <common.h>
+#include <crypto.h>
+#include <fdtdec.h>
+#include <image.h>
+#include <image-cipher.h>
+#include <asm/unaligned.h>
+
+static int fit_cipher_get_key(const void *blob, int node, const char *name,
+			      u8 *buf, int len)
+{
+	const void *val;
+	int size;
+
+	val = fdt_getprop(blob, node, name, &size);
+	if (!val || size != len)
+		return -EINVAL;
+	memcpy(buf, val, len);
+
+	return 0;
+}
+
+int fit_image_cipher_init(const void *fit, int noffset, const void *key_blob,
+			  struct fit_cipher *c)
+{
+	const char *algo, *mode, *hint;
+	int cipher_node, key_node;
+	int size, unciphered;
+	char path[64];
+	int ret;
+
+	cipher_node = fdt_subnode_offset(fit, noffset, FIT_CIPHER_NODENAME);
+	if (cipher_node < 0)
+		return 0;
+
+	memset(c, 0, sizeof(*c));
+	algo = fdt_getprop(fit, cipher_node, FIT_ALGO_PROP, NULL);
+	hint = fdt_getprop(fit, cipher_node, FIT_CIPHER_KEY_HINT_PROP, NULL);
+	if (!algo || !hint) {
+		debug("%s: no algo or key name\n", __func__);
+		return -EINVAL;
+	}
+
+	if (!strcmp(algo, "aes128"))
+		c->ctx.key_len = 16;
+	else if (!strcmp(algo, "aes192"))
+		c->ctx.key_len = 24;
+	else if (!strcmp(algo, "aes256"))
+		c->ctx.key_len = 32;
+	else
+		return -EPROTONOSUPPORT;
+
+	mode = fdt_getprop(fit, cipher_node, "mode", NULL);
+	if (!mode || !strcmp(mode, "cbc"))
+		c->ctx.mode = RK_MODE_CBC;
+	else if (!strcmp(mode, "xts") && c->ctx.key_len != 24)
+		c->ctx.mode = RK_MODE_XTS;
+	else
+		return -EPROTONOSUPPORT;
+
+	if (fit_image_get_data_size(fit, noffset, &size) || size <= 0)
+		return -EINVAL;
+	unciphered = fdtdec_get_int(fit, noffset, FIT_DATA_SIZE_UNCIPHERED_PROP,
+				    size);
+	if (unciphered <= 0 || unciphered > size)
+		return -EINVAL;
+	if (c->ctx.mode == RK_MODE_CBC) {
+		if (size % FIT_CIPHER_BLOCK_SIZE)
+			return -EINVAL;
+	} else if (size % FIT_CIPHER_XTS_UNIT &&
+		   size % FIT_CIPHER_XTS_UNIT < FIT_CIPHER_BLOCK_SIZE) {
+		/* XTS needs at least a block in the last unit */
+		return -EINVAL;
+	}
+	c->size = size;
+	c->size_unciphered = unciphered;
+
+	snprintf(path, sizeof(path), "/%s/key-%s-%s", FIT_CIPHER_NODENAME,
+		 algo, hint);
+	key_node = fdt_path_offset(key_blob, path);
+	if (key_node < 0) {
+		printf("No key %s\n", path);
+		return -ENOENT;
+	}
+
+	ret = fit_cipher_get_key(key_blob, key_node, "key", c->key,
+				 c->ctx.key_len);
+	if (!ret && c->ctx.mode == RK_MODE_XTS)
+		ret = fit_cipher_get_key(key_blob, key_node, "twk-key",
+					 c->twk_key, c->ctx.key_len);
+	/* An IV in the image overrides the one of the key */
+	if (!ret && c->ctx.mode == RK_MODE_CBC &&
+	    fit_cipher_get_key(fit, cipher_node, "iv", c->iv,
+			       FIT_CIPHER_BLOCK_SIZE))
+		ret = fit_cipher_get_key(key_blob, key_node, "iv", c->iv,
+					 FIT_CIPHER_BLOCK_SIZE);
+	if (ret) {
+		printf("Bad key %s\n", path);
+		return ret;
+	}
+
+	c->ctx.algo = CRYPTO_AES;
+	c->ctx.key = c->key;
+	c->ctx.twk_key = c->twk_key;
+	c->ctx.iv = c->iv;
+	c->ctx.iv_len = FIT_CIPHER_BLOCK_SIZE;
+
+	c->dev = crypto_get_device(CRYPTO_AES);
+	if (!c->dev) {
+		printf("No crypto device for AES\n");
+		return -ENODEV;
+	}
+
+	return 1;
+}
+
+/* XTS: one call per data unit, the tweak is the unit number */
+static int fit_decrypt_xts(struct fit_cipher *c, u8 *data, size_t end)
+{
+	size_t len;
+	u64 unit;
+	int ret;
+
+	while (c->done < end) {
+		len = min_t(size_t, end - c->done, FIT_CIPHER_XTS_UNIT);
+		unit = c->done / FIT_CIPHER_XTS_UNIT;
+		memset(c->iv, 0, sizeof(c->iv));
+		put_unaligned_le64(unit, c->iv);
+
+		ret = crypto_cipher(c->dev, &c->ctx, data + c->done,
+				    data + c->done, len, false);
+		if (ret)
+			return ret;
+		c->done += len;
+	}
+
+	return 0;
+}
+
+/* CBC: the last encrypted block is the IV of the next call */
+static int fit_decrypt_cbc(struct fit_cipher *c, u8 *data, size_t end)
+{
+	u8 next_iv[FIT_CIPHER_BLOCK_SIZE];
+	int ret;
+
+	if (end == c->done)
+		return 0;
+
+	memcpy(next_iv, data + end - FIT_CIPHER_BLOCK_SIZE, sizeof(next_iv));
+	ret = crypto_cipher(c->dev, &c->ctx, data + c->done, data + c->done,
+			    end - c->done, false);
+	if (ret)
+		return ret;
+	memcpy(c->iv, next_iv, sizeof(c->iv));
+	c->done = end;
+
+	return 0;
+}
+
+int fit_image_decrypt(struct fit_cipher *c, u8 *data, size_t avail)
+{
+	size_t step, end;
+
+	step = c->ctx.mode == RK_MODE_XTS ? FIT_CIPHER_XTS_UNIT :
+					    FIT_CIPHER_BLOCK_SIZE;
+	if (avail >= c->size)
+		end = c->size;
+	else
+		end = avail - avail % step;
+
+	if (end <= c->done)
+		return 0;
+
+	if (c->ctx.mode == RK_MODE_XTS)
+		return fit_decrypt_xts(c, data, end);
+
+	return fit_decrypt_cbc(c, data, end);
+}
@@ -21,6 +21,7 @@
 #include <asm/io.h>
 #include <malloc.h>
 #include <crypto.h>
+#include <image-pipe.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 #endif /* !USE_HOSTCC*/
@@ -1329,6 +1330,17 @@ int fit_image_check_hash(const void *fit, int noffset, const void *data,
 		return -1;
 	}
 
+#ifndef USE_HOSTCC
+	if ((CONFIG_IS_ENABLED(IMAGE_PIPE) &&
+	     img_pipe_hash_verified(data, size, algo, fit_value,
+				    fit_value_len)) ||
+	    board_fit_hash_verified(data, size, algo, fit_value,
+				    fit_value_len)) {
+		printf("-cached ");
+		return 0;
+	}
+#endif
+
 	if (calculate_hash(data, size, algo, value, &value_len)) {
 		*err_msgp = "Unsupported hash algorithm";
 		return -1;
@@ -2021,6 +2033,13 @@ __weak int fit_board_verify_required_sigs(void)
 {
 	return 0;
 }
+
+__weak int board_fit_hash_verified(const void *data, size_t size,
+				   const char *algo, const uint8_t *value,
+				   int value_len)
+{
+	return 0;
+}
 #endif
 
 int fit_image_load_index(bootm_headers_t *images, ulong addr,
@@ -2096,7 +2115,11 @@ int fit_image_load_index(bootm_headers_t *images, ulong addr,
 			images->fit_uname_cfg = fit_base_uname_config;
 			if (IMAGE_ENABLE_VERIFY) {
 				puts("   Verifying Hash Integrity ... ");
-				if (fit_config_verify(fit, cfg_noffset)) {
+				bootstage_start(BOOTSTAGE_ID_ACCUM_VERIFY,
+						"verify");
+				ret = fit_config_verify(fit, cfg_noffset);
+				bootstage_accum(BOOTSTAGE_ID_ACCUM_VERIFY);
+				if (ret) {
 					puts("Bad Data Hash\n");
 					bootstage_error(bootstage_id +
 						BOOTSTAGE_SUB_HASH);
@@ -2137,7 +2160,9 @@ int fit_image_load_index(bootm_headers_t *images, ulong addr,
 
 	printf("   Trying '%s' %s subimage\n", fit_uname, prop_name);
 
+	bootstage_start(BOOTSTAGE_ID_ACCUM_VERIFY, "verify");
 	ret = fit_image_select(fit, noffset, images->verify);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_VERIFY);
 	if (ret) {
 		bootstage_error(bootstage_id + BOOTSTAGE_SUB_HASH);
 		return ret;
@@ -2265,7 +2290,9 @@ int fit_image_load_index(bootm_headers_t *images, ulong addr,
 		       prop_name, data, load);
 
 		dst = map_sysmem(load, len);
-		memmove(dst, buf, len);
+		/* The board may have put the data in place already */
+		if (dst != buf)
+			memmove(dst, buf, len);
 		data = load;
 	}
 	bootstage_mark(bootstage_id + BOOTSTAGE_SUB_LOAD);
@@ -0,0 +1,260 @@
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ *
+ * Image pipelines: stages which each take a pass over image data, run
+ * chunk by chunk while the data is read so that each chunk goes through
+ * all of them while it is still in the cache.
+ */
+
+#include <common.h>
+#include <crypto.h>
+#include <errno.h>
+#include <image.h>
+#include <image-cipher.h>
+#include <image-pipe.h>
+
+void img_pipe_init(struct img_pipe *p, void *data, size_t total)
+{
+	memset(p, 0, sizeof(*p));
+	p->data = data;
+	p->total = total;
+}
+
+int img_pipe_add(struct img_pipe *p, struct img_stage *st)
+{
+	if (p->count >= IMG_PIPE_STAGES)
+		return -ENOSPC;
+
+	st->done = 0;
+	st->skip = false;
+	p->stages[p->count++] = st;
+
+	return 0;
+}
+
+int img_pipe_feed(struct img_pipe *p, size_t avail)
+{
+	struct img_stage *st;
+	int i, ret;
+
+	avail = min(avail, p->total);
+	for (i = 0; i < p->count; i++) {
+		st = p->stages[i];
+		if (!st->skip && avail > st->done) {
+			ret = st->feed(st, p->data, avail, p->total);
+			if (ret == IMG_STAGE_SKIP) {
+				debug("%s: %s left the pipeline\n", __func__,
+				      st->name);
+				st->skip = true;
+			} else if (ret) {
+				return ret;
+			}
+		}
+		if (st->skip)
+			st->done = avail;
+
+		/* The next stage can't go further than this one */
+		avail = min(avail, st->done);
+	}
+
+	return 0;
+}
+
+int img_pipe_finish(struct img_pipe *p)
+{
+	struct img_stage *st;
+	int i, ret;
+
+	ret = img_pipe_feed(p, p->total);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < p->count; i++) {
+		st = p->stages[i];
+		if (st->skip)
+			continue;
+		if (st->done != p->total)
+			return -EIO;
+		if (st->finish) {
+			ret = st->finish(st, p->data, p->total);
+			if (ret)
+				return ret;
+		}
+	}
+
+	return 0;
+}
+
+void img_pipe_abort(struct img_pipe *p)
+{
+	struct img_stage *st;
+	int i;
+
+	for (i = 0; i < p->count; i++) {
+		st = p->stages[i];
+		if (!st->skip && st->done && st->abort)
+			st->abort(st);
+		st->skip = true;
+	}
+}
+
+static int img_hash_feed(struct img_stage *st, u8 *data, size_t avail,
+			 size_t total)
+{
+	struct img_hash_stage *h = container_of(st, struct img_hash_stage, st);
+	size_t len;
+
+	len = min(avail, h->size) - min(st->done, h->size);
+	st->done = avail;
+	if (!len)
+		return 0;
+
+#if CONFIG_IS_ENABLED(FIT_HW_CRYPTO)
+	if (crypto_sha_update(h->dev, (u32 *)(data + avail - len), len))
+		return -EIO;
+#else
+	if (h->value_len == SHA256_SUM_LEN)
+		sha256_update(&h->ctx.sha256, data + avail - len, len);
+	else
+		sha1_update(&h->ctx.sha1, data + avail - len, len);
+#endif
+
+	return 0;
+}
+
+static int img_hash_finish(struct img_stage *st, u8 *data, size_t total)
+{
+	struct img_hash_stage *h = container_of(st, struct img_hash_stage, st);
+
+#if CONFIG_IS_ENABLED(FIT_HW_CRYPTO)
+	if (crypto_sha_final(h->dev, &h->ctx, h->value))
+		return -EIO;
+#else
+	if (h->value_len == SHA256_SUM_LEN)
+		sha256_finish(&h->ctx.sha256, h->value);
+	else
+		sha1_finish(&h->ctx.sha1, h->value);
+#endif
+
+	return 0;
+}
+
+int img_hash_stage_init(struct img_hash_stage *h, const char *algo,
+			size_t size)
+{
+	memset(h, 0, sizeof(*h));
+	h->st.name = "hash";
+	h->st.feed = img_hash_feed;
+	h->st.finish = img_hash_finish;
+	h->algo = algo;
+	h->size = size;
+
+#if CONFIG_IS_ENABLED(FIT_HW_CRYPTO)
+	if (!strcmp(algo, "sha256")) {
+		h->ctx.algo = CRYPTO_SHA256;
+		h->value_len = SHA256_SUM_LEN;
+	} else if (!strcmp(algo, "sha1")) {
+		h->ctx.algo = CRYPTO_SHA1;
+		h->value_len = SHA1_SUM_LEN;
+	} else {
+		return -EPROTONOSUPPORT;
+	}
+
+	h->dev = crypto_get_device(h->ctx.algo);
+	if (!h->dev)
+		return -ENODEV;
+	h->ctx.length = size;
+
+	return crypto_sha_init(h->dev, &h->ctx);
+#else
+	if (IS_ENABLED(CONFIG_SHA256) && !strcmp(algo, "sha256")) {
+		sha256_starts(&h->ctx.sha256);
+		h->value_len = SHA256_SUM_LEN;
+	} else if (IS_ENABLED(CONFIG_SHA1) && !strcmp(algo, "sha1")) {
+		sha1_starts(&h->ctx.sha1);
+		h->value_len = SHA1_SUM_LEN;
+	} else {
+		return -EPROTONOSUPPORT;
+	}
+
+	return 0;
+#endif
+}
+
+/* Hashes taken by stages, waiting for the image to be verified */
+static struct {
+	const void *data;
+	size_t size;
+	const char *algo;
+	u8 value[FIT_MAX_HASH_LEN];
+	int value_len;
+} img_hash_records[IMG_PIPE_STAGES];
+static int img_hash_next;
+
+void img_hash_stage_record(const struct img_hash_stage *h, const void *data,
+			   size_t size)
+{
+	int i = img_hash_next++ % ARRAY_SIZE(img_hash_records);
+
+	img_hash_records[i].data = data;
+	img_hash_records[i].size = size;
+	img_hash_records[i].algo = h->algo;
+	img_hash_records[i].value_len = h->value_len;
+	memcpy(img_hash_records[i].value, h->value, h->value_len);
+}
+
+int img_pipe_hash_verified(const void *data, size_t size, const char *algo,
+			   const uint8_t *value, int value_len)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(img_hash_records); i++) {
+		if (!img_hash_records[i].data ||
+		    img_hash_records[i].data != data ||
+		    img_hash_records[i].size != size ||
+		    strcmp(img_hash_records[i].algo, algo) ||
+		    img_hash_records[i].value_len != value_len ||
+		    memcmp(img_hash_records[i].value, value, value_len))
+			continue;
+
+		/* The data may change once it is verified */
+		img_hash_records[i].data = NULL;
+		return 1;
+	}
+
+	return 0;
+}
+
+#if CONFIG_IS_ENABLED(FIT_CIPHER)
+static int img_cipher_feed(struct img_stage *st, u8 *data, size_t avail,
+			   size_t total)
+{
+	struct img_cipher_stage *c = container_of(st, struct img_cipher_stage,
+						  st);
+	int ret;
+
+	ret = fit_image_decrypt(&c->cipher, data, avail);
+	st->done = c->cipher.done;
+
+	return ret;
+}
+
+int img_cipher_stage_init(struct img_cipher_stage *c, const void *fit,
+			  int noffset, const void *key_blob)
+{
+	memset(&c->st, 0, sizeof(c->st));
+	c->st.name = "cipher";
+	c->st.feed = img_cipher_feed;
+
+	return fit_image_cipher_init(fit, noffset, key_blob, &c->cipher);
+}
+#else
+int img_cipher_stage_init(struct img_cipher_stage *c, const void *fit,
+			  int noffset, const void *key_blob)
+{
+	return fdt_subnode_offset(fit, noffset, FIT_CIPHER_NODENAME) < 0 ?
+	       0 : -EPROTONOSUPPORT;
+}
+#endif
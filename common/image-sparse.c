@@ -39,6 +39,7 @@
 #include <image-sparse.h>
 #include <div64.h>
 #include <malloc.h>
+#include <arena.h>
 #include <part.h>
 #include <sparse_format.h>
 #include <fastboot.h>
@@ -46,12 +47,115 @@
 #include <linux/math64.h>
 
 #ifndef CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE
-#define CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE (1024 * 512)
+#define CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE (1024 * 1024 * 4)
 #endif
 
-void write_sparse_image(
-		struct sparse_storage *info, const char *part_name,
-		void *data, unsigned sz, char *response)
+#if CONFIG_IS_ENABLED(ARENA)
+/* Kept across images, a fastboot session flashes one after another */
+static struct arena *sparse_fill_arena;
+#endif
+
+/* One buffer for all FILL chunks, smaller ones if memory is short */
+static uint32_t *sparse_alloc_fill_buf(lbaint_t blksz, int *num_blks)
+{
+	uint32_t *buf;
+	int n;
+
+#if CONFIG_IS_ENABLED(ARENA)
+	if (!sparse_fill_arena)
+		sparse_fill_arena = arena_create("sparse-fill",
+					CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE);
+	n = CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE / blksz;
+	buf = arena_alloc(sparse_fill_arena, blksz * n);
+	if (buf) {
+		*num_blks = n;
+		return buf;
+	}
+#endif
+	for (n = CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE / blksz; n; n /= 2) {
+		buf = memalign(ARCH_DMA_MINALIGN,
+			       ROUNDUP(blksz * n, ARCH_DMA_MINALIGN));
+		if (buf) {
+			*num_blks = n;
+			return buf;
+		}
+	}
+
+	return NULL;
+}
+
+static void sparse_free_fill_buf(uint32_t *buf)
+{
+#if CONFIG_IS_ENABLED(ARENA)
+	if (arena_owns(sparse_fill_arena, buf)) {
+		arena_reset(sparse_fill_arena);
+		return;
+	}
+#endif
+	free(buf);
+}
+
+static int sparse_write_fill(struct sparse_storage *info, lbaint_t *blk,
+			     lbaint_t blkcnt, const uint32_t *fill_buf,
+			     int fill_buf_num_blks)
+{
+	lbaint_t blks;
+	lbaint_t i;
+	lbaint_t j;
+
+	for (i = 0; i < blkcnt; i += j) {
+		j = min_t(lbaint_t, blkcnt - i, fill_buf_num_blks);
+		blks = info->write(info, *blk, j, fill_buf);
+		/* blks might be > j (eg. NAND bad-blocks) */
+		if (blks < j) {
+			printf("%s: %s " LBAFU " [" LBAFU "]\n", __func__,
+			       "Write failed, block #", *blk, j);
+			return -EIO;
+		}
+		*blk += blks;
+	}
+
+	return 0;
+}
+
+/*
+ * Zero whole erase groups by erasing them, which is much quicker than
+ * writing zeros, and write the partial groups at either end.
+ */
+static int sparse_erase_zero(struct sparse_storage *info, lbaint_t *blk,
+			     lbaint_t blkcnt, const uint32_t *fill_buf,
+			     int fill_buf_num_blks)
+{
+	lbaint_t grp = info->erase_grp;
+	lbaint_t head, mid;
+	u32 rem;
+
+	div_u64_rem(*blk, grp, &rem);
+	head = rem ? grp - rem : 0;
+	if (head >= blkcnt)
+		return sparse_write_fill(info, blk, blkcnt, fill_buf,
+					 fill_buf_num_blks);
+
+	div_u64_rem(blkcnt - head, grp, &rem);
+	mid = blkcnt - head - rem;
+	if (!mid)
+		return sparse_write_fill(info, blk, blkcnt, fill_buf,
+					 fill_buf_num_blks);
+
+	if (sparse_write_fill(info, blk, head, fill_buf, fill_buf_num_blks))
+		return -EIO;
+
+	if (info->erase(info, *blk, mid) == mid)
+		*blk += mid;
+	else if (sparse_write_fill(info, blk, mid, fill_buf,
+				   fill_buf_num_blks))
+		return -EIO;
+
+	return sparse_write_fill(info, blk, rem, fill_buf, fill_buf_num_blks);
+}
+
+int sparse_write(struct sparse_storage *info, void *data, u64 *written,
+		 const char **reason)
 {
 	lbaint_t blk;
 	lbaint_t blkcnt;
@@ -61,15 +165,15 @@ void write_sparse_image(
 	unsigned int offset;
 	uint64_t chunk_data_sz;
 	uint32_t *fill_buf = NULL;
+	uint32_t fill_buf_val = 0;
 	uint32_t fill_val;
 	sparse_header_t *sparse_header;
 	chunk_header_t *chunk_header;
 	uint32_t total_blocks = 0;
-	int fill_buf_num_blks;
+	int fill_buf_num_blks = 0;
 	int i;
-	int j;
-
-	fill_buf_num_blks = CONFIG_FASTBOOT_FLASH_FILLBUF_SIZE / info->blksz;
+	int err = -EINVAL;
+	int ret;
 
 	/* Read and skip over sparse image header */
 	sparse_header = (sparse_header_t *)data;
@@ -101,12 +205,10 @@ void write_sparse_image(
 	if (offset) {
 		printf("%s: Sparse image block size issue [%u]\n",
 		       __func__, sparse_header->blk_sz);
-		fastboot_fail("sparse image block size issue", response);
-		return;
+		*reason = "sparse image block size issue";
+		return -EINVAL;
 	}
 
-	puts("Flashing Sparse Image\n");
-
 	/* Start processing chunks */
 	blk = info->start;
 	for (chunk = 0; chunk < sparse_header->total_chunks; chunk++) {
@@ -136,18 +238,16 @@ void write_sparse_image(
 		case CHUNK_TYPE_RAW:
 			if (chunk_header->total_sz !=
 			    (sparse_header->chunk_hdr_sz + chunk_data_sz)) {
-				fastboot_fail(
-					"Bogus chunk size for chunk type Raw", response);
-				return;
+				*reason = "Bogus chunk size for chunk type Raw";
+				goto out;
 			}
 
 			if (blk + blkcnt > info->start + info->size) {
 				printf(
 				    "%s: Request would exceed partition size!\n",
 				    __func__);
-				fastboot_fail(
-				    "Request would exceed partition size!", response);
-				return;
+				*reason = "Request would exceed partition size!";
+				goto out;
 			}
 
 			blks = info->write(info, blk, blkcnt, data);
@@ -156,9 +256,9 @@ void write_sparse_image(
 				printf("%s: %s" LBAFU " [" LBAFU "]\n",
 				       __func__, "Write failed, block #",
 				       blk, blks);
-				fastboot_fail(
-					      "flash write failure", response);
-				return;
+				*reason = "flash write failure";
+				err = -EIO;
+				goto out;
 			}
 			blk += blks;
 			bytes_written += ((u64)blkcnt) * info->blksz;
@@ -169,63 +269,57 @@ void write_sparse_image(
 		case CHUNK_TYPE_FILL:
 			if (chunk_header->total_sz !=
 			    (sparse_header->chunk_hdr_sz + sizeof(uint32_t))) {
-				fastboot_fail(
-					"Bogus chunk size for chunk type FILL", response);
-				return;
-			}
-
-			fill_buf = (uint32_t *)
-				   memalign(ARCH_DMA_MINALIGN,
-					    ROUNDUP(
-						info->blksz * fill_buf_num_blks,
-						ARCH_DMA_MINALIGN));
-			if (!fill_buf) {
-				fastboot_fail(
-					"Malloc failed for: CHUNK_TYPE_FILL", response);
-				return;
+				*reason = "Bogus chunk size for chunk type FILL";
+				goto out;
 			}
 
 			fill_val = *(uint32_t *)data;
 			data = (char *)data + sizeof(uint32_t);
 
-			for (i = 0;
-			     i < (info->blksz * fill_buf_num_blks /
-				  sizeof(fill_val));
-			     i++)
-				fill_buf[i] = fill_val;
-
 			if (blk + blkcnt > info->start + info->size) {
 				printf(
 				    "%s: Request would exceed partition size!\n",
 				    __func__);
-				fastboot_fail(
-				    "Request would exceed partition size!", response);
-				return;
+				*reason = "Request would exceed partition size!";
+				goto out;
 			}
 
-			for (i = 0; i < blkcnt;) {
-				j = blkcnt - i;
-				if (j > fill_buf_num_blks)
-					j = fill_buf_num_blks;
-				blks = info->write(info, blk, j, fill_buf);
-				/* blks might be > j (eg. NAND bad-blocks) */
-				if (blks < j) {
-					printf("%s: %s " LBAFU " [%d]\n",
-					       __func__,
-					       "Write failed, block #",
-					       blk, j);
-					fastboot_fail(
-						      "flash write failure", response);
-					free(fill_buf);
-					return;
+			if (!fill_buf) {
+				fill_buf = sparse_alloc_fill_buf(info->blksz,
+							&fill_buf_num_blks);
+				if (!fill_buf) {
+					*reason = "Malloc failed for: CHUNK_TYPE_FILL";
+					err = -ENOMEM;
+					goto out;
 				}
-				blk += blks;
-				i += j;
+				fill_buf_val = ~fill_val;
+			}
+
+			if (fill_buf_val != fill_val) {
+				for (i = 0;
+				     i < (info->blksz * fill_buf_num_blks /
+					  sizeof(fill_val));
+				     i++)
+					fill_buf[i] = fill_val;
+				fill_buf_val = fill_val;
+			}
+
+			if (!fill_val && info->erase && info->erase_grp)
+				ret = sparse_erase_zero(info, &blk, blkcnt,
+							fill_buf,
+							fill_buf_num_blks);
+			else
+				ret = sparse_write_fill(info, &blk, blkcnt,
+							fill_buf,
+							fill_buf_num_blks);
+			if (ret) {
+				*reason = "flash write failure";
+				err = -EIO;
+				goto out;
 			}
 			bytes_written += ((u64)blkcnt) * info->blksz;
 			total_blocks += DIV_ROUND_UP_ULL(chunk_data_sz,
 							 sparse_header->blk_sz);
-			free(fill_buf);
 			break;
 
 		case CHUNK_TYPE_DONT_CARE:
@@ -236,9 +330,8 @@ void write_sparse_image(
 		case CHUNK_TYPE_CRC32:
 			if (chunk_header->total_sz !=
 			    sparse_header->chunk_hdr_sz) {
-				fastboot_fail(
-					"Bogus chunk size for chunk type Dont Care", response);
-				return;
+				*reason = "Bogus chunk size for chunk type Dont Care";
+				goto out;
 			}
 			total_blocks += chunk_header->chunk_sz;
 			data += chunk_data_sz;
@@ -247,19 +340,44 @@ void write_sparse_image(
 		default:
 			printf("%s: Unknown chunk type: %x\n", __func__,
 			       chunk_header->chunk_type);
-			fastboot_fail("Unknown chunk type", response);
-			return;
+			*reason = "Unknown chunk type";
+			goto out;
 		}
 	}
 
 	debug("Wrote %d blocks, expected to write %d blocks\n",
 	      total_blocks, sparse_header->total_blks);
-	printf("........ wrote %llu bytes to '%s'\n", bytes_written, part_name);
+	*written = bytes_written;
+
+	if (total_blocks != sparse_header->total_blks) {
+		*reason = "sparse image write failure";
+		goto out;
+	}
+	err = 0;
+
+out:
+	sparse_free_fill_buf(fill_buf);
+
+	return err;
+}
+
+void write_sparse_image(
+		struct sparse_storage *info, const char *part_name,
+		void *data, unsigned sz, char *response)
+{
+	const char *reason = NULL;
+	u64 written = 0;
+	int ret;
 
-	if (total_blocks != sparse_header->total_blks)
-		fastboot_fail("sparse image write failure", response);
+	puts("Flashing Sparse Image\n");
+
+	ret = sparse_write(info, data, &written, &reason);
+	if (written)
+		printf("........ wrote %llu bytes to '%s'\n", written,
+		       part_name);
+
+	if (ret)
+		fastboot_fail(reason, response);
 	else
 		fastboot_okay("", response);
-
-	return;
 }
@@ -20,6 +20,7 @@
 #include <environment.h>
 #include <image.h>
 #include <mapmem.h>
+#include <mem_large.h>
 
 #if IMAGE_ENABLE_FIT || IMAGE_ENABLE_OF_LIBFDT
 #include <linux/libfdt.h>
@@ -174,6 +175,7 @@ static const table_entry_t uimage_comp[] = {
 	{	IH_COMP_LZMA,	"lzma",		"lzma compressed",	},
 	{	IH_COMP_LZO,	"lzo",		"lzo compressed",	},
 	{	IH_COMP_LZ4,	"lz4",		"lz4 compressed",	},
+	{	IH_COMP_ZSTD,	"zstd",		"zstd compressed",	},
 	{	-1,		"",		"",			},
 };
 
@@ -1203,8 +1205,17 @@ int boot_ramdisk_high(struct lmb *lmb, ulong rd_data, ulong rd_len,
 			printf("   Loading Ramdisk to %08lx, end %08lx ... ",
 					*initrd_start, *initrd_end);
 
-			memmove_wd((void *)*initrd_start,
-					(void *)rd_data, rd_len, CHUNKSZ);
+			/*
+			 * A parallel copy is quick enough not to need the
+			 * watchdog resets; overlapping moves keep them.
+			 */
+			if (*initrd_start + rd_len <= rd_data ||
+			    rd_data + rd_len <= *initrd_start)
+				memcpy_large((void *)*initrd_start,
+					     (void *)rd_data, rd_len);
+			else
+				memmove_wd((void *)*initrd_start,
+					   (void *)rd_data, rd_len, CHUNKSZ);
 
 #ifdef CONFIG_MP
 			/*
@@ -1345,6 +1356,48 @@ static void fit_loadable_process(uint8_t img_type,
 			fit_loadable_handler->handler(img_data, img_len);
 }
 
+int boot_load_loadable(bootm_headers_t *images, uint8_t arch,
+		       const char *uname)
+{
+	ulong tmp_img_addr = map_to_sysmem(images->fit_hdr_os);
+	void *buf = map_sysmem(tmp_img_addr, 0);
+	/*
+	 * These two variables are requirements for fit_image_load, but
+	 * their values are not used
+	 */
+	ulong img_data, img_len;
+	int fit_img_result;
+	uint8_t img_type;
+
+	fit_img_result = fit_image_load(images,
+		tmp_img_addr,
+		&uname,
+		&(images->fit_uname_cfg), arch,
+		IH_TYPE_LOADABLE,
+		BOOTSTAGE_ID_FIT_LOADABLE_START,
+		FIT_LOAD_OPTIONAL_NON_ZERO,
+		&img_data, &img_len);
+	if (fit_img_result < 0) {
+		/* Something went wrong! */
+		return fit_img_result;
+	}
+
+	fit_img_result = fit_image_get_node(buf, uname);
+	if (fit_img_result < 0) {
+		/* Something went wrong! */
+		return fit_img_result;
+	}
+	fit_img_result = fit_image_get_type(buf, fit_img_result, &img_type);
+	if (fit_img_result < 0) {
+		/* Something went wrong! */
+		return fit_img_result;
+	}
+
+	fit_loadable_process(img_type, img_data, img_len);
+
+	return 0;
+}
+
 int boot_get_loadable(int argc, char * const argv[], bootm_headers_t *images,
 		uint8_t arch, const ulong *ld_start, ulong * const ld_len)
 {
@@ -1353,17 +1406,11 @@ int boot_get_loadable(int argc, char * const argv[], bootm_headers_t *images,
 	 * in system memory.
 	 */
 	ulong tmp_img_addr;
-	/*
-	 * These two variables are requirements for fit_image_load, but
-	 * their values are not used
-	 */
-	ulong img_data, img_len;
 	void *buf;
 	int loadables_index;
 	int conf_noffset;
 	int fit_img_result;
 	const char *uname;
-	uint8_t img_type;
 
 	/* Check to see if the images struct has a FIT configuration */
 	if (!genimg_has_config(images)) {
@@ -1390,33 +1437,10 @@ int boot_get_loadable(int argc, char * const argv[], bootm_headers_t *images,
 					NULL), uname;
 		     loadables_index++)
 		{
-			fit_img_result = fit_image_load(images,
-				tmp_img_addr,
-				&uname,
-				&(images->fit_uname_cfg), arch,
-				IH_TYPE_LOADABLE,
-				BOOTSTAGE_ID_FIT_LOADABLE_START,
-				FIT_LOAD_OPTIONAL_NON_ZERO,
-				&img_data, &img_len);
-			if (fit_img_result < 0) {
-				/* Something went wrong! */
-				return fit_img_result;
-			}
-
-			fit_img_result = fit_image_get_node(buf, uname);
-			if (fit_img_result < 0) {
-				/* Something went wrong! */
+			fit_img_result = boot_load_loadable(images, arch,
+							    uname);
+			if (fit_img_result < 0)
 				return fit_img_result;
-			}
-			fit_img_result = fit_image_get_type(buf,
-							    fit_img_result,
-							    &img_type);
-			if (fit_img_result < 0) {
-				/* Something went wrong! */
-				return fit_img_result;
-			}
-
-			fit_loadable_process(img_type, img_data, img_len);
 		}
 		break;
 	default:
@@ -1530,7 +1554,9 @@ int image_setup_linux(bootm_headers_t *images)
 	}
 
 	if (IMAGE_ENABLE_OF_LIBFDT && of_size) {
+		bootstage_start(BOOTSTAGE_ID_ACCUM_FDT_FIXUP, "fdt_fixup");
 		ret = image_setup_libfdt(images, *of_flat_tree, of_size, lmb);
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_FDT_FIXUP);
 		if (ret)
 			return ret;
 	}
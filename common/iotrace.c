@@ -7,6 +7,9 @@
 #define IOTRACE_IMPL
 
 #include <common.h>
+#include <div64.h>
+#include <iotrace.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <asm/io.h>
 
@@ -30,11 +33,18 @@ enum iotrace_flags {
  * @flags: I/O access type
  * @addr: Address of access
  * @value: Value written or read
+ * @time: Timer ticks (get_ticks()) when the access was made
  */
 struct iotrace_record {
 	enum iotrace_flags flags;
 	phys_addr_t addr;
 	iovalue_t value;
+	ulong time;
+};
+
+struct iotrace_filter {
+	phys_addr_t start;
+	phys_addr_t end;
 };
 
 /**
@@ -43,20 +53,48 @@ struct iotrace_record {
  * @start:	Start address of iotrace buffer
  * @size:	Size of iotrace buffer in bytes
  * @offset:	Current write offset into iotrace buffer
+ * @count:	Number of records traced, including any no longer stored
  * @crc32:	Current value of CRC chceksum of trace records
  * @enabled:	true if enabled, false if disabled
+ * @ring:	true to wrap around and overwrite the oldest records when
+ *		the buffer is full, false to stop storing them
+ * @busy:	true while a record is added, so that the accesses of
+ *		get_ticks() are not traced
+ * @nr_filters:	Number of entries in @filter, 0 to trace all addresses
+ * @filter:	Address ranges to trace
  */
 static struct iotrace {
 	ulong start;
 	ulong size;
 	ulong offset;
+	ulong count;
 	u32 crc32;
 	bool enabled;
+	bool ring;
+	bool busy;
+	int nr_filters;
+	struct iotrace_filter filter[IOTRACE_MAX_FILTERS];
 } iotrace;
 
+static bool iotrace_wanted(phys_addr_t addr)
+{
+	int i;
+
+	if (!iotrace.nr_filters)
+		return true;
+	for (i = 0; i < iotrace.nr_filters; i++) {
+		if (addr >= iotrace.filter[i].start &&
+		    addr < iotrace.filter[i].end)
+			return true;
+	}
+
+	return false;
+}
+
 static void add_record(int flags, const void *ptr, ulong value)
 {
 	struct iotrace_record srec, *rec = &srec;
+	phys_addr_t addr;
 
 	/*
 	 * We don't support iotrace before relocation. Since the trace buffer
@@ -64,45 +102,68 @@ static void add_record(int flags, const void *ptr, ulong value)
 	 * this we would need to set the iotrace buffer at build-time. See
 	 * lib/trace.c for how this might be done if you are interested.
 	 */
-	if (!(gd->flags & GD_FLG_RELOC) || !iotrace.enabled)
+	if (!(gd->flags & GD_FLG_RELOC) || !iotrace.enabled || iotrace.busy)
 		return;
 
-	/* Store it if there is room */
-	if (iotrace.offset + sizeof(*rec) < iotrace.size) {
+	addr = map_to_sysmem(ptr);
+	if (!iotrace_wanted(addr))
+		return;
+	iotrace.busy = true;
+
+	/* Store it if there is room, the oldest goes in ring mode */
+	if (iotrace.ring && iotrace.size &&
+	    iotrace.offset + sizeof(*rec) > iotrace.size)
+		iotrace.offset = 0;
+	if (iotrace.offset + sizeof(*rec) <= iotrace.size) {
 		rec = (struct iotrace_record *)map_sysmem(
 					iotrace.start + iotrace.offset,
-					sizeof(value));
+					sizeof(*rec));
 	}
 
 	rec->flags = flags;
-	rec->addr = map_to_sysmem(ptr);
+	rec->addr = addr;
 	rec->value = value;
+	rec->time = get_ticks();
 
-	/* Update our checksum */
+	/* Update our checksum, timestamps would make it differ every run */
 	iotrace.crc32 = crc32(iotrace.crc32, (unsigned char *)rec,
-			      sizeof(*rec));
+			      offsetof(struct iotrace_record, time));
 
 	iotrace.offset += sizeof(struct iotrace_record);
+	iotrace.count++;
+	iotrace.busy = false;
 }
 
+/*
+ * Without a buffer to trace to, each 32-bit access is also printed, before
+ * and after, to find the one which hangs the bus.
+ */
 u32 iotrace_readl(const void *ptr)
 {
+	bool print = !iotrace.size;
 	u32 v;
 
-	printf("[iotrace]: read  addr 0x%08lx... ", (ulong)ptr);
+	if (print)
+		printf("[iotrace]: read  addr 0x%08lx... ", (ulong)ptr);
 	v = readl(ptr);
 	add_record(IOT_32 | IOT_READ, ptr, v);
-	printf("OK\n");
+	if (print)
+		printf("OK\n");
 
 	return v;
 }
 
 void iotrace_writel(ulong value, const void *ptr)
 {
-	printf("[iotrace]: write addr 0x%08lx value 0x%08lx... ", (ulong)ptr, value);
+	bool print = !iotrace.size;
+
+	if (print)
+		printf("[iotrace]: write addr 0x%08lx value 0x%08lx... ",
+		       (ulong)ptr, value);
 	add_record(IOT_32 | IOT_WRITE, ptr, value);
 	writel(value, ptr);
-	printf("OK\n");
+	if (print)
+		printf("OK\n");
 }
 
 u16 iotrace_readw(const void *ptr)
@@ -157,11 +218,51 @@ int iotrace_get_enabled(void)
 	return iotrace.enabled;
 }
 
+void iotrace_set_ring(int ring)
+{
+	iotrace.ring = ring;
+}
+
+int iotrace_get_ring(void)
+{
+	return iotrace.ring;
+}
+
+int iotrace_add_filter(ulong start, ulong size)
+{
+	if (iotrace.nr_filters == IOTRACE_MAX_FILTERS)
+		return -ENOSPC;
+	if (!size)
+		return -EINVAL;
+
+	iotrace.filter[iotrace.nr_filters].start = start;
+	iotrace.filter[iotrace.nr_filters].end = start + size;
+	iotrace.nr_filters++;
+
+	return 0;
+}
+
+void iotrace_clear_filters(void)
+{
+	iotrace.nr_filters = 0;
+}
+
+void iotrace_print_filters(void)
+{
+	int i;
+
+	for (i = 0; i < iotrace.nr_filters; i++)
+		printf("Filter: %08llx-%08llx\n",
+		       (unsigned long long)iotrace.filter[i].start,
+		       (unsigned long long)iotrace.filter[i].end);
+}
+
 void iotrace_set_buffer(ulong start, ulong size)
 {
 	iotrace.start = start;
 	iotrace.size = size;
 	iotrace.offset = 0;
+	iotrace.count = 0;
 	iotrace.crc32 = 0;
 }
 
@@ -170,5 +271,140 @@ void iotrace_get_buffer(ulong *start, ulong *size, ulong *offset, ulong *count)
 	*start = iotrace.start;
 	*size = iotrace.size;
 	*offset = iotrace.offset;
-	*count = iotrace.offset / sizeof(struct iotrace_record);
+	*count = iotrace.count;
+}
+
+/* The stored record @n, counting from the oldest */
+static struct iotrace_record *iotrace_get_record(ulong n)
+{
+	ulong nr = iotrace.size / sizeof(struct iotrace_record);
+	ulong first = 0;
+
+	if (iotrace.ring && iotrace.count > nr)
+		first = iotrace.offset / sizeof(struct iotrace_record);
+
+	return (struct iotrace_record *)map_sysmem(iotrace.start +
+			((first + n) % nr) * sizeof(struct iotrace_record),
+			sizeof(struct iotrace_record));
+}
+
+/**
+ * struct iotrace_reg - Accesses of one register, for iotrace_print_summary()
+ *
+ * @addr: Address of the register
+ * @reads: Number of reads
+ * @writes: Number of writes
+ * @polls: Reads which returned the same value as the read just before
+ * @poll_ticks: Time from each of those reads to the one before
+ */
+struct iotrace_reg {
+	phys_addr_t addr;
+	ulong reads;
+	ulong writes;
+	ulong polls;
+	u64 poll_ticks;
+};
+
+#define IOTRACE_SUMMARY_REGS	1024	/* hash table size, a power of 2 */
+
+static struct iotrace_reg *iotrace_find_reg(struct iotrace_reg *regs,
+					    phys_addr_t addr)
+{
+	uint i = (addr >> 2) * 2654435761U;
+	int n;
+
+	for (n = 0; n < IOTRACE_SUMMARY_REGS; n++, i++) {
+		struct iotrace_reg *reg = &regs[i % IOTRACE_SUMMARY_REGS];
+
+		if (!reg->reads && !reg->writes) {
+			reg->addr = addr;
+			return reg;
+		}
+		if (reg->addr == addr)
+			return reg;
+	}
+
+	return NULL;
+}
+
+static int iotrace_cmp_accesses(const void *a, const void *b)
+{
+	const struct iotrace_reg *x = a, *y = b;
+	ulong nx = x->reads + x->writes, ny = y->reads + y->writes;
+
+	return nx < ny ? 1 : -(nx > ny);
+}
+
+static int iotrace_cmp_polls(const void *a, const void *b)
+{
+	const struct iotrace_reg *x = a, *y = b;
+
+	return x->poll_ticks < y->poll_ticks ? 1 :
+		-(x->poll_ticks > y->poll_ticks);
+}
+
+void iotrace_print_summary(int top)
+{
+	ulong nr = min(iotrace.count,
+		       iotrace.size / sizeof(struct iotrace_record));
+	struct iotrace_record *rec, *prev = NULL;
+	struct iotrace_reg *regs, *reg;
+	ulong n, lost = 0;
+	int i;
+
+	if (!nr) {
+		printf("No records\n");
+		return;
+	}
+	regs = calloc(IOTRACE_SUMMARY_REGS, sizeof(*regs));
+	if (!regs) {
+		printf("No memory for the summary\n");
+		return;
+	}
+
+	for (n = 0; n < nr; n++, prev = rec) {
+		rec = iotrace_get_record(n);
+		reg = iotrace_find_reg(regs, rec->addr);
+		if (!reg) {
+			lost++;
+			continue;
+		}
+		if (rec->flags & IOT_WRITE) {
+			reg->writes++;
+			continue;
+		}
+		reg->reads++;
+		/* Reading the same register again for the same value */
+		if (prev && !(prev->flags & IOT_WRITE) &&
+		    prev->addr == rec->addr && prev->value == rec->value) {
+			reg->polls++;
+			reg->poll_ticks += rec->time - prev->time;
+		}
+	}
+
+	printf("%lu records, from %lu us\n", nr,
+	       (ulong)lldiv((u64)(rec->time - iotrace_get_record(0)->time) *
+			    1000000, get_tbclk()));
+	if (lost)
+		printf("%lu records of registers beyond the first %d left out\n",
+		       lost, IOTRACE_SUMMARY_REGS);
+
+	printf("\nMost accessed:\n%-18s %10s %10s\n", "Address", "Reads",
+	       "Writes");
+	qsort(regs, IOTRACE_SUMMARY_REGS, sizeof(*regs), iotrace_cmp_accesses);
+	for (i = 0; i < top && (regs[i].reads || regs[i].writes); i++)
+		printf("%018llx %10lu %10lu\n",
+		       (unsigned long long)regs[i].addr, regs[i].reads,
+		       regs[i].writes);
+
+	printf("\nLongest polled:\n%-18s %10s %10s\n", "Address", "Polls",
+	       "Time(us)");
+	qsort(regs, IOTRACE_SUMMARY_REGS, sizeof(*regs), iotrace_cmp_polls);
+	for (i = 0; i < top && regs[i].polls; i++)
+		printf("%018llx %10lu %10lu\n",
+		       (unsigned long long)regs[i].addr, regs[i].polls,
+		       (ulong)lldiv(regs[i].poll_ticks * 1000000,
+				    get_tbclk()));
+
+	free(regs);
 }
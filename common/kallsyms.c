@@ -7,8 +7,11 @@
 
 #include <common.h>
 
-/* We need the weak marking as this symbol is provided specially */
-extern const char system_map[] __attribute__((weak));
+/* We need the weak marking as these symbols are provided specially */
+extern const unsigned int kallsyms_num __attribute__((weak));
+extern const unsigned long kallsyms_addrs[] __attribute__((weak));
+extern const unsigned int kallsyms_offs[] __attribute__((weak));
+extern const char kallsyms_names[] __attribute__((weak));
 
 /* Given an address, return a pointer to the symbol name and store
  * the base address in caddr.  So if the symbol map had an entry:
@@ -22,23 +25,27 @@ extern const char system_map[] __attribute__((weak));
  */
 const char *symbol_lookup(unsigned long addr, unsigned long *caddr)
 {
-	const char *sym, *csym;
-	char *esym;
-	unsigned long sym_addr;
+	unsigned int lo = 0, hi, mid;
 
-	sym = system_map;
-	csym = NULL;
 	*caddr = 0;
 
-	while (*sym) {
-		sym_addr = simple_strtoul(sym, &esym, 16);
-		sym = esym;
-		if (sym_addr > addr)
-			break;
-		*caddr = sym_addr;
-		csym = sym;
-		sym += strlen(sym) + 1;
+	/* Not there on the first link */
+	if (!&kallsyms_num)
+		return NULL;
+
+	/* The last symbol at or below @addr */
+	hi = kallsyms_num;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (kallsyms_addrs[mid] <= addr)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
+	if (!lo)
+		return NULL;
+
+	*caddr = kallsyms_addrs[lo - 1];
 
-	return csym;
+	return kallsyms_names + kallsyms_offs[lo - 1];
 }
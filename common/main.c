@@ -12,6 +12,7 @@
 #include <cli.h>
 #include <console.h>
 #include <version.h>
+#include <dm/root.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -65,6 +66,9 @@ void main_loop(void)
 
 	autoboot_command(s);
 
+	/* Not booting, so bring up what was left for later */
+	dm_probe_deferred();
+
 	cli_loop();
 	panic("No CLI available");
 }
@@ -0,0 +1,242 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd
+ *
+ * Records, per malloc() call site, how many bytes are live and the most
+ * that ever were, to size CONFIG_SYS_MALLOC_LEN from data. Only the full
+ * dlmalloc after relocation is tracked: malloc_f before it is never freed,
+ * and its tables would have nowhere to live.
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <malloc_track.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define MALLOC_TRACK_SITES	256	/* power of 2 */
+#define MALLOC_TRACK_ALLOCS	4096	/* power of 2 */
+#define MALLOC_TRACK_CLASSES	16	/* up to 16B << 14, and larger */
+
+struct malloc_site {
+	ulong caller;
+	ulong calls;
+	ulong live;
+	ulong peak;
+	ulong live_cnt;
+};
+
+/* A live allocation, free while ptr is NULL */
+struct malloc_alloc {
+	void *ptr;
+	u32 size;
+	u16 site;
+};
+
+static struct malloc_site malloc_sites[MALLOC_TRACK_SITES];
+static struct malloc_alloc malloc_allocs[MALLOC_TRACK_ALLOCS];
+static ulong malloc_classes[MALLOC_TRACK_CLASSES];
+static uint malloc_nsites, malloc_nallocs;
+static ulong malloc_live, malloc_peak, malloc_untracked;
+
+static bool malloc_track_on(void)
+{
+	const ulong flags = GD_FLG_RELOC | GD_FLG_FULL_MALLOC_INIT;
+
+	return (gd->flags & flags) == flags;
+}
+
+static uint malloc_hash(ulong key, uint size)
+{
+	return ((key >> 3) * 0x9e3779b1UL >> 8) & (size - 1);
+}
+
+static struct malloc_site *malloc_site_get(ulong caller)
+{
+	uint i = malloc_hash(caller, MALLOC_TRACK_SITES);
+
+	while (malloc_sites[i].caller) {
+		if (malloc_sites[i].caller == caller)
+			return &malloc_sites[i];
+		i = (i + 1) & (MALLOC_TRACK_SITES - 1);
+	}
+
+	if (malloc_nsites == MALLOC_TRACK_SITES - 1)
+		return NULL;
+
+	malloc_nsites++;
+	malloc_sites[i].caller = caller;
+
+	return &malloc_sites[i];
+}
+
+static uint malloc_class(size_t size)
+{
+	uint class = 0;
+
+	while (class < MALLOC_TRACK_CLASSES - 1 && size > (16UL << class))
+		class++;
+
+	return class;
+}
+
+void malloc_track_alloc(void *ptr, size_t size, void *caller)
+{
+	struct malloc_site *site;
+	uint i;
+
+	if (!ptr || !malloc_track_on())
+		return;
+
+	malloc_classes[malloc_class(size)]++;
+
+	/* Keep the table sparse enough for short probes */
+	site = malloc_site_get((ulong)caller);
+	if (!site || malloc_nallocs >= MALLOC_TRACK_ALLOCS * 3 / 4) {
+		malloc_untracked++;
+		return;
+	}
+
+	i = malloc_hash((ulong)ptr, MALLOC_TRACK_ALLOCS);
+	while (malloc_allocs[i].ptr)
+		i = (i + 1) & (MALLOC_TRACK_ALLOCS - 1);
+	malloc_allocs[i].ptr = ptr;
+	malloc_allocs[i].size = size;
+	malloc_allocs[i].site = site - malloc_sites;
+	malloc_nallocs++;
+
+	site->calls++;
+	site->live_cnt++;
+	site->live += size;
+	if (site->live > site->peak)
+		site->peak = site->live;
+
+	malloc_live += size;
+	if (malloc_live > malloc_peak)
+		malloc_peak = malloc_live;
+}
+
+/* Linear probing delete, moving back the entries that probed past @i */
+static void malloc_alloc_del(uint i)
+{
+	const uint mask = MALLOC_TRACK_ALLOCS - 1;
+	uint j = i, k;
+
+	for (;;) {
+		malloc_allocs[i].ptr = NULL;
+		do {
+			j = (j + 1) & mask;
+			if (!malloc_allocs[j].ptr)
+				return;
+			k = malloc_hash((ulong)malloc_allocs[j].ptr,
+					MALLOC_TRACK_ALLOCS);
+		} while (i <= j ? (i < k && k <= j) : (i < k || k <= j));
+		malloc_allocs[i] = malloc_allocs[j];
+		i = j;
+	}
+}
+
+void malloc_track_free(void *ptr)
+{
+	struct malloc_site *site;
+	uint i;
+
+	if (!ptr || !malloc_track_on())
+		return;
+
+	i = malloc_hash((ulong)ptr, MALLOC_TRACK_ALLOCS);
+	while (malloc_allocs[i].ptr != ptr) {
+		/* Not tracked, from before relocation or a full table */
+		if (!malloc_allocs[i].ptr)
+			return;
+		i = (i + 1) & (MALLOC_TRACK_ALLOCS - 1);
+	}
+
+	site = &malloc_sites[malloc_allocs[i].site];
+	site->live_cnt--;
+	site->live -= malloc_allocs[i].size;
+	malloc_live -= malloc_allocs[i].size;
+	malloc_nallocs--;
+	malloc_alloc_del(i);
+}
+
+void malloc_track_dump(uint max_sites)
+{
+	struct malloc_site *site, *prev = NULL;
+	uint i, n;
+
+	printf("\nmalloc_track:\n");
+	printf("    --------------------------------------------------------------------\n");
+	printf("    pool      = 0x%08lx (%ld KiB)\n",
+	       (ulong)CONFIG_SYS_MALLOC_LEN, (ulong)CONFIG_SYS_MALLOC_LEN >> 10);
+	printf("    live      = 0x%08lx (%ld KiB)\n",
+	       malloc_live, malloc_live >> 10);
+	printf("    peak      = 0x%08lx (%ld KiB)\n",
+	       malloc_peak, malloc_peak >> 10);
+	if (malloc_untracked)
+		printf("    untracked = %ld allocations, tables full\n",
+		       malloc_untracked);
+
+	printf("    --------------------------------------------------------------------\n");
+	for (i = 0; i < MALLOC_TRACK_CLASSES; i++) {
+		if (!malloc_classes[i])
+			continue;
+		if (i < MALLOC_TRACK_CLASSES - 1)
+			printf("    <= %-8lu: %ld\n", 16UL << i, malloc_classes[i]);
+		else
+			printf("    >  %-8lu: %ld\n", 16UL << (i - 1),
+			       malloc_classes[i]);
+	}
+
+	/* Sites by peak, a selection sort is plenty for a one-off dump */
+	printf("    --------------------------------------------------------------------\n");
+	printf("    %-10s %-10s %-10s %-8s %s\n",
+	       "site", "peak", "live", "live_cnt", "calls");
+	if (!max_sites || max_sites > malloc_nsites)
+		max_sites = malloc_nsites;
+	for (n = 0; n < max_sites; n++) {
+		site = NULL;
+		for (i = 0; i < MALLOC_TRACK_SITES; i++) {
+			struct malloc_site *s = &malloc_sites[i];
+
+			if (!s->caller)
+				continue;
+			if (prev && (s->peak > prev->peak ||
+				     (s->peak == prev->peak && s <= prev)))
+				continue;
+			if (!site || s->peak > site->peak)
+				site = s;
+		}
+		if (!site)
+			break;
+
+		/* As in u-boot.map, not the relocated address */
+		printf("    0x%08lx 0x%08lx 0x%08lx %-8ld %ld\n",
+		       site->caller - gd->reloc_off, site->peak, site->live,
+		       site->live_cnt, site->calls);
+		prev = site;
+	}
+	printf("    --------------------------------------------------------------------\n\n");
+}
+
+static int do_malloc_stat(cmd_tbl_t *cmdtp, int flag,
+			  int argc, char *const argv[])
+{
+	uint max_sites = 0;
+
+	if (argc < 2 || strcmp(argv[1], "stat"))
+		return CMD_RET_USAGE;
+	if (argc > 2)
+		max_sites = simple_strtoul(argv[2], NULL, 10);
+
+	malloc_track_dump(max_sites);
+
+	return 0;
+}
+
+U_BOOT_CMD(
+	malloc, 3, 1, do_malloc_stat,
+	"Dump malloc usage by call site",
+	"stat [sites] - show the sites with the biggest peak, or all"
+);
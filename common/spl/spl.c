@@ -247,7 +247,7 @@ __weak void __noreturn jump_to_image_no_args(struct spl_image_info *spl_image)
  *	   Assuming 256MB is enough for SPL(MMU still maps 4GB size).
  */
 #ifndef CONFIG_SPL_SYS_DCACHE_OFF
-static int spl_dcache_enable(void)
+int spl_dcache_enable(void)
 {
 	bool free_bd = false;
 
@@ -299,12 +299,11 @@ static int spl_common_init(bool setup_malloc)
 	 * setup D-cache as early as possible after malloc setup
 	 * I-cache has been setup at early assembly code by default.
 	 */
-#ifndef CONFIG_SPL_SYS_DCACHE_OFF
+#if !defined(CONFIG_SPL_SYS_DCACHE_OFF) && !defined(CONFIG_SPL_SYS_DCACHE_LATE)
+	/* Slow, but not a reason to stop booting */
 	ret = spl_dcache_enable();
-	if (ret) {
-		debug("spl_dcache_enable() return error %d\n", ret);
-		return ret;
-	}
+	if (ret)
+		printf("spl: dcache disabled, error %d\n", ret);
 #endif
 	ret = bootstage_init(true);
 	if (ret) {
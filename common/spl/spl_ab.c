@@ -8,6 +8,19 @@
 #include <malloc.h>
 #include <spl_ab.h>
 #include <fdt_support.h>
+#ifdef CONFIG_SPL_AB_HANDOFF
+#include <asm/arch/rk_atags.h>
+#endif
+
+/*
+ * The A/B metadata of misc, read and checked once per boot: the slot is
+ * asked for each partition SPL loads. Writes go through to the device.
+ */
+static struct {
+	struct blk_desc *dev_desc;
+	bool dirty;	/* reset, but left to U-Boot to write */
+	AvbABData data;
+} spl_ab_cache;
 
 int safe_memcmp(const void *s1, const void *s2, size_t n)
 {
@@ -161,14 +174,54 @@ static int spl_write_ab_metadata(struct blk_desc *dev_desc, AvbABData *ab_data,
 	return 0;
 }
 
+#ifdef CONFIG_SPL_AB_HANDOFF
+static void spl_ab_handoff_save(void)
+{
+	struct blk_desc *dev_desc = spl_ab_cache.dev_desc;
+	disk_partition_t part_info;
+	struct tag_ab t;
+
+	BUILD_BUG_ON(sizeof(AvbABData) != AB_DATA_LEN);
+
+	if (part_get_info_by_name(dev_desc, "misc", &part_info) < 0)
+		return;
+
+	memset(&t, 0, sizeof(t));
+	t.flags = spl_ab_cache.dirty ? AB_FLG_DIRTY : 0;
+	t.dev_lba = dev_desc->lba;
+	t.misc_start = part_info.start;
+	memcpy(t.ab_data, &spl_ab_cache.data, sizeof(AvbABData));
+	atags_set_tag(ATAG_AB, &t);
+}
+#else
+static inline void spl_ab_handoff_save(void) { }
+#endif
+
+static void spl_ab_cache_update(struct blk_desc *dev_desc, char *partition,
+				AvbABData *ab_data, bool dirty)
+{
+	if (strcmp(partition, "misc"))
+		return;
+
+	spl_ab_cache.dev_desc = dev_desc;
+	spl_ab_cache.dirty = dirty;
+	memcpy(&spl_ab_cache.data, ab_data, sizeof(AvbABData));
+	spl_ab_handoff_save();
+}
+
 static int spl_ab_data_write(struct blk_desc *dev_desc, AvbABData *ab_data,
 			     char *partition)
 {
 	AvbABData serialized;
+	int ret;
 
 	spl_ab_data_update_crc_and_byteswap(ab_data, &serialized);
 
-	return spl_write_ab_metadata(dev_desc, &serialized, partition);
+	ret = spl_write_ab_metadata(dev_desc, &serialized, partition);
+	if (!ret)
+		spl_ab_cache_update(dev_desc, partition, ab_data, false);
+
+	return ret;
 }
 
 static int spl_ab_data_read(struct blk_desc *dev_desc, AvbABData *ab_data,
@@ -177,6 +230,11 @@ static int spl_ab_data_read(struct blk_desc *dev_desc, AvbABData *ab_data,
 	int ret;
 	AvbABData serialized;
 
+	if (spl_ab_cache.dev_desc == dev_desc && !strcmp(partition, "misc")) {
+		memcpy(ab_data, &spl_ab_cache.data, sizeof(AvbABData));
+		return 0;
+	}
+
 	ret = spl_read_ab_metadata(dev_desc, &serialized, partition);
 	if (ret)
 		return ret;
@@ -185,9 +243,17 @@ static int spl_ab_data_read(struct blk_desc *dev_desc, AvbABData *ab_data,
 		printf("Error validating A/B metadata from disk. "
 		       "Resetting and writing new A/B metadata to disk.\n");
 		spl_ab_data_init(ab_data);
+#ifdef CONFIG_SPL_AB_HANDOFF
+		/* Written with the next update, by SPL or U-Boot */
+		spl_ab_cache_update(dev_desc, partition, ab_data, true);
+		return 0;
+#else
 		spl_ab_data_write(dev_desc, ab_data, partition);
+#endif
 	}
 
+	spl_ab_cache_update(dev_desc, partition, ab_data, false);
+
 	return 0;
 }
 
@@ -301,7 +367,8 @@ static int spl_save_metadata_if_changed(struct blk_desc *dev_desc,
 					AvbABData *ab_data,
 					AvbABData *ab_data_orig)
 {
-	if (safe_memcmp(ab_data, ab_data_orig, sizeof(AvbABData)))
+	if (spl_ab_cache.dirty ||
+	    safe_memcmp(ab_data, ab_data_orig, sizeof(AvbABData)))
 		return spl_ab_data_write(dev_desc, ab_data, "misc");
 
 	return 0;
@@ -6,6 +6,7 @@
 
 #include <common.h>
 #include <dm.h>
+#include <errno.h>
 #include <malloc.h>
 #include <version.h>
 #include <asm/sections.h>
@@ -166,6 +167,17 @@ static int un_lzma(const image_header_t *hdr, int *err_algo)
 	src_lenp = *(u32 *)(uimage_to_cpu(hdr->ih_size));
 	data = (void *)hdr + sizeof(*hdr);
 	lzma_len = SZ_2M; /* default max size */
+#ifdef CONFIG_SPL_LZMA_XZ
+	if (xz_is_valid(data)) {
+		err = xz_decompress(data, src_lenp, (void *)load_addr,
+				    &lzma_len);
+		/* As an LZMA SDK code, print_ret() takes small numbers */
+		if (err == -ENOBUFS)
+			err = SZ_ERROR_OUTPUT_EOF;
+		else if (err)
+			err = SZ_ERROR_DATA;
+	} else
+#endif
 	err = lzmaBuffToBuffDecompress((uchar *)(load_addr), &lzma_len,
 				       (uchar *)(data), src_lenp);
 	if (err) {
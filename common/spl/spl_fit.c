@@ -6,16 +6,24 @@
  */
 
 #include <common.h>
+#include <amp.h>
 #include <boot_rkimg.h>
 #include <errno.h>
 #include <fdt_support.h>
 #include <image.h>
+#include <image-pipe.h>
 #include <malloc.h>
+#include <memalign.h>
 #include <mtd_blk.h>
 #include <mp_boot.h>
 #include <spl.h>
 #include <spl_ab.h>
+#include <asm/unaligned.h>
+#include <u-boot/zstd.h>
 #include <linux/libfdt.h>
+#include <linux/sizes.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 #ifndef CONFIG_SYS_BOOTM_LEN
 #define CONFIG_SYS_BOOTM_LEN	(64 << 20)
@@ -147,6 +155,484 @@ static int get_aligned_image_size(struct spl_load_info *info, int data_size,
 	return (data_size + info->bl_len - 1) / info->bl_len;
 }
 
+__weak void board_fit_image_verified(const void *fit, int node, u64 offset,
+				     size_t size)
+{
+}
+
+#ifdef CONFIG_SPL_FIT_IMAGE_STREAM
+__weak int board_fit_image_stream(void *fit, int node, ulong load_addr,
+				  const void *src, size_t avail, size_t total,
+				  void *spec)
+{
+	return -ENOSYS;
+}
+#endif
+
+struct spl_fit_pipe;
+
+/*
+ * How the external data of an image is read. Normally all sectors covering
+ * it go to @buf, the data then starts at @buf + @overhead and is copied or
+ * decompressed from there. With @zero_copy the sectors holding nothing but
+ * image data go straight to @load_addr, only the partial sectors at the
+ * head and tail are bounced.
+ */
+struct spl_fit_read {
+	ulong sector;		/* first sector of the bulk read */
+	int nr_sectors;		/* sectors of the bulk read */
+	ulong buf;		/* destination of the bulk read */
+	ulong first;		/* first sector holding image data */
+	ulong overhead;		/* bytes before the data in that sector */
+	size_t length;
+	bool zero_copy;
+	ulong load_addr;
+};
+
+static void spl_fit_plan_read(struct spl_load_info *info, ulong sector,
+			      int offset, size_t length, ulong load_ptr,
+			      ulong load_addr, bool zero_copy,
+			      struct spl_fit_read *rd)
+{
+	ulong head;
+
+	rd->first = sector + get_aligned_image_offset(info, offset);
+	rd->overhead = get_aligned_image_overhead(info, offset);
+	rd->length = length;
+	rd->load_addr = load_addr;
+	rd->sector = rd->first;
+	rd->nr_sectors = get_aligned_image_size(info, length, offset);
+	rd->buf = load_ptr;
+	rd->zero_copy = false;
+
+	if (!zero_copy || info->filename)
+		return;
+
+	/* Bytes of the image in its first, partial sector */
+	head = rd->overhead ? info->bl_len - rd->overhead : 0;
+	if (length < head + info->bl_len ||
+	    !IS_ALIGNED(load_addr + head, ARCH_DMA_MINALIGN))
+		return;
+
+	rd->zero_copy = true;
+	rd->sector = rd->first + (rd->overhead ? 1 : 0);
+	rd->nr_sectors = (length - head) / info->bl_len;
+	rd->buf = load_addr + head;
+}
+
+/* Zero-copy: fill in the partial sectors around the bulk read */
+static int spl_fit_read_edges(struct spl_load_info *info,
+			      const struct spl_fit_read *rd)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(u8, bounce, info->bl_len);
+	ulong head = rd->buf - rd->load_addr;
+	ulong done = head + rd->nr_sectors * info->bl_len;
+
+	if (head) {
+		if (info->read(info, rd->first, 1, bounce) != 1)
+			return -EIO;
+		memcpy((void *)rd->load_addr, bounce + rd->overhead, head);
+	}
+
+	if (done < rd->length) {
+		if (info->read(info, rd->sector + rd->nr_sectors, 1,
+			       bounce) != 1)
+			return -EIO;
+		memcpy((void *)rd->load_addr + done, bounce,
+		       rd->length - done);
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_SPL_IMAGE_PIPE
+/* Bytes read before the stages get to work on them */
+#define FIT_PIPE_CHUNK	SZ_256K
+
+/*
+ * What the external data of an image goes through while it is read:
+ * decryption, hashing and, for a compressed image which isn't encrypted,
+ * board_fit_image_stream(). Each chunk does so while the next one is read.
+ */
+struct spl_fit_pipe {
+	struct img_pipe pipe;
+	struct img_cipher_stage cipher;
+	struct img_hash_stage hash;
+	bool ciphered;
+	bool hashed;
+#ifdef CONFIG_SPL_FIT_IMAGE_STREAM
+	bool streamed;
+	struct img_stage stream;
+	struct spl_load_info *info;
+	void *fit;
+	int node;
+	ulong load_addr;
+#endif
+};
+
+/* Start of the data of an image once all of it is read */
+static u8 *spl_fit_data_start(const struct spl_fit_read *rd)
+{
+	if (rd->zero_copy)
+		return (u8 *)rd->load_addr;
+
+	return (u8 *)rd->buf + rd->overhead;
+}
+
+#ifdef CONFIG_SPL_FIT_IMAGE_STREAM
+static int spl_fit_stream_feed(struct img_stage *st, u8 *data, size_t avail,
+			       size_t total)
+{
+	struct spl_fit_pipe *sp = container_of(st, struct spl_fit_pipe, stream);
+
+	st->done = avail;
+	if (board_fit_image_stream(sp->fit, sp->node, sp->load_addr, data,
+				   avail, total, sp->info))
+		return IMG_STAGE_SKIP;
+
+	return 0;
+}
+
+static void spl_fit_stream_abort(struct img_stage *st)
+{
+	struct spl_fit_pipe *sp = container_of(st, struct spl_fit_pipe, stream);
+
+	board_fit_image_stream(sp->fit, sp->node, sp->load_addr, NULL, 0,
+			       sp->pipe.total, sp->info);
+}
+#endif
+
+/* Returns the number of hash nodes of an image, @algo is that of the last */
+static int spl_fit_image_hash(const void *fit, int node, char **algo)
+{
+	const char *name;
+	int sub, count = 0;
+
+	fdt_for_each_subnode(sub, fit, node) {
+		name = fit_get_name(fit, sub, NULL);
+		if (strncmp(name, FIT_HASH_NODENAME, strlen(FIT_HASH_NODENAME)))
+			continue;
+		if (fit_image_hash_get_algo(fit, sub, algo))
+			return -EINVAL;
+		count++;
+	}
+
+	return count;
+}
+
+static int spl_fit_pipe_init(struct spl_fit_pipe *sp,
+			     struct spl_load_info *info, void *fit, int node,
+			     const struct spl_fit_read *rd, uint8_t image_comp)
+{
+	size_t size = rd->length;
+	char *algo;
+	int ret;
+
+	img_pipe_init(&sp->pipe, spl_fit_data_start(rd), rd->length);
+	sp->ciphered = false;
+	sp->hashed = false;
+#ifdef CONFIG_SPL_FIT_IMAGE_STREAM
+	sp->streamed = false;
+#endif
+
+	ret = img_cipher_stage_init(&sp->cipher, fit, node, gd_fdt_blob());
+	if (ret < 0)
+		return ret;
+	if (ret) {
+		sp->ciphered = true;
+		size = sp->cipher.cipher.size_unciphered;
+		img_pipe_add(&sp->pipe, &sp->cipher.st);
+	}
+
+	/*
+	 * The hash of the (decrypted) data, if there is just one. The engine
+	 * can't hash while it decrypts, such images are hashed afterwards.
+	 */
+	if ((!sp->ciphered || !CONFIG_IS_ENABLED(FIT_HW_CRYPTO)) &&
+	    spl_fit_image_hash(fit, node, &algo) == 1 &&
+	    !img_hash_stage_init(&sp->hash, algo, size)) {
+		sp->hashed = true;
+		img_pipe_add(&sp->pipe, &sp->hash.st);
+	}
+
+#ifdef CONFIG_SPL_FIT_IMAGE_STREAM
+	/* The trailer with the decompressed size is read first, see below */
+	if (!sp->ciphered && rd->length > FIT_PIPE_CHUNK &&
+	    (image_comp == IH_COMP_GZIP || image_comp == IH_COMP_LZ4)) {
+		memset(&sp->stream, 0, sizeof(sp->stream));
+		sp->stream.name = "stream";
+		sp->stream.feed = spl_fit_stream_feed;
+		sp->stream.abort = spl_fit_stream_abort;
+		sp->info = info;
+		sp->fit = fit;
+		sp->node = node;
+		sp->load_addr = rd->load_addr;
+		sp->streamed = true;
+		img_pipe_add(&sp->pipe, &sp->stream);
+	}
+#endif
+
+	return 0;
+}
+
+/*
+ * Same as one info->read() of the external data, but run the pipeline over
+ * each chunk while the next one is read. With zero-copy the edges must be
+ * read first. The caller finishes the pipeline.
+ */
+static int spl_fit_read_pipe(struct spl_load_info *info,
+			     const struct spl_fit_read *rd,
+			     struct spl_fit_pipe *sp)
+{
+	int chunk = FIT_PIPE_CHUNK / info->bl_len;
+	bool async = info->read_async && info->wait && !info->filename;
+	u8 *data = sp->pipe.data;
+	int done = 0, cnt, ret;
+	ulong queued;
+	u8 *dst;
+
+#ifdef CONFIG_SPL_FIT_IMAGE_STREAM
+	/* Trailer first: the decompressed size of gzip/lz4 is kept there */
+	dst = (u8 *)rd->buf + (rd->nr_sectors - 1) * info->bl_len;
+	if (sp->streamed &&
+	    info->read(info, rd->sector + rd->nr_sectors - 1, 1, dst) != 1)
+		return -EIO;
+#endif
+
+	while (done < rd->nr_sectors) {
+		cnt = min(chunk, rd->nr_sectors - done);
+		dst = (u8 *)rd->buf + done * info->bl_len;
+
+		queued = async ? info->read_async(info, rd->sector + done,
+						  cnt, dst) : 0;
+		if (!queued || queued > cnt) {
+			queued = 0;
+			if (info->read(info, rd->sector + done, cnt,
+				       dst) != cnt)
+				return -EIO;
+			dst += cnt * info->bl_len;
+		} else {
+			cnt = queued;
+		}
+
+		/* What is in so far, while the chunk queued comes in */
+		ret = dst > data ? img_pipe_feed(&sp->pipe, dst - data) : 0;
+		if (queued && info->wait(info))
+			return -EIO;
+		if (ret)
+			return ret;
+		done += cnt;
+	}
+
+	return 0;
+}
+#endif
+
+/* Do the bulk read of the external data of an image */
+static int spl_fit_read_data(struct spl_load_info *info,
+			     const struct spl_fit_read *rd,
+			     struct spl_fit_pipe *sp)
+{
+#ifdef CONFIG_SPL_IMAGE_PIPE
+	int ret;
+
+	if (sp) {
+		ret = spl_fit_read_pipe(info, rd, sp);
+		if (ret)
+			img_pipe_abort(&sp->pipe);
+		return ret;
+	}
+#endif
+	if (info->read(info, rd->sector, rd->nr_sectors,
+		       (void *)rd->buf) != rd->nr_sectors)
+		return -EIO;
+
+	return 0;
+}
+
+/* Uncompressed images in reach of DMA can be read to their final place */
+static bool spl_fit_can_zero_copy(ulong load_addr, uint8_t image_comp)
+{
+	if (image_comp != IH_COMP_NONE)
+		return false;
+#if  defined(CONFIG_ARCH_ROCKCHIP)
+	if ((load_addr < CONFIG_SYS_SDRAM_BASE) ||
+	     (load_addr >= CONFIG_SYS_SDRAM_BASE + SDRAM_MAX_SIZE))
+		return false;
+#endif
+	return true;
+}
+
+/* Where the (possibly compressed) data of an image is loaded to */
+static ulong spl_fit_load_ptr(void *fit, int node, ulong load_addr,
+			      uint8_t image_comp)
+{
+	int align_len = ARCH_DMA_MINALIGN - 1;
+	ulong comp_addr;
+
+	if (image_comp != IH_COMP_NONE && image_comp != IH_COMP_ZIMAGE) {
+		/* Empirically, 2MB is enough for U-Boot, tee and atf */
+		if (fit_image_get_comp_addr(fit, node, &comp_addr))
+			comp_addr = load_addr + FIT_MAX_SPL_IMAGE_SZ;
+	} else {
+		comp_addr = load_addr;
+	}
+
+	return (comp_addr + align_len) & ~align_len;
+}
+
+/* Get the offset of external data, returns false if data is embedded */
+static bool spl_fit_ext_data_offset(void *fit, int node, ulong base_offset,
+				    int *offset)
+{
+	if (!fit_image_get_data_position(fit, node, offset))
+		return true;
+
+	if (!fit_image_get_data_offset(fit, node, offset)) {
+		*offset += base_offset;
+		return true;
+	}
+
+	return false;
+}
+
+#ifdef CONFIG_SPL_FIT_PIPELINE
+/*
+ * External data of the next image, read with info->read_async() while the
+ * current one is verified and post-processed.
+ */
+static struct {
+	int node;		/* -1 if nothing is prefetched */
+	bool busy;		/* read outstanding */
+	struct spl_fit_read rd;
+	int queued;		/* sectors covered by the async read */
+} spl_fit_prefetch = { .node = -1 };
+
+static bool spl_fit_overlap(ulong s1, ulong e1, ulong s2, ulong e2)
+{
+	return s1 < e2 && s2 < e1;
+}
+
+static void spl_fit_prefetch_wait(struct spl_load_info *info)
+{
+	if (!spl_fit_prefetch.busy)
+		return;
+
+	spl_fit_prefetch.busy = false;
+	if (info->wait(info))
+		spl_fit_prefetch.node = -1;
+}
+
+/* Wait for the prefetch and forget about it */
+static void spl_fit_prefetch_cancel(struct spl_load_info *info)
+{
+	spl_fit_prefetch_wait(info);
+	spl_fit_prefetch.node = -1;
+}
+
+/*
+ * Start reading the external data of @node in the background. The ranges
+ * [@in, @in_end) and [@out, @out_end) are still in use by the current
+ * image, the read must not touch them.
+ */
+static void spl_fit_prefetch_start(struct spl_load_info *info, ulong sector,
+				   void *fit, ulong base_offset, int node,
+				   ulong in, ulong in_end,
+				   ulong out, ulong out_end)
+{
+	uint8_t image_comp = -1;
+	ulong load_addr, load_ptr, queued;
+	struct spl_fit_read rd;
+	int offset, len;
+
+	if (node < 0 || !info->read_async || !info->wait || info->filename)
+		return;
+
+	/* Without a "load" property the address depends on earlier images */
+	if (fit_image_get_load(fit, node, &load_addr) ||
+	    !spl_fit_ext_data_offset(fit, node, base_offset, &offset) ||
+	    fit_image_get_data_size(fit, node, &len))
+		return;
+
+	fit_image_get_comp(fit, node, &image_comp);
+	load_ptr = spl_fit_load_ptr(fit, node, load_addr, image_comp);
+#if  defined(CONFIG_ARCH_ROCKCHIP)
+	if ((load_ptr < CONFIG_SYS_SDRAM_BASE) ||
+	     (load_ptr >= CONFIG_SYS_SDRAM_BASE + SDRAM_MAX_SIZE))
+		return;
+#endif
+	spl_fit_plan_read(info, sector, offset, len, load_ptr, load_addr,
+			  spl_fit_can_zero_copy(load_addr, image_comp), &rd);
+	/* Zero-copy edges are filled in later, when the image is reached */
+	len = rd.nr_sectors * info->bl_len;
+	if (spl_fit_overlap(rd.buf, rd.buf + len, in, in_end) ||
+	    spl_fit_overlap(rd.buf, rd.buf + len, out, out_end))
+		return;
+
+	queued = info->read_async(info, rd.sector, rd.nr_sectors,
+				  (void *)rd.buf);
+	if (!queued || queued > rd.nr_sectors)
+		return;
+
+	spl_fit_prefetch.node = node;
+	spl_fit_prefetch.busy = true;
+	spl_fit_prefetch.rd = rd;
+	spl_fit_prefetch.queued = queued;
+}
+
+/*
+ * Use the prefetched data of @node if there is any: wait for it and read
+ * what the async read did not cover. Returns 1 if the bulk of the data
+ * is in place, 0 if it has to be read, -ve on error.
+ */
+static int spl_fit_prefetch_take(struct spl_load_info *info, int node,
+				 const struct spl_fit_read *rd)
+{
+	const struct spl_fit_read *pf = &spl_fit_prefetch.rd;
+	int done = spl_fit_prefetch.queued;
+	int left;
+
+	if (spl_fit_prefetch.node < 0)
+		return 0;
+
+	spl_fit_prefetch_wait(info);
+	if (spl_fit_prefetch.node != node || pf->sector != rd->sector ||
+	    pf->nr_sectors != rd->nr_sectors || pf->buf != rd->buf) {
+		/* Some other image, e.g. the FDT for U-Boot */
+		spl_fit_prefetch.node = -1;
+		return 0;
+	}
+
+	spl_fit_prefetch.node = -1;
+	left = rd->nr_sectors - done;
+	if (left &&
+	    info->read(info, rd->sector + done, left,
+		       (void *)rd->buf + done * info->bl_len) != left)
+		return -EIO;
+
+	return 1;
+}
+
+/* Size of the image once decompressed, 0 if it can't be told */
+static ulong spl_fit_out_size(uint8_t image_comp, const void *src,
+			      size_t length)
+{
+	if (image_comp == IH_COMP_NONE || image_comp == IH_COMP_ZIMAGE)
+		return length;
+
+	/* gzip ISIZE, or the size the kernel build appends to lz4 */
+	if ((image_comp == IH_COMP_GZIP || image_comp == IH_COMP_LZ4) &&
+	    length > 4)
+		return get_unaligned_le32(src + length - 4);
+
+	/* zstd records it in the frame header, unless it compressed a pipe */
+	if (CONFIG_IS_ENABLED(ZSTD) && image_comp == IH_COMP_ZSTD)
+		return zstd_get_content_size(src, length);
+
+	return 0;
+}
+#endif
+
 /**
  * spl_load_fit_image(): load the image described in a certain FIT node
  * @info:	points to information about the device to load data from
@@ -161,25 +647,38 @@ static int get_aligned_image_size(struct spl_load_info *info, int data_size,
  *		If the FIT node does not contain a "load" (address) property,
  *		the image gets loaded to the address pointed to by the
  *		load_addr member in this struct.
+ * @next:	image that will be loaded after this one, its data is read in
+ *		the background if possible. -1 if none.
  *
  * Return:	0 on success or a negative error number.
  */
-static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
-			      void *fit, ulong base_offset, int node,
-			      struct spl_image_info *image_info)
+static int spl_load_fit_image_next(struct spl_load_info *info, ulong sector,
+				   void *fit, ulong base_offset, int node,
+				   struct spl_image_info *image_info, int next)
 {
 	int offset;
 	size_t length;
 	int len;
 	ulong size;
-	ulong comp_addr, load_addr, load_ptr;
+	ulong load_addr, load_ptr;
 	void *src;
-	ulong overhead;
-	int nr_sectors;
-	int align_len = ARCH_DMA_MINALIGN - 1;
+	struct spl_fit_read rd;
+	bool zero_copy;
 	uint8_t image_comp = -1, type = -1;
 	const void *data;
-	bool external_data = false;
+	bool external_data;
+	struct spl_fit_pipe *pipe = NULL;
+	int ret = 0;
+#ifdef CONFIG_SPL_IMAGE_PIPE
+	struct spl_fit_pipe sp;
+#endif
+#ifdef CONFIG_SPL_FIT_PIPELINE
+	ulong out_size;
+
+	/* Another image in between, e.g. the FDT for U-Boot */
+	if (spl_fit_prefetch.node >= 0 && spl_fit_prefetch.node != node)
+		spl_fit_prefetch_cancel(info);
+#endif
 
 	if (IS_ENABLED(CONFIG_SPL_OS_BOOT) && IS_ENABLED(CONFIG_SPL_GZIP)) {
 		if (fit_image_get_comp(fit, node, &image_comp))
@@ -198,27 +697,15 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 	if (fit_image_get_load(fit, node, &load_addr))
 		load_addr = image_info->load_addr;
 
-	if (image_comp != IH_COMP_NONE && image_comp != IH_COMP_ZIMAGE) {
-		/* Empirically, 2MB is enough for U-Boot, tee and atf */
-		if (fit_image_get_comp_addr(fit, node, &comp_addr))
-			comp_addr = load_addr + FIT_MAX_SPL_IMAGE_SZ;
-	} else {
-		comp_addr = load_addr;
-	}
-
-	if (!fit_image_get_data_position(fit, node, &offset)) {
-		external_data = true;
-	} else if (!fit_image_get_data_offset(fit, node, &offset)) {
-		offset += base_offset;
-		external_data = true;
-	}
-
+	external_data = spl_fit_ext_data_offset(fit, node, base_offset,
+						&offset);
 	if (external_data) {
 		/* External data */
 		if (fit_image_get_data_size(fit, node, &len))
 			return -ENOENT;
 
-		load_ptr = (comp_addr + align_len) & ~align_len;
+		load_ptr = spl_fit_load_ptr(fit, node, load_addr, image_comp);
+		zero_copy = spl_fit_can_zero_copy(load_addr, image_comp);
 #if  defined(CONFIG_ARCH_ROCKCHIP)
 		if ((load_ptr < CONFIG_SYS_SDRAM_BASE) ||
 		     (load_ptr >= CONFIG_SYS_SDRAM_BASE + SDRAM_MAX_SIZE))
@@ -226,28 +713,91 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 #endif
 		length = len;
 
-		overhead = get_aligned_image_overhead(info, offset);
-		nr_sectors = get_aligned_image_size(info, length, offset);
+		spl_fit_plan_read(info, sector, offset, length, load_ptr,
+				  load_addr, zero_copy, &rd);
 
-		if (info->read(info,
-			       sector + get_aligned_image_offset(info, offset),
-			       nr_sectors, (void *)load_ptr) != nr_sectors)
-			return -EIO;
+#ifdef CONFIG_SPL_IMAGE_PIPE
+		ret = spl_fit_pipe_init(&sp, info, fit, node, &rd, image_comp);
+		if (ret)
+			return ret;
+		if (!img_pipe_empty(&sp.pipe))
+			pipe = &sp;
+#else
+		if (fdt_subnode_offset(fit, node, FIT_CIPHER_NODENAME) >= 0) {
+			printf("%s: encrypted, no SPL_FIT_CIPHER\n",
+			       fit_get_name(fit, node, NULL));
+			return -EPROTONOSUPPORT;
+		}
+#endif
+#ifdef CONFIG_SPL_FIT_PIPELINE
+		ret = spl_fit_prefetch_take(info, node, &rd);
+		if (ret < 0)
+			return ret;
+#endif
+		/* The stages run from the start, so the head comes first */
+		if (rd.zero_copy && pipe) {
+			if (spl_fit_read_edges(info, &rd))
+				return -EIO;
+		}
+		if (!ret) {
+			ret = spl_fit_read_data(info, &rd, pipe);
+			if (ret)
+				return ret;
+		}
+		if (rd.zero_copy && !pipe) {
+			ret = spl_fit_read_edges(info, &rd);
+			if (ret)
+				return ret;
+		}
+#ifdef CONFIG_SPL_IMAGE_PIPE
+		if (pipe) {
+			/* The rest, or all of it if it was prefetched */
+			ret = img_pipe_finish(&sp.pipe);
+			if (ret) {
+				img_pipe_abort(&sp.pipe);
+				printf("Failed to load %s: %d\n",
+				       fit_get_name(fit, node, NULL), ret);
+				return ret;
+			}
+			if (sp.ciphered)
+				length = sp.cipher.cipher.size_unciphered;
+			if (sp.hashed)
+				img_hash_stage_record(&sp.hash, sp.pipe.data,
+						      length);
+		}
+#endif
 
-		debug("External data: dst=%lx, offset=%x, size=%lx\n",
-		      load_ptr, offset, (unsigned long)length);
-		src = (void *)load_ptr + overhead;
+		debug("External data: dst=%lx, offset=%x, size=%lx%s\n",
+		      rd.buf, offset, (unsigned long)length,
+		      rd.zero_copy ? " (zero-copy)" : "");
+		src = rd.zero_copy ? (void *)load_addr :
+				     (void *)load_ptr + rd.overhead;
 	} else {
 		/* Embedded data */
 		if (fit_image_get_data(fit, node, &data, &length)) {
 			puts("Cannot get image data/size\n");
 			return -ENOENT;
 		}
+		/* Only external data is decrypted, see spl_fit_pipe_init() */
+		if (fdt_subnode_offset(fit, node, FIT_CIPHER_NODENAME) >= 0) {
+			printf("%s: encrypted embedded data is not supported\n",
+			       fit_get_name(fit, node, NULL));
+			return -EPROTONOSUPPORT;
+		}
 		debug("Embedded data: dst=%lx, size=%lx\n", load_addr,
 		      (unsigned long)length);
 		src = (void *)data;
 	}
 
+#ifdef CONFIG_SPL_FIT_PIPELINE
+	/* Read the next image while this one is checked and processed */
+	out_size = spl_fit_out_size(image_comp, src, length);
+	if (out_size)
+		spl_fit_prefetch_start(info, sector, fit, base_offset, next,
+				       (ulong)src, (ulong)src + length,
+				       load_addr, load_addr + out_size);
+#endif
+
 	/* Check hashes and signature */
 	if (image_comp != IH_COMP_NONE && image_comp != IH_COMP_ZIMAGE)
 		printf("## Checking %s 0x%08lx (%s @0x%08lx) ... ",
@@ -263,8 +813,18 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 	fit_image_print(fit, node, "");
 #endif
 	if (!fit_image_verify_with_data(fit, node,
-					 src, length))
+					 src, length)) {
+#ifdef CONFIG_SPL_FIT_IMAGE_STREAM
+		board_fit_image_stream(fit, node, load_addr, NULL, 0, length,
+				       info);
+#endif
 		return -EPERM;
+	}
+
+	if (external_data && !info->filename)
+		board_fit_image_verified(fit, node,
+					 (u64)sector * info->bl_len + offset,
+					 length);
 
 #ifdef CONFIG_SPL_FIT_IMAGE_POST_PROCESS
 	board_fit_image_post_process(fit, node, (ulong *)&load_addr,
@@ -283,7 +843,18 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 			return -EIO;
 		}
 		length = size;
-	} else {
+	} else if (IS_ENABLED(CONFIG_SPL_OS_BOOT)	&&
+		   CONFIG_IS_ENABLED(ZSTD)		&&
+		   image_comp == IH_COMP_ZSTD		&&
+		   type == IH_TYPE_KERNEL) {
+		size_t zsize = CONFIG_SYS_BOOTM_LEN;
+
+		if (zstd_decompress(src, length, (void *)load_addr, &zsize)) {
+			puts("Uncompressing error\n");
+			return -EIO;
+		}
+		length = zsize;
+	} else if (src != (void *)load_addr) {
 		memcpy((void *)load_addr, src, length);
 	}
 
@@ -296,6 +867,14 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 	return 0;
 }
 
+static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
+			      void *fit, ulong base_offset, int node,
+			      struct spl_image_info *image_info)
+{
+	return spl_load_fit_image_next(info, sector, fit, base_offset, node,
+				       image_info, -1);
+}
+
 static int spl_fit_append_fdt(struct spl_image_info *spl_image,
 			      struct spl_load_info *info, ulong sector,
 			      void *fit, int images, ulong base_offset)
@@ -483,12 +1062,14 @@ static int spl_load_kernel_fit(struct spl_image_info *spl_image,
 	 * The .its content rule of kernel fit image follows U-Boot proper.
 	 */
 	const char *images[] = { FIT_FDT_PROP, FIT_KERNEL_PROP, FIT_RAMDISK_PROP, };
+	int nodes[ARRAY_SIZE(images)];
 	struct spl_image_info image_info;
+	void *fdt = NULL;
 	char fit_header[info->bl_len];
 	int images_noffset;
 	int base_offset;
 	int sector;
-	int node, ret, i;
+	int next, ret, i, j;
 	void *fit;
 
 	if (spl_image->next_stage != SPL_NEXT_STAGE_KERNEL)
@@ -549,38 +1130,37 @@ static int spl_load_kernel_fit(struct spl_image_info *spl_image,
 		return images_noffset;
 	}
 
+	/* Find them all first, so each one is read while the last is checked */
 	for (i = 0; i < ARRAY_SIZE(images); i++) {
 		if (!strcmp(images[i], FIT_FDT_PROP))
-			node = spl_fit_get_kernel_dtb(fit, images_noffset);
+			nodes[i] = spl_fit_get_kernel_dtb(fit, images_noffset);
 		else
-			node = spl_fit_get_image_node(fit, images_noffset,
-						      images[i], 0);
-		if (node < 0) {
+			nodes[i] = spl_fit_get_image_node(fit, images_noffset,
+							  images[i], 0);
+		if (nodes[i] < 0)
 			debug("No image: %s\n", images[i]);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(images); i++) {
+		if (nodes[i] < 0)
 			continue;
+
+		for (next = -1, j = i + 1; j < ARRAY_SIZE(images); j++) {
+			if (nodes[j] >= 0) {
+				next = nodes[j];
+				break;
+			}
 		}
 
-		ret = spl_load_fit_image(info, sector, fit, base_offset,
-					 node, &image_info);
+		ret = spl_load_fit_image_next(info, sector, fit, base_offset,
+					      nodes[i], &image_info, next);
 		if (ret)
 			return ret;
 
 		/* initial addr or entry point */
 		if (!strcmp(images[i], FIT_FDT_PROP)) {
-			spl_image->fdt_addr = (void *)image_info.load_addr;
-#ifdef CONFIG_SPL_AB
-			char slot_suffix[3] = {0};
-
-			if (!spl_get_current_slot(info->dev, "misc", slot_suffix))
-				spl_ab_bootargs_append_slot((void *)image_info.load_addr, slot_suffix);
-#endif
-
-#ifdef CONFIG_SPL_MTD_SUPPORT
-			struct blk_desc *desc = info->dev;
-
-			if (desc->devnum == BLK_MTD_SPI_NAND)
-				fdt_bootargs_append((void *)image_info.load_addr, mtd_part_parse(desc));
-#endif
+			fdt = (void *)image_info.load_addr;
+			spl_image->fdt_addr = fdt;
 		} else if (!strcmp(images[i], FIT_KERNEL_PROP)) {
 #if CONFIG_IS_ENABLED(OPTEE)
 			spl_image->entry_point_os = image_info.load_addr;
@@ -591,6 +1171,26 @@ static int spl_load_kernel_fit(struct spl_image_info *spl_image,
 		}
 	}
 
+	/*
+	 * The bootargs fixups read the device, so they wait until no image
+	 * is read in the background any more.
+	 */
+	if (fdt) {
+#ifdef CONFIG_SPL_AB
+		char slot_suffix[3] = {0};
+
+		if (!spl_get_current_slot(info->dev, "misc", slot_suffix))
+			spl_ab_bootargs_append_slot(fdt, slot_suffix);
+#endif
+
+#ifdef CONFIG_SPL_MTD_SUPPORT
+		struct blk_desc *desc = info->dev;
+
+		if (desc->devnum == BLK_MTD_SPI_NAND)
+			fdt_bootargs_append(fdt, mtd_part_parse(desc));
+#endif
+	}
+
 	debug("fdt_addr=0x%08lx, entry_point=0x%08lx, entry_point_os=0x%08lx\n",
 	      (ulong)spl_image->fdt_addr,
 	      spl_image->entry_point,
@@ -605,6 +1205,99 @@ static int spl_load_kernel_fit(struct spl_image_info *spl_image,
 }
 #endif
 
+#ifdef CONFIG_SPL_ROCKCHIP_AMP
+/*
+ * Load the firmwares of amp.img which U-Boot is to start before it
+ * relocates. Whatever goes wrong, U-Boot loads them itself later on.
+ */
+static int spl_load_amp_fit(struct spl_image_info *spl_image,
+			    struct spl_load_info *info)
+{
+	struct spl_image_info image_info;
+	char fit_header[info->bl_len];
+	disk_partition_t part_info;
+	const char *uname;
+	int conf_noffset;
+	int base_offset;
+	int sector;
+	int node, ret, i;
+	void *fit;
+
+	/* nothing runs after the trust to start the cpus */
+	if (spl_image->next_stage == SPL_NEXT_STAGE_KERNEL)
+		return 0;
+
+	if (part_get_info_by_name(info->dev, PART_AMP, &part_info) <= 0)
+		return 0;
+	sector = part_info.start;
+
+	if (info->read(info, sector, 1, &fit_header) != 1)
+		return -EIO;
+
+	if (image_get_magic((void *)&fit_header) != FDT_MAGIC)
+		return -EINVAL;
+
+	fit = spl_fit_load_blob(info, sector, fit_header, &base_offset);
+	if (!fit)
+		return -ENODEV;
+
+	conf_noffset = fit_conf_get_node(fit, NULL);
+	if (conf_noffset < 0)
+		return conf_noffset;
+
+#ifdef CONFIG_SPL_FIT_SIGNATURE
+	ret = fit_config_verify(fit, conf_noffset);
+	if (ret)
+		return ret;
+#endif
+
+	for (i = 0;
+	     uname = fdt_stringlist_get(fit, conf_noffset,
+					FIT_LOADABLE_PROP, i, NULL), uname;
+	     i++) {
+		node = fit_image_get_node(fit, uname);
+		if (node < 0 || !amp_handoff_wanted(fit, node))
+			continue;
+
+		ret = spl_load_fit_image(info, sector, fit, base_offset,
+					 node, &image_info);
+		if (ret) {
+			printf("AMP: load %s failed, ret=%d\n", uname, ret);
+			continue;
+		}
+		amp_handoff_add(fit, node, &image_info);
+		printf("AMP: %s at 0x%08lx\n", uname, image_info.load_addr);
+	}
+
+	return 0;
+}
+#endif
+
+/* skip U-Boot ? */
+static bool spl_fit_skip_loadable(void *fit, int node,
+				  struct spl_image_info *spl_image)
+{
+	uint8_t os_type = IH_OS_INVALID;
+
+	spl_fit_image_get_os(fit, node, &os_type);
+
+	return spl_image->next_stage == SPL_NEXT_STAGE_KERNEL &&
+	       os_type == IH_OS_U_BOOT;
+}
+
+/* The first loadable from @index on that gets loaded, -1 if none */
+static int spl_fit_next_loadable(void *fit, int images, int index,
+				 struct spl_image_info *spl_image)
+{
+	int node;
+
+	for (; ; index++) {
+		node = spl_fit_get_image_node(fit, images, "loadables", index);
+		if (node < 0 || !spl_fit_skip_loadable(fit, node, spl_image))
+			return node;
+	}
+}
+
 static int spl_internal_load_simple_fit(struct spl_image_info *spl_image,
 					struct spl_load_info *info,
 					ulong sector, void *fit_header)
@@ -737,8 +1430,10 @@ static int spl_internal_load_simple_fit(struct spl_image_info *spl_image,
 	}
 
 	/* Load the image and set up the spl_image structure */
-	ret = spl_load_fit_image(info, sector, fit, base_offset, node,
-				 spl_image);
+	ret = spl_load_fit_image_next(info, sector, fit, base_offset, node,
+				      spl_image,
+				      spl_fit_next_loadable(fit, images, index,
+							    spl_image));
 	if (ret)
 		return ret;
 
@@ -772,13 +1467,14 @@ static int spl_internal_load_simple_fit(struct spl_image_info *spl_image,
 		if (!spl_fit_image_get_os(fit, node, &os_type))
 			debug("Loadable is %s\n", genimg_get_os_name(os_type));
 
-		/* skip U-Boot ? */
-		if (spl_image->next_stage == SPL_NEXT_STAGE_KERNEL &&
-		    os_type == IH_OS_U_BOOT)
-		    continue;
+		if (spl_fit_skip_loadable(fit, node, spl_image))
+			continue;
 
-		ret = spl_load_fit_image(info, sector, fit, base_offset, node,
-					 &image_info);
+		ret = spl_load_fit_image_next(info, sector, fit, base_offset,
+					      node, &image_info,
+					      spl_fit_next_loadable(fit, images,
+								    index + 1,
+								    spl_image));
 		if (ret < 0)
 			return ret;
 
@@ -851,7 +1547,15 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 
 		ret = spl_internal_load_simple_fit(spl_image, info,
 						   sector_offs, fit);
+#ifdef CONFIG_SPL_FIT_PIPELINE
+		/* Nothing may still be read in the background on return */
+		spl_fit_prefetch_cancel(info);
+#endif
 		if (!ret) {
+#ifdef CONFIG_SPL_ROCKCHIP_AMP
+			if (spl_load_amp_fit(spl_image, info))
+				printf("AMP: left to U-Boot\n");
+#endif
 #ifdef CONFIG_SPL_KERNEL_BOOT
 			ret = spl_load_kernel_fit(spl_image, info);
 #endif
@@ -53,6 +53,19 @@ static ulong h_spl_load_read(struct spl_load_info *load, ulong sector,
 	return blk_dread(load->dev, sector, count, buf);
 }
 
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+static ulong h_spl_load_read_async(struct spl_load_info *load, ulong sector,
+				   ulong count, void *buf)
+{
+	return blk_dread_async(load->dev, sector, count, buf);
+}
+
+static int h_spl_load_wait(struct spl_load_info *load)
+{
+	return blk_wait(load->dev);
+}
+#endif
+
 static __maybe_unused
 int mmc_load_image_raw_sector(struct spl_image_info *spl_image,
 			      struct mmc *mmc, unsigned long sector)
@@ -80,7 +93,7 @@ int mmc_load_image_raw_sector(struct spl_image_info *spl_image,
 	if (IS_ENABLED(CONFIG_SPL_LOAD_FIT) &&
 	    image_get_magic(header) == FDT_MAGIC) {
 #endif
-		struct spl_load_info load;
+		struct spl_load_info load = { 0 };
 
 		debug("Found FIT\n");
 		load.dev = mmc_get_blk_desc(mmc);
@@ -88,6 +101,10 @@ int mmc_load_image_raw_sector(struct spl_image_info *spl_image,
 		load.filename = NULL;
 		load.bl_len = mmc->read_bl_len;
 		load.read = h_spl_load_read;
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+		load.read_async = h_spl_load_read_async;
+		load.wait = h_spl_load_wait;
+#endif
 		ret = spl_load_simple_fit(spl_image, &load, sector, header);
 	} else {
 		ret = mmc_load_legacy(spl_image, mmc, sector, header);
@@ -300,7 +317,7 @@ int spl_mmc_load_image(struct spl_image_info *spl_image,
 	}
 
 #ifdef CONFIG_SPL_LOAD_RKFW
-	struct spl_load_info load;
+	struct spl_load_info load = { 0 };
 
 	load.dev = mmc_get_blk_desc(mmc);
 	load.priv = NULL;
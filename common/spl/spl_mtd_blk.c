@@ -79,7 +79,7 @@ static ulong mtd_spl_load_read(struct spl_load_info *load, ulong sector,
 #ifdef CONFIG_SPL_LOAD_RKFW
 int spl_mtd_load_rkfw(struct spl_image_info *spl_image, struct blk_desc *desc)
 {
-	struct spl_load_info load;
+	struct spl_load_info load = { 0 };
 	int ret;
 
 	load.dev = desc;
@@ -134,7 +134,7 @@ int spl_mtd_load_image(struct spl_image_info *spl_image,
 #else
 		if (image_get_magic(header) == FDT_MAGIC) {
 #endif
-			struct spl_load_info load;
+			struct spl_load_info load = { 0 };
 
 			load.dev = desc;
 			load.priv = NULL;
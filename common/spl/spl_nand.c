@@ -61,7 +61,7 @@ static int spl_nand_load_element(struct spl_image_info *spl_image,
 	int err;
 
 #ifdef CONFIG_SPL_LOAD_RKFW
-	struct spl_load_info load;
+	struct spl_load_info load = { 0 };
 	int ret;
 
 	load.dev = NULL;
@@ -86,7 +86,7 @@ static int spl_nand_load_element(struct spl_image_info *spl_image,
 	if (IS_ENABLED(CONFIG_SPL_LOAD_FIT) &&
 	    image_get_magic(header) == FDT_MAGIC) {
 #endif
-		struct spl_load_info load;
+		struct spl_load_info load = { 0 };
 
 		debug("Found FIT\n");
 		load.dev = NULL;
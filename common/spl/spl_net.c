@@ -55,7 +55,7 @@ static int spl_net_load_image(struct spl_image_info *spl_image,
 	if (IS_ENABLED(CONFIG_SPL_LOAD_FIT) &&
 	    image_get_magic(header) == FDT_MAGIC) {
 #endif
-		struct spl_load_info load;
+		struct spl_load_info load = { 0 };
 
 		debug("Found FIT\n");
 		load.bl_len = 1;
@@ -298,6 +298,86 @@ static int rkfw_load_uboot(struct spl_load_info *info, u32 image_sector,
 	return 0;
 }
 
+#ifdef CONFIG_SPL_ROCKCHIP_HW_DECOMPRESS
+/*
+ * Queue the decompression of an image just read, it runs on the engine
+ * while the next images are read. misc_decompress_cleanup() waits for
+ * all of them just before jumping to the kernel.
+ */
+static int rkfw_decompress(const char *name, ulong dst, ulong src,
+			   ulong src_len, ulong limit)
+{
+	u64 size = 0;
+	int ret;
+
+	ret = misc_decompress_process(dst, src, src_len, DECOM_GZIP, false,
+				      &size, 0);
+	if (ret) {
+		printf("SPL: %s decompress failed, ret=%d\n", name, ret);
+		return ret;
+	}
+
+	if (size > limit) {
+		printf("SPL: %s is 0x%llx bytes decompressed, over 0x%lx\n",
+		       name, size, limit);
+		return -EFBIG;
+	}
+
+	return 0;
+}
+#endif
+
+#ifdef CONFIG_SPL_KERNEL_BOOT
+/*
+ * Read the index of the resource image and then only the kernel dtb out
+ * of it, straight to its place.
+ */
+static int rkfw_load_resource_dtb(struct spl_load_info *info, u32 sector)
+{
+	struct resource_img_hdr *head;
+	struct resource_entry *entry;
+	int ret = -EIO;
+	int cnt;
+
+	head = memalign(ARCH_DMA_MINALIGN, 512);
+	if (!head)
+		return -ENOMEM;
+
+	if (info->read(info, sector, 1, head) != 1)
+		goto out;
+
+	if (spl_resource_image_check_header(head)) {
+		printf("Can't find kernel dtb in spl.");
+		ret = 0;
+		goto out;
+	}
+
+	cnt = head->blks + head->e_nums * head->e_blks;
+	free(head);
+	head = memalign(ARCH_DMA_MINALIGN, cnt * 512);
+	if (!head)
+		return -ENOMEM;
+
+	if (info->read(info, sector, cnt, head) != cnt)
+		goto out;
+
+	entry = spl_resource_image_get_dtb_entry(head);
+	if (!entry)
+		goto out;
+
+	cnt = DIV_ROUND_UP(entry->f_size, 512);
+	if (info->read(info, sector + entry->f_offset, cnt,
+		       (void *)CONFIG_SPL_FDT_ADDR) != cnt)
+		goto out;
+
+	ret = 0;
+out:
+	free(head);
+
+	return ret;
+}
+#endif
+
 static int rkfw_load_kernel(struct spl_load_info *info, u32 image_sector,
 			    struct spl_image_info *spl_image, u32 try_count)
 {
@@ -331,6 +411,11 @@ static int rkfw_load_kernel(struct spl_load_info *info, u32 image_sector,
 	image_sector = image_sector + cnt;
 	cnt = ALIGN(hdr->kernel_size, hdr->page_size) >> 9;
 
+	/*
+	 * Each image is read while the engine decompresses the ones before,
+	 * nothing waits for the engine before the jump to the kernel.
+	 */
+
 	/* Load kernel image */
 #ifdef CONFIG_SPL_ROCKCHIP_HW_DECOMPRESS
 	ret = info->read(info, image_sector, cnt,
@@ -343,20 +428,12 @@ static int rkfw_load_kernel(struct spl_load_info *info, u32 image_sector,
 		goto out;
 	}
 #ifdef CONFIG_SPL_ROCKCHIP_HW_DECOMPRESS
-	struct udevice *dev;
-	u32 cap = DECOM_GZIP;
-
-	dev = misc_decompress_get_device(cap);
-
-	if (!dev)
-		goto out;
-
-	ret = misc_decompress_start(dev, CONFIG_SPL_KERNEL_COMPRESS_ADDR,
-				    CONFIG_SPL_KERNEL_ADDR,
-				    CONFIG_SPL_KERNEL_DECOM_LIMIT_SIZE);
+	ret = rkfw_decompress("kernel", CONFIG_SPL_KERNEL_ADDR,
+			      CONFIG_SPL_KERNEL_COMPRESS_ADDR,
+			      hdr->kernel_size,
+			      CONFIG_SPL_KERNEL_DECOM_LIMIT_SIZE);
 	if (ret)
 		goto out;
-
 #endif
 
 	/* Load ramdisk image */
@@ -375,74 +452,23 @@ static int rkfw_load_kernel(struct spl_load_info *info, u32 image_sector,
 			goto out;
 		}
 #ifdef CONFIG_SPL_ROCKCHIP_HW_DECOMPRESS
-		int timeout = 10000;
-
-		while (!misc_decompress_is_complete(dev)) {
-			if (timeout < 0) {
-				ret = -EIO;
-				goto out;
-			}
-
-			timeout--;
-			udelay(10);
-		}
-
-		ret = misc_decompress_stop(dev);
-		if (ret)
-			goto out;
-
-		ret = misc_decompress_start(dev,
-					    CONFIG_SPL_RAMDISK_COMPRESS_ADDR,
-					    CONFIG_SPL_RAMDISK_ADDR,
-					    CONFIG_SPL_RAMDISK_DECOM_LIMIT_SIZE);
+		/* Queued behind the kernel on the engine */
+		ret = rkfw_decompress("ramdisk", CONFIG_SPL_RAMDISK_ADDR,
+				      CONFIG_SPL_RAMDISK_COMPRESS_ADDR,
+				      hdr->ramdisk_size,
+				      CONFIG_SPL_RAMDISK_DECOM_LIMIT_SIZE);
 		if (ret)
 			goto out;
 #endif
 	}
-#ifdef CONFIG_SPL_ROCKCHIP_HW_DECOMPRESS
-	else {
-		int timeout = 10000;
 
-		while (!misc_decompress_is_complete(dev)) {
-			if (timeout < 0) {
-				ret = -EIO;
-				goto out;
-			}
-
-			timeout--;
-			udelay(10);
-		}
-	}
-#endif
 	/* Load resource, and checkout the dtb */
 	if (hdr->second_size) {
-		struct resource_img_hdr *head =
-		   (struct resource_img_hdr *)(CONFIG_SPL_FDT_ADDR + 0x100000);
-
-		ret = info->read(info, (resource_sector >> 9) + image_sector,
-				 ALIGN(hdr->second_size, hdr->page_size) >> 9,
-				 (void *)head);
-		if (ret != (ALIGN(hdr->second_size, hdr->page_size) >> 9)) {
-			ret = -EIO;
-			goto out;
-		}
 #ifdef CONFIG_SPL_KERNEL_BOOT
-		if (spl_resource_image_check_header(head)) {
-			printf("Can't find kernel dtb in spl.");
-		} else {
-			struct resource_entry *entry;
-			char *dtb_temp;
-
-			entry = spl_resource_image_get_dtb_entry(head);
-			if (!entry) {
-				ret = -EIO;
-				goto out;
-			}
-
-			dtb_temp = (char *)((char *)head + entry->f_offset * 512);
-			memcpy((char *)CONFIG_SPL_FDT_ADDR, dtb_temp,
-			       entry->f_size);
-		}
+		ret = rkfw_load_resource_dtb(info,
+					     (resource_sector >> 9) + image_sector);
+		if (ret)
+			goto out;
 #endif
 	} else {
 		/* Load dtb image */
@@ -54,7 +54,7 @@ static int spl_rknand_load_image(struct spl_image_info *spl_image,
 {
 	lbaint_t image_sector = CONFIG_RKNAND_BLK_U_BOOT_OFFS;
 	struct image_header *header;
-	struct spl_load_info load;
+	struct spl_load_info load = { 0 };
 	struct blk_desc *desc;
 	int ret = -1;
 
@@ -31,7 +31,7 @@ static int spl_ufs_load_image(struct spl_image_info *spl_image,
 	int ret;
 	struct blk_desc *desc;
 	struct image_header *header;
-	struct spl_load_info load;
+	struct spl_load_info load = { 0 };
 
 	/* try to recognize storage devices immediately */
 	ufs_probe();
@@ -92,7 +92,7 @@ static int spl_ymodem_load_image(struct spl_image_info *spl_image,
 
 	if (IS_ENABLED(CONFIG_SPL_LOAD_FIT) &&
 	    image_get_magic((struct image_header *)buf) == FDT_MAGIC) {
-		struct spl_load_info load;
+		struct spl_load_info load = { 0 };
 		struct ymodem_fit_info info;
 
 		debug("Found FIT\n");
@@ -5,4 +5,9 @@
  * Licensed under the GPL-2 or later.
  */
 
-const char const system_map[] = SYSTEM_MAP;
+/*
+ * Generated from the System.map at link time: kallsyms_num text symbols,
+ * their addresses in ascending order, and for each the offset of its name
+ * in kallsyms_names.
+ */
+#include "system_map.inc"
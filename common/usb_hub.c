@@ -56,6 +56,7 @@ struct usb_device_scan {
 };
 
 static LIST_HEAD(usb_scan_list);
+static bool usb_scan_deferred;	/* see usb_hub_scan_defer() */
 
 __weak void usb_hub_reset_devices(struct usb_hub_device *hub, int port)
 {
@@ -581,7 +582,7 @@ static int usb_device_list_scan(void)
 	int ret = 0;
 
 	/* Only run this loop once for each controller */
-	if (running)
+	if (running || usb_scan_deferred)
 		return 0;
 
 	running = 1;
@@ -612,6 +613,15 @@ out:
 	return ret;
 }
 
+int usb_hub_scan_defer(bool defer)
+{
+	usb_scan_deferred = defer;
+	if (defer)
+		return 0;
+
+	return usb_device_list_scan();
+}
+
 static struct usb_hub_device *usb_get_hub_device(struct usb_device *dev)
 {
 	struct usb_hub_device *hub;
@@ -965,6 +965,11 @@ static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 	size_t size;
 	int ret;
 
+#ifdef CONFIG_USB_STORAGE_SS_MAX_XFER_BLK
+	if (udev->speed >= USB_SPEED_SUPER)
+		blk = CONFIG_USB_STORAGE_SS_MAX_XFER_BLK;
+#endif
+
 	ret = usb_get_max_xfer_size(udev, (size_t *)&size);
 	if ((ret >= 0) && (size < blk * 512))
 		blk = size / 512;
@@ -232,6 +232,142 @@ void dev_print (struct blk_desc *dev_desc)
 }
 #endif
 
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+/*
+ * The parsed partition table of a block device, for the name lookups of
+ * the boot flow. parts[i] is partition i + 1, up to the first one that the
+ * driver fails on, which is where the lookup by name always stopped. The
+ * hash holds the index of each name plus 1, 0 for a free slot.
+ */
+struct part_cache {
+	int hwpart;
+	int part_type;
+	int count;
+	uint hash_size;		/* power of 2 */
+	disk_partition_t *parts;
+	u16 *hash;
+};
+
+void part_cache_invalidate(struct blk_desc *dev_desc)
+{
+	struct part_cache *pc = dev_desc->part_cache;
+
+	if (!pc)
+		return;
+
+	free(pc->parts);
+	free(pc->hash);
+	free(pc);
+	dev_desc->part_cache = NULL;
+}
+
+#ifdef HAVE_BLOCK_DEVICE
+/* FNV-1a */
+static uint part_cache_hash(const char *name, uint size)
+{
+	u32 hash = 2166136261U;
+
+	while (*name)
+		hash = (hash ^ (u8)*name++) * 16777619U;
+
+	return hash & (size - 1);
+}
+
+/* The slot of @name, or the free slot where it would go */
+static u16 *part_cache_slot(struct part_cache *pc, const char *name)
+{
+	uint i = part_cache_hash(name, pc->hash_size);
+
+	while (pc->hash[i] &&
+	       strcmp((const char *)pc->parts[pc->hash[i] - 1].name, name))
+		i = (i + 1) & (pc->hash_size - 1);
+
+	return &pc->hash[i];
+}
+
+/* The cache of @dev_desc if it is still for the table in use, or NULL */
+static struct part_cache *part_cache_peek(struct blk_desc *dev_desc)
+{
+	struct part_cache *pc = dev_desc->part_cache;
+
+	if (pc && pc->hwpart == dev_desc->hwpart &&
+	    pc->part_type == dev_desc->part_type)
+		return pc;
+
+	return NULL;
+}
+
+static struct part_cache *part_cache_get(struct blk_desc *dev_desc,
+					 struct part_driver *drv)
+{
+	struct part_cache *pc = part_cache_peek(dev_desc);
+	disk_partition_t *parts;
+	u16 *slot;
+	int i;
+
+	if (pc)
+		return pc;
+
+	/* Another hardware partition or table type, parse it again */
+	part_cache_invalidate(dev_desc);
+
+	pc = calloc(1, sizeof(*pc));
+	if (!pc)
+		return NULL;
+
+	for (i = 1; i < drv->max_entries; i++) {
+		if (pc->count % 16 == 0) {
+			parts = realloc(pc->parts,
+					(pc->count + 16) * sizeof(*parts));
+			if (!parts)
+				goto err;
+			pc->parts = parts;
+		}
+		parts = &pc->parts[pc->count];
+#if CONFIG_IS_ENABLED(PARTITION_UUIDS)
+		parts->uuid[0] = 0;
+#endif
+#ifdef CONFIG_PARTITION_TYPE_GUID
+		parts->type_guid[0] = 0;
+#endif
+		if (drv->get_info(dev_desc, i, parts))
+			break;
+		pc->count++;
+	}
+
+	/* Nothing to gain from caching a table that can't be read */
+	if (!pc->count)
+		goto err;
+
+	pc->hash_size = 16;
+	while (pc->hash_size < pc->count * 2)
+		pc->hash_size <<= 1;
+	pc->hash = calloc(pc->hash_size, sizeof(*pc->hash));
+	if (!pc->hash)
+		goto err;
+
+	/* Names may repeat, the first one wins as in a walk of the table */
+	for (i = 0; i < pc->count; i++) {
+		slot = part_cache_slot(pc, (const char *)pc->parts[i].name);
+		if (!*slot)
+			*slot = i + 1;
+	}
+
+	pc->hwpart = dev_desc->hwpart;
+	pc->part_type = dev_desc->part_type;
+	dev_desc->part_cache = pc;
+
+	return pc;
+
+err:
+	free(pc->parts);
+	free(pc);
+
+	return NULL;
+}
+#endif /* HAVE_BLOCK_DEVICE */
+#endif /* CONFIG_PARTITION_CACHE */
+
 #ifdef HAVE_BLOCK_DEVICE
 
 void part_init(struct blk_desc *dev_desc)
@@ -242,6 +378,7 @@ void part_init(struct blk_desc *dev_desc)
 	struct part_driver *entry;
 
 	blkcache_invalidate(dev_desc->if_type, dev_desc->devnum);
+	part_cache_invalidate(dev_desc);
 
 	dev_desc->part_type = PART_TYPE_UNKNOWN;
 	for (entry = drv; entry != drv + n_ents; entry++) {
@@ -350,6 +487,9 @@ int part_get_info(struct blk_desc *dev_desc, int part,
 {
 #ifdef HAVE_BLOCK_DEVICE
 	struct part_driver *drv;
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+	struct part_cache *pc;
+#endif
 
 #if CONFIG_IS_ENABLED(PARTITION_UUIDS)
 	/* The common case is no UUID support */
@@ -365,6 +505,13 @@ int part_get_info(struct blk_desc *dev_desc, int part,
 		      dev_desc->part_type);
 		return -EPROTONOSUPPORT;
 	}
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+	pc = part_cache_peek(dev_desc);
+	if (pc && part >= 1 && part <= pc->count) {
+		*info = pc->parts[part - 1];
+		return 0;
+	}
+#endif
 	if (!drv->get_info) {
 		PRINTF("## Driver %s does not have the get_info() method\n",
 		       drv->name);
@@ -674,6 +821,40 @@ cleanup:
 	return ret;
 }
 
+static int part_lookup_name(struct blk_desc *dev_desc,
+			    struct part_driver *part_drv,
+			    const char *name, disk_partition_t *info)
+{
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+	struct part_cache *pc;
+	u16 *slot;
+#endif
+	int i;
+
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+	pc = part_cache_get(dev_desc, part_drv);
+	if (pc) {
+		slot = part_cache_slot(pc, name);
+		if (!*slot)
+			return -1;
+		*info = pc->parts[*slot - 1];
+		return *slot;
+	}
+#endif
+	for (i = 1; i < part_drv->max_entries; i++) {
+		if (part_drv->get_info(dev_desc, i, info)) {
+			/* no more entries in table */
+			break;
+		}
+		if (strcmp(name, (const char *)info->name) == 0) {
+			/* matched */
+			return i;
+		}
+	}
+
+	return -1;
+}
+
 /*
  * For android A/B system, we append the current slot suffix quietly,
  * this takes over the responsibility of slot suffix appending from
@@ -688,7 +869,7 @@ static int part_get_info_by_name_option(struct blk_desc *dev_desc,
 	struct part_driver *part_drv;
 	const char *full_name = name;
 	int none_slot_try = 1;
-	int ret, i;
+	int ret;
 
 	part_drv = part_driver_lookup_type(dev_desc);
 	if (!part_drv)
@@ -718,17 +899,9 @@ static int part_get_info_by_name_option(struct blk_desc *dev_desc,
 
 lookup:
 	debug("## Query partition(%d): %s\n", none_slot_try, full_name);
-	for (i = 1; i < part_drv->max_entries; i++) {
-		ret = part_drv->get_info(dev_desc, i, info);
-		if (ret != 0) {
-			/* no more entries in table */
-			break;
-		}
-		if (strcmp(full_name, (const char *)info->name) == 0) {
-			/* matched */
-			return i;
-		}
-	}
+	ret = part_lookup_name(dev_desc, part_drv, full_name, info);
+	if (ret > 0)
+		return ret;
 
 	/* 2. Query partition without A/B slot suffix if above failed */
 	if (none_slot_try) {
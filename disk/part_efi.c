@@ -280,11 +280,31 @@ void part_print_efi(struct blk_desc *dev_desc)
 	return;
 }
 
+/*
+ * The GPT last read by part_get_info_efi(), for the device and hardware
+ * partition it was read from.
+ */
+static struct {
+	struct blk_desc *dev_desc;
+	int hwpart;
+	gpt_header *head;
+	gpt_entry *pte;
+} gpt_cache;
+
+static void gpt_cache_drop(void)
+{
+	free(gpt_cache.pte);
+	gpt_cache.pte = NULL;
+	free(gpt_cache.head);
+	gpt_cache.head = NULL;
+	gpt_cache.dev_desc = NULL;
+}
+
 int part_get_info_efi(struct blk_desc *dev_desc, int part,
 		      disk_partition_t *info)
 {
-	static gpt_entry *gpt_pte = NULL;
-	static gpt_header *gpt_head = NULL;
+	gpt_entry *gpt_pte;
+	gpt_header *gpt_head;
 	int sector, b_gpt_nsec = 0x22;
 
 	if (!dev_desc->rawblksz || !dev_desc->rawlba) {
@@ -295,24 +315,22 @@ int part_get_info_efi(struct blk_desc *dev_desc, int part,
 	if (dev_desc->rawblksz == 4096)
 		b_gpt_nsec = 6;
 
-	if (!gpt_head)
-		gpt_head = memalign(ARCH_DMA_MINALIGN, dev_desc->rawblksz);
-
 	/*
-	 * We suppose different dev have different size, eg. emmc vs sd
-	 * free the pte first if exist and then will malloc and init a new one.
+	 * Read the GPT again for another device or hardware partition, and
+	 * for one which no longer fits the device, e.g. a replaced SD card.
 	 */
-	if (gpt_head && (gpt_head->last_usable_lba + b_gpt_nsec) != dev_desc->rawlba) {
-		if (dev_desc->rawblksz == 4096) {
-			/* realloc gpt header buffer */
-			free(gpt_head);
-			gpt_head = memalign(ARCH_DMA_MINALIGN, dev_desc->rawblksz);
-		}
-		if (gpt_pte)
-			free(gpt_pte);
-		gpt_pte = NULL;
+	if (gpt_cache.dev_desc != dev_desc ||
+	    gpt_cache.hwpart != dev_desc->hwpart ||
+	    (gpt_cache.head &&
+	     (gpt_cache.head->last_usable_lba + b_gpt_nsec) != dev_desc->rawlba)) {
+		gpt_cache_drop();
+		gpt_cache.dev_desc = dev_desc;
+		gpt_cache.hwpart = dev_desc->hwpart;
 	}
 
+	if (!gpt_cache.head)
+		gpt_cache.head = memalign(ARCH_DMA_MINALIGN, dev_desc->rawblksz);
+
 	/* "part" argument must be at least 1 */
 	if (part < 1) {
 		printf("%s: Invalid Argument(s)\n", __func__);
@@ -321,10 +339,10 @@ int part_get_info_efi(struct blk_desc *dev_desc, int part,
 
 	/* This function validates AND fills in the GPT header and PTE */
 	if (is_gpt_valid(dev_desc, GPT_PRIMARY_PARTITION_TABLE_LBA,
-			gpt_head, &gpt_pte) != 1) {
+			gpt_cache.head, &gpt_cache.pte) != 1) {
 		printf("%s: *** ERROR: Invalid GPT ***\n", __func__);
 		if (is_gpt_valid(dev_desc, (dev_desc->rawlba - 1),
-				 gpt_head, &gpt_pte) != 1) {
+				 gpt_cache.head, &gpt_cache.pte) != 1) {
 			printf("%s: *** ERROR: Invalid Backup GPT ***\n",
 			       __func__);
 			return -1;
@@ -333,6 +351,8 @@ int part_get_info_efi(struct blk_desc *dev_desc, int part,
 			       __func__);
 		}
 	}
+	gpt_head = gpt_cache.head;
+	gpt_pte = gpt_cache.pte;
 
 	if (part > le32_to_cpu(gpt_head->num_partition_entries) ||
 	    !is_pte_valid(&gpt_pte[part - 1])) {
@@ -442,6 +462,10 @@ static int part_efi_repair(struct blk_desc *dev_desc, gpt_entry *gpt_pte,
 			printf("*** ERROR: Can't write entry partitions ***\n");
 			return -1;
 		}
+		if (blk_flush(dev_desc)) {
+			printf("*** ERROR: Can't flush the GPT ***\n");
+			return -1;
+		}
 		printf("Repair the backup gpt table OK!\n");
 	} else if (head_gpt_valid == 0 && backup_gpt_valid == 1) {
 		gpt_head->header_crc32 = 0;
@@ -480,6 +504,10 @@ static int part_efi_repair(struct blk_desc *dev_desc, gpt_entry *gpt_pte,
 			printf("*** ERROR: Can't write entry partitions ***\n");
 			return -1;
 		}
+		if (blk_flush(dev_desc)) {
+			printf("*** ERROR: Can't flush the GPT ***\n");
+			return -1;
+		}
 		printf("Repair the Primary gpt table OK!\n");
 	}
 
@@ -492,6 +520,9 @@ static int part_test_efi(struct blk_desc *dev_desc)
 {
 	int ret = 0;
 
+	/* Probing, possibly repairing, the table: read it again later */
+	gpt_cache_drop();
+
 	if (!dev_desc->rawblksz || !dev_desc->rawlba) {
 		dev_desc->rawblksz = dev_desc->blksz;
 		dev_desc->rawlba = dev_desc->lba;
@@ -604,6 +635,9 @@ int write_gpt_table(struct blk_desc *dev_desc,
 					   * sizeof(gpt_entry)), dev_desc);
 	u32 calc_crc32, sector;
 
+	gpt_cache_drop();
+	part_cache_invalidate(dev_desc);
+
 	sector = dev_desc->rawblksz / dev_desc->blksz;
 
 	debug("max lba: %x\n", (u32) dev_desc->rawlba);
@@ -639,6 +673,9 @@ int write_gpt_table(struct blk_desc *dev_desc,
 		       gpt_h) != 1)
 		goto err;
 
+	if (blk_flush(dev_desc))
+		goto err;
+
 	debug("GPT successfully written to block device!\n");
 	return 0;
 
@@ -1057,6 +1094,9 @@ int write_mbr_and_gpt_partitions(struct blk_desc *dev_desc, void *buf)
 	if (is_valid_gpt_buf(dev_desc, buf))
 		return -1;
 
+	gpt_cache_drop();
+	part_cache_invalidate(dev_desc);
+
 	/* determine start of GPT Header in the buffer */
 	gpt_h = buf + (GPT_PRIMARY_PARTITION_TABLE_LBA *
 		       dev_desc->rawblksz);
@@ -1113,6 +1153,11 @@ int write_mbr_and_gpt_partitions(struct blk_desc *dev_desc, void *buf)
 		return 1;
 	}
 
+	if (blk_flush(dev_desc)) {
+		printf("%s: failed to flush the GPT\n", __func__);
+		return 1;
+	}
+
 	return 0;
 }
 #endif
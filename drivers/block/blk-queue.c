@@ -0,0 +1,171 @@
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <blk_queue.h>
+#include <dm.h>
+#include <errno.h>
+
+void blk_queue_init(struct blk_queue *q, const struct blk_rq_ops *ops,
+		    uint depth, lbaint_t max_blocks)
+{
+	memset(q, 0, sizeof(*q));
+	q->ops = ops;
+	q->depth = clamp_t(uint, depth, 1, BLK_QUEUE_MAX_DEPTH);
+	q->max_blocks = max_blocks;
+}
+
+static int blk_queue_free_tag(struct blk_queue *q)
+{
+	int tag;
+
+	for (tag = 0; tag < q->depth; tag++) {
+		if (!(q->busy & BIT(tag)))
+			return tag;
+	}
+
+	return -EBUSY;
+}
+
+/*
+ * Submit the requests for [@start, @start + @blkcnt) while there are free
+ * tags, return the number of blocks submitted or -ve if a submit failed
+ * before any was.
+ */
+static long blk_queue_fill(struct udevice *dev, struct blk_queue *q,
+			   lbaint_t start, lbaint_t blkcnt, void *buffer,
+			   bool write)
+{
+	struct blk_desc *desc = dev_get_uclass_platdata(dev);
+	lbaint_t done = 0;
+	struct blk_rq *rq;
+	int tag, ret;
+
+	while (done < blkcnt) {
+		tag = blk_queue_free_tag(q);
+		if (tag < 0)
+			break;
+
+		rq = &q->rq[tag];
+		rq->tag = tag;
+		rq->start = start + done;
+		rq->blkcnt = min(blkcnt - done, q->max_blocks);
+		rq->buffer = buffer + done * desc->blksz;
+		rq->write = write;
+		rq->error = 0;
+		ret = q->ops->submit(dev, rq);
+		if (ret)
+			return done ? done : ret;
+
+		q->busy |= BIT(tag);
+		done += rq->blkcnt;
+	}
+
+	return done;
+}
+
+/*
+ * Wait for one request, return the first block of it if it failed, else
+ * @end. If nothing completes, all requests in flight fail.
+ */
+static lbaint_t blk_queue_reap(struct udevice *dev, struct blk_queue *q,
+			       lbaint_t end)
+{
+	int tag;
+
+	tag = q->ops->complete(dev, q);
+	if (tag < 0 || tag >= q->depth || !(q->busy & BIT(tag))) {
+		for (tag = 0; tag < q->depth; tag++) {
+			if (q->busy & BIT(tag))
+				end = min(end, q->rq[tag].start);
+		}
+		q->busy = 0;
+		return end;
+	}
+
+	q->busy &= ~BIT(tag);
+
+	return q->rq[tag].error ? q->rq[tag].start : end;
+}
+
+ulong blk_queue_rw(struct udevice *dev, struct blk_queue *q, lbaint_t start,
+		   lbaint_t blkcnt, void *buffer, bool write)
+{
+	struct blk_desc *desc = dev_get_uclass_platdata(dev);
+	lbaint_t end = start + blkcnt, first_bad = end;
+	lbaint_t next = start;
+	struct bounce_buffer bb;
+	long ret;
+
+	if (q->async)
+		blk_queue_wait(dev, q);
+
+	ret = bounce_buffer_start(&bb, buffer, blkcnt * desc->blksz,
+				  write ? GEN_BB_READ : GEN_BB_WRITE);
+	if (ret)
+		return -ENOMEM;
+
+	while (q->busy || (next < end && first_bad == end)) {
+		if (next < end && first_bad == end &&
+		    q->busy != GENMASK(q->depth - 1, 0)) {
+			ret = blk_queue_fill(dev, q, next, end - next,
+					     bb.bounce_buffer +
+					     (next - start) * desc->blksz,
+					     write);
+			if (ret < 0)
+				first_bad = next;
+			else
+				next += ret;
+			if (ret)
+				continue;
+		}
+		first_bad = min(first_bad, blk_queue_reap(dev, q, end));
+	}
+
+	bounce_buffer_stop(&bb);
+
+	return min(first_bad, next) - start;
+}
+
+ulong blk_queue_read_async(struct udevice *dev, struct blk_queue *q,
+			   lbaint_t start, lbaint_t blkcnt, void *buffer)
+{
+	struct blk_desc *desc = dev_get_uclass_platdata(dev);
+	long ret;
+
+	if (q->async)
+		blk_queue_wait(dev, q);
+
+	blkcnt = min(blkcnt, (lbaint_t)q->depth * q->max_blocks);
+	if (bounce_buffer_start(&q->bb, buffer, blkcnt * desc->blksz,
+				GEN_BB_WRITE))
+		return -ENOMEM;
+
+	ret = blk_queue_fill(dev, q, start, blkcnt, q->bb.bounce_buffer,
+			     false);
+	if (ret <= 0) {
+		bounce_buffer_stop(&q->bb);
+		return ret;
+	}
+	q->async = true;
+
+	return ret;
+}
+
+int blk_queue_wait(struct udevice *dev, struct blk_queue *q)
+{
+	lbaint_t bad = -1;
+
+	if (!q->async)
+		return 0;
+
+	while (q->busy)
+		bad = min(bad, blk_queue_reap(dev, q, (lbaint_t)-1));
+	bounce_buffer_stop(&q->bb);
+	q->async = false;
+
+	return bad == (lbaint_t)-1 ? 0 : -EIO;
+}
@@ -11,6 +11,8 @@
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <dm/uclass-internal.h>
+#include <linux/sizes.h>
+#include <video_rockchip.h>
 
 static const char *if_typename_str[IF_TYPE_COUNT] = {
 	[IF_TYPE_IDE]		= "ide",
@@ -357,12 +359,20 @@ ulong blk_erase_devnum(enum if_type if_type, int devnum, lbaint_t start,
 int blk_select_hwpart(struct udevice *dev, int hwpart)
 {
 	const struct blk_ops *ops = blk_get_ops(dev);
+	struct blk_desc *desc = dev_get_uclass_platdata(dev);
 
 	if (!ops)
 		return -ENOSYS;
 	if (!ops->select_hwpart)
 		return 0;
 
+	/*
+	 * The cache only knows the device, so its blocks and pending writes
+	 * are those of the current hwpart: write them back and drop them.
+	 */
+	if (desc->hwpart != hwpart)
+		blkcache_invalidate(desc->if_type, desc->devnum);
+
 	return ops->select_hwpart(dev, hwpart);
 }
 
@@ -446,25 +456,226 @@ int blk_get_device(int if_type, int devnum, struct udevice **devp)
 	return device_probe(*devp);
 }
 
+#if CONFIG_IS_ENABLED(BLK_STATS)
+static const char *const blk_stats_names[BLK_STATS_OPS] = {
+	"read", "write", "erase",
+};
+
+/*
+ * Counted on the uclass blk_desc, like write_gen, so that the I/O of ums
+ * and rockusb through their copies of it adds up with everybody else's
+ */
+static void blk_stats_time(struct udevice *dev, enum blk_stats_op op,
+			   ulong start_us)
+{
+	struct blk_desc *desc = dev_get_uclass_platdata(dev);
+	struct blk_op_stats *st = &desc->stats[op];
+	ulong us = timer_get_us() - start_us;
+
+	st->time_us += us;
+	st->max_us = max(st->max_us, us);
+}
+
+static void blk_stats_add(struct udevice *dev, enum blk_stats_op op,
+			  ulong blkcnt, ulong start_us)
+{
+	struct blk_desc *desc = dev_get_uclass_platdata(dev);
+	struct blk_op_stats *st = &desc->stats[op];
+	u64 bytes;
+	int i;
+
+	blk_stats_time(dev, op, start_us);
+	st->ops++;
+	if (IS_ERR_VALUE(blkcnt))
+		return;
+
+	st->blocks += blkcnt;
+	bytes = (u64)blkcnt * desc->blksz;
+	for (i = 0; i < BLK_STATS_BUCKETS - 1; i++) {
+		if (bytes <= (u64)SZ_4K << (2 * i))
+			break;
+	}
+	st->hist[i]++;
+}
+
+void blk_stats_show(void)
+{
+	static const char *const sizes[BLK_STATS_BUCKETS] = {
+		"4K", "16K", "64K", "256K", "1M", "4M", ">4M",
+	};
+	struct udevice *dev;
+	struct uclass *uc;
+	char name[16];
+	int op, i;
+
+	if (uclass_get(UCLASS_BLK, &uc))
+		return;
+
+	printf("%-8s %-5s %8s %10s %9s %8s %9s\n", "Device", "Op", "Requests",
+	       "KiB", "Time(ms)", "Max(ms)", "KiB/s");
+	uclass_foreach_dev(dev, uc) {
+		struct blk_desc *desc = dev_get_uclass_platdata(dev);
+
+		snprintf(name, sizeof(name), "%s%d",
+			 blk_get_if_type_name(desc->if_type), desc->devnum);
+		for (op = 0; op < BLK_STATS_OPS; op++) {
+			struct blk_op_stats *st = &desc->stats[op];
+			u64 kib = (st->blocks * desc->blksz) >> 10;
+
+			if (!st->ops)
+				continue;
+			printf("%-8s %-5s %8lu %10llu %9llu %8lu %9llu\n", name,
+			       blk_stats_names[op], st->ops, kib,
+			       st->time_us / 1000, st->max_us / 1000,
+			       st->time_us ? kib * 1000000 / st->time_us : 0);
+			printf("%14s", "sizes");
+			for (i = 0; i < BLK_STATS_BUCKETS; i++) {
+				if (st->hist[i])
+					printf(" %s:%lu", sizes[i], st->hist[i]);
+			}
+			printf("\n");
+		}
+	}
+}
+
+void blk_stats_reset(void)
+{
+	struct udevice *dev;
+	struct uclass *uc;
+
+	if (uclass_get(UCLASS_BLK, &uc))
+		return;
+
+	uclass_foreach_dev(dev, uc) {
+		struct blk_desc *desc = dev_get_uclass_platdata(dev);
+
+		memset(desc->stats, 0, sizeof(desc->stats));
+	}
+}
+
+void blk_stats_bootstage(int digits)
+{
+	struct udevice *dev;
+	struct uclass *uc;
+	int op;
+
+	if (uclass_get(UCLASS_BLK, &uc))
+		return;
+
+	uclass_foreach_dev(dev, uc) {
+		struct blk_desc *desc = dev_get_uclass_platdata(dev);
+
+		for (op = 0; op < BLK_STATS_OPS; op++) {
+			if (!desc->stats[op].ops)
+				continue;
+			printf("%11s", "");
+			print_grouped_ull(desc->stats[op].time_us, digits);
+			printf("  %s %s%d\n", blk_stats_names[op],
+			       blk_get_if_type_name(desc->if_type),
+			       desc->devnum);
+		}
+	}
+}
+#else
+static inline void blk_stats_time(struct udevice *dev, enum blk_stats_op op,
+				  ulong start_us)
+{
+}
+
+static inline void blk_stats_add(struct udevice *dev, enum blk_stats_op op,
+				 ulong blkcnt, ulong start_us)
+{
+}
+#endif
+
+static ulong blk_read_dev(struct blk_desc *block_dev, lbaint_t start,
+			  lbaint_t blkcnt, void *buffer)
+{
+	struct udevice *dev = block_dev->bdev;
+	ulong start_us = timer_get_us();
+	ulong ret;
+
+	bootstage_start(BOOTSTAGE_ID_ACCUM_READ, "read");
+	ret = blk_get_ops(dev)->read(dev, start, blkcnt, buffer);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_READ);
+	blk_stats_add(dev, BLK_STATS_READ, ret, start_us);
+
+	return ret;
+}
+
+#ifdef CONFIG_DRM_ROCKCHIP_ASYNC_ENABLE
+/*
+ * Large reads, like the kernel's, are split while a display is still
+ * powering its panel up, for it to go on in between.
+ */
+#define BLK_DREAD_POLL_SIZE	SZ_4M
+
+static ulong blk_dread_poll(struct blk_desc *block_dev, lbaint_t start,
+			    lbaint_t blkcnt, void *buffer)
+{
+	lbaint_t chunk = BLK_DREAD_POLL_SIZE / block_dev->blksz;
+	lbaint_t done = 0;
+	ulong ret;
+
+	while (blkcnt - done > chunk && rockchip_display_poll() == -EAGAIN) {
+		ret = blkcache_dread(block_dev, start + done, chunk,
+				     buffer + done * block_dev->blksz,
+				     blk_read_dev);
+		if (IS_ERR_VALUE(ret))
+			return done ? done : ret;
+		done += ret;
+		if (ret != chunk)
+			return done;
+	}
+
+	ret = blkcache_dread(block_dev, start + done, blkcnt - done,
+			     buffer + done * block_dev->blksz, blk_read_dev);
+	if (IS_ERR_VALUE(ret))
+		return done ? done : ret;
+	rockchip_display_poll();
+
+	return done + ret;
+}
+#endif
+
 unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 			lbaint_t blkcnt, void *buffer)
 {
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
-	ulong blks_read;
 
 	if (!ops->read)
 		return -ENOSYS;
 
-	if (blkcache_read(block_dev->if_type, block_dev->devnum,
-			  start, blkcnt, block_dev->blksz, buffer))
-		return blkcnt;
-	blks_read = ops->read(dev, start, blkcnt, buffer);
-	if (blks_read == blkcnt)
-		blkcache_fill(block_dev->if_type, block_dev->devnum,
-			      start, blkcnt, block_dev->blksz, buffer);
+#ifdef CONFIG_DRM_ROCKCHIP_ASYNC_ENABLE
+	return blk_dread_poll(block_dev, start, blkcnt, buffer);
+#else
+	return blkcache_dread(block_dev, start, blkcnt, buffer, blk_read_dev);
+#endif
+}
+
+static ulong blk_write_dev(struct blk_desc *block_dev, lbaint_t start,
+			   lbaint_t blkcnt, const void *buffer)
+{
+	struct udevice *dev = block_dev->bdev;
+	ulong start_us = timer_get_us();
+	ulong ret;
+
+	ret = blk_get_ops(dev)->write(dev, start, blkcnt, buffer);
+	blk_stats_add(dev, BLK_STATS_WRITE, ret, start_us);
+
+	return ret;
+}
+
+/*
+ * Counted on the uclass blk_desc, since ums and rockusb write through
+ * copies of it, for the caches above the device to notice writes
+ */
+static void blk_bump_write_gen(struct udevice *dev)
+{
+	struct blk_desc *desc = dev_get_uclass_platdata(dev);
 
-	return blks_read;
+	desc->write_gen++;
 }
 
 unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
@@ -476,8 +687,8 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 	if (!ops->write)
 		return -ENOSYS;
 
-	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
-	return ops->write(dev, start, blkcnt, buffer);
+	blk_bump_write_gen(dev);
+	return blkcache_dwrite(block_dev, start, blkcnt, buffer, blk_write_dev);
 }
 
 unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
@@ -485,13 +696,118 @@ unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 {
 	struct udevice *dev = block_dev->bdev;
 	const struct blk_ops *ops = blk_get_ops(dev);
+	ulong start_us, ret;
 
 	if (!ops->erase)
 		return -ENOSYS;
 
+	blk_bump_write_gen(dev);
 	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
-	return ops->erase(dev, start, blkcnt);
+	start_us = timer_get_us();
+	ret = ops->erase(dev, start, blkcnt);
+	blk_stats_add(dev, BLK_STATS_ERASE, ret, start_us);
+
+	return ret;
+}
+
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC) || CONFIG_IS_ENABLED(BLK_READ_SG)
+/*
+ * Reads that go around blkcache_dread() must see the pending writes of
+ * BLOCK_CACHE_WRITEBACK, so write them back first
+ */
+static int blk_flush_range(struct blk_desc *block_dev, lbaint_t start,
+			   lbaint_t blkcnt)
+{
+	if (!blkcache_dirty(block_dev->if_type, block_dev->devnum, start,
+			    blkcnt))
+		return 0;
+
+	return blkcache_flush(block_dev->if_type, block_dev->devnum);
 }
+#endif
+
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+unsigned long blk_dread_async(struct blk_desc *block_dev, lbaint_t start,
+			      lbaint_t blkcnt, void *buffer)
+{
+	struct udevice *dev = block_dev->bdev;
+	const struct blk_ops *ops = blk_get_ops(dev);
+
+	if (!ops->read_async || !ops->wait)
+		return blk_dread(block_dev, start, blkcnt, buffer);
+
+	ulong start_us, ret;
+
+	if (blk_flush_range(block_dev, start, blkcnt))
+		return -EIO;
+
+	if (blkcache_read(block_dev->if_type, block_dev->devnum,
+			  start, blkcnt, block_dev->blksz, buffer))
+		return blkcnt;
+
+	/* The time it takes is counted by blk_wait() */
+	start_us = timer_get_us();
+	ret = ops->read_async(dev, start, blkcnt, buffer);
+	blk_stats_add(dev, BLK_STATS_READ, ret, start_us);
+
+	return ret;
+}
+
+int blk_wait(struct blk_desc *block_dev)
+{
+	struct udevice *dev = block_dev->bdev;
+	const struct blk_ops *ops = blk_get_ops(dev);
+	ulong start_us;
+	int ret;
+
+	if (!ops->wait)
+		return 0;
+
+	/* Only the wait, the reads go on in the background until then */
+	bootstage_start(BOOTSTAGE_ID_ACCUM_READ, "read");
+	start_us = timer_get_us();
+	ret = ops->wait(dev);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_READ);
+	blk_stats_time(dev, BLK_STATS_READ, start_us);
+
+	return ret;
+}
+#endif
+
+#if CONFIG_IS_ENABLED(BLK_READ_SG)
+unsigned long blk_dread_sg(struct blk_desc *block_dev, lbaint_t start,
+			   const struct blk_sg *sg, int nsegs)
+{
+	struct udevice *dev = block_dev->bdev;
+	const struct blk_ops *ops = blk_get_ops(dev);
+	unsigned long total = 0;
+	int i;
+
+	if (ops->read_sg) {
+		ulong start_us;
+		lbaint_t blkcnt = 0;
+
+		for (i = 0; i < nsegs; i++)
+			blkcnt += sg[i].blkcnt;
+		if (blk_flush_range(block_dev, start, blkcnt))
+			return 0;
+
+		start_us = timer_get_us();
+		total = ops->read_sg(dev, start, sg, nsegs);
+		blk_stats_add(dev, BLK_STATS_READ, total, start_us);
+		return total;
+	}
+
+	for (i = 0; i < nsegs; i++) {
+		if (blk_dread(block_dev, start + total, sg[i].blkcnt,
+			      sg[i].buf) != sg[i].blkcnt)
+			break;
+		total += sg[i].blkcnt;
+	}
+
+	return total;
+}
+#endif
 
 int blk_prepare_device(struct udevice *dev)
 {
@@ -678,8 +994,21 @@ int blk_unbind_all(int if_type)
 	return 0;
 }
 
+/*
+ * The parsed partition table lives in the blk_desc, which is freed on unbind.
+ * A device that is removed may come back with other media.
+ */
+static int blk_drop_part_cache(struct udevice *dev)
+{
+	part_cache_invalidate(dev_get_uclass_platdata(dev));
+
+	return 0;
+}
+
 UCLASS_DRIVER(blk) = {
 	.id		= UCLASS_BLK,
 	.name		= "blk",
+	.pre_unbind	= blk_drop_part_cache,
+	.pre_remove	= blk_drop_part_cache,
 	.per_device_platdata_auto_alloc_size = sizeof(struct blk_desc),
 };
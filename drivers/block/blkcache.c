@@ -8,39 +8,103 @@
 #include <config.h>
 #include <common.h>
 #include <malloc.h>
+#include <memalign.h>
 #include <part.h>
 #include <linux/ctype.h>
 #include <linux/list.h>
 
+/*
+ * The cache is made of lines of max_blocks_per_entry blocks, aligned to
+ * their size on the device, so that a block can only ever be in one line.
+ * Lines are found through a hash of (device, line number) and recycled in
+ * LRU order. A request hits if every line it touches is present, so reads
+ * that straddle lines or cover a piece of a line are served as well.
+ */
+#define BLKCACHE_HASH_BITS	6
+#define BLKCACHE_HASH_SIZE	(1 << BLKCACHE_HASH_BITS)
+
+/* Requests above this many lines are not worth caching */
+#define BLKCACHE_MAX_REQ_LINES	8
+
 struct block_cache_node {
-	struct list_head lh;
+	struct list_head lh;		/* LRU list, MRU first */
+	struct list_head hash_lh;	/* hash bucket */
 	int iftype;
 	int devnum;
-	lbaint_t start;
-	lbaint_t blkcnt;
+	lbaint_t line;
 	unsigned long blksz;
 	char *cache;
 };
 
+#ifdef CONFIG_BLOCK_CACHE_WRITEBACK
+/* A run of consecutive blocks written but not yet sent to the device */
+struct block_cache_dirty {
+	struct list_head lh;	/* sorted by start block */
+	lbaint_t start;
+	lbaint_t blkcnt;
+	char *data;
+};
+#endif
+
+/* Per-device statistics, read-ahead and write-back state */
+struct block_cache_dev {
+	struct list_head lh;
+	int iftype;
+	int devnum;
+	lbaint_t next_start;	/* block following the last request */
+	unsigned ra_lines;	/* current read-ahead window */
+	unsigned hits;
+	unsigned misses;
+	unsigned prefetched;
+#ifdef CONFIG_BLOCK_CACHE_WRITEBACK
+	struct list_head dirty;
+	lbaint_t dirty_blocks;
+	struct blk_desc *block_dev;
+	blkcache_write_t write;
+#endif
+};
+
 static LIST_HEAD(block_cache);
+static LIST_HEAD(block_cache_devs);
+static struct list_head block_cache_hash[BLKCACHE_HASH_SIZE];
+static bool block_cache_hash_init;
+
+static char *block_cache_scratch;
+static size_t block_cache_scratch_size;
 
 static struct block_cache_stats _stats = {
-	.max_blocks_per_entry = 2,
-	.max_entries = 32
+	.max_blocks_per_entry = CONFIG_BLOCK_CACHE_BLOCKS_PER_ENTRY,
+	.max_entries = CONFIG_BLOCK_CACHE_ENTRIES,
+	.read_ahead = CONFIG_BLOCK_CACHE_READ_AHEAD,
 };
 
+static struct list_head *cache_bucket(int iftype, int devnum, lbaint_t line)
+{
+	unsigned long key = (unsigned long)line ^ ((unsigned long)line >> 16);
+	unsigned i;
+
+	if (!block_cache_hash_init) {
+		for (i = 0; i < BLKCACHE_HASH_SIZE; i++)
+			INIT_LIST_HEAD(&block_cache_hash[i]);
+		block_cache_hash_init = true;
+	}
+
+	key ^= (iftype << 4) ^ (devnum << 8);
+	key *= 0x9e3779b1UL;
+
+	return &block_cache_hash[(key >> 8) & (BLKCACHE_HASH_SIZE - 1)];
+}
+
 static struct block_cache_node *cache_find(int iftype, int devnum,
-					   lbaint_t start, lbaint_t blkcnt,
-					   unsigned long blksz)
+					   lbaint_t line, unsigned long blksz)
 {
 	struct block_cache_node *node;
 
-	list_for_each_entry(node, &block_cache, lh)
+	list_for_each_entry(node, cache_bucket(iftype, devnum, line), hash_lh)
 		if ((node->iftype == iftype) &&
 		    (node->devnum == devnum) &&
 		    (node->blksz == blksz) &&
-		    (node->start <= start) &&
-		    (node->start + node->blkcnt >= start + blkcnt)) {
+		    (node->line == line)) {
 			if (block_cache.next != &node->lh) {
 				/* maintain MRU ordering */
 				list_del(&node->lh);
@@ -51,50 +115,103 @@ static struct block_cache_node *cache_find(int iftype, int devnum,
 	return 0;
 }
 
+static void cache_drop(struct block_cache_node *node)
+{
+	list_del(&node->lh);
+	list_del(&node->hash_lh);
+	free(node->cache);
+	free(node);
+	--_stats.entries;
+}
+
+static struct block_cache_dev *cache_dev(int iftype, int devnum, bool create)
+{
+	struct block_cache_dev *bdev;
+
+	list_for_each_entry(bdev, &block_cache_devs, lh)
+		if ((bdev->iftype == iftype) && (bdev->devnum == devnum))
+			return bdev;
+
+	if (!create)
+		return NULL;
+
+	bdev = calloc(1, sizeof(*bdev));
+	if (!bdev)
+		return NULL;
+
+	bdev->iftype = iftype;
+	bdev->devnum = devnum;
+#ifdef CONFIG_BLOCK_CACHE_WRITEBACK
+	INIT_LIST_HEAD(&bdev->dirty);
+#endif
+	list_add(&bdev->lh, &block_cache_devs);
+
+	return bdev;
+}
+
 int blkcache_read(int iftype, int devnum,
 		  lbaint_t start, lbaint_t blkcnt,
 		  unsigned long blksz, void *buffer)
 {
-	struct block_cache_node *node = cache_find(iftype, devnum, start,
-						   blkcnt, blksz);
-	if (node) {
-		const char *src = node->cache + (start - node->start) * blksz;
-		memcpy(buffer, src, blksz * blkcnt);
-		debug("hit: start " LBAF ", count " LBAFU "\n",
-		      start, blkcnt);
-		++_stats.hits;
-		return 1;
+	struct block_cache_dev *bdev = cache_dev(iftype, devnum, true);
+	lbaint_t bpl = _stats.max_blocks_per_entry;
+	lbaint_t blk, end = start + blkcnt, line, off, cnt;
+	struct block_cache_node *node;
+
+	if (!bpl || !_stats.max_entries || !blkcnt)
+		goto miss;
+
+	/* Check that each line is present before copying anything out */
+	for (line = start / bpl; line <= (end - 1) / bpl; line++)
+		if (!cache_find(iftype, devnum, line, blksz))
+			goto miss;
+
+	for (blk = start; blk < end; blk += cnt) {
+		line = blk / bpl;
+		off = blk - line * bpl;
+		cnt = min(bpl - off, end - blk);
+		node = cache_find(iftype, devnum, line, blksz);
+		memcpy(buffer, node->cache + off * blksz, cnt * blksz);
+		buffer += cnt * blksz;
 	}
 
+	debug("hit: start " LBAF ", count " LBAFU "\n",
+	      start, blkcnt);
+	++_stats.hits;
+	if (bdev)
+		++bdev->hits;
+	return 1;
+
+miss:
 	debug("miss: start " LBAF ", count " LBAFU "\n",
 	      start, blkcnt);
 	++_stats.misses;
+	if (bdev)
+		++bdev->misses;
 	return 0;
 }
 
-void blkcache_fill(int iftype, int devnum,
-		   lbaint_t start, lbaint_t blkcnt,
-		   unsigned long blksz, void const *buffer)
+static void cache_fill_line(int iftype, int devnum, lbaint_t line,
+			    unsigned long blksz, void const *buffer)
 {
-	lbaint_t bytes;
+	lbaint_t bytes = blksz * _stats.max_blocks_per_entry;
 	struct block_cache_node *node;
 
-	/* don't cache big stuff */
-	if (blkcnt > _stats.max_blocks_per_entry)
-		return;
-
-	if (_stats.max_entries == 0)
+	node = cache_find(iftype, devnum, line, blksz);
+	if (node) {
+		memcpy(node->cache, buffer, bytes);
 		return;
+	}
 
-	bytes = blksz * blkcnt;
 	if (_stats.max_entries <= _stats.entries) {
-		/* pop LRU */
-		node = (struct block_cache_node *)block_cache.prev;
+		/* recycle LRU */
+		node = list_entry(block_cache.prev, struct block_cache_node,
+				  lh);
 		list_del(&node->lh);
+		list_del(&node->hash_lh);
 		_stats.entries--;
-		debug("drop: start " LBAF ", count " LBAFU "\n",
-		      node->start, node->blkcnt);
-		if (node->blkcnt * node->blksz < bytes) {
+		debug("drop: line " LBAFU "\n", node->line);
+		if (node->blksz != blksz) {
 			free(node->cache);
 			node->cache = 0;
 		}
@@ -113,61 +230,396 @@ void blkcache_fill(int iftype, int devnum,
 		}
 	}
 
-	debug("fill: start " LBAF ", count " LBAFU "\n",
-	      start, blkcnt);
-
 	node->iftype = iftype;
 	node->devnum = devnum;
-	node->start = start;
-	node->blkcnt = blkcnt;
+	node->line = line;
 	node->blksz = blksz;
 	memcpy(node->cache, buffer, bytes);
 	list_add(&node->lh, &block_cache);
+	list_add(&node->hash_lh, cache_bucket(iftype, devnum, line));
 	_stats.entries++;
 }
 
+void blkcache_fill(int iftype, int devnum,
+		   lbaint_t start, lbaint_t blkcnt,
+		   unsigned long blksz, void const *buffer)
+{
+	lbaint_t bpl = _stats.max_blocks_per_entry;
+	lbaint_t line, end = start + blkcnt;
+
+	if (!bpl || !_stats.max_entries)
+		return;
+
+	/* don't cache big stuff */
+	if (blkcnt > bpl * (BLKCACHE_MAX_REQ_LINES + 1 + _stats.read_ahead))
+		return;
+
+	debug("fill: start " LBAF ", count " LBAFU "\n",
+	      start, blkcnt);
+
+	/* Only lines fully covered by the data can be cached */
+	for (line = DIV_ROUND_UP(start, bpl); (line + 1) * bpl <= end; line++)
+		cache_fill_line(iftype, devnum, line, blksz,
+				buffer + (line * bpl - start) * blksz);
+}
+
+static void *cache_scratch(size_t size)
+{
+	if (size > block_cache_scratch_size) {
+		free(block_cache_scratch);
+		block_cache_scratch = malloc_cache_aligned(size);
+		block_cache_scratch_size = block_cache_scratch ? size : 0;
+	}
+
+	return block_cache_scratch;
+}
+
+ulong blkcache_dread(struct blk_desc *block_dev, lbaint_t start,
+		     lbaint_t blkcnt, void *buffer, blkcache_read_t read)
+{
+	int iftype = block_dev->if_type, devnum = block_dev->devnum;
+	unsigned long blksz = block_dev->blksz;
+	lbaint_t bpl = _stats.max_blocks_per_entry;
+	lbaint_t wstart, wend, ra = 0;
+	struct block_cache_dev *bdev;
+	bool seq;
+	ulong n;
+	char *buf;
+
+	/* Dirty blocks are not in the read cache, so write them out first */
+	if (blkcache_dirty(iftype, devnum, start, blkcnt))
+		blkcache_flush(iftype, devnum);
+
+	if (blkcache_read(iftype, devnum, start, blkcnt, blksz, buffer)) {
+		bdev = cache_dev(iftype, devnum, false);
+		if (bdev)
+			bdev->next_start = start + blkcnt;
+		return blkcnt;
+	}
+
+	bdev = cache_dev(iftype, devnum, false);
+	if (!bpl || !_stats.max_entries || !blkcnt ||
+	    blkcnt > bpl * BLKCACHE_MAX_REQ_LINES)
+		goto direct;
+
+	/* Grow the read-ahead window while the reads stay sequential */
+	seq = bdev && bdev->next_start == start;
+	if (bdev) {
+		if (seq && _stats.read_ahead)
+			bdev->ra_lines = bdev->ra_lines ?
+				min(bdev->ra_lines * 2, _stats.read_ahead) : 1;
+		else if (!seq)
+			bdev->ra_lines = 0;
+		ra = bdev->ra_lines;
+		bdev->next_start = start + blkcnt;
+	}
+
+	wstart = rounddown(start, bpl);
+	wend = roundup(start + blkcnt, bpl) + ra * bpl;
+	if (block_dev->lba && wend > block_dev->lba)
+		wend = block_dev->lba;
+	if (wend <= start + blkcnt)
+		goto direct_fill;
+
+	buf = cache_scratch((wend - wstart) * blksz);
+	if (!buf)
+		goto direct_fill;
+
+	n = read(block_dev, wstart, wend - wstart, buf);
+	if (n != wend - wstart)
+		goto direct_fill;
+
+	blkcache_fill(iftype, devnum, wstart, n, blksz, buf);
+	memcpy(buffer, buf + (start - wstart) * blksz, blkcnt * blksz);
+	if (bdev)
+		bdev->prefetched += n - blkcnt;
+	_stats.prefetched += n - blkcnt;
+
+	return blkcnt;
+
+direct_fill:
+	n = read(block_dev, start, blkcnt, buffer);
+	if (n == blkcnt)
+		blkcache_fill(iftype, devnum, start, blkcnt, blksz, buffer);
+	return n;
+
+direct:
+	if (bdev)
+		bdev->next_start = start + blkcnt;
+	return read(block_dev, start, blkcnt, buffer);
+}
+
+/* Drop the cached lines overlapping a range that is being written */
+static void cache_invalidate_range(int iftype, int devnum, lbaint_t start,
+				   lbaint_t blkcnt)
+{
+	lbaint_t bpl = _stats.max_blocks_per_entry;
+	struct block_cache_node *node, *n;
+	lbaint_t line, first, last;
+
+	if (!bpl || !blkcnt)
+		return;
+
+	first = start / bpl;
+	last = (start + blkcnt - 1) / bpl;
+
+	if (last - first >= _stats.entries) {
+		list_for_each_entry_safe(node, n, &block_cache, lh)
+			if ((node->iftype == iftype) &&
+			    (node->devnum == devnum) &&
+			    (node->line >= first) && (node->line <= last))
+				cache_drop(node);
+		return;
+	}
+
+	for (line = first; line <= last; line++) {
+		list_for_each_entry_safe(node, n,
+					 cache_bucket(iftype, devnum, line),
+					 hash_lh)
+			if ((node->iftype == iftype) &&
+			    (node->devnum == devnum) &&
+			    (node->line == line))
+				cache_drop(node);
+	}
+}
+
+#ifdef CONFIG_BLOCK_CACHE_WRITEBACK
+bool blkcache_dirty(int iftype, int devnum, lbaint_t start, lbaint_t blkcnt)
+{
+	struct block_cache_dev *bdev = cache_dev(iftype, devnum, false);
+	struct block_cache_dirty *d;
+
+	if (!bdev)
+		return false;
+
+	list_for_each_entry(d, &bdev->dirty, lh)
+		if ((d->start < start + blkcnt) &&
+		    (start < d->start + d->blkcnt))
+			return true;
+
+	return false;
+}
+
+int blkcache_flush(int iftype, int devnum)
+{
+	struct block_cache_dev *bdev = cache_dev(iftype, devnum, false);
+	struct block_cache_dirty *d, *n;
+	int ret = 0;
+
+	if (!bdev)
+		return 0;
+
+	list_for_each_entry_safe(d, n, &bdev->dirty, lh) {
+		debug("flush: start " LBAF ", count " LBAFU "\n",
+		      d->start, d->blkcnt);
+		if (bdev->write(bdev->block_dev, d->start, d->blkcnt,
+				d->data) != d->blkcnt) {
+			printf("%s: failed to write back " LBAFU
+			       " blocks at " LBAF "\n", __func__, d->blkcnt,
+			       d->start);
+			ret = -EIO;
+		}
+		list_del(&d->lh);
+		free(d->data);
+		free(d);
+	}
+	bdev->dirty_blocks = 0;
+
+	return ret;
+}
+
+int blkcache_flush_all(void)
+{
+	struct block_cache_dev *bdev;
+	int ret = 0;
+
+	list_for_each_entry(bdev, &block_cache_devs, lh)
+		if (blkcache_flush(bdev->iftype, bdev->devnum))
+			ret = -EIO;
+
+	return ret;
+}
+
+/*
+ * Merge the new data with every dirty run it overlaps or touches, so the
+ * device later sees one write per run of consecutive blocks.
+ */
+static int cache_add_dirty(struct block_cache_dev *bdev, lbaint_t start,
+			   lbaint_t blkcnt, unsigned long blksz,
+			   const void *buffer)
+{
+	struct block_cache_dirty *d, *n, *nd;
+	struct list_head *pos = &bdev->dirty;
+	lbaint_t nstart = start, nend = start + blkcnt;
+
+	list_for_each_entry(d, &bdev->dirty, lh) {
+		if (d->start + d->blkcnt < start)
+			continue;
+		if (d->start > start + blkcnt)
+			break;
+		nstart = min(nstart, d->start);
+		nend = max(nend, d->start + d->blkcnt);
+	}
+
+	nd = malloc(sizeof(*nd));
+	if (!nd)
+		return -ENOMEM;
+	nd->data = malloc((nend - nstart) * blksz);
+	if (!nd->data) {
+		free(nd);
+		return -ENOMEM;
+	}
+	nd->start = nstart;
+	nd->blkcnt = nend - nstart;
+
+	list_for_each_entry_safe(d, n, &bdev->dirty, lh) {
+		if (d->start + d->blkcnt < nstart) {
+			pos = &d->lh;
+			continue;
+		}
+		if (d->start >= nend)
+			break;
+		memcpy(nd->data + (d->start - nstart) * blksz, d->data,
+		       d->blkcnt * blksz);
+		bdev->dirty_blocks -= d->blkcnt;
+		list_del(&d->lh);
+		free(d->data);
+		free(d);
+	}
+	memcpy(nd->data + (start - nstart) * blksz, buffer, blkcnt * blksz);
+
+	list_add(&nd->lh, pos);
+	bdev->dirty_blocks += nd->blkcnt;
+
+	return 0;
+}
+#endif
+
+ulong blkcache_dwrite(struct blk_desc *block_dev, lbaint_t start,
+		      lbaint_t blkcnt, const void *buffer,
+		      blkcache_write_t write)
+{
+	int iftype = block_dev->if_type, devnum = block_dev->devnum;
+#ifdef CONFIG_BLOCK_CACHE_WRITEBACK
+	struct block_cache_dev *bdev = cache_dev(iftype, devnum, true);
+#endif
+
+	cache_invalidate_range(iftype, devnum, start, blkcnt);
+
+#ifdef CONFIG_BLOCK_CACHE_WRITEBACK
+	if (!bdev || !blkcnt)
+		goto write_through;
+
+	/* Big writes gain nothing from coalescing */
+	if (blkcnt > CONFIG_BLOCK_CACHE_WRITEBACK_BLOCKS / 4)
+		goto write_through;
+
+	if (bdev->dirty_blocks + blkcnt > CONFIG_BLOCK_CACHE_WRITEBACK_BLOCKS &&
+	    blkcache_flush(iftype, devnum))
+		goto write_through;
+
+	bdev->block_dev = block_dev;
+	bdev->write = write;
+	if (!cache_add_dirty(bdev, start, blkcnt, block_dev->blksz, buffer))
+		return blkcnt;
+
+write_through:
+	/* Keep the device's write order */
+	if (blkcache_flush(iftype, devnum))
+		return 0;
+#endif
+	return write(block_dev, start, blkcnt, buffer);
+}
+
 void blkcache_invalidate(int iftype, int devnum)
 {
-	struct list_head *entry, *n;
-	struct block_cache_node *node;
+	struct block_cache_node *node, *n;
+	struct block_cache_dev *bdev;
+
+	/* Never lose written data, the caller only means the cached reads */
+	blkcache_flush(iftype, devnum);
 
-	list_for_each_safe(entry, n, &block_cache) {
-		node = (struct block_cache_node *)entry;
+	list_for_each_entry_safe(node, n, &block_cache, lh)
 		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum)) {
-			list_del(entry);
-			free(node->cache);
-			free(node);
-			--_stats.entries;
-		}
+		    (node->devnum == devnum))
+			cache_drop(node);
+
+	bdev = cache_dev(iftype, devnum, false);
+	if (bdev) {
+		bdev->next_start = 0;
+		bdev->ra_lines = 0;
 	}
 }
 
+static void blkcache_reset_stats(void)
+{
+	struct block_cache_dev *bdev;
+
+	list_for_each_entry(bdev, &block_cache_devs, lh) {
+		bdev->hits = 0;
+		bdev->misses = 0;
+		bdev->prefetched = 0;
+	}
+
+	_stats.hits = 0;
+	_stats.misses = 0;
+	_stats.prefetched = 0;
+}
+
 void blkcache_configure(unsigned blocks, unsigned entries)
 {
-	struct block_cache_node *node;
+	struct block_cache_node *node, *n;
+
 	if ((blocks != _stats.max_blocks_per_entry) ||
 	    (entries != _stats.max_entries)) {
 		/* invalidate cache */
-		while (!list_empty(&block_cache)) {
-			node = (struct block_cache_node *)block_cache.next;
-			list_del(&node->lh);
-			free(node->cache);
-			free(node);
-		}
+		list_for_each_entry_safe(node, n, &block_cache, lh)
+			cache_drop(node);
 		_stats.entries = 0;
 	}
 
 	_stats.max_blocks_per_entry = blocks;
 	_stats.max_entries = entries;
 
-	_stats.hits = 0;
-	_stats.misses = 0;
+	blkcache_reset_stats();
+}
+
+void blkcache_set_read_ahead(unsigned lines)
+{
+	_stats.read_ahead = lines;
 }
 
 void blkcache_stats(struct block_cache_stats *stats)
 {
 	memcpy(stats, &_stats, sizeof(*stats));
-	_stats.hits = 0;
-	_stats.misses = 0;
+	blkcache_reset_stats();
+}
+
+int blkcache_dev_stats(int iftype, int devnum, struct block_cache_stats *stats)
+{
+	struct block_cache_dev *bdev = cache_dev(iftype, devnum, false);
+	struct block_cache_node *node;
+
+	if (!bdev)
+		return -ENOENT;
+
+	memcpy(stats, &_stats, sizeof(*stats));
+	stats->hits = bdev->hits;
+	stats->misses = bdev->misses;
+	stats->prefetched = bdev->prefetched;
+	stats->entries = 0;
+	list_for_each_entry(node, &block_cache, lh)
+		if ((node->iftype == iftype) && (node->devnum == devnum))
+			stats->entries++;
+
+	return 0;
+}
+
+void blkcache_for_each_dev(void (*func)(int iftype, int devnum, void *priv),
+			   void *priv)
+{
+	struct block_cache_dev *bdev;
+
+	list_for_each_entry(bdev, &block_cache_devs, lh)
+		func(bdev->iftype, bdev->devnum, priv);
 }
@@ -15,6 +15,25 @@
 
 static struct rockchip_pll_rate_table rockchip_auto_table;
 
+#ifdef CONFIG_ROCKCHIP_CLK_PLL_BATCH
+#define PLL_BATCH_MAX		8
+
+/*
+ * PLLs which are set up and powered up, but not yet waited for. The clock
+ * controller may be probed before bss is usable, so keep it in data.
+ */
+static struct {
+	int depth;
+	int count;
+	struct {
+		struct rockchip_pll_clock *pll;
+		void __iomem *base;
+		ulong pll_id;
+		ulong rate;
+	} plls[PLL_BATCH_MAX];
+} pll_batch __section(".data");
+#endif
+
 #define PLL_MODE_MASK				0x3
 #define PLL_RK3328_MODE_MASK			0x1
 
@@ -288,12 +307,68 @@ rockchip_get_pll_settings(struct rockchip_pll_clock *pll, ulong rate)
 	}
 }
 
+#ifdef CONFIG_ROCKCHIP_CLK_PLL_BATCH
+/* Leave a PLL to rockchip_pll_batch_end() to wait for, if in a batch */
+static bool rockchip_pll_defer_lock(struct rockchip_pll_clock *pll,
+				    void __iomem *base, ulong pll_id,
+				    ulong rate)
+{
+	int i;
+
+	if (!pll_batch.depth)
+		return false;
+
+	for (i = 0; i < pll_batch.count; i++) {
+		if (pll_batch.plls[i].pll == pll)
+			break;
+	}
+	if (i == PLL_BATCH_MAX)
+		return false;
+
+	pll_batch.plls[i].pll = pll;
+	pll_batch.plls[i].base = base;
+	pll_batch.plls[i].pll_id = pll_id;
+	pll_batch.plls[i].rate = rate;
+	if (i == pll_batch.count)
+		pll_batch.count++;
+
+	return true;
+}
+
+/* The rate a PLL waiting in the batch will run at, 0 if none is */
+static ulong rockchip_pll_deferred_rate(struct rockchip_pll_clock *pll)
+{
+	int i;
+
+	for (i = 0; i < pll_batch.count; i++) {
+		if (pll_batch.plls[i].pll == pll)
+			return pll_batch.plls[i].rate;
+	}
+
+	return 0;
+}
+#else
+static inline bool rockchip_pll_defer_lock(struct rockchip_pll_clock *pll,
+					   void __iomem *base, ulong pll_id,
+					   ulong rate)
+{
+	return false;
+}
+
+static inline ulong rockchip_pll_deferred_rate(struct rockchip_pll_clock *pll)
+{
+	return 0;
+}
+#endif
+
+static int rk3036_pll_wait_lock(struct rockchip_pll_clock *pll,
+				void __iomem *base, ulong pll_id);
+
 static int rk3036_pll_set_rate(struct rockchip_pll_clock *pll,
 			       void __iomem *base, ulong pll_id,
 			       ulong drate)
 {
 	const struct rockchip_pll_rate_table *rate;
-	int timeout = 1000;
 
 	rate = rockchip_get_pll_settings(pll, drate);
 	if (!rate) {
@@ -344,6 +419,18 @@ static int rk3036_pll_set_rate(struct rockchip_pll_clock *pll,
 	rk_clrreg(base + pll->con_offset + 0x4,
 		  1 << RK3036_PLLCON1_PWRDOWN_SHIT);
 
+	if (rockchip_pll_defer_lock(pll, base, pll_id, drate))
+		return 0;
+
+	return rk3036_pll_wait_lock(pll, base, pll_id);
+}
+
+/* Switch a PLL to normal mode once it is locked */
+static int rk3036_pll_wait_lock(struct rockchip_pll_clock *pll,
+				void __iomem *base, ulong pll_id)
+{
+	int timeout = 1000;
+
 	/* waiting for pll lock */
 	while ((timeout > 0) && !(readl(base + pll->con_offset + 0x4) & (1 << pll->lock_shift))) {
 		udelay(1);
@@ -441,6 +528,9 @@ static ulong rk3036_pll_get_rate(struct rockchip_pll_clock *pll,
 #define RK3588_CORE_B02_DIV_SHIFT	8
 #define RK3588_CORE_B13_DIV_SHIFT	0
 
+static int rk3588_pll_wait_lock(struct rockchip_pll_clock *pll,
+				void __iomem *base, ulong pll_id);
+
 static int rk3588_pll_set_rate(struct rockchip_pll_clock *pll,
 			       void __iomem *base, ulong pll_id,
 			       ulong drate)
@@ -499,6 +589,16 @@ static int rk3588_pll_set_rate(struct rockchip_pll_clock *pll,
 	rk_clrreg(base + pll->con_offset + RK3588_PLLCON(1),
 		  RK3588_PLLCON1_PWRDOWN);
 
+	if (rockchip_pll_defer_lock(pll, base, pll_id, drate))
+		return 0;
+
+	return rk3588_pll_wait_lock(pll, base, pll_id);
+}
+
+/* Switch a PLL to normal mode once it is locked */
+static int rk3588_pll_wait_lock(struct rockchip_pll_clock *pll,
+				void __iomem *base, ulong pll_id)
+{
 	/* waiting for pll lock */
 	while (!(readl(base + pll->con_offset + RK3588_PLLCON(6)) &
 		RK3588_PLLCON6_LOCK_STATUS)) {
@@ -623,6 +723,11 @@ ulong rockchip_pll_get_rate(struct rockchip_pll_clock *pll,
 {
 	ulong rate = 0;
 
+	/* still in slow mode, but as good as set */
+	rate = rockchip_pll_deferred_rate(pll);
+	if (rate)
+		return rate;
+
 	switch (pll->type) {
 	case pll_rk3036:
 		pll->mode_mask = PLL_MODE_MASK;
@@ -672,6 +777,34 @@ int rockchip_pll_set_rate(struct rockchip_pll_clock *pll,
 	return ret;
 }
 
+#ifdef CONFIG_ROCKCHIP_CLK_PLL_BATCH
+void rockchip_pll_batch_begin(void)
+{
+	pll_batch.depth++;
+}
+
+void rockchip_pll_batch_end(void)
+{
+	struct rockchip_pll_clock *pll;
+	int i;
+
+	if (!pll_batch.depth || --pll_batch.depth)
+		return;
+
+	/* All of them have been locking meanwhile, in the order they were set */
+	for (i = 0; i < pll_batch.count; i++) {
+		pll = pll_batch.plls[i].pll;
+		if (pll->type == pll_rk3588)
+			rk3588_pll_wait_lock(pll, pll_batch.plls[i].base,
+					     pll_batch.plls[i].pll_id);
+		else
+			rk3036_pll_wait_lock(pll, pll_batch.plls[i].base,
+					     pll_batch.plls[i].pll_id);
+	}
+	pll_batch.count = 0;
+}
+#endif
+
 const struct rockchip_cpu_rate_table *
 rockchip_get_cpu_settings(struct rockchip_cpu_rate_table *cpu_table,
 			  ulong rate)
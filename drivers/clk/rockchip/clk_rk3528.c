@@ -1990,12 +1990,17 @@ static int rk3528_clk_probe(struct udevice *dev)
 	if (IS_ERR(priv->grf))
 		return PTR_ERR(priv->grf);
 
+	/* the PLLs lock together, see rockchip_pll_batch_begin() */
+	rockchip_pll_batch_begin();
 	ret = rk3528_clk_init(priv);
-	if (ret)
+	if (ret) {
+		rockchip_pll_batch_end();
 		return ret;
+	}
 
 	/* Process 'assigned-{clocks/clock-parents/clock-rates}' properties */
 	ret = clk_set_defaults(dev);
+	rockchip_pll_batch_end();
 	if (ret)
 		debug("%s clk_set_defaults failed %d\n", __func__, ret);
 	else
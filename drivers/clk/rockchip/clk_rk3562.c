@@ -1847,10 +1847,13 @@ static int rk3562_clk_probe(struct udevice *dev)
 	struct rk3562_clk_priv *priv = dev_get_priv(dev);
 	int ret;
 
+	/* the PLLs lock together, see rockchip_pll_batch_begin() */
+	rockchip_pll_batch_begin();
 	rk3562_clk_init(priv);
 
 	/* Process 'assigned-{clocks/clock-parents/clock-rates}' properties */
 	ret = clk_set_defaults(dev);
+	rockchip_pll_batch_end();
 	if (ret)
 		debug("%s clk_set_defaults failed %d\n", __func__, ret);
 	else
@@ -2107,6 +2107,7 @@ static int rk3588_clk_probe(struct udevice *dev)
 	priv->sync_kernel = false;
 
 #ifdef CONFIG_SPL_BUILD
+	rockchip_pll_batch_begin();
 	rockchip_pll_set_rate(&rk3588_pll_clks[B0PLL], priv->cru,
 			      B0PLL, LPLL_HZ);
 	rockchip_pll_set_rate(&rk3588_pll_clks[B1PLL], priv->cru,
@@ -2119,6 +2120,7 @@ static int rk3588_clk_probe(struct udevice *dev)
 					      priv->cru, LPLL);
 		priv->armclk_init_hz = priv->armclk_enter_hz;
 	}
+	rockchip_pll_batch_end();
 #endif
 
 #if CONFIG_IS_ENABLED(CLK_SCMI)
@@ -2159,10 +2161,13 @@ static int rk3588_clk_probe(struct udevice *dev)
 	if (IS_ERR(priv->grf))
 		return PTR_ERR(priv->grf);
 
+	/* the PLLs lock together, see rockchip_pll_batch_begin() */
+	rockchip_pll_batch_begin();
 	rk3588_clk_init(priv);
 
 	/* Process 'assigned-{clocks/clock-parents/clock-rates}' properties */
 	ret = clk_set_defaults(dev);
+	rockchip_pll_batch_end();
 	if (ret)
 		debug("%s clk_set_defaults failed %d\n", __func__, ret);
 	else
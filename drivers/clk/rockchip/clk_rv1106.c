@@ -1299,10 +1299,13 @@ static int rv1106_clk_probe(struct udevice *dev)
 #ifndef CONFIG_ROCKCHIP_IMAGE_TINY
 	int ret;
 
+	/* the PLLs lock together, see rockchip_pll_batch_begin() */
+	rockchip_pll_batch_begin();
 	rv1106_clk_init(priv);
 
 	/* Process 'assigned-{clocks/clock-parents/clock-rates}' properties */
 	ret = clk_set_defaults(dev);
+	rockchip_pll_batch_end();
 	if (ret)
 		debug("%s clk_set_defaults failed %d\n", __func__, ret);
 	else
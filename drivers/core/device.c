@@ -78,6 +78,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 					 * this. Maybe removed in the future.
 					 */
 					dev->node = node;
+					uclass_index_invalidate(uc);
 					return 0;
 				}
 			}
@@ -99,6 +100,7 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 					return 0;
 				} else {
 					list_del_init(&dev->uclass_node);
+					uclass_index_invalidate(uc);
 				}
 			}
 		}
@@ -273,6 +275,11 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	if (devp)
 		*devp = dev;
 
+#if CONFIG_IS_ENABLED(DM_PROBE_DEFER)
+	if ((drv->flags & DM_FLAG_PROBE_DEFER) ||
+	    ofnode_read_bool(node, "u-boot,dm-probe-defer"))
+		dev->flags |= DM_FLAG_PROBE_DEFER;
+#endif
 	dev->flags |= DM_FLAG_BOUND;
 
 	return 0;
@@ -469,7 +476,7 @@ int device_probe(struct udevice *dev)
 		ret = seq;
 		goto fail;
 	}
-	dev->seq = seq;
+	uclass_set_seq(dev, seq);
 
 	dev->flags |= DM_FLAG_ACTIVATED;
 
@@ -524,7 +531,7 @@ fail_uclass:
 fail:
 	dev->flags &= ~DM_FLAG_ACTIVATED;
 
-	dev->seq = -1;
+	uclass_set_seq(dev, -1);
 	device_free(dev);
 
 	return ret;
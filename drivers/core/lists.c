@@ -16,7 +16,11 @@
 #include <dm/uclass.h>
 #include <dm/util.h>
 #include <fdtdec.h>
+#include <malloc.h>
 #include <linux/compiler.h>
+#include <linux/log2.h>
+
+DECLARE_GLOBAL_DATA_PTR;
 
 struct driver *lists_driver_lookup_name(const char *name)
 {
@@ -123,6 +127,121 @@ static int driver_check_compatible(const struct udevice_id *of_match,
 	return -ENOENT;
 }
 
+#if defined(CONFIG_DM_DRIVER_INDEX) && !defined(CONFIG_SPL_BUILD) && \
+	!defined(CONFIG_NEEDS_MANUAL_RELOC)
+/* A compatible string, as the first driver in the linker list to have it */
+struct driver_index {
+	const struct udevice_id *id;
+	struct driver *drv;
+	uint hash;	/* full hash, to skip most strcmp() on collisions */
+};
+
+static struct driver_index *driver_index;
+static uint driver_index_mask;
+
+static uint driver_index_hash(const char *compat)
+{
+	uint hash = 5381;
+
+	while (*compat)
+		hash = hash * 33 + *compat++;
+
+	return hash;
+}
+
+static bool driver_index_match(struct driver_index *idx, uint hash,
+			       const char *compat)
+{
+	return idx->hash == hash && !strcmp(idx->id->compatible, compat);
+}
+
+static int driver_index_build(struct driver *driver, int n_ents)
+{
+	const struct udevice_id *of_match;
+	struct driver *entry;
+	uint count = 0, hash, i;
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (of_match = entry->of_match;
+		     of_match && of_match->compatible; of_match++)
+			count++;
+	}
+
+	/* At most half full */
+	driver_index_mask = __roundup_pow_of_two(count * 2 + 1) - 1;
+	driver_index = calloc(driver_index_mask + 1, sizeof(*driver_index));
+	if (!driver_index)
+		return -ENOMEM;
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (of_match = entry->of_match;
+		     of_match && of_match->compatible; of_match++) {
+			hash = driver_index_hash(of_match->compatible);
+			i = hash & driver_index_mask;
+			while (driver_index[i].id &&
+			       !driver_index_match(&driver_index[i], hash,
+						   of_match->compatible))
+				i = (i + 1) & driver_index_mask;
+			/* Keep the earlier driver, as the linear search would */
+			if (driver_index[i].id)
+				continue;
+			driver_index[i].id = of_match;
+			driver_index[i].drv = entry;
+			driver_index[i].hash = hash;
+		}
+	}
+	pr_debug("Indexed %u compatible strings\n", count);
+
+	return 0;
+}
+
+static struct driver *driver_index_lookup(const char *compat,
+					  const struct udevice_id **of_idp)
+{
+	uint hash = driver_index_hash(compat);
+	uint i = hash & driver_index_mask;
+
+	while (driver_index[i].id) {
+		if (driver_index_match(&driver_index[i], hash, compat)) {
+			*of_idp = driver_index[i].id;
+			return driver_index[i].drv;
+		}
+		i = (i + 1) & driver_index_mask;
+	}
+
+	return NULL;
+}
+#endif
+
+/**
+ * driver_lookup_compatible() - Find the first driver for a compatible string
+ *
+ * @param driver:	Start of the driver list
+ * @param n_ents:	Number of drivers in the list
+ * @param compat:	The compatible string to search for
+ * @param of_idp:	Returns the match that was found
+ * @return the driver, or NULL if none matches
+ */
+static struct driver *driver_lookup_compatible(struct driver *driver,
+					       int n_ents, const char *compat,
+					       const struct udevice_id **of_idp)
+{
+	struct driver *entry;
+
+#if defined(CONFIG_DM_DRIVER_INDEX) && !defined(CONFIG_SPL_BUILD) && \
+	!defined(CONFIG_NEEDS_MANUAL_RELOC)
+	if ((gd->flags & GD_FLG_RELOC) &&
+	    (driver_index || !driver_index_build(driver, n_ents)))
+		return driver_index_lookup(compat, of_idp);
+#endif
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		if (!driver_check_compatible(entry->of_match, of_idp, compat))
+			return entry;
+	}
+
+	return NULL;
+}
+
 int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp)
 {
 	struct driver *driver = ll_entry_start(struct driver, driver);
@@ -163,14 +282,11 @@ int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp)
 		pr_debug("   - attempt to match compatible string '%s'\n",
 			 compat);
 
-		for (entry = driver; entry != driver + n_ents; entry++) {
-			ret = driver_check_compatible(entry->of_match, &id,
-						      compat);
-			if (!ret)
-				break;
-		}
-		if (entry == driver + n_ents)
+		entry = driver_lookup_compatible(driver, n_ents, compat, &id);
+		if (!entry) {
+			ret = -ENOENT;
 			continue;
+		}
 
 		pr_debug("   - found match at '%s'\n", entry->name);
 		ret = device_bind_with_driver_data(parent, entry, name,
@@ -184,6 +184,43 @@ int dm_init(bool of_live)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(DM_PROBE_DEFER)
+static bool dm_probe_defer_done;
+
+bool device_probe_deferred(const struct udevice *dev)
+{
+	/* Only U-Boot proper defers, bss is not usable before relocation */
+	return (gd->flags & GD_FLG_RELOC) && !dm_probe_defer_done &&
+	       (dev->flags & DM_FLAG_PROBE_DEFER);
+}
+
+int dm_probe_deferred(void)
+{
+	struct udevice *dev;
+	struct uclass *uc;
+	int ret = 0;
+
+	if (dm_probe_defer_done)
+		return 0;
+	dm_probe_defer_done = true;
+
+	list_for_each_entry(uc, &gd->uclass_root, sibling_node) {
+		list_for_each_entry(dev, &uc->dev_head, uclass_node) {
+			if (!(dev->flags & DM_FLAG_PROBE_DEFER) ||
+			    device_active(dev))
+				continue;
+			if (device_probe(dev)) {
+				dm_warn("Deferred probe of '%s' failed\n",
+					dev->name);
+				ret = -EIO;
+			}
+		}
+	}
+
+	return ret;
+}
+#endif
+
 int dm_uninit(void)
 {
 	device_remove(dm_root(), DM_REMOVE_NORMAL);
@@ -42,6 +42,268 @@ struct uclass *uclass_find(enum uclass_id key)
 	return NULL;
 }
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+enum uclass_key {
+	UCLASS_KEY_NODE,
+	UCLASS_KEY_REQ_SEQ,
+	UCLASS_KEY_SEQ,
+
+	UCLASS_KEY_COUNT,
+};
+
+/**
+ * struct uclass_index - hash tables of the devices in a uclass
+ *
+ * Each table is open addressed with linear probing, and holds for each key
+ * the first device in uclass order, as a walk of the list would find it.
+ * Binding a device at the end of the list adds it to the tables, anything
+ * else that moves devices around or changes the node or requested sequence
+ * number of one has them rebuilt on the next lookup. The sequence numbers
+ * change as devices are probed and removed, and are kept up to date by
+ * uclass_set_seq(). Names are not indexed, as a lookup by name matches any
+ * device whose name starts with it.
+ *
+ * @valid: The tables match the device list
+ * @count: Number of devices in the tables
+ * @size: Number of slots in each table, a power of two over twice @count
+ * @tab: The tables, by enum uclass_key, all in one allocation
+ */
+struct uclass_index {
+	bool valid;
+	uint count;
+	uint size;
+	struct udevice **tab[UCLASS_KEY_COUNT];
+};
+
+static const void *uclass_dev_key(struct udevice *dev, int key)
+{
+	switch (key) {
+	case UCLASS_KEY_NODE:
+		return &dev->node;
+	case UCLASS_KEY_REQ_SEQ:
+		return &dev->req_seq;
+	default:
+		return &dev->seq;
+	}
+}
+
+static bool uclass_key_valid(struct udevice *dev, int key)
+{
+	switch (key) {
+	case UCLASS_KEY_NODE:
+		return ofnode_valid(dev->node);
+	case UCLASS_KEY_REQ_SEQ:
+		return dev->req_seq != -1;
+	default:
+		return dev->seq != -1;
+	}
+}
+
+static bool uclass_key_match(struct udevice *dev, int key, const void *val)
+{
+	switch (key) {
+	case UCLASS_KEY_NODE:
+		return ofnode_equal(dev->node, *(const ofnode *)val);
+	case UCLASS_KEY_REQ_SEQ:
+		return dev->req_seq == *(const int *)val;
+	default:
+		return dev->seq == *(const int *)val;
+	}
+}
+
+static uint uclass_key_hash(int key, const void *val)
+{
+	ulong v;
+	uint h;
+
+	switch (key) {
+	case UCLASS_KEY_NODE:
+		v = ((const ofnode *)val)->of_offset;
+		break;
+	default:
+		v = *(const int *)val;
+		break;
+	}
+
+	/* Spread node offsets and pointers, which are aligned */
+	h = (uint)v * 2654435761u;
+
+	return h ^ (h >> 16);
+}
+
+/* Returns the slot with the device for @val, or the empty one it goes in */
+static struct udevice **uclass_index_slot(struct uclass_index *idx, int key,
+					  const void *val)
+{
+	struct udevice **tab = idx->tab[key];
+	uint mask = idx->size - 1;
+	uint i = uclass_key_hash(key, val) & mask;
+
+	while (tab[i] && !uclass_key_match(tab[i], key, val))
+		i = (i + 1) & mask;
+
+	return &tab[i];
+}
+
+static void uclass_index_add(struct uclass_index *idx, int key,
+			     struct udevice *dev)
+{
+	struct udevice **slot;
+
+	if (!uclass_key_valid(dev, key))
+		return;
+
+	/* A device earlier in the list keeps the key */
+	slot = uclass_index_slot(idx, key, uclass_dev_key(dev, key));
+	if (!*slot)
+		*slot = dev;
+}
+
+static void uclass_index_del(struct uclass_index *idx, int key,
+			     struct udevice *dev)
+{
+	struct udevice **tab = idx->tab[key];
+	uint mask = idx->size - 1;
+	uint i, j, k;
+
+	if (!uclass_key_valid(dev, key))
+		return;
+
+	i = uclass_index_slot(idx, key, uclass_dev_key(dev, key)) - tab;
+	if (tab[i] != dev)
+		return;
+
+	/* Close the gap, so that the entries after it can still be found */
+	tab[i] = NULL;
+	for (j = (i + 1) & mask; tab[j]; j = (j + 1) & mask) {
+		k = uclass_key_hash(key, uclass_dev_key(tab[j], key)) & mask;
+		if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+			continue;
+		tab[i] = tab[j];
+		tab[j] = NULL;
+		i = j;
+	}
+}
+
+static int uclass_index_build(struct uclass *uc)
+{
+	struct uclass_index *idx = uc->index;
+	struct udevice *dev;
+	uint count = 0, size = 8;
+	int key;
+
+	list_for_each_entry(dev, &uc->dev_head, uclass_node)
+		count++;
+	while (size < 2 * count)
+		size <<= 1;
+
+	if (!idx) {
+		idx = calloc(1, sizeof(*idx));
+		if (!idx)
+			return -ENOMEM;
+		uc->index = idx;
+	}
+
+	if (idx->size < size) {
+		free(idx->tab[0]);
+		idx->tab[0] = malloc(size * UCLASS_KEY_COUNT * sizeof(dev));
+		if (!idx->tab[0]) {
+			idx->size = 0;
+			return -ENOMEM;
+		}
+		idx->size = size;
+	}
+
+	memset(idx->tab[0], '\0', idx->size * UCLASS_KEY_COUNT * sizeof(dev));
+	for (key = 0; key < UCLASS_KEY_COUNT; key++)
+		idx->tab[key] = idx->tab[0] + key * idx->size;
+
+	list_for_each_entry(dev, &uc->dev_head, uclass_node) {
+		for (key = 0; key < UCLASS_KEY_COUNT; key++)
+			uclass_index_add(idx, key, dev);
+	}
+	idx->count = count;
+	idx->valid = true;
+
+	return 0;
+}
+
+static void uclass_index_free(struct uclass *uc)
+{
+	if (uc->index) {
+		free(uc->index->tab[0]);
+		free(uc->index);
+		uc->index = NULL;
+	}
+}
+
+/* Binds @dev at the end of the list into the index, if it is up to date */
+static void uclass_index_bind(struct uclass *uc, struct udevice *dev)
+{
+	struct uclass_index *idx = uc->index;
+	int key;
+
+	if (!idx || !idx->valid)
+		return;
+
+	if (2 * (idx->count + 1) > idx->size) {
+		idx->valid = false;
+		return;
+	}
+
+	for (key = 0; key < UCLASS_KEY_COUNT; key++)
+		uclass_index_add(idx, key, dev);
+	idx->count++;
+}
+
+/*
+ * Looks a device up in the index, which is not used before relocation,
+ * as the early malloc() cannot free the tables that are rebuilt.
+ *
+ * @return 0 if found, -ENODEV if not there, -ENOENT if there is no index
+ */
+static int uclass_index_find(struct uclass *uc, int key, const void *val,
+			     struct udevice **devp)
+{
+	if (!(gd->flags & GD_FLG_FULL_MALLOC_INIT))
+		return -ENOENT;
+
+	if (!uc->index || !uc->index->valid) {
+		if (uclass_index_build(uc))
+			return -ENOENT;
+	}
+
+	*devp = *uclass_index_slot(uc->index, key, val);
+
+	return *devp ? 0 : -ENODEV;
+}
+
+void uclass_index_invalidate(struct uclass *uc)
+{
+	if (uc && uc->index)
+		uc->index->valid = false;
+}
+
+void uclass_set_seq(struct udevice *dev, int seq)
+{
+	struct uclass_index *idx = dev->uclass->index;
+
+	if (idx && idx->valid)
+		uclass_index_del(idx, UCLASS_KEY_SEQ, dev);
+	dev->seq = seq;
+	if (idx && idx->valid)
+		uclass_index_add(idx, UCLASS_KEY_SEQ, dev);
+}
+#else
+static inline void uclass_index_free(struct uclass *uc) {}
+static inline void uclass_index_bind(struct uclass *uc, struct udevice *dev) {}
+
+void uclass_set_seq(struct udevice *dev, int seq)
+{
+	dev->seq = seq;
+}
+#endif
+
 /**
  * uclass_add() - Create new uclass in list
  * @id: Id number to create
@@ -137,6 +399,7 @@ int uclass_destroy(struct uclass *uc)
 	list_del(&uc->sibling_node);
 	if (uc_drv->priv_auto_alloc_size)
 		free(uc->priv);
+	uclass_index_free(uc);
 	free(uc);
 
 	return 0;
@@ -270,6 +533,12 @@ int uclass_find_device_by_seq(enum uclass_id id, int seq_or_req_seq,
 	if (ret)
 		return ret;
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	ret = uclass_index_find(uc, find_req_seq ? UCLASS_KEY_REQ_SEQ :
+				UCLASS_KEY_SEQ, &seq_or_req_seq, devp);
+	if (ret != -ENOENT)
+		return ret;
+#endif
 	list_for_each_entry(dev, &uc->dev_head, uclass_node) {
 		pr_debug("   - %d %d '%s'\n", dev->req_seq, dev->seq, dev->name);
 		if ((find_req_seq ? dev->req_seq : dev->seq) ==
@@ -322,6 +591,11 @@ int uclass_find_device_by_ofnode(enum uclass_id id, ofnode node,
 	if (ret)
 		return ret;
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	ret = uclass_index_find(uc, UCLASS_KEY_NODE, &node, devp);
+	if (ret != -ENOENT)
+		return ret;
+#endif
 	list_for_each_entry(dev, &uc->dev_head, uclass_node) {
 		if (ofnode_equal(dev_ofnode(dev), node)) {
 			*devp = dev;
@@ -609,12 +883,16 @@ int uclass_bind_device(struct udevice *dev, bool after_u_boot_dev)
 
 	uc = dev->uclass;
 #ifdef CONFIG_USING_KERNEL_DTB_V2
-	if (after_u_boot_dev)
+	if (after_u_boot_dev) {
 		list_add_tail(&dev->uclass_node, &uc->dev_head);
-	else
+		uclass_index_bind(uc, dev);
+	} else {
 		list_add_tail(&dev->uclass_node, uc->u_boot_dev_head);
+		uclass_index_invalidate(uc);
+	}
 #else
 	list_add_tail(&dev->uclass_node, &uc->dev_head);
+	uclass_index_bind(uc, dev);
 #endif
 	if (dev->parent) {
 		struct uclass_driver *uc_drv = dev->parent->uclass->uc_drv;
@@ -630,6 +908,7 @@ int uclass_bind_device(struct udevice *dev, bool after_u_boot_dev)
 err:
 	/* There is no need to undo the parent's post_bind call */
 	list_del(&dev->uclass_node);
+	uclass_index_invalidate(uc);
 
 	return ret;
 }
@@ -648,6 +927,7 @@ int uclass_unbind_device(struct udevice *dev)
 	}
 
 	list_del(&dev->uclass_node);
+	uclass_index_invalidate(uc);
 	return 0;
 }
 #endif
@@ -39,10 +39,16 @@ DECLARE_GLOBAL_DATA_PTR;
  *
  * [trust]
  *	The AMP feature requires trust support.
+ *
+ * [spl]
+ *	With CONFIG_SPL_ROCKCHIP_AMP, SPL loads the firmwares for non-boot
+ *	cpus and U-Boot starts them before relocation, so that they are up
+ *	early: see arch/arm/mach-rockchip/amp_handoff.c. Their memory is
+ *	reserved in bidram and they are skipped here.
  */
 
-#define AMP_PART		"amp"
 #define FIT_HEADER_SIZE		SZ_4K
+#define AMP_READ_CHUNK		SZ_256K
 
 #define gicd_readl(offset)	readl((void *)GICD_BASE + (offset))
 #define gicd_writel(v, offset)	writel(v, (void *)GICD_BASE + (offset))
@@ -64,6 +70,19 @@ typedef struct boot_cpu {
 	u32 boot_on;
 } boot_cpu_t;
 
+/*
+ * amp.img as it is read from storage, a chunk at a time: the next chunk
+ * is read while the images which are already in are started.
+ */
+typedef struct amp_reader {
+	struct blk_desc *dev_desc;
+	lbaint_t start;
+	lbaint_t blkcnt;
+	lbaint_t done;
+	lbaint_t queued;
+	void *fit;
+} amp_reader_t;
+
 static boot_cpu_t g_bootcpu;
 static u32 os_amp_dispatcher_cpu[8];
 
@@ -327,6 +346,18 @@ static int brought_up_amp(void *fit, int noffset,
 
 	/* === only nonboot cpu can reach here === */
 
+	/* already up, see amp_handoff_cpus_on() */
+	if (!is_linux) {
+		ret = amp_handoff_cpu(cpu);
+		if (!ret) {
+			AMP_I("cpu[%x] was brought up with state 0x%x, entry 0x%08x from SPL\n",
+			      cpu, pe_state, entry);
+			return 0;
+		} else if (ret != -ENOENT) {
+			AMP_E("cpu[%x] from SPL failed to come up\n", cpu);
+		}
+	}
+
 	/* load or check */
 	if (is_linux) {
 		ret = load_linux_for_nonboot_cpu(cpu,
@@ -359,6 +390,47 @@ exit:
 	return 0;
 }
 
+/* The firmware of a cpu SPL had started must not be loaded over */
+static bool amp_image_running(const void *fit, int noffset)
+{
+	return !amp_handoff_cpu(fit_get_u32_default(fit, noffset, "cpu",
+						    -ENODATA));
+}
+
+/* Like boot_get_loadable(), but skips the firmwares which are running */
+static int amp_load_loadables(bootm_headers_t *images)
+{
+	void *fit = images->fit_hdr_os;
+	int loadables_index;
+	int conf_noffset;
+	int cpu_noffset;
+	int ret;
+	const char *uname;
+
+	conf_noffset = fit_conf_get_node(fit, images->fit_uname_cfg);
+	if (conf_noffset < 0)
+		return conf_noffset;
+
+	for (loadables_index = 0;
+	     uname = fdt_stringlist_get(fit, conf_noffset,
+			FIT_LOADABLE_PROP, loadables_index, NULL), uname;
+	     loadables_index++) {
+		cpu_noffset = fit_image_get_node(fit, uname);
+		if (cpu_noffset < 0)
+			return cpu_noffset;
+		if (amp_image_running(fit, cpu_noffset))
+			continue;
+
+		ret = boot_load_loadable(images, IH_ARCH_DEFAULT, uname);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static int brought_up_boot_cpu(void);
+
 static int brought_up_all_amp(void *fit, const char *fit_uname_cfg)
 {
 	int loadables_index;
@@ -398,6 +470,201 @@ static int brought_up_all_amp(void *fit, const char *fit_uname_cfg)
 			return ret;
 	}
 
+	return brought_up_boot_cpu();
+}
+
+#ifdef CONFIG_ROCKCHIP_AMP_EARLY_START
+/* Start reading the next chunk of amp.img, after the last one is in */
+static int amp_read_next(amp_reader_t *r)
+{
+	lbaint_t cnt;
+	ulong blks;
+
+	if (r->queued) {
+		if (blk_wait(r->dev_desc))
+			return -EIO;
+		r->done += r->queued;
+		r->queued = 0;
+	}
+
+	if (r->done >= r->blkcnt)
+		return 0;
+
+	cnt = min_t(lbaint_t, AMP_READ_CHUNK / r->dev_desc->blksz,
+		    r->blkcnt - r->done);
+	blks = blk_dread_async(r->dev_desc, r->start + r->done, cnt,
+			       r->fit + r->done * r->dev_desc->blksz);
+	if (!blks || IS_ERR_VALUE(blks))
+		return -EIO;
+	r->queued = blks;
+
+	return 0;
+}
+
+/* Wait for the first @end bytes of amp.img to be read */
+static int amp_read_until(amp_reader_t *r, ulong end)
+{
+	int ret;
+
+	while (r->done * r->dev_desc->blksz < end) {
+		if (!r->queued && r->done >= r->blkcnt)
+			return -EINVAL;
+		ret = amp_read_next(r);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/* Bytes of amp.img to be read before the data of an image is in */
+static ulong amp_image_data_end(const void *fit, int noffset)
+{
+	int offset, size;
+
+	/* embedded data is part of the FIT structure */
+	if (fit_image_get_data_size(fit, noffset, &size))
+		return fdt_totalsize(fit);
+
+	if (!fit_image_get_data_position(fit, noffset, &offset))
+		return offset + size;
+	if (!fit_image_get_data_offset(fit, noffset, &offset))
+		return ALIGN(fdt_totalsize(fit), 4) + offset + size;
+
+	return fdt_totalsize(fit);
+}
+
+/* Wait for an image to be read, then load it to where it runs */
+static int amp_load_early(amp_reader_t *r, bootm_headers_t *images,
+			  const char *uname, int noffset)
+{
+	int ret;
+
+	ret = amp_read_until(r, amp_image_data_end(r->fit, noffset));
+	if (ret) {
+		AMP_E("Read %s, ret=%d\n", uname, ret);
+		return ret;
+	}
+
+	ret = boot_load_loadable(images, IH_ARCH_DEFAULT, uname);
+	if (ret) {
+		AMP_E("Load %s, ret=%d\n", uname, ret);
+		return ret;
+	}
+	flush_dcache_all();
+
+	return 0;
+}
+
+/*
+ * Like boot_get_loadable() followed by brought_up_all_amp(), but each cpu
+ * is started as soon as its image is read and verified, while the rest of
+ * amp.img is read. Linux is loaded last, so that it doesn't hold back the
+ * other cpus.
+ */
+static int brought_up_all_amp_early(amp_reader_t *r, bootm_headers_t *images)
+{
+	void *fit = r->fit;
+	int loadables_index;
+	int linux_noffset;
+	int conf_noffset;
+	int cpu_noffset;
+	int ret;
+	const char *uname;
+
+	conf_noffset = fit_conf_get_node(fit, images->fit_uname_cfg);
+	if (conf_noffset < 0)
+		return conf_noffset;
+
+	/* see brought_up_all_amp() */
+	g_bootcpu.boot_on = 1;
+
+	for (loadables_index = 0;
+	     uname = fdt_stringlist_get(fit, conf_noffset,
+			FIT_LOADABLE_PROP, loadables_index, NULL), uname;
+	     loadables_index++) {
+		cpu_noffset = fit_image_get_node(fit, uname);
+		if (cpu_noffset < 0)
+			return cpu_noffset;
+
+		if (!amp_image_running(fit, cpu_noffset)) {
+			ret = amp_load_early(r, images, uname, cpu_noffset);
+			if (ret)
+				return ret;
+		}
+
+		ret = brought_up_amp(fit, cpu_noffset, &g_bootcpu, 0);
+		if (ret)
+			return ret;
+	}
+
+	/* amp.img is done with, don't leave a read running */
+	ret = amp_read_next(r);
+	if (ret)
+		return ret;
+	if (r->queued && blk_wait(r->dev_desc))
+		return -EIO;
+	r->queued = 0;
+
+	linux_noffset = fdt_subnode_offset(fit, conf_noffset, "linux");
+	if (linux_noffset > 0) {
+		ret = brought_up_amp(fit, linux_noffset, &g_bootcpu, 1);
+		if (ret)
+			return ret;
+	}
+
+	return brought_up_boot_cpu();
+}
+
+static int amp_cpus_on_early(struct blk_desc *dev_desc, disk_partition_t *part,
+			     void *hdr, int totalsize)
+{
+	bootm_headers_t images;
+	amp_reader_t r;
+	int ret;
+
+	r.fit = memalign(ARCH_DMA_MINALIGN, ALIGN(totalsize, part->blksz));
+	if (!r.fit) {
+		printf("No memory\n");
+		return -ENOMEM;
+	}
+	memcpy(r.fit, hdr, FIT_HEADER_SIZE);
+
+	r.dev_desc = dev_desc;
+	r.start = part->start;
+	r.blkcnt = DIV_ROUND_UP(totalsize, part->blksz);
+	r.done = DIV_ROUND_UP(FIT_HEADER_SIZE, part->blksz);
+	r.queued = 0;
+
+	/* the FIT structure first, it tells where the images are */
+	ret = amp_read_until(&r, fdt_totalsize(hdr));
+	if (ret)
+		goto out;
+
+	ret = parse_os_amp_dispatcher();
+	if (ret < 0) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	memset(&images, 0, sizeof(images));
+	images.fit_uname_cfg = "conf";
+	images.fit_hdr_os = r.fit;
+	images.verify = 1;
+	ret = brought_up_all_amp_early(&r, &images);
+	if (ret)
+		AMP_E("Brought up amps, ret=%d\n", ret);
+out:
+	if (r.queued)
+		blk_wait(dev_desc);
+	free(r.fit);
+
+	return ret;
+}
+#endif
+
+static int brought_up_boot_cpu(void)
+{
 	/* === only boot cpu can reach here === */
 
 	if (!g_bootcpu.boot_on) {
@@ -455,7 +722,7 @@ int amp_cpus_on(void)
 	if (!dev_desc)
 		return -EIO;
 
-	if (part_get_info_by_name(dev_desc, AMP_PART, &part) < 0)
+	if (part_get_info_by_name(dev_desc, PART_AMP, &part) < 0)
 		return -ENODEV;
 
 	hdr = memalign(ARCH_DMA_MINALIGN, FIT_HEADER_SIZE);
@@ -482,6 +749,11 @@ int amp_cpus_on(void)
 		goto out2;
 	}
 
+#ifdef CONFIG_ROCKCHIP_AMP_EARLY_START
+	ret = amp_cpus_on_early(dev_desc, &part, hdr, totalsize);
+	goto out2;
+#endif
+
 	/* load image */
 	fit = memalign(ARCH_DMA_MINALIGN, ALIGN(totalsize, part.blksz));
 	if (!fit) {
@@ -510,7 +782,7 @@ int amp_cpus_on(void)
 	images.fit_uname_cfg = "conf";
 	images.fit_hdr_os = fit;
 	images.verify = 1;
-	ret = boot_get_loadable(0, NULL, &images, IH_ARCH_DEFAULT, NULL, NULL);
+	ret = amp_load_loadables(&images);
 	if (ret) {
 		AMP_E("Load loadables, ret=%d\n", ret);
 		goto out1;
@@ -212,8 +212,18 @@ int crypto_hmac_final(struct udevice *dev, sha_context *ctx, u8 *output)
 int crypto_sha_csum(struct udevice *dev, sha_context *ctx,
 		    char *input, u32 input_len, u8 *output)
 {
+	const struct dm_crypto_ops *ops = device_get_ops(dev);
 	int ret;
 
+	if (ops && ops->sha_regions && ctx && ctx->length) {
+		struct image_region region = {
+			.data = input,
+			.size = input_len,
+		};
+
+		return crypto_sha_regions_csum(dev, ctx, &region, 1, output);
+	}
+
 	ret = crypto_sha_init(dev, ctx);
 	if (ret)
 		return ret;
@@ -231,12 +241,17 @@ int crypto_sha_regions_csum(struct udevice *dev, sha_context *ctx,
 			    const struct image_region region[],
 			    int region_count, u8 *output)
 {
+	const struct dm_crypto_ops *ops = device_get_ops(dev);
 	int i, ret;
 
 	ctx->length = 0;
 	for (i = 0; i < region_count; i++)
 		ctx->length += region[i].size;
 
+	/* Empty input is handled by crypto_sha_final() */
+	if (ops && ops->sha_regions && ctx->length)
+		return ops->sha_regions(dev, ctx, region, region_count, output);
+
 	ret = crypto_sha_init(dev, ctx);
 	if (ret)
 		return ret;
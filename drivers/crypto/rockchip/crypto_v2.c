@@ -655,6 +655,270 @@ exit:
 	return ret;
 }
 
+#if CONFIG_IS_ENABLED(ROCKCHIP_HASH_LLI)
+/* Descriptors per DMA start, the chain pauses after the last one */
+#define HASH_LLI_MAX		32
+
+/*
+ * Descriptor chain for hashing several buffers in one DMA run.
+ *
+ * Aligned data is hashed in place. Data that would break the engine's
+ * alignment rules is copied into @bounce, where consecutive pieces are
+ * merged into one segment until it is a multiple of DATA_LEN_ALIGN_SIZE
+ * again, so every descriptor but the very last one is fully aligned.
+ */
+struct rk_hash_lli_chain {
+	struct crypto_lli_desc	*lli;
+	u8			*bounce;	/* HASH_CACHE_SIZE bytes */
+	u32			nlli;		/* descriptors queued */
+	u32			queued;		/* bytes queued */
+	u32			seg_start;	/* open bounce segment */
+	u32			bounce_used;
+	u8			started;
+};
+
+static void hash_lli_add(struct rk_hash_lli_chain *chain,
+			 const u8 *data, u32 len)
+{
+	struct crypto_lli_desc *lli = &chain->lli[chain->nlli++];
+
+	memset(lli, 0x00, sizeof(*lli));
+	lli->src_addr = (u32)virt_to_phys(data);
+	lli->src_len = len;
+
+	/* Flushed with the descriptors by hash_lli_kick() */
+	chain->queued += len;
+}
+
+static void hash_lli_close(struct rk_hash_lli_chain *chain)
+{
+	u32 len = chain->bounce_used - chain->seg_start;
+
+	if (!len)
+		return;
+
+	hash_lli_add(chain, chain->bounce + chain->seg_start, len);
+	chain->seg_start = chain->bounce_used;
+}
+
+static int hash_lli_kick(struct rockchip_crypto_priv *priv,
+			 struct rk_hash_lli_chain *chain, u8 is_last)
+{
+	struct dcache_range ranges[HASH_LLI_MAX + 1];
+	struct crypto_lli_desc *lli = chain->lli, *last;
+	u32 tmp, mask, i, n = 0;
+	int ret;
+
+	/* An empty message still needs one (zero length) descriptor */
+	if (!chain->nlli)
+		hash_lli_add(chain, chain->bounce, 0);
+
+	for (i = 0; i + 1 < chain->nlli; i++)
+		lli[i].next_addr = (u32)virt_to_phys(&lli[i + 1]);
+
+	last = &lli[chain->nlli - 1];
+	last->dma_ctrl = LLI_DMA_CTRL_SRC_DONE;
+	if (is_last) {
+		last->user_define |= LLI_USER_STRING_LAST;
+		last->dma_ctrl |= LLI_DMA_CTRL_LAST;
+	} else {
+		/* The next batch is written from the start of the array */
+		last->next_addr = (u32)virt_to_phys(lli);
+		last->dma_ctrl |= LLI_DMA_CTRL_PAUSE;
+	}
+
+	if (!chain->started) {
+		lli->user_define |=
+			(LLI_USER_STRING_START | LLI_USER_CIPHER_START);
+		crypto_write((u32)virt_to_phys(lli), CRYPTO_DMA_LLI_ADDR);
+		crypto_write((CRYPTO_HASH_ENABLE << CRYPTO_WRITE_MASK_SHIFT) |
+			     CRYPTO_HASH_ENABLE, CRYPTO_HASH_CTL);
+		tmp = CRYPTO_DMA_START;
+		chain->started = 1;
+	} else {
+		tmp = CRYPTO_DMA_RESTART;
+	}
+
+	/* The data and the descriptors, with one barrier for all of them */
+	for (i = 0; i < chain->nlli; i++) {
+		if (!lli[i].src_len)
+			continue;
+		ranges[n].start = (ulong)phys_to_virt(lli[i].src_addr);
+		ranges[n].stop = ranges[n].start + lli[i].src_len;
+		n++;
+	}
+	ranges[n].start = (ulong)lli;
+	ranges[n].stop = (ulong)(lli + chain->nlli);
+	flush_dcache_ranges(ranges, n + 1);
+
+	crypto_write(tmp << CRYPTO_WRITE_MASK_SHIFT | tmp, CRYPTO_DMA_CTL);
+
+	/* mask CRYPTO_SYNC_LOCKSTEP_INT_ST flag */
+	mask = ~CRYPTO_SYNC_LOCKSTEP_INT_ST;
+
+	ret = RK_POLL_TIMEOUT(!(crypto_read(CRYPTO_DMA_INT_ST) & mask),
+			      RK_CRYPTO_TIMEOUT);
+
+	tmp = crypto_read(CRYPTO_DMA_INT_ST);
+	crypto_write(tmp, CRYPTO_DMA_INT_ST);
+
+	if ((tmp & mask) != CRYPTO_SRC_ITEM_DONE_INT_ST &&
+	    (tmp & mask) != CRYPTO_ZERO_LEN_INT_ST) {
+		debug("[%s] %d: CRYPTO_DMA_INT_ST = 0x%x\n",
+		      __func__, __LINE__, tmp);
+		return -EFAULT;
+	}
+
+	priv->length += chain->queued;
+	chain->queued = 0;
+	chain->nlli = 0;
+
+	/* Keep the open bounce segment for the next batch */
+	tmp = chain->bounce_used - chain->seg_start;
+	if (tmp)
+		memmove(chain->bounce, chain->bounce + chain->seg_start, tmp);
+	chain->bounce_used = tmp;
+	chain->seg_start = 0;
+
+	return ret;
+}
+
+static int hash_lli_update(struct rockchip_crypto_priv *priv,
+			   struct rk_hash_lli_chain *chain,
+			   const u8 *data, u32 len)
+{
+	u32 n, seg_len;
+	int ret;
+
+	while (len) {
+		if (chain->nlli == HASH_LLI_MAX ||
+		    chain->queued >= HASH_UPDATE_LIMIT) {
+			ret = hash_lli_kick(priv, chain, 0);
+			if (ret)
+				return ret;
+		}
+
+		seg_len = chain->bounce_used - chain->seg_start;
+
+		if (!seg_len && len >= DATA_LEN_ALIGN_SIZE &&
+		    IS_ALIGNED((ulong)data, DATA_ADDR_ALIGN_SIZE)) {
+			n = round_down(min_t(u32, len, HASH_UPDATE_LIMIT),
+				       DATA_LEN_ALIGN_SIZE);
+			hash_lli_add(chain, data, n);
+			data += n;
+			len -= n;
+			continue;
+		}
+
+		if (chain->bounce_used == HASH_CACHE_SIZE) {
+			if (seg_len) {
+				hash_lli_close(chain);
+			} else {
+				ret = hash_lli_kick(priv, chain, 0);
+				if (ret)
+					return ret;
+			}
+			continue;
+		}
+
+		n = min_t(u32, len, HASH_CACHE_SIZE - chain->bounce_used);
+		/* Aligned data only tops the segment up, then goes direct */
+		if (IS_ALIGNED((ulong)data, DATA_ADDR_ALIGN_SIZE) &&
+		    seg_len % DATA_LEN_ALIGN_SIZE)
+			n = min_t(u32, n, DATA_LEN_ALIGN_SIZE -
+				  seg_len % DATA_LEN_ALIGN_SIZE);
+
+		memcpy(chain->bounce + chain->bounce_used, data, n);
+		chain->bounce_used += n;
+		data += n;
+		len -= n;
+
+		if (IS_ALIGNED(seg_len + n, DATA_LEN_ALIGN_SIZE))
+			hash_lli_close(chain);
+	}
+
+	return 0;
+}
+
+static int hash_lli_finish(struct rockchip_crypto_priv *priv,
+			   struct rk_hash_lli_chain *chain)
+{
+	int ret;
+
+	if (chain->nlli == HASH_LLI_MAX) {
+		ret = hash_lli_kick(priv, chain, 0);
+		if (ret)
+			return ret;
+	}
+
+	hash_lli_close(chain);
+
+	return hash_lli_kick(priv, chain, 1);
+}
+
+static int rockchip_crypto_sha_regions(struct udevice *dev, sha_context *ctx,
+				       const struct image_region region[],
+				       int region_count, u8 *output)
+{
+	struct rockchip_crypto_priv *priv = dev_get_priv(dev);
+	struct rk_hash_ctx *hash_ctx = priv->hw_ctx;
+	struct rk_hash_lli_chain chain;
+	int i, ret;
+
+	if (!ctx)
+		return -EINVAL;
+
+	memset(&chain, 0x00, sizeof(chain));
+	chain.lli = align_malloc(sizeof(*chain.lli) * HASH_LLI_MAX,
+				 CONFIG_SYS_CACHELINE_SIZE);
+	chain.bounce = align_malloc(HASH_CACHE_SIZE,
+				    CONFIG_SYS_CACHELINE_SIZE);
+	if (!chain.lli || !chain.bounce) {
+		ret = -ENOMEM;
+		goto exit;
+	}
+
+	memset(hash_ctx, 0x00, sizeof(*hash_ctx));
+	priv->length = 0;
+
+	rk_crypto_enable_clk(dev);
+	ret = rk_hash_init(hash_ctx, ctx->algo);
+	if (ret)
+		goto disable_clk;
+
+	for (i = 0; i < region_count; i++) {
+		ret = hash_lli_update(priv, &chain, region[i].data,
+				      region[i].size);
+		if (ret)
+			goto clean_ctx;
+	}
+
+	ret = hash_lli_finish(priv, &chain);
+	if (ret)
+		goto clean_ctx;
+
+	if (priv->length != ctx->length) {
+		printf("total length(0x%08x) != init length(0x%08x)!\n",
+		       priv->length, ctx->length);
+		ret = -EIO;
+		goto clean_ctx;
+	}
+
+	ret = rk_hash_final(hash_ctx, output,
+			    BITS2BYTE(crypto_algo_nbits(ctx->algo)));
+
+clean_ctx:
+	hw_hash_clean_ctx(hash_ctx);
+disable_clk:
+	rk_crypto_disable_clk(dev);
+exit:
+	align_free(chain.lli);
+	align_free(chain.bounce);
+
+	return ret;
+}
+#endif
+
 #if CONFIG_IS_ENABLED(ROCKCHIP_HMAC)
 int rk_hmac_init(void *hw_ctx, u32 algo, u8 *key, u32 key_len)
 {
@@ -1451,6 +1715,9 @@ static const struct dm_crypto_ops rockchip_crypto_ops = {
 	.sha_init     = rockchip_crypto_sha_init,
 	.sha_update   = rockchip_crypto_sha_update,
 	.sha_final    = rockchip_crypto_sha_final,
+#if CONFIG_IS_ENABLED(ROCKCHIP_HASH_LLI)
+	.sha_regions  = rockchip_crypto_sha_regions,
+#endif
 #if CONFIG_IS_ENABLED(ROCKCHIP_RSA)
 	.rsa_verify   = rockchip_crypto_rsa_verify,
 #endif
@@ -16,6 +16,7 @@
 #include <hash.h>
 #include <linux/list.h>
 #include <linux/compiler.h>
+#include <linux/sizes.h>
 
 static LIST_HEAD(dfu_list);
 static int dfu_alt_num;
@@ -136,6 +137,103 @@ static char *dfu_get_hash_algo(void)
 	return NULL;
 }
 
+/* Data written per dfu_write_background() call */
+#define DFU_WRITE_SLICE		SZ_128K
+
+#ifdef CONFIG_DFU_WRITE_BACKGROUND
+/* Entity with a half buffer being written out */
+static struct dfu_entity *dfu_write_busy;
+
+/*
+ * Only raw MMC takes the data in pieces, the other media erase around each
+ * write and get whole buffers.
+ */
+static bool dfu_can_split(struct dfu_entity *dfu)
+{
+	return dfu->dev_type == DFU_DEV_MMC && dfu->layout == DFU_RAW_ADDR &&
+	       dfu_get_buf_size() / 2 >= DFU_WRITE_SLICE;
+}
+
+static void dfu_write_slice(struct dfu_entity *dfu)
+{
+	long w_size = min(dfu->w_left, (long)DFU_WRITE_SLICE);
+	int ret;
+
+	ret = dfu->write_medium(dfu, dfu->offset, dfu->w_buf, &w_size);
+	if (ret) {
+		debug("%s: Write error!\n", __func__);
+		dfu->w_ret = ret;
+		dfu->w_left = 0;
+	} else {
+		dfu->w_buf += w_size;
+		dfu->w_left -= w_size;
+		dfu->offset += w_size;
+	}
+
+	if (!dfu->w_left)
+		dfu_write_busy = NULL;
+}
+
+/* Finishes writing the other half, returns its error if any */
+static int dfu_write_wait(struct dfu_entity *dfu)
+{
+	int ret;
+
+	while (dfu->w_left)
+		dfu_write_slice(dfu);
+
+	ret = dfu->w_ret;
+	dfu->w_ret = 0;
+
+	return ret;
+}
+
+void dfu_write_background(void)
+{
+	if (dfu_write_busy)
+		dfu_write_slice(dfu_write_busy);
+}
+
+/* Hands the full half over to dfu_write_background(), receives in the other */
+static int dfu_write_buffer_split(struct dfu_entity *dfu, long w_size)
+{
+	unsigned char *buf = dfu_get_buf(dfu);
+	long half = dfu->i_buf_end - dfu->i_buf_start;
+	int ret;
+
+	ret = dfu_write_wait(dfu);
+	if (ret)
+		return ret;
+
+	dfu->w_buf = dfu->i_buf_start;
+	dfu->w_left = w_size;
+	dfu_write_busy = dfu;
+
+	dfu->i_buf_start = dfu->i_buf_start == buf ? buf + half : buf;
+	dfu->i_buf_end = dfu->i_buf_start + half;
+	dfu->i_buf = dfu->i_buf_start;
+
+	puts("#");
+
+	return 0;
+}
+#else
+static inline bool dfu_can_split(struct dfu_entity *dfu)
+{
+	return false;
+}
+
+static inline int dfu_write_wait(struct dfu_entity *dfu)
+{
+	return 0;
+}
+
+static inline int dfu_write_buffer_split(struct dfu_entity *dfu, long w_size)
+{
+	return -ENOSYS;
+}
+#endif
+
 static int dfu_write_buffer_drain(struct dfu_entity *dfu)
 {
 	long w_size;
@@ -150,6 +248,9 @@ static int dfu_write_buffer_drain(struct dfu_entity *dfu)
 		dfu_hash_algo->hash_update(dfu_hash_algo, &dfu->crc,
 					   dfu->i_buf_start, w_size, 0);
 
+	if (dfu->w_split)
+		return dfu_write_buffer_split(dfu, w_size);
+
 	ret = dfu->write_medium(dfu, dfu->offset, dfu->i_buf_start, &w_size);
 	if (ret)
 		debug("%s: Write error!\n", __func__);
@@ -177,8 +278,15 @@ void dfu_transaction_cleanup(struct dfu_entity *dfu)
 	dfu->r_left = 0;
 	dfu->b_left = 0;
 	dfu->bad_skip = 0;
+#ifdef CONFIG_DFU_WRITE_BACKGROUND
+	if (dfu_write_busy == dfu)
+		dfu_write_busy = NULL;
+#endif
+	dfu->w_left = 0;
+	dfu->w_ret = 0;
 
 	dfu->inited = 0;
+	dfu->w_split = 0;
 }
 
 int dfu_transaction_initiate(struct dfu_entity *dfu, bool read)
@@ -195,6 +303,12 @@ int dfu_transaction_initiate(struct dfu_entity *dfu, bool read)
 
 	dfu->i_buf_end = dfu->i_buf_start + dfu_get_buf_size();
 
+	if (!read && dfu_can_split(dfu)) {
+		dfu->i_buf_end = dfu->i_buf_start +
+			round_down(dfu_get_buf_size() / 2, DFU_WRITE_SLICE);
+		dfu->w_split = 1;
+	}
+
 	if (read) {
 		ret = dfu->get_medium_size(dfu, &dfu->r_left);
 		if (ret < 0)
@@ -212,8 +326,12 @@ int dfu_flush(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 	int ret = 0;
 
 	ret = dfu_write_buffer_drain(dfu);
-	if (ret)
+	if (!ret)
+		ret = dfu_write_wait(dfu);
+	if (ret) {
+		dfu_transaction_cleanup(dfu);
 		return ret;
+	}
 
 	if (dfu->flush_medium)
 		ret = dfu->flush_medium(dfu);
@@ -568,8 +686,11 @@ int dfu_write_from_mem_addr(struct dfu_entity *dfu, void *buf, int size)
 	 * has been properly initialized - e.g. if "dfu_bufsiz" has been taken
 	 * into account.
 	 */
-	dfu_get_buf(dfu);
-	dfu_buf_size = dfu_get_buf_size();
+	ret = dfu_transaction_initiate(dfu, false);
+	if (ret)
+		return ret;
+	/* Half of it with CONFIG_DFU_WRITE_BACKGROUND */
+	dfu_buf_size = dfu->i_buf_end - dfu->i_buf_start;
 	debug("%s: dfu buf size: %lu\n", __func__, dfu_buf_size);
 
 	for (i = 0; left > 0; i++) {
@@ -25,6 +25,9 @@ DECLARE_GLOBAL_DATA_PTR;
 #define I2C_TIMEOUT_MS		100
 #define I2C_RETRY_COUNT		3
 
+/* Fast-mode Plus is the fastest mode the controller can do */
+#define I2C_MAX_SPEED_HZ	1000000
+
 /* rk i2c fifo max transfer bytes */
 #define RK_I2C_FIFO_SIZE	32
 
@@ -33,6 +36,8 @@ struct rk_i2c {
 	struct i2c_regs *regs;
 	unsigned int speed;
 	unsigned int cfg;
+	unsigned int scl_rise_ns;
+	unsigned int scl_fall_ns;
 };
 
 struct i2c_spec_values {
@@ -168,10 +173,13 @@ static int rk_i2c_adapter_clk(struct rk_i2c *i2c, unsigned int scl_rate)
 
 	min_total_div = DIV_ROUND_UP(i2c_rate, speed * 8);
 
-	min_high_ns = spec->max_rise_ns + spec->min_high_ns;
+	/* Boards may give the rise and fall times their bus really has */
+	min_high_ns = (i2c->scl_rise_ns ? : spec->max_rise_ns) +
+		      spec->min_high_ns;
 	min_high_div = DIV_ROUND_UP(i2c_rate * min_high_ns, 8 * 1000000);
 
-	min_low_ns = spec->max_fall_ns + spec->min_low_ns;
+	min_low_ns = (i2c->scl_fall_ns ? : spec->max_fall_ns) +
+		     spec->min_low_ns;
 	min_low_div = DIV_ROUND_UP(i2c_rate * min_low_ns, 8 * 1000000);
 
 	min_high_div = (min_high_div < 1) ? 2 : min_high_div;
@@ -208,30 +216,49 @@ static int rk_i2c_adapter_clk(struct rk_i2c *i2c, unsigned int scl_rate)
 	return 0;
 }
 
-static int rk_i2c_send_start_bit(struct rk_i2c *i2c, u32 con)
+/*
+ * Wait for the @ipd_bit event, or a NAK. This spins on the status register
+ * instead of waiting a fixed time between reads of it: a byte only takes
+ * 9us at 1MHz, so any delay adds up over a transfer.
+ */
+static int rk_i2c_wait(struct rk_i2c *i2c, u32 ipd_bit, const char *what)
 {
 	struct i2c_regs *regs = i2c->regs;
-	ulong start;
-
-	debug("I2c Send Start bit.\n");
-	writel(I2C_IPD_ALL_CLEAN, &regs->ipd);
+	ulong start = get_timer(0);
+	u32 ipd;
 
-	writel(I2C_STARTIEN, &regs->ien);
-	writel(I2C_CON_EN | I2C_CON_START | i2c->cfg | con, &regs->con);
-
-	start = get_timer(0);
 	while (1) {
-		if (readl(&regs->ipd) & I2C_STARTIPD) {
-			writel(I2C_STARTIPD, &regs->ipd);
-			break;
+		ipd = readl(&regs->ipd);
+		if (ipd & I2C_NAKRCVIPD) {
+			writel(I2C_NAKRCVIPD, &regs->ipd);
+			return -EREMOTEIO;
+		}
+		if (ipd & ipd_bit) {
+			writel(ipd_bit, &regs->ipd);
+			return 0;
 		}
 		if (get_timer(start) > I2C_TIMEOUT_MS) {
-			debug("I2C Send Start Bit Timeout\n");
+			debug("I2C %s Timeout\n", what);
 			rk_i2c_show_regs(regs);
 			return -ETIMEDOUT;
 		}
-		udelay(1);
 	}
+}
+
+static int rk_i2c_send_start_bit(struct rk_i2c *i2c, u32 con)
+{
+	struct i2c_regs *regs = i2c->regs;
+	int ret;
+
+	debug("I2c Send Start bit.\n");
+	writel(I2C_IPD_ALL_CLEAN, &regs->ipd);
+
+	writel(I2C_STARTIEN, &regs->ien);
+	writel(I2C_CON_EN | I2C_CON_START | i2c->cfg | con, &regs->con);
+
+	ret = rk_i2c_wait(i2c, I2C_STARTIPD, "Send Start Bit");
+	if (ret)
+		return ret;
 
 	/* clean start bit */
 	writel(I2C_CON_EN | i2c->cfg | con, &regs->con);
@@ -242,7 +269,7 @@ static int rk_i2c_send_start_bit(struct rk_i2c *i2c, u32 con)
 static int rk_i2c_send_stop_bit(struct rk_i2c *i2c)
 {
 	struct i2c_regs *regs = i2c->regs;
-	ulong start;
+	int ret;
 
 	debug("I2c Send Stop bit.\n");
 	writel(I2C_IPD_ALL_CLEAN, &regs->ipd);
@@ -250,20 +277,11 @@ static int rk_i2c_send_stop_bit(struct rk_i2c *i2c)
 	writel(I2C_CON_EN | i2c->cfg | I2C_CON_STOP, &regs->con);
 	writel(I2C_CON_STOP, &regs->ien);
 
-	start = get_timer(0);
-	while (1) {
-		if (readl(&regs->ipd) & I2C_STOPIPD) {
-			writel(I2C_STOPIPD, &regs->ipd);
-			break;
-		}
-		if (get_timer(start) > I2C_TIMEOUT_MS) {
-			debug("I2C Send Start Bit Timeout\n");
-			rk_i2c_show_regs(regs);
-			return -ETIMEDOUT;
-		}
-		udelay(1);
-	}
+	ret = rk_i2c_wait(i2c, I2C_STOPIPD, "Send Stop Bit");
+	if (ret)
+		return ret;
 
+	/* Bus free time before the next START */
 	udelay(1);
 	return 0;
 }
@@ -283,7 +301,6 @@ static int rk_i2c_read(struct rk_i2c *i2c, uchar chip, uint reg, uint r_len,
 	uint bytes_remain_len = b_len;
 	uint bytes_xferred = 0;
 	uint words_xferred = 0;
-	ulong start;
 	uint con = 0;
 	uint rxdata;
 	uint i, j;
@@ -301,7 +318,9 @@ static int rk_i2c_read(struct rk_i2c *i2c, uchar chip, uint reg, uint r_len,
 	if (r_len == 0) {
 		writel(0, &regs->mrxraddr);
 	} else if (r_len < 4) {
-		writel(I2C_MRXRADDR_SET(r_len, reg), &regs->mrxraddr);
+		/* One valid bit per register address byte */
+		writel(I2C_MRXRADDR_SET((1 << r_len) - 1, reg),
+		       &regs->mrxraddr);
 	} else {
 		debug("I2C Read: addr len %d not supported\n", r_len);
 		return -EIO;
@@ -338,25 +357,9 @@ static int rk_i2c_read(struct rk_i2c *i2c, uchar chip, uint reg, uint r_len,
 		writel(I2C_MBRFIEN | I2C_NAKRCVIEN, &regs->ien);
 		writel(bytes_xferred, &regs->mrxcnt);
 
-		start = get_timer(0);
-		while (1) {
-			if (readl(&regs->ipd) & I2C_NAKRCVIPD) {
-				writel(I2C_NAKRCVIPD, &regs->ipd);
-				err = -EREMOTEIO;
-				goto i2c_exit;
-			}
-			if (readl(&regs->ipd) & I2C_MBRFIPD) {
-				writel(I2C_MBRFIPD, &regs->ipd);
-				break;
-			}
-			if (get_timer(start) > I2C_TIMEOUT_MS) {
-				debug("I2C Read Data Timeout\n");
-				err =  -ETIMEDOUT;
-				rk_i2c_show_regs(regs);
-				goto i2c_exit;
-			}
-			udelay(1);
-		}
+		err = rk_i2c_wait(i2c, I2C_MBRFIPD, "Read Data");
+		if (err)
+			goto i2c_exit;
 
 		for (i = 0; i < words_xferred; i++) {
 			rxdata = readl(&regs->rxdata[i]);
@@ -387,7 +390,6 @@ static int rk_i2c_write(struct rk_i2c *i2c, uchar chip, uint reg, uint r_len,
 	uint bytes_xferred = 0;
 	uint words_xferred = 0;
 	bool next = false;
-	ulong start;
 	uint txdata;
 	uint i, j;
 
@@ -434,25 +436,9 @@ static int rk_i2c_write(struct rk_i2c *i2c, uchar chip, uint reg, uint r_len,
 		writel(I2C_MBTFIEN | I2C_NAKRCVIEN, &regs->ien);
 		writel(bytes_xferred, &regs->mtxcnt);
 
-		start = get_timer(0);
-		while (1) {
-			if (readl(&regs->ipd) & I2C_NAKRCVIPD) {
-				writel(I2C_NAKRCVIPD, &regs->ipd);
-				err = -EREMOTEIO;
-				goto i2c_exit;
-			}
-			if (readl(&regs->ipd) & I2C_MBTFIPD) {
-				writel(I2C_MBTFIPD, &regs->ipd);
-				break;
-			}
-			if (get_timer(start) > I2C_TIMEOUT_MS) {
-				debug("I2C Write Data Timeout\n");
-				err =  -ETIMEDOUT;
-				rk_i2c_show_regs(regs);
-				goto i2c_exit;
-			}
-			udelay(1);
-		}
+		err = rk_i2c_wait(i2c, I2C_MBTFIPD, "Write Data");
+		if (err)
+			goto i2c_exit;
 
 		bytes_remain_len -= bytes_xferred;
 		debug("I2C Write bytes_remain_len %d\n", bytes_remain_len);
@@ -462,21 +448,30 @@ i2c_exit:
 	return err;
 }
 
+/*
+ * A write of up to 3 bytes followed by a read of the same chip, i.e. a
+ * register read: the controller sends the register address, the repeated
+ * start and reads the data in one TRX transfer.
+ */
+static bool rk_i2c_is_reg_read(struct i2c_msg *msg, int nmsgs)
+{
+	return nmsgs >= 2 && !(msg[0].flags & I2C_M_RD) &&
+	       msg[0].len > 0 && msg[0].len < 4 &&
+	       (msg[1].flags & I2C_M_RD) && msg[1].addr == msg[0].addr;
+}
+
 static int rockchip_i2c_xfer(struct udevice *bus, struct i2c_msg *msg,
 			     int nmsgs)
 {
 	struct rk_i2c *i2c = dev_get_priv(bus);
-	bool snd = false; /* second message for TRX read */
-	int ret;
+	bool snd = false; /* not the first message, use a repeated start */
+	uint reg;
+	int ret = 0, i;
 #ifdef CONFIG_IRQ
 	ulong flags;
 #endif
 
 	debug("i2c_xfer: %d messages\n", nmsgs);
-	if (nmsgs > 2 || ((nmsgs == 2) && (msg->flags & I2C_M_RD))) {
-		debug("Not support more messages now, split them\n");
-		return -EINVAL;
-	}
 
 #ifdef CONFIG_IRQ
 	local_irq_save(flags);
@@ -487,11 +482,16 @@ static int rockchip_i2c_xfer(struct udevice *bus, struct i2c_msg *msg,
 		debug("i2c_xfer: chip=0x%x, len=0x%x\n", msg->addr, msg->len);
 
 		if (msg->flags & I2C_M_RD) {
-			/* If snd is true, it is TRX mode. */
 			ret = rk_i2c_read(i2c, msg->addr, 0, 0, msg->buf,
 					  msg->len, snd);
+		} else if (rk_i2c_is_reg_read(msg, nmsgs)) {
+			for (reg = 0, i = 0; i < msg->len; i++)
+				reg |= msg->buf[i] << (i * 8);
+			ret = rk_i2c_read(i2c, msg->addr, reg, msg->len,
+					  msg[1].buf, msg[1].len, snd);
+			nmsgs--;
+			msg++;
 		} else {
-			snd = true;
 			ret = rk_i2c_write(i2c, msg->addr, 0, 0, msg->buf,
 					   msg->len);
 		}
@@ -500,6 +500,7 @@ static int rockchip_i2c_xfer(struct udevice *bus, struct i2c_msg *msg,
 			debug("i2c_write: error sending\n");
 			goto exit;
 		}
+		snd = true;
 	}
 
 exit:
@@ -525,10 +526,16 @@ int rockchip_i2c_set_bus_speed(struct udevice *bus, unsigned int speed)
 {
 	struct rk_i2c *i2c = dev_get_priv(bus);
 
+	if (speed > I2C_MAX_SPEED_HZ) {
+		debug("%s: %u Hz too fast, using Fast-mode Plus\n",
+		      bus->name, speed);
+		speed = I2C_MAX_SPEED_HZ;
+	}
+
 	if (rk3x_i2c_get_version(i2c) >= RK_I2C_VERSION1)
-		rk_i2c_adapter_clk(i2c, speed);
-	else
-		rk_i2c_set_clk(i2c, speed);
+		return rk_i2c_adapter_clk(i2c, speed);
+
+	rk_i2c_set_clk(i2c, speed);
 
 	return 0;
 }
@@ -545,6 +552,11 @@ static int rockchip_i2c_ofdata_to_platdata(struct udevice *bus)
 		return ret;
 	}
 
+	priv->scl_rise_ns = dev_read_u32_default(bus, "i2c-scl-rising-time-ns",
+						 0);
+	priv->scl_fall_ns = dev_read_u32_default(bus,
+						 "i2c-scl-falling-time-ns", 0);
+
 	return 0;
 }
 
@@ -30,6 +30,7 @@ struct irqchip_desc {
 
 static struct irq_desc irq_desc[PLATFORM_MAX_IRQ];
 static struct irqchip_desc irqchip;
+static struct pt_regs *irq_regs;
 static bool intr_setup;
 
 int bad_irq(int irq)
@@ -304,6 +305,11 @@ int irqs_resume(void)
 	return irqchip.gic->irq_resume();
 }
 
+struct pt_regs *get_irq_regs(void)
+{
+	return irq_regs;
+}
+
 #ifdef CONFIG_ARM64
 void do_irq(struct pt_regs *pt_regs, unsigned int esr)
 {
@@ -312,7 +318,9 @@ void do_irq(struct pt_regs *pt_regs, unsigned int esr)
 	show_regs(pt_regs);
 #endif
 
+	irq_regs = pt_regs;
 	__do_generic_irq_handler();
+	irq_regs = NULL;
 }
 #else
 void do_irq(struct pt_regs *pt_regs)
@@ -322,7 +330,9 @@ void do_irq(struct pt_regs *pt_regs)
 	show_regs(pt_regs);
 #endif
 
+	irq_regs = pt_regs;
 	__do_generic_irq_handler();
+	irq_regs = NULL;
 }
 #endif
 
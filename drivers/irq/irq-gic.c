@@ -7,6 +7,7 @@
 #include <common.h>
 #include <asm/gic.h>
 #include <config.h>
+#include <linux/sizes.h>
 #include "irq-internal.h"
 
 #define gicd_readl(offset)	readl((void *)GICD_BASE + (offset))
@@ -131,6 +132,28 @@ static int gic_irq_set_trigger(int irq, eINT_TRIG trig)
 	return 0;
 }
 
+#if !defined(CONFIG_GICV2) && defined(GICR_BASE)
+#define GICR_TYPER_LAST		BIT(4)
+
+/* The SGI frame of this CPU's redistributor, where its PPIs are enabled */
+static void __iomem *gicr_sgi_base(void)
+{
+	void __iomem *base = (void __iomem *)GICR_BASE;
+	u64 mpidr = read_mpidr(), typer;
+	u32 aff;
+
+	aff = (mpidr & 0xffffff) | ((mpidr >> 32) & 0xff) << 24;
+	for (;;) {
+		typer = readq(base + GICR_TYPER);
+		if ((typer >> 32) == aff)
+			return base + SZ_64K;
+		if (typer & GICR_TYPER_LAST)
+			return NULL;
+		base += 2 * SZ_64K;
+	}
+}
+#endif
+
 static int gic_irq_enable(int irq)
 {
 #ifdef CONFIG_GICV2
@@ -155,6 +178,18 @@ static int gic_irq_enable(int irq)
 	u32 val;
 	u64 affinity_val;
 
+#ifdef GICR_BASE
+	/* SGIs and PPIs are banked in the redistributor with GICv3 */
+	if (irq < 32) {
+		void __iomem *sgi_base = gicr_sgi_base();
+
+		if (!sgi_base)
+			return -ENODEV;
+		writel(1 << irq, sgi_base + GICR_ISENABLERn);
+		return 0;
+	}
+#endif
+
 	/* set enable */
 	val = gicd_readl(GICD_ISENABLERn + IRQ_REG_X32(irq));
 	val |= 1 << IRQ_REG_X32_OFFSET(irq);
@@ -170,6 +205,15 @@ static int gic_irq_enable(int irq)
 
 static int gic_irq_disable(int irq)
 {
+#if !defined(CONFIG_GICV2) && defined(GICR_BASE)
+	if (irq < 32) {
+		void __iomem *sgi_base = gicr_sgi_base();
+
+		if (sgi_base)
+			writel(1 << irq, sgi_base + GICR_ICENABLERn);
+		return 0;
+	}
+#endif
 	gicd_writel(1 << IRQ_REG_X32_OFFSET(irq),
 		    GICD_ICENABLERn + IRQ_REG_X32(irq));
 
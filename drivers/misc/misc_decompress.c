@@ -5,8 +5,6 @@
 #include <common.h>
 #include <dm.h>
 #include <misc.h>
-#include <dm/uclass.h>
-#include <dm/uclass-internal.h>
 
 #define HEAD_CRC		2
 #define EXTRA_FIELD		4
@@ -15,25 +13,28 @@
 #define RESERVED		0xe0
 #define DEFLATED		8
 
-static u32 misc_decomp_async, misc_decomp_sync;
+/* Time allowed for one job once the engine has started on it */
+#define MISC_DECOMP_TIMEOUT_MS	2000
+#define MISC_DECOMP_MAX_JOBS	8
 
-static void decomp_set_flags(u32 *flags, u8 comp)
-{
-	if (comp == IH_COMP_GZIP)
-		*flags |= DECOM_GZIP;
-	else if (comp == IH_COMP_LZ4)
-		*flags |= DECOM_LZ4;
-}
+enum {
+	JOB_FREE,
+	JOB_QUEUED,
+	JOB_RUNNING,
+};
 
-void misc_decompress_async(u8 comp)
-{
-	decomp_set_flags(&misc_decomp_async, comp);
-}
+struct misc_decomp_job {
+	struct decom_job job;
+	struct udevice *dev;
+	int state;
+	u32 seq;	/* submit order, jobs of one device run in this order */
+	ulong start;	/* get_timer() when the engine was started on it */
+};
 
-void misc_decompress_sync(u8 comp)
-{
-	decomp_set_flags(&misc_decomp_sync, comp);
-}
+static struct misc_decomp_job misc_decomp_jobs[MISC_DECOMP_MAX_JOBS];
+static u32 misc_decomp_seq;
+/* First error of a job without callback, reported by wait_all */
+static int misc_decomp_err;
 
 static int misc_gzip_parse_header(const unsigned char *src, unsigned long len)
 {
@@ -99,22 +100,15 @@ static u64 misc_get_data_size(unsigned long src, unsigned long len, u32 comp)
 	return size;
 }
 
-static void misc_setup_default_sync(u32 comp)
-{
-	if (comp == DECOM_GZIP)
-		misc_decompress_sync(IH_COMP_GZIP);
-	else if (comp == DECOM_LZ4)
-		misc_decompress_sync(IH_COMP_LZ4);
-}
-
 static struct udevice *misc_decompress_get_device(u32 comp)
 {
 	return misc_get_device_by_capability(comp);
 }
 
+/* @src_len bytes are loaded, @total_len is the full size of the data */
 static int misc_decompress_start(struct udevice *dev, unsigned long dst,
 				 unsigned long src, unsigned long src_len,
-				 u32 flags)
+				 unsigned long total_len, u32 flags)
 {
 	struct decom_param param;
 
@@ -131,11 +125,16 @@ static int misc_decompress_start(struct udevice *dev, unsigned long dst,
 	}
 
 	param.size_src = src_len;
-	param.size_dst = misc_get_data_size(src, src_len, param.mode);
+	param.size_dst = misc_get_data_size(src, total_len, param.mode);
 
 	if (!param.size_src || !param.size_dst)
 		return -EINVAL;
 
+	/* The output must not land on input that is still to be loaded */
+	if ((flags & DCOMP_FLG_STREAM) &&
+	    dst < src + total_len && src < dst + param.size_dst)
+		return -EINVAL;
+
 	return misc_ioctl(dev, IOCTL_REQ_START, &param);
 }
 
@@ -167,124 +166,379 @@ static int misc_decompress_data_size(struct udevice *dev, u64 *size, u32 comp)
 	return ret;
 }
 
-static int misc_decompress_finish(struct udevice *dev, u32 comp)
+static struct misc_decomp_job *misc_decomp_find(struct udevice *dev,
+						int state)
 {
-	int timeout = 200000;	/* 2s */
+	struct misc_decomp_job *j, *found = NULL;
 
-	while (!misc_decompress_is_complete(dev)) {
-		if (timeout < 0)
-			return -ETIMEDOUT;
-		timeout--;
-		udelay(10);
+	for (j = misc_decomp_jobs;
+	     j < misc_decomp_jobs + MISC_DECOMP_MAX_JOBS; j++) {
+		if (j->state != state || j->dev != dev)
+			continue;
+		if (!found || (int)(j->seq - found->seq) < 0)
+			found = j;
 	}
 
-	return misc_decompress_stop(dev);
+	return found;
 }
 
-int misc_decompress_cleanup(void)
+static void misc_decomp_complete(struct misc_decomp_job *j, int ret, u64 size)
+{
+	struct decom_job job = j->job;
+
+	/* Free the slot first, the callback may submit the next job */
+	j->state = JOB_FREE;
+	if (job.complete)
+		job.complete(&job, ret, size);
+	else if (ret && !misc_decomp_err)
+		misc_decomp_err = ret;
+}
+
+static int misc_decomp_run(struct misc_decomp_job *j)
 {
-	const struct misc_ops *ops;
-	struct udevice *dev;
-	struct uclass *uc;
 	int ret;
-	u32 comp;
 
-	ret = uclass_get(UCLASS_MISC, &uc);
+	ret = misc_decompress_start(j->dev, j->job.dst, j->job.src,
+				    j->job.src_len, j->job.src_len,
+				    j->job.flags);
 	if (ret)
-		return 0;
+		return ret;
 
-	/* use "find_" */
-	for (uclass_find_first_device(UCLASS_MISC, &dev);
-	     dev;
-	     uclass_find_next_device(&dev)) {
-		if (!device_active(dev))
-			continue;
-		ops = device_get_ops(dev);
-		if (!ops || !ops->ioctl)
-			continue;
-		else if (ops->ioctl(dev, IOCTL_REQ_CAPABILITY, &comp))
-			continue;
-		else if (misc_decomp_async & comp)
-			continue;
+	j->state = JOB_RUNNING;
+	j->start = get_timer(0);
+
+	return 0;
+}
+
+/*
+ * Move the queue of @dev on: reap the running job if the engine is done with
+ * it and start the next one. Returns true if the engine is (still) busy.
+ */
+static bool misc_decomp_advance(struct udevice *dev)
+{
+	struct misc_decomp_job *j;
+	u64 size = 0;
+	int ret;
+
+	j = misc_decomp_find(dev, JOB_RUNNING);
+	if (j) {
+		if (!misc_decompress_is_complete(dev)) {
+			if (get_timer(j->start) < MISC_DECOMP_TIMEOUT_MS)
+				return true;
+			printf("%s: decompress timeout\n", dev->name);
+			misc_decompress_stop(dev);
+			misc_decomp_complete(j, -ETIMEDOUT, 0);
+		} else {
+			ret = misc_decompress_data_size(dev, &size,
+							j->job.comp);
+			misc_decompress_stop(dev);
+			misc_decomp_complete(j, ret, size);
+		}
+	}
+
+	while ((j = misc_decomp_find(dev, JOB_QUEUED))) {
+		ret = misc_decomp_run(j);
+		if (!ret)
+			return true;
+		misc_decomp_complete(j, ret, 0);
+	}
+
+	return false;
+}
+
+/* Wait until the engine of @dev has nothing left to do */
+static void misc_decomp_drain(struct udevice *dev)
+{
+	while (misc_decomp_advance(dev))
+		udelay(10);
+}
 
-		if (misc_decomp_sync & comp) {
-			ret = misc_decompress_finish(dev, comp);
-			if (ret) {
-				printf("Failed to stop decompress: %s, ret=%d\n",
-				       dev->name, ret);
-				return ret;
+static struct misc_decomp_job *misc_decomp_alloc(struct udevice *dev)
+{
+	struct misc_decomp_job *j;
+	int i;
+
+	for (;;) {
+		for (i = 0; i < MISC_DECOMP_MAX_JOBS; i++) {
+			j = &misc_decomp_jobs[i];
+			if (j->state == JOB_FREE) {
+				j->dev = dev;
+				j->seq = misc_decomp_seq++;
+				return j;
 			}
 		}
+		/* All slots in use: make room by finishing the oldest jobs */
+		for (i = 0; i < MISC_DECOMP_MAX_JOBS; i++)
+			misc_decomp_advance(misc_decomp_jobs[i].dev);
+		udelay(10);
 	}
+}
+
+int misc_decompress_submit(const struct decom_job *job)
+{
+	struct misc_decomp_job *j;
+	struct udevice *dev;
+
+	dev = misc_decompress_get_device(job->comp);
+	if (!dev)
+		return -ENODEV;
+
+	if (!IS_ALIGNED(job->dst, ARCH_DMA_MINALIGN))
+		return -EINVAL;
+
+	j = misc_decomp_alloc(dev);
+	j->job = *job;
+	j->state = JOB_QUEUED;
+
+	misc_decomp_advance(dev);
 
 	return 0;
 }
 
+int misc_decompress_poll(void)
+{
+	struct misc_decomp_job *j;
+	int pending = 0;
+
+	for (j = misc_decomp_jobs;
+	     j < misc_decomp_jobs + MISC_DECOMP_MAX_JOBS; j++) {
+		if (j->state != JOB_FREE)
+			misc_decomp_advance(j->dev);
+	}
+
+	for (j = misc_decomp_jobs;
+	     j < misc_decomp_jobs + MISC_DECOMP_MAX_JOBS; j++) {
+		if (j->state != JOB_FREE)
+			pending++;
+	}
+
+	return pending;
+}
+
+/* A job wait_all has to wait for: anything not allowed to outlive U-Boot */
+static bool misc_decomp_must_wait(void)
+{
+	struct misc_decomp_job *j;
+
+	for (j = misc_decomp_jobs;
+	     j < misc_decomp_jobs + MISC_DECOMP_MAX_JOBS; j++) {
+		if (j->state == JOB_QUEUED ||
+		    (j->state == JOB_RUNNING &&
+		     !(j->job.flags & DCOMP_FLG_BOOT_ASYNC)))
+			return true;
+	}
+
+	return false;
+}
+
+int misc_decompress_wait_all(void)
+{
+	int ret;
+
+	while (misc_decompress_poll() && misc_decomp_must_wait())
+		udelay(10);
+
+	ret = misc_decomp_err;
+	misc_decomp_err = 0;
+
+	return ret;
+}
+
+int misc_decompress_cleanup(void)
+{
+	int ret;
+
+	ret = misc_decompress_wait_all();
+	if (ret)
+		printf("Failed to finish decompress, ret=%d\n", ret);
+
+	return ret;
+}
+
+struct misc_decomp_result {
+	int ret;
+	u64 size;
+};
+
+/* Completion of a job the submitter waits for itself */
+static void misc_decomp_sync_done(const struct decom_job *job, int ret,
+				  u64 size)
+{
+	struct misc_decomp_result *result = job->priv;
+
+	result->ret = ret;
+	result->size = size;
+}
+
 int misc_decompress_process(unsigned long dst, unsigned long src,
 			    unsigned long src_len, u32 comp, bool sync,
 			    u64 *size, u32 flags)
 {
+	struct decom_job job = {
+		.src = src,
+		.src_len = src_len,
+		.comp = comp,
+		.flags = flags,
+	};
 	struct udevice *dev;
+	struct misc_decomp_result result;
 	ulong dst_org = dst;
-	u64 dst_size = 0;
 	int ret;
 
 	dev = misc_decompress_get_device(comp);
 	if (!dev)
 		return -ENODEV;
 
-	/* Wait last finish */
-	ret = misc_decompress_finish(dev, comp);
-	if (ret)
-		return ret;
-
 	/*
 	 * Check if ARCH_DMA_MINALIGN aligned, otherwise use sync action
 	 * for output data memcpy.
 	 */
 	if (!IS_ALIGNED(dst, ARCH_DMA_MINALIGN)) {
-		dst_org = dst;
 		dst = ALIGN(dst, ARCH_DMA_MINALIGN);
 		sync = true;
 	}
-
-	ret = misc_decompress_start(dev, dst, src, src_len, flags);
-	if (ret)
-		return ret;
+	job.dst = dst;
 
 	/*
 	 * Wait this round finish ?
 	 *
 	 * If sync, return original data length after decompress done.
-	 * otherwise return from compressed file information.
+	 * otherwise return from compressed file information, the job is
+	 * reaped by later submits, polls or misc_decompress_cleanup().
 	 */
-	if (sync) {
-		ret = misc_decompress_finish(dev, comp);
-		if (ret)
-			return ret;
-
-		if (size || (dst != dst_org)) {
-			ret = misc_decompress_data_size(dev, &dst_size, comp);
-			if (size)
-				*size = dst_size;
-			if (dst != dst_org)
-				memcpy((char *)dst_org,
-				       (const char *)dst, dst_size);
-		}
-	} else {
-		/*
-		 * setup cleanup sync flags by default if this is a sync request,
-		 * unless misc_decompress_async() is called by manual.
-		 *
-		 * This avoid caller to forget to setup cleanup sync flags when
-		 * they use a async operation, otherwise cpu jump to kernel
-		 * before decompress done.
-		 */
-		misc_setup_default_sync(comp);
+	if (!sync) {
+		ret = misc_decompress_submit(&job);
+		if (!ret && size)
+			*size = misc_get_data_size(src, src_len, comp);
+		return ret;
+	}
+
+	job.complete = misc_decomp_sync_done;
+	job.priv = &result;
+	ret = misc_decompress_submit(&job);
+	if (ret)
+		return ret;
+
+	misc_decomp_drain(dev);
+	if (result.ret)
+		return result.ret;
+
+	if (size)
+		*size = result.size;
+	if (dst != dst_org)
+		memcpy((char *)dst_org, (const char *)dst, result.size);
+
+	return 0;
+}
+
+int misc_decompress_stream_start(unsigned long dst, unsigned long src,
+				 unsigned long src_len, unsigned long total_len,
+				 u32 comp, u32 flags)
+{
+	struct misc_decomp_job *j;
+	struct udevice *dev;
+	int ret;
+
+	dev = misc_decompress_get_device(comp);
+	if (!dev)
+		return -ENODEV;
+
+	/* No bounce buffer for the output, it is produced piece by piece */
+	if (!IS_ALIGNED(dst, ARCH_DMA_MINALIGN))
+		return -EINVAL;
+
+	/* The engine is fed by the caller, so the queue must be empty */
+	misc_decomp_drain(dev);
+
+	ret = misc_decompress_start(dev, dst, src, src_len, total_len,
+				    flags | DCOMP_FLG_STREAM);
+	if (ret)
+		return ret;
+
+	j = misc_decomp_alloc(dev);
+	j->job = (struct decom_job) {
+		.dst = dst,
+		.src = src,
+		.src_len = total_len,
+		.comp = comp,
+		.flags = flags,
+	};
+	j->state = JOB_RUNNING;
+	j->start = get_timer(0);
 
+	return 0;
+}
+
+int misc_decompress_stream_feed(unsigned long src, unsigned long src_len,
+				u32 comp)
+{
+	struct decom_param param;
+	struct misc_decomp_job *j;
+	struct udevice *dev;
+	int ret;
+
+	dev = misc_decompress_get_device(comp);
+	if (!dev)
+		return -ENODEV;
+
+	param.addr_src = src;
+	param.size_src = src_len;
+	param.mode = comp;
+
+	ret = misc_ioctl(dev, IOCTL_REQ_FEED, &param);
+
+	/* Don't let the window spent on loading count against the job */
+	j = misc_decomp_find(dev, JOB_RUNNING);
+	if (j)
+		j->start = get_timer(0);
+
+	return ret;
+}
+
+int misc_decompress_stream_end(unsigned long src, unsigned long src_len,
+			       u32 comp, bool sync, u64 *size)
+{
+	struct misc_decomp_result result;
+	struct misc_decomp_job *j;
+	struct udevice *dev;
+
+	dev = misc_decompress_get_device(comp);
+	if (!dev)
+		return -ENODEV;
+
+	if (!sync) {
 		if (size)
 			*size = misc_get_data_size(src, src_len, comp);
+		return 0;
 	}
 
-	return ret;
+	j = misc_decomp_find(dev, JOB_RUNNING);
+	if (!j)
+		return -EINVAL;
+
+	j->job.complete = misc_decomp_sync_done;
+	j->job.priv = &result;
+	misc_decomp_drain(dev);
+	if (result.ret)
+		return result.ret;
+
+	if (size)
+		*size = result.size;
+
+	return 0;
+}
+
+void misc_decompress_stream_abort(u32 comp)
+{
+	struct misc_decomp_job *j;
+	struct udevice *dev;
+
+	dev = misc_decompress_get_device(comp);
+	if (!dev)
+		return;
+
+	misc_decompress_stop(dev);
+	j = misc_decomp_find(dev, JOB_RUNNING);
+	if (j)
+		j->state = JOB_FREE;
 }
@@ -81,6 +81,12 @@ DECLARE_GLOBAL_DATA_PTR;
 	DISEIEN | LENEIEN | LITEIEN | SQMEIEN | SLCIEN | \
 	HDEIEN | DSIEN)
 
+/* Everything but "done" and "source length consumed" is an error */
+#define DECOM_ERR_MASK		(DECOM_INT_MASK & ~(SLCIEN | DSIEN))
+
+/* Time allowed for the engine to consume one source window */
+#define DECOM_FEED_TIMEOUT_MS	2000
+
 #define DCLK_DECOM		400 * 1000 * 1000
 
 struct rockchip_decom_priv {
@@ -143,7 +149,14 @@ static int rockchip_decom_start(struct udevice *dev, void *buf)
 	writel(limit_lo, priv->base + DECOM_LMTSL);
 	writel(limit_hi, priv->base + DECOM_LMTSH);
 
-	if (param->flags && DCOMP_FLG_IRQ_ONESHOT)
+	/*
+	 * Streaming: the engine pauses with SLC set once it has consumed
+	 * SLEN bytes, the next window is given by rockchip_decom_feed().
+	 */
+	if (param->flags & DCOMP_FLG_STREAM)
+		writel(param->size_src, priv->base + DECOM_SLEN);
+
+	if (param->flags & DCOMP_FLG_IRQ_ONESHOT)
 		writel(DECOM_INT_MASK, priv->base + DECOM_IEN);
 	writel(DECOM_ENABLE, priv->base + DECOM_ENR);
 
@@ -152,11 +165,52 @@ static int rockchip_decom_start(struct udevice *dev, void *buf)
 	return 0;
 }
 
+/* Wait for the current source window to be consumed, then restart on @buf */
+static int rockchip_decom_feed(struct udevice *dev, void *buf)
+{
+	struct rockchip_decom_priv *priv = dev_get_priv(dev);
+	struct decom_param *param = (struct decom_param *)buf;
+	ulong start;
+	u32 irq_status;
+
+	if (!priv->cached)
+		flush_dcache_range(param->addr_src,
+				   param->addr_src + param->size_src);
+
+	start = get_timer(0);
+	while (1) {
+		/* The stream ended early, e.g. this window is the trailer */
+		if (readl(priv->base + DECOM_STAT) & DECOM_COMPLETE)
+			return 0;
+
+		irq_status = readl(priv->base + DECOM_ISR);
+		if (irq_status & DECOM_ERR_MASK) {
+			printf("decom: stream error, isr=0x%x\n", irq_status);
+			return -EIO;
+		}
+		if (irq_status & SLCIEN)
+			break;
+
+		if (get_timer(start) > DECOM_FEED_TIMEOUT_MS)
+			return -ETIMEDOUT;
+	}
+
+	writel(SLCIEN, priv->base + DECOM_ISR);
+	writel(param->addr_src, priv->base + DECOM_RADDR);
+	writel(param->size_src, priv->base + DECOM_SLEN);
+	writel(DECOM_ENABLE, priv->base + DECOM_ENR);
+
+	return 0;
+}
+
 static int rockchip_decom_stop(struct udevice *dev)
 {
 	struct rockchip_decom_priv *priv = dev_get_priv(dev);
 
 	writel(DECOM_DISABLE, priv->base + DECOM_ENR);
+	/* An aborted stream never completes, so wait for idle next time */
+	if (!(readl(priv->base + DECOM_STAT) & DECOM_COMPLETE))
+		priv->idle_check_once = false;
 
 	return 0;
 }
@@ -213,6 +267,9 @@ static int rockchip_decom_ioctl(struct udevice *dev, unsigned long request,
 	case IOCTL_REQ_STOP:
 		ret = rockchip_decom_stop(dev);
 		break;
+	case IOCTL_REQ_FEED:
+		ret = rockchip_decom_feed(dev, buf);
+		break;
 	case IOCTL_REQ_CAPABILITY:
 		ret = rockchip_decom_capability(buf);
 		break;
@@ -0,0 +1,257 @@
+/*
+ * Copyright (C) 2024 Rockchip Electronics Co., Ltd
+ *
+ * eMMC Command Queue Host Controller Interface (CQHCI)
+ *
+ * Only the polled, data-transfer part of the engine is used: U-Boot keeps
+ * the card in legacy mode and switches it to command queue mode for the
+ * duration of a large read or write, so that up to 32 tasks can be kept
+ * outstanding on the card instead of one CMD18/CMD25 at a time.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#include <common.h>
+#include <cqhci.h>
+#include <errno.h>
+#include <malloc.h>
+#include <memalign.h>
+#include <mmc.h>
+#include <linux/sizes.h>
+
+/* Time allowed between two task completions */
+#define CQHCI_TASK_TIMEOUT_MS		2000
+#define CQHCI_HALT_TIMEOUT_MS		10
+
+/* 64-bit task descriptor followed by 64-bit link descriptor */
+#define CQHCI_SLOT_WORDS		2
+#define CQHCI_DESC_SIZE		(CQHCI_MAX_SLOTS * CQHCI_SLOT_WORDS * \
+					 sizeof(u64))
+#define CQHCI_TRANS_SIZE		(CQHCI_MAX_SLOTS * CQHCI_MAX_SEGS * \
+					 sizeof(u64))
+
+int cqhci_init(struct cqhci_host *cq_host, struct mmc *mmc)
+{
+	cq_host->mmc = mmc;
+	cq_host->num_slots = CQHCI_MAX_SLOTS;
+
+	cq_host->desc_base = memalign(ARCH_DMA_MINALIGN,
+				      ALIGN(CQHCI_DESC_SIZE,
+					    ARCH_DMA_MINALIGN));
+	cq_host->trans_base = memalign(ARCH_DMA_MINALIGN,
+				       ALIGN(CQHCI_TRANS_SIZE,
+					     ARCH_DMA_MINALIGN));
+	if (!cq_host->desc_base || !cq_host->trans_base) {
+		free(cq_host->desc_base);
+		free(cq_host->trans_base);
+		cq_host->desc_base = NULL;
+		cq_host->trans_base = NULL;
+		return -ENOMEM;
+	}
+
+	memset(cq_host->desc_base, 0, CQHCI_DESC_SIZE);
+	memset(cq_host->trans_base, 0, CQHCI_TRANS_SIZE);
+
+	debug("%s: CQHCI version 0x%x, caps 0x%x\n", __func__,
+	      cqhci_readl(cq_host, CQHCI_VER),
+	      cqhci_readl(cq_host, CQHCI_CAP));
+
+	return 0;
+}
+
+static int cqhci_halt(struct cqhci_host *cq_host)
+{
+	ulong start = get_timer(0);
+
+	cqhci_writel(cq_host, CQHCI_HALT, CQHCI_CTL);
+	while (!(cqhci_readl(cq_host, CQHCI_CTL) & CQHCI_HALT)) {
+		if (get_timer(start) > CQHCI_HALT_TIMEOUT_MS)
+			return -ETIMEDOUT;
+	}
+
+	return 0;
+}
+
+static void cqhci_enable(struct cqhci_host *cq_host)
+{
+	ulong desc = (ulong)cq_host->desc_base;
+	u32 cqcfg;
+
+	cqcfg = cqhci_readl(cq_host, CQHCI_CFG);
+	if (cqcfg & CQHCI_ENABLE) {
+		cqcfg &= ~CQHCI_ENABLE;
+		cqhci_writel(cq_host, cqcfg, CQHCI_CFG);
+	}
+
+	/* 64-bit task descriptors, no direct command slot */
+	cqcfg &= ~(CQHCI_DCMD | CQHCI_TASK_DESC_SZ);
+	cqhci_writel(cq_host, cqcfg, CQHCI_CFG);
+
+	cqhci_writel(cq_host, lower_32_bits(desc), CQHCI_TDLBA);
+	cqhci_writel(cq_host, upper_32_bits(desc), CQHCI_TDLBAU);
+
+	/* RCA used by the engine for its CMD13 status polling */
+	cqhci_writel(cq_host, cq_host->mmc->rca, CQHCI_SSC2);
+
+	/* Status is polled, so enable status bits but no signals */
+	cqhci_writel(cq_host, 0, CQHCI_ISGE);
+	cqhci_writel(cq_host, CQHCI_IS_MASK, CQHCI_ISTE);
+	cqhci_writel(cq_host, cqhci_readl(cq_host, CQHCI_IS), CQHCI_IS);
+
+	cqcfg |= CQHCI_ENABLE;
+	cqhci_writel(cq_host, cqcfg, CQHCI_CFG);
+
+	if (cqhci_readl(cq_host, CQHCI_CTL) & CQHCI_HALT)
+		cqhci_writel(cq_host, 0, CQHCI_CTL);
+
+	if (cq_host->ops->enable)
+		cq_host->ops->enable(cq_host);
+}
+
+static void cqhci_disable(struct cqhci_host *cq_host, bool recovery)
+{
+	u32 cqcfg;
+
+	if (cqhci_halt(cq_host))
+		debug("%s: CQE halt timeout\n", __func__);
+
+	if (recovery) {
+		cqhci_writel(cq_host, CQHCI_CLEAR_ALL_TASKS | CQHCI_HALT,
+			     CQHCI_CTL);
+		cqhci_writel(cq_host, ~0, CQHCI_TCN);
+	}
+
+	cqhci_writel(cq_host, 0, CQHCI_ISTE);
+	cqhci_writel(cq_host, cqhci_readl(cq_host, CQHCI_IS), CQHCI_IS);
+
+	cqcfg = cqhci_readl(cq_host, CQHCI_CFG);
+	cqcfg &= ~CQHCI_ENABLE;
+	cqhci_writel(cq_host, cqcfg, CQHCI_CFG);
+
+	if (cq_host->ops->disable)
+		cq_host->ops->disable(cq_host, recovery);
+}
+
+/* Fill the task, link and transfer descriptors of one slot */
+static void cqhci_prep_task(struct cqhci_host *cq_host, int tag, ulong buf,
+			    lbaint_t blk, uint blocks, uint blksz, bool read)
+{
+	u64 *task = cq_host->desc_base + tag * CQHCI_SLOT_WORDS;
+	u64 *trans = cq_host->trans_base + tag * CQHCI_MAX_SEGS;
+	u32 len = blocks * blksz, seg;
+	int i = 0;
+
+	task[0] = CQHCI_VALID(1) | CQHCI_END(1) | CQHCI_INT(1) |
+		  CQHCI_ACT(CQHCI_ACT_TASK) | CQHCI_DATA_DIR(read) |
+		  CQHCI_BLK_COUNT(blocks) | CQHCI_BLK_ADDR(blk);
+	task[1] = CQHCI_VALID(1) | CQHCI_ACT(CQHCI_ACT_LINK) |
+		  ((u64)lower_32_bits((ulong)trans) << 32);
+
+	while (len) {
+		seg = min_t(u32, len, CQHCI_MAX_SEG_SIZE);
+		len -= seg;
+		/* A length of 0 means 64KiB */
+		trans[i++] = CQHCI_VALID(1) | CQHCI_END(!len) |
+			     CQHCI_ACT(CQHCI_ACT_TRAN) | CQHCI_DAT_LENGTH(seg) |
+			     ((u64)lower_32_bits(buf) << 32);
+		buf += seg;
+	}
+}
+
+static int cqhci_wait_tasks(struct cqhci_host *cq_host, u32 *done)
+{
+	ulong start = get_timer(0);
+	u32 status;
+
+	do {
+		status = cqhci_readl(cq_host, CQHCI_IS);
+		if ((status & CQHCI_IS_ERR) ||
+		    (cq_host->ops->check_error &&
+		     cq_host->ops->check_error(cq_host))) {
+			printf("%s: CQE error, IS 0x%x, TERRI 0x%x\n",
+			       __func__, status,
+			       cqhci_readl(cq_host, CQHCI_TERRI));
+			cqhci_writel(cq_host, status, CQHCI_IS);
+			return -EIO;
+		}
+
+		if (status & CQHCI_IS_TCC) {
+			cqhci_writel(cq_host, CQHCI_IS_TCC, CQHCI_IS);
+			*done = cqhci_readl(cq_host, CQHCI_TCN);
+			cqhci_writel(cq_host, *done, CQHCI_TCN);
+			return 0;
+		}
+	} while (get_timer(start) < CQHCI_TASK_TIMEOUT_MS);
+
+	printf("%s: CQE timeout, pending 0x%x\n", __func__,
+	       cqhci_readl(cq_host, CQHCI_TDBR));
+
+	return -ETIMEDOUT;
+}
+
+int cqhci_request(struct cqhci_host *cq_host, struct mmc_data *data,
+		  lbaint_t start, uint depth)
+{
+	bool read = data->flags == MMC_DATA_READ;
+	ulong buf = (ulong)data->dest;
+	ulong len = (ulong)data->blocks * data->blocksize;
+	uint task_blks = CQHCI_MAX_SEGS * CQHCI_MAX_SEG_SIZE / data->blocksize;
+	uint left = data->blocks, cnt;
+	int slots = min_t(int, depth, cq_host->num_slots);
+	u32 busy = 0, pend, done;
+	int tag, ret = 0;
+
+	if (!cq_host->desc_base || !slots)
+		return -ENODEV;
+
+	/* ADMA2 descriptors only carry 32-bit addresses */
+	if (!IS_ALIGNED(buf, ARCH_DMA_MINALIGN) ||
+	    upper_32_bits(buf + len - 1))
+		return -EINVAL;
+
+	flush_dcache_range(buf, buf + ALIGN(len, ARCH_DMA_MINALIGN));
+	cqhci_enable(cq_host);
+
+	while (left || busy) {
+		pend = 0;
+		for (tag = 0; tag < slots && left; tag++) {
+			if (busy & BIT(tag))
+				continue;
+
+			cnt = min(left, task_blks);
+			cqhci_prep_task(cq_host, tag, buf, start, cnt,
+					data->blocksize, read);
+			pend |= BIT(tag);
+			buf += cnt * data->blocksize;
+			start += cnt;
+			left -= cnt;
+		}
+
+		if (pend) {
+			flush_dcache_range((ulong)cq_host->desc_base,
+					   (ulong)cq_host->desc_base +
+					   ALIGN(CQHCI_DESC_SIZE,
+						 ARCH_DMA_MINALIGN));
+			flush_dcache_range((ulong)cq_host->trans_base,
+					   (ulong)cq_host->trans_base +
+					   ALIGN(CQHCI_TRANS_SIZE,
+						 ARCH_DMA_MINALIGN));
+			busy |= pend;
+			cqhci_writel(cq_host, pend, CQHCI_TDBR);
+		}
+
+		ret = cqhci_wait_tasks(cq_host, &done);
+		if (ret)
+			break;
+		busy &= ~done;
+	}
+
+	cqhci_disable(cq_host, ret != 0);
+
+	if (read)
+		invalidate_dcache_range((ulong)data->dest,
+					(ulong)data->dest +
+					ALIGN(len, ARCH_DMA_MINALIGN));
+
+	return ret;
+}
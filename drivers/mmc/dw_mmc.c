@@ -7,6 +7,7 @@
  */
 
 #include <common.h>
+#include <blk.h>
 #include <bouncebuf.h>
 #include <div64.h>
 #include <errno.h>
@@ -16,6 +17,8 @@
 #include <dwmmc.h>
 #include <dm/pinctrl.h>
 #include <dm.h>
+#include <io-domain.h>
+#include <power/regulator.h>
 #ifdef CONFIG_DM_GPIO
 #include <asm/gpio.h>
 #include <asm-generic/gpio.h>
@@ -101,6 +104,24 @@ static int dwmci_wait_reset(struct dwmci_host *host, u32 value)
 	return 0;
 }
 
+/* Have the controller load CLKDIV, CLKSRC and CLKENA */
+static int dwmci_update_clock(struct dwmci_host *host, u32 flags)
+{
+	int timeout = 10000;
+
+	dwmci_writel(host, DWMCI_CMD, DWMCI_CMD_PRV_DAT_WAIT |
+			DWMCI_CMD_UPD_CLK | DWMCI_CMD_START | flags);
+
+	while (dwmci_readl(host, DWMCI_CMD) & DWMCI_CMD_START) {
+		if (timeout-- < 0) {
+			debug("%s: Timeout!\n", __func__);
+			return -ETIMEDOUT;
+		}
+	}
+
+	return 0;
+}
+
 static void dwmci_set_idma_desc(struct dwmci_idmac *idmac,
 		u32 desc0, u32 desc1, u32 desc2)
 {
@@ -112,43 +133,47 @@ static void dwmci_set_idma_desc(struct dwmci_idmac *idmac,
 	desc->next_addr = (ulong)desc + sizeof(struct dwmci_idmac);
 }
 
+/*
+ * Build the IDMAC chain for @data. Each segment of @sg is split into
+ * descriptors of up to 8 blocks; the chain never crosses from one segment
+ * into the next within a descriptor, so segments need not be contiguous.
+ * The chain needs DIV_ROUND_UP(blocks, 8) + nsegs descriptors at most.
+ */
 static void dwmci_prepare_data(struct dwmci_host *host,
 			       struct mmc_data *data,
 			       struct dwmci_idmac *cur_idmac,
-			       void *bounce_buffer)
+			       const struct blk_sg *sg, int nsegs)
 {
 	unsigned long ctrl;
-	unsigned int i = 0, flags, cnt, blk_cnt;
-	ulong data_start, data_end;
-
-
-	blk_cnt = data->blocks;
+	unsigned int i = 0, s, flags, cnt, blk_cnt;
+	ulong data_start, data_end, addr;
 
 	dwmci_wait_reset(host, DWMCI_CTRL_FIFO_RESET);
 
 	data_start = (ulong)cur_idmac;
 	dwmci_writel(host, DWMCI_DBADDR, (ulong)cur_idmac);
 
-	do {
-		flags = DWMCI_IDMAC_OWN | DWMCI_IDMAC_CH ;
-		flags |= (i == 0) ? DWMCI_IDMAC_FS : 0;
-		if (blk_cnt <= 8) {
-			flags |= DWMCI_IDMAC_LD;
-			cnt = data->blocksize * blk_cnt;
-		} else
-			cnt = data->blocksize * 8;
-
-		dwmci_set_idma_desc(cur_idmac, flags, cnt,
-				    (ulong)bounce_buffer + (i * PAGE_SIZE));
-
-		if (blk_cnt <= 8)
-			break;
-		blk_cnt -= 8;
-		cur_idmac++;
-		i++;
-	} while(1);
+	for (s = 0; s < nsegs; s++) {
+		addr = (ulong)sg[s].buf;
+		blk_cnt = sg[s].blkcnt;
+
+		while (blk_cnt) {
+			flags = DWMCI_IDMAC_OWN | DWMCI_IDMAC_CH;
+			flags |= (i == 0) ? DWMCI_IDMAC_FS : 0;
+			cnt = min(blk_cnt, 8U);
+			blk_cnt -= cnt;
+			if (!blk_cnt && s == nsegs - 1)
+				flags |= DWMCI_IDMAC_LD;
+
+			dwmci_set_idma_desc(cur_idmac, flags,
+					    cnt * data->blocksize, addr);
+			addr += cnt * data->blocksize;
+			cur_idmac++;
+			i++;
+		}
+	}
 
-	data_end = (ulong)cur_idmac;
+	data_end = (ulong)(cur_idmac - 1);
 	flush_dcache_range(data_start, data_end + ARCH_DMA_MINALIGN);
 
 	ctrl = dwmci_readl(host, DWMCI_CTRL);
@@ -242,7 +267,8 @@ static int dwmci_data_transfer(struct dwmci_host *host, struct mmc_data *data)
 
 	timeout = dwmci_get_drto(host, size);
 	/* The tuning data is 128bytes, a timeout of 1ms is sufficient.*/
-	if ((dwmci_readl(host, DWMCI_CMD) & 0x1F) == MMC_SEND_TUNING_BLOCK_HS200)
+	if ((dwmci_readl(host, DWMCI_CMD) & 0x1F) == MMC_SEND_TUNING_BLOCK_HS200 ||
+	    (dwmci_readl(host, DWMCI_CMD) & 0x1F) == MMC_SEND_TUNING_BLOCK)
 		timeout = 1;
 
 	size /= 4;
@@ -375,24 +401,57 @@ static int dwmci_set_transfer_mode(struct dwmci_host *host,
 	return mode;
 }
 
-#ifdef CONFIG_DM_MMC
-static int dwmci_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
-		   struct mmc_data *data)
+#if CONFIG_IS_ENABLED(BLK_READ_SG)
+/* Segments are used for DMA in place, so they must be cache aligned */
+static int dwmci_sg_check(struct mmc_data *data, const struct blk_sg *sg,
+			  int nsegs)
 {
-	struct mmc *mmc = mmc_get_mmc_dev(dev);
-#else
-static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
-		struct mmc_data *data)
+	ulong addr, len;
+	int i;
+
+	for (i = 0; i < nsegs; i++) {
+		addr = (ulong)sg[i].buf;
+		len = sg[i].blkcnt * data->blocksize;
+		if (!IS_ALIGNED(addr, ARCH_DMA_MINALIGN) ||
+		    !IS_ALIGNED(len, ARCH_DMA_MINALIGN) ||
+		    upper_32_bits(addr + len - 1))
+			return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void dwmci_sg_cache(struct mmc_data *data, const struct blk_sg *sg,
+			   int nsegs, bool done)
 {
+	ulong addr, len;
+	int i;
+
+	for (i = 0; i < nsegs; i++) {
+		addr = (ulong)sg[i].buf;
+		len = sg[i].blkcnt * data->blocksize;
+		if (!done)
+			flush_dcache_range(addr, addr + len);
+		else if (data->flags == MMC_DATA_READ)
+			invalidate_dcache_range(addr, addr + len);
+	}
+}
 #endif
+
+static int __dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
+			    struct mmc_data *data, const struct blk_sg *sg,
+			    int nsegs)
+{
 	struct dwmci_host *host = mmc->priv;
 	ALLOC_CACHE_ALIGN_BUFFER(struct dwmci_idmac, cur_idmac,
-				 data ? DIV_ROUND_UP(data->blocks, 8) : 0);
+				 data ? DIV_ROUND_UP(data->blocks, 8) + nsegs : 0);
 	int ret = 0, flags = 0;
 	unsigned int timeout = 500;
 	u32 mask, ctrl;
 	ulong start = get_timer(0);
 	struct bounce_buffer bbstate;
+	struct blk_sg seg;
+	u32 done = DWMCI_INTMSK_CDONE;
 
 	while (dwmci_readl(host, DWMCI_STATUS) & DWMCI_BUSY) {
 		if (get_timer(start) > timeout) {
@@ -403,12 +462,29 @@ static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 
 	dwmci_writel(host, DWMCI_RINTSTS, DWMCI_INTMSK_ALL);
 
+#if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT)
+	if (cmd->cmdidx == SD_CMD_SWITCH_UHS18V) {
+		/* The card must see the clock until it answers, no auto stop */
+		dwmci_writel(host, DWMCI_CLKENA, DWMCI_CLKEN_ENABLE);
+		ret = dwmci_update_clock(host, 0);
+		if (ret)
+			return ret;
+		flags |= DWMCI_CMD_VOLT_SWITCH;
+		done |= DWMCI_INTMSK_VOLT_SWITCH;
+	}
+#endif
+
 	if (data) {
 		if (host->fifo_mode) {
 			dwmci_writel(host, DWMCI_BLKSIZ, data->blocksize);
 			dwmci_writel(host, DWMCI_BYTCNT,
 				     data->blocksize * data->blocks);
 			dwmci_wait_reset(host, DWMCI_CTRL_FIFO_RESET);
+#if CONFIG_IS_ENABLED(BLK_READ_SG)
+		} else if (sg) {
+			dwmci_sg_cache(data, sg, nsegs, false);
+			dwmci_prepare_data(host, data, cur_idmac, sg, nsegs);
+#endif
 		} else {
 			if (data->flags == MMC_DATA_READ) {
 				ret = bounce_buffer_start(&bbstate,
@@ -425,15 +501,16 @@ static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 			if (ret)
 				return ret;
 
-			dwmci_prepare_data(host, data, cur_idmac,
-					   bbstate.bounce_buffer);
+			seg.buf = bbstate.bounce_buffer;
+			seg.blkcnt = data->blocks;
+			dwmci_prepare_data(host, data, cur_idmac, &seg, 1);
 		}
 	}
 
 	dwmci_writel(host, DWMCI_CMDARG, cmd->cmdarg);
 
 	if (data)
-		flags = dwmci_set_transfer_mode(host, data);
+		flags |= dwmci_set_transfer_mode(host, data);
 
 	if ((cmd->resp_type & MMC_RSP_136) && (cmd->resp_type & MMC_RSP_BUSY))
 		return -1;
@@ -464,7 +541,7 @@ static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 	start = get_timer(0);
 	do {
 		mask = dwmci_readl(host, DWMCI_RINTSTS);
-		if (mask & DWMCI_INTMSK_CDONE) {
+		if (mask & done) {
 			if (!data)
 				dwmci_writel(host, DWMCI_RINTSTS, mask);
 			break;
@@ -512,14 +589,69 @@ static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 			ctrl = dwmci_readl(host, DWMCI_CTRL);
 			ctrl &= ~(DWMCI_DMA_EN);
 			dwmci_writel(host, DWMCI_CTRL, ctrl);
-			bounce_buffer_stop(&bbstate);
+#if CONFIG_IS_ENABLED(BLK_READ_SG)
+			if (sg)
+				dwmci_sg_cache(data, sg, nsegs, true);
+			else
+#endif
+				bounce_buffer_stop(&bbstate);
 		}
 	}
 
 	return ret;
 }
 
-#ifdef CONFIG_SPL_BLK_READ_PREPARE
+#ifdef CONFIG_DM_MMC
+static int dwmci_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
+		   struct mmc_data *data)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+#else
+static int dwmci_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
+		struct mmc_data *data)
+{
+#endif
+	return __dwmci_send_cmd(mmc, cmd, data, NULL, 0);
+}
+
+#if CONFIG_IS_ENABLED(BLK_READ_SG)
+static int dwmci_send_cmd_sg(struct udevice *dev, struct mmc_cmd *cmd,
+			     struct mmc_data *data, const struct blk_sg *sg,
+			     int nsegs)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct dwmci_host *host = mmc->priv;
+	int ret;
+
+	/* In fifo mode there is no DMA, so nothing to gain over send_cmd */
+	if (host->fifo_mode)
+		return -ENOSYS;
+
+	ret = dwmci_sg_check(data, sg, nsegs);
+	if (ret)
+		return ret;
+
+	return __dwmci_send_cmd(mmc, cmd, data, sg, nsegs);
+}
+#endif
+
+#if defined(CONFIG_SPL_BLK_READ_PREPARE) || CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+static void dwmci_async_release(struct dwmci_host *host)
+{
+	u32 ctrl;
+
+	if (!host->fifo_mode) {
+		ctrl = dwmci_readl(host, DWMCI_CTRL);
+		ctrl &= ~(DWMCI_DMA_EN);
+		dwmci_writel(host, DWMCI_CTRL, ctrl);
+		bounce_buffer_stop(&host->async_bbstate);
+	}
+
+	free(host->async_idmac);
+	host->async_idmac = NULL;
+	host->async_pending = false;
+}
+
 #ifdef CONFIG_DM_MMC
 static int dwmci_send_cmd_prepare(struct udevice *dev, struct mmc_cmd *cmd,
 				  struct mmc_data *data)
@@ -531,18 +663,13 @@ static int dwmci_send_cmd_prepare(struct mmc *mmc, struct mmc_cmd *cmd,
 {
 #endif
 	struct dwmci_host *host = mmc->priv;
-	struct dwmci_idmac *cur_idmac;
+	struct dwmci_idmac *cur_idmac = NULL;
 	int ret = 0, flags = 0;
 	unsigned int timeout = 500;
 	u32 mask;
 	ulong start = get_timer(0);
-	struct bounce_buffer bbstate;
-
-	cur_idmac = malloc(ROUND(DIV_ROUND_UP(data->blocks, 8) *
-			   sizeof(struct dwmci_idmac),
-			   ARCH_DMA_MINALIGN) + ARCH_DMA_MINALIGN - 1);
-	if (!cur_idmac)
-		return -ENODATA;
+	struct bounce_buffer *bbstate = &host->async_bbstate;
+	struct blk_sg seg;
 
 	while (dwmci_readl(host, DWMCI_STATUS) & DWMCI_BUSY) {
 		if (get_timer(start) > timeout) {
@@ -551,6 +678,13 @@ static int dwmci_send_cmd_prepare(struct mmc *mmc, struct mmc_cmd *cmd,
 		}
 	}
 
+	/*
+	 * The card is idle, so a previous prepared transfer that nobody
+	 * waited for is done: drop its descriptors and bounce buffer.
+	 */
+	if (host->async_pending)
+		dwmci_async_release(host);
+
 	dwmci_writel(host, DWMCI_RINTSTS, DWMCI_INTMSK_ALL);
 
 	if (data) {
@@ -560,18 +694,39 @@ static int dwmci_send_cmd_prepare(struct mmc *mmc, struct mmc_cmd *cmd,
 				     data->blocksize * data->blocks);
 			dwmci_wait_reset(host, DWMCI_CTRL_FIFO_RESET);
 		} else {
+			/* Only data commands need descriptors */
+			cur_idmac = malloc(ROUND(DIV_ROUND_UP(data->blocks, 8) *
+					   sizeof(struct dwmci_idmac),
+					   ARCH_DMA_MINALIGN) +
+					   ARCH_DMA_MINALIGN - 1);
+			if (!cur_idmac)
+				return -ENOMEM;
+			host->async_idmac = cur_idmac;
+
 			if (data->flags == MMC_DATA_READ) {
-				bounce_buffer_start(&bbstate, (void *)data->dest,
-						    data->blocksize *
-						    data->blocks, GEN_BB_WRITE);
+				ret = bounce_buffer_start(bbstate,
+						(void *)data->dest,
+						data->blocksize *
+						data->blocks, GEN_BB_WRITE);
 			} else {
-				bounce_buffer_start(&bbstate, (void *)data->src,
-						    data->blocksize *
-						    data->blocks, GEN_BB_READ);
+				ret = bounce_buffer_start(bbstate,
+						(void *)data->src,
+						data->blocksize *
+						data->blocks, GEN_BB_READ);
 			}
-			dwmci_prepare_data(host, data, cur_idmac,
-					   bbstate.bounce_buffer);
+
+			if (ret) {
+				free(cur_idmac);
+				host->async_idmac = NULL;
+				return ret;
+			}
+
+			seg.buf = bbstate->bounce_buffer;
+			seg.blkcnt = data->blocks;
+			dwmci_prepare_data(host, data, cur_idmac, &seg, 1);
 		}
+		host->async_data = *data;
+		host->async_pending = true;
 	}
 
 	dwmci_writel(host, DWMCI_CMDARG, cmd->cmdarg);
@@ -579,8 +734,10 @@ static int dwmci_send_cmd_prepare(struct mmc *mmc, struct mmc_cmd *cmd,
 	if (data)
 		flags = dwmci_set_transfer_mode(host, data);
 
-	if ((cmd->resp_type & MMC_RSP_136) && (cmd->resp_type & MMC_RSP_BUSY))
-		return -1;
+	if ((cmd->resp_type & MMC_RSP_136) && (cmd->resp_type & MMC_RSP_BUSY)) {
+		ret = -1;
+		goto err;
+	}
 
 	if (cmd->cmdidx == MMC_CMD_STOP_TRANSMISSION)
 		flags |= DWMCI_CMD_ABORT_STOP;
@@ -615,7 +772,8 @@ static int dwmci_send_cmd_prepare(struct mmc *mmc, struct mmc_cmd *cmd,
 
 	if (get_timer(start) > timeout) {
 		debug("%s: Timeout.\n", __func__);
-		return -ETIMEDOUT;
+		ret = -ETIMEDOUT;
+		goto err;
 	}
 
 	if (mask & DWMCI_INTMSK_RTO) {
@@ -628,10 +786,12 @@ static int dwmci_send_cmd_prepare(struct mmc *mmc, struct mmc_cmd *cmd,
 		 * CMD8, please keep that in mind.
 		 */
 		debug("%s: Response Timeout.\n", __func__);
-		return -ETIMEDOUT;
+		ret = -ETIMEDOUT;
+		goto err;
 	} else if (mask & DWMCI_INTMSK_RE) {
 		debug("%s: Response Error.\n", __func__);
-		return -EIO;
+		ret = -EIO;
+		goto err;
 	}
 
 	if (cmd->resp_type & MMC_RSP_PRESENT) {
@@ -645,14 +805,42 @@ static int dwmci_send_cmd_prepare(struct mmc *mmc, struct mmc_cmd *cmd,
 		}
 	}
 
+	return 0;
+
+err:
+	if (host->async_pending) {
+		dwmci_async_release(host);
+	} else {
+		free(cur_idmac);
+		host->async_idmac = NULL;
+	}
+
+	return ret;
+}
+#endif
+
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+static int dwmci_wait_data(struct udevice *dev)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct dwmci_host *host = mmc->priv;
+	int ret;
+
+	if (!host->async_pending)
+		return 0;
+
+	/* In fifo mode this is where the data is actually moved */
+	ret = dwmci_data_transfer(host, &host->async_data);
+	dwmci_async_release(host);
+
 	return ret;
 }
 #endif
 
 static int dwmci_setup_bus(struct dwmci_host *host, u32 freq)
 {
-	u32 div, status;
-	int timeout = 10000;
+	u32 div;
+	int ret;
 	unsigned long sclk;
 
 	if (freq == 0)
@@ -683,31 +871,15 @@ static int dwmci_setup_bus(struct dwmci_host *host, u32 freq)
 	dwmci_writel(host, DWMCI_CLKSRC, 0);
 
 	dwmci_writel(host, DWMCI_CLKDIV, div);
-	dwmci_writel(host, DWMCI_CMD, DWMCI_CMD_PRV_DAT_WAIT |
-			DWMCI_CMD_UPD_CLK | DWMCI_CMD_START);
-
-	do {
-		status = dwmci_readl(host, DWMCI_CMD);
-		if (timeout-- < 0) {
-			debug("%s: Timeout!\n", __func__);
-			return -ETIMEDOUT;
-		}
-	} while (status & DWMCI_CMD_START);
+	ret = dwmci_update_clock(host, 0);
+	if (ret)
+		return ret;
 
 	dwmci_writel(host, DWMCI_CLKENA, DWMCI_CLKEN_ENABLE |
 			DWMCI_CLKEN_LOW_PWR);
-
-	dwmci_writel(host, DWMCI_CMD, DWMCI_CMD_PRV_DAT_WAIT |
-			DWMCI_CMD_UPD_CLK | DWMCI_CMD_START);
-
-	timeout = 10000;
-	do {
-		status = dwmci_readl(host, DWMCI_CMD);
-		if (timeout-- < 0) {
-			debug("%s: Timeout!\n", __func__);
-			return -ETIMEDOUT;
-		}
-	} while (status & DWMCI_CMD_START);
+	ret = dwmci_update_clock(host, 0);
+	if (ret)
+		return ret;
 
 	host->clock = freq;
 
@@ -750,6 +922,71 @@ static int dwmci_execute_tuning(struct mmc *mmc, u32 opcode)
 	return host->execute_tuning(host, opcode);
 }
 
+#if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT)
+/* Keep the io domain of the pins safe: never 1.8V mode at a 3.3V supply */
+static int dwmci_set_vqmmc(struct dwmci_host *host, int uV)
+{
+	int ret;
+
+	if (!host->vqmmc)
+		return -ENOSYS;
+
+#ifdef CONFIG_IO_DOMAIN
+	if (uV > regulator_get_value(host->vqmmc)) {
+		ret = io_domain_supply_changed(host->vqmmc, uV);
+		if (ret)
+			return ret;
+	}
+#endif
+	ret = regulator_set_value(host->vqmmc, uV);
+	if (ret)
+		return ret;
+#ifdef CONFIG_IO_DOMAIN
+	ret = io_domain_supply_changed(host->vqmmc, uV);
+#endif
+
+	return ret;
+}
+
+static int dwmci_set_signal_voltage(struct udevice *dev)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct dwmci_host *host = mmc->priv;
+	bool v18 = mmc->signal_voltage == MMC_SIGNAL_VOLTAGE_180;
+	/* The clock updates of the CMD11 switch must say so */
+	u32 flags = v18 ? DWMCI_CMD_VOLT_SWITCH : 0;
+	u32 uhs;
+	int ret;
+
+	dwmci_writel(host, DWMCI_CLKENA, 0);
+	ret = dwmci_update_clock(host, flags);
+	if (ret)
+		return ret;
+
+	ret = dwmci_set_vqmmc(host, v18 ? 1800000 : 3300000);
+	if (ret) {
+		debug("%s: vqmmc: %d\n", __func__, ret);
+		return ret;
+	}
+
+	uhs = dwmci_readl(host, DWMCI_UHS_REG);
+	if (v18)
+		uhs |= DWMCI_UHS_VOLT_18;
+	else
+		uhs &= ~DWMCI_UHS_VOLT_18;
+	dwmci_writel(host, DWMCI_UHS_REG, uhs);
+
+	/* At least 5ms without a clock for the card and the supply to settle */
+	mdelay(10);
+
+	dwmci_writel(host, DWMCI_CLKENA, DWMCI_CLKEN_ENABLE);
+	ret = dwmci_update_clock(host, flags);
+	dwmci_writel(host, DWMCI_RINTSTS, DWMCI_INTMSK_VOLT_SWITCH);
+
+	return ret;
+}
+#endif
+
 #ifdef CONFIG_DM_MMC
 static int dwmci_set_ios(struct udevice *dev)
 {
@@ -906,12 +1143,21 @@ int dwmci_probe(struct udevice *dev)
 const struct dm_mmc_ops dm_dwmci_ops = {
 	.card_busy	= dwmci_card_busy,
 	.send_cmd	= dwmci_send_cmd,
-#ifdef CONFIG_SPL_BLK_READ_PREPARE
+#if defined(CONFIG_SPL_BLK_READ_PREPARE) || CONFIG_IS_ENABLED(BLK_READ_ASYNC)
 	.send_cmd_prepare = dwmci_send_cmd_prepare,
+#endif
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+	.wait_data	= dwmci_wait_data,
+#endif
+#if CONFIG_IS_ENABLED(BLK_READ_SG)
+	.send_cmd_sg	= dwmci_send_cmd_sg,
 #endif
 	.set_ios	= dwmci_set_ios,
 	.get_cd         = dwmci_get_cd,
 	.execute_tuning	= dwmci_execute_tuning,
+#if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT)
+	.set_signal_voltage = dwmci_set_signal_voltage,
+#endif
 };
 
 #else
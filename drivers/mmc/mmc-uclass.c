@@ -21,14 +21,22 @@ int dm_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	struct mmc *mmc = mmc_get_mmc_dev(dev);
 	struct dm_mmc_ops *ops = mmc_get_ops(dev);
 	int ret, retry_time = 3;
+	__maybe_unused u64 start;
 
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+	/* A new command must not be issued while async data is in flight */
+	if (mmc->async_blkcnt)
+		mmc_wait_async(mmc);
+#endif
 retry:
+	start = mmc_stats_start();
 	mmmc_trace_before_send(mmc, cmd);
 	if (ops->send_cmd)
 		ret = ops->send_cmd(dev, cmd, data);
 	else
 		ret = -ENOSYS;
 	mmmc_trace_after_send(mmc, cmd, ret);
+	mmc_stats_cmd(mmc, cmd, start, ret);
 
 	if (ret && cmd->cmdidx != SD_CMD_SEND_IF_COND &&
 	    cmd->cmdidx != MMC_CMD_APP_CMD &&
@@ -52,7 +60,7 @@ retry:
 	return ret;
 }
 
-#ifdef CONFIG_SPL_BLK_READ_PREPARE
+#if defined(CONFIG_SPL_BLK_READ_PREPARE) || CONFIG_IS_ENABLED(BLK_READ_ASYNC)
 int dm_mmc_send_cmd_prepare(struct udevice *dev, struct mmc_cmd *cmd,
 			    struct mmc_data *data)
 {
@@ -79,13 +87,83 @@ int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 	return dm_mmc_send_cmd(mmc->dev, cmd, data);
 }
 
-#ifdef CONFIG_SPL_BLK_READ_PREPARE
+#if CONFIG_IS_ENABLED(BLK_READ_SG)
+int dm_mmc_send_cmd_sg(struct udevice *dev, struct mmc_cmd *cmd,
+		       struct mmc_data *data, const struct blk_sg *sg,
+		       int nsegs)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+	__maybe_unused u64 start;
+	int ret;
+
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+	if (mmc->async_blkcnt)
+		mmc_wait_async(mmc);
+#endif
+	if (!ops->send_cmd_sg)
+		return -ENOSYS;
+
+	start = mmc_stats_start();
+	mmmc_trace_before_send(mmc, cmd);
+	ret = ops->send_cmd_sg(dev, cmd, data, sg, nsegs);
+	mmmc_trace_after_send(mmc, cmd, ret);
+	mmc_stats_cmd(mmc, cmd, start, ret);
+
+	return ret;
+}
+
+int mmc_send_cmd_sg(struct mmc *mmc, struct mmc_cmd *cmd,
+		    struct mmc_data *data, const struct blk_sg *sg, int nsegs)
+{
+	return dm_mmc_send_cmd_sg(mmc->dev, cmd, data, sg, nsegs);
+}
+#endif
+
+#if defined(CONFIG_SPL_BLK_READ_PREPARE) || CONFIG_IS_ENABLED(BLK_READ_ASYNC)
 int mmc_send_cmd_prepare(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 {
 	return dm_mmc_send_cmd_prepare(mmc->dev, cmd, data);
 }
 #endif
 
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+int dm_mmc_wait_data(struct udevice *dev)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+
+	if (!ops->wait_data)
+		return -ENOSYS;
+	return ops->wait_data(dev);
+}
+
+int mmc_wait_async(struct mmc *mmc)
+{
+	struct mmc_cmd cmd;
+	uint blkcnt = mmc->async_blkcnt;
+	int ret;
+
+	if (!blkcnt)
+		return 0;
+
+	/* Clear it first, the stop command below must not wait for itself */
+	mmc->async_blkcnt = 0;
+	ret = dm_mmc_wait_data(mmc->dev);
+	if (ret)
+		printf("MMC error: async read failed, ret is %d\n", ret);
+
+	if (blkcnt > 1) {
+		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
+		cmd.cmdarg = 0;
+		cmd.resp_type = MMC_RSP_R1b;
+		if (mmc_send_cmd(mmc, &cmd, NULL) && !ret)
+			ret = -EIO;
+	}
+
+	return ret;
+}
+#endif
+
 bool mmc_card_busy(struct mmc *mmc)
 {
 	struct dm_mmc_ops *ops = mmc_get_ops(mmc->dev);
@@ -158,6 +236,25 @@ int mmc_set_enhanced_strobe(struct mmc *mmc)
 {
 	return dm_mmc_set_enhanced_strobe(mmc->dev);
 }
+
+#if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT)
+int mmc_set_signal_voltage(struct mmc *mmc, uint signal_voltage)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(mmc->dev);
+	uint old = mmc->signal_voltage;
+	int ret;
+
+	if (!ops->set_signal_voltage)
+		return -ENOSYS;
+
+	mmc->signal_voltage = signal_voltage;
+	ret = ops->set_signal_voltage(mmc->dev);
+	if (ret)
+		mmc->signal_voltage = old;
+
+	return ret;
+}
+#endif
 struct mmc *mmc_get_mmc_dev(struct udevice *dev)
 {
 	struct mmc_uclass_priv *upriv;
@@ -325,12 +422,23 @@ static int mmc_select_hwpart(struct udevice *bdev, int hwpart)
 	struct mmc *mmc = mmc_get_mmc_dev(mmc_dev);
 	struct blk_desc *desc = dev_get_uclass_platdata(bdev);
 
+#if CONFIG_IS_ENABLED(MMC_HWPART_LAZY)
+	if (desc->hwpart == hwpart && mmc->part_access == hwpart)
+		return 0;
+#else
 	if (desc->hwpart == hwpart)
 		return 0;
+#endif
 
 	if (mmc->part_config == MMCPART_NOAVAILABLE)
 		return -EMEDIUMTYPE;
 
+#if CONFIG_IS_ENABLED(MMC_HWPART_LAZY)
+	/* The transfer functions select desc->hwpart again, switching then */
+	if (desc->hwpart != hwpart && hwpart != MMC_PART_RPMB)
+		return mmc_defer_switch_part(mmc, hwpart);
+#endif
+
 	return mmc_switch_part(mmc, hwpart);
 }
 
@@ -357,6 +465,13 @@ static const struct blk_ops mmc_blk_ops = {
 	.erase	= mmc_berase,
 #endif
 	.select_hwpart	= mmc_select_hwpart,
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+	.read_async	= mmc_bread_async,
+	.wait		= mmc_bwait,
+#endif
+#if CONFIG_IS_ENABLED(BLK_READ_SG)
+	.read_sg	= mmc_bread_sg,
+#endif
 };
 
 U_BOOT_DRIVER(mmc_blk) = {
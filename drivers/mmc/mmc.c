@@ -20,6 +20,12 @@
 #include <memalign.h>
 #include <linux/list.h>
 #include <div64.h>
+#ifdef CONFIG_MMC_SPL_HANDOFF
+#include <asm/arch/rk_atags.h>
+#endif
+#if CONFIG_IS_ENABLED(MMC_PARALLEL_INIT)
+#include <asm/arch/smp_work.h>
+#endif
 #include "mmc_private.h"
 
 static const unsigned int sd_au_size[] = {
@@ -154,17 +160,19 @@ void mmc_trace_state(struct mmc *mmc, struct mmc_cmd *cmd)
 #if !CONFIG_IS_ENABLED(DM_MMC)
 int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd, struct mmc_data *data)
 {
+	u64 start = mmc_stats_start();
 	int ret;
 
 	mmmc_trace_before_send(mmc, cmd);
 	ret = mmc->cfg->ops->send_cmd(mmc, cmd, data);
 	mmmc_trace_after_send(mmc, cmd, ret);
+	mmc_stats_cmd(mmc, cmd, start, ret);
 
 	return ret;
 }
 #endif
 
-int mmc_send_status(struct mmc *mmc, int timeout)
+static int __mmc_send_status(struct mmc *mmc, int timeout)
 {
 	struct mmc_cmd cmd;
 	int err, retries = 5;
@@ -208,6 +216,17 @@ int mmc_send_status(struct mmc *mmc, int timeout)
 	return 0;
 }
 
+int mmc_send_status(struct mmc *mmc, int timeout)
+{
+	u64 start = mmc_stats_start();
+	int ret;
+
+	ret = __mmc_send_status(mmc, timeout);
+	mmc_stats_wait(mmc, MMC_STATS_STATUS, start, ret);
+
+	return ret;
+}
+
 int mmc_set_blocklen(struct mmc *mmc, int len)
 {
 	struct mmc_cmd cmd;
@@ -263,7 +282,7 @@ static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
 	return blkcnt;
 }
 
-#ifdef CONFIG_SPL_BLK_READ_PREPARE
+#if defined(CONFIG_SPL_BLK_READ_PREPARE) || CONFIG_IS_ENABLED(BLK_READ_ASYNC)
 static int mmc_read_blocks_prepare(struct mmc *mmc, void *dst, lbaint_t start,
 				   lbaint_t blkcnt)
 {
@@ -365,6 +384,298 @@ re_init_retry:
 }
 #endif
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+/* Below this size the two CMD6 switches cost more than queueing saves */
+#define MMC_CQE_MIN_BLOCKS	2048
+
+bool mmc_cqe_usable(struct mmc *mmc, struct blk_desc *block_dev,
+		    lbaint_t blkcnt, const void *buf)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(mmc->dev);
+
+	return ops->cqe_request && (mmc->cfg->host_caps & MMC_CAP_CQE) &&
+	       mmc->cqe_depth && mmc->high_capacity &&
+	       blkcnt >= MMC_CQE_MIN_BLOCKS &&
+	       block_dev->hwpart != MMC_PART_RPMB &&
+	       IS_ALIGNED((ulong)buf, ARCH_DMA_MINALIGN);
+}
+
+int mmc_cqe_transfer(struct mmc *mmc, void *buf, lbaint_t start,
+		     lbaint_t blkcnt, bool write)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(mmc->dev);
+	struct mmc_data data;
+	int ret, err;
+
+	ret = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_CMDQ_MODE_EN, 1);
+	if (ret)
+		return ret;
+
+	data.dest = buf;
+	data.blocks = blkcnt;
+	data.blocksize = write ? mmc->write_bl_len : mmc->read_bl_len;
+	data.flags = write ? MMC_DATA_WRITE : MMC_DATA_READ;
+	ret = ops->cqe_request(mmc->dev, &data, start);
+
+	err = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_CMDQ_MODE_EN, 0);
+	if (err) {
+		printf("%s: Failed to leave command queue mode\n", __func__);
+		return err;
+	}
+
+	return ret;
+}
+#endif
+
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+ulong mmc_bread_async(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
+		      void *dst)
+{
+	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
+	struct dm_mmc_ops *ops;
+	struct mmc *mmc;
+	int err;
+
+	if (blkcnt == 0)
+		return 0;
+
+	mmc = find_mmc_device(block_dev->devnum);
+	if (!mmc)
+		return 0;
+
+	ops = mmc_get_ops(mmc->dev);
+	if (!ops->send_cmd_prepare || !ops->wait_data)
+		return mmc_bread(dev, start, blkcnt, dst);
+
+	/* Only one transfer can be in flight */
+	if (mmc_wait_async(mmc))
+		return 0;
+
+	if (CONFIG_IS_ENABLED(MMC_TINY))
+		err = mmc_switch_part(mmc, block_dev->hwpart);
+	else
+		err = blk_dselect_hwpart(block_dev, block_dev->hwpart);
+
+	if (err < 0)
+		return 0;
+
+	if ((start + blkcnt) > block_dev->lba) {
+#if !defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBCOMMON_SUPPORT)
+		printf("MMC: block number 0x" LBAF " exceeds max(0x" LBAF ")\n",
+		       start + blkcnt, block_dev->lba);
+#endif
+		return 0;
+	}
+
+	if (mmc_set_blocklen(mmc, mmc->read_bl_len)) {
+		debug("%s: Failed to set blocklen\n", __func__);
+		return 0;
+	}
+
+	if (blkcnt > mmc->cfg->b_max)
+		blkcnt = mmc->cfg->b_max;
+
+	/*
+	 * If the controller can't start the transfer in the background, do
+	 * it synchronously so that the re-init retry of mmc_bread() is kept.
+	 */
+	if (mmc_read_blocks_prepare(mmc, dst, start, blkcnt) != blkcnt)
+		return mmc_bread(dev, start, blkcnt, dst);
+
+	mmc->async_blkcnt = blkcnt;
+
+	return blkcnt;
+}
+
+int mmc_bwait(struct udevice *dev)
+{
+	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
+	struct mmc *mmc = find_mmc_device(block_dev->devnum);
+
+	if (!mmc)
+		return -ENODEV;
+
+	return mmc_wait_async(mmc);
+}
+#endif
+
+#if CONFIG_IS_ENABLED(BLK_READ_SG)
+static lbaint_t mmc_read_blocks_sg(struct mmc *mmc, lbaint_t start,
+				   const struct blk_sg *sg, int nsegs,
+				   lbaint_t blkcnt)
+{
+	struct mmc_cmd cmd;
+	struct mmc_data data;
+
+	if (blkcnt > 1)
+		cmd.cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
+	else
+		cmd.cmdidx = MMC_CMD_READ_SINGLE_BLOCK;
+
+	if (mmc->high_capacity)
+		cmd.cmdarg = start;
+	else
+		cmd.cmdarg = start * mmc->read_bl_len;
+
+	cmd.resp_type = MMC_RSP_R1;
+
+	data.dest = NULL;
+	data.blocks = blkcnt;
+	data.blocksize = mmc->read_bl_len;
+	data.flags = MMC_DATA_READ;
+
+	if (mmc_send_cmd_sg(mmc, &cmd, &data, sg, nsegs))
+		return 0;
+
+	if (blkcnt > 1) {
+		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
+		cmd.cmdarg = 0;
+		cmd.resp_type = MMC_RSP_R1b;
+		if (mmc_send_cmd(mmc, &cmd, NULL)) {
+#if !defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBCOMMON_SUPPORT)
+			printf("mmc fail to send stop cmd\n");
+#endif
+			return 0;
+		}
+	}
+
+	return blkcnt;
+}
+
+ulong mmc_bread_sg(struct udevice *dev, lbaint_t start,
+		   const struct blk_sg *sg, int nsegs)
+{
+	struct blk_desc *block_dev = dev_get_uclass_platdata(dev);
+	struct dm_mmc_ops *ops;
+	lbaint_t cnt, total = 0;
+	struct mmc *mmc;
+	bool sg_ok;
+	int i = 0, n, err;
+
+	mmc = find_mmc_device(block_dev->devnum);
+	if (!mmc)
+		return 0;
+
+	ops = mmc_get_ops(mmc->dev);
+	sg_ok = ops->send_cmd_sg;
+
+	if (sg_ok) {
+		if (CONFIG_IS_ENABLED(MMC_TINY))
+			err = mmc_switch_part(mmc, block_dev->hwpart);
+		else
+			err = blk_dselect_hwpart(block_dev, block_dev->hwpart);
+
+		if (err < 0 || mmc_set_blocklen(mmc, mmc->read_bl_len))
+			sg_ok = false;
+	}
+
+	while (i < nsegs) {
+		/* Gather as many segments as fit in one transfer */
+		cnt = 0;
+		for (n = 0; sg_ok && i + n < nsegs; n++) {
+			if (!sg[i + n].blkcnt ||
+			    cnt + sg[i + n].blkcnt > mmc->cfg->b_max)
+				break;
+			cnt += sg[i + n].blkcnt;
+		}
+
+		if (n > 1 && start + total + cnt <= block_dev->lba &&
+		    mmc_read_blocks_sg(mmc, start + total, &sg[i], n,
+				       cnt) == cnt) {
+			total += cnt;
+			i += n;
+			continue;
+		}
+
+		/* One segment at a time, with the retries of mmc_bread() */
+		if (mmc_bread(dev, start + total, sg[i].blkcnt, sg[i].buf) !=
+		    sg[i].blkcnt)
+			break;
+		total += sg[i].blkcnt;
+		i++;
+	}
+
+	return total;
+}
+#endif
+
+#if CONFIG_IS_ENABLED(MMC_HWPART_LAZY)
+/* Small reads of the boot partitions, which then need no switch to redo */
+#define MMC_BOOT_CACHE_ENTRIES	8
+#define MMC_BOOT_CACHE_BLKS	16
+
+static struct mmc_boot_cache {
+	struct mmc *mmc;	/* NULL if the entry is free */
+	int hwpart;
+	lbaint_t start;
+	lbaint_t blkcnt;
+	void *data;
+} mmc_boot_cache[MMC_BOOT_CACHE_ENTRIES];
+static int mmc_boot_cache_next;
+
+static bool mmc_is_boot_part(int hwpart)
+{
+	return hwpart >= 1 && hwpart <= MMC_NUM_BOOT_PARTITION;
+}
+
+static bool mmc_boot_cache_read(struct mmc *mmc, int hwpart, lbaint_t start,
+				lbaint_t blkcnt, void *dst)
+{
+	struct mmc_boot_cache *c;
+	int i;
+
+	if (!mmc_is_boot_part(hwpart))
+		return false;
+
+	for (i = 0; i < MMC_BOOT_CACHE_ENTRIES; i++) {
+		c = &mmc_boot_cache[i];
+		if (c->mmc != mmc || c->hwpart != hwpart ||
+		    start < c->start || start + blkcnt > c->start + c->blkcnt)
+			continue;
+
+		memcpy(dst, c->data + (start - c->start) * mmc->read_bl_len,
+		       blkcnt * mmc->read_bl_len);
+		return true;
+	}
+
+	return false;
+}
+
+static void mmc_boot_cache_fill(struct mmc *mmc, int hwpart, lbaint_t start,
+				lbaint_t blkcnt, const void *src)
+{
+	struct mmc_boot_cache *c;
+
+	if (!mmc_is_boot_part(hwpart) || blkcnt > MMC_BOOT_CACHE_BLKS ||
+	    mmc->read_bl_len > MMC_MAX_BLOCK_LEN)
+		return;
+
+	c = &mmc_boot_cache[mmc_boot_cache_next++ % MMC_BOOT_CACHE_ENTRIES];
+	if (!c->data) {
+		c->data = malloc(MMC_BOOT_CACHE_BLKS * MMC_MAX_BLOCK_LEN);
+		if (!c->data)
+			return;
+	}
+
+	memcpy(c->data, src, blkcnt * mmc->read_bl_len);
+	c->mmc = mmc;
+	c->hwpart = hwpart;
+	c->start = start;
+	c->blkcnt = blkcnt;
+}
+
+void mmc_boot_cache_invalidate(struct mmc *mmc, int hwpart)
+{
+	int i;
+
+	for (i = 0; i < MMC_BOOT_CACHE_ENTRIES; i++) {
+		if (mmc_boot_cache[i].mmc == mmc &&
+		    (hwpart < 0 || mmc_boot_cache[i].hwpart == hwpart))
+			mmc_boot_cache[i].mmc = NULL;
+	}
+}
+#endif
+
 #if CONFIG_IS_ENABLED(BLK)
 ulong mmc_bread(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *dst)
 #else
@@ -394,6 +705,11 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 	if (!mmc)
 		return 0;
 
+#if CONFIG_IS_ENABLED(MMC_HWPART_LAZY)
+	if (mmc_boot_cache_read(mmc, block_dev->hwpart, start, blkcnt, dst))
+		return blkcnt;
+#endif
+
 	if (CONFIG_IS_ENABLED(MMC_TINY))
 		err = mmc_switch_part(mmc, block_dev->hwpart);
 	else
@@ -415,6 +731,12 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 		return 0;
 	}
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	if (mmc_cqe_usable(mmc, block_dev, blkcnt, dst) &&
+	    !mmc_cqe_transfer(mmc, dst, start, blkcnt, false))
+		return blkcnt;
+#endif
+
 	do {
 		cur = (blocks_todo > mmc->cfg->b_max) ?
 			mmc->cfg->b_max : blocks_todo;
@@ -446,6 +768,11 @@ re_init_retry:
 		dst += cur * mmc->read_bl_len;
 	} while (blocks_todo > 0);
 
+#if CONFIG_IS_ENABLED(MMC_HWPART_LAZY)
+	mmc_boot_cache_fill(mmc, block_dev->hwpart, start - blkcnt, blkcnt,
+			    dst - blkcnt * mmc->read_bl_len);
+#endif
+
 	return blkcnt;
 }
 
@@ -528,6 +855,11 @@ static int sd_send_op_cond(struct mmc *mmc)
 
 		if (mmc->version == SD_VERSION_2)
 			cmd.cmdarg |= OCR_HCS;
+#if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT)
+		if (mmc->version == SD_VERSION_2 &&
+		    (mmc->cfg->host_caps & MMC_MODE_UHS))
+			cmd.cmdarg |= OCR_S18R;
+#endif
 
 		err = mmc_send_cmd(mmc, &cmd, NULL);
 
@@ -754,8 +1086,13 @@ static int __mmc_switch(struct mmc *mmc, u8 set, u8 index, u8 value,
 	do {
 		ret = mmc_send_cmd(mmc, &cmd, NULL);
 
-		if (!ret)
-			return mmc_poll_for_busy(mmc, send_status);
+		if (!ret) {
+			u64 start = mmc_stats_start();
+
+			ret = mmc_poll_for_busy(mmc, send_status);
+			mmc_stats_wait(mmc, MMC_STATS_SWITCH_BUSY, start, ret);
+			return ret;
+		}
 	} while (--retries > 0 && ret);
 
 	return ret;
@@ -943,7 +1280,13 @@ static int mmc_execute_tuning(struct mmc *mmc)
 
 static int mmc_hs200_tuning(struct mmc *mmc)
 {
-	return mmc_execute_tuning(mmc);
+	u64 start = mmc_stats_start();
+	int ret;
+
+	ret = mmc_execute_tuning(mmc);
+	mmc_stats_wait(mmc, MMC_STATS_TUNING, start, ret);
+
+	return ret;
 }
 
 #else
@@ -1276,11 +1619,27 @@ int mmc_switch_part(struct mmc *mmc, unsigned int part_num)
 	if ((ret == 0) || ((ret == -ENODEV) && (part_num == 0))) {
 		ret = mmc_set_capacity(mmc, part_num);
 		mmc_get_blk_desc(mmc)->hwpart = part_num;
+#if CONFIG_IS_ENABLED(MMC_HWPART_LAZY)
+		mmc->part_access = part_num;
+#endif
 	}
 
 	return ret;
 }
 
+#if CONFIG_IS_ENABLED(MMC_HWPART_LAZY)
+int mmc_defer_switch_part(struct mmc *mmc, unsigned int part_num)
+{
+	int ret;
+
+	ret = mmc_set_capacity(mmc, part_num);
+	if (!ret)
+		mmc_get_blk_desc(mmc)->hwpart = part_num;
+
+	return ret;
+}
+#endif
+
 int mmc_hwpart_config(struct mmc *mmc,
 		      const struct mmc_hwpart_conf *conf,
 		      enum mmc_hwpart_conf_mode mode)
@@ -1599,6 +1958,18 @@ retry_scr:
 			break;
 	}
 
+#if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT)
+	/* The UHS-I modes are set by sd_select_uhs() once the bus is 4-bit */
+	if (mmc->signal_voltage == MMC_SIGNAL_VOLTAGE_180) {
+		if (__be32_to_cpu(switch_status[3]) & SD_UHS_SDR104_SUPPORTED)
+			mmc->card_caps |= MMC_MODE_UHS_SDR104;
+		if (__be32_to_cpu(switch_status[3]) & SD_UHS_SDR50_SUPPORTED)
+			mmc->card_caps |= MMC_MODE_UHS_SDR50;
+		if (__be32_to_cpu(switch_status[3]) & SD_UHS_DDR50_SUPPORTED)
+			mmc->card_caps |= MMC_MODE_UHS_DDR50;
+	}
+#endif
+
 	/* If high-speed isn't supported, we return */
 	if (!(__be32_to_cpu(switch_status[3]) & SD_HIGHSPEED_SUPPORTED))
 		return 0;
@@ -1732,43 +2103,421 @@ static bool mmc_can_card_busy(struct mmc *)
 }
 #endif
 
-static int mmc_startup(struct mmc *mmc)
+#if defined(CONFIG_MMC_SPL_HANDOFF) && defined(CONFIG_SPL_BUILD)
+/* The EXT_CSD mmc_startup() read, for the handoff to U-Boot */
+static u8 mmc_handoff_ext_csd[MMC_MAX_BLOCK_LEN];
+#endif
+
+/* Decode mmc->csd, return the transfer speed it gives */
+static uint mmc_decode_csd(struct mmc *mmc)
 {
-	int err, i;
 	uint mult, freq, tran_speed;
-	u64 cmult, csize, capacity;
-	struct mmc_cmd cmd;
-	ALLOC_CACHE_ALIGN_BUFFER(u8, ext_csd, MMC_MAX_BLOCK_LEN);
-	bool has_parts = false;
-	bool part_completed;
-	struct blk_desc *bdesc;
+	u64 cmult, csize;
+	int i;
 
-#ifdef CONFIG_MMC_SPI_CRC_ON
-	if (mmc_host_is_spi(mmc)) { /* enable CRC check for spi */
-		cmd.cmdidx = MMC_CMD_SPI_CRC_ON_OFF;
-		cmd.resp_type = MMC_RSP_R1;
-		cmd.cmdarg = 1;
-		err = mmc_send_cmd(mmc, &cmd, NULL);
+	if (mmc->version == MMC_VERSION_UNKNOWN) {
+		int version = (mmc->csd[0] >> 26) & 0xf;
 
-		if (err)
-			return err;
+		switch (version) {
+		case 0:
+			mmc->version = MMC_VERSION_1_2;
+			break;
+		case 1:
+			mmc->version = MMC_VERSION_1_4;
+			break;
+		case 2:
+			mmc->version = MMC_VERSION_2_2;
+			break;
+		case 3:
+			mmc->version = MMC_VERSION_3;
+			break;
+		case 4:
+			mmc->version = MMC_VERSION_4;
+			break;
+		default:
+			mmc->version = MMC_VERSION_1_2;
+			break;
+		}
 	}
-#endif
-#ifndef CONFIG_MMC_USE_PRE_CONFIG
-	/* Put the Card in Identify Mode */
-	cmd.cmdidx = mmc_host_is_spi(mmc) ? MMC_CMD_SEND_CID :
-		MMC_CMD_ALL_SEND_CID; /* cmd not supported in spi */
-	cmd.resp_type = MMC_RSP_R2;
-	cmd.cmdarg = 0;
 
-	err = mmc_send_cmd(mmc, &cmd, NULL);
+	/* divide frequency by 10, since the mults are 10x bigger */
+	freq = fbase[(mmc->csd[0] & 0x7)];
+	mult = multipliers[((mmc->csd[0] >> 3) & 0xf)];
 
-	if (err)
-		return err;
+	tran_speed = freq * mult;
 
-	memcpy(mmc->cid, cmd.response, 16);
+	mmc->dsr_imp = ((mmc->csd[1] >> 12) & 0x1);
+	mmc->read_bl_len = 1 << ((mmc->csd[1] >> 16) & 0xf);
 
-	/*
+	if (IS_SD(mmc))
+		mmc->write_bl_len = mmc->read_bl_len;
+	else
+		mmc->write_bl_len = 1 << ((mmc->csd[3] >> 22) & 0xf);
+
+	if (mmc->high_capacity) {
+		csize = (mmc->csd[1] & 0x3f) << 16
+			| (mmc->csd[2] & 0xffff0000) >> 16;
+		cmult = 8;
+	} else {
+		csize = (mmc->csd[1] & 0x3ff) << 2
+			| (mmc->csd[2] & 0xc0000000) >> 30;
+		cmult = (mmc->csd[2] & 0x00038000) >> 15;
+	}
+
+	mmc->capacity_user = (csize + 1) << (cmult + 2);
+	mmc->capacity_user *= mmc->read_bl_len;
+	mmc->capacity_boot = 0;
+	mmc->capacity_rpmb = 0;
+	for (i = 0; i < 4; i++)
+		mmc->capacity_gp[i] = 0;
+
+	if (mmc->read_bl_len > MMC_MAX_BLOCK_LEN)
+		mmc->read_bl_len = MMC_MAX_BLOCK_LEN;
+
+	if (mmc->write_bl_len > MMC_MAX_BLOCK_LEN)
+		mmc->write_bl_len = MMC_MAX_BLOCK_LEN;
+
+	return tran_speed;
+}
+
+/* Decode the EXT_CSD of an MMC 4 or later card */
+static int mmc_decode_ext_csd(struct mmc *mmc, u8 *ext_csd)
+{
+	bool has_parts = false;
+	bool part_completed;
+	u64 capacity;
+	int err, i;
+
+	if (ext_csd[EXT_CSD_REV] >= 2) {
+		/*
+		 * According to the JEDEC Standard, the value of
+		 * ext_csd's capacity is valid if the value is more
+		 * than 2GB
+		 */
+		capacity = ext_csd[EXT_CSD_SEC_CNT] << 0
+				| ext_csd[EXT_CSD_SEC_CNT + 1] << 8
+				| ext_csd[EXT_CSD_SEC_CNT + 2] << 16
+				| ext_csd[EXT_CSD_SEC_CNT + 3] << 24;
+		capacity *= MMC_MAX_BLOCK_LEN;
+		if ((capacity >> 20) > 2 * 1024)
+			mmc->capacity_user = capacity;
+	}
+
+	switch (ext_csd[EXT_CSD_REV]) {
+	case 1:
+		mmc->version = MMC_VERSION_4_1;
+		break;
+	case 2:
+		mmc->version = MMC_VERSION_4_2;
+		break;
+	case 3:
+		mmc->version = MMC_VERSION_4_3;
+		break;
+	case 5:
+		mmc->version = MMC_VERSION_4_41;
+		break;
+	case 6:
+		mmc->version = MMC_VERSION_4_5;
+		break;
+	case 7:
+		mmc->version = MMC_VERSION_5_0;
+		break;
+	case 8:
+		mmc->version = MMC_VERSION_5_1;
+		break;
+	}
+
+	/* The partition data may be non-zero but it is only
+	 * effective if PARTITION_SETTING_COMPLETED is set in
+	 * EXT_CSD, so ignore any data if this bit is not set,
+	 * except for enabling the high-capacity group size
+	 * definition (see below). */
+	part_completed = !!(ext_csd[EXT_CSD_PARTITION_SETTING] &
+			    EXT_CSD_PARTITION_SETTING_COMPLETED);
+
+	/* store the partition info of emmc */
+	mmc->part_support = ext_csd[EXT_CSD_PARTITIONING_SUPPORT];
+	if ((ext_csd[EXT_CSD_PARTITIONING_SUPPORT] & PART_SUPPORT) ||
+	    ext_csd[EXT_CSD_BOOT_MULT])
+		mmc->part_config = ext_csd[EXT_CSD_PART_CONF];
+	if (part_completed &&
+	    (ext_csd[EXT_CSD_PARTITIONING_SUPPORT] & ENHNCD_SUPPORT))
+		mmc->part_attr = ext_csd[EXT_CSD_PARTITIONS_ATTRIBUTE];
+	if (ext_csd[EXT_CSD_SEC_FEATURE_SUPPORT] & EXT_CSD_SEC_GB_CL_EN)
+		mmc->esr.mmc_can_trim = 1;
+	mmc->esr.mmc_erase_zero = !ext_csd[EXT_CSD_ERASED_MEM_CONT];
+
+	mmc->capacity_boot = ext_csd[EXT_CSD_BOOT_MULT] << 17;
+
+	mmc->capacity_rpmb = ext_csd[EXT_CSD_RPMB_MULT] << 17;
+
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	if (ext_csd[EXT_CSD_REV] >= 8 &&
+	    (ext_csd[EXT_CSD_CMDQ_SUPPORT] & EXT_CSD_CMDQ_SUPPORTED))
+		mmc->cqe_depth = (ext_csd[EXT_CSD_CMDQ_DEPTH] &
+				  EXT_CSD_CMDQ_DEPTH_MASK) + 1;
+#endif
+
+	for (i = 0; i < 4; i++) {
+		int idx = EXT_CSD_GP_SIZE_MULT + i * 3;
+		uint mult = (ext_csd[idx + 2] << 16) +
+			(ext_csd[idx + 1] << 8) + ext_csd[idx];
+		if (mult)
+			has_parts = true;
+		if (!part_completed)
+			continue;
+		mmc->capacity_gp[i] = mult;
+		mmc->capacity_gp[i] *=
+			ext_csd[EXT_CSD_HC_ERASE_GRP_SIZE];
+		mmc->capacity_gp[i] *= ext_csd[EXT_CSD_HC_WP_GRP_SIZE];
+		mmc->capacity_gp[i] <<= 19;
+	}
+
+	if (part_completed) {
+		mmc->enh_user_size =
+			(ext_csd[EXT_CSD_ENH_SIZE_MULT+2] << 16) +
+			(ext_csd[EXT_CSD_ENH_SIZE_MULT+1] << 8) +
+			ext_csd[EXT_CSD_ENH_SIZE_MULT];
+		mmc->enh_user_size *= ext_csd[EXT_CSD_HC_ERASE_GRP_SIZE];
+		mmc->enh_user_size *= ext_csd[EXT_CSD_HC_WP_GRP_SIZE];
+		mmc->enh_user_size <<= 19;
+		mmc->enh_user_start =
+			(ext_csd[EXT_CSD_ENH_START_ADDR+3] << 24) +
+			(ext_csd[EXT_CSD_ENH_START_ADDR+2] << 16) +
+			(ext_csd[EXT_CSD_ENH_START_ADDR+1] << 8) +
+			ext_csd[EXT_CSD_ENH_START_ADDR];
+		if (mmc->high_capacity)
+			mmc->enh_user_start <<= 9;
+	}
+
+	/*
+	 * Host needs to enable ERASE_GRP_DEF bit if device is
+	 * partitioned. This bit will be lost every time after a reset
+	 * or power off. This will affect erase size.
+	 */
+	if (part_completed)
+		has_parts = true;
+	if ((ext_csd[EXT_CSD_PARTITIONING_SUPPORT] & PART_SUPPORT) &&
+	    (ext_csd[EXT_CSD_PARTITIONS_ATTRIBUTE] & PART_ENH_ATTRIB))
+		has_parts = true;
+	if (has_parts && !(ext_csd[EXT_CSD_ERASE_GROUP_DEF] & 0x01)) {
+		err = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL,
+			EXT_CSD_ERASE_GROUP_DEF, 1);
+
+		if (err)
+			return err;
+		else
+			ext_csd[EXT_CSD_ERASE_GROUP_DEF] = 1;
+	}
+
+	if (ext_csd[EXT_CSD_ERASE_GROUP_DEF] & 0x01) {
+		/* Read out group size from ext_csd */
+		mmc->erase_grp_size =
+			ext_csd[EXT_CSD_HC_ERASE_GRP_SIZE] * 1024;
+		/*
+		 * if high capacity and partition setting completed
+		 * SEC_COUNT is valid even if it is smaller than 2 GiB
+		 * JEDEC Standard JESD84-B45, 6.2.4
+		 */
+		if (mmc->high_capacity && part_completed) {
+			capacity = (ext_csd[EXT_CSD_SEC_CNT]) |
+				(ext_csd[EXT_CSD_SEC_CNT + 1] << 8) |
+				(ext_csd[EXT_CSD_SEC_CNT + 2] << 16) |
+				(ext_csd[EXT_CSD_SEC_CNT + 3] << 24);
+			capacity *= MMC_MAX_BLOCK_LEN;
+			mmc->capacity_user = capacity;
+		}
+	} else {
+		/* Calculate the group size from the csd value. */
+		int erase_gsz, erase_gmul;
+		erase_gsz = (mmc->csd[2] & 0x00007c00) >> 10;
+		erase_gmul = (mmc->csd[2] & 0x000003e0) >> 5;
+		mmc->erase_grp_size = (erase_gsz + 1)
+			* (erase_gmul + 1);
+	}
+
+	mmc->hc_wp_grp_size = 1024
+		* ext_csd[EXT_CSD_HC_ERASE_GRP_SIZE]
+		* ext_csd[EXT_CSD_HC_WP_GRP_SIZE];
+
+	mmc->wr_rel_set = ext_csd[EXT_CSD_WR_REL_SET];
+	mmc->rel_wr_sec_c = ext_csd[EXT_CSD_REL_WR_SEC_C];
+
+	mmc->raw_driver_strength = ext_csd[EXT_CSD_DRIVER_STRENGTH];
+
+	return 0;
+}
+
+static void mmc_setup_blk_desc(struct mmc *mmc)
+{
+	struct blk_desc *bdesc;
+
+	/* fill in device description */
+	bdesc = mmc_get_blk_desc(mmc);
+	bdesc->lun = 0;
+	bdesc->hwpart = 0;
+#if CONFIG_IS_ENABLED(MMC_HWPART_LAZY)
+	mmc->part_access = 0;
+#endif
+	bdesc->type = 0;
+	bdesc->blksz = mmc->read_bl_len;
+	bdesc->log2blksz = LOG2(bdesc->blksz);
+	bdesc->lba = lldiv(mmc->capacity, mmc->read_bl_len);
+#if !defined(CONFIG_SPL_BUILD) || \
+		(defined(CONFIG_SPL_LIBCOMMON_SUPPORT) && \
+		!defined(CONFIG_USE_TINY_PRINTF))
+	sprintf(bdesc->vendor, "Man %06x Snr %04x%04x",
+		mmc->cid[0] >> 24, (mmc->cid[2] & 0xffff),
+		(mmc->cid[3] >> 16) & 0xffff);
+	sprintf(bdesc->product, "%c%c%c%c%c%c", mmc->cid[0] & 0xff,
+		(mmc->cid[1] >> 24), (mmc->cid[1] >> 16) & 0xff,
+		(mmc->cid[1] >> 8) & 0xff, mmc->cid[1] & 0xff,
+		(mmc->cid[2] >> 24) & 0xff);
+	sprintf(bdesc->revision, "%d.%d", (mmc->cid[2] >> 20) & 0xf,
+		(mmc->cid[2] >> 16) & 0xf);
+#else
+	bdesc->vendor[0] = 0;
+	bdesc->product[0] = 0;
+	bdesc->revision[0] = 0;
+#endif
+#if !defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBDISK_SUPPORT)
+	part_init(bdesc);
+#endif
+}
+
+#if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT)
+/*
+ * The card accepted 1.8V signaling in ACMD41. This is done from
+ * mmc_startup() rather than right after ACMD41, as mmc_start_init() may
+ * run on another CPU and the I/O supply may be on a shared bus.
+ */
+static int sd_switch_voltage(struct mmc *mmc)
+{
+	struct mmc_cmd cmd;
+	int err;
+
+	cmd.cmdidx = SD_CMD_SWITCH_UHS18V;
+	cmd.resp_type = MMC_RSP_R1;
+	cmd.cmdarg = 0;
+
+	err = mmc_send_cmd(mmc, &cmd, NULL);
+	if (err)
+		return err;
+
+	/* The card holds DAT[3:0] low until it is clocked at 1.8V ... */
+	if (mmc_can_card_busy(mmc) && !mmc_card_busy(mmc))
+		return -EIO;
+
+	err = mmc_set_signal_voltage(mmc, MMC_SIGNAL_VOLTAGE_180);
+	if (err)
+		return err;
+
+	/* ... and lets them go within 1ms of it */
+	udelay(1000);
+	if (mmc_can_card_busy(mmc) && mmc_card_busy(mmc))
+		return -EIO;
+
+	return 0;
+}
+
+static const struct {
+	uint mode;
+	u8 access_mode;
+	uint timing;
+	uint clock;
+} sd_uhs_modes[] = {
+	{ MMC_MODE_UHS_SDR104, SD_ACCESS_MODE_SDR104, MMC_TIMING_UHS_SDR104,
+	  UHS_SDR104_MAX_DTR },
+	{ MMC_MODE_UHS_SDR50, SD_ACCESS_MODE_SDR50, MMC_TIMING_UHS_SDR50,
+	  UHS_SDR50_MAX_DTR },
+	{ MMC_MODE_UHS_DDR50, SD_ACCESS_MODE_DDR50, MMC_TIMING_UHS_DDR50,
+	  UHS_DDR50_MAX_DTR },
+};
+
+/*
+ * Switch to the fastest UHS-I mode of card_caps which tunes, once the bus
+ * is 4-bit. If none does, the card is put back to SDR25 and -EIO returned.
+ */
+static int sd_select_uhs(struct mmc *mmc)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(uint, switch_status, 16);
+	int i, err;
+
+	for (i = 0; i < ARRAY_SIZE(sd_uhs_modes); i++) {
+		if (!(mmc->card_caps & sd_uhs_modes[i].mode))
+			continue;
+
+		err = sd_switch(mmc, SD_SWITCH_SWITCH, 0,
+				sd_uhs_modes[i].access_mode,
+				(u8 *)switch_status);
+		if (err || ((__be32_to_cpu(switch_status[4]) >> 24) & 0xf) !=
+			   sd_uhs_modes[i].access_mode)
+			continue;
+
+		mmc_set_timing(mmc, sd_uhs_modes[i].timing);
+		mmc_set_clock(mmc, sd_uhs_modes[i].clock);
+		if (sd_uhs_modes[i].timing == MMC_TIMING_UHS_DDR50)
+			return 0;
+
+		err = mmc_hs200_tuning(mmc);
+		if (!err)
+			return 0;
+		printf("SD: tuning at %d Hz failed\n", mmc->clock);
+	}
+
+	mmc_set_timing(mmc, MMC_TIMING_LEGACY);
+	if (mmc->card_caps & MMC_MODE_HS)
+		sd_switch(mmc, SD_SWITCH_SWITCH, 0, SD_ACCESS_MODE_SDR25,
+			  (u8 *)switch_status);
+
+	return -EIO;
+}
+#endif
+
+static int mmc_startup(struct mmc *mmc)
+{
+	int err;
+	uint tran_speed;
+	struct mmc_cmd cmd;
+	ALLOC_CACHE_ALIGN_BUFFER(u8, ext_csd, MMC_MAX_BLOCK_LEN);
+
+#ifdef CONFIG_MMC_SPI_CRC_ON
+	if (mmc_host_is_spi(mmc)) { /* enable CRC check for spi */
+		cmd.cmdidx = MMC_CMD_SPI_CRC_ON_OFF;
+		cmd.resp_type = MMC_RSP_R1;
+		cmd.cmdarg = 1;
+		err = mmc_send_cmd(mmc, &cmd, NULL);
+
+		if (err)
+			return err;
+	}
+#endif
+#ifndef CONFIG_MMC_USE_PRE_CONFIG
+#if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT)
+	/* S18A is only valid for high capacity cards */
+	if (IS_SD(mmc) && !mmc_host_is_spi(mmc) &&
+	    (mmc->ocr & (OCR_HCS | OCR_S18R)) == (OCR_HCS | OCR_S18R)) {
+		err = sd_switch_voltage(mmc);
+		if (err) {
+			printf("SD: 1.8V switch failed, ret=%d\n", err);
+			return err;
+		}
+	}
+#endif
+	/* Put the Card in Identify Mode */
+	cmd.cmdidx = mmc_host_is_spi(mmc) ? MMC_CMD_SEND_CID :
+		MMC_CMD_ALL_SEND_CID; /* cmd not supported in spi */
+	cmd.resp_type = MMC_RSP_R2;
+	cmd.cmdarg = 0;
+
+	err = mmc_send_cmd(mmc, &cmd, NULL);
+
+	if (err)
+		return err;
+
+	memcpy(mmc->cid, cmd.response, 16);
+
+	/*
 	 * For MMC cards, set the Relative Address.
 	 * For SD cards, get the Relatvie Address.
 	 * This also puts the cards into Standby State
@@ -1802,67 +2551,7 @@ static int mmc_startup(struct mmc *mmc)
 	mmc->csd[2] = cmd.response[2];
 	mmc->csd[3] = cmd.response[3];
 
-	if (mmc->version == MMC_VERSION_UNKNOWN) {
-		int version = (cmd.response[0] >> 26) & 0xf;
-
-		switch (version) {
-		case 0:
-			mmc->version = MMC_VERSION_1_2;
-			break;
-		case 1:
-			mmc->version = MMC_VERSION_1_4;
-			break;
-		case 2:
-			mmc->version = MMC_VERSION_2_2;
-			break;
-		case 3:
-			mmc->version = MMC_VERSION_3;
-			break;
-		case 4:
-			mmc->version = MMC_VERSION_4;
-			break;
-		default:
-			mmc->version = MMC_VERSION_1_2;
-			break;
-		}
-	}
-
-	/* divide frequency by 10, since the mults are 10x bigger */
-	freq = fbase[(cmd.response[0] & 0x7)];
-	mult = multipliers[((cmd.response[0] >> 3) & 0xf)];
-
-	tran_speed = freq * mult;
-
-	mmc->dsr_imp = ((cmd.response[1] >> 12) & 0x1);
-	mmc->read_bl_len = 1 << ((cmd.response[1] >> 16) & 0xf);
-
-	if (IS_SD(mmc))
-		mmc->write_bl_len = mmc->read_bl_len;
-	else
-		mmc->write_bl_len = 1 << ((cmd.response[3] >> 22) & 0xf);
-
-	if (mmc->high_capacity) {
-		csize = (mmc->csd[1] & 0x3f) << 16
-			| (mmc->csd[2] & 0xffff0000) >> 16;
-		cmult = 8;
-	} else {
-		csize = (mmc->csd[1] & 0x3ff) << 2
-			| (mmc->csd[2] & 0xc0000000) >> 30;
-		cmult = (mmc->csd[2] & 0x00038000) >> 15;
-	}
-
-	mmc->capacity_user = (csize + 1) << (cmult + 2);
-	mmc->capacity_user *= mmc->read_bl_len;
-	mmc->capacity_boot = 0;
-	mmc->capacity_rpmb = 0;
-	for (i = 0; i < 4; i++)
-		mmc->capacity_gp[i] = 0;
-
-	if (mmc->read_bl_len > MMC_MAX_BLOCK_LEN)
-		mmc->read_bl_len = MMC_MAX_BLOCK_LEN;
-
-	if (mmc->write_bl_len > MMC_MAX_BLOCK_LEN)
-		mmc->write_bl_len = MMC_MAX_BLOCK_LEN;
+	tran_speed = mmc_decode_csd(mmc);
 
 	if ((mmc->dsr_imp) && (0xffffffff != mmc->dsr)) {
 		cmd.cmdidx = MMC_CMD_SET_DSR;
@@ -1897,153 +2586,12 @@ static int mmc_startup(struct mmc *mmc)
 		err = mmc_send_ext_csd(mmc, ext_csd);
 		if (err)
 			return err;
-		if (ext_csd[EXT_CSD_REV] >= 2) {
-			/*
-			 * According to the JEDEC Standard, the value of
-			 * ext_csd's capacity is valid if the value is more
-			 * than 2GB
-			 */
-			capacity = ext_csd[EXT_CSD_SEC_CNT] << 0
-					| ext_csd[EXT_CSD_SEC_CNT + 1] << 8
-					| ext_csd[EXT_CSD_SEC_CNT + 2] << 16
-					| ext_csd[EXT_CSD_SEC_CNT + 3] << 24;
-			capacity *= MMC_MAX_BLOCK_LEN;
-			if ((capacity >> 20) > 2 * 1024)
-				mmc->capacity_user = capacity;
-		}
-
-		switch (ext_csd[EXT_CSD_REV]) {
-		case 1:
-			mmc->version = MMC_VERSION_4_1;
-			break;
-		case 2:
-			mmc->version = MMC_VERSION_4_2;
-			break;
-		case 3:
-			mmc->version = MMC_VERSION_4_3;
-			break;
-		case 5:
-			mmc->version = MMC_VERSION_4_41;
-			break;
-		case 6:
-			mmc->version = MMC_VERSION_4_5;
-			break;
-		case 7:
-			mmc->version = MMC_VERSION_5_0;
-			break;
-		case 8:
-			mmc->version = MMC_VERSION_5_1;
-			break;
-		}
-
-		/* The partition data may be non-zero but it is only
-		 * effective if PARTITION_SETTING_COMPLETED is set in
-		 * EXT_CSD, so ignore any data if this bit is not set,
-		 * except for enabling the high-capacity group size
-		 * definition (see below). */
-		part_completed = !!(ext_csd[EXT_CSD_PARTITION_SETTING] &
-				    EXT_CSD_PARTITION_SETTING_COMPLETED);
-
-		/* store the partition info of emmc */
-		mmc->part_support = ext_csd[EXT_CSD_PARTITIONING_SUPPORT];
-		if ((ext_csd[EXT_CSD_PARTITIONING_SUPPORT] & PART_SUPPORT) ||
-		    ext_csd[EXT_CSD_BOOT_MULT])
-			mmc->part_config = ext_csd[EXT_CSD_PART_CONF];
-		if (part_completed &&
-		    (ext_csd[EXT_CSD_PARTITIONING_SUPPORT] & ENHNCD_SUPPORT))
-			mmc->part_attr = ext_csd[EXT_CSD_PARTITIONS_ATTRIBUTE];
-		if (ext_csd[EXT_CSD_SEC_FEATURE_SUPPORT] & EXT_CSD_SEC_GB_CL_EN)
-			mmc->esr.mmc_can_trim = 1;
-
-		mmc->capacity_boot = ext_csd[EXT_CSD_BOOT_MULT] << 17;
-
-		mmc->capacity_rpmb = ext_csd[EXT_CSD_RPMB_MULT] << 17;
-
-		for (i = 0; i < 4; i++) {
-			int idx = EXT_CSD_GP_SIZE_MULT + i * 3;
-			uint mult = (ext_csd[idx + 2] << 16) +
-				(ext_csd[idx + 1] << 8) + ext_csd[idx];
-			if (mult)
-				has_parts = true;
-			if (!part_completed)
-				continue;
-			mmc->capacity_gp[i] = mult;
-			mmc->capacity_gp[i] *=
-				ext_csd[EXT_CSD_HC_ERASE_GRP_SIZE];
-			mmc->capacity_gp[i] *= ext_csd[EXT_CSD_HC_WP_GRP_SIZE];
-			mmc->capacity_gp[i] <<= 19;
-		}
-
-		if (part_completed) {
-			mmc->enh_user_size =
-				(ext_csd[EXT_CSD_ENH_SIZE_MULT+2] << 16) +
-				(ext_csd[EXT_CSD_ENH_SIZE_MULT+1] << 8) +
-				ext_csd[EXT_CSD_ENH_SIZE_MULT];
-			mmc->enh_user_size *= ext_csd[EXT_CSD_HC_ERASE_GRP_SIZE];
-			mmc->enh_user_size *= ext_csd[EXT_CSD_HC_WP_GRP_SIZE];
-			mmc->enh_user_size <<= 19;
-			mmc->enh_user_start =
-				(ext_csd[EXT_CSD_ENH_START_ADDR+3] << 24) +
-				(ext_csd[EXT_CSD_ENH_START_ADDR+2] << 16) +
-				(ext_csd[EXT_CSD_ENH_START_ADDR+1] << 8) +
-				ext_csd[EXT_CSD_ENH_START_ADDR];
-			if (mmc->high_capacity)
-				mmc->enh_user_start <<= 9;
-		}
-
-		/*
-		 * Host needs to enable ERASE_GRP_DEF bit if device is
-		 * partitioned. This bit will be lost every time after a reset
-		 * or power off. This will affect erase size.
-		 */
-		if (part_completed)
-			has_parts = true;
-		if ((ext_csd[EXT_CSD_PARTITIONING_SUPPORT] & PART_SUPPORT) &&
-		    (ext_csd[EXT_CSD_PARTITIONS_ATTRIBUTE] & PART_ENH_ATTRIB))
-			has_parts = true;
-		if (has_parts) {
-			err = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL,
-				EXT_CSD_ERASE_GROUP_DEF, 1);
-
-			if (err)
-				return err;
-			else
-				ext_csd[EXT_CSD_ERASE_GROUP_DEF] = 1;
-		}
-
-		if (ext_csd[EXT_CSD_ERASE_GROUP_DEF] & 0x01) {
-			/* Read out group size from ext_csd */
-			mmc->erase_grp_size =
-				ext_csd[EXT_CSD_HC_ERASE_GRP_SIZE] * 1024;
-			/*
-			 * if high capacity and partition setting completed
-			 * SEC_COUNT is valid even if it is smaller than 2 GiB
-			 * JEDEC Standard JESD84-B45, 6.2.4
-			 */
-			if (mmc->high_capacity && part_completed) {
-				capacity = (ext_csd[EXT_CSD_SEC_CNT]) |
-					(ext_csd[EXT_CSD_SEC_CNT + 1] << 8) |
-					(ext_csd[EXT_CSD_SEC_CNT + 2] << 16) |
-					(ext_csd[EXT_CSD_SEC_CNT + 3] << 24);
-				capacity *= MMC_MAX_BLOCK_LEN;
-				mmc->capacity_user = capacity;
-			}
-		} else {
-			/* Calculate the group size from the csd value. */
-			int erase_gsz, erase_gmul;
-			erase_gsz = (mmc->csd[2] & 0x00007c00) >> 10;
-			erase_gmul = (mmc->csd[2] & 0x000003e0) >> 5;
-			mmc->erase_grp_size = (erase_gsz + 1)
-				* (erase_gmul + 1);
-		}
-
-		mmc->hc_wp_grp_size = 1024
-			* ext_csd[EXT_CSD_HC_ERASE_GRP_SIZE]
-			* ext_csd[EXT_CSD_HC_WP_GRP_SIZE];
-
-		mmc->wr_rel_set = ext_csd[EXT_CSD_WR_REL_SET];
-
-		mmc->raw_driver_strength = ext_csd[EXT_CSD_DRIVER_STRENGTH];
+		err = mmc_decode_ext_csd(mmc, ext_csd);
+		if (err)
+			return err;
+#if defined(CONFIG_MMC_SPL_HANDOFF) && defined(CONFIG_SPL_BUILD)
+		memcpy(mmc_handoff_ext_csd, ext_csd, MMC_MAX_BLOCK_LEN);
+#endif
 	}
 
 	err = mmc_set_capacity(mmc, mmc_get_blk_desc(mmc)->hwpart);
@@ -2090,7 +2638,11 @@ static int mmc_startup(struct mmc *mmc)
 		else
 			tran_speed = MMC_HIGH_26_MAX_DTR;
 
-		mmc_set_clock(mmc, tran_speed);
+#if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT)
+		if (!(mmc->card_caps & MMC_MODE_UHS) ||
+		    mmc->bus_width != MMC_BUS_WIDTH_4BIT || sd_select_uhs(mmc))
+#endif
+			mmc_set_clock(mmc, tran_speed);
 	}
 
 	/* Fix the block length for DDR mode */
@@ -2099,34 +2651,7 @@ static int mmc_startup(struct mmc *mmc)
 		mmc->write_bl_len = MMC_MAX_BLOCK_LEN;
 	}
 
-	/* fill in device description */
-	bdesc = mmc_get_blk_desc(mmc);
-	bdesc->lun = 0;
-	bdesc->hwpart = 0;
-	bdesc->type = 0;
-	bdesc->blksz = mmc->read_bl_len;
-	bdesc->log2blksz = LOG2(bdesc->blksz);
-	bdesc->lba = lldiv(mmc->capacity, mmc->read_bl_len);
-#if !defined(CONFIG_SPL_BUILD) || \
-		(defined(CONFIG_SPL_LIBCOMMON_SUPPORT) && \
-		!defined(CONFIG_USE_TINY_PRINTF))
-	sprintf(bdesc->vendor, "Man %06x Snr %04x%04x",
-		mmc->cid[0] >> 24, (mmc->cid[2] & 0xffff),
-		(mmc->cid[3] >> 16) & 0xffff);
-	sprintf(bdesc->product, "%c%c%c%c%c%c", mmc->cid[0] & 0xff,
-		(mmc->cid[1] >> 24), (mmc->cid[1] >> 16) & 0xff,
-		(mmc->cid[1] >> 8) & 0xff, mmc->cid[1] & 0xff,
-		(mmc->cid[2] >> 24) & 0xff);
-	sprintf(bdesc->revision, "%d.%d", (mmc->cid[2] >> 20) & 0xf,
-		(mmc->cid[2] >> 16) & 0xf);
-#else
-	bdesc->vendor[0] = 0;
-	bdesc->product[0] = 0;
-	bdesc->revision[0] = 0;
-#endif
-#if !defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBDISK_SUPPORT)
-	part_init(bdesc);
-#endif
+	mmc_setup_blk_desc(mmc);
 
 	return 0;
 }
@@ -2194,6 +2719,131 @@ static int mmc_power_init(struct mmc *mmc)
 	return 0;
 }
 #endif
+#ifdef CONFIG_MMC_SPL_HANDOFF
+/* The host the state is for, 0 if it can't tell */
+static ulong mmc_handoff_reg(struct mmc *mmc)
+{
+#if CONFIG_IS_ENABLED(DM_MMC) && !CONFIG_IS_ENABLED(OF_PLATDATA)
+	fdt_addr_t addr = dev_read_addr(mmc->dev);
+
+	return addr == FDT_ADDR_T_NONE ? 0 : addr;
+#else
+	return 0;
+#endif
+}
+
+#ifdef CONFIG_SPL_BUILD
+static void mmc_handoff_save(struct mmc *mmc)
+{
+	struct tag_mmc t;
+
+	memset(&t, 0, sizeof(t));
+	t.reg = mmc_handoff_reg(mmc);
+	if (!t.reg || IS_SD(mmc) || mmc->version < MMC_VERSION_4)
+		return;
+
+	t.rca = mmc->rca;
+	t.ocr = mmc->ocr;
+	memcpy(t.cid, mmc->cid, sizeof(t.cid));
+	memcpy(t.csd, mmc->csd, sizeof(t.csd));
+	t.high_capacity = mmc->high_capacity;
+	t.timing = mmc->timing;
+	t.bus_width = mmc->bus_width;
+	t.clock = mmc->clock;
+	t.card_caps = mmc->card_caps;
+	memcpy(t.ext_csd, mmc_handoff_ext_csd, sizeof(t.ext_csd));
+	atags_set_tag(ATAG_MMC, &t);
+}
+#else
+/* Whether the card has the size and modes of the one SPL set up */
+static bool mmc_handoff_same_card(const u8 *ext_csd, const u8 *spl)
+{
+	static const u8 fields[] = {
+		EXT_CSD_REV, EXT_CSD_CARD_TYPE, EXT_CSD_BOOT_MULT,
+		EXT_CSD_RPMB_MULT, EXT_CSD_SEC_CNT, EXT_CSD_SEC_CNT + 1,
+		EXT_CSD_SEC_CNT + 2, EXT_CSD_SEC_CNT + 3,
+	};
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(fields); i++) {
+		if (ext_csd[fields[i]] != spl[fields[i]])
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Set the host up as SPL left it and pick the card up in that mode. The
+ * one EXT_CSD read checks the bus works and the card is still SPL's.
+ */
+static int mmc_handoff_resume(struct mmc *mmc)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(u8, ext_csd, MMC_MAX_BLOCK_LEN);
+	static ulong failed;	/* a host the state did not work for */
+	struct tag_mmc *t;
+	struct tag *tag;
+	ulong reg;
+	int err = 0;
+
+	tag = atags_get_tag(ATAG_MMC);
+	if (!tag)
+		return -ENOENT;
+
+	t = &tag->u.mmc;
+	reg = mmc_handoff_reg(mmc);
+	if (!reg || t->reg != reg || reg == failed)
+		return -ENOENT;
+
+	mmc->rca = t->rca;
+	mmc->ocr = t->ocr;
+	memcpy(mmc->cid, t->cid, sizeof(mmc->cid));
+	memcpy(mmc->csd, t->csd, sizeof(mmc->csd));
+	mmc->high_capacity = t->high_capacity;
+	mmc->version = MMC_VERSION_UNKNOWN;
+	mmc_decode_csd(mmc);
+	mmc->erase_grp_size = 1;
+	mmc->part_config = MMCPART_NOAVAILABLE;
+
+	mmc_set_bus_width(mmc, t->bus_width);
+	mmc_set_timing(mmc, t->timing);
+	mmc_set_clock(mmc, t->clock);
+	mmc->card_caps = t->card_caps;
+	if (mmc_card_hs400es(mmc))
+		err = mmc_set_enhanced_strobe(mmc);
+	else if (mmc_card_hs200(mmc))
+		err = mmc_hs200_tuning(mmc);
+
+	if (!err)
+		err = mmc_send_status(mmc, 1);
+	if (!err)
+		err = mmc_send_ext_csd(mmc, ext_csd);
+	if (!err && !mmc_handoff_same_card(ext_csd, t->ext_csd))
+		err = -ENODEV;
+	if (!err)
+		err = mmc_decode_ext_csd(mmc, ext_csd);
+	/* SPL may have left a boot partition selected */
+	if (!err && (ext_csd[EXT_CSD_PART_CONF] & PART_ACCESS_MASK))
+		err = mmc_switch_part(mmc, 0);
+	if (!err)
+		err = mmc_set_capacity(mmc, 0);
+	if (err) {
+		debug("%s: state from SPL failed: %d\n", __func__, err);
+		failed = reg;
+		return err;
+	}
+
+	if (mmc_card_ddr(mmc)) {
+		mmc->read_bl_len = MMC_MAX_BLOCK_LEN;
+		mmc->write_bl_len = MMC_MAX_BLOCK_LEN;
+	}
+	mmc_setup_blk_desc(mmc);
+
+	return 0;
+}
+#endif
+#endif
+
 #ifdef CONFIG_MMC_USE_PRE_CONFIG
 static int mmc_select_card(struct mmc *mmc, int n)
 {
@@ -2237,7 +2887,11 @@ int mmc_start_init(struct mmc *mmc)
 	return 0;
 }
 #else
-int mmc_start_init(struct mmc *mmc)
+/*
+ * With @quiet the host has been powered on already and nothing is printed,
+ * for running on another CPU than the console's.
+ */
+static int __mmc_start_init(struct mmc *mmc, bool quiet)
 {
 	bool no_card;
 	int err;
@@ -2250,7 +2904,8 @@ int mmc_start_init(struct mmc *mmc)
 	if (no_card) {
 		mmc->has_init = 0;
 #if !defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBCOMMON_SUPPORT)
-		printf("MMC: no card present\n");
+		if (!quiet)
+			printf("MMC: no card present\n");
 #endif
 		return -ENOMEDIUM;
 	}
@@ -2261,9 +2916,11 @@ int mmc_start_init(struct mmc *mmc)
 #ifdef CONFIG_FSL_ESDHC_ADAPTER_IDENT
 	mmc_adapter_card_type_ident();
 #endif
-	err = mmc_power_init(mmc);
-	if (err)
-		return err;
+	if (!quiet) {
+		err = mmc_power_init(mmc);
+		if (err)
+			return err;
+	}
 
 #if CONFIG_IS_ENABLED(DM_MMC)
 	/* The device has already been probed ready for use */
@@ -2272,6 +2929,12 @@ int mmc_start_init(struct mmc *mmc)
 	err = mmc->cfg->ops->init(mmc);
 	if (err)
 		return err;
+#endif
+#if defined(CONFIG_MMC_SPL_HANDOFF) && !defined(CONFIG_SPL_BUILD)
+	if (!mmc_handoff_resume(mmc)) {
+		mmc->has_init = 1;
+		return 0;
+	}
 #endif
 	mmc_set_bus_width(mmc, 1);
 	mmc_set_clock(mmc, 1);
@@ -2285,6 +2948,10 @@ int mmc_start_init(struct mmc *mmc)
 
 	/* The internal partition reset to user partition(0) at every CMD0*/
 	mmc_get_blk_desc(mmc)->hwpart = 0;
+#if CONFIG_IS_ENABLED(MMC_HWPART_LAZY)
+	mmc->part_access = 0;
+	mmc_boot_cache_invalidate(mmc, -1);
+#endif
 
 	/* Test for SD version 2 */
 	err = mmc_send_if_cond(mmc);
@@ -2298,7 +2965,8 @@ int mmc_start_init(struct mmc *mmc)
 
 		if (err) {
 #if !defined(CONFIG_SPL_BUILD) || defined(CONFIG_SPL_LIBCOMMON_SUPPORT)
-			printf("Card did not respond to voltage select!\n");
+			if (!quiet)
+				printf("Card did not respond to voltage select!\n");
 #endif
 			return -EOPNOTSUPP;
 		}
@@ -2309,6 +2977,69 @@ int mmc_start_init(struct mmc *mmc)
 
 	return err;
 }
+
+int mmc_start_init(struct mmc *mmc)
+{
+	return __mmc_start_init(mmc, false);
+}
+
+#if CONFIG_IS_ENABLED(MMC_PARALLEL_INIT)
+struct mmc_start_work {
+	struct mmc *mmc;
+	struct mp_task task;
+};
+
+static void mmc_start_init_task(void *arg)
+{
+	struct mmc_start_work *w = arg;
+
+	w->mmc->start_err = __mmc_start_init(w->mmc, true);
+}
+
+void mmc_start_init_all(void)
+{
+	struct mmc_start_work *work;
+	struct udevice *dev;
+	struct uclass *uc;
+	struct mmc *mmc;
+	int i, n = 0;
+
+	if (uclass_get(UCLASS_MMC, &uc))
+		return;
+	uclass_foreach_dev(dev, uc)
+		n++;
+	work = calloc(n, sizeof(*work));
+	if (!work)
+		return;
+
+	/* The supplies may share a bus, so power up from this CPU */
+	n = 0;
+	uclass_foreach_dev(dev, uc) {
+		if (!device_active(dev))
+			continue;
+		mmc = mmc_get_mmc_dev(dev);
+		if (!mmc || mmc->has_init || mmc->init_in_progress)
+			continue;
+		mmc->start_err = mmc_power_init(mmc);
+		if (mmc->start_err)
+			continue;
+		work[n++].mmc = mmc;
+	}
+
+	for (i = 0; i < n; i++)
+		mp_task_submit(&work[i].task, mmc_start_init_task, &work[i]);
+	for (i = 0; i < n; i++) {
+		mp_task_wait(&work[i].task);
+		mmc = work[i].mmc;
+		if (mmc->start_err == -ENOMEDIUM)
+			printf("%s: no card present\n", mmc->dev->name);
+		else if (mmc->start_err)
+			printf("%s: card did not respond to identification: %d\n",
+			       mmc->dev->name, mmc->start_err);
+	}
+	free(work);
+}
+#endif
 #endif
 
 static int mmc_complete_init(struct mmc *mmc)
@@ -2332,6 +3063,7 @@ int mmc_init(struct mmc *mmc)
 {
 	int err = 0;
 	__maybe_unused unsigned start;
+	__maybe_unused u64 stats_start;
 #if CONFIG_IS_ENABLED(DM_MMC)
 	struct mmc_uclass_priv *upriv = dev_get_uclass_priv(mmc->dev);
 
@@ -2341,12 +3073,27 @@ int mmc_init(struct mmc *mmc)
 		return 0;
 
 	start = get_timer(0);
+	stats_start = mmc_stats_start();
 
+#if CONFIG_IS_ENABLED(MMC_PARALLEL_INIT)
+	/* Don't wait for the timeouts of mmc_start_init_all() again */
+	err = mmc->start_err;
+	mmc->start_err = 0;
+	if (!err && !mmc->init_in_progress)
+		err = mmc_start_init(mmc);
+#else
 	if (!mmc->init_in_progress)
 		err = mmc_start_init(mmc);
+#endif
 
-	if (!err)
+	/* Unless it picked up the card as SPL left it */
+	if (!err && !mmc->has_init)
 		err = mmc_complete_init(mmc);
+#if defined(CONFIG_MMC_SPL_HANDOFF) && defined(CONFIG_SPL_BUILD)
+	if (!err)
+		mmc_handoff_save(mmc);
+#endif
+	mmc_stats_wait(mmc, MMC_STATS_INIT, stats_start, err);
 	if (err)
 		printf("%s: %d, time %lu\n", __func__, err, get_timer(start));
 
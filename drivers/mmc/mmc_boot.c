@@ -109,8 +109,12 @@ int mmc_set_part_conf(struct mmc *mmc, u8 ack, u8 part_num, u8 access)
 
 	ret = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_PART_CONF,
 			 part_conf);
-	if (!ret)
+	if (!ret) {
 		mmc->part_config = part_conf;
+#if CONFIG_IS_ENABLED(MMC_HWPART_LAZY)
+		mmc->part_access = access;
+#endif
+	}
 
 	return ret;
 }
@@ -14,12 +14,60 @@
 
 extern int mmc_send_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
 			struct mmc_data *data);
-#ifdef CONFIG_SPL_BLK_READ_PREPARE
+#if defined(CONFIG_SPL_BLK_READ_PREPARE) || CONFIG_IS_ENABLED(BLK_READ_ASYNC)
 int mmc_send_cmd_prepare(struct mmc *mmc, struct mmc_cmd *cmd,
 			 struct mmc_data *data);
 #endif
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+/**
+ * mmc_wait_async() - Finish the read started by mmc_bread_async()
+ *
+ * This waits for the data, then stops a multi-block transfer.
+ *
+ * @mmc:	MMC device
+ * @return 0 if OK (or nothing was outstanding), -ve on error
+ */
+int mmc_wait_async(struct mmc *mmc);
+#endif
+#if CONFIG_IS_ENABLED(BLK_READ_SG)
+/*
+ * Scatter-gather variant of mmc_send_cmd(); fails with -ENOSYS if the
+ * host driver has no send_cmd_sg() operation
+ */
+int mmc_send_cmd_sg(struct mmc *mmc, struct mmc_cmd *cmd,
+		    struct mmc_data *data, const struct blk_sg *sg, int nsegs);
+#endif
 extern int mmc_send_status(struct mmc *mmc, int timeout);
 extern int mmc_set_blocklen(struct mmc *mmc, int len);
+#if CONFIG_IS_ENABLED(MMC_CQE)
+/**
+ * mmc_cqe_usable() - Check if a transfer should use the command queue
+ *
+ * @mmc:	MMC device
+ * @block_dev:	Block device of the current hardware partition
+ * @blkcnt:	Number of blocks to transfer
+ * @buf:	Data buffer
+ * @return true if the transfer can go through mmc_cqe_transfer()
+ */
+bool mmc_cqe_usable(struct mmc *mmc, struct blk_desc *block_dev,
+		    lbaint_t blkcnt, const void *buf);
+
+/**
+ * mmc_cqe_transfer() - Transfer blocks with the command queue engine
+ *
+ * The card is switched to command queue mode for the transfer and back to
+ * legacy mode afterwards, so all other commands keep working as before.
+ *
+ * @mmc:	MMC device
+ * @buf:	Data buffer
+ * @start:	Start block
+ * @blkcnt:	Number of blocks
+ * @write:	true to write, false to read
+ * @return 0 if OK, -ve on error
+ */
+int mmc_cqe_transfer(struct mmc *mmc, void *buf, lbaint_t start,
+		     lbaint_t blkcnt, bool write);
+#endif
 #ifdef CONFIG_FSL_ESDHC_ADAPTER_IDENT
 void mmc_adapter_card_type_ident(void);
 #endif
@@ -31,6 +79,15 @@ ulong mmc_bread(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
 ulong mmc_bread_prepare(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
 			void *dst);
 #endif
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+ulong mmc_bread_async(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
+		      void *dst);
+int mmc_bwait(struct udevice *dev);
+#endif
+#if CONFIG_IS_ENABLED(BLK_READ_SG)
+ulong mmc_bread_sg(struct udevice *dev, lbaint_t start,
+		   const struct blk_sg *sg, int nsegs);
+#endif
 #else
 ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 		void *dst);
@@ -103,6 +160,34 @@ static inline void mmc_trace_state(struct mmc *mmc, struct mmc_cmd *cmd)
 }
 #endif
 
+enum mmc_stats_wait {
+	MMC_STATS_SWITCH_BUSY,	/* card busy after CMD6 */
+	MMC_STATS_STATUS,	/* CMD13 polling for ready for data */
+	MMC_STATS_TUNING,
+	MMC_STATS_INIT,
+
+	MMC_STATS_WAITS,
+};
+
+#if CONFIG_IS_ENABLED(MMC_STATS)
+/* @start is get_ticks() before the command was sent */
+void mmc_stats_cmd(struct mmc *mmc, struct mmc_cmd *cmd, u64 start, int ret);
+void mmc_stats_wait(struct mmc *mmc, enum mmc_stats_wait what, u64 start,
+		    int ret);
+#define mmc_stats_start()	get_ticks()
+#else
+static inline void mmc_stats_cmd(struct mmc *mmc, struct mmc_cmd *cmd,
+				 u64 start, int ret)
+{
+}
+
+static inline void mmc_stats_wait(struct mmc *mmc, enum mmc_stats_wait what,
+				  u64 start, int ret)
+{
+}
+#define mmc_stats_start()	0
+#endif
+
 /**
  * mmc_get_next_devnum() - Get the next available MMC device number
  *
@@ -136,6 +221,32 @@ void mmc_list_add(struct mmc *mmc);
  */
 int mmc_switch_part(struct mmc *mmc, unsigned int part_num);
 
+#if CONFIG_IS_ENABLED(MMC_HWPART_LAZY)
+/**
+ * mmc_defer_switch_part() - Select a hardware partition without a switch
+ *
+ * The block device is set up for the partition, the card is switched over
+ * by the next access through it.
+ *
+ * @mmc:	MMC device
+ * @part_num:	Hardware partition number
+ * @return 0 if OK, -ve on error
+ */
+int mmc_defer_switch_part(struct mmc *mmc, unsigned int part_num);
+
+/**
+ * mmc_boot_cache_invalidate() - Drop the cached reads of a boot partition
+ *
+ * @mmc:	MMC device
+ * @hwpart:	Hardware partition written to, -1 for all of them
+ */
+void mmc_boot_cache_invalidate(struct mmc *mmc, int hwpart);
+#else
+static inline void mmc_boot_cache_invalidate(struct mmc *mmc, int hwpart)
+{
+}
+#endif
+
 /**
  * mmc_switch() - Issue and MMC switch mode command
  *
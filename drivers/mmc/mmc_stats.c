@@ -0,0 +1,160 @@
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ *
+ * Latency of each MMC command and of the waits around them, timed with the
+ * timer counter, for finding out where the time of mmc_init() goes.
+ */
+
+#include <common.h>
+#include <div64.h>
+#include <malloc.h>
+#include <mmc.h>
+#include "mmc_private.h"
+
+/* Latencies up to 16us, 64us, ... 256ms, and longer */
+#define MMC_STATS_BUCKETS	10
+#define MMC_STATS_CMDS		64
+
+struct mmc_lat {
+	uint count;
+	uint errors;
+	u64 total;		/* timer ticks */
+	u64 max;
+	uint hist[MMC_STATS_BUCKETS];
+};
+
+struct mmc_stats {
+	struct mmc_lat cmd[MMC_STATS_CMDS];
+	struct mmc_lat acmd[MMC_STATS_CMDS];	/* after CMD55 */
+	struct mmc_lat wait[MMC_STATS_WAITS];
+	u64 bucket[MMC_STATS_BUCKETS - 1];	/* upper bounds in ticks */
+	bool app_cmd;		/* the last command was CMD55 */
+};
+
+static const char *const mmc_stats_wait_names[MMC_STATS_WAITS] = {
+	[MMC_STATS_SWITCH_BUSY]	= "CMD6 busy",
+	[MMC_STATS_STATUS]	= "CMD13 ready",
+	[MMC_STATS_TUNING]	= "tuning",
+	[MMC_STATS_INIT]	= "init",
+};
+
+static struct mmc_stats *mmc_stats_get(struct mmc *mmc)
+{
+	struct mmc_stats *st = mmc->stats;
+	u64 ticks;
+	int i;
+
+	if (st)
+		return st;
+
+	st = calloc(1, sizeof(*st));
+	if (!st)
+		return NULL;
+	ticks = get_tbclk() / 62500;		/* 16us */
+	for (i = 0; i < MMC_STATS_BUCKETS - 1; i++, ticks *= 4)
+		st->bucket[i] = ticks;
+	mmc->stats = st;
+
+	return st;
+}
+
+static void mmc_lat_add(struct mmc_stats *st, struct mmc_lat *lat, u64 start,
+			int ret)
+{
+	u64 ticks = get_ticks() - start;
+	int i;
+
+	lat->count++;
+	if (ret)
+		lat->errors++;
+	lat->total += ticks;
+	lat->max = max(lat->max, ticks);
+	for (i = 0; i < MMC_STATS_BUCKETS - 1; i++) {
+		if (ticks < st->bucket[i])
+			break;
+	}
+	lat->hist[i]++;
+}
+
+void mmc_stats_cmd(struct mmc *mmc, struct mmc_cmd *cmd, u64 start, int ret)
+{
+	struct mmc_stats *st = mmc_stats_get(mmc);
+	uint idx = cmd->cmdidx % MMC_STATS_CMDS;
+
+	if (!st)
+		return;
+
+	mmc_lat_add(st, st->app_cmd ? &st->acmd[idx] : &st->cmd[idx], start,
+		    ret);
+	st->app_cmd = cmd->cmdidx == MMC_CMD_APP_CMD && !ret;
+}
+
+void mmc_stats_wait(struct mmc *mmc, enum mmc_stats_wait what, u64 start,
+		    int ret)
+{
+	struct mmc_stats *st = mmc_stats_get(mmc);
+
+	if (st)
+		mmc_lat_add(st, &st->wait[what], start, ret);
+}
+
+static ulong mmc_ticks_to_us(u64 ticks)
+{
+	return lldiv(ticks * 1000000, get_tbclk());
+}
+
+static void mmc_lat_show(const char *name, struct mmc_lat *lat)
+{
+	static const char *const bounds[MMC_STATS_BUCKETS] = {
+		"16us", "64us", "256us", "1ms", "4ms", "16ms", "64ms",
+		"256ms", "1s", ">1s",
+	};
+	int i;
+
+	printf("%-12s %7u %6u %10lu %8lu %8lu ", name, lat->count,
+	       lat->errors, mmc_ticks_to_us(lat->total),
+	       mmc_ticks_to_us(lldiv(lat->total, lat->count)),
+	       mmc_ticks_to_us(lat->max));
+	for (i = 0; i < MMC_STATS_BUCKETS; i++) {
+		if (lat->hist[i])
+			printf(" %s:%u", bounds[i], lat->hist[i]);
+	}
+	printf("\n");
+}
+
+void mmc_stats_show(struct mmc *mmc)
+{
+	struct mmc_stats *st = mmc->stats;
+	char name[16];
+	int i;
+
+	if (!st) {
+		printf("No commands counted\n");
+		return;
+	}
+
+	printf("%-12s %7s %6s %10s %8s %8s  %s\n", "Command", "Count",
+	       "Errors", "Total(us)", "Avg(us)", "Max(us)", "Latency");
+	for (i = 0; i < MMC_STATS_CMDS; i++) {
+		if (st->cmd[i].count) {
+			snprintf(name, sizeof(name), "CMD%d", i);
+			mmc_lat_show(name, &st->cmd[i]);
+		}
+		if (st->acmd[i].count) {
+			snprintf(name, sizeof(name), "ACMD%d", i);
+			mmc_lat_show(name, &st->acmd[i]);
+		}
+	}
+	for (i = 0; i < MMC_STATS_WAITS; i++) {
+		if (st->wait[i].count)
+			mmc_lat_show(mmc_stats_wait_names[i], &st->wait[i]);
+	}
+}
+
+void mmc_stats_reset(struct mmc *mmc)
+{
+	free(mmc->stats);
+	mmc->stats = NULL;
+}
@@ -108,6 +108,8 @@ ulong mmc_berase(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt)
 	if (err < 0)
 		return -1;
 
+	mmc_boot_cache_invalidate(mmc, block_dev->hwpart);
+
 	if (!IS_SD(mmc)) {
 		if (mmc->esr.mmc_can_trim)
 			mode = 1;
@@ -240,9 +242,17 @@ ulong mmc_bwrite(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 	if (err < 0)
 		return 0;
 
+	mmc_boot_cache_invalidate(mmc, block_dev->hwpart);
+
 	if (mmc_set_blocklen(mmc, mmc->write_bl_len))
 		return 0;
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	if (mmc_cqe_usable(mmc, block_dev, blkcnt, src) &&
+	    !mmc_cqe_transfer(mmc, (void *)src, start, blkcnt, true))
+		return blkcnt;
+#endif
+
 	do {
 		cur = (blocks_todo > mmc->cfg->b_max) ?
 			mmc->cfg->b_max : blocks_todo;
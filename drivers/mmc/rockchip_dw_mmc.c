@@ -16,6 +16,10 @@
 #include <asm/gpio.h>
 #include <asm/arch/clock.h>
 #include <asm/arch/periph.h>
+#include <power/regulator.h>
+#ifdef CONFIG_MMC_DW_ROCKCHIP_TUNING_CACHE
+#include <asm/arch/vendor.h>
+#endif
 #include <linux/err.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -251,6 +255,114 @@ static int rockchip_mmc_set_phase(struct dwmci_host *host, bool sample, int degr
 	return 0;
 }
 
+static void rockchip_dwmmc_set_sample_phase(struct dwmci_host *host,
+					    int degrees)
+{
+	struct udevice *dev = host->priv;
+	struct rockchip_dwmmc_priv *priv = dev_get_priv(dev);
+
+	if (priv->usrid == USRID_INTER_PHASE)
+		rockchip_mmc_set_phase(host, true, degrees);
+	else
+		clk_set_phase(&priv->sample_clk, degrees);
+}
+
+#if defined(CONFIG_MMC_DW_ROCKCHIP_TUNING_CACHE) && !defined(CONFIG_SPL_BUILD)
+#define TUNING_CACHE_MAGIC	0x4e555444	/* "DTUN" */
+
+/* Vendor storage item MMC_TUNING_ID + slot */
+struct dwmmc_tuning_cache {
+	u32 magic;
+	u32 cid[4];
+	u32 clock;
+	u32 opcode;
+	u32 phase;
+};
+
+/*
+ * The slot of this card, or else the one to cache it in. Only once vendor
+ * storage is loaded: the card being tuned may be the one it is kept on.
+ */
+static int dwmmc_tuning_cache_find(struct mmc *mmc,
+				   struct dwmmc_tuning_cache *cache)
+{
+	int i, ret, slot = -1;
+
+	if (!vendor_storage_ready())
+		return -ENODEV;
+
+	for (i = 0; i < MMC_TUNING_NUM; i++) {
+		ret = vendor_storage_read(MMC_TUNING_ID + i, cache,
+					  sizeof(*cache));
+		if (ret != sizeof(*cache) || cache->magic != TUNING_CACHE_MAGIC) {
+			if (slot < 0)
+				slot = i;
+			continue;
+		}
+		if (!memcmp(cache->cid, mmc->cid, sizeof(cache->cid)))
+			return i;
+	}
+	memset(cache, 0, sizeof(*cache));
+
+	return slot < 0 ? 0 : slot;
+}
+
+/* Set the phase cached for this card and check it with a tuning block */
+static int dwmmc_tuning_cache_load(struct dwmci_host *host, u32 opcode)
+{
+	struct mmc *mmc = host->mmc;
+	struct dwmmc_tuning_cache cache;
+
+	if (dwmmc_tuning_cache_find(mmc, &cache) < 0 ||
+	    cache.magic != TUNING_CACHE_MAGIC || cache.clock != mmc->clock ||
+	    cache.opcode != opcode)
+		return -ENOENT;
+
+	rockchip_dwmmc_set_sample_phase(host, cache.phase);
+	if (mmc_send_tuning(mmc, opcode)) {
+		printf("Cached phase %d failed, tuning again\n", cache.phase);
+		return -EIO;
+	}
+	debug("Using cached phase %d\n", cache.phase);
+
+	return 0;
+}
+
+static void dwmmc_tuning_cache_save(struct dwmci_host *host, u32 opcode,
+				    int phase)
+{
+	struct mmc *mmc = host->mmc;
+	struct dwmmc_tuning_cache cache;
+	int slot;
+
+	slot = dwmmc_tuning_cache_find(mmc, &cache);
+	if (slot < 0)
+		return;
+	if (cache.magic == TUNING_CACHE_MAGIC && cache.clock == mmc->clock &&
+	    cache.opcode == opcode && cache.phase == phase)
+		return;
+
+	cache.magic = TUNING_CACHE_MAGIC;
+	memcpy(cache.cid, mmc->cid, sizeof(cache.cid));
+	cache.clock = mmc->clock;
+	cache.opcode = opcode;
+	cache.phase = phase;
+	if (vendor_storage_write(MMC_TUNING_ID + slot, &cache,
+				 sizeof(cache)) != sizeof(cache))
+		debug("%s: can't cache the phase\n", __func__);
+}
+#else
+static inline int dwmmc_tuning_cache_load(struct dwmci_host *host, u32 opcode)
+{
+	return -ENOENT;
+}
+
+static inline void dwmmc_tuning_cache_save(struct dwmci_host *host,
+					   u32 opcode, int phase)
+{
+}
+#endif
+
 static int rockchip_dwmmc_execute_tuning(struct dwmci_host *host, u32 opcode)
 {
 	struct mmc *mmc = host->mmc;
@@ -272,6 +384,8 @@ static int rockchip_dwmmc_execute_tuning(struct dwmci_host *host, u32 opcode)
 
 	if (!(priv->sample_clk.dev))
 		return -EIO;
+	if (!dwmmc_tuning_cache_load(host, opcode))
+		return 0;
 	ts = get_timer(0);
 
 	/* Try each phase and extract good ranges */
@@ -358,10 +472,8 @@ static int rockchip_dwmmc_execute_tuning(struct dwmci_host *host, u32 opcode)
 
 	printf("Successfully tuned phase to %d, used %ldms\n", real_middle_phase, get_timer(0) - ts);
 
-	if (priv->usrid == USRID_INTER_PHASE)
-		rockchip_mmc_set_phase(host, true, real_middle_phase);
-	else
-		clk_set_phase(&priv->sample_clk, real_middle_phase);
+	rockchip_dwmmc_set_sample_phase(host, real_middle_phase);
+	dwmmc_tuning_cache_save(host, opcode, real_middle_phase);
 
 	return ret;
 }
@@ -440,6 +552,17 @@ internal_phase:
 	dwmci_setup_cfg(&plat->cfg, host, priv->minmax[1], priv->minmax[0]);
 	if (dev_read_bool(dev, "mmc-hs200-1_8v"))
 		plat->cfg.host_caps |= MMC_MODE_HS200;
+#if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT)
+	/* The UHS-I modes need the I/O supply switched to 1.8V */
+	if (!device_get_supply_regulator(dev, "vqmmc-supply", &host->vqmmc)) {
+		if (dev_read_bool(dev, "sd-uhs-sdr104"))
+			plat->cfg.host_caps |= MMC_MODE_UHS_SDR104;
+		if (dev_read_bool(dev, "sd-uhs-sdr50"))
+			plat->cfg.host_caps |= MMC_MODE_UHS_SDR50;
+		if (dev_read_bool(dev, "sd-uhs-ddr50"))
+			plat->cfg.host_caps |= MMC_MODE_UHS_DDR50;
+	}
+#endif
 	plat->mmc.default_phase =
 		dev_read_u32_default(dev, "default-sample-phase", 0);
 
@@ -462,6 +585,35 @@ internal_phase:
 	return dwmci_probe(dev);
 }
 
+#if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT)
+/*
+ * An SD card stays at 1.8V signaling until it is powered off, so power
+ * cycle it for the OS, which starts at 3.3V.
+ */
+static int rockchip_dwmmc_remove(struct udevice *dev)
+{
+	struct rockchip_mmc_plat *plat = dev_get_platdata(dev);
+	struct mmc *mmc = &plat->mmc;
+	struct udevice *vmmc;
+
+	if (mmc->signal_voltage != MMC_SIGNAL_VOLTAGE_180)
+		return 0;
+
+	if (device_get_supply_regulator(dev, "vmmc-supply", &vmmc) ||
+	    regulator_set_enable(vmmc, false)) {
+		printf("%s: can't power off the card at 1.8V\n", dev->name);
+		return 0;
+	}
+
+	mmc_set_signal_voltage(mmc, MMC_SIGNAL_VOLTAGE_330);
+	mdelay(dev_read_u32_default(dev, "power-off-delay-ms", 200));
+	regulator_set_enable(vmmc, true);
+	mmc->has_init = 0;
+
+	return 0;
+}
+#endif
+
 static int rockchip_dwmmc_bind(struct udevice *dev)
 {
 	struct rockchip_mmc_plat *plat = dev_get_platdata(dev);
@@ -483,6 +635,9 @@ U_BOOT_DRIVER(rockchip_dwmmc_drv) = {
 	.ops		= &dm_dwmci_ops,
 	.bind		= rockchip_dwmmc_bind,
 	.probe		= rockchip_dwmmc_probe,
+#if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT)
+	.remove		= rockchip_dwmmc_remove,
+#endif
 	.priv_auto_alloc_size = sizeof(struct rockchip_dwmmc_priv),
 	.platdata_auto_alloc_size = sizeof(struct rockchip_mmc_plat),
 };
@@ -14,6 +14,7 @@
 #include <malloc.h>
 #include <mapmem.h>
 #include <sdhci.h>
+#include <cqhci.h>
 #include <clk.h>
 #include <syscon.h>
 #include <dm/ofnode.h>
@@ -45,6 +46,9 @@ DECLARE_GLOBAL_DATA_PTR;
 /* DWC IP vendor area 1 pointer */
 #define DWCMSHC_P_VENDOR_AREA1		0xe8
 #define DWCMSHC_AREA1_MASK		GENMASK(11, 0)
+/* DWC IP vendor area 2 pointer, locates the CQE registers */
+#define DWCMSHC_P_VENDOR_AREA2		0xea
+#define DWCMSHC_AREA2_MASK		GENMASK(11, 0)
 /* Rockchip specific Registers */
 #define DWCMSHC_CTRL_HS400		0x7
 #define DWCMSHC_CARD_IS_EMMC		BIT(0)
@@ -125,6 +129,7 @@ struct sdhci_data {
 #define RK_DLL_CMD_OUT		BIT(1)
 #define RK_RXCLK_NO_INVERTER	BIT(2)
 #define RK_TAP_VALUE_SEL	BIT(3)
+#define RK_CQE_SUPPORT		BIT(4)
 
 	u8 hs200_tx_tap;
 	u8 hs400_tx_tap;
@@ -508,6 +513,63 @@ static int rockchip_sdhci_set_enhanced_strobe(struct sdhci_host *host)
 	return -ENOTSUPP;
 }
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+static void dwcmshc_cqe_enable(struct cqhci_host *cq_host)
+{
+	struct sdhci_host *host = cq_host->priv;
+
+	/* Drain anything left in the FIFO by the last legacy transfer */
+	while (sdhci_readl(host, SDHCI_PRESENT_STATE) & SDHCI_DATA_AVAILABLE)
+		sdhci_readl(host, SDHCI_BUFFER);
+
+	sdhci_writew(host, SDHCI_TRNS_MULTI | SDHCI_TRNS_BLK_CNT_EN |
+		     SDHCI_TRNS_DMA, SDHCI_TRANSFER_MODE);
+	sdhci_cqe_enable(host);
+}
+
+static void dwcmshc_cqe_disable(struct cqhci_host *cq_host, bool recovery)
+{
+	sdhci_cqe_disable(cq_host->priv, recovery);
+}
+
+static int dwcmshc_cqe_check_error(struct cqhci_host *cq_host)
+{
+	return sdhci_cqe_check_error(cq_host->priv);
+}
+
+static const struct cqhci_host_ops dwcmshc_cqhci_ops = {
+	.enable		= dwcmshc_cqe_enable,
+	.disable	= dwcmshc_cqe_disable,
+	.check_error	= dwcmshc_cqe_check_error,
+};
+
+static int dwcmshc_cqe_init(struct udevice *dev, struct sdhci_host *host)
+{
+	struct cqhci_host *cq_host;
+	u16 area2;
+	int ret;
+
+	cq_host = calloc(1, sizeof(*cq_host));
+	if (!cq_host)
+		return -ENOMEM;
+
+	area2 = sdhci_readw(host, DWCMSHC_P_VENDOR_AREA2) & DWCMSHC_AREA2_MASK;
+	cq_host->mmio = host->ioaddr + area2;
+	cq_host->ops = &dwcmshc_cqhci_ops;
+	cq_host->priv = host;
+
+	ret = cqhci_init(cq_host, host->mmc);
+	if (ret) {
+		free(cq_host);
+		return ret;
+	}
+
+	host->cq_host = cq_host;
+
+	return 0;
+}
+#endif
+
 static struct sdhci_ops rockchip_sdhci_ops = {
 	.set_clock	= rockchip_sdhci_set_clock,
 	.set_ios_post	= rockchip_sdhci_set_ios_post,
@@ -586,6 +648,17 @@ static int rockchip_sdhci_probe(struct udevice *dev)
 	host->mmc->dev = dev;
 	upriv->mmc = host->mmc;
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	/* CQE is optional: fall back to legacy transfers if it fails */
+	if ((data->flags & RK_CQE_SUPPORT) && dev_read_bool(dev, "supports-cqe")) {
+		ret = dwcmshc_cqe_init(dev, host);
+		if (ret)
+			printf("%s: CQE init failed: %d\n", __func__, ret);
+		else
+			plat->cfg.host_caps |= MMC_CAP_CQE;
+	}
+#endif
+
 	return sdhci_probe(dev);
 }
 
@@ -616,7 +689,7 @@ static const struct sdhci_data arasan_data = {
 static const struct sdhci_data rk3568_data = {
 	.emmc_set_clock = dwcmshc_sdhci_emmc_set_clock,
 	.get_phy = dwcmshc_emmc_get_phy,
-	.flags = RK_RXCLK_NO_INVERTER | RK_TAP_VALUE_SEL,
+	.flags = RK_RXCLK_NO_INVERTER | RK_TAP_VALUE_SEL | RK_CQE_SUPPORT,
 	.hs200_tx_tap = 16,
 	.hs400_tx_tap = 8,
 	.hs400_cmd_tap = 8,
@@ -629,7 +702,7 @@ static const struct sdhci_data rk3588_data = {
 	.get_phy = dwcmshc_emmc_get_phy,
 	.set_ios_post = dwcmshc_sdhci_set_ios_post,
 	.set_enhanced_strobe = dwcmshc_sdhci_set_enhanced_strobe,
-	.flags = RK_DLL_CMD_OUT | RK_TAP_VALUE_SEL,
+	.flags = RK_DLL_CMD_OUT | RK_TAP_VALUE_SEL | RK_CQE_SUPPORT,
 	.hs200_tx_tap = 16,
 	.hs400_tx_tap = 9,
 	.hs400_cmd_tap = 8,
@@ -642,7 +715,7 @@ static const struct sdhci_data rk3528_data = {
 	.get_phy = dwcmshc_emmc_get_phy,
 	.set_ios_post = dwcmshc_sdhci_set_ios_post,
 	.set_enhanced_strobe = dwcmshc_sdhci_set_enhanced_strobe,
-	.flags = RK_DLL_CMD_OUT | RK_TAP_VALUE_SEL,
+	.flags = RK_DLL_CMD_OUT | RK_TAP_VALUE_SEL | RK_CQE_SUPPORT,
 	.hs200_tx_tap = 12,
 	.hs400_tx_tap = 6,
 	.hs400_cmd_tap = 6,
@@ -655,7 +728,7 @@ static const struct sdhci_data rk3562_data = {
 	.get_phy = dwcmshc_emmc_get_phy,
 	.set_ios_post = dwcmshc_sdhci_set_ios_post,
 	.set_enhanced_strobe = dwcmshc_sdhci_set_enhanced_strobe,
-	.flags = RK_DLL_CMD_OUT | RK_TAP_VALUE_SEL,
+	.flags = RK_DLL_CMD_OUT | RK_TAP_VALUE_SEL | RK_CQE_SUPPORT,
 	.hs200_tx_tap = 12,
 	.hs400_tx_tap = 6,
 	.hs400_cmd_tap = 6,
@@ -668,7 +741,7 @@ static const struct sdhci_data rk3576_data = {
 	.get_phy = dwcmshc_emmc_get_phy,
 	.set_ios_post = dwcmshc_sdhci_set_ios_post,
 	.set_enhanced_strobe = dwcmshc_sdhci_set_enhanced_strobe,
-	.flags = RK_DLL_CMD_OUT | RK_TAP_VALUE_SEL,
+	.flags = RK_DLL_CMD_OUT | RK_TAP_VALUE_SEL | RK_CQE_SUPPORT,
 	.hs200_tx_tap = 16,
 	.hs400_tx_tap = 7,
 	.hs400_cmd_tap = 7,
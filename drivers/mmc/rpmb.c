@@ -10,6 +10,7 @@
 
 #include <config.h>
 #include <common.h>
+#include <crypto.h>
 #include <memalign.h>
 #include <mmc.h>
 #include <u-boot/sha256.h>
@@ -160,6 +161,38 @@ static int mmc_rpmb_status(struct mmc *mmc, unsigned short expected)
 	/* Read the result */
 	return mmc_rpmb_response(mmc, rpmb_frame, expected, 1);
 }
+#if CONFIG_IS_ENABLED(DM_CRYPTO)
+/* HMAC-SHA256 with the crypto engine, if there is one which has it */
+static int rpmb_hmac_hw(unsigned char *key, unsigned char *buff, int len,
+			unsigned char *output)
+{
+	struct udevice *dev;
+	sha_context ctx;
+	int ret;
+
+	dev = crypto_get_device(CRYPTO_HMAC_SHA256);
+	if (!dev)
+		return -ENODEV;
+
+	ctx.algo = CRYPTO_HMAC_SHA256;
+	ctx.length = len;
+	ret = crypto_hmac_init(dev, &ctx, key, RPMB_SZ_MAC);
+	if (ret)
+		return ret;
+	ret = crypto_hmac_update(dev, (u32 *)buff, len);
+	if (ret)
+		return ret;
+
+	return crypto_hmac_final(dev, &ctx, output);
+}
+#else
+static int rpmb_hmac_hw(unsigned char *key, unsigned char *buff, int len,
+			unsigned char *output)
+{
+	return -ENODEV;
+}
+#endif
+
 static void rpmb_hmac(unsigned char *key, unsigned char *buff, int len,
 		      unsigned char *output)
 {
@@ -168,6 +201,9 @@ static void rpmb_hmac(unsigned char *key, unsigned char *buff, int len,
 	unsigned char k_ipad[SHA256_BLOCK_SIZE];
 	unsigned char k_opad[SHA256_BLOCK_SIZE];
 
+	if (!rpmb_hmac_hw(key, buff, len, output))
+		return;
+
 	sha256_starts(&ctx);
 
 	/* According to RFC 4634, the HMAC transform looks like:
@@ -293,8 +329,16 @@ int mmc_rpmb_read(struct mmc *mmc, void *addr, unsigned short blk,
 
 	return cnt;
 }
-int mmc_rpmb_write(struct mmc *mmc, void *addr, unsigned short blk,
-		  unsigned short cnt, unsigned char *key)
+/* Most frames the card takes in one reliable write */
+static unsigned short mmc_rpmb_max_frames(struct mmc *mmc)
+{
+	return mmc->rel_wr_sec_c ? mmc->rel_wr_sec_c * 2 : 1;
+}
+
+/* Write @cnt frames, at most mmc_rpmb_max_frames(), in one request */
+static int mmc_rpmb_write_frames(struct mmc *mmc, void *addr,
+				 unsigned short blk, unsigned short cnt,
+				 unsigned char *key)
 {
 	struct s_rpmb *rpmb_frame;
 	struct s_rpmb_verify *rpmb_frame_vrify;
@@ -316,7 +360,7 @@ int mmc_rpmb_write(struct mmc *mmc, void *addr, unsigned short blk,
 		if (i == 0) {
 			if (mmc_rpmb_get_counter(mmc, &wcount)) {
 				printf("Cannot read RPMB write counter\n");
-				break;
+				return -1;
 			}
 		}
 
@@ -351,6 +395,23 @@ int mmc_rpmb_write(struct mmc *mmc, void *addr, unsigned short blk,
 	return cnt;
 }
 
+int mmc_rpmb_write(struct mmc *mmc, void *addr, unsigned short blk,
+		  unsigned short cnt, unsigned char *key)
+{
+	unsigned short max = mmc_rpmb_max_frames(mmc);
+	unsigned short done, n;
+
+	/* As many frames per request as the card takes */
+	for (done = 0; done < cnt; done += n) {
+		n = min_t(unsigned short, cnt - done, max);
+		if (mmc_rpmb_write_frames(mmc, addr + done * RPMB_SZ_DATA,
+					  blk + done, n, key) != n)
+			return -1;
+	}
+
+	return cnt;
+}
+
 int read_counter(struct mmc *mmc, struct s_rpmb *requestpackets)
 {
 	if (mmc_rpmb_request(mmc, requestpackets, 1, false))
@@ -390,9 +451,13 @@ int authenticated_read(struct mmc *mmc,
 	return 0;
 }
 
-int authenticated_write(struct mmc *mmc, struct s_rpmb *requestpackets)
+int authenticated_write(struct mmc *mmc, struct s_rpmb *requestpackets,
+			uint16_t block_count)
 {
-	if (mmc_rpmb_request(mmc, requestpackets, 1, true))
+	if (block_count > mmc_rpmb_max_frames(mmc))
+		return -1;
+
+	if (mmc_rpmb_request(mmc, requestpackets, block_count, true))
 		return -1;
 
 	memset(requestpackets, 0, sizeof(struct s_rpmb));
@@ -9,6 +9,7 @@
  */
 
 #include <common.h>
+#include <cqhci.h>
 #include <errno.h>
 #include <malloc.h>
 #include <mmc.h>
@@ -300,6 +301,12 @@ static int sdhci_send_command(struct mmc *mmc, struct mmc_cmd *cmd,
 	stat = sdhci_readl(host, SDHCI_INT_STATUS);
 	sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
 	if (!ret) {
+#ifdef CONFIG_MMC_SDHCI_SDMA
+		/* Drop the lines the CPU fetched while the DMA was running */
+		if (data && data->flags == MMC_DATA_READ)
+			invalidate_dcache_range(start_addr,
+						start_addr + trans_bytes);
+#endif
 		if ((host->quirks & SDHCI_QUIRK_32BIT_DMA_ADDR) &&
 				!is_aligned && (data->flags == MMC_DATA_READ))
 			memcpy(data->dest, aligned_buffer, trans_bytes);
@@ -682,6 +689,67 @@ static int sdhci_execute_tuning(struct mmc *mmc, u32 opcode)
 	return __sdhci_execute_tuning(host, opcode);
 }
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+void sdhci_cqe_enable(struct sdhci_host *host)
+{
+	u8 ctrl;
+
+	ctrl = sdhci_readb(host, SDHCI_HOST_CONTROL);
+	ctrl &= ~SDHCI_CTRL_DMA_MASK;
+	ctrl |= SDHCI_CTRL_ADMA32;
+	sdhci_writeb(host, ctrl, SDHCI_HOST_CONTROL);
+
+	sdhci_writew(host, SDHCI_MAKE_BLKSZ(SDHCI_DEFAULT_BOUNDARY_ARG, 512),
+		     SDHCI_BLOCK_SIZE);
+	sdhci_writeb(host, 0xe, SDHCI_TIMEOUT_CONTROL);
+
+	sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
+	sdhci_writel(host, SDHCI_CQE_INT_MASK, SDHCI_INT_ENABLE);
+}
+
+void sdhci_cqe_disable(struct sdhci_host *host, bool recovery)
+{
+	u8 ctrl;
+
+	ctrl = sdhci_readb(host, SDHCI_HOST_CONTROL);
+	ctrl &= ~SDHCI_CTRL_DMA_MASK;
+	sdhci_writeb(host, ctrl, SDHCI_HOST_CONTROL);
+
+	if (recovery) {
+		sdhci_reset(host, SDHCI_RESET_CMD);
+		sdhci_reset(host, SDHCI_RESET_DATA);
+	}
+
+	sdhci_writel(host, SDHCI_INT_ALL_MASK, SDHCI_INT_STATUS);
+	sdhci_writel(host, SDHCI_INT_DATA_MASK | SDHCI_INT_CMD_MASK,
+		     SDHCI_INT_ENABLE);
+}
+
+int sdhci_cqe_check_error(struct sdhci_host *host)
+{
+	u32 stat = sdhci_readl(host, SDHCI_INT_STATUS);
+
+	if (stat & SDHCI_CQE_INT_ERR_MASK) {
+		debug("%s: int status 0x%x\n", __func__, stat);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static int sdhci_cqe_request(struct udevice *dev, struct mmc_data *data,
+			     lbaint_t start)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct sdhci_host *host = mmc->priv;
+
+	if (!host->cq_host)
+		return -ENOSYS;
+
+	return cqhci_request(host->cq_host, data, start, mmc->cqe_depth);
+}
+#endif
+
 #ifdef CONFIG_DM_MMC
 int sdhci_probe(struct udevice *dev)
 {
@@ -707,6 +775,9 @@ const struct dm_mmc_ops sdhci_ops = {
 	.set_ios	= sdhci_set_ios,
 	.execute_tuning = sdhci_execute_tuning,
 	.set_enhanced_strobe = sdhci_set_enhanced_strobe,
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	.cqe_request	= sdhci_cqe_request,
+#endif
 };
 #else
 static const struct mmc_ops sdhci_ops = {
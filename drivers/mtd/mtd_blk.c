@@ -21,6 +21,9 @@
 #ifdef CONFIG_NAND
 #include <linux/mtd/nand.h>
 #endif
+#ifdef CONFIG_ROCKCHIP_PRELOADER_ATAGS
+#include <asm/arch/rk_atags.h>
+#endif
 
 // #define MTD_BLK_VERBOSE
 
@@ -31,8 +34,24 @@
 #define MTD_BLK_TABLE_BLOCK_UNKNOWN	(-2)
 #define MTD_BLK_TABLE_BLOCK_SHIFT	(-1)
 
+#define MTD_BLK_BBT_MAX			128
+
 static int *mtd_map_blk_table;
 
+/*
+ * Bad blocks of the whole device, found in one pass before the first map
+ * table is built. SPL passes them on in ATAG_MTD_BBT, so U-Boot builds its
+ * map table without checking a single bad block marker.
+ */
+static struct {
+	int devnum;			/* -1 if not scanned */
+	bool valid;			/* false if there were too many */
+	u32 blk_total;
+	u32 erasesize;
+	u32 count;
+	u32 bad[MTD_BLK_BBT_MAX];	/* ascending */
+} mtd_blk_bbt = { .devnum = -1 };
+
 #if CONFIG_IS_ENABLED(SUPPORT_USBPLUG)
 static loff_t usbplug_dummy_partition_write_last_addr;
 static loff_t usbplug_dummy_partition_write_seek;
@@ -40,6 +59,96 @@ static loff_t usbplug_dummy_partition_read_last_addr;
 static loff_t usbplug_dummy_partition_read_seek;
 #endif
 
+#if defined(CONFIG_ROCKCHIP_PRELOADER_ATAGS) && defined(CONFIG_SPL_BUILD)
+static void mtd_blk_bbt_save(void)
+{
+	struct tag_mtd_bbt t = { 0 };
+
+	if (!mtd_blk_bbt.valid || mtd_blk_bbt.count > MTD_BBT_MAX_BAD)
+		return;
+
+	t.devnum = mtd_blk_bbt.devnum;
+	t.blk_total = mtd_blk_bbt.blk_total;
+	t.erasesize = mtd_blk_bbt.erasesize;
+	t.count = mtd_blk_bbt.count;
+	memcpy(t.bad, mtd_blk_bbt.bad, t.count * sizeof(t.bad[0]));
+	atags_set_tag(ATAG_MTD_BBT, &t);
+}
+#elif defined(CONFIG_ROCKCHIP_PRELOADER_ATAGS)
+static bool mtd_blk_bbt_load(void)
+{
+	struct tag_mtd_bbt *t;
+	struct tag *tag;
+
+	tag = atags_get_tag(ATAG_MTD_BBT);
+	if (!tag)
+		return false;
+
+	/* Only if SPL scanned this very device */
+	t = &tag->u.mtd_bbt;
+	if (t->devnum != mtd_blk_bbt.devnum ||
+	    t->blk_total != mtd_blk_bbt.blk_total ||
+	    t->erasesize != mtd_blk_bbt.erasesize ||
+	    t->count > MTD_BLK_BBT_MAX)
+		return false;
+
+	mtd_blk_bbt.count = t->count;
+	memcpy(mtd_blk_bbt.bad, t->bad, t->count * sizeof(t->bad[0]));
+	mtd_blk_bbt.valid = true;
+
+	return true;
+}
+#endif
+
+static void mtd_blk_bbt_init(struct blk_desc *desc, struct mtd_info *mtd,
+			     u32 blk_total)
+{
+	u32 i;
+
+	if (mtd_blk_bbt.devnum == desc->devnum)
+		return;
+
+	mtd_blk_bbt.devnum = desc->devnum;
+	mtd_blk_bbt.blk_total = blk_total;
+	mtd_blk_bbt.erasesize = mtd->erasesize;
+	mtd_blk_bbt.count = 0;
+	mtd_blk_bbt.valid = false;
+
+#if defined(CONFIG_ROCKCHIP_PRELOADER_ATAGS) && !defined(CONFIG_SPL_BUILD)
+	if (mtd_blk_bbt_load())
+		return;
+#endif
+
+	for (i = 0; i < blk_total; i++) {
+		if (!mtd_block_isbad(mtd, (loff_t)i << mtd->erasesize_shift))
+			continue;
+		/* Too many to keep, fall back to checking the markers */
+		if (mtd_blk_bbt.count == MTD_BLK_BBT_MAX)
+			return;
+		mtd_blk_bbt.bad[mtd_blk_bbt.count++] = i;
+	}
+	mtd_blk_bbt.valid = true;
+
+#if defined(CONFIG_ROCKCHIP_PRELOADER_ATAGS) && defined(CONFIG_SPL_BUILD)
+	mtd_blk_bbt_save();
+#endif
+}
+
+static bool mtd_blk_bbt_isbad(struct mtd_info *mtd, u32 blk)
+{
+	u32 i;
+
+	if (!mtd_blk_bbt.valid)
+		return mtd_block_isbad(mtd, (loff_t)blk << mtd->erasesize_shift);
+
+	for (i = 0; i < mtd_blk_bbt.count && mtd_blk_bbt.bad[i] <= blk; i++) {
+		if (mtd_blk_bbt.bad[i] == blk)
+			return true;
+	}
+
+	return false;
+}
+
 int mtd_blk_map_table_init(struct blk_desc *desc,
 			   loff_t offset,
 			   size_t length)
@@ -85,13 +194,15 @@ int mtd_blk_map_table_init(struct blk_desc *desc,
 		if (mtd_map_blk_table[blk_begin] != MTD_BLK_TABLE_BLOCK_UNKNOWN)
 			return 0;
 
+		mtd_blk_bbt_init(desc, mtd, blk_total);
+
 		j = 0;
 		 /* should not across blk_cnt */
 		for (i = 0; i < blk_cnt; i++) {
 			if (j >= blk_cnt)
 				mtd_map_blk_table[blk_begin + i] = MTD_BLK_TABLE_BLOCK_SHIFT;
 			for (; j < blk_cnt; j++) {
-				if (!mtd_block_isbad(mtd, (blk_begin + j) << mtd->erasesize_shift)) {
+				if (!mtd_blk_bbt_isbad(mtd, blk_begin + j)) {
 					mtd_map_blk_table[blk_begin + i] = blk_begin + j;
 					j++;
 					if (j == blk_cnt)
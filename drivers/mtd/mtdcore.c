@@ -1638,6 +1638,107 @@ int mtd_block_markbad(struct mtd_info *mtd, loff_t ofs)
 }
 EXPORT_SYMBOL_GPL(mtd_block_markbad);
 
+#ifdef CONFIG_MTD_ECC_STATS
+/* Stats live on the master device, partitions translate their offsets */
+static struct mtd_info *mtd_ecc_stats_master(struct mtd_info *mtd,
+					     loff_t *ofs)
+{
+	while (mtd->parent) {
+		*ofs += mtd->offset;
+		mtd = mtd->parent;
+	}
+
+	return mtd;
+}
+
+/**
+ * mtd_ecc_stats_record - account one ECC-corrected page read
+ * @mtd: device the page was read from
+ * @ofs: offset of the page in @mtd
+ * @bitflips: bitflips corrected in the worst ECC step, or -EBADMSG
+ *
+ * Called by the NAND drivers for each page read with ECC enabled.
+ */
+void mtd_ecc_stats_record(struct mtd_info *mtd, loff_t ofs, int bitflips)
+{
+	struct mtd_eb_stats *st;
+
+	mtd = mtd_ecc_stats_master(mtd, &ofs);
+	if (ofs < 0 || ofs >= mtd->size || !mtd->erasesize)
+		return;
+
+	if (!mtd->eb_stats) {
+		mtd->eb_stats = calloc(mtd_div_by_eb(mtd->size, mtd),
+				       sizeof(*mtd->eb_stats));
+		if (!mtd->eb_stats)
+			return;
+	}
+
+	st = &mtd->eb_stats[mtd_div_by_eb(ofs, mtd)];
+	st->reads++;
+	if (bitflips < 0) {
+		st->failed++;
+		return;
+	}
+	st->corrected += bitflips;
+	if (bitflips > st->max_bitflips)
+		st->max_bitflips = bitflips;
+}
+EXPORT_SYMBOL_GPL(mtd_ecc_stats_record);
+
+/**
+ * mtd_ecc_stats_get - ECC history of the eraseblock holding @ofs
+ * @mtd: device or partition
+ * @ofs: offset in @mtd
+ *
+ * Return: the block stats, or NULL if nothing was read from @mtd yet.
+ */
+const struct mtd_eb_stats *mtd_ecc_stats_get(struct mtd_info *mtd, loff_t ofs)
+{
+	mtd = mtd_ecc_stats_master(mtd, &ofs);
+	if (!mtd->eb_stats || ofs < 0 || ofs >= mtd->size)
+		return NULL;
+
+	return &mtd->eb_stats[mtd_div_by_eb(ofs, mtd)];
+}
+EXPORT_SYMBOL_GPL(mtd_ecc_stats_get);
+
+void mtd_ecc_stats_reset(struct mtd_info *mtd)
+{
+	loff_t ofs = 0;
+
+	mtd = mtd_ecc_stats_master(mtd, &ofs);
+	if (mtd->eb_stats)
+		memset(mtd->eb_stats, 0, mtd_div_by_eb(mtd->size, mtd) *
+		       sizeof(*mtd->eb_stats));
+}
+EXPORT_SYMBOL_GPL(mtd_ecc_stats_reset);
+
+/**
+ * mtd_block_needs_refresh - should the block holding @ofs be rewritten?
+ * @mtd: device or partition
+ * @ofs: offset in @mtd
+ *
+ * True once a page of the block reached mtd->bitflip_threshold, the same
+ * limit which turns a read into -EUCLEAN, or could not be corrected at all.
+ * Unlike -EUCLEAN it stays set until the stats are reset, so a caller can
+ * move the data whenever it gets round to it.
+ */
+bool mtd_block_needs_refresh(struct mtd_info *mtd, loff_t ofs)
+{
+	const struct mtd_eb_stats *st;
+
+	mtd = mtd_ecc_stats_master(mtd, &ofs);
+	st = mtd_ecc_stats_get(mtd, ofs);
+	if (!st)
+		return false;
+
+	return st->failed || (mtd->bitflip_threshold &&
+			      st->max_bitflips >= mtd->bitflip_threshold);
+}
+EXPORT_SYMBOL_GPL(mtd_block_needs_refresh);
+#endif
+
 #ifndef __UBOOT__
 /*
  * default_mtd_writev - the default writev method
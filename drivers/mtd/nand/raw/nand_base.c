@@ -2383,6 +2383,11 @@ read_retry:
 			}
 
 			max_bitflips = max_t(unsigned int, max_bitflips, ret);
+			if (ops->mode != MTD_OPS_RAW)
+				mtd_ecc_stats_record(mtd,
+					(loff_t)realpage << chip->page_shift,
+					mtd->ecc_stats.failed - ecc_failures ?
+					-EBADMSG : ret);
 
 			/* Transfer not aligned data */
 			if (use_bufpoi) {
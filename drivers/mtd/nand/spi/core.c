@@ -558,6 +558,62 @@ static int spinand_read_page(struct spinand_device *spinand,
 	return spinand_check_ecc_status(spinand, status);
 }
 
+static int spinand_read_cache_seq_op(struct spinand_device *spinand,
+				     bool last)
+{
+	struct spi_mem_op seq_op = SPINAND_PAGE_READ_CACHE_SEQ_OP;
+	struct spi_mem_op end_op = SPINAND_PAGE_READ_CACHE_END_OP;
+
+	return spi_mem_exec_op(spinand->slave, last ? &end_op : &seq_op);
+}
+
+/*
+ * Read a page of a sequential run. With @loaded, the previous 31h is already
+ * loading this page into the data register, otherwise it is loaded by 13h.
+ * With @prefetch, 31h moves it to the cache register and starts loading the
+ * next page of the block while this one is read out; otherwise a pending run
+ * is ended by 3Fh.
+ */
+static int spinand_read_page_seq(struct spinand_device *spinand,
+				 const struct nand_page_io_req *req,
+				 bool ecc_enabled, bool loaded, bool prefetch)
+{
+	u8 status = 0;
+	int ret;
+
+	if (!loaded) {
+		ret = spinand_load_page_op(spinand, req);
+		if (ret)
+			return ret;
+
+		ret = spinand_wait(spinand, &status);
+		if (spinand->id.data[0] == 0x01 && status && !ret)
+			ret = spinand_wait(spinand, &status);
+		if (ret < 0)
+			return ret;
+	}
+
+	if (loaded || prefetch) {
+		ret = spinand_read_cache_seq_op(spinand, !prefetch);
+		if (ret)
+			return ret;
+
+		/* The ECC status now describes the page in the cache */
+		ret = spinand_wait(spinand, &status);
+		if (ret < 0)
+			return ret;
+	}
+
+	ret = spinand_read_from_cache_op(spinand, req);
+	if (ret)
+		return ret;
+
+	if (!ecc_enabled)
+		return 0;
+
+	return spinand_check_ecc_status(spinand, status);
+}
+
 static int spinand_write_page(struct spinand_device *spinand,
 			      const struct nand_page_io_req *req)
 {
@@ -592,11 +648,15 @@ static int spinand_mtd_read(struct mtd_info *mtd, loff_t from,
 	struct nand_io_iter iter;
 	bool enable_ecc = false;
 	bool ecc_failed = false;
+	bool cache_seq, loaded = false, prefetch;
 	int ret = 0;
 
 	if (ops->mode != MTD_OPS_RAW && spinand->eccinfo.ooblayout)
 		enable_ecc = true;
 
+	cache_seq = !spinand->support_cont_read &&
+		    (spinand->flags & SPINAND_HAS_CACHE_SEQ_READ);
+
 #ifndef __UBOOT__
 	mutex_lock(&spinand->lock);
 #endif
@@ -614,10 +674,26 @@ static int spinand_mtd_read(struct mtd_info *mtd, loff_t from,
 			iter.req.datalen = ops->len;
 			iter.req.ooblen = 0;
 		}
-		ret = spinand_read_page(spinand, &iter.req, enable_ecc);
+		if (cache_seq) {
+			/* Prefetch only within the block, bad ones are skipped */
+			prefetch = iter.req.pos.page <
+				   nand->memorg.pages_per_eraseblock - 1 &&
+				   (iter.dataleft > iter.req.datalen ||
+				    iter.oobleft > iter.req.ooblen);
+			ret = spinand_read_page_seq(spinand, &iter.req,
+						    enable_ecc, loaded,
+						    prefetch);
+			loaded = prefetch;
+		} else {
+			ret = spinand_read_page(spinand, &iter.req, enable_ecc);
+		}
 		if (ret < 0 && ret != -EBADMSG)
 			break;
 
+		if (enable_ecc)
+			mtd_ecc_stats_record(mtd, nanddev_pos_to_offs(nand,
+							&iter.req.pos), ret);
+
 		if (ret == -EBADMSG) {
 			ecc_failed = true;
 			mtd->ecc_stats.failed++;
@@ -637,6 +713,12 @@ static int spinand_mtd_read(struct mtd_info *mtd, loff_t from,
 		ops->oobretlen += iter.req.ooblen;
 	}
 
+	/* Leave the cache read mode if the run stopped on an error */
+	if (loaded) {
+		spinand_read_cache_seq_op(spinand, true);
+		spinand_wait(spinand, NULL);
+	}
+
 #ifndef __UBOOT__
 	mutex_unlock(&spinand->lock);
 #endif
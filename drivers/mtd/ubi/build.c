@@ -861,6 +861,15 @@ static int autoresize(struct ubi_device *ubi, int vol_id)
 	return 0;
 }
 
+static void ubi_free_read_ahead(struct ubi_device *ubi)
+{
+	if (ubi->ra) {
+		vfree(ubi->ra->buf);
+		kfree(ubi->ra);
+		ubi->ra = NULL;
+	}
+}
+
 /**
  * ubi_attach_mtd_dev - attach an MTD device.
  * @mtd: MTD device description object
@@ -882,6 +891,9 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
 {
 	struct ubi_device *ubi;
 	int i, err, ref = 0;
+#ifdef __UBOOT__
+	ulong attach_start;
+#endif
 
 	if (max_beb_per1024 < 0 || max_beb_per1024 > MAX_MTD_UBI_BEB_LIMIT)
 		return -EINVAL;
@@ -997,11 +1009,27 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
 	if (!ubi->peb_buf)
 		goto out_free;
 
+	if (CONFIG_MTD_UBI_READ_AHEAD) {
+		ubi->ra = kzalloc(sizeof(*ubi->ra), GFP_KERNEL);
+		if (!ubi->ra)
+			goto out_free;
+		ubi->ra->size = min(ALIGN(CONFIG_MTD_UBI_READ_AHEAD * 1024,
+					  ubi->min_io_size), ubi->peb_size);
+		ubi->ra->pnum = -1;
+		ubi->ra->next_pnum = -1;
+		ubi->ra->buf = vmalloc(ubi->ra->size);
+		if (!ubi->ra->buf)
+			goto out_free;
+	}
+
 #ifdef CONFIG_MTD_UBI_FASTMAP
 	ubi->fm_size = ubi_calc_fm_size(ubi);
 	ubi->fm_buf = vzalloc(ubi->fm_size);
 	if (!ubi->fm_buf)
 		goto out_free;
+#endif
+#ifdef __UBOOT__
+	attach_start = get_timer(0);
 #endif
 	err = ubi_attach(ubi, 0);
 	if (err) {
@@ -1009,6 +1037,11 @@ int ubi_attach_mtd_dev(struct mtd_info *mtd, int ubi_num,
 			mtd->index, err);
 		goto out_free;
 	}
+#ifdef __UBOOT__
+	/* A full scan reads the headers of every PEB, a fastmap a few */
+	ubi_msg(ubi, "attached by %s in %lu ms",
+		ubi->fm ? "fastmap" : "scanning", get_timer(attach_start));
+#endif
 
 	if (ubi->autoresize_vol_id != -1) {
 		err = autoresize(ubi, ubi->autoresize_vol_id);
@@ -1082,6 +1115,7 @@ out_detach:
 out_free:
 	vfree(ubi->peb_buf);
 	vfree(ubi->fm_buf);
+	ubi_free_read_ahead(ubi);
 	if (ref)
 		put_device(&ubi->dev);
 	else
@@ -1161,6 +1195,7 @@ int ubi_detach_mtd_dev(int ubi_num, int anyway)
 	put_mtd_device(ubi->mtd);
 	vfree(ubi->peb_buf);
 	vfree(ubi->fm_buf);
+	ubi_free_read_ahead(ubi);
 	ubi_msg(ubi, "mtd%d is detached", ubi->mtd->index);
 	put_device(&ubi->dev);
 	return 0;
@@ -1386,6 +1421,35 @@ void ubi_exit(void)
 }
 module_exit(ubi_exit);
 
+#if defined(__UBOOT__) && defined(CONFIG_MTD_UBI_FASTMAP)
+/**
+ * ubi_sync_fastmap - write out the fastmaps that are missing or stale.
+ *
+ * U-Boot never detaches the UBI devices before booting the kernel, which is
+ * where Linux writes its fastmap. Write one for the devices that have none,
+ * e.g. with CONFIG_MTD_UBI_FASTMAP_AUTOCONVERT, or that handed out PEBs of
+ * their pools since it was written, so that the next attach is by fastmap
+ * and knows the erase counters.
+ */
+void ubi_sync_fastmap(void)
+{
+	struct ubi_device *ubi;
+	int i, err;
+
+	for (i = 0; i < UBI_MAX_DEVICES; i++) {
+		ubi = ubi_devices[i];
+		if (!ubi || ubi->ro_mode || ubi->fm_disabled)
+			continue;
+		if (ubi->fm && !ubi->fm_pool.used && !ubi->fm_wl_pool.used)
+			continue;
+
+		err = ubi_update_fastmap(ubi);
+		if (err)
+			ubi_err(ubi, "cannot write fastmap, error %d", err);
+	}
+}
+#endif
+
 /**
  * bytes_str_to_int - convert a number of bytes string into an integer.
  * @str: the string to convert
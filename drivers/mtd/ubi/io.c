@@ -94,45 +94,14 @@ static int self_check_vid_hdr(const struct ubi_device *ubi, int pnum,
 static int self_check_write(struct ubi_device *ubi, const void *buf, int pnum,
 			    int offset, int len);
 
-/**
- * ubi_io_read - read data from a physical eraseblock.
- * @ubi: UBI device description object
- * @buf: buffer where to store the read data
- * @pnum: physical eraseblock number to read from
- * @offset: offset within the physical eraseblock from where to read
- * @len: how many bytes to read
- *
- * This function reads data from offset @offset of physical eraseblock @pnum
- * and stores the read data in the @buf buffer. The following return codes are
- * possible:
- *
- * o %0 if all the requested data were successfully read;
- * o %UBI_IO_BITFLIPS if all the requested data were successfully read, but
- *   correctable bit-flips were detected; this is harmless but may indicate
- *   that this eraseblock may become bad soon (but do not have to);
- * o %-EBADMSG if the MTD subsystem reported about data integrity problems, for
- *   example it can be an ECC error in case of NAND; this most probably means
- *   that the data is corrupted;
- * o %-EIO if some I/O error occurred;
- * o other negative error codes in case of other errors.
- */
-int ubi_io_read(const struct ubi_device *ubi, void *buf, int pnum, int offset,
-		int len)
+/* Reads from the flash, see ubi_io_read() */
+static int io_read(const struct ubi_device *ubi, void *buf, int pnum,
+		   int offset, int len)
 {
 	int err, retries = 0;
 	size_t read;
 	loff_t addr;
 
-	dbg_io("read %d bytes from PEB %d:%d", len, pnum, offset);
-
-	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
-	ubi_assert(offset >= 0 && offset + len <= ubi->peb_size);
-	ubi_assert(len > 0);
-
-	err = self_check_not_bad(ubi, pnum);
-	if (err)
-		return err;
-
 	/*
 	 * Deliberately corrupt the buffer to improve robustness. Indeed, if we
 	 * do not do this, the following may happen:
@@ -208,6 +177,98 @@ retry:
 	return err;
 }
 
+/*
+ * UBIFS reads index and data nodes in pieces much smaller than a LEB, each
+ * costing at least one whole NAND page read. Once reads are seen to follow
+ * each other in a PEB, read an aligned window of it in one go and serve the
+ * next reads from there. Returns %-EAGAIN if @buf was not filled.
+ */
+static int read_ahead(const struct ubi_device *ubi, void *buf, int pnum,
+		      int offset, int len)
+{
+	struct ubi_read_ahead *ra = ubi->ra;
+	bool seq = pnum == ra->next_pnum && offset == ra->next;
+	int start, end, err;
+
+	ra->next_pnum = pnum;
+	ra->next = offset + len;
+
+	if (pnum != ra->pnum || offset < ra->offset ||
+	    offset + len > ra->offset + ra->len) {
+		if (!seq || len >= ra->size)
+			return -EAGAIN;
+
+		start = rounddown(offset, ra->size);
+		end = min(start + ra->size, ubi->peb_size);
+		if (offset + len > end)
+			return -EAGAIN;
+
+		ra->pnum = -1;
+		err = io_read(ubi, ra->buf, pnum, start, end - start);
+		if (err && err != UBI_IO_BITFLIPS)
+			return -EAGAIN;
+
+		memcpy(buf, ra->buf + offset - start, len);
+		/* Let the PEB be scrubbed rather than keep serving it */
+		if (err)
+			return err;
+
+		ra->pnum = pnum;
+		ra->offset = start;
+		ra->len = end - start;
+		return 0;
+	}
+
+	memcpy(buf, ra->buf + offset - ra->offset, len);
+	return 0;
+}
+
+/**
+ * ubi_io_read - read data from a physical eraseblock.
+ * @ubi: UBI device description object
+ * @buf: buffer where to store the read data
+ * @pnum: physical eraseblock number to read from
+ * @offset: offset within the physical eraseblock from where to read
+ * @len: how many bytes to read
+ *
+ * This function reads data from offset @offset of physical eraseblock @pnum
+ * and stores the read data in the @buf buffer. The following return codes are
+ * possible:
+ *
+ * o %0 if all the requested data were successfully read;
+ * o %UBI_IO_BITFLIPS if all the requested data were successfully read, but
+ *   correctable bit-flips were detected; this is harmless but may indicate
+ *   that this eraseblock may become bad soon (but do not have to);
+ * o %-EBADMSG if the MTD subsystem reported about data integrity problems, for
+ *   example it can be an ECC error in case of NAND; this most probably means
+ *   that the data is corrupted;
+ * o %-EIO if some I/O error occurred;
+ * o other negative error codes in case of other errors.
+ */
+int ubi_io_read(const struct ubi_device *ubi, void *buf, int pnum, int offset,
+		int len)
+{
+	int err;
+
+	dbg_io("read %d bytes from PEB %d:%d", len, pnum, offset);
+
+	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
+	ubi_assert(offset >= 0 && offset + len <= ubi->peb_size);
+	ubi_assert(len > 0);
+
+	err = self_check_not_bad(ubi, pnum);
+	if (err)
+		return err;
+
+	if (ubi->ra) {
+		err = read_ahead(ubi, buf, pnum, offset, len);
+		if (err != -EAGAIN)
+			return err;
+	}
+
+	return io_read(ubi, buf, pnum, offset, len);
+}
+
 /**
  * ubi_io_write - write data to a physical eraseblock.
  * @ubi: UBI device description object
@@ -248,6 +309,9 @@ int ubi_io_write(struct ubi_device *ubi, const void *buf, int pnum, int offset,
 	if (err)
 		return err;
 
+	if (ubi->ra && ubi->ra->pnum == pnum)
+		ubi->ra->pnum = -1;
+
 	/* The area we are writing to has to contain all 0xFF bytes */
 	err = ubi_self_check_all_ff(ubi, pnum, offset, len);
 	if (err)
@@ -336,6 +400,9 @@ static int do_sync_erase(struct ubi_device *ubi, int pnum)
 		return -EROFS;
 	}
 
+	if (ubi->ra && ubi->ra->pnum == pnum)
+		ubi->ra->pnum = -1;
+
 retry:
 	init_waitqueue_head(&wq);
 	memset(&ei, 0, sizeof(struct erase_info));
@@ -412,6 +412,26 @@ struct ubi_debug_info {
 	struct dentry *dfs_power_cut_max;
 };
 
+/**
+ * struct ubi_read_ahead - read-ahead window of a UBI device.
+ * @size: size of the window
+ * @pnum: PEB held in @buf, or %-1
+ * @offset: offset of @buf in @pnum
+ * @len: number of bytes held in @buf
+ * @next_pnum: PEB of the end of the last read
+ * @next: offset of the end of the last read
+ * @buf: the data
+ */
+struct ubi_read_ahead {
+	int size;
+	int pnum;
+	int offset;
+	int len;
+	int next_pnum;
+	int next;
+	void *buf;
+};
+
 /**
  * struct ubi_device - UBI device description structure
  * @dev: UBI device object to use the the Linux device model
@@ -523,6 +543,7 @@ struct ubi_debug_info {
  *
  * @peb_buf: a buffer of PEB size used for different purposes
  * @buf_mutex: protects @peb_buf
+ * @ra: read-ahead window of small sequential reads, or %NULL
  * @ckvol_mutex: serializes static volume checking when opening
  *
  * @dbg: debugging information for this UBI device
@@ -623,6 +644,7 @@ struct ubi_device {
 	void *peb_buf;
 	struct mutex buf_mutex;
 	struct mutex ckvol_mutex;
+	struct ubi_read_ahead *ra;
 
 	struct ubi_debug_info dbg;
 };
@@ -261,6 +261,24 @@ static int dw_adjust_link(struct dw_eth_dev *priv, struct eth_mac_regs *mac_p,
 	return 0;
 }
 
+static void dw_update_stats(struct dw_eth_dev *priv)
+{
+	u32 missed = readl(&priv->dma_regs_p->missedframes);
+
+	/* The overflow bits mean the counter saturated, keep it saturated */
+	if (missed & MISSED_NODESC_OVF)
+		priv->rx_missed = U32_MAX;
+	else if (priv->rx_missed != U32_MAX)
+		priv->rx_missed += (missed & MISSED_NODESC_MSK) >>
+				   MISSED_NODESC_SHFT;
+
+	if (missed & MISSED_FIFO_OVF)
+		priv->rx_overruns = U32_MAX;
+	else if (priv->rx_overruns != U32_MAX)
+		priv->rx_overruns += (missed & MISSED_FIFO_MSK) >>
+				     MISSED_FIFO_SHFT;
+}
+
 static void _dw_eth_halt(struct dw_eth_dev *priv)
 {
 	struct eth_mac_regs *mac_p = priv->mac_regs_p;
@@ -269,6 +287,11 @@ static void _dw_eth_halt(struct dw_eth_dev *priv)
 	writel(readl(&mac_p->conf) & ~(RXENABLE | TXENABLE), &mac_p->conf);
 	writel(readl(&dma_p->opmode) & ~(RXSTART | TXSTART), &dma_p->opmode);
 
+	dw_update_stats(priv);
+	if (priv->rx_missed || priv->rx_overruns || priv->rx_errors)
+		printf("eth: rx %u missed, %u overruns, %u errors\n",
+		       priv->rx_missed, priv->rx_overruns, priv->rx_errors);
+
 	phy_shutdown(priv->phydev);
 }
 
@@ -277,6 +300,7 @@ int designware_eth_init(struct dw_eth_dev *priv, u8 *enetaddr)
 	struct eth_mac_regs *mac_p = priv->mac_regs_p;
 	struct eth_dma_regs *dma_p = priv->dma_regs_p;
 	unsigned int start;
+	u32 features;
 	int ret;
 
 	writel(readl(&dma_p->busmode) | DMAMAC_SRST, &dma_p->busmode);
@@ -297,9 +321,26 @@ int designware_eth_init(struct dw_eth_dev *priv, u8 *enetaddr)
 	 */
 	_dw_write_hwaddr(priv, enetaddr);
 
+	/* The reset cleared the missed frame counter as well */
+	priv->rx_errors = 0;
+	priv->rx_missed = 0;
+	priv->rx_overruns = 0;
+
 	rx_descs_init(priv);
 	tx_descs_init(priv);
 
+	/*
+	 * Let the checksum offload engine do the IP and UDP/TCP sums. The
+	 * alternate descriptors report the RX result in the extended status
+	 * word, which this driver does not set up.
+	 */
+	features = readl(&dma_p->hwfeature);
+	priv->tx_coe = !!(features & HWFEAT_TXCOESEL);
+	priv->rx_coe = !IS_ENABLED(CONFIG_DW_ALTDESCRIPTOR) &&
+		       (features & HWFEAT_RXTYP2COE);
+	if (priv->rx_coe)
+		writel(readl(&mac_p->conf) | CHECKSUMOFFLOAD, &mac_p->conf);
+
 	writel(FIXEDBURST | PRIORXTX_41 | DMA_PBL, &dma_p->busmode);
 
 #ifndef CONFIG_DW_MAC_FORCE_THRESHOLD_MODE
@@ -378,6 +419,9 @@ static int _dw_eth_send(struct dw_eth_dev *priv, void *packet, int length)
 	desc_p->txrx_status |= DESC_TXSTS_TXFIRST | DESC_TXSTS_TXLAST;
 	desc_p->dmamac_cntl |= (length << DESC_TXCTRL_SIZE1SHFT) &
 			       DESC_TXCTRL_SIZE1MASK;
+	/* Full insertion, pseudo-header included; non-IP frames bypass it */
+	if (priv->tx_coe)
+		desc_p->txrx_status |= DESC_TXSTS_TXCHECKINSCTRL;
 
 	desc_p->txrx_status &= ~(DESC_TXSTS_MSK);
 	desc_p->txrx_status |= DESC_TXSTS_OWNBYDMA;
@@ -385,6 +429,9 @@ static int _dw_eth_send(struct dw_eth_dev *priv, void *packet, int length)
 	desc_p->dmamac_cntl |= ((length << DESC_TXCTRL_SIZE1SHFT) &
 			       DESC_TXCTRL_SIZE1MASK) | DESC_TXCTRL_TXLAST |
 			       DESC_TXCTRL_TXFIRST;
+	/* Full insertion, pseudo-header included; non-IP frames bypass it */
+	if (priv->tx_coe)
+		desc_p->dmamac_cntl |= DESC_TXCTRL_TXCHECKINSCTRL;
 
 	desc_p->txrx_status = DESC_TXSTS_OWNBYDMA;
 #endif
@@ -425,6 +472,8 @@ static int _dw_eth_recv(struct dw_eth_dev *priv, uchar **packetp)
 
 		length = (status & DESC_RXSTS_FRMLENMSK) >>
 			 DESC_RXSTS_FRMLENSHFT;
+		if (status & DESC_RXSTS_ERROR)
+			priv->rx_errors++;
 
 		/* Invalidate received data */
 		data_end = data_start + roundup(length, ARCH_DMA_MINALIGN);
@@ -435,6 +484,23 @@ static int _dw_eth_recv(struct dw_eth_dev *priv, uchar **packetp)
 	return length;
 }
 
+/*
+ * With the type 2 engine, an Ethernet type frame (RXFRAMEETHER) with
+ * neither the IP header (RXIPC_GIANT) nor the payload (bit 0) error set
+ * is an IPv4/IPv6 UDP/TCP/ICMP frame whose checksums are all good. Every
+ * other combination, including fragments, was not fully checked.
+ */
+static bool _dw_rx_csum_ok(struct dw_eth_dev *priv)
+{
+	u32 status = priv->rx_mac_descrtable[priv->rx_currdescnum].txrx_status;
+
+	if (!priv->rx_coe)
+		return false;
+
+	return (status & (DESC_RXSTS_RXFRAMEETHER | DESC_RXSTS_RXIPC_GIANT |
+			  DESC_RXSTS_RXPAYLOADCSUM)) == DESC_RXSTS_RXFRAMEETHER;
+}
+
 static int _dw_free_pkt(struct dw_eth_dev *priv)
 {
 	u32 desc_num = priv->rx_currdescnum;
@@ -623,6 +689,33 @@ int designware_eth_free_pkt(struct udevice *dev, uchar *packet, int length)
 	return _dw_free_pkt(priv);
 }
 
+bool designware_eth_rx_csum_ok(struct udevice *dev, uchar *packet,
+			       int length)
+{
+	struct dw_eth_dev *priv = dev_get_priv(dev);
+
+	return _dw_rx_csum_ok(priv);
+}
+
+#ifdef CONFIG_MCAST_TFTP
+/*
+ * Only one group is joined at a time, for multicast TFTP, so take all
+ * multicast frames rather than program the hash filter for it.
+ */
+int designware_eth_mcast(struct udevice *dev, const u8 *enetaddr, int join)
+{
+	struct dw_eth_dev *priv = dev_get_priv(dev);
+	struct eth_mac_regs *mac_p = priv->mac_regs_p;
+
+	if (join)
+		setbits_le32(&mac_p->framefilt, PASSALLMULTICAST);
+	else
+		clrbits_le32(&mac_p->framefilt, PASSALLMULTICAST);
+
+	return 0;
+}
+#endif
+
 void designware_eth_stop(struct udevice *dev)
 {
 	struct dw_eth_dev *priv = dev_get_priv(dev);
@@ -725,7 +818,11 @@ const struct eth_ops designware_eth_ops = {
 	.send			= designware_eth_send,
 	.recv			= designware_eth_recv,
 	.free_pkt		= designware_eth_free_pkt,
+	.rx_csum_ok		= designware_eth_rx_csum_ok,
 	.stop			= designware_eth_stop,
+#ifdef CONFIG_MCAST_TFTP
+	.mcast			= designware_eth_mcast,
+#endif
 	.write_hwaddr		= designware_eth_write_hwaddr,
 };
 
@@ -12,8 +12,16 @@
 #include <asm-generic/gpio.h>
 #endif
 
+#ifdef CONFIG_ETH_DESIGNWARE_TX_DESCR_NUM
+#define CONFIG_TX_DESCR_NUM	CONFIG_ETH_DESIGNWARE_TX_DESCR_NUM
+#else
 #define CONFIG_TX_DESCR_NUM	16
+#endif
+#ifdef CONFIG_ETH_DESIGNWARE_RX_DESCR_NUM
+#define CONFIG_RX_DESCR_NUM	CONFIG_ETH_DESIGNWARE_RX_DESCR_NUM
+#else
 #define CONFIG_RX_DESCR_NUM	16
+#endif
 #define CONFIG_ETH_BUFSIZE	2048
 #define TX_TOTAL_BUFSIZE	(CONFIG_ETH_BUFSIZE * CONFIG_TX_DESCR_NUM)
 #define RX_TOTAL_BUFSIZE	(CONFIG_ETH_BUFSIZE * CONFIG_RX_DESCR_NUM)
@@ -44,9 +52,13 @@ struct eth_mac_regs {
 #define FES_100			(1 << 14)
 #define DISABLERXOWN		(1 << 13)
 #define FULLDPLXMODE		(1 << 11)
+#define CHECKSUMOFFLOAD		(1 << 10)
 #define RXENABLE		(1 << 2)
 #define TXENABLE		(1 << 3)
 
+/* Frame filter register definitions */
+#define PASSALLMULTICAST	(1 << 4)
+
 /* MII address register definitions */
 #define MII_BUSY		(1 << 0)
 #define MII_WRITE		(1 << 1)
@@ -72,13 +84,15 @@ struct eth_dma_regs {
 	u32 status;		/* 0x14 */
 	u32 opmode;		/* 0x18 */
 	u32 intenable;		/* 0x1c */
-	u32 reserved1[2];
+	u32 missedframes;	/* 0x20 */
+	u32 reserved1[1];
 	u32 axibus;		/* 0x28 */
 	u32 reserved2[7];
 	u32 currhosttxdesc;	/* 0x48 */
 	u32 currhostrxdesc;	/* 0x4c */
 	u32 currhosttxbuffaddr;	/* 0x50 */
 	u32 currhostrxbuffaddr;	/* 0x54 */
+	u32 hwfeature;		/* 0x58 */
 };
 
 #define DW_DMA_BASE_OFFSET	(0x1000)
@@ -108,6 +122,18 @@ struct eth_dma_regs {
 #define TXSECONDFRAME		(1 << 2)
 #define RXSTART			(1 << 1)
 
+/* HW feature register definitions, reads as 0 on cores without it */
+#define HWFEAT_TXCOESEL		(1 << 16)
+#define HWFEAT_RXTYP2COE	(1 << 18)
+
+/* Missed frame and buffer overflow counter definitions, clear on read */
+#define MISSED_NODESC_MSK	(0xFFFF << 0)
+#define MISSED_NODESC_SHFT	(0)
+#define MISSED_NODESC_OVF	(1 << 16)
+#define MISSED_FIFO_MSK		(0x7FF << 17)
+#define MISSED_FIFO_SHFT	(17)
+#define MISSED_FIFO_OVF		(1 << 28)
+
 /* Descriptior related definitions */
 #define MAC_MAX_FRAME_SZ	(1600)
 
@@ -165,6 +191,7 @@ struct dmamacdescr {
 #define DESC_RXSTS_RXMIIERROR		(1 << 3)
 #define DESC_RXSTS_RXDRIBBLING		(1 << 2)
 #define DESC_RXSTS_RXCRC		(1 << 1)
+#define DESC_RXSTS_RXPAYLOADCSUM	(1 << 0)
 
 /*
  * dmamac_cntl definitions
@@ -231,6 +258,14 @@ struct dw_eth_dev {
 	u32 tx_currdescnum;
 	u32 rx_currdescnum;
 
+	/* Since the last designware_eth_init() */
+	u32 rx_errors;		/* frames received with an error status */
+	u32 rx_missed;		/* dropped, no free receive descriptor */
+	u32 rx_overruns;	/* dropped, receive FIFO overflow */
+
+	bool tx_coe;		/* MAC inserts IP and UDP/TCP checksums */
+	bool rx_coe;		/* MAC checks IP and UDP/TCP checksums */
+
 	struct eth_mac_regs *mac_regs_p;
 	struct eth_dma_regs *dma_regs_p;
 #ifndef CONFIG_DM_ETH
@@ -262,6 +297,11 @@ int designware_eth_free_pkt(struct udevice *dev, uchar *packet,
 				   int length);
 void designware_eth_stop(struct udevice *dev);
 int designware_eth_write_hwaddr(struct udevice *dev);
+bool designware_eth_rx_csum_ok(struct udevice *dev, uchar *packet,
+			       int length);
+#ifdef CONFIG_MCAST_TFTP
+int designware_eth_mcast(struct udevice *dev, const u8 *enetaddr, int join);
+#endif
 #endif
 
 #endif
@@ -75,6 +75,7 @@ struct eqos_mac_regs {
 	uint32_t address0_low;				/* 0x304 */
 };
 
+#define EQOS_MAC_CONFIGURATION_IPC			BIT(27)
 #define EQOS_MAC_CONFIGURATION_GPSLCE			BIT(23)
 #define EQOS_MAC_CONFIGURATION_CST			BIT(21)
 #define EQOS_MAC_CONFIGURATION_ACS			BIT(20)
@@ -108,6 +109,9 @@ struct eqos_mac_regs {
 #define EQOS_MAC_HW_FEATURE0_GMIISEL_SHIFT		1
 #define EQOS_MAC_HW_FEATURE0_MIISEL_SHIFT		0
 
+#define EQOS_MAC_HW_FEATURE0_RXCOESEL			BIT(16)
+#define EQOS_MAC_HW_FEATURE0_TXCOESEL			BIT(14)
+
 #define EQOS_MAC_HW_FEATURE1_TXFIFOSIZE_SHIFT		6
 #define EQOS_MAC_HW_FEATURE1_TXFIFOSIZE_MASK		0x1f
 #define EQOS_MAC_HW_FEATURE1_RXFIFOSIZE_SHIFT		0
@@ -270,6 +274,17 @@ struct eqos_desc {
 #define EQOS_DESC3_FD		BIT(29)
 #define EQOS_DESC3_LD		BIT(28)
 #define EQOS_DESC3_BUF1V	BIT(24)
+#define EQOS_DESC3_RS1V		BIT(26)
+#define EQOS_DESC3_CIC_FULL	(3 << 16)
+
+/* RX write-back des1, valid with EQOS_DESC3_RS1V */
+#define EQOS_DESC1_IPCE		BIT(7)
+#define EQOS_DESC1_IPCB		BIT(6)
+#define EQOS_DESC1_IPV4		BIT(4)
+#define EQOS_DESC1_IPHE		BIT(3)
+#define EQOS_DESC1_PT_MASK	7
+#define EQOS_DESC1_PT_UDP	1
+#define EQOS_DESC1_PT_TCP	2
 
 /*
  * TX and RX descriptors are 16 bytes. This causes problems with the cache
@@ -1139,6 +1154,62 @@ static int eqos_read_rom_hwaddr(struct udevice *dev)
 }
 #endif
 
+int eqos_phy_init(struct udevice *dev)
+{
+	struct eqos_priv *eqos = dev_get_priv(dev);
+	struct phy_device *phy;
+	int addr = -1;
+	int ret;
+
+	if (!eqos->mii_reseted) {
+		ret = eqos->config->ops->eqos_start_resets(dev);
+		if (ret < 0) {
+			pr_err("eqos_start_resets() failed: %d", ret);
+			return ret;
+		}
+
+		eqos->mii_reseted = true;
+		udelay(10);
+	}
+
+#ifdef CONFIG_DM_ETH_PHY
+	addr = eth_phy_get_addr(dev);
+#endif
+#ifdef DWC_NET_PHYADDR
+	addr = DWC_NET_PHYADDR;
+#endif
+	phy = phy_connect(eqos->mii, addr, dev,
+			  eqos->config->ops->eqos_get_interface(dev));
+	if (!phy) {
+		pr_err("phy_connect() failed");
+		return -ENODEV;
+	}
+
+	if (eqos->max_speed) {
+		ret = phy_set_supported(phy, eqos->max_speed);
+		if (ret) {
+			pr_err("phy_set_supported() failed: %d", ret);
+			goto err_shutdown_phy;
+		}
+	}
+
+	/* This (re)starts autonegotiation, which phy_startup() waits for */
+	ret = phy_config(phy);
+	if (ret < 0) {
+		pr_err("phy_config() failed: %d", ret);
+		goto err_shutdown_phy;
+	}
+
+	eqos->phy = phy;
+
+	return 0;
+
+err_shutdown_phy:
+	phy_shutdown(phy);
+	free(phy);
+	return ret;
+}
+
 int eqos_init(struct udevice *dev)
 {
 	struct eqos_priv *eqos = dev_get_priv(dev);
@@ -1200,34 +1271,9 @@ int eqos_init(struct udevice *dev)
 	 * don't need to reconnect/reconfigure again
 	 */
 	if (!eqos->phy) {
-		int addr = -1;
-#ifdef CONFIG_DM_ETH_PHY
-		addr = eth_phy_get_addr(dev);
-#endif
-#ifdef DWC_NET_PHYADDR
-		addr = DWC_NET_PHYADDR;
-#endif
-		eqos->phy = phy_connect(eqos->mii, addr, dev,
-		 eqos->config->ops->eqos_get_interface(dev));
-		if (!eqos->phy) {
-			pr_err("phy_connect() failed");
-			ret = -ENODEV;
+		ret = eqos_phy_init(dev);
+		if (ret < 0)
 			goto err_stop_resets;
-		}
-
-		if (eqos->max_speed) {
-			ret = phy_set_supported(eqos->phy, eqos->max_speed);
-			if (ret) {
-				pr_err("phy_set_supported() failed: %d", ret);
-				goto err_shutdown_phy;
-			}
-		}
-
-		ret = phy_config(eqos->phy);
-		if (ret < 0) {
-			pr_err("phy_config() failed: %d", ret);
-			goto err_shutdown_phy;
-		}
 	}
 
 	ret = phy_startup(eqos->phy);
@@ -1406,6 +1452,14 @@ void eqos_enable(struct udevice *dev)
 			EQOS_MAC_CONFIGURATION_CST |
 			EQOS_MAC_CONFIGURATION_ACS);
 
+	/* Let the checksum offload engine do the IP and UDP/TCP sums */
+	val = readl(&eqos->mac_regs->hw_feature0);
+	eqos->tx_coe = !!(val & EQOS_MAC_HW_FEATURE0_TXCOESEL);
+	eqos->rx_coe = !!(val & EQOS_MAC_HW_FEATURE0_RXCOESEL);
+	if (eqos->rx_coe)
+		setbits_le32(&eqos->mac_regs->configuration,
+			     EQOS_MAC_CONFIGURATION_IPC);
+
 	eqos_write_hwaddr(dev);
 
 	/* Configure DMA */
@@ -1586,7 +1640,8 @@ int eqos_send(struct udevice *dev, void *packet, int length)
 	 * writes to the rest of the descriptor too.
 	 */
 	mb();
-	tx_desc->des3 = EQOS_DESC3_OWN | EQOS_DESC3_FD | EQOS_DESC3_LD | length;
+	tx_desc->des3 = EQOS_DESC3_OWN | EQOS_DESC3_FD | EQOS_DESC3_LD |
+			(eqos->tx_coe ? EQOS_DESC3_CIC_FULL : 0) | length;
 	eqos->config->ops->eqos_flush_desc(tx_desc);
 
 	writel((ulong)(&(eqos->tx_descs[eqos->tx_desc_idx])),
@@ -1629,6 +1684,27 @@ int eqos_recv(struct udevice *dev, int flags, uchar **packetp)
 	return length;
 }
 
+/*
+ * Only an IPv4 UDP or TCP frame checked without a header or payload error
+ * counts, fragments and other protocols are bypassed by the engine.
+ */
+bool eqos_rx_csum_ok(struct udevice *dev, uchar *packet, int length)
+{
+	struct eqos_priv *eqos = dev_get_priv(dev);
+	struct eqos_desc *rx_desc = &eqos->rx_descs[eqos->rx_desc_idx];
+	u32 pt = rx_desc->des1 & EQOS_DESC1_PT_MASK;
+
+	if (!eqos->rx_coe || !(rx_desc->des3 & EQOS_DESC3_RS1V))
+		return false;
+
+	if ((rx_desc->des1 & (EQOS_DESC1_IPV4 | EQOS_DESC1_IPHE |
+			      EQOS_DESC1_IPCE | EQOS_DESC1_IPCB)) !=
+	    EQOS_DESC1_IPV4)
+		return false;
+
+	return pt == EQOS_DESC1_PT_UDP || pt == EQOS_DESC1_PT_TCP;
+}
+
 int eqos_free_pkt(struct udevice *dev, uchar *packet, int length)
 {
 	struct eqos_priv *eqos = dev_get_priv(dev);
@@ -2107,6 +2183,7 @@ static const struct eth_ops eqos_ops = {
 	.send = eqos_send,
 	.recv = eqos_recv,
 	.free_pkt = eqos_free_pkt,
+	.rx_csum_ok = eqos_rx_csum_ok,
 	.write_hwaddr = eqos_write_hwaddr,
 	.read_rom_hwaddr	= eqos_read_rom_hwaddr,
 };
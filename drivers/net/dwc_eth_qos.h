@@ -75,8 +75,11 @@ struct eqos_priv {
 	bool started;
 	bool reg_access_ok;
 	bool mii_reseted;
+	bool tx_coe;
+	bool rx_coe;
 };
 
+int eqos_phy_init(struct udevice *dev);
 int eqos_init(struct udevice *dev);
 void eqos_enable(struct udevice *dev);
 int eqos_probe(struct udevice *dev);
@@ -84,6 +87,7 @@ void eqos_stop(struct udevice *dev);
 int eqos_send(struct udevice *dev, void *packet, int length);
 int eqos_recv(struct udevice *dev, int flags, uchar **packetp);
 int eqos_free_pkt(struct udevice *dev, uchar *packet, int length);
+bool eqos_rx_csum_ok(struct udevice *dev, uchar *packet, int length);
 int eqos_write_hwaddr(struct udevice *dev);
 
 extern struct eqos_ops eqos_rockchip_ops;
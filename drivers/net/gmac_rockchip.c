@@ -2282,8 +2282,19 @@ static int gmac_rockchip_probe(struct udevice *dev)
 	}
 
 #ifdef CONFIG_DWC_ETH_QOS
-	return eqos_probe(dev);
+	ret = eqos_probe(dev);
+#ifdef CONFIG_GMAC_ROCKCHIP_EARLY_PHY
+	/*
+	 * Get autonegotiation going now so that it runs alongside the rest
+	 * of the boot, eqos_init() then only waits for what is left of it.
+	 * It is not fatal here: eqos_init() tries again if need be.
+	 */
+	if (!ret && eqos_phy_init(dev))
+		debug("%s: PHY not ready at probe\n", dev->name);
+#endif
+	return ret;
 #else
+	/* designware_eth_probe() sets up the PHY and so starts negotiating */
 	return designware_eth_probe(dev);
 #endif
 }
@@ -2307,6 +2318,16 @@ static int gmac_rockchip_eth_free_pkt(struct udevice *dev, uchar *packet,
 #endif
 }
 
+static bool gmac_rockchip_eth_rx_csum_ok(struct udevice *dev, uchar *packet,
+					 int length)
+{
+#ifdef CONFIG_DWC_ETH_QOS
+	return eqos_rx_csum_ok(dev, packet, length);
+#else
+	return designware_eth_rx_csum_ok(dev, packet, length);
+#endif
+}
+
 static int gmac_rockchip_eth_send(struct udevice *dev, void *packet,
 				  int length)
 {
@@ -2364,6 +2385,19 @@ static int gmac_rockchip_eth_start(struct udevice *dev)
 	return 0;
 }
 
+#ifdef CONFIG_MCAST_TFTP
+static int gmac_rockchip_eth_mcast(struct udevice *dev, const u8 *enetaddr,
+				   int join)
+{
+#ifdef CONFIG_DWC_ETH_QOS
+	/* eqos_init() leaves the MAC promiscuous */
+	return 0;
+#else
+	return designware_eth_mcast(dev, enetaddr, join);
+#endif
+}
+#endif
+
 static void gmac_rockchip_eth_stop(struct udevice *dev)
 {
 #ifdef CONFIG_DWC_ETH_QOS
@@ -2378,7 +2412,11 @@ const struct eth_ops gmac_rockchip_eth_ops = {
 	.send			= gmac_rockchip_eth_send,
 	.recv			= gmac_rockchip_eth_recv,
 	.free_pkt		= gmac_rockchip_eth_free_pkt,
+	.rx_csum_ok		= gmac_rockchip_eth_rx_csum_ok,
 	.stop			= gmac_rockchip_eth_stop,
+#ifdef CONFIG_MCAST_TFTP
+	.mcast			= gmac_rockchip_eth_mcast,
+#endif
 	.write_hwaddr		= gmac_rockchip_eth_write_hwaddr,
 };
 
@@ -6,7 +6,6 @@
  */
 
 #include <common.h>
-#include <bouncebuf.h>
 #include <dm.h>
 #include <errno.h>
 #include <memalign.h>
@@ -14,7 +13,7 @@
 #include <dm/device-internal.h>
 #include "nvme.h"
 
-#define NVME_Q_DEPTH		2
+#define NVME_Q_DEPTH		16
 #define NVME_AQ_DEPTH		2
 #define NVME_SQ_SIZE(depth)	(depth * sizeof(struct nvme_command))
 #define NVME_CQ_SIZE(depth)	(depth * sizeof(struct nvme_completion))
@@ -22,7 +21,6 @@
 				      ARCH_DMA_MINALIGN)
 #define ADMIN_TIMEOUT		60
 #define IO_TIMEOUT		30
-#define MAX_PRP_POOL		512
 
 enum nvme_queue_id {
 	NVME_ADMIN_Q,
@@ -69,12 +67,17 @@ static int nvme_wait_ready(struct nvme_dev *dev, bool enabled)
 	return -ETIME;
 }
 
-static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
+/*
+ * Build the PRP list of a transfer in the pool of @slot, whose pages are
+ * chained through their last entry.
+ */
+static int nvme_setup_prps(struct nvme_dev *dev, int slot, u64 *prp2,
 			   int total_len, u64 dma_addr)
 {
 	u32 page_size = dev->page_size;
 	int offset = dma_addr & (page_size - 1);
-	u64 *prp_pool;
+	u64 *prp_list = dev->prp_pool + slot * dev->prp_entry_num;
+	u64 *prp_pool = prp_list;
 	int length = total_len;
 	int i, nprps;
 	u32 prps_per_page = page_size >> 3;
@@ -98,21 +101,11 @@ static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
 	nprps = DIV_ROUND_UP(length, page_size);
 	num_pages = DIV_ROUND_UP(nprps + 1, prps_per_page);
 
-	if (nprps > dev->prp_entry_num) {
-		free(dev->prp_pool);
-		/*
-		 * Always increase in increments of pages.  It doesn't waste
-		 * much memory and reduces the number of allocations.
-		 */
-		dev->prp_pool = memalign(page_size, num_pages * page_size);
-		if (!dev->prp_pool) {
-			printf("Error: malloc prp_pool fail\n");
-			return -ENOMEM;
-		}
-		dev->prp_entry_num = prps_per_page * num_pages;
+	if (prps_per_page * num_pages > dev->prp_entry_num) {
+		printf("Error: %d bytes exceed the PRP pool\n", total_len);
+		return -EINVAL;
 	}
 
-	prp_pool = dev->prp_pool;
 	i = 0;
 	while (nprps) {
 		if (i == prps_per_page) {
@@ -120,16 +113,38 @@ static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
 			*(prp_pool + i - 1) = cpu_to_le64((ulong)prp_pool +
 					page_size);
 			i = 1;
-			prp_pool += page_size;
+			prp_pool += prps_per_page;
 		}
 		*(prp_pool + i++) = cpu_to_le64(dma_addr);
 		dma_addr += page_size;
 		nprps--;
 	}
-	*prp2 = (ulong)dev->prp_pool;
+	*prp2 = (ulong)prp_list;
 
-	flush_dcache_range((ulong)dev->prp_pool, (ulong)dev->prp_pool +
-			   dev->prp_entry_num * sizeof(u64));
+	flush_dcache_range((ulong)prp_list,
+			   (ulong)prp_list + num_pages * page_size);
+
+	return 0;
+}
+
+/*
+ * Pools for NVME_IO_INFLIGHT transfers of the largest size the controller
+ * takes, allocated once so the I/O path never has to.
+ */
+static int nvme_alloc_prp_pool(struct nvme_dev *dev)
+{
+	u32 page_size = dev->page_size;
+	u32 prps_per_page = page_size >> 3;
+	u32 num_pages;
+
+	num_pages = DIV_ROUND_UP((1U << dev->max_transfer_shift) / page_size + 1,
+				 prps_per_page);
+
+	dev->prp_pool = memalign(page_size,
+				 NVME_IO_INFLIGHT * num_pages * page_size);
+	if (!dev->prp_pool)
+		return -ENOMEM;
+	dev->prp_entry_num = prps_per_page * num_pages;
 
 	return 0;
 }
@@ -177,8 +192,16 @@ static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
 	nvmeq->sq_tail = tail;
 }
 
-static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
-				struct nvme_command *cmd,
+/**
+ * nvme_wait_completion() - reap the next completion of a queue
+ *
+ * @nvmeq:	The queue to poll
+ * @cmdid:	Returns the command_id of the completed command, may be NULL
+ * @result:	Returns the command specific result, may be NULL
+ * @timeout:	Timeout, 0 waits forever
+ * @return 0 if OK, -EIO if the command failed, -ETIMEDOUT
+ */
+static int nvme_wait_completion(struct nvme_queue *nvmeq, u16 *cmdid,
 				u32 *result, unsigned timeout)
 {
 	u16 head = nvmeq->cq_head;
@@ -187,9 +210,6 @@ static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
 	ulong start_time;
 	ulong timeout_us = timeout * 100000;
 
-	cmd->common.command_id = nvme_get_cmd_id();
-	nvme_submit_cmd(nvmeq, cmd);
-
 	start_time = timer_get_us();
 
 	for (;;) {
@@ -201,23 +221,14 @@ static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
 			return -ETIMEDOUT;
 	}
 
+	if (cmdid)
+		*cmdid = readw(&(nvmeq->cqes[head].command_id));
+
 	status >>= 1;
-	if (status) {
+	if (status)
 		printf("ERROR: status = %x, phase = %d, head = %d\n",
 		       status, phase, head);
-		status = 0;
-		if (++head == nvmeq->q_depth) {
-			head = 0;
-			phase = !phase;
-		}
-		writel(head, nvmeq->q_db + nvmeq->dev->db_stride);
-		nvmeq->cq_head = head;
-		nvmeq->cq_phase = phase;
-
-		return -EIO;
-	}
-
-	if (result)
+	else if (result)
 		*result = readl(&(nvmeq->cqes[head].result));
 
 	if (++head == nvmeq->q_depth) {
@@ -228,7 +239,17 @@ static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
 	nvmeq->cq_head = head;
 	nvmeq->cq_phase = phase;
 
-	return status;
+	return status ? -EIO : 0;
+}
+
+static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
+				struct nvme_command *cmd,
+				u32 *result, unsigned timeout)
+{
+	cmd->common.command_id = nvme_get_cmd_id();
+	nvme_submit_cmd(nvmeq, cmd);
+
+	return nvme_wait_completion(nvmeq, NULL, result, timeout);
 }
 
 static int nvme_submit_admin_cmd(struct nvme_dev *dev, struct nvme_command *cmd,
@@ -689,6 +710,8 @@ int nvme_scan_namespace(void)
 	return 0;
 }
 
+static const struct blk_rq_ops nvme_rq_ops;
+
 static int nvme_blk_probe(struct udevice *udev)
 {
 	struct nvme_dev *ndev = dev_get_priv(udev->parent);
@@ -720,6 +743,11 @@ static int nvme_blk_probe(struct udevice *udev)
 	desc->log2blksz = ns->lba_shift;
 	desc->blksz = 1 << ns->lba_shift;
 	desc->bdev = udev;
+	/* A full submission queue still has one free entry */
+	blk_queue_init(&ns->queue, &nvme_rq_ops,
+		       min_t(int, ndev->queues[NVME_IO_Q]->q_depth - 1,
+			     NVME_IO_INFLIGHT),
+		       1 << (ndev->max_transfer_shift - ns->lba_shift));
 	pplat = dev_get_parent_platdata(udev->parent);
 	sprintf(desc->vendor, "0x%.4x", pplat->vendor);
 	memcpy(desc->product, ndev->serial, sizeof(ndev->serial));
@@ -730,92 +758,103 @@ static int nvme_blk_probe(struct udevice *udev)
 	return 0;
 }
 
-static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
-			 lbaint_t blkcnt, void *buffer, bool read)
+/*
+ * The block queue keeps up to NVME_IO_INFLIGHT commands of at most
+ * max_transfer_shift bytes queued, so the controller fetches the next one
+ * while it transfers the current. The tag of a request is its PRP pool.
+ */
+static int nvme_blk_submit(struct udevice *udev, struct blk_rq *rq)
 {
 	struct nvme_ns *ns = dev_get_priv(udev);
 	struct nvme_dev *dev = ns->dev;
 	struct nvme_command c;
-	struct blk_desc *desc = dev_get_uclass_platdata(udev);
-	int status;
 	u64 prp2;
-	u64 total_len = blkcnt << desc->log2blksz;
-	u64 temp_len = total_len;
-	uintptr_t temp_buffer;
-
-	u64 slba = blknr;
-	u16 lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
-	u64 total_lbas = blkcnt;
-
-	struct bounce_buffer bb;
-	unsigned int bb_flags;
 	int ret;
 
-	if (read)
-		bb_flags = GEN_BB_WRITE;
-	else
-		bb_flags = GEN_BB_READ;
-
-	ret = bounce_buffer_start(&bb, buffer, total_len, bb_flags);
+	ret = nvme_setup_prps(dev, rq->tag, &prp2, rq->blkcnt << ns->lba_shift,
+			      (ulong)rq->buffer);
 	if (ret)
-		return -ENOMEM;
-	temp_buffer = (unsigned long)bb.bounce_buffer;
+		return ret;
 
-	c.rw.opcode = read ? nvme_cmd_read : nvme_cmd_write;
-	c.rw.flags = 0;
+	memset(&c, 0, sizeof(c));
+	c.rw.opcode = rq->write ? nvme_cmd_write : nvme_cmd_read;
 	c.rw.nsid = cpu_to_le32(ns->ns_id);
-	c.rw.control = 0;
-	c.rw.dsmgmt = 0;
-	c.rw.reftag = 0;
-	c.rw.apptag = 0;
-	c.rw.appmask = 0;
-	c.rw.metadata = 0;
-
 	/* Enable FUA for data integrity if vwc is enabled */
 	if (dev->vwc)
 		c.rw.control |= NVME_RW_FUA;
+	c.rw.command_id = nvme_get_cmd_id();
+	c.rw.slba = cpu_to_le64(rq->start);
+	c.rw.length = cpu_to_le16(rq->blkcnt - 1);
+	c.rw.prp1 = cpu_to_le64((ulong)rq->buffer);
+	c.rw.prp2 = cpu_to_le64(prp2);
+	nvme_submit_cmd(dev->queues[NVME_IO_Q], &c);
+	ns->cmdid[rq->tag] = c.rw.command_id;
 
-	while (total_lbas) {
-		if (total_lbas < lbas) {
-			lbas = (u16)total_lbas;
-			total_lbas = 0;
-		} else {
-			total_lbas -= lbas;
-		}
+	return 0;
+}
 
-		if (nvme_setup_prps(dev, &prp2,
-				    lbas << ns->lba_shift, temp_buffer))
-			return -EIO;
-		c.rw.slba = cpu_to_le64(slba);
-		slba += lbas;
-		c.rw.length = cpu_to_le16(lbas - 1);
-		c.rw.prp1 = cpu_to_le64(temp_buffer);
-		c.rw.prp2 = cpu_to_le64(prp2);
-		status = nvme_submit_sync_cmd(dev->queues[NVME_IO_Q],
-				&c, NULL, IO_TIMEOUT);
-		if (status)
-			break;
-		temp_len -= (u32)lbas << ns->lba_shift;
-		temp_buffer += lbas << ns->lba_shift;
-	}
+/* Completions may come back in any order, match them by command_id */
+static int nvme_blk_complete(struct udevice *udev, struct blk_queue *q)
+{
+	struct nvme_ns *ns = dev_get_priv(udev);
+	struct nvme_queue *nvmeq = ns->dev->queues[NVME_IO_Q];
+	int ret, tag;
+	u16 cmdid;
 
-	bounce_buffer_stop(&bb);
+	for (;;) {
+		ret = nvme_wait_completion(nvmeq, &cmdid, NULL, IO_TIMEOUT);
+		if (ret == -ETIMEDOUT)
+			return ret;
 
-	return (total_len - temp_len) >> desc->log2blksz;
+		/* Skip completions of commands not waited for, e.g. DSM */
+		for (tag = 0; tag < q->depth; tag++) {
+			if ((q->busy & BIT(tag)) && ns->cmdid[tag] == cmdid) {
+				q->rq[tag].error = ret;
+				return tag;
+			}
+		}
+	}
 }
 
+static const struct blk_rq_ops nvme_rq_ops = {
+	.submit		= nvme_blk_submit,
+	.complete	= nvme_blk_complete,
+};
+
 static ulong nvme_blk_read(struct udevice *udev, lbaint_t blknr,
 			   lbaint_t blkcnt, void *buffer)
 {
-	return nvme_blk_rw(udev, blknr, blkcnt, buffer, true);
+	struct nvme_ns *ns = dev_get_priv(udev);
+
+	return blk_queue_rw(udev, &ns->queue, blknr, blkcnt, buffer, false);
 }
 
 static ulong nvme_blk_write(struct udevice *udev, lbaint_t blknr,
 			    lbaint_t blkcnt, const void *buffer)
 {
-	return nvme_blk_rw(udev, blknr, blkcnt, (void *)buffer, false);
+	struct nvme_ns *ns = dev_get_priv(udev);
+
+	return blk_queue_rw(udev, &ns->queue, blknr, blkcnt, (void *)buffer,
+			    true);
+}
+
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+static ulong nvme_blk_read_async(struct udevice *udev, lbaint_t blknr,
+				 lbaint_t blkcnt, void *buffer)
+{
+	struct nvme_ns *ns = dev_get_priv(udev);
+
+	return blk_queue_read_async(udev, &ns->queue, blknr, blkcnt, buffer);
 }
 
+static int nvme_blk_wait(struct udevice *udev)
+{
+	struct nvme_ns *ns = dev_get_priv(udev);
+
+	return blk_queue_wait(udev, &ns->queue);
+}
+#endif
+
 static ulong nvme_blk_erase(struct udevice *udev, lbaint_t blknr,
 			    lbaint_t blkcnt)
 {
@@ -849,6 +888,10 @@ static const struct blk_ops nvme_blk_ops = {
 	.read	= nvme_blk_read,
 	.write	= nvme_blk_write,
 	.erase  = nvme_blk_erase,
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+	.read_async = nvme_blk_read_async,
+	.wait	= nvme_blk_wait,
+#endif
 };
 
 U_BOOT_DRIVER(nvme_blk) = {
@@ -903,21 +946,19 @@ static int nvme_probe(struct udevice *udev)
 	if (ret)
 		goto free_queue;
 
-	/* Allocate after the page size is known */
-	ndev->prp_pool = memalign(ndev->page_size, MAX_PRP_POOL);
-	if (!ndev->prp_pool) {
-		ret = -ENOMEM;
-		printf("Error: %s: Out of memory!\n", udev->name);
-		goto free_nvme;
-	}
-	ndev->prp_entry_num = MAX_PRP_POOL >> 3;
-
 	ret = nvme_setup_io_queues(ndev);
 	if (ret)
 		goto free_queue;
 
 	nvme_get_info_from_identify(ndev);
 
+	/* Allocate after the page and the maximum transfer size are known */
+	ret = nvme_alloc_prp_pool(ndev);
+	if (ret) {
+		printf("Error: %s: Out of memory!\n", udev->name);
+		goto free_queue;
+	}
+
 	/* Create a blk device for each namespace */
 
 	id = memalign(ndev->page_size, sizeof(struct nvme_id_ns));
@@ -9,6 +9,10 @@
 #define __DRIVER_NVME_H__
 
 #include <asm/io.h>
+#include <blk_queue.h>
+
+/* Read/write commands kept in flight, each with a PRP list of its own */
+#define NVME_IO_INFLIGHT	8
 
 struct nvme_id_power_state {
 	__le16			max_power;	/* centiwatts */
@@ -627,8 +631,8 @@ struct nvme_dev {
 	u32 stripe_size;
 	u32 page_size;
 	u8 vwc;
-	u64 *prp_pool;
-	u32 prp_entry_num;
+	u64 *prp_pool;		/* a PRP list per in-flight I/O command */
+	u32 prp_entry_num;	/* entries in each of the lists */
 	u32 nn;
 };
 
@@ -644,6 +648,8 @@ struct nvme_ns {
 	int devnum;
 	int lba_shift;
 	u8 flbas;
+	struct blk_queue queue;
+	u16 cmdid[NVME_IO_INFLIGHT];	/* command_id of each queue tag */
 };
 
 #endif /* __DRIVER_NVME_H__ */
@@ -8,6 +8,8 @@
 #include <common.h>
 #include <clk.h>
 #include <dm.h>
+#include <dm/pinctrl.h>
+#include <dm/uclass-internal.h>
 #include <generic-phy.h>
 #include <pci.h>
 #include <power-domain.h>
@@ -71,6 +73,14 @@ struct rk_pcie {
 	struct pci_region	mem64;
 	bool		is_bifurcation;
 	u32 gen;
+	/* Link training, see rockchip_pcie_start_all() */
+	bool		started;
+	bool		ltssm_started;
+	bool		link_ready;
+	int		parse_ret;
+	int		start_ret;
+	ulong		power_on;
+	ulong		ltssm_start;
 };
 
 enum {
@@ -81,6 +91,10 @@ enum {
 
 #define msleep(a)		udelay((a) * 1000)
 
+/* Link training timeout, and how long an empty slot stays in Detect */
+#define RK_PCIE_LINK_TIMEOUT		500
+#define RK_PCIE_DETECT_TIMEOUT		100
+
 /* Parameters for the waiting for iATU enabled routine */
 #define PCIE_CLIENT_GENERAL_DEBUG	0x104
 #define PCIE_CLIENT_HOT_RESET_CTRL	0x180
@@ -88,6 +102,8 @@ enum {
 #define PCIE_CLIENT_LTSSM_STATUS	0x300
 #define SMLH_LINKUP			BIT(16)
 #define RDLH_LINKUP			BIT(17)
+#define PCIE_LTSSM_STATE_MASK		GENMASK(5, 0)
+#define PCIE_LTSSM_DETECT_ACT		0x01
 #define PCIE_CLIENT_DBG_FIFO_MODE_CON	0x310
 #define PCIE_CLIENT_DBG_FIFO_PTN_HIT_D0 0x320
 #define PCIE_CLIENT_DBG_FIFO_PTN_HIT_D1 0x324
@@ -431,7 +447,7 @@ static int rockchip_pcie_rd_conf(struct udevice *bus, pci_dev_t bdf,
 				 uint offset, ulong *valuep,
 				 enum pci_size_t size)
 {
-	struct rk_pcie *pcie = dev_get_priv(bus);
+	struct rk_pcie *pcie = dev_get_platdata(bus);
 	uintptr_t va_address;
 	ulong value;
 
@@ -462,7 +478,7 @@ static int rockchip_pcie_wr_conf(struct udevice *bus, pci_dev_t bdf,
 				 uint offset, ulong value,
 				 enum pci_size_t size)
 {
-	struct rk_pcie *pcie = dev_get_priv(bus);
+	struct rk_pcie *pcie = dev_get_platdata(bus);
 	uintptr_t va_address;
 	ulong old;
 
@@ -543,26 +559,36 @@ static int is_link_up(struct rk_pcie *priv)
 	return 0;
 }
 
-static int rk_pcie_link_up(struct rk_pcie *priv, u32 cap_speed)
+/*
+ * All the controllers are powered up and start training their link from
+ * the first probe, so that they wait for it together: each probe then
+ * only collects its own result, and an empty slot costs the longest wait
+ * rather than adding to the others.
+ */
+static int rk_pcie_start_link(struct rk_pcie *priv)
 {
-	int retries;
+	ulong elapsed;
 
 	if (is_link_up(priv)) {
 		printf("PCI Link already up before configuration!\n");
-		return 1;
+		priv->link_ready = true;
+		return 0;
 	}
 
 	/* DW pre link configurations */
-	rk_pcie_configure(priv, cap_speed);
+	rk_pcie_configure(priv, priv->gen);
 
 	/* Release the device */
 	if (dm_gpio_is_valid(&priv->rst_gpio)) {
 		/*
 		 * T_PVPERL (Power stable to PERST# inactive) should be a minimum of 100ms.
 		 * We add a 200ms by default for sake of hoping everthings
-		 * work fine.
+		 * work fine. It runs from power up, so it is only waited for
+		 * once for all the controllers.
 		 */
-		msleep(200);
+		elapsed = get_timer(priv->power_on);
+		if (elapsed < 200)
+			msleep(200 - elapsed);
 		dm_gpio_set_value(&priv->rst_gpio, 1);
 		/*
 		 * Add this 20ms delay because we observe link is always up stably after it and
@@ -577,33 +603,79 @@ static int rk_pcie_link_up(struct rk_pcie *priv, u32 cap_speed)
 
 	/* Enable LTSSM */
 	rk_pcie_enable_ltssm(priv);
+	priv->ltssm_start = get_timer(0);
+
+	return 0;
+}
+
+static int rk_pcie_wait_link(struct rk_pcie *priv)
+{
+	bool detected = false;
+	bool polled = false;
+	ulong elapsed, up;
+	u32 ltssm;
+
+	if (priv->link_ready)
+		return 0;
+
+	for (;;) {
+		elapsed = get_timer(priv->ltssm_start);
+		ltssm = rk_pcie_readl_apb(priv, PCIE_CLIENT_LTSSM_STATUS);
 
-	for (retries = 0; retries < 50; retries++) {
 		if (is_link_up(priv)) {
 			dev_info(priv->dev, "PCIe Link up, LTSSM is 0x%x\n",
-				 rk_pcie_readl_apb(priv, PCIE_CLIENT_LTSSM_STATUS));
+				 ltssm);
 			rk_pcie_debug_dump(priv);
-			/* Link maybe in Gen switch recovery but we need to wait more 1s */
-			msleep(1000);
+			/*
+			 * Link maybe in Gen switch recovery but we need to wait
+			 * more 1s. A link found up on arrival came up before
+			 * the training timeout at the latest.
+			 */
+			up = polled ? elapsed :
+			     min_t(ulong, elapsed, RK_PCIE_LINK_TIMEOUT);
+			if (elapsed < up + 1000)
+				msleep(up + 1000 - elapsed);
 			return 0;
 		}
 
-		dev_info(priv->dev, "PCIe Linking... LTSSM is 0x%x\n",
-			 rk_pcie_readl_apb(priv, PCIE_CLIENT_LTSSM_STATUS));
+		if (elapsed >= RK_PCIE_LINK_TIMEOUT)
+			break;
+
+		/* No receiver seen: the slot is empty */
+		if ((ltssm & PCIE_LTSSM_STATE_MASK) > PCIE_LTSSM_DETECT_ACT)
+			detected = true;
+		else if (!detected && elapsed >= RK_PCIE_DETECT_TIMEOUT)
+			break;
+
+		dev_info(priv->dev, "PCIe Linking... LTSSM is 0x%x\n", ltssm);
 		rk_pcie_debug_dump(priv);
 		msleep(10);
+		polled = true;
 	}
 
-	dev_err(priv->dev, "PCIe-%d Link Fail\n", priv->dev->seq);
+	if (detected)
+		dev_err(priv->dev, "PCIe-%d Link Fail\n", priv->dev->seq);
+	else
+		dev_info(priv->dev, "PCIe-%d: no device\n", priv->dev->seq);
 	rk_pcie_disable_ltssm(priv);
 	return -EINVAL;
 }
 
+static void rockchip_pcie_power_off(struct rk_pcie *priv)
+{
+	clk_disable_bulk(&priv->clks);
+	reset_assert_bulk(&priv->rsts);
+	generic_phy_power_off(&priv->phy);
+	generic_phy_exit(&priv->phy);
+	if (priv->vpcie3v3)
+		regulator_set_enable(priv->vpcie3v3, false);
+}
+
 static int rockchip_pcie_init_port(struct udevice *dev)
 {
 	int ret;
 	u32 val;
-	struct rk_pcie *priv = dev_get_priv(dev);
+	struct rk_pcie *priv = dev_get_platdata(dev);
 	union phy_configure_opts phy_cfg;
 
 	/* Rest the device */
@@ -619,6 +691,7 @@ static int rockchip_pcie_init_port(struct udevice *dev)
 			return ret;
 		}
 	}
+	priv->power_on = get_timer(0);
 
 	if (priv->is_bifurcation) {
 		phy_cfg.pcie.is_bifurcation = true;
@@ -660,13 +733,7 @@ static int rockchip_pcie_init_port(struct udevice *dev)
 	rk_pcie_writel_apb(priv, 0x0, 0xf00040);
 	rk_pcie_setup_host(priv);
 
-	ret = rk_pcie_link_up(priv, priv->gen);
-	if (ret < 0)
-		goto err_link_up;
-
 	return 0;
-err_link_up:
-	clk_disable_bulk(&priv->clks);
 err_deassert_bulk:
 	reset_assert_bulk(&priv->rsts);
 err_power_off_phy:
@@ -681,7 +748,7 @@ err_disable_3v3:
 
 static int rockchip_pcie_parse_dt(struct udevice *dev)
 {
-	struct rk_pcie *priv = dev_get_priv(dev);
+	struct rk_pcie *priv = dev_get_platdata(dev);
 	u32 max_link_speed;
 	int ret;
 	struct resource res;
@@ -742,23 +809,72 @@ static int rockchip_pcie_parse_dt(struct udevice *dev)
 	return 0;
 }
 
+/* Powers up the controllers not started yet, then starts their links */
+static void rockchip_pcie_start_all(void)
+{
+	struct rk_pcie *priv;
+	struct udevice *dev;
+
+	for (uclass_find_first_device(UCLASS_PCI, &dev); dev;
+	     uclass_find_next_device(&dev)) {
+		if (dev->driver != DM_GET_DRIVER(rockchip_pcie))
+			continue;
+		priv = dev_get_platdata(dev);
+		if (priv->started)
+			continue;
+
+		priv->started = true;
+		priv->dev = dev;
+		priv->link_ready = false;
+		/* As device_probe() would, before touching the hardware */
+		if (!device_active(dev))
+			pinctrl_select_state(dev, "default");
+		priv->parse_ret = rockchip_pcie_parse_dt(dev);
+		if (!priv->parse_ret)
+			priv->start_ret = rockchip_pcie_init_port(dev);
+	}
+
+	for (uclass_find_first_device(UCLASS_PCI, &dev); dev;
+	     uclass_find_next_device(&dev)) {
+		if (dev->driver != DM_GET_DRIVER(rockchip_pcie))
+			continue;
+		priv = dev_get_platdata(dev);
+		if (priv->parse_ret || priv->start_ret || priv->ltssm_started)
+			continue;
+
+		priv->ltssm_started = true;
+		rk_pcie_start_link(priv);
+	}
+}
+
 static int rockchip_pcie_probe(struct udevice *dev)
 {
-	struct rk_pcie *priv = dev_get_priv(dev);
+	struct rk_pcie *priv = dev_get_platdata(dev);
 	struct udevice *ctlr = pci_get_controller(dev);
 	struct pci_controller *hose = dev_get_uclass_priv(ctlr);
 	int ret;
 
+	rockchip_pcie_start_all();
 	priv->first_busno = dev->seq;
-	priv->dev = dev;
 
-	ret = rockchip_pcie_parse_dt(dev);
-	if (ret)
+	/* A later probe of this controller powers it up again */
+	ret = priv->parse_ret;
+	if (ret) {
+		priv->started = false;
 		return ret;
+	}
 
-	ret = rockchip_pcie_init_port(dev);
-	if (ret)
+	ret = priv->start_ret;
+	if (!ret) {
+		ret = rk_pcie_wait_link(priv);
+		if (ret)
+			rockchip_pcie_power_off(priv);
+	}
+	if (ret) {
+		priv->started = false;
+		priv->ltssm_started = false;
 		goto free_rst;
+	}
 
 	dev_info(dev, "PCIE-%d: Link up (Gen%d-x%d, Bus%d)\n",
 		 dev->seq, rk_pcie_get_link_speed(priv),
@@ -876,5 +992,5 @@ U_BOOT_DRIVER(rockchip_pcie) = {
 	.of_match		= rockchip_pcie_ids,
 	.ops			= &rockchip_pcie_ops,
 	.probe			= rockchip_pcie_probe,
-	.priv_auto_alloc_size	= sizeof(struct rk_pcie),
+	.platdata_auto_alloc_size = sizeof(struct rk_pcie),
 };
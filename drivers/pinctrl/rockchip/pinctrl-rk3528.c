@@ -34,7 +34,7 @@ static int rk3528_set_mux(struct rockchip_pin_bank *bank, int pin, int mux)
 
 	debug("iomux write reg = %x data = %x\n", reg, data);
 
-	ret = regmap_write(regmap, reg, data);
+	ret = rockchip_pinctrl_write(bank, regmap, reg, data);
 
 	return ret;
 }
@@ -100,7 +100,7 @@ static int rk3528_set_drive(struct rockchip_pin_bank *bank,
 	/* enable the write to the equivalent lower bits */
 	data = ((1 << RK3528_DRV_BITS_PER_PIN) - 1) << (bit + 16);
 	data |= (drv << bit);
-	ret = regmap_write(regmap, reg, data);
+	ret = rockchip_pinctrl_write(bank, regmap, reg, data);
 
 	return ret;
 }
@@ -175,7 +175,7 @@ static int rk3528_set_pull(struct rockchip_pin_bank *bank,
 	data = ((1 << RK3528_PULL_BITS_PER_PIN) - 1) << (bit + 16);
 
 	data |= (ret << bit);
-	ret = regmap_write(regmap, reg, data);
+	ret = rockchip_pinctrl_write(bank, regmap, reg, data);
 
 	return ret;
 }
@@ -242,7 +242,7 @@ static int rk3528_set_schmitt(struct rockchip_pin_bank *bank,
 	/* enable the write to the equivalent lower bits */
 	data = ((1 << RK3528_SMT_BITS_PER_PIN) - 1) << (bit + 16);
 	data |= (enable << bit);
-	ret = regmap_write(regmap, reg, data);
+	ret = rockchip_pinctrl_write(bank, regmap, reg, data);
 
 	return ret;
 }
@@ -36,16 +36,16 @@ static int rk3562_set_mux(struct rockchip_pin_bank *bank, int pin, int mux)
 	if (bank->bank_num == 1) {
 		if ((pin == 13) || (pin == 14)) {
 			if (mux == 1) {
-				regmap_write(regmap, 0x504, 0x10001);
+				rockchip_pinctrl_write(bank, regmap, 0x504, 0x10001);
 			} else {
-				regmap_write(regmap, 0x504, 0x10000);
+				rockchip_pinctrl_write(bank, regmap, 0x504, 0x10000);
 			}
 		}
 	}
 
 	debug("iomux write reg = %x data = %x\n", reg, data);
 
-	ret = regmap_write(regmap, reg, data);
+	ret = rockchip_pinctrl_write(bank, regmap, reg, data);
 
 	return ret;
 }
@@ -111,7 +111,7 @@ static int rk3562_set_drive(struct rockchip_pin_bank *bank,
 	/* enable the write to the equivalent lower bits */
 	data = ((1 << RK3562_DRV_BITS_PER_PIN) - 1) << (bit + 16);
 	data |= (drv << bit);
-	ret = regmap_write(regmap, reg, data);
+	ret = rockchip_pinctrl_write(bank, regmap, reg, data);
 
 	return ret;
 }
@@ -186,7 +186,7 @@ static int rk3562_set_pull(struct rockchip_pin_bank *bank,
 	data = ((1 << RK3562_PULL_BITS_PER_PIN) - 1) << (bit + 16);
 
 	data |= (ret << bit);
-	ret = regmap_write(regmap, reg, data);
+	ret = rockchip_pinctrl_write(bank, regmap, reg, data);
 
 	return ret;
 }
@@ -254,7 +254,7 @@ static int rk3562_set_schmitt(struct rockchip_pin_bank *bank,
 	/* enable the write to the equivalent lower bits */
 	data = ((1 << RK3562_SMT_BITS_PER_PIN) - 1) << (bit + 16);
 	data |= (enable << bit);
-	ret = regmap_write(regmap, reg, data);
+	ret = rockchip_pinctrl_write(bank, regmap, reg, data);
 
 	return ret;
 }
@@ -114,7 +114,7 @@ static int rk3568_set_mux(struct rockchip_pin_bank *bank, int pin, int mux)
 	struct regmap *regmap;
 	int reg, mask;
 	u8 bit;
-	u32 data, rmask;
+	u32 data;
 
 	debug("setting mux of GPIO%d-%d to %d\n", bank->bank_num, pin, mux);
 
@@ -130,10 +130,9 @@ static int rk3568_set_mux(struct rockchip_pin_bank *bank, int pin, int mux)
 	mask = 0xf;
 
 	data = (mask << (bit + 16));
-	rmask = data | (data >> 16);
 	data |= (mux & mask) << bit;
 
-	return regmap_update_bits(regmap, reg, rmask, data);
+	return rockchip_pinctrl_write(bank, regmap, reg, data);
 }
 
 #define RK3568_PULL_PMU_OFFSET		0x20
@@ -224,7 +223,7 @@ static int rk3568_set_pull(struct rockchip_pin_bank *bank,
 	struct regmap *regmap;
 	int reg, ret;
 	u8 bit, type;
-	u32 data, rmask;
+	u32 data;
 
 	if (pull == PIN_CONFIG_BIAS_PULL_PIN_DEFAULT)
 		return -ENOTSUPP;
@@ -239,10 +238,9 @@ static int rk3568_set_pull(struct rockchip_pin_bank *bank,
 
 	/* enable the write to the equivalent lower bits */
 	data = ((1 << ROCKCHIP_PULL_BITS_PER_PIN) - 1) << (bit + 16);
-	rmask = data | (data >> 16);
 	data |= (ret << bit);
 
-	return regmap_update_bits(regmap, reg, rmask, data);
+	return rockchip_pinctrl_write(bank, regmap, reg, data);
 }
 
 #define GRF_GPIO1C5_DS		0x0840
@@ -257,7 +255,7 @@ static int rk3568_set_drive(struct rockchip_pin_bank *bank,
 {
 	struct regmap *regmap;
 	int reg, ret;
-	u32 data, rmask;
+	u32 data;
 	u8 bit;
 	int drv = (1 << (strength + 1)) - 1;
 
@@ -265,10 +263,9 @@ static int rk3568_set_drive(struct rockchip_pin_bank *bank,
 
 	/* enable the write to the equivalent lower bits */
 	data = ((1 << RK3568_DRV_BITS_PER_PIN) - 1) << (bit + 16);
-	rmask = data | (data >> 16);
 	data |= (drv << bit);
 
-	ret = regmap_update_bits(regmap, reg, rmask, data);
+	ret = rockchip_pinctrl_write(bank, regmap, reg, data);
 	if (ret)
 		return ret;
 
@@ -291,10 +288,9 @@ static int rk3568_set_drive(struct rockchip_pin_bank *bank,
 		return 0;
 
 	data = ((1 << RK3568_DRV_BITS_PER_PIN) - 1) << 16;
-	rmask = data | (data >> 16);
 	data |= drv;
 
-	return regmap_update_bits(regmap, reg, rmask, data);
+	return rockchip_pinctrl_write(bank, regmap, reg, data);
 }
 
 static int rk3568_set_schmitt(struct rockchip_pin_bank *bank,
@@ -302,17 +298,16 @@ static int rk3568_set_schmitt(struct rockchip_pin_bank *bank,
 {
 	struct regmap *regmap;
 	int reg;
-	u32 data, rmask;
+	u32 data;
 	u8 bit;
 
 	rk3568_calc_schmitt_reg_and_bit(bank, pin_num, &regmap, &reg, &bit);
 
 	/* enable the write to the equivalent lower bits */
 	data = ((1 << RK3568_SCHMITT_BITS_PER_PIN) - 1) << (bit + 16);
-	rmask = data | (data >> 16);
 	data |= ((enable ? 0x2 : 0x1) << bit);
 
-	return regmap_update_bits(regmap, reg, rmask, data);
+	return rockchip_pinctrl_write(bank, regmap, reg, data);
 }
 static struct rockchip_pin_bank rk3568_pin_banks[] = {
 	PIN_BANK_IOMUX_FLAGS(0, 32, "gpio0", IOMUX_SOURCE_PMU | IOMUX_WIDTH_4BIT,
@@ -37,7 +37,7 @@ static int rk3576_set_mux(struct rockchip_pin_bank *bank, int pin, int mux)
 
 	debug("iomux write reg = %x data = %x\n", reg, data);
 
-	ret = regmap_write(regmap, reg, data);
+	ret = rockchip_pinctrl_write(bank, regmap, reg, data);
 
 	return ret;
 }
@@ -100,7 +100,7 @@ static int rk3576_set_drive(struct rockchip_pin_bank *bank,
 	/* enable the write to the equivalent lower bits */
 	data = ((1 << RK3576_DRV_BITS_PER_PIN) - 1) << (bit + 16);
 	data |= (drv << bit);
-	ret = regmap_write(regmap, reg, data);
+	ret = rockchip_pinctrl_write(bank, regmap, reg, data);
 
 	return ret;
 }
@@ -172,7 +172,7 @@ static int rk3576_set_pull(struct rockchip_pin_bank *bank,
 	data = ((1 << RK3576_PULL_BITS_PER_PIN) - 1) << (bit + 16);
 
 	data |= (ret << bit);
-	ret = regmap_write(regmap, reg, data);
+	ret = rockchip_pinctrl_write(bank, regmap, reg, data);
 
 	return ret;
 }
@@ -237,7 +237,7 @@ static int rk3576_set_schmitt(struct rockchip_pin_bank *bank,
 	/* enable the write to the equivalent lower bits */
 	data = ((1 << RK3576_SMT_BITS_PER_PIN) - 1) << (bit + 16);
 	data |= (enable << bit);
-	ret = regmap_write(regmap, reg, data);
+	ret = rockchip_pinctrl_write(bank, regmap, reg, data);
 
 	return ret;
 }
@@ -37,6 +37,66 @@ static int rockchip_verify_config(struct udevice *dev, u32 bank, u32 pin)
 	return 0;
 }
 
+static int rockchip_pinctrl_flush(struct rockchip_pinctrl_priv *priv)
+{
+	struct rockchip_pin_write *w;
+	int i, ret = 0;
+
+	for (i = 0; i < priv->nr_writes; i++) {
+		w = &priv->writes[i];
+		debug("pinctrl write reg = %x data = %x\n", w->reg, w->data);
+		if (regmap_write(w->regmap, w->reg, w->data) && !ret)
+			ret = -EIO;
+	}
+	priv->nr_writes = 0;
+
+	return ret;
+}
+
+/*
+ * Write a hiword-masked register: the upper 16 bits of @data select the
+ * bits of the lower 16 that are written. While a state is being applied,
+ * the writes to the same register are merged and only made at the end,
+ * so that a group of pins costs one write per register rather than one
+ * per pin and setting.
+ */
+int rockchip_pinctrl_write(struct rockchip_pin_bank *bank,
+			   struct regmap *regmap, u32 reg, u32 data)
+{
+	struct rockchip_pinctrl_priv *priv = bank->priv;
+	struct rockchip_pin_write *w;
+	u32 mask, old_mask;
+	int i, ret;
+
+	if (!priv->batch)
+		return regmap_write(regmap, reg, data);
+
+	for (i = 0; i < priv->nr_writes; i++) {
+		w = &priv->writes[i];
+		if (w->regmap != regmap || w->reg != reg)
+			continue;
+
+		mask = data >> 16;
+		old_mask = w->data >> 16;
+		w->data = ((old_mask | mask) << 16) |
+			  (w->data & old_mask & ~mask) | (data & mask);
+		return 0;
+	}
+
+	if (priv->nr_writes == ROCKCHIP_PIN_WRITES) {
+		ret = rockchip_pinctrl_flush(priv);
+		if (ret)
+			return ret;
+	}
+
+	w = &priv->writes[priv->nr_writes++];
+	w->regmap = regmap;
+	w->reg = reg;
+	w->data = data;
+
+	return 0;
+}
+
 void rockchip_get_recalced_mux(struct rockchip_pin_bank *bank, int pin,
 			       int *reg, u8 *bit, int *mask)
 {
@@ -231,13 +291,16 @@ static int rockchip_set_mux(struct rockchip_pin_bank *bank, int pin, int mux)
 			else
 				regmap = priv->regmap_base;
 
-			regmap_write(regmap, route_reg, route_val);
+			rockchip_pinctrl_write(bank, regmap, route_reg,
+					       route_val);
 			break;
 		case ROUTE_TYPE_TOPGRF:
-			regmap_write(priv->regmap_base, route_reg, route_val);
+			rockchip_pinctrl_write(bank, priv->regmap_base,
+					       route_reg, route_val);
 			break;
 		case ROUTE_TYPE_PMUGRF:
-			regmap_write(priv->regmap_pmu, route_reg, route_val);
+			rockchip_pinctrl_write(bank, priv->regmap_pmu,
+					       route_reg, route_val);
 			break;
 		case ROUTE_TYPE_INVALID: /* Fall through */
 		default:
@@ -387,6 +450,11 @@ static int rockchip_pinconf_set(struct rockchip_pin_bank *bank,
 	case PIN_CONFIG_OUTPUT:
 #if CONFIG_IS_ENABLED(DM_GPIO) && \
 	(CONFIG_IS_ENABLED(SPL_GPIO_SUPPORT) || !defined(CONFIG_SPL_BUILD))
+		/* The GPIO driver looks at the mux set so far */
+		rc = rockchip_pinctrl_flush(bank->priv);
+		if (rc)
+			return rc;
+
 		desc.flags = GPIOD_IS_OUT | GPIOD_IS_OUT_ACTIVE;
 		if (!arg) desc.flags |= GPIOD_ACTIVE_LOW;
 		snprintf(gpio_name, 16, "%s%d", bank->name, pin);
@@ -450,19 +518,19 @@ static int rockchip_pinconf_prop_name_to_param(const char *property,
 	return -EPERM;
 }
 
-static int rockchip_pinctrl_set_state(struct udevice *dev,
-				      struct udevice *config)
+struct rockchip_pinconf {
+	int param;
+	u32 arg;
+};
+
+/* Reads the settings of a pin configuration node, returns how many */
+static int rockchip_pinconf_parse(ofnode node, struct rockchip_pinconf *confs)
 {
-	struct rockchip_pinctrl_priv *priv = dev_get_priv(dev);
-	struct rockchip_pin_ctrl *ctrl = priv->ctrl;
-	u32 cells[MAX_ROCKCHIP_PINS_ENTRIES * 4];
-	u32 bank, pin, mux, conf, arg, default_val;
-	int ret, count, i;
+	u32 default_val;
 	const char *prop_name;
 	const void *value;
 	int prop_len, param;
-	const u32 *data;
-	ofnode node;
+	int count = 0;
 #if CONFIG_IS_ENABLED(OF_LIVE)
 	const struct device_node *np;
 	struct property *pp;
@@ -470,6 +538,53 @@ static int rockchip_pinctrl_set_state(struct udevice *dev,
 	int property_offset, pcfg_node;
 	const void *blob = gd->fdt_blob;
 #endif
+
+#if CONFIG_IS_ENABLED(OF_LIVE)
+	np = ofnode_to_np(node);
+	for (pp = np->properties; pp; pp = pp->next) {
+		prop_name = pp->name;
+		prop_len = pp->length;
+		value = pp->value;
+#else
+	pcfg_node = ofnode_to_offset(node);
+	fdt_for_each_property_offset(property_offset, blob, pcfg_node) {
+		value = fdt_getprop_by_offset(blob, property_offset,
+					      &prop_name, &prop_len);
+		if (!value)
+			return -ENOENT;
+#endif
+		param = rockchip_pinconf_prop_name_to_param(prop_name,
+							    &default_val);
+		if (param < 0)
+			break;
+
+		/* Each property is there once, and maps to one entry */
+		if (count == ARRAY_SIZE(rockchip_conf_params))
+			return -EINVAL;
+
+		confs[count].param = param;
+		if (prop_len >= sizeof(fdt32_t))
+			confs[count].arg = fdt32_to_cpu(*(fdt32_t *)value);
+		else
+			confs[count].arg = default_val;
+		count++;
+	}
+
+	return count;
+}
+
+static int rockchip_pinctrl_set_state(struct udevice *dev,
+				      struct udevice *config)
+{
+	struct rockchip_pinctrl_priv *priv = dev_get_priv(dev);
+	struct rockchip_pin_ctrl *ctrl = priv->ctrl;
+	struct rockchip_pinconf confs[ARRAY_SIZE(rockchip_conf_params)];
+	u32 cells[MAX_ROCKCHIP_PINS_ENTRIES * 4];
+	u32 bank, pin, mux, conf, last_conf = 0;
+	int ret, count, i, j, nr_confs = 0;
+	const u32 *data;
+	ofnode node;
+
 	data = dev_read_prop(config, "rockchip,pins", &count);
 	if (count < 0) {
 		debug("%s: bad array size %d\n", __func__, count);
@@ -486,6 +601,10 @@ static int rockchip_pinctrl_set_state(struct udevice *dev,
 	for (i = 0; i < count; i++)
 		cells[i] = fdt32_to_cpu(data[i]);
 
+	/* Hold the register writes back, see rockchip_pinctrl_write() */
+	priv->nr_writes = 0;
+	priv->batch = true;
+
 	for (i = 0; i < (count >> 2); i++) {
 		bank = cells[4 * i + 0];
 		pin = cells[4 * i + 1];
@@ -494,50 +613,50 @@ static int rockchip_pinctrl_set_state(struct udevice *dev,
 
 		ret = rockchip_verify_config(dev, bank, pin);
 		if (ret)
-			return ret;
+			goto out;
 
 		ret = rockchip_set_mux(&ctrl->pin_banks[bank], pin, mux);
 		if (ret)
-			return ret;
+			goto out;
 
-		node = ofnode_get_by_phandle(conf);
-		if (!ofnode_valid(node))
-			return -ENODEV;
-#if CONFIG_IS_ENABLED(OF_LIVE)
-		np = ofnode_to_np(node);
-		for (pp = np->properties; pp; pp = pp->next) {
-			prop_name = pp->name;
-			prop_len = pp->length;
-			value = pp->value;
-#else
-		pcfg_node = ofnode_to_offset(node);
-		fdt_for_each_property_offset(property_offset, blob, pcfg_node) {
-			value = fdt_getprop_by_offset(blob, property_offset,
-						      &prop_name, &prop_len);
-			if (!value)
-				return -ENOENT;
-#endif
-			param = rockchip_pinconf_prop_name_to_param(prop_name,
-								    &default_val);
-			if (param < 0)
-				break;
+		/*
+		 * The pins of a group mostly share their configuration node,
+		 * which is only looked up and read again when it changes.
+		 */
+		if (!last_conf || conf != last_conf) {
+			node = ofnode_get_by_phandle(conf);
+			if (!ofnode_valid(node)) {
+				ret = -ENODEV;
+				goto out;
+			}
 
-			if (prop_len >= sizeof(fdt32_t))
-				arg = fdt32_to_cpu(*(fdt32_t *)value);
-			else
-				arg = default_val;
+			nr_confs = rockchip_pinconf_parse(node, confs);
+			if (nr_confs < 0) {
+				ret = nr_confs;
+				goto out;
+			}
+			last_conf = conf;
+		}
 
+		for (j = 0; j < nr_confs; j++) {
 			ret = rockchip_pinconf_set(&ctrl->pin_banks[bank], pin,
-						   param, arg);
+						   confs[j].param,
+						   confs[j].arg);
 			if (ret) {
 				debug("%s: rockchip_pinconf_set fail: %d\n",
 				      __func__, ret);
-				return ret;
+				goto out;
 			}
 		}
 	}
 
-	return 0;
+	ret = 0;
+out:
+	/* Whatever was set before an error is still written, as it was */
+	priv->batch = false;
+	j = rockchip_pinctrl_flush(priv);
+
+	return ret ? ret : j;
 }
 
 static int rockchip_pinctrl_get_pins_count(struct udevice *dev)
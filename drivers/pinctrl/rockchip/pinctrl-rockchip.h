@@ -574,6 +574,21 @@ struct rockchip_pin_ctrl {
 			       int pin_num, int enable);
 };
 
+/* Register writes held back while a pinctrl state is applied */
+#define ROCKCHIP_PIN_WRITES		32
+
+/**
+ * struct rockchip_pin_write: pending write to a hiword-masked register
+ * @regmap: regmap of the register
+ * @reg: register offset
+ * @data: mask of the bits written in the upper 16 bits, values in the lower
+ */
+struct rockchip_pin_write {
+	struct regmap			*regmap;
+	u32				reg;
+	u32				data;
+};
+
 /**
  */
 struct rockchip_pinctrl_priv {
@@ -582,6 +597,9 @@ struct rockchip_pinctrl_priv {
 	struct regmap			*regmap_pmu;
 	struct regmap			*regmap_ioc1;
 	struct regmap			*regmap_rmio;
+	struct rockchip_pin_write	writes[ROCKCHIP_PIN_WRITES];
+	int				nr_writes;
+	bool				batch;
 };
 
 extern const struct pinctrl_ops rockchip_pinctrl_ops;
@@ -591,5 +609,7 @@ void rockchip_get_recalced_mux(struct rockchip_pin_bank *bank, int pin,
 int rockchip_get_mux_data(int mux_type, int pin, u8 *bit, int *mask);
 int rockchip_translate_drive_value(int type, int strength);
 int rockchip_translate_pull_value(int type, int pull);
+int rockchip_pinctrl_write(struct rockchip_pin_bank *bank,
+			   struct regmap *regmap, u32 reg, u32 data);
 
 #endif /* __DRIVERS_PINCTRL_ROCKCHIP_H */
@@ -8,6 +8,7 @@
 #include <common.h>
 #include <dm.h>
 #include <power/charge_display.h>
+#include <dm/uclass-internal.h>
 
 int charge_display_show(struct udevice *dev)
 {
@@ -24,6 +25,13 @@ int charge_display(void)
 	struct udevice *dev;
 	int ret;
 
+	/* Leave charging to the kernel, which sets the charger up again */
+	if (!uclass_find_first_device(UCLASS_CHARGE_DISPLAY, &dev) && dev &&
+	    device_probe_deferred(dev)) {
+		debug("Charge display deferred\n");
+		return 0;
+	}
+
 	ret = uclass_get_device(UCLASS_CHARGE_DISPLAY, 0, &dev);
 	if (ret) {
 		debug("Get charge display failed, ret=%d\n", ret);
@@ -39,6 +39,8 @@ DECLARE_GLOBAL_DATA_PTR;
 #define IMAGE_LOWPOWER_IDX(n)			((n) - 1)
 #define SYSTEM_SUSPEND_DELAY_MS			5000
 #define FUEL_GAUGE_POLL_MS			1000
+#define CHARGE_IDLE_MIN_MS			5
+#define CHARGE_IDLE_MAX_MS			100
 
 #define LED_CHARGING_NAME			"battery_charging"
 #define LED_CHARGING_FULL_NAME			"battery_full"
@@ -64,6 +66,11 @@ struct charge_animation_priv {
 	int auto_wakeup_key_state;
 	ulong auto_screen_off_timeout;	/* ms */
 	ulong suspend_delay_timeout;	/* ms */
+
+	bool timer_on;			/* auto wakeup timer installed */
+	bool idle;			/* timer reprogrammed by charge_idle() */
+	ulong wakeup_ms;		/* auto wakeup interval */
+	ulong wakeup_start;		/* last auto wakeup */
 };
 
 /*
@@ -298,7 +305,12 @@ static int system_suspend_enter(struct udevice *dev)
 }
 
 static void autowakeup_timer_init(struct udevice *dev, uint32_t seconds) {}
-static void autowakeup_timer_uninit(void) {}
+static void autowakeup_timer_uninit(struct udevice *dev) {}
+
+static void charge_idle(struct udevice *dev, ulong ms)
+{
+	mdelay(ms);
+}
 
 #else
 static int system_suspend_enter(struct udevice *dev)
@@ -366,6 +378,20 @@ static int system_suspend_enter(struct udevice *dev)
 	return 0;
 }
 
+static void autowakeup_timer_start(ulong ms)
+{
+	uint64_t period = 24000ULL * ms;
+
+	/* Disable before conifg */
+	writel(0, TIMER_BASE + TIMER_CTRL);
+
+	/* Config */
+	writel((uint32_t)period, TIMER_BASE + TIMER_LOAD_COUNT0);
+	writel((uint32_t)(period >> 32), TIMER_BASE + TIMER_LOAD_COUNT1);
+	writel(TIMER_CLR_INT, TIMER_BASE + TIMER_INTSTATUS);
+	writel(TIMER_EN | TIMER_INT_EN, TIMER_BASE + TIMER_CTRL);
+}
+
 static void autowake_timer_handler(int irq, void *data)
 {
 	struct udevice *dev = data;
@@ -374,34 +400,83 @@ static void autowake_timer_handler(int irq, void *data)
 
 	writel(TIMER_CLR_INT, TIMER_BASE + TIMER_INTSTATUS);
 
+	/* Just a wakeup from charge_idle(), which does the accounting */
+	if (priv->idle)
+		return;
+
+	/* Back to the full interval, charge_idle() may have shortened it */
+	autowakeup_timer_start(priv->wakeup_ms);
+	priv->wakeup_start = get_timer(0);
+
 	priv->auto_wakeup_key_state = KEY_PRESS_DOWN;
 	printf("auto wakeup count: %lld\n", ++count);
 }
 
 static void autowakeup_timer_init(struct udevice *dev, uint32_t seconds)
 {
-	uint64_t period = 24000000ULL * seconds;
-
-	/* Disable before conifg */
-	writel(0, TIMER_BASE + TIMER_CTRL);
+	struct charge_animation_priv *priv = dev_get_priv(dev);
 
-	/* Config */
-	writel((uint32_t)period, TIMER_BASE + TIMER_LOAD_COUNT0);
-	writel((uint32_t)(period >> 32), TIMER_BASE + TIMER_LOAD_COUNT1);
-	writel(TIMER_CLR_INT, TIMER_BASE + TIMER_INTSTATUS);
-	writel(TIMER_EN | TIMER_INT_EN, TIMER_BASE + TIMER_CTRL);
+	/* No auto wakeup, only charge_idle() uses the timer then */
+	priv->wakeup_ms = seconds * 1000UL;
+	priv->wakeup_start = get_timer(0);
+	if (priv->wakeup_ms)
+		autowakeup_timer_start(priv->wakeup_ms);
 
 	/* IRQ */
 	irq_install_handler(TIMER_IRQ, autowake_timer_handler, dev);
 	irq_handler_enable(TIMER_IRQ);
+	priv->timer_on = true;
 }
 
-static void autowakeup_timer_uninit(void)
+static void autowakeup_timer_uninit(struct udevice *dev)
 {
+	struct charge_animation_priv *priv = dev_get_priv(dev);
+
 	writel(0, TIMER_BASE + TIMER_CTRL);
 
 	irq_handler_disable(TIMER_IRQ);
 	irq_free_handler(TIMER_IRQ);
+	priv->timer_on = false;
+}
+
+/*
+ * Sleep in wfi for @ms instead of spinning. The auto wakeup timer is the
+ * only timer interrupt, so it is pointed at the end of the idle time, or
+ * at the auto wakeup if that comes first, and then put back.
+ */
+static void charge_idle(struct udevice *dev, ulong ms)
+{
+	struct charge_animation_priv *priv = dev_get_priv(dev);
+	ulong start = get_timer(0), elapsed;
+
+	if (!priv->timer_on) {
+		mdelay(ms);
+		return;
+	}
+
+	priv->idle = true;
+	if (priv->wakeup_ms) {
+		elapsed = min(get_timer(priv->wakeup_start), priv->wakeup_ms);
+		ms = max(min(ms, priv->wakeup_ms - elapsed), 1UL);
+	}
+	autowakeup_timer_start(ms);
+
+	/* Other interrupts, like the power key, wake up early too */
+	while (get_timer(start) < ms)
+		wfi();
+	priv->idle = false;
+
+	if (!priv->wakeup_ms) {
+		writel(0, TIMER_BASE + TIMER_CTRL);
+		return;
+	}
+
+	/* The auto wakeup is due, or else it gets the rest of its interval */
+	elapsed = get_timer(priv->wakeup_start);
+	if (elapsed >= priv->wakeup_ms)
+		autowake_timer_handler(TIMER_IRQ, dev);
+	else
+		autowakeup_timer_start(priv->wakeup_ms - elapsed);
 }
 #endif
 
@@ -415,9 +490,15 @@ static void charge_show_logo(void)
 {
 	rockchip_show_logo();
 }
+
+static void charge_preload_bmp(const char *name)
+{
+	rockchip_preload_bmp(name);
+}
 #else
 static void charge_show_bmp(const char *name) {}
 static void charge_show_logo(void) {}
+static void charge_preload_bmp(const char *name) {}
 #endif
 
 #ifdef CONFIG_LED
@@ -560,7 +641,7 @@ static int charge_extrem_low_power(struct udevice *dev)
 		}
 	}
 
-	autowakeup_timer_uninit();
+	autowakeup_timer_uninit(dev);
 
 	return 0;
 }
@@ -580,6 +661,7 @@ static int charge_animation_show(struct udevice *dev)
 	ulong ms = 0, sec = 0;
 	int start_idx = 0, show_idx = -1, old_show_idx = IMAGE_RECALC_IDX;
 	int soc, voltage, current, key_state;
+	ulong idle, elapsed;
 	int i, charging = 1, ret;
 	int boot_mode;
 	int first_poll_fg = 1;
@@ -678,11 +760,10 @@ static int charge_animation_show(struct udevice *dev)
 		charge_show_bmp(NULL);
 	}
 
-	/* Auto wakeup */
-	if (pdata->auto_wakeup_interval) {
+	/* Auto wakeup, the timer also wakes up charge_idle() */
+	if (pdata->auto_wakeup_interval)
 		printf("Auto wakeup: %dS\n", pdata->auto_wakeup_interval);
-		autowakeup_timer_init(dev, pdata->auto_wakeup_interval);
-	}
+	autowakeup_timer_init(dev, pdata->auto_wakeup_interval);
 
 /* Give a message warning when CONFIG_IRQ is not enabled */
 #ifdef CONFIG_IRQ
@@ -691,6 +772,10 @@ static int charge_animation_show(struct udevice *dev)
 	printf("Enter U-Boot charging mode(IRQ)\n");
 #endif
 
+	/* Decode all frames up front, showing one is then only a flip */
+	for (i = 0; i < image_num; i++)
+		charge_preload_bmp(image[i].name);
+
 	charge_start = get_timer(0);
 	delta = get_timer(0);
 
@@ -915,7 +1000,17 @@ show_images:
 			system_suspend_enter(dev);
 		}
 
-		mdelay(5);
+		/* Sleep until the next image or fuel gauge poll is due */
+		elapsed = get_timer(show_start);
+		idle = image[show_idx].period >= elapsed ?
+		       image[show_idx].period - elapsed + 1 : 0;
+		elapsed = get_timer(delta);
+		if (elapsed < FUEL_GAUGE_POLL_MS)
+			idle = min(idle, FUEL_GAUGE_POLL_MS - elapsed);
+		else
+			idle = 0;
+		charge_idle(dev, clamp_t(ulong, idle, CHARGE_IDLE_MIN_MS,
+					 CHARGE_IDLE_MAX_MS));
 
 		/* It's time to show next image ? */
 		if (get_timer(show_start) > image[show_idx].period) {
@@ -1014,8 +1109,7 @@ show_images:
 		}
 	}
 
-	if (pdata->auto_wakeup_interval)
-		autowakeup_timer_uninit();
+	autowakeup_timer_uninit(dev);
 
 	ms = get_timer(charge_start);
 	if (ms >= 1000) {
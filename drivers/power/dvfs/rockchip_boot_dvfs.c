@@ -0,0 +1,158 @@
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ *
+ * Boot performance policy: run the cpu at a high but safe OPP of the kernel
+ * dtb while U-Boot decompresses, hashes and sets the display up, instead of
+ * the rate the loader left it at. Software lzma/gzip and sha scale with the
+ * cpu clock.
+ *
+ * The OPP is the fastest one of the first cpu's operating-points-v2 which
+ * is not above CONFIG_ROCKCHIP_BOOT_DVFS_MAX_MHZ, does not depend on the
+ * chip version (opp-supported-hw) and whose voltage is within the table's
+ * "rockchip,max-volt". Its "opp-microvolt" is used, which is the highest of
+ * the leakage based voltages. The wide temperature dvfs policy is applied
+ * afterwards, so it still lowers the rate when it's hot.
+ */
+
+#include <common.h>
+#include <clk.h>
+#include <dm.h>
+#include <dvfs.h>
+#include <power/regulator.h>
+
+#define FDT_PATH_CPUS		"/cpus"
+
+static struct {
+	struct udevice *supply;
+	struct clk clk;
+	ulong org_hz;
+	int org_uv;
+	bool raised;
+} boot_dvfs;
+
+static int boot_dvfs_get_opp(ofnode cpu, u64 *hz, u32 *uv)
+{
+	ofnode opp_table, opp;
+	u32 phandle, volt, max_uv;
+	u64 rate;
+
+	if (ofnode_read_u32(cpu, "operating-points-v2", &phandle))
+		return -ENOENT;
+
+	opp_table = ofnode_get_by_phandle(phandle);
+	max_uv = ofnode_read_u32_default(opp_table, "rockchip,max-volt", ~0U);
+
+	*hz = 0;
+	ofnode_for_each_subnode(opp, opp_table) {
+		if (ofnode_read_bool(opp, "opp-supported-hw"))
+			continue;
+		if (ofnode_read_u64(opp, "opp-hz", &rate) ||
+		    ofnode_read_u32_array(opp, "opp-microvolt", &volt, 1))
+			continue;
+		if (rate > CONFIG_ROCKCHIP_BOOT_DVFS_MAX_MHZ * 1000000ULL ||
+		    volt > max_uv || rate <= *hz)
+			continue;
+		*hz = rate;
+		*uv = volt;
+	}
+
+	return *hz ? 0 : -ENOENT;
+}
+
+static int boot_dvfs_get_cpu(ofnode cpu)
+{
+	u32 phandle, clock[2];
+	ofnode supply;
+	int ret;
+
+	if (ofnode_read_u32(cpu, "cpu-supply", &phandle))
+		return -ENOENT;
+	supply = ofnode_get_by_phandle(phandle);
+	ret = regulator_get_by_devname(ofnode_get_name(supply),
+				       &boot_dvfs.supply);
+	if (ret)
+		return ret;
+
+	if (ofnode_read_u32_array(cpu, "clocks", clock, ARRAY_SIZE(clock)))
+		return -ENOENT;
+	ret = uclass_get_device_by_ofnode(UCLASS_CLK,
+					  ofnode_get_by_phandle(clock[0]),
+					  &boot_dvfs.clk.dev);
+	if (ret)
+		return ret;
+	boot_dvfs.clk.id = clock[1];
+
+	return 0;
+}
+
+int boot_dvfs_raise(void)
+{
+	const char *name;
+	ofnode cpus, cpu;
+	u64 hz;
+	u32 uv;
+	int ret;
+
+	cpus = ofnode_path(FDT_PATH_CPUS);
+	ofnode_for_each_subnode(cpu, cpus) {
+		name = ofnode_read_string(cpu, "device_type");
+		if (name && !strcmp(name, "cpu"))
+			break;
+	}
+	if (!ofnode_valid(cpu))
+		return -ENODEV;
+
+	ret = boot_dvfs_get_opp(cpu, &hz, &uv);
+	if (ret)
+		return ret;
+
+	ret = boot_dvfs_get_cpu(cpu);
+	if (ret) {
+		debug("DVFS: boot: no cpu clock or supply, ret=%d\n", ret);
+		return ret;
+	}
+
+	boot_dvfs.org_hz = clk_get_rate(&boot_dvfs.clk);
+	boot_dvfs.org_uv = regulator_get_value(boot_dvfs.supply);
+	if (IS_ERR_VALUE(boot_dvfs.org_hz) || boot_dvfs.org_uv < 0)
+		return -EINVAL;
+	if (boot_dvfs.org_hz >= hz)
+		return 0;
+
+	/* voltage up first, then rate */
+	if (uv > boot_dvfs.org_uv) {
+		ret = regulator_set_value(boot_dvfs.supply, uv);
+		if (ret) {
+			printf("DVFS: boot: set %d uV failed, ret=%d\n", uv, ret);
+			return ret;
+		}
+	}
+
+	ret = clk_set_rate(&boot_dvfs.clk, hz);
+	if (IS_ERR_VALUE((ulong)ret)) {
+		printf("DVFS: boot: set %lld Hz failed, ret=%d\n", hz, ret);
+		regulator_set_value(boot_dvfs.supply, boot_dvfs.org_uv);
+		return ret;
+	}
+	boot_dvfs.raised = true;
+
+	printf("DVFS: boot: cpu %ld->%ld Hz, %d->%d uV\n", boot_dvfs.org_hz,
+	       clk_get_rate(&boot_dvfs.clk), boot_dvfs.org_uv,
+	       regulator_get_value(boot_dvfs.supply));
+
+	return 0;
+}
+
+void boot_dvfs_restore(void)
+{
+	if (!boot_dvfs.raised)
+		return;
+
+	/* rate down first, then voltage */
+	clk_set_rate(&boot_dvfs.clk, boot_dvfs.org_hz);
+	if (regulator_get_value(boot_dvfs.supply) > boot_dvfs.org_uv)
+		regulator_set_value(boot_dvfs.supply, boot_dvfs.org_uv);
+	boot_dvfs.raised = false;
+}
@@ -6,6 +6,7 @@
 #include <common.h>
 #include <console.h>
 #include <io-domain.h>
+#include <dm/device-internal.h>
 
 int io_domain_init(void)
 {
@@ -17,16 +18,40 @@ int io_domain_init(void)
 	if (ret)
 		return ret;
 
-	for (uclass_first_device(UCLASS_IO_DOMAIN, &dev);
-	     dev;
-	     uclass_next_device(&dev))
-		;
+	uclass_foreach_dev(dev, uc) {
+		if (device_probe_deferred(dev))
+			continue;
+		device_probe(dev);
+	}
 
 	printf("io-domain: OK\n");
 
 	return 0;
 }
 
+int io_domain_supply_changed(struct udevice *reg, int uV)
+{
+	const struct dm_io_domain_ops *ops;
+	struct udevice *dev;
+	struct uclass *uc;
+	int ret;
+
+	ret = uclass_get(UCLASS_IO_DOMAIN, &uc);
+	if (ret)
+		return ret;
+
+	uclass_foreach_dev(dev, uc) {
+		ops = dev_get_driver_ops(dev);
+		if (!device_active(dev) || !ops || !ops->supply_changed)
+			continue;
+		ret = ops->supply_changed(dev, reg, uV);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
 UCLASS_DRIVER(io_domain) = {
 	.id		= UCLASS_IO_DOMAIN,
 	.name		= "io_domain",
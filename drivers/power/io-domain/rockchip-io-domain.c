@@ -5,6 +5,7 @@
 
 #include <common.h>
 #include <dm.h>
+#include <io-domain.h>
 #include <dm/of_access.h>
 #include <regmap.h>
 #include <syscon.h>
@@ -660,6 +661,27 @@ static int rockchip_iodomain_probe(struct udevice *dev)
 	return 0;
 }
 
+static int rockchip_iodomain_supply_changed(struct udevice *dev,
+					    struct udevice *reg, int uV)
+{
+	struct rockchip_iodomain_priv *priv = dev_get_priv(dev);
+	int i, ret;
+
+	for (i = 0; i < MAX_SUPPLIES; i++) {
+		if (priv->supplies[i].reg != reg)
+			continue;
+		ret = priv->write(&priv->supplies[i], uV);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+static const struct dm_io_domain_ops rockchip_iodomain_ops = {
+	.supply_changed = rockchip_iodomain_supply_changed,
+};
+
 static const struct udevice_id rockchip_iodomain_match[] = {
 	{
 		.compatible = "rockchip,px30-io-voltage-domain",
@@ -732,6 +754,7 @@ U_BOOT_DRIVER(io_domain) = {
 	.name		= "io_domain",
 	.id		= UCLASS_IO_DOMAIN,
 	.of_match	= rockchip_iodomain_match,
+	.ops		= &rockchip_iodomain_ops,
 	.priv_auto_alloc_size = sizeof(struct rockchip_iodomain_priv),
 	.ofdata_to_platdata	= rockchip_ofdata_to_platdata,
 	.probe		= rockchip_iodomain_probe,
@@ -242,16 +242,184 @@ static int rk8xx_reg_count(struct udevice *dev)
 	}
 }
 
+#ifdef CONFIG_PMIC_RK8XX_REG_CACHE
+/* Registers @min to @max, a list of them ends with an empty entry */
+struct rk8xx_reg_range {
+	u8 min;
+	u8 max;
+};
+
+/*
+ * The registers which are cached: the voltage, mode and sleep settings of
+ * the regulators, which only software changes. The enable registers of the
+ * rails are not, some of them have write-mask bits, nor is anything the
+ * hardware updates (status, interrupts, charger and fuel gauge).
+ */
+static const struct rk8xx_reg_range rk805_cache_ranges[] = {
+	{ RK816_REG_DCDC_SLP_EN, RK816_REG_LDO_SLP_EN },
+	{ REG_BUCK1_CONFIG, REG_LDO6_SLP_VSEL },
+	{ }
+};
+
+static const struct rk8xx_reg_range rk808_cache_ranges[] = {
+	{ REG_SLEEP_SET_OFF1, REG_SLEEP_SET_OFF2 },
+	{ REG_BUCK1_CONFIG, REG_LDO8_SLP_VSEL },
+	{ REG_DCDC_ILMAX, REG_DCDC_ILMAX },
+	{ }
+};
+
+static const struct rk8xx_reg_range rk817_cache_ranges[] = {
+	{ 0xb5, 0xb6 },		/* POWER_SLP_EN0..1 */
+	{ 0xba, RK817_BUCK4_CMIN },	/* BUCK1..4 config and vsel */
+	{ 0xcc, 0xdf },		/* LDO1..9 vsel, BUCK5 config */
+	{ }
+};
+
+static const struct rk8xx_reg_range rk806_cache_ranges[] = {
+	{ RK806_BUCK_SUSPEND_EN, RK806_PLDO_SUSPEND_EN },
+	{ RK806_BUCK_CONFIG(1), RK806_BUCK_SLP_VSEL(10) },
+	{ RK806_NLDO_ON_VSEL(1), RK806_PLDO_SLP_VSEL(6) },
+	{ RK806_RAMP_RATE_REG9_10, RK806_RAMP_RATE_REG1_8 },
+	{ }
+};
+
+/* Fill the cache with one read per range, once the variant is known */
+static void rk8xx_cache_init(struct udevice *dev)
+{
+	struct rk8xx_priv *priv = dev_get_priv(dev);
+	const struct rk8xx_reg_range *range;
+	int i, ret;
+
+	switch (priv->variant) {
+	case RK805_ID:
+	case RK816_ID:
+		range = rk805_cache_ranges;
+		break;
+	case RK808_ID:
+	case RK818_ID:
+		range = rk808_cache_ranges;
+		break;
+	case RK809_ID:
+	case RK817_ID:
+		range = rk817_cache_ranges;
+		break;
+	case RK806_ID:
+		range = rk806_cache_ranges;
+		break;
+	default:
+		return;
+	}
+
+	for (; range->max; range++) {
+		ret = dm_i2c_read(dev, range->min, &priv->reg_cache[range->min],
+				  range->max - range->min + 1);
+		for (i = range->min; i <= range->max; i++) {
+			__set_bit(i, priv->cache_mask);
+			if (!ret)
+				__set_bit(i, priv->cache_valid);
+		}
+	}
+}
+
+/* Copy registers from the cache, if all of them are in it */
+static bool rk8xx_cache_read(struct udevice *dev, uint reg, uint8_t *buff,
+			     int len)
+{
+	struct rk8xx_priv *priv = dev_get_priv(dev);
+	int i;
+
+	if (reg + len > RK8XX_CACHE_REGS)
+		return false;
+	for (i = 0; i < len; i++)
+		if (!test_bit(reg + i, priv->cache_valid))
+			return false;
+	memcpy(buff, &priv->reg_cache[reg], len);
+
+	return true;
+}
+
+/* Whether writing @buff would leave the registers as they are */
+static bool rk8xx_cache_same(struct udevice *dev, uint reg,
+			     const uint8_t *buff, int len)
+{
+	struct rk8xx_priv *priv = dev_get_priv(dev);
+	int i;
+
+	if (reg + len > RK8XX_CACHE_REGS)
+		return false;
+	for (i = 0; i < len; i++)
+		if (!test_bit(reg + i, priv->cache_valid) ||
+		    priv->reg_cache[reg + i] != buff[i])
+			return false;
+
+	return true;
+}
+
+static void rk8xx_cache_update(struct udevice *dev, uint reg,
+			       const uint8_t *buff, int len)
+{
+	struct rk8xx_priv *priv = dev_get_priv(dev);
+	int i;
+
+	for (i = 0; i < len && reg + i < RK8XX_CACHE_REGS; i++) {
+		if (!test_bit(reg + i, priv->cache_mask))
+			continue;
+		priv->reg_cache[reg + i] = buff[i];
+		__set_bit(reg + i, priv->cache_valid);
+	}
+}
+
+/* After a failed write the registers may hold either value */
+static void rk8xx_cache_drop(struct udevice *dev, uint reg, int len)
+{
+	struct rk8xx_priv *priv = dev_get_priv(dev);
+	int i;
+
+	for (i = 0; i < len && reg + i < RK8XX_CACHE_REGS; i++)
+		__clear_bit(reg + i, priv->cache_valid);
+}
+#else
+static inline void rk8xx_cache_init(struct udevice *dev)
+{
+}
+
+static inline bool rk8xx_cache_read(struct udevice *dev, uint reg,
+				    uint8_t *buff, int len)
+{
+	return false;
+}
+
+static inline bool rk8xx_cache_same(struct udevice *dev, uint reg,
+				    const uint8_t *buff, int len)
+{
+	return false;
+}
+
+static inline void rk8xx_cache_update(struct udevice *dev, uint reg,
+				      const uint8_t *buff, int len)
+{
+}
+
+static inline void rk8xx_cache_drop(struct udevice *dev, uint reg, int len)
+{
+}
+#endif
+
 static int rk8xx_write(struct udevice *dev, uint reg, const uint8_t *buff,
 			  int len)
 {
 	int ret;
 
+	if (rk8xx_cache_same(dev, reg, buff, len))
+		return 0;
+
 	ret = dm_i2c_write(dev, reg, buff, len);
 	if (ret) {
+		rk8xx_cache_drop(dev, reg, len);
 		printf("%s: write reg 0x%02x failed, ret=%d\n", __func__, reg, ret);
 		return ret;
 	}
+	rk8xx_cache_update(dev, reg, buff, len);
 
 	return 0;
 }
@@ -260,11 +428,15 @@ static int rk8xx_read(struct udevice *dev, uint reg, uint8_t *buff, int len)
 {
 	int ret;
 
+	if (rk8xx_cache_read(dev, reg, buff, len))
+		return 0;
+
 	ret = dm_i2c_read(dev, reg, buff, len);
 	if (ret) {
 		printf("%s: read reg 0x%02x failed, ret=%d\n", __func__, reg, ret);
 		return ret;
 	}
+	rk8xx_cache_update(dev, reg, buff, len);
 
 	return 0;
 }
@@ -669,6 +841,7 @@ static int rk8xx_probe(struct udevice *dev)
 
 	priv->variant = ((msb << 8) | lsb) & RK8XX_ID_MSK;
 	show_variant = priv->variant;
+	rk8xx_cache_init(dev);
 	switch (priv->variant) {
 	case RK806_ID:
 		on_source = RK806_ON_SOURCE;
@@ -125,8 +125,8 @@ static int fixed_regulator_set_enable(struct udevice *dev, bool enable)
 		return ret;
 	}
 
-	if (enable && dev_pdata->startup_delay_us)
-		udelay(dev_pdata->startup_delay_us);
+	if (enable)
+		regulator_delay(dev, dev_pdata->startup_delay_us);
 	debug("%s: done\n", __func__);
 
 	return 0;
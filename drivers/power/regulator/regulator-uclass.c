@@ -14,6 +14,47 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/**
+ * struct regulator_uc_priv - regulator uclass state
+ *
+ * @batch:	regulators_enable_boot_on() is running, regulator_delay()
+ *		only records when the outputs settle
+ * @settle_at:	timer_get_us() time all outputs are stable at
+ */
+struct regulator_uc_priv {
+	bool batch;
+	ulong settle_at;
+};
+
+void regulator_delay(struct udevice *dev, uint us)
+{
+	struct dm_regulator_uclass_platdata *uc_pdata;
+	struct regulator_uc_priv *uc_priv = dev->uclass->priv;
+	ulong end;
+
+	if (!us)
+		return;
+	if (!IS_ENABLED(CONFIG_DM_REGULATOR_BATCH_DELAY) || !uc_priv->batch) {
+		udelay(us);
+		return;
+	}
+
+	uc_pdata = dev_get_uclass_platdata(dev);
+	end = timer_get_us() + us;
+	if (time_after(end, uc_pdata->settle_at))
+		uc_pdata->settle_at = end;
+	if (time_after(end, uc_priv->settle_at))
+		uc_priv->settle_at = end;
+}
+
+static void regulator_wait_until(ulong end)
+{
+	long us = (long)(end - timer_get_us());
+
+	if (us > 0)
+		udelay(us);
+}
+
 int regulator_mode(struct udevice *dev, struct dm_regulator_mode **modep)
 {
 	struct dm_regulator_uclass_platdata *uc_pdata;
@@ -66,7 +107,7 @@ int regulator_set_value(struct udevice *dev, int uV)
 
 	if (!ret && (old_uV != -ENODATA) && (old_uV != uV)) {
 		us = DIV_ROUND_UP(abs(uV - old_uV), uc_pdata->ramp_delay);
-		udelay(us);
+		regulator_delay(dev, us);
 		debug("%s: ramp=%d, old_uV=%d, uV=%d, us=%d\n",
 		      uc_pdata->name, uc_pdata->ramp_delay, old_uV, uV, us);
 	}
@@ -244,6 +285,22 @@ int device_get_supply_regulator(struct udevice *dev, const char *supply_name,
 					    supply_name, devp);
 }
 
+/* Let the supply of a regulator settle before the regulator is enabled */
+static void regulator_wait_supply(struct udevice *dev)
+{
+	struct dm_regulator_uclass_platdata *uc_pdata;
+	struct regulator_uc_priv *uc_priv = dev->uclass->priv;
+	struct udevice *supply;
+
+	if (!IS_ENABLED(CONFIG_DM_REGULATOR_BATCH_DELAY) || !uc_priv->batch)
+		return;
+	if (device_get_supply_regulator(dev, "vin-supply", &supply))
+		return;
+
+	uc_pdata = dev_get_uclass_platdata(supply);
+	regulator_wait_until(uc_pdata->settle_at);
+}
+
 static int regulator_init_suspend(struct udevice *dev)
 {
 	struct dm_regulator_uclass_platdata *uc_pdata;
@@ -295,8 +352,10 @@ int regulator_autoset(struct udevice *dev)
 	if (!ret && (uc_pdata->flags & REGULATOR_FLAG_AUTOSET_UA))
 		ret = regulator_set_current(dev, uc_pdata->min_uA);
 
-	if (!ret)
+	if (!ret) {
+		regulator_wait_supply(dev);
 		ret = regulator_set_enable(dev, true);
+	}
 
 	return ret;
 }
@@ -500,6 +559,7 @@ int regulators_enable_state_mem(bool verbose)
 
 int regulators_enable_boot_on(bool verbose)
 {
+	struct regulator_uc_priv *uc_priv;
 	struct udevice *dev;
 	struct uclass *uc;
 	int ret;
@@ -507,6 +567,10 @@ int regulators_enable_boot_on(bool verbose)
 	ret = uclass_get(UCLASS_REGULATOR, &uc);
 	if (ret)
 		return ret;
+
+	uc_priv = uc->priv;
+	uc_priv->batch = true;
+	uc_priv->settle_at = timer_get_us();
 	for (uclass_first_device(UCLASS_REGULATOR, &dev);
 	     dev;
 	     uclass_next_device(&dev)) {
@@ -520,6 +584,10 @@ int regulators_enable_boot_on(bool verbose)
 			ret = 0;
 	}
 
+	/* One wait for the slowest rail */
+	regulator_wait_until(uc_priv->settle_at);
+	uc_priv->batch = false;
+
 	return ret;
 }
 
@@ -528,6 +596,7 @@ UCLASS_DRIVER(regulator) = {
 	.name		= "regulator",
 	.post_bind	= regulator_post_bind,
 	.pre_probe	= regulator_pre_probe,
+	.priv_auto_alloc_size = sizeof(struct regulator_uc_priv),
 	.per_device_platdata_auto_alloc_size =
 				sizeof(struct dm_regulator_uclass_platdata),
 };
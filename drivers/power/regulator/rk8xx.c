@@ -925,9 +925,6 @@ static int _ldo_set_enable(struct udevice *pmic, int ldo, bool enable)
 		break;
 	}
 
-	if (enable)
-		udelay(500);
-
 	return ret;
 }
 
@@ -1212,8 +1209,13 @@ static int ldo_get_suspend_value(struct udevice *dev)
 static int ldo_set_enable(struct udevice *dev, bool enable)
 {
 	int ldo = dev->driver_data - 1;
+	int ret;
 
-	return _ldo_set_enable(dev->parent, ldo, enable);
+	ret = _ldo_set_enable(dev->parent, ldo, enable);
+	if (!ret && enable)
+		regulator_delay(dev, 500);
+
+	return ret;
 }
 
 static int ldo_set_suspend_enable(struct udevice *dev, bool enable)
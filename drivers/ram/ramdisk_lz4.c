@@ -0,0 +1,225 @@
+// SPDX-License-Identifier:     GPL-2.0+
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * Read only ramdisk whose image is kept LZ4 compressed in memory, as
+ * chunks that are compressed on their own, and decompressed as they are
+ * read. See struct ramdisk_lz4_header for the layout.
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <div64.h>
+#include <malloc.h>
+#include <ramdisk.h>
+#include <dm/device-internal.h>
+#include <u-boot/lz4.h>
+
+#define RAMDISK_LZ4_CACHE	CONFIG_RAMDISK_LZ4_CACHE_CHUNKS
+
+struct ramdisk_lz4_priv {
+	const struct ramdisk_lz4_header *hdr;
+	u64 size;
+	u32 chunk_size;
+	u32 chunks;
+	/* The last chunks read in part, most recently used first */
+	struct {
+		u32 chunk;
+		void *buf;
+	} cache[RAMDISK_LZ4_CACHE];
+	int cached;
+};
+
+static u32 ramdisk_lz4_chunk_len(struct ramdisk_lz4_priv *priv, u32 chunk)
+{
+	u64 left = priv->size - (u64)chunk * priv->chunk_size;
+
+	return min_t(u64, left, priv->chunk_size);
+}
+
+static int ramdisk_lz4_decode(struct ramdisk_lz4_priv *priv, u32 chunk,
+			      void *dst)
+{
+	const struct ramdisk_lz4_header *hdr = priv->hdr;
+	u32 start = le32_to_cpu(hdr->offset[chunk]);
+	u32 end = le32_to_cpu(hdr->offset[chunk + 1]);
+	u32 len = ramdisk_lz4_chunk_len(priv, chunk);
+	const char *src = (const char *)hdr + start;
+
+	/* Chunks that do not get smaller are stored as they are */
+	if (end - start == len) {
+		memcpy(dst, src, len);
+		return 0;
+	}
+
+	if (LZ4_decompress_safe(src, dst, end - start, len) != (int)len) {
+		printf("ramdisk-lz4: chunk %u is corrupted\n", chunk);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+/* Returns the chunk from the cache, decompressing it if need be */
+static void *ramdisk_lz4_get(struct ramdisk_lz4_priv *priv, u32 chunk)
+{
+	void *buf;
+	int i;
+
+	for (i = 0; i < priv->cached; i++) {
+		if (priv->cache[i].chunk == chunk)
+			break;
+	}
+
+	if (i == priv->cached) {
+		/* Not cached: take a free slot or the least recently used */
+		if (priv->cached < RAMDISK_LZ4_CACHE) {
+			priv->cache[i].buf = malloc(priv->chunk_size);
+			if (!priv->cache[i].buf)
+				return NULL;
+			priv->cached++;
+		} else {
+			i--;
+		}
+		priv->cache[i].chunk = chunk;
+		if (ramdisk_lz4_decode(priv, chunk, priv->cache[i].buf)) {
+			priv->cache[i].chunk = U32_MAX;
+			return NULL;
+		}
+	}
+
+	/* Move it to the front */
+	buf = priv->cache[i].buf;
+	for (; i > 0; i--)
+		priv->cache[i] = priv->cache[i - 1];
+	priv->cache[0].chunk = chunk;
+	priv->cache[0].buf = buf;
+
+	return buf;
+}
+
+static ulong ramdisk_lz4_bread(struct blk_desc *desc, lbaint_t start,
+			       lbaint_t blkcnt, void *dst)
+{
+	struct ramdisk_lz4_priv *priv = dev_get_priv(desc->bdev->parent);
+	u64 off = (u64)start * desc->blksz;
+	u64 len = (u64)blkcnt * desc->blksz;
+	u32 chunk, chunk_off, chunk_len, n;
+	void *buf;
+
+	if (start + blkcnt > desc->lba)
+		return -EINVAL;
+
+	while (len) {
+		chunk_off = do_div(off, priv->chunk_size);
+		chunk = off;
+		chunk_len = ramdisk_lz4_chunk_len(priv, chunk);
+		n = min_t(u64, len, chunk_len - chunk_off);
+
+		if (!chunk_off && n == chunk_len) {
+			/* Whole chunks go straight to the caller */
+			if (ramdisk_lz4_decode(priv, chunk, dst))
+				return -EIO;
+		} else {
+			buf = ramdisk_lz4_get(priv, chunk);
+			if (!buf)
+				return -EIO;
+			memcpy(dst, buf + chunk_off, n);
+		}
+
+		off = (u64)chunk * priv->chunk_size + chunk_off + n;
+		dst += n;
+		len -= n;
+	}
+
+	return blkcnt;
+}
+
+static int ramdisk_lz4_bind(struct udevice *dev)
+{
+	struct udevice *bdev;
+	int ret;
+
+	ret = blk_create_devicef(dev, "ramdisk_blk", "blk",
+				 IF_TYPE_RAMDISK, -1, 512, 0, &bdev);
+	if (ret) {
+		debug("Can't create block device\n");
+		return ret;
+	}
+
+	return 0;
+}
+
+static int ramdisk_lz4_probe(struct udevice *dev)
+{
+	struct ramdisk_lz4_priv *priv = dev_get_priv(dev);
+	const struct ramdisk_lz4_header *hdr;
+	struct blk_desc *desc;
+	struct udevice *bdev;
+	fdt_addr_t addr;
+	fdt_size_t size;
+	u32 chunks;
+
+	addr = dev_read_addr_size(dev, "reg", &size);
+	if (addr == FDT_ADDR_T_NONE)
+		return -EINVAL;
+
+	hdr = (const struct ramdisk_lz4_header *)addr;
+	if (le32_to_cpu(hdr->magic) != RAMDISK_LZ4_MAGIC) {
+		printf("ramdisk-lz4: no image at 0x%lx\n", (ulong)addr);
+		return -ENOENT;
+	}
+
+	priv->hdr = hdr;
+	priv->size = le64_to_cpu(hdr->size);
+	priv->chunk_size = le32_to_cpu(hdr->chunk_size);
+	priv->chunks = le32_to_cpu(hdr->chunks);
+
+	chunks = DIV_ROUND_UP_ULL(priv->size, priv->chunk_size ? : 1);
+	if (!priv->chunk_size || chunks != priv->chunks ||
+	    le32_to_cpu(hdr->offset[chunks]) > size) {
+		printf("ramdisk-lz4: bad image header\n");
+		return -EINVAL;
+	}
+
+	device_find_first_child(dev, &bdev);
+	if (!bdev)
+		return -ENODEV;
+
+	desc = dev_get_uclass_platdata(bdev);
+	desc->lba = lldiv(priv->size, desc->blksz);
+
+	return 0;
+}
+
+static int ramdisk_lz4_remove(struct udevice *dev)
+{
+	struct ramdisk_lz4_priv *priv = dev_get_priv(dev);
+	int i;
+
+	for (i = 0; i < priv->cached; i++)
+		free(priv->cache[i].buf);
+	priv->cached = 0;
+
+	return 0;
+}
+
+static const struct ramdisk_ops ramdisk_lz4_ops = {
+	.read = ramdisk_lz4_bread,
+};
+
+static const struct udevice_id ramdisk_lz4_ids[] = {
+	{ .compatible = "rockchip,ramdisk-lz4" },
+	{ }
+};
+
+U_BOOT_DRIVER(ramdisk_lz4) = {
+	.name		= "ramdisk-lz4",
+	.id		= UCLASS_RAMDISK,
+	.ops		= &ramdisk_lz4_ops,
+	.of_match	= ramdisk_lz4_ids,
+	.bind		= ramdisk_lz4_bind,
+	.probe		= ramdisk_lz4_probe,
+	.remove		= ramdisk_lz4_remove,
+	.priv_auto_alloc_size = sizeof(struct ramdisk_lz4_priv),
+};
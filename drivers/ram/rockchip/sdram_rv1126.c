@@ -2090,6 +2090,238 @@ static void save_rw_trn_result_to_ddr(struct rw_trn_result *result)
 }
 #endif
 
+#if defined(CONFIG_ROCKCHIP_SDRAM_TRN_CACHE)
+/*
+ * Results of high_freq_training() kept in DRAM across a reboot, so that a
+ * later boot on the same board can load them back into the PHY and only
+ * run the read gate training. Each fsp is checked with a pattern test
+ * after it is restored, anything that fails goes through the full training.
+ */
+#define TRN_CACHE_MAGIC		(0x4e525444)	/* "DTRN" */
+#define TRN_CACHE_VERSION	(1)
+
+struct trn_cache_fsp {
+	u32 freq_mhz;
+	u32 vref_dq[2];
+	u8 ca_dif;
+	u8 ca_sig;
+	u8 wrlvl[4];
+	u8 dq_deskew[16][11];
+	u8 prebit[4][ARRAY_SIZE(dq_sel)][2];
+};
+
+struct trn_cache {
+	u32 magic;
+	u32 version;
+	u32 size;
+	/* of common_info and the detected dram, a change of either is a miss */
+	u32 dram_sum;
+	struct trn_cache_fsp fsp[MAX_IDX];
+	u32 sum;
+};
+
+static struct trn_cache trn_cache;
+static u32 trn_cache_valid;
+static u32 trn_cache_dirty;
+static u32 trn_cache_failed;
+
+static u32 trn_cache_sum(const void *buf, u32 len, u32 sum)
+{
+	const u8 *p = buf;
+
+	while (len--)
+		sum = ((sum << 5) | (sum >> 27)) ^ *p++;
+
+	return sum;
+}
+
+static u32 trn_cache_dram_sum(struct rv1126_sdram_params *sdram_params)
+{
+	u32 sum;
+
+	sum = trn_cache_sum(common_info, sizeof(common_info), 0);
+	sum = trn_cache_sum(&sdram_params->base.dramtype,
+			    sizeof(sdram_params->base.dramtype), sum);
+
+	return trn_cache_sum(&sdram_params->ch.cap_info,
+			     sizeof(sdram_params->ch.cap_info), sum);
+}
+
+static void trn_cache_load(struct rv1126_sdram_params *sdram_params)
+{
+	u32 dram_sum = trn_cache_dram_sum(sdram_params);
+
+	memcpy(&trn_cache, (void *)CONFIG_ROCKCHIP_SDRAM_TRN_CACHE_ADDR,
+	       sizeof(trn_cache));
+	trn_cache_valid = trn_cache.magic == TRN_CACHE_MAGIC &&
+			  trn_cache.version == TRN_CACHE_VERSION &&
+			  trn_cache.size == sizeof(trn_cache) &&
+			  trn_cache.dram_sum == dram_sum &&
+			  trn_cache.sum == trn_cache_sum(&trn_cache,
+					offsetof(struct trn_cache, sum), 0);
+	if (!trn_cache_valid) {
+		memset(&trn_cache, 0, sizeof(trn_cache));
+		trn_cache.dram_sum = dram_sum;
+	}
+	trn_cache_dirty = 0;
+	trn_cache_failed = 0;
+}
+
+/* Write the cache back if a fsp was trained and none of them failed */
+static void trn_cache_store(void)
+{
+	if (!trn_cache_dirty || trn_cache_failed)
+		return;
+
+	trn_cache.magic = TRN_CACHE_MAGIC;
+	trn_cache.version = TRN_CACHE_VERSION;
+	trn_cache.size = sizeof(trn_cache);
+	trn_cache.sum = trn_cache_sum(&trn_cache,
+				      offsetof(struct trn_cache, sum), 0);
+	memcpy((void *)CONFIG_ROCKCHIP_SDRAM_TRN_CACHE_ADDR, &trn_cache,
+	       sizeof(trn_cache));
+}
+
+/* Drop the cache, the next boot trains in full */
+static void trn_cache_invalidate(void)
+{
+	trn_cache_valid = 0;
+	writel(0, CONFIG_ROCKCHIP_SDRAM_TRN_CACHE_ADDR);
+}
+
+static void trn_cache_save_fsp(struct dram_info *dram,
+			       struct rv1126_sdram_params *sdram_params,
+			       u32 fsp)
+{
+	struct trn_cache_fsp *c = &trn_cache.fsp[fsp];
+	void __iomem *phy_base = dram->phy;
+	u32 i, j;
+
+	c->freq_mhz = sdram_params->base.ddr_freq;
+	c->vref_dq[0] = fsp_param[fsp].vref_dq[0];
+	c->vref_dq[1] = fsp_param[fsp].vref_dq[1];
+	c->ca_dif = readl(PHY_REG(phy_base, 0x150 + 0x17));
+	c->ca_sig = readl(PHY_REG(phy_base, 0x150 + 0x0));
+	c->wrlvl[0] = readl(PHY_REG(phy_base, 0x233));
+	c->wrlvl[1] = readl(PHY_REG(phy_base, 0x237));
+	c->wrlvl[2] = readl(PHY_REG(phy_base, 0x2b3));
+	c->wrlvl[3] = readl(PHY_REG(phy_base, 0x2b7));
+	for (j = 0; j < ARRAY_SIZE(dqs_dq_skew_adr); j++)
+		for (i = 0; i < ARRAY_SIZE(c->dq_deskew[0]); i++)
+			c->dq_deskew[j][i] =
+				readl(PHY_REG(phy_base, dqs_dq_skew_adr[j] + i));
+	for (j = 0; j < ARRAY_SIZE(grp_addr); j++) {
+		for (i = 0; i < ARRAY_SIZE(dq_sel); i++) {
+			c->prebit[j][i][0] = readl(PHY_REG(phy_base,
+						grp_addr[j] + dq_sel[i][1]));
+			c->prebit[j][i][1] = readl(PHY_REG(phy_base,
+						grp_addr[j] + dq_sel[i][2]));
+		}
+	}
+	trn_cache_dirty = 1;
+}
+
+/* A few words on each cs, with all the bits of each byte toggling */
+static int trn_cache_test(struct dram_info *dram,
+			  struct rv1126_sdram_params *sdram_params)
+{
+	static const u32 pattern[] = {
+		PATTERN, ~PATTERN, 0x00000000, 0xffffffff,
+		0x55555555, 0xaaaaaaaa, 0x01234567, 0xfedcba98,
+	};
+	u32 rank = sdram_params->ch.cap_info.rank;
+	u32 byte_mask, cs, cs_pst, i;
+	ulong base;
+
+	if (sdram_params->ch.cap_info.bw == 2)
+		byte_mask = 0xffffffff;
+	else if (sdram_params->ch.cap_info.bw == 1)
+		byte_mask = 0xffff;
+	else
+		byte_mask = 0xff;
+
+	for (cs = 0; cs < rank; cs++) {
+		base = CONFIG_SYS_SDRAM_BASE;
+		if (cs) {
+			cs_pst = (readl(dram->pctl + DDR_PCTL2_ADDRMAP0) &
+				  0x1f) + 6 + 2;
+			if (cs_pst > 31)
+				break;
+			base += 1ul << cs_pst;
+		}
+		for (i = 0; i < ARRAY_SIZE(pattern); i++)
+			writel(pattern[i], base + i * 4);
+		for (i = 0; i < ARRAY_SIZE(pattern); i++) {
+			if ((readl(base + i * 4) ^ pattern[i]) & byte_mask)
+				return -1;
+		}
+	}
+
+	return 0;
+}
+
+/* return: 0 = the cached result of @fsp is in use, other = train it */
+static int trn_cache_restore(struct dram_info *dram,
+			     struct rv1126_sdram_params *sdram_params,
+			     u32 fsp)
+{
+	struct trn_cache_fsp *c = &trn_cache.fsp[fsp];
+	void __iomem *phy_base = dram->phy;
+	u32 dramtype = sdram_params->base.dramtype;
+	u32 rank = sdram_params->ch.cap_info.rank;
+	u32 i, j, cs;
+	int ret = 0;
+
+	if (!trn_cache_valid || c->freq_mhz != sdram_params->base.ddr_freq)
+		return -1;
+
+	modify_ca_deskew(dram, DESKEW_MDF_ABS_VAL, c->ca_dif, c->ca_sig, 3,
+			 dramtype);
+
+	writel(c->wrlvl[0], PHY_REG(phy_base, 0x233));
+	writel(c->wrlvl[1], PHY_REG(phy_base, 0x237));
+	writel(c->wrlvl[2], PHY_REG(phy_base, 0x2b3));
+	writel(c->wrlvl[3], PHY_REG(phy_base, 0x2b7));
+	/* use 0x233 0x237 0x2b3 0x2b7 as the write training leaves it */
+	setbits_le32(PHY_REG(phy_base, 0x7a), BIT(4));
+
+	for (j = 0; j < ARRAY_SIZE(grp_addr); j++) {
+		for (i = 0; i < ARRAY_SIZE(dq_sel); i++) {
+			writel(c->prebit[j][i][0], PHY_REG(phy_base,
+			       grp_addr[j] + dq_sel[i][1]));
+			writel(c->prebit[j][i][1], PHY_REG(phy_base,
+			       grp_addr[j] + dq_sel[i][2]));
+		}
+	}
+	for (j = 0; j < ARRAY_SIZE(dqs_dq_skew_adr); j++)
+		for (i = 0; i < ARRAY_SIZE(c->dq_deskew[0]); i++)
+			writel(c->dq_deskew[j][i],
+			       PHY_REG(phy_base, dqs_dq_skew_adr[j] + i));
+	update_dq_rx_prebit(dram);
+	update_dq_tx_prebit(dram);
+
+	if (dramtype == LPDDR4 || dramtype == LPDDR4X) {
+		for (cs = 0; cs < rank; cs++) {
+			fsp_param[fsp].vref_dq[cs] = c->vref_dq[cs];
+			pctl_write_mr(dram->pctl, BIT(cs), 14, c->vref_dq[cs],
+				      dramtype);
+		}
+	}
+
+	for (cs = 0; cs < rank; cs++)
+		ret |= data_training(dram, cs, sdram_params, fsp,
+				     READ_GATE_TRAINING);
+	if (!ret)
+		ret = trn_cache_test(dram, sdram_params);
+	if (ret) {
+		printascii("training cache mismatch\n");
+		trn_cache_invalidate();
+	}
+
+	return ret;
+}
+#endif
+
 static int high_freq_training(struct dram_info *dram,
 			      struct rv1126_sdram_params *sdram_params,
 			      u32 fsp)
@@ -2102,6 +2334,10 @@ static int high_freq_training(struct dram_info *dram,
 	u8 byte_en;
 	int ret;
 
+#if defined(CONFIG_ROCKCHIP_SDRAM_TRN_CACHE)
+	if (!trn_cache_restore(dram, sdram_params, fsp))
+		return 0;
+#endif
 	byte_en = readl(PHY_REG(phy_base, 0xf)) & PHY_DQ_WIDTH_MASK;
 	dqs_skew = 0;
 	for (j = 0; j < sdram_params->ch.cap_info.rank; j++) {
@@ -2202,6 +2438,12 @@ static int high_freq_training(struct dram_info *dram,
 		ret |= data_training(dram, 1, sdram_params, 0,
 				     READ_GATE_TRAINING);
 out:
+#if defined(CONFIG_ROCKCHIP_SDRAM_TRN_CACHE)
+	if (!ret)
+		trn_cache_save_fsp(dram, sdram_params, fsp);
+	else
+		trn_cache_failed = 1;
+#endif
 	return ret;
 }
 
@@ -3547,6 +3789,9 @@ static void ddr_set_rate_for_fsp(struct dram_info *dram,
 
 	if (get_wrlvl_val(dram, sdram_params))
 		printascii("get wrlvl value fail\n");
+#if defined(CONFIG_ROCKCHIP_SDRAM_TRN_CACHE)
+	trn_cache_load(sdram_params);
+#endif
 
 #ifndef CONFIG_SPL_KERNEL_BOOT
 	printascii("change to: ");
@@ -3571,6 +3816,9 @@ static void ddr_set_rate_for_fsp(struct dram_info *dram,
 #else
 	ddr_set_rate(&dram_info, sdram_params, f0, sdram_params->base.ddr_freq, 1, 1, 1);
 #endif
+#if defined(CONFIG_ROCKCHIP_SDRAM_TRN_CACHE)
+	trn_cache_store();
+#endif
 }
 
 int get_uart_config(void)
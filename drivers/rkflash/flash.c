@@ -22,6 +22,12 @@ static u8 g_nand_flash_ecc_bits;
 static u8 g_nand_idb_res_blk_num;
 static u8 g_nand_ecc_en;
 
+/* Programs left running between nandc_flash_prog_begin() and _end() */
+static u8 g_nand_prog_behind;
+static u8 g_nand_prog_pending[MAX_FLASH_NUM];
+static u32 g_nand_prog_page[MAX_FLASH_NUM];
+static u32 g_nand_prog_err;
+
 static struct NAND_PARA_INFO_T nand_para = {
 	2,
 	{0x98, 0xF1, 0, 0, 0, 0},
@@ -130,6 +136,51 @@ static u32 flash_read_status(u8 cs, u32 page_addr)
 	return nandc_readl(NANDC_CHIP_DATA(cs));
 }
 
+static void flash_prog_cache_cmd(u8 cs, u32 page_addr)
+{
+	udelay(100);
+	nandc_writel(PAGE_CACHE_PROG_CMD & 0x00ff, NANDC_CHIP_CMD(cs));
+}
+
+/*
+ * Poll the status of one chip, the ready line of NANDC_FMCTL does not tell
+ * which chip select is still busy.
+ */
+static u32 flash_wait_status(u8 cs, u32 mask)
+{
+	u32 status, i;
+
+	for (i = 0; i < 100000; i++) {
+		status = flash_read_status(cs, 0);
+		if (status & mask)
+			return status;
+		nandc_delayns(100);
+	}
+
+	return NAND_STATUS_FAIL;
+}
+
+/* Wait for a program left running on @cs and collect its status */
+static void flash_prog_finish(u8 cs)
+{
+	u32 status, fail = NAND_STATUS_FAIL;
+
+	if (!g_nand_prog_pending[cs])
+		return;
+
+	if (nand_para.operation_opt & NAND_CACHE_PROG_EN)
+		fail |= NAND_STATUS_FAIL_N1;
+	g_nand_prog_pending[cs] = 0;
+	nandc_flash_cs(cs);
+	status = flash_wait_status(cs, NAND_STATUS_ARDY);
+	nandc_flash_de_cs(cs);
+	if (status & fail) {
+		g_nand_prog_err = 1;
+		rkflash_print_error("%s addr=%x status=%x\n",
+				    __func__, g_nand_prog_page[cs], status);
+	}
+}
+
 static void flash_read_random_dataout_cmd(u8 cs, u32 col_addr)
 {
 	nandc_writel(READ_DP_OUT_CMD >> 8, NANDC_CHIP_CMD(cs));
@@ -164,6 +215,7 @@ static u32 flash_read_page_raw(u8 cs, u32 page_addr, u32 *p_data, u32 *p_spare)
 	u32 sec_per_page = nand_para.sec_per_page;
 	u32 nand_ecc = 0;
 
+	flash_prog_finish(cs);
 	nandc_wait_flash_ready(cs);
 	nandc_flash_cs(cs);
 	flash_read_cmd(cs, page_addr);
@@ -223,12 +275,55 @@ static u32 flash_read_page(u8 cs, u32 page_addr, u32 *p_data, u32 *p_spare)
 	return ret;
 }
 
+/*
+ * Start programming a page and return without waiting for tPROG, so that it
+ * overlaps the FTL preparing the next page and, with cache program, sending
+ * it. The status is checked before @cs is used again.
+ */
+static u32 flash_prog_page_behind(u8 cs, u32 page_addr, u32 *p_data,
+				  u32 *p_spare)
+{
+	u32 status;
+	u32 sec_per_page = nand_para.sec_per_page;
+	bool cache = nand_para.operation_opt & NAND_CACHE_PROG_EN;
+
+	if (!cache)
+		flash_prog_finish(cs);
+
+	nandc_flash_cs(cs);
+	if (g_nand_prog_pending[cs]) {
+		/* Cache register free, the previous page may still be busy */
+		status = flash_wait_status(cs, NAND_STATUS_RDY);
+		if (status & (NAND_STATUS_FAIL | NAND_STATUS_FAIL_N1)) {
+			g_nand_prog_err = 1;
+			rkflash_print_error("%s before addr=%x status=%x\n",
+					    __func__, g_nand_prog_page[cs],
+					    status);
+		}
+	}
+	flash_prog_first_cmd(cs, page_addr);
+	nandc_xfer_data(cs, NANDC_WRITE, sec_per_page, p_data, p_spare);
+	if (cache)
+		flash_prog_cache_cmd(cs, page_addr);
+	else
+		flash_prog_second_cmd(cs, page_addr);
+	nandc_flash_de_cs(cs);
+	g_nand_prog_pending[cs] = 1;
+	g_nand_prog_page[cs] = page_addr;
+
+	return 0;
+}
+
 static u32 flash_prog_page(u8 cs, u32 page_addr, u32 *p_data, u32 *p_spare)
 {
 	u32 status;
 	u32 sec_per_page = nand_para.sec_per_page;
 
 	rkflash_print_dio("%s %x %x\n", __func__, page_addr, p_data[0]);
+	if (g_nand_prog_behind)
+		return flash_prog_page_behind(cs, page_addr, p_data, p_spare);
+
+	flash_prog_finish(cs);
 	nandc_wait_flash_ready(cs);
 	nandc_flash_cs(cs);
 	flash_prog_first_cmd(cs, page_addr);
@@ -250,6 +345,7 @@ static u32 flash_erase_block(u8 cs, u32 page_addr)
 	u32 status;
 
 	rkflash_print_dio("%s %x\n", __func__, page_addr);
+	flash_prog_finish(cs);
 	nandc_wait_flash_ready(cs);
 	nandc_flash_cs(cs);
 	flash_erase_cmd(cs, page_addr);
@@ -518,6 +614,10 @@ u32 nandc_flash_init(void __iomem *nandc_addr)
 		nand_para.plane_per_die = 2;
 		nand_para.blk_per_plane = 2048;
 	}
+	/* SLC parts of these vendors all take PAGE CACHE PROGRAM (80h-15h) */
+	if (id_byte[0][0] == 0x98 || id_byte[0][0] == 0x2C ||
+	    id_byte[0][0] == 0xEC || id_byte[0][0] == 0x01)
+		nand_para.operation_opt |= NAND_CACHE_PROG_EN;
 	flash_die_info_init();
 	flash_bch_sel(nand_para.ecc_bits);
 	flash_show_info();
@@ -531,6 +631,28 @@ void nandc_flash_get_id(u8 cs, void *buf)
 	memcpy(buf, id_byte[cs], 5);
 }
 
+/*
+ * Let flash_prog_page() return before the page is programmed, until
+ * nandc_flash_prog_end(), for bulk writes. A program failing meanwhile is
+ * only reported by nandc_flash_prog_end().
+ */
+void nandc_flash_prog_begin(void)
+{
+	g_nand_prog_err = 0;
+	g_nand_prog_behind = 1;
+}
+
+u32 nandc_flash_prog_end(void)
+{
+	u32 cs;
+
+	g_nand_prog_behind = 0;
+	for (cs = 0; cs < MAX_FLASH_NUM; cs++)
+		flash_prog_finish(cs);
+
+	return g_nand_prog_err;
+}
+
 u32 nandc_flash_deinit(void)
 {
 	return 0;
@@ -39,11 +39,17 @@
 #define READ_ID_CMD		0x90
 #define READ_STATUS_CMD		0x70
 #define PAGE_PROG_CMD		0x8010
+#define PAGE_CACHE_PROG_CMD	0x8015
 #define BLOCK_ERASE_CMD		0x60d0
 #define READ_CMD		0x0030
 #define READ_DP_OUT_CMD		0x05E0
 #define READ_ECC_STATUS_CMD	0x7A
 
+#define NAND_STATUS_FAIL	BIT(0)
+#define NAND_STATUS_FAIL_N1	BIT(1)	/* the page before, cache prog */
+#define NAND_STATUS_ARDY	BIT(5)	/* array idle, tPROG over */
+#define NAND_STATUS_RDY		BIT(6)	/* ready for the next command */
+
 #define SAMSUNG			0x00	/* SAMSUNG */
 #define TOSHIBA			0x01	/* TOSHIBA */
 #define HYNIX			0x02	/* HYNIX */
@@ -130,5 +136,7 @@ void nandc_flash_get_id(u8 cs, void *buf);
 void nandc_flash_reset(u8 chip_sel);
 u32 nandc_flash_init(void __iomem *nandc_addr);
 u32 nandc_flash_deinit(void);
+void nandc_flash_prog_begin(void);
+u32 nandc_flash_prog_end(void);
 
 #endif
@@ -370,6 +370,27 @@ static void nandc_xfer_done(void)
 	}
 }
 
+/*
+ * Invalidate the buffers of a read, the CPU may have fetched their lines
+ * while the DMA was running
+ */
+static void nandc_xfer_unmap(u8 n_sec)
+{
+	unsigned long vir_addr;
+	u32 page_num = (n_sec + 1) / 2;
+
+	if (!master.mapped)
+		return;
+
+	vir_addr = (unsigned long)master.page_vir;
+	invalidate_dcache_range(vir_addr & (~0x3FuL),
+				((vir_addr + 63) & (~0x3FuL)) + page_num * 1024);
+	vir_addr = (unsigned long)master.spare_vir;
+	invalidate_dcache_range(vir_addr & (~0x3FuL),
+				((vir_addr + 63) & (~0x3FuL)) + page_num * 128);
+	master.mapped = 0;
+}
+
 u32 nandc_xfer_data(u8 chip_sel, u8 dir, u8 n_sec,
 		    u32 *p_data, u32 *p_spare)
 {
@@ -385,6 +406,7 @@ u32 nandc_xfer_data(u8 chip_sel, u8 dir, u8 n_sec,
 	nandc_xfer_start(dir, n_sec, p_data, p_spare);
 	nandc_xfer_done();
 	if (dir == NANDC_READ) {
+		nandc_xfer_unmap(n_sec);
 		if (g_nandc_ver == 9) {
 			for (i = 0; i < n_sec / 4; i++) {
 				bch_st_reg.d32 = nandc_readl(NANDC_V9_BCHST(i));
@@ -80,6 +80,8 @@ int rksfc_nor_init(struct udevice *udev)
 		}
 		kfree(idb_tag);
 	}
+	if (ret == SFC_OK && priv->xipaddr)
+		snor_xip_init(p_dev, priv->xipaddr, priv->xipsize);
 
 	return ret;
 }
@@ -129,6 +131,28 @@ int rksfc_nor_read(struct udevice *udev, u32 sec, u32 n_sec, void *p_data)
 	return n_sec;
 }
 
+int rksfc_nor_read_async(struct udevice *udev, u32 sec, u32 n_sec,
+			 void *p_data)
+{
+	struct rkflash_info *priv = dev_get_priv(udev);
+	struct SFNOR_DEV *p_dev = (struct SFNOR_DEV *)&priv->flash_dev_info;
+
+	/* The vendor part reads back as zeroes, leave that to the sync path */
+	if (sec + n_sec - 1 >= FLASH_VENDOR_PART_START &&
+	    sec <= FLASH_VENDOR_PART_END)
+		return rksfc_nor_read(udev, sec, n_sec, p_data);
+
+	return snor_read_async(p_dev, sec, n_sec, p_data);
+}
+
+int rksfc_nor_wait(struct udevice *udev)
+{
+	struct rkflash_info *priv = dev_get_priv(udev);
+	struct SFNOR_DEV *p_dev = (struct SFNOR_DEV *)&priv->flash_dev_info;
+
+	return snor_wait(p_dev);
+}
+
 /* Workaround for GPT not aligned program */
 int rksfc_nor_simply_over_write(struct udevice *udev,
 				u32 sec,
@@ -319,7 +343,11 @@ int rknand_flash_write(struct udevice *udev,
 {
 	int ret;
 
+	/* Overlap tPROG of each page with the FTL preparing the next one */
+	nandc_flash_prog_begin();
 	ret = sftl_write(index, count, (u8 *)buf);
+	if (nandc_flash_prog_end())
+		ret = -EIO;
 	if (!ret)
 		return count;
 	else
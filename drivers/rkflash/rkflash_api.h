@@ -17,6 +17,9 @@
 int rksfc_nor_init(struct udevice *udev);
 u32 rksfc_nor_get_capacity(struct udevice *udev);
 int rksfc_nor_read(struct udevice *udev, u32 sec, u32 n_sec, void *p_data);
+int rksfc_nor_read_async(struct udevice *udev, u32 sec, u32 n_sec,
+			 void *p_data);
+int rksfc_nor_wait(struct udevice *udev);
 int rksfc_nor_write(struct udevice *udev,
 		    u32 sec,
 		    u32 n_sec,
@@ -9,10 +9,89 @@
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <dm/root.h>
+#include <malloc.h>
 
 #include "rkflash_blk.h"
 #include "rkflash_debug.h"
 
+#ifdef CONFIG_RKFLASH_READ_AHEAD
+#define RKFLASH_RA_SECS		CONFIG_RKFLASH_READ_AHEAD
+#else
+#define RKFLASH_RA_SECS		0
+#endif
+
+/*
+ * Small sequential reads are served from a window of RKFLASH_RA_SECS
+ * sectors read in one go, so that the FTL translates and reads each Nand
+ * page once instead of once per request.
+ */
+static ulong rkflash_ra_read(struct udevice *udev, u32 start, u32 blkcnt,
+			     void *dst)
+{
+	struct blk_desc *block_dev = dev_get_uclass_platdata(udev);
+	struct rkflash_info *priv = dev_get_priv(udev->parent);
+	bool seq = start == priv->ra_next;
+	u32 ra_end, wstart, n;
+	ulong done = 0;
+	int ret;
+
+	priv->ra_next = start + blkcnt;
+	while (blkcnt) {
+		ra_end = priv->ra_start + priv->ra_count;
+		if (start >= priv->ra_start && start < ra_end) {
+			n = min(blkcnt, ra_end - start);
+			memcpy(dst, priv->ra_buf + ((start - priv->ra_start) << 9),
+			       n << 9);
+			start += n;
+			blkcnt -= n;
+			dst += n << 9;
+			done += n;
+			continue;
+		}
+
+		if (!seq || blkcnt >= RKFLASH_RA_SECS)
+			break;
+
+		wstart = rounddown(start, RKFLASH_RA_SECS);
+		n = min_t(u32, RKFLASH_RA_SECS, block_dev->lba - wstart);
+		priv->ra_count = 0;
+		ret = priv->read(udev->parent, wstart, n, priv->ra_buf);
+		if (ret != (int)n)
+			break;
+		priv->ra_start = wstart;
+		priv->ra_count = n;
+	}
+
+	if (!blkcnt)
+		return done;
+
+	ret = priv->read(udev->parent, start, blkcnt, dst);
+	if (ret < 0)
+		return done ? done : (ulong)ret;
+
+	return done + ret;
+}
+
+/* Keeps the read-ahead window in line with what was written or erased */
+static void rkflash_ra_update(struct rkflash_info *priv, u32 start,
+			      u32 blkcnt, const void *src)
+{
+	u32 ra_end = priv->ra_start + priv->ra_count;
+	u32 from = max(start, priv->ra_start);
+	u32 to = min(start + blkcnt, ra_end);
+
+	if (from >= to)
+		return;
+
+	if (!src) {
+		priv->ra_count = 0;
+		return;
+	}
+
+	memcpy(priv->ra_buf + ((from - priv->ra_start) << 9),
+	       src + ((from - start) << 9), (to - from) << 9);
+}
+
 ulong rkflash_bread(struct udevice *udev, lbaint_t start,
 		    lbaint_t blkcnt, void *dst)
 {
@@ -29,14 +108,49 @@ ulong rkflash_bread(struct udevice *udev, lbaint_t start,
 	if (!priv->read)
 		return -EINVAL;
 
+	if (priv->ra_buf)
+		return rkflash_ra_read(udev, (u32)start, (u32)blkcnt, dst);
+
 	return (ulong)priv->read(udev->parent, (u32)start, (u32)blkcnt, dst);
 }
 
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+static ulong rkflash_bread_async(struct udevice *udev, lbaint_t start,
+				 lbaint_t blkcnt, void *dst)
+{
+	struct blk_desc *block_dev = dev_get_uclass_platdata(udev);
+	struct rkflash_info *priv = dev_get_priv(udev->parent);
+
+	if (!priv->read_async)
+		return rkflash_bread(udev, start, blkcnt, dst);
+
+	if (blkcnt == 0)
+		return 0;
+
+	if ((start + blkcnt) > block_dev->lba)
+		return -EINVAL;
+
+	return (ulong)priv->read_async(udev->parent, (u32)start, (u32)blkcnt,
+				       dst);
+}
+
+static int rkflash_bwait(struct udevice *udev)
+{
+	struct rkflash_info *priv = dev_get_priv(udev->parent);
+
+	if (!priv->wait)
+		return 0;
+
+	return priv->wait(udev->parent) ? -EIO : 0;
+}
+#endif
+
 ulong rkflash_bwrite(struct udevice *udev, lbaint_t start,
 		     lbaint_t blkcnt, const void *src)
 {
 	struct blk_desc *block_dev = dev_get_uclass_platdata(udev);
 	struct rkflash_info *priv = dev_get_priv(udev->parent);
+	int ret;
 
 	if (blkcnt == 0)
 		return 0;
@@ -47,7 +161,12 @@ ulong rkflash_bwrite(struct udevice *udev, lbaint_t start,
 	if (!priv->write)
 		return -EINVAL;
 
-	return (ulong)priv->write(udev->parent, (u32)start, (u32)blkcnt, src);
+	ret = priv->write(udev->parent, (u32)start, (u32)blkcnt, src);
+	if (priv->ra_buf)
+		rkflash_ra_update(priv, (u32)start, (u32)blkcnt,
+				  ret == blkcnt ? src : NULL);
+
+	return (ulong)ret;
 }
 
 ulong rkflash_berase(struct udevice *udev, lbaint_t start,
@@ -65,6 +184,9 @@ ulong rkflash_berase(struct udevice *udev, lbaint_t start,
 	if (!priv->erase)
 		return -EINVAL;
 
+	if (priv->ra_buf)
+		rkflash_ra_update(priv, (u32)start, (u32)blkcnt, NULL);
+
 	return (ulong)priv->erase(udev->parent, (u32)start, (u32)blkcnt);
 }
 
@@ -100,6 +222,13 @@ static int rkflash_blk_probe(struct udevice *udev)
 	sprintf(desc->vendor, "0x%.4x", 0x0308);
 	memcpy(desc->product, product, strlen(product));
 	memcpy(desc->revision, "V1.00", sizeof("V1.00"));
+
+	/* Only the FTL reads whole pages for a few sectors */
+	if (RKFLASH_RA_SECS && priv->flash_con_type != IF_TYPE_SPINOR &&
+	    !priv->ra_buf)
+		priv->ra_buf = memalign(ARCH_DMA_MINALIGN,
+					RKFLASH_RA_SECS << 9);
+
 	part_init(desc);
 	rkflash_test(udev);
 
@@ -110,6 +239,10 @@ static const struct blk_ops rkflash_blk_ops = {
 	.read	= rkflash_bread,
 	.write	= rkflash_bwrite,
 	.erase	= rkflash_berase,
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+	.read_async	= rkflash_bread_async,
+	.wait		= rkflash_bwait,
+#endif
 };
 
 U_BOOT_DRIVER(rkflash_blk) = {
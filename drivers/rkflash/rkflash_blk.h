@@ -43,6 +43,11 @@ struct flash_operation {
 			    u32 start,
 			    u32 blkcnt,
 			    void *buffer);
+	int (*flash_read_async)(struct udevice *udev,
+				u32 start,
+				u32 blkcnt,
+				void *buffer);
+	int (*flash_wait)(struct udevice *udev);
 };
 
 struct rkflash_dev {
@@ -51,11 +56,18 @@ struct rkflash_dev {
 
 struct rkflash_info {
 	void *ioaddr;
+	void *xipaddr;		/* AHB window for memory-mapped reads */
+	u32 xipsize;
 	u32 flash_con_type;
 	u32 freq;
 	u32 density;
 	struct udevice *child_dev;
 	struct rkflash_dev flash_dev_info;
+	/* FTL read-ahead window, see rkflash_bread() */
+	u8 *ra_buf;
+	u32 ra_start;
+	u32 ra_count;
+	u32 ra_next;
 	/*
 	 * read() - read from a block device
 	 *
@@ -92,6 +104,24 @@ struct rkflash_info {
 	int (*erase)(struct udevice *udev,
 		     u32 start,
 		     u32 blkcnt);
+	/*
+	 * read_async() - start a read without waiting for the data
+	 *
+	 * @start:	Start block number to read (0=first)
+	 * @blkcnt:	Number of blocks to read
+	 * @buffer:	Destination buffer, not valid until wait() returns
+	 * @return number of blocks queued, may be less than @blkcnt.
+	 */
+	int (*read_async)(struct udevice *udev,
+			  u32 start,
+			  u32 blkcnt,
+			  void *buffer);
+	/*
+	 * wait() - finish the outstanding read_async()
+	 *
+	 * @return 0 is OK, others is error.
+	 */
+	int (*wait)(struct udevice *udev);
 };
 
 struct rkflash_uclass_priv {
@@ -25,6 +25,8 @@ static struct flash_operation sfc_nor_op = {
 	NULL,
 	rksfc_nor_vendor_read,
 	rksfc_nor_vendor_write,
+	rksfc_nor_read_async,
+	rksfc_nor_wait,
 #else
 	-1, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
 #endif
@@ -93,8 +95,16 @@ static int rksfc_blk_bind(struct udevice *udev)
 static int rockchip_rksfc_ofdata_to_platdata(struct udevice *dev)
 {
 	struct rkflash_info *priv = dev_get_priv(dev);
+	fdt_addr_t addr;
+	fdt_size_t size;
 
 	priv->ioaddr = dev_read_addr_ptr(dev);
+	/* Optional second reg entry: the memory-mapped read window */
+	addr = devfdt_get_addr_size_index(dev, 1, &size);
+	if (addr != FDT_ADDR_T_NONE) {
+		priv->xipaddr = (void *)addr;
+		priv->xipsize = size;
+	}
 
 	return 0;
 }
@@ -121,6 +131,8 @@ static int rockchip_rksfc_probe(struct udevice *udev)
 				spi_flash_op[i]->flash_get_capacity(udev);
 			priv->read = spi_flash_op[i]->flash_read;
 			priv->write = spi_flash_op[i]->flash_write;
+			priv->read_async = spi_flash_op[i]->flash_read_async;
+			priv->wait = spi_flash_op[i]->flash_wait;
 #ifdef CONFIG_ROCKCHIP_VENDOR_PARTITION
 			flash_vendor_dev_ops_register(spi_flash_op[i]->vendor_read,
 						      spi_flash_op[i]->vendor_write);
@@ -8,6 +8,7 @@
 #include <linux/delay.h>
 #include <bouncebuf.h>
 #include <asm/io.h>
+#include <linux/log2.h>
 
 #include "sfc.h"
 
@@ -16,6 +17,16 @@
 
 static void __iomem *g_sfc_reg;
 
+/* DMA read started by sfc_request_async(), drained by sfc_wait() */
+static struct bounce_buffer g_sfc_async_bb;
+static u32 g_sfc_async_size;
+
+/* AHB window for memory-mapped (XMMC) reads, NULL if the SoC has none */
+static void __iomem *g_sfc_xip;
+static u32 g_sfc_xip_cmd;
+static u32 g_sfc_xip_ctrl;
+static bool g_sfc_xmmc;
+
 static void sfc_reset(void)
 {
 	int timeout = 10000;
@@ -72,18 +83,54 @@ int sfc_init(void __iomem *reg_addr)
 	return SFC_OK;
 }
 
+/*
+ * Set up the read command the SFC sends for accesses to the AHB window.
+ * XMMC_RCMD0 and XMMC_CTRL take the SFC_CMD and SFC_CTRL layouts.
+ */
+int sfc_xmmc_init(void __iomem *window, struct rk_sfc_op *op, u32 size)
+{
+	if (!window || !size || sfc_get_version() < SFC_VER_4)
+		return SFC_PARAM_ERR;
+
+	g_sfc_xip_cmd = op->sfcmd.d32;
+	g_sfc_xip_ctrl = op->sfctrl.d32 & ~SFC_ENABLE_DMA;
+	writel(ilog2(size), g_sfc_reg + SFC_DEVRGN);
+	writel(ilog2(size), g_sfc_reg + SFC_DEVSIZE0);
+	g_sfc_xip = window;
+
+	return SFC_OK;
+}
+
+/* Switch to memory-mapped reads, returns the window or NULL */
+void __iomem *sfc_xmmc_map(void)
+{
+	if (g_sfc_xip && !g_sfc_xmmc) {
+		writel(g_sfc_xip_ctrl, g_sfc_reg + SFC_XMMC_CTRL);
+		writel(g_sfc_xip_cmd, g_sfc_reg + SFC_XMMC_RCMD0);
+		writel(SFC_MODE_XMMC, g_sfc_reg + SFC_MODE);
+		g_sfc_xmmc = true;
+	}
+
+	return g_sfc_xip;
+}
+
 void sfc_clean_irq(void)
 {
 	writel(0xFFFFFFFF, g_sfc_reg + SFC_ICLR);
 	writel(0xFFFFFFFF, g_sfc_reg + SFC_IMR);
 }
 
-int sfc_request(struct rk_sfc_op *op, u32 addr, void *data, u32 size)
+/* Program the command, the data phase is then handled by the caller */
+static int sfc_start(struct rk_sfc_op *op, u32 addr, u32 size)
 {
-	int ret = SFC_OK;
 	union SFCCMD_DATA cmd;
 	int reg;
-	int timeout = 0;
+
+	/* Back to command mode, sfc_xmmc_map() turns the window on again */
+	if (g_sfc_xmmc) {
+		writel(0, g_sfc_reg + SFC_MODE);
+		g_sfc_xmmc = false;
+	}
 
 	reg = readl(g_sfc_reg + SFC_FSR);
 
@@ -120,6 +167,75 @@ int sfc_request(struct rk_sfc_op *op, u32 addr, void *data, u32 size)
 	if (cmd.b.addrbits)
 		writel(addr, g_sfc_reg + SFC_ADDR);
 
+	return SFC_OK;
+}
+
+int sfc_wait(void)
+{
+	int ret = SFC_OK;
+	int timeout;
+
+	if (!g_sfc_async_size)
+		return SFC_OK;
+
+	timeout = g_sfc_async_size * 10;
+	while ((readl(g_sfc_reg + SFC_SR) & SFC_BUSY) && (timeout-- > 0))
+		sfc_delay(1);
+
+	writel(0xFFFFFFFF, g_sfc_reg + SFC_ICLR);
+
+	if (timeout <= 0)
+		ret = SFC_WAIT_TIMEOUT;
+	bounce_buffer_stop(&g_sfc_async_bb);
+	g_sfc_async_size = 0;
+
+	sfc_delay(1); /* CS# High Time (read/write) >100ns */
+	return ret;
+}
+
+int sfc_request_async(struct rk_sfc_op *op, u32 addr, void *data, u32 size)
+{
+	int ret;
+
+	sfc_wait();
+
+	if (!size || op->sfcmd.b.rw == SFC_WRITE)
+		return SFC_PARAM_ERR;
+
+	ret = bounce_buffer_start(&g_sfc_async_bb, data, size, GEN_BB_WRITE);
+	if (ret)
+		return ret;
+
+	op->sfctrl.b.enbledma = 1;
+	ret = sfc_start(op, addr, size);
+	if (ret != SFC_OK) {
+		bounce_buffer_stop(&g_sfc_async_bb);
+		return ret;
+	}
+
+	writel(0xFFFFFFFF, g_sfc_reg + SFC_ICLR);
+	writel(~((u32)DMA_INT), g_sfc_reg + SFC_IMR);
+	writel((unsigned long)g_sfc_async_bb.bounce_buffer,
+	       g_sfc_reg + SFC_DMA_ADDR);
+	writel(SFC_DMA_START, g_sfc_reg + SFC_DMA_TRIGGER);
+	g_sfc_async_size = size;
+
+	return SFC_OK;
+}
+
+int sfc_request(struct rk_sfc_op *op, u32 addr, void *data, u32 size)
+{
+	int ret = SFC_OK;
+	union SFCCMD_DATA cmd;
+	int timeout = 0;
+
+	sfc_wait();
+
+	ret = sfc_start(op, addr, size);
+	if (ret != SFC_OK)
+		return ret;
+
+	cmd.d32 = op->sfcmd.d32;
 	if (!size)
 		goto exit_wait;
 
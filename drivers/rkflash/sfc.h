@@ -81,6 +81,9 @@
 /* Dma start trigger signal. Auto cleared after write */
 #define SFC_DMA_START	BIT(0)
 
+/* SFC_MODE */
+#define SFC_MODE_XMMC	BIT(0)	/* reads through the AHB window */
+
 #define SFC_CTRL	0x00
 #define SFC_IMR		0x04
 #define SFC_ICLR	0x08
@@ -95,6 +98,12 @@
 #define SFC_VER		0x2C
 #define SFC_QOP		0x30
 #define SFC_DLL_CTRL0	0x3C
+#define SFC_XMMC_WCMD0	0x50
+#define SFC_XMMC_RCMD0	0x54
+#define SFC_XMMC_CTRL	0x58
+#define SFC_MODE	0x5C
+#define SFC_DEVRGN	0x60
+#define SFC_DEVSIZE0	0x64
 #define SFC_DMA_TRIGGER	0x80
 #define SFC_DMA_ADDR	0x84
 #define SFC_LEN_CTRL	0x88
@@ -213,6 +222,10 @@ struct id_block_tag {
 
 int sfc_init(void __iomem *reg_addr);
 int sfc_request(struct rk_sfc_op *op, u32 addr, void *data, u32 size);
+int sfc_request_async(struct rk_sfc_op *op, u32 addr, void *data, u32 size);
+int sfc_wait(void);
+int sfc_xmmc_init(void __iomem *window, struct rk_sfc_op *op, u32 size);
+void __iomem *sfc_xmmc_map(void);
 u16 sfc_get_version(void);
 void sfc_clean_irq(void);
 u32 sfc_get_max_iosize(void);
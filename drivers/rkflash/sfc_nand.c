@@ -210,9 +210,9 @@ static struct nand_info spi_nand_tbl[] = {
 	{ 0x0B, 0x33, 0x00, 8, 0x40, 1, 2048, 0x4C, 20, 0x8, 1, { 0x04, 0x08, 0x0C, 0x10 }, &sfc_nand_get_ecc_status0 },
 
 	/* MT29F2G01ABA, XT26G02E, F50L2G41XA */
-	{ 0x2C, 0x24, 0x00, 4, 0x40, 2, 1024, 0x4C, 19, 0x8, 0, { 0x20, 0x24, 0xFF, 0xFF }, &sfc_nand_get_ecc_status6 },
+	{ 0x2C, 0x24, 0x00, 4, 0x40, 2, 1024, 0xCC, 19, 0x8, 0, { 0x20, 0x24, 0xFF, 0xFF }, &sfc_nand_get_ecc_status6 },
 	/* MT29F1G01ABA, F50L1G41XA */
-	{ 0x2C, 0x14, 0x00, 4, 0x40, 1, 1024, 0x4C, 18, 0x8, 0, { 0x20, 0x24, 0xFF, 0xFF }, &sfc_nand_get_ecc_status6 },
+	{ 0x2C, 0x14, 0x00, 4, 0x40, 1, 1024, 0xCC, 18, 0x8, 0, { 0x20, 0x24, 0xFF, 0xFF }, &sfc_nand_get_ecc_status6 },
 
 	/* FM25S01 */
 	{ 0xA1, 0xA1, 0x00, 4, 0x40, 1, 1024, 0x4C, 18, 0x1, 0, { 0x00, 0x04, 0xFF, 0xFF }, &sfc_nand_get_ecc_status1 },
@@ -427,6 +427,8 @@ static u32 sfc_nand_get_ecc_status0(void)
 
 	ecc = (status >> 4) & 0x03;
 
+	sfc_nand_dev.ecc_bits = ecc == 3 ? p_nand_info->max_ecc_bits : ecc;
+
 	if (ecc <= 1)
 		ret = SFC_NAND_ECC_OK;
 	else if (ecc == 2)
@@ -468,6 +470,8 @@ static u32 sfc_nand_get_ecc_status1(void)
 
 	ecc = (status >> 4) & 0x03;
 
+	sfc_nand_dev.ecc_bits = ecc ? p_nand_info->max_ecc_bits : 0;
+
 	if (ecc == 0)
 		ret = SFC_NAND_ECC_OK;
 	else if (ecc == 1)
@@ -516,6 +520,8 @@ static u32 sfc_nand_get_ecc_status2(void)
 	ecc = (status >> 4) & 0x03;
 	ecc = (ecc << 2) | ((status1 >> 4) & 0x03);
 
+	sfc_nand_dev.ecc_bits = ecc < 4 ? 0 : ecc - 3;
+
 	if (ecc < 7)
 		ret = SFC_NAND_ECC_OK;
 	else if (ecc == 7)
@@ -565,6 +571,11 @@ static u32 sfc_nand_get_ecc_status3(void)
 	ecc = (status >> 4) & 0x03;
 	ecc = (ecc << 2) | ((status1 >> 4) & 0x03);
 
+	if (ecc >= 12)
+		sfc_nand_dev.ecc_bits = p_nand_info->max_ecc_bits;
+	else
+		sfc_nand_dev.ecc_bits = ecc < 4 ? 0 : ecc - 3;
+
 	if (ecc < 7)
 		ret = SFC_NAND_ECC_OK;
 	else if (ecc == 7 || ecc >= 12)
@@ -609,6 +620,8 @@ static u32 sfc_nand_get_ecc_status4(void)
 
 	ecc = (status >> 2) & 0x0f;
 
+	sfc_nand_dev.ecc_bits = ecc == 12 ? p_nand_info->max_ecc_bits : ecc;
+
 	if (ecc < 7)
 		ret = SFC_NAND_ECC_OK;
 	else if (ecc == 7 || ecc == 12)
@@ -653,6 +666,8 @@ static u32 sfc_nand_get_ecc_status5(void)
 
 	ecc = (status >> 4) & 0x07;
 
+	sfc_nand_dev.ecc_bits = ecc == 4 ? p_nand_info->max_ecc_bits : ecc;
+
 	if (ecc < 4)
 		ret = SFC_NAND_ECC_OK;
 	else if (ecc == 4)
@@ -699,6 +714,11 @@ static u32 sfc_nand_get_ecc_status6(void)
 
 	ecc = (status >> 4) & 0x07;
 
+	if (ecc == 5)
+		sfc_nand_dev.ecc_bits = p_nand_info->max_ecc_bits;
+	else
+		sfc_nand_dev.ecc_bits = ecc == 3 ? 6 : ecc * 3;
+
 	if (ecc == 0 || ecc == 1 || ecc == 3)
 		ret = SFC_NAND_ECC_OK;
 	else if (ecc == 5)
@@ -742,6 +762,8 @@ static u32 sfc_nand_get_ecc_status7(void)
 
 	ecc = (status >> 4) & 0xf;
 
+	sfc_nand_dev.ecc_bits = ecc;
+
 	if (ecc < 7)
 		ret = SFC_NAND_ECC_OK;
 	else if (ecc == 7 || ecc == 8)
@@ -784,6 +806,8 @@ static u32 sfc_nand_get_ecc_status8(void)
 
 	ecc = (status >> 4) & 0x07;
 
+	sfc_nand_dev.ecc_bits = ecc == 4 ? p_nand_info->max_ecc_bits : ecc;
+
 	if (ecc < 4)
 		ret = SFC_NAND_ECC_OK;
 	else if (ecc == 4)
@@ -824,6 +848,8 @@ static u32 sfc_nand_get_ecc_status9(void)
 
 	ecc = (status >> 4) & 0x03;
 
+	sfc_nand_dev.ecc_bits = ecc * 2;
+
 	if (ecc <= 1)
 		ret = SFC_NAND_ECC_OK;
 	else if (ecc == 2)
@@ -834,6 +860,48 @@ static u32 sfc_nand_get_ecc_status9(void)
 	return ret;
 }
 
+/*
+ * Send PAGE READ (13h), or one of the cache read commands which need no
+ * address, and wait for the page to reach the cache register.
+ */
+static void sfc_nand_load_page(u8 cmd, u32 row)
+{
+	struct rk_sfc_op op;
+	u8 status;
+
+	op.sfcmd.d32 = 0;
+	op.sfcmd.b.cmd = cmd;
+	op.sfcmd.b.rw = SFC_WRITE;
+	if (cmd == CMD_PAGE_READ)
+		op.sfcmd.b.addrbits = SFC_ADDR_24BITS;
+
+	op.sfctrl.d32 = 0;
+
+	sfc_request(&op, row, NULL, 0);
+
+	if (sfc_nand_dev.read_lines == DATA_LINES_X4 &&
+	    p_nand_info->feature & FEA_SOFT_QOP_BIT &&
+	    sfc_get_version() < SFC_VER_3)
+		sfc_nand_rw_preset();
+
+	sfc_nand_wait_busy(&status, 1000 * 1000);
+	if (sfc_nand_dev.manufacturer == 0x01 && status)
+		sfc_nand_wait_busy(&status, 1000 * 1000);
+}
+
+/*
+ * The page prefetched by 31h is still in the data register, end the cache
+ * read with 3Fh before the flash is used for anything else.
+ */
+static void sfc_nand_cache_read_end(void)
+{
+	if (sfc_nand_dev.cache_seq_row == SFC_NAND_ROW_NONE)
+		return;
+
+	sfc_nand_load_page(CMD_PAGE_READ_CACHE_END, 0);
+	sfc_nand_dev.cache_seq_row = SFC_NAND_ROW_NONE;
+}
+
 u32 sfc_nand_erase_block(u8 cs, u32 addr)
 {
 	int ret;
@@ -841,6 +909,7 @@ u32 sfc_nand_erase_block(u8 cs, u32 addr)
 	u8 status;
 
 	rkflash_print_dio("%s %x\n", __func__, addr);
+	sfc_nand_cache_read_end();
 	op.sfcmd.d32 = 0;
 	op.sfcmd.b.cmd = 0xd8;
 	op.sfcmd.b.addrbits = SFC_ADDR_24BITS;
@@ -896,6 +965,7 @@ u32 sfc_nand_prog_page_raw(u8 cs, u32 addr, u32 *p_page_buf)
 	u32 data_area_size = SFC_NAND_SECTOR_SIZE * p_nand_info->sec_per_page;
 
 	rkflash_print_dio("%s %x %x\n", __func__, addr, p_page_buf[0]);
+	sfc_nand_cache_read_end();
 	sfc_nand_write_en();
 
 	if (sfc_nand_dev.prog_lines == DATA_LINES_X4 &&
@@ -975,27 +1045,39 @@ u32 sfc_nand_read(u32 row, u32 *p_page_buf, u32 column, u32 len)
 	u32 plane;
 	struct rk_sfc_op op;
 	u32 ecc_result;
-	u8 status;
-
-	op.sfcmd.d32 = 0;
-	op.sfcmd.b.cmd = 0x13;
-	op.sfcmd.b.rw = SFC_WRITE;
-	op.sfcmd.b.addrbits = SFC_ADDR_24BITS;
-
-	op.sfctrl.d32 = 0;
-
-	sfc_request(&op, row, p_page_buf, 0);
-
-	if (sfc_nand_dev.read_lines == DATA_LINES_X4 &&
-	    p_nand_info->feature & FEA_SOFT_QOP_BIT &&
-	    sfc_get_version() < SFC_VER_3)
-		sfc_nand_rw_preset();
+	bool loaded, prefetch;
 
-	sfc_nand_wait_busy(&status, 1000 * 1000);
-	if (sfc_nand_dev.manufacturer == 0x01 && status)
-		sfc_nand_wait_busy(&status, 1000 * 1000);
+	/*
+	 * The FTL reads page by page, so once two pages of a block are read
+	 * in a row, 31h loads the next one into the data register while the
+	 * current one is read out of the cache, hiding the array read time.
+	 */
+	loaded = row == sfc_nand_dev.cache_seq_row;
+	prefetch = p_nand_info->feature & FEA_CACHE_SEQ_READ &&
+		   (row + 1) % p_nand_info->page_per_blk &&
+		   (loaded || row == sfc_nand_dev.last_read_row + 1);
+
+	if (!loaded) {
+		sfc_nand_cache_read_end();
+		sfc_nand_load_page(CMD_PAGE_READ, row);
+	}
+	if (prefetch)
+		sfc_nand_load_page(CMD_PAGE_READ_CACHE_SEQ, 0);
+	else if (loaded)
+		sfc_nand_load_page(CMD_PAGE_READ_CACHE_END, 0);
+	sfc_nand_dev.cache_seq_row = prefetch ? row + 1 : SFC_NAND_ROW_NONE;
+	sfc_nand_dev.last_read_row = row;
 
 	ecc_result = p_nand_info->ecc_status();
+#if CONFIG_RKSFC_NAND_REFRESH_BITS
+	/*
+	 * The FTL moves the data of a block whose read returns REFRESH, so
+	 * an earlier refresh point leaves more margin for read disturb.
+	 */
+	if (ecc_result == SFC_NAND_ECC_OK &&
+	    sfc_nand_dev.ecc_bits >= CONFIG_RKSFC_NAND_REFRESH_BITS)
+		ecc_result = SFC_NAND_ECC_REFRESH;
+#endif
 
 	op.sfcmd.d32 = 0;
 	op.sfcmd.b.cmd = sfc_nand_dev.page_read_cmd;
@@ -1209,6 +1291,8 @@ u32 sfc_nand_init(void)
 	sfc_nand_dev.capacity = p_nand_info->density;
 	sfc_nand_dev.block_size = p_nand_info->page_per_blk * p_nand_info->sec_per_page;
 	sfc_nand_dev.page_size = p_nand_info->sec_per_page;
+	sfc_nand_dev.last_read_row = SFC_NAND_ROW_NONE;
+	sfc_nand_dev.cache_seq_row = SFC_NAND_ROW_NONE;
 
 	/* disable block lock */
 	sfc_nand_write_feature(0xA0, 0);
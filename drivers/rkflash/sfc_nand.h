@@ -19,6 +19,7 @@
 #define SFC_NAND_PAGE_MAX_SIZE		4224
 #define SFC_NAND_SECTOR_FULL_SIZE	528
 #define SFC_NAND_SECTOR_SIZE		512
+#define SFC_NAND_ROW_NONE		0xFFFFFFFF
 
 #define FEA_READ_STATUE_MASK    (0x3 << 0)
 #define FEA_STATUE_MODE1        0
@@ -28,6 +29,7 @@
 #define FEA_4BYTE_ADDR          BIT(4)
 #define FEA_4BYTE_ADDR_MODE	BIT(5)
 #define FEA_SOFT_QOP_BIT	BIT(6)
+#define FEA_CACHE_SEQ_READ	BIT(7)
 
 /* Command Set */
 #define CMD_READ_JEDECID        (0x9F)
@@ -42,6 +44,8 @@
 #define CMD_WRITE_EN            (0x06)
 #define CMD_WRITE_DIS           (0x04)
 #define CMD_PAGE_READ           (0x13)
+#define CMD_PAGE_READ_CACHE_SEQ (0x31)
+#define CMD_PAGE_READ_CACHE_END (0x3F)
 #define CMD_GET_FEATURE         (0x0F)
 #define CMD_SET_FEATURE         (0x1F)
 #define CMD_PROG_LOAD           (0x02)
@@ -84,6 +88,10 @@ struct SFNAND_DEV {
 	u8 page_read_cmd;
 	u8 page_prog_cmd;
 	u8 *recheck_buffer;
+	u32 last_read_row;
+	u32 cache_seq_row;	/* being loaded by 31h, or SFC_NAND_ROW_NONE */
+	u8 ecc_bits;		/* bitflips of the last read, as far as the
+				 * ecc status tells them */
 };
 
 struct nand_mega_area {
@@ -3,6 +3,7 @@
  *
  * SPDX-License-Identifier:	GPL-2.0
  */
+#include <asm/io.h>
 #include <linux/compat.h>
 #include <linux/delay.h>
 #include <linux/kernel.h>
@@ -11,15 +12,21 @@
 #include "rkflash_debug.h"
 #include "sfc_nor.h"
 
+enum snor_xfer {
+	SNOR_XFER_PIO = 0,
+	SNOR_XFER_DMA,
+	SNOR_XFER_DMA_ASYNC
+};
+
 static struct flash_info spi_flash_tbl[] = {
 	/* GD25Q40B */
 	{ 0xc84013, 128, 8, 0x03, 0x02, 0x6B, 0x32, 0x20, 0xD8, 0x05, 10, 9, 0 },
 	/* GD25Q32B */
 	{ 0xc84016, 128, 8, 0x03, 0x02, 0x6B, 0x32, 0x20, 0xD8, 0x0D, 13, 9, 0 },
 	/* GD25Q64B/C/E */
-	{ 0xc84017, 128, 8, 0x03, 0x02, 0x6B, 0x32, 0x20, 0xD8, 0x0C, 14, 9, 0 },
+	{ 0xc84017, 128, 8, 0x03, 0x02, 0x6B, 0x32, 0x20, 0xD8, 0x0C, 14, 9, 1 },
 	/* GD25Q127C and GD25Q128C/E */
-	{ 0xc84018, 128, 8, 0x03, 0x02, 0x6B, 0x32, 0x20, 0xD8, 0x0C, 15, 9, 0 },
+	{ 0xc84018, 128, 8, 0x03, 0x02, 0x6B, 0x32, 0x20, 0xD8, 0x0C, 15, 9, 1 },
 	/* GD25Q256B/C/D/E */
 	{ 0xc84019, 128, 8, 0x13, 0x12, 0x6C, 0x3E, 0x21, 0xDC, 0x1C, 16, 6, 0 },
 	/* GD25Q512MC */
@@ -48,11 +55,11 @@ static struct flash_info spi_flash_tbl[] = {
 	/* W25Q32JV */
 	{ 0xef4016, 128, 8, 0x03, 0x02, 0x6B, 0x32, 0x20, 0xD8, 0x0C, 13, 9, 0 },
 	/* W25Q64JVSSIQ */
-	{ 0xef4017, 128, 8, 0x03, 0x02, 0x6B, 0x32, 0x20, 0xD8, 0x0C, 14, 9, 0 },
+	{ 0xef4017, 128, 8, 0x03, 0x02, 0x6B, 0x32, 0x20, 0xD8, 0x0C, 14, 9, 1 },
 	/* W25Q128FV and W25Q128JV*/
-	{ 0xef4018, 128, 8, 0x03, 0x02, 0x6B, 0x32, 0x20, 0xD8, 0x0C, 15, 9, 0 },
+	{ 0xef4018, 128, 8, 0x03, 0x02, 0x6B, 0x32, 0x20, 0xD8, 0x0C, 15, 9, 1 },
 	/* W25Q256F/J */
-	{ 0xef4019, 128, 8, 0x13, 0x02, 0x6C, 0x32, 0x20, 0xD8, 0x3C, 16, 9, 0 },
+	{ 0xef4019, 128, 8, 0x13, 0x02, 0x6C, 0x32, 0x20, 0xD8, 0x3C, 16, 9, 1 },
 	/* W25Q32JW */
 	{ 0xef6016, 128, 8, 0x03, 0x02, 0x6B, 0x32, 0x20, 0xD8, 0x0C, 13, 9, 0 },
 	/* W25Q64FWSSIG */
@@ -69,9 +76,9 @@ static struct flash_info spi_flash_tbl[] = {
 	/* MX25L3233FM2I-08G */
 	{ 0xc22016, 128, 8, 0x03, 0x02, 0x6B, 0x38, 0x20, 0xD8, 0x0E, 13, 6, 0 },
 	/* MX25L6433F */
-	{ 0xc22017, 128, 8, 0x03, 0x02, 0x6B, 0x38, 0x20, 0xD8, 0x0E, 14, 6, 0 },
+	{ 0xc22017, 128, 8, 0x03, 0x02, 0x6B, 0x38, 0x20, 0xD8, 0x0E, 14, 6, 1 },
 	/* MX25L12835E/F MX25L12833FMI-10G */
-	{ 0xc22018, 128, 8, 0x03, 0x02, 0x6B, 0x38, 0x20, 0xD8, 0x0E, 15, 6, 0 },
+	{ 0xc22018, 128, 8, 0x03, 0x02, 0x6B, 0x38, 0x20, 0xD8, 0x0E, 15, 6, 1 },
 	/* MX25L25635E/F MX25L25645G MX25L25645GMI-08G */
 	{ 0xc22019, 128, 8, 0x13, 0x12, 0x6C, 0x3E, 0x21, 0xDC, 0x1E, 16, 6, 0 },
 	/* MX25L51245GMI */
@@ -387,16 +394,20 @@ int snor_erase(struct SFNOR_DEV *p_dev,
 {
 	int ret;
 	struct rk_sfc_op op;
-	int timeout[] = {400, 2000, 40000};   /* ms */
+	int timeout[] = {400, 2000, 1600, 40000};   /* ms */
 
 	rkflash_print_dio("%s %x %x\n", __func__, addr, erase_type);
 
 	if (erase_type > ERASE_CHIP)
 		return SFC_PARAM_ERR;
 
+	snor_wait(p_dev);
+
 	op.sfcmd.d32 = 0;
 	if (erase_type == ERASE_BLOCK64K)
 		op.sfcmd.b.cmd = p_dev->blk_erase_cmd;
+	else if (erase_type == ERASE_BLOCK32K)
+		op.sfcmd.b.cmd = p_dev->blk32_erase_cmd;
 	else if (erase_type == ERASE_SECTOR)
 		op.sfcmd.b.cmd = p_dev->sec_erase_cmd;
 	else
@@ -430,6 +441,8 @@ int snor_prog_page(struct SFNOR_DEV *p_dev,
 
 	rkflash_print_dio("%s %x %x\n", __func__, addr, *(u32 *)(p_data));
 
+	snor_wait(p_dev);
+
 	op.sfcmd.d32 = 0;
 	op.sfcmd.b.cmd = p_dev->prog_cmd;
 	op.sfcmd.b.addrbits = SFC_ADDR_24BITS;
@@ -454,6 +467,16 @@ int snor_prog_page(struct SFNOR_DEV *p_dev,
 	return ret;
 }
 
+static bool snor_is_blank(const u8 *p_buf, u32 size)
+{
+	while (size--) {
+		if (*p_buf++ != 0xFF)
+			return false;
+	}
+
+	return true;
+}
+
 static int snor_prog(struct SFNOR_DEV *p_dev, u32 addr, void *p_data, u32 size)
 {
 	int ret = SFC_OK;
@@ -463,9 +486,12 @@ static int snor_prog(struct SFNOR_DEV *p_dev, u32 addr, void *p_data, u32 size)
 	page_size = NOR_PAGE_SIZE;
 	while (size) {
 		len = page_size < size ? page_size : size;
-		ret = snor_prog_page(p_dev, addr, p_buf, len);
-		if (ret != SFC_OK)
-			return ret;
+		/* Programming 0xFF leaves the flash as it is */
+		if (!snor_is_blank(p_buf, len)) {
+			ret = snor_prog_page(p_dev, addr, p_buf, len);
+			if (ret != SFC_OK)
+				return ret;
+		}
 
 		size -= len;
 		addr += len;
@@ -517,24 +543,71 @@ int snor_disable_QE(struct SFNOR_DEV *p_dev)
 	return p_dev->write_status(reg_index, status);
 }
 
-int snor_read_data(struct SFNOR_DEV *p_dev,
-		   u32 addr,
-		   void *p_data,
-		   u32 size)
+/*
+ * QPI only lasts for one snor_read(), so every other command, the next
+ * loader stage and the kernel all find the flash in SPI mode.
+ */
+static int snor_enter_qpi(struct SFNOR_DEV *p_dev)
 {
 	int ret;
 	struct rk_sfc_op op;
 
+	op.sfcmd.d32 = 0;
+	op.sfcmd.b.cmd = p_dev->qpi_enter_cmd;
+
+	op.sfctrl.d32 = 0;
+
+	ret = sfc_request(&op, 0, NULL, 0);
+	if (ret == SFC_OK)
+		p_dev->io_mode = IO_MODE_QPI;
+
+	return ret;
+}
+
+static int snor_exit_qpi(struct SFNOR_DEV *p_dev)
+{
+	struct rk_sfc_op op;
+
+	op.sfcmd.d32 = 0;
+	op.sfcmd.b.cmd = p_dev->qpi_exit_cmd;
+
+	op.sfctrl.d32 = 0;
+	op.sfctrl.b.cmdlines = SFC_4BITS_LINE;
+
+	p_dev->io_mode = IO_MODE_SPI;
+
+	return sfc_request(&op, 0, NULL, 0);
+}
+
+static int snor_read_op(struct SFNOR_DEV *p_dev, u32 addr, void *p_data,
+			u32 size, enum snor_xfer xfer)
+{
+	struct rk_sfc_op op;
+
 	op.sfcmd.d32 = 0;
 	op.sfcmd.b.cmd = p_dev->read_cmd;
 	op.sfcmd.b.addrbits = SFC_ADDR_24BITS;
 
 	op.sfctrl.d32 = 0;
 	op.sfctrl.b.datalines = p_dev->read_lines;
-	if (!(size & 0x3) && size >= 4)
+	if (xfer == SNOR_XFER_DMA)
 		op.sfctrl.b.enbledma = 1;
 
-	if (p_dev->read_cmd == CMD_FAST_READ_X1 ||
+	if (p_dev->io_mode == IO_MODE_QPI) {
+		op.sfcmd.b.cmd = p_dev->qpi_read_cmd;
+		op.sfctrl.b.cmdlines = SFC_4BITS_LINE;
+		op.sfctrl.b.addrlines = SFC_4BITS_LINE;
+		op.sfctrl.b.datalines = DATA_LINES_X4;
+		if (p_dev->qpi_mode_clks == 2 &&
+		    p_dev->addr_mode == ADDR_MODE_3BYTE) {
+			op.sfcmd.b.addrbits = SFC_ADDR_32BITS;
+			addr = (addr << 8) | 0xFF;	/* Set M[7:0] = 0xFF */
+			op.sfcmd.b.dummybits = p_dev->qpi_dummy;
+		} else {
+			op.sfcmd.b.dummybits = p_dev->qpi_mode_clks +
+					       p_dev->qpi_dummy;
+		}
+	} else if (p_dev->read_cmd == CMD_FAST_READ_X1 ||
 	    p_dev->read_cmd == CMD_PAGE_FASTREAD4B ||
 	    p_dev->read_cmd == CMD_FAST_READ_X4 ||
 	    p_dev->read_cmd == CMD_FAST_READ_X2 ||
@@ -543,19 +616,117 @@ int snor_read_data(struct SFNOR_DEV *p_dev,
 	} else if (p_dev->read_cmd == CMD_FAST_READ_A4) {
 		op.sfcmd.b.addrbits = SFC_ADDR_32BITS;
 		addr = (addr << 8) | 0xFF;	/* Set M[7:0] = 0xFF */
-		op.sfcmd.b.dummybits = 4;
+		op.sfcmd.b.dummybits = p_dev->read_dummy;
 		op.sfctrl.b.addrlines = SFC_4BITS_LINE;
 	}
 
 	if (p_dev->addr_mode == ADDR_MODE_4BYTE)
 		op.sfcmd.b.addrbits = SFC_ADDR_32BITS;
 
-	ret = sfc_request(&op, addr, p_data, size);
+	if (xfer == SNOR_XFER_DMA_ASYNC)
+		return sfc_request_async(&op, addr, p_data, size);
+
+	return sfc_request(&op, addr, p_data, size);
+}
+
+/*
+ * Split a read so the DMA covers only whole cache lines of @p_data and goes
+ * straight to it, leaving the unaligned head and tail to PIO, instead of a
+ * bounce buffer copy of the whole transfer.
+ */
+static void snor_dma_split(void *p_data, u32 size, u32 *head, u32 *body)
+{
+	*head = min_t(u32, size, -(ulong)p_data & (ARCH_DMA_MINALIGN - 1));
+	*body = round_down(size - *head, ARCH_DMA_MINALIGN);
+}
+
+int snor_read_data(struct SFNOR_DEV *p_dev,
+		   u32 addr,
+		   void *p_data,
+		   u32 size)
+{
+	int ret = SFC_OK;
+	u8 *p_buf = (u8 *)p_data;
+	u32 head, body;
+
+	snor_dma_split(p_data, size, &head, &body);
+	if (!body) {
+		ret = snor_read_op(p_dev, addr, p_data, size,
+				   !(size & 0x3) && size >= 4 ?
+				   SNOR_XFER_DMA : SNOR_XFER_PIO);
+	} else {
+		if (head)
+			ret = snor_read_op(p_dev, addr, p_buf, head,
+					   SNOR_XFER_PIO);
+		if (ret == SFC_OK)
+			ret = snor_read_op(p_dev, addr + head, p_buf + head,
+					   body, SNOR_XFER_DMA);
+		if (ret == SFC_OK && size > head + body)
+			ret = snor_read_op(p_dev, addr + head + body,
+					   p_buf + head + body,
+					   size - head - body, SNOR_XFER_PIO);
+	}
 	rkflash_print_dio("%s %x %x\n", __func__, addr, *(u32 *)(p_data));
 
 	return ret;
 }
 
+/* Short reads come straight from the AHB window, no command or DMA setup */
+static int snor_read_xip(u32 addr, void *p_data, u32 size)
+{
+	void __iomem *window;
+	u32 *p_word = (u32 *)p_data;
+	u8 *p_byte = (u8 *)p_data;
+	u32 i;
+
+	if (size > SNOR_XIP_MAX_SIZE)
+		return SFC_PARAM_ERR;
+
+	window = sfc_xmmc_map();
+	if (!window)
+		return SFC_ERROR;
+
+	/* Device memory, no unaligned or vector accesses */
+	if (!((ulong)p_data & 0x3)) {
+		for (i = 0; i < size; i += 4)
+			*p_word++ = readl(window + addr + i);
+	} else {
+		for (i = 0; i < size; i++)
+			*p_byte++ = readb(window + addr + i);
+	}
+
+	return SFC_OK;
+}
+
+int snor_xip_init(struct SFNOR_DEV *p_dev, void __iomem *window, u32 size)
+{
+	struct rk_sfc_op op;
+
+	if ((u64)p_dev->capacity << 9 > size)
+		return SFC_PARAM_ERR;
+
+	op.sfcmd.d32 = 0;
+	op.sfcmd.b.cmd = p_dev->read_cmd;
+	op.sfcmd.b.addrbits = SFC_ADDR_24BITS;
+	if (p_dev->addr_mode == ADDR_MODE_4BYTE)
+		op.sfcmd.b.addrbits = SFC_ADDR_32BITS;
+
+	op.sfctrl.d32 = 0;
+	op.sfctrl.b.datalines = p_dev->read_lines;
+
+	/* 1-4-4 needs the mode bits in the address, use 1-1-4 instead */
+	if (p_dev->read_cmd == CMD_FAST_READ_A4)
+		op.sfcmd.b.cmd = CMD_FAST_READ_X4;
+	if (op.sfcmd.b.cmd == CMD_FAST_READ_X1 ||
+	    op.sfcmd.b.cmd == CMD_PAGE_FASTREAD4B ||
+	    op.sfcmd.b.cmd == CMD_FAST_READ_X4 ||
+	    op.sfcmd.b.cmd == CMD_FAST_READ_X2 ||
+	    op.sfcmd.b.cmd == CMD_FAST_4READ_X4)
+		op.sfcmd.b.dummybits = 8;
+
+	return sfc_xmmc_init(window, &op, size);
+}
+
 int snor_read(struct SFNOR_DEV *p_dev, u32 sec, u32 n_sec, void *p_data)
 {
 	int ret = SFC_OK;
@@ -564,11 +735,20 @@ int snor_read(struct SFNOR_DEV *p_dev, u32 sec, u32 n_sec, void *p_data)
 
 	rkflash_print_dio("%s %x %x\n", __func__, sec, n_sec);
 
+	ret = snor_wait(p_dev);
+	if (ret != SFC_OK)
+		return ret;
+
 	if ((sec + n_sec) > p_dev->capacity)
 		return SFC_PARAM_ERR;
 
 	addr = sec << 9;
 	size = n_sec << 9;
+	if (snor_read_xip(addr, p_data, size) == SFC_OK)
+		return n_sec;
+
+	if (p_dev->qpi_read_cmd)
+		snor_enter_qpi(p_dev);
 	while (size) {
 		len = size < p_dev->max_iosize ? size : p_dev->max_iosize;
 		ret = snor_read_data(p_dev, addr, p_buf, len);
@@ -583,16 +763,151 @@ int snor_read(struct SFNOR_DEV *p_dev, u32 sec, u32 n_sec, void *p_data)
 		p_buf += len;
 	}
 out:
+	if (p_dev->io_mode == IO_MODE_QPI)
+		snor_exit_qpi(p_dev);
 	if (!ret)
 		ret = n_sec;
 
 	return ret;
 }
 
+/*
+ * Start reading as much of @n_sec as one transfer allows and return the
+ * number of sectors queued. The cache-aligned body is left to DMA in the
+ * background, snor_wait() then reads the unaligned tail.
+ */
+int snor_read_async(struct SFNOR_DEV *p_dev, u32 sec, u32 n_sec, void *p_data)
+{
+	int ret;
+	u32 addr, size, head, body;
+	u8 *p_buf = (u8 *)p_data;
+
+	rkflash_print_dio("%s %x %x\n", __func__, sec, n_sec);
+
+	ret = snor_wait(p_dev);
+	if (ret != SFC_OK)
+		return ret;
+
+	if ((sec + n_sec) > p_dev->capacity)
+		return SFC_PARAM_ERR;
+
+	addr = sec << 9;
+	size = min_t(u32, n_sec << 9, p_dev->max_iosize & ~511);
+	snor_dma_split(p_data, size, &head, &body);
+	if (!body)
+		return snor_read(p_dev, sec, size >> 9, p_data);
+
+	if (p_dev->qpi_read_cmd)
+		snor_enter_qpi(p_dev);
+
+	if (head) {
+		ret = snor_read_op(p_dev, addr, p_buf, head, SNOR_XFER_PIO);
+		if (ret != SFC_OK)
+			goto out;
+	}
+
+	ret = snor_read_op(p_dev, addr + head, p_buf + head, body,
+			   SNOR_XFER_DMA_ASYNC);
+	if (ret != SFC_OK)
+		goto out;
+
+	p_dev->async_pending = 1;
+	p_dev->async_addr = addr + head + body;
+	p_dev->async_buf = p_buf + head + body;
+	p_dev->async_tail = size - head - body;
+
+	return size >> 9;
+out:
+	if (p_dev->io_mode == IO_MODE_QPI)
+		snor_exit_qpi(p_dev);
+
+	return ret;
+}
+
+int snor_wait(struct SFNOR_DEV *p_dev)
+{
+	int ret;
+
+	if (!p_dev->async_pending)
+		return SFC_OK;
+
+	p_dev->async_pending = 0;
+	ret = sfc_wait();
+	if (ret == SFC_OK && p_dev->async_tail)
+		ret = snor_read_op(p_dev, p_dev->async_addr, p_dev->async_buf,
+				   p_dev->async_tail, SNOR_XFER_PIO);
+
+	if (p_dev->io_mode == IO_MODE_QPI)
+		snor_exit_qpi(p_dev);
+	if (ret != SFC_OK)
+		rkflash_print_error("%s %x ret= %x\n", __func__,
+				    p_dev->async_addr >> 9, ret);
+
+	return ret;
+}
+
+/* The largest erase at @sec that does not go past @end */
+static enum NOR_ERASE_TYPE snor_erase_type(struct SFNOR_DEV *p_dev, u32 sec,
+					   u32 end, u32 *len)
+{
+	/* Only 4 KB erases in the first and last 256 KB, as before */
+	if (sec >= 512 && sec < p_dev->capacity - 512) {
+		if (!(sec & (p_dev->blk_size - 1)) &&
+		    end - sec >= p_dev->blk_size) {
+			*len = p_dev->blk_size;
+			return ERASE_BLOCK64K;
+		}
+		if (p_dev->blk32_erase_cmd && !(sec & (NOR_SECS_32K - 1)) &&
+		    end - sec >= NOR_SECS_32K) {
+			*len = NOR_SECS_32K;
+			return ERASE_BLOCK32K;
+		}
+	}
+	*len = NOR_SECS_PAGE;
+
+	return ERASE_SECTOR;
+}
+
+#ifdef CONFIG_RKSFC_NOR_WRITE_COMPARE
+enum snor_cmp {
+	SNOR_CMP_DIFF = 0,
+	SNOR_CMP_BLANK,		/* erased already, only needs programming */
+	SNOR_CMP_SAME
+};
+
+static u8 snor_cmp_buf[NOR_SECS_PAGE << 9] __aligned(ARCH_DMA_MINALIGN);
+
+static enum snor_cmp snor_write_cmp(struct SFNOR_DEV *p_dev, u32 sec,
+				    u32 n_sec, const u8 *p_buf)
+{
+	bool same = true, blank = true;
+	u32 len;
+
+	while (n_sec && (same || blank)) {
+		len = min_t(u32, n_sec, NOR_SECS_PAGE);
+		if (snor_read(p_dev, sec, len, snor_cmp_buf) != len)
+			return SNOR_CMP_DIFF;
+		if (same && memcmp(snor_cmp_buf, p_buf, len << 9))
+			same = false;
+		if (blank && !snor_is_blank(snor_cmp_buf, len << 9))
+			blank = false;
+		sec += len;
+		n_sec -= len;
+		p_buf += len << 9;
+	}
+
+	if (same)
+		return SNOR_CMP_SAME;
+
+	return blank ? SNOR_CMP_BLANK : SNOR_CMP_DIFF;
+}
+#endif
+
 int snor_write(struct SFNOR_DEV *p_dev, u32 sec, u32 n_sec, void *p_data)
 {
 	int ret = SFC_OK;
-	u32 len, blk_size, offset;
+	u32 len, erase_len, end, erase_end;
+	enum NOR_ERASE_TYPE erase_type;
 	u8 *p_buf =  (u8 *)p_data;
 	u32 total_sec = n_sec;
 
@@ -601,32 +916,53 @@ int snor_write(struct SFNOR_DEV *p_dev, u32 sec, u32 n_sec, void *p_data)
 	if ((sec + n_sec) > p_dev->capacity)
 		return SFC_PARAM_ERR;
 
-	while (n_sec) {
-		if (sec < 512 || sec >= p_dev->capacity  - 512)
-			blk_size = 8;
-		else
-			blk_size = p_dev->blk_size;
-
-		offset = (sec & (blk_size - 1));
-		if (!offset) {
-			ret = snor_erase(p_dev, sec << 9, (blk_size == 8) ?
-				ERASE_SECTOR : ERASE_BLOCK64K);
+	/*
+	 * Every 4 KB sector the write starts is erased, a partial one at the
+	 * beginning was erased by the write before. Each erase is as large as
+	 * the range allows and is skipped if the flash holds the data already.
+	 * Only an erase the write covers entirely may be skipped: the next
+	 * write goes on in a partial one without erasing it.
+	 */
+	end = sec + n_sec;
+	erase_end = round_up(end, NOR_SECS_PAGE);
+	len = min(round_up(sec, NOR_SECS_PAGE), end) - sec;
+	while (sec < end) {
+		if (!len) {
+			erase_type = snor_erase_type(p_dev, sec, erase_end,
+						     &erase_len);
+			len = min(erase_len, end - sec);
+#ifdef CONFIG_RKSFC_NOR_WRITE_COMPARE
+			switch (len < erase_len ? SNOR_CMP_DIFF :
+				snor_write_cmp(p_dev, sec, len, p_buf)) {
+			case SNOR_CMP_SAME:
+				goto next;
+			case SNOR_CMP_BLANK:
+				goto prog;
+			default:
+				break;
+			}
+#endif
+			ret = snor_erase(p_dev, sec << 9, erase_type);
 			if (ret != SFC_OK) {
 				rkflash_print_error("snor_erase %x ret= %x\n",
 						    sec, ret);
 				goto out;
 			}
 		}
-		len = (blk_size - offset) < n_sec ?
-		      (blk_size - offset) : n_sec;
+#ifdef CONFIG_RKSFC_NOR_WRITE_COMPARE
+prog:
+#endif
 		ret = snor_prog(p_dev, sec << 9, p_buf, len << 9);
 		if (ret != SFC_OK) {
 			rkflash_print_error("snor_prog %x ret= %x\n", sec, ret);
 			goto out;
 		}
-		n_sec -= len;
+#ifdef CONFIG_RKSFC_NOR_WRITE_COMPARE
+next:
+#endif
 		sec += len;
 		p_buf += len << 9;
+		len = 0;
 	}
 out:
 	if (!ret)
@@ -650,7 +986,7 @@ int snor_read_id(u8 *data)
 	return ret;
 }
 
-static int snor_read_parameter(u32 addr, u8 *data)
+static int snor_read_parameter(u32 addr, u8 *data, u32 size)
 {
 	int ret;
 	struct rk_sfc_op op;
@@ -662,11 +998,83 @@ static int snor_read_parameter(u32 addr, u8 *data)
 
 	op.sfctrl.d32 = 0;
 
-	ret = sfc_request(&op, addr, data, 1);
+	ret = sfc_request(&op, addr, data, size);
 
 	return ret;
 }
 
+/*
+ * The SFDP basic flash parameter table gives the wait states of the fast
+ * reads at their power-on setting, and tells if and how the part enters
+ * QPI (4-4-4) mode.
+ */
+static void snor_parse_sfdp(struct SFNOR_DEV *p_dev, bool qpi)
+{
+	u32 hdr[4], bfpt[SFDP_BFPT_DWORDS];
+	u32 len, enable, disable, mode_clks, dummy, erase, i;
+	u8 enter_cmd, exit_cmd;
+
+	if (snor_read_parameter(0, (u8 *)hdr, sizeof(hdr)) != SFC_OK ||
+	    hdr[0] != SFDP_SIGNATURE)
+		return;
+
+	/* The first parameter header is the basic flash parameter table */
+	if ((hdr[2] & 0xFF) != 0x00 || (hdr[3] >> 24) != 0xFF)
+		return;
+
+	len = min_t(u32, hdr[2] >> 24, SFDP_BFPT_DWORDS);
+	memset(bfpt, 0, sizeof(bfpt));
+	if (snor_read_parameter(hdr[3] & 0xFFFFFF, (u8 *)bfpt, len * 4) !=
+	    SFC_OK)
+		return;
+
+	/* 1-4-4: DWORD3[7:5] mode clocks, DWORD3[4:0] wait states */
+	if (p_dev->read_cmd == CMD_FAST_READ_A4 && bfpt[0] & BIT(21) &&
+	    ((bfpt[2] >> 5) & 0x7) == 2)
+		p_dev->read_dummy = bfpt[2] & 0x1F;
+
+	/* DWORD8-9: erase types, [7:0] log2 of the size, [15:8] opcode */
+	for (i = 0; i < 4 && len >= 9; i++) {
+		erase = bfpt[7 + i / 2] >> (i % 2 * 16);
+		if ((erase & 0xFF) == SFDP_ERASE_32K) {
+			p_dev->blk32_erase_cmd = (erase >> 8) & 0xFF;
+			break;
+		}
+	}
+
+	/* 4-4-4: DWORD5[4] supported, DWORD15 enable and disable sequence */
+	if (!qpi || len < 15 || !(bfpt[4] & BIT(4)))
+		return;
+
+	enable = (bfpt[14] >> 4) & 0x1F;
+	disable = bfpt[14] & 0xF;
+	if (enable & (BIT(0) | BIT(1)))
+		enter_cmd = CMD_ENTER_QPI;
+	else if (enable & BIT(2))
+		enter_cmd = CMD_ENTER_QPI_MXIC;
+	else
+		return;
+
+	if (disable & BIT(0))
+		exit_cmd = CMD_EXIT_QPI;
+	else if (disable & BIT(1))
+		exit_cmd = CMD_EXIT_QPI_MXIC;
+	else
+		return;
+
+	/* DWORD7[31:24] opcode, [23:21] mode clocks, [20:16] wait states */
+	mode_clks = (bfpt[6] >> 21) & 0x7;
+	dummy = (bfpt[6] >> 16) & 0x1F;
+	if (!(bfpt[6] >> 24) || mode_clks + dummy > 0xF)
+		return;
+
+	p_dev->qpi_read_cmd = bfpt[6] >> 24;
+	p_dev->qpi_mode_clks = mode_clks;
+	p_dev->qpi_dummy = dummy;
+	p_dev->qpi_enter_cmd = enter_cmd;
+	p_dev->qpi_exit_cmd = exit_cmd;
+}
+
 u32 snor_get_capacity(struct SFNOR_DEV *p_dev)
 {
 	return p_dev->capacity;
@@ -692,7 +1100,7 @@ static void *snor_flash_info_adjust(struct flash_info *spi_flash_info)
 
 	if (spi_flash_info->id == 0xc84019) {
 		addr = 0x09;
-		snor_read_parameter(addr, &para_version);
+		snor_read_parameter(addr, &para_version, 1);
 		if (para_version == 0x06) {
 			spi_flash_info->QE_bits = 9;
 			spi_flash_info->prog_cmd_4 = 0x34;
@@ -705,6 +1113,7 @@ static int snor_parse_flash_table(struct SFNOR_DEV *p_dev,
 				  struct flash_info *g_spi_flash_info)
 {
 	int i, ret;
+	bool qpi;
 
 	if (g_spi_flash_info) {
 		snor_flash_info_adjust(g_spi_flash_info);
@@ -721,6 +1130,8 @@ static int snor_parse_flash_table(struct SFNOR_DEV *p_dev,
 		p_dev->read_lines = DATA_LINES_X1;
 		p_dev->QE_bits = g_spi_flash_info->QE_bits;
 		p_dev->addr_mode = ADDR_MODE_3BYTE;
+		p_dev->read_dummy = 4;
+		p_dev->qpi_read_cmd = 0;
 
 		i = g_spi_flash_info->feature & FEA_READ_STATUE_MASK;
 		if (i == 0)
@@ -752,6 +1163,21 @@ static int snor_parse_flash_table(struct SFNOR_DEV *p_dev,
 		if (g_spi_flash_info->feature & FEA_4BYTE_ADDR)
 			p_dev->addr_mode = ADDR_MODE_4BYTE;
 
+		/*
+		 * QPI needs QE set, and its EBh takes a 4-byte address only
+		 * once the part is put into 4-byte address mode. Read SFDP
+		 * before that, it always has a 3-byte address.
+		 */
+		qpi = g_spi_flash_info->ext_feature & EXT_FEA_QPI_READ &&
+		      p_dev->read_lines == DATA_LINES_X4 &&
+		      (!(g_spi_flash_info->feature & FEA_4BYTE_ADDR) ||
+		       g_spi_flash_info->feature & FEA_4BYTE_ADDR_MODE);
+		snor_parse_sfdp(p_dev, qpi);
+		/* The SFDP opcodes take a 4-byte address in 4-byte mode only */
+		if ((g_spi_flash_info->feature & FEA_4BYTE_ADDR) &&
+		    !(g_spi_flash_info->feature & FEA_4BYTE_ADDR_MODE))
+			p_dev->blk32_erase_cmd = 0;
+
 		if ((g_spi_flash_info->feature & FEA_4BYTE_ADDR_MODE))
 			snor_enter_4byte_mode();
 	}
@@ -803,6 +1229,7 @@ int snor_init(struct SFNOR_DEV *p_dev)
 	rkflash_print_info("read_lines: %x\n", p_dev->read_lines);
 	rkflash_print_info("prog_lines: %x\n", p_dev->prog_lines);
 	rkflash_print_info("read_cmd: %x\n", p_dev->read_cmd);
+	rkflash_print_info("qpi_read_cmd: %x\n", p_dev->qpi_read_cmd);
 	rkflash_print_info("prog_cmd: %x\n", p_dev->prog_cmd);
 	rkflash_print_info("blk_erase_cmd: %x\n", p_dev->blk_erase_cmd);
 	rkflash_print_info("sec_erase_cmd: %x\n", p_dev->sec_erase_cmd);
@@ -814,7 +1241,7 @@ int snor_init(struct SFNOR_DEV *p_dev)
 int snor_reinit_from_table_packet(struct SFNOR_DEV *p_dev,
 				  struct snor_info_packet *packet)
 {
-	struct flash_info g_spi_flash_info;
+	struct flash_info g_spi_flash_info, *info;
 	u8 id_byte[5];
 	int ret;
 
@@ -839,6 +1266,8 @@ int snor_reinit_from_table_packet(struct SFNOR_DEV *p_dev,
 	g_spi_flash_info.feature = packet->feature;
 	g_spi_flash_info.density = id_byte[2] - 9;
 	g_spi_flash_info.QE_bits = packet->QE_bits;
+	info = snor_get_flash_info(id_byte);
+	g_spi_flash_info.ext_feature = info ? info->ext_feature : 0;
 
 	ret = snor_parse_flash_table(p_dev, &g_spi_flash_info);
 
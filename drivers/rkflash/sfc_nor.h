@@ -13,6 +13,8 @@
 #define NOR_BLOCK_SIZE		(64 * 1024)
 #define NOR_SECS_BLK		(NOR_BLOCK_SIZE / 512)
 #define NOR_SECS_PAGE		8
+#define NOR_SECS_32K		64
+#define SNOR_XIP_MAX_SIZE	(4 * 1024)
 
 #define FEA_READ_STATUE_MASK	(0x3 << 0)
 #define FEA_STATUE_MODE1	0
@@ -22,6 +24,9 @@
 #define FEA_4BYTE_ADDR		BIT(4)
 #define FEA_4BYTE_ADDR_MODE	BIT(5)
 
+/* flash_info.ext_feature, checked against SFDP before use */
+#define EXT_FEA_QPI_READ	BIT(0)
+
 /*Command Set*/
 #define CMD_READ_JEDECID        (0x9F)
 #define CMD_READ_DATA           (0x03)
@@ -70,10 +75,20 @@
 #define CMD_ENABLE_RESER	(0x66)
 #define CMD_RESET_DEVICE	(0x99)
 #define CMD_READ_PARAMETER	(0x5A)
+#define CMD_ENTER_QPI		(0x38)
+#define CMD_ENTER_QPI_MXIC	(0x35)
+#define CMD_EXIT_QPI		(0xFF)
+#define CMD_EXIT_QPI_MXIC	(0xF5)
+
+/* SFDP, JESD216 */
+#define SFDP_SIGNATURE		0x50444653	/* "SFDP" */
+#define SFDP_BFPT_DWORDS	16
+#define SFDP_ERASE_32K		15	/* log2 of the erase type size */
 
 enum NOR_ERASE_TYPE {
 	ERASE_SECTOR = 0,
 	ERASE_BLOCK64K,
+	ERASE_BLOCK32K,
 	ERASE_CHIP
 };
 
@@ -117,6 +132,19 @@ struct SFNOR_DEV {
 
 	SNOR_WRITE_STATUS write_status;
 	u32 max_iosize;
+
+	u8 read_dummy;		/* CMD_FAST_READ_A4 wait states, 0 for default */
+	u8 qpi_read_cmd;	/* 4-4-4 read, 0 if QPI is not used */
+	u8 qpi_mode_clks;
+	u8 qpi_dummy;
+	u8 qpi_enter_cmd;
+	u8 qpi_exit_cmd;
+	u8 blk32_erase_cmd;	/* 32 KB erase from SFDP, 0 if none */
+
+	u8 async_pending;	/* snor_read_async() waiting for snor_wait() */
+	u32 async_addr;		/* unaligned tail, read by PIO in snor_wait() */
+	u32 async_tail;
+	void *async_buf;
 };
 
 struct flash_info {
@@ -135,7 +163,7 @@ struct flash_info {
 	u8 feature;
 	u8 density;  /* (1 << density) sectors*/
 	u8 QE_bits;
-	u8 reserved2;
+	u8 ext_feature;
 };
 
 /* flash table packet for easy boot */
@@ -172,6 +200,9 @@ int snor_erase(struct SFNOR_DEV *p_dev,
 int snor_read_id(u8 *data);
 int snor_prog_page(struct SFNOR_DEV *p_dev, u32 addr, void *p_data, u32 size);
 int snor_read_data(struct SFNOR_DEV *p_dev, u32 addr, void *p_data, u32 size);
+int snor_read_async(struct SFNOR_DEV *p_dev, u32 sec, u32 n_sec, void *p_data);
+int snor_wait(struct SFNOR_DEV *p_dev);
+int snor_xip_init(struct SFNOR_DEV *p_dev, void __iomem *window, u32 size);
 int snor_reset_device(void);
 int snor_disable_QE(struct SFNOR_DEV *p_dev);
 int snor_reinit_from_table_packet(struct SFNOR_DEV *p_dev,
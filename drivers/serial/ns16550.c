@@ -394,6 +394,32 @@ static inline int _debug_uart_setbrg(void)
 
 DEBUG_UART_FUNCS
 
+#if CONFIG_IS_ENABLED(CONSOLE_TX_BUFFER)
+int debug_uart_putc_nowait(int ch)
+{
+	struct NS16550 *com_port;
+
+	if (gd && gd->flags & GD_FLG_DISABLE_CONSOLE)
+		return 0;
+
+	if (gd && gd->serial.addr)
+		com_port = (struct NS16550 *)gd->serial.addr;
+	else
+		com_port = (struct NS16550 *)CONFIG_DEBUG_UART_BASE;
+
+	/*
+	 * UART_USR: bit1 trans_fifo_not_full:
+	 *	0 = Transmit FIFO is full
+	 *	1 = Transmit FIFO is not full
+	 */
+	if (!(serial_din(&com_port->rbr + 0x1f) & 0x02))
+		return -EAGAIN;
+	serial_dout(&com_port->thr, ch);
+
+	return 0;
+}
+#endif
+
 #endif
 
 #ifdef CONFIG_DEBUG_UART_OMAP
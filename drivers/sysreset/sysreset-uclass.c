@@ -6,6 +6,8 @@
  */
 
 #include <common.h>
+#include <android_ab.h>
+#include <blk.h>
 #include <sysreset.h>
 #include <dm.h>
 #include <errno.h>
@@ -73,6 +75,12 @@ void sysreset_walk_halt(enum sysreset_t type)
 {
 	int ret;
 
+#ifndef CONFIG_SPL_BUILD
+	/* Writes still held in memory, as in do_reset() of arch/arm/lib */
+	android_misc_flush();
+	blkcache_flush_all();
+#endif
+
 	ret = sysreset_walk(type);
 
 	/* Wait for the reset to take effect */
@@ -18,6 +18,7 @@
 #include <scsi.h>
 #include <asm/io.h>
 #include <asm/dma-mapping.h>
+#include <asm/unaligned.h>
 #include <linux/bitops.h>
 #include <linux/delay.h>
 
@@ -57,9 +58,17 @@
 /* Timeout after 30 msecs if NOP OUT hangs without response */
 #define NOP_OUT_TIMEOUT    1500 /* msecs */
 
-/* Only use one Task Tag for all requests */
+/* Task Tag of all requests but the pipelined reads and writes */
 #define TASK_TAG	0
 
+/*
+ * Slots a large READ/WRITE is split over, so the device works on the next
+ * chunk while the current one is transferred. Chunks below
+ * UFS_PIPELINE_MIN_SIZE are not worth an extra request.
+ */
+#define UFSHCD_MAX_SLOTS	8
+#define UFS_PIPELINE_MIN_SIZE	(1024 * 1024)
+
 /* Expose the flag value from utp_upiu_query.value */
 #define MASK_QUERY_UPIU_FLAG_LOC 0xFF
 
@@ -648,21 +657,25 @@ static void ufshcd_host_memory_configure(struct ufs_hba *hba)
 	dma_addr_t cmd_desc_dma_addr;
 	u16 response_offset;
 	u16 prdt_offset;
+	int i;
+
+	response_offset = offsetof(struct utp_transfer_cmd_desc, response_upiu);
+	prdt_offset = offsetof(struct utp_transfer_cmd_desc, prd_table);
 
-	utrdlp = hba->utrdl;
-	cmd_desc_dma_addr = (dma_addr_t)hba->ucdl;
+	for (i = 0; i < hba->nutrs; i++) {
+		utrdlp = &hba->utrdl[i];
+		cmd_desc_dma_addr = (dma_addr_t)&hba->ucdl[i];
 
-	utrdlp->command_desc_base_addr_lo =
+		utrdlp->command_desc_base_addr_lo =
 				cpu_to_le32(lower_32_bits(cmd_desc_dma_addr));
-	utrdlp->command_desc_base_addr_hi =
+		utrdlp->command_desc_base_addr_hi =
 				cpu_to_le32(upper_32_bits(cmd_desc_dma_addr));
 
-	response_offset = offsetof(struct utp_transfer_cmd_desc, response_upiu);
-	prdt_offset = offsetof(struct utp_transfer_cmd_desc, prd_table);
-
-	utrdlp->response_upiu_offset = cpu_to_le16(response_offset >> 2);
-	utrdlp->prd_table_offset = cpu_to_le16(prdt_offset >> 2);
-	utrdlp->response_upiu_length = cpu_to_le16(ALIGNED_UPIU_SIZE >> 2);
+		utrdlp->response_upiu_offset = cpu_to_le16(response_offset >> 2);
+		utrdlp->prd_table_offset = cpu_to_le16(prdt_offset >> 2);
+		utrdlp->response_upiu_length =
+				cpu_to_le16(ALIGNED_UPIU_SIZE >> 2);
+	}
 
 	hba->ucd_req_ptr = (struct utp_upiu_req *)hba->ucdl;
 	hba->ucd_rsp_ptr =
@@ -676,19 +689,21 @@ static void ufshcd_host_memory_configure(struct ufs_hba *hba)
  */
 static int ufshcd_memory_alloc(struct ufs_hba *hba)
 {
-	/* Allocate one Transfer Request Descriptor
+	/* Allocate a Transfer Request Descriptor per slot
 	 * Should be aligned to 1k boundary.
 	 */
-	hba->utrdl = memalign(1024, sizeof(struct utp_transfer_req_desc));
+	hba->utrdl = memalign(1024, sizeof(struct utp_transfer_req_desc) *
+			      hba->nutrs);
 	if (!hba->utrdl) {
 		dev_err(hba->dev, "Transfer Descriptor memory allocation failed\n");
 		return -ENOMEM;
 	}
 
-	/* Allocate one Command Descriptor
+	/* Allocate a Command Descriptor per slot
 	 * Should be aligned to 1k boundary.
 	 */
-	hba->ucdl = memalign(1024, sizeof(struct utp_transfer_cmd_desc));
+	hba->ucdl = memalign(1024, sizeof(struct utp_transfer_cmd_desc) *
+			     hba->nutrs);
 	if (!hba->ucdl) {
 		dev_err(hba->dev, "Command descriptor memory allocation failed\n");
 		return -ENOMEM;
@@ -930,6 +945,50 @@ static int ufshcd_send_command(struct ufs_hba *hba, unsigned int task_tag)
 	return 0;
 }
 
+/**
+ * ufshcd_send_commands - ring the doorbell of several prepared slots
+ * @hba: per adapter instance
+ * @tags: bitmask of the slots
+ *
+ * Any request completing raises UTP_TRANSFER_REQ_COMPL, so wait for the
+ * controller to clear all the doorbell bits instead.
+ */
+static int ufshcd_send_commands(struct ufs_hba *hba, u32 tags)
+{
+	unsigned long start;
+	u32 intr_status;
+
+	ufshcd_writel(hba, tags, REG_UTP_TRANSFER_REQ_DOOR_BELL);
+
+	start = get_timer(0);
+	while (ufshcd_readl(hba, REG_UTP_TRANSFER_REQ_DOOR_BELL) & tags) {
+		intr_status = ufshcd_readl(hba, REG_INTERRUPT_STATUS);
+		ufshcd_writel(hba, intr_status, REG_INTERRUPT_STATUS);
+
+		if (intr_status & hba->intr_mask & UFSHCD_ERROR_MASK) {
+			dev_err(hba->dev, "Error in status:%08x\n",
+				intr_status);
+			goto abort;
+		}
+
+		if (get_timer(start) > QUERY_REQ_TIMEOUT) {
+			dev_err(hba->dev,
+				"Timedout waiting for UTP response\n");
+			goto abort;
+		}
+	}
+	ufshcd_writel(hba, ufshcd_readl(hba, REG_INTERRUPT_STATUS),
+		      REG_INTERRUPT_STATUS);
+
+	return 0;
+
+abort:
+	/* Writing 0 clears a slot, so it is free for the single request path */
+	ufshcd_writel(hba, ~tags, REG_UTP_TRANSFER_REQ_LIST_CLEAR);
+
+	return -ETIMEDOUT;
+}
+
 /**
  * ufshcd_get_req_rsp - returns the TR response transaction type
  */
@@ -942,9 +1001,9 @@ static inline int ufshcd_get_req_rsp(struct utp_upiu_rsp *ucd_rsp_ptr)
  * ufshcd_get_tr_ocs - Get the UTRD Overall Command Status
  *
  */
-static inline int ufshcd_get_tr_ocs(struct ufs_hba *hba)
+static inline int ufshcd_get_tr_ocs(struct ufs_hba *hba, int tag)
 {
-	return le32_to_cpu(hba->utrdl->header.dword_2) & MASK_OCS;
+	return le32_to_cpu(hba->utrdl[tag].header.dword_2) & MASK_OCS;
 }
 
 static inline int ufshcd_get_rsp_upiu_result(struct utp_upiu_rsp *ucd_rsp_ptr)
@@ -1017,7 +1076,7 @@ int ufshcd_exec_dev_cmd(struct ufs_hba *hba, enum dev_cmd_type cmd_type, int tim
 	if (err)
 		return err;
 
-	err = ufshcd_get_tr_ocs(hba);
+	err = ufshcd_get_tr_ocs(hba, TASK_TAG);
 	if (err) {
 		dev_err(hba->dev, "Error in OCS:%d\n", err);
 		return -EINVAL;
@@ -1472,15 +1531,19 @@ static int ufshcd_uic_change_pwr_mode(struct ufs_hba *hba, u8 mode)
 
 static
 void ufshcd_prepare_utp_scsi_cmd_upiu(struct ufs_hba *hba,
-				      struct scsi_cmd *pccb, u32 upiu_flags)
+				      struct scsi_cmd *pccb, u32 upiu_flags,
+				      int tag)
 {
-	struct utp_upiu_req *ucd_req_ptr = hba->ucd_req_ptr;
+	struct utp_upiu_req *ucd_req_ptr =
+		(struct utp_upiu_req *)hba->ucdl[tag].command_upiu;
+	struct utp_upiu_rsp *ucd_rsp_ptr =
+		(struct utp_upiu_rsp *)hba->ucdl[tag].response_upiu;
 	unsigned int cdb_len;
 
 	/* command descriptor fields */
 	ucd_req_ptr->header.dword_0 =
 			UPIU_HEADER_DWORD(UPIU_TRANSACTION_COMMAND, upiu_flags,
-					  pccb->lun, TASK_TAG);
+					  pccb->lun, tag);
 	ucd_req_ptr->header.dword_1 =
 			UPIU_HEADER_DWORD(UPIU_COMMAND_SET_TYPE_SCSI, 0, 0, 0);
 
@@ -1493,9 +1556,9 @@ void ufshcd_prepare_utp_scsi_cmd_upiu(struct ufs_hba *hba,
 	memset(ucd_req_ptr->sc.cdb, 0, UFS_CDB_SIZE);
 	memcpy(ucd_req_ptr->sc.cdb, pccb->cmd, cdb_len);
 
-	memset(hba->ucd_rsp_ptr, 0, sizeof(struct utp_upiu_rsp));
+	memset(ucd_rsp_ptr, 0, sizeof(struct utp_upiu_rsp));
 	ufshcd_cache_flush_and_invalidate(ucd_req_ptr, sizeof(*ucd_req_ptr));
-	ufshcd_cache_flush_and_invalidate(hba->ucd_rsp_ptr, sizeof(*hba->ucd_rsp_ptr));
+	ufshcd_cache_flush_and_invalidate(ucd_rsp_ptr, sizeof(*ucd_rsp_ptr));
 }
 
 static inline void prepare_prdt_desc(struct ufshcd_sg_entry *entry,
@@ -1506,10 +1569,11 @@ static inline void prepare_prdt_desc(struct ufshcd_sg_entry *entry,
 	entry->upper_addr = cpu_to_le32(upper_32_bits((unsigned long)buf));
 }
 
-static void prepare_prdt_table(struct ufs_hba *hba, struct scsi_cmd *pccb)
+static void prepare_prdt_table(struct ufs_hba *hba, struct scsi_cmd *pccb,
+			       int tag)
 {
-	struct utp_transfer_req_desc *req_desc = hba->utrdl;
-	struct ufshcd_sg_entry *prd_table = hba->ucd_prdt_ptr;
+	struct utp_transfer_req_desc *req_desc = &hba->utrdl[tag];
+	struct ufshcd_sg_entry *prd_table = hba->ucdl[tag].prd_table;
 	uintptr_t aaddr = (uintptr_t)(pccb->pdata) & ~(ARCH_DMA_MINALIGN - 1);
 	ulong datalen = pccb->datalen;
 	int table_length;
@@ -1546,47 +1610,25 @@ static void prepare_prdt_table(struct ufs_hba *hba, struct scsi_cmd *pccb)
 	ufshcd_cache_flush_and_invalidate(req_desc, sizeof(*req_desc));
 }
 
-int ufs_send_scsi_cmd(struct ufs_hba *hba, struct scsi_cmd *pccb)
+/*
+ * Return the SCSI status of the request in @tag, or -EINVAL if it did not
+ * complete.
+ */
+static int ufshcd_get_scsi_status(struct ufs_hba *hba, int tag)
 {
-	struct utp_transfer_req_desc *req_desc = hba->utrdl;
-	u32 upiu_flags;
-	int ocs, result = 0, retry_count = 3;
-	u8 scsi_status;
-
-	if (hba->quirks & UFSDEV_QUIRK_LUN_IN_SCSI_COMMANDS)
-		pccb->cmd[1] &= 0x1F;
+	struct utp_upiu_rsp *ucd_rsp_ptr =
+		(struct utp_upiu_rsp *)hba->ucdl[tag].response_upiu;
+	int ocs, result;
 
-retry:
-	ufshcd_prepare_req_desc_hdr(req_desc, &upiu_flags, pccb->dma_dir);
-	ufshcd_prepare_utp_scsi_cmd_upiu(hba, pccb, upiu_flags);
-	prepare_prdt_table(hba, pccb);
-
-	if (ufshcd_send_command(hba, TASK_TAG) == -ETIMEDOUT && retry_count) {
-		retry_count--;
-		goto retry;
-	}
-
-	ocs = ufshcd_get_tr_ocs(hba);
+	ocs = ufshcd_get_tr_ocs(hba, tag);
 	switch (ocs) {
 	case OCS_SUCCESS:
-		result = ufshcd_get_req_rsp(hba->ucd_rsp_ptr);
+		result = ufshcd_get_req_rsp(ucd_rsp_ptr);
 		switch (result) {
 		case UPIU_TRANSACTION_RESPONSE:
-			result = ufshcd_get_rsp_upiu_result(hba->ucd_rsp_ptr);
-
-			scsi_status = result & MASK_SCSI_STATUS;
-			if (pccb->cmd[0] == SCSI_TST_U_RDY && scsi_status) {
-				/* Test ready cmd will fail with Phison UFS, break to continue */
-				if (retry_count) {
-					retry_count--;
-					goto retry;
-				}
-				break;
-			}
-			if (scsi_status)
-				return -EINVAL;
+			result = ufshcd_get_rsp_upiu_result(ucd_rsp_ptr);
 
-			break;
+			return result & MASK_SCSI_STATUS;
 		case UPIU_TRANSACTION_REJECT_UPIU:
 			/* TODO: handle Reject UPIU Response */
 			dev_err(hba->dev,
@@ -1598,15 +1640,134 @@ retry:
 				result);
 			return -EINVAL;
 		}
-		break;
 	default:
 		dev_err(hba->dev, "OCS error from controller = %x\n", ocs);
 		return -EINVAL;
 	}
+}
+
+/* Get the LBA and length of a READ/WRITE(10/16), false for other commands */
+static bool ufs_scsi_rw_get(const u8 *cdb, u64 *lba, u32 *blocks)
+{
+	switch (cdb[0]) {
+	case SCSI_READ10:
+	case SCSI_WRITE10:
+		*lba = get_unaligned_be32(&cdb[2]);
+		*blocks = get_unaligned_be16(&cdb[7]);
+		return true;
+	case SCSI_READ16:
+		*lba = get_unaligned_be64(&cdb[2]);
+		*blocks = get_unaligned_be32(&cdb[10]);
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void ufs_scsi_rw_set(u8 *cdb, u64 lba, u32 blocks)
+{
+	if (cdb[0] == SCSI_READ16) {
+		put_unaligned_be64(lba, &cdb[2]);
+		put_unaligned_be32(blocks, &cdb[10]);
+	} else {
+		put_unaligned_be32(lba, &cdb[2]);
+		put_unaligned_be16(blocks, &cdb[7]);
+	}
+}
+
+/*
+ * Split a large read or write over the free slots and ring them all at
+ * once. Returns 1 if @pccb is not worth splitting, so the caller sends it
+ * as a single request.
+ */
+static int ufs_send_scsi_cmd_pipelined(struct ufs_hba *hba,
+				       struct scsi_cmd *pccb)
+{
+	struct scsi_cmd sub;
+	u32 blocks, blksz, chunk, n, upiu_flags, tags = 0;
+	u64 lba;
+	int i, ret;
+
+	if (hba->nutrs < 2 || pccb->datalen < 2 * UFS_PIPELINE_MIN_SIZE ||
+	    !ufs_scsi_rw_get(pccb->cmd, &lba, &blocks) || !blocks ||
+	    pccb->datalen % blocks)
+		return 1;
+
+	blksz = pccb->datalen / blocks;
+	n = min_t(u32, hba->nutrs, pccb->datalen / UFS_PIPELINE_MIN_SIZE);
+	chunk = DIV_ROUND_UP(blocks, n);
+
+	sub = *pccb;
+	for (i = 0; blocks; i++) {
+		n = min(chunk, blocks);
+		ufs_scsi_rw_set(sub.cmd, lba, n);
+		sub.datalen = n * blksz;
+
+		ufshcd_prepare_req_desc_hdr(&hba->utrdl[i], &upiu_flags,
+					    sub.dma_dir);
+		ufshcd_prepare_utp_scsi_cmd_upiu(hba, &sub, upiu_flags, i);
+		prepare_prdt_table(hba, &sub, i);
+		tags |= BIT(i);
+
+		lba += n;
+		blocks -= n;
+		sub.pdata += sub.datalen;
+	}
+
+	ret = ufshcd_send_commands(hba, tags);
+	if (ret)
+		return ret;
+
+	ufshcd_cache_flush_and_invalidate(hba->utrdl,
+					  sizeof(*hba->utrdl) * hba->nutrs);
+	for (i = 0; tags & BIT(i); i++) {
+		invalidate_dcache_range((uintptr_t)hba->ucdl[i].response_upiu,
+					(uintptr_t)hba->ucdl[i].response_upiu +
+					ALIGNED_UPIU_SIZE);
+		if (ufshcd_get_scsi_status(hba, i))
+			return -EINVAL;
+	}
 
 	return 0;
 }
 
+int ufs_send_scsi_cmd(struct ufs_hba *hba, struct scsi_cmd *pccb)
+{
+	struct utp_transfer_req_desc *req_desc = hba->utrdl;
+	u32 upiu_flags;
+	int ret, retry_count = 3;
+
+	if (hba->quirks & UFSDEV_QUIRK_LUN_IN_SCSI_COMMANDS)
+		pccb->cmd[1] &= 0x1F;
+
+	/* A timed out pipeline is retried below one request at a time */
+	ret = ufs_send_scsi_cmd_pipelined(hba, pccb);
+	if (ret <= 0 && ret != -ETIMEDOUT)
+		return ret;
+
+retry:
+	ufshcd_prepare_req_desc_hdr(req_desc, &upiu_flags, pccb->dma_dir);
+	ufshcd_prepare_utp_scsi_cmd_upiu(hba, pccb, upiu_flags, TASK_TAG);
+	prepare_prdt_table(hba, pccb, TASK_TAG);
+
+	if (ufshcd_send_command(hba, TASK_TAG) == -ETIMEDOUT && retry_count) {
+		retry_count--;
+		goto retry;
+	}
+
+	ret = ufshcd_get_scsi_status(hba, TASK_TAG);
+	if (ret > 0 && pccb->cmd[0] == SCSI_TST_U_RDY) {
+		/* Test ready cmd will fail with Phison UFS, break to continue */
+		if (retry_count) {
+			retry_count--;
+			goto retry;
+		}
+		return 0;
+	}
+
+	return ret ? -EINVAL : 0;
+}
+
 static int ufs_scsi_exec(struct udevice *scsi_dev, struct scsi_cmd *pccb)
 {
 	struct ufs_hba *hba = dev_get_uclass_priv(scsi_dev->parent);
@@ -2025,6 +2186,9 @@ int ufshcd_probe(struct udevice *ufs_dev, struct ufs_hba_ops *hba_ops)
 	/* Get Interrupt bit mask per version */
 	hba->intr_mask = ufshcd_get_intr_mask(hba);
 
+	hba->nutrs = min_t(u32, UFSHCD_MAX_SLOTS,
+			   (hba->capabilities & MASK_TRANSFER_REQUESTS_SLOTS) + 1);
+
 	/* Allocate memory for host memory space */
 	err = ufshcd_memory_alloc(hba);
 	if (err) {
@@ -755,6 +755,8 @@ struct ufs_hba {
 	u32			capabilities;
 	u32			version;
 	u32			intr_mask;
+	/* Transfer request slots in use, at most UFSHCD_MAX_SLOTS */
+	u32			nutrs;
 	u32			quirks;
 /*
  * If UFS host controller is having issue in processing LCC (Line
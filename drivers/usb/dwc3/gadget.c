@@ -395,7 +395,7 @@ static int dwc3_gadget_set_ep_config(struct dwc3 *dwc, struct dwc3_ep *dep,
 
 	/* Burst size is only needed in SuperSpeed mode */
 	if (dwc->gadget.speed == USB_SPEED_SUPER) {
-		u32 burst = dep->endpoint.maxburst - 1;
+		u32 burst = max_t(u32, dep->endpoint.maxburst, 1) - 1;
 
 		params.param0 |= DWC3_DEPCFG_BURST_SIZE(burst);
 	}
@@ -794,7 +794,9 @@ static void dwc3_prepare_one_trb(struct dwc3_ep *dep,
  *
  * The function goes through the requests list and sets up TRBs for the
  * transfers. The function returns once there are no more TRBs available or
- * it runs out of requests.
+ * it runs out of requests. Bulk endpoints take all queued requests into
+ * one transfer, one TRB each, so the core moves from one buffer to the
+ * next without waiting for a new START TRANSFER.
  */
 static void dwc3_prepare_trbs(struct dwc3_ep *dep, bool starting)
 {
@@ -850,14 +852,22 @@ static void dwc3_prepare_trbs(struct dwc3_ep *dep, bool starting)
 	list_for_each_entry_safe(req, n, &dep->request_list, list) {
 		unsigned	length;
 		dma_addr_t	dma;
+		unsigned	last_one = 0;
 
 		dma = req->request.dma;
 		length = req->request.length;
+		trbs_left--;
+
+		if (!trbs_left ||
+		    list_is_last(&req->list, &dep->request_list) ||
+		    !usb_endpoint_xfer_bulk(dep->endpoint.desc))
+			last_one = 1;
 
 		dwc3_prepare_one_trb(dep, req, dma, length,
-				     true, false, 0);
+				     last_one, false, 0);
 
-		break;
+		if (last_one)
+			break;
 	}
 }
 
@@ -1779,23 +1789,31 @@ static int dwc3_cleanup_done_reqs(struct dwc3 *dwc, struct dwc3_ep *dep,
 	struct dwc3_request	*req;
 	struct dwc3_trb		*trb;
 	unsigned int		slot;
+	int			ret;
 
-	req = next_request(&dep->req_queued);
-	if (!req) {
-		WARN_ON_ONCE(1);
-		return 1;
-	}
+	/*
+	 * Give back requests up to the one whose TRB raised the event,
+	 * those queued with no_interrupt before it are done as well.
+	 */
+	do {
+		req = next_request(&dep->req_queued);
+		if (!req) {
+			WARN_ON_ONCE(1);
+			return 1;
+		}
 
-	slot = req->start_slot;
-	if ((slot == DWC3_TRB_NUM - 1) &&
-	    usb_endpoint_xfer_isoc(dep->endpoint.desc))
-		slot++;
-	slot %= DWC3_TRB_NUM;
-	trb = &dep->trb_pool[slot];
+		slot = req->start_slot;
+		if ((slot == DWC3_TRB_NUM - 1) &&
+		    usb_endpoint_xfer_isoc(dep->endpoint.desc))
+			slot++;
+		slot %= DWC3_TRB_NUM;
+		trb = &dep->trb_pool[slot];
 
-	dwc3_flush_cache((uintptr_t)trb, sizeof(*trb));
-	__dwc3_cleanup_done_trbs(dwc, dep, req, trb, event, status);
-	dwc3_gadget_giveback(dep, req, status);
+		dwc3_flush_cache((uintptr_t)trb, sizeof(*trb));
+		ret = __dwc3_cleanup_done_trbs(dwc, dep, req, trb, event,
+					       status);
+		dwc3_gadget_giveback(dep, req, status);
+	} while (!ret);
 
 	if (usb_endpoint_xfer_isoc(dep->endpoint.desc) &&
 			list_empty(&dep->req_queued)) {
@@ -1860,8 +1878,12 @@ static void dwc3_endpoint_transfer_complete(struct dwc3 *dwc,
 		dwc->u1u2 = 0;
 	}
 
-	if (!usb_endpoint_xfer_isoc(dep->endpoint.desc)) {
-		ret = __dwc3_gadget_kick_transfer(dep, 0, is_xfer_complete);
+	/*
+	 * The core stops at the LST TRB, so requests queued meanwhile go
+	 * into a new transfer once this one completes.
+	 */
+	if (!usb_endpoint_xfer_isoc(dep->endpoint.desc) && is_xfer_complete) {
+		ret = __dwc3_gadget_kick_transfer(dep, 0, 1);
 		if (!ret || ret == -EBUSY)
 			return;
 	}
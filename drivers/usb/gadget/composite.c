@@ -11,7 +11,13 @@
 #include <linux/bitops.h>
 #include <linux/usb/composite.h>
 
+/* ep0 buffer, which takes the DFU blocks in the data stage */
+#if defined(CONFIG_USB_FUNCTION_DFU_TRANSFER_SIZE) && \
+	CONFIG_USB_FUNCTION_DFU_TRANSFER_SIZE > 4096
+#define USB_BUFSIZ	CONFIG_USB_FUNCTION_DFU_TRANSFER_SIZE
+#else
 #define USB_BUFSIZ	4096
+#endif
 
 /* Helper type for accessing packed u16 pointers */
 typedef struct { __le16 val; } __packed __le16_packed;
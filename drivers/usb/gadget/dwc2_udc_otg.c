@@ -542,6 +542,15 @@ static void reconfig_usbd(struct dwc2_udc *dev)
 	writel((np_tx_fifo_sz << 16) | rx_fifo_sz,
 	       &reg->gnptxfsiz);
 
+	/* Widths of the DxEPTSIZ transfer size and packet count fields */
+	uTemp = readl(&reg->ghwcfg3);
+	dev->max_xfer_size = (1 << ((uTemp & GHWCFG3_XFER_SIZE_WIDTH_MASK) +
+				    11)) - 1;
+	dev->max_xfer_size = min_t(u32, dev->max_xfer_size,
+				   DOEPT_SIZ_XFER_SIZE_MAX_EP);
+	dev->max_pkt_cnt = (1 << (((uTemp & GHWCFG3_PKT_SIZE_WIDTH_MASK) >>
+				   GHWCFG3_PKT_SIZE_WIDTH_SHIFT) + 4)) - 1;
+
 	/* retrieve the number of IN Endpoints (excluding ep0) */
 	max_hw_ep = (readl(&reg->ghwcfg4) & GHWCFG4_NUM_IN_EPS_MASK) >>
 		    GHWCFG4_NUM_IN_EPS_SHIFT;
@@ -83,6 +83,10 @@ struct dwc2_udc {
 
 	unsigned char usb_address;
 
+	/* Transfer size and packet count limits of a non-control endpoint */
+	u32 max_xfer_size;
+	u32 max_pkt_cnt;
+
 	unsigned req_pending:1, req_std:1;
 	unsigned connected:1;
 };
@@ -63,7 +63,8 @@ struct dwc2_usbotg_reg {
 	u32 gnptxfsiz; /* Non-Periodic Transmit FIFO Size */
 	u8  res0[12];
 	u32 ggpio;     /* 0x038 */
-	u8  res1[20];
+	u8  res1[16];
+	u32 ghwcfg3; /* User HW Config3 */
 	u32 ghwcfg4; /* User HW Config4 */
 	u8  res2[176];
 	u32 dieptxf[15]; /* Device Periodic Transmit FIFO size register */
@@ -263,7 +264,13 @@ struct dwc2_usbotg_reg {
 			| INT_RESET | INT_SUSPEND | INT_OTG)
 #define DOEPMSK_INIT	(CTRL_OUT_EP_SETUP_PHASE_DONE | AHB_ERROR|TRANSFER_DONE)
 #define DIEPMSK_INIT	(NON_ISO_IN_EP_TIMEOUT|AHB_ERROR|TRANSFER_DONE)
-#define GAHBCFG_INIT	(PTXFE_HALF | NPTXFE_HALF | MODE_DMA | BURST_INCR4\
+#ifdef CONFIG_ARCH_ROCKCHIP
+/* As the Linux dwc2 parameters for Rockchip, fewer AHB bursts per MB */
+#define GAHBCFG_BURST	BURST_INCR16
+#else
+#define GAHBCFG_BURST	BURST_INCR4
+#endif
+#define GAHBCFG_INIT	(PTXFE_HALF | NPTXFE_HALF | MODE_DMA | GAHBCFG_BURST\
 			| GBL_INT_UNMASK)
 
 /* Device Endpoint X Transfer Size Register (DIEPTSIZX) */
@@ -284,6 +291,11 @@ struct dwc2_usbotg_reg {
 #define DAINT_IN_EP_INT(x)                        (x << 0)
 #define DAINT_OUT_EP_INT(x)                       (x << 16)
 
+/* User HW Config3 */
+#define GHWCFG3_XFER_SIZE_WIDTH_MASK	(0xf << 0)
+#define GHWCFG3_PKT_SIZE_WIDTH_MASK	(0x7 << 4)
+#define GHWCFG3_PKT_SIZE_WIDTH_SHIFT	4
+
 /* User HW Config4 */
 #define GHWCFG4_NUM_IN_EPS_MASK		(0xf << 26)
 #define GHWCFG4_NUM_IN_EPS_SHIFT	26
@@ -89,6 +89,21 @@ static inline void dwc2_ep0_complete_out(void)
 
 }
 
+/*
+ * Largest transfer the core takes in one go, in whole packets, so a big
+ * request is split into as few DMA runs as possible and an OUT run
+ * never ends in the middle of a packet.
+ */
+static u32 dwc2_max_xfer(struct dwc2_ep *ep)
+{
+	struct dwc2_udc *dev = ep->dev;
+	u32 maxpacket = ep->ep.maxpacket;
+	u32 len;
+
+	len = min(dev->max_xfer_size, dev->max_pkt_cnt * maxpacket);
+
+	return len - len % maxpacket;
+}
 
 static int setdma_rx(struct dwc2_ep *ep, struct dwc2_request *req)
 {
@@ -98,7 +113,7 @@ static int setdma_rx(struct dwc2_ep *ep, struct dwc2_request *req)
 
 	buf = req->req.buf + req->req.actual;
 	length = min_t(u32, req->req.length - req->req.actual,
-		       ep_num ? DOEPT_SIZ_XFER_SIZE_MAX_EP : ep->ep.maxpacket);
+		       ep_num ? dwc2_max_xfer(ep) : ep->ep.maxpacket);
 
 	ep->len = length;
 	ep->dma_buf = buf;
@@ -143,6 +158,8 @@ static int setdma_tx(struct dwc2_ep *ep, struct dwc2_request *req)
 
 	if (ep_num == EP0_CON)
 		length = min(length, (u32)ep_maxpacket(ep));
+	else
+		length = min(length, dwc2_max_xfer(ep));
 
 	ep->len = length;
 	ep->dma_buf = buf;
@@ -32,6 +32,9 @@
 #ifdef CONFIG_FASTBOOT_FLASH_MMC_DEV
 #include <fb_mmc.h>
 #endif
+#ifdef CONFIG_FASTBOOT_FLASH_PIPELINE
+#include <image-sparse.h>
+#endif
 #ifdef CONFIG_FASTBOOT_FLASH_NAND_DEV
 #include <fb_nand.h>
 #endif
@@ -58,6 +61,24 @@
 #define TX_ENDPOINT_MAXIMUM_PACKET_SIZE      (0x0040)
 
 #define EP_BUFFER_SIZE			4096
+/* Requests queued at a time to download straight into the buffer */
+#define DL_REQ_NUM			4
+#define DL_REQ_SIZE			(1024 * 1024)
+#ifdef CONFIG_FASTBOOT_FLASH_PIPELINE
+/* Downloads land in the lower half, sparse images are written from the upper */
+#define DL_BUF_SIZE			(CONFIG_FASTBOOT_BUF_SIZE / 2)
+#define FLASH_BUF_ADDR			(CONFIG_FASTBOOT_BUF_ADDR + DL_BUF_SIZE)
+#else
+#define DL_BUF_SIZE			CONFIG_FASTBOOT_BUF_SIZE
+#endif
+#ifdef CONFIG_FASTBOOT_DOWNLOAD_SHA256
+/* Room for "OKAY" and a hex SHA-256, more than the classic 64 bytes */
+#define GETVAR_RESPONSE_LEN		(4 + 2 * SHA256_SUM_LEN + 1)
+#else
+#define GETVAR_RESPONSE_LEN		FASTBOOT_RESPONSE_LEN
+#endif
+/* Largest fetch, 4KB aligned and within the 8 digits of DATA */
+#define FETCH_MAX_SIZE			0xfffff000
 #define SLEEP_COUNT 20000
 #define MAX_PART_NUM_STR_SIZE 4
 #define PARTITION_TYPE_STRINGS "partition-type"
@@ -74,6 +95,14 @@ struct f_fastboot {
 	/* IN/OUT EP's and corresponding requests */
 	struct usb_ep *in_ep, *out_ep;
 	struct usb_request *in_req, *out_req;
+#ifdef CONFIG_FASTBOOT_DL_DIRECT
+	/* Point into CONFIG_FASTBOOT_BUF_ADDR, no buffers of their own */
+	struct usb_request *dl_req[DL_REQ_NUM];
+#endif
+#ifdef CONFIG_FASTBOOT_FETCH
+	/* Each sends its own DL_REQ_SIZE slot of CONFIG_FASTBOOT_BUF_ADDR */
+	struct usb_request *fetch_req[DL_REQ_NUM];
+#endif
 };
 
 static inline struct f_fastboot *func_to_fastboot(struct usb_function *f)
@@ -84,9 +113,37 @@ static inline struct f_fastboot *func_to_fastboot(struct usb_function *f)
 static struct f_fastboot *fastboot_func;
 static unsigned int download_size;
 static unsigned int download_bytes;
+#ifdef CONFIG_FASTBOOT_DL_DIRECT
+static unsigned int download_queued;
+static u32 dl_req_busy;
+#endif
+#ifdef CONFIG_FASTBOOT_FLASH_PIPELINE
+static bool flash_busy;
+static bool flash_failed;
+static int flash_index;
+static unsigned int flash_bytes;
+static char flash_part[PART_NAME_LEN];
+static char flash_response[FASTBOOT_RESPONSE_LEN];
+/* Command which arrived while the image was being written */
+static struct usb_request *flash_deferred;
+#endif
+#ifdef CONFIG_FASTBOOT_DOWNLOAD_SHA256
+static sha256_context download_sha256;
+/* Of the last download, valid once it has completed */
+static u8 download_digest[SHA256_SUM_LEN];
+static bool download_digest_valid;
+#endif
 static unsigned int upload_size;
 static unsigned int upload_bytes;
 static bool start_upload;
+#ifdef CONFIG_FASTBOOT_FETCH
+static struct blk_desc *fetch_dev;
+static lbaint_t fetch_lba;		/* next block to read */
+static unsigned int fetch_left;		/* bytes not read yet */
+static unsigned int fetch_size;
+static unsigned int fetch_bytes;	/* bytes sent */
+static u32 fetch_req_busy;
+#endif
 static unsigned intthread_wakeup_needed;
 
 static struct usb_endpoint_descriptor fs_ep_in = {
@@ -132,7 +189,7 @@ static struct usb_endpoint_descriptor ss_ep_in = {
 static struct usb_ss_ep_comp_descriptor ss_ep_in_comp_desc = {
 	.bLength		= sizeof(ss_ep_in_comp_desc),
 	.bDescriptorType	= USB_DT_SS_ENDPOINT_COMP,
-	/* .bMaxBurst		= DYNAMIC, */
+	.bMaxBurst		= 15,
 };
 
 static struct usb_endpoint_descriptor ss_ep_out = {
@@ -146,7 +203,7 @@ static struct usb_endpoint_descriptor ss_ep_out = {
 static struct usb_ss_ep_comp_descriptor ss_ep_out_comp_desc = {
 	.bLength		= sizeof(ss_ep_out_comp_desc),
 	.bDescriptorType	= USB_DT_SS_ENDPOINT_COMP,
-	/* .bMaxBurst		= DYNAMIC, */
+	.bMaxBurst		= 15,
 };
 
 static struct usb_interface_descriptor interface_desc = {
@@ -197,6 +254,7 @@ fb_ep_desc(struct usb_gadget *g, struct usb_endpoint_descriptor *fs,
 		if (gadget_is_superspeed(g)) {
 			speed_desc = ss;
 			ep->comp_desc = comp_desc;
+			ep->maxburst = comp_desc->bMaxBurst + 1;
 			break;
 		}
 		/* else: Fall trough */
@@ -390,6 +448,9 @@ static void fastboot_unbind(struct usb_configuration *c, struct usb_function *f)
 static void fastboot_disable(struct usb_function *f)
 {
 	struct f_fastboot *f_fb = func_to_fastboot(f);
+#if defined(CONFIG_FASTBOOT_DL_DIRECT) || defined(CONFIG_FASTBOOT_FETCH)
+	int i;
+#endif
 
 	usb_ep_disable(f_fb->out_ep);
 	usb_ep_disable(f_fb->in_ep);
@@ -404,6 +465,24 @@ static void fastboot_disable(struct usb_function *f)
 		usb_ep_free_request(f_fb->in_ep, f_fb->in_req);
 		f_fb->in_req = NULL;
 	}
+#ifdef CONFIG_FASTBOOT_DL_DIRECT
+	for (i = 0; i < DL_REQ_NUM; i++) {
+		if (f_fb->dl_req[i]) {
+			usb_ep_free_request(f_fb->out_ep, f_fb->dl_req[i]);
+			f_fb->dl_req[i] = NULL;
+		}
+	}
+	dl_req_busy = 0;
+#endif
+#ifdef CONFIG_FASTBOOT_FETCH
+	for (i = 0; i < DL_REQ_NUM; i++) {
+		if (f_fb->fetch_req[i]) {
+			usb_ep_free_request(f_fb->in_ep, f_fb->fetch_req[i]);
+			f_fb->fetch_req[i] = NULL;
+		}
+	}
+	fetch_req_busy = 0;
+#endif
 }
 
 static struct usb_request *fastboot_start_ep(struct usb_ep *ep)
@@ -682,8 +761,33 @@ static int fb_read_var(char *cmd, char *response,
 		break;
 	case FB_DWNLD_SIZE:
 		fb_add_number(response, chars_left, "0x%08x",
-			      CONFIG_FASTBOOT_BUF_SIZE);
+			      DL_BUF_SIZE);
 		break;
+#ifdef CONFIG_FASTBOOT_FETCH
+	case FB_FETCH_SIZE:
+		fb_add_number(response, chars_left, "0x%08x",
+			      FETCH_MAX_SIZE);
+		break;
+#endif
+#ifdef CONFIG_FASTBOOT_DOWNLOAD_SHA256
+	case FB_DWNLD_SHA256: {
+		int i;
+
+		if (!download_digest_valid) {
+			fb_add_string(response, chars_left, "no download",
+				      NULL);
+			ret = -1;
+			break;
+		}
+		for (i = 0; i < SHA256_SUM_LEN && chars_left > 2; i++) {
+			snprintf(response, chars_left, "%02x",
+				 download_digest[i]);
+			response += 2;
+			chars_left -= 2;
+		}
+		break;
+	}
+#endif
 	case FB_PART_SIZE:
 	case FB_PART_TYPE: {
 		char *part_name = cmd;
@@ -1108,6 +1212,12 @@ static const struct {
 	{ NAME_NO_ARGS("serialno"), FB_SERIAL_NO},
 	{ NAME_NO_ARGS("secure"), FB_SECURE},
 	{ NAME_NO_ARGS("max-download-size"), FB_DWNLD_SIZE},
+#ifdef CONFIG_FASTBOOT_DOWNLOAD_SHA256
+	{ NAME_NO_ARGS("download-sha256"), FB_DWNLD_SHA256},
+#endif
+#ifdef CONFIG_FASTBOOT_FETCH
+	{ NAME_NO_ARGS("max-fetch-size"), FB_FETCH_SIZE},
+#endif
 	{ NAME_NO_ARGS("logical-block-size"), FB_BLK_SIZE},
 	{ NAME_NO_ARGS("erase-block-size"), FB_ERASE_SIZE},
 	{ NAME_ARGS("partition-type", ':'), FB_PART_TYPE},
@@ -1421,6 +1531,11 @@ static void fb_getvar_all(void)
 #ifdef CONFIG_RK_AVB_LIBAVB_USER
 		case FB_AT_VBST:
 			break;
+#endif
+#ifdef CONFIG_FASTBOOT_DOWNLOAD_SHA256
+		/* Too long for an INFO line, ask for it on its own */
+		case FB_DWNLD_SHA256:
+			break;
 #endif
 		default:
 			fb_getvar_single((char *)getvar_table[i].name.str,
@@ -1505,7 +1620,7 @@ static int get_virtual_ab_merge_status(void)
 static void cb_getvar(struct usb_ep *ep, struct usb_request *req)
 {
 	char *cmd = req->buf;
-	char response[FASTBOOT_RESPONSE_LEN] = {0};
+	char response[GETVAR_RESPONSE_LEN] = {0};
 	const char *str_read_all = "all";
 	size_t len = 0;
 	size_t chars_left;
@@ -1564,13 +1679,51 @@ static unsigned int rx_bytes_expected(struct usb_ep *ep)
 }
 
 #define BYTES_PER_DOT	0x20000
+static void fastboot_dl_progress(unsigned int transfer_size)
+{
+	unsigned int pre_dot_num, now_dot_num;
+
+#ifdef CONFIG_FASTBOOT_DOWNLOAD_SHA256
+	/* While the requests still queued are being received */
+	sha256_update(&download_sha256,
+		      (const u8 *)CONFIG_FASTBOOT_BUF_ADDR + download_bytes,
+		      transfer_size);
+#endif
+
+	pre_dot_num = download_bytes / BYTES_PER_DOT;
+	download_bytes += transfer_size;
+	now_dot_num = download_bytes / BYTES_PER_DOT;
+
+	if (pre_dot_num != now_dot_num) {
+		putc('.');
+		if (!(now_dot_num % 74))
+			putc('\n');
+	}
+}
+
+static void fastboot_dl_done(void)
+{
+	/*
+	 * Reset global transfer variable, keep download_bytes because
+	 * it will be used in the next possible flashing command
+	 */
+	download_size = 0;
+
+#ifdef CONFIG_FASTBOOT_DOWNLOAD_SHA256
+	sha256_finish(&download_sha256, download_digest);
+	download_digest_valid = true;
+#endif
+
+	fastboot_tx_write_str("OKAY");
+
+	printf("\ndownloading of %d bytes finished\n", download_bytes);
+}
+
 static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 {
-	char response[FASTBOOT_RESPONSE_LEN];
 	unsigned int transfer_size = download_size - download_bytes;
 	const unsigned char *buffer = req->buf;
 	unsigned int buffer_size = req->actual;
-	unsigned int pre_dot_num, now_dot_num;
 
 	if (req->status != 0) {
 		printf("Bad status: %d\n", req->status);
@@ -1583,30 +1736,13 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 	memcpy((void *)CONFIG_FASTBOOT_BUF_ADDR + download_bytes,
 	       buffer, transfer_size);
 
-	pre_dot_num = download_bytes / BYTES_PER_DOT;
-	download_bytes += transfer_size;
-	now_dot_num = download_bytes / BYTES_PER_DOT;
-
-	if (pre_dot_num != now_dot_num) {
-		putc('.');
-		if (!(now_dot_num % 74))
-			putc('\n');
-	}
+	fastboot_dl_progress(transfer_size);
 
 	/* Check if transfer is done */
 	if (download_bytes >= download_size) {
-		/*
-		 * Reset global transfer variable, keep download_bytes because
-		 * it will be used in the next possible flashing command
-		 */
-		download_size = 0;
 		req->complete = rx_handler_command;
 		req->length = EP_BUFFER_SIZE;
-
-		strcpy(response, "OKAY");
-		fastboot_tx_write_str(response);
-
-		printf("\ndownloading of %d bytes finished\n", download_bytes);
+		fastboot_dl_done();
 	} else {
 		req->length = rx_bytes_expected(ep);
 	}
@@ -1615,6 +1751,127 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 	usb_ep_queue(ep, req, 0);
 }
 
+#ifdef CONFIG_FASTBOOT_DL_DIRECT
+static void rx_handler_dl_direct(struct usb_ep *ep, struct usb_request *req);
+
+/* Point @req at the next part of the buffer not queued yet */
+static int fastboot_dl_queue(struct usb_ep *ep, int i)
+{
+	struct usb_request *req = fastboot_func->dl_req[i];
+	unsigned int len = download_size - download_queued;
+	unsigned int maxpacket = ep->maxpacket;
+
+	if (!len)
+		return 0;
+
+	len = min_t(unsigned int, len, DL_REQ_SIZE);
+	req->buf = (void *)CONFIG_FASTBOOT_BUF_ADDR + download_queued;
+	/* Whole packets, the buffer has room for the rounding */
+	req->length = roundup(len, maxpacket);
+	req->actual = 0;
+	req->complete = rx_handler_dl_direct;
+	req->context = (void *)(uintptr_t)i;
+	download_queued += len;
+
+	dl_req_busy |= BIT(i);
+	if (usb_ep_queue(ep, req, 0)) {
+		dl_req_busy &= ~BIT(i);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static void fastboot_dl_cancel(struct usb_ep *ep)
+{
+	u32 busy = dl_req_busy;
+	int i;
+
+	/* Mark them idle first, dequeuing may call their completion */
+	dl_req_busy = 0;
+	for (i = 0; i < DL_REQ_NUM; i++) {
+		if (busy & BIT(i))
+			usb_ep_dequeue(ep, fastboot_func->dl_req[i]);
+	}
+}
+
+/* Hand the bulk OUT endpoint back to the command request */
+static void fastboot_dl_direct_end(struct usb_ep *ep)
+{
+	struct usb_request *out_req = fastboot_func->out_req;
+
+	fastboot_dl_cancel(ep);
+
+	out_req->actual = 0;
+	usb_ep_queue(ep, out_req, 0);
+}
+
+static void rx_handler_dl_direct(struct usb_ep *ep, struct usb_request *req)
+{
+	unsigned int transfer_size = download_size - download_bytes;
+	int i = (uintptr_t)req->context;
+
+	/* Cancelled */
+	if (!(dl_req_busy & BIT(i)))
+		return;
+	dl_req_busy &= ~BIT(i);
+
+	if (req->status != 0) {
+		printf("Bad status: %d\n", req->status);
+		return;
+	}
+
+	if (req->actual < transfer_size)
+		transfer_size = req->actual;
+	fastboot_dl_progress(transfer_size);
+
+	if (download_bytes >= download_size) {
+		fastboot_dl_done();
+		fastboot_dl_direct_end(ep);
+	} else if (req->actual < req->length) {
+		/* The queued requests no longer line up with the data */
+		download_size = 0;
+		fastboot_tx_write_str("FAILshort transfer");
+		printf("\ndownload cut short at %d bytes\n", download_bytes);
+		fastboot_dl_direct_end(ep);
+	} else if (fastboot_dl_queue(ep, i)) {
+		download_size = 0;
+		fastboot_tx_write_str("FAILqueue request");
+		fastboot_dl_direct_end(ep);
+	}
+}
+
+/*
+ * Queue the first requests of a download in place of the command request,
+ * or return false to receive it packet by packet.
+ */
+static bool fastboot_dl_direct_start(struct usb_ep *ep)
+{
+	unsigned int maxpacket = ep->maxpacket;
+	int i;
+
+	if (roundup(download_size, maxpacket) > DL_BUF_SIZE)
+		return false;
+
+	for (i = 0; i < DL_REQ_NUM; i++) {
+		if (!fastboot_func->dl_req[i])
+			fastboot_func->dl_req[i] = usb_ep_alloc_request(ep, 0);
+		if (!fastboot_func->dl_req[i])
+			return false;
+	}
+
+	download_queued = 0;
+	for (i = 0; i < DL_REQ_NUM; i++) {
+		if (fastboot_dl_queue(ep, i)) {
+			fastboot_dl_cancel(ep);
+			return false;
+		}
+	}
+
+	return true;
+}
+#endif
+
 static void cb_download(struct usb_ep *ep, struct usb_request *req)
 {
 	char *cmd = req->buf;
@@ -1626,13 +1883,28 @@ static void cb_download(struct usb_ep *ep, struct usb_request *req)
 
 	printf("Starting download of %d bytes\n", download_size);
 
+#ifdef CONFIG_FASTBOOT_DOWNLOAD_SHA256
+	/* The crypto engine, if any, needs the total length up front */
+	download_digest_valid = false;
+	memset(&download_sha256, 0, sizeof(download_sha256));
+	download_sha256.length = download_size;
+	if (download_size && download_size <= DL_BUF_SIZE)
+		sha256_starts(&download_sha256);
+#endif
+
 	if (0 == download_size) {
 		strcpy(response, "FAILdata invalid size");
-	} else if (download_size > CONFIG_FASTBOOT_BUF_SIZE) {
+	} else if (download_size > DL_BUF_SIZE) {
 		download_size = 0;
 		strcpy(response, "FAILdata too large");
 	} else {
 		sprintf(response, "DATA%08x", download_size);
+#ifdef CONFIG_FASTBOOT_DL_DIRECT
+		if (fastboot_dl_direct_start(ep)) {
+			fastboot_tx_write_str(response);
+			return;
+		}
+#endif
 		req->complete = rx_handler_dl_image;
 		req->length = rx_bytes_expected(ep);
 	}
@@ -1711,6 +1983,184 @@ static void cb_upload(struct usb_ep *ep, struct usb_request *req)
 	fastboot_tx_write_str(response);
 }
 
+#ifdef CONFIG_FASTBOOT_FETCH
+static void tx_handler_fetch(struct usb_ep *ep, struct usb_request *req);
+
+/* Read the next chunk into slot @i and send it */
+static int fastboot_fetch_queue(int i)
+{
+	struct usb_request *req = fastboot_func->fetch_req[i];
+	unsigned int len = min_t(unsigned int, fetch_left, DL_REQ_SIZE);
+	lbaint_t blkcnt;
+
+	if (!len)
+		return 0;
+
+	/* The last chunk is read up to a whole block, the slot has room */
+	blkcnt = DIV_ROUND_UP(len, fetch_dev->blksz);
+	req->buf = (void *)CONFIG_FASTBOOT_BUF_ADDR + i * DL_REQ_SIZE;
+	if (blk_dread(fetch_dev, fetch_lba, blkcnt, req->buf) != blkcnt) {
+		printf("\nfetch read failed at block " LBAF "\n", fetch_lba);
+		return -EIO;
+	}
+	fetch_lba += blkcnt;
+	fetch_left -= len;
+
+	req->length = len;
+	req->actual = 0;
+	req->complete = tx_handler_fetch;
+	req->context = (void *)(uintptr_t)i;
+
+	fetch_req_busy |= BIT(i);
+	if (usb_ep_queue(fastboot_func->in_ep, req, 0)) {
+		fetch_req_busy &= ~BIT(i);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+/* Stop sending, and reply on the command request */
+static void fastboot_fetch_end(const char *response)
+{
+	u32 busy = fetch_req_busy;
+	int i;
+
+	/* Mark them idle first, dequeuing may call their completion */
+	fetch_req_busy = 0;
+	for (i = 0; i < DL_REQ_NUM; i++) {
+		if (busy & BIT(i))
+			usb_ep_dequeue(fastboot_func->in_ep,
+				       fastboot_func->fetch_req[i]);
+	}
+
+	fastboot_tx_write_str(response);
+}
+
+static void tx_handler_fetch(struct usb_ep *ep, struct usb_request *req)
+{
+	unsigned int pre_dot_num, now_dot_num;
+	int i = (uintptr_t)req->context;
+
+	/* Cancelled */
+	if (!(fetch_req_busy & BIT(i)))
+		return;
+	fetch_req_busy &= ~BIT(i);
+
+	if (req->status != 0) {
+		printf("Bad status: %d\n", req->status);
+		fastboot_fetch_end("FAILtransfer error");
+		return;
+	}
+
+	pre_dot_num = fetch_bytes / BYTES_PER_DOT;
+	fetch_bytes += req->actual;
+	now_dot_num = fetch_bytes / BYTES_PER_DOT;
+	if (pre_dot_num != now_dot_num) {
+		putc('.');
+		if (!(now_dot_num % 74))
+			putc('\n');
+	}
+
+	if (fetch_bytes >= fetch_size) {
+		printf("\nfetch of %u bytes finished\n", fetch_bytes);
+		fastboot_fetch_end("OKAY");
+	} else if (fastboot_fetch_queue(i)) {
+		fastboot_fetch_end("FAILread error");
+	}
+}
+
+/* The DATA reply has gone out, fill all the slots */
+static void tx_handler_fetch_start(struct usb_ep *ep, struct usb_request *req)
+{
+	int i;
+
+	req->complete = fastboot_complete;
+	wakeup_thread();
+	if (req->status != 0)
+		return;
+
+	for (i = 0; i < DL_REQ_NUM; i++) {
+		if (fastboot_fetch_queue(i)) {
+			fastboot_fetch_end("FAILread error");
+			return;
+		}
+	}
+}
+
+static void cb_fetch(struct usb_ep *ep, struct usb_request *req)
+{
+	char *cmd = req->buf;
+	char response[FASTBOOT_RESPONSE_LEN];
+	disk_partition_t part_info;
+	char *part_name, *arg;
+	u64 part_bytes, offset = 0, size;
+	int i;
+#ifdef CONFIG_RK_AVB_LIBAVB_USER
+	uint8_t flash_lock_state;
+
+	if (rk_avb_read_flash_lock_state(&flash_lock_state) ||
+	    flash_lock_state == 0) {
+		fastboot_tx_write_str("FAILThe device is locked, can not fetch!");
+		return;
+	}
+#endif
+	strsep(&cmd, ":");
+	part_name = strsep(&cmd, ":");
+	if (!part_name || !*part_name) {
+		fastboot_tx_write_str("FAILmissing partition name");
+		return;
+	}
+
+	fetch_dev = rockchip_get_bootdev();
+	if (!fetch_dev) {
+		fastboot_tx_write_str("FAILblock device not found");
+		return;
+	}
+	if (part_get_info_by_name(fetch_dev, part_name, &part_info) < 0) {
+		fastboot_tx_write_str("FAILpartition not found");
+		return;
+	}
+	part_bytes = (u64)part_info.size * part_info.blksz;
+
+	arg = strsep(&cmd, ":");
+	if (arg)
+		offset = simple_strtoull(arg, NULL, 16);
+	if (offset >= part_bytes || offset % part_info.blksz) {
+		fastboot_tx_write_str("FAILinvalid offset");
+		return;
+	}
+	size = part_bytes - offset;
+	if (cmd)
+		size = min(size, simple_strtoull(cmd, NULL, 16));
+	if (!size || size > FETCH_MAX_SIZE ||
+	    DL_REQ_NUM * DL_REQ_SIZE > DL_BUF_SIZE) {
+		fastboot_tx_write_str("FAILinvalid size");
+		return;
+	}
+
+	for (i = 0; i < DL_REQ_NUM; i++) {
+		if (!fastboot_func->fetch_req[i])
+			fastboot_func->fetch_req[i] =
+				usb_ep_alloc_request(fastboot_func->in_ep, 0);
+		if (!fastboot_func->fetch_req[i]) {
+			fastboot_tx_write_str("FAILno request");
+			return;
+		}
+	}
+
+	fetch_lba = part_info.start + offset / part_info.blksz;
+	fetch_size = size;
+	fetch_left = size;
+	fetch_bytes = 0;
+	printf("Starting fetch of %u bytes from %s\n", fetch_size, part_name);
+
+	sprintf(response, "DATA%08x", fetch_size);
+	fastboot_tx_write_str(response);
+	fastboot_func->in_req->complete = tx_handler_fetch_start;
+}
+#endif
+
 static void do_bootm_on_complete(struct usb_ep *ep, struct usb_request *req)
 {
 	char boot_addr_start[12];
@@ -1782,6 +2232,82 @@ static void cb_set_active(struct usb_ep *ep, struct usb_request *req)
 #endif
 }
 
+#ifdef CONFIG_FASTBOOT_FLASH_PIPELINE
+/*
+ * Move a sparse image out of the way of the next download and reply at
+ * once, fastboot_flash_run() writes it while the host sends the next one.
+ */
+static bool fastboot_flash_queue(const char *cmd)
+{
+	if (!is_sparse_image((void *)CONFIG_FASTBOOT_BUF_ADDR) ||
+	    strlen(cmd) >= sizeof(flash_part))
+		return false;
+
+	memcpy((void *)FLASH_BUF_ADDR, (void *)CONFIG_FASTBOOT_BUF_ADDR,
+	       download_bytes);
+	strcpy(flash_part, cmd);
+	flash_bytes = download_bytes;
+	flash_busy = true;
+
+	return true;
+}
+
+/*
+ * Hold back everything but a download while an image is being written,
+ * and answer the first command after a failed write with its error.
+ */
+static bool fastboot_flash_defer(struct usb_ep *ep, struct usb_request *req)
+{
+	if (flash_busy) {
+		if (!strcmp_l1("download:", req->buf))
+			return false;
+		flash_deferred = req;
+		return true;
+	}
+
+	if (!flash_failed)
+		return false;
+
+	flash_failed = false;
+	fastboot_tx_write_str(flash_response);
+	*(char *)req->buf = '\0';
+	req->actual = 0;
+	usb_ep_queue(ep, req, 0);
+
+	return true;
+}
+
+void fastboot_flash_poll(void)
+{
+	if (flash_busy)
+		usb_gadget_handle_interrupts(flash_index);
+}
+
+void fastboot_flash_run(int index)
+{
+	struct usb_request *req;
+
+	if (!flash_busy)
+		return;
+
+	flash_index = index;
+	fastboot_fail("no flash device defined", flash_response);
+	fb_mmc_flash_write(flash_part, (void *)FLASH_BUF_ADDR, flash_bytes,
+			   flash_response);
+	flash_busy = false;
+
+	if (strncmp(flash_response, "OKAY", 4)) {
+		printf("flashing %s failed: %s\n", flash_part, flash_response + 4);
+		flash_failed = true;
+	}
+
+	req = flash_deferred;
+	flash_deferred = NULL;
+	if (req)
+		rx_handler_command(fastboot_func->out_ep, req);
+}
+#endif
+
 #ifdef CONFIG_FASTBOOT_FLASH
 static void cb_flash(struct usb_ep *ep, struct usb_request *req)
 {
@@ -1822,6 +2348,12 @@ static void cb_flash(struct usb_ep *ep, struct usb_request *req)
 			return;
 		}
 	}
+#endif
+#ifdef CONFIG_FASTBOOT_FLASH_PIPELINE
+	if (fastboot_flash_queue(cmd)) {
+		fastboot_tx_write_str("OKAY");
+		return;
+	}
 #endif
 	fastboot_fail("no flash device defined", response);
 #ifdef CONFIG_FASTBOOT_FLASH_MMC_DEV
@@ -2336,6 +2868,11 @@ static const struct cmd_dispatch_info cmd_dispatch_info[] = {
 		.cmd = "upload",
 		.cb = cb_upload,
 	}, {
+#ifdef CONFIG_FASTBOOT_FETCH
+		.cmd = "fetch:",
+		.cb = cb_fetch,
+	}, {
+#endif
 		.cmd = "boot",
 		.cb = cb_boot,
 	}, {
@@ -2373,6 +2910,11 @@ static void rx_handler_command(struct usb_ep *ep, struct usb_request *req)
 	if (req->status != 0 || req->length == 0)
 		return;
 
+#ifdef CONFIG_FASTBOOT_FLASH_PIPELINE
+	if (fastboot_flash_defer(ep, req))
+		return;
+#endif
+
 	for (i = 0; i < ARRAY_SIZE(cmd_dispatch_info); i++) {
 		if (!strcmp_l1(cmd_dispatch_info[i].cmd, cmdbuf)) {
 			func_cb = cmd_dispatch_info[i].cb;
@@ -2396,5 +2938,10 @@ static void rx_handler_command(struct usb_ep *ep, struct usb_request *req)
 
 	*cmdbuf = '\0';
 	req->actual = 0;
+#ifdef CONFIG_FASTBOOT_DL_DIRECT
+	/* Queued again by fastboot_dl_direct_end() */
+	if (dl_req_busy)
+		return;
+#endif
 	usb_ep_queue(ep, req, 0);
 }
@@ -320,6 +320,23 @@ struct fsg_common {
 	u32			residue;
 	u32			usb_amount_left;
 	u32			usb_trb_size;	/* usb transfer size */
+	u32			usb_trb_align;	/* keep writes within, 0 if none */
+
+	/* Sequential read-ahead, see fsg_read_ahead() */
+	void			*ra_buf;
+	u32			ra_lba;
+	u32			ra_count;	/* sectors in ra_buf, 0 if none */
+	u32			ra_next;	/* where the last READ ended */
+	unsigned int		ra_lun;
+	unsigned int		ra_wanted:1;
+
+	/* Write coalescing, see fsg_wb_flush() */
+	void			*wb_buf;
+	loff_t			wb_offset;
+	u32			wb_len;		/* bytes not written back yet */
+	unsigned int		wb_lun;
+	ulong			wb_time;	/* get_timer() of the last WRITE */
+	unsigned int		wb_error:1;	/* for SYNCHRONIZE CACHE */
 
 	unsigned int		can_stall:1;
 	unsigned int		free_storage_on_release:1;
@@ -647,6 +664,65 @@ static void busy_indicator(void)
 		state = 0;
 }
 
+/*-------------------------------------------------------------------------*/
+
+/*
+ * Adjacent WRITEs are gathered in wb_buf and reach the backing store as
+ * one write, which eMMC takes much faster than many small ones. The
+ * caching mode page reports a write cache, so the host sends SYNCHRONIZE
+ * CACHE before it relies on the data. Besides, wb_buf is written back
+ * before any other command, when the host idles and when it goes away.
+ */
+static int fsg_wb_flush(struct fsg_common *common)
+{
+	struct ums *ums_dev = &ums[common->wb_lun];
+	u32 len = common->wb_len;
+	int rc;
+
+	if (!len)
+		return 0;
+
+	common->wb_len = 0;
+	rc = ums_dev->write_sector(ums_dev, common->wb_offset / SECTOR_SIZE,
+				   len / SECTOR_SIZE, common->wb_buf);
+	if (rc * SECTOR_SIZE != len) {
+		printf("UMS: write back of %u @ %llu failed\n", len,
+		       (unsigned long long)common->wb_offset);
+		common->wb_error = 1;
+		return -EIO;
+	}
+
+	return 0;
+}
+
+/* Like ums->write_sector(), but may keep the data in wb_buf for a while */
+static int fsg_wb_write(struct fsg_common *common, loff_t file_offset,
+			unsigned int amount, void *buf)
+{
+	struct ums *ums_dev = &ums[common->lun];
+
+	if (common->wb_len &&
+	    (common->wb_lun != common->lun ||
+	     common->wb_offset + common->wb_len != file_offset ||
+	     common->wb_len + amount > FSG_WB_LEN) &&
+	    fsg_wb_flush(common))
+		return 0;
+
+	if (!common->wb_buf || amount >= FSG_WB_LEN)
+		return ums_dev->write_sector(ums_dev, file_offset / SECTOR_SIZE,
+					     amount / SECTOR_SIZE, buf);
+
+	if (!common->wb_len) {
+		common->wb_lun = common->lun;
+		common->wb_offset = file_offset;
+	}
+	memcpy(common->wb_buf + common->wb_len, buf, amount);
+	common->wb_len += amount;
+	common->wb_time = get_timer(0);
+
+	return amount / SECTOR_SIZE;
+}
+
 static int sleep_thread(struct fsg_common *common)
 {
 	int	rc = 0;
@@ -657,6 +733,10 @@ static int sleep_thread(struct fsg_common *common)
 		if (common->thread_wakeup_needed)
 			break;
 
+		if (common->wb_len &&
+		    get_timer(common->wb_time) > FSG_WB_IDLE_MS)
+			fsg_wb_flush(common);
+
 		if (++i == 20000) {
 			busy_indicator();
 			i = 0;
@@ -665,30 +745,71 @@ static int sleep_thread(struct fsg_common *common)
 
 		if (k == 10) {
 			/* Handle CTRL+C */
-			if (ctrlc())
-				return -EPIPE;
+			if (ctrlc()) {
+				rc = -EPIPE;
+				break;
+			}
 
 			/* Check cable connection */
-			if (!g_dnl_board_usb_cable_connected())
-				return -EIO;
+			if (!g_dnl_board_usb_cable_connected()) {
+				rc = -EIO;
+				break;
+			}
 
 			k = 0;
 		}
 
 #ifdef CONFIG_USB_DWC3_GADGET
 		if (rkusb_usb3_capable() && !dwc3_gadget_is_connected()
-		    && !rkusb_force_usb2_enabled())
-			return -ENODEV;
+		    && !rkusb_force_usb2_enabled()) {
+			rc = -ENODEV;
+			break;
+		}
 #endif
 
 		usb_gadget_handle_interrupts(0);
 	}
+
+	if (rc) {
+		/* Nobody is going to ask for it any more */
+		fsg_wb_flush(common);
+		return rc;
+	}
+
 	common->thread_wakeup_needed = 0;
 	return rc;
 }
 
 /*-------------------------------------------------------------------------*/
 
+/*
+ * Once the host reads sequentially, the data following its last READ is
+ * read into ra_buf while the host collects that READ's data and status
+ * and sends the next CBW. A READ starting there swaps ra_buf into the
+ * buffer ring rather than waiting for the backing store.
+ */
+static void fsg_read_ahead(struct fsg_common *common)
+{
+	struct fsg_lun *curlun = &common->luns[common->ra_lun];
+	struct ums *ums_dev = &ums[common->ra_lun];
+	u32 count;
+	int rc;
+
+	if (!common->ra_wanted)
+		return;
+	common->ra_wanted = 0;
+
+	count = min_t(u32, common->usb_trb_size / SECTOR_SIZE,
+		      curlun->num_sectors - common->ra_next);
+	rc = ums_dev->read_sector(ums_dev, common->ra_next, count,
+				  common->ra_buf);
+	if (rc != count)
+		return;
+
+	common->ra_lba = common->ra_next;
+	common->ra_count = count;
+}
+
 static int do_read(struct fsg_common *common)
 {
 	struct fsg_lun		*curlun = &common->luns[common->lun];
@@ -700,6 +821,7 @@ static int do_read(struct fsg_common *common)
 	unsigned int		amount;
 	unsigned int		partial_page;
 	ssize_t			nread;
+	bool			sequential;
 
 	/* Get the starting Logical Block Address and check that it's
 	 * not too big */
@@ -721,6 +843,8 @@ static int do_read(struct fsg_common *common)
 		return -EINVAL;
 	}
 	file_offset = ((loff_t) lba) << 9;
+	sequential = common->ra_buf && common->ra_lun == common->lun &&
+		     common->ra_next == lba;
 
 	/* Carry out the file reads */
 	amount_left = common->data_size_from_cmnd;
@@ -762,11 +886,20 @@ static int do_read(struct fsg_common *common)
 			break;
 		}
 
-		/* Perform the read */
-		rc = ums[common->lun].read_sector(&ums[common->lun],
-				      file_offset / SECTOR_SIZE,
-				      amount / SECTOR_SIZE,
-				      (char __user *)bh->buf);
+		/* Perform the read, unless it has been done ahead */
+		if (common->ra_count && common->ra_lun == common->lun &&
+		    common->ra_lba == file_offset / SECTOR_SIZE &&
+		    amount <= common->ra_count * SECTOR_SIZE) {
+			swap(bh->buf, common->ra_buf);
+			bh->inreq->buf = bh->outreq->buf = bh->buf;
+			rc = amount / SECTOR_SIZE;
+		} else {
+			rc = ums[common->lun].read_sector(&ums[common->lun],
+					      file_offset / SECTOR_SIZE,
+					      amount / SECTOR_SIZE,
+					      (char __user *)bh->buf);
+		}
+		common->ra_count = 0;
 		if (!rc)
 			return -EIO;
 
@@ -811,6 +944,12 @@ static int do_read(struct fsg_common *common)
 		common->next_buffhd_to_fill = bh->next;
 	}
 
+	/* Read ahead after the second READ in a row */
+	common->ra_next = file_offset / SECTOR_SIZE;
+	common->ra_lun = common->lun;
+	common->ra_wanted = sequential && !amount_left &&
+			    common->ra_next < curlun->num_sectors;
+
 	return -EIO;		/* No default reply */
 }
 
@@ -829,6 +968,7 @@ static int do_write(struct fsg_common *common)
 	ssize_t			nwritten;
 	int			rc;
 	const char		*cdev_name __maybe_unused;
+	bool			gather;
 
 	if (curlun->ro) {
 		curlun->sense_data = SS_WRITE_PROTECTED;
@@ -856,6 +996,18 @@ static int do_write(struct fsg_common *common)
 		return -EINVAL;
 	}
 
+	/*
+	 * Rockusb checks what it wrote right away, and FUA asks for the
+	 * medium, so only plain UMS writes are gathered.
+	 */
+	cdev_name = common->fsg->function.config->cdev->driver->name;
+	gather = !IS_RKUSB_UMS_DNL(cdev_name) &&
+		 (common->cmnd[0] == SC_WRITE_6 || !(common->cmnd[1] & 0x08));
+	if (!gather && fsg_wb_flush(common)) {
+		curlun->sense_data = SS_WRITE_ERROR;
+		return -EIO;
+	}
+
 	/* Carry out the file writes */
 	get_some_more = 1;
 	file_offset = usb_offset = ((loff_t) lba) << 9;
@@ -882,6 +1034,15 @@ static int do_write(struct fsg_common *common)
 			if (partial_page > 0)
 				amount = min(amount,
 	(unsigned int) PAGE_CACHE_SIZE - partial_page);
+			/* Realign to e.g. the erase group after an odd LBA */
+			if (common->usb_trb_align) {
+				partial_page = usb_offset &
+					       (common->usb_trb_align - 1);
+				if (partial_page > 0)
+					amount = min(amount,
+						     common->usb_trb_align -
+						     partial_page);
+			}
 
 			if (amount == 0) {
 				get_some_more = 0;
@@ -938,10 +1099,14 @@ static int do_write(struct fsg_common *common)
 			amount = bh->outreq->actual;
 
 			/* Perform the write */
-			rc = ums[common->lun].write_sector(&ums[common->lun],
-					       file_offset / SECTOR_SIZE,
-					       amount / SECTOR_SIZE,
-					       (char __user *)bh->buf);
+			if (gather)
+				rc = fsg_wb_write(common, file_offset, amount,
+						  bh->buf);
+			else
+				rc = ums[common->lun].write_sector(&ums[common->lun],
+						       file_offset / SECTOR_SIZE,
+						       amount / SECTOR_SIZE,
+						       (char __user *)bh->buf);
 			if (!rc)
 				return -EIO;
 			nwritten = rc * SECTOR_SIZE;
@@ -987,7 +1152,6 @@ static int do_write(struct fsg_common *common)
 			return rc;
 	}
 
-	cdev_name = common->fsg->function.config->cdev->driver->name;
 	if (IS_RKUSB_UMS_DNL(cdev_name))
 		rkusb_do_check_parity(common);
 
@@ -998,6 +1162,15 @@ static int do_write(struct fsg_common *common)
 
 static int do_synchronize_cache(struct fsg_common *common)
 {
+	struct fsg_lun	*curlun = &common->luns[common->lun];
+
+	/* Also report a write back that failed since the last time */
+	if (fsg_wb_flush(common) || common->wb_error) {
+		common->wb_error = 0;
+		curlun->sense_data = SS_WRITE_ERROR;
+		return -EIO;
+	}
+
 	return 0;
 }
 
@@ -1810,6 +1983,27 @@ static int do_scsi_command(struct fsg_common *common)
 	common->phase_error = 0;
 	common->short_packet_received = 0;
 
+	/*
+	 * Only a READ may take the data read ahead, and anything but a
+	 * WRITE must find the gathered writes on the medium.
+	 */
+	switch (common->cmnd[0]) {
+	case SC_READ_6:
+	case SC_READ_10:
+	case SC_READ_12:
+		fsg_wb_flush(common);
+		break;
+	case SC_WRITE_6:
+	case SC_WRITE_10:
+	case SC_WRITE_12:
+		common->ra_count = 0;
+		break;
+	default:
+		fsg_wb_flush(common);
+		common->ra_count = 0;
+		break;
+	}
+
 	down_read(&common->filesem);	/* We're using the backing file */
 
 	cdev_name = common->fsg->function.config->cdev->driver->name;
@@ -2168,6 +2362,9 @@ static int get_next_command(struct fsg_common *common)
 	 * can reuse it for the next filling.  No need to advance
 	 * next_buffhd_to_fill. */
 
+	/* Meanwhile the host may still be fetching the last READ */
+	fsg_read_ahead(common);
+
 	/* Wait for the CBW to arrive */
 	while (bh->state != BUF_STATE_FULL) {
 		rc = sleep_thread(common);
@@ -2367,6 +2564,8 @@ static void handle_exception(struct fsg_common *common)
 	}
 	common->next_buffhd_to_fill = &common->buffhds[0];
 	common->next_buffhd_to_drain = &common->buffhds[0];
+	common->ra_count = 0;
+	common->ra_wanted = 0;
 	exception_req_tag = common->exception_req_tag;
 	old_state = common->state;
 
@@ -2534,24 +2733,28 @@ static struct fsg_common *fsg_common_init(struct fsg_common *common,
 	}
 	common->lun = 0;
 
-	/* Data buffers cyclic list */
-	bh = common->buffhds;
-
-	i = FSG_NUM_BUFFERS;
-	goto buffhds_first_it;
-	do {
-		bh->next = bh + 1;
-		++bh;
-buffhds_first_it:
+	/*
+	 * Data buffers cyclic list. Buffers past the first two only deepen
+	 * the queue, so make do with fewer if memory is short.
+	 */
+	for (i = 0; i < FSG_NUM_BUFFERS; i++) {
+		bh = &common->buffhds[i];
 		bh->inreq_busy = 0;
 		bh->outreq_busy = 0;
 		bh->buf = memalign(CONFIG_SYS_CACHELINE_SIZE, FSG_BUFLEN);
 		if (unlikely(!bh->buf)) {
+			if (i >= 2)
+				break;
 			rc = -ENOMEM;
 			goto error_release;
 		}
-	} while (--i);
-	bh->next = common->buffhds;
+		bh->next = bh + 1;
+	}
+	common->buffhds[i - 1].next = common->buffhds;
+
+	/* UMS works as before without these, so they are optional */
+	common->ra_buf = memalign(CONFIG_SYS_CACHELINE_SIZE, FSG_BUFLEN);
+	common->wb_buf = memalign(CONFIG_SYS_CACHELINE_SIZE, FSG_WB_LEN);
 
 	snprintf(common->inquiry_string, sizeof common->inquiry_string,
 		 "%-8s%-16s%04x",
@@ -2618,6 +2821,8 @@ static void fsg_common_release(struct kref *ref)
 			kfree(bh->buf);
 		} while (++bh, --i);
 	}
+	kfree(common->ra_buf);
+	kfree(common->wb_buf);
 
 	if (common->free_storage_on_release)
 		kfree(common);
@@ -12,6 +12,7 @@
 #include <asm/arch/chip_info.h>
 #include <asm/arch/rk_atags.h>
 #include <write_keybox.h>
+#include <linux/log2.h>
 #include <linux/mtd/mtd.h>
 #include <optee_include/OpteeClientInterface.h>
 #include <dm.h>
@@ -22,6 +23,7 @@
 #include <usbplug.h>
 #include <asm/arch/vendor.h>
 #include <rockusb.h>
+#include <u-boot/sha256.h>
 
 #define ROCKUSB_INTERFACE_CLASS	0xff
 #define ROCKUSB_INTERFACE_SUB_CLASS	0x06
@@ -192,6 +194,29 @@ static int rkusb_do_switch_to_usb3(struct fsg_common *common,
 	return 0;
 }
 
+/*
+ * Split LBA writes at eMMC erase group boundaries, so each buffer is
+ * written as whole groups once the first short one realigns them.
+ */
+static u32 rkusb_write_align(struct blk_desc *desc, u32 usb_trb_size)
+{
+	struct mmc *mmc;
+	u32 grp;
+
+	if (desc->if_type != IF_TYPE_MMC)
+		return 0;
+
+	mmc = find_mmc_device(desc->devnum);
+	if (!mmc)
+		return 0;
+
+	grp = mmc->erase_grp_size * 512;
+	if (!grp || grp > usb_trb_size || !is_power_of_2(grp))
+		return 0;
+
+	return grp;
+}
+
 static int rkusb_do_test_unit_ready(struct fsg_common *common,
 				    struct fsg_buffhd *bh)
 {
@@ -209,6 +234,7 @@ static int rkusb_do_test_unit_ready(struct fsg_common *common,
 
 	usb_trb_size = (1 << residue) * 4096;
 	common->usb_trb_size = min(usb_trb_size, FSG_BUFLEN);
+	common->usb_trb_align = rkusb_write_align(desc, common->usb_trb_size);
 	common->residue = residue << 24;
 	common->data_dir = DATA_DIR_NONE;
 	bh->state = BUF_STATE_EMPTY;
@@ -959,6 +985,239 @@ static int rkusb_do_read_otp(struct fsg_common *common,
 }
 #endif
 
+#ifdef CONFIG_CMD_ROCKUSB_LOAD_IMAGES
+DECLARE_GLOBAL_DATA_PTR;
+
+struct rkusb_load {
+	struct rkusb_manifest hdr;
+	struct rkusb_image image[RKUSB_MANIFEST_MAX_IMAGES];
+	u32 hdr_len;		/* bytes of the manifest, once count is in */
+	u32 hdr_got;
+	u32 cur;		/* image being received */
+	u32 offset;		/* bytes of it received */
+	sha256_context ctx;
+	int err;
+};
+
+static struct rkusb_load rkusb_load;
+static ulong rkusb_exec_addr;
+
+static void __do_exec(struct usb_ep *ep, struct usb_request *req)
+{
+	void (*entry)(void) = (void *)rkusb_exec_addr;
+
+	printf("Starting image at 0x%lx\n", rkusb_exec_addr);
+	cleanup_before_linux();
+	entry();
+}
+
+static int rkusb_load_check(struct rkusb_load *ld)
+{
+	/* The stack, malloc and U-Boot itself are above start_addr_sp */
+	ulong start = gd->bd->bi_dram[0].start;
+	ulong end = gd->start_addr_sp - SZ_1M;
+	struct rkusb_image *img;
+	int i;
+
+	for (i = 0; i < ld->hdr.count; i++) {
+		img = &ld->image[i];
+		if (img->load_addr < start || img->load_addr > end ||
+		    img->size > end - img->load_addr) {
+			printf("Image %d 0x%x@0x%llx is outside 0x%lx-0x%lx\n",
+			       i, img->size, img->load_addr, start, end);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+/* Finish the images which are complete, the empty ones right away */
+static int rkusb_load_next(struct rkusb_load *ld)
+{
+	struct rkusb_image *img;
+	u8 sum[SHA256_SUM_LEN];
+
+	while (ld->cur < ld->hdr.count) {
+		img = &ld->image[ld->cur];
+		if (ld->offset < img->size)
+			break;
+
+		flush_cache(img->load_addr, img->size);
+		if (img->flags & RKUSB_IMAGE_SHA256) {
+			sha256_finish(&ld->ctx, sum);
+			if (memcmp(sum, img->sha256, SHA256_SUM_LEN)) {
+				printf("Image %d sha256 mismatch\n", ld->cur);
+				return -EBADMSG;
+			}
+		}
+		if (img->flags & RKUSB_IMAGE_EXEC)
+			rkusb_exec_addr = img->load_addr;
+
+		ld->cur++;
+		ld->offset = 0;
+		sha256_starts(&ld->ctx);
+	}
+
+	return 0;
+}
+
+/* Take the next @len bytes of the transfer */
+static int rkusb_load_data(struct rkusb_load *ld, const u8 *buf, u32 len)
+{
+	struct rkusb_image *img;
+	u32 n;
+	int ret;
+
+	while (len) {
+		if (ld->hdr_got < ld->hdr_len) {
+			n = min(len, ld->hdr_len - ld->hdr_got);
+			memcpy((u8 *)&ld->hdr + ld->hdr_got, buf, n);
+			ld->hdr_got += n;
+			buf += n;
+			len -= n;
+			if (ld->hdr_got == sizeof(ld->hdr)) {
+				if (ld->hdr.magic != RKUSB_MANIFEST_MAGIC ||
+				    ld->hdr.count > RKUSB_MANIFEST_MAX_IMAGES) {
+					printf("Bad manifest magic 0x%x count %u\n",
+					       ld->hdr.magic, ld->hdr.count);
+					return -EINVAL;
+				}
+				ld->hdr_len += ld->hdr.count *
+					       sizeof(struct rkusb_image);
+			}
+			if (ld->hdr_got < ld->hdr_len)
+				continue;
+			ret = rkusb_load_check(ld);
+			if (ret)
+				return ret;
+			ret = rkusb_load_next(ld);
+			if (ret)
+				return ret;
+			continue;
+		}
+
+		if (ld->cur >= ld->hdr.count) {
+			printf("0x%x bytes behind the last image\n", len);
+			return -EINVAL;
+		}
+
+		img = &ld->image[ld->cur];
+		n = min(len, img->size - ld->offset);
+		memcpy((void *)(ulong)img->load_addr + ld->offset, buf, n);
+		if (img->flags & RKUSB_IMAGE_SHA256)
+			sha256_update(&ld->ctx, buf, n);
+		ld->offset += n;
+		buf += n;
+		len -= n;
+		ret = rkusb_load_next(ld);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/*
+ * LOAD_IMAGES: receive a manifest and the images behind it. As with the
+ * LBA writes all buffers are kept queued, so each one is copied to its
+ * load address and hashed while the next ones come in.
+ */
+static int rkusb_do_load_images(struct fsg_common *common)
+{
+	struct fsg_lun		*curlun = &common->luns[common->lun];
+	struct rkusb_load	*ld = &rkusb_load;
+	struct fsg_buffhd	*bh;
+	u32			amount, left_to_req;
+	int			rc;
+
+	if (unlikely(common->data_size == 0))
+		return -EIO; /* No data to write */
+
+	memset(ld, 0, sizeof(*ld));
+	ld->hdr_len = sizeof(ld->hdr);
+	rkusb_exec_addr = 0;
+	sha256_starts(&ld->ctx);
+
+	common->residue         = common->data_size;
+	common->usb_amount_left = common->data_size;
+	left_to_req		= common->data_size;
+
+	for (;;) {
+		/* Queue a request for more data from the host */
+		bh = common->next_buffhd_to_fill;
+		if (left_to_req && bh->state == BUF_STATE_EMPTY) {
+			amount = min(left_to_req, common->usb_trb_size);
+			left_to_req		     -= amount;
+			common->usb_amount_left      -= amount;
+			bh->outreq->length	     = amount;
+			bh->bulk_out_intended_length = amount;
+			bh->outreq->short_not_ok     = 1;
+
+			START_TRANSFER_OR(common, bulk_out, bh->outreq,
+					  &bh->outreq_busy, &bh->state)
+				/*
+				 * Don't know what to do if
+				 * common->fsg is NULL
+				 */
+				return -EIO;
+			common->next_buffhd_to_fill = bh->next;
+			continue;
+		}
+
+		/* Load what was received */
+		bh = common->next_buffhd_to_drain;
+		if (bh->state == BUF_STATE_FULL) {
+			common->next_buffhd_to_drain = bh->next;
+			bh->state = BUF_STATE_EMPTY;
+
+			/* Did something go wrong with the transfer? */
+			if (bh->outreq->status != 0) {
+				curlun->sense_data = SS_COMMUNICATION_FAILURE;
+				curlun->info_valid = 1;
+				break;
+			}
+
+			amount = bh->outreq->actual;
+			common->residue -= amount;
+			/* Take the rest anyway, an error fails the command */
+			if (!ld->err)
+				ld->err = rkusb_load_data(ld, bh->buf, amount);
+
+			/* Did the host decide to stop early? */
+			if (amount != bh->outreq->length) {
+				common->short_packet_received = 1;
+				break;
+			}
+			if (!common->residue)
+				break;
+			continue;
+		}
+
+		/* Wait for something to happen */
+		rc = sleep_thread(common);
+		if (rc)
+			return rc;
+	}
+
+	if (!ld->err && (ld->hdr_got < ld->hdr_len ||
+			 ld->cur < ld->hdr.count))
+		ld->err = -EINVAL;
+	if (ld->err) {
+		printf("Load images failed: %d\n", ld->err);
+		curlun->sense_data = SS_WRITE_ERROR;
+		return -EIO;
+	}
+
+	printf("Loaded %u images\n", ld->hdr.count);
+	/* Start it once the status is sent */
+	if (rkusb_exec_addr)
+		common->next_buffhd_to_fill->inreq->complete = __do_exec;
+
+	return -EIO; /* No default reply */
+}
+#endif
+
 static void rkusb_fixup_cbwcb(struct fsg_common *common,
 			      struct fsg_buffhd *bh)
 {
@@ -1058,6 +1317,13 @@ static int rkusb_cmd_process(struct fsg_common *common,
 		rc = RKUSB_RC_FINISHED;
 		break;
 
+#ifdef CONFIG_CMD_ROCKUSB_LOAD_IMAGES
+	case RKUSB_LOAD_IMAGES:
+		*reply = rkusb_do_load_images(common);
+		rc = RKUSB_RC_FINISHED;
+		break;
+#endif
+
 	case RKUSB_SWITCH_STORAGE:
 		*reply = rkusb_do_switch_storage(common);
 		rc = RKUSB_RC_FINISHED;
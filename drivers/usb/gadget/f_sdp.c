@@ -708,7 +708,7 @@ static void sdp_handle_in_ep(struct spl_image_info *spl_image)
 				sdp_ptr(sdp_func->jmp_address);
 #ifdef CONFIG_SPL_LOAD_FIT
 			if (image_get_magic(header) == FDT_MAGIC) {
-				struct spl_load_info load;
+				struct spl_load_info load = { 0 };
 
 				debug("Found FIT\n");
 				load.dev = header;
@@ -305,8 +305,15 @@ static struct fsg_lun *fsg_lun_from_dev(struct device *dev)
 #define EP0_BUFSIZE	256
 #define DELAYED_STATUS	(EP0_BUFSIZE + 999)	/* An impossibly large value */
 
-/* Number of buffers we will use.  2 is enough for double-buffering */
+/*
+ * Number of buffers we will use.  2 is enough for double-buffering, more
+ * keep the host sending while a slow storage write is in progress.
+ */
+#if defined(CONFIG_USB_DWC3_GADGET) && defined(ROCKUSB_FSG_NUM_BUFFERS)
+#define FSG_NUM_BUFFERS	ROCKUSB_FSG_NUM_BUFFERS
+#else
 #define FSG_NUM_BUFFERS	2
+#endif
 
 #if defined(CONFIG_USB_DWC3_GADGET) && defined(ROCKUSB_FSG_BUFLEN)
 #define FSG_BUFLEN	((u32)ROCKUSB_FSG_BUFLEN)
@@ -315,6 +322,14 @@ static struct fsg_lun *fsg_lun_from_dev(struct device *dev)
 #define FSG_BUFLEN	((u32)262144)
 #endif
 
+/*
+ * Adjacent WRITEs are gathered into one backing store write of up to
+ * FSG_WB_LEN, which is written back at the latest after FSG_WB_IDLE_MS
+ * without any new command.
+ */
+#define FSG_WB_LEN	((u32)0x100000)
+#define FSG_WB_IDLE_MS	20
+
 /* Maximal number of LUNs supported in mass storage function */
 #define FSG_MAX_LUNS	8
 
@@ -548,7 +563,7 @@ static struct usb_ss_ep_comp_descriptor
 fsg_ss_bulk_in_comp_desc = {
 	.bLength		= sizeof(fsg_ss_bulk_in_comp_desc),
 	.bDescriptorType	= USB_DT_SS_ENDPOINT_COMP,
-	/* .bMaxBurst		= DYNAMIC, */
+	.bMaxBurst		= 15,
 };
 
 static struct usb_endpoint_descriptor
@@ -565,7 +580,7 @@ static struct usb_ss_ep_comp_descriptor
 fsg_ss_bulk_out_comp_desc = {
 	.bLength		= sizeof(fsg_ss_bulk_out_comp_desc),
 	.bDescriptorType	= USB_DT_SS_ENDPOINT_COMP,
-	/* .bMaxBurst		= DYNAMIC, */
+	.bMaxBurst		= 15,
 };
 
 /* Maxpacket and other transfer characteristics vary by speed. */
@@ -584,6 +599,7 @@ fsg_ep_desc(struct usb_gadget *g, struct usb_endpoint_descriptor *fs,
 		if (gadget_is_superspeed(g)) {
 			speed_desc = ss;
 			ep->comp_desc = comp_desc;
+			ep->maxburst = comp_desc->bMaxBurst + 1;
 			break;
 		}
 		/* else: Fall trough */
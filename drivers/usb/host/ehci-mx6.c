@@ -563,7 +563,7 @@ static int ehci_usb_bind(struct udevice *dev)
 	u32 controller_spacing = is_mx7() ? 0x10000 : 0x200;
 	fdt_addr_t addr = devfdt_get_addr_index(dev, 0);
 
-	dev->req_seq = (addr - USB_BASE_ADDR) / controller_spacing;
+	dev_set_req_seq(dev, (addr - USB_BASE_ADDR) / controller_spacing);
 
 	return 0;
 }
@@ -303,7 +303,7 @@ static int vf_usb_bind(struct udevice *dev)
 	 * sequence number of 0. This conflicts with our requirement of
 	 * sequence numbers while initialising the peripherals.
 	 */
-	dev->req_seq = num_controllers;
+	dev_set_req_seq(dev, num_controllers);
 	num_controllers++;
 
 	return 0;
@@ -204,6 +204,7 @@ int usb_stop(void)
 	return err;
 }
 
+#if !CONFIG_IS_ENABLED(USB_PARALLEL_SCAN)
 static void usb_scan_bus(struct udevice *bus, bool recurse)
 {
 	struct usb_bus_priv *priv;
@@ -224,6 +225,60 @@ static void usb_scan_bus(struct udevice *bus, bool recurse)
 	else
 		printf("%d USB Device(s) found\n", priv->next_addr);
 }
+#endif
+
+/*
+ * Scan the primary controllers or their companions. With USB_PARALLEL_SCAN
+ * each root hub is powered on first and all their ports are scanned in one
+ * loop, so the power-good and connect waits of the controllers overlap.
+ */
+static void usb_scan_buses(struct uclass *uc, bool companion)
+{
+	struct usb_bus_priv *priv;
+	struct udevice *bus;
+#if CONFIG_IS_ENABLED(USB_PARALLEL_SCAN)
+	struct udevice *dev;
+	int ret;
+
+	usb_hub_scan_defer(true);
+	uclass_foreach_dev(bus, uc) {
+		if (!device_active(bus))
+			continue;
+		priv = dev_get_uclass_priv(bus);
+		if (priv->companion != companion)
+			continue;
+		ret = usb_scan_device(bus, 0, USB_SPEED_FULL, &dev);
+		if (ret)
+			printf("scanning bus %s failed, error %d\n",
+			       bus->name, ret);
+	}
+	ret = usb_hub_scan_defer(false);
+	if (ret)
+		printf("scanning USB ports failed, error %d\n", ret);
+
+	uclass_foreach_dev(bus, uc) {
+		if (!device_active(bus))
+			continue;
+		priv = dev_get_uclass_priv(bus);
+		if (priv->companion != companion)
+			continue;
+		printf("scanning bus %s for devices... ", bus->name);
+		if (priv->next_addr == 0)
+			printf("No USB Device found\n");
+		else
+			printf("%d USB Device(s) found\n", priv->next_addr);
+	}
+#else
+	uclass_foreach_dev(bus, uc) {
+		if (!device_active(bus))
+			continue;
+
+		priv = dev_get_uclass_priv(bus);
+		if (priv->companion == companion)
+			usb_scan_bus(bus, true);
+	}
+#endif
+}
 
 static void remove_inactive_children(struct uclass *uc, struct udevice *bus)
 {
@@ -243,7 +298,6 @@ int usb_init(void)
 {
 	int controllers_initialized = 0;
 	struct usb_uclass_priv *uc_priv;
-	struct usb_bus_priv *priv;
 	struct udevice *bus;
 	struct uclass *uc;
 	int ret;
@@ -293,30 +347,15 @@ int usb_init(void)
 	 * lowlevel init done, now scan the bus for devices i.e. search HUBs
 	 * and configure them, first scan primary controllers.
 	 */
-	uclass_foreach_dev(bus, uc) {
-		if (!device_active(bus))
-			continue;
-
-		priv = dev_get_uclass_priv(bus);
-		if (!priv->companion)
-			usb_scan_bus(bus, true);
-	}
+	usb_scan_buses(uc, false);
 
 	/*
 	 * Now that the primary controllers have been scanned and have handed
 	 * over any devices they do not understand to their companions, scan
 	 * the companions if necessary.
 	 */
-	if (uc_priv->companion_device_count) {
-		uclass_foreach_dev(bus, uc) {
-			if (!device_active(bus))
-				continue;
-
-			priv = dev_get_uclass_priv(bus);
-			if (priv->companion)
-				usb_scan_bus(bus, true);
-		}
-	}
+	if (uc_priv->companion_device_count)
+		usb_scan_buses(uc, true);
 
 	debug("scan end\n");
 
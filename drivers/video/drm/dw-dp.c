@@ -1459,7 +1459,8 @@ static int dw_dp_connector_get_edid(struct rockchip_connector *conn, struct disp
 	struct connector_state *conn_state = &state->conn_state;
 	struct dw_dp *dp = connector_to_dw_dp(conn);
 
-	ret = drm_do_get_edid(&dp->aux.ddc, conn_state->edid);
+	ret = drm_do_get_edid_cached(&dp->aux.ddc, conn_state->edid,
+				     conn->dev->name);
 
 	return ret;
 }
@@ -1644,7 +1645,8 @@ static int dw_dp_connector_get_timing(struct rockchip_connector *conn, struct di
 	edid_data.mode_buf = mode_buf;
 
 	if (!dp->force_output) {
-		ret = drm_do_get_edid(&dp->aux.ddc, conn_state->edid);
+		ret = drm_do_get_edid_cached(&dp->aux.ddc, conn_state->edid,
+					     conn->dev->name);
 		if (!ret)
 			ret = drm_add_edid_modes(&edid_data, conn_state->edid);
 
@@ -2641,7 +2641,8 @@ int rockchip_dw_hdmi_get_timing(struct rockchip_connector *conn, struct display_
 	if (!hdmi)
 		return -EFAULT;
 
-	ret = drm_do_get_edid(&hdmi->adap, conn_state->edid);
+	ret = drm_do_get_edid_cached(&hdmi->adap, conn_state->edid,
+				     conn->dev->name);
 
 	if (!ret) {
 		hdmi->sink_has_audio = drm_detect_monitor_audio(edid);
@@ -2715,7 +2716,8 @@ int rockchip_dw_hdmi_get_edid(struct rockchip_connector *conn, struct display_st
 	struct connector_state *conn_state = &state->conn_state;
 	struct dw_hdmi *hdmi = conn->data;
 
-	ret = drm_do_get_edid(&hdmi->adap, conn_state->edid);
+	ret = drm_do_get_edid_cached(&hdmi->adap, conn_state->edid,
+				     conn->dev->name);
 
 	return ret;
 }
@@ -1503,7 +1503,8 @@ int rockchip_dw_hdmi_qp_get_timing(struct rockchip_connector *conn, struct displ
 	struct dw_hdmi_qp *hdmi = conn->data;
 	int ret;
 
-	ret = drm_do_get_edid(&hdmi->adap, conn_state->edid);
+	ret = drm_do_get_edid_cached(&hdmi->adap, conn_state->edid,
+				     conn->dev->name);
 
 	if (conn_state->secondary)
 		_rockchip_dw_hdmi_qp_get_timing(conn_state->secondary, state, ret);
@@ -1531,7 +1532,8 @@ int rockchip_dw_hdmi_qp_get_edid(struct rockchip_connector *conn, struct display
 	struct connector_state *conn_state = &state->conn_state;
 	struct dw_hdmi_qp *hdmi = conn->data;
 
-	ret = drm_do_get_edid(&hdmi->adap, conn_state->edid);
+	ret = drm_do_get_edid_cached(&hdmi->adap, conn_state->edid,
+				     conn->dev->name);
 
 	return ret;
 }
@@ -749,7 +749,8 @@ static int rockchip_inno_hdmi_get_timing(struct rockchip_connector *conn,
 	if (!hdmi)
 		return -EFAULT;
 
-	ret = drm_do_get_edid(&hdmi->adap, conn_state->edid);
+	ret = drm_do_get_edid_cached(&hdmi->adap, conn_state->edid,
+				     conn->dev->name);
 	if (!ret) {
 		hdmi->hdmi_data.sink_is_hdmi =
 			drm_detect_hdmi_monitor(edid);
@@ -68,6 +68,25 @@ static inline uint32_t read_uint32(uint8_t *data, unsigned int o) {
                            ((unsigned)data[o+3] << 24));
 }
 
+/* Colour from B,G,R bytes, in the channel order the image decodes to */
+static inline uint32_t bmp_colour(bmp_image *bmp, uint8_t *data) {
+        if (bmp->bgra)
+                return data[0] | (data[1] << 8) | (data[2] << 16);
+        return data[2] | (data[1] << 8) | (data[0] << 16);
+}
+
+/* Bit position of channel i (R, G, B, A) in a decoded pixel */
+static inline int bmp_channel_pos(bmp_image *bmp, int i) {
+        if (bmp->bgra && (i == 0 || i == 2))
+                return (2 - i) << 3;
+        return i << 3;
+}
+
+static inline uint32_t bmp_swap_rb(uint32_t colour) {
+        return (colour & 0xff00ff00) | ((colour & 0xff) << 16) |
+               ((colour >> 16) & 0xff);
+}
+
 
 /**
  * Parse the bitmap info header
@@ -277,7 +296,7 @@ static bmp_result bmp_info_header_parse(bmp_image *bmp, uint8_t *data)
                                                         bmp->mask[i] &= (unsigned)0xff << (j - 7);
                                                 else
                                                         bmp->mask[i] &= 0xff >> (-(j - 7));
-                                                bmp->shift[i] = (i << 3) - (j - 7);
+                                                bmp->shift[i] = bmp_channel_pos(bmp, i) - (j - 7);
                                                 break;
                                         }
                         }
@@ -316,7 +335,7 @@ static bmp_result bmp_info_header_parse(bmp_image *bmp, uint8_t *data)
                 if (!bmp->colour_table)
                         return BMP_INSUFFICIENT_MEMORY;
                 for (i = 0; i < bmp->colours; i++) {
-                        uint32_t colour = data[2] | (data[1] << 8) | (data[0] << 16);
+                        uint32_t colour = bmp_colour(bmp, data);
                         if (bmp->opaque)
                                 colour |= ((uint32_t)0xff << 24);
                         data += palette_size;
@@ -534,7 +553,7 @@ static bmp_result bmp_decode_rgb32(bmp_image *bmp, uint8_t **start, int bytes)
                 if (bmp->encoding == BMP_ENCODING_BITFIELDS)
                         bmp->transparent_index = read_uint32(data, 0);
                 else
-                        bmp->transparent_index = data[2] | (data[1] << 8) | (data[0] << 16);
+                        bmp->transparent_index = bmp_colour(bmp, data);
         }
 
         for (y = 0; y < bmp->height; y++) {
@@ -544,7 +563,13 @@ static bmp_result bmp_decode_rgb32(bmp_image *bmp, uint8_t **start, int bytes)
                         scanline = (void *)(top + (y * swidth));
                 else
                         scanline = (void *)(bottom - (y * swidth));
-                if (bmp->encoding == BMP_ENCODING_BITFIELDS) {
+                if (bmp->bgra && !bmp->limited_trans &&
+                    bmp->encoding != BMP_ENCODING_BITFIELDS) {
+                        /* the pixels are stored as they decode to */
+                        word = bmp->opaque ? (unsigned)0xff << 24 : 0;
+                        for (x = 0; x < bmp->width; x++, data += 4)
+                                scanline[x] = read_uint32(data, 0) | word;
+                } else if (bmp->encoding == BMP_ENCODING_BITFIELDS) {
                         for (x = 0; x < bmp->width; x++) {
                                 word = read_uint32(data, 0);
                                 for (i = 0; i < 4; i++)
@@ -560,7 +585,7 @@ static bmp_result bmp_decode_rgb32(bmp_image *bmp, uint8_t **start, int bytes)
                         }
                 } else {
                         for (x = 0; x < bmp->width; x++) {
-                                scanline[x] = data[2] | (data[1] << 8) | (data[0] << 16);
+                                scanline[x] = bmp_colour(bmp, data);
                                 if ((bmp->limited_trans) && (scanline[x] == bmp->transparent_index)) {
                                         scanline[x] = bmp->trans_colour;
                                 }
@@ -615,7 +640,7 @@ static bmp_result bmp_decode_rgb24(bmp_image *bmp, uint8_t **start, int bytes)
                         return BMP_INSUFFICIENT_DATA;
                 }
 
-                bmp->transparent_index = data[2] | (data[1] << 8) | (data[0] << 16);
+                bmp->transparent_index = bmp_colour(bmp, data);
         }
 
         for (y = 0; y < bmp->height; y++) {
@@ -629,8 +654,17 @@ static bmp_result bmp_decode_rgb24(bmp_image *bmp, uint8_t **start, int bytes)
                         scanline = (void *)(bottom - (y * swidth));
                 }
 
+                if (bmp->bgra && !bmp->limited_trans) {
+                        for (x = 0; x < bmp->width; x++, data += 3)
+                                scanline[x] = data[0] | (data[1] << 8) |
+                                              (data[2] << 16) | ((uint32_t)0xff << 24);
+                        while (addr != (((uintptr_t)data) & 3))
+                                data++;
+                        continue;
+                }
+
                 for (x = 0; x < bmp->width; x++) {
-                        scanline[x] = data[2] | (data[1] << 8) | (data[0] << 16);
+                        scanline[x] = bmp_colour(bmp, data);
                         if ((bmp->limited_trans) && (scanline[x] == bmp->transparent_index)) {
                                 scanline[x] = bmp->trans_colour;
                         } else {
@@ -720,6 +754,8 @@ static bmp_result bmp_decode_rgb16(bmp_image *bmp, uint8_t **start, int bytes)
                                         scanline[x] = ((word & (31 << 0)) << 19) |
                                                       ((word & (31 << 5)) << 6) |
                                                       ((word & (31 << 10)) >> 7);
+                                        if (bmp->bgra)
+                                                scanline[x] = bmp_swap_rb(scanline[x]);
                                 }
                                 if (bmp->opaque)
                                         scanline[x] |= ((unsigned)0xff << 24);
@@ -785,6 +821,17 @@ static bmp_result bmp_decode_rgb(bmp_image *bmp, uint8_t **start, int bytes)
                         scanline = (void *)(top + (y * swidth));
                 else
                         scanline = (void *)(bottom - (y * swidth));
+                if (bmp->bpp == 8 && !bmp->limited_trans) {
+                        /* a byte per pixel, nothing to unpack */
+                        for (x = 0; x < bmp->width; x++) {
+                                if (data[x] < bmp->colours)
+                                        scanline[x] = bmp->colour_table[data[x]];
+                        }
+                        data += bmp->width;
+                        while (addr != (((uintptr_t)data) & 3))
+                                data++;
+                        continue;
+                }
                 for (x = 0; x < bmp->width; x++) {
                         uint32_t idx;
                         if (bit >= ppb) {
@@ -873,7 +920,7 @@ bmp_decode_rle8(bmp_image *bmp, uint8_t *data, int bytes)
         uint8_t *top, *bottom, *end;
         uint32_t *scanline;
         uint32_t swidth;
-        uint32_t i, length, pixels_left;
+        uint32_t i, j, count, length, pixels_left;
         uint32_t x = 0, y = 0, last_y = 0;
         uint32_t pixel = 0;
 
@@ -936,12 +983,10 @@ bmp_decode_rle8(bmp_image *bmp, uint8_t *data, int bytes)
                                 if (data + length > end)
                                         return BMP_INSUFFICIENT_DATA;
 
-                                /* the following code could be easily optimised
-                                 * by simply checking the bounds on entry and
-                                 * using some simple copying routines if so
+                                /* copy up to the end of each scanline in
+                                 * one go, then move to the next one
                                  */
-                                for (i = 0; i < length; i++) {
-                                        uint32_t idx = (uint32_t) *data++;
+                                for (i = 0; i < length; i += count) {
                                         if (x >= bmp->width) {
                                                 x = 0;
                                                 y++;
@@ -953,9 +998,17 @@ bmp_decode_rle8(bmp_image *bmp, uint8_t *data, int bytes)
                                                         scanline -= bmp->width;
                                                 }
                                         }
-                                        if (idx >= bmp->colours)
-                                                return BMP_DATA_ERROR;
-                                        scanline[x++] = bmp->colour_table[idx];
+                                        count = length - i;
+                                        if (count > bmp->width - x)
+                                                count = bmp->width - x;
+                                        for (j = 0; j < count; j++) {
+                                                uint32_t idx = (uint32_t) data[j];
+                                                if (idx >= bmp->colours)
+                                                        return BMP_DATA_ERROR;
+                                                scanline[x + j] = bmp->colour_table[idx];
+                                        }
+                                        data += count;
+                                        x += count;
                                 }
 
                                 if ((length & 1) && (*data++ != 0x00))
@@ -981,16 +1034,13 @@ bmp_decode_rle8(bmp_image *bmp, uint8_t *data, int bytes)
                         if (data + 1 > end)
                                 return BMP_INSUFFICIENT_DATA;
 
-                        /* the following code could be easily optimised by
-                         * simply checking the bounds on entry and using some
-                         * simply copying routines if so
-                         */
                         idx = (uint32_t) *data++;
                         if (idx >= bmp->colours)
                                 return BMP_DATA_ERROR;
 
+                        /* fill up to the end of each scanline in one go */
                         pixel = bmp->colour_table[idx];
-                        for (i = 0; i < length; i++) {
+                        for (i = 0; i < length; i += count) {
                                 if (x >= bmp->width) {
                                         x = 0;
                                         y++;
@@ -1002,7 +1052,12 @@ bmp_decode_rle8(bmp_image *bmp, uint8_t *data, int bytes)
                                                 scanline -= bmp->width;
                                         }
                                 }
-                                scanline[x++] = pixel;
+                                count = length - i;
+                                if (count > bmp->width - x)
+                                        count = bmp->width - x;
+                                for (j = 0; j < count; j++)
+                                        scanline[x + j] = pixel;
+                                x += count;
                         }
                 }
         } while (data < end);
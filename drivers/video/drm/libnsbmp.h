@@ -110,6 +110,10 @@ typedef struct bmp_img {
         bool ico;
         /** true if the bitmap does not contain an alpha channel */
         bool opaque;
+        /** decode to B,G,R,A bytes, as the BMP stores them, not R,G,B,A;
+         * to be set between bmp_create() and bmp_analyse()
+         */
+        bool bgra;
         /** four bitwise mask */
         uint32_t mask[4];
         /** four bitwise shifts */
@@ -18,6 +18,9 @@
 #include <linux/media-bus-format.h>
 #include <malloc.h>
 #include <memalign.h>
+#include <mem_large.h>
+#include <rk_logo.h>
+#include <sysmem.h>
 #include <video.h>
 #include <video_rockchip.h>
 #include <video_bridge.h>
@@ -25,6 +28,7 @@
 #include <dm/uclass-internal.h>
 #include <asm/arch-rockchip/resource_img.h>
 #include <asm/arch-rockchip/cpu.h>
+#include <u-boot/lz4.h>
 
 #include "bmp_helper.h"
 #include "libnsbmp.h"
@@ -663,6 +667,38 @@ static int display_mode_fixup(struct display_state *state)
 	return 0;
 }
 
+#ifdef CONFIG_DRM_ROCKCHIP_ASYNC_ENABLE
+static int display_poll(struct display_state *state);
+
+/*
+ * Go on with the other displays while @state is busy, so that the panel
+ * waits of displays on separate VPs overlap instead of adding up.
+ */
+static void display_poll_others(struct display_state *state)
+{
+	struct display_state *s;
+
+	list_for_each_entry(s, &rockchip_display_list, head) {
+		if (s != state)
+			display_poll(s);
+	}
+}
+#else
+static inline void display_poll_others(struct display_state *state) {}
+#endif
+
+/* Power up @panel for its EDID, the other displays go on meanwhile */
+static void display_panel_prepare(struct display_state *state,
+				  struct rockchip_panel *panel)
+{
+#ifdef CONFIG_DRM_ROCKCHIP_ASYNC_ENABLE
+	panel->async = true;
+#endif
+	rockchip_panel_prepare(panel);
+	while (rockchip_panel_poll(panel) == -EAGAIN)
+		display_poll_others(state);
+}
+
 static int display_init(struct display_state *state)
 {
 	struct connector_state *conn_state = &state->conn_state;
@@ -674,7 +710,7 @@ static int display_init(struct display_state *state)
 	const char *compatible;
 	int ret = 0;
 	static bool __print_once = false;
-#ifdef CONFIG_SPL_BUILD
+#ifdef CONFIG_SPL_DRM_ROCKCHIP_SPLASH
 	struct spl_display_info *spl_disp_info = (struct spl_display_info *)CONFIG_SPL_VIDEO_BUF;
 #endif
 	if (!__print_once) {
@@ -690,7 +726,7 @@ static int display_init(struct display_state *state)
 		return -ENXIO;
 	}
 
-#ifdef CONFIG_SPL_BUILD
+#ifdef CONFIG_SPL_DRM_ROCKCHIP_SPLASH
 	if (state->conn_state.type == DRM_MODE_CONNECTOR_HDMIA)
 		state->enabled_at_spl = spl_disp_info->enabled == 1 ? true : false;
 	if (state->enabled_at_spl)
@@ -719,6 +755,7 @@ static int display_init(struct display_state *state)
 		if (ret)
 			goto deinit;
 	}
+	display_poll_others(state);
 
 	/*
 	 * support hotplug, but not connect;
@@ -736,6 +773,7 @@ static int display_init(struct display_state *state)
 #endif
 
 	ret = rockchip_connector_detect(state);
+	display_poll_others(state);
 #if defined(CONFIG_DRM_ROCKCHIP_TVE) || defined(CONFIG_DRM_ROCKCHIP_RK1000)
 	if (conn_state->type == DRM_MODE_CONNECTOR_HDMIA)
 		crtc->hdmi_hpd = ret;
@@ -747,7 +785,7 @@ static int display_init(struct display_state *state)
 
 	ret = 0;
 	if (state->enabled_at_spl == true) {
-#ifdef CONFIG_SPL_BUILD
+#ifdef CONFIG_SPL_DRM_ROCKCHIP_SPLASH
 		struct drm_display_mode *mode = &conn_state->mode;
 
 		memcpy(mode, &spl_disp_info->mode,  sizeof(*mode));
@@ -762,7 +800,7 @@ static int display_init(struct display_state *state)
 			conn_state->bpc = conn->panel->bpc;
 #if defined(CONFIG_I2C_EDID)
 		if (ret < 0 && conn->funcs->get_edid) {
-			rockchip_panel_prepare(conn->panel);
+			display_panel_prepare(state, conn->panel);
 			ret = conn->funcs->get_edid(conn, state);
 			if (!ret)
 				display_get_edid_mode(state);
@@ -838,6 +876,7 @@ static int display_init(struct display_state *state)
 	       mode->vsync_end, mode->vtotal,
 	       conn_state->bus_format);
 
+	display_poll_others(state);
 	if (crtc_funcs->init && state->enabled_at_spl == false) {
 		ret = crtc_funcs->init(state);
 		if (ret)
@@ -894,23 +933,38 @@ static int display_set_plane(struct display_state *state)
 	return 0;
 }
 
-static int display_enable(struct display_state *state)
+#ifdef CONFIG_DRM_ROCKCHIP_ASYNC_ENABLE
+static void display_set_panels_async(struct display_state *state)
 {
-	struct crtc_state *crtc_state = &state->crtc_state;
-	const struct rockchip_crtc *crtc = crtc_state->crtc;
-	const struct rockchip_crtc_funcs *crtc_funcs = crtc->funcs;
+	struct rockchip_connector *conn = state->conn_state.connector;
+	struct rockchip_connector *secondary = state->conn_state.secondary;
 
-	if (!state->is_init)
-		return -EINVAL;
+	if (conn->panel)
+		conn->panel->async = true;
+	if (secondary && secondary->panel)
+		secondary->panel->async = true;
+}
 
-	if (state->is_enable)
-		return 0;
+static int display_panels_poll(struct display_state *state)
+{
+	struct rockchip_connector *conn = state->conn_state.connector;
+	struct rockchip_connector *secondary = state->conn_state.secondary;
+	int ret = 0;
 
-	if (crtc_funcs->prepare)
-		crtc_funcs->prepare(state);
+	if (rockchip_panel_poll(conn->panel))
+		ret = -EAGAIN;
+	if (secondary && rockchip_panel_poll(secondary->panel))
+		ret = -EAGAIN;
 
-	if (state->enabled_at_spl == false)
-		rockchip_connector_pre_enable(state);
+	return ret;
+}
+#endif
+
+static void display_enable_finish(struct display_state *state)
+{
+	struct crtc_state *crtc_state = &state->crtc_state;
+	const struct rockchip_crtc *crtc = crtc_state->crtc;
+	const struct rockchip_crtc_funcs *crtc_funcs = crtc->funcs;
 
 	if (crtc_funcs->enable)
 		crtc_funcs->enable(state);
@@ -937,12 +991,86 @@ static int display_enable(struct display_state *state)
 
 	if (crtc_state->soft_te)
 		crtc_funcs->apply_soft_te(state);
+}
+
+static int display_enable(struct display_state *state)
+{
+	struct crtc_state *crtc_state = &state->crtc_state;
+	const struct rockchip_crtc *crtc = crtc_state->crtc;
+	const struct rockchip_crtc_funcs *crtc_funcs = crtc->funcs;
+
+	if (!state->is_init)
+		return -EINVAL;
+
+	if (state->is_enable)
+		return 0;
+
+#ifdef CONFIG_DRM_ROCKCHIP_ASYNC_ENABLE
+	display_set_panels_async(state);
+#endif
+
+	if (crtc_funcs->prepare)
+		crtc_funcs->prepare(state);
+
+	if (state->enabled_at_spl == false)
+		rockchip_connector_pre_enable(state);
 
 	state->is_enable = true;
 
+#ifdef CONFIG_DRM_ROCKCHIP_ASYNC_ENABLE
+	/* The rest once the panel is powered up, see rockchip_display_poll() */
+	if (display_panels_poll(state)) {
+		state->enable_pending = true;
+		return 0;
+	}
+#endif
+	display_enable_finish(state);
+
 	return 0;
 }
 
+#ifdef CONFIG_DRM_ROCKCHIP_ASYNC_ENABLE
+static int display_poll(struct display_state *state)
+{
+	if (state->enable_pending) {
+		if (display_panels_poll(state))
+			return -EAGAIN;
+		state->enable_pending = false;
+		display_enable_finish(state);
+	}
+
+	/* And the panel enable delay before the backlight goes on */
+	return display_panels_poll(state);
+}
+
+static void display_sync(struct display_state *state)
+{
+	while (display_poll(state) == -EAGAIN)
+		display_poll_others(state);
+}
+
+int rockchip_display_poll(void)
+{
+	struct display_state *s;
+	int ret = 0;
+
+	list_for_each_entry(s, &rockchip_display_list, head) {
+		if (display_poll(s))
+			ret = -EAGAIN;
+	}
+
+	return ret;
+}
+
+void rockchip_display_sync(void)
+{
+	struct display_state *s;
+
+	list_for_each_entry(s, &rockchip_display_list, head)
+		display_sync(s);
+}
+#endif
+
 static int display_disable(struct display_state *state)
 {
 	struct crtc_state *crtc_state = &state->crtc_state;
@@ -955,6 +1083,9 @@ static int display_disable(struct display_state *state)
 	if (!state->is_enable)
 		return 0;
 
+#ifdef CONFIG_DRM_ROCKCHIP_ASYNC_ENABLE
+	display_sync(state);
+#endif
 	rockchip_connector_disable(state);
 
 	if (crtc_funcs->disable)
@@ -1184,26 +1315,19 @@ static int load_kernel_bmp_logo(struct logo_info *logo, const char *bmp_name)
 #ifdef CONFIG_ROCKCHIP_RESOURCE_IMAGE
 	void *dst = NULL;
 	int len, size;
-	struct bmp_header *header;
 
 	if (!logo || !bmp_name)
 		return -EINVAL;
 
-	header = malloc(RK_BLK_SIZE);
-	if (!header)
-		return -ENOMEM;
-
-	len = rockchip_read_resource_file(header, bmp_name, 0, RK_BLK_SIZE);
-	if (len != RK_BLK_SIZE) {
-		free(header);
+	/* The resource directory knows the size, no need to read the header */
+	size = rockchip_get_resource_file_size(bmp_name);
+	if (size <= 0)
 		return -EINVAL;
-	}
-	size = get_unaligned_le32(&header->file_size);
+
 	dst = (void *)(memory_start + MEMORY_POOL_SIZE / 2);
 	len = rockchip_read_resource_file(dst, bmp_name, 0, size);
 	if (len != size) {
 		printf("failed to load bmp %s\n", bmp_name);
-		free(header);
 		return -ENOENT;
 	}
 
@@ -1317,13 +1441,23 @@ free_header:
 }
 #endif
 
+/*
+ * The decoder writes straight into the display buffer the logo is shown
+ * from, top-down and as ARGB8888, so there is no copy to make after it.
+ */
 static void *bitmap_create(int width, int height, unsigned int state)
 {
+	void *bitmap;
+
 	/* Ensure a stupidly large bitmap is not created */
 	if (width > 4096 || height > 4096)
 		return NULL;
 
-	return calloc(width * height, BYTES_PER_PIXEL);
+	bitmap = get_display_buffer(width * height * BYTES_PER_PIXEL);
+	if (bitmap && (state & BMP_CLEAR_MEMORY))
+		memset(bitmap, 0, width * height * BYTES_PER_PIXEL);
+
+	return bitmap;
 }
 
 static unsigned char *bitmap_get_buffer(void *bitmap)
@@ -1333,27 +1467,45 @@ static unsigned char *bitmap_get_buffer(void *bitmap)
 
 static void bitmap_destroy(void *bitmap)
 {
-	free(bitmap);
+	/* Display buffers are never given back */
 }
 
-static void bmp_copy(void *dst, bmp_image *bmp)
-{
-	u16 row, col;
-	u8 *image;
-	u8 *pdst = (u8 *)dst;
-
-	image = (u8 *)bmp->bitmap;
-	for (row = 0; row != bmp->height; row++) {
-		for (col = 0; col != bmp->width; col++) {
-			size_t z = (row * bmp->width + col) * BYTES_PER_PIXEL;
-
-			*pdst++ = image[z + 2];
-			*pdst++ = image[z + 1];
-			*pdst++ = image[z + 0];
-			*pdst++ = image[z + 3];
-		}
-	}
-}
+/*
+ * Rotate in 16x16 tiles, so that both the rows read and the columns
+ * written stay in cache, one pixel-sized load and store per pixel.
+ * Source pixel (i, j) goes to dst[base + i * di + j * dj].
+ */
+#define LOGO_ROTATE_TILE	16
+
+struct logo_pixel24 {
+	u8 c[3];
+} __packed;
+
+#define DEFINE_LOGO_ROTATE(name, type)					\
+static void name(void *dst, const void *src, int width, int height,	\
+		 long base, long di, long dj)				\
+{									\
+	int ti, tj, i, j, iend, jend;					\
+	const type *s;							\
+	type *d;							\
+									\
+	for (ti = 0; ti < height; ti += LOGO_ROTATE_TILE) {		\
+		iend = min(ti + LOGO_ROTATE_TILE, height);		\
+		for (tj = 0; tj < width; tj += LOGO_ROTATE_TILE) {	\
+			jend = min(tj + LOGO_ROTATE_TILE, width);	\
+			for (i = ti; i < iend; i++) {			\
+				s = (const type *)src + (long)i * width; \
+				d = (type *)dst + base + i * di;	\
+				for (j = tj; j < jend; j++)		\
+					d[j * dj] = s[j];		\
+			}						\
+		}							\
+	}								\
+}
+
+DEFINE_LOGO_ROTATE(rockchip_logo_rotate16, u16)
+DEFINE_LOGO_ROTATE(rockchip_logo_rotate24, struct logo_pixel24)
+DEFINE_LOGO_ROTATE(rockchip_logo_rotate32, u32)
 
 static void *rockchip_logo_rotate(struct logo_info *logo, void *src)
 {
@@ -1362,76 +1514,215 @@ static void *rockchip_logo_rotate(struct logo_info *logo, void *src)
 	int height = logo->height;
 	int width_rotate = logo->height & 0x3 ? (logo->height & ~0x3) + 4 : logo->height;
 	int height_rotate = logo->width;
-	int dst_size = width * height * logo->bpp >> 3;
 	int dst_size_rotate = width_rotate * height_rotate * logo->bpp >> 3;
 	int bytes_per_pixel = logo->bpp >> 3;
-	int padded_width;
-	int i, j;
-	char *img_data;
+	int padded_width = width_rotate;
+	long base, di, dj;
+	int i;
 
 	if (!(logo->rotate == 90 || logo->rotate == 180 || logo->rotate == 270)) {
 		printf("Unsupported rotation angle\n");
 		return NULL;
 	}
-
-	img_data = (char *)malloc(dst_size);
-	if (!img_data) {
-		printf("failed to alloc memory for image data\n");
+	if (bytes_per_pixel < 2 || bytes_per_pixel > 4) {
+		printf("Unsupported logo bpp %d for rotation\n", logo->bpp);
 		return NULL;
 	}
-	memcpy(img_data, src, dst_size);
 
+	/* src is a display buffer of its own, so read it in place */
 	dst_rotate = get_display_buffer(dst_size_rotate);
 	if (!dst_rotate)
 		return NULL;
-	memset(dst_rotate, 0, dst_size_rotate);
 
 	switch (logo->rotate) {
 	case 90:
-		logo->width = width_rotate;
-		logo->height = height_rotate;
-		padded_width = height & 0x3 ? (height & ~0x3) + 4 : height;
-		for (i = 0; i < height; i++) {
-			for (j = 0; j < width; j++) {
-				memcpy(dst_rotate + (j * padded_width * bytes_per_pixel) +
-				       (height - i - 1) * bytes_per_pixel,
-				       img_data + i * width * bytes_per_pixel + j * bytes_per_pixel,
-				       bytes_per_pixel);
-			}
-		}
+		/* (i, j) -> row j, column height - 1 - i */
+		base = height - 1;
+		di = -1;
+		dj = padded_width;
 		break;
 	case 180:
-		for (i = 0; i < height; i++) {
-			for (j = 0; j < width; j++) {
-				memcpy(dst_rotate + (height - i - 1) * width * bytes_per_pixel +
-				       (width - j - 1) * bytes_per_pixel,
-				       img_data + i * width * bytes_per_pixel + j * bytes_per_pixel,
-				       bytes_per_pixel);
-			}
-		}
+		/* (i, j) -> row height - 1 - i, column width - 1 - j */
+		base = (long)(height - 1) * width + width - 1;
+		di = -width;
+		dj = -1;
 		break;
-	case 270:
-		logo->width = width_rotate;
-		logo->height = height_rotate;
-		padded_width = height & 0x3 ? (height & ~0x3) + 4 : height;
-		for (i = 0; i < height; i++) {
-			for (j = 0; j < width; j++) {
-				memcpy(dst_rotate + (width - j - 1) * padded_width * bytes_per_pixel +
-				       i * bytes_per_pixel,
-				       img_data + i * width * bytes_per_pixel + j * bytes_per_pixel,
-				       bytes_per_pixel);
-			}
-		}
+	default:
+		/* 270: (i, j) -> row width - 1 - j, column i */
+		base = (long)(width - 1) * padded_width;
+		di = 1;
+		dj = -padded_width;
+		break;
+	}
+
+	switch (bytes_per_pixel) {
+	case 2:
+		rockchip_logo_rotate16(dst_rotate, src, width, height,
+				       base, di, dj);
+		break;
+	case 3:
+		rockchip_logo_rotate24(dst_rotate, src, width, height,
+				       base, di, dj);
 		break;
 	default:
+		rockchip_logo_rotate32(dst_rotate, src, width, height,
+				       base, di, dj);
 		break;
 	}
 
-	free(img_data);
+	if (logo->rotate != 180) {
+		/* Only the columns padding each row to 4 pixels are left */
+		if (padded_width > height) {
+			for (i = 0; i < height_rotate; i++)
+				memset(dst_rotate + ((long)i * padded_width + height) *
+				       bytes_per_pixel, 0,
+				       (padded_width - height) * bytes_per_pixel);
+		}
+		logo->width = width_rotate;
+		logo->height = height_rotate;
+	}
 
 	return dst_rotate;
 }
 
+#ifdef CONFIG_ROCKCHIP_RESOURCE_IMAGE
+/*
+ * A raw logo, see <rk_logo.h>, is only read or inflated into a display
+ * buffer: it is scanned out as it is stored, with no decode nor rotation.
+ *
+ * @file: the file if it is in memory already, else NULL
+ * @len: its size
+ *
+ * Return: 0 on success, -ENOEXEC if the file is not a raw logo, another
+ * negative error otherwise.
+ */
+static int load_raw_logo(struct logo_info *logo, const char *name,
+			 const void *file, int len)
+{
+	struct rk_raw_logo_header hdr;
+	u32 width, height, bpp, rotate, stride, flags, offset, data_size;
+	void *buf = NULL, *dst;
+	size_t size;
+	int ret = 0;
+
+	if (!file) {
+		buf = malloc(RK_BLK_SIZE);
+		if (!buf)
+			return -ENOMEM;
+		if (rockchip_read_resource_file(buf, name, 0, RK_BLK_SIZE) !=
+		    RK_BLK_SIZE) {
+			free(buf);
+			return -ENOEXEC;
+		}
+		memcpy(&hdr, buf, sizeof(hdr));
+		free(buf);
+		buf = NULL;
+		len = rockchip_get_resource_file_size(name);
+	} else if (len >= sizeof(hdr)) {
+		memcpy(&hdr, file, sizeof(hdr));
+	} else {
+		return -ENOEXEC;
+	}
+
+	if (memcmp(hdr.magic, RK_RAW_LOGO_MAGIC, sizeof(hdr.magic)))
+		return -ENOEXEC;
+
+	width = get_unaligned_le16(&hdr.width);
+	height = get_unaligned_le16(&hdr.height);
+	bpp = get_unaligned_le16(&hdr.bpp);
+	rotate = get_unaligned_le16(&hdr.rotate);
+	stride = get_unaligned_le32(&hdr.stride);
+	flags = get_unaligned_le32(&hdr.flags);
+	offset = get_unaligned_le32(&hdr.data_offset);
+	data_size = get_unaligned_le32(&hdr.data_size);
+	size = (size_t)stride * height;
+
+	/* The stride display_logo() programs is the only one scanned out */
+	if ((bpp != 16 && bpp != 24 && bpp != 32) ||
+	    stride != ALIGN(width * bpp, 32) >> 3 ||
+	    len < 0 || offset > len || data_size > len - offset ||
+	    (!(flags & RK_RAW_LOGO_LZ4) && data_size != size)) {
+		printf("invalid raw logo %s\n", name);
+		return -EINVAL;
+	}
+	if (rotate != logo->rotate) {
+		printf("raw logo %s is rotated by %d, not %d\n", name, rotate,
+		       logo->rotate);
+		return -EINVAL;
+	}
+
+	if (!(flags & RK_RAW_LOGO_LZ4)) {
+		if (file) {
+			dst = get_display_buffer(size);
+			if (!dst)
+				return -ENOMEM;
+			memcpy(dst, file + offset, size);
+			logo->offset = 0;
+		} else {
+			/* Scan out from behind the header, where it is read */
+			dst = get_display_buffer(ALIGN(offset + size,
+						       RK_BLK_SIZE));
+			if (!dst)
+				return -ENOMEM;
+			if (rockchip_read_resource_file(dst, name, 0,
+							offset + size) !=
+			    offset + size)
+				return -EIO;
+			logo->offset = offset;
+		}
+	} else {
+#ifdef CONFIG_LZ4
+		size_t out = size;
+
+		if (!file) {
+			buf = malloc(ALIGN(offset + data_size, RK_BLK_SIZE));
+			if (!buf)
+				return -ENOMEM;
+			if (rockchip_read_resource_file(buf, name, 0,
+							offset + data_size) !=
+			    offset + data_size) {
+				ret = -EIO;
+				goto free_buf;
+			}
+			file = buf;
+		}
+		dst = get_display_buffer(size);
+		if (!dst) {
+			ret = -ENOMEM;
+			goto free_buf;
+		}
+		ret = ulz4fn(file + offset, data_size, dst, &out);
+		if (!ret && out != size)
+			ret = -EINVAL;
+		if (ret) {
+			printf("failed to inflate raw logo %s: %d\n", name, ret);
+			goto free_buf;
+		}
+		logo->offset = 0;
+#else
+		printf("raw logo %s is LZ4 compressed, enable CONFIG_LZ4\n",
+		       name);
+		return -EPROTONOSUPPORT;
+#endif
+	}
+
+	logo->mem = dst;
+	logo->bpp = bpp;
+	logo->width = width;
+	logo->height = height;
+	logo->ymirror = 0;
+	flush_dcache_range((ulong)dst,
+			   ALIGN((ulong)dst + logo->offset + size,
+				 CONFIG_SYS_CACHELINE_SIZE));
+
+#ifdef CONFIG_LZ4
+free_buf:
+	free(buf);
+#endif
+	return ret;
+}
+#endif
+
 static int load_bmp_logo(struct logo_info *logo, const char *bmp_name)
 {
 #ifdef CONFIG_ROCKCHIP_RESOURCE_IMAGE
@@ -1443,7 +1734,8 @@ static int load_bmp_logo(struct logo_info *logo, const char *bmp_name)
 	};
 	bmp_result code;
 	bmp_image bmp;
-	void *bmp_data;
+	const void *bmp_file;
+	void *bmp_data = NULL;
 	void *dst = NULL;
 	void *dst_rotate = NULL;
 	int len, dst_size;
@@ -1461,22 +1753,42 @@ static int load_bmp_logo(struct logo_info *logo, const char *bmp_name)
 		return 0;
 	}
 
-	bmp_data = malloc(MAX_IMAGE_BYTES);
-	if (!bmp_data) {
-		printf("failed to alloc bmp data\n");
-		return -ENOMEM;
+	/* Decode in place if the resource file is in memory already */
+	bmp_file = rockchip_get_resource_file_data(bmp_name, &len);
+
+	ret = load_raw_logo(logo, bmp_name, bmp_file, len);
+	if (ret != -ENOEXEC) {
+		if (!ret) {
+			memcpy(&logo_cache->logo, logo, sizeof(*logo));
+			logo_cache->logo_rotate = logo->rotate;
+		}
+		return ret;
+	}
+	ret = 0;
+
+	if (!bmp_file) {
+		bmp_data = malloc(MAX_IMAGE_BYTES);
+		if (!bmp_data) {
+			printf("failed to alloc bmp data\n");
+			return -ENOMEM;
+		}
 	}
 
 	bmp_create(&bmp, &bitmap_callbacks);
+	bmp.bgra = true;
 
-	len = rockchip_read_resource_file(bmp_data, bmp_name, 0, MAX_IMAGE_BYTES);
-	if (len < 0) {
-		ret = -EINVAL;
-		goto free_bmp_data;
+	if (!bmp_file) {
+		len = rockchip_read_resource_file(bmp_data, bmp_name, 0,
+						  MAX_IMAGE_BYTES);
+		if (len < 0) {
+			ret = -EINVAL;
+			goto free_bmp_data;
+		}
+		bmp_file = bmp_data;
 	}
 
 	/* analyse the BMP */
-	code = bmp_analyse(&bmp, len, bmp_data);
+	code = bmp_analyse(&bmp, len, (uint8_t *)bmp_file);
 	if (code != BMP_OK) {
 		printf("failed to parse bmp:%s header\n", bmp_name);
 		ret = -EINVAL;
@@ -1508,12 +1820,7 @@ static int load_bmp_logo(struct logo_info *logo, const char *bmp_name)
 		}
 	}
 
-	dst = get_display_buffer(dst_size);
-	if (!dst) {
-		ret = -ENOMEM;
-		goto free_bmp_data;
-	}
-	bmp_copy(dst, &bmp);
+	dst = bmp.bitmap;
 
 	if (logo->rotate) {
 		dst_rotate = rockchip_logo_rotate(logo, dst);
@@ -1556,9 +1863,29 @@ void rockchip_show_fbbase(ulong fbbase)
 	}
 }
 
+/* Same plane setup, only the buffer differs */
+static bool logo_same_layout(const struct logo_info *a,
+			     const struct logo_info *b)
+{
+	return a->mode == b->mode && a->ymirror == b->ymirror &&
+	       a->width == b->width && a->height == b->height &&
+	       a->bpp == b->bpp;
+}
+
+static int display_logo_flip(struct display_state *state)
+{
+	struct crtc_state *crtc_state = &state->crtc_state;
+	struct logo_info *logo = &state->logo;
+
+	crtc_state->dma_addr = (u32)(unsigned long)logo->mem + logo->offset;
+
+	return display_set_plane(state);
+}
+
 int rockchip_show_bmp(const char *bmp)
 {
 	struct display_state *s;
+	struct logo_info old;
 	int ret = 0;
 
 	if (!bmp) {
@@ -1568,10 +1895,34 @@ int rockchip_show_bmp(const char *bmp)
 	}
 
 	list_for_each_entry(s, &rockchip_display_list, head) {
+		old = s->logo;
 		s->logo.mode = s->charge_logo_mode;
 		if (load_bmp_logo(&s->logo, bmp))
 			continue;
-		ret = display_logo(s);
+		/*
+		 * Charge animation frames only differ in the battery level,
+		 * point the plane at the cached frame and leave the rest be.
+		 */
+		if (s->is_enable && old.mem && logo_same_layout(&old, &s->logo))
+			ret = display_logo_flip(s);
+		else
+			ret = display_logo(s);
+	}
+
+	return ret;
+}
+
+int rockchip_preload_bmp(const char *bmp)
+{
+	struct display_state *s;
+	struct logo_info logo;
+	int ret = 0;
+
+	list_for_each_entry(s, &rockchip_display_list, head) {
+		logo = s->logo;
+		logo.mode = s->charge_logo_mode;
+		if (load_bmp_logo(&logo, bmp))
+			ret = -ENOENT;
 	}
 
 	return ret;
@@ -1584,6 +1935,7 @@ int rockchip_show_logo(void)
 	int ret = 0;
 	int count = 0;
 
+	bootstage_start(BOOTSTAGE_ID_ACCUM_LCD, "display");
 	list_for_each_entry(s, &rockchip_display_list, head) {
 		s->logo.mode = s->logo_mode;
 		s->logo.rotate = s->logo_rotate;
@@ -1612,6 +1964,7 @@ int rockchip_show_logo(void)
 			count++;
 		}
 	}
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_LCD);
 
 	return ret;
 }
@@ -2038,6 +2391,22 @@ static int rockchip_display_fixup_dts(void *blob)
 }
 #endif
 
+#ifdef CONFIG_SPL_DRM_ROCKCHIP_SPLASH
+/* Keep the SPL splash scanned out until a logo of ours replaces it */
+static void rockchip_display_reserve_splash(void)
+{
+	struct spl_display_info *spl_disp_info = (struct spl_display_info *)CONFIG_SPL_VIDEO_BUF;
+
+	if (spl_disp_info->enabled != 1 || !spl_disp_info->splash)
+		return;
+
+	if (!sysmem_alloc_base_by_name("spl-splash", spl_disp_info->splash_addr,
+				       ALIGN(spl_disp_info->splash_size, PAGE_SIZE)))
+		printf("failed to reserve spl splash at 0x%x\n",
+		       spl_disp_info->splash_addr);
+}
+#endif
+
 static int rockchip_display_probe(struct udevice *dev)
 {
 	struct video_priv *uc_priv = dev_get_uclass_priv(dev);
@@ -2070,6 +2439,9 @@ static int rockchip_display_probe(struct udevice *dev)
 	data->phy_init = false;
 
 	init_display_buffer(plat->base);
+#ifdef CONFIG_SPL_DRM_ROCKCHIP_SPLASH
+	rockchip_display_reserve_splash();
+#endif
 
 	route_node = dev_read_subnode(dev, "route");
 	if (!ofnode_valid(route_node))
@@ -2276,6 +2648,9 @@ void rockchip_display_fixup(void *blob)
 	const char *cacm_header;
 	u64 aligned_memory_size;
 
+	/* The kernel takes over the displays as they are now */
+	rockchip_display_sync();
+
 	if (fdt_node_offset_by_compatible(blob, 0, "rockchip,drm-logo") >= 0) {
 		list_for_each_entry(s, &rockchip_display_list, head) {
 			ret = load_bmp_logo(&s->logo, s->klogo_name);
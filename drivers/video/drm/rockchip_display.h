@@ -306,6 +306,8 @@ struct display_state {
 	int enable;
 	int is_init;
 	int is_enable;
+	/* crtc and connector enable wait for the panel to be prepared */
+	bool enable_pending;
 	bool is_klogo_valid;
 	bool force_output;
 	bool enabled_at_spl;
@@ -60,9 +60,26 @@ struct rockchip_panel_plat {
 	struct rockchip_panel_cmds *off_cmds;
 };
 
+/*
+ * Power up sequence of a simple panel, each step waiting for the delay the
+ * previous one started
+ */
+enum panel_simple_step {
+	PANEL_STEP_OFF,
+	PANEL_STEP_POWERED,	/* delay.prepare */
+	PANEL_STEP_RESET,	/* delay.reset */
+	PANEL_STEP_RELEASED,	/* delay.init */
+	PANEL_STEP_PREPARED,
+	PANEL_STEP_ENABLING,	/* delay.enable */
+	PANEL_STEP_ENABLED,
+};
+
 struct rockchip_panel_priv {
 	bool prepared;
 	bool enabled;
+	int step;
+	int target;
+	unsigned long ready;	/* timer_get_us() the current delay ends at */
 	struct udevice *power_supply;
 	struct udevice *backlight;
 	struct spi_slave *spi_slave;
@@ -292,51 +309,101 @@ static int rockchip_panel_send_dsi_cmds(struct mipi_dsi_device *dsi,
 	return 0;
 }
 
-static void panel_simple_prepare(struct rockchip_panel *panel)
+static void panel_simple_delay(struct rockchip_panel_priv *priv,
+			       unsigned int ms)
+{
+	priv->ready = timer_get_us() + ms * 1000UL;
+}
+
+/*
+ * Run the power up sequence up to priv->target, as far as its delays allow.
+ *
+ * Return: -EAGAIN while a delay is still running, 0 once the target is hit.
+ */
+static int panel_simple_run(struct rockchip_panel *panel)
 {
 	struct rockchip_panel_plat *plat = dev_get_platdata(panel->dev);
 	struct rockchip_panel_priv *priv = dev_get_priv(panel->dev);
 	struct mipi_dsi_device *dsi = dev_get_parent_platdata(panel->dev);
 	int ret;
 
-	if (priv->prepared)
-		return;
-
-	if (priv->power_supply)
-		regulator_set_enable(priv->power_supply, !plat->power_invert);
-
-	if (dm_gpio_is_valid(&priv->enable_gpio))
-		dm_gpio_set_value(&priv->enable_gpio, 1);
-
-	if (plat->delay.prepare)
-		mdelay(plat->delay.prepare);
+	while (priv->step < priv->target) {
+		if ((long)(timer_get_us() - priv->ready) < 0)
+			return -EAGAIN;
+
+		switch (priv->step) {
+		case PANEL_STEP_OFF:
+			if (priv->power_supply)
+				regulator_set_enable(priv->power_supply,
+						     !plat->power_invert);
+			if (dm_gpio_is_valid(&priv->enable_gpio))
+				dm_gpio_set_value(&priv->enable_gpio, 1);
+			panel_simple_delay(priv, plat->delay.prepare);
+			break;
+		case PANEL_STEP_POWERED:
+			if (dm_gpio_is_valid(&priv->reset_gpio))
+				dm_gpio_set_value(&priv->reset_gpio, 1);
+			panel_simple_delay(priv, plat->delay.reset);
+			break;
+		case PANEL_STEP_RESET:
+			if (dm_gpio_is_valid(&priv->reset_gpio))
+				dm_gpio_set_value(&priv->reset_gpio, 0);
+			panel_simple_delay(priv, plat->delay.init);
+			break;
+		case PANEL_STEP_RELEASED:
+			if (plat->on_cmds) {
+				if (priv->cmd_type == CMD_TYPE_SPI)
+					ret = rockchip_panel_send_spi_cmds(panel,
+						panel->state, plat->on_cmds);
+				else if (priv->cmd_type == CMD_TYPE_MCU)
+					ret = rockchip_panel_send_mcu_cmds(panel,
+						panel->state, plat->on_cmds);
+				else
+					ret = rockchip_panel_send_dsi_cmds(dsi,
+						plat->on_cmds);
+				if (ret)
+					printf("failed to send on cmds: %d\n", ret);
+			}
+			priv->prepared = true;
+			break;
+		case PANEL_STEP_PREPARED:
+			panel_simple_delay(priv, plat->delay.enable);
+			break;
+		case PANEL_STEP_ENABLING:
+			if (priv->backlight)
+				backlight_enable(priv->backlight);
+			priv->enabled = true;
+			break;
+		}
+		priv->step++;
+	}
 
-	if (dm_gpio_is_valid(&priv->reset_gpio))
-		dm_gpio_set_value(&priv->reset_gpio, 1);
+	return 0;
+}
 
-	if (plat->delay.reset)
-		mdelay(plat->delay.reset);
+static void panel_simple_wait(struct rockchip_panel *panel)
+{
+	while (panel_simple_run(panel) == -EAGAIN)
+		;
+}
 
-	if (dm_gpio_is_valid(&priv->reset_gpio))
-		dm_gpio_set_value(&priv->reset_gpio, 0);
+static int panel_simple_poll(struct rockchip_panel *panel)
+{
+	return panel_simple_run(panel);
+}
 
-	if (plat->delay.init)
-		mdelay(plat->delay.init);
+static void panel_simple_prepare(struct rockchip_panel *panel)
+{
+	struct rockchip_panel_priv *priv = dev_get_priv(panel->dev);
 
-	if (plat->on_cmds) {
-		if (priv->cmd_type == CMD_TYPE_SPI)
-			ret = rockchip_panel_send_spi_cmds(panel, panel->state,
-							   plat->on_cmds);
-		else if (priv->cmd_type == CMD_TYPE_MCU)
-			ret = rockchip_panel_send_mcu_cmds(panel, panel->state,
-							   plat->on_cmds);
-		else
-			ret = rockchip_panel_send_dsi_cmds(dsi, plat->on_cmds);
-		if (ret)
-			printf("failed to send on cmds: %d\n", ret);
-	}
+	if (priv->prepared || priv->target >= PANEL_STEP_PREPARED)
+		return;
 
-	priv->prepared = true;
+	priv->target = PANEL_STEP_PREPARED;
+	if (panel->async)
+		panel_simple_run(panel);
+	else
+		panel_simple_wait(panel);
 }
 
 static void panel_simple_unprepare(struct rockchip_panel *panel)
@@ -346,6 +413,7 @@ static void panel_simple_unprepare(struct rockchip_panel *panel)
 	struct mipi_dsi_device *dsi = dev_get_parent_platdata(panel->dev);
 	int ret;
 
+	panel_simple_wait(panel);
 	if (!priv->prepared)
 		return;
 
@@ -375,23 +443,22 @@ static void panel_simple_unprepare(struct rockchip_panel *panel)
 		mdelay(plat->delay.unprepare);
 
 	priv->prepared = false;
+	priv->step = PANEL_STEP_OFF;
+	priv->target = PANEL_STEP_OFF;
 }
 
 static void panel_simple_enable(struct rockchip_panel *panel)
 {
-	struct rockchip_panel_plat *plat = dev_get_platdata(panel->dev);
 	struct rockchip_panel_priv *priv = dev_get_priv(panel->dev);
 
-	if (priv->enabled)
+	if (priv->enabled || priv->target == PANEL_STEP_ENABLED)
 		return;
 
-	if (plat->delay.enable)
-		mdelay(plat->delay.enable);
-
-	if (priv->backlight)
-		backlight_enable(priv->backlight);
-
-	priv->enabled = true;
+	priv->target = PANEL_STEP_ENABLED;
+	if (panel->async)
+		panel_simple_run(panel);
+	else
+		panel_simple_wait(panel);
 }
 
 static void panel_simple_disable(struct rockchip_panel *panel)
@@ -399,6 +466,7 @@ static void panel_simple_disable(struct rockchip_panel *panel)
 	struct rockchip_panel_plat *plat = dev_get_platdata(panel->dev);
 	struct rockchip_panel_priv *priv = dev_get_priv(panel->dev);
 
+	panel_simple_wait(panel);
 	if (!priv->enabled)
 		return;
 
@@ -409,6 +477,8 @@ static void panel_simple_disable(struct rockchip_panel *panel)
 		mdelay(plat->delay.disable);
 
 	priv->enabled = false;
+	priv->step = PANEL_STEP_PREPARED;
+	priv->target = PANEL_STEP_PREPARED;
 }
 
 static const struct rockchip_panel_funcs rockchip_panel_funcs = {
@@ -416,6 +486,7 @@ static const struct rockchip_panel_funcs rockchip_panel_funcs = {
 	.unprepare = panel_simple_unprepare,
 	.enable = panel_simple_enable,
 	.disable = panel_simple_disable,
+	.poll = panel_simple_poll,
 };
 
 static int rockchip_panel_ofdata_to_platdata(struct udevice *dev)
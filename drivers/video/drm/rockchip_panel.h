@@ -18,6 +18,11 @@ struct rockchip_panel_funcs {
 	void (*disable)(struct rockchip_panel *panel);
 	int (*get_mode)(struct rockchip_panel *panel,
 			struct drm_display_mode *mode);
+	/*
+	 * With async set, prepare and enable only start what they have to
+	 * wait for; poll goes on with it and returns -EAGAIN until done.
+	 */
+	int (*poll)(struct rockchip_panel *panel);
 };
 
 struct rockchip_panel {
@@ -29,6 +34,7 @@ struct rockchip_panel {
 
 	struct rockchip_connector *conn;
 	struct display_state *state;
+	bool async;
 };
 
 static inline void rockchip_panel_init(struct rockchip_panel *panel,
@@ -66,6 +72,17 @@ static inline void rockchip_panel_enable(struct rockchip_panel *panel)
 		panel->funcs->enable(panel);
 }
 
+static inline int rockchip_panel_poll(struct rockchip_panel *panel)
+{
+	if (!panel)
+		return 0;
+
+	if (panel->funcs && panel->funcs->poll)
+		return panel->funcs->poll(panel);
+
+	return 0;
+}
+
 static inline void rockchip_panel_unprepare(struct rockchip_panel *panel)
 {
 	if (!panel)
@@ -12,6 +12,7 @@
 #include <part.h>
 #include <drm_modes.h>
 #include <spl_display.h>
+#include <rk_logo.h>
 #include <linux/hdmi.h>
 
 #include "rockchip_display.h"
@@ -20,6 +21,11 @@
 #include "rockchip_phy.h"
 
 static struct base2_info base_parameter;
+#ifdef CONFIG_SPL_DRM_ROCKCHIP_SPLASH
+/* Set by spl_load_splash() for spl_init_display() to scan out */
+static struct rk_raw_logo_header splash;
+static bool splash_loaded;
+#endif
 
 struct display_state *rockchip_spl_display_drv_probe(void)
 {
@@ -122,6 +128,52 @@ static int rockchip_spl_display_post_enable(struct display_state *state)
 	return 0;
 }
 
+#ifdef CONFIG_SPL_DRM_ROCKCHIP_SPLASH
+/*
+ * One window of the primary plane, the one U-Boot proper shows its logo
+ * on, so that taking over is only a change of the buffer address.
+ */
+static int rockchip_spl_display_set_splash(struct display_state *state)
+{
+	struct crtc_state *crtc_state = &state->crtc_state;
+	struct connector_state *conn_state = &state->conn_state;
+	const struct rockchip_crtc *crtc = crtc_state->crtc;
+	const struct rockchip_crtc_funcs *crtc_funcs = crtc->funcs;
+	int hdisplay = conn_state->mode.crtc_hdisplay;
+	int vdisplay = conn_state->mode.vdisplay;
+
+	if (!splash_loaded || !crtc_funcs->set_plane)
+		return 0;
+
+	switch (splash.bpp) {
+	case 16:
+		crtc_state->format = ROCKCHIP_FMT_RGB565;
+		break;
+	case 24:
+		crtc_state->format = ROCKCHIP_FMT_RGB888;
+		break;
+	default:
+		crtc_state->format = ROCKCHIP_FMT_ARGB8888;
+		break;
+	}
+
+	crtc_state->src_rect.x = 0;
+	crtc_state->src_rect.y = 0;
+	crtc_state->src_rect.w = min_t(int, splash.width, hdisplay);
+	crtc_state->src_rect.h = min_t(int, splash.height, vdisplay);
+	crtc_state->crtc_rect.x = (hdisplay - crtc_state->src_rect.w) / 2;
+	crtc_state->crtc_rect.y = (vdisplay - crtc_state->src_rect.h) / 2;
+	crtc_state->crtc_rect.w = crtc_state->src_rect.w;
+	crtc_state->crtc_rect.h = crtc_state->src_rect.h;
+	crtc_state->ymirror = 0;
+	crtc_state->rb_swap = 0;
+	crtc_state->dma_addr = CONFIG_SPL_DRM_ROCKCHIP_SPLASH_FB;
+	crtc_state->xvir = splash.stride >> 2;
+
+	return crtc_funcs->set_plane(state);
+}
+#endif
+
 static void rockchip_spl_display_transmit_info_to_uboot(struct display_state *state)
 {
 	struct connector_state *conn_state = &state->conn_state;
@@ -131,6 +183,12 @@ static void rockchip_spl_display_transmit_info_to_uboot(struct display_state *st
 	memcpy(&spl_disp_info->mode, &conn_state->mode, sizeof(conn_state->mode));
 	spl_disp_info->bus_format = state->conn_state.bus_format;
 	spl_disp_info->enabled = 1;
+#ifdef CONFIG_SPL_DRM_ROCKCHIP_SPLASH
+	/* The buffer is scanned out until U-Boot proper shows its logo */
+	spl_disp_info->splash = splash_loaded;
+	spl_disp_info->splash_addr = CONFIG_SPL_DRM_ROCKCHIP_SPLASH_FB;
+	spl_disp_info->splash_size = splash.data_size;
+#endif
 	flush_dcache_all();
 }
 
@@ -157,6 +215,15 @@ int spl_init_display(struct task_data *data)
 		return 0;
 	}
 
+#ifdef CONFIG_SPL_DRM_ROCKCHIP_SPLASH
+	/* Before the VP is enabled, the first frame has the logo */
+	ret = rockchip_spl_display_set_splash(state);
+	if (ret) {
+		printf("rockchip_spl_display_set_splash failed ret:%d\n", ret);
+		splash_loaded = false;
+	}
+#endif
+
 	ret = rockchip_spl_display_post_enable(state);
 	if (ret) {
 		printf("rockchip_spl_display_post_enable failed ret:%d\n", ret);
@@ -266,3 +333,53 @@ int spl_load_baseparamter(struct task_data *data)
 	return 0;
 }
 
+
+#ifdef CONFIG_SPL_DRM_ROCKCHIP_SPLASH
+/*
+ * Read the raw logo, see <rk_logo.h>, at the start of the "logo" partition
+ * straight into the splash framebuffer. It must be uncompressed and made
+ * for the mode SPL sets, there is no decoding, scaling or rotating here.
+ */
+int spl_load_splash(struct task_data *data)
+{
+	struct spl_load_info *info = &data->info;
+	void *fb = (void *)CONFIG_SPL_DRM_ROCKCHIP_SPLASH_FB;
+	disk_partition_t part;
+	ulong blk, cnt;
+
+	debug("== Splash: start\n");
+
+	if (part_get_info_by_name(info->dev, "logo", &part) < 0) {
+		printf("No logo partition\n");
+		return -ENOENT;
+	}
+
+	/* The header block goes where the pixels go next */
+	if (info->read(info, part.start, 1, fb) != 1)
+		return -EIO;
+	memcpy(&splash, fb, sizeof(splash));
+
+	if (memcmp(splash.magic, RK_RAW_LOGO_MAGIC, sizeof(splash.magic)) ||
+	    (splash.flags & RK_RAW_LOGO_LZ4) ||
+	    (splash.bpp != 16 && splash.bpp != 24 && splash.bpp != 32) ||
+	    splash.stride < splash.width * splash.bpp / 8 ||
+	    splash.data_size < splash.stride * splash.height ||
+	    splash.data_offset % info->bl_len) {
+		printf("Splash: not an uncompressed raw logo\n");
+		return -EINVAL;
+	}
+
+	blk = splash.data_offset / info->bl_len;
+	cnt = DIV_ROUND_UP(splash.data_size, info->bl_len);
+	if (blk + cnt > part.size)
+		return -EINVAL;
+	if (info->read(info, part.start + blk, cnt, fb) != cnt)
+		return -EIO;
+	flush_dcache_range((ulong)fb, (ulong)fb + cnt * info->bl_len);
+	splash_loaded = true;
+
+	debug("== Splash: %dx%d load OK\n", splash.width, splash.height);
+
+	return 0;
+}
+#endif
@@ -1392,6 +1392,9 @@ struct vop2_data {
 	u32 dump_regs_size;
 };
 
+/* Words of the commit dirty map, one bit per register */
+#define VOP2_DIRTY_WORDS			DIV_ROUND_UP(RK3568_MAX_REG / 4, 32)
+
 struct vop2 {
 	u32 *regsbak;
 	void *regs;
@@ -1405,6 +1408,10 @@ struct vop2 {
 	u32 esmart_lb_mode;
 	bool global_init;
 	bool merge_irq;
+	/* Registers held back by an open commit, see vop2_commit_begin() */
+	bool in_commit;
+	u32 commit_cfg_done;
+	u32 dirty[VOP2_DIRTY_WORDS];
 	const struct vop2_data *data;
 	struct vop2_vp_plane_mask vp_plane_mask[VOP2_VP_MAX];
 };
@@ -1561,14 +1568,75 @@ static inline u16 scl_cal_scale2(int src, int dst)
 	return ((src - 1) << 12) / (dst - 1);
 }
 
+static inline bool vop2_reg_dirty(struct vop2 *vop2, u32 offset)
+{
+	u32 i = offset >> 2;
+
+	return vop2->dirty[i / 32] & BIT(i % 32);
+}
+
+static inline void vop2_reg_set_dirty(struct vop2 *vop2, u32 offset)
+{
+	u32 i = offset >> 2;
+
+	vop2->dirty[i / 32] |= BIT(i % 32);
+}
+
+/*
+ * Between vop2_commit_begin() and vop2_commit(), vop2_writel() and the
+ * cached vop2_mask_write() only update regsbak, and the cfg_done bits of
+ * all the writes to RK3568_REG_CFG_DONE are gathered. vop2_commit() then
+ * writes each changed register once, in a burst, followed by a single
+ * cfg_done. Write-masked registers are not cached and go out at once.
+ */
+static void vop2_commit_begin(struct vop2 *vop2)
+{
+	vop2->in_commit = true;
+}
+
+static void vop2_commit(struct vop2 *vop2)
+{
+	u32 i, bits, reg;
+
+	if (!vop2->in_commit)
+		return;
+
+	vop2->in_commit = false;
+	for (i = 0; i < VOP2_DIRTY_WORDS; i++) {
+		bits = vop2->dirty[i];
+		vop2->dirty[i] = 0;
+		while (bits) {
+			reg = i * 32 + __ffs(bits);
+			bits &= bits - 1;
+			writel(vop2->regsbak[reg], vop2->regs + (reg << 2));
+		}
+	}
+
+	if (vop2->commit_cfg_done) {
+		writel(vop2->commit_cfg_done, vop2->regs + RK3568_REG_CFG_DONE);
+		vop2->commit_cfg_done = 0;
+	}
+}
+
 static inline void vop2_writel(struct vop2 *vop2, u32 offset, u32 v)
 {
-	writel(v, vop2->regs + offset);
 	vop2->regsbak[offset >> 2] = v;
+	if (vop2->in_commit) {
+		if (offset == RK3568_REG_CFG_DONE)
+			vop2->commit_cfg_done |= v;
+		else
+			vop2_reg_set_dirty(vop2, offset);
+		return;
+	}
+
+	writel(v, vop2->regs + offset);
 }
 
 static inline u32 vop2_readl(struct vop2 *vop2, u32 offset)
 {
+	if (vop2->in_commit && vop2_reg_dirty(vop2, offset))
+		return vop2->regsbak[offset >> 2];
+
 	return readl(vop2->regs + offset);
 }
 
@@ -1586,6 +1654,10 @@ static inline void vop2_mask_write(struct vop2 *vop2, u32 offset,
 
 		v = (cached_val & ~(mask << shift)) | ((v & mask) << shift);
 		vop2->regsbak[offset >> 2] = v;
+		if (vop2->in_commit) {
+			vop2_reg_set_dirty(vop2, offset);
+			return;
+		}
 	}
 
 	writel(v, vop2->regs + offset);
@@ -4616,6 +4688,8 @@ static int rockchip_vop2_init(struct display_state *state)
 	    conn_state->output_if & VOP_OUTPUT_IF_BT656)
 		conn_state->output_mode = ROCKCHIP_OUT_MODE_P888;
 
+	/* The VP timing and post-processing registers go out in one burst */
+	vop2_commit_begin(vop2);
 	vop2_post_color_swap(state);
 
 	vop2_mask_write(vop2, RK3568_VP0_DSP_CTRL + vp_offset, OUT_MODE_MASK,
@@ -4710,6 +4784,7 @@ static int rockchip_vop2_init(struct display_state *state)
 
 	vop2_tv_config_update(state, vop2);
 	vop2_post_config(state, vop2);
+	vop2_commit(vop2);
 	if (cstate->feature & (VOP_FEATURE_POST_ACM | VOP_FEATURE_POST_CSC))
 		vop3_post_config(state, vop2);
 
@@ -5397,6 +5472,7 @@ static int rockchip_vop2_set_plane(struct display_state *state)
 				printf("splice mode: open vp%d plane pd fail\n", cstate->splice_crtc_id);
 
 			vop2_calc_display_rect_for_splice(state);
+			vop2_commit_begin(vop2);
 			if (win_data->type == CLUSTER_LAYER)
 				vop2_set_cluster_win(state, splice_win_data);
 			else
@@ -5408,10 +5484,13 @@ static int rockchip_vop2_set_plane(struct display_state *state)
 		}
 	}
 
+	/* Both windows of a splice go out with one cfg_done */
+	vop2_commit_begin(vop2);
 	if (win_data->type == CLUSTER_LAYER)
 		ret = vop2_set_cluster_win(state, win_data);
 	else
 		ret = vop2_set_smart_win(state, win_data);
+	vop2_commit(vop2);
 	if (ret)
 		return ret;
 
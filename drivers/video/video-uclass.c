@@ -7,6 +7,7 @@
 #include <common.h>
 #include <dm.h>
 #include <mapmem.h>
+#include <mem_large.h>
 #include <stdio_dev.h>
 #include <video.h>
 #include <video_console.h>
@@ -108,15 +109,17 @@ int video_reserve(ulong *addrp)
 static int video_clear(struct udevice *dev)
 {
 	struct video_priv *priv = dev_get_uclass_priv(dev);
+	u32 bg = priv->colour_bg & 0xff;
 
-	if (priv->bpix == VIDEO_BPP32) {
+	if (priv->bpix == VIDEO_BPP32 && priv->colour_bg != bg * 0x01010101) {
 		u32 *ppix = priv->fb;
 		u32 *end = priv->fb + priv->fb_size;
 
 		while (ppix < end)
 			*ppix++ = priv->colour_bg;
 	} else {
-		memset(priv->fb, priv->colour_bg, priv->fb_size);
+		/* Black or white: a byte fill, spread over all CPUs */
+		memset_large(priv->fb, priv->colour_bg, priv->fb_size);
 	}
 
 	return 0;
@@ -169,6 +169,23 @@ static inline int env_aes_cbc_crypt(env_t *env, const int enc)
 }
 #endif
 
+#ifdef CONFIG_ENV_SAVE_IF_CHANGED
+/*
+ * CRC of the environment in storage while it is known, and of the last
+ * env_export() for a save to turn it into the stored one.
+ */
+static u32 env_stored_crc, env_exported_crc;
+static bool env_stored, env_exported;
+
+static void env_set_stored(u32 crc)
+{
+	env_stored_crc = crc;
+	env_stored = true;
+}
+#else
+static inline void env_set_stored(u32 crc) {}
+#endif
+
 /*
  * Check if CRC is valid and (if yes) import the environment.
  * Note that "buf" may or may not be aligned.
@@ -176,13 +193,12 @@ static inline int env_aes_cbc_crypt(env_t *env, const int enc)
 int env_import(const char *buf, int check)
 {
 	env_t *ep = (env_t *)buf;
+	uint32_t crc;
 	int ret;
 
-	if (check) {
-		uint32_t crc;
-
-		memcpy(&crc, &ep->crc, sizeof(crc));
+	memcpy(&crc, &ep->crc, sizeof(crc));
 
+	if (check) {
 		if (crc32(0, ep->data, ENV_SIZE) != crc) {
 			set_default_env("!bad CRC");
 			return 0;
@@ -200,6 +216,11 @@ int env_import(const char *buf, int check)
 	if (himport_r(&env_htab, (char *)ep->data, ENV_SIZE, '\0', 0, 0,
 			0, NULL)) {
 		gd->flags |= GD_FLG_ENV_READY;
+#ifndef CONFIG_SYS_REDUNDAND_ENVIRONMENT
+		/* With a redundant copy, only when both are good */
+		if (check)
+			env_set_stored(crc);
+#endif
 		return 1;
 	}
 
@@ -215,7 +236,7 @@ static unsigned char env_flags;
 
 int env_import_redund(const char *buf1, const char *buf2)
 {
-	int crc1_ok, crc2_ok;
+	int crc1_ok, crc2_ok, ret;
 	env_t *ep, *tmp_env1, *tmp_env2;
 
 	tmp_env1 = (env_t *)buf1;
@@ -253,12 +274,15 @@ int env_import_redund(const char *buf1, const char *buf2)
 		ep = tmp_env2;
 
 	env_flags = ep->flags;
-	return env_import((char *)ep, 0);
+	ret = env_import((char *)ep, 0);
+	if (ret == 1 && crc1_ok && crc2_ok)
+		env_set_stored(ep->crc);
+
+	return ret;
 }
 #endif /* CONFIG_SYS_REDUNDAND_ENVIRONMENT */
 
-/* Export the environment and generate CRC for it. */
-int env_export(env_t *env_out)
+static int env_export_data(env_t *env_out)
 {
 	char *res;
 	ssize_t	len;
@@ -278,6 +302,22 @@ int env_export(env_t *env_out)
 
 	env_out->crc = crc32(0, env_out->data, ENV_SIZE);
 
+	return 0;
+}
+
+/* Export the environment and generate CRC for it. */
+int env_export(env_t *env_out)
+{
+	int ret;
+
+	ret = env_export_data(env_out);
+	if (ret)
+		return ret;
+
+#ifdef CONFIG_ENV_SAVE_IF_CHANGED
+	env_exported_crc = env_out->crc;
+	env_exported = true;
+#endif
 #ifdef CONFIG_SYS_REDUNDAND_ENVIRONMENT
 	env_out->flags = ++env_flags; /* increase the serial */
 #endif
@@ -285,6 +325,37 @@ int env_export(env_t *env_out)
 	return 0;
 }
 
+#ifdef CONFIG_ENV_SAVE_IF_CHANGED
+bool env_unchanged(void)
+{
+	env_t *env;
+	bool ret;
+
+	env_exported = false;
+	if (!env_stored)
+		return false;
+
+	env = malloc(sizeof(*env));
+	if (!env)
+		return false;
+
+	/* Equal CRCs of two exports, of the same size, mean equal content */
+	ret = !env_export_data(env) && env->crc == env_stored_crc;
+	free(env);
+
+	return ret;
+}
+
+void env_update_stored(bool saved)
+{
+	if (saved && env_exported)
+		env_set_stored(env_exported_crc);
+	else
+		env_stored = false;
+	env_exported = false;
+}
+#endif
+
 void env_relocate(void)
 {
 #if defined(CONFIG_NEEDS_MANUAL_RELOC)
@@ -117,7 +117,16 @@ int env_save(void)
 		return -ENODEV;
 	if (!drv->save)
 		return -ENOSYS;
+#ifdef CONFIG_ENV_SAVE_IF_CHANGED
+	if (env_unchanged()) {
+		printf("Environment unchanged, not saved\n");
+		return 0;
+	}
+#endif
 	ret = drv->save();
+#ifdef CONFIG_ENV_SAVE_IF_CHANGED
+	env_update_stored(!ret);
+#endif
 	if (ret) {
 		debug("%s: Environment failed to save (err=%d)\n", __func__,
 		      ret);
@@ -95,7 +95,10 @@ static inline int write_env(struct blk_desc *blk_desc, unsigned long size,
 
 	n = blk_dwrite(blk_desc, blk_start, blk_cnt, (u_char *)buffer);
 
-	return (n == blk_cnt) ? 0 : -1;
+	if (n != blk_cnt)
+		return -1;
+
+	return blk_flush(blk_desc) ? -1 : 0;
 }
 
 static int env_blk_save(void)
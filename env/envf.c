@@ -327,6 +327,11 @@ static int envf_save(void)
 			ret = 0;
 	}
 
+	if (blk_flush(desc)) {
+		ret = -EIO;
+		ENVF_MSG("flush error\n");
+	}
+
 	return ret;
 }
 
@@ -194,7 +194,10 @@ static inline int write_env(struct mmc *mmc, unsigned long size,
 
 	n = blk_dwrite(desc, blk_start, blk_cnt, (u_char *)buffer);
 
-	return (n == blk_cnt) ? 0 : -1;
+	if (n != blk_cnt)
+		return -1;
+
+	return blk_flush(desc) ? -1 : 0;
 }
 
 static int env_mmc_save(void)
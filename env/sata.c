@@ -42,7 +42,10 @@ static inline int write_env(struct blk_desc *sata, unsigned long size,
 
 	n = blk_dwrite(sata, blk_start, blk_cnt, buffer);
 
-	return (n == blk_cnt) ? 0 : -1;
+	if (n != blk_cnt)
+		return -1;
+
+	return blk_flush(sata) ? -1 : 0;
 }
 
 static int env_sata_save(void)
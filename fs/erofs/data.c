@@ -0,0 +1,253 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd
+ *
+ * File data: flat and chunk based inodes are mapped to the device as is,
+ * compressed ones an extent at a time, see zmap.c.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <u-boot/lz4.h>
+#include "internal.h"
+
+static int erofs_map_flat(struct erofs_inode *vi, struct erofs_map_blocks *map)
+{
+	bool tailpacking = vi->datalayout == EROFS_INODE_FLAT_INLINE;
+	u64 lastblk = DIV_ROUND_UP(vi->size, erofs_blksiz()) - tailpacking;
+
+	if (map->m_la < erofs_pos(lastblk)) {
+		map->m_pa = erofs_pos(vi->raw_blkaddr) + map->m_la;
+		map->m_plen = erofs_pos(lastblk) - map->m_la;
+		map->m_flags = EROFS_MAP_MAPPED;
+	} else if (tailpacking) {
+		/* The tail is inline, right after the inode and its xattrs */
+		map->m_pa = erofs_iloc(vi) + vi->inode_isize +
+			    vi->xattr_isize + erofs_blkoff(map->m_la);
+		map->m_plen = vi->size - map->m_la;
+		map->m_flags = EROFS_MAP_MAPPED | EROFS_MAP_META;
+		if (erofs_blkoff(map->m_pa) + map->m_plen > erofs_blksiz()) {
+			EROFS_E("Inline data crosses a block in inode %llu\n",
+				vi->nid);
+			return -EFSCORRUPTED;
+		}
+	} else {
+		return -EFSCORRUPTED;
+	}
+	map->m_llen = map->m_plen;
+
+	return 0;
+}
+
+static int erofs_map_chunk(struct erofs_inode *vi,
+			   struct erofs_map_blocks *map)
+{
+	struct erofs_inode_chunk_index idx;
+	unsigned int unit, chunkbits;
+	u64 chunknr, pos;
+	u32 blkaddr;
+	int ret;
+
+	if (vi->chunkformat & EROFS_CHUNK_FORMAT_INDEXES)
+		unit = sizeof(struct erofs_inode_chunk_index);
+	else
+		unit = sizeof(__le32);	/* block map */
+
+	chunkbits = erofs_sbi.blkszbits +
+		    (vi->chunkformat & EROFS_CHUNK_FORMAT_BLKBITS_MASK);
+	chunknr = map->m_la >> chunkbits;
+	pos = ALIGN(erofs_iloc(vi) + vi->inode_isize + vi->xattr_isize, unit) +
+	      unit * chunknr;
+
+	memset(&idx, 0, sizeof(idx));
+	ret = erofs_dev_read(unit == sizeof(__le32) ? (void *)&idx.blkaddr :
+			     (void *)&idx, pos, unit);
+	if (ret)
+		return ret;
+	if (le16_to_cpu(idx.device_id)) {
+		EROFS_E("Chunk on extra device %d\n",
+			le16_to_cpu(idx.device_id));
+		return -EOPNOTSUPP;
+	}
+
+	map->m_la = chunknr << chunkbits;
+	map->m_plen = min_t(u64, 1ULL << chunkbits,
+			    ALIGN(vi->size, erofs_blksiz()) - map->m_la);
+	map->m_llen = map->m_plen;
+
+	blkaddr = le32_to_cpu(idx.blkaddr);
+	if (blkaddr == EROFS_NULL_ADDR) {
+		map->m_pa = 0;
+		map->m_flags = 0;	/* a hole */
+	} else {
+		map->m_pa = erofs_pos(blkaddr);
+		map->m_flags = EROFS_MAP_MAPPED;
+	}
+
+	return 0;
+}
+
+/* Decompress the whole of the extent in @map, from @raw to @out */
+static int z_erofs_decompress(struct erofs_map_blocks *map, char *raw,
+			      char *out)
+{
+	unsigned int inlen = map->m_plen, outlen = map->m_llen;
+	unsigned int margin = 0, skip, right;
+	int ret;
+
+	switch (map->m_algorithmformat) {
+	case Z_EROFS_COMPRESSION_SHIFTED:
+		if (outlen > inlen)
+			return -EFSCORRUPTED;
+		memcpy(out, raw, outlen);
+		return 0;
+	case Z_EROFS_COMPRESSION_INTERLACED:
+		/* A block rotated by where the extent starts in it */
+		if (outlen > inlen || inlen > erofs_blksiz())
+			return -EFSCORRUPTED;
+		skip = erofs_blkoff(map->m_la);
+		right = min(erofs_blksiz() - skip, outlen);
+		memcpy(out, raw + skip, right);
+		memcpy(out + right, raw, outlen - right);
+		return 0;
+	case Z_EROFS_COMPRESSION_LZ4:
+		break;
+	default:
+		EROFS_E("Unsupported compression %d\n",
+			map->m_algorithmformat);
+		return -EOPNOTSUPP;
+	}
+
+	/* Zero padding ahead lets the block end exactly where the input does */
+	if (erofs_sb_has(EROFS_FEATURE_INCOMPAT_ZERO_PADDING)) {
+		while (margin < inlen && !raw[margin])
+			margin++;
+		if (margin >= inlen)
+			return -EFSCORRUPTED;
+	}
+
+	if ((map->m_flags & EROFS_MAP_PARTIAL_REF) ||
+	    !erofs_sb_has(EROFS_FEATURE_INCOMPAT_ZERO_PADDING))
+		ret = LZ4_decompress_safe_partial(raw + margin, out,
+						  inlen - margin, outlen,
+						  outlen);
+	else
+		ret = LZ4_decompress_safe(raw + margin, out, inlen - margin,
+					  outlen);
+	if (ret != outlen) {
+		EROFS_E("LZ4 decompression failed at %llu: %d\n",
+			map->m_pa, ret);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static int z_erofs_pread(struct erofs_inode *vi, char *buf, u64 len,
+			 u64 offset)
+{
+	struct erofs_map_blocks map;
+	struct erofs_inode packed;
+	char *raw = NULL, *out;
+	u64 end = offset + len, skip, n;
+	int ret = 0;
+
+	while (offset < end) {
+		map.m_la = offset;
+		ret = z_erofs_map_blocks(vi, &map);
+		if (ret)
+			break;
+		if (map.m_la > offset || map.m_la + map.m_llen <= offset) {
+			ret = -EFSCORRUPTED;
+			break;
+		}
+		skip = offset - map.m_la;
+		n = min(end - offset, map.m_llen - skip);
+
+		if (!(map.m_flags & EROFS_MAP_MAPPED)) {
+			memset(buf, 0, n);
+		} else if (map.m_flags & EROFS_MAP_FRAGMENT) {
+			packed.nid = erofs_sbi.packed_nid;
+			ret = erofs_read_inode(&packed);
+			if (!ret)
+				ret = erofs_pread(&packed, buf, n,
+						  vi->z_fragmentoff + skip);
+		} else {
+			raw = malloc(map.m_plen);
+			if (!raw) {
+				ret = -ENOMEM;
+				break;
+			}
+			ret = erofs_dev_read(raw, map.m_pa, map.m_plen);
+			if (ret)
+				break;
+
+			/* Straight into @buf when all of the extent is wanted */
+			if (!skip && n == map.m_llen) {
+				ret = z_erofs_decompress(&map, raw, buf);
+			} else {
+				out = malloc(map.m_llen);
+				if (!out) {
+					ret = -ENOMEM;
+					break;
+				}
+				ret = z_erofs_decompress(&map, raw, out);
+				if (!ret)
+					memcpy(buf, out + skip, n);
+				free(out);
+			}
+			free(raw);
+			raw = NULL;
+		}
+		if (ret)
+			break;
+
+		buf += n;
+		offset += n;
+	}
+	free(raw);
+
+	return ret;
+}
+
+int erofs_pread(struct erofs_inode *vi, char *buf, u64 len, u64 offset)
+{
+	struct erofs_map_blocks map;
+	u64 skip, n;
+	int ret;
+
+	if (offset > vi->size || len > vi->size - offset)
+		return -EINVAL;
+
+	if (erofs_inode_is_compressed(vi))
+		return z_erofs_pread(vi, buf, len, offset);
+
+	while (len) {
+		map.m_la = offset;
+		if (vi->datalayout == EROFS_INODE_CHUNK_BASED)
+			ret = erofs_map_chunk(vi, &map);
+		else
+			ret = erofs_map_flat(vi, &map);
+		if (ret)
+			return ret;
+
+		skip = offset - map.m_la;
+		if (skip >= map.m_llen)
+			return -EFSCORRUPTED;
+		n = min(len, map.m_llen - skip);
+
+		if (map.m_flags & EROFS_MAP_MAPPED) {
+			ret = erofs_dev_read(buf, map.m_pa + skip, n);
+			if (ret)
+				return ret;
+		} else {
+			memset(buf, 0, n);
+		}
+
+		buf += n;
+		offset += n;
+		len -= n;
+	}
+
+	return 0;
+}
@@ -0,0 +1,195 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * EROFS on-disk format, as include/uapi erofs_fs.h in Linux
+ *
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd
+ */
+
+#ifndef __EROFS_FS_H
+#define __EROFS_FS_H
+
+#define EROFS_SUPER_OFFSET		1024
+#define EROFS_SUPER_MAGIC_V1		0xE0F5E1E2
+
+#define EROFS_FEATURE_INCOMPAT_ZERO_PADDING	0x00000001
+#define EROFS_FEATURE_INCOMPAT_COMPR_CFGS	0x00000002
+#define EROFS_FEATURE_INCOMPAT_BIG_PCLUSTER	0x00000002
+#define EROFS_FEATURE_INCOMPAT_CHUNKED_FILE	0x00000004
+#define EROFS_FEATURE_INCOMPAT_DEVICE_TABLE	0x00000008
+#define EROFS_FEATURE_INCOMPAT_COMPR_HEAD2	0x00000008
+#define EROFS_FEATURE_INCOMPAT_ZTAILPACKING	0x00000010
+#define EROFS_FEATURE_INCOMPAT_FRAGMENTS	0x00000020
+#define EROFS_FEATURE_INCOMPAT_DEDUPE		0x00000020
+#define EROFS_FEATURE_INCOMPAT_XATTR_PREFIXES	0x00000040
+#define EROFS_ALL_FEATURE_INCOMPAT		0x0000007f
+
+struct erofs_super_block {
+	__le32 magic;
+	__le32 checksum;		/* crc32c of the rest of the block */
+	__le32 feature_compat;
+	__u8 blkszbits;
+	__u8 sb_extslots;
+	__le16 root_nid;
+	__le64 inos;
+	__le64 build_time;
+	__le32 build_time_nsec;
+	__le32 blocks;
+	__le32 meta_blkaddr;		/* first block of the inodes */
+	__le32 xattr_blkaddr;
+	__u8 uuid[16];
+	__u8 volume_name[16];
+	__le32 feature_incompat;
+	__le16 available_compr_algs;	/* with COMPR_CFGS, else lz4 distance */
+	__le16 extra_devices;
+	__le16 devt_slotoff;
+	__u8 dirblkbits;
+	__u8 xattr_prefix_count;
+	__le32 xattr_prefix_start;
+	__le64 packed_nid;		/* inode of the fragments */
+	__u8 reserved2[24];
+} __packed;
+
+/* i_format: bit 0 the version, bits 1-3 the data layout */
+#define EROFS_I_VERSION_BIT		0
+#define EROFS_I_DATALAYOUT_BIT		1
+#define EROFS_I_DATALAYOUT_BITS		3
+
+#define EROFS_INODE_LAYOUT_COMPACT	0
+#define EROFS_INODE_LAYOUT_EXTENDED	1
+
+#define EROFS_INODE_FLAT_PLAIN		0
+#define EROFS_INODE_COMPRESSED_FULL	1
+#define EROFS_INODE_FLAT_INLINE		2
+#define EROFS_INODE_COMPRESSED_COMPACT	3
+#define EROFS_INODE_CHUNK_BASED		4
+
+/* i_u.c.format of chunk based inodes */
+#define EROFS_CHUNK_FORMAT_BLKBITS_MASK	0x001f
+#define EROFS_CHUNK_FORMAT_INDEXES	0x0020
+
+#define EROFS_NULL_ADDR			(-1U)
+
+struct erofs_inode_chunk_info {
+	__le16 format;
+	__le16 reserved;
+};
+
+union erofs_inode_i_u {
+	__le32 compressed_blocks;
+	__le32 raw_blkaddr;
+	__le32 rdev;
+	struct erofs_inode_chunk_info c;
+};
+
+struct erofs_inode_compact {
+	__le16 i_format;
+	__le16 i_xattr_icount;
+	__le16 i_mode;
+	__le16 i_nlink;
+	__le32 i_size;
+	__le32 i_reserved;
+	union erofs_inode_i_u i_u;
+	__le32 i_ino;
+	__le16 i_uid;
+	__le16 i_gid;
+	__le32 i_reserved2;
+} __packed;
+
+struct erofs_inode_extended {
+	__le16 i_format;
+	__le16 i_xattr_icount;
+	__le16 i_mode;
+	__le16 i_reserved;
+	__le64 i_size;
+	union erofs_inode_i_u i_u;
+	__le32 i_ino;
+	__le32 i_uid;
+	__le32 i_gid;
+	__le64 i_mtime;
+	__le32 i_mtime_nsec;
+	__le32 i_nlink;
+	__u8 i_reserved2[16];
+} __packed;
+
+/* Inodes are addressed in slots of 32 bytes from meta_blkaddr */
+#define EROFS_ISLOTBITS			5
+
+struct erofs_xattr_ibody_header {
+	__le32 h_name_filter;
+	__u8 h_shared_count;
+	__u8 h_reserved2[7];
+	__le32 h_shared_xattrs[0];
+} __packed;
+
+struct erofs_inode_chunk_index {
+	__le16 advise;
+	__le16 device_id;
+	__le32 blkaddr;
+} __packed;
+
+/* Directory blocks, the names after all dirents of the block */
+#define EROFS_FT_UNKNOWN		0
+#define EROFS_FT_REG_FILE		1
+#define EROFS_FT_DIR			2
+#define EROFS_FT_SYMLINK		7
+
+struct erofs_dirent {
+	__le64 nid;
+	__le16 nameoff;
+	__u8 file_type;
+	__u8 reserved;
+} __packed;
+
+#define EROFS_NAME_LEN			255
+
+/* Compressed inodes, the map header after the inode and its xattrs */
+#define Z_EROFS_COMPRESSION_LZ4		0
+#define Z_EROFS_COMPRESSION_SHIFTED	0xff
+#define Z_EROFS_COMPRESSION_INTERLACED	0xfe
+
+#define Z_EROFS_ADVISE_COMPACTED_2B		0x0001
+#define Z_EROFS_ADVISE_BIG_PCLUSTER_1		0x0002
+#define Z_EROFS_ADVISE_BIG_PCLUSTER_2		0x0004
+#define Z_EROFS_ADVISE_INLINE_PCLUSTER		0x0008
+#define Z_EROFS_ADVISE_INTERLACED_PCLUSTER	0x0010
+#define Z_EROFS_ADVISE_FRAGMENT_PCLUSTER	0x0020
+
+/* Set in h_clusterbits when the whole file is a fragment */
+#define Z_EROFS_FRAGMENT_INODE_BIT		7
+
+struct z_erofs_map_header {
+	union {
+		__le32 h_fragmentoff;
+		struct {
+			__le16 h_reserved1;
+			__le16 h_idata_size;	/* of the inline pcluster */
+		};
+	};
+	__le16 h_advise;
+	__u8 h_algorithmtype;	/* bits 0-3 for HEAD1, 4-7 for HEAD2 */
+	__u8 h_clusterbits;	/* bits 0-2 over the block size bits */
+} __packed;
+
+#define Z_EROFS_LCLUSTER_TYPE_PLAIN	0
+#define Z_EROFS_LCLUSTER_TYPE_HEAD1	1
+#define Z_EROFS_LCLUSTER_TYPE_NONHEAD	2
+#define Z_EROFS_LCLUSTER_TYPE_HEAD2	3
+#define Z_EROFS_LI_LCLUSTER_TYPE_MASK	3
+#define Z_EROFS_LI_PARTIAL_REF		(1 << 15)
+/* In delta[0] of the first NONHEAD, the blocks of a big pcluster */
+#define Z_EROFS_LI_D0_CBLKCNT		(1 << 11)
+
+struct z_erofs_lcluster_index {
+	__le16 di_advise;
+	__le16 di_clusterofs;	/* where the extent starts in the lcluster */
+	union {
+		__le32 blkaddr;		/* HEAD and PLAIN */
+		__le16 delta[2];	/* NONHEAD, to the heads around */
+	} di_u;
+} __packed;
+
+/* Full indexes start after the map header and 8 reserved bytes */
+#define Z_EROFS_FULL_INDEX_ALIGN(end)	\
+	(ALIGN(end, 8) + sizeof(struct z_erofs_map_header) + 8)
+
+#endif /* __EROFS_FS_H */
@@ -0,0 +1,252 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd
+ *
+ * EROFS, read-only and mostly for compressed system images, behind the
+ * generic fs commands.
+ */
+
+#include <common.h>
+#include <erofs.h>
+#include <fs.h>
+#include <fs_internal.h>
+#include <malloc.h>
+#include <uuid.h>
+#include <linux/sizes.h>
+#include <linux/stat.h>
+#include "internal.h"
+
+struct erofs_sb_info erofs_sbi;
+
+struct erofs_dir_stream {
+	struct fs_dir_stream fs_dirs;
+	struct fs_dirent dirent;
+
+	struct erofs_inode inode;
+	u64 pos;		/* of the next block */
+	char *block;
+	unsigned int blkpos;	/* next dirent in block */
+	unsigned int size;
+	unsigned int count;
+};
+
+int erofs_dev_read(void *buf, u64 offset, u64 len)
+{
+	struct blk_desc *desc = erofs_sbi.desc;
+	int n;
+
+	while (len) {
+		n = min_t(u64, len, SZ_1G);
+		if (!fs_devread(desc, &erofs_sbi.part, offset >> desc->log2blksz,
+				offset & (desc->blksz - 1), n, buf))
+			return -EIO;
+		buf += n;
+		offset += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+int erofs_probe(struct blk_desc *fs_dev_desc, disk_partition_t *fs_partition)
+{
+	struct erofs_super_block sb;
+	u32 incompat;
+
+	erofs_sbi.desc = fs_dev_desc;
+	erofs_sbi.part = *fs_partition;
+	if (erofs_dev_read(&sb, EROFS_SUPER_OFFSET, sizeof(sb)))
+		goto err;
+
+	/* Quiet, the fs layer probes every type in turn */
+	if (le32_to_cpu(sb.magic) != EROFS_SUPER_MAGIC_V1)
+		goto err;
+
+	if (sb.blkszbits < 9 || sb.blkszbits > 16) {
+		EROFS_E("Unsupported block size 2^%d\n", sb.blkszbits);
+		goto err;
+	}
+	incompat = le32_to_cpu(sb.feature_incompat);
+	if (incompat & ~EROFS_ALL_FEATURE_INCOMPAT) {
+		EROFS_E("Unsupported features %x\n",
+			incompat & ~EROFS_ALL_FEATURE_INCOMPAT);
+		goto err;
+	}
+	if (le16_to_cpu(sb.extra_devices)) {
+		EROFS_E("Multiple devices are not supported\n");
+		goto err;
+	}
+
+	erofs_sbi.blkszbits = sb.blkszbits;
+	erofs_sbi.blocks = le32_to_cpu(sb.blocks);
+	erofs_sbi.meta_blkaddr = le32_to_cpu(sb.meta_blkaddr);
+	erofs_sbi.feature_incompat = incompat;
+	/* Without compression configs, the field is the LZ4 distance */
+	if (incompat & EROFS_FEATURE_INCOMPAT_COMPR_CFGS)
+		erofs_sbi.available_compr_algs =
+			le16_to_cpu(sb.available_compr_algs);
+	else
+		erofs_sbi.available_compr_algs = 1 << Z_EROFS_COMPRESSION_LZ4;
+	erofs_sbi.root_nid = le16_to_cpu(sb.root_nid);
+	erofs_sbi.packed_nid = le64_to_cpu(sb.packed_nid);
+	memcpy(erofs_sbi.uuid, sb.uuid, sizeof(erofs_sbi.uuid));
+
+	return 0;
+err:
+	erofs_sbi.desc = NULL;
+
+	return -1;
+}
+
+void erofs_close(void)
+{
+	erofs_sbi.desc = NULL;
+}
+
+int erofs_exists(const char *filename)
+{
+	struct erofs_inode vi;
+
+	return !erofs_lookup(filename, &vi);
+}
+
+int erofs_size(const char *filename, loff_t *size)
+{
+	struct erofs_inode vi;
+	int ret;
+
+	ret = erofs_lookup(filename, &vi);
+	if (ret)
+		return ret;
+	*size = vi.size;
+
+	return 0;
+}
+
+int erofs_read(const char *filename, void *buf, loff_t offset, loff_t len,
+	       loff_t *actread)
+{
+	struct erofs_inode vi;
+	int ret;
+
+	*actread = 0;
+	ret = erofs_lookup(filename, &vi);
+	if (ret) {
+		printf("** File not found %s **\n", filename);
+		return ret;
+	}
+	if (!S_ISREG(vi.mode)) {
+		printf("** %s is not a regular file **\n", filename);
+		return -EISDIR;
+	}
+
+	if (offset > vi.size)
+		return -EINVAL;
+	if (!len || len > vi.size - offset)
+		len = vi.size - offset;
+
+	ret = erofs_pread(&vi, buf, len, offset);
+	if (ret)
+		return ret;
+	*actread = len;
+
+	return 0;
+}
+
+int erofs_uuid(char *uuid_str)
+{
+#ifdef CONFIG_LIB_UUID
+	if (!erofs_sbi.desc)
+		return -ENODEV;
+
+	uuid_bin_to_str(erofs_sbi.uuid, uuid_str, UUID_STR_FORMAT_STD);
+
+	return 0;
+#else
+	return -ENOSYS;
+#endif
+}
+
+int erofs_opendir(const char *filename, struct fs_dir_stream **dirsp)
+{
+	struct erofs_dir_stream *dirs;
+	int ret;
+
+	dirs = calloc(1, sizeof(*dirs));
+	if (!dirs)
+		return -ENOMEM;
+	dirs->block = malloc(erofs_blksiz());
+	if (!dirs->block) {
+		free(dirs);
+		return -ENOMEM;
+	}
+
+	ret = erofs_lookup(filename, &dirs->inode);
+	if (!ret && !S_ISDIR(dirs->inode.mode))
+		ret = -ENOTDIR;
+	if (ret) {
+		erofs_closedir(&dirs->fs_dirs);
+		return ret;
+	}
+	*dirsp = &dirs->fs_dirs;
+
+	return 0;
+}
+
+int erofs_readdir(struct fs_dir_stream *fs_dirs, struct fs_dirent **dentp)
+{
+	struct erofs_dir_stream *dirs = (struct erofs_dir_stream *)fs_dirs;
+	struct fs_dirent *dent = &dirs->dirent;
+	const struct erofs_dirent *de;
+	struct erofs_inode vi;
+	const char *name;
+	unsigned int len;
+	int ret;
+
+	if (dirs->blkpos >= dirs->count) {
+		if (dirs->pos >= dirs->inode.size)
+			return -ENOENT;
+		ret = erofs_read_dir_block(&dirs->inode, dirs->pos,
+					   dirs->block, &dirs->size,
+					   &dirs->count);
+		if (ret)
+			return ret;
+		dirs->pos += erofs_blksiz();
+		dirs->blkpos = 0;
+	}
+
+	de = (const struct erofs_dirent *)dirs->block + dirs->blkpos;
+	name = erofs_dirent_name(dirs->block, dirs->size, dirs->count,
+				 dirs->blkpos, &len);
+	if (!name)
+		return -EFSCORRUPTED;
+	dirs->blkpos++;
+
+	memset(dent, 0, sizeof(*dent));
+	memcpy(dent->name, name, len);
+	switch (de->file_type) {
+	case EROFS_FT_DIR:
+		dent->type = FS_DT_DIR;
+		break;
+	case EROFS_FT_SYMLINK:
+		dent->type = FS_DT_LNK;
+		break;
+	default:
+		dent->type = FS_DT_REG;
+		vi.nid = le64_to_cpu(de->nid);
+		if (!erofs_read_inode(&vi))
+			dent->size = vi.size;
+		break;
+	}
+	*dentp = dent;
+
+	return 0;
+}
+
+void erofs_closedir(struct fs_dir_stream *fs_dirs)
+{
+	struct erofs_dir_stream *dirs = (struct erofs_dir_stream *)fs_dirs;
+
+	free(dirs->block);
+	free(dirs);
+}
@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd
+ */
+
+#ifndef __EROFS_INTERNAL_H
+#define __EROFS_INTERNAL_H
+
+#include <common.h>
+#include <part.h>
+#include "erofs_fs.h"
+
+#define EROFS_E(fmt, args...)	printf("EROFS Error: "fmt, ##args)
+
+#define EFSCORRUPTED		EUCLEAN
+
+struct erofs_sb_info {
+	struct blk_desc *desc;
+	disk_partition_t part;
+	u8 blkszbits;
+	u32 blocks;
+	u32 meta_blkaddr;
+	u32 feature_incompat;
+	u16 available_compr_algs;
+	u64 root_nid;
+	u64 packed_nid;
+	u8 uuid[16];
+};
+
+/* The mounted filesystem, NULL desc if none */
+extern struct erofs_sb_info erofs_sbi;
+
+#define erofs_blksiz()		(1U << erofs_sbi.blkszbits)
+#define erofs_blknr(addr)	((addr) >> erofs_sbi.blkszbits)
+#define erofs_blkoff(addr)	((addr) & (erofs_blksiz() - 1))
+#define erofs_pos(blk)		((u64)(blk) << erofs_sbi.blkszbits)
+
+static inline bool erofs_sb_has(u32 feature)
+{
+	return erofs_sbi.feature_incompat & feature;
+}
+
+struct erofs_inode {
+	u64 nid;
+	u64 size;
+	u16 mode;
+	u8 datalayout;
+	u8 inode_isize;
+	u16 xattr_isize;
+	union {
+		u32 raw_blkaddr;	/* flat */
+		u16 chunkformat;	/* chunk based */
+	};
+
+	/* Compressed inodes, once z_erofs_fill_inode() has run */
+	bool z_inited;
+	u16 z_advise;
+	u8 z_algorithmtype[2];
+	u8 z_lclusterbits;
+	u16 z_idata_size;
+	u64 z_idataoff;
+	u64 z_tailextent_headlcn;
+	u64 z_fragmentoff;
+};
+
+static inline u64 erofs_iloc(struct erofs_inode *vi)
+{
+	return erofs_pos(erofs_sbi.meta_blkaddr) +
+	       (vi->nid << EROFS_ISLOTBITS);
+}
+
+static inline bool erofs_inode_is_compressed(struct erofs_inode *vi)
+{
+	return vi->datalayout == EROFS_INODE_COMPRESSED_FULL ||
+	       vi->datalayout == EROFS_INODE_COMPRESSED_COMPACT;
+}
+
+#define EROFS_MAP_MAPPED	0x0001	/* else a hole */
+#define EROFS_MAP_META		0x0002	/* inline, in the metadata */
+#define EROFS_MAP_FULL_MAPPED	0x0004	/* m_llen is the whole extent */
+#define EROFS_MAP_FRAGMENT	0x0008	/* in the packed inode */
+#define EROFS_MAP_PARTIAL_REF	0x0010	/* a part of the pcluster output */
+
+struct erofs_map_blocks {
+	u64 m_la;		/* logical start, in and out */
+	u64 m_llen;
+	u64 m_pa;
+	u64 m_plen;
+	u32 m_flags;
+	u8 m_algorithmformat;
+};
+
+/* fs.c */
+int erofs_dev_read(void *buf, u64 offset, u64 len);
+
+/* namei.c */
+int erofs_read_inode(struct erofs_inode *vi);
+int erofs_read_dir_block(struct erofs_inode *dir, u64 pos, char *block,
+			 unsigned int *size, unsigned int *count);
+const char *erofs_dirent_name(const char *block, unsigned int size,
+			      unsigned int count, unsigned int i,
+			      unsigned int *len);
+int erofs_lookup(const char *path, struct erofs_inode *vi);
+
+/* data.c */
+int erofs_pread(struct erofs_inode *vi, char *buf, u64 len, u64 offset);
+
+/* zmap.c */
+int z_erofs_map_blocks(struct erofs_inode *vi, struct erofs_map_blocks *map);
+
+#endif /* __EROFS_INTERNAL_H */
@@ -0,0 +1,242 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd
+ *
+ * Inodes, directories and path lookup.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <linux/stat.h>
+#include "internal.h"
+
+#define EROFS_MAX_SYMLINKS	8
+
+int erofs_read_inode(struct erofs_inode *vi)
+{
+	union {
+		struct erofs_inode_compact c;
+		struct erofs_inode_extended e;
+	} di;
+	u16 ifmt, icount;
+	int ret;
+
+	ret = erofs_dev_read(&di.c, erofs_iloc(vi), sizeof(di.c));
+	if (ret)
+		return ret;
+
+	ifmt = le16_to_cpu(di.c.i_format);
+	vi->datalayout = (ifmt >> EROFS_I_DATALAYOUT_BIT) &
+			 ((1 << EROFS_I_DATALAYOUT_BITS) - 1);
+	if (vi->datalayout > EROFS_INODE_CHUNK_BASED) {
+		EROFS_E("Unsupported layout %d of inode %llu\n",
+			vi->datalayout, vi->nid);
+		return -EOPNOTSUPP;
+	}
+
+	switch ((ifmt >> EROFS_I_VERSION_BIT) & 1) {
+	case EROFS_INODE_LAYOUT_EXTENDED:
+		ret = erofs_dev_read(&di.e, erofs_iloc(vi), sizeof(di.e));
+		if (ret)
+			return ret;
+		vi->inode_isize = sizeof(di.e);
+		vi->size = le64_to_cpu(di.e.i_size);
+		break;
+	default:
+		vi->inode_isize = sizeof(di.c);
+		vi->size = le32_to_cpu(di.c.i_size);
+		break;
+	}
+
+	/* The union of both versions is at the same place */
+	vi->mode = le16_to_cpu(di.c.i_mode);
+	icount = le16_to_cpu(di.c.i_xattr_icount);
+	vi->xattr_isize = icount ? sizeof(struct erofs_xattr_ibody_header) +
+				   sizeof(__le32) * (icount - 1) : 0;
+
+	if (vi->datalayout == EROFS_INODE_CHUNK_BASED) {
+		vi->chunkformat = le16_to_cpu(di.c.i_u.c.format);
+		if (vi->chunkformat & ~(EROFS_CHUNK_FORMAT_INDEXES |
+					EROFS_CHUNK_FORMAT_BLKBITS_MASK)) {
+			EROFS_E("Unsupported chunk format %x of inode %llu\n",
+				vi->chunkformat, vi->nid);
+			return -EOPNOTSUPP;
+		}
+	} else {
+		vi->raw_blkaddr = le32_to_cpu(di.c.i_u.raw_blkaddr);
+	}
+	vi->z_inited = false;
+
+	return 0;
+}
+
+/*
+ * Read the block of @dir at @pos, and check that its dirents and names
+ * are where they claim to be.
+ */
+int erofs_read_dir_block(struct erofs_inode *dir, u64 pos, char *block,
+			 unsigned int *size, unsigned int *count)
+{
+	struct erofs_dirent *de = (struct erofs_dirent *)block;
+	unsigned int nameoff;
+	int ret;
+
+	*size = min_t(u64, erofs_blksiz(), dir->size - pos);
+	ret = erofs_pread(dir, block, *size, pos);
+	if (ret)
+		return ret;
+
+	nameoff = le16_to_cpu(de->nameoff);
+	if (nameoff < sizeof(*de) || nameoff >= *size ||
+	    nameoff % sizeof(*de)) {
+		EROFS_E("Bad directory block at %llu of inode %llu\n",
+			pos, dir->nid);
+		return -EFSCORRUPTED;
+	}
+	*count = nameoff / sizeof(*de);
+
+	return 0;
+}
+
+/* Name of dirent @i of a block, not NUL terminated */
+const char *erofs_dirent_name(const char *block, unsigned int size,
+			      unsigned int count, unsigned int i,
+			      unsigned int *len)
+{
+	const struct erofs_dirent *de = (const struct erofs_dirent *)block;
+	unsigned int nameoff = le16_to_cpu(de[i].nameoff);
+	unsigned int end;
+
+	if (i + 1 < count)
+		end = le16_to_cpu(de[i + 1].nameoff);
+	else
+		end = size;
+	if (nameoff >= end || end > size)
+		return NULL;
+
+	/* The last name may be followed by padding */
+	*len = strnlen(block + nameoff, min(end - nameoff,
+					    (unsigned int)EROFS_NAME_LEN));
+
+	return block + nameoff;
+}
+
+/* Look @name up in @dir, each block sorted by name */
+static int erofs_namei(struct erofs_inode *dir, const char *name,
+		       unsigned int len, struct erofs_inode *vi)
+{
+	const struct erofs_dirent *de;
+	unsigned int size, count, dlen;
+	int lo, hi, mid, cmp, ret;
+	const char *dname;
+	char *block;
+	u64 pos;
+
+	block = malloc(erofs_blksiz());
+	if (!block)
+		return -ENOMEM;
+
+	ret = -ENOENT;
+	for (pos = 0; pos < dir->size; pos += erofs_blksiz()) {
+		ret = erofs_read_dir_block(dir, pos, block, &size, &count);
+		if (ret)
+			break;
+
+		de = (const struct erofs_dirent *)block;
+		lo = 0;
+		hi = count - 1;
+		while (lo <= hi) {
+			mid = (lo + hi) / 2;
+			dname = erofs_dirent_name(block, size, count, mid,
+						  &dlen);
+			if (!dname) {
+				ret = -EFSCORRUPTED;
+				goto out;
+			}
+
+			cmp = memcmp(name, dname, min(len, dlen));
+			if (!cmp)
+				cmp = len - dlen;
+			if (!cmp) {
+				vi->nid = le64_to_cpu(de[mid].nid);
+				ret = erofs_read_inode(vi);
+				goto out;
+			}
+			if (cmp < 0)
+				hi = mid - 1;
+			else
+				lo = mid + 1;
+		}
+		ret = -ENOENT;
+	}
+out:
+	free(block);
+
+	return ret;
+}
+
+static int erofs_lookup_at(struct erofs_inode *dir, const char *path,
+			   struct erofs_inode *vi, int depth)
+{
+	struct erofs_inode cur = *dir, next;
+	unsigned int len;
+	char *target;
+	int ret;
+
+	if (*path == '/') {
+		cur.nid = erofs_sbi.root_nid;
+		ret = erofs_read_inode(&cur);
+		if (ret)
+			return ret;
+	}
+
+	while (*path) {
+		while (*path == '/')
+			path++;
+		len = strchrnul(path, '/') - path;
+		if (!len)
+			break;
+
+		if (!S_ISDIR(cur.mode))
+			return -ENOTDIR;
+		ret = erofs_namei(&cur, path, len, &next);
+		if (ret)
+			return ret;
+		path += len;
+
+		/* Relative to the directory holding the link */
+		if (S_ISLNK(next.mode)) {
+			if (depth >= EROFS_MAX_SYMLINKS ||
+			    next.size > EROFS_NAME_LEN * 16)
+				return -ELOOP;
+
+			target = malloc(next.size + 1);
+			if (!target)
+				return -ENOMEM;
+			ret = erofs_pread(&next, target, next.size, 0);
+			target[next.size] = '\0';
+			if (!ret)
+				ret = erofs_lookup_at(&cur, target, &next,
+						      depth + 1);
+			free(target);
+			if (ret)
+				return ret;
+		}
+		cur = next;
+	}
+	*vi = cur;
+
+	return 0;
+}
+
+int erofs_lookup(const char *path, struct erofs_inode *vi)
+{
+	struct erofs_inode root = { .nid = erofs_sbi.root_nid };
+	int ret;
+
+	ret = erofs_read_inode(&root);
+	if (ret)
+		return ret;
+
+	return erofs_lookup_at(&root, path, vi, 0);
+}
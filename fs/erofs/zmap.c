@@ -0,0 +1,591 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd
+ *
+ * Maps the logical extents of compressed inodes to their physical
+ * clusters, from the full or compacted lcluster indexes after the inode.
+ * Follows fs/erofs/zmap.c of Linux, which documents the format.
+ */
+
+#include <common.h>
+#include <asm/unaligned.h>
+#include <linux/log2.h>
+#include "internal.h"
+
+#define Z_EROFS_COMPRESSION_MAX		4
+
+struct z_erofs_maprecorder {
+	struct erofs_inode *vi;
+	struct erofs_map_blocks *map;
+	u8 pack[32];		/* the compacted pack of lcn */
+
+	u64 lcn;
+	u8 type, headtype;
+	unsigned int clusterofs;
+	u16 delta[2];
+	u32 pblk, compressedblks;
+	u64 nextpackoff;
+	bool partialref;
+};
+
+static u64 z_erofs_ibase(struct erofs_inode *vi)
+{
+	return erofs_iloc(vi) + vi->inode_isize + vi->xattr_isize;
+}
+
+static int z_erofs_load_full_lcluster(struct z_erofs_maprecorder *m, u64 lcn)
+{
+	struct erofs_inode *vi = m->vi;
+	const u64 pos = Z_EROFS_FULL_INDEX_ALIGN(z_erofs_ibase(vi)) +
+			lcn * sizeof(struct z_erofs_lcluster_index);
+	struct z_erofs_lcluster_index di;
+	unsigned int advise;
+	int ret;
+
+	ret = erofs_dev_read(&di, pos, sizeof(di));
+	if (ret)
+		return ret;
+	m->nextpackoff = pos + sizeof(di);
+	m->lcn = lcn;
+
+	advise = le16_to_cpu(di.di_advise);
+	m->type = advise & Z_EROFS_LI_LCLUSTER_TYPE_MASK;
+	if (m->type == Z_EROFS_LCLUSTER_TYPE_NONHEAD) {
+		m->clusterofs = 1 << vi->z_lclusterbits;
+		m->delta[0] = le16_to_cpu(di.di_u.delta[0]);
+		if (m->delta[0] & Z_EROFS_LI_D0_CBLKCNT) {
+			if (!(vi->z_advise & (Z_EROFS_ADVISE_BIG_PCLUSTER_1 |
+					      Z_EROFS_ADVISE_BIG_PCLUSTER_2)))
+				return -EFSCORRUPTED;
+			m->compressedblks = m->delta[0] &
+					    ~Z_EROFS_LI_D0_CBLKCNT;
+			m->delta[0] = 1;
+		}
+		m->delta[1] = le16_to_cpu(di.di_u.delta[1]);
+	} else {
+		m->partialref = !!(advise & Z_EROFS_LI_PARTIAL_REF);
+		m->clusterofs = le16_to_cpu(di.di_clusterofs);
+		if (m->clusterofs >= 1 << vi->z_lclusterbits)
+			return -EFSCORRUPTED;
+		m->pblk = le32_to_cpu(di.di_u.blkaddr);
+	}
+
+	return 0;
+}
+
+static unsigned int decode_compactedbits(unsigned int lobits, const u8 *in,
+					 unsigned int pos, u8 *type)
+{
+	const unsigned int v = get_unaligned_le32(in + pos / 8) >> (pos & 7);
+
+	*type = (v >> lobits) & 3;
+
+	return v & ((1 << lobits) - 1);
+}
+
+static int get_compacted_la_distance(unsigned int lobits,
+				     unsigned int encodebits,
+				     unsigned int vcnt, const u8 *in, int i)
+{
+	unsigned int lo, d1 = 0;
+	u8 type;
+
+	do {
+		lo = decode_compactedbits(lobits, in, encodebits * i, &type);
+		if (type != Z_EROFS_LCLUSTER_TYPE_NONHEAD)
+			return d1;
+		++d1;
+	} while (++i < vcnt);
+
+	/* The last NONHEAD of a pack holds delta[1] */
+	if (!(lo & Z_EROFS_LI_D0_CBLKCNT))
+		d1 += lo - 1;
+
+	return d1;
+}
+
+static int unpack_compacted_index(struct z_erofs_maprecorder *m,
+				  unsigned int amortizedshift, u64 pos,
+				  bool lookahead)
+{
+	struct erofs_inode *vi = m->vi;
+	const unsigned int lclusterbits = vi->z_lclusterbits;
+	unsigned int vcnt, lo, lobits, encodebits, nblk, packsz;
+	bool big_pcluster;
+	const u8 *in;
+	u64 base;
+	int i, ret;
+	u8 type;
+
+	if (amortizedshift == 2 && lclusterbits <= 14)
+		vcnt = 2;
+	else if (amortizedshift == 1 && lclusterbits <= 12)
+		vcnt = 16;
+	else
+		return -EOPNOTSUPP;
+
+	packsz = vcnt << amortizedshift;
+	base = round_down(pos, packsz);
+	ret = erofs_dev_read(m->pack, base, packsz);
+	if (ret)
+		return ret;
+	m->nextpackoff = base + packsz;
+
+	big_pcluster = vi->z_advise & Z_EROFS_ADVISE_BIG_PCLUSTER_1;
+	lobits = max(lclusterbits, ilog2(Z_EROFS_LI_D0_CBLKCNT) + 1U);
+	encodebits = (packsz - sizeof(__le32)) * 8 / vcnt;
+	in = m->pack;
+	i = (pos - base) >> amortizedshift;
+
+	lo = decode_compactedbits(lobits, in, encodebits * i, &type);
+	m->type = type;
+	if (type == Z_EROFS_LCLUSTER_TYPE_NONHEAD) {
+		m->clusterofs = 1 << lclusterbits;
+
+		if (lookahead)
+			m->delta[1] = get_compacted_la_distance(lobits,
+								encodebits,
+								vcnt, in, i);
+		if (lo & Z_EROFS_LI_D0_CBLKCNT) {
+			if (!big_pcluster)
+				return -EFSCORRUPTED;
+			m->compressedblks = lo & ~Z_EROFS_LI_D0_CBLKCNT;
+			m->delta[0] = 1;
+			return 0;
+		} else if (i + 1 != (int)vcnt) {
+			m->delta[0] = lo;
+			return 0;
+		}
+
+		/*
+		 * The last lcluster of a pack keeps delta[1] instead, so work
+		 * delta[0] out from the one before it.
+		 */
+		lo = decode_compactedbits(lobits, in, encodebits * (i - 1),
+					  &type);
+		if (type != Z_EROFS_LCLUSTER_TYPE_NONHEAD)
+			lo = 0;
+		else if (lo & Z_EROFS_LI_D0_CBLKCNT)
+			lo = 1;
+		m->delta[0] = lo + 1;
+		return 0;
+	}
+	m->clusterofs = lo;
+	m->delta[0] = 0;
+
+	/* The pack keeps the first blkaddr, count the pclusters before i */
+	if (!big_pcluster) {
+		nblk = 1;
+		while (i > 0) {
+			--i;
+			lo = decode_compactedbits(lobits, in, encodebits * i,
+						  &type);
+			if (type == Z_EROFS_LCLUSTER_TYPE_NONHEAD)
+				i -= lo;
+			if (i >= 0)
+				++nblk;
+		}
+	} else {
+		nblk = 0;
+		while (i > 0) {
+			--i;
+			lo = decode_compactedbits(lobits, in, encodebits * i,
+						  &type);
+			if (type == Z_EROFS_LCLUSTER_TYPE_NONHEAD) {
+				if (lo & Z_EROFS_LI_D0_CBLKCNT) {
+					--i;
+					nblk += lo & ~Z_EROFS_LI_D0_CBLKCNT;
+					continue;
+				}
+				/* A big pcluster has no plain d0 of 1 */
+				if (lo <= 1)
+					return -EFSCORRUPTED;
+				i -= lo - 2;
+				continue;
+			}
+			++nblk;
+		}
+	}
+	m->pblk = get_unaligned_le32(in + packsz - sizeof(__le32)) + nblk;
+
+	return 0;
+}
+
+static int z_erofs_load_compact_lcluster(struct z_erofs_maprecorder *m,
+					 u64 lcn, bool lookahead)
+{
+	struct erofs_inode *vi = m->vi;
+	const u64 ebase = sizeof(struct z_erofs_map_header) +
+			  ALIGN(z_erofs_ibase(vi), 8);
+	const u64 totalidx = DIV_ROUND_UP(vi->size, 1ULL << vi->z_lclusterbits);
+	unsigned int compacted_4b_initial, amortizedshift;
+	u64 compacted_2b, pos;
+
+	if (lcn >= totalidx)
+		return -EINVAL;
+	m->lcn = lcn;
+
+	/* 4B indexes up to a 32B boundary, then 2B ones, then 4B again */
+	compacted_4b_initial = (32 - ebase % 32) / 4;
+	if (compacted_4b_initial == 32 / 4)
+		compacted_4b_initial = 0;
+
+	if ((vi->z_advise & Z_EROFS_ADVISE_COMPACTED_2B) &&
+	    compacted_4b_initial < totalidx)
+		compacted_2b = rounddown(totalidx - compacted_4b_initial, 16);
+	else
+		compacted_2b = 0;
+
+	pos = ebase;
+	if (lcn < compacted_4b_initial) {
+		amortizedshift = 2;
+		goto out;
+	}
+	pos += compacted_4b_initial * 4;
+	lcn -= compacted_4b_initial;
+
+	if (lcn < compacted_2b) {
+		amortizedshift = 1;
+		goto out;
+	}
+	pos += compacted_2b * 2;
+	lcn -= compacted_2b;
+	amortizedshift = 2;
+out:
+	pos += lcn << amortizedshift;
+
+	return unpack_compacted_index(m, amortizedshift, pos, lookahead);
+}
+
+static int z_erofs_load_lcluster(struct z_erofs_maprecorder *m, u64 lcn,
+				 bool lookahead)
+{
+	if (m->vi->datalayout == EROFS_INODE_COMPRESSED_FULL)
+		return z_erofs_load_full_lcluster(m, lcn);
+
+	return z_erofs_load_compact_lcluster(m, lcn, lookahead);
+}
+
+static int z_erofs_extent_lookback(struct z_erofs_maprecorder *m,
+				   unsigned int lookback_distance)
+{
+	struct erofs_inode *vi = m->vi;
+	u64 lcn;
+	int ret;
+
+	while (m->lcn >= lookback_distance) {
+		lcn = m->lcn - lookback_distance;
+		ret = z_erofs_load_lcluster(m, lcn, false);
+		if (ret)
+			return ret;
+
+		switch (m->type) {
+		case Z_EROFS_LCLUSTER_TYPE_NONHEAD:
+			lookback_distance = m->delta[0];
+			if (!lookback_distance)
+				goto err_bogus;
+			continue;
+		case Z_EROFS_LCLUSTER_TYPE_PLAIN:
+		case Z_EROFS_LCLUSTER_TYPE_HEAD1:
+		case Z_EROFS_LCLUSTER_TYPE_HEAD2:
+			m->headtype = m->type;
+			m->map->m_la = (lcn << vi->z_lclusterbits) |
+				       m->clusterofs;
+			return 0;
+		}
+	}
+err_bogus:
+	EROFS_E("Bogus lookback distance %u at lcn %llu of inode %llu\n",
+		lookback_distance, m->lcn, vi->nid);
+
+	return -EFSCORRUPTED;
+}
+
+static int z_erofs_get_extent_compressedlen(struct z_erofs_maprecorder *m)
+{
+	struct erofs_inode *vi = m->vi;
+	const unsigned int lclusterbits = vi->z_lclusterbits;
+	struct erofs_map_blocks *map = m->map;
+	u64 lcn;
+	int ret;
+
+	if (m->headtype == Z_EROFS_LCLUSTER_TYPE_PLAIN ||
+	    (m->headtype == Z_EROFS_LCLUSTER_TYPE_HEAD1 &&
+	     !(vi->z_advise & Z_EROFS_ADVISE_BIG_PCLUSTER_1)) ||
+	    (m->headtype == Z_EROFS_LCLUSTER_TYPE_HEAD2 &&
+	     !(vi->z_advise & Z_EROFS_ADVISE_BIG_PCLUSTER_2))) {
+		map->m_plen = 1ULL << lclusterbits;
+		return 0;
+	}
+
+	/* Big pclusters keep their block count in the first NONHEAD */
+	lcn = m->lcn + 1;
+	if (!m->compressedblks) {
+		ret = z_erofs_load_lcluster(m, lcn, false);
+		if (ret)
+			return ret;
+
+		switch (m->type) {
+		case Z_EROFS_LCLUSTER_TYPE_PLAIN:
+		case Z_EROFS_LCLUSTER_TYPE_HEAD1:
+		case Z_EROFS_LCLUSTER_TYPE_HEAD2:
+			m->compressedblks = 1 << (lclusterbits -
+						  erofs_sbi.blkszbits);
+			break;
+		case Z_EROFS_LCLUSTER_TYPE_NONHEAD:
+			if (m->delta[0] == 1 && m->compressedblks)
+				break;
+			/* fall through */
+		default:
+			EROFS_E("Bogus CBLKCNT at lcn %llu of inode %llu\n",
+				lcn, vi->nid);
+			return -EFSCORRUPTED;
+		}
+	}
+	map->m_plen = erofs_pos(m->compressedblks);
+
+	return 0;
+}
+
+static int z_erofs_get_extent_decompressedlen(struct z_erofs_maprecorder *m)
+{
+	struct erofs_inode *vi = m->vi;
+	const unsigned int lclusterbits = vi->z_lclusterbits;
+	struct erofs_map_blocks *map = m->map;
+	u64 lcn = m->lcn, headlcn = map->m_la >> lclusterbits;
+	int ret;
+
+	do {
+		/* The last pcluster has no HEAD after it */
+		if ((lcn << lclusterbits) >= vi->size) {
+			map->m_llen = vi->size - map->m_la;
+			return 0;
+		}
+
+		ret = z_erofs_load_lcluster(m, lcn, true);
+		if (ret)
+			return ret;
+
+		if (m->type != Z_EROFS_LCLUSTER_TYPE_NONHEAD) {
+			/* Go on up to the next HEAD */
+			if (lcn != headlcn)
+				break;
+			m->delta[1] = 1;
+		}
+		lcn += m->delta[1];
+	} while (m->delta[1]);
+
+	map->m_llen = (lcn << lclusterbits) + m->clusterofs - map->m_la;
+
+	return 0;
+}
+
+static int z_erofs_do_map_blocks(struct erofs_inode *vi,
+				 struct erofs_map_blocks *map, bool findtail)
+{
+	bool ztailpacking = vi->z_advise & Z_EROFS_ADVISE_INLINE_PCLUSTER;
+	bool fragment = vi->z_advise & Z_EROFS_ADVISE_FRAGMENT_PCLUSTER;
+	struct z_erofs_maprecorder m = { .vi = vi, .map = map };
+	const unsigned int lclusterbits = vi->z_lclusterbits;
+	unsigned int endoff, afmt;
+	u64 ofs, end;
+	int ret;
+
+	ofs = findtail ? vi->size - 1 : map->m_la;
+	endoff = ofs & ((1 << lclusterbits) - 1);
+
+	ret = z_erofs_load_lcluster(&m, ofs >> lclusterbits, false);
+	if (ret)
+		return ret;
+
+	if (ztailpacking && findtail)
+		vi->z_idataoff = m.nextpackoff;
+
+	map->m_flags = EROFS_MAP_MAPPED;
+	end = (m.lcn + 1ULL) << lclusterbits;
+
+	switch (m.type) {
+	case Z_EROFS_LCLUSTER_TYPE_PLAIN:
+	case Z_EROFS_LCLUSTER_TYPE_HEAD1:
+	case Z_EROFS_LCLUSTER_TYPE_HEAD2:
+		if (endoff >= m.clusterofs) {
+			m.headtype = m.type;
+			map->m_la = (m.lcn << lclusterbits) | m.clusterofs;
+			/* An inline tail may end in its lcluster */
+			if (ztailpacking && end > vi->size)
+				end = vi->size;
+			break;
+		}
+		/* In the extent of the HEAD before */
+		if (!m.lcn) {
+			EROFS_E("Invalid lcluster 0 of inode %llu\n", vi->nid);
+			return -EFSCORRUPTED;
+		}
+		end = (m.lcn << lclusterbits) | m.clusterofs;
+		map->m_flags |= EROFS_MAP_FULL_MAPPED;
+		m.delta[0] = 1;
+		/* fall through */
+	case Z_EROFS_LCLUSTER_TYPE_NONHEAD:
+		ret = z_erofs_extent_lookback(&m, m.delta[0]);
+		if (ret)
+			return ret;
+		break;
+	default:
+		EROFS_E("Unknown lcluster type %u of inode %llu\n", m.type,
+			vi->nid);
+		return -EOPNOTSUPP;
+	}
+	if (m.partialref)
+		map->m_flags |= EROFS_MAP_PARTIAL_REF;
+	map->m_llen = end - map->m_la;
+
+	if (findtail) {
+		vi->z_tailextent_headlcn = m.lcn;
+		/* Full indexes keep the upper half of the offset in pblk */
+		if (fragment && vi->datalayout == EROFS_INODE_COMPRESSED_FULL)
+			vi->z_fragmentoff |= (u64)m.pblk << 32;
+	}
+
+	if (ztailpacking && m.lcn == vi->z_tailextent_headlcn) {
+		map->m_flags |= EROFS_MAP_META;
+		map->m_pa = vi->z_idataoff;
+		map->m_plen = vi->z_idata_size;
+	} else if (fragment && m.lcn == vi->z_tailextent_headlcn) {
+		map->m_flags |= EROFS_MAP_FRAGMENT;
+		map->m_pa = 0;
+		map->m_plen = 0;
+	} else {
+		map->m_pa = erofs_pos(m.pblk);
+		ret = z_erofs_get_extent_compressedlen(&m);
+		if (ret)
+			return ret;
+	}
+
+	if (m.headtype == Z_EROFS_LCLUSTER_TYPE_PLAIN) {
+		if (map->m_llen > map->m_plen &&
+		    !(map->m_flags & EROFS_MAP_FRAGMENT))
+			return -EFSCORRUPTED;
+		afmt = vi->z_advise & Z_EROFS_ADVISE_INTERLACED_PCLUSTER ?
+		       Z_EROFS_COMPRESSION_INTERLACED :
+		       Z_EROFS_COMPRESSION_SHIFTED;
+	} else {
+		afmt = m.headtype == Z_EROFS_LCLUSTER_TYPE_HEAD2 ?
+		       vi->z_algorithmtype[1] : vi->z_algorithmtype[0];
+		if (!(erofs_sbi.available_compr_algs & (1 << afmt))) {
+			EROFS_E("Inconsistent compression %u of inode %llu\n",
+				afmt, vi->nid);
+			return -EFSCORRUPTED;
+		}
+	}
+	map->m_algorithmformat = afmt;
+
+	/* Readers decompress whole extents, so find where this one ends */
+	if (!findtail && !(map->m_flags & EROFS_MAP_FULL_MAPPED)) {
+		ret = z_erofs_get_extent_decompressedlen(&m);
+		if (ret)
+			return ret;
+		map->m_flags |= EROFS_MAP_FULL_MAPPED;
+	}
+
+	return 0;
+}
+
+static int z_erofs_fill_inode(struct erofs_inode *vi)
+{
+	struct erofs_map_blocks map;
+	struct z_erofs_map_header h;
+	int headnr, ret;
+
+	ret = erofs_dev_read(&h, ALIGN(z_erofs_ibase(vi), 8), sizeof(h));
+	if (ret)
+		return ret;
+
+	vi->z_tailextent_headlcn = 0;
+	/* The whole file is in the packed inode, at the rest of the header */
+	if (h.h_clusterbits >> Z_EROFS_FRAGMENT_INODE_BIT) {
+		vi->z_advise = Z_EROFS_ADVISE_FRAGMENT_PCLUSTER;
+		vi->z_fragmentoff = get_unaligned_le64(&h) ^ (1ULL << 63);
+		goto done;
+	}
+
+	vi->z_advise = le16_to_cpu(h.h_advise);
+	vi->z_algorithmtype[0] = h.h_algorithmtype & 15;
+	vi->z_algorithmtype[1] = h.h_algorithmtype >> 4;
+	headnr = 0;
+	if (vi->z_algorithmtype[0] >= Z_EROFS_COMPRESSION_MAX ||
+	    vi->z_algorithmtype[++headnr] >= Z_EROFS_COMPRESSION_MAX) {
+		EROFS_E("Unknown HEAD%u compression %u of inode %llu\n",
+			headnr + 1, vi->z_algorithmtype[headnr], vi->nid);
+		return -EOPNOTSUPP;
+	}
+
+	vi->z_lclusterbits = erofs_sbi.blkszbits + (h.h_clusterbits & 7);
+	if (!erofs_sb_has(EROFS_FEATURE_INCOMPAT_BIG_PCLUSTER) &&
+	    vi->z_advise & (Z_EROFS_ADVISE_BIG_PCLUSTER_1 |
+			    Z_EROFS_ADVISE_BIG_PCLUSTER_2)) {
+		EROFS_E("Big pcluster without the feature in inode %llu\n",
+			vi->nid);
+		return -EFSCORRUPTED;
+	}
+	if (vi->datalayout == EROFS_INODE_COMPRESSED_COMPACT &&
+	    !(vi->z_advise & Z_EROFS_ADVISE_BIG_PCLUSTER_1) ^
+	    !(vi->z_advise & Z_EROFS_ADVISE_BIG_PCLUSTER_2)) {
+		EROFS_E("Inconsistent big pclusters in inode %llu\n",
+			vi->nid);
+		return -EFSCORRUPTED;
+	}
+
+	if (vi->z_advise & Z_EROFS_ADVISE_INLINE_PCLUSTER) {
+		vi->z_idata_size = le16_to_cpu(h.h_idata_size);
+		ret = z_erofs_do_map_blocks(vi, &map, true);
+		if (ret)
+			return ret;
+		if (!map.m_plen ||
+		    erofs_blkoff(map.m_pa) + map.m_plen > erofs_blksiz()) {
+			EROFS_E("Invalid inline pcluster size %llu\n",
+				map.m_plen);
+			return -EFSCORRUPTED;
+		}
+	}
+
+	if (vi->z_advise & Z_EROFS_ADVISE_FRAGMENT_PCLUSTER) {
+		vi->z_fragmentoff = le32_to_cpu(h.h_fragmentoff);
+		ret = z_erofs_do_map_blocks(vi, &map, true);
+		if (ret)
+			return ret;
+	}
+done:
+	vi->z_inited = true;
+
+	return 0;
+}
+
+int z_erofs_map_blocks(struct erofs_inode *vi, struct erofs_map_blocks *map)
+{
+	int ret;
+
+	/* Leave what is beyond EOF unmapped */
+	if (map->m_la >= vi->size) {
+		map->m_llen = map->m_la + 1 - vi->size;
+		map->m_la = vi->size;
+		map->m_flags = 0;
+		return 0;
+	}
+
+	if (!vi->z_inited) {
+		ret = z_erofs_fill_inode(vi);
+		if (ret)
+			return ret;
+	}
+
+	if ((vi->z_advise & Z_EROFS_ADVISE_FRAGMENT_PCLUSTER) &&
+	    !vi->z_tailextent_headlcn) {
+		map->m_la = 0;
+		map->m_llen = vi->size;
+		map->m_flags = EROFS_MAP_MAPPED | EROFS_MAP_FULL_MAPPED |
+			       EROFS_MAP_FRAGMENT;
+		return 0;
+	}
+
+	return z_erofs_do_map_blocks(vi, map, false);
+}
@@ -26,6 +26,8 @@
 #include <common.h>
 #include <blk.h>
 #include <config.h>
+#include <dm.h>
+#include <malloc.h>
 #include <fs_internal.h>
 #include <ext4fs.h>
 #include <ext_common.h>
@@ -36,6 +38,150 @@ lbaint_t part_offset;
 static struct blk_desc *ext4fs_blk_desc;
 static disk_partition_t *part_info;
 
+#if CONFIG_IS_ENABLED(BLK) && defined(CONFIG_EXT4_CACHE_BLOCKS) && \
+	CONFIG_EXT4_CACHE_BLOCKS > 0
+#define EXT4_CACHE_BLOCKS	CONFIG_EXT4_CACHE_BLOCKS
+#endif
+
+#ifdef EXT4_CACHE_BLOCKS
+/*
+ * Metadata blocks (group descriptors, inode tables, extent index and
+ * directory blocks) of the last mounted filesystem. They outlive the mount,
+ * every command mounts again, for as long as the same filesystem is found
+ * on the same partition and nothing was written to the device.
+ */
+struct ext4_cache_block {
+	char *buf;
+	lbaint_t blknr;
+	uint tick;		/* last use, 0 while empty */
+};
+
+static struct ext4_cache {
+	struct blk_desc *desc;	/* uclass blk_desc, which counts the writes */
+	uint write_gen;
+	int hwpart;
+	lbaint_t lba;
+	lbaint_t part_start;
+	lbaint_t part_size;
+	int blksz;
+	struct ext2_sblock sblock;
+	uint tick;
+	struct ext4_cache_block blocks[EXT4_CACHE_BLOCKS];
+} ext4_cache;
+
+static void ext4fs_cache_drop(void)
+{
+	int i;
+
+	for (i = 0; i < EXT4_CACHE_BLOCKS; i++) {
+		free(ext4_cache.blocks[i].buf);
+		ext4_cache.blocks[i].buf = NULL;
+		ext4_cache.blocks[i].tick = 0;
+	}
+	ext4_cache.desc = NULL;
+	ext4_cache.tick = 0;
+}
+
+static struct blk_desc *ext4fs_cache_desc(void)
+{
+	struct blk_desc *desc = get_fs()->dev_desc;
+
+	return desc->bdev ? dev_get_uclass_platdata(desc->bdev) : NULL;
+}
+
+void ext4fs_cache_mount(struct ext2_data *data)
+{
+	struct blk_desc *desc = ext4fs_cache_desc();
+
+	if (desc && desc == ext4_cache.desc &&
+	    desc->write_gen == ext4_cache.write_gen &&
+	    desc->hwpart == ext4_cache.hwpart &&
+	    desc->lba == ext4_cache.lba &&
+	    part_info->start == ext4_cache.part_start &&
+	    part_info->size == ext4_cache.part_size &&
+	    EXT2_BLOCK_SIZE(data) == ext4_cache.blksz &&
+	    !memcmp(&data->sblock, &ext4_cache.sblock, sizeof(data->sblock)))
+		return;
+
+	ext4fs_cache_drop();
+	if (!desc)
+		return;
+
+	ext4_cache.desc = desc;
+	ext4_cache.write_gen = desc->write_gen;
+	ext4_cache.hwpart = desc->hwpart;
+	ext4_cache.lba = desc->lba;
+	ext4_cache.part_start = part_info->start;
+	ext4_cache.part_size = part_info->size;
+	ext4_cache.blksz = EXT2_BLOCK_SIZE(data);
+	memcpy(&ext4_cache.sblock, &data->sblock, sizeof(data->sblock));
+}
+
+int ext4fs_cache_read(struct ext2_data *data, lbaint_t sector,
+		      int byte_offset, int byte_len, char *buf)
+{
+	struct ext4_cache_block *blk, *victim = NULL;
+	int log2blksz = get_fs()->dev_desc->log2blksz;
+	int blksz = EXT2_BLOCK_SIZE(data);
+	lbaint_t blknr;
+	u64 pos;
+	int i, off;
+
+	if (ext4_cache.desc != ext4fs_cache_desc() ||
+	    ext4_cache.blksz != blksz)
+		return ext4fs_devread(sector, byte_offset, byte_len, buf);
+
+	/* Written since it was filled, by the ext4 write code or anyone else */
+	if (ext4_cache.desc->write_gen != ext4_cache.write_gen) {
+		for (i = 0; i < EXT4_CACHE_BLOCKS; i++)
+			ext4_cache.blocks[i].tick = 0;
+		ext4_cache.write_gen = ext4_cache.desc->write_gen;
+	}
+
+	pos = ((u64)sector << log2blksz) + byte_offset;
+	blknr = pos >> LOG2_BLOCK_SIZE(data);
+	off = pos & (blksz - 1);
+	if (off + byte_len > blksz)
+		return ext4fs_devread(sector, byte_offset, byte_len, buf);
+
+	for (i = 0; i < EXT4_CACHE_BLOCKS; i++) {
+		blk = &ext4_cache.blocks[i];
+		if (blk->tick && blk->blknr == blknr)
+			goto hit;
+		if (!victim || blk->tick < victim->tick)
+			victim = blk;
+	}
+
+	blk = victim;
+	blk->tick = 0;
+	if (!blk->buf) {
+		blk->buf = memalign(ARCH_DMA_MINALIGN, blksz);
+		if (!blk->buf)
+			return ext4fs_devread(sector, byte_offset, byte_len,
+					      buf);
+	}
+	if (!ext4fs_devread(blknr << (LOG2_BLOCK_SIZE(data) - log2blksz), 0,
+			    blksz, blk->buf))
+		return 0;
+	blk->blknr = blknr;
+hit:
+	blk->tick = ++ext4_cache.tick;
+	memcpy(buf, blk->buf + off, byte_len);
+
+	return 1;
+}
+#else
+void ext4fs_cache_mount(struct ext2_data *data)
+{
+}
+
+int ext4fs_cache_read(struct ext2_data *data, lbaint_t sector,
+		      int byte_offset, int byte_len, char *buf)
+{
+	return ext4fs_devread(sector, byte_offset, byte_len, buf);
+}
+#endif
+
 void ext4fs_set_blk_dev(struct blk_desc *rbdd, disk_partition_t *info)
 {
 	assert(rbdd->blksz == (1 << rbdd->log2blksz));
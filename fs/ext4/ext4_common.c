@@ -1554,8 +1554,8 @@ static struct ext4_extent_header *ext4fs_get_extent_block
 		block = le16_to_cpu(index[i].ei_leaf_hi);
 		block = (block << 32) + le32_to_cpu(index[i].ei_leaf_lo);
 
-		if (ext4fs_devread((lbaint_t)block << log2_blksz, 0, blksz,
-				   buf))
+		if (ext4fs_cache_read(data, (lbaint_t)block << log2_blksz, 0,
+				      blksz, buf))
 			ext_block = (struct ext4_extent_header *)buf;
 		else
 			return NULL;
@@ -1579,9 +1579,9 @@ static int ext4fs_blockgroup
 	debug("ext4fs read %d group descriptor (blkno %ld blkoff %u)\n",
 	      group, blkno, blkoff);
 
-	return ext4fs_devread((lbaint_t)blkno <<
-			      (LOG2_BLOCK_SIZE(data) - log2blksz),
-			      blkoff, desc_size, (char *)blkgrp);
+	return ext4fs_cache_read(data, (lbaint_t)blkno <<
+				 (LOG2_BLOCK_SIZE(data) - log2blksz),
+				 blkoff, desc_size, (char *)blkgrp);
 }
 
 int ext4fs_read_inode(struct ext2_data *data, int ino, struct ext2_inode *inode)
@@ -1606,15 +1606,86 @@ int ext4fs_read_inode(struct ext2_data *data, int ino, struct ext2_inode *inode)
 	    (ino % le32_to_cpu(sblock->inodes_per_group)) / inodes_per_block;
 	blkoff = (ino % inodes_per_block) * fs->inodesz;
 	/* Read the inode. */
-	status = ext4fs_devread((lbaint_t)blkno << (LOG2_BLOCK_SIZE(data) -
-				log2blksz), blkoff,
-				sizeof(struct ext2_inode), (char *)inode);
+	status = ext4fs_cache_read(data, (lbaint_t)blkno <<
+				   (LOG2_BLOCK_SIZE(data) - log2blksz), blkoff,
+				   sizeof(struct ext2_inode), (char *)inode);
 	if (status == 0)
 		return 0;
 
 	return 1;
 }
 
+/*
+ * Map @fileblock of an extent mapped inode, and count in @count how many
+ * blocks from it on map as contiguously, no more than @count on entry.
+ */
+static long int ext4fs_map_extent(struct ext2_inode *inode, int fileblock,
+				  lbaint_t *count)
+{
+	int blksz = EXT2_BLOCK_SIZE(ext4fs_root);
+	int log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root) -
+			 get_fs()->dev_desc->log2blksz;
+	struct ext4_extent_header *ext_block;
+	struct ext4_extent *extent;
+	long int startblock, endblock;
+	unsigned long long start;
+	char *buf;
+	int i;
+
+	buf = zalloc(blksz);
+	if (!buf)
+		return -ENOMEM;
+
+	ext_block = ext4fs_get_extent_block(ext4fs_root, buf,
+					    (struct ext4_extent_header *)
+					    inode->b.blocks.dir_blocks,
+					    fileblock, log2_blksz);
+	if (!ext_block) {
+		printf("invalid extent block\n");
+		free(buf);
+		return -EINVAL;
+	}
+
+	extent = (struct ext4_extent *)(ext_block + 1);
+
+	for (i = 0; i < le16_to_cpu(ext_block->eh_entries); i++) {
+		startblock = le32_to_cpu(extent[i].ee_block);
+		endblock = startblock + le16_to_cpu(extent[i].ee_len);
+
+		if (startblock > fileblock) {
+			/* Sparse file, a hole up to this extent */
+			*count = min_t(lbaint_t, *count,
+				       startblock - fileblock);
+			free(buf);
+			return 0;
+
+		} else if (fileblock < endblock) {
+			start = le16_to_cpu(extent[i].ee_start_hi);
+			start = (start << 32) +
+				le32_to_cpu(extent[i].ee_start_lo);
+			*count = min_t(lbaint_t, *count, endblock - fileblock);
+			free(buf);
+			return (fileblock - startblock) + start;
+		}
+	}
+
+	/* A hole past this leaf, which may end anywhere in the next one */
+	*count = 1;
+	free(buf);
+	return 0;
+}
+
+long int read_allocated_run(struct ext2_inode *inode, int fileblock,
+			    lbaint_t *count)
+{
+	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL)
+		return ext4fs_map_extent(inode, fileblock, count);
+
+	*count = 1;
+
+	return read_allocated_block(inode, fileblock);
+}
+
 long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 {
 	long int blknr;
@@ -1624,53 +1695,15 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock)
 	long int rblock;
 	long int perblock_parent;
 	long int perblock_child;
-	unsigned long long start;
 	/* get the blocksize of the filesystem */
 	blksz = EXT2_BLOCK_SIZE(ext4fs_root);
 	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
 		- get_fs()->dev_desc->log2blksz;
 
 	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL) {
-		long int startblock, endblock;
-		char *buf = zalloc(blksz);
-		if (!buf)
-			return -ENOMEM;
-		struct ext4_extent_header *ext_block;
-		struct ext4_extent *extent;
-		int i;
-		ext_block =
-			ext4fs_get_extent_block(ext4fs_root, buf,
-						(struct ext4_extent_header *)
-						inode->b.blocks.dir_blocks,
-						fileblock, log2_blksz);
-		if (!ext_block) {
-			printf("invalid extent block\n");
-			free(buf);
-			return -EINVAL;
-		}
-
-		extent = (struct ext4_extent *)(ext_block + 1);
-
-		for (i = 0; i < le16_to_cpu(ext_block->eh_entries); i++) {
-			startblock = le32_to_cpu(extent[i].ee_block);
-			endblock = startblock + le16_to_cpu(extent[i].ee_len);
-
-			if (startblock > fileblock) {
-				/* Sparse file */
-				free(buf);
-				return 0;
+		lbaint_t count = 1;
 
-			} else if (fileblock < endblock) {
-				start = le16_to_cpu(extent[i].ee_start_hi);
-				start = (start << 32) +
-					le32_to_cpu(extent[i].ee_start_lo);
-				free(buf);
-				return (fileblock - startblock) + start;
-			}
-		}
-
-		free(buf);
-		return 0;
+		return ext4fs_map_extent(inode, fileblock, &count);
 	}
 
 	/* Direct blocks. */
@@ -2005,13 +2038,305 @@ void ext4fs_close(void)
 	ext4fs_reinit_global();
 }
 
+struct dx_root_info {
+	__le32 reserved_zero;
+	uint8_t hash_version;
+	uint8_t info_length;
+	uint8_t indirect_levels;
+	uint8_t unused_flags;
+};
+
+struct dx_entry {
+	__le32 hash;
+	__le32 block;
+};
+
+/* Overlays the hash of the first dx_entry of a node */
+struct dx_countlimit {
+	__le16 limit;
+	__le16 count;
+};
+
+#define EXT4_FEATURE_COMPAT_DIR_INDEX	0x0020
+#define EXT2_FLAGS_UNSIGNED_HASH	0x0002
+/* dx_root_info sits after the "." and ".." entries of block 0 */
+#define DX_ROOT_INFO_OFFSET		24
+/* The entries of the other index blocks after an empty dirent */
+#define DX_NODE_ENTRIES_OFFSET		8
+#define DX_BLOCK_MASK			0x0fffffff
+#define DX_MAX_LEVELS			2
+
+/* Read block @blk of directory @diro, where holes are errors */
+static int ext4fs_read_dir_block(struct ext2fs_node *diro, int blk, char *buf)
+{
+	struct ext2_data *data = diro->data;
+	int log2blksz = get_fs()->dev_desc->log2blksz;
+	long int blknr;
+
+	if ((loff_t)blk * EXT2_BLOCK_SIZE(data) >=
+	    le32_to_cpu(diro->inode.size))
+		return -EINVAL;
+
+	blknr = read_allocated_block(&diro->inode, blk);
+	if (blknr <= 0)
+		return -EIO;
+
+	if (!ext4fs_cache_read(data, (lbaint_t)blknr <<
+			       (LOG2_BLOCK_SIZE(data) - log2blksz), 0,
+			       EXT2_BLOCK_SIZE(data), buf))
+		return -EIO;
+
+	return 0;
+}
+
+/*
+ * Look for @name at @dirent, or list it when @name is NULL
+ *
+ * @return 1 if found, 0 to go on, -1 on error
+ */
+static int ext4fs_iterate_dirent(struct ext2fs_node *diro,
+				 struct ext2_dirent *dirent, char *filename,
+				 char *name, struct ext2fs_node **fnode,
+				 int *ftype)
+{
+	struct ext2fs_node *fdiro;
+	int type = FILETYPE_UNKNOWN;
+	int status;
+
+	if (name && fnode && ftype && strcmp(filename, name))
+		return 0;
+
+	fdiro = zalloc(sizeof(struct ext2fs_node));
+	if (!fdiro)
+		return -1;
+
+	fdiro->data = diro->data;
+	fdiro->ino = le32_to_cpu(dirent->inode);
+
+	if (dirent->filetype != FILETYPE_UNKNOWN) {
+		fdiro->inode_read = 0;
+
+		if (dirent->filetype == FILETYPE_DIRECTORY)
+			type = FILETYPE_DIRECTORY;
+		else if (dirent->filetype == FILETYPE_SYMLINK)
+			type = FILETYPE_SYMLINK;
+		else if (dirent->filetype == FILETYPE_REG)
+			type = FILETYPE_REG;
+	} else {
+		status = ext4fs_read_inode(diro->data,
+					   le32_to_cpu(dirent->inode),
+					   &fdiro->inode);
+		if (status == 0) {
+			free(fdiro);
+			return -1;
+		}
+		fdiro->inode_read = 1;
+
+		if ((le16_to_cpu(fdiro->inode.mode) &
+		     FILETYPE_INO_MASK) == FILETYPE_INO_DIRECTORY) {
+			type = FILETYPE_DIRECTORY;
+		} else if ((le16_to_cpu(fdiro->inode.mode) &
+			    FILETYPE_INO_MASK) == FILETYPE_INO_SYMLINK) {
+			type = FILETYPE_SYMLINK;
+		} else if ((le16_to_cpu(fdiro->inode.mode) &
+			    FILETYPE_INO_MASK) == FILETYPE_INO_REG) {
+			type = FILETYPE_REG;
+		}
+	}
+#ifdef DEBUG
+	printf("iterate >%s<\n", filename);
+#endif /* of DEBUG */
+	if ((name != NULL) && (fnode != NULL) && (ftype != NULL)) {
+		*ftype = type;
+		*fnode = fdiro;
+		return 1;
+	}
+
+	if (fdiro->inode_read == 0) {
+		status = ext4fs_read_inode(diro->data,
+					   le32_to_cpu(dirent->inode),
+					   &fdiro->inode);
+		if (status == 0) {
+			free(fdiro);
+			return -1;
+		}
+		fdiro->inode_read = 1;
+	}
+	switch (type) {
+	case FILETYPE_DIRECTORY:
+		printf("<DIR> ");
+		break;
+	case FILETYPE_SYMLINK:
+		printf("<SYM> ");
+		break;
+	case FILETYPE_REG:
+		printf("      ");
+		break;
+	default:
+		printf("< ? > ");
+		break;
+	}
+	printf("%10u %s\n", le32_to_cpu(fdiro->inode.size), filename);
+	free(fdiro);
+
+	return 0;
+}
+
+/*
+ * Walk the entries of block @blk of directory @diro, read into @buf
+ *
+ * @return 1 if found, 0 to go on, -1 on error
+ */
+static int ext4fs_iterate_dir_block(struct ext2fs_node *diro, int blk,
+				    char *buf, char *name,
+				    struct ext2fs_node **fnode, int *ftype)
+{
+	unsigned int blksz = EXT2_BLOCK_SIZE(diro->data);
+	unsigned int end = le32_to_cpu(diro->inode.size) - blk * blksz;
+	struct ext2_dirent *dirent;
+	unsigned int fpos, direntlen;
+	int ret;
+
+	if (ext4fs_read_dir_block(diro, blk, buf))
+		goto fail;
+
+	end = min(end, blksz);
+	for (fpos = 0; fpos < end; fpos += direntlen) {
+		dirent = (struct ext2_dirent *)(buf + fpos);
+		if (fpos + sizeof(*dirent) > end)
+			goto fail;
+		direntlen = le16_to_cpu(dirent->direntlen);
+		if (direntlen == 0 ||
+		    fpos + sizeof(*dirent) + dirent->namelen > blksz)
+			goto fail;
+
+		if (dirent->namelen != 0) {
+			char filename[dirent->namelen + 1];
+
+			memcpy(filename, dirent + 1, dirent->namelen);
+			filename[dirent->namelen] = '\0';
+
+			ret = ext4fs_iterate_dirent(diro, dirent, filename,
+						    name, fnode, ftype);
+			if (ret)
+				return ret;
+		}
+	}
+
+	return 0;
+fail:
+	printf("Failed to iterate over directory %s\n", name);
+	return -1;
+}
+
+/*
+ * Look @name up in the hash tree of directory @diro, with @buf for the
+ * leaf blocks. Anything unexpected in the index leaves it to the linear
+ * scan, which reads the same leaves as plain directory blocks.
+ *
+ * @return 1 if found, 0 if not or on error, -EOPNOTSUPP to scan instead
+ */
+static int ext4fs_htree_lookup(struct ext2fs_node *diro, char *buf,
+			       char *name, struct ext2fs_node **fnode,
+			       int *ftype)
+{
+	struct ext2_sblock *sblock = &diro->data->sblock;
+	unsigned int blksz = EXT2_BLOCK_SIZE(diro->data);
+	struct dx_entry *entries, *at;
+	struct dx_root_info *info;
+	struct dx_countlimit *cl;
+	int version, levels, depth, count, lo, hi, mid, ret;
+	u32 hash, next, seed[4];
+	char *node;
+
+	if (!(le32_to_cpu(sblock->feature_compatibility) &
+	      EXT4_FEATURE_COMPAT_DIR_INDEX))
+		return -EOPNOTSUPP;
+
+	node = zalloc(blksz);
+	if (!node)
+		return -EOPNOTSUPP;
+
+	if (ext4fs_read_dir_block(diro, 0, node))
+		goto scan;
+
+	info = (struct dx_root_info *)(node + DX_ROOT_INFO_OFFSET);
+	if (info->reserved_zero || info->info_length < sizeof(*info) ||
+	    info->indirect_levels > DX_MAX_LEVELS)
+		goto scan;
+
+	version = info->hash_version;
+	if (version <= DX_HASH_TEA &&
+	    (le32_to_cpu(sblock->flags) & EXT2_FLAGS_UNSIGNED_HASH))
+		version += DX_HASH_LEGACY_UNSIGNED;
+	for (lo = 0; lo < 4; lo++)
+		seed[lo] = le32_to_cpu(sblock->hash_seed[lo]);
+	if (ext4fs_dirhash(name, strlen(name), version, seed, &hash))
+		goto scan;
+
+	entries = (struct dx_entry *)(node + DX_ROOT_INFO_OFFSET +
+				      info->info_length);
+	depth = info->indirect_levels;
+	levels = depth;
+	for (;;) {
+		cl = (struct dx_countlimit *)entries;
+		count = le16_to_cpu(cl->count);
+		if (!count || count > le16_to_cpu(cl->limit) ||
+		    (char *)(entries + count) > node + blksz)
+			goto scan;
+
+		/* The last entry hashing at most @hash, entries[0] has none */
+		lo = 1;
+		hi = count - 1;
+		while (lo <= hi) {
+			mid = (lo + hi) / 2;
+			if (le32_to_cpu(entries[mid].hash) > hash)
+				hi = mid - 1;
+			else
+				lo = mid + 1;
+		}
+		at = entries + lo - 1;
+
+		if (!levels--)
+			break;
+		if (ext4fs_read_dir_block(diro, le32_to_cpu(at->block) &
+					  DX_BLOCK_MASK, node))
+			goto scan;
+		entries = (struct dx_entry *)(node + DX_NODE_ENTRIES_OFFSET);
+	}
+
+	/* Names with the same hash may go on into the next leaves */
+	for (;;) {
+		ret = ext4fs_iterate_dir_block(diro, le32_to_cpu(at->block) &
+					       DX_BLOCK_MASK, buf, name,
+					       fnode, ftype);
+		if (ret)
+			break;
+
+		if (++at == entries + count) {
+			/* Going on would take the next index node */
+			ret = depth ? -EOPNOTSUPP : 0;
+			break;
+		}
+		next = le32_to_cpu(at->hash);
+		if (!(next & 1) || (next & ~1) != hash)
+			break;
+	}
+	free(node);
+
+	return ret;
+scan:
+	free(node);
+	return -EOPNOTSUPP;
+}
+
 int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 				struct ext2fs_node **fnode, int *ftype)
 {
-	unsigned int fpos = 0;
-	int status;
-	loff_t actread;
 	struct ext2fs_node *diro = (struct ext2fs_node *) dir;
+	unsigned int blksz, nblocks;
+	int status, blk, ret = 0;
+	char *buf;
 
 #ifdef DEBUG
 	if (name != NULL)
@@ -2022,122 +2347,29 @@ int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 		if (status == 0)
 			return 0;
 	}
-	/* Search the file.  */
-	while (fpos < le32_to_cpu(diro->inode.size)) {
-		struct ext2_dirent dirent;
-
-		status = ext4fs_read_file(diro, fpos,
-					   sizeof(struct ext2_dirent),
-					   (char *)&dirent, &actread);
-		if (status < 0)
-			return 0;
-
-		if (dirent.direntlen == 0) {
-			printf("Failed to iterate over directory %s\n", name);
-			return 0;
-		}
-
-		if (dirent.namelen != 0) {
-			char filename[dirent.namelen + 1];
-			struct ext2fs_node *fdiro;
-			int type = FILETYPE_UNKNOWN;
-
-			status = ext4fs_read_file(diro,
-						  fpos +
-						  sizeof(struct ext2_dirent),
-						  dirent.namelen, filename,
-						  &actread);
-			if (status < 0)
-				return 0;
-
-			fdiro = zalloc(sizeof(struct ext2fs_node));
-			if (!fdiro)
-				return 0;
 
-			fdiro->data = diro->data;
-			fdiro->ino = le32_to_cpu(dirent.inode);
+	blksz = EXT2_BLOCK_SIZE(diro->data);
+	buf = zalloc(blksz);
+	if (!buf)
+		return 0;
 
-			filename[dirent.namelen] = '\0';
+	if (name && fnode && ftype &&
+	    (le32_to_cpu(diro->inode.flags) & EXT4_INDEX_FL)) {
+		ret = ext4fs_htree_lookup(diro, buf, name, fnode, ftype);
+		if (ret != -EOPNOTSUPP)
+			goto out;
+		ret = 0;
+	}
 
-			if (dirent.filetype != FILETYPE_UNKNOWN) {
-				fdiro->inode_read = 0;
+	/* Search the file, a block at a time */
+	nblocks = DIV_ROUND_UP(le32_to_cpu(diro->inode.size), blksz);
+	for (blk = 0; blk < nblocks && !ret; blk++)
+		ret = ext4fs_iterate_dir_block(diro, blk, buf, name, fnode,
+					       ftype);
+out:
+	free(buf);
 
-				if (dirent.filetype == FILETYPE_DIRECTORY)
-					type = FILETYPE_DIRECTORY;
-				else if (dirent.filetype == FILETYPE_SYMLINK)
-					type = FILETYPE_SYMLINK;
-				else if (dirent.filetype == FILETYPE_REG)
-					type = FILETYPE_REG;
-			} else {
-				status = ext4fs_read_inode(diro->data,
-							   le32_to_cpu
-							   (dirent.inode),
-							   &fdiro->inode);
-				if (status == 0) {
-					free(fdiro);
-					return 0;
-				}
-				fdiro->inode_read = 1;
-
-				if ((le16_to_cpu(fdiro->inode.mode) &
-				     FILETYPE_INO_MASK) ==
-				    FILETYPE_INO_DIRECTORY) {
-					type = FILETYPE_DIRECTORY;
-				} else if ((le16_to_cpu(fdiro->inode.mode)
-					    & FILETYPE_INO_MASK) ==
-					   FILETYPE_INO_SYMLINK) {
-					type = FILETYPE_SYMLINK;
-				} else if ((le16_to_cpu(fdiro->inode.mode)
-					    & FILETYPE_INO_MASK) ==
-					   FILETYPE_INO_REG) {
-					type = FILETYPE_REG;
-				}
-			}
-#ifdef DEBUG
-			printf("iterate >%s<\n", filename);
-#endif /* of DEBUG */
-			if ((name != NULL) && (fnode != NULL)
-			    && (ftype != NULL)) {
-				if (strcmp(filename, name) == 0) {
-					*ftype = type;
-					*fnode = fdiro;
-					return 1;
-				}
-			} else {
-				if (fdiro->inode_read == 0) {
-					status = ext4fs_read_inode(diro->data,
-								 le32_to_cpu(
-								 dirent.inode),
-								 &fdiro->inode);
-					if (status == 0) {
-						free(fdiro);
-						return 0;
-					}
-					fdiro->inode_read = 1;
-				}
-				switch (type) {
-				case FILETYPE_DIRECTORY:
-					printf("<DIR> ");
-					break;
-				case FILETYPE_SYMLINK:
-					printf("<SYM> ");
-					break;
-				case FILETYPE_REG:
-					printf("      ");
-					break;
-				default:
-					printf("< ? > ");
-					break;
-				}
-				printf("%10u %s\n",
-				       le32_to_cpu(fdiro->inode.size),
-					filename);
-			}
-			free(fdiro);
-		}
-		fpos += le16_to_cpu(dirent.direntlen);
-	}
-	return 0;
+	return ret > 0;
 }
 
 static char *ext4fs_read_symlink(struct ext2fs_node *node)
@@ -2365,6 +2597,8 @@ int ext4fs_mount(unsigned part_length)
 	      le32_to_cpu(data->sblock.revision_level),
 	      fs->inodesz, fs->gdsize);
 
+	ext4fs_cache_mount(data);
+
 	data->diropen.data = data;
 	data->diropen.ino = 2;
 	data->diropen.inode_read = 1;
@@ -6,143 +6,112 @@
 
 #include <common.h>
 #include <blk.h>
-#include <memalign.h>
+#include <div64.h>
 #include <image-sparse.h>
-#include <u-boot/sha256.h>
+#include <mmc.h>
 
 /******************************************************************************/
 #define PER_BLK_WRITE_SIZE	SZ_8M	  /* Avoid -ENOMEM, eg: bounce buffer */
-#define DEBUG_SPARSE
+
+struct ext4_sparse {
+	struct blk_desc *desc;
+	/* Blocks per erase group, DONT_CARE chunks discard whole groups */
+	lbaint_t discard_grp;
+};
 
 /******************************************************************************/
-static void print_header_info(sparse_header_t *header)
+static lbaint_t ext4_sparse_write(struct sparse_storage *info, lbaint_t blk,
+				  lbaint_t blkcnt, const void *buffer)
 {
-#ifdef DEBUG_SPARSE
-	printf("  ==== sparse header ===\n");
-	printf("  magic:          0x%x\n", header->magic);
-	printf("  major_version:  0x%x\n", header->major_version);
-	printf("  minor_version:  0x%x\n", header->minor_version);
-	printf("  file_hdr_sz:    %d\n", header->file_hdr_sz);
-	printf("  chunk_hdr_sz:   %d\n", header->chunk_hdr_sz);
-	printf("  blk_sz:         %d\n", header->blk_sz);
-	printf("  total_blks:     %d\n", header->total_blks);
-	printf("  total_chunks:   %d\n", header->total_chunks);
-	printf("  image_checksum: %d\n\n", header->image_checksum);
-#endif
+	struct ext4_sparse *sparse = info->priv;
+	struct blk_desc *desc = sparse->desc;
+	lbaint_t step = BLOCK_CNT(PER_BLK_WRITE_SIZE, desc);
+	const u8 *buf = buffer;
+	lbaint_t left = blkcnt;
+	lbaint_t blks;
+
+	while (left) {
+		blks = min(left, step);
+		if (blks != blk_dwrite(desc, blk, blks, buf)) {
+			printf("Raw data: LBA 0x" LBAF " written error.\n", blk);
+			break;
+		}
+		buf += blks * desc->blksz;
+		blk += blks;
+		left -= blks;
+	}
+
+	return blkcnt - left;
 }
 
-static void print_chunk_info(chunk_header_t *chunk, u32 id,
-			     const u8 *ptr, sparse_header_t *header)
+/*
+ * DONT_CARE chunks are not written. Their whole erase groups are erased,
+ * so that the card knows the blocks are unused, but the blocks at either
+ * end are left alone: erasing their group would also erase data which
+ * has been written already.
+ */
+static lbaint_t ext4_sparse_reserve(struct sparse_storage *info,
+				    lbaint_t blk, lbaint_t blkcnt)
 {
-#ifdef DEBUG_SPARSE
-	const char *type;
-
-	if (chunk->chunk_type == CHUNK_TYPE_RAW)
-		type = "RAW";
-	else if (chunk->chunk_type == CHUNK_TYPE_DONT_CARE)
-		type = "DONT CARE";
-	else if (chunk->chunk_type == CHUNK_TYPE_FILL)
-		type = "FILL";
-	else if (chunk->chunk_type == CHUNK_TYPE_CRC32)
-		type = "CRC32";
-	else
-		type = "UNK";
-
-	printf("  === [chunk.%d]\n", id + 1);
-	printf("  chunk_type: %s\n", type);
-	printf("  chunk_sz:   %d\n", chunk->chunk_sz);
-	printf("  total_sz:   %d\n", chunk->total_sz);
-	printf("  offset:     %ld\n", (ulong)ptr - (ulong)header);
-	printf("  buf:        0x%08lx\n", (ulong)ptr);
-#endif
+	struct ext4_sparse *sparse = info->priv;
+	lbaint_t grp = sparse->discard_grp;
+	lbaint_t head, mid;
+	u32 rem;
+
+	div_u64_rem(blk, grp, &rem);
+	head = rem ? grp - rem : 0;
+	if (head < blkcnt) {
+		div_u64_rem(blkcnt - head, grp, &rem);
+		mid = blkcnt - head - rem;
+		if (mid)
+			blk_derase(sparse->desc, blk + head, mid);
+	}
+
+	return blkcnt;
 }
 
-static int flash_write_data(struct blk_desc *desc, const u8 *data,
-			    ulong offset, ulong blocks)
-{	const u8 *buf = data;
-	u32 step = BLOCK_CNT(PER_BLK_WRITE_SIZE, desc);
-	long left = blocks;	/* signed long ! */
-	ulong lba = offset;
-	ulong blks;
-
-#ifdef DEBUG_SPARSE
-	printf("  lba:        0x%08lx - 0x%08lx\n", lba, lba + blocks);
-#ifdef CONFIG_SHA256
-	u8 hash[32];
-	int i;
-
-	sha256_csum(data, blocks * desc->blksz, hash);
-	printf("  sha256sum:  ");
-	for (i = 0; i < ARRAY_SIZE(hash); i++)
-		printf("%02x", hash[i]);
-	printf("\n");
-#endif
-#endif
-	while (left > 0) {
-		if (left < step)
-			blks = left;
-		else
-			blks = step;
-
-		if (blks != blk_dwrite(desc, lba, blks, buf)) {
-			printf("Raw data: LBA 0x%lx written error.\n", lba);
-			return -EIO;
-		}
-		buf += blks * desc->blksz;
-		lba += blks;
-		left -= step;
-	}
+static lbaint_t ext4_sparse_erase(struct sparse_storage *info,
+				  lbaint_t blk, lbaint_t blkcnt)
+{
+	struct ext4_sparse *sparse = info->priv;
 
-	return 0;
+	return blk_derase(sparse->desc, blk, blkcnt);
 }
 
-static int flash_fill_data(struct blk_desc *desc, ulong offset, ulong blocks,
-			   u32 fill_val)
+/*
+ * Zero FILL chunks can be erased instead of written if erased blocks read
+ * back as zero, which only eMMC tells us.
+ */
+static void ext4_sparse_erase_grp(struct blk_desc *desc, lbaint_t *discard,
+				  lbaint_t *zero)
 {
-	u32 step = BLOCK_CNT(PER_BLK_WRITE_SIZE, desc);
-	long left = blocks;	/* signed long ! */
-	ulong lba = offset;
-	ulong blks;
-	char *buf;
-
-	buf = malloc(PER_BLK_WRITE_SIZE);
-	if (!buf) {
-		printf("No memory\n");
-		return -ENOMEM;
-	}
-#ifdef DEBUG_SPARSE
-	printf("  lba:        0x%08lx - 0x%08lx\n", lba, lba + blocks);
-	printf("  fill:       0x%08x\n", fill_val);
-#endif
-	memset((char *)buf, fill_val, PER_BLK_WRITE_SIZE);
-	while (left > 0) {
-		if (left < step)
-			blks = left;
-		else
-			blks = step;
-
-		if (blks != blk_dwrite(desc, lba, blks, buf)) {
-			printf("Fill data: LBA 0x%lx write error.\n", lba);
-			free(buf);
-			return -EIO;
-		}
-		lba += blks;
-		left -= step;
-	}
-	free(buf);
+	*discard = 1;
+	*zero = 0;
+#if CONFIG_IS_ENABLED(MMC)
+	struct mmc *mmc;
 
-	return 0;
+	if (desc->if_type != IF_TYPE_MMC)
+		return;
+
+	mmc = find_mmc_device(desc->devnum);
+	if (!mmc || !mmc->erase_grp_size)
+		return;
+
+	*discard = mmc->erase_grp_size;
+	if (!IS_SD(mmc) && mmc->esr.mmc_erase_zero)
+		*zero = mmc->erase_grp_size;
+#endif
 }
 
 /******************************************************************************/
 int ext4_unsparse(struct blk_desc *desc, const u8 *buf, ulong start)
 {
 	sparse_header_t *header = (sparse_header_t *)buf;
-	chunk_header_t *chunk = NULL;
-	ulong blk = start;
-	ulong chunk_len;
-	u64 img_size;
-	u32 i, fill;
+	struct ext4_sparse sparse_priv;
+	struct sparse_storage sparse;
+	const char *reason = NULL;
+	u64 written = 0;
+	int ret;
 
 	putc('\n');
 
@@ -151,97 +120,32 @@ int ext4_unsparse(struct blk_desc *desc, const u8 *buf, ulong start)
 		return -EINVAL;
 	}
 
-	print_header_info(header);
-
-	/* check fs img's real size is larger than partition size */
-	img_size = (u64)(header->total_blks * header->blk_sz);
-
-	/* erase area: ensure DONT-CARE is 0 and FILL(0x0) is 0 */
-	if (blk_derase(desc, start, BLOCK_CNT(img_size, desc)) !=
-			BLOCK_CNT(img_size, desc))
-		return -EIO;
-
-	printf("Erase 0x%08lx - 0x%08lx blocks OK.\n\n",
-	       start, start + (ulong)BLOCK_CNT(img_size, desc));
-
-	/* skip the sparse header,to visit first chunk */
-	buf += header->file_hdr_sz;
-
-	/* to visit each chunk */
-	for (i = 0; i < header->total_chunks; i++) {
-		/* here the chunk_header */
-		chunk = (chunk_header_t *)buf;
-
-		/* go to next chunk's data */
-		buf += header->chunk_hdr_sz;
-
-		switch (chunk->chunk_type) {
-		case CHUNK_TYPE_RAW:
-			print_chunk_info(chunk, i, buf, header);
-
-			/* to calculate the length of each chunk */
-			chunk_len = chunk->chunk_sz * header->blk_sz;
-
-			/* verify every chunk to asure it is valid */
-			if (chunk->total_sz
-			    != (chunk_len + header->chunk_hdr_sz)) {
-				printf("No.%d chunk size error.\n", i + 1);
-				return -EINVAL;
-			}
-
-			if (flash_write_data(desc, buf,
-					     blk, BLOCK_CNT(chunk_len, desc)))
-				return -EIO;
-
-			buf += chunk_len;
-			blk += BLOCK_CNT(chunk_len, desc);
-			break;
-		case CHUNK_TYPE_DONT_CARE:
-			print_chunk_info(chunk, i, buf, header);
-
-			if (chunk->total_sz != header->chunk_hdr_sz) {
-				printf("No.%d chunk size error.\n", i + 1);
-				return -EINVAL;
-			}
+	if (start >= desc->lba) {
+		printf("Start block 0x%08lx is out of the device.\n", start);
+		return -EINVAL;
+	}
 
-			chunk_len = chunk->chunk_sz * header->blk_sz;
-			blk += BLOCK_CNT(chunk_len, desc);
-			break;
-		case CHUNK_TYPE_FILL:
-			print_chunk_info(chunk, i, buf, header);
-
-			/* verify every chunk to asure it is valid */
-			if (chunk->total_sz - header->chunk_hdr_sz != 4) {
-				printf("No.%d chunk size error.\n", i);
-				return -EINVAL;
-			}
-
-			/* to calculate the length of each chunk */
-			chunk_len = chunk->chunk_sz * header->blk_sz;
-
-			/* ignore fill value "0", as we have erased yet */
-			fill = *(u32 *)buf;
-			if (fill != 0) {
-				if (flash_fill_data(desc, blk,
-					BLOCK_CNT(chunk_len, desc), fill))
-					return -EIO;
-			}
-			buf += 4;
-			blk += BLOCK_CNT(chunk_len, desc);
-			break;
-		case CHUNK_TYPE_CRC32:
-			print_chunk_info(chunk, i, buf, header);
-			printf("No.%d chunk type CRC32, Cannot handle!\n", i + 1);
-			return -ENOTSUPP;
-		default:
-			printf("sparse: unknown chunk type %04x.\n", chunk->chunk_type);
-			return -ENOTSUPP;
-		}
+	sparse_priv.desc = desc;
+	sparse.blksz = desc->blksz;
+	sparse.start = start;
+	sparse.size = desc->lba - start;
+	sparse.priv = &sparse_priv;
+	sparse.write = ext4_sparse_write;
+	sparse.reserve = ext4_sparse_reserve;
+	sparse.erase = ext4_sparse_erase;
+	ext4_sparse_erase_grp(desc, &sparse_priv.discard_grp,
+			      &sparse.erase_grp);
+
+	ret = sparse_write(&sparse, (void *)buf, &written, &reason);
+	if (ret) {
+		printf("Unsparse failed: %s\n", reason);
+		return ret;
 	}
 
-	printf("\nUnsparsed is %lld MiB and 0x%08lx - 0x%08lx blocks written OK.\n",
-	       img_size >> 20, start, blk);
+	printf("Unsparsed is %lld MiB and 0x%08lx - 0x%08lx blocks written OK.\n",
+	       ((u64)header->total_blks * header->blk_sz) >> 20, start,
+	       start + (ulong)BLOCK_CNT((u64)header->total_blks *
+					header->blk_sz, desc));
 
 	return 0;
 }
-
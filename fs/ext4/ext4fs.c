@@ -51,7 +51,7 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 {
 	struct ext_filesystem *fs = get_fs();
 	int i;
-	lbaint_t blockcnt;
+	lbaint_t blockcnt, run;
 	int log2blksz = fs->dev_desc->log2blksz;
 	int log2_fs_blocksize = LOG2_BLOCK_SIZE(node->data) - log2blksz;
 	int blocksize = (1 << (log2_fs_blocksize + log2blksz));
@@ -73,38 +73,39 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 
 	blockcnt = lldiv(((len + pos) + blocksize - 1), blocksize);
 
-	for (i = lldiv(pos, blocksize); i < blockcnt; i++) {
+	/*
+	 * A run of blocks at a time, a whole extent for extent mapped files,
+	 * and runs that follow each other on disk are read in one go.
+	 */
+	for (i = lldiv(pos, blocksize); i < blockcnt; i += run) {
 		long int blknr;
-		int blockoff = pos - (blocksize * i);
-		int blockend = blocksize;
-		int skipfirst = 0;
-		blknr = read_allocated_block(&(node->inode), i);
+		loff_t start, end;
+		int blockend;
+		int skipfirst;
+
+		/* No more bytes than an int holds, for a long hole */
+		run = min_t(lbaint_t, blockcnt - i, INT_MAX / blocksize);
+		blknr = read_allocated_run(&(node->inode), i, &run);
 		if (blknr < 0)
 			return -1;
 
 		blknr = blknr << log2_fs_blocksize;
 
-		/* Last block.  */
-		if (i == blockcnt - 1) {
-			blockend = (len + pos) - (blocksize * i);
-
-			/* The last portion is exactly blocksize. */
-			if (!blockend)
-				blockend = blocksize;
-		}
+		/* The bytes of the file in the run */
+		start = max_t(loff_t, pos, (loff_t)blocksize * i);
+		end = min_t(loff_t, len + pos, (loff_t)blocksize * (i + run));
+		skipfirst = start - (loff_t)blocksize * i;
+		blockend = end - start;
 
-		/* First block. */
-		if (i == lldiv(pos, blocksize)) {
-			skipfirst = blockoff;
-			blockend -= skipfirst;
-		}
 		if (blknr) {
 			int status;
 
 			if (previous_block_number != -1) {
-				if (delayed_next == blknr) {
+				/* fs_devread() takes an int length */
+				if (delayed_next == blknr &&
+				    delayed_extent <= INT_MAX - blockend) {
 					delayed_extent += blockend;
-					delayed_next += blockend >> log2blksz;
+					delayed_next += run << log2_fs_blocksize;
 				} else {	/* spill */
 					status = ext4fs_devread(delayed_start,
 							delayed_skipfirst,
@@ -118,7 +119,7 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 					delayed_skipfirst = skipfirst;
 					delayed_buf = buf;
 					delayed_next = blknr +
-						(blockend >> log2blksz);
+						(run << log2_fs_blocksize);
 				}
 			} else {
 				previous_block_number = blknr;
@@ -127,10 +128,9 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 				delayed_skipfirst = skipfirst;
 				delayed_buf = buf;
 				delayed_next = blknr +
-					(blockend >> log2blksz);
+					(run << log2_fs_blocksize);
 			}
 		} else {
-			int n;
 			if (previous_block_number != -1) {
 				/* spill */
 				status = ext4fs_devread(delayed_start,
@@ -141,13 +141,10 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 					return -1;
 				previous_block_number = -1;
 			}
-			/* Zero no more than `len' bytes. */
-			n = blocksize - skipfirst;
-			if (n > len)
-				n = len;
-			memset(buf, 0, n);
+			/* Zero the holes, and none of the bytes past `len' */
+			memset(buf, 0, blockend);
 		}
-		buf += blocksize - skipfirst;
+		buf += blockend;
 	}
 	if (previous_block_number != -1) {
 		/* spill */
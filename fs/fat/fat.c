@@ -151,15 +151,99 @@ static void get_name(dir_entry *dirent, char *s_name)
 		*s_name = DELETED_FLAG;
 }
 
-static int flush_dirty_fat_buffer(fsdata *mydata);
-#if !defined(CONFIG_FAT_WRITE)
-/* Stub for read only operation */
-int flush_dirty_fat_buffer(fsdata *mydata)
+/*
+ * Number of FAT entries in 'size' bytes of the table.
+ */
+static __u32 fat_entries(fsdata *mydata, __u32 size)
 {
-	(void)(mydata);
-	return 0;
+	switch (mydata->fatsize) {
+	case 32:
+		return size / 4;
+	case 16:
+		return size / 2;
+	default:
+		return size * 2 / 3;
+	}
+}
+
+/*
+ * Allocate fatbuf and the read cache windows after it.
+ * Return 0 on success, -1 otherwise.
+ */
+static int fat_alloc_fatbuf(fsdata *mydata)
+{
+	int i;
+
+	mydata->fatbufnum = -1;
+	mydata->fat_dirty = 0;
+	for (i = 0; i < FATCACHEWINDOWS; i++) {
+		mydata->fatcachenum[i] = -1;
+		mydata->fatcacheused[i] = 0;
+	}
+	mydata->fatcachetick = 0;
+	mydata->fatbuf = malloc_cache_aligned(FATBUFSIZE +
+					      FATCACHESIZE * FATCACHEWINDOWS);
+
+	return mydata->fatbuf ? 0 : -1;
+}
+
+/*
+ * Drop the read cache window holding FAT sector 'sect', once written.
+ */
+static void __maybe_unused fat_cache_invalidate(fsdata *mydata, __u32 sect)
+{
+	int i;
+
+	for (i = 0; i < FATCACHEWINDOWS; i++) {
+		if (mydata->fatcachenum[i] == (int)(sect / FATCACHEBLOCKS)) {
+			mydata->fatcachenum[i] = -1;
+			mydata->fatcacheused[i] = 0;
+		}
+	}
+}
+
+/*
+ * Get the read cache window holding entry 'entry', and the entry's offset
+ * in it.
+ * Return NULL on failure.
+ */
+static __u8 *fat_cache_window(fsdata *mydata, __u32 entry, __u32 *offset)
+{
+	__u32 per_window = fat_entries(mydata, FATCACHESIZE);
+	__u32 bufnum = entry / per_window;
+	__u32 getsize = FATCACHEBLOCKS;
+	__u32 startblock = bufnum * FATCACHEBLOCKS;
+	__u8 *window;
+	int i, lru = 0;
+
+	*offset = entry - bufnum * per_window;
+	for (i = 0; i < FATCACHEWINDOWS; i++) {
+		if (mydata->fatcachenum[i] == (int)bufnum)
+			goto hit;
+		/* Empty windows were last used at 0 */
+		if (mydata->fatcacheused[i] < mydata->fatcacheused[lru])
+			lru = i;
+	}
+
+	i = lru;
+	window = mydata->fatbuf + FATBUFSIZE + i * FATCACHESIZE;
+
+	/* Cap length if fatlength is not a multiple of FATCACHEBLOCKS */
+	if (startblock + getsize > mydata->fatlength)
+		getsize = mydata->fatlength - startblock;
+
+	mydata->fatcachenum[i] = -1;
+	mydata->fatcacheused[i] = 0;
+	if (disk_read(mydata->fat_sect + startblock, getsize, window) < 0) {
+		debug("Error reading FAT blocks\n");
+		return NULL;
+	}
+	mydata->fatcachenum[i] = bufnum;
+hit:
+	mydata->fatcacheused[i] = ++mydata->fatcachetick;
+
+	return mydata->fatbuf + FATBUFSIZE + i * FATCACHESIZE;
 }
-#endif
 
 /*
  * Get the entry at index 'entry' in a FAT (12/16/32) table.
@@ -170,70 +254,45 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
 	__u32 bufnum;
 	__u32 offset, off8;
 	__u32 ret = 0x00;
+	__u8 *fatbuf;
 
 	if (CHECK_CLUST(entry, mydata->fatsize)) {
 		printf("Error: Invalid FAT entry: 0x%08x\n", entry);
 		return ret;
 	}
 
-	switch (mydata->fatsize) {
-	case 32:
-		bufnum = entry / FAT32BUFSIZE;
-		offset = entry - bufnum * FAT32BUFSIZE;
-		break;
-	case 16:
-		bufnum = entry / FAT16BUFSIZE;
-		offset = entry - bufnum * FAT16BUFSIZE;
-		break;
-	case 12:
-		bufnum = entry / FAT12BUFSIZE;
-		offset = entry - bufnum * FAT12BUFSIZE;
-		break;
-
-	default:
+	if (mydata->fatsize != 32 && mydata->fatsize != 16 &&
+	    mydata->fatsize != 12) {
 		/* Unsupported FAT size */
 		return ret;
 	}
 
-	debug("FAT%d: entry: 0x%08x = %d, offset: 0x%04x = %d\n",
-	       mydata->fatsize, entry, entry, offset, offset);
-
-	/* Read a new block of FAT entries into the cache. */
-	if (bufnum != mydata->fatbufnum) {
-		__u32 getsize = FATBUFBLOCKS;
-		__u8 *bufptr = mydata->fatbuf;
-		__u32 fatlength = mydata->fatlength;
-		__u32 startblock = bufnum * FATBUFBLOCKS;
-
-		/* Cap length if fatlength is not a multiple of FATBUFBLOCKS */
-		if (startblock + getsize > fatlength)
-			getsize = fatlength - startblock;
-
-		startblock += mydata->fat_sect;	/* Offset from start of disk */
-
-		/* Write back the fatbuf to the disk */
-		if (flush_dirty_fat_buffer(mydata) < 0)
-			return -1;
-
-		if (disk_read(startblock, getsize, bufptr) < 0) {
-			debug("Error reading FAT blocks\n");
+	/* The window of fatbuf, when writing, is the one up to date */
+	bufnum = entry / fat_entries(mydata, FATBUFSIZE);
+	if (bufnum == mydata->fatbufnum) {
+		fatbuf = mydata->fatbuf;
+		offset = entry - bufnum * fat_entries(mydata, FATBUFSIZE);
+	} else {
+		fatbuf = fat_cache_window(mydata, entry, &offset);
+		if (!fatbuf)
 			return ret;
-		}
-		mydata->fatbufnum = bufnum;
 	}
 
+	debug("FAT%d: entry: 0x%08x = %d, offset: 0x%04x = %d\n",
+	       mydata->fatsize, entry, entry, offset, offset);
+
 	/* Get the actual entry from the table */
 	switch (mydata->fatsize) {
 	case 32:
-		ret = FAT2CPU32(((__u32 *) mydata->fatbuf)[offset]);
+		ret = FAT2CPU32(((__u32 *)fatbuf)[offset]);
 		break;
 	case 16:
-		ret = FAT2CPU16(((__u16 *) mydata->fatbuf)[offset]);
+		ret = FAT2CPU16(((__u16 *)fatbuf)[offset]);
 		break;
 	case 12:
 		off8 = (offset * 3) / 2;
 		/* fatbut + off8 may be unaligned, read in byte granularity */
-		ret = mydata->fatbuf[off8] + (mydata->fatbuf[off8 + 1] << 8);
+		ret = fatbuf[off8] + (fatbuf[off8 + 1] << 8);
 
 		if (offset & 0x1)
 			ret >>= 4;
@@ -249,6 +308,14 @@ static __u32 get_fatent(fsdata *mydata, __u32 entry)
  * Read at most 'size' bytes from the specified cluster into 'buffer'.
  * Return 0 on success, -1 otherwise.
  */
+/* A run of consecutive clusters of a file */
+struct fat_extent {
+	__u32 clust;
+	__u32 count;
+};
+
+#define FAT_EXTENTS	32
+
 static int
 get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 {
@@ -307,6 +374,48 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 	return 0;
 }
 
+/*
+ * Walk the cluster chain from '*clust' for 'size' bytes, up to 'max' runs
+ * of consecutive clusters into 'extents', before any of them is read.
+ * '*clust' is left at the first cluster of the next run, or 0 if the chain
+ * ended early on an invalid entry.
+ * Return the number of runs.
+ */
+static int get_extents(fsdata *mydata, __u32 *clust, loff_t size,
+		       struct fat_extent *extents, int max)
+{
+	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
+	loff_t need = DIV_ROUND_UP(size, bytesperclust);
+	__u32 endclust = *clust, newclust;
+	int n = 0;
+
+	extents[0].clust = endclust;
+	extents[0].count = 1;
+	while (--need) {
+		newclust = get_fatent(mydata, endclust);
+		if (CHECK_CLUST(newclust, mydata->fatsize)) {
+			debug("curclust: 0x%x\n", newclust);
+			debug("Invalid FAT entry\n");
+			*clust = 0;
+			return n + 1;
+		}
+		if (newclust == endclust + 1) {
+			extents[n].count++;
+		} else {
+			if (++n == max) {
+				*clust = newclust;
+				return n;
+			}
+			extents[n].clust = newclust;
+			extents[n].count = 1;
+		}
+		endclust = newclust;
+	}
+	*clust = endclust;
+
+	return n + 1;
+}
+
 /*
  * Read at most 'maxsize' bytes from 'pos' in the file associated with 'dentptr'
  * into 'buffer'.
@@ -321,8 +430,9 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 	loff_t filesize = FAT2CPU32(dentptr->size);
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
 	__u32 curclust = START(dentptr);
-	__u32 endclust, newclust;
+	struct fat_extent extents[FAT_EXTENTS];
 	loff_t actsize;
+	int i, n;
 
 	*gotsize = 0;
 	debug("Filesize: %llu bytes\n", filesize);
@@ -379,50 +489,28 @@ static int get_contents(fsdata *mydata, dir_entry *dentptr, loff_t pos,
 		}
 	}
 
-	actsize = bytesperclust;
-	endclust = curclust;
-
-	do {
-		/* search for consecutive clusters */
-		while (actsize < filesize) {
-			newclust = get_fatent(mydata, endclust);
-			if ((newclust - 1) != endclust)
-				goto getit;
-			if (CHECK_CLUST(newclust, mydata->fatsize)) {
-				debug("curclust: 0x%x\n", newclust);
-				debug("Invalid FAT entry\n");
-				return 0;
+	while (filesize) {
+		n = get_extents(mydata, &curclust, filesize, extents,
+				FAT_EXTENTS);
+		for (i = 0; i < n; i++) {
+			actsize = min(filesize, (loff_t)extents[i].count *
+				      bytesperclust);
+			if (get_cluster(mydata, extents[i].clust, buffer,
+					actsize) != 0) {
+				printf("Error reading cluster\n");
+				return -1;
 			}
-			endclust = newclust;
-			actsize += bytesperclust;
+			*gotsize += actsize;
+			filesize -= actsize;
+			buffer += actsize;
 		}
-
-		/* get remaining bytes */
-		actsize = filesize;
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
-		}
-		*gotsize += actsize;
-		return 0;
-getit:
-		if (get_cluster(mydata, curclust, buffer, (int)actsize) != 0) {
-			printf("Error reading cluster\n");
-			return -1;
-		}
-		*gotsize += (int)actsize;
-		filesize -= actsize;
-		buffer += actsize;
-
-		curclust = get_fatent(mydata, endclust);
-		if (CHECK_CLUST(curclust, mydata->fatsize)) {
-			debug("curclust: 0x%x\n", curclust);
+		if (filesize && !curclust) {
 			printf("Invalid FAT entry\n");
 			return 0;
 		}
-		actsize = bytesperclust;
-		endclust = curclust;
-	} while (1);
+	}
+
+	return 0;
 }
 
 /*
@@ -597,10 +685,7 @@ static int get_fs_info(fsdata *mydata)
 			sect_to_clust(mydata, mydata->rootdir_sect);
 	}
 
-	mydata->fatbufnum = -1;
-	mydata->fat_dirty = 0;
-	mydata->fatbuf = malloc_cache_aligned(FATBUFSIZE);
-	if (mydata->fatbuf == NULL) {
+	if (fat_alloc_fatbuf(mydata) < 0) {
 		debug("Error: allocating memory\n");
 		return -1;
 	}
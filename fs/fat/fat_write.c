@@ -121,6 +121,8 @@ static int flush_dirty_fat_buffer(fsdata *mydata)
 	if (startblock + getsize > fatlength)
 		getsize = fatlength - startblock;
 
+	/* Reads of these entries would otherwise see the old ones */
+	fat_cache_invalidate(mydata, startblock);
 	startblock += mydata->fat_sect;
 
 	/* Write FAT buf */
@@ -956,10 +958,7 @@ static int do_fat_write(const char *filename, void *buffer, loff_t size,
 					(mydata->clust_size * 2);
 	}
 
-	mydata->fatbufnum = -1;
-	mydata->fat_dirty = 0;
-	mydata->fatbuf = memalign(ARCH_DMA_MINALIGN, FATBUFSIZE);
-	if (mydata->fatbuf == NULL) {
+	if (fat_alloc_fatbuf(mydata) < 0) {
 		debug("Error: allocating memory\n");
 		return -1;
 	}
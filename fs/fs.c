@@ -10,6 +10,7 @@
 #include <mapmem.h>
 #include <part.h>
 #include <ext4fs.h>
+#include <erofs.h>
 #include <fat.h>
 #include <fs.h>
 #include <sandboxfs.h>
@@ -218,6 +219,24 @@ static struct fstype_info fstypes[] = {
 		.uuid = fs_uuid_unsupported,
 		.opendir = fs_opendir_unsupported,
 	},
+#endif
+#ifdef CONFIG_FS_EROFS
+	{
+		.fstype = FS_TYPE_EROFS,
+		.name = "erofs",
+		.null_dev_desc_ok = false,
+		.probe = erofs_probe,
+		.close = erofs_close,
+		.ls = fs_ls_generic,
+		.exists = erofs_exists,
+		.size = erofs_size,
+		.read = erofs_read,
+		.write = fs_write_unsupported,
+		.uuid = erofs_uuid,
+		.opendir = erofs_opendir,
+		.readdir = erofs_readdir,
+		.closedir = erofs_closedir,
+	},
 #endif
 	{
 		.fstype = FS_TYPE_ANY,
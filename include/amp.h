@@ -31,5 +31,72 @@
 int amp_cpus_on(void);
 int arm64_switch_amp_pe(bootm_headers_t *images);
 
+struct spl_image_info;
+
+#ifdef CONFIG_SPL_ROCKCHIP_AMP
+/**
+ * amp_handoff_wanted() - check whether SPL should load an amp.img image
+ *
+ * Firmwares for non-boot cpus which are to be booted are, other images are
+ * left to U-Boot.
+ *
+ * @fit:	amp.img
+ * @node:	image node
+ * @return true if SPL should load the image and pass it on
+ */
+bool amp_handoff_wanted(const void *fit, int node);
+
+/**
+ * amp_handoff_add() - note an image SPL has loaded and verified
+ *
+ * @fit:	amp.img
+ * @node:	image node
+ * @image:	where the image was loaded
+ */
+void amp_handoff_add(const void *fit, int node, struct spl_image_info *image);
+
+/**
+ * amp_handoff_set_atags() - pass the loaded images on in ATAG_AMP
+ *
+ * @return 0 if OK, -ve on error
+ */
+int amp_handoff_set_atags(void);
+
+/**
+ * amp_handoff_cpus_on() - start the cpus whose images SPL has loaded
+ *
+ * This is run before relocation and has no console.
+ */
+void amp_handoff_cpus_on(void);
+
+/**
+ * amp_handoff_reserve() - reserve the memory of the cpus which are up
+ *
+ * @return 0 if OK, -ve on error
+ */
+int amp_handoff_reserve(void);
+
+/**
+ * amp_handoff_cpu() - check whether a cpu was started from SPL's handoff
+ *
+ * @cpu:	mpidr
+ * @return 0 if the cpu is up, -EIO if it failed to start, -ENOENT if SPL
+ * did not load its image
+ */
+int amp_handoff_cpu(u32 cpu);
+#else
+static inline bool amp_handoff_wanted(const void *fit, int node)
+{
+	return false;
+}
+
+static inline void amp_handoff_add(const void *fit, int node,
+				   struct spl_image_info *image) { }
+static inline int amp_handoff_set_atags(void) { return 0; }
+static inline void amp_handoff_cpus_on(void) { }
+static inline int amp_handoff_reserve(void) { return 0; }
+static inline int amp_handoff_cpu(u32 cpu) { return -ENOENT; }
+#endif
+
 #endif	/* _AMP_H_ */
 
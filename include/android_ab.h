@@ -47,7 +47,69 @@ int android_ab_select(struct blk_desc *dev_desc, disk_partition_t *part_info);
 int read_misc_virtual_ab_message(struct misc_virtual_ab_message *message);
 int write_misc_virtual_ab_message(struct misc_virtual_ab_message *message);
 
-void ab_update_root_partition(void);
+/**
+ * android_misc_read() - Read from the cached head of misc
+ *
+ * The head of misc, up to the end of the virtual A/B message, is read from
+ * @dev_desc at first use and kept until android_misc_invalidate().
+ *
+ * @dev_desc: device of the misc partition
+ * @part_info: misc partition
+ * @offset: byte offset in misc
+ * @size: number of bytes
+ * @buf: buffer to read to
+ * @return 0 on success, otherwise negative errno
+ */
+int android_misc_read(struct blk_desc *dev_desc,
+		      const disk_partition_t *part_info,
+		      ulong offset, size_t size, void *buf);
+
+/**
+ * android_misc_write() - Write to the cached head of misc
+ *
+ * The cache is updated and the changed blocks are written through to the
+ * device, block cache included, before this returns.
+ *
+ * @dev_desc: device of the misc partition
+ * @part_info: misc partition
+ * @offset: byte offset in misc
+ * @size: number of bytes
+ * @buf: buffer to write from
+ * @return 0 on success, otherwise negative errno
+ */
+int android_misc_write(struct blk_desc *dev_desc,
+		       const disk_partition_t *part_info,
+		       ulong offset, size_t size, const void *buf);
+
+#if CONFIG_IS_ENABLED(ANDROID_AB)
+/**
+ * android_misc_flush() - Write the changes to the cached misc back
+ *
+ * Only has something to do if a write through android_misc_write() failed.
+ *
+ * @return 0 on success, otherwise negative errno
+ */
+int android_misc_flush(void);
+
+/**
+ * android_misc_invalidate() - Write back and drop the cached misc
+ *
+ * Call it before misc is written other than by android_misc_write(), e.g.
+ * when it is flashed.
+ */
+void android_misc_invalidate(void);
+#else
+static inline int android_misc_flush(void)
+{
+	return 0;
+}
+
+static inline void android_misc_invalidate(void) {}
+#endif
+
+struct cmdline;
+
+void ab_update_root_partition(struct cmdline *cl);
 int ab_get_slot_suffix(char *slot_suffix);
 int ab_is_support_dynamic_partition(struct blk_desc *dev_desc);
 int ab_decrease_tries(void);
@@ -157,6 +157,44 @@ struct AvbOps {
                                          size_t* out_num_bytes_preloaded,
                                          int allow_verification_error);
 
+  /* Like |get_preloaded_partition|, but also calculates the digest of
+   * |salt| followed by the first |num_bytes| of the partition using
+   * |hash_algorithm| ("sha256" or "sha512"), so that an implementation can
+   * hash the data while it is still being read from storage.
+   *
+   * On success the digest is returned in |out_digest|, which must have room
+   * for AVB_SHA512_DIGEST_SIZE bytes, and its length in |out_digest_len|.
+   *
+   * When this function pointer is not set (has value NULL), or when the
+   * |out_pointer| is set to NULL as a result, |get_preloaded_partition| and
+   * a separate hash pass are used as the fallback.
+   */
+  AvbIOResult (*get_preloaded_partition_hash)(AvbOps* ops,
+                                              const char* partition,
+                                              size_t num_bytes,
+                                              const char* hash_algorithm,
+                                              const uint8_t* salt,
+                                              size_t salt_len,
+                                              uint8_t** out_pointer,
+                                              size_t* out_num_bytes_preloaded,
+                                              uint8_t* out_digest,
+                                              size_t* out_digest_len);
+
+  /* Announces that |get_preloaded_partition_hash| is about to be called for
+   * |partition| with the same arguments. All hash partitions of a vbmeta
+   * image are announced before the first of them is verified, so that an
+   * implementation can load and hash them at the same time. Errors are left
+   * to the later |get_preloaded_partition_hash| call to report.
+   *
+   * This function pointer can be NULL.
+   */
+  void (*prefetch_partition_hash)(AvbOps* ops,
+                                  const char* partition,
+                                  size_t num_bytes,
+                                  const char* hash_algorithm,
+                                  const uint8_t* salt,
+                                  size_t salt_len);
+
   /* Writes |num_bytes| from |bffer| at offset |offset| to partition
    * with name |partition| (NUL-terminated UTF-8 string). If |offset|
    * is negative, its absolute value should be interpreted as the
@@ -66,6 +66,7 @@ void avb_ops_user_free(AvbOps* ops);
 struct preloaded_partition {
 	uint8_t *addr;
 	size_t size; // 0 means the partition hasn't yet been preloaded
+	size_t max; // room at addr, 0 means unknown
 };
 
 struct AvbOpsData {
@@ -0,0 +1,146 @@
+/* SPDX-License-Identifier:     GPL-2.0+ */
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ */
+
+#ifndef _ARENA_H
+#define _ARENA_H
+
+/*
+ * Allocators for transient buffers on hot paths, carved once from sysmem
+ * so that they neither fragment the malloc pool nor pay for its bins.
+ *
+ * An arena hands out buffers by bumping a pointer and takes all of them
+ * back at once with arena_reset(). A slab hands out and takes back
+ * buffers of one fixed size. Both return ARCH_DMA_MINALIGN aligned
+ * buffers.
+ */
+
+struct arena {
+	const char *name;
+	void *base;
+	size_t size;
+	size_t used;
+};
+
+struct slab {
+	const char *name;
+	void *base;
+	size_t obj_size;
+	uint count;
+	void *free;	/* free list, linked through the objects */
+};
+
+#if CONFIG_IS_ENABLED(ARENA)
+/**
+ * arena_create() - Create an arena
+ *
+ * @name: sysmem region name, must be unique
+ * @size: arena size
+ *
+ * @return NULL on error, otherwise the arena
+ */
+struct arena *arena_create(const char *name, size_t size);
+
+/**
+ * arena_alloc() - Alloc a buffer from an arena
+ *
+ * @arena: arena
+ * @size: buffer size
+ *
+ * @return NULL if the arena is full, otherwise the buffer
+ */
+void *arena_alloc(struct arena *arena, size_t size);
+
+/**
+ * arena_reset() - Free all buffers allocated from an arena
+ *
+ * @arena: arena
+ */
+void arena_reset(struct arena *arena);
+
+/**
+ * arena_owns() - Does a buffer come from an arena
+ *
+ * @arena: arena, may be NULL
+ * @buf: buffer
+ *
+ * @return true or false
+ */
+bool arena_owns(struct arena *arena, void *buf);
+
+/**
+ * slab_create() - Create a slab
+ *
+ * @name: sysmem region name, must be unique
+ * @obj_size: size of each buffer
+ * @count: number of buffers
+ *
+ * @return NULL on error, otherwise the slab
+ */
+struct slab *slab_create(const char *name, size_t obj_size, uint count);
+
+/**
+ * slab_alloc() - Alloc a buffer from a slab
+ *
+ * @slab: slab
+ *
+ * @return NULL if all buffers are in use, otherwise the buffer
+ */
+void *slab_alloc(struct slab *slab);
+
+/**
+ * slab_free() - Give a buffer back to its slab
+ *
+ * @slab: slab
+ * @buf: buffer from slab_alloc()
+ */
+void slab_free(struct slab *slab, void *buf);
+
+/**
+ * slab_owns() - Does a buffer come from a slab
+ *
+ * @slab: slab, may be NULL
+ * @buf: buffer
+ *
+ * @return true or false
+ */
+bool slab_owns(struct slab *slab, void *buf);
+#else
+static inline struct arena *arena_create(const char *name, size_t size)
+{
+	return NULL;
+}
+
+static inline void *arena_alloc(struct arena *arena, size_t size)
+{
+	return NULL;
+}
+
+static inline void arena_reset(struct arena *arena) {}
+
+static inline bool arena_owns(struct arena *arena, void *buf)
+{
+	return false;
+}
+
+static inline struct slab *slab_create(const char *name, size_t obj_size,
+				       uint count)
+{
+	return NULL;
+}
+
+static inline void *slab_alloc(struct slab *slab)
+{
+	return NULL;
+}
+
+static inline void slab_free(struct slab *slab, void *buf) {}
+
+static inline bool slab_owns(struct slab *slab, void *buf)
+{
+	return false;
+}
+#endif /* CONFIG_ARENA */
+
+#endif /* _ARENA_H */
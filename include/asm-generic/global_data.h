@@ -151,6 +151,7 @@ typedef struct global_data {
 #ifdef CONFIG_PSTORE
 	u64 pstore_addr;
 	u32 pstore_size;
+	u32 pstore_written;		/* Bytes this stage put in it */
 #endif
 } gd_t;
 #endif
@@ -185,6 +186,8 @@ typedef struct global_data {
 #ifdef CONFIG_ARCH_ROCKCHIP
 /* BL32 is enabled */
 #define GD_FLG_BL32_ENABLED	0x20000
+/* A quiet console (CONFIG_CONSOLE_QUIET) shows everything */
+#define GD_FLG_CONSOLE_VERBOSE	0x40000
 #endif
 
 #endif /* __ASM_GENERIC_GBL_DATA_H */
@@ -13,6 +13,7 @@ typedef struct memblock *(*parse_fn_t)(int *);
 struct bidram {
 	struct lmb lmb;
 	struct list_head reserved_head;
+	struct memblk_tree reserved_tree;
 	bool has_init;
 	bool fixup;
 	u64 base_u64[MEM_RESV_COUNT]; /* 4GB+ */
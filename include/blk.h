@@ -66,6 +66,28 @@ enum sig_type {
 	SIG_TYPE_COUNT			/* Number of signature types */
 };
 
+enum blk_stats_op {
+	BLK_STATS_READ,
+	BLK_STATS_WRITE,
+	BLK_STATS_ERASE,
+
+	BLK_STATS_OPS,
+};
+
+#if CONFIG_IS_ENABLED(BLK_STATS)
+/* Request sizes up to 4 KiB, 16 KiB, ... 4 MiB, and larger */
+#define BLK_STATS_BUCKETS	7
+
+/* What the device itself was asked to do, block cache hits not included */
+struct blk_op_stats {
+	ulong		ops;
+	u64		blocks;
+	u64		time_us;
+	ulong		max_us;
+	ulong		hist[BLK_STATS_BUCKETS];
+};
+#endif
+
 /*
  * With driver model (CONFIG_BLK) this is uclass platform data, accessible
  * with dev_get_uclass_platdata(dev)
@@ -102,6 +124,9 @@ struct blk_desc {
 		uint32_t mbr_sig;	/* MBR integer signature */
 		efi_guid_t guid_sig;	/* GPT GUID Signature */
 	};
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+	struct part_cache *part_cache;	/* parsed partition table */
+#endif
 #if CONFIG_IS_ENABLED(BLK)
 	/*
 	 * For now we have a few functions which take struct blk_desc as a
@@ -109,6 +134,10 @@ struct blk_desc {
 	 * device. Once these functions are removed we can drop this field.
 	 */
 	struct udevice *bdev;
+	uint		write_gen;	/* bumped by each write and erase */
+#if CONFIG_IS_ENABLED(BLK_STATS)
+	struct blk_op_stats stats[BLK_STATS_OPS];
+#endif
 #else
 	unsigned long	(*block_read)(struct blk_desc *block_dev,
 				      lbaint_t start,
@@ -129,6 +158,13 @@ struct blk_desc {
 #define PAD_TO_BLOCKSIZE(size, blk_desc) \
 	(PAD_SIZE(size, blk_desc->blksz))
 
+/* Raw device read, as used by blkcache_dread() on a cache miss */
+typedef ulong (*blkcache_read_t)(struct blk_desc *block_dev, lbaint_t start,
+				 lbaint_t blkcnt, void *buffer);
+/* Raw device write, as used by blkcache_dwrite() and on flush */
+typedef ulong (*blkcache_write_t)(struct blk_desc *block_dev, lbaint_t start,
+				  lbaint_t blkcnt, const void *buffer);
+
 #ifdef CONFIG_BLOCK_CACHE
 /**
  * blkcache_read() - attempt to read a set of blocks from cache
@@ -162,6 +198,92 @@ void blkcache_fill(int iftype, int dev,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer);
 
+/**
+ * blkcache_dread() - read blocks through the block cache
+ *
+ * Serves the request from the cache if possible. On a miss, small requests
+ * are widened to whole cache entries, plus a read-ahead window which grows
+ * while the device is read sequentially, and the result is cached.
+ *
+ * @param block_dev - block device to read from
+ * @param start - starting block number
+ * @param blkcnt - number of blocks to read
+ * @param buffer - destination buffer
+ * @param read - function doing the actual device read
+ *
+ * @return - number of blocks read
+ */
+ulong blkcache_dread(struct blk_desc *block_dev, lbaint_t start,
+		     lbaint_t blkcnt, void *buffer, blkcache_read_t read);
+
+/**
+ * blkcache_dwrite() - write blocks through the block cache
+ *
+ * Cached reads of the written range are dropped. With
+ * CONFIG_BLOCK_CACHE_WRITEBACK small writes are only recorded, merged with
+ * adjacent pending writes, and sent to the device by blkcache_flush().
+ *
+ * @param block_dev - block device to write to
+ * @param start - starting block number
+ * @param blkcnt - number of blocks to write
+ * @param buffer - data to write
+ * @param write - function doing the actual device write
+ *
+ * @return - number of blocks written (or accepted for write-back)
+ */
+ulong blkcache_dwrite(struct blk_desc *block_dev, lbaint_t start,
+		      lbaint_t blkcnt, const void *buffer,
+		      blkcache_write_t write);
+
+#ifdef CONFIG_BLOCK_CACHE_WRITEBACK
+/**
+ * blkcache_dirty() - check for pending writes in a range of blocks
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ * @param start - starting block number
+ * @param blkcnt - number of blocks
+ *
+ * @return - true if any block in the range has not been written back yet
+ */
+bool blkcache_dirty(int iftype, int dev, lbaint_t start, lbaint_t blkcnt);
+
+/**
+ * blkcache_flush() - write back the pending writes of a device
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ *
+ * @return - 0 if OK, -EIO if a write failed (the data is dropped anyway)
+ */
+int blkcache_flush(int iftype, int dev);
+
+/**
+ * blkcache_flush_all() - write back the pending writes of all devices
+ *
+ * Called before booting an OS or resetting.
+ *
+ * @return - 0 if OK, -EIO if a write failed
+ */
+int blkcache_flush_all(void);
+#else
+static inline bool blkcache_dirty(int iftype, int dev, lbaint_t start,
+				  lbaint_t blkcnt)
+{
+	return false;
+}
+
+static inline int blkcache_flush(int iftype, int dev)
+{
+	return 0;
+}
+
+static inline int blkcache_flush_all(void)
+{
+	return 0;
+}
+#endif
+
 /**
  * blkcache_invalidate() - discard the cache for a set of blocks
  * because of a write or device (re)initialization.
@@ -174,20 +296,29 @@ void blkcache_invalidate(int iftype, int dev);
 /**
  * blkcache_configure() - configure block cache
  *
- * @param blocks - maximum blocks per entry
+ * @param blocks - blocks per entry, entries are aligned to this on the device
  * @param entries - maximum entries in cache
  */
 void blkcache_configure(unsigned blocks, unsigned entries);
 
+/**
+ * blkcache_set_read_ahead() - configure sequential read-ahead
+ *
+ * @param lines - maximum number of entries read ahead, 0 to disable
+ */
+void blkcache_set_read_ahead(unsigned lines);
+
 /*
  * statistics of the block cache
  */
 struct block_cache_stats {
 	unsigned hits;
 	unsigned misses;
+	unsigned prefetched; /* blocks read ahead of a request */
 	unsigned entries; /* current entry count */
 	unsigned max_blocks_per_entry;
 	unsigned max_entries;
+	unsigned read_ahead; /* maximum entries read ahead */
 };
 
 /**
@@ -197,6 +328,28 @@ struct block_cache_stats {
  */
 void blkcache_stats(struct block_cache_stats *stats);
 
+/**
+ * blkcache_dev_stats() - return statistics of one device
+ *
+ * The counters are reset by blkcache_stats().
+ *
+ * @param iftype - IF_TYPE_x for type of device
+ * @param dev - device index of particular type
+ * @param stats - statistics are copied here
+ *
+ * @return - 0 if OK, -ENOENT if the device has not been read yet
+ */
+int blkcache_dev_stats(int iftype, int dev, struct block_cache_stats *stats);
+
+/**
+ * blkcache_for_each_dev() - call a function for each device seen by the cache
+ *
+ * @param func - function to call
+ * @param priv - passed to @func
+ */
+void blkcache_for_each_dev(void (*func)(int iftype, int dev, void *priv),
+			   void *priv);
+
 #else
 
 static inline int blkcache_read(int iftype, int dev,
@@ -212,8 +365,49 @@ static inline void blkcache_fill(int iftype, int dev,
 
 static inline void blkcache_invalidate(int iftype, int dev) {}
 
+static inline ulong blkcache_dread(struct blk_desc *block_dev, lbaint_t start,
+				   lbaint_t blkcnt, void *buffer,
+				   blkcache_read_t read)
+{
+	return read(block_dev, start, blkcnt, buffer);
+}
+
+static inline ulong blkcache_dwrite(struct blk_desc *block_dev,
+				    lbaint_t start, lbaint_t blkcnt,
+				    const void *buffer, blkcache_write_t write)
+{
+	return write(block_dev, start, blkcnt, buffer);
+}
+
+static inline bool blkcache_dirty(int iftype, int dev, lbaint_t start,
+				  lbaint_t blkcnt)
+{
+	return false;
+}
+
+static inline int blkcache_flush(int iftype, int dev)
+{
+	return 0;
+}
+
+static inline int blkcache_flush_all(void)
+{
+	return 0;
+}
+
 #endif
 
+/**
+ * struct blk_sg - One segment of a scatter-gather read
+ *
+ * @buf:	Destination buffer for this segment
+ * @blkcnt:	Number of blocks to read into @buf
+ */
+struct blk_sg {
+	void *buf;
+	lbaint_t blkcnt;
+};
+
 #if CONFIG_IS_ENABLED(BLK)
 struct udevice;
 
@@ -275,6 +469,48 @@ struct blk_ops {
 	 * @return 0 if OK, -ve on error
 	 */
 	int (*select_hwpart)(struct udevice *dev, int hwpart);
+
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+	/**
+	 * read_async() - start reading from a block device
+	 *
+	 * The transfer is started and the function returns without waiting
+	 * for the data to arrive. The buffer must not be accessed until
+	 * wait() has returned. Only one read may be outstanding at a time.
+	 *
+	 * @dev:	Device to read from
+	 * @start:	Start block number to read (0=first)
+	 * @blkcnt:	Number of blocks to read
+	 * @buffer:	Destination buffer for data read
+	 * @return number of blocks queued (may be less than @blkcnt), or
+	 * -ve error number (see the IS_ERR_VALUE() macro)
+	 */
+	unsigned long (*read_async)(struct udevice *dev, lbaint_t start,
+				    lbaint_t blkcnt, void *buffer);
+
+	/**
+	 * wait() - wait for an outstanding read_async() to complete
+	 *
+	 * @dev:	Device to wait for
+	 * @return 0 if OK (or nothing was outstanding), -ve on error
+	 */
+	int (*wait)(struct udevice *dev);
+#endif
+
+#if CONFIG_IS_ENABLED(BLK_READ_SG)
+	/**
+	 * read_sg() - read consecutive blocks into a list of buffers
+	 *
+	 * @dev:	Device to read from
+	 * @start:	Start block number to read (0=first)
+	 * @sg:		Segments to fill, in block order
+	 * @nsegs:	Number of segments in @sg
+	 * @return total number of blocks read, or -ve error number (see the
+	 * IS_ERR_VALUE() macro)
+	 */
+	unsigned long (*read_sg)(struct udevice *dev, lbaint_t start,
+				 const struct blk_sg *sg, int nsegs);
+#endif
 };
 
 #define blk_get_ops(dev)	((struct blk_ops *)(dev)->driver->ops)
@@ -292,6 +528,122 @@ unsigned long blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 			 lbaint_t blkcnt);
 
+/**
+ * blk_flush() - write back data held by the block cache
+ *
+ * Only has an effect with CONFIG_BLOCK_CACHE_WRITEBACK, where small writes
+ * are kept in memory until flushed.
+ *
+ * @block_dev:	Block device to flush
+ * @return 0 if OK, -ve on error
+ */
+static inline int blk_flush(struct blk_desc *block_dev)
+{
+	return blkcache_flush(block_dev->if_type, block_dev->devnum);
+}
+
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+/**
+ * blk_dread_async() - start reading blocks without waiting for the data
+ *
+ * This queues a read on the device and returns as soon as the transfer has
+ * been started, so that the caller can do something useful (e.g. hash the
+ * previous chunk) while the data arrives. Call blk_wait() before touching
+ * @buffer. If the device does not support asynchronous reads this is the
+ * same as blk_dread().
+ *
+ * @block_dev:	Block device to read from
+ * @start:	Start block number to read (0=first)
+ * @blkcnt:	Number of blocks to read
+ * @buffer:	Destination buffer for data read
+ * @return number of blocks queued, which may be less than @blkcnt if the
+ * device limits the size of a single transfer, or -ve on error
+ */
+unsigned long blk_dread_async(struct blk_desc *block_dev, lbaint_t start,
+			      lbaint_t blkcnt, void *buffer);
+
+/**
+ * blk_wait() - wait for the read started by blk_dread_async() to finish
+ *
+ * @block_dev:	Block device to wait for
+ * @return 0 if OK (or no read was outstanding), -ve on error
+ */
+int blk_wait(struct blk_desc *block_dev);
+#else
+static inline unsigned long blk_dread_async(struct blk_desc *block_dev,
+					    lbaint_t start, lbaint_t blkcnt,
+					    void *buffer)
+{
+	return blk_dread(block_dev, start, blkcnt, buffer);
+}
+
+static inline int blk_wait(struct blk_desc *block_dev)
+{
+	return 0;
+}
+#endif
+
+#if CONFIG_IS_ENABLED(BLK_READ_SG)
+/**
+ * blk_dread_sg() - read consecutive blocks into several buffers
+ *
+ * The blocks starting at @start are spread over the segments in @sg, so
+ * that e.g. the kernel, ramdisk and dtb of a boot image can each be read to
+ * their final load address without staging the image and copying it. The
+ * device reads everything in as few transfers as it can; if it does not
+ * support scatter-gather, each segment is read with blk_dread().
+ *
+ * @block_dev:	Block device to read from
+ * @start:	Start block number to read (0=first)
+ * @sg:		Segments to fill, in block order
+ * @nsegs:	Number of segments in @sg
+ * @return total number of blocks read
+ */
+unsigned long blk_dread_sg(struct blk_desc *block_dev, lbaint_t start,
+			   const struct blk_sg *sg, int nsegs);
+#else
+static inline unsigned long blk_dread_sg(struct blk_desc *block_dev,
+					 lbaint_t start,
+					 const struct blk_sg *sg, int nsegs)
+{
+	unsigned long total = 0;
+	int i;
+
+	for (i = 0; i < nsegs; i++) {
+		if (blk_dread(block_dev, start + total, sg[i].blkcnt,
+			      sg[i].buf) != sg[i].blkcnt)
+			break;
+		total += sg[i].blkcnt;
+	}
+
+	return total;
+}
+#endif
+
+#if CONFIG_IS_ENABLED(BLK_STATS)
+/**
+ * blk_stats_show() - print the I/O done by each block device
+ *
+ * Lists the requests, data, time and request sizes of the reads, writes
+ * and erases sent to each device since boot or the last blk_stats_reset().
+ */
+void blk_stats_show(void);
+
+/**
+ * blk_stats_reset() - clear the I/O counters of all block devices
+ */
+void blk_stats_reset(void);
+
+/**
+ * blk_stats_bootstage() - print the I/O time of each device for bootstage
+ *
+ * For the accumulated time section of bootstage_report(), in its format.
+ *
+ * @digits:	column width of the times
+ */
+void blk_stats_bootstage(int digits);
+#endif
+
 /**
  * blk_find_device() - Find a block device
  *
@@ -435,29 +787,20 @@ int blk_get_from_parent(struct udevice *parent, struct udevice **devp);
 static inline ulong blk_dread(struct blk_desc *block_dev, lbaint_t start,
 			      lbaint_t blkcnt, void *buffer)
 {
-	ulong blks_read;
-	if (blkcache_read(block_dev->if_type, block_dev->devnum,
-			  start, blkcnt, block_dev->blksz, buffer))
-		return blkcnt;
-
 	/*
 	 * We could check if block_read is NULL and return -ENOSYS. But this
 	 * bloats the code slightly (cause some board to fail to build), and
 	 * it would be an error to try an operation that does not exist.
 	 */
-	blks_read = block_dev->block_read(block_dev, start, blkcnt, buffer);
-	if (blks_read == blkcnt)
-		blkcache_fill(block_dev->if_type, block_dev->devnum,
-			      start, blkcnt, block_dev->blksz, buffer);
-
-	return blks_read;
+	return blkcache_dread(block_dev, start, blkcnt, buffer,
+			      block_dev->block_read);
 }
 
 static inline ulong blk_dwrite(struct blk_desc *block_dev, lbaint_t start,
 			       lbaint_t blkcnt, const void *buffer)
 {
-	blkcache_invalidate(block_dev->if_type, block_dev->devnum);
-	return block_dev->block_write(block_dev, start, blkcnt, buffer);
+	return blkcache_dwrite(block_dev, start, blkcnt, buffer,
+			       block_dev->block_write);
 }
 
 static inline ulong blk_derase(struct blk_desc *block_dev, lbaint_t start,
@@ -467,6 +810,11 @@ static inline ulong blk_derase(struct blk_desc *block_dev, lbaint_t start,
 	return block_dev->block_erase(block_dev, start, blkcnt);
 }
 
+static inline int blk_flush(struct blk_desc *block_dev)
+{
+	return blkcache_flush(block_dev->if_type, block_dev->devnum);
+}
+
 /**
  * struct blk_driver - Driver for block interface types
  *
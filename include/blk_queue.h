@@ -0,0 +1,137 @@
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ *
+ * Common request layer for block transports that can keep several commands
+ * outstanding: it splits a read or write into requests of the size the
+ * device takes, bounces unaligned buffers and keeps up to the queue depth
+ * of them in flight, so a driver only has to submit and complete them.
+ */
+
+#ifndef __BLK_QUEUE_H
+#define __BLK_QUEUE_H
+
+#include <blk.h>
+#include <bouncebuf.h>
+
+#define BLK_QUEUE_MAX_DEPTH	32
+
+/**
+ * struct blk_rq - one command of a transfer
+ *
+ * @start:	First block
+ * @blkcnt:	Number of blocks, at most the max_blocks of the queue
+ * @buffer:	Data, aligned for DMA
+ * @write:	true to write @buffer, false to read into it
+ * @tag:	Index in the queue, 0 to depth - 1, for the driver to keep its
+ *		per-command resources (PRP list, descriptor, slot) by
+ * @error:	Set by the driver's complete(), 0 if the command succeeded
+ */
+struct blk_rq {
+	lbaint_t start;
+	lbaint_t blkcnt;
+	void *buffer;
+	bool write;
+	int tag;
+	int error;
+};
+
+struct blk_queue;
+
+/**
+ * struct blk_rq_ops - what a transport implements for a queue
+ */
+struct blk_rq_ops {
+	/**
+	 * submit() - start a request and return without waiting for it
+	 *
+	 * @dev:	Block device
+	 * @rq:		Request, its tag is free
+	 * @return 0 if it was started, -ve if it could not be
+	 */
+	int (*submit)(struct udevice *dev, struct blk_rq *rq);
+
+	/**
+	 * complete() - wait for one of the submitted requests to finish
+	 *
+	 * Requests may finish in any order. The driver sets the error of
+	 * the request that finished.
+	 *
+	 * @dev:	Block device
+	 * @q:		Queue the requests were submitted on
+	 * @return tag of the request that finished, or -ve if none did in
+	 * time, after which all outstanding requests count as failed
+	 */
+	int (*complete)(struct udevice *dev, struct blk_queue *q);
+};
+
+/**
+ * struct blk_queue - requests of a device in flight
+ *
+ * @ops:	Transport operations
+ * @depth:	Most requests in flight, at most BLK_QUEUE_MAX_DEPTH
+ * @max_blocks:	Most blocks in one request
+ * @busy:	Bit mask of the tags in flight
+ * @rq:		The requests, indexed by tag
+ * @bb:		Bounce buffer of the read started by blk_queue_read_async()
+ * @async:	A read started by blk_queue_read_async() is outstanding
+ */
+struct blk_queue {
+	const struct blk_rq_ops *ops;
+	uint depth;
+	lbaint_t max_blocks;
+	u32 busy;
+	struct blk_rq rq[BLK_QUEUE_MAX_DEPTH];
+	struct bounce_buffer bb;
+	bool async;
+};
+
+/**
+ * blk_queue_init() - set a queue up
+ *
+ * @q:		Queue to set up
+ * @ops:	Transport operations
+ * @depth:	Most requests in flight, clamped to 1..BLK_QUEUE_MAX_DEPTH
+ * @max_blocks:	Most blocks in one request
+ */
+void blk_queue_init(struct blk_queue *q, const struct blk_rq_ops *ops,
+		    uint depth, lbaint_t max_blocks);
+
+/**
+ * blk_queue_rw() - read or write blocks through a queue
+ *
+ * Use from the read and write operations of a block driver.
+ *
+ * @dev:	Block device
+ * @q:		Queue of the device
+ * @start:	First block
+ * @blkcnt:	Number of blocks
+ * @buffer:	Data, any alignment
+ * @write:	true to write, false to read
+ * @return number of blocks from @start transferred before the first
+ * failed request, or -ve error number
+ */
+ulong blk_queue_rw(struct udevice *dev, struct blk_queue *q, lbaint_t start,
+		   lbaint_t blkcnt, void *buffer, bool write);
+
+/**
+ * blk_queue_read_async() - start a read without waiting for it
+ *
+ * Submits as many requests as the queue takes and returns, for the
+ * read_async() block operation. An unaligned @buffer is read into a bounce
+ * buffer, which blk_queue_wait() copies from.
+ *
+ * @return number of blocks queued, or -ve error number
+ */
+ulong blk_queue_read_async(struct udevice *dev, struct blk_queue *q,
+			   lbaint_t start, lbaint_t blkcnt, void *buffer);
+
+/**
+ * blk_queue_wait() - wait for the read of blk_queue_read_async()
+ *
+ * @return 0 if OK or nothing was outstanding, -EIO if a request failed
+ */
+int blk_queue_wait(struct udevice *dev, struct blk_queue *q);
+
+#endif
@@ -205,6 +205,10 @@ enum bootstage_id {
 	BOOTSTATE_ID_ACCUM_DM_SPL,
 	BOOTSTATE_ID_ACCUM_DM_F,
 	BOOTSTATE_ID_ACCUM_DM_R,
+	BOOTSTAGE_ID_ACCUM_READ,	/* Block device reads */
+	BOOTSTAGE_ID_ACCUM_VERIFY,	/* AVB or FIT verification */
+	BOOTSTAGE_ID_ACCUM_FDT_FIXUP,	/* Kernel device tree fixups */
+	BOOTSTAGE_ID_BOOT_FLOW,		/* Android or FIT boot flow starts */
 
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
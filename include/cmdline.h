@@ -0,0 +1,104 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Kernel command line builder
+ *
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ */
+
+#ifndef __CMDLINE_H
+#define __CMDLINE_H
+
+/**
+ * struct cmdline - kernel command line being put together
+ *
+ * The command line is held as separate arguments, so that the many
+ * updates made on the way to boot are each a lookup by key rather than a
+ * rescan and reallocation of the whole string, which is only produced
+ * once at the end by cmdline_str().
+ *
+ * Using memset() to zero all fields is equivalent to cmdline_init(cl, NULL).
+ *
+ * @args: Arguments, in command line order, each allocated
+ * @count: Number of arguments
+ * @max: Number of arguments @args has room for
+ * @buf: Result of the last cmdline_str()
+ */
+struct cmdline {
+	char **args;
+	int count;
+	int max;
+	char *buf;
+};
+
+/**
+ * cmdline_init() - start a command line
+ *
+ * The arguments of @str are kept as they are, duplicates included.
+ *
+ * @cl: Command line to set up
+ * @str: Initial arguments, separated by spaces, or NULL
+ * @return 0 if OK, -ENOMEM if out of memory
+ */
+int cmdline_init(struct cmdline *cl, const char *str);
+
+/**
+ * cmdline_uninit() - free a command line
+ *
+ * This also frees the string returned by cmdline_str().
+ *
+ * @cl: Command line to free
+ */
+void cmdline_uninit(struct cmdline *cl);
+
+/**
+ * cmdline_update() - add arguments to a command line
+ *
+ * This has the semantics of env_update(): an argument "key=value" replaces
+ * the first one with the same key, or is appended if there is none, while
+ * an argument without a value is only appended if it is not there yet.
+ * Spaces inside double quotes do not separate arguments.
+ *
+ * @cl: Command line to update
+ * @args: Arguments to add, separated by spaces
+ * @ignore: Arguments containing this string are skipped, or NULL
+ * @return 0 if OK, -ENOMEM if out of memory
+ */
+int cmdline_update(struct cmdline *cl, const char *args, const char *ignore);
+
+/**
+ * cmdline_find() - find an argument
+ *
+ * @cl: Command line to look in
+ * @prefix: Start of the argument, e.g. "root=" or "rootfstype=ubifs"
+ * @return the first argument starting with @prefix, or NULL
+ */
+const char *cmdline_find(struct cmdline *cl, const char *prefix);
+
+/**
+ * cmdline_delete() - remove arguments
+ *
+ * @cl: Command line to update
+ * @prefix: Arguments starting with this are removed
+ */
+void cmdline_delete(struct cmdline *cl, const char *prefix);
+
+/**
+ * cmdline_extract() - move arguments out of a command line
+ *
+ * @cl: Command line to update
+ * @substr: Arguments containing this string are moved
+ * @return the moved arguments separated by spaces, which the caller must
+ * free, or NULL if out of memory
+ */
+char *cmdline_extract(struct cmdline *cl, const char *substr);
+
+/**
+ * cmdline_str() - get the command line as a string
+ *
+ * @cl: Command line
+ * @return the arguments separated by spaces, valid until the next change
+ * to @cl, or NULL if out of memory
+ */
+const char *cmdline_str(struct cmdline *cl);
+
+#endif
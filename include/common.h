@@ -609,6 +609,18 @@ void	flush_dcache_all(void);
 void	flush_dcache_range(unsigned long start, unsigned long stop);
 void	invalidate_dcache_range(unsigned long start, unsigned long stop);
 void	invalidate_dcache_all(void);
+
+/* A range for the batched cache maintenance, [start, stop) */
+struct dcache_range {
+	unsigned long start;
+	unsigned long stop;
+};
+
+/* As flush_dcache_range() for each range, with one barrier at the end */
+void	flush_dcache_ranges(const struct dcache_range *ranges, int count);
+void	invalidate_dcache_ranges(const struct dcache_range *ranges, int count);
+void	dcache_stats_show(void);
+void	dcache_stats_reset(void);
 void	invalidate_icache_all(void);
 
 enum {
@@ -81,6 +81,7 @@
 #define CONFIG_USB_FUNCTION_MASS_STORAGE
 #define CONFIG_ROCKUSB_G_DNL_PID	0x350a
 #define ROCKUSB_FSG_BUFLEN		0x400000
+#define ROCKUSB_FSG_NUM_BUFFERS		4
 
 #define ENV_MEM_LAYOUT_SETTINGS \
 	"scriptaddr=0x00c00000\0" \
@@ -62,6 +62,7 @@
 #define CONFIG_USB_FUNCTION_MASS_STORAGE
 #define CONFIG_ROCKUSB_G_DNL_PID	0x350b
 #define ROCKUSB_FSG_BUFLEN		0x400000
+#define ROCKUSB_FSG_NUM_BUFFERS		4
 
 /*
  * decompressed kernel:  4M ~ 84M
@@ -20,6 +20,31 @@ void clear_ctrlc(void);	/* clear the Control-C condition */
 int disable_ctrlc(int);	/* 1 to disable, 0 to enable Control-C detect */
 int confirm_yesno(void);        /*  1 if input is "y", "Y", "yes" or "YES" */
 
+#if CONFIG_IS_ENABLED(CONSOLE_QUIET)
+/**
+ * console_quiet_exit() - make a quiet console verbose
+ *
+ * Writes the log recorded in the pstore buffer so far to the console and
+ * shows all output from then on. Nothing happens if it is verbose already.
+ */
+void console_quiet_exit(void);
+#else
+static inline void console_quiet_exit(void) {}
+#endif
+
+#if CONFIG_IS_ENABLED(CONSOLE_TX_BUFFER)
+/**
+ * console_tx_poll() - move buffered console output to the UART
+ *
+ * Writes as much of the output putc() buffered as the UART FIFO takes,
+ * without waiting. Called while U-Boot waits, so the output goes on
+ * behind whatever the CPU is doing.
+ */
+void console_tx_poll(void);
+#else
+static inline void console_tx_poll(void) {}
+#endif
+
 /**
  * console_record_init() - set up the console recording buffers
  *
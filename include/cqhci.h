@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2024 Rockchip Electronics Co., Ltd
+ *
+ * eMMC Command Queue Host Controller Interface (CQHCI), as defined
+ * by JEDEC JESD84-B51.
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef __CQHCI_H
+#define __CQHCI_H
+
+#include <asm/io.h>
+#include <mmc.h>
+
+/* Registers, relative to the CQHCI base */
+#define CQHCI_VER			0x00
+#define CQHCI_CAP			0x04
+#define CQHCI_CFG			0x08
+#define  CQHCI_DCMD			BIT(12)
+#define  CQHCI_TASK_DESC_SZ		BIT(8)
+#define  CQHCI_ENABLE			BIT(0)
+#define CQHCI_CTL			0x0c
+#define  CQHCI_CLEAR_ALL_TASKS		BIT(8)
+#define  CQHCI_HALT			BIT(0)
+#define CQHCI_IS			0x10
+#define CQHCI_ISTE			0x14
+#define CQHCI_ISGE			0x18
+#define  CQHCI_IS_HAC			BIT(0)
+#define  CQHCI_IS_TCC			BIT(1)
+#define  CQHCI_IS_RED			BIT(2)
+#define  CQHCI_IS_TCL			BIT(3)
+#define  CQHCI_IS_GCE			BIT(4)
+#define  CQHCI_IS_ICCE			BIT(5)
+#define  CQHCI_IS_MASK			(CQHCI_IS_TCC | CQHCI_IS_RED | \
+					 CQHCI_IS_GCE | CQHCI_IS_ICCE)
+#define  CQHCI_IS_ERR			(CQHCI_IS_RED | CQHCI_IS_GCE | \
+					 CQHCI_IS_ICCE)
+#define CQHCI_IC			0x1c
+#define CQHCI_TDLBA			0x20
+#define CQHCI_TDLBAU			0x24
+#define CQHCI_TDBR			0x28
+#define CQHCI_TCN			0x2c
+#define CQHCI_DQS			0x30
+#define CQHCI_DPT			0x34
+#define CQHCI_TCLR			0x38
+#define CQHCI_SSC1			0x40
+#define CQHCI_SSC2			0x44
+#define CQHCI_CRDCT			0x48
+#define CQHCI_RMEM			0x50
+#define CQHCI_TERRI			0x54
+#define CQHCI_CRI			0x58
+#define CQHCI_CRA			0x5c
+
+/* Task, link and transfer descriptor fields */
+#define CQHCI_VALID(x)			(((x) & 1) << 0)
+#define CQHCI_END(x)			(((x) & 1) << 1)
+#define CQHCI_INT(x)			(((x) & 1) << 2)
+#define CQHCI_ACT(x)			(((x) & 0x7) << 3)
+#define CQHCI_FORCED_PROG(x)		(((x) & 1) << 6)
+#define CQHCI_CONTEXT(x)		(((x) & 0xf) << 7)
+#define CQHCI_DATA_TAG(x)		(((x) & 1) << 11)
+#define CQHCI_DATA_DIR(x)		(((x) & 1) << 12)
+#define CQHCI_PRIORITY(x)		(((x) & 1) << 13)
+#define CQHCI_QBAR(x)			(((x) & 1) << 14)
+#define CQHCI_REL_WRITE(x)		(((x) & 1) << 15)
+#define CQHCI_BLK_COUNT(x)		(((x) & 0xffff) << 16)
+#define CQHCI_BLK_ADDR(x)		(((u64)(x) & 0xffffffff) << 32)
+#define CQHCI_DAT_LENGTH(x)		(((x) & 0xffff) << 16)
+
+#define CQHCI_ACT_TRAN			0x4
+#define CQHCI_ACT_TASK			0x5
+#define CQHCI_ACT_LINK			0x6
+
+#define CQHCI_MAX_SLOTS			32
+/* Each transfer descriptor moves at most 64KiB */
+#define CQHCI_MAX_SEG_SIZE		SZ_64K
+/* Number of transfer descriptors per task, i.e. 1MiB per task */
+#define CQHCI_MAX_SEGS			16
+
+struct cqhci_host;
+
+struct cqhci_host_ops {
+	/**
+	 * enable() - Put the host controller into command queue mode
+	 *
+	 * Called once CQHCI_CFG.CQHCI_ENABLE is set, typically to select
+	 * ADMA2 and program the block size.
+	 */
+	void (*enable)(struct cqhci_host *cq_host);
+
+	/**
+	 * disable() - Return the host controller to legacy mode
+	 *
+	 * @recovery:	true if the queue was aborted on an error and the
+	 *		controller needs a reset of its command/data lines
+	 */
+	void (*disable)(struct cqhci_host *cq_host, bool recovery);
+
+	/**
+	 * check_error() - Check the host for errors not reported in CQHCI_IS
+	 *
+	 * Data CRC/timeout errors are flagged in the host's own interrupt
+	 * status rather than by the command queue engine.
+	 *
+	 * @return 0 if no error, -ve if the transfer failed
+	 */
+	int (*check_error)(struct cqhci_host *cq_host);
+};
+
+/**
+ * struct cqhci_host - Command queue state for one host controller
+ *
+ * @mmio:	Base of the CQHCI register block
+ * @mmc:	MMC device using this queue
+ * @ops:	Host controller hooks for entering/leaving CQ mode
+ * @priv:	Private pointer for use by the host controller driver
+ * @desc_base:	Task descriptor list, one task + link descriptor per slot
+ * @trans_base:	Transfer descriptors, CQHCI_MAX_SEGS per slot
+ * @num_slots:	Number of slots in use (min of host and card queue depth)
+ */
+struct cqhci_host {
+	void *mmio;
+	struct mmc *mmc;
+	const struct cqhci_host_ops *ops;
+	void *priv;
+
+	u64 *desc_base;
+	u64 *trans_base;
+	int num_slots;
+};
+
+static inline void cqhci_writel(struct cqhci_host *cq_host, u32 val, int reg)
+{
+	writel(val, cq_host->mmio + reg);
+}
+
+static inline u32 cqhci_readl(struct cqhci_host *cq_host, int reg)
+{
+	return readl(cq_host->mmio + reg);
+}
+
+/**
+ * cqhci_init() - Set up the descriptor memory of a command queue host
+ *
+ * @cq_host:	Command queue host, with @mmio and @ops filled in
+ * @mmc:	MMC device using the queue
+ * @return 0 if OK, -ve on error
+ */
+int cqhci_init(struct cqhci_host *cq_host, struct mmc *mmc);
+
+/**
+ * cqhci_request() - Move data using the command queue engine
+ *
+ * The transfer is split into tasks of up to CQHCI_MAX_SEGS * 64KiB which
+ * are queued on all available slots at once, so the card always has work
+ * outstanding. The card must already be in command queue mode.
+ *
+ * @cq_host:	Command queue host
+ * @data:	Data to transfer; the buffer must be DMA aligned
+ * @start:	Start block address on the card
+ * @depth:	Queue depth supported by the card
+ * @return 0 if OK, -ve on error
+ */
+int cqhci_request(struct cqhci_host *cq_host, struct mmc_data *data,
+		  lbaint_t start, uint depth);
+
+#endif /* __CQHCI_H */
@@ -85,6 +85,11 @@ struct dm_crypto_ops {
 	int (*sha_update)(struct udevice *dev, u32 *input, u32 len);
 	int (*sha_final)(struct udevice *dev, sha_context *ctx, u8 *output);
 
+	/* Optional, SHA over several buffers in a single pass */
+	int (*sha_regions)(struct udevice *dev, sha_context *ctx,
+			   const struct image_region region[],
+			   int region_count, u8 *output);
+
 	/* RSA verify */
 	int (*rsa_verify)(struct udevice *dev, rsa_key *ctx,
 			  u8 *sign, u8 *output);
@@ -174,6 +179,9 @@ int crypto_sha_csum(struct udevice *dev, sha_context *ctx,
 /**
  * crypto_sha_regions_csum() - Crypto sha hash for multi data blocks
  *
+ * If the device provides sha_regions() all blocks are handed to it at once,
+ * otherwise they are hashed with one sha_update() per block.
+ *
  * @dev: crypto device
  * @ctx: sha context
  * @region: regions buffer
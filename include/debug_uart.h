@@ -82,6 +82,17 @@ int debug_uart_clrc(void);
 int debug_uart_flushc(void);
 int debug_uart_setbrg(void);
 
+/**
+ * debug_uart_putc_nowait() - Output a character if the UART has room for it
+ *
+ * Unlike printch() this does not wait for the transmitter and does not add
+ * a '\r' before a '\n'.
+ *
+ * @ch:		Character to output
+ * @return 0 if it was written, -EAGAIN if the transmit FIFO is full
+ */
+int debug_uart_putc_nowait(int ch);
+
 /**
  * printascii() - Output an ASCII string to the debug UART
  *
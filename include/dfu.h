@@ -150,7 +150,13 @@ struct dfu_entity {
 
 	u32 bad_skip;	/* for nand use */
 
+	/* Half of the buffer still to be written, see dfu_write_background() */
+	u8 *w_buf;
+	long w_left;
+	int w_ret;
+
 	unsigned int inited:1;
+	unsigned int w_split:1;
 };
 
 #ifdef CONFIG_SET_DFU_ALT_INFO
@@ -201,6 +207,21 @@ static inline void dfu_set_defer_flush(struct dfu_entity *dfu)
 	dfu_defer_flush = dfu;
 }
 
+#ifdef CONFIG_DFU_WRITE_BACKGROUND
+/**
+ * dfu_write_background() - write out a piece of the received data
+ *
+ * Once one half of the DFU buffer is full, data is received into the other
+ * one, while the full half is written to the medium a piece per call. This
+ * is meant to be called between polls of the USB controller.
+ */
+void dfu_write_background(void);
+#else
+static inline void dfu_write_background(void)
+{
+}
+#endif
+
 /**
  * dfu_write_from_mem_addr - write data from memory to DFU managed medium
  *
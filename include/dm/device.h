@@ -62,6 +62,12 @@ struct driver_info;
  */
 #define DM_FLAG_OS_PREPARE		(1 << 10)
 
+/*
+ * Device need not be probed before the boot decision, see
+ * dm_probe_deferred(). Set by the driver or by "u-boot,dm-probe-defer"
+ */
+#define DM_FLAG_PROBE_DEFER		(1 << 11)
+
 /* Device is from kernel dtb */
 #define DM_FLAG_KNRL_DTB		(1 << 31)
 
@@ -166,9 +172,33 @@ static inline int dev_of_offset(const struct udevice *dev)
 	return ofnode_to_offset(dev->node);
 }
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+void uclass_index_invalidate(struct uclass *uc);
+#endif
+
 static inline void dev_set_of_offset(struct udevice *dev, int of_offset)
 {
 	dev->node = offset_to_ofnode(of_offset);
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	uclass_index_invalidate(dev->uclass);
+#endif
+}
+
+/**
+ * dev_set_req_seq() - Set the requested sequence number of a device
+ *
+ * Drivers which pick the number themselves, rather than take it from an
+ * alias, must set it with this so that lookups by sequence number see it.
+ *
+ * @dev:	Device to update
+ * @req_seq:	Requested sequence number, or -1 for none
+ */
+static inline void dev_set_req_seq(struct udevice *dev, int req_seq)
+{
+	dev->req_seq = req_seq;
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	uclass_index_invalidate(dev->uclass);
+#endif
 }
 
 static inline bool dev_has_of_node(struct udevice *dev)
@@ -538,6 +568,26 @@ bool device_has_active_children(struct udevice *dev);
  */
 bool device_is_last_sibling(struct udevice *dev);
 
+/**
+ * device_probe_deferred() - check if probing a device is deferred for now
+ *
+ * Board code which probes all devices of a uclass up front should skip
+ * those for which this is true. They are probed by dm_probe_deferred()
+ * if U-Boot does not boot, or on first use as usual.
+ *
+ * @dev:	Device to check
+ * @return true if @dev has DM_FLAG_PROBE_DEFER and dm_probe_deferred()
+ * has not run yet
+ */
+#if CONFIG_IS_ENABLED(DM_PROBE_DEFER)
+bool device_probe_deferred(const struct udevice *dev);
+#else
+static inline bool device_probe_deferred(const struct udevice *dev)
+{
+	return false;
+}
+#endif
+
 /**
  * device_set_name() - set the name of a device
  *
@@ -912,11 +962,19 @@ static inline void devm_kfree(struct udevice *dev, void *ptr)
 	printk(fmt, ##__VA_ARGS__);				\
 })
 
+#if CONFIG_IS_ENABLED(CONSOLE_QUIET)
+#define __dev_printk(level, dev, fmt, ...)			\
+({								\
+	if (level < CONFIG_VAL(LOGLEVEL))			\
+		printk_level(level, fmt, ##__VA_ARGS__);	\
+})
+#else
 #define __dev_printk(level, dev, fmt, ...)			\
 ({								\
 	if (level < CONFIG_VAL(LOGLEVEL))			\
 		dev_printk(dev, fmt, ##__VA_ARGS__);		\
 })
+#endif
 
 #define dev_emerg(dev, fmt, ...) \
 	__dev_printk(0, dev, fmt, ##__VA_ARGS__)
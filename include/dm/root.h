@@ -114,6 +114,22 @@ int dm_init(bool of_live);
  */
 int dm_uninit(void);
 
+/**
+ * dm_probe_deferred() - Probe the devices whose probe was deferred
+ *
+ * Probe all devices with DM_FLAG_PROBE_DEFER which nothing has used yet.
+ * This is called once the boot decision is made and U-Boot stays, e.g.
+ * before entering the command line. Afterwards device_probe_deferred()
+ * is false for every device.
+ *
+ * @return 0 if OK, -ve on error of the last device which failed
+ */
+#if CONFIG_IS_ENABLED(DM_PROBE_DEFER)
+int dm_probe_deferred(void);
+#else
+static inline int dm_probe_deferred(void) { return 0; }
+#endif
+
 #if CONFIG_IS_ENABLED(DM_DEVICE_REMOVE)
 /**
  * dm_remove_devices_flags - Call remove function of all drivers with
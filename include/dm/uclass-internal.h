@@ -132,6 +132,31 @@ int uclass_find_device_by_of_offset(enum uclass_id id, int node,
 int uclass_find_device_by_ofnode(enum uclass_id id, ofnode node,
 				 struct udevice **devp);
 
+/**
+ * uclass_set_seq() - Set the sequence number of a device
+ *
+ * This keeps the uclass index in step, see CONFIG_DM_UCLASS_INDEX.
+ *
+ * @dev:	Device to update
+ * @seq:	New sequence number, or -1 for none
+ */
+void uclass_set_seq(struct udevice *dev, int seq);
+
+/**
+ * uclass_index_invalidate() - Rebuild the uclass index on the next lookup
+ *
+ * This is needed when the node or requested sequence number of a device in
+ * @uc changes, or when a device is added to or taken off the list other than
+ * by uclass_bind_device() and uclass_unbind_device().
+ *
+ * @uc:		Uclass whose device list changed
+ */
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+void uclass_index_invalidate(struct uclass *uc);
+#else
+static inline void uclass_index_invalidate(struct uclass *uc) {}
+#endif
+
 /**
  * uclass_bind_device() - Associate device with a uclass
  *
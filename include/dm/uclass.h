@@ -31,6 +31,7 @@
  * @dev_head: List of devices in this uclass (devices are attached to their
  * uclass when their bind method is called)
  * @sibling_node: Next uclass in the linked list of uclasses
+ * @index: Hash tables to look devices up by name, sequence number and node
  */
 struct uclass {
 	void *priv;
@@ -40,6 +41,9 @@ struct uclass {
 #ifdef CONFIG_USING_KERNEL_DTB_V2
 	struct list_head *u_boot_dev_head;
 #endif
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	struct uclass_index *index;
+#endif
 };
 
 struct driver;
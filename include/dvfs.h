@@ -32,6 +32,26 @@ int dvfs_apply(struct udevice *dev);
  */
 int dvfs_repeat_apply(struct udevice *dev);
 
+#ifdef CONFIG_ROCKCHIP_BOOT_DVFS
+/**
+ * boot_dvfs_raise() - run the cpu at the boot OPP of the kernel dtb
+ *
+ * Nothing is done if the cpu already runs at least that fast.
+ *
+ * @return 0 if OK, -ve on error
+ */
+int boot_dvfs_raise(void);
+
+/**
+ * boot_dvfs_restore() - set the cpu rate and voltage of before
+ *		       boot_dvfs_raise() back
+ */
+void boot_dvfs_restore(void);
+#else
+static inline int boot_dvfs_raise(void) { return 0; }
+static inline void boot_dvfs_restore(void) {}
+#endif
+
 /**
  * struct dm_dvfs_ops - Driver model Thermal operations
  *
@@ -9,6 +9,7 @@
 #define __DWMMC_HW_H
 
 #include <asm/io.h>
+#include <bouncebuf.h>
 #include <mmc.h>
 
 #define DWMCI_CTRL		0x000
@@ -62,6 +63,7 @@
 #define DWMCI_INTMSK_RTO	(1 << 8)
 #define DWMCI_INTMSK_DRTO	(1 << 9)
 #define DWMCI_INTMSK_HTO	(1 << 10)
+#define DWMCI_INTMSK_VOLT_SWITCH DWMCI_INTMSK_HTO	/* during CMD11 */
 #define DWMCI_INTMSK_FRUN	(1 << 11)
 #define DWMCI_INTMSK_HLE	(1 << 12)
 #define DWMCI_INTMSK_SBE	(1 << 13)
@@ -93,6 +95,7 @@
 #define DWMCI_CMD_PRV_DAT_WAIT	(1 << 13)
 #define SDMMC_CMD_INIT		(1 << 15)
 #define DWMCI_CMD_UPD_CLK	(1 << 21)
+#define DWMCI_CMD_VOLT_SWITCH	(1 << 28)
 #define DWMCI_CMD_USE_HOLD_REG	(1 << 29)
 #define DWMCI_CMD_START		(1 << 31)
 
@@ -132,6 +135,7 @@
 #define DWMCI_BMOD_IDMAC_EN	(1 << 7)
 
 /* UHS register */
+#define DWMCI_UHS_VOLT_18	(1 << 0)
 #define DWMCI_DDR_MODE	(1 << 16)
 
 /* quirks */
@@ -201,12 +205,24 @@ struct dwmci_host {
 	 */
 	unsigned int (*get_mmc_clk)(struct dwmci_host *host, uint freq);
 	int (*execute_tuning)(struct dwmci_host *host, u32 opcode);
+#if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT)
+	/* I/O supply of the card, switched to 1.8V for the UHS-I modes */
+	struct udevice *vqmmc;
+#endif
 #ifndef CONFIG_BLK
 	struct mmc_config cfg;
 #endif
 
 	/* use fifo mode to read and write data */
 	bool fifo_mode;
+
+#if defined(CONFIG_SPL_BLK_READ_PREPARE) || CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+	/* state of the transfer started by send_cmd_prepare() */
+	bool async_pending;
+	struct mmc_data async_data;
+	struct bounce_buffer async_bbstate;
+	struct dwmci_idmac *async_idmac;
+#endif
 };
 
 struct dwmci_idmac {
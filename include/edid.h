@@ -1024,6 +1024,29 @@ bool drm_detect_hdmi_monitor(struct edid *edid);
 bool drm_detect_monitor_audio(struct edid *edid);
 int do_cea_modes(struct hdmi_edid_data *data, const u8 *db, u8 len);
 int drm_do_get_edid(struct ddc_adapter *adap, u8 *edid);
+#ifdef CONFIG_DRM_ROCKCHIP_EDID_CACHE
+/**
+ * drm_do_get_edid_cached() - Get EDID, from the cache if the sink is known
+ *
+ * The EDID last read for @key is kept in vendor storage. When the sink
+ * still reports the same identity and base block checksum, which a short
+ * DDC read finds out, the cached EDID is returned instead of reading all
+ * the blocks again.
+ *
+ * @adap: ddc adapter
+ * @edid: EDID buffer, EDID_SIZE * 4 bytes at least
+ * @key: what the EDID is cached by, the connector device name
+ * @return 0 on success, -ve on error
+ */
+int drm_do_get_edid_cached(struct ddc_adapter *adap, u8 *edid,
+			   const char *key);
+#else
+static inline int drm_do_get_edid_cached(struct ddc_adapter *adap, u8 *edid,
+					 const char *key)
+{
+	return drm_do_get_edid(adap, edid);
+}
+#endif
 enum hdmi_quantization_range
 drm_default_rgb_quant_range(struct drm_display_mode *mode);
 u8 drm_scdc_readb(struct ddc_adapter *adap, u8 offset,
@@ -143,6 +143,12 @@ void efi_net_set_dhcp_ack(void *pkt, int len);
 
 /* Called from places to check whether a timer expired */
 void efi_timer_check(void);
+#if defined(CONFIG_EFI_LOADER_BLOCK_IO2) && defined(CONFIG_PARTITIONS)
+/* Called from efi_timer_check() to complete Block I/O 2 reads */
+void efi_disk_poll(void);
+#else
+static inline void efi_disk_poll(void) { }
+#endif
 /* PE loader implementation */
 void *efi_load_pe(void *efi, struct efi_loaded_image *loaded_image_info);
 /* Called once to store the pristine gd pointer */
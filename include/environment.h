@@ -313,6 +313,24 @@ int env_import(const char *buf, int check);
 /* Export from hash table into binary representation */
 int env_export(env_t *env_out);
 
+/**
+ * env_unchanged() - Check if saving would rewrite the stored environment
+ *
+ * This exports the environment and compares its CRC with that of the one
+ * loaded or last saved, if that is known to be in storage.
+ *
+ * @return true if the stored environment is the same
+ */
+bool env_unchanged(void);
+
+/**
+ * env_update_stored() - Record the result of saving the environment
+ *
+ * @saved: true if the last env_export() made it to storage, false if the
+ *	storage is in an unknown state now
+ */
+void env_update_stored(bool saved);
+
 #ifdef CONFIG_SYS_REDUNDAND_ENVIRONMENT
 /* Select and import one of two redundant environments */
 int env_import_redund(const char *buf1, const char *buf2);
@@ -0,0 +1,70 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd
+ */
+
+#ifndef _EROFS_H
+#define _EROFS_H
+
+struct blk_desc;
+struct fs_dir_stream;
+struct fs_dirent;
+
+/**
+ * erofs_probe() - Mount an EROFS filesystem
+ *
+ * @fs_dev_desc: block device
+ * @fs_partition: partition on @fs_dev_desc
+ * @return 0 if OK, -1 if there is no EROFS we can read
+ */
+int erofs_probe(struct blk_desc *fs_dev_desc, disk_partition_t *fs_partition);
+
+/**
+ * erofs_close() - Forget the filesystem mounted by erofs_probe()
+ */
+void erofs_close(void);
+
+/**
+ * erofs_exists() - Check whether a file or directory exists
+ *
+ * @filename: absolute path, symlinks followed
+ * @return 1 if it exists, 0 if not
+ */
+int erofs_exists(const char *filename);
+
+/**
+ * erofs_size() - Get the size of a file
+ *
+ * @filename: absolute path, symlinks followed
+ * @size: returns the size in bytes
+ * @return 0 if OK, -ve on error
+ */
+int erofs_size(const char *filename, loff_t *size);
+
+/**
+ * erofs_read() - Read a regular file, decompressing it as needed
+ *
+ * @filename: absolute path, symlinks followed
+ * @buf: destination buffer
+ * @offset: offset in the file to read from
+ * @len: bytes to read, 0 for up to the end of the file
+ * @actread: returns the bytes read
+ * @return 0 if OK, -ve on error
+ */
+int erofs_read(const char *filename, void *buf, loff_t offset, loff_t len,
+	       loff_t *actread);
+
+/**
+ * erofs_uuid() - Get the filesystem UUID
+ *
+ * @uuid_str: returns the UUID as a string
+ * @return 0 if OK, -ve on error
+ */
+int erofs_uuid(char *uuid_str);
+
+/* See struct fstype_info in fs/fs.c */
+int erofs_opendir(const char *filename, struct fs_dir_stream **dirsp);
+int erofs_readdir(struct fs_dir_stream *dirs, struct fs_dirent **dentp);
+void erofs_closedir(struct fs_dir_stream *dirs);
+
+#endif /* _EROFS_H */
@@ -146,8 +146,50 @@ int ext4fs_exists(const char *filename);
 int ext4fs_size(const char *filename, loff_t *size);
 void ext4fs_free_node(struct ext2fs_node *node, struct ext2fs_node *currroot);
 int ext4fs_devread(lbaint_t sector, int byte_offset, int byte_len, char *buf);
+
+/**
+ * ext4fs_cache_mount() - Keep or drop the metadata cache for a mount
+ *
+ * The cached blocks are kept if @data is the filesystem they were read
+ * from, on the same partition, and nothing was written to the device since.
+ *
+ * @data:	filesystem being mounted, with its superblock read
+ */
+void ext4fs_cache_mount(struct ext2_data *data);
+
+/**
+ * ext4fs_cache_read() - ext4fs_devread() through the metadata cache
+ *
+ * Reads within one filesystem block are served from and fill the cache,
+ * others go to the device.
+ *
+ * @data:	mounted filesystem
+ * @sector:	as for ext4fs_devread()
+ * @byte_offset: as for ext4fs_devread()
+ * @byte_len:	as for ext4fs_devread()
+ * @buf:	as for ext4fs_devread()
+ *
+ * @return 1 on success, 0 on error
+ */
+int ext4fs_cache_read(struct ext2_data *data, lbaint_t sector,
+		      int byte_offset, int byte_len, char *buf);
 void ext4fs_set_blk_dev(struct blk_desc *rbdd, disk_partition_t *info);
 long int read_allocated_block(struct ext2_inode *inode, int fileblock);
+
+/**
+ * read_allocated_run() - Map a run of contiguous blocks of a file
+ *
+ * @inode:	inode of the file
+ * @fileblock:	first block of the run in the file
+ * @count:	in, the most blocks wanted; out, the blocks in the run
+ *
+ * Extent mapped files map a run per extent, others a block at a time.
+ *
+ * @return the first block of the run on disk, 0 for a run of holes,
+ * negative on error
+ */
+long int read_allocated_run(struct ext2_inode *inode, int fileblock,
+			    lbaint_t *count);
 int ext4fs_probe(struct blk_desc *fs_dev_desc,
 		 disk_partition_t *fs_partition);
 int ext4_read_file(const char *filename, void *buf, loff_t offset, loff_t len,
@@ -35,6 +35,12 @@ typedef enum {
 	FB_BATT_VOLTAGE,
 	FB_BATT_SOC_OK,
 	FB_IS_USERSPACE,
+#ifdef CONFIG_FASTBOOT_DOWNLOAD_SHA256
+	FB_DWNLD_SHA256,
+#endif
+#ifdef CONFIG_FASTBOOT_FETCH
+	FB_FETCH_SIZE,
+#endif
 #ifdef CONFIG_RK_AVB_LIBAVB_USER
 	FB_HAS_COUNT,
 	FB_HAS_SLOT,
@@ -68,4 +74,23 @@ void fastboot_okay(const char *reason, char *response);
  */
 void timed_send_info(ulong *start, const char *msg);
 
+#ifdef CONFIG_FASTBOOT_FLASH_PIPELINE
+/**
+ * Run USB fastboot while a sparse image is being written, so the host
+ * can send the next one. Called between the writes of each slice.
+ */
+void fastboot_flash_poll(void);
+
+/**
+ * Write the sparse image a flash command replied to early, if any.
+ * Called from the fastboot loop, outside of any USB completion.
+ *
+ * @param index:  USB controller the gadget runs on
+ */
+void fastboot_flash_run(int index);
+#else
+static inline void fastboot_flash_poll(void) {}
+static inline void fastboot_flash_run(int index) {}
+#endif
+
 #endif /* _FASTBOOT_H_ */
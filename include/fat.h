@@ -31,6 +31,20 @@
 #define FAT16BUFSIZE	(FATBUFSIZE/2)
 #define FAT32BUFSIZE	(FATBUFSIZE/4)
 
+/*
+ * Reads of FAT entries go through a few larger windows after fatbuf, in
+ * the same allocation. The window size is a multiple of 3 sectors for
+ * FAT12 entries not to straddle windows, and of FATBUFBLOCKS for a
+ * window of fatbuf to fall in a single one.
+ */
+#define FATCACHEBLOCKS	48
+#define FATCACHESIZE	(mydata->sect_size * FATCACHEBLOCKS)
+#ifdef CONFIG_FS_FAT_CACHE_WINDOWS
+#define FATCACHEWINDOWS	CONFIG_FS_FAT_CACHE_WINDOWS
+#else
+#define FATCACHEWINDOWS	4
+#endif
+
 /* Maximum number of entry for long file name according to spec */
 #define MAX_LFN_SLOT	20
 
@@ -173,6 +187,9 @@ typedef struct {
 	__u16	clust_size;	/* Size of clusters in sectors */
 	int	data_begin;	/* The sector of the first cluster, can be negative */
 	int	fatbufnum;	/* Used by get_fatent, init to -1 */
+	int	fatcachenum[FATCACHEWINDOWS];	/* -1 while empty */
+	__u32	fatcacheused[FATCACHEWINDOWS];	/* last use */
+	__u32	fatcachetick;
 	int	rootdir_size;	/* Size of root dir for non-FAT32 */
 	__u32	root_cluster;	/* First cluster of root dir for FAT32 */
 } fsdata;
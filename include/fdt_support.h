@@ -232,6 +232,57 @@ void set_working_fdt_addr(ulong addr);
 int fdt_shrink_to_minimum(void *blob, uint extrasize);
 int fdt_increase_size(void *fdt, int add_len);
 
+/*
+ * A batch of property writes, applied with a single move of the blob.
+ *
+ * fdt_setprop() moves everything behind the property, strings block
+ * included, on each write that changes a size. A batch writes properties
+ * which keep their size in place at once and queues the others, which
+ * fdt_batch_commit() then puts in with one copy of the struct block.
+ *
+ * Offsets stay valid until the commit, as nothing is moved before. Reads
+ * of a queued property see its old value, and the blob must not be
+ * changed in any other way until the commit.
+ */
+struct fdt_batch_op;
+
+struct fdt_batch {
+	void *fdt;
+	struct fdt_batch_op *ops;
+	int count;
+	int max;
+};
+
+/**
+ * fdt_batch_begin() - Start a batch of property writes
+ *
+ * @b:		Batch to start
+ * @fdt:	FDT blob to write to
+ */
+void fdt_batch_begin(struct fdt_batch *b, void *fdt);
+
+/**
+ * fdt_batch_setprop() - Set a property, as fdt_setprop() but batched
+ *
+ * @b:		Batch
+ * @nodeoffset:	Offset of the node
+ * @name:	Property name, must stay valid until the commit
+ * @val:	Property value, copied
+ * @len:	Length of @val
+ * @return 0 if ok, or -FDT_ERR_... on error
+ */
+int fdt_batch_setprop(struct fdt_batch *b, int nodeoffset, const char *name,
+		      const void *val, int len);
+
+/**
+ * fdt_batch_commit() - Apply, then free, the queued writes of a batch
+ *
+ * @b:		Batch
+ * @return 0 if ok, -FDT_ERR_NOSPACE if the blob has not enough free space
+ * left, in which case nothing queued was written, or another -FDT_ERR_...
+ */
+int fdt_batch_commit(struct fdt_batch *b);
+
 int fdt_fixup_nor_flash_size(void *blob);
 
 #if defined(CONFIG_FDT_FIXUP_PARTITIONS)
@@ -0,0 +1,72 @@
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef _IMAGE_CIPHER_H_
+#define _IMAGE_CIPHER_H_
+
+#include <crypto.h>
+#include <linux/sizes.h>
+
+#define FIT_CIPHER_NODENAME		"cipher"
+#define FIT_CIPHER_KEY_HINT_PROP	"key-name-hint"
+#define FIT_DATA_SIZE_UNCIPHERED_PROP	"data-size-unciphered"
+
+#define FIT_CIPHER_BLOCK_SIZE		16
+#define FIT_CIPHER_KEY_MAX		32
+#define FIT_CIPHER_XTS_UNIT		SZ_4K	/* bytes per XTS tweak */
+
+/**
+ * struct fit_cipher - decryption state of a FIT image
+ *
+ * @dev:	crypto device
+ * @ctx:	cipher context, points into @key, @twk_key and @iv
+ * @size:	size of the encrypted data
+ * @size_unciphered: size of the data once decrypted
+ * @done:	bytes of the data decrypted so far
+ */
+struct fit_cipher {
+	struct udevice *dev;
+	cipher_context ctx;
+	u8 key[FIT_CIPHER_KEY_MAX];
+	u8 twk_key[FIT_CIPHER_KEY_MAX];
+	u8 iv[FIT_CIPHER_BLOCK_SIZE];
+	size_t size;
+	size_t size_unciphered;
+	size_t done;
+};
+
+/**
+ * fit_image_cipher_init() - set up decryption of a FIT image
+ *
+ * The image node has a "cipher" subnode with the algo ("aes128", "aes192"
+ * or "aes256"), the mode ("cbc", the default, or "xts") and the name of
+ * the key. The key is in the node /cipher/key-<algo>-<name> of @key_blob.
+ *
+ * @fit:	FIT blob
+ * @noffset:	image node
+ * @key_blob:	device tree with the keys
+ * @c:		decryption state to set up
+ * @return 1 if the image is encrypted, 0 if not, -ve on error
+ */
+int fit_image_cipher_init(const void *fit, int noffset, const void *key_blob,
+			  struct fit_cipher *c);
+
+/**
+ * fit_image_decrypt() - decrypt the data of a FIT image as it comes in
+ *
+ * Decrypts in place what is new in @data[0..@avail) since the last call:
+ * whole AES blocks with CBC, whole data units with XTS, and everything up
+ * to the end once all of the data is there. So this can be called after
+ * each chunk read from storage.
+ *
+ * @c:		decryption state from fit_image_cipher_init()
+ * @data:	start of the encrypted data
+ * @avail:	bytes of it read so far
+ * @return 0 if OK, -ve on error
+ */
+int fit_image_decrypt(struct fit_cipher *c, u8 *data, size_t avail);
+
+#endif
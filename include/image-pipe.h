@@ -0,0 +1,207 @@
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ */
+
+#ifndef _IMAGE_PIPE_H_
+#define _IMAGE_PIPE_H_
+
+#include <crypto.h>
+#include <image.h>
+#include <image-cipher.h>
+#include <u-boot/sha1.h>
+#include <u-boot/sha256.h>
+
+/*
+ * An image pipeline runs a chain of stages over image data while it is
+ * read from storage: each chunk goes through e.g. decryption, hashing and
+ * decompression as soon as it is in memory, instead of one pass over the
+ * whole image per step once all of it is read.
+ */
+
+#define IMG_PIPE_STAGES		4
+
+/* Returned by img_stage.feed() to leave the pipeline */
+#define IMG_STAGE_SKIP		1
+
+/**
+ * struct img_stage - one step of an image pipeline
+ *
+ * @name:	for messages
+ * @feed:	process @data[@done..@avail) in place, @avail is @total on the
+ *		last call. Sets @done to the end of the data it is through
+ *		with, which is what the next stage may process. Returns 0 if
+ *		OK, IMG_STAGE_SKIP to see no more data, -ve on error.
+ * @finish:	optional, called once all data went through
+ * @abort:	optional, called when the pipeline is given up after a stage
+ *		has seen data
+ * @done:	bytes processed so far
+ * @skip:	the stage left the pipeline, data goes past it unchanged
+ */
+struct img_stage {
+	const char *name;
+	int (*feed)(struct img_stage *st, u8 *data, size_t avail,
+		    size_t total);
+	int (*finish)(struct img_stage *st, u8 *data, size_t total);
+	void (*abort)(struct img_stage *st);
+	size_t done;
+	bool skip;
+};
+
+/**
+ * struct img_pipe - stages run over some image data
+ *
+ * @data:	start of the image data
+ * @total:	size of the image data
+ * @count:	number of stages
+ * @stages:	the stages, in the order the data goes through them
+ */
+struct img_pipe {
+	u8 *data;
+	size_t total;
+	int count;
+	struct img_stage *stages[IMG_PIPE_STAGES];
+};
+
+/**
+ * struct img_hash_stage - hash the image data as it goes through
+ *
+ * The hash is calculated by the crypto engine with FIT_HW_CRYPTO, by the
+ * CPU otherwise.
+ *
+ * @st:		stage
+ * @algo:	hash algorithm name, e.g. "sha256"
+ * @size:	bytes to hash, from the start of the data. Less than the size
+ *		of the data when e.g. decryption padded it.
+ * @value:	the hash once the pipeline is finished
+ * @value_len:	length of @value
+ */
+struct img_hash_stage {
+	struct img_stage st;
+	const char *algo;
+	size_t size;
+	u8 value[FIT_MAX_HASH_LEN];
+	int value_len;
+#if CONFIG_IS_ENABLED(FIT_HW_CRYPTO)
+	struct udevice *dev;
+	sha_context ctx;
+#else
+	union {
+		sha1_context sha1;
+		sha256_context sha256;
+	} ctx;
+#endif
+};
+
+/**
+ * struct img_cipher_stage - decrypt the data of an encrypted FIT image
+ *
+ * @st:		stage
+ * @cipher:	set up by fit_image_cipher_init()
+ */
+struct img_cipher_stage {
+	struct img_stage st;
+	struct fit_cipher cipher;
+};
+
+/**
+ * img_pipe_init() - Set up an empty pipeline
+ *
+ * @p:		pipeline
+ * @data:	where the image data is read to
+ * @total:	size of the image data
+ */
+void img_pipe_init(struct img_pipe *p, void *data, size_t total);
+
+/**
+ * img_pipe_add() - Append a stage to a pipeline
+ *
+ * @p:		pipeline
+ * @st:		stage, must stay around until the pipeline is finished
+ * @return 0 if OK, -ENOSPC if the pipeline is full
+ */
+int img_pipe_add(struct img_pipe *p, struct img_stage *st);
+
+/**
+ * img_pipe_feed() - Run the stages over newly read data
+ *
+ * @p:		pipeline
+ * @avail:	bytes of the image data read so far, from its start
+ * @return 0 if OK, -ve on error
+ */
+int img_pipe_feed(struct img_pipe *p, size_t avail);
+
+/**
+ * img_pipe_finish() - Run the stages over the rest of the data
+ *
+ * All of the image data must be read.
+ *
+ * @p:		pipeline
+ * @return 0 if OK, -ve on error
+ */
+int img_pipe_finish(struct img_pipe *p);
+
+/**
+ * img_pipe_abort() - Give up a pipeline, e.g. after a read error
+ *
+ * @p:		pipeline
+ */
+void img_pipe_abort(struct img_pipe *p);
+
+static inline bool img_pipe_empty(const struct img_pipe *p)
+{
+	return !p->count;
+}
+
+/**
+ * img_hash_stage_init() - Set up a stage hashing the data
+ *
+ * @h:		stage
+ * @algo:	hash algorithm name, "sha1" or "sha256"
+ * @size:	bytes to hash
+ * @return 0 if OK, -EPROTONOSUPPORT if @algo can't be used, -ve on error
+ */
+int img_hash_stage_init(struct img_hash_stage *h, const char *algo,
+			size_t size);
+
+/**
+ * img_hash_stage_record() - Keep the hash a stage took of some data
+ *
+ * This lets the next fit_image_check_hash() of the same data compare the
+ * hash of the image with the result of the stage instead of hashing the
+ * data again. Each record is used once.
+ *
+ * @h:		finished stage
+ * @data:	the image data, as it will be passed for verification
+ * @size:	size of the image data
+ */
+void img_hash_stage_record(const struct img_hash_stage *h, const void *data,
+			   size_t size);
+
+/**
+ * img_pipe_hash_verified() - Check for a hash taken by a hash stage
+ *
+ * @data:	image data to be hashed
+ * @size:	size of @data
+ * @algo:	hash algorithm name
+ * @value:	expected hash value
+ * @value_len:	length of @value
+ * @return 1 if a stage hashed @data to @value, 0 if not
+ */
+int img_pipe_hash_verified(const void *data, size_t size, const char *algo,
+			   const uint8_t *value, int value_len);
+
+/**
+ * img_cipher_stage_init() - Set up a stage decrypting a FIT image
+ *
+ * @c:		stage
+ * @fit:	FIT blob
+ * @noffset:	image node
+ * @key_blob:	device tree with the keys
+ * @return 1 if the image is encrypted, 0 if not, -ve on error
+ */
+int img_cipher_stage_init(struct img_cipher_stage *c, const void *fit,
+			  int noffset, const void *key_blob);
+
+#endif
@@ -23,6 +23,15 @@ struct sparse_storage {
 	lbaint_t	(*reserve)(struct sparse_storage *info,
 				 lbaint_t blk,
 				 lbaint_t blkcnt);
+
+	/*
+	 * Optional: blocks per erase group, and a callback which erases
+	 * whole groups so they read back as zero, used for zero FILL chunks.
+	 */
+	lbaint_t	erase_grp;
+	lbaint_t	(*erase)(struct sparse_storage *info,
+				 lbaint_t blk,
+				 lbaint_t blkcnt);
 };
 
 static inline int is_sparse_image(void *buf)
@@ -36,5 +45,17 @@ static inline int is_sparse_image(void *buf)
 	return 0;
 }
 
+/**
+ * sparse_write() - write an Android sparse image to a storage
+ *
+ * @info:	Storage to write to, from info->start on
+ * @data:	Sparse image, starting with its header
+ * @written:	Returns the number of bytes written or filled
+ * @reason:	Returns what went wrong, on error
+ * @return 0 if OK, -ve on error
+ */
+int sparse_write(struct sparse_storage *info, void *data, u64 *written,
+		 const char **reason);
+
 void write_sparse_image(struct sparse_storage *info, const char *part_name,
 			void *data, unsigned sz, char *response);
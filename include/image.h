@@ -294,6 +294,7 @@ enum {
 	IH_COMP_LZO,			/* lzo   Compression Used	*/
 	IH_COMP_LZ4,			/* lz4   Compression Used	*/
 	IH_COMP_ZIMAGE,			/* zImage Decompressed itself   */
+	IH_COMP_ZSTD,			/* zstd  Compression Used	*/
 
 	IH_COMP_COUNT,
 };
@@ -598,6 +599,22 @@ int boot_get_ramdisk(int argc, char * const argv[], bootm_headers_t *images,
  */
 int boot_get_loadable(int argc, char * const argv[], bootm_headers_t *images,
 		uint8_t arch, const ulong *ld_start, ulong * const ld_len);
+
+/**
+ * boot_load_loadable - load one of the loadables of a FIT configuration
+ * @images: pointer to the bootm images structure
+ * @arch: expected architecture for the image
+ * @uname: name of the image node
+ *
+ * This does for one image what boot_get_loadable() does for all of them,
+ * so that a caller can use each image as soon as it is loaded.
+ *
+ * @return:
+ *     0, if the image is loaded
+ *     error code, if an error occurs during fit_image_load
+ */
+int boot_load_loadable(bootm_headers_t *images, uint8_t arch,
+		       const char *uname);
 #endif /* !USE_HOSTCC */
 
 int boot_get_setup_fit(bootm_headers_t *images, uint8_t arch,
@@ -921,6 +938,7 @@ int bootz_setup(ulong image, ulong *start, ulong *end);
 #define FIT_DATA_POSITION_PROP	"data-position"
 #define FIT_DATA_OFFSET_PROP	"data-offset"
 #define FIT_DATA_SIZE_PROP	"data-size"
+#define FIT_DATA_EXTENT_PROP	"data-extent"
 #define FIT_TIMESTAMP_PROP	"timestamp"
 #define FIT_TOTALSIZE_PROP	"totalsize"
 #define FIT_VERSION_PROP	"version"
@@ -1070,6 +1088,22 @@ int fit_config_verify(const void *fit, int conf_noffset);
 int fit_all_image_verify(const void *fit);
 int fit_board_verify_required_sigs(void);
 
+/**
+ * board_fit_hash_verified() - Check if data was hashed earlier in the boot
+ *
+ * Called before an image hash is calculated, so that a board can skip
+ * hashing data that a previous boot stage has already verified.
+ *
+ * @data: image data to be hashed
+ * @size: size of @data
+ * @algo: hash algorithm name, e.g. "sha256"
+ * @value: expected hash value from the FIT
+ * @value_len: length of @value
+ * @return 1 if @data is known to hash to @value, 0 to calculate the hash
+ */
+int board_fit_hash_verified(const void *data, size_t size, const char *algo,
+			    const uint8_t *value, int value_len);
+
 int fit_image_check_os(const void *fit, int noffset, uint8_t os);
 int fit_image_check_arch(const void *fit, int noffset, uint8_t arch);
 int fit_image_check_type(const void *fit, int noffset, uint8_t type);
@@ -1371,6 +1405,102 @@ void android_image_set_decomp(struct andr_img_hdr *hdr, int comp);
 int android_image_parse_comp(struct andr_img_hdr *hdr, ulong *load_addr);
 int android_image_memcpy_separate(struct andr_img_hdr *hdr, ulong *load_address);
 
+#define ANDROID_PLACE_MAX	3
+
+/**
+ * struct android_place - A boot image section that AVB reads in place
+ *
+ * @part: partition name, with the slot suffix
+ * @img: section, private to image-android.c
+ * @offset: where the section is in the partition, block aligned
+ * @len: section size
+ * @dst: where image_load() puts the section
+ * @mem: sysmem region id holding @dst
+ * @mem_base: sysmem region base
+ * @mem_size: sysmem region size
+ * @claimed: the region is reserved and the section read to @dst
+ */
+struct android_place {
+	char part[32];
+	int img;
+	ulong offset;
+	ulong len;
+	ulong dst;
+	int mem;
+	ulong mem_base;
+	ulong mem_size;
+	bool claimed;
+};
+
+#ifdef CONFIG_ANDROID_AVB_PRELOAD_IN_PLACE
+/**
+ * android_image_place_prepare() - Plan the sections AVB reads in place
+ *
+ * The kernel and the ramdisks are planned to be read straight to their
+ * load address, so that android_image_memcpy_separate() has nothing to
+ * copy but the small sections.
+ *
+ * @hdr: header from populate_andr_img_hdr(), not verified yet
+ * @boot_part: boot or recovery, without the slot suffix
+ * @slot_suffix: slot suffix
+ * @load_address: kernel_addr_r
+ *
+ * @return number of sections planned, or negative errno
+ */
+int android_image_place_prepare(struct andr_img_hdr *hdr,
+				const char *boot_part,
+				const char *slot_suffix,
+				ulong load_address);
+
+/**
+ * android_image_place_next() - The next planned section of a partition
+ *
+ * @part: partition name, with the slot suffix
+ * @offset: offset in the partition
+ *
+ * @return the first section at or after @offset, NULL if none
+ */
+struct android_place *android_image_place_next(const char *part,
+					       ulong offset);
+
+/**
+ * android_image_place_claim() - Reserve the load address of a section
+ *
+ * Called right before the section is read to place->dst.
+ *
+ * @place: section from android_image_place_next()
+ *
+ * @return 0 on success, otherwise the section is to be read as usual
+ */
+int android_image_place_claim(struct android_place *place);
+
+/**
+ * android_image_place_reset() - Drop the plan and free what was claimed
+ */
+void android_image_place_reset(void);
+#else
+static inline int android_image_place_prepare(struct andr_img_hdr *hdr,
+					      const char *boot_part,
+					      const char *slot_suffix,
+					      ulong load_address)
+{
+	return 0;
+}
+
+static inline struct android_place *
+android_image_place_next(const char *part, ulong offset)
+{
+	return NULL;
+}
+
+static inline int android_image_place_claim(struct android_place *place)
+{
+	return -1;
+}
+
+static inline void android_image_place_reset(void) {}
+#endif
+
 struct andr_img_hdr *populate_andr_img_hdr(struct blk_desc *dev_desc,
 					   disk_partition_t *part_boot);
 int populate_boot_info(const struct boot_img_hdr_v34 *boot_hdr,
@@ -1444,8 +1574,52 @@ int board_fit_config_name_match(const char *name);
 void board_fit_image_post_process(void *fit, int node, ulong *load_addr,
 				  ulong **src_addr, size_t *size, void *spec);
 
+#ifdef CONFIG_SPL_FIT_IMAGE_STREAM
+/**
+ * board_fit_image_stream() - Process FIT binary data while it is loaded
+ *
+ * SPL loads large external data in chunks and calls this after each one,
+ * so that e.g. a hardware decompressor can start on the image before its
+ * last block is read. The last 4 bytes of the data are loaded before the
+ * first call. board_fit_image_post_process() is still called afterwards
+ * and must finish whatever was started here.
+ *
+ * @fit: fit blob
+ * @node: image node
+ * @load_addr: load address of the image (uncompressed)
+ * @src: start of the image data, or NULL to abort a stream started earlier
+ *	 (e.g. the image failed verification)
+ * @avail: bytes of @src loaded so far
+ * @total: full size of the image data
+ * @spec: struct spl_load_info info
+ *
+ * @return 0 to be called for the next chunk, -ve to load the rest without
+ * further calls
+ */
+int board_fit_image_stream(void *fit, int node, ulong load_addr,
+			   const void *src, size_t avail, size_t total,
+			   void *spec);
+#endif
+
 #endif /* CONFIG_SPL_FIT_IMAGE_POST_PROCESS */
 
+#ifndef USE_HOSTCC
+/**
+ * board_fit_image_verified() - Note an image SPL has verified on the device
+ *
+ * Called once the hashes and signature of external image data read from a
+ * block device are checked, so that a board can pass them on to the next
+ * stage, see board_fit_hash_verified().
+ *
+ * @fit: fit blob
+ * @node: image node
+ * @offset: byte offset of the image data from the start of the device
+ * @size: size of the image data
+ */
+void board_fit_image_verified(const void *fit, int node, u64 offset,
+			      size_t size);
+#endif
+
 #define FDT_ERROR	((ulong)(-1))
 
 ulong fdt_getprop_u32(const void *fdt, int node, const char *prop);
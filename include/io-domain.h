@@ -8,9 +8,36 @@
 
 #include <dm.h>
 
+/**
+ * struct dm_io_domain_ops - Driver model io-domain operations
+ */
+struct dm_io_domain_ops {
+	/**
+	 * supply_changed() - Set the domains of a supply up for a voltage
+	 *
+	 * @dev:	io-domain device
+	 * @reg:	regulator supplying some domains
+	 * @uV:		the voltage it is changed to
+	 * @return 0 if OK, or if @reg supplies no domain of @dev, -ve on error
+	 */
+	int (*supply_changed)(struct udevice *dev, struct udevice *reg, int uV);
+};
+
 /**
  * io_domain_init() - init io-domain driver
  */
 int io_domain_init(void);
 
+/**
+ * io_domain_supply_changed() - Set the domains of a supply up for a voltage
+ *
+ * Called before a supply goes up and after it went down, so the pins are
+ * never in 1.8V mode at a 3.3V supply.
+ *
+ * @reg:	regulator supplying some domains
+ * @uV:		the voltage it is changed to
+ * @return 0 if OK, -ve on error
+ */
+int io_domain_supply_changed(struct udevice *reg, int uV);
+
 #endif	/* _IO_DOMAIN_H_ */
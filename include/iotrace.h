@@ -83,8 +83,9 @@ int iotrace_get_enabled(void);
  * the start of the buffer.
  *
  * The buffer can be 0 size in which case the checksum is updated but no
- * trace records are writen. If the buffer is exhausted, the offset will
- * continue to increase but not new data will be written.
+ * trace records are writen, and each 32-bit access is printed as it is made.
+ * If the buffer is exhausted, the offset will continue to increase but not
+ * new data will be written, unless ring mode is on.
  *
  * @start: Start address of buffer
  * @size: Size of buffer in bytes
@@ -97,9 +98,64 @@ void iotrace_set_buffer(ulong start, ulong size);
  * @start: Returns start address of buffer
  * @size: Returns size of buffer in bytes
  * @offset: Returns the byte offset where the next output trace record will
- * @count: Returns the number of trace records recorded
  * be written (or would be if the buffer was large enough)
+ * @count: Returns the number of trace records recorded, including those
+ * which did not fit or were overwritten
  */
 void iotrace_get_buffer(ulong *start, ulong *size, ulong *offset, ulong *count);
 
+/**
+ * iotrace_set_ring() - Set whether the buffer is a ring
+ *
+ * In ring mode the newest record overwrites the oldest once the buffer is
+ * full, so the buffer holds the accesses leading up to a hang rather than
+ * the ones just after tracing started.
+ *
+ * @ring: true to overwrite the oldest records, false to stop storing
+ */
+void iotrace_set_ring(int ring);
+
+/**
+ * iotrace_get_ring() - Get whether the buffer is a ring
+ *
+ * @return true if in ring mode, false if not
+ */
+int iotrace_get_ring(void);
+
+#define IOTRACE_MAX_FILTERS	4
+
+/**
+ * iotrace_add_filter() - Only trace accesses to an address range
+ *
+ * With no filters every access is traced. Once one is added, accesses
+ * outside all of them are neither recorded nor added to the checksum.
+ *
+ * @start: Start address of the range
+ * @size: Size of the range in bytes
+ * @return 0 if OK, -ENOSPC if there are IOTRACE_MAX_FILTERS already,
+ *	-EINVAL if @size is 0
+ */
+int iotrace_add_filter(ulong start, ulong size);
+
+/**
+ * iotrace_clear_filters() - Trace accesses to all addresses again
+ */
+void iotrace_clear_filters(void);
+
+/**
+ * iotrace_print_filters() - Print the address ranges traced
+ */
+void iotrace_print_filters(void);
+
+/**
+ * iotrace_print_summary() - Print the registers accessed most
+ *
+ * Goes through the records in the buffer, oldest first, and lists the
+ * registers with the most accesses, then those which were polled longest:
+ * the time spent reading a register again for the value it had.
+ *
+ * @top: Number of registers in each list
+ */
+void iotrace_print_summary(int top);
+
 #endif /* __IOTRACE_H */
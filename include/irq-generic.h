@@ -102,6 +102,12 @@ int irqs_resume(void);
 int irq_is_busy(int irq);
 int gpio_to_irq(struct gpio_desc *gpio);
 
+/*
+ * The registers of the code an interrupt came in on, for its handler to
+ * look at. Only valid inside a handler.
+ */
+struct pt_regs *get_irq_regs(void);
+
 /*
  * Assign gpio to irq directly. Don't use it without special reasons.
  *
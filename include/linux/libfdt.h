@@ -305,6 +305,22 @@ int fdt_next_region(const void *fdt,
  */
 int fdt_add_alias_regions(const void *fdt, struct fdt_region *region, int count,
 			  int max_regions, struct fdt_region_state *info);
+
+/**
+ * fdt_overlay_apply_multi() - Apply several overlays in a row
+ *
+ * The same as fdt_overlay_apply() on each overlay in turn, without walking
+ * the base tree again for each of them: its highest phandle is carried
+ * over, and the labels in __symbols__ are resolved once for all overlays.
+ *
+ * @fdt:	Base device tree, with room for all the overlays
+ * @fdtos:	Overlays, applied in this order
+ * @count:	Number of overlays
+ * @return 0 on success, or -FDT_ERR_... on failure. As with
+ * fdt_overlay_apply(), the overlays are damaged either way, and so is the
+ * base tree on failure.
+ */
+int fdt_overlay_apply_multi(void *fdt, void * const fdtos[], int count);
 #endif /* SWIG */
 
 extern struct fdt_header *working_fdt;  /* Pointer to the working fdt */
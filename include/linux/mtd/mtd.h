@@ -153,6 +153,23 @@ struct nand_ecclayout {
 
 struct module;	/* only needed for owner field in mtd_info */
 
+/**
+ * struct mtd_eb_stats - ECC history of one eraseblock
+ * @reads: pages read with ECC enabled
+ * @corrected: bitflips corrected, summed over all the reads
+ * @failed: page reads with uncorrectable errors
+ * @max_bitflips: most bitflips seen in one ECC step of a page
+ *
+ * A block whose @max_bitflips keeps climbing towards the ECC strength is
+ * being worn or read-disturbed, and should be rewritten before it fails.
+ */
+struct mtd_eb_stats {
+	u32 reads;
+	u32 corrected;
+	u16 failed;
+	u16 max_bitflips;
+};
+
 struct mtd_info {
 	u_char type;
 	uint32_t flags;
@@ -301,6 +318,10 @@ struct mtd_info {
 
 	/* ECC status information */
 	struct mtd_ecc_stats ecc_stats;
+#ifdef CONFIG_MTD_ECC_STATS
+	/* Per eraseblock ECC history, allocated on the first read */
+	struct mtd_eb_stats *eb_stats;
+#endif
 	/* Subpage shift (NAND) */
 	int subpage_sft;
 
@@ -450,6 +471,33 @@ int mtd_block_isreserved(struct mtd_info *mtd, loff_t ofs);
 int mtd_block_isbad(struct mtd_info *mtd, loff_t ofs);
 int mtd_block_markbad(struct mtd_info *mtd, loff_t ofs);
 
+#ifdef CONFIG_MTD_ECC_STATS
+void mtd_ecc_stats_record(struct mtd_info *mtd, loff_t ofs, int bitflips);
+const struct mtd_eb_stats *mtd_ecc_stats_get(struct mtd_info *mtd, loff_t ofs);
+void mtd_ecc_stats_reset(struct mtd_info *mtd);
+bool mtd_block_needs_refresh(struct mtd_info *mtd, loff_t ofs);
+#else
+static inline void mtd_ecc_stats_record(struct mtd_info *mtd, loff_t ofs,
+					int bitflips)
+{
+}
+
+static inline const struct mtd_eb_stats *
+mtd_ecc_stats_get(struct mtd_info *mtd, loff_t ofs)
+{
+	return NULL;
+}
+
+static inline void mtd_ecc_stats_reset(struct mtd_info *mtd)
+{
+}
+
+static inline bool mtd_block_needs_refresh(struct mtd_info *mtd, loff_t ofs)
+{
+	return false;
+}
+#endif
+
 #ifndef __UBOOT__
 static inline int mtd_suspend(struct mtd_info *mtd)
 {
@@ -267,6 +267,9 @@ int ubi_leb_map(struct ubi_volume_desc *desc, int lnum);
 int ubi_is_mapped(struct ubi_volume_desc *desc, int lnum);
 int ubi_sync(int ubi_num);
 int ubi_flush(int ubi_num, int vol_id, int lnum);
+#ifdef __UBOOT__
+void ubi_sync_fastmap(void);
+#endif
 
 /*
  * This function is the same as the 'ubi_leb_read()' function, but it does not
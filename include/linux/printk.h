@@ -28,10 +28,21 @@
 	0;						\
 })
 
+#if CONFIG_IS_ENABLED(CONSOLE_QUIET)
+/* printf() which a quiet console shows if @level is severe enough */
+int __printf(2, 3) printk_level(int level, const char *fmt, ...);
+
+#define __printk(level, fmt, ...)					\
+({									\
+	level < CONFIG_LOGLEVEL ?					\
+		printk_level(level, fmt, ##__VA_ARGS__) : 0;		\
+})
+#else
 #define __printk(level, fmt, ...)					\
 ({									\
 	level < CONFIG_LOGLEVEL ? printk(fmt, ##__VA_ARGS__) : 0;	\
 })
+#endif
 
 #ifndef pr_fmt
 #define pr_fmt(fmt) fmt
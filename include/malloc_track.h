@@ -0,0 +1,36 @@
+/* SPDX-License-Identifier:     GPL-2.0+ */
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ */
+
+#ifndef _MALLOC_TRACK_H
+#define _MALLOC_TRACK_H
+
+#if CONFIG_IS_ENABLED(MALLOC_TRACK)
+/**
+ * malloc_track_alloc() - Record an allocation, called by dlmalloc
+ *
+ * @ptr: allocated buffer, NULL if the allocation failed
+ * @size: requested size
+ * @caller: return address of the malloc() call
+ */
+void malloc_track_alloc(void *ptr, size_t size, void *caller);
+
+/**
+ * malloc_track_free() - Record a free, called by dlmalloc
+ *
+ * @ptr: buffer being freed
+ */
+void malloc_track_free(void *ptr);
+
+/**
+ * malloc_track_dump() - Dump malloc usage, by size class and call site
+ *
+ * @max_sites: number of call sites to show, biggest peak first, 0 for all
+ */
+void malloc_track_dump(uint max_sites);
+#else
+static inline void malloc_track_dump(uint max_sites) {}
+#endif
+
+#endif /* _MALLOC_TRACK_H */
@@ -0,0 +1,52 @@
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:     GPL-2.0+
+ */
+
+#ifndef __MEM_LARGE_H
+#define __MEM_LARGE_H
+
+#include <linux/string.h>
+#include <linux/types.h>
+
+#ifdef CONFIG_ROCKCHIP_MEM_LARGE
+/**
+ * memset_large() - memset() for regions of several megabytes
+ *
+ * Regions above a threshold are split over the boot CPU and the secondary
+ * CPU worker pool; a zero fill uses DC ZVA to clear whole cache blocks
+ * without reading them first. Smaller regions go straight to memset().
+ *
+ * @s:		Start of the region
+ * @c:		Fill byte
+ * @n:		Size of the region in bytes
+ * @return @s
+ */
+void *memset_large(void *s, int c, size_t n);
+
+/**
+ * memcpy_large() - memcpy() for regions of several megabytes
+ *
+ * Like memset_large(), splits the copy over all CPUs. Overlapping regions
+ * are handed to memmove() on the boot CPU.
+ *
+ * @dst:	Destination
+ * @src:	Source
+ * @n:		Number of bytes to copy
+ * @return @dst
+ */
+void *memcpy_large(void *dst, const void *src, size_t n);
+#else
+static inline void *memset_large(void *s, int c, size_t n)
+{
+	return memset(s, c, n);
+}
+
+static inline void *memcpy_large(void *dst, const void *src, size_t n)
+{
+	return memmove(dst, src, n);
+}
+#endif
+
+#endif
@@ -6,6 +6,8 @@
 #ifndef _MEMBLK_H
 #define _MEMBLK_H
 
+#include <linux/rbtree.h>
+
 #define ALIAS_COUNT_MAX		2
 #define MEM_RESV_COUNT		10
 
@@ -57,10 +59,71 @@ struct memblock {
 	phys_addr_t orig_base;
 	struct memblk_attr attr;
 	struct list_head node;
+	struct rb_node rb;
+	struct rb_node name_rb;
+	phys_addr_t subtree_end;	/* highest end of the rb subtree */
+};
+
+/* Memblocks indexed by address and by name, names must be unique */
+struct memblk_tree {
+	struct rb_root addr;
+	struct rb_root name;
 };
 
 extern const struct memblk_attr *mem_attr;
 
+#define MEMBLK_TREE_INIT	((struct memblk_tree) { RB_ROOT, RB_ROOT })
+
+/**
+ * memblk_tree_insert() - Add a memblock to the index
+ *
+ * @tree: memblock index
+ * @mem: memblock, its base, size and attr.name must be set
+ */
+void memblk_tree_insert(struct memblk_tree *tree, struct memblock *mem);
+
+/**
+ * memblk_tree_erase() - Remove a memblock from the index
+ *
+ * @tree: memblock index
+ * @mem: memblock added by memblk_tree_insert()
+ */
+void memblk_tree_erase(struct memblk_tree *tree, struct memblock *mem);
+
+/**
+ * memblk_tree_overlap() - Find the lowest memblock overlapping a region
+ *
+ * @tree: memblock index
+ * @base: region base
+ * @size: region size
+ *
+ * @return NULL if none, otherwise the memblock
+ */
+struct memblock *memblk_tree_overlap(struct memblk_tree *tree,
+				     phys_addr_t base, phys_size_t size);
+
+/**
+ * memblk_tree_find_base() - Find the memblock at an address
+ *
+ * @tree: memblock index
+ * @base: memblock base
+ *
+ * @return NULL if none, otherwise the memblock
+ */
+struct memblock *memblk_tree_find_base(struct memblk_tree *tree,
+				       phys_addr_t base);
+
+/**
+ * memblk_tree_find_name() - Find a memblock by name
+ *
+ * @tree: memblock index
+ * @name: memblock attr.name
+ *
+ * @return NULL if none, otherwise the memblock
+ */
+struct memblock *memblk_tree_find_name(struct memblk_tree *tree,
+				       const char *name);
+
 #define SIZE_MB(len)		((len) >> 20)
 #define SIZE_KB(len)		(((len) % (1 << 20)) >> 10)
 
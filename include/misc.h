@@ -17,6 +17,7 @@
 #define IOCTL_REQ_POLL		_IO('m', 0x03)
 #define IOCTL_REQ_CAPABILITY	_IO('m', 0x04)
 #define IOCTL_REQ_DATA_SIZE	_IO('m', 0x05)
+#define IOCTL_REQ_FEED		_IO('m', 0x06)
 
 enum misc_mode {
 	DECOM_LZ4	= BIT(0),
@@ -158,11 +159,125 @@ struct decom_param {
 
 /* function flags for decompress */
 #define DCOMP_FLG_IRQ_ONESHOT	BIT(0)
+/*
+ * size_src is only the part of the input loaded so far, the rest is
+ * handed over window by window with IOCTL_REQ_FEED.
+ */
+#define DCOMP_FLG_STREAM	BIT(1)
+/* The job may still be running when the OS is entered, e.g. the ramdisk */
+#define DCOMP_FLG_BOOT_ASYNC	BIT(2)
 
-void misc_decompress_async(u8 comp);
-void misc_decompress_sync(u8 comp);
+/**
+ * struct decom_job - A decompression queued on the engine
+ *
+ * @dst:	output address, must be ARCH_DMA_MINALIGN aligned
+ * @src:	compressed data, must stay intact until the job completes
+ * @src_len:	size of the compressed data
+ * @comp:	DECOM_GZIP or DECOM_LZ4
+ * @flags:	DCOMP_FLG_*
+ * @complete:	optional, called once the job is done with its result and
+ *		decompressed size. It may submit further jobs.
+ * @priv:	for use by @complete
+ */
+struct decom_job {
+	unsigned long dst;
+	unsigned long src;
+	unsigned long src_len;
+	u32 comp;
+	u32 flags;
+	void (*complete)(const struct decom_job *job, int ret, u64 size);
+	void *priv;
+};
+
+/**
+ * misc_decompress_submit() - Queue a decompression
+ *
+ * Jobs on one engine run in submit order. This does not wait for jobs
+ * already queued unless all slots are in use.
+ *
+ * @job:	the job, copied
+ * @return 0 if queued, -ve on error
+ */
+int misc_decompress_submit(const struct decom_job *job);
+
+/**
+ * misc_decompress_poll() - Reap finished jobs and start queued ones
+ *
+ * @return number of jobs not completed yet
+ */
+int misc_decompress_poll(void);
+
+/**
+ * misc_decompress_wait_all() - Wait for all jobs
+ *
+ * Jobs with DCOMP_FLG_BOOT_ASYNC are started but not waited for.
+ *
+ * @return 0 if OK, or the error of the first job that failed since the
+ * last call
+ */
+int misc_decompress_wait_all(void);
+
+/* misc_decompress_wait_all() just before jumping to the OS */
 int misc_decompress_cleanup(void);
 int misc_decompress_process(unsigned long dst, unsigned long src,
 			    unsigned long src_len, u32 cap, bool sync,
 			    u64 *size, u32 flags);
+
+/**
+ * misc_decompress_stream_start() - Start decompressing partly loaded data
+ *
+ * Only the first @src_len bytes of the compressed data need to be in memory,
+ * plus its last 4 bytes when the decompressed size is taken from a trailer
+ * (gzip, lz4 without content size). The rest is passed in with
+ * misc_decompress_stream_feed() as it is loaded.
+ *
+ * @dst:	output address, must be ARCH_DMA_MINALIGN aligned
+ * @src:	compressed data
+ * @src_len:	bytes of @src loaded so far
+ * @total_len:	full size of the compressed data
+ * @comp:	DECOM_GZIP or DECOM_LZ4
+ * @flags:	DCOMP_FLG_*
+ * @return 0 if OK, -ve on error (nothing started)
+ */
+int misc_decompress_stream_start(unsigned long dst, unsigned long src,
+				 unsigned long src_len, unsigned long total_len,
+				 u32 comp, u32 flags);
+
+/**
+ * misc_decompress_stream_feed() - Hand the next source window to the engine
+ *
+ * Windows must follow each other in memory. This waits for the engine to
+ * consume the previous window, so that the caller can load the next one
+ * meanwhile.
+ *
+ * @src:	start of the new window
+ * @src_len:	bytes in the window
+ * @comp:	as passed to misc_decompress_stream_start()
+ * @return 0 if OK, -ve on error
+ */
+int misc_decompress_stream_feed(unsigned long src, unsigned long src_len,
+				u32 comp);
+
+/**
+ * misc_decompress_stream_end() - Finish a stream once all data is fed
+ *
+ * Same as the tail of misc_decompress_process(): with @sync this waits for
+ * the engine, otherwise completion is left to misc_decompress_cleanup().
+ *
+ * @src:	compressed data, as passed to misc_decompress_stream_start()
+ * @src_len:	full size of the compressed data
+ * @comp:	DECOM_GZIP or DECOM_LZ4
+ * @sync:	wait for the engine
+ * @size:	returns the decompressed size
+ * @return 0 if OK, -ve on error
+ */
+int misc_decompress_stream_end(unsigned long src, unsigned long src_len,
+			       u32 comp, bool sync, u64 *size);
+
+/**
+ * misc_decompress_stream_abort() - Stop a stream that will not be completed
+ *
+ * @comp:	as passed to misc_decompress_stream_start()
+ */
+void misc_decompress_stream_abort(u32 comp);
 #endif	/* _MISC_H_ */
@@ -61,6 +61,14 @@
 #define MMC_MODE_HS200		(1 << 6)
 #define MMC_MODE_HS400		(1 << 7)
 #define MMC_MODE_HS400ES	(1 << 8)
+#define MMC_MODE_UHS_SDR50	(1 << 9)
+#define MMC_MODE_UHS_SDR104	(1 << 10)
+#define MMC_MODE_UHS_DDR50	(1 << 11)
+/* The host has a command queue engine, see dm_mmc_ops.cqe_request() */
+#define MMC_CAP_CQE		(1 << 12)
+
+#define MMC_MODE_UHS		(MMC_MODE_UHS_SDR50 | MMC_MODE_UHS_SDR104 | \
+				 MMC_MODE_UHS_DDR50)
 
 #define SD_DATA_4BIT	0x00040000
 
@@ -117,11 +125,21 @@
 /* SCR definitions in different words */
 #define SD_HIGHSPEED_BUSY	0x00020000
 #define SD_HIGHSPEED_SUPPORTED	0x00020000
+#define SD_UHS_SDR50_SUPPORTED	0x00040000
+#define SD_UHS_SDR104_SUPPORTED	0x00080000
+#define SD_UHS_DDR50_SUPPORTED	0x00100000
+
+/* Access modes of the SD switch function group 1 */
+#define SD_ACCESS_MODE_SDR25	1	/* high speed */
+#define SD_ACCESS_MODE_SDR50	2
+#define SD_ACCESS_MODE_SDR104	3
+#define SD_ACCESS_MODE_DDR50	4
 
 #define OCR_BUSY		0x80000000
 #define OCR_HCS			0x40000000
 #define OCR_VOLTAGE_MASK	0x007FFF80
 #define OCR_ACCESS_MODE		0x60000000
+#define OCR_S18R		0x01000000	/* 1.8V signaling, S18A in R3 */
 
 #define MMC_ERASE_ARG		0x00000000
 #define MMC_SECURE_ERASE_ARG	0x80000000
@@ -172,6 +190,7 @@
 /*
  * EXT_CSD fields
  */
+#define EXT_CSD_CMDQ_MODE_EN		15	/* R/W */
 #define EXT_CSD_ENH_START_ADDR		136	/* R/W */
 #define EXT_CSD_ENH_SIZE_MULT		140	/* R/W */
 #define EXT_CSD_GP_SIZE_MULT		143	/* R/W */
@@ -187,6 +206,7 @@
 #define EXT_CSD_ERASE_GROUP_DEF		175	/* R/W */
 #define EXT_CSD_BOOT_BUS_WIDTH		177
 #define EXT_CSD_PART_CONF		179	/* R/W */
+#define EXT_CSD_ERASED_MEM_CONT		181	/* RO */
 #define EXT_CSD_BUS_WIDTH		183	/* R/W */
 #define EXT_CSD_STROBE_SUPPORT		184	/* RO */
 #define EXT_CSD_HS_TIMING		185	/* R/W */
@@ -196,9 +216,12 @@
 #define EXT_CSD_DRIVER_STRENGTH		197	/* RO */
 #define EXT_CSD_SEC_CNT			212	/* RO, 4 bytes */
 #define EXT_CSD_HC_WP_GRP_SIZE		221	/* RO */
+#define EXT_CSD_REL_WR_SEC_C		222	/* RO */
 #define EXT_CSD_HC_ERASE_GRP_SIZE	224	/* RO */
 #define EXT_CSD_BOOT_MULT		226	/* RO */
 #define EXT_CSD_SEC_FEATURE_SUPPORT     231     /* RO */
+#define EXT_CSD_CMDQ_DEPTH		307	/* RO */
+#define EXT_CSD_CMDQ_SUPPORT		308	/* RO */
 #define EXT_CSD_BKOPS_SUPPORT		502	/* RO */
 
 /*
@@ -277,6 +300,9 @@
 #define MMC_RSP_BUSY	(1 << 3)		/* card may send busy */
 #define MMC_RSP_OPCODE	(1 << 4)		/* response contains opcode */
 
+#define EXT_CSD_CMDQ_DEPTH_MASK	0x1f
+#define EXT_CSD_CMDQ_SUPPORTED	BIT(0)
+
 #define EXT_CSD_SEC_ER_EN      BIT(0)
 #define EXT_CSD_SEC_BD_BLK_EN  BIT(2)
 #define EXT_CSD_SEC_GB_CL_EN   BIT(4)
@@ -342,14 +368,15 @@ int finish_rpmb(void);
 int do_readcounter(struct s_rpmb *requestpackets);
 int do_programkey(struct s_rpmb *requestpackets);
 int do_authenticatedread(struct s_rpmb *requestpackets, uint16_t block_count);
-int do_authenticatedwrite(struct s_rpmb *requestpackets);
+int do_authenticatedwrite(struct s_rpmb *requestpackets, uint16_t block_count);
 struct mmc *do_returnmmc(void);
 
 int read_counter(struct mmc *mmc, struct s_rpmb *requestpackets);
 int program_key(struct mmc *mmc, struct s_rpmb *requestpackets);
 int authenticated_read
 	(struct mmc *mmc, struct s_rpmb *requestpackets, uint16_t block_count);
-int authenticated_write(struct mmc *mmc, struct s_rpmb *requestpackets);
+int authenticated_write(struct mmc *mmc, struct s_rpmb *requestpackets,
+			uint16_t block_count);
 
 /* Driver model support */
 
@@ -362,6 +389,7 @@ struct mmc_uclass_priv {
 
 struct emmc_esr {
 	unsigned int mmc_can_trim;
+	unsigned int mmc_erase_zero;	/* erased blocks read back as 0 */
 };
 
 /**
@@ -405,6 +433,7 @@ struct mmc_data {
 
 /* forward decl. */
 struct mmc;
+struct blk_sg;
 
 #if CONFIG_IS_ENABLED(DM_MMC)
 struct dm_mmc_ops {
@@ -427,9 +456,38 @@ struct dm_mmc_ops {
 	 * @data:	Additional data to send/receive
 	 * @return 0 if OK, -ve on error
 	 */
-#ifdef CONFIG_SPL_BLK_READ_PREPARE
+#if defined(CONFIG_SPL_BLK_READ_PREPARE) || CONFIG_IS_ENABLED(BLK_READ_ASYNC)
 	int (*send_cmd_prepare)(struct udevice *dev, struct mmc_cmd *cmd,
 				struct mmc_data *data);
+#endif
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+	/**
+	 * wait_data() - Wait for the data of send_cmd_prepare() to complete
+	 *
+	 * @dev:	Device which received the command
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*wait_data)(struct udevice *dev);
+#endif
+#if CONFIG_IS_ENABLED(BLK_READ_SG)
+	/**
+	 * send_cmd_sg() - Send a data command using a list of buffers
+	 *
+	 * Like send_cmd(), but the data is moved to/from the segments in @sg
+	 * rather than data->dest. data->blocks is the total over all
+	 * segments. May fail with -EINVAL if a segment can't be used for DMA
+	 * directly, in which case the caller falls back to send_cmd().
+	 *
+	 * @dev:	Device to receive the command
+	 * @cmd:	Command to send
+	 * @data:	Data transfer, without a buffer
+	 * @sg:		Data segments
+	 * @nsegs:	Number of segments in @sg
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*send_cmd_sg)(struct udevice *dev, struct mmc_cmd *cmd,
+			   struct mmc_data *data, const struct blk_sg *sg,
+			   int nsegs);
 #endif
 	/**
 	 * card_busy() - Query the card device status
@@ -475,6 +533,34 @@ struct dm_mmc_ops {
 	int (*execute_tuning)(struct udevice *dev, u32 opcode);
 	/* set_enhanced_strobe() - set HS400 enhanced strobe */
 	int (*set_enhanced_strobe)(struct udevice *dev);
+#if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT)
+	/**
+	 * set_signal_voltage() - Switch the I/O lines to mmc->signal_voltage
+	 *
+	 * For the 1.8V switch of an SD card this is called after CMD11: the
+	 * clock is stopped for at least 5ms while the I/O supply changes,
+	 * then it is given to the card again.
+	 *
+	 * @dev:	Device to update
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*set_signal_voltage)(struct udevice *dev);
+#endif
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	/**
+	 * cqe_request() - Transfer data with the command queue engine
+	 *
+	 * The card is already in command queue mode when this is called.
+	 * Only used on a host which sets MMC_CAP_CQE in its host_caps.
+	 *
+	 * @dev:	Device to transfer with
+	 * @data:	Data to transfer
+	 * @start:	Start block address on the card
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*cqe_request)(struct udevice *dev, struct mmc_data *data,
+			   lbaint_t start);
+#endif
 };
 
 #define mmc_get_ops(dev)        ((struct dm_mmc_ops *)(dev)->driver->ops)
@@ -482,6 +568,14 @@ struct dm_mmc_ops {
 int dm_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 		    struct mmc_data *data);
 int dm_mmc_set_ios(struct udevice *dev);
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+int dm_mmc_wait_data(struct udevice *dev);
+#endif
+#if CONFIG_IS_ENABLED(BLK_READ_SG)
+int dm_mmc_send_cmd_sg(struct udevice *dev, struct mmc_cmd *cmd,
+		       struct mmc_data *data, const struct blk_sg *sg,
+		       int nsegs);
+#endif
 int dm_mmc_get_cd(struct udevice *dev);
 int dm_mmc_get_wp(struct udevice *dev);
 
@@ -493,6 +587,9 @@ int mmc_getcd(struct mmc *mmc);
 int mmc_getwp(struct mmc *mmc);
 
 int mmc_set_enhanced_strobe(struct mmc *mmc);
+#if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT)
+int mmc_set_signal_voltage(struct mmc *mmc, uint signal_voltage);
+#endif
 #else
 struct mmc_ops {
 	bool (*card_busy)(struct mmc *mmc);
@@ -568,6 +665,14 @@ struct mmc {
 #define MMC_HIGH_52_MAX_DTR	52000000
 #define MMC_HIGH_DDR_MAX_DTR	52000000
 #define MMC_HS200_MAX_DTR	200000000
+#define UHS_SDR104_MAX_DTR	208000000
+#define UHS_SDR50_MAX_DTR	100000000
+#define UHS_DDR50_MAX_DTR	50000000
+
+	uint signal_voltage;
+
+#define MMC_SIGNAL_VOLTAGE_330	0
+#define MMC_SIGNAL_VOLTAGE_180	1
 
 	uint card_caps;
 	uint ocr;
@@ -580,7 +685,11 @@ struct mmc {
 	u8 part_support;
 	u8 part_attr;
 	u8 wr_rel_set;
+	u8 rel_wr_sec_c;	/* reliable write sectors, 2 RPMB frames each */
 	u8 part_config;
+#if CONFIG_IS_ENABLED(MMC_HWPART_LAZY)
+	u8 part_access;		/* hardware partition the card has selected */
+#endif
 	uint read_bl_len;
 	uint write_bl_len;
 	uint erase_grp_size;	/* in 512-byte sectors */
@@ -602,10 +711,22 @@ struct mmc {
 	char op_cond_pending;	/* 1 if we are waiting on an op_cond command */
 	char init_in_progress;	/* 1 if we have done mmc_start_init() */
 	char preinit;		/* start init as early as possible */
+#if CONFIG_IS_ENABLED(MMC_PARALLEL_INIT)
+	int start_err;		/* mmc_start_init_all() failure for mmc_init() */
+#endif
 #if CONFIG_IS_ENABLED(DM_MMC)
 	struct udevice *dev;	/* Device for this MMC controller */
 #endif
 	u8 raw_driver_strength;
+#if CONFIG_IS_ENABLED(BLK_READ_ASYNC)
+	uint async_blkcnt;	/* blocks of the outstanding async read */
+#endif
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	uint cqe_depth;		/* card command queue depth, 0 if none */
+#endif
+#if CONFIG_IS_ENABLED(MMC_STATS)
+	struct mmc_stats *stats;	/* command latencies, see mmc stat */
+#endif
 };
 
 struct mmc_hwpart_conf {
@@ -715,6 +836,27 @@ int board_mmc_getwp(struct mmc *mmc);
 #endif
 
 int mmc_set_dsr(struct mmc *mmc, u16 val);
+
+#if CONFIG_IS_ENABLED(MMC_STATS)
+/**
+ * mmc_stats_show() - print the latencies of the commands sent to a device
+ *
+ * Lists the count, errors and total, average and longest time of each
+ * command, with a histogram of its latencies, and the same for the busy
+ * waits after CMD6, CMD13 polling, tuning and mmc_init() as a whole.
+ *
+ * @mmc:	MMC device
+ */
+void mmc_stats_show(struct mmc *mmc);
+
+/**
+ * mmc_stats_reset() - clear the latencies counted for a device
+ *
+ * @mmc:	MMC device
+ */
+void mmc_stats_reset(struct mmc *mmc);
+#endif
+
 /* Function to change the size of boot partition and rpmb partitions */
 int mmc_boot_partition_size_change(struct mmc *mmc, unsigned long bootsize,
 					unsigned long rpmbsize);
@@ -760,6 +902,18 @@ int mmc_start_init(struct mmc *mmc);
  */
 void mmc_set_preinit(struct mmc *mmc, int preinit);
 
+/**
+ * mmc_start_init_all() - Identify the cards of all probed hosts at once
+ *
+ * Runs mmc_start_init() for every probed MMC host that has not been set up
+ * yet, each on its own CPU, so an empty slot timing out or an SD card
+ * taking its time to leave ACMD41 busy does not hold up the others. The
+ * hosts are powered on by the caller's CPU first. A later mmc_init()
+ * completes the init of the hosts that found a card and returns the error
+ * of the others once, without sending any command again.
+ */
+void mmc_start_init_all(void);
+
 #ifdef CONFIG_MMC_SPI
 #define mmc_host_is_spi(mmc)	((mmc)->cfg->host_caps & MMC_MODE_SPI)
 #else
@@ -132,6 +132,9 @@ enum eth_recv_flags {
  *		    ROM on the board. This is how the driver should expose it
  *		    to the network stack. This function should fill in the
  *		    eth_pdata::enetaddr field - optional
+ * rx_csum_ok: Return true if the MAC has verified both the IPv4 header
+ *	       checksum and the UDP/TCP checksum of the packet last returned
+ *	       by recv(), so the network stack need not - optional
  */
 struct eth_ops {
 	int (*start)(struct udevice *dev);
@@ -144,6 +147,7 @@ struct eth_ops {
 #endif
 	int (*write_hwaddr)(struct udevice *dev);
 	int (*read_rom_hwaddr)(struct udevice *dev);
+	bool (*rx_csum_ok)(struct udevice *dev, uchar *packet, int length);
 };
 
 #define eth_get_ops(dev) ((struct eth_ops *)(dev)->driver->ops)
@@ -526,6 +530,7 @@ extern uchar		*net_tx_packet;		/* THE transmit packet */
 extern uchar		*net_rx_packets[PKTBUFSRX]; /* Receive packets */
 extern uchar		*net_rx_packet;		/* Current receive packet */
 extern int		net_rx_packet_len;	/* Current rx packet length */
+extern bool		net_rx_csum_ok;		/* MAC verified its checksums */
 extern const u8		net_bcast_ethaddr[ARP_HLEN];	/* Ethernet broadcast address */
 extern const u8		net_null_ethaddr[ARP_HLEN];
 
@@ -589,6 +594,30 @@ extern struct in_addr net_mcast_addr;
 void net_init(void);
 int net_loop(enum proto_t);
 
+/**
+ * net_loop_start() - Start a transfer without waiting for it to finish
+ *
+ * This is net_loop() split in two, so that the caller can do other work,
+ * such as writing out what has been received so far, in between calls to
+ * net_loop_poll().
+ *
+ * @protocol:	Protocol to run, as for net_loop()
+ * @return 0 if started, -ve on error
+ */
+int net_loop_start(enum proto_t protocol);
+
+/**
+ * net_loop_poll() - Run one step of the transfer started by net_loop_start()
+ *
+ * Receives any pending packets and runs their handlers, and the timeout
+ * handler if it is due. The caller should come back quickly enough for the
+ * protocol's timeouts, a second or so is safe.
+ *
+ * @return -EAGAIN while the transfer is still going on, otherwise what
+ *	   net_loop() would have returned
+ */
+int net_loop_poll(void);
+
 /* Load failed.	 Start again. */
 int net_start_again(void);
 
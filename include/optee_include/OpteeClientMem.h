@@ -15,4 +15,6 @@ void *OpteeClientMemAlloc(uint32_t length);
 
 void  OpteeClientMemFree(void *mem);
 
+bool OpteeClientMemIsShared(void *mem, uint32_t length);
+
 #endif /*_OPTEE_CLIENT_MEM_H_*/
@@ -115,6 +115,21 @@ void part_print(struct blk_desc *dev_desc);
 void part_init(struct blk_desc *dev_desc);
 void dev_print(struct blk_desc *dev_desc);
 
+/**
+ * part_cache_invalidate() - Drop the parsed partition table of a device
+ *
+ * To be called by whoever rewrites the partition table behind the back of
+ * the partition drivers, the next lookup parses it again. The blk uclass
+ * calls it when a device is removed or unbound, which frees the table.
+ *
+ * @dev_desc: block device descriptor
+ */
+#if CONFIG_IS_ENABLED(PARTITION_CACHE)
+void part_cache_invalidate(struct blk_desc *dev_desc);
+#else
+static inline void part_cache_invalidate(struct blk_desc *dev_desc) {}
+#endif
+
 /**
  * blk_get_device_by_str() - Get a block device given its interface/hw partition
  *
@@ -237,6 +252,7 @@ static inline int part_get_info_whole_disk(struct blk_desc *dev_desc,
 static inline const char *part_get_type(struct blk_desc *dev_desc) { return NULL; }
 static inline void part_print(struct blk_desc *dev_desc) {}
 static inline void part_init(struct blk_desc *dev_desc) {}
+static inline void part_cache_invalidate(struct blk_desc *dev_desc) {}
 static inline void dev_print(struct blk_desc *dev_desc) {}
 static inline int blk_get_device_by_str(const char *ifname, const char *dev_str,
 					struct blk_desc **dev_desc)
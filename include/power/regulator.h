@@ -155,6 +155,8 @@ enum regulator_flag {
  * @name**     - fdt regulator name - should be taken from the device tree
  * ctrl_reg:   - Control register offset used to enable/disable regulator
  * volt_reg:   - register offset for writing voltage vsel values
+ * settle_at   - timer_get_us() time the output is stable at, while
+ *               regulators_enable_boot_on() runs
  *
  * Note:
  * *  - set automatically on device probe by the uclass's '.pre_probe' method.
@@ -181,6 +183,7 @@ struct dm_regulator_uclass_platdata {
 	bool ignore;
 	u32 suspend_uV;
 	u32 ramp_delay;
+	ulong settle_at;
 };
 
 /* Regulator device operations */
@@ -339,6 +342,18 @@ int regulator_get_enable(struct udevice *dev);
  */
 int regulator_set_enable(struct udevice *dev, bool enable);
 
+/**
+ * regulator_delay: wait for the output of a regulator to settle
+ *
+ * Drivers call this instead of udelay() after enabling an output or changing
+ * its value. With CONFIG_DM_REGULATOR_BATCH_DELAY the wait is deferred while
+ * regulators_enable_boot_on() runs, so that the rails ramp up together.
+ *
+ * @dev    - pointer to the regulator device
+ * @us     - time the output needs to settle [micro seconds]
+ */
+void regulator_delay(struct udevice *dev, uint us);
+
 /**
  * regulator_set_suspend_enable: set regulator suspend enable state
  *
@@ -391,6 +406,11 @@ int regulator_set_mode(struct udevice *dev, int mode_id);
  * since in that case it is not possible to know which value to use.
  *
  * This effectively calls regulator_autoset() for every regulator.
+ *
+ * With CONFIG_DM_REGULATOR_BATCH_DELAY the regulators don't wait for their
+ * output to settle one after the other: a regulator only waits for its
+ * "vin-supply" before it is enabled, and the longest remaining wait is done
+ * once at the end.
  */
 int regulators_enable_boot_on(bool verbose);
 
@@ -377,6 +377,8 @@ struct rk8xx_reg_table {
 	u8 reg_vol;
 };
 
+#define RK8XX_CACHE_REGS	256
+
 struct rk8xx_priv {
 	struct virq_chip *irq_chip;
 	struct spi_slave *slave;
@@ -390,6 +392,12 @@ struct rk8xx_priv {
 	int sys_can_sd;
 	int buck5_feedback_dis;
 	int pwr_ctr[3];
+#ifdef CONFIG_PMIC_RK8XX_REG_CACHE
+	/* values of the registers in @cache_mask, known if in @cache_valid */
+	uint8_t reg_cache[RK8XX_CACHE_REGS];
+	DECLARE_BITMAP(cache_mask, RK8XX_CACHE_REGS);
+	DECLARE_BITMAP(cache_valid, RK8XX_CACHE_REGS);
+#endif
 };
 
 int rk8xx_spl_configure_buck(struct udevice *pmic, int buck, int uvolt);
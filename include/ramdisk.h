@@ -45,6 +45,30 @@ struct ramdisk_ops {
 	ulong (*erase)(struct blk_desc *desc, lbaint_t start, lbaint_t blkcnt);
 };
 
+/* "RDZ4" */
+#define RAMDISK_LZ4_MAGIC	0x345a4452
+
+/*
+ * Image of a compressed ramdisk (ramdisk-lz4). The disk is cut into chunks
+ * of @chunk_size bytes, the last one maybe shorter, each compressed on its
+ * own as a raw LZ4 block so that any of them can be read alone. A chunk
+ * that would not get smaller is stored as it is, which shows as a
+ * compressed size equal to its size. All fields are little endian.
+ */
+struct ramdisk_lz4_header {
+	u32 magic;		/* RAMDISK_LZ4_MAGIC */
+	u32 version;		/* 0 */
+	u32 chunk_size;
+	u32 chunks;
+	u64 size;		/* of the disk, a multiple of 512 bytes */
+	u32 reserved[2];
+	/*
+	 * Offset of each chunk from the start of the header, and the end
+	 * of the last one: @chunks + 1 entries
+	 */
+	u32 offset[];
+} __packed;
+
 int dm_ramdisk_is_enabled(void);
 
 #endif /* __RAMDISK_H__ */
@@ -0,0 +1,32 @@
+/* SPDX-License-Identifier:     GPL-2.0+ */
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ */
+
+#ifndef RK_LOGO_H
+#define RK_LOGO_H
+
+/*
+ * A raw logo is a logo converted at build time, by bmp2rawlogo, to the
+ * pixel format, orientation and stride it is scanned out with. It goes in
+ * resource.img under the name of the BMP it replaces. The pixel data, LZ4
+ * framed if RK_RAW_LOGO_LZ4 is set, starts at data_offset. All fields are
+ * little endian.
+ */
+#define RK_RAW_LOGO_MAGIC	"RLOG"
+#define RK_RAW_LOGO_LZ4		(1 << 0)
+
+struct rk_raw_logo_header {
+	char magic[4];		/* must be "RLOG" */
+	uint16_t width;
+	uint16_t height;
+	uint16_t bpp;		/* 16: RGB565, 24: RGB888, 32: ARGB8888 */
+	uint16_t rotate;	/* already applied: 0, 90, 180 or 270 */
+	uint32_t stride;	/* bytes per line, 4 bytes aligned */
+	uint32_t flags;
+	uint32_t data_offset;	/* from the start of the file */
+	uint32_t data_size;	/* as stored */
+	uint32_t rsv[2];
+} __attribute__((packed));
+
+#endif
@@ -26,6 +26,21 @@ struct md_region {
 	u64	size;
 };
 
+#define MD_SEG_LZ4_MAGIC		0x345a4c44	/* "DLZ4" */
+
+/* md_seg_lz4 - Header of a compressed minidump elf segment
+ * @magic:	MD_SEG_LZ4_MAGIC
+ * @size:	Length of the LZ4 block behind the header.
+ * @raw_size:	Length of the region, the p_memsz of the segment.
+ * @reserved:	Zero.
+ */
+struct md_seg_lz4 {
+	u32	magic;
+	u32	size;
+	u32	raw_size;
+	u32	reserved;
+};
+
 void rk_minidump_init(void);
 
 #ifdef CONFIG_ARM64
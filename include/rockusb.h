@@ -42,6 +42,7 @@ enum rkusb_cmd {
 	RKUSB_SWITCH_STORAGE	= 0x2A,
 	RKUSB_GET_STORAGE_MEDIA = 0x2B,
 	RKUSB_READ_OTP_DATA	= 0x2C,
+	RKUSB_LOAD_IMAGES	= 0x2D,
 	RKUSB_READ_CAPACITY	= 0xAA,
 	RKUSB_SWITCH_USB3	= 0xBB,
 	RKUSB_RESET		= 0xFF,
@@ -54,6 +55,48 @@ enum rkusb_rc {
 	RKUSB_RC_UNKNOWN_CMND	= 2,
 };
 
+#define RKUSB_MANIFEST_MAGIC		0x464d4b52	/* "RKMF" */
+#define RKUSB_MANIFEST_MAX_IMAGES	16
+
+/* rkusb_image flags */
+#define RKUSB_IMAGE_SHA256		BIT(0)	/* check sha256 */
+#define RKUSB_IMAGE_EXEC		BIT(1)	/* start it when all are in */
+
+/**
+ * struct rkusb_image - an image of a LOAD_IMAGES manifest
+ *
+ * @load_addr:	Where in DRAM it goes
+ * @size:	Bytes of it in the transfer
+ * @flags:	RKUSB_IMAGE_*
+ * @reserved:	Zero
+ * @sha256:	Sum of the image, for RKUSB_IMAGE_SHA256
+ */
+struct rkusb_image {
+	u64 load_addr;
+	u32 size;
+	u32 flags;
+	u32 reserved[2];
+	u8 sha256[32];
+} __packed;
+
+/**
+ * struct rkusb_manifest - data of the LOAD_IMAGES command
+ *
+ * The @count entries of @image follow the header, and the images follow
+ * them back to back in the same order, with no padding.
+ *
+ * @magic:	RKUSB_MANIFEST_MAGIC
+ * @count:	Number of images, at most RKUSB_MANIFEST_MAX_IMAGES
+ * @reserved:	Zero
+ * @image:	The images
+ */
+struct rkusb_manifest {
+	u32 magic;
+	u32 count;
+	u32 reserved[2];
+	struct rkusb_image image[];
+} __packed;
+
 struct fsg_common;
 
 #ifdef CONFIG_CMD_ROCKUSB
@@ -121,6 +121,7 @@
 #define  SDHCI_INT_CARD_INSERT	BIT(6)
 #define  SDHCI_INT_CARD_REMOVE	BIT(7)
 #define  SDHCI_INT_CARD_INT	BIT(8)
+#define  SDHCI_INT_CQE		BIT(14)
 #define  SDHCI_INT_ERROR	BIT(15)
 #define  SDHCI_INT_TIMEOUT	BIT(16)
 #define  SDHCI_INT_CRC		BIT(17)
@@ -144,6 +145,12 @@
 		SDHCI_INT_DATA_END_BIT | SDHCI_INT_ADMA_ERROR)
 #define SDHCI_INT_ALL_MASK	((unsigned int)-1)
 
+#define  SDHCI_CQE_INT_ERR_MASK	(SDHCI_INT_ADMA_ERROR | SDHCI_INT_BUS_POWER | \
+		SDHCI_INT_DATA_END_BIT | SDHCI_INT_DATA_CRC | \
+		SDHCI_INT_DATA_TIMEOUT | SDHCI_INT_INDEX | \
+		SDHCI_INT_END_BIT | SDHCI_INT_CRC | SDHCI_INT_TIMEOUT)
+#define  SDHCI_CQE_INT_MASK	(SDHCI_CQE_INT_ERR_MASK | SDHCI_INT_CQE)
+
 #define SDHCI_ACMD12_ERR	0x3C
 
 /* 3E-3F reserved */
@@ -290,11 +297,44 @@ struct sdhci_host {
 	uint	voltages;
 
 	struct mmc_config cfg;
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	struct cqhci_host *cq_host;	/* NULL if CQE is not used */
+#endif
 };
 
 void sdhci_enable_clk(struct sdhci_host *host, u16 clk);
 int sdhci_set_clock(struct sdhci_host *host, unsigned int clock);
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+struct cqhci_host;
+
+/**
+ * sdhci_cqe_enable() - Prepare the SDHCI core for command queue mode
+ *
+ * Selects ADMA2, sets the block size and routes the CQE interrupt status.
+ * Meant to be called from the cqhci_host_ops enable() hook.
+ *
+ * @host:	SDHCI host structure
+ */
+void sdhci_cqe_enable(struct sdhci_host *host);
+
+/**
+ * sdhci_cqe_disable() - Return the SDHCI core to legacy mode
+ *
+ * @host:	SDHCI host structure
+ * @recovery:	true to reset the command and data lines after an error
+ */
+void sdhci_cqe_disable(struct sdhci_host *host, bool recovery);
+
+/**
+ * sdhci_cqe_check_error() - Check for errors flagged by the SDHCI core
+ *
+ * @host:	SDHCI host structure
+ * @return 0 if no error, -EIO otherwise
+ */
+int sdhci_cqe_check_error(struct sdhci_host *host);
+#endif
+
 #ifdef CONFIG_MMC_SDHCI_IO_ACCESSORS
 
 static inline void sdhci_writel(struct sdhci_host *host, u32 val, int reg)
@@ -62,6 +62,13 @@ struct hsearch_data {
  */
 	int (*change_ok)(const ENTRY *__item, const char *newval, enum env_op,
 		int flag);
+/*
+ * Copy of the last imported environment. Imported keys and values point
+ * into it instead of being strdup()ed one by one; a value only gets its
+ * own allocation once it is overwritten.
+ */
+	char *import_buf;
+	size_t import_size;
 };
 
 /* Create a new hash table which will contain at most "__nel" elements.  */
@@ -53,6 +53,10 @@ struct spl_image_info {
  * @bl_len: Block length for reading in bytes
  * @filename: Name of the fit image file.
  * @read: Function to call to read from the device
+ * @read_async: Optional, start a read and return without waiting for the
+ *	data. Returns the number of blocks queued, which may be less than
+ *	@count. Only one read is outstanding at a time.
+ * @wait: Wait for the read started by @read_async, 0 if OK
  */
 struct spl_load_info {
 	void *dev;
@@ -61,6 +65,9 @@ struct spl_load_info {
 	const char *filename;
 	ulong (*read)(struct spl_load_info *load, ulong sector, ulong count,
 		      void *buf);
+	ulong (*read_async)(struct spl_load_info *load, ulong sector,
+			    ulong count, void *buf);
+	int (*wait)(struct spl_load_info *load);
 };
 
 /**
@@ -239,6 +246,16 @@ int spl_load_image_ext_os(struct spl_image_info *spl_image,
  */
 int spl_early_init(void);
 
+/**
+ * spl_dcache_enable() - Set up the page tables and enable the dcache
+ *
+ * spl_early_init() calls this, unless CONFIG_SPL_SYS_DCACHE_LATE leaves it
+ * to the board to call once DRAM works.
+ *
+ * @return 0 if OK, -ENOMEM if there is no memory for the page tables
+ */
+int spl_dcache_enable(void);
+
 /**
  * spl_init() - Set up device tree and driver model in SPL if enabled
  *
@@ -23,6 +23,16 @@ struct spl_display_info {
 	struct drm_display_mode mode;
 	u32 bus_format;
 	u32 enabled;
+	/* CONFIG_SPL_DRM_ROCKCHIP_SPLASH, the logo SPL scans out */
+	u32 splash;
+	u32 splash_addr;
+	u32 splash_size;
 };
+
+int spl_init_display(struct task_data *data);
+int spl_load_baseparamter(struct task_data *data);
+#ifdef CONFIG_SPL_DRM_ROCKCHIP_SPLASH
+int spl_load_splash(struct task_data *data);
+#endif
 #endif
 
@@ -20,6 +20,7 @@
 struct sysmem {
 	struct lmb lmb;
 	struct list_head allocated_head;
+	struct memblk_tree allocated_tree;
 	struct list_head kmem_resv_head;
 	ulong allocated_cnt;
 	ulong kmem_resv_cnt;
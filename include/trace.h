@@ -80,6 +80,29 @@ struct trace_call {
 
 int trace_list_calls(void *buff, int buff_size, unsigned int *needed);
 
+/**
+ * Dump the call trace as Chrome trace event JSON
+ *
+ * This is the format chrome://tracing and ui.perfetto.dev load. Each entry
+ * and exit is a begin / end event with its timestamp in microseconds, named
+ * by the function's link address for looking up in System.map.
+ *
+ * @param buff		Buffer in which to place data, or NULL to count size
+ * @param buff_size	Size of buffer
+ * @param needed	Returns number of bytes used / needed
+ * @return 0 if ok, -1 on error (buffer exhausted)
+ */
+int trace_list_chrome(void *buff, int buff_size, unsigned int *needed);
+
+/**
+ * Only record the calls of functions in an address range
+ *
+ * @param start		First address, as link address in System.map
+ * @param end		Address after the range, or <= start to trace all
+ * @return 0 if ok, -1 if trace is not initialised or the range is bad
+ */
+int trace_set_filter(ulong start, ulong end);
+
 /**
  * Turn function tracing on and off
  *
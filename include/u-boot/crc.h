@@ -17,6 +17,13 @@ uint32_t crc32 (uint32_t, const unsigned char *, uint);
 uint32_t crc32_wd (uint32_t, const unsigned char *, uint, uint);
 uint32_t crc32_no_comp (uint32_t, const unsigned char *, uint);
 
+/*
+ * Portable versions, for use by optimised crc32_no_comp() and crc32c_cal()
+ * implementations on CPUs without the instructions they need.
+ */
+uint32_t crc32_no_comp_generic(uint32_t, const unsigned char *, uint);
+uint32_t crc32c_cal_generic(uint32_t, const char *, int, uint32_t *);
+
 /**
  * crc32_wd_buf - Perform CRC32 on a buffer and return result in buffer
  *
@@ -62,4 +62,91 @@ bool lz4_is_valid_header(const unsigned char *h);
  */
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn);
 
+/**
+ * LZ4_decompress_safe() - Decompress a raw LZ4 block
+ *
+ * @src: Compressed block, without any frame or block header
+ * @dst: Destination for uncompressed data
+ * @srcSize: Exact length of the compressed block
+ * @dstCapacity: Size of the destination buffer
+ * @return number of bytes decompressed, or -ve if the block is malformed
+ *	or does not fit in @dstCapacity
+ */
+int LZ4_decompress_safe(const char *src, char *dst, int srcSize,
+			int dstCapacity);
+
+/**
+ * LZ4_decompress_safe_partial() - Decompress the start of a raw LZ4 block
+ *
+ * Stops once at least @targetOutputSize bytes are out, so that @src need
+ * not end exactly where the block does, e.g. when it is zero padded.
+ *
+ * @src: Compressed block, without any frame or block header
+ * @dst: Destination for uncompressed data
+ * @srcSize: Length of @src, at least that of the block
+ * @targetOutputSize: Bytes wanted
+ * @dstCapacity: Size of the destination buffer
+ * @return number of bytes decompressed, which may exceed
+ *	@targetOutputSize, or -ve if the block is malformed
+ */
+int LZ4_decompress_safe_partial(const char *src, char *dst, int srcSize,
+				int targetOutputSize, int dstCapacity);
+
+/**
+ * LZ4_compress_default() - Compress data into a raw LZ4 block
+ *
+ * @source: Data to compress
+ * @dest: Destination for the block, without any frame or block header
+ * @srcSize: Length of @source
+ * @dstCapacity: Size of @dest
+ * @return length of the block, or 0 if it does not fit in @dstCapacity
+ */
+int LZ4_compress_default(const char *source, char *dest, int srcSize,
+			 int dstCapacity);
+
+/**
+ * struct ulz4f_stream - State of an incremental LZ4 frame decode
+ *
+ * @out:		Next byte of the destination buffer to write
+ * @end:		End of the destination buffer
+ * @block_max:		Largest block size allowed by the frame header, once
+ *			the header has been parsed
+ * @has_block_checksum:	Each block is followed by a 32-bit checksum
+ * @header_done:	The frame header has been consumed
+ * @done:		The end mark has been seen, the frame is complete
+ */
+struct ulz4f_stream {
+	void *out;
+	void *end;
+	size_t block_max;
+	bool has_block_checksum;
+	bool header_done;
+	bool done;
+};
+
+/**
+ * ulz4f_stream_init() - Prepare to decode an LZ4 frame piece by piece
+ *
+ * @s: Stream state to set up
+ * @dst: Destination for uncompressed data
+ * @dstn: Size of the destination buffer
+ */
+void ulz4f_stream_init(struct ulz4f_stream *s, void *dst, size_t dstn);
+
+/**
+ * ulz4f_stream_decode() - Decode as much of a partial LZ4 frame as possible
+ *
+ * Only whole blocks are decoded. Bytes belonging to an incomplete block are
+ * left unconsumed and must be passed again, followed by more input, in the
+ * next call. The caller must therefore be able to hold @block_max bytes (and
+ * a block header) of unconsumed input.
+ *
+ * @s: Stream state, see ulz4f_stream_init()
+ * @src: Input data, starting at the first byte not consumed previously
+ * @srcn: Length of input data
+ * @return number of bytes consumed from @src, or -ve error code as for
+ *	ulz4fn()
+ */
+int ulz4f_stream_decode(struct ulz4f_stream *s, const void *src, size_t srcn);
+
 #endif
@@ -66,6 +66,18 @@ void sha1_update(sha1_context *ctx, const unsigned char *input,
  */
 void sha1_finish( sha1_context *ctx, unsigned char output[20] );
 
+/**
+ * \brief	   SHA-1 portable block function, for use by optimised
+ *		   sha1_process() implementations on CPUs without the
+ *		   instructions they need
+ *
+ * \param ctx	   SHA-1 context
+ * \param data	   input data, a multiple of 64 bytes
+ * \param blocks   number of 64-byte blocks
+ */
+void sha1_process_generic(sha1_context *ctx, const unsigned char *data,
+			  unsigned int blocks);
+
 /**
  * \brief	   Output = SHA-1( input buffer )
  *
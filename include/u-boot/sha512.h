@@ -81,6 +81,18 @@ int sha512_update(sha512_context *ctx, const unsigned char *input, size_t ilen);
  */
 int sha512_finish(sha512_context *ctx, unsigned char output[64]);
 
+/**
+ * \brief          Portable SHA-512 block function, for use by optimised
+ *                 sha512_process() implementations on CPUs without the
+ *                 instructions they need.
+ *
+ * \param ctx      The SHA-512 context.
+ * \param data     The input data, a multiple of 128 bytes.
+ * \param blocks   The number of 128-byte blocks.
+ */
+void sha512_process_generic(sha512_context *ctx, const unsigned char *data,
+			    unsigned int blocks);
+
 /**
  * \brief          This function starts SHA-512 checksum for the input data.
  *
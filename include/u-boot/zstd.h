@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd
+ */
+
+#ifndef __ZSTD_H
+#define __ZSTD_H
+
+#define ZSTD_MAGIC		0xFD2FB528
+#define ZSTD_SKIP_MAGIC		0x184D2A50	/* low 4 bits are free */
+
+/**
+ * zstd_is_valid_header() - Does a buffer start with a Zstandard frame
+ *
+ * @h: buffer, at least 4 bytes
+ * @return true or false
+ */
+bool zstd_is_valid_header(const unsigned char *h);
+
+/**
+ * zstd_get_content_size() - Get the decompressed size of a Zstandard frame
+ *
+ * @src: compressed data
+ * @srcn: length of compressed data
+ * @return decompressed size of the first frame, 0 if its header does not
+ *	record it
+ */
+u64 zstd_get_content_size(const void *src, size_t srcn);
+
+/**
+ * zstd_decompress() - Decompress Zstandard data
+ *
+ * Decodes all the frames in @src back to back, skippable frames skipped.
+ * Frames referring to a dictionary are not supported.
+ *
+ * @src: Source data to decompress
+ * @srcn: Length of source data
+ * @dst: Destination for uncompressed data
+ * @dstn: Size of @dst, returns length of uncompressed data
+ * @return 0 if OK, -EPROTONOSUPPORT if a frame needs a dictionary, -EINVAL
+ *	if @src is no Zstandard frame or a reserved field is non-zero,
+ *	-ENOBUFS if the destination buffer is overrun, -EPROTO if the
+ *	compressed data is corrupt or fails its checksum, -ENOMEM if there
+ *	is no memory for the decoder tables
+ */
+int zstd_decompress(const void *src, size_t srcn, void *dst, size_t *dstn);
+
+#endif
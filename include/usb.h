@@ -924,6 +924,17 @@ bool usb_device_has_child_on_port(struct usb_device *parent, int port);
 int usb_hub_probe(struct usb_device *dev, int ifnum);
 void usb_hub_reset(void);
 
+/**
+ * usb_hub_scan_defer() - Hold back the scan of the ports of configured hubs
+ *
+ * While deferred, configuring a hub only powers its ports on and queues them,
+ * so that the ports of several controllers can be scanned in one loop.
+ *
+ * @defer:	true to start queueing, false to scan all queued ports
+ * @return 0 if OK, -ve on error of the scan
+ */
+int usb_hub_scan_defer(bool defer);
+
 /*
  * usb_find_usb2_hub_address_port() - Get hub address and port for TT setting
  *
@@ -22,7 +22,37 @@
 	VNBYTES(DRM_ROCKCHIP_FB_BPP) * DRM_ROCKCHIP_FB_WIDTH * DRM_ROCKCHIP_FB_HEIGHT
 
 int rockchip_show_bmp(const char *bmp);
+
+/*
+ * rockchip_preload_bmp() - Decode a bmp into the logo cache, not showing it
+ *
+ * Later rockchip_show_bmp() of the same bmp only has to scan it out.
+ *
+ * return 0 on success, -ENOENT if a display failed to load it
+ */
+int rockchip_preload_bmp(const char *bmp);
 int rockchip_show_logo(void);
 void rockchip_display_fixup(void *blob);
 
+#ifdef CONFIG_DRM_ROCKCHIP_ASYNC_ENABLE
+/*
+ * rockchip_display_poll() - Go on with the display bring-up left pending
+ *
+ * return -EAGAIN while a display still waits for its panel, 0 once all are up
+ */
+int rockchip_display_poll(void);
+
+/*
+ * rockchip_display_sync() - Wait until all displays are up
+ */
+void rockchip_display_sync(void);
+#else
+static inline int rockchip_display_poll(void)
+{
+	return 0;
+}
+
+static inline void rockchip_display_sync(void) {}
+#endif
+
 #endif
@@ -0,0 +1,121 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd
+ */
+
+#include <common.h>
+#include <arena.h>
+#include <malloc.h>
+#include <sysmem.h>
+
+#define ARENA_E(fmt, args...)	printf("Arena Error: "fmt, ##args)
+
+static void *arena_region_alloc(const char *name, size_t size)
+{
+	if (!sysmem_has_init()) {
+		ARENA_E("No sysmem for \"%s\"\n", name);
+		return NULL;
+	}
+
+	return sysmem_alloc_by_name(name, size);
+}
+
+struct arena *arena_create(const char *name, size_t size)
+{
+	struct arena *arena;
+
+	arena = malloc(sizeof(*arena));
+	if (!arena)
+		return NULL;
+
+	arena->size = ALIGN(size, ARCH_DMA_MINALIGN);
+	arena->base = arena_region_alloc(name, arena->size);
+	if (!arena->base) {
+		free(arena);
+		return NULL;
+	}
+	arena->name = name;
+	arena->used = 0;
+
+	return arena;
+}
+
+void *arena_alloc(struct arena *arena, size_t size)
+{
+	void *buf;
+
+	size = ALIGN(size, ARCH_DMA_MINALIGN);
+	if (!arena || size > arena->size - arena->used)
+		return NULL;
+
+	buf = arena->base + arena->used;
+	arena->used += size;
+
+	return buf;
+}
+
+void arena_reset(struct arena *arena)
+{
+	if (arena)
+		arena->used = 0;
+}
+
+bool arena_owns(struct arena *arena, void *buf)
+{
+	return arena && buf >= arena->base && buf < arena->base + arena->size;
+}
+
+struct slab *slab_create(const char *name, size_t obj_size, uint count)
+{
+	struct slab *slab;
+	uint i;
+
+	if (!count)
+		return NULL;
+
+	slab = malloc(sizeof(*slab));
+	if (!slab)
+		return NULL;
+
+	slab->obj_size = ALIGN(max_t(size_t, obj_size, sizeof(void *)),
+			       ARCH_DMA_MINALIGN);
+	slab->base = arena_region_alloc(name, slab->obj_size * count);
+	if (!slab->base) {
+		free(slab);
+		return NULL;
+	}
+	slab->name = name;
+	slab->count = count;
+
+	/* Free list in address order */
+	slab->free = NULL;
+	for (i = count; i > 0; i--)
+		slab_free(slab, slab->base + (i - 1) * slab->obj_size);
+
+	return slab;
+}
+
+void *slab_alloc(struct slab *slab)
+{
+	void *buf;
+
+	if (!slab || !slab->free)
+		return NULL;
+
+	buf = slab->free;
+	slab->free = *(void **)buf;
+
+	return buf;
+}
+
+void slab_free(struct slab *slab, void *buf)
+{
+	*(void **)buf = slab->free;
+	slab->free = buf;
+}
+
+bool slab_owns(struct slab *slab, void *buf)
+{
+	return slab && buf >= slab->base &&
+	       buf < slab->base + slab->obj_size * slab->count;
+}
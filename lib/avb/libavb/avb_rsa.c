@@ -36,6 +36,9 @@
 #include <android_avb/avb_sha.h>
 #include <android_avb/avb_util.h>
 #include <android_avb/avb_vbmeta_image.h>
+#ifdef CONFIG_ANDROID_AVB_HW_RSA
+#include <crypto.h>
+#endif
 
 typedef struct IAvbKey {
   unsigned int len; /* Length of n[] in number of uint32_t */
@@ -225,6 +228,64 @@ out:
   }
 }
 
+#ifdef CONFIG_ANDROID_AVB_HW_RSA
+/* modpowF4() on the crypto device. Key and input as for modpowF4(), the
+ * device takes little-endian words for both. Returns false if there is no
+ * device for the key size or it failed, leaving inout untouched.
+ */
+static bool hw_modpowF4(const IAvbKey* key, uint8_t* inout) {
+  size_t num_bytes = key->len * sizeof(uint32_t);
+  struct udevice* dev;
+  rsa_key rsa_key;
+  uint8_t *e, *sig, *out;
+  size_t i;
+  bool ret = false;
+
+  switch (key->len * 32) {
+    case 2048:
+      rsa_key.algo = CRYPTO_RSA2048;
+      break;
+    case 4096:
+      rsa_key.algo = CRYPTO_RSA4096;
+      break;
+    default:
+      return false;
+  }
+
+  dev = crypto_get_device(rsa_key.algo);
+  if (dev == NULL) {
+    return false;
+  }
+
+  e = (uint8_t*)avb_calloc(3 * num_bytes);
+  if (e == NULL) {
+    return false;
+  }
+  sig = e + num_bytes;
+  out = sig + num_bytes;
+
+  /* 65537, the exponent modpowF4() is hard-wired to. */
+  e[0] = 0x01;
+  e[2] = 0x01;
+  for (i = 0; i < num_bytes; i++) {
+    sig[i] = inout[num_bytes - i - 1];
+  }
+
+  rsa_key.n = key->n;
+  rsa_key.e = (uint32_t*)e;
+  rsa_key.c = NULL; /* The device derives it from n. */
+  if (crypto_rsa_verify(dev, &rsa_key, sig, out) == 0) {
+    for (i = 0; i < num_bytes; i++) {
+      inout[i] = out[num_bytes - i - 1];
+    }
+    ret = true;
+  }
+
+  avb_free(e);
+  return ret;
+}
+#endif
+
 /* Verify a RSA PKCS1.5 signature against an expected hash.
  * Returns false on failure, true on success.
  */
@@ -268,7 +329,10 @@ bool avb_rsa_verify(const uint8_t* key,
   }
   avb_memcpy(buf, sig, sig_num_bytes);
 
-  modpowF4(parsed_key, buf);
+#ifdef CONFIG_ANDROID_AVB_HW_RSA
+  if (!hw_modpowF4(parsed_key, buf))
+#endif
+    modpowF4(parsed_key, buf);
 
   /* Check padding bytes.
    *
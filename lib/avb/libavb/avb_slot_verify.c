@@ -145,6 +145,65 @@ static AvbSlotVerifyResult load_full_partition(AvbOps* ops,
   return AVB_SLOT_VERIFY_RESULT_OK;
 }
 
+/* Loads and hashes a partition in one pass through the optional
+ * |get_preloaded_partition_hash| op. If the op is not available or
+ * declines, |*out_image_buf| is left NULL and the caller should load the
+ * partition with load_full_partition() and hash it itself.
+ */
+static AvbSlotVerifyResult load_and_hash_full_partition(
+    AvbOps* ops,
+    const char* part_name,
+    uint64_t image_size,
+    const char* hash_algorithm,
+    const uint8_t* salt,
+    size_t salt_len,
+    uint8_t** out_image_buf,
+    bool* out_image_preloaded,
+    uint8_t* out_digest,
+    size_t* out_digest_len) {
+  size_t part_num_read;
+  AvbIOResult io_ret;
+
+  avb_assert(*out_image_buf == NULL);
+  avb_assert(!*out_image_preloaded);
+
+  if (ops->get_preloaded_partition_hash == NULL) {
+    return AVB_SLOT_VERIFY_RESULT_OK;
+  }
+
+  if (image_size != (size_t)(image_size)) {
+    avb_errorv(part_name, ": Partition size too large to load.\n", NULL);
+    return AVB_SLOT_VERIFY_RESULT_ERROR_INVALID_METADATA;
+  }
+
+  io_ret = ops->get_preloaded_partition_hash(ops,
+                                             part_name,
+                                             image_size,
+                                             hash_algorithm,
+                                             salt,
+                                             salt_len,
+                                             out_image_buf,
+                                             &part_num_read,
+                                             out_digest,
+                                             out_digest_len);
+  if (io_ret == AVB_IO_RESULT_ERROR_OOM) {
+    return AVB_SLOT_VERIFY_RESULT_ERROR_OOM;
+  } else if (io_ret != AVB_IO_RESULT_OK) {
+    avb_errorv(part_name, ": Error loading data from partition.\n", NULL);
+    return AVB_SLOT_VERIFY_RESULT_ERROR_IO;
+  }
+
+  if (*out_image_buf != NULL) {
+    if (part_num_read != image_size) {
+      avb_errorv(part_name, ": Read incorrect number of bytes.\n", NULL);
+      return AVB_SLOT_VERIFY_RESULT_ERROR_IO;
+    }
+    *out_image_preloaded = true;
+  }
+
+  return AVB_SLOT_VERIFY_RESULT_OK;
+}
+
 /* Reads a persistent digest stored as a named persistent value corresponding to
  * the given |part_name|. The value is returned in |out_digest| which must point
  * to |expected_digest_size| bytes. If there is no digest stored for |part_name|
@@ -279,6 +338,115 @@ static AvbSlotVerifyResult initialize_persistent_digest(
   return ret;
 }
 
+/* Finds the partition of a hash descriptor in |requested_partitions| and
+ * builds the name to load it by in |part_name|, which must have room for
+ * AVB_PART_NAME_MAX_SIZE bytes. |*out_found| is set to NULL if the
+ * partition was not requested.
+ */
+static AvbSlotVerifyResult get_hash_partition_name(
+    const char* const* requested_partitions,
+    const char* ab_suffix,
+    const AvbHashDescriptor* hash_desc,
+    const uint8_t* desc_partition_name,
+    char* part_name,
+    const char** out_found) {
+  *out_found = avb_strv_find_str(requested_partitions,
+                                 (const char*)desc_partition_name,
+                                 hash_desc->partition_name_len);
+  if (*out_found == NULL) {
+    return AVB_SLOT_VERIFY_RESULT_OK;
+  }
+
+  if ((hash_desc->flags & AVB_HASH_DESCRIPTOR_FLAGS_DO_NOT_USE_AB) != 0) {
+    /* No ab_suffix, just copy the partition name as is. */
+    if (hash_desc->partition_name_len >= AVB_PART_NAME_MAX_SIZE) {
+      avb_error("Partition name does not fit.\n");
+      return AVB_SLOT_VERIFY_RESULT_ERROR_INVALID_METADATA;
+    }
+    avb_memcpy(part_name, desc_partition_name, hash_desc->partition_name_len);
+    part_name[hash_desc->partition_name_len] = '\0';
+  } else if (hash_desc->digest_len == 0 && avb_strlen(ab_suffix) != 0) {
+    /* No ab_suffix allowed for partitions without a digest in the descriptor
+     * because these partitions hold data unique to this device and are not
+     * updated using an A/B scheme.
+     */
+    avb_error("Cannot use A/B with a persistent digest.\n");
+    return AVB_SLOT_VERIFY_RESULT_ERROR_INVALID_METADATA;
+  } else {
+    /* Add ab_suffix to the partition name. */
+    if (!avb_str_concat(part_name,
+                        AVB_PART_NAME_MAX_SIZE,
+                        (const char*)desc_partition_name,
+                        hash_desc->partition_name_len,
+                        ab_suffix,
+                        avb_strlen(ab_suffix))) {
+      avb_error("Partition name and suffix does not fit.\n");
+      return AVB_SLOT_VERIFY_RESULT_ERROR_INVALID_METADATA;
+    }
+  }
+
+  return AVB_SLOT_VERIFY_RESULT_OK;
+}
+
+/* Tells the ops about the hash partitions of a vbmeta image before they
+ * are verified one by one, through the optional |prefetch_partition_hash|
+ * op, so that it can load and hash them all at once. Nothing is checked
+ * here: any error shows up again when the descriptor is verified.
+ */
+static void prefetch_hash_partitions(AvbOps* ops,
+                                     const char* const* requested_partitions,
+                                     const char* ab_suffix,
+                                     const AvbDescriptor** descriptors,
+                                     size_t num_descriptors) {
+  AvbHashDescriptor hash_desc;
+  AvbDescriptor desc;
+  const uint8_t* desc_partition_name;
+  char part_name[AVB_PART_NAME_MAX_SIZE];
+  const char* found;
+  size_t n;
+
+  if (ops->prefetch_partition_hash == NULL) {
+    return;
+  }
+
+  for (n = 0; n < num_descriptors; n++) {
+    if (!avb_descriptor_validate_and_byteswap(descriptors[n], &desc) ||
+        desc.tag != AVB_DESCRIPTOR_TAG_HASH) {
+      continue;
+    }
+    if (!avb_hash_descriptor_validate_and_byteswap(
+            (const AvbHashDescriptor*)descriptors[n], &hash_desc)) {
+      continue;
+    }
+    desc_partition_name =
+        ((const uint8_t*)descriptors[n]) + sizeof(AvbHashDescriptor);
+    if (!avb_validate_utf8(desc_partition_name,
+                           hash_desc.partition_name_len)) {
+      continue;
+    }
+    if (get_hash_partition_name(requested_partitions,
+                                ab_suffix,
+                                &hash_desc,
+                                desc_partition_name,
+                                part_name,
+                                &found) != AVB_SLOT_VERIFY_RESULT_OK ||
+        found == NULL) {
+      continue;
+    }
+    if (hash_desc.image_size != (size_t)(hash_desc.image_size)) {
+      continue;
+    }
+
+    ops->prefetch_partition_hash(
+        ops,
+        part_name,
+        hash_desc.image_size,
+        (const char*)hash_desc.hash_algorithm,
+        desc_partition_name + hash_desc.partition_name_len,
+        hash_desc.salt_len);
+  }
+}
+
 static AvbSlotVerifyResult load_and_verify_hash_partition(
     AvbOps* ops,
     const char* const* requested_partitions,
@@ -302,6 +470,7 @@ static AvbSlotVerifyResult load_and_verify_hash_partition(
   size_t expected_digest_len = 0;
   uint8_t expected_digest_buf[AVB_SHA512_DIGEST_SIZE];
   const uint8_t* expected_digest = NULL;
+  uint8_t streamed_digest[AVB_SHA512_DIGEST_SIZE];
 
   if (!avb_hash_descriptor_validate_and_byteswap(
           (const AvbHashDescriptor*)descriptor, &hash_desc)) {
@@ -323,45 +492,16 @@ static AvbSlotVerifyResult load_and_verify_hash_partition(
   /* Don't bother loading or validating unless the partition was
    * requested in the first place.
    */
-  found = avb_strv_find_str(requested_partitions,
-                            (const char*)desc_partition_name,
-                            hash_desc.partition_name_len);
-  if (found == NULL) {
-    ret = AVB_SLOT_VERIFY_RESULT_OK;
+  ret = get_hash_partition_name(requested_partitions,
+                                ab_suffix,
+                                &hash_desc,
+                                desc_partition_name,
+                                part_name,
+                                &found);
+  if (ret != AVB_SLOT_VERIFY_RESULT_OK || found == NULL) {
     goto out;
   }
 
-  if ((hash_desc.flags & AVB_HASH_DESCRIPTOR_FLAGS_DO_NOT_USE_AB) != 0) {
-    /* No ab_suffix, just copy the partition name as is. */
-    if (hash_desc.partition_name_len >= AVB_PART_NAME_MAX_SIZE) {
-      avb_error("Partition name does not fit.\n");
-      ret = AVB_SLOT_VERIFY_RESULT_ERROR_INVALID_METADATA;
-      goto out;
-    }
-    avb_memcpy(part_name, desc_partition_name, hash_desc.partition_name_len);
-    part_name[hash_desc.partition_name_len] = '\0';
-  } else if (hash_desc.digest_len == 0 && avb_strlen(ab_suffix) != 0) {
-    /* No ab_suffix allowed for partitions without a digest in the descriptor
-     * because these partitions hold data unique to this device and are not
-     * updated using an A/B scheme.
-     */
-    avb_error("Cannot use A/B with a persistent digest.\n");
-    ret = AVB_SLOT_VERIFY_RESULT_ERROR_INVALID_METADATA;
-    goto out;
-  } else {
-    /* Add ab_suffix to the partition name. */
-    if (!avb_str_concat(part_name,
-                        sizeof part_name,
-                        (const char*)desc_partition_name,
-                        hash_desc.partition_name_len,
-                        ab_suffix,
-                        avb_strlen(ab_suffix))) {
-      avb_error("Partition name and suffix does not fit.\n");
-      ret = AVB_SLOT_VERIFY_RESULT_ERROR_INVALID_METADATA;
-      goto out;
-    }
-  }
-
   /* If we're allowing verification errors then hash_desc.image_size
    * may no longer match what's in the partition... so in this case
    * just load the entire partition.
@@ -384,6 +524,26 @@ static AvbSlotVerifyResult load_and_verify_hash_partition(
     avb_debugv(part_name, ": Loading entire partition.\n", NULL);
   }
 
+  /* Hash the partition while it is being loaded, if the ops can. */
+  if (!allow_verification_error) {
+    ret = load_and_hash_full_partition(ops,
+                                       part_name,
+                                       image_size,
+                                       (const char*)hash_desc.hash_algorithm,
+                                       desc_salt,
+                                       hash_desc.salt_len,
+                                       &image_buf,
+                                       &image_preloaded,
+                                       streamed_digest,
+                                       &digest_len);
+    if (ret != AVB_SLOT_VERIFY_RESULT_OK) {
+      goto out;
+    } else if (image_buf != NULL) {
+      digest = streamed_digest;
+      goto check_digest;
+    }
+  }
+
   ret = load_full_partition(
       ops, part_name, image_size, &image_buf, &image_preloaded,
       allow_verification_error);
@@ -424,6 +584,7 @@ static AvbSlotVerifyResult load_and_verify_hash_partition(
     goto out;
   }
 
+check_digest:
   if (hash_desc.digest_len == 0) {
     /* Expect a match to a persistent digest. */
     avb_debugv(part_name, ": No digest, using persistent digest.\n", NULL);
@@ -959,6 +1120,10 @@ static AvbSlotVerifyResult load_and_verify_vbmeta(
    */
   descriptors =
       avb_descriptor_get_all(vbmeta_buf, vbmeta_num_read, &num_descriptors);
+  if (!allow_verification_error) {
+    prefetch_hash_partitions(
+        ops, requested_partitions, ab_suffix, descriptors, num_descriptors);
+  }
   for (n = 0; n < num_descriptors; n++) {
     AvbDescriptor desc;
 
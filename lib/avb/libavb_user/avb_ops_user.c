@@ -34,6 +34,7 @@
 #include <part.h>
 #include <stdio.h>
 #include <android_avb/avb_ops_user.h>
+#include <android_avb/avb_sha.h>
 #include <android_avb/libavb_ab.h>
 #include <android_avb/avb_atx_validate.h>
 #include <android_avb/avb_atx_types.h>
@@ -42,6 +43,10 @@
 #include <android_avb/avb_vbmeta_image.h>
 #include <android_avb/avb_atx_validate.h>
 #include <boot_rkimg.h>
+#ifdef CONFIG_ANDROID_AVB_PARALLEL_HASH
+#include <asm/arch/smp_work.h>
+#include <asm/system.h>
+#endif
 
 static void byte_to_block(int64_t *offset,
 			  size_t *num_bytes,
@@ -431,6 +436,35 @@ AvbIOResult rk_get_random(AvbAtxOps *atx_ops,
 }
 
 #ifdef CONFIG_ANDROID_BOOT_IMAGE
+/* Record partition name(either boot or recovery) */
+static void record_boot_partition(struct AvbOpsData *data,
+				  const char *partition)
+{
+	if (!strncmp(partition, ANDROID_PARTITION_BOOT, 4) ||
+	    !strncmp(partition, ANDROID_PARTITION_RECOVERY, 8)) {
+		data->boot_partition = strdup(partition);
+#ifdef CONFIG_ANDROID_AB
+		*((char *)data->boot_partition + strlen(partition) - 2) = '\0';
+#endif
+	}
+}
+
+static struct preloaded_partition *get_preload_info(struct AvbOpsData *data,
+						    const char *partition)
+{
+	if (!strncmp(partition, ANDROID_PARTITION_BOOT, 4) ||
+	    !strncmp(partition, ANDROID_PARTITION_RECOVERY, 8))
+		return &data->boot;
+	else if (!strncmp(partition, ANDROID_PARTITION_VENDOR_BOOT, 11))
+		return &data->vendor_boot;
+	else if (!strncmp(partition, ANDROID_PARTITION_INIT_BOOT, 9))
+		return &data->init_boot;
+	else if (!strncmp(partition, ANDROID_PARTITION_RESOURCE, 8))
+		return &data->resource;
+
+	return NULL;
+}
+
 static AvbIOResult get_preloaded_partition(AvbOps* ops,
 					   const char* partition,
 					   size_t num_bytes,
@@ -455,26 +489,10 @@ static AvbIOResult get_preloaded_partition(AvbOps* ops,
 		return AVB_IO_RESULT_ERROR_NO_SUCH_PARTITION;
 	}
 
-	/* Record partition name(either boot or recovery) */
-	if (!strncmp(partition, ANDROID_PARTITION_BOOT, 4) ||
-	    !strncmp(partition, ANDROID_PARTITION_RECOVERY, 8)) {
-		data->boot_partition = strdup(partition);
-#ifdef CONFIG_ANDROID_AB
-		*((char *)data->boot_partition + strlen(partition) - 2) = '\0';
-#endif
-	}
+	record_boot_partition(data, partition);
 
 	if (!allow_verification_error) {
-		if (!strncmp(partition, ANDROID_PARTITION_BOOT, 4) ||
-		    !strncmp(partition, ANDROID_PARTITION_RECOVERY, 8))
-			preload_info = &data->boot;
-		else if (!strncmp(partition, ANDROID_PARTITION_VENDOR_BOOT, 11))
-			preload_info = &data->vendor_boot;
-		else if (!strncmp(partition, ANDROID_PARTITION_INIT_BOOT, 9))
-			preload_info = &data->init_boot;
-		else if (!strncmp(partition, ANDROID_PARTITION_RESOURCE, 8))
-			preload_info = &data->resource;
-
+		preload_info = get_preload_info(data, partition);
 		if (!preload_info) {
 			printf("Error: unknown full load partition '%s'\n", partition);
 			return AVB_IO_RESULT_ERROR_NO_SUCH_PARTITION;
@@ -485,6 +503,14 @@ static AvbIOResult get_preloaded_partition(AvbOps* ops,
 		       (ulong)preload_info->addr,
 		       (ulong)preload_info->addr + num_bytes);
 
+		/* Sized by the footer, which the hash descriptor disagrees with */
+		if (!preload_info->size && preload_info->max &&
+		    num_bytes > preload_info->max) {
+			printf("Error: '%s' image is 0x%zx, more than 0x%zx\n",
+			       partition, num_bytes, preload_info->max);
+			return AVB_IO_RESULT_ERROR_RANGE_OUTSIDE_PARTITION;
+		}
+
 		/* If the partition hasn't yet been preloaded, do it now.*/
 		if (preload_info->size == 0) {
 			ret = ops->read_from_partition(ops, partition,
@@ -556,6 +582,496 @@ static AvbIOResult get_preloaded_partition(AvbOps* ops,
 
 	return ret;
 }
+
+#ifdef CONFIG_ANDROID_AVB_STREAM_HASH
+/* Blocks read ahead while the previous chunk is hashed, 1MiB */
+#define STREAM_HASH_CHUNK_BLKS		2048
+
+struct stream_hash {
+	bool sha512;
+	AvbSHA256Ctx sha256_ctx;
+	AvbSHA512Ctx sha512_ctx;
+};
+
+static int stream_hash_init(struct stream_hash *hash, const char *algo,
+			    uint64_t tot_len)
+{
+	if (!strcmp(algo, "sha256")) {
+		hash->sha512 = false;
+		hash->sha256_ctx.tot_len = tot_len;
+		avb_sha256_init(&hash->sha256_ctx);
+	} else if (!strcmp(algo, "sha512")) {
+		hash->sha512 = true;
+		hash->sha512_ctx.tot_len = tot_len;
+		avb_sha512_init(&hash->sha512_ctx);
+	} else {
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static void stream_hash_update(struct stream_hash *hash,
+			       const uint8_t *data, size_t len)
+{
+	if (hash->sha512)
+		avb_sha512_update(&hash->sha512_ctx, data, len);
+	else
+		avb_sha256_update(&hash->sha256_ctx, data, len);
+}
+
+static size_t stream_hash_final(struct stream_hash *hash, uint8_t *digest)
+{
+	if (hash->sha512) {
+		memcpy(digest, avb_sha512_final(&hash->sha512_ctx),
+		       AVB_SHA512_DIGEST_SIZE);
+		return AVB_SHA512_DIGEST_SIZE;
+	}
+
+	memcpy(digest, avb_sha256_final(&hash->sha256_ctx),
+	       AVB_SHA256_DIGEST_SIZE);
+	return AVB_SHA256_DIGEST_SIZE;
+}
+
+/*
+ * A partition to load and hash, split into the segments read to the
+ * preload buffer and the ones read in place, see
+ * android_image_place_prepare(). The hash is over the segments in order.
+ */
+#define STREAM_JOB_SEGS			(2 * ANDROID_PLACE_MAX + 2)
+
+struct stream_seg {
+	uint8_t *buf;
+	size_t len;
+};
+
+#ifdef CONFIG_ANDROID_AVB_PARALLEL_HASH
+/* boot, vendor_boot, init_boot and resource */
+#define STREAM_JOB_MAX			4
+#define STREAM_SALT_MAX			64
+
+enum stream_job_state {
+	STREAM_JOB_FREE,
+	STREAM_JOB_ANNOUNCED,
+	STREAM_JOB_SUBMITTED,
+};
+#endif
+
+struct stream_job {
+	char partition[32];
+	size_t num_bytes;
+	struct preloaded_partition *preload_info;
+	struct stream_hash hash;
+	struct stream_seg segs[STREAM_JOB_SEGS];
+	int num_segs;
+#ifdef CONFIG_ANDROID_AVB_PARALLEL_HASH
+	AvbOps *ops;
+	int state;
+	char hash_algorithm[32];
+	uint8_t salt[STREAM_SALT_MAX];
+	size_t salt_len;
+	size_t landed;		/* bytes read, for the worker to hash */
+	bool failed;
+	uint8_t digest[AVB_SHA512_DIGEST_SIZE];
+	size_t digest_len;
+	struct mp_task task;
+#endif
+};
+
+/* Split @job into the segments to read, claiming the sections in place */
+static void stream_job_plan(struct stream_job *job)
+{
+	struct android_place *place;
+	uint8_t *buf = job->preload_info->addr;
+	lbaint_t blkcnt = job->num_bytes / 512;
+	lbaint_t blk, end;
+	uint8_t *dst;
+
+	job->num_segs = 0;
+	for (blk = 0; blk < blkcnt; blk = end) {
+		place = android_image_place_next(job->partition, blk * 512);
+		if (place && place->offset == blk * 512) {
+			end = blk + DIV_ROUND_UP(place->len, 512);
+			if (end <= blkcnt && !android_image_place_claim(place)) {
+				dst = (uint8_t *)place->dst;
+				printf("preloaded(s): 0x%lx bytes of '%s' in place at 0x%08lx\n",
+				       place->len, job->partition, place->dst);
+			} else {
+				dst = buf + blk * 512;
+			}
+		} else {
+			end = place ? place->offset / 512 : blkcnt;
+			dst = buf + blk * 512;
+		}
+		end = min(end, blkcnt);
+
+		job->segs[job->num_segs].buf = dst;
+		job->segs[job->num_segs++].len = (end - blk) * 512;
+	}
+
+	/* The buffer only has room for num_bytes, the tail is read alone */
+	if (job->num_bytes % 512) {
+		job->segs[job->num_segs].buf = buf + blkcnt * 512;
+		job->segs[job->num_segs++].len = job->num_bytes % 512;
+	}
+}
+
+/* Hash what was just read, or tell the worker hashing @job about it */
+static void stream_job_landed(struct stream_job *job, const uint8_t *data,
+			      size_t len, bool publish)
+{
+#ifdef CONFIG_ANDROID_AVB_PARALLEL_HASH
+	if (publish) {
+		__atomic_add_fetch(&job->landed, len, __ATOMIC_RELEASE);
+		dsb();
+		asm volatile("sev");
+		return;
+	}
+#endif
+	stream_hash_update(&job->hash, data, len);
+}
+
+/*
+ * Read the segments of @job from @start.
+ *
+ * The read of chunk N+1 is queued with blk_dread_async() before chunk N is
+ * hashed, so the storage controller and the hash engine (the crypto device
+ * when DM_CRYPTO is enabled, or a worker CPU with @publish) work at the
+ * same time.
+ */
+static int stream_job_read(AvbOps *ops, struct blk_desc *dev_desc,
+			   lbaint_t start, struct stream_job *job, bool publish)
+{
+	lbaint_t blk = start, blkcnt, queued, hashed, landed;
+	struct stream_seg *seg;
+	size_t num_read;
+	unsigned long n;
+	int i;
+
+	for (i = 0; i < job->num_segs; i++) {
+		seg = &job->segs[i];
+		blkcnt = seg->len / 512;
+
+		if (!blkcnt) {
+			if (read_from_partition(ops, job->partition,
+						(blk - start) * 512, seg->len,
+						seg->buf, &num_read) !=
+			    AVB_IO_RESULT_OK)
+				return -EIO;
+			stream_job_landed(job, seg->buf, seg->len, publish);
+			continue;
+		}
+
+		n = blk_dread_async(dev_desc, blk,
+				    min_t(lbaint_t, blkcnt,
+					  STREAM_HASH_CHUNK_BLKS), seg->buf);
+		if (!n || IS_ERR_VALUE(n))
+			return -EIO;
+		queued = n;
+		hashed = 0;
+
+		while (hashed < blkcnt) {
+			if (blk_wait(dev_desc))
+				return -EIO;
+			landed = queued;
+
+			if (queued < blkcnt) {
+				n = blk_dread_async(dev_desc, blk + queued,
+						    min_t(lbaint_t, blkcnt - queued,
+							  STREAM_HASH_CHUNK_BLKS),
+						    seg->buf + queued * 512);
+				if (!n || IS_ERR_VALUE(n))
+					return -EIO;
+				queued += n;
+			}
+
+			stream_job_landed(job, seg->buf + hashed * 512,
+					  (landed - hashed) * 512, publish);
+			hashed = landed;
+		}
+		blk += blkcnt;
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_ANDROID_AVB_PARALLEL_HASH
+/*
+ * The hash partitions of a vbmeta image, announced by libavb before it
+ * verifies them one by one. On the first get_preloaded_partition_hash()
+ * the boot CPU reads all of them back to back while each is hashed by a
+ * worker CPU following job->landed, so hashing one partition overlaps
+ * with reading and hashing the others. libavb then gets the digests in
+ * its usual order.
+ */
+static struct stream_job stream_jobs[STREAM_JOB_MAX];
+
+/* Runs on a worker: no console, no malloc */
+static void stream_job_hash(void *arg)
+{
+	struct stream_job *job = arg;
+	size_t hashed = 0, pos = 0, landed, n;
+	struct stream_seg *seg;
+	int i = 0;
+
+	while (i < job->num_segs) {
+		landed = __atomic_load_n(&job->landed, __ATOMIC_ACQUIRE);
+		if (landed == hashed) {
+			if (READ_ONCE(job->failed))
+				return;
+			/* A sev after the load above still ends this wfe */
+			asm volatile("wfe");
+			continue;
+		}
+
+		seg = &job->segs[i];
+		n = min(landed, pos + seg->len) - hashed;
+		stream_hash_update(&job->hash, seg->buf + hashed - pos, n);
+		hashed += n;
+		if (hashed == pos + seg->len) {
+			pos = hashed;
+			i++;
+		}
+	}
+
+	job->digest_len = stream_hash_final(&job->hash, job->digest);
+}
+
+static void stream_job_free(struct stream_job *job)
+{
+	if (job->state == STREAM_JOB_SUBMITTED)
+		mp_task_wait(&job->task);
+	job->state = STREAM_JOB_FREE;
+}
+
+static void prefetch_partition_hash(AvbOps *ops, const char *partition,
+				    size_t num_bytes,
+				    const char *hash_algorithm,
+				    const uint8_t *salt, size_t salt_len)
+{
+	struct preloaded_partition *preload_info;
+	struct stream_job *job = NULL;
+	int i;
+
+	for (i = 0; i < STREAM_JOB_MAX; i++) {
+		/* Left over from an earlier verification */
+		if (stream_jobs[i].state != STREAM_JOB_FREE &&
+		    stream_jobs[i].ops != ops)
+			stream_job_free(&stream_jobs[i]);
+
+		if (stream_jobs[i].state == STREAM_JOB_FREE) {
+			if (!job)
+				job = &stream_jobs[i];
+		} else if (!strcmp(stream_jobs[i].partition, partition)) {
+			return;
+		}
+	}
+
+	preload_info = get_preload_info(ops->user_data, partition);
+	if (!job || !preload_info || preload_info->size ||
+	    (preload_info->max && num_bytes > preload_info->max) ||
+	    salt_len > STREAM_SALT_MAX ||
+	    strlen(partition) >= sizeof(job->partition) ||
+	    strlen(hash_algorithm) >= sizeof(job->hash_algorithm))
+		return;
+
+	if (stream_hash_init(&job->hash, hash_algorithm, salt_len + num_bytes))
+		return;
+	stream_hash_update(&job->hash, salt, salt_len);
+
+	strcpy(job->partition, partition);
+	strcpy(job->hash_algorithm, hash_algorithm);
+	memcpy(job->salt, salt, salt_len);
+	job->salt_len = salt_len;
+	job->num_bytes = num_bytes;
+	job->preload_info = preload_info;
+	job->ops = ops;
+	job->state = STREAM_JOB_ANNOUNCED;
+}
+
+/* Read all the announced partitions, each hashed on a worker */
+static void stream_jobs_run(AvbOps *ops)
+{
+	struct blk_desc *dev_desc = rockchip_get_bootdev();
+	disk_partition_t part_info;
+	struct stream_job *job;
+	int i;
+
+	/* Without workers get_preloaded_partition_hash() reads them one by one */
+	if (!dev_desc || !mp_task_pool_start()) {
+		for (i = 0; i < STREAM_JOB_MAX; i++) {
+			if (stream_jobs[i].state == STREAM_JOB_ANNOUNCED)
+				stream_jobs[i].state = STREAM_JOB_FREE;
+		}
+		return;
+	}
+
+	for (i = 0; i < STREAM_JOB_MAX; i++) {
+		job = &stream_jobs[i];
+		if (job->state != STREAM_JOB_ANNOUNCED)
+			continue;
+
+		if (part_get_info_by_name(dev_desc, job->partition,
+					  &part_info) < 0) {
+			job->state = STREAM_JOB_FREE;
+			continue;
+		}
+
+		printf("preloaded(s): full image from '%s' at 0x%08lx - 0x%08lx, hashing on a worker\n",
+		       job->partition, (ulong)job->preload_info->addr,
+		       (ulong)job->preload_info->addr + job->num_bytes);
+
+		stream_job_plan(job);
+		job->landed = 0;
+		job->failed = false;
+		job->state = STREAM_JOB_SUBMITTED;
+		mp_task_submit(&job->task, stream_job_hash, job);
+
+		if (stream_job_read(ops, dev_desc, part_info.start, job, true)) {
+			WRITE_ONCE(job->failed, true);
+			dsb();
+			asm volatile("sev");
+		}
+	}
+}
+
+/*
+ * The digest of @partition if it was announced with the same arguments,
+ * 1 if it wasn't and is to be read as usual, or negative on a read error.
+ */
+static int stream_jobs_get(AvbOps *ops, const char *partition,
+			   size_t num_bytes, const char *hash_algorithm,
+			   const uint8_t *salt, size_t salt_len,
+			   uint8_t *out_digest, size_t *out_digest_len)
+{
+	struct stream_job *job = NULL;
+	int i, ret;
+
+	for (i = 0; i < STREAM_JOB_MAX; i++) {
+		if (stream_jobs[i].state == STREAM_JOB_ANNOUNCED &&
+		    stream_jobs[i].ops == ops) {
+			stream_jobs_run(ops);
+			break;
+		}
+	}
+
+	for (i = 0; i < STREAM_JOB_MAX; i++) {
+		if (stream_jobs[i].state == STREAM_JOB_SUBMITTED &&
+		    stream_jobs[i].ops == ops &&
+		    !strcmp(stream_jobs[i].partition, partition)) {
+			job = &stream_jobs[i];
+			break;
+		}
+	}
+	if (!job)
+		return 1;
+
+	mp_task_wait(&job->task);
+	if (job->failed) {
+		ret = -EIO;
+	} else if (job->num_bytes != num_bytes ||
+		   strcmp(job->hash_algorithm, hash_algorithm) ||
+		   job->salt_len != salt_len ||
+		   memcmp(job->salt, salt, salt_len)) {
+		ret = 1;
+	} else {
+		memcpy(out_digest, job->digest, job->digest_len);
+		*out_digest_len = job->digest_len;
+		ret = 0;
+	}
+	stream_job_free(job);
+
+	return ret;
+}
+#endif
+
+/*
+ * Load a boot partition into its preload buffer and hash it on the way.
+ *
+ * With ANDROID_AVB_PRELOAD_IN_PLACE the sections planned by
+ * android_image_place_prepare() go to their load address instead, and
+ * the hash is calculated over the pieces in partition order. Partitions
+ * which are already preloaded are left to the caller to hash from memory.
+ */
+static AvbIOResult get_preloaded_partition_hash(AvbOps *ops,
+						const char *partition,
+						size_t num_bytes,
+						const char *hash_algorithm,
+						const uint8_t *salt,
+						size_t salt_len,
+						uint8_t **out_pointer,
+						size_t *out_num_bytes_preloaded,
+						uint8_t *out_digest,
+						size_t *out_digest_len)
+{
+	struct preloaded_partition *preload_info;
+	struct AvbOpsData *data = ops->user_data;
+	struct blk_desc *dev_desc;
+	disk_partition_t part_info;
+	struct stream_job job;
+
+	*out_pointer = NULL;
+
+	preload_info = get_preload_info(data, partition);
+	if (!preload_info || preload_info->size)
+		return AVB_IO_RESULT_OK;
+
+	/* Left to get_preloaded_partition() to refuse */
+	if (preload_info->max && num_bytes > preload_info->max)
+		return AVB_IO_RESULT_OK;
+
+#ifdef CONFIG_ANDROID_AVB_PARALLEL_HASH
+	switch (stream_jobs_get(ops, partition, num_bytes, hash_algorithm,
+				salt, salt_len, out_digest, out_digest_len)) {
+	case 0:
+		record_boot_partition(data, partition);
+		goto done;
+	case 1:
+		break;
+	default:
+		return AVB_IO_RESULT_ERROR_IO;
+	}
+#endif
+
+	if (strlen(partition) >= sizeof(job.partition) ||
+	    stream_hash_init(&job.hash, hash_algorithm, salt_len + num_bytes))
+		return AVB_IO_RESULT_OK;
+
+	dev_desc = rockchip_get_bootdev();
+	if (!dev_desc)
+		return AVB_IO_RESULT_ERROR_IO;
+
+	if (part_get_info_by_name(dev_desc, partition, &part_info) < 0) {
+		printf("Could not find \"%s\" partition\n", partition);
+		return AVB_IO_RESULT_ERROR_NO_SUCH_PARTITION;
+	}
+
+	record_boot_partition(data, partition);
+
+	printf("preloaded(s): full image from '%s' at 0x%08lx - 0x%08lx, hashing\n",
+	       partition, (ulong)preload_info->addr,
+	       (ulong)preload_info->addr + num_bytes);
+
+	strcpy(job.partition, partition);
+	job.num_bytes = num_bytes;
+	job.preload_info = preload_info;
+	stream_job_plan(&job);
+
+	stream_hash_update(&job.hash, salt, salt_len);
+	if (stream_job_read(ops, dev_desc, part_info.start, &job, false))
+		return AVB_IO_RESULT_ERROR_IO;
+
+	*out_digest_len = stream_hash_final(&job.hash, out_digest);
+#ifdef CONFIG_ANDROID_AVB_PARALLEL_HASH
+done:
+#endif
+	preload_info->size = num_bytes;
+	*out_pointer = preload_info->addr;
+	*out_num_bytes_preloaded = preload_info->size;
+
+	return AVB_IO_RESULT_OK;
+}
+#endif
 #endif
 
 AvbIOResult validate_public_key_for_partition(AvbOps *ops,
@@ -636,6 +1152,12 @@ AvbOps *avb_ops_user_new(void)
 	ops->get_size_of_partition = get_size_of_partition;
 #ifdef CONFIG_ANDROID_BOOT_IMAGE
 	ops->get_preloaded_partition = get_preloaded_partition;
+#ifdef CONFIG_ANDROID_AVB_STREAM_HASH
+	ops->get_preloaded_partition_hash = get_preloaded_partition_hash;
+#endif
+#ifdef CONFIG_ANDROID_AVB_PARALLEL_HASH
+	ops->prefetch_partition_hash = prefetch_partition_hash;
+#endif
 #endif
 	ops->validate_public_key_for_partition = validate_public_key_for_partition;
 	ops->ab_ops->read_ab_metadata = avb_ab_data_read;
@@ -11,7 +11,11 @@
 #include <blk.h>
 #include <part.h>
 #include <boot_rkimg.h>
+#include <android_ab.h>
 #include <android_avb/rk_avb_ops_user.h>
+#ifdef CONFIG_SPL_AB_HANDOFF
+#include <asm/arch/rk_atags.h>
+#endif
 
 static int safe_memcmp(const void *s1, const void *s2, size_t n)
 {
@@ -161,19 +165,103 @@ void avb_ab_data_init(AvbABData* data)
  */
 #define AB_METADATA_MISC_PARTITION_OFFSET 2048
 
+#if CONFIG_IS_ENABLED(ANDROID_AB)
+/* Through the misc cache of android_ab.c, written back once at boot */
+static AvbIOResult ab_metadata_rw(void *buf, bool write)
+{
+        struct blk_desc *dev_desc;
+        disk_partition_t part_info;
+        int ret;
+
+        dev_desc = rockchip_get_bootdev();
+        if (!dev_desc ||
+            part_get_info_by_name(dev_desc, PART_MISC, &part_info) < 0)
+                return AVB_IO_RESULT_ERROR_NO_SUCH_PARTITION;
+
+        if (write)
+                ret = android_misc_write(dev_desc, &part_info,
+                                         AB_METADATA_MISC_PARTITION_OFFSET,
+                                         sizeof(AvbABData), buf);
+        else
+                ret = android_misc_read(dev_desc, &part_info,
+                                        AB_METADATA_MISC_PARTITION_OFFSET,
+                                        sizeof(AvbABData), buf);
+        if (ret == -ENOMEM)
+                return AVB_IO_RESULT_ERROR_OOM;
+
+        return ret ? AVB_IO_RESULT_ERROR_IO : AVB_IO_RESULT_OK;
+}
+#endif
+
+#ifdef CONFIG_SPL_AB_HANDOFF
+/*
+ * The metadata SPL read and checked. Only the first read uses it, later
+ * ones see what U-Boot has written since.
+ *
+ * Return: 0 if @data is set, 1 if it is also still to be written, or
+ * -ENOENT if it has to be read from misc.
+ */
+static int ab_handoff_take(AvbABData *data)
+{
+        static bool taken;
+        struct blk_desc *dev_desc;
+        disk_partition_t part_info;
+        struct tag_ab *t;
+        struct tag *tag;
+
+        if (taken)
+                return -ENOENT;
+        taken = true;
+
+        tag = atags_get_tag(ATAG_AB);
+        if (!tag)
+                return -ENOENT;
+
+        t = &tag->u.ab;
+        dev_desc = rockchip_get_bootdev();
+        if (!dev_desc || dev_desc->lba != t->dev_lba ||
+            part_get_info_by_name(dev_desc, PART_MISC, &part_info) < 0 ||
+            part_info.start != t->misc_start)
+                return -ENOENT;
+
+        memcpy(data, t->ab_data, sizeof(AvbABData));
+        if (memcmp(data->magic, AVB_AB_MAGIC, AVB_AB_MAGIC_LEN))
+                return -ENOENT;
+
+        return t->flags & AB_FLG_DIRTY ? 1 : 0;
+}
+#endif
+
 AvbIOResult avb_ab_data_read(AvbABOps* ab_ops, AvbABData* data)
 {
+#if !CONFIG_IS_ENABLED(ANDROID_AB)
         AvbOps* ops = ab_ops->ops;
+#endif
         AvbABData serialized;
         AvbIOResult io_ret;
         size_t num_bytes_read;
 
+#ifdef CONFIG_SPL_AB_HANDOFF
+        switch (ab_handoff_take(data)) {
+        case 0:
+                return AVB_IO_RESULT_OK;
+        case 1:
+                /* SPL reset it, write it now with ours */
+                return avb_ab_data_write(ab_ops, data);
+        }
+#endif
+
+#if CONFIG_IS_ENABLED(ANDROID_AB)
+        io_ret = ab_metadata_rw(&serialized, false);
+        num_bytes_read = sizeof(AvbABData);
+#else
         io_ret = ops->read_from_partition(ops,
                                           "misc",
                                           AB_METADATA_MISC_PARTITION_OFFSET,
                                           sizeof(AvbABData),
                                           &serialized,
                                           &num_bytes_read);
+#endif
         if (io_ret == AVB_IO_RESULT_ERROR_OOM) {
                 return AVB_IO_RESULT_ERROR_OOM;
         } else if (io_ret != AVB_IO_RESULT_OK ||
@@ -194,16 +282,22 @@ AvbIOResult avb_ab_data_read(AvbABOps* ab_ops, AvbABData* data)
 
 AvbIOResult avb_ab_data_write(AvbABOps* ab_ops, const AvbABData* data)
 {
+#if !CONFIG_IS_ENABLED(ANDROID_AB)
         AvbOps* ops = ab_ops->ops;
+#endif
         AvbABData serialized;
         AvbIOResult io_ret;
 
         avb_ab_data_update_crc_and_byteswap(data, &serialized);
+#if CONFIG_IS_ENABLED(ANDROID_AB)
+        io_ret = ab_metadata_rw(&serialized, true);
+#else
         io_ret = ops->write_to_partition(ops,
                                          "misc",
                                          AB_METADATA_MISC_PARTITION_OFFSET,
                                          sizeof(AvbABData),
                                          &serialized);
+#endif
         if (io_ret == AVB_IO_RESULT_ERROR_OOM) {
                 return AVB_IO_RESULT_ERROR_OOM;
         } else if (io_ret != AVB_IO_RESULT_OK) {
@@ -233,28 +233,14 @@ u64 bidram_append_size(void)
 	return size;
 }
 
-static int bidram_is_overlap(phys_addr_t base1, phys_size_t size1,
-			     phys_addr_t base2, phys_size_t size2)
-{
-	return ((base1 < (base2 + size2)) && (base2 < (base1 + size1)));
-}
-
 struct memblock *bidram_reserved_is_overlap(phys_addr_t base, phys_size_t size)
 {
 	struct bidram *bidram = &plat_bidram;
-	struct list_head *node;
-	struct memblock *mem;
 
 	if (!bidram_has_init())
 		return false;
 
-	list_for_each(node, &bidram->reserved_head) {
-		mem = list_entry(node, struct memblock, node);
-		if (bidram_is_overlap(mem->base, mem->size, base, size))
-			return mem;
-	}
-
-	return NULL;
+	return memblk_tree_overlap(&bidram->reserved_tree, base, size);
 }
 
 static int bidram_core_reserve(enum memblk_id id, const char *mem_name,
@@ -263,7 +249,6 @@ static int bidram_core_reserve(enum memblk_id id, const char *mem_name,
 	struct bidram *bidram = &plat_bidram;
 	struct memblk_attr attr;
 	struct memblock *mem;
-	struct list_head *node;
 	const char *name;
 	int ret;
 
@@ -296,23 +281,19 @@ static int bidram_core_reserve(enum memblk_id id, const char *mem_name,
 		return 0;
 
 	/* Check overlap */
-	list_for_each(node, &bidram->reserved_head) {
-		mem = list_entry(node, struct memblock, node);
-		BIDRAM_D("Has reserved: %s 0x%08lx - 0x%08lx\n",
-			 mem->attr.name, (ulong)mem->base,
-			 (ulong)(mem->base + mem->size));
-		if (!strcmp(mem->attr.name, name)) {
-			BIDRAM_E("Failed to double reserve for existence \"%s\"\n", name);
-			return -EEXIST;
-		} else if (bidram_is_overlap(mem->base, mem->size, base, size)) {
-			BIDRAM_D("\"%s\" (0x%08lx - 0x%08lx) reserve is "
-				 "overlap with existence \"%s\" (0x%08lx - "
-				 "0x%08lx)\n",
-				 name, (ulong)base, (ulong)(base + size), mem->attr.name,
-				 (ulong)mem->base, (ulong)(mem->base + mem->size));
-		}
+	if (memblk_tree_find_name(&bidram->reserved_tree, name)) {
+		BIDRAM_E("Failed to double reserve for existence \"%s\"\n", name);
+		return -EEXIST;
 	}
 
+	mem = memblk_tree_overlap(&bidram->reserved_tree, base, size);
+	if (mem)
+		BIDRAM_D("\"%s\" (0x%08lx - 0x%08lx) reserve is "
+			 "overlap with existence \"%s\" (0x%08lx - "
+			 "0x%08lx)\n",
+			 name, (ulong)base, (ulong)(base + size), mem->attr.name,
+			 (ulong)mem->base, (ulong)(mem->base + mem->size));
+
 	BIDRAM_D("Reserve: \"%s\" 0x%08lx - 0x%08lx\n",
 		 name, (ulong)base, (ulong)(base + size));
 
@@ -348,6 +329,7 @@ static int bidram_core_reserve(enum memblk_id id, const char *mem_name,
 			mem->attr = attr;
 		}
 		list_add_tail(&mem->node, &bidram->reserved_head);
+		memblk_tree_insert(&bidram->reserved_tree, mem);
 	} else {
 		BIDRAM_E("Failed to reserve \"%s\" 0x%08lx - 0x%08lx\n",
 			 name, (ulong)base, (ulong)(base + size));
@@ -422,6 +404,7 @@ phys_size_t bidram_get_ram_size(void)
 	/* Initial plat_bidram */
 	lmb_init(&bidram->lmb);
 	INIT_LIST_HEAD(&bidram->reserved_head);
+	bidram->reserved_tree = MEMBLK_TREE_INIT;
 	bidram->has_init = true;
 
 	/* Initial memory pool */
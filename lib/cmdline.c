@@ -0,0 +1,254 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Kernel command line builder
+ *
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ */
+
+#include <common.h>
+#include <cmdline.h>
+#include <malloc.h>
+
+/* Length of the key of @arg, i.e. up to '=', or 0 if it has no value */
+static int cmdline_keylen(const char *arg, int len)
+{
+	const char *eq = memchr(arg, '=', len);
+
+	return eq ? eq - arg : 0;
+}
+
+static char *cmdline_dup(const char *arg, int len)
+{
+	char *str = malloc(len + 1);
+
+	if (str) {
+		memcpy(str, arg, len);
+		str[len] = '\0';
+	}
+
+	return str;
+}
+
+/*
+ * Finds the next argument of @str, which may have spaces inside double
+ * quotes, e.g. dm="1 vroot none ro 1,0 ...". Returns its length and sets
+ * @argp, or returns 0 at the end of @str.
+ */
+static int cmdline_next(const char *str, const char **argp)
+{
+	const char *p;
+	bool quoted = false;
+
+	while (*str == ' ')
+		str++;
+
+	for (p = str; *p && (quoted || *p != ' '); p++) {
+		if (*p == '"')
+			quoted = !quoted;
+	}
+
+	*argp = str;
+
+	return p - str;
+}
+
+/* Whether @substr is in the @len first bytes of @arg */
+static bool cmdline_contains(const char *arg, int len, const char *substr)
+{
+	int n = strlen(substr);
+	int i;
+
+	for (i = 0; i + n <= len; i++) {
+		if (!strncmp(arg + i, substr, n))
+			return true;
+	}
+
+	return false;
+}
+
+static int cmdline_add(struct cmdline *cl, const char *arg, int len)
+{
+	char **args;
+	char *str;
+	int max;
+
+	if (cl->count == cl->max) {
+		max = cl->max ? cl->max * 2 : 32;
+		args = realloc(cl->args, max * sizeof(*args));
+		if (!args)
+			return -ENOMEM;
+		cl->args = args;
+		cl->max = max;
+	}
+
+	str = cmdline_dup(arg, len);
+	if (!str)
+		return -ENOMEM;
+	cl->args[cl->count++] = str;
+
+	return 0;
+}
+
+static void cmdline_remove(struct cmdline *cl, int i)
+{
+	free(cl->args[i]);
+	memmove(&cl->args[i], &cl->args[i + 1],
+		(cl->count - i - 1) * sizeof(*cl->args));
+	cl->count--;
+}
+
+/* Replaces the argument with the same key, or appends @arg */
+static int cmdline_set(struct cmdline *cl, const char *arg, int len)
+{
+	int keylen = cmdline_keylen(arg, len);
+	char *str;
+	int i;
+
+	for (i = 0; i < cl->count; i++) {
+		if (keylen) {
+			if (!strncmp(cl->args[i], arg, keylen + 1))
+				break;
+		} else if (strlen(cl->args[i]) == (size_t)len &&
+			   !strncmp(cl->args[i], arg, len)) {
+			return 0;
+		}
+	}
+
+	if (i == cl->count)
+		return cmdline_add(cl, arg, len);
+
+	str = cmdline_dup(arg, len);
+	if (!str)
+		return -ENOMEM;
+	free(cl->args[i]);
+	cl->args[i] = str;
+
+	return 0;
+}
+
+int cmdline_init(struct cmdline *cl, const char *str)
+{
+	const char *arg;
+	int len, ret;
+
+	memset(cl, 0, sizeof(*cl));
+	if (!str)
+		return 0;
+
+	/* Taken as is, only the arguments added later are merged */
+	while ((len = cmdline_next(str, &arg))) {
+		ret = cmdline_add(cl, arg, len);
+		if (ret)
+			return ret;
+		str = arg + len;
+	}
+
+	return 0;
+}
+
+void cmdline_uninit(struct cmdline *cl)
+{
+	int i;
+
+	for (i = 0; i < cl->count; i++)
+		free(cl->args[i]);
+	free(cl->args);
+	free(cl->buf);
+	memset(cl, 0, sizeof(*cl));
+}
+
+int cmdline_update(struct cmdline *cl, const char *args, const char *ignore)
+{
+	const char *arg;
+	int len, ret;
+
+	while ((len = cmdline_next(args, &arg))) {
+		if (!ignore || !cmdline_contains(arg, len, ignore)) {
+			ret = cmdline_set(cl, arg, len);
+			if (ret)
+				return ret;
+		}
+		args = arg + len;
+	}
+
+	return 0;
+}
+
+const char *cmdline_find(struct cmdline *cl, const char *prefix)
+{
+	int len = strlen(prefix);
+	int i;
+
+	for (i = 0; i < cl->count; i++) {
+		if (!strncmp(cl->args[i], prefix, len))
+			return cl->args[i];
+	}
+
+	return NULL;
+}
+
+void cmdline_delete(struct cmdline *cl, const char *prefix)
+{
+	int len = strlen(prefix);
+	int i;
+
+	for (i = 0; i < cl->count;) {
+		if (!strncmp(cl->args[i], prefix, len))
+			cmdline_remove(cl, i);
+		else
+			i++;
+	}
+}
+
+char *cmdline_extract(struct cmdline *cl, const char *substr)
+{
+	struct cmdline sub = { };
+	char *str;
+	int i;
+
+	for (i = 0; i < cl->count;) {
+		if (!strstr(cl->args[i], substr)) {
+			i++;
+			continue;
+		}
+		if (cmdline_add(&sub, cl->args[i], strlen(cl->args[i]))) {
+			cmdline_uninit(&sub);
+			return NULL;
+		}
+		cmdline_remove(cl, i);
+	}
+
+	/* Keep the string, free the rest */
+	str = (char *)cmdline_str(&sub);
+	sub.buf = NULL;
+	cmdline_uninit(&sub);
+
+	return str;
+}
+
+const char *cmdline_str(struct cmdline *cl)
+{
+	size_t len = 1;
+	char *p;
+	int i;
+
+	for (i = 0; i < cl->count; i++)
+		len += strlen(cl->args[i]) + 1;
+
+	free(cl->buf);
+	cl->buf = malloc(len);
+	if (!cl->buf)
+		return NULL;
+
+	p = cl->buf;
+	for (i = 0; i < cl->count; i++) {
+		if (i)
+			*p++ = ' ';
+		len = strlen(cl->args[i]);
+		memcpy(p, cl->args[i], len);
+		p += len;
+	}
+	*p = '\0';
+
+	return cl->buf;
+}
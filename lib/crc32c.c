@@ -13,8 +13,8 @@
 #include <common.h>
 #include <compiler.h>
 
-uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
-		    uint32_t *crc32c_table)
+uint32_t crc32c_cal_generic(uint32_t crc, const char *data, int length,
+			    uint32_t *crc32c_table)
 {
 	while (length--)
 		crc = crc32c_table[(u8)(crc ^ *data++)] ^ (crc >> 8);
@@ -22,6 +22,12 @@ uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
 	return crc;
 }
 
+__weak uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
+			   uint32_t *crc32c_table)
+{
+	return crc32c_cal_generic(crc, data, length, crc32c_table);
+}
+
 void crc32c_init(uint32_t *crc32c_table, uint32_t pol)
 {
 	int i, j;
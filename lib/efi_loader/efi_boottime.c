@@ -300,6 +300,8 @@ void efi_timer_check(void)
 	int i;
 	u64 now = timer_get_us();
 
+	efi_disk_poll();
+
 	for (i = 0; i < ARRAY_SIZE(efi_events); ++i) {
 		if (!efi_events[i].type ||
 		    !(efi_events[i].type & EVT_TIMER) ||
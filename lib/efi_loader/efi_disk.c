@@ -15,6 +15,12 @@
 #include <malloc.h>
 
 static const efi_guid_t efi_block_io_guid = BLOCK_IO_GUID;
+#ifdef CONFIG_EFI_LOADER_BLOCK_IO2
+static const efi_guid_t efi_block_io2_guid = BLOCK_IO2_GUID;
+
+/* Disks with a Block I/O 2 read in flight */
+static LIST_HEAD(efi_disk_pending);
+#endif
 
 struct efi_disk_obj {
 	/* Generic EFI object parent class data */
@@ -35,6 +41,18 @@ struct efi_disk_obj {
 	lbaint_t offset;
 	/* Internal block device */
 	struct blk_desc *desc;
+#ifdef CONFIG_EFI_LOADER_BLOCK_IO2
+	/* EFI Interface callback struct for block I/O 2 */
+	struct efi_block_io2 ops2;
+	/* Entry in efi_disk_pending while a read is in flight */
+	struct list_head pending;
+	/* The read in flight: token to complete and where to put the data */
+	struct efi_block_io2_token *token;
+	lbaint_t pending_lba;
+	lbaint_t pending_blocks;
+	lbaint_t pending_queued;
+	void *pending_buffer;
+#endif
 };
 
 static efi_status_t EFIAPI efi_disk_reset(struct efi_block_io *this,
@@ -49,6 +67,45 @@ enum efi_disk_direction {
 	EFI_DISK_WRITE,
 };
 
+#ifdef CONFIG_EFI_LOADER_BLOCK_IO2
+static void efi_disk_complete(struct efi_disk_obj *diskobj)
+{
+	struct blk_desc *desc = diskobj->desc;
+	struct efi_block_io2_token *token = diskobj->token;
+	lbaint_t rest = diskobj->pending_blocks - diskobj->pending_queued;
+	efi_status_t r = EFI_SUCCESS;
+
+	list_del(&diskobj->pending);
+	diskobj->token = NULL;
+
+	if (blk_wait(desc))
+		r = EFI_DEVICE_ERROR;
+
+	/* The device may have queued only part of the read */
+	if (r == EFI_SUCCESS && rest &&
+	    blk_dread(desc, diskobj->pending_lba + diskobj->pending_queued,
+		      rest, diskobj->pending_buffer +
+		      diskobj->pending_queued * desc->blksz) != rest)
+		r = EFI_DEVICE_ERROR;
+
+	token->transaction_status = r;
+	efi_signal_event(token->event);
+}
+
+/*
+ * Finish the reads in flight. We don't do interrupts, so this is called
+ * whenever the application checks or waits for an event, and before any
+ * other disk access: the block devices only take one read at a time.
+ */
+void efi_disk_poll(void)
+{
+	struct efi_disk_obj *diskobj, *n;
+
+	list_for_each_entry_safe(diskobj, n, &efi_disk_pending, pending)
+		efi_disk_complete(diskobj);
+}
+#endif
+
 static efi_status_t EFIAPI efi_disk_rw_blocks(struct efi_block_io *this,
 			u32 media_id, u64 lba, unsigned long buffer_size,
 			void *buffer, enum efi_disk_direction direction)
@@ -72,6 +129,9 @@ static efi_status_t EFIAPI efi_disk_rw_blocks(struct efi_block_io *this,
 	if (buffer_size & (blksz - 1))
 		return EFI_DEVICE_ERROR;
 
+	/* The device only takes one read at a time */
+	efi_disk_poll();
+
 	if (direction == EFI_DISK_READ)
 		n = blk_dread(desc, lba, blocks, buffer);
 	else
@@ -160,8 +220,14 @@ static efi_status_t EFIAPI efi_disk_write_blocks(struct efi_block_io *this,
 
 static efi_status_t EFIAPI efi_disk_flush_blocks(struct efi_block_io *this)
 {
-	/* We always write synchronously */
+	struct efi_disk_obj *diskobj;
+
+	/* We write synchronously, but the block cache may hold data back */
 	EFI_ENTRY("%p", this);
+	diskobj = container_of(this, struct efi_disk_obj, ops);
+	if (blk_flush(diskobj->desc))
+		return EFI_EXIT(EFI_DEVICE_ERROR);
+
 	return EFI_EXIT(EFI_SUCCESS);
 }
 
@@ -172,6 +238,129 @@ static const struct efi_block_io block_io_disk_template = {
 	.flush_blocks = &efi_disk_flush_blocks,
 };
 
+#ifdef CONFIG_EFI_LOADER_BLOCK_IO2
+static efi_status_t EFIAPI efi_disk_reset_ex(struct efi_block_io2 *this,
+			char extended_verification)
+{
+	EFI_ENTRY("%p, %x", this, extended_verification);
+	return EFI_EXIT(EFI_DEVICE_ERROR);
+}
+
+/* Signal a token for a request that was handled synchronously */
+static efi_status_t efi_disk_token_done(struct efi_block_io2_token *token,
+					efi_status_t r)
+{
+	if (token && token->event) {
+		token->transaction_status = r;
+		efi_signal_event(token->event);
+		return EFI_SUCCESS;
+	}
+
+	return r;
+}
+
+static efi_status_t EFIAPI efi_disk_read_blocks_ex(struct efi_block_io2 *this,
+			u32 media_id, u64 lba,
+			struct efi_block_io2_token *token,
+			unsigned long buffer_size, void *buffer)
+{
+	struct efi_disk_obj *diskobj;
+	struct blk_desc *desc;
+	lbaint_t blocks;
+	unsigned long n;
+	efi_status_t r;
+
+	EFI_ENTRY("%p, %x, %"PRIx64", %p, %lx, %p", this, media_id, lba,
+		  token, buffer_size, buffer);
+
+	diskobj = container_of(this, struct efi_disk_obj, ops2);
+	desc = diskobj->desc;
+
+	if (!buffer)
+		return EFI_EXIT(EFI_INVALID_PARAMETER);
+
+	/*
+	 * Without an event, or when the data has to go through the bounce
+	 * buffer, this is an ordinary Block I/O read
+	 */
+	if (!token || !token->event ||
+	    IS_ENABLED(CONFIG_EFI_LOADER_BOUNCE_BUFFER)) {
+		EFI_CALL(r = efi_disk_read_blocks(&diskobj->ops, media_id, lba,
+						  buffer_size, buffer));
+		return EFI_EXIT(efi_disk_token_done(token, r));
+	}
+
+	if (buffer_size & (desc->blksz - 1))
+		return EFI_EXIT(EFI_BAD_BUFFER_SIZE);
+
+	/* Let the previous read finish, the device only takes one */
+	efi_disk_poll();
+
+	blocks = buffer_size / desc->blksz;
+	lba += diskobj->offset;
+	n = blk_dread_async(desc, lba, blocks, buffer);
+	if (IS_ERR_VALUE(n) || !n) {
+		token->transaction_status = EFI_DEVICE_ERROR;
+		efi_signal_event(token->event);
+		return EFI_EXIT(EFI_SUCCESS);
+	}
+
+	diskobj->token = token;
+	diskobj->pending_lba = lba;
+	diskobj->pending_blocks = blocks;
+	diskobj->pending_queued = n;
+	diskobj->pending_buffer = buffer;
+	list_add_tail(&diskobj->pending, &efi_disk_pending);
+
+	return EFI_EXIT(EFI_SUCCESS);
+}
+
+static efi_status_t EFIAPI efi_disk_write_blocks_ex(struct efi_block_io2 *this,
+			u32 media_id, u64 lba,
+			struct efi_block_io2_token *token,
+			unsigned long buffer_size, void *buffer)
+{
+	struct efi_disk_obj *diskobj;
+	efi_status_t r;
+
+	EFI_ENTRY("%p, %x, %"PRIx64", %p, %lx, %p", this, media_id, lba,
+		  token, buffer_size, buffer);
+
+	/* We always write synchronously */
+	diskobj = container_of(this, struct efi_disk_obj, ops2);
+	if (!buffer)
+		return EFI_EXIT(EFI_INVALID_PARAMETER);
+
+	EFI_CALL(r = efi_disk_write_blocks(&diskobj->ops, media_id, lba,
+					   buffer_size, buffer));
+
+	return EFI_EXIT(efi_disk_token_done(token, r));
+}
+
+static efi_status_t EFIAPI efi_disk_flush_blocks_ex(struct efi_block_io2 *this,
+			struct efi_block_io2_token *token)
+{
+	struct efi_disk_obj *diskobj;
+	efi_status_t r;
+
+	EFI_ENTRY("%p, %p", this, token);
+	diskobj = container_of(this, struct efi_disk_obj, ops2);
+
+	/* Reads in flight are part of what has to be done */
+	efi_disk_poll();
+	EFI_CALL(r = efi_disk_flush_blocks(&diskobj->ops));
+
+	return EFI_EXIT(efi_disk_token_done(token, r));
+}
+
+static const struct efi_block_io2 block_io2_disk_template = {
+	.reset = &efi_disk_reset_ex,
+	.read_blocks_ex = &efi_disk_read_blocks_ex,
+	.write_blocks_ex = &efi_disk_write_blocks_ex,
+	.flush_blocks_ex = &efi_disk_flush_blocks_ex,
+};
+#endif
+
 static void efi_disk_add_dev(const char *name,
 			     const char *if_typename,
 			     struct blk_desc *desc,
@@ -209,6 +398,14 @@ static void efi_disk_add_dev(const char *name,
 	diskobj->media.last_block = desc->lba - offset;
 	diskobj->ops.media = &diskobj->media;
 
+#ifdef CONFIG_EFI_LOADER_BLOCK_IO2
+	diskobj->parent.protocols[2].guid = &efi_block_io2_guid;
+	diskobj->parent.protocols[2].protocol_interface = &diskobj->ops2;
+	diskobj->ops2 = block_io2_disk_template;
+	diskobj->ops2.media = &diskobj->media;
+	INIT_LIST_HEAD(&diskobj->pending);
+#endif
+
 	/* Hook up to the device list */
 	list_add_tail(&diskobj->parent.link, &efi_obj_list);
 }
@@ -11,23 +11,23 @@
 #include <malloc.h>
 #include <asm/global_data.h>
 #include <linux/libfdt_env.h>
-#include <linux/list_sort.h>
+#include <linux/rbtree.h>
 #include <inttypes.h>
 #include <watchdog.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
 struct efi_mem_list {
-	struct list_head link;
+	struct rb_node node;
 	struct efi_mem_desc desc;
 };
 
-#define EFI_CARVE_NO_OVERLAP		-1
-#define EFI_CARVE_LOOP_AGAIN		-2
-#define EFI_CARVE_OVERLAPS_NONRAM	-3
-
-/* This list contains all memory map items */
-LIST_HEAD(efi_mem);
+/*
+ * This tree contains all memory map items, sorted by address. The items
+ * never overlap, so their ends are in the same order as their starts.
+ */
+static struct rb_root efi_mem = RB_ROOT;
+static int efi_mem_entries;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 void *efi_bounce_buffer;
@@ -46,114 +46,189 @@ struct efi_pool_allocation {
 	char data[];
 };
 
-/*
- * Sorts the memory list from highest address to lowest address
- *
- * When allocating memory we should always start from the highest
- * address chunk, so sort the memory list such that the first list
- * iterator gets the highest address and goes lower from there.
- */
-static int efi_mem_cmp(void *priv, struct list_head *a, struct list_head *b)
+static uint64_t efi_mem_end(struct efi_mem_list *lmem)
 {
-	struct efi_mem_list *mema = list_entry(a, struct efi_mem_list, link);
-	struct efi_mem_list *memb = list_entry(b, struct efi_mem_list, link);
+	return lmem->desc.physical_start +
+	       (lmem->desc.num_pages << EFI_PAGE_SHIFT);
+}
 
-	if (mema->desc.physical_start == memb->desc.physical_start)
-		return 0;
-	else if (mema->desc.physical_start < memb->desc.physical_start)
-		return 1;
-	else
-		return -1;
+static struct efi_mem_list *efi_mem_next(struct efi_mem_list *lmem)
+{
+	return rb_entry_safe(rb_next(&lmem->node), struct efi_mem_list, node);
+}
+
+static struct efi_mem_list *efi_mem_prev(struct efi_mem_list *lmem)
+{
+	return rb_entry_safe(rb_prev(&lmem->node), struct efi_mem_list, node);
+}
+
+/* Returns the lowest map item that ends above addr */
+static struct efi_mem_list *efi_mem_first_above(uint64_t addr)
+{
+	struct rb_node *n = efi_mem.rb_node;
+	struct efi_mem_list *found = NULL;
+
+	while (n) {
+		struct efi_mem_list *lmem = rb_entry(n, struct efi_mem_list,
+						     node);
+
+		if (efi_mem_end(lmem) > addr) {
+			found = lmem;
+			n = n->rb_left;
+		} else {
+			n = n->rb_right;
+		}
+	}
+
+	return found;
 }
 
-static void efi_mem_sort(void)
+/* Returns the highest map item that starts below addr */
+static struct efi_mem_list *efi_mem_last_below(uint64_t addr)
 {
-	list_sort(NULL, &efi_mem, efi_mem_cmp);
+	struct rb_node *n = efi_mem.rb_node;
+	struct efi_mem_list *found = NULL;
+
+	while (n) {
+		struct efi_mem_list *lmem = rb_entry(n, struct efi_mem_list,
+						     node);
+
+		if (lmem->desc.physical_start < addr) {
+			found = lmem;
+			n = n->rb_right;
+		} else {
+			n = n->rb_left;
+		}
+	}
+
+	return found;
+}
+
+static void efi_mem_insert(struct efi_mem_list *newmem)
+{
+	struct rb_node **link = &efi_mem.rb_node, *parent = NULL;
+
+	while (*link) {
+		struct efi_mem_list *lmem;
+
+		parent = *link;
+		lmem = rb_entry(parent, struct efi_mem_list, node);
+		if (newmem->desc.physical_start < lmem->desc.physical_start)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+
+	rb_link_node(&newmem->node, parent, link);
+	rb_insert_color(&newmem->node, &efi_mem);
+	efi_mem_entries++;
+}
+
+static void efi_mem_remove(struct efi_mem_list *lmem)
+{
+	rb_erase(&lmem->node, &efi_mem);
+	efi_mem_entries--;
+	free(lmem);
 }
 
 /*
- * Unmaps all memory occupied by the carve_desc region from the
- * list entry pointed to by map.
- *
- * Returns EFI_CARVE_NO_OVERLAP if the regions don't overlap.
- * Returns EFI_CARVE_OVERLAPS_NONRAM if the carve and map overlap,
- *    and the map contains anything but free ram.
- *    (only when overlap_only_ram is true)
- * Returns EFI_CARVE_LOOP_AGAIN if the mapping list should be traversed
- *    again, as it has been altered
- * Returns the number of overlapping pages. The pages are removed from
- *     the mapping list.
- *
- * In case of EFI_CARVE_OVERLAPS_NONRAM it is the callers responsibility
- * to readd the already carved out pages to the mapping.
+ * Checks that [start, end) only covers free RAM, all of it known to the
+ * memory map. This is what allocations ask for.
  */
-static int efi_mem_carve_out(struct efi_mem_list *map,
-			     struct efi_mem_desc *carve_desc,
-			     bool overlap_only_ram)
+static bool efi_mem_is_free_ram(uint64_t start, uint64_t end)
 {
-	struct efi_mem_list *newmap;
-	struct efi_mem_desc *map_desc = &map->desc;
-	uint64_t map_start = map_desc->physical_start;
-	uint64_t map_end = map_start + (map_desc->num_pages << EFI_PAGE_SHIFT);
-	uint64_t carve_start = carve_desc->physical_start;
-	uint64_t carve_end = carve_start +
-			     (carve_desc->num_pages << EFI_PAGE_SHIFT);
-
-	/* check whether we're overlapping */
-	if ((carve_end <= map_start) || (carve_start >= map_end))
-		return EFI_CARVE_NO_OVERLAP;
-
-	/* We're overlapping with non-RAM, warn the caller if desired */
-	if (overlap_only_ram && (map_desc->type != EFI_CONVENTIONAL_MEMORY))
-		return EFI_CARVE_OVERLAPS_NONRAM;
-
-	/* Sanitize carve_start and carve_end to lie within our bounds */
-	carve_start = max(carve_start, map_start);
-	carve_end = min(carve_end, map_end);
-
-	/* Carving at the beginning of our map? Just move it! */
-	if (carve_start == map_start) {
-		if (map_end == carve_end) {
-			/* Full overlap, just remove map */
-			list_del(&map->link);
-			free(map);
+	struct efi_mem_list *lmem = efi_mem_first_above(start);
+	uint64_t addr = start;
+
+	for (; lmem && addr < end; lmem = efi_mem_next(lmem)) {
+		/* A hole not covered by any map */
+		if (lmem->desc.physical_start > addr)
+			return false;
+		if (lmem->desc.type != EFI_CONVENTIONAL_MEMORY)
+			return false;
+		addr = efi_mem_end(lmem);
+	}
+
+	return addr >= end;
+}
+
+/*
+ * Unmaps [start, end) from all map items it overlaps. At most the first
+ * and the last overlapping items survive, shrunk or split; all others are
+ * fully covered and dropped.
+ */
+static void efi_mem_carve_out(uint64_t start, uint64_t end)
+{
+	struct efi_mem_list *lmem = efi_mem_first_above(start);
+
+	while (lmem && lmem->desc.physical_start < end) {
+		struct efi_mem_list *next = efi_mem_next(lmem);
+		uint64_t map_start = lmem->desc.physical_start;
+		uint64_t map_end = efi_mem_end(lmem);
+
+		if (map_start < start) {
+			/* Keep [ map_start ... start ] */
+			lmem->desc.num_pages = (start - map_start)
+					       >> EFI_PAGE_SHIFT;
+
+			if (map_end > end) {
+				/* And add [ end ... map_end ] */
+				struct efi_mem_list *newmem;
+
+				newmem = calloc(1, sizeof(*newmem));
+				newmem->desc = lmem->desc;
+				newmem->desc.physical_start = end;
+				newmem->desc.num_pages = (map_end - end)
+							 >> EFI_PAGE_SHIFT;
+				efi_mem_insert(newmem);
+				break;
+			}
+		} else if (map_end > end) {
+			/* Move to [ end ... map_end ], the order stays */
+			lmem->desc.physical_start = end;
+			lmem->desc.num_pages = (map_end - end) >> EFI_PAGE_SHIFT;
 		} else {
-			map->desc.physical_start = carve_end;
-			map->desc.num_pages = (map_end - carve_end)
-					      >> EFI_PAGE_SHIFT;
+			/* Full overlap, just remove map */
+			efi_mem_remove(lmem);
 		}
 
-		return (carve_end - carve_start) >> EFI_PAGE_SHIFT;
+		lmem = next;
 	}
+}
 
-	/*
-	 * Overlapping maps, just split the list map at carve_start,
-	 * it will get moved or removed in the next iteration.
-	 *
-	 * [ map_desc |__carve_start__| newmap ]
-	 */
+static bool efi_mem_can_merge(struct efi_mem_list *a, struct efi_mem_list *b)
+{
+	return a->desc.type == b->desc.type &&
+	       a->desc.attribute == b->desc.attribute &&
+	       efi_mem_end(a) == b->desc.physical_start;
+}
 
-	/* Create a new map from [ carve_start ... map_end ] */
-	newmap = calloc(1, sizeof(*newmap));
-	newmap->desc = map->desc;
-	newmap->desc.physical_start = carve_start;
-	newmap->desc.num_pages = (map_end - carve_start) >> EFI_PAGE_SHIFT;
-	/* Insert before current entry (descending address order) */
-	list_add_tail(&newmap->link, &map->link);
+/*
+ * Merges a new map item with its neighbours of the same type, so that
+ * freeing what was allocated gives the free region back in one piece and
+ * the map does not grow with every allocation.
+ */
+static void efi_mem_merge(struct efi_mem_list *lmem)
+{
+	struct efi_mem_list *prev = efi_mem_prev(lmem);
+	struct efi_mem_list *next = efi_mem_next(lmem);
 
-	/* Shrink the map to [ map_start ... carve_start ] */
-	map_desc->num_pages = (carve_start - map_start) >> EFI_PAGE_SHIFT;
+	if (next && efi_mem_can_merge(lmem, next)) {
+		lmem->desc.num_pages += next->desc.num_pages;
+		efi_mem_remove(next);
+	}
 
-	return EFI_CARVE_LOOP_AGAIN;
+	if (prev && efi_mem_can_merge(prev, lmem)) {
+		prev->desc.num_pages += lmem->desc.num_pages;
+		efi_mem_remove(lmem);
+	}
 }
 
 uint64_t efi_add_memory_map(uint64_t start, uint64_t pages, int memory_type,
 			    bool overlap_only_ram)
 {
-	struct list_head *lhandle;
-	struct efi_mem_list *newlist;
-	bool carve_again;
-	uint64_t carved_pages = 0;
+	struct efi_mem_list *newmem;
+	uint64_t end = start + (pages << EFI_PAGE_SHIFT);
 
 	debug("%s: 0x%" PRIx64 " 0x%" PRIx64 " %d %s\n", __func__,
 	      start, pages, memory_type, overlap_only_ram ? "yes" : "no");
@@ -161,94 +236,54 @@ uint64_t efi_add_memory_map(uint64_t start, uint64_t pages, int memory_type,
 	if (!pages)
 		return start;
 
-	newlist = calloc(1, sizeof(*newlist));
-	newlist->desc.type = memory_type;
-	newlist->desc.physical_start = start;
-	newlist->desc.virtual_start = start;
-	newlist->desc.num_pages = pages;
+	/*
+	 * The payload wanted to have RAM overlaps only, but we overlapped
+	 * with a non-RAM or an unallocated region. Error out before anything
+	 * is changed.
+	 */
+	if (overlap_only_ram && !efi_mem_is_free_ram(start, end))
+		return 0;
+
+	newmem = calloc(1, sizeof(*newmem));
+	newmem->desc.type = memory_type;
+	newmem->desc.physical_start = start;
+	newmem->desc.virtual_start = start;
+	newmem->desc.num_pages = pages;
 
 	switch (memory_type) {
 	case EFI_RUNTIME_SERVICES_CODE:
 	case EFI_RUNTIME_SERVICES_DATA:
-		newlist->desc.attribute = (1 << EFI_MEMORY_WB_SHIFT) |
-					  (1ULL << EFI_MEMORY_RUNTIME_SHIFT);
+		newmem->desc.attribute = (1 << EFI_MEMORY_WB_SHIFT) |
+					 (1ULL << EFI_MEMORY_RUNTIME_SHIFT);
 		break;
 	case EFI_MMAP_IO:
-		newlist->desc.attribute = 1ULL << EFI_MEMORY_RUNTIME_SHIFT;
+		newmem->desc.attribute = 1ULL << EFI_MEMORY_RUNTIME_SHIFT;
 		break;
 	default:
-		newlist->desc.attribute = 1 << EFI_MEMORY_WB_SHIFT;
+		newmem->desc.attribute = 1 << EFI_MEMORY_WB_SHIFT;
 		break;
 	}
 
 	/* Add our new map */
-	do {
-		carve_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			int r;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			r = efi_mem_carve_out(lmem, &newlist->desc,
-					      overlap_only_ram);
-			switch (r) {
-			case EFI_CARVE_OVERLAPS_NONRAM:
-				/*
-				 * The user requested to only have RAM overlaps,
-				 * but we hit a non-RAM region. Error out.
-				 */
-				return 0;
-			case EFI_CARVE_NO_OVERLAP:
-				/* Just ignore this list entry */
-				break;
-			case EFI_CARVE_LOOP_AGAIN:
-				/*
-				 * We split an entry, but need to loop through
-				 * the list again to actually carve it.
-				 */
-				carve_again = true;
-				break;
-			default:
-				/* We carved a number of pages */
-				carved_pages += r;
-				carve_again = true;
-				break;
-			}
-
-			if (carve_again) {
-				/* The list changed, we need to start over */
-				break;
-			}
-		}
-	} while (carve_again);
-
-	if (overlap_only_ram && (carved_pages != pages)) {
-		/*
-		 * The payload wanted to have RAM overlaps, but we overlapped
-		 * with an unallocated region. Error out.
-		 */
-		return 0;
-	}
-
-	/* Add our new map */
-        list_add_tail(&newlist->link, &efi_mem);
-
-	/* And make sure memory is listed in descending order */
-	efi_mem_sort();
+	efi_mem_carve_out(start, end);
+	efi_mem_insert(newmem);
+	efi_mem_merge(newmem);
 
 	return start;
 }
 
 static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
 {
-	struct list_head *lhandle;
+	struct efi_mem_list *lmem;
 
-	list_for_each(lhandle, &efi_mem) {
-		struct efi_mem_list *lmem = list_entry(lhandle,
-			struct efi_mem_list, link);
+	/*
+	 * When allocating memory we should always start from the highest
+	 * address chunk, so go down from the last map below max_addr.
+	 */
+	for (lmem = efi_mem_last_below(max_addr); lmem;
+	     lmem = efi_mem_prev(lmem)) {
 		struct efi_mem_desc *desc = &lmem->desc;
-		uint64_t desc_len = desc->num_pages << EFI_PAGE_SHIFT;
-		uint64_t desc_end = desc->physical_start + desc_len;
+		uint64_t desc_end = efi_mem_end(lmem);
 		uint64_t curmax = min(max_addr, desc_end);
 		uint64_t ret = curmax - len;
 
@@ -343,7 +378,6 @@ efi_status_t efi_free_pages(uint64_t memory, unsigned long pages)
 	uint64_t r = 0;
 
 	r = efi_add_memory_map(memory, pages, EFI_CONVENTIONAL_MEMORY, false);
-	/* Merging of adjacent free regions is missing */
 
 	if (r == memory)
 		return EFI_SUCCESS;
@@ -398,14 +432,10 @@ efi_status_t efi_get_memory_map(unsigned long *memory_map_size,
 			       uint32_t *descriptor_version)
 {
 	ulong map_size = 0;
-	int map_entries = 0;
-	struct list_head *lhandle;
+	struct rb_node *n;
 	unsigned long provided_map_size = *memory_map_size;
 
-	list_for_each(lhandle, &efi_mem)
-		map_entries++;
-
-	map_size = map_entries * sizeof(struct efi_mem_desc);
+	map_size = efi_mem_entries * sizeof(struct efi_mem_desc);
 
 	*memory_map_size = map_size;
 
@@ -418,16 +448,13 @@ efi_status_t efi_get_memory_map(unsigned long *memory_map_size,
 	if (descriptor_version)
 		*descriptor_version = EFI_MEMORY_DESCRIPTOR_VERSION;
 
-	/* Copy list into array */
+	/* Copy tree into array, in ascending order */
 	if (memory_map) {
-		/* Return the list in ascending order */
-		memory_map = &memory_map[map_entries - 1];
-		list_for_each(lhandle, &efi_mem) {
+		for (n = rb_first(&efi_mem); n; n = rb_next(n)) {
 			struct efi_mem_list *lmem;
 
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			*memory_map = lmem->desc;
-			memory_map--;
+			lmem = rb_entry(n, struct efi_mem_list, node);
+			*memory_map++ = lmem->desc;
 		}
 	}
 
@@ -9,12 +9,18 @@
 #include <watchdog.h>
 #include <command.h>
 #include <console.h>
+#include <errno.h>
 #include <image.h>
 #include <malloc.h>
 #include <memalign.h>
 #include <misc.h>
 #include <u-boot/zlib.h>
 #include <div64.h>
+#include <asm/unaligned.h>
+#if defined(CONFIG_GZIP_SMP) && !defined(CONFIG_SPL_BUILD)
+#include <asm/arch/smp_work.h>
+#include <linux/sizes.h>
+#endif
 
 #define HEADER0			'\x1f'
 #define HEADER1			'\x8b'
@@ -71,16 +77,222 @@ int gzip_parse_header(const unsigned char *src, unsigned long len)
 	return i;
 }
 
+#if defined(CONFIG_GZIP_SMP) && !defined(CONFIG_SPL_BUILD)
+#define GZIP_SMP_HEAP		SZ_64K	/* inflate state and window */
+
+struct gzip_smp_member {
+	unsigned char *in;	/* deflate data */
+	uint in_len;
+	unsigned char *out;
+	uint out_len;
+	int ret;
+};
+
+struct gzip_smp_heap {
+	void *base;
+	uint used;
+};
+
+struct gzip_smp {
+	struct gzip_smp_member *mbr;
+	int nr_mbrs;
+	int next;		/* next member to be claimed by a CPU */
+	void *heap;		/* GZIP_SMP_HEAP for each of nr_heaps CPUs */
+	int nr_heaps;
+};
+
+/* BGZF members record their size in a 'BC' subfield of the extra field */
+static uint gzip_bgzf_size(const unsigned char *src, unsigned long len)
+{
+	uint xlen, slen, i, size;
+
+	if (len < 18 || src[0] != (u8)HEADER0 || src[1] != (u8)HEADER1 ||
+	    src[2] != DEFLATED || !(src[3] & EXTRA_FIELD) ||
+	    (src[3] & RESERVED))
+		return 0;
+
+	xlen = get_unaligned_le16(src + 10);
+	if (12 + xlen > len)
+		return 0;
+
+	for (i = 12; i + 4 <= 12 + xlen; i += 4 + slen) {
+		slen = get_unaligned_le16(src + i + 2);
+		if (src[i] != 'B' || src[i + 1] != 'C' || slen != 2 ||
+		    i + 6 > 12 + xlen)
+			continue;
+
+		size = get_unaligned_le16(src + i + 4) + 1;
+		/* Header, deflate data, CRC32 and ISIZE */
+		if (size < 12 + xlen + 8 || size > len)
+			return 0;
+		return size;
+	}
+
+	return 0;
+}
+
+/* zlib's allocator for the workers, which may not use malloc() */
+static void *gzip_smp_alloc(void *x, unsigned items, unsigned size)
+{
+	struct gzip_smp_heap *heap = x;
+	void *p;
+
+	size = ALIGN(size * items, ZALLOC_ALIGNMENT);
+	if (size > GZIP_SMP_HEAP - heap->used)
+		return NULL;
+
+	p = heap->base + heap->used;
+	heap->used += size;
+
+	return p;
+}
+
+static void gzip_smp_free(void *x, void *addr, unsigned nb)
+{
+}
+
+static int gzip_smp_inflate(struct gzip_smp_member *m, void *base)
+{
+	struct gzip_smp_heap heap = { base, 0 };
+	z_stream s;
+	int r;
+
+	memset(&s, 0, sizeof(s));
+	s.zalloc = gzip_smp_alloc;
+	s.zfree = gzip_smp_free;
+	s.opaque = &heap;
+
+	r = inflateInit2(&s, -MAX_WBITS);
+	if (r != Z_OK)
+		return r;
+	s.next_in = m->in;
+	s.avail_in = m->in_len;
+	s.next_out = m->out;
+	s.avail_out = m->out_len;
+	r = inflate(&s, Z_FINISH);
+	inflateEnd(&s);
+
+	if (r == Z_STREAM_END && s.avail_out)
+		r = Z_DATA_ERROR;	/* shorter than its ISIZE */
+
+	return r == Z_STREAM_END ? 0 : r;
+}
+
+/* Runs on every CPU, each claiming the next member not inflated yet */
+static void gzip_smp_decode(void *arg, int cpu, int nr_cpus)
+{
+	struct gzip_smp *ctx = arg;
+	int i;
+
+	if (cpu >= ctx->nr_heaps)
+		return;
+
+	while ((i = __atomic_fetch_add(&ctx->next, 1, __ATOMIC_RELAXED)) <
+	       ctx->nr_mbrs)
+		ctx->mbr[i].ret = gzip_smp_inflate(&ctx->mbr[i],
+						   ctx->heap + cpu * GZIP_SMP_HEAP);
+}
+
+/*
+ * Return: 0 if OK, -EAGAIN if @src is not made of BGZF members, or -1 on
+ * error as for zunzip()
+ */
+static int gunzip_smp(void *dst, int dstlen, unsigned char *src,
+		      unsigned long *lenp)
+{
+	struct gzip_smp_member *m;
+	struct gzip_smp ctx;
+	unsigned long off, out;
+	uint size;
+	int i, offset, nr_cpus = 1, ret = -1;
+
+	/* First pass: count the members, anything after them is ignored */
+	ctx.nr_mbrs = 0;
+	for (off = 0; off < *lenp; off += size) {
+		size = gzip_bgzf_size(src + off, *lenp - off);
+		if (!size)
+			break;
+		ctx.nr_mbrs++;
+	}
+	if (ctx.nr_mbrs < 2)
+		return -EAGAIN;
+
+	ctx.mbr = malloc(ctx.nr_mbrs * sizeof(*ctx.mbr));
+	if (!ctx.mbr)
+		return -EAGAIN;
+
+	/* Second pass: place each member's output by the ISIZE before it */
+	for (i = 0, off = 0, out = 0; i < ctx.nr_mbrs; i++, off += size) {
+		m = &ctx.mbr[i];
+		size = gzip_bgzf_size(src + off, *lenp - off);
+		offset = gzip_parse_header(src + off, size - 8);
+		if (offset < 0)
+			goto out;
+		m->in = src + off + offset;
+		m->in_len = size - offset - 8;
+		m->out = dst + out;
+		m->out_len = get_unaligned_le32(src + off + size - 4);
+		if (m->out_len > dstlen - out) {
+			printf("Error: gunzip output exceeds %d bytes\n",
+			       dstlen);
+			goto out;
+		}
+		out += m->out_len;
+	}
+
+	/* In-place: later members could overwrite input not decoded yet */
+	if (dst >= (void *)src + off || (void *)src >= dst + dstlen)
+		nr_cpus = mp_task_pool_start() + 1;
+
+	ctx.heap = malloc(nr_cpus * GZIP_SMP_HEAP);
+	if (!ctx.heap && nr_cpus > 1) {
+		nr_cpus = 1;
+		ctx.heap = malloc(GZIP_SMP_HEAP);
+	}
+	if (!ctx.heap) {
+		printf("Error: no memory for gunzip\n");
+		goto out;
+	}
+	ctx.nr_heaps = nr_cpus;
+	ctx.next = 0;
+
+	if (nr_cpus > 1)
+		smp_work_run(gzip_smp_decode, &ctx);
+	else
+		gzip_smp_decode(&ctx, 0, 1);
+	free(ctx.heap);
+
+	for (i = 0; i < ctx.nr_mbrs; i++) {
+		if (ctx.mbr[i].ret) {
+			printf("Error: inflate() returned %d for member %d\n",
+			       ctx.mbr[i].ret, i);
+			goto out;
+		}
+	}
+
+	*lenp = out;
+	ret = 0;
+out:
+	free(ctx.mbr);
+	return ret;
+}
+#endif
+
 int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 {
 	int offset = gzip_parse_header(src, *lenp);
+	int __maybe_unused ret;
 
 	if (offset < 0)
 		return offset;
 
+#if defined(CONFIG_GZIP_SMP) && !defined(CONFIG_SPL_BUILD)
+	/* BGZF first, a single gzip member is left to the decoders below */
+	ret = gunzip_smp(dst, dstlen, src, lenp);
+	if (ret != -EAGAIN)
+		return ret;
+#endif
 #if defined(CONFIG_MISC_DECOMPRESS) && !defined(CONFIG_SPL_BUILD)
-	int ret;
-
 	ret = misc_decompress_process((ulong)dst, (ulong)src, *lenp,
 				      DECOM_GZIP, false, (u64 *)lenp, 0);
 	if (!ret)
@@ -125,17 +337,124 @@ void gzwrite_progress_finish(int returnval,
 	}
 }
 
+/* State of a gzwrite(), shared with the CPU inflating the next buffer */
+struct gzwrite_ctx {
+	z_stream s;
+	unsigned long szwritebuf;
+	unsigned crc;		/* of the data inflated so far */
+#if defined(CONFIG_MISC_DECOMPRESS) && !defined(CONFIG_SPL_BUILD)
+	unsigned char *hw_out;	/* all of the data, inflated by the engine */
+	u64 hw_size;
+	u64 hw_done;		/* bytes of hw_out given out for writing */
+#endif
+#if defined(CONFIG_GZIP_SMP) && !defined(CONFIG_SPL_BUILD)
+	struct gzip_smp_heap heap;
+#endif
+};
+
+struct gzwrite_buf {
+	struct gzwrite_ctx *gz;
+	unsigned char *data;	/* szwritebuf bytes for inflate() */
+	unsigned char *out;	/* the data to write */
+	int numfilled;
+	int ret;		/* of inflate() */
+#if defined(CONFIG_GZIP_SMP) && !defined(CONFIG_SPL_BUILD)
+	struct mp_task task;
+#endif
+};
+
+/* Fills @b with the next szwritebuf bytes of the image */
+static void gzwrite_inflate(struct gzwrite_buf *b)
+{
+	struct gzwrite_ctx *gz = b->gz;
+
+#if defined(CONFIG_MISC_DECOMPRESS) && !defined(CONFIG_SPL_BUILD)
+	if (gz->hw_out) {
+		b->out = gz->hw_out + gz->hw_done;
+		b->numfilled = min_t(u64, gz->szwritebuf,
+				     gz->hw_size - gz->hw_done);
+		gz->hw_done += b->numfilled;
+		b->ret = gz->hw_done == gz->hw_size ? Z_STREAM_END : Z_OK;
+		gz->crc = crc32(gz->crc, b->out, b->numfilled);
+		return;
+	}
+#endif
+	gz->s.avail_out = gz->szwritebuf;
+	gz->s.next_out = b->data;
+	b->ret = inflate(&gz->s, Z_SYNC_FLUSH);
+	b->out = b->data;
+	b->numfilled = gz->szwritebuf - gz->s.avail_out;
+	gz->crc = crc32(gz->crc, b->out, b->numfilled);
+}
+
+#if defined(CONFIG_GZIP_SMP) && !defined(CONFIG_SPL_BUILD)
+static void gzwrite_inflate_task(void *arg)
+{
+	gzwrite_inflate(arg);
+}
+#endif
+
+/*
+ * Starts filling @b, on a secondary CPU if there is one, for the boot CPU
+ * to write the previous buffer meanwhile
+ */
+static void gzwrite_inflate_start(struct gzwrite_buf *b)
+{
+#if defined(CONFIG_GZIP_SMP) && !defined(CONFIG_SPL_BUILD)
+	mp_task_submit(&b->task, gzwrite_inflate_task, b);
+#else
+	gzwrite_inflate(b);
+#endif
+}
+
+static void gzwrite_inflate_wait(struct gzwrite_buf *b)
+{
+#if defined(CONFIG_GZIP_SMP) && !defined(CONFIG_SPL_BUILD)
+	mp_task_wait(&b->task);
+#endif
+}
+
+#if defined(CONFIG_MISC_DECOMPRESS) && !defined(CONFIG_SPL_BUILD)
+/*
+ * The decompression engine has no output window, so it is only used when
+ * all of the data fits in malloc(). One block more is for padding the end.
+ */
+static unsigned char *gzwrite_hw_inflate(unsigned char *src, int len,
+					 u64 szexpected, unsigned long blksz)
+{
+	unsigned char *dst;
+	u64 size;
+	int ret;
+
+	if (szexpected > ULONG_MAX - blksz)
+		return NULL;
+
+	dst = malloc_cache_aligned(szexpected + blksz);
+	if (!dst)
+		return NULL;
+
+	ret = misc_decompress_process((ulong)dst, (ulong)src, len, DECOM_GZIP,
+				      true, &size, 0);
+	if (!ret && size == szexpected)
+		return dst;
+
+	printf("hw gunzip failed(%d), fallback to soft gunzip\n", ret);
+	free(dst);
+
+	return NULL;
+}
+#endif
+
 int gzwrite(unsigned char *src, int len,
 	    struct blk_desc *dev,
 	    unsigned long szwritebuf,
 	    u64 startoffs,
 	    u64 szexpected)
 {
-	int i, flags;
-	z_stream s;
+	struct gzwrite_buf buf[2], *b, *next;
+	struct gzwrite_ctx gz;
+	int i, j, flags;
 	int r = 0;
-	unsigned char *writebuf;
-	unsigned crc = 0;
 	u64 totalfilled = 0;
 	lbaint_t blksperbuf, outblock;
 	u32 expected_crc;
@@ -203,79 +522,138 @@ int gzwrite(unsigned char *src, int len,
 
 	gzwrite_progress_init(szexpected);
 
-	s.zalloc = gzalloc;
-	s.zfree = gzfree;
+	memset(&gz, 0, sizeof(gz));
+	memset(buf, 0, sizeof(buf));
+	gz.szwritebuf = szwritebuf;
+	for (j = 0; j < ARRAY_SIZE(buf); j++)
+		buf[j].gz = &gz;
 
-	r = inflateInit2(&s, -MAX_WBITS);
-	if (r != Z_OK) {
-		printf("Error: inflateInit2() returned %d\n", r);
-		return -1;
-	}
+#if defined(CONFIG_MISC_DECOMPRESS) && !defined(CONFIG_SPL_BUILD)
+	gz.hw_out = gzwrite_hw_inflate(src, len, szexpected, dev->blksz);
+	gz.hw_size = szexpected;
+	if (!gz.hw_out)
+#endif
+	{
+		for (j = 0; j < ARRAY_SIZE(buf); j++) {
+			buf[j].data = malloc_cache_aligned(szwritebuf);
+			if (!buf[j].data) {
+				puts("Error: no memory for gzwrite\n");
+				r = -1;
+				goto out;
+			}
+		}
 
-	s.next_in = src + i;
-	s.avail_in = payload_size+8;
-	writebuf = (unsigned char *)malloc_cache_aligned(szwritebuf);
+#if defined(CONFIG_GZIP_SMP) && !defined(CONFIG_SPL_BUILD)
+		/* inflate() may allocate its window on the secondary CPU */
+		gz.heap.base = malloc(GZIP_SMP_HEAP);
+		if (!gz.heap.base) {
+			puts("Error: no memory for gzwrite\n");
+			r = -1;
+			goto out;
+		}
+		gz.s.zalloc = gzip_smp_alloc;
+		gz.s.zfree = gzip_smp_free;
+		gz.s.opaque = &gz.heap;
+#else
+		gz.s.zalloc = gzalloc;
+		gz.s.zfree = gzfree;
+#endif
 
-	/* decompress until deflate stream ends or end of file */
-	do {
-		if (s.avail_in == 0) {
-			printf("%s: weird termination with result %d\n",
-			       __func__, r);
-			break;
+		r = inflateInit2(&gz.s, -MAX_WBITS);
+		if (r != Z_OK) {
+			printf("Error: inflateInit2() returned %d\n", r);
+			r = -1;
+			goto out;
 		}
 
-		/* run inflate() on input until output buffer not full */
-		do {
-			unsigned long blocks_written;
-			int numfilled;
-			lbaint_t writeblocks;
-
-			s.avail_out = szwritebuf;
-			s.next_out = writebuf;
-			r = inflate(&s, Z_SYNC_FLUSH);
-			if ((r != Z_OK) &&
-			    (r != Z_STREAM_END)) {
-				printf("Error: inflate() returned %d\n", r);
-				goto out;
-			}
-			numfilled = szwritebuf - s.avail_out;
-			crc = crc32(crc, writebuf, numfilled);
-			totalfilled += numfilled;
-			if (numfilled < szwritebuf) {
-				writeblocks = (numfilled+dev->blksz-1)
-						/ dev->blksz;
-				memset(writebuf+numfilled, 0,
-				       dev->blksz-(numfilled%dev->blksz));
+		gz.s.next_in = src + i;
+		gz.s.avail_in = payload_size + 8;
+	}
+
+	/* inflate until the deflate stream ends or the input runs out */
+	b = &buf[0];
+	gzwrite_inflate(b);
+	for (;;) {
+		int numfilled;
+		unsigned long blocks_written;
+		lbaint_t writeblocks;
+
+		if ((b->ret != Z_OK) &&
+		    (b->ret != Z_STREAM_END)) {
+			printf("Error: inflate() returned %d\n", b->ret);
+			r = b->ret;
+			goto out;
+		}
+		r = b->ret;
+		numfilled = b->numfilled;
+		totalfilled += numfilled;
+
+		/* Never write past what the caller made room for */
+		if (totalfilled > szexpected) {
+			printf("%s: data exceeds expected size %llu\n",
+			       __func__, szexpected);
+			r = -1;
+			goto out;
+		}
+
+		next = NULL;
+		if (b->ret != Z_STREAM_END) {
+			if (numfilled < szwritebuf && !gz.s.avail_in) {
+				printf("%s: weird termination with result %d\n",
+				       __func__, b->ret);
 			} else {
-				writeblocks = blksperbuf;
+				next = &buf[b == &buf[0]];
+				gzwrite_inflate_start(next);
 			}
+		}
 
-			gzwrite_progress(iteration++,
-					 totalfilled,
-					 szexpected);
-			blocks_written = blk_dwrite(dev, outblock,
-						    writeblocks, writebuf);
-			outblock += blocks_written;
-			if (ctrlc()) {
-				puts("abort\n");
-				goto out;
-			}
-			WATCHDOG_RESET();
-		} while (s.avail_out == 0);
-		/* done when inflate() says it's done */
-	} while (r != Z_STREAM_END);
+		if (numfilled < szwritebuf) {
+			writeblocks = (numfilled+dev->blksz-1)
+					/ dev->blksz;
+			memset(b->out+numfilled, 0,
+			       dev->blksz-(numfilled%dev->blksz));
+		} else {
+			writeblocks = blksperbuf;
+		}
+
+		gzwrite_progress(iteration++,
+				 totalfilled,
+				 szexpected);
+		blocks_written = blk_dwrite(dev, outblock,
+					    writeblocks, b->out);
+		outblock += blocks_written;
+		if (ctrlc()) {
+			puts("abort\n");
+			goto out;
+		}
+		WATCHDOG_RESET();
+
+		if (!next)
+			break;
+		gzwrite_inflate_wait(next);
+		b = next;
+	}
 
 	if ((szexpected != totalfilled) ||
-	    (crc != expected_crc))
+	    (gz.crc != expected_crc))
 		r = -1;
 	else
 		r = 0;
 
 out:
+	for (j = 0; j < ARRAY_SIZE(buf); j++)
+		gzwrite_inflate_wait(&buf[j]);
 	gzwrite_progress_finish(r, totalfilled, szexpected,
-				expected_crc, crc);
-	free(writebuf);
-	inflateEnd(&s);
+				expected_crc, gz.crc);
+	for (j = 0; j < ARRAY_SIZE(buf); j++)
+		free(buf[j].data);
+	inflateEnd(&gz.s);
+#if defined(CONFIG_MISC_DECOMPRESS) && !defined(CONFIG_SPL_BUILD)
+	free(gz.hw_out);
+#endif
+#if defined(CONFIG_GZIP_SMP) && !defined(CONFIG_SPL_BUILD)
+	free(gz.heap.base);
+#endif
 
 	return r;
 }
@@ -66,6 +66,24 @@ typedef struct _ENTRY {
 static void _hdelete(const char *key, struct hsearch_data *htab, ENTRY *ep,
 	int idx);
 
+/* Keys and values inside the import buffer are not allocated on their own */
+static inline int _hin_import(struct hsearch_data *htab, const char *s)
+{
+	return htab->import_buf && s >= htab->import_buf &&
+	       s < htab->import_buf + htab->import_size;
+}
+
+static inline char *_hstrdup(struct hsearch_data *htab, const char *s)
+{
+	return _hin_import(htab, s) ? (char *)s : strdup(s);
+}
+
+static inline void _hfree(struct hsearch_data *htab, const char *s)
+{
+	if (!_hin_import(htab, s))
+		free((void *)s);
+}
+
 /*
  * hcreate()
  */
@@ -151,11 +169,14 @@ void hdestroy_r(struct hsearch_data *htab)
 		if (htab->table[i].used > 0) {
 			ENTRY *ep = &htab->table[i].entry;
 
-			free((void *)ep->key);
-			free(ep->data);
+			_hfree(htab, ep->key);
+			_hfree(htab, ep->data);
 		}
 	}
 	free(htab->table);
+	free(htab->import_buf);
+	htab->import_buf = NULL;
+	htab->import_size = 0;
 
 	/* the sign for an existing table is an value != NULL in htable */
 	htab->table = NULL;
@@ -252,8 +273,8 @@ static inline int _compare_and_overwrite_entry(ENTRY item, ACTION action,
 				return 0;
 			}
 
-			free(htab->table[idx].entry.data);
-			htab->table[idx].entry.data = strdup(item.data);
+			_hfree(htab, htab->table[idx].entry.data);
+			htab->table[idx].entry.data = _hstrdup(htab, item.data);
 			if (!htab->table[idx].entry.data) {
 				__set_errno(ENOMEM);
 				*retval = NULL;
@@ -365,8 +386,8 @@ int hsearch_r(ENTRY item, ACTION action, ENTRY ** retval,
 			idx = first_deleted;
 
 		htab->table[idx].used = hval;
-		htab->table[idx].entry.key = strdup(item.key);
-		htab->table[idx].entry.data = strdup(item.data);
+		htab->table[idx].entry.key = _hstrdup(htab, item.key);
+		htab->table[idx].entry.data = _hstrdup(htab, item.data);
 		if (!htab->table[idx].entry.key ||
 		    !htab->table[idx].entry.data) {
 			__set_errno(ENOMEM);
@@ -430,8 +451,8 @@ static void _hdelete(const char *key, struct hsearch_data *htab, ENTRY *ep,
 {
 	/* free used ENTRY */
 	debug("hdelete: DELETING key \"%s\"\n", key);
-	free((void *)ep->key);
-	free(ep->data);
+	_hfree(htab, ep->key);
+	_hfree(htab, ep->data);
 	ep->callback = NULL;
 	ep->flags = 0;
 	htab->table[idx].used = -1;
@@ -787,6 +808,21 @@ int himport_r(struct hsearch_data *htab,
 		return 0;
 	}
 
+	/*
+	 * Only copy up to the end of the data: a binary environment is
+	 * mostly '\0' padding behind the terminating empty string.
+	 */
+	if (sep == '\0') {
+		size_t end = 0;
+
+		while (end < size && env[end])
+			end += strnlen(env + end, size - end) + 1;
+		if (end < size)
+			size = end;
+	} else {
+		size = strnlen(env, size);
+	}
+
 	/* we allocate new space to make sure we can write to the array */
 	if ((data = malloc(size + 1)) == NULL) {
 		debug("himport_r: can't malloc %lu bytes\n", (ulong)size + 1);
@@ -845,6 +881,13 @@ int himport_r(struct hsearch_data *htab,
 		free(data);
 		return 1;		/* everything OK */
 	}
+
+	/* A fresh table keeps the data, its entries point into it */
+	if ((flag & H_NOCLEAR) == 0) {
+		htab->import_buf = data;
+		htab->import_size = size + 1;
+	}
+
 	if(crlf_is_lf) {
 		/* Remove Carriage Returns in front of Line Feeds */
 		unsigned ignored_crs = 0;
@@ -908,7 +951,8 @@ int himport_r(struct hsearch_data *htab,
 		if (*name == 0) {
 			debug("INSERT: unable to use an empty key\n");
 			__set_errno(EINVAL);
-			free(data);
+			if (data != htab->import_buf)
+				free(data);
 			return 0;
 		}
 
@@ -930,8 +974,10 @@ int himport_r(struct hsearch_data *htab,
 			rv, name, value);
 	} while ((dp < data + size) && *dp);	/* size check needed for text */
 						/* without '\0' termination */
-	debug("INSERT: free(data = %p)\n", data);
-	free(data);
+	if (data != htab->import_buf) {
+		debug("INSERT: free(data = %p)\n", data);
+		free(data);
+	}
 
 	/*
 	 * CONFIG_ENVF=y: don't delete the default variables when they are
@@ -0,0 +1,256 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd
+ *
+ * Lookup caches for fdt_node_offset_by_phandle() and fdt_path_offset(),
+ * which otherwise walk the blob from its start on every call.
+ *
+ * A cached phandle is checked before it is used: it must still be on the
+ * node it maps to. The paths of a blob are dropped by each libfdt function
+ * which modifies it, see the wrappers of fdt_rw.c, fdt_wip.c and fdt_sw.c.
+ * A blob changed by other means, e.g. copied over with memcpy(), is caught
+ * only if the sizes of its blocks or the name of the node changed.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <linux/libfdt.h>
+#include "libfdt_internal.h"
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define FDT_CACHE_BLOBS		2
+#define FDT_CACHE_PATHS		64	/* power of 2 */
+#define FDT_CACHE_PATH_LEN	64
+
+/* phandle -> offset for one blob, dtc numbers phandles from 1 */
+struct fdt_phandle_cache {
+	const void *fdt;
+	uint32_t size_struct;	/* when built */
+	uint32_t max;
+	int *offsets;
+	ulong stamp;
+};
+
+struct fdt_path_cache {
+	const void *fdt;
+	uint32_t size_struct;
+	uint32_t size_strings;
+	int offset;
+	int len;
+	char path[FDT_CACHE_PATH_LEN];
+};
+
+static struct fdt_phandle_cache phandle_caches[FDT_CACHE_BLOBS];
+static struct fdt_path_cache path_caches[FDT_CACHE_PATHS];
+static ulong phandle_stamp;
+
+static bool fdt_cache_on(void)
+{
+	const ulong flags = GD_FLG_RELOC | GD_FLG_FULL_MALLOC_INIT;
+
+	/* bss is not usable before relocation */
+	return (gd->flags & flags) == flags;
+}
+
+static int fdt_phandle_cache_build(struct fdt_phandle_cache *c,
+				   const void *fdt)
+{
+	uint32_t phandle, max = 0;
+	int offset, count = 0;
+
+	/* Even if nothing can be cached, so as not to retry on every call */
+	free(c->offsets);
+	c->fdt = fdt;
+	c->size_struct = fdt_size_dt_struct(fdt);
+	c->max = 0;
+	c->offsets = NULL;
+
+	for (offset = fdt_next_node(fdt, -1, NULL); offset >= 0;
+	     offset = fdt_next_node(fdt, offset, NULL)) {
+		phandle = fdt_get_phandle(fdt, offset);
+		if (phandle && phandle != -1) {
+			count++;
+			max = max(max, phandle);
+		}
+	}
+
+	/* Sparse phandles, e.g. from overlays, are left to the scan */
+	if (!count || max > 4 * count + 64)
+		return -FDT_ERR_NOTFOUND;
+
+	c->offsets = malloc((max + 1) * sizeof(*c->offsets));
+	if (!c->offsets)
+		return -FDT_ERR_NOSPACE;
+	memset(c->offsets, 0xff, (max + 1) * sizeof(*c->offsets));
+
+	for (offset = fdt_next_node(fdt, -1, NULL); offset >= 0;
+	     offset = fdt_next_node(fdt, offset, NULL)) {
+		phandle = fdt_get_phandle(fdt, offset);
+		/* The first node wins, as in the scan */
+		if (phandle && phandle <= max && c->offsets[phandle] < 0)
+			c->offsets[phandle] = offset;
+	}
+	c->max = max;
+
+	return 0;
+}
+
+static struct fdt_phandle_cache *fdt_phandle_cache_get(const void *fdt)
+{
+	struct fdt_phandle_cache *c, *lru = &phandle_caches[0];
+	int i;
+
+	for (i = 0; i < FDT_CACHE_BLOBS; i++) {
+		c = &phandle_caches[i];
+		if (c->fdt == fdt) {
+			c->stamp = ++phandle_stamp;
+			return c;
+		}
+		if (c->stamp < lru->stamp)
+			lru = c;
+	}
+
+	lru->stamp = ++phandle_stamp;
+	fdt_phandle_cache_build(lru, fdt);
+
+	return lru;
+}
+
+static int fdt_phandle_cache_find(struct fdt_phandle_cache *c,
+				  const void *fdt, uint32_t phandle)
+{
+	int offset;
+
+	if (phandle > c->max)
+		return -FDT_ERR_NOTFOUND;
+
+	offset = c->offsets[phandle];
+	if (offset >= 0 && fdt_get_phandle(fdt, offset) == phandle)
+		return offset;
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+int fdt_cache_phandle(const void *fdt, uint32_t phandle)
+{
+	struct fdt_phandle_cache *c;
+	int offset;
+
+	if (!fdt_cache_on())
+		return -FDT_ERR_NOTFOUND;
+
+	c = fdt_phandle_cache_get(fdt);
+	offset = fdt_phandle_cache_find(c, fdt, phandle);
+	if (offset >= 0)
+		return offset;
+
+	/* Nodes moved since the cache was built, rebuild it once */
+	if (c->size_struct != fdt_size_dt_struct(fdt) &&
+	    !fdt_phandle_cache_build(c, fdt))
+		return fdt_phandle_cache_find(c, fdt, phandle);
+
+	return -FDT_ERR_NOTFOUND;
+}
+
+void fdt_cache_phandle_put(const void *fdt, uint32_t phandle, int offset)
+{
+	int i;
+
+	if (!fdt_cache_on())
+		return;
+
+	/* A phandle set in place, after the cache was built */
+	for (i = 0; i < FDT_CACHE_BLOBS; i++) {
+		if (phandle_caches[i].fdt == fdt &&
+		    phandle <= phandle_caches[i].max)
+			phandle_caches[i].offsets[phandle] = offset;
+	}
+}
+
+static uint fdt_path_hash(const void *fdt, const char *path, int len)
+{
+	uint hash = (ulong)fdt >> 3;
+
+	while (len--)
+		hash = hash * 33 + *path++;
+
+	return hash & (FDT_CACHE_PATHS - 1);
+}
+
+static bool fdt_path_cacheable(const char *path, int len)
+{
+	/* Aliases may be repointed in place, so only absolute paths */
+	return len < FDT_CACHE_PATH_LEN && *path == '/' &&
+	       !memchr(path, ':', len);
+}
+
+/* Is the node at @offset still the one which @path ends with */
+static bool fdt_path_names_node(const void *fdt, int offset,
+				const char *path, int len)
+{
+	const char *comp = path + len, *name;
+	int clen, nlen;
+
+	while (comp > path && comp[-1] != '/')
+		comp--;
+	clen = path + len - comp;
+
+	name = fdt_get_name(fdt, offset, &nlen);
+	if (!name || nlen < clen || memcmp(name, comp, clen))
+		return false;
+
+	return nlen == clen ||
+	       (name[clen] == '@' && !memchr(comp, '@', clen));
+}
+
+int fdt_cache_path(const void *fdt, const char *path, int len)
+{
+	struct fdt_path_cache *c;
+
+	if (!fdt_cache_on() || !fdt_path_cacheable(path, len))
+		return -FDT_ERR_NOTFOUND;
+
+	c = &path_caches[fdt_path_hash(fdt, path, len)];
+	if (c->fdt != fdt || c->len != len || memcmp(c->path, path, len))
+		return -FDT_ERR_NOTFOUND;
+
+	if (c->size_struct != fdt_size_dt_struct(fdt) ||
+	    c->size_strings != fdt_size_dt_strings(fdt) ||
+	    !fdt_path_names_node(fdt, c->offset, path, len)) {
+		c->fdt = NULL;
+		return -FDT_ERR_NOTFOUND;
+	}
+
+	return c->offset;
+}
+
+void fdt_cache_invalidate(const void *fdt)
+{
+	int i;
+
+	if (!fdt_cache_on())
+		return;
+
+	for (i = 0; i < FDT_CACHE_PATHS; i++) {
+		if (path_caches[i].fdt == fdt)
+			path_caches[i].fdt = NULL;
+	}
+}
+
+void fdt_cache_path_put(const void *fdt, const char *path, int len,
+			int offset)
+{
+	struct fdt_path_cache *c;
+
+	if (!fdt_cache_on() || !fdt_path_cacheable(path, len))
+		return;
+
+	c = &path_caches[fdt_path_hash(fdt, path, len)];
+	c->fdt = fdt;
+	c->size_struct = fdt_size_dt_struct(fdt);
+	c->size_strings = fdt_size_dt_strings(fdt);
+	c->offset = offset;
+	c->len = len;
+	memcpy(c->path, path, len);
+}
@@ -1,2 +1,352 @@
 #include <linux/libfdt_env.h>
 #include "../../scripts/dtc/libfdt/fdt_overlay.c"
+
+#include <common.h>
+#include <malloc.h>
+
+/*
+ * Applying several overlays with fdt_overlay_apply() walks the base tree
+ * for its highest phandle, searches __symbols__ for each label the overlay
+ * refers to, and scans every node for the target phandle of each fragment.
+ * fdt_overlay_apply_multi() does the same as that over all the overlays,
+ * but with the highest phandle carried from one overlay to the next, and
+ * each label resolved once to the path and phandle of its node, so that
+ * fragments targeted by label are looked up by path.
+ */
+
+/* A label of the base tree, as resolved from __symbols__ */
+struct overlay_symbol {
+	char *label;
+	char *path;
+	uint32_t phandle;
+};
+
+struct overlay_symbols {
+	struct overlay_symbol *syms;
+	int count;
+	int max;
+};
+
+/* A fragment whose "target" was fixed up to a label */
+struct overlay_target {
+	int fragment;
+	int sym;
+};
+
+#define OVERLAY_TARGETS_MAX	64
+
+static int overlay_symbol_get(void *fdt, struct overlay_symbols *s,
+			      const char *label)
+{
+	struct overlay_symbol *sym;
+	const char *path;
+	uint32_t phandle;
+	int symbols_off, node, len, i;
+
+	for (i = 0; i < s->count; i++) {
+		if (!strcmp(s->syms[i].label, label))
+			return i;
+	}
+
+	symbols_off = fdt_path_offset(fdt, "/__symbols__");
+	if (symbols_off < 0)
+		return symbols_off;
+
+	path = fdt_getprop(fdt, symbols_off, label, &len);
+	if (!path)
+		return len;
+
+	node = fdt_path_offset(fdt, path);
+	if (node < 0)
+		return node;
+
+	phandle = fdt_get_phandle(fdt, node);
+	if (!phandle)
+		return -FDT_ERR_NOTFOUND;
+
+	if (s->count == s->max) {
+		sym = realloc(s->syms, (s->max + 16) * sizeof(*sym));
+		if (!sym)
+			return -FDT_ERR_NOSPACE;
+		s->syms = sym;
+		s->max += 16;
+	}
+
+	sym = &s->syms[s->count];
+	sym->label = strdup(label);
+	sym->path = strdup(path);
+	if (!sym->label || !sym->path) {
+		free(sym->label);
+		free(sym->path);
+		return -FDT_ERR_NOSPACE;
+	}
+	sym->phandle = phandle;
+
+	return s->count++;
+}
+
+/* Forget the labels an overlay (re)defines, they point elsewhere now */
+static void overlay_symbols_drop(struct overlay_symbols *s, const void *fdto)
+{
+	const char *label;
+	int symbols_off, property, i;
+
+	symbols_off = fdt_subnode_offset(fdto, 0, "__symbols__");
+	if (symbols_off < 0)
+		return;
+
+	fdt_for_each_property_offset(property, fdto, symbols_off) {
+		if (!fdt_getprop_by_offset(fdto, property, &label, NULL))
+			continue;
+
+		for (i = 0; i < s->count; i++) {
+			if (strcmp(s->syms[i].label, label))
+				continue;
+			free(s->syms[i].label);
+			free(s->syms[i].path);
+			s->syms[i] = s->syms[--s->count];
+			break;
+		}
+	}
+}
+
+static void overlay_symbols_free(struct overlay_symbols *s)
+{
+	int i;
+
+	for (i = 0; i < s->count; i++) {
+		free(s->syms[i].label);
+		free(s->syms[i].path);
+	}
+	free(s->syms);
+}
+
+/* overlay_fixup_phandle(), with the label resolved through @s */
+static int overlay_fixup_phandle_multi(void *fdt, void *fdto,
+				       struct overlay_symbols *s, int property,
+				       struct overlay_target *targets,
+				       int *ntargets)
+{
+	const char *value;
+	const char *label;
+	int len, sym;
+
+	value = fdt_getprop_by_offset(fdto, property, &label, &len);
+	if (!value) {
+		if (len == -FDT_ERR_NOTFOUND)
+			return -FDT_ERR_INTERNAL;
+
+		return len;
+	}
+
+	sym = overlay_symbol_get(fdt, s, label);
+	if (sym < 0)
+		return sym;
+
+	do {
+		const char *path, *name, *fixup_end;
+		const char *fixup_str = value;
+		uint32_t path_len, name_len;
+		uint32_t fixup_len;
+		fdt32_t phandle_prop;
+		char *sep, *endptr;
+		int poffset, fixup_off, ret;
+
+		fixup_end = memchr(value, '\0', len);
+		if (!fixup_end)
+			return -FDT_ERR_BADOVERLAY;
+		fixup_len = fixup_end - fixup_str;
+
+		len -= fixup_len + 1;
+		value += fixup_len + 1;
+
+		path = fixup_str;
+		sep = memchr(fixup_str, ':', fixup_len);
+		if (!sep || *sep != ':')
+			return -FDT_ERR_BADOVERLAY;
+
+		path_len = sep - path;
+		if (path_len == (fixup_len - 1))
+			return -FDT_ERR_BADOVERLAY;
+
+		fixup_len -= path_len + 1;
+		name = sep + 1;
+		sep = memchr(name, ':', fixup_len);
+		if (!sep || *sep != ':')
+			return -FDT_ERR_BADOVERLAY;
+
+		name_len = sep - name;
+		if (!name_len)
+			return -FDT_ERR_BADOVERLAY;
+
+		poffset = strtoul(sep + 1, &endptr, 10);
+		if ((*endptr != '\0') || (endptr <= (sep + 1)))
+			return -FDT_ERR_BADOVERLAY;
+
+		fixup_off = fdt_path_offset_namelen(fdto, path, path_len);
+		if (fixup_off == -FDT_ERR_NOTFOUND)
+			return -FDT_ERR_BADOVERLAY;
+		if (fixup_off < 0)
+			return fixup_off;
+
+		phandle_prop = cpu_to_fdt32(s->syms[sym].phandle);
+		ret = fdt_setprop_inplace_namelen_partial(fdto, fixup_off,
+							  name, name_len,
+							  poffset,
+							  &phandle_prop,
+							  sizeof(phandle_prop));
+		if (ret)
+			return ret;
+
+		/* The "target" of a fragment, a top level node */
+		if (name_len == 6 && !memcmp(name, "target", 6) && !poffset &&
+		    path_len > 1 && !memchr(path + 1, '/', path_len - 1) &&
+		    *ntargets < OVERLAY_TARGETS_MAX) {
+			targets[*ntargets].fragment = fixup_off;
+			targets[*ntargets].sym = sym;
+			(*ntargets)++;
+		}
+	} while (len > 0);
+
+	return 0;
+}
+
+static int overlay_fixup_phandles_multi(void *fdt, void *fdto,
+					struct overlay_symbols *s,
+					struct overlay_target *targets,
+					int *ntargets)
+{
+	int fixups_off, property, ret;
+
+	*ntargets = 0;
+
+	/* We can have overlays without any fixups */
+	fixups_off = fdt_path_offset(fdto, "/__fixups__");
+	if (fixups_off == -FDT_ERR_NOTFOUND)
+		return 0;
+	if (fixups_off < 0)
+		return fixups_off;
+
+	fdt_for_each_property_offset(property, fdto, fixups_off) {
+		ret = overlay_fixup_phandle_multi(fdt, fdto, s, property,
+						  targets, ntargets);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/* overlay_merge(), finding fragments targeted by label by their path */
+static int overlay_merge_multi(void *fdt, void *fdto,
+			       struct overlay_symbols *s,
+			       struct overlay_target *targets, int ntargets)
+{
+	struct overlay_symbol *sym;
+	int fragment;
+
+	fdt_for_each_subnode(fragment, fdto, 0) {
+		int overlay;
+		int target;
+		int ret, i;
+
+		overlay = fdt_subnode_offset(fdto, fragment, "__overlay__");
+		if (overlay == -FDT_ERR_NOTFOUND)
+			continue;
+
+		if (overlay < 0)
+			return overlay;
+
+		target = -FDT_ERR_NOTFOUND;
+		for (i = 0; i < ntargets; i++) {
+			if (targets[i].fragment != fragment)
+				continue;
+			sym = &s->syms[targets[i].sym];
+			target = fdt_path_offset(fdt, sym->path);
+			if (target >= 0 &&
+			    fdt_get_phandle(fdt, target) != sym->phandle)
+				target = -FDT_ERR_NOTFOUND;
+			break;
+		}
+
+		if (target < 0)
+			target = overlay_get_target(fdt, fdto, fragment, NULL);
+		if (target < 0)
+			return target;
+
+		ret = overlay_apply_node(fdt, target, fdto, overlay);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+int fdt_overlay_apply_multi(void *fdt, void * const fdtos[], int count)
+{
+	struct overlay_target targets[OVERLAY_TARGETS_MAX];
+	struct overlay_symbols s = { NULL };
+	uint32_t delta, fdto_max;
+	void *fdto = NULL;
+	int ntargets;
+	int i, ret;
+
+	FDT_CHECK_HEADER(fdt);
+	for (i = 0; i < count; i++)
+		FDT_CHECK_HEADER(fdtos[i]);
+
+	delta = fdt_get_max_phandle(fdt);
+	if (delta == (uint32_t)-1)
+		return -FDT_ERR_BADSTRUCTURE;
+
+	for (i = 0; i < count; i++) {
+		fdto = fdtos[i];
+
+		ret = overlay_adjust_local_phandles(fdto, delta);
+		if (ret)
+			goto err;
+
+		ret = overlay_update_local_references(fdto, delta);
+		if (ret)
+			goto err;
+
+		ret = overlay_fixup_phandles_multi(fdt, fdto, &s, targets,
+						   &ntargets);
+		if (ret)
+			goto err;
+
+		ret = overlay_merge_multi(fdt, fdto, &s, targets, ntargets);
+		if (ret)
+			goto err;
+
+		ret = overlay_symbol_update(fdt, fdto);
+		if (ret)
+			goto err;
+
+		/* The base now has the overlay's phandles, above delta */
+		fdto_max = fdt_get_max_phandle(fdto);
+		if (fdto_max == (uint32_t)-1) {
+			ret = -FDT_ERR_BADSTRUCTURE;
+			goto err;
+		}
+		delta = max(delta, fdto_max);
+
+		overlay_symbols_drop(&s, fdto);
+
+		/* The overlay has been damaged, erase its magic */
+		fdt_set_magic(fdto, ~0);
+	}
+
+	overlay_symbols_free(&s);
+
+	return 0;
+
+err:
+	overlay_symbols_free(&s);
+
+	/* The overlay and the base tree might have been damaged */
+	fdt_set_magic(fdto, ~0);
+	fdt_set_magic(fdt, ~0);
+
+	return ret;
+}
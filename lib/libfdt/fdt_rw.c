@@ -1,2 +1,30 @@
 #include <linux/libfdt_env.h>
+#include <linux/libfdt.h>
+#include "libfdt_internal.h"
+
+#ifdef FDT_USE_CACHE
+/* Every change to a blob starts with this, see fdt_cache_invalidate() */
+#undef FDT_CHECK_HEADER
+#define FDT_CHECK_HEADER(fdt) \
+	{ \
+		int __err; \
+		fdt_cache_invalidate(fdt); \
+		if ((__err = fdt_check_header(fdt)) != 0) \
+			return __err; \
+	}
+
+/* And this one writes to another blob */
+#define fdt_open_into fdt_open_into_
+#endif
+
 #include "../../scripts/dtc/libfdt/fdt_rw.c"
+
+#ifdef FDT_USE_CACHE
+#undef fdt_open_into
+int fdt_open_into(const void *fdt, void *buf, int bufsize)
+{
+	fdt_cache_invalidate(buf);
+
+	return fdt_open_into_(fdt, buf, bufsize);
+}
+#endif
@@ -1,2 +1,20 @@
 #include <linux/libfdt_env.h>
+#include <linux/libfdt.h>
+#include "libfdt_internal.h"
+
+#ifdef FDT_USE_CACHE
+/* Makes a new blob, see fdt_cache_invalidate() */
+#define fdt_finish fdt_finish_
+#endif
+
 #include "../../scripts/dtc/libfdt/fdt_sw.c"
+
+#ifdef FDT_USE_CACHE
+#undef fdt_finish
+int fdt_finish(void *fdt)
+{
+	fdt_cache_invalidate(fdt);
+
+	return fdt_finish_(fdt);
+}
+#endif
@@ -1,2 +1,20 @@
 #include <linux/libfdt_env.h>
+#include <linux/libfdt.h>
+#include "libfdt_internal.h"
+
+#ifdef FDT_USE_CACHE
+/* Removes a node in place, see fdt_cache_invalidate() */
+#define fdt_nop_node fdt_nop_node_
+#endif
+
 #include "../../scripts/dtc/libfdt/fdt_wip.c"
+
+#ifdef FDT_USE_CACHE
+#undef fdt_nop_node
+int fdt_nop_node(void *fdt, int nodeoffset)
+{
+	fdt_cache_invalidate(fdt);
+
+	return fdt_nop_node_(fdt, nodeoffset);
+}
+#endif
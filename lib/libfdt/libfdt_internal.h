@@ -1 +1,25 @@
 #include "../../scripts/dtc/libfdt/libfdt_internal.h"
+
+/* U-Boot local hacks */
+
+#if !defined(USE_HOSTCC) && defined(CONFIG_FDT_CACHE) && \
+	!defined(CONFIG_SPL_BUILD)
+#define FDT_USE_CACHE
+
+/*
+ * Lookup caches in fdt_cache.c. The lookups return -FDT_ERR_NOTFOUND if
+ * the answer is not cached, the caller then scans the blob and puts what
+ * it found.
+ */
+int fdt_cache_phandle(const void *fdt, uint32_t phandle);
+void fdt_cache_phandle_put(const void *fdt, uint32_t phandle, int offset);
+int fdt_cache_path(const void *fdt, const char *path, int len);
+void fdt_cache_path_put(const void *fdt, const char *path, int len,
+			int offset);
+
+/*
+ * Forget the paths cached for @fdt, called by every libfdt function which
+ * changes a blob or writes a new one
+ */
+void fdt_cache_invalidate(const void *fdt);
+#endif
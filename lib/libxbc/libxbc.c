@@ -116,3 +116,100 @@ int32_t addBootConfigTrailer(uint64_t bootconfig_start_addr,
 
     return BOOTCONFIG_TRAILER_SIZE;
 }
+
+/*
+ * Start building on a boot config section, dropping its trailer if present.
+ */
+int32_t bootConfigBuilderInit(struct BootConfigBuilder* builder,
+                              uint64_t bootconfig_start_addr,
+                              uint32_t bootconfig_size, uint32_t max_size) {
+    if (!builder || !bootconfig_start_addr ||
+        bootconfig_size > max_size) {
+        return -1;
+    }
+
+    builder->start = (char*)bootconfig_start_addr;
+    builder->size = bootconfig_size;
+    builder->max_size = max_size;
+    if (bootconfig_size >= BOOTCONFIG_TRAILER_SIZE &&
+        isTrailerPresent(bootconfig_start_addr + bootconfig_size)) {
+        builder->size -= BOOTCONFIG_TRAILER_SIZE;
+    }
+
+    return 0;
+}
+
+/*
+ * Append one parameter and its new line.
+ */
+int32_t bootConfigBuilderAdd(struct BootConfigBuilder* builder,
+                             const char* param, uint32_t param_size) {
+    if (!builder || !param) {
+        return -1;
+    }
+    if (param_size == 0) {
+        return 0;
+    }
+    // keep room for the trailer
+    if (builder->size + param_size + 1 + BOOTCONFIG_TRAILER_SIZE >
+        builder->max_size) {
+        return -1;
+    }
+
+    memcpy(builder->start + builder->size, param, param_size);
+    builder->size += param_size;
+    builder->start[builder->size++] = '\n';
+
+    return 0;
+}
+
+/*
+ * Append each space separated word of a command line as a parameter.
+ */
+int32_t bootConfigBuilderAddCmdline(struct BootConfigBuilder* builder,
+                                    const char* cmdline) {
+    const char* end;
+
+    if (!cmdline) {
+        return -1;
+    }
+
+    while (*cmdline) {
+        if (*cmdline == ' ') {
+            cmdline++;
+            continue;
+        }
+        end = strchr(cmdline, ' ');
+        if (!end) {
+            end = cmdline + strlen(cmdline);
+        }
+        if (bootConfigBuilderAdd(builder, cmdline, end - cmdline) < 0) {
+            return -1;
+        }
+        cmdline = end;
+    }
+
+    return 0;
+}
+
+/*
+ * Write the trailer after the parameters.
+ */
+int32_t bootConfigBuilderFinish(struct BootConfigBuilder* builder) {
+    if (!builder) {
+        return -1;
+    }
+    if (builder->size == 0) {
+        return 0;
+    }
+
+    char* end = builder->start + builder->size;
+    uint32_t sum = checksum((unsigned char*)builder->start, builder->size);
+
+    memcpy(end, &builder->size, BOOTCONFIG_SIZE_SIZE);
+    memcpy(end + BOOTCONFIG_SIZE_SIZE, &sum, BOOTCONFIG_CHECKSUM_SIZE);
+    memcpy(end + BOOTCONFIG_SIZE_SIZE + BOOTCONFIG_CHECKSUM_SIZE,
+           BOOTCONFIG_MAGIC, BOOTCONFIG_MAGIC_SIZE);
+
+    return builder->size + BOOTCONFIG_TRAILER_SIZE;
+}
@@ -56,4 +56,63 @@ int addBootConfigParameters(char *params, uint32_t params_size,
 int addBootConfigTrailer(uint64_t bootconfig_start_addr,
                          uint32_t bootconfig_size);
 
+/*
+ * A boot config section under construction. Unlike addBootConfigParameters(),
+ * which checksums the whole section again on every call, parameters are only
+ * copied as they are added, and the size and checksum are worked out once by
+ * bootConfigBuilderFinish().
+ */
+struct BootConfigBuilder {
+    char *start;        // start of the boot config section
+    uint32_t size;      // bytes of parameters so far, trailer excluded
+    uint32_t max_size;  // room at start, trailer included
+};
+
+/*
+ * Start building on the boot config section already in memory, e.g. the
+ * vendor bootconfig right after the ramdisks. A trailer at its end is dropped,
+ * to be written again after the new parameters.
+ *
+ * @param builder builder to initialize.
+ * @param bootconfig_start_addr address that the boot config section is starting
+ *        at in memory.
+ * @param bootconfig_size size of the current bootconfig section in bytes.
+ * @param max_size bytes available at bootconfig_start_addr.
+ * @return 0 on success, -1 for error.
+ */
+int bootConfigBuilderInit(struct BootConfigBuilder *builder,
+                          uint64_t bootconfig_start_addr,
+                          uint32_t bootconfig_size, uint32_t max_size);
+
+/*
+ * Add one "key=value" parameter, a new line is appended to it.
+ *
+ * @param builder builder from bootConfigBuilderInit().
+ * @param param parameter, without new line.
+ * @param param_size size of param in bytes.
+ * @return 0 on success, -1 for error or if there is no room left.
+ */
+int bootConfigBuilderAdd(struct BootConfigBuilder *builder,
+                         const char *param, uint32_t param_size);
+
+/*
+ * Add every space separated word of a kernel style command line as a
+ * parameter.
+ *
+ * @param builder builder from bootConfigBuilderInit().
+ * @param cmdline command line, e.g. "androidboot.a=1 androidboot.b=2".
+ * @return 0 on success, -1 for error or if there is no room left.
+ */
+int bootConfigBuilderAddCmdline(struct BootConfigBuilder *builder,
+                                const char *cmdline);
+
+/*
+ * Checksum the parameters and write the trailer after them.
+ *
+ * @param builder builder from bootConfigBuilderInit().
+ * @return size of the whole boot config section, trailer included, in bytes.
+ *         -1 for error.
+ */
+int bootConfigBuilderFinish(struct BootConfigBuilder *builder);
+
 #endif /* LIBXBC_H_ */
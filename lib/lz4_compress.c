@@ -0,0 +1,126 @@
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:	GPL-2.0+
+ *
+ * Greedy LZ4 block compressor. It makes blocks that LZ4_decompress_safe()
+ * and the 'lz4' tool read, for data U-Boot has to store or send rather
+ * than load, e.g. a crash dump. It is built for speed, not ratio: a single
+ * hash table, no chains and no lazy matching.
+ */
+
+#include <common.h>
+#include <linux/kernel.h>
+#include <asm/unaligned.h>
+#include <u-boot/lz4.h>
+
+#define LZ4C_HASH_LOG		12
+#define LZ4C_MIN_MATCH		4
+#define LZ4C_MFLIMIT		12	/* a match can't start after this */
+#define LZ4C_LAST_LITERALS	5	/* the block ends with literals */
+#define LZ4C_MAX_DISTANCE	65535
+#define LZ4C_SKIP_TRIGGER	6	/* step up after 64 misses */
+
+/* Input offsets of the last position with each hash */
+static u32 lz4c_table[1 << LZ4C_HASH_LOG];
+
+static inline u32 lz4c_hash(u32 seq)
+{
+	return (seq * 2654435761U) >> (32 - LZ4C_HASH_LOG);
+}
+
+static u8 *lz4c_put_len(u8 *op, size_t len)
+{
+	for (; len >= 255; len -= 255)
+		*op++ = 255;
+	*op++ = len;
+
+	return op;
+}
+
+/*
+ * Add a sequence: @nlit literals from @lit, then a match of @mlen bytes
+ * @offset back. A @mlen of 0 makes the last sequence, which has no match.
+ */
+static u8 *lz4c_sequence(u8 *op, u8 *oend, const u8 *lit, size_t nlit,
+			 size_t offset, size_t mlen)
+{
+	u8 *token = op++;
+	size_t need = nlit + nlit / 255 + 1;
+
+	if (mlen)
+		need += 2 + (mlen - LZ4C_MIN_MATCH) / 255 + 1;
+	if (need > oend - op)
+		return NULL;
+
+	if (nlit >= 15) {
+		*token = 15 << 4;
+		op = lz4c_put_len(op, nlit - 15);
+	} else {
+		*token = nlit << 4;
+	}
+	memcpy(op, lit, nlit);
+	op += nlit;
+	if (!mlen)
+		return op;
+
+	put_unaligned_le16(offset, op);
+	op += 2;
+	mlen -= LZ4C_MIN_MATCH;
+	if (mlen >= 15) {
+		*token |= 15;
+		op = lz4c_put_len(op, mlen - 15);
+	} else {
+		*token |= mlen;
+	}
+
+	return op;
+}
+
+int LZ4_compress_default(const char *source, char *dest, int srcSize,
+			 int dstCapacity)
+{
+	const u8 *src = (const u8 *)source, *iend = src + srcSize;
+	const u8 *ip = src, *anchor = src;
+	u8 *op = (u8 *)dest, *oend = op + dstCapacity;
+
+	if (srcSize < 0 || dstCapacity <= 0)
+		return 0;
+
+	memset(lz4c_table, 0, sizeof(lz4c_table));
+	while (srcSize > LZ4C_MFLIMIT && ip < iend - LZ4C_MFLIMIT) {
+		u32 seq = get_unaligned((u32 *)ip);
+		u32 h = lz4c_hash(seq);
+		const u8 *ref = src + lz4c_table[h];
+		const u8 *p, *r;
+
+		lz4c_table[h] = ip - src;
+		if (ref >= ip || ip - ref > LZ4C_MAX_DISTANCE ||
+		    get_unaligned((u32 *)ref) != seq) {
+			/* Walk faster through data that doesn't compress */
+			ip += 1 + ((ip - anchor) >> LZ4C_SKIP_TRIGGER);
+			continue;
+		}
+
+		while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+			ip--;
+			ref--;
+		}
+		p = ip + LZ4C_MIN_MATCH;
+		r = ref + LZ4C_MIN_MATCH;
+		while (p < iend - LZ4C_LAST_LITERALS && *p == *r) {
+			p++;
+			r++;
+		}
+
+		op = lz4c_sequence(op, oend, anchor, ip - anchor, ip - ref,
+				   p - ip);
+		if (!op)
+			return 0;
+		ip = anchor = p;
+	}
+
+	op = lz4c_sequence(op, oend, anchor, iend - anchor, 0, 0);
+
+	return op ? op - (u8 *)dest : 0;
+}
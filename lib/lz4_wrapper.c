@@ -10,6 +10,10 @@
 #include <linux/kernel.h>
 #include <linux/types.h>
 #include <asm/unaligned.h>
+#if defined(CONFIG_LZ4_SMP) && !defined(CONFIG_SPL_BUILD)
+#include <malloc.h>
+#include <asm/arch/smp_work.h>
+#endif
 
 static u16 LZ4_readLE16(const void *src)
 {
@@ -35,6 +39,23 @@ typedef uint64_t U64;
 /* Unaltered (except removing unrelated code) from github.com/Cyan4973/lz4. */
 #include "lz4.c"	/* #include for inlining, do not link! */
 
+int LZ4_decompress_safe(const char *src, char *dst, int srcSize,
+			int dstCapacity)
+{
+	return LZ4_decompress_generic(src, dst, srcSize, dstCapacity,
+				      endOnInputSize, full, 0, noDict,
+				      (BYTE *)dst, NULL, 0);
+}
+
+int LZ4_decompress_safe_partial(const char *src, char *dst, int srcSize,
+				int targetOutputSize, int dstCapacity)
+{
+	return LZ4_decompress_generic(src, dst, srcSize, dstCapacity,
+				      endOnInputSize, partial,
+				      targetOutputSize, noDict,
+				      (BYTE *)dst, NULL, 0);
+}
+
 bool lz4_is_valid_header(const unsigned char *h)
 {
 	const struct lz4_frame_header *hdr  = (const struct lz4_frame_header *)h;
@@ -49,6 +70,143 @@ bool lz4_is_valid_header(const unsigned char *h)
 	return true;
 }
 
+#if defined(CONFIG_LZ4_SMP) && !defined(CONFIG_SPL_BUILD)
+struct lz4_smp_block {
+	const void *in;
+	u32 size;
+	bool not_compressed;
+	int ret;
+};
+
+struct lz4_smp {
+	struct lz4_smp_block *blk;
+	int nr_blks;
+	void *dst;
+	size_t block_max;
+};
+
+/*
+ * Runs on every CPU: block i is decoded by CPU (i % nr_cpus) to its own
+ * block_max sized slot of the output, as its decoded size isn't known yet.
+ */
+static void lz4_smp_decode(void *arg, int cpu, int nr_cpus)
+{
+	struct lz4_smp *ctx = arg;
+	struct lz4_smp_block *b;
+	void *out;
+	int i;
+
+	for (i = cpu; i < ctx->nr_blks; i += nr_cpus) {
+		b = &ctx->blk[i];
+		out = ctx->dst + i * ctx->block_max;
+
+		if (b->not_compressed) {
+			memcpy(out, b->in, b->size);
+			b->ret = b->size;
+		} else {
+			/* constant folding essential, do not touch params! */
+			b->ret = LZ4_decompress_generic(b->in, out, b->size,
+					ctx->block_max, endOnInputSize,
+					full, 0, noDict, out, NULL, 0);
+		}
+	}
+}
+
+/*
+ * Return: 0 if OK, -EAGAIN if the frame is better decoded by one CPU, or
+ * other -ve error code as for ulz4fn()
+ */
+static int ulz4fn_smp(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	const struct lz4_frame_header *h = src;
+	const void *in = src;
+	struct lz4_block_header b;
+	struct lz4_smp ctx;
+	void *out;
+	int i, ret;
+
+	/* In-place: block slots could overwrite input not decoded yet */
+	if (dst < src + srcn && src < dst + *dstn)
+		return -EAGAIN;
+
+	if (srcn < sizeof(*h) + sizeof(u64) + sizeof(u8))
+		return -EINVAL;	/* input overrun */
+	if (le32_to_cpu(h->magic) != LZ4F_MAGIC || h->version != 1 ||
+	    !h->independent_blocks || h->max_block_size < 4)
+		return -EAGAIN;	/* let ulz4fn() report it */
+
+	ctx.block_max = 1 << (2 * h->max_block_size + 8);
+	ctx.dst = dst;
+
+	in += sizeof(*h) + sizeof(u8);
+	if (h->has_content_size)
+		in += sizeof(u64);
+
+	/* First pass: count the blocks */
+	ctx.nr_blks = 0;
+	while (1) {
+		if (in - src + sizeof(b) > srcn)
+			return -EINVAL;	/* input overrun */
+		b.raw = get_unaligned_le32(in);
+		in += sizeof(b);
+		if (!b.size)
+			break;
+		if (b.size > ctx.block_max || in - src + b.size > srcn)
+			return -EINVAL;
+		in += b.size;
+		if (h->has_block_checksum)
+			in += sizeof(u32);
+		ctx.nr_blks++;
+	}
+
+	if (ctx.nr_blks < 2)
+		return -EAGAIN;
+	if (ctx.nr_blks * ctx.block_max > *dstn)
+		return -EAGAIN;	/* the last slot may end beyond dst */
+
+	ctx.blk = malloc(ctx.nr_blks * sizeof(*ctx.blk));
+	if (!ctx.blk)
+		return -EAGAIN;
+
+	/* Second pass: record them */
+	in = src + sizeof(*h) + sizeof(u8);
+	if (h->has_content_size)
+		in += sizeof(u64);
+	for (i = 0; i < ctx.nr_blks; i++) {
+		b.raw = get_unaligned_le32(in);
+		in += sizeof(b);
+		ctx.blk[i].in = in;
+		ctx.blk[i].size = b.size;
+		ctx.blk[i].not_compressed = b.not_compressed;
+		in += b.size;
+		if (h->has_block_checksum)
+			in += sizeof(u32);
+	}
+
+	ret = smp_work_run(lz4_smp_decode, &ctx);
+	if (ret < 0)
+		goto out;
+
+	/* Close the gaps left by blocks shorter than block_max */
+	out = dst;
+	for (i = 0; i < ctx.nr_blks; i++) {
+		if (ctx.blk[i].ret < 0) {
+			ret = -EPROTO;	/* decompression error */
+			goto out;
+		}
+		if (out != dst + i * ctx.block_max)
+			memmove(out, dst + i * ctx.block_max, ctx.blk[i].ret);
+		out += ctx.blk[i].ret;
+	}
+
+	*dstn = out - dst;
+	ret = 0;
+out:
+	free(ctx.blk);
+	return ret;
+}
+#endif
+
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 {
 	const void *end = dst + *dstn;
@@ -70,6 +228,16 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 		printf("hw ulz4fn failed(%d), fallback to soft ulz4fn\n", ret);
 	}
 
+#endif
+#if defined(CONFIG_LZ4_SMP) && !defined(CONFIG_SPL_BUILD)
+	*dstn = end - dst;
+	ret = ulz4fn_smp(src, srcn, dst, dstn);
+	if (ret != -EAGAIN) {
+		if (ret)
+			*dstn = 0;
+		return ret;
+	}
+	*dstn = 0;
 #endif
 	{ /* With in-place decompression the header may become invalid later. */
 		const struct lz4_frame_header *h = in;
@@ -136,3 +304,85 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 	*dstn = out - dst;
 	return ret;
 }
+
+void ulz4f_stream_init(struct ulz4f_stream *s, void *dst, size_t dstn)
+{
+	memset(s, 0, sizeof(*s));
+	s->out = dst;
+	s->end = dst + dstn;
+}
+
+int ulz4f_stream_decode(struct ulz4f_stream *s, const void *src, size_t srcn)
+{
+	const void *in = src;
+	size_t hsize;
+	int ret;
+
+	if (!s->header_done) {
+		const struct lz4_frame_header *h = in;
+
+		if (srcn < sizeof(*h))
+			return 0;
+
+		if (le32_to_cpu(h->magic) != LZ4F_MAGIC || h->version != 1)
+			return -EPROTONOSUPPORT;	/* unknown format */
+		if (h->reserved0 || h->reserved1 || h->reserved2)
+			return -EINVAL;	/* reserved must be zero */
+		if (!h->independent_blocks)
+			return -EPROTONOSUPPORT; /* we can't support this yet */
+
+		hsize = sizeof(*h) + sizeof(u8);
+		if (h->has_content_size)
+			hsize += sizeof(u64);
+		if (srcn < hsize)
+			return 0;
+
+		/* 64KiB, 256KiB, 1MiB or 4MiB */
+		s->block_max = 1 << (2 * h->max_block_size + 8);
+		s->has_block_checksum = h->has_block_checksum;
+		s->header_done = true;
+		in += hsize;
+	}
+
+	while (!s->done) {
+		struct lz4_block_header b;
+		size_t bsize;
+
+		if (src + srcn - in < sizeof(b))
+			break;
+
+		b.raw = get_unaligned_le32(in);
+		if (!b.size) {
+			in += sizeof(b);
+			s->done = true;
+			break;
+		}
+		if (b.size > s->block_max)
+			return -EINVAL;
+
+		bsize = sizeof(b) + b.size;
+		if (s->has_block_checksum)
+			bsize += sizeof(u32);
+		if (src + srcn - in < bsize)
+			break;	/* wait for the rest of the block */
+
+		if (b.not_compressed) {
+			if (b.size > s->end - s->out)
+				return -ENOBUFS;	/* output overrun */
+			memcpy(s->out, in + sizeof(b), b.size);
+			s->out += b.size;
+		} else {
+			/* constant folding essential, do not touch params! */
+			ret = LZ4_decompress_generic(in + sizeof(b), s->out,
+					b.size, s->end - s->out, endOnInputSize,
+					full, 0, noDict, s->out, NULL, 0);
+			if (ret < 0)
+				return -EPROTO;	/* decompression error */
+			s->out += ret;
+		}
+
+		in += bsize;
+	}
+
+	return in - src;
+}
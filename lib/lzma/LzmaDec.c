@@ -27,7 +27,27 @@
   { UPDATE_1(p); i = (i + i) + 1; A1; }
 #define GET_BIT(p, i) GET_BIT2(p, i, ; , ;)
 
+#ifdef _LZMA_DEC_SPEED
+/*
+ * The bits of literals and bit trees are close to random, so a branch on
+ * each of them is mispredicted about half of the time. Decode them with
+ * a mask instead: m is all ones for a 1 bit and zero for a 0 bit, and
+ * the compiler turns the selects into conditional instructions. The
+ * probability update is UPDATE_0 or UPDATE_1, as
+ * ttt - ((ttt - kBitModelTotal + 31) >> 5) equals
+ * ttt + ((kBitModelTotal - ttt) >> 5) with an arithmetic shift.
+ */
+#define GET_BIT_MASK(p, i, m) \
+  { ttt = *(p); NORMALIZE; bound = (range >> kNumBitModelTotalBits) * ttt; \
+  m = 0 - (UInt32)(code >= bound); \
+  range = (bound & ~m) | ((range - bound) & m); \
+  code -= bound & m; \
+  *(p) = (CLzmaProb)(ttt - ((Int32)(ttt + (~m & (UInt32)(31 - kBitModelTotal))) >> kNumMoveBits)); \
+  i = (i + i) + (m & 1); }
+#define TREE_GET_BIT(probs, i) { UInt32 m_; GET_BIT_MASK((probs + i), i, m_); }
+#else
 #define TREE_GET_BIT(probs, i) { GET_BIT((probs + i), i); }
+#endif
 #define TREE_DECODE(probs, limit, i) \
   { i = 1; do { TREE_GET_BIT(probs, i); } while (i < limit); i -= limit; }
 
@@ -179,7 +199,19 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
 
         WATCHDOG_RESET();
 
+#ifdef _LZMA_DEC_SPEED
+        /* Always 8 bits: unrolled, without the loop branch */
+        TREE_GET_BIT(prob, symbol);
+        TREE_GET_BIT(prob, symbol);
+        TREE_GET_BIT(prob, symbol);
+        TREE_GET_BIT(prob, symbol);
+        TREE_GET_BIT(prob, symbol);
+        TREE_GET_BIT(prob, symbol);
+        TREE_GET_BIT(prob, symbol);
+        TREE_GET_BIT(prob, symbol);
+#else
         do { GET_BIT(prob + symbol, symbol) } while (symbol < 0x100);
+#endif
       }
       else
       {
@@ -197,7 +229,16 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
           matchByte <<= 1;
           bit = (matchByte & offs);
           probLit = prob + offs + bit + symbol;
+#ifdef _LZMA_DEC_SPEED
+          {
+            /* offs &= bit for a 1 bit, offs &= ~bit for a 0 bit */
+            UInt32 m;
+            GET_BIT_MASK(probLit, symbol, m);
+            offs &= ~(bit ^ m);
+          }
+#else
           GET_BIT2(probLit, symbol, offs &= ~bit, offs &= bit)
+#endif
         }
         while (symbol < 0x100);
       }
@@ -325,7 +366,13 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
 
               do
               {
+#ifdef _LZMA_DEC_SPEED
+                UInt32 m;
+                GET_BIT_MASK(prob + i, i, m);
+                distance |= mask & m;
+#else
                 GET_BIT2(prob + i, i, ; , distance |= mask);
+#endif
                 mask <<= 1;
               }
               while (--numDirectBits != 0);
@@ -363,10 +410,22 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
             distance <<= kNumAlignBits;
             {
               unsigned i = 1;
+#ifdef _LZMA_DEC_SPEED
+              UInt32 m;
+              GET_BIT_MASK(prob + i, i, m);
+              distance |= 1 & m;
+              GET_BIT_MASK(prob + i, i, m);
+              distance |= 2 & m;
+              GET_BIT_MASK(prob + i, i, m);
+              distance |= 4 & m;
+              GET_BIT_MASK(prob + i, i, m);
+              distance |= 8 & m;
+#else
               GET_BIT2(prob + i, i, ; , distance |= 1);
               GET_BIT2(prob + i, i, ; , distance |= 2);
               GET_BIT2(prob + i, i, ; , distance |= 4);
               GET_BIT2(prob + i, i, ; , distance |= 8);
+#endif
             }
             if (distance == (UInt32)0xFFFFFFFF)
             {
@@ -17,4 +17,30 @@
 extern int lzma_is_valid(const unsigned char *buf);
 extern int lzmaBuffToBuffDecompress (unsigned char *outStream, SizeT *uncompressedSize,
 			      unsigned char *inStream,  SizeT  length);
+
+/**
+ * xz_is_valid() - Does a buffer start with an xz stream header
+ *
+ * @buf: buffer, at least 6 bytes
+ * @return 1 or 0
+ */
+int xz_is_valid(const unsigned char *buf);
+
+/**
+ * xz_decompress() - Decompress an xz stream
+ *
+ * Decodes a single xz stream, as made by xz(1), whose blocks only use the
+ * LZMA2 filter. The blocks are decoded independently, by all CPUs with
+ * CONFIG_LZMA_SMP unless @dst overlaps @src.
+ *
+ * @src: Source data to decompress
+ * @srcn: Length of source data, trailing stream padding allowed
+ * @dst: Destination for uncompressed data
+ * @dstn: Size of @dst, returns length of uncompressed data
+ * @return 0 if OK, -EINVAL if @src is no xz stream, -EPROTONOSUPPORT if a
+ *	block uses another filter than LZMA2 alone, -ENOBUFS if the
+ *	destination buffer is overrun, -EPROTO if the data is corrupt or
+ *	fails its check, -ENOMEM if there is no memory for the decoder
+ */
+int xz_decompress(const void *src, size_t srcn, void *dst, size_t *dstn);
 #endif
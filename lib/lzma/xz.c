@@ -0,0 +1,451 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd
+ *
+ * Decoder for .xz files with LZMA2 blocks, as made by xz(1), on top of the
+ * LZMA SDK decoder. The index at the end of the stream gives the size of
+ * every block before and after compression, so each block can be decoded
+ * on its own straight to its place in the output. With CONFIG_LZMA_SMP
+ * the blocks of a multi-block file (xz -T0, or --block-size) are decoded
+ * by all CPUs at once.
+ */
+
+#include <common.h>
+#include <errno.h>
+#include <malloc.h>
+#include <watchdog.h>
+#include <asm/unaligned.h>
+#include <u-boot/crc.h>
+#if CONFIG_IS_ENABLED(LZMA_SMP)
+#include <asm/arch/smp_work.h>
+#endif
+
+#include "LzmaTools.h"
+#include "LzmaDec.h"
+
+#define XZ_STREAM_HDR_SIZE	12
+#define XZ_STREAM_FTR_SIZE	12
+#define XZ_FILTER_LZMA2		0x21
+#define XZ_CHECK_CRC32		1
+#define XZ_CHECK_CRC64		4
+#define XZ_BLOCK_FILTERS	0x03
+#define XZ_BLOCK_RESERVED	0x3c
+#define XZ_BLOCK_CSIZE		0x40
+#define XZ_BLOCK_USIZE		0x80
+
+/* LZMA2 limits lc + lp to 4, so one probs array fits all its chunks */
+#define XZ_LZMA2_LCLP_MAX	4
+#define XZ_LZMA2_PROBS		(1846 + (0x300 << XZ_LZMA2_LCLP_MAX))
+
+static const u8 xz_magic[6] = { 0xfd, '7', 'z', 'X', 'Z', 0x00 };
+
+/* Size of the check field for each of the 16 check types */
+static const u8 xz_check_size[16] = {
+	0, 4, 4, 4, 8, 8, 8, 16, 16, 16, 32, 32, 32, 64, 64, 64
+};
+
+static u64 xz_crc64_table[256];
+
+struct xz_block {
+	const u8 *in;		/* block header */
+	size_t size;		/* unpadded size: header, data and check */
+	u8 *out;
+	size_t out_size;
+	int ret;
+};
+
+struct xz_ctx {
+	struct xz_block *blk;
+	int nr_blks;
+	int next;		/* next block to be claimed by a CPU */
+	int check;
+	CLzmaProb *probs;	/* XZ_LZMA2_PROBS for each of nr_probs CPUs */
+	int nr_probs;
+};
+
+int xz_is_valid(const unsigned char *buf)
+{
+	return !memcmp(buf, xz_magic, sizeof(xz_magic));
+}
+
+/* ECMA-182 as xz uses it, the table is filled by the boot CPU */
+static void xz_crc64_init(void)
+{
+	u64 crc;
+	int i, j;
+
+	if (xz_crc64_table[1])
+		return;
+
+	for (i = 0; i < 256; i++) {
+		crc = i;
+		for (j = 0; j < 8; j++)
+			crc = (crc >> 1) ^ (crc & 1 ? 0xc96c5795d7870f42ULL : 0);
+		xz_crc64_table[i] = crc;
+	}
+}
+
+static u64 xz_crc64(const u8 *buf, size_t len)
+{
+	u64 crc = ~0ULL;
+
+	while (len--)
+		crc = xz_crc64_table[(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+
+	return ~crc;
+}
+
+/* Variable-length integer, 7 bits per byte, at most 9 bytes */
+static int xz_vli(const u8 **p, const u8 *end, u64 *val)
+{
+	const u8 *in = *p;
+	int i;
+
+	*val = 0;
+	for (i = 0; i < 9 && in < end; i++) {
+		*val |= (u64)(*in & 0x7f) << (i * 7);
+		if (!(*in++ & 0x80)) {
+			if (i && !in[-1])
+				return -EPROTO;	/* not the shortest encoding */
+			*p = in;
+			return 0;
+		}
+	}
+
+	return -EPROTO;
+}
+
+/*
+ * Decode the LZMA2 chunks of a block, taking the whole of @out as the
+ * dictionary as LzmaDecode() does. Every LZMA chunk restarts the range
+ * coder and ends after an exact number of bytes in and out.
+ */
+static int xz_lzma2(CLzmaProb *probs, u32 dict_size, const u8 *in, size_t len,
+		    u8 *out, size_t size)
+{
+	const u8 *end = in + len;
+	bool need_dic = true, need_props = true, need_state = true;
+	size_t unpack, pack, in_len, limit;
+	ELzmaStatus status;
+	CLzmaDec dec;
+	int ctrl, mode, props;
+
+	LzmaDec_Construct(&dec);
+	dec.probs = probs;
+	dec.dic = out;
+	dec.dicBufSize = size;
+	dec.prop.dicSize = dict_size;
+	LzmaDec_Init(&dec);
+
+	while (in < end) {
+		ctrl = *in++;
+		if (!ctrl)
+			return dec.dicPos == size ? 0 : -EPROTO;
+
+		/* Stored chunk, 1 resets the dictionary */
+		if (ctrl < 0x80) {
+			if (ctrl > 2 || end - in < 2)
+				return -EPROTO;
+			unpack = get_unaligned_be16(in) + 1;
+			in += 2;
+
+			if (ctrl == 1) {
+				need_props = true;
+				need_state = true;
+				need_dic = false;
+			} else if (need_dic) {
+				return -EPROTO;
+			}
+			LzmaDec_InitDicAndState(&dec, ctrl == 1, False);
+
+			if (unpack > end - in || unpack > size - dec.dicPos)
+				return -EPROTO;
+			memcpy(out + dec.dicPos, in, unpack);
+			if (!dec.checkDicSize &&
+			    dec.prop.dicSize - dec.processedPos <= unpack)
+				dec.checkDicSize = dec.prop.dicSize;
+			dec.processedPos += unpack;
+			dec.dicPos += unpack;
+			in += unpack;
+			continue;
+		}
+
+		/*
+		 * LZMA chunk, mode 1 resets the state, 2 also sets new
+		 * properties and 3 also resets the dictionary
+		 */
+		if (end - in < 4)
+			return -EPROTO;
+		mode = (ctrl >> 5) & 3;
+		unpack = ((ctrl & 0x1f) << 16) + get_unaligned_be16(in) + 1;
+		pack = get_unaligned_be16(in + 2) + 1;
+		in += 4;
+
+		if (mode >= 2) {
+			if (in >= end)
+				return -EPROTO;
+			props = *in++;
+			if (props >= 9 * 5 * 5)
+				return -EPROTO;
+			dec.prop.lc = props % 9;
+			props /= 9;
+			dec.prop.lp = props % 5;
+			dec.prop.pb = props / 5;
+			if (dec.prop.lc + dec.prop.lp > XZ_LZMA2_LCLP_MAX)
+				return -EPROTO;
+			need_props = false;
+		} else if (need_props) {
+			return -EPROTO;
+		}
+		if ((mode < 3 && need_dic) || (!mode && need_state))
+			return -EPROTO;
+		LzmaDec_InitDicAndState(&dec, mode == 3, mode > 0);
+		need_dic = false;
+		need_state = false;
+
+		if (pack > end - in || unpack > size - dec.dicPos)
+			return -EPROTO;
+		in_len = pack;
+		limit = dec.dicPos + unpack;
+		if (LzmaDec_DecodeToDic(&dec, limit, in, &in_len,
+					LZMA_FINISH_ANY, &status) != SZ_OK ||
+		    in_len != pack || dec.dicPos != limit ||
+		    status != LZMA_STATUS_MAYBE_FINISHED_WITHOUT_MARK)
+			return -EPROTO;
+		in += pack;
+	}
+
+	return -EPROTO;	/* no end of data chunk */
+}
+
+/*
+ * Decode one block. Runs on any CPU: nothing but the block, the output
+ * slot and the given probs array is touched.
+ */
+static int xz_decode_block(const struct xz_block *b, int check,
+			   CLzmaProb *probs)
+{
+	const u8 *in = b->in, *p, *hdr_end, *chk;
+	size_t hdr_size, data_size, chk_size = xz_check_size[check];
+	u32 dict_size;
+	u64 val;
+	int flags, dict, ret;
+
+	hdr_size = (in[0] + 1) * 4;
+	if (!in[0] || hdr_size + chk_size >= b->size)
+		return -EPROTO;
+	data_size = b->size - hdr_size - chk_size;
+	hdr_end = in + hdr_size - 4;
+	if (get_unaligned_le32(hdr_end) != crc32(0, in, hdr_size - 4))
+		return -EPROTO;
+
+	flags = in[1];
+	if (flags & XZ_BLOCK_RESERVED)
+		return -EPROTO;
+	if (flags & XZ_BLOCK_FILTERS)
+		return -EPROTONOSUPPORT;	/* e.g. a BCJ filter */
+
+	p = in + 2;
+	if (flags & XZ_BLOCK_CSIZE) {
+		if (xz_vli(&p, hdr_end, &val) || val != data_size)
+			return -EPROTO;
+	}
+	if (flags & XZ_BLOCK_USIZE) {
+		if (xz_vli(&p, hdr_end, &val) || val != b->out_size)
+			return -EPROTO;
+	}
+	if (xz_vli(&p, hdr_end, &val))
+		return -EPROTO;
+	if (val != XZ_FILTER_LZMA2)
+		return -EPROTONOSUPPORT;
+	if (xz_vli(&p, hdr_end, &val) || val != 1 || p >= hdr_end)
+		return -EPROTO;
+	dict = *p++;
+	if (dict > 40)
+		return -EPROTO;
+	while (p < hdr_end)
+		if (*p++)
+			return -EPROTO;	/* header padding */
+
+	dict_size = dict == 40 ? 0xffffffff :
+		    (u32)(2 | (dict & 1)) << (dict / 2 + 11);
+	ret = xz_lzma2(probs, dict_size, in + hdr_size, data_size,
+		       b->out, b->out_size);
+	if (ret)
+		return ret;
+
+	/* Block padding, then the check of the uncompressed data */
+	p = in + hdr_size + data_size;
+	chk = in + ALIGN(hdr_size + data_size, 4);
+	while (p < chk)
+		if (*p++)
+			return -EPROTO;
+
+	switch (check) {
+	case XZ_CHECK_CRC32:
+		if (get_unaligned_le32(chk) != crc32(0, b->out, b->out_size))
+			return -EPROTO;
+		break;
+	case XZ_CHECK_CRC64:
+		if (get_unaligned_le64(chk) != xz_crc64(b->out, b->out_size))
+			return -EPROTO;
+		break;
+	default:
+		/* None, or SHA-256 which is left unchecked */
+		break;
+	}
+
+	return 0;
+}
+
+/* Runs on every CPU, each claiming the next block not decoded yet */
+static void xz_decode_blocks(void *arg, int cpu, int nr_cpus)
+{
+	struct xz_ctx *ctx = arg;
+	CLzmaProb *probs;
+	int i;
+
+	if (cpu >= ctx->nr_probs)
+		return;
+	probs = ctx->probs + cpu * XZ_LZMA2_PROBS;
+
+	while ((i = __atomic_fetch_add(&ctx->next, 1, __ATOMIC_RELAXED)) <
+	       ctx->nr_blks) {
+		ctx->blk[i].ret = xz_decode_block(&ctx->blk[i], ctx->check,
+						  probs);
+		if (!cpu)
+			WATCHDOG_RESET();
+	}
+}
+
+/* Lay out the blocks from the index, checking them against the stream */
+static int xz_parse_index(const u8 *src, const u8 *index, const u8 *footer,
+			  u8 *dst, size_t dst_size, struct xz_ctx *ctx)
+{
+	const u8 *blk = src + XZ_STREAM_HDR_SIZE, *p = index + 1;
+	struct xz_block *b;
+	u64 count, size, out_size;
+	u8 *out = dst;
+	int i;
+
+	if (*index || xz_vli(&p, footer, &count))
+		return -EPROTO;
+	/* Each record takes two bytes at least */
+	if (count > (footer - p) / 2)
+		return -EPROTO;
+
+	ctx->nr_blks = count;
+	ctx->blk = malloc(sizeof(*ctx->blk) * (count ? count : 1));
+	if (!ctx->blk)
+		return -ENOMEM;
+
+	for (i = 0; i < count; i++) {
+		if (xz_vli(&p, footer, &size) ||
+		    xz_vli(&p, footer, &out_size))
+			return -EPROTO;
+		if (size > index - blk || ALIGN(size, 4) > index - blk)
+			return -EPROTO;
+		if (out_size > dst + dst_size - out)
+			return -ENOBUFS;
+
+		b = &ctx->blk[i];
+		b->in = blk;
+		b->size = size;
+		b->out = out;
+		b->out_size = out_size;
+		b->ret = 0;
+		blk += ALIGN(size, 4);
+		out += out_size;
+	}
+
+	/* The blocks fill the space up to the index, a single stream only */
+	if (blk != index)
+		return -EPROTO;
+
+	while ((p - index) & 3)
+		if (p >= footer || *p++)
+			return -EPROTO;
+	if (footer - p != 4 ||
+	    get_unaligned_le32(p) != crc32(0, index, p - index))
+		return -EPROTO;
+
+	return 0;
+}
+
+int xz_decompress(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	const u8 *in = src, *end = in + srcn, *footer, *index;
+	struct xz_ctx ctx;
+	size_t size = 0, index_size;
+	int nr_cpus = 1;
+	int i, ret;
+
+	if (srcn < XZ_STREAM_HDR_SIZE + XZ_STREAM_FTR_SIZE || !xz_is_valid(in))
+		return -EINVAL;
+	if (in[6] || in[7] & 0xf0 ||
+	    get_unaligned_le32(in + 8) != crc32(0, in + 6, 2))
+		return -EINVAL;
+	ctx.check = in[7];
+
+	/* Stream padding: a multiple of 4 zero bytes */
+	while (end - in > XZ_STREAM_HDR_SIZE + XZ_STREAM_FTR_SIZE &&
+	       !get_unaligned_le32(end - 4))
+		end -= 4;
+	footer = end - XZ_STREAM_FTR_SIZE;
+	if (footer[10] != 'Y' || footer[11] != 'Z' ||
+	    memcmp(footer + 8, in + 6, 2) ||
+	    get_unaligned_le32(footer) != crc32(0, footer + 4, 6))
+		return -EPROTO;
+	index_size = (get_unaligned_le32(footer + 4) + 1ULL) * 4;
+	if (index_size > footer - in - XZ_STREAM_HDR_SIZE)
+		return -EPROTO;
+	index = footer - index_size;
+
+	ctx.blk = NULL;
+	ctx.probs = NULL;
+	ret = xz_parse_index(in, index, footer, dst, *dstn, &ctx);
+	if (ret)
+		goto out;
+
+	if (ctx.check == XZ_CHECK_CRC64)
+		xz_crc64_init();
+
+#if CONFIG_IS_ENABLED(LZMA_SMP)
+	/* In-place: later blocks could overwrite input not decoded yet */
+	if (ctx.nr_blks > 1 &&
+	    (dst >= src + srcn || src >= dst + *dstn))
+		nr_cpus = mp_task_pool_start() + 1;
+#endif
+	ctx.probs = malloc(nr_cpus * XZ_LZMA2_PROBS * sizeof(CLzmaProb));
+	if (!ctx.probs && nr_cpus > 1) {
+		nr_cpus = 1;
+		ctx.probs = malloc(XZ_LZMA2_PROBS * sizeof(CLzmaProb));
+	}
+	if (!ctx.probs) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	ctx.nr_probs = nr_cpus;
+	ctx.next = 0;
+
+#if CONFIG_IS_ENABLED(LZMA_SMP)
+	if (nr_cpus > 1)
+		smp_work_run(xz_decode_blocks, &ctx);
+	else
+#endif
+		xz_decode_blocks(&ctx, 0, 1);
+
+	for (i = 0; i < ctx.nr_blks; i++) {
+		if (ctx.blk[i].ret) {
+			debug("xz: block %d failed (%d)\n", i, ctx.blk[i].ret);
+			ret = ctx.blk[i].ret;
+			goto out;
+		}
+		size += ctx.blk[i].out_size;
+	}
+	*dstn = size;
+out:
+	free(ctx.probs);
+	free(ctx.blk);
+	return ret;
+}
@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd
+ *
+ * Index of sysmem and bidram memblocks: by address as an interval tree,
+ * each node keeping the highest end address below it, and by name.
+ */
+
+#include <common.h>
+#include <memblk.h>
+#include <linux/rbtree_augmented.h>
+
+static inline phys_addr_t memblk_end(struct memblock *mem)
+{
+	return mem->base + mem->size;
+}
+
+static inline phys_addr_t memblk_compute_end(struct memblock *mem)
+{
+	phys_addr_t end = memblk_end(mem);
+	struct memblock *child;
+
+	if (mem->rb.rb_left) {
+		child = rb_entry(mem->rb.rb_left, struct memblock, rb);
+		end = max(end, child->subtree_end);
+	}
+	if (mem->rb.rb_right) {
+		child = rb_entry(mem->rb.rb_right, struct memblock, rb);
+		end = max(end, child->subtree_end);
+	}
+
+	return end;
+}
+
+RB_DECLARE_CALLBACKS(static, memblk_augment, struct memblock, rb,
+		     phys_addr_t, subtree_end, memblk_compute_end)
+
+void memblk_tree_insert(struct memblk_tree *tree, struct memblock *mem)
+{
+	struct rb_node **link = &tree->addr.rb_node, *parent = NULL;
+	struct memblock *node;
+	int cmp;
+
+	mem->subtree_end = memblk_end(mem);
+	while (*link) {
+		parent = *link;
+		node = rb_entry(parent, struct memblock, rb);
+		if (node->subtree_end < mem->subtree_end)
+			node->subtree_end = mem->subtree_end;
+		if (mem->base < node->base)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+	rb_link_node(&mem->rb, parent, link);
+	rb_insert_augmented(&mem->rb, &tree->addr, &memblk_augment);
+
+	link = &tree->name.rb_node;
+	parent = NULL;
+	while (*link) {
+		parent = *link;
+		node = rb_entry(parent, struct memblock, name_rb);
+		cmp = strcmp(mem->attr.name, node->attr.name);
+		if (cmp < 0)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+	rb_link_node(&mem->name_rb, parent, link);
+	rb_insert_color(&mem->name_rb, &tree->name);
+}
+
+void memblk_tree_erase(struct memblk_tree *tree, struct memblock *mem)
+{
+	rb_erase_augmented(&mem->rb, &tree->addr, &memblk_augment);
+	rb_erase(&mem->name_rb, &tree->name);
+}
+
+struct memblock *memblk_tree_overlap(struct memblk_tree *tree,
+				     phys_addr_t base, phys_size_t size)
+{
+	phys_addr_t end = base + size;
+	struct memblock *node, *left;
+
+	if (!tree->addr.rb_node || !size)
+		return NULL;
+
+	node = rb_entry(tree->addr.rb_node, struct memblock, rb);
+	if (base >= node->subtree_end)
+		return NULL;
+
+	/* The lowest based one, as a walk of the sorted list would find */
+	while (true) {
+		if (node->rb.rb_left) {
+			left = rb_entry(node->rb.rb_left, struct memblock, rb);
+			if (base < left->subtree_end) {
+				node = left;
+				continue;
+			}
+		}
+		if (node->base >= end)
+			return NULL;
+		if (base < memblk_end(node))
+			return node;
+		if (!node->rb.rb_right)
+			return NULL;
+		node = rb_entry(node->rb.rb_right, struct memblock, rb);
+		if (base >= node->subtree_end)
+			return NULL;
+	}
+}
+
+struct memblock *memblk_tree_find_base(struct memblk_tree *tree,
+				       phys_addr_t base)
+{
+	struct rb_node *rb = tree->addr.rb_node;
+	struct memblock *node;
+
+	while (rb) {
+		node = rb_entry(rb, struct memblock, rb);
+		if (base < node->base)
+			rb = rb->rb_left;
+		else if (base > node->base)
+			rb = rb->rb_right;
+		else
+			return node;
+	}
+
+	return NULL;
+}
+
+struct memblock *memblk_tree_find_name(struct memblk_tree *tree,
+				       const char *name)
+{
+	struct rb_node *rb = tree->name.rb_node;
+	struct memblock *node;
+	int cmp;
+
+	while (rb) {
+		node = rb_entry(rb, struct memblock, name_rb);
+		cmp = strcmp(name, node->attr.name);
+		if (cmp < 0)
+			rb = rb->rb_left;
+		else if (cmp > 0)
+			rb = rb->rb_right;
+		else
+			return node;
+	}
+
+	return NULL;
+}
@@ -188,16 +188,25 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 		if (pa < ps)
 			pa = p1;
 		sz = (pa - ps) + 1;
-		pp = unflatten_dt_alloc(&mem, sizeof(struct property) + sz,
+		/*
+		 * Without a unit address the name is already terminated in
+		 * the flat tree, so point there rather than copy it.
+		 */
+		pp = unflatten_dt_alloc(&mem, sizeof(struct property) +
+					(pa == p1 ? 0 : sz),
 					__alignof__(struct property));
 		if (!dryrun) {
 			pp->name = "name";
 			pp->length = sz;
-			pp->value = pp + 1;
+			if (pa == p1) {
+				pp->value = (void *)ps;
+			} else {
+				pp->value = pp + 1;
+				memcpy(pp->value, ps, sz - 1);
+				((char *)pp->value)[sz - 1] = 0;
+			}
 			*prev_pp = pp;
 			prev_pp = &pp->next;
-			memcpy(pp->value, ps, sz - 1);
-			((char *)pp->value)[sz - 1] = 0;
 			debug("fixed up name for %s -> %s\n", pathp,
 			      (char *)pp->value);
 		}
@@ -297,6 +306,8 @@ static int unflatten_device_tree(const void *blob,
 
 	/* Allocate memory for the expanded device tree */
 	mem = malloc(size + 4);
+	if (!mem)
+		return -ENOMEM;
 	memset(mem, '\0', size);
 
 	*(__be32 *)(mem + size) = cpu_to_be32(0xdeadbeef);
@@ -273,8 +273,10 @@ Exit:
 /*
  * Register shared memory
  *
- * If the supplied buffer is compatible we can use it as supplied otherwise
- * we'll need to allocate a copy buffer for the transfer instead.
+ * If the supplied buffer is in the shared memory block already the TEE
+ * uses it as supplied, without a copy. Otherwise we'll need to allocate a
+ * copy buffer for the transfer instead, which TEEC_InvokeCommand() copies
+ * the data through.
  */
 TEEC_Result TEEC_RegisterSharedMemory(TEEC_Context *context,
 			TEEC_SharedMemory *shared_memory)
@@ -293,12 +295,11 @@ TEEC_Result TEEC_RegisterSharedMemory(TEEC_Context *context,
 
 	shared_memory->alloc_buffer = 0;
 
-	phys_addr_t start = (phys_addr_t) shared_memory->buffer;
-
-	if ((start % 4096) != 0) {
+	if (!OpteeClientMemIsShared(shared_memory->buffer,
+				    shared_memory->size)) {
 		TEEC_SharedMemory TempSharedMemory;
 		TempSharedMemory.size  = shared_memory->size;
-		TempSharedMemory.flags = shared_memory->flags;
+		TempSharedMemory.flags = 0;
 
 		TeecResult = TEEC_AllocateSharedMemory
 			(context, &TempSharedMemory);
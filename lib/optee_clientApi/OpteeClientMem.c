@@ -88,18 +88,16 @@ void *my_malloc(uint32_t size)
 	num = (size - 1) / 4096 + 1;
 	if (my_count < num)
 		return 0;
-	for (i = 0; i < my_count - num; i++) {
+	for (i = 0; i + num <= my_count; i++) {
 		if (*(my_flag + i) == 0) {
 			for (j = 0; j < num; j++) {
 				if (*(my_flag + i + j) != 0)
 					break;
 			}
 			if (j == num) {
-				for (k = 0; k < num; k++) {
+				/* Free blocks are zero already, my_free() clears them */
+				for (k = 0; k < num; k++)
 					*(my_flag + i + k) = 1;
-					memset(my_mem_start +
-						(i + k) * 4096, 0, 4096);
-				}
 				debug("TEEC: malloc is: 0x%X  0x%X\n",
 					(int)i, (int)num);
 				write_usedblock((my_mem_start + i * 4096),
@@ -117,7 +115,7 @@ void my_free(void *ptr)
 {
 	uint32_t i, j, num, size;
 
-	if (ptr < my_mem_start)
+	if (ptr < my_mem_start || !my_count)
 		return;
 
 	i = (ptr - my_mem_start) / 4096;
@@ -170,3 +168,15 @@ void OpteeClientMemFree(void *mem)
 {
 	my_free(mem);
 }
+
+/*
+ * Whether the TEE can reach a buffer as it is, that is whether it lies in
+ * the TrustZone shared memory block.
+ */
+bool OpteeClientMemIsShared(void *mem, uint32_t length)
+{
+	void *end = my_mem_start + my_count * 4096;
+
+	return my_count && mem >= my_mem_start && mem < end &&
+	       length <= end - mem;
+}
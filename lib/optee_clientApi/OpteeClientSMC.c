@@ -21,6 +21,43 @@ static void GetTeeSmc32Params(t_teesmc32_param *TeeSmc32Param,
 	TEEC_Operation *operation);
 static TEEC_Result OpteeSmcCall(t_teesmc32_arg *TeeSmc32Arg);
 
+/*
+ * The argument block of a call is kept from call to call rather than
+ * taken from the shared memory pool and cleared each time. A call while
+ * it is in use gets a block of its own.
+ */
+#define TEEC_SMC_ARG_CACHE_SIZE		4096
+
+static void *TeeSmc32ArgCache;
+static bool TeeSmc32ArgCacheBusy;
+
+static void *TeeSmc32ArgAlloc(uint32_t Length)
+{
+	void *Arg;
+
+	if (Length > TEEC_SMC_ARG_CACHE_SIZE || TeeSmc32ArgCacheBusy)
+		return OpteeClientMemAlloc(Length);
+
+	if (!TeeSmc32ArgCache)
+		TeeSmc32ArgCache = OpteeClientMemAlloc(TEEC_SMC_ARG_CACHE_SIZE);
+	if (!TeeSmc32ArgCache)
+		return NULL;
+
+	Arg = TeeSmc32ArgCache;
+	memset(Arg, 0, Length);
+	TeeSmc32ArgCacheBusy = true;
+
+	return Arg;
+}
+
+static void TeeSmc32ArgFree(void *Arg)
+{
+	if (Arg == TeeSmc32ArgCache)
+		TeeSmc32ArgCacheBusy = false;
+	else
+		OpteeClientMemFree(Arg);
+}
+
 void tee_uuid_to_octets(uint8_t *d, const TEEC_UUID *s)
 {
 	d[0] = s->timeLow >> 24;
@@ -62,27 +99,22 @@ TEEC_Result TEEC_SMC_OpenSession(TEEC_Context *context,
 
 	TeeSmc32ArgLength =
 		TEESMC32_GET_ARG_SIZE(TEEC_CONFIG_PAYLOAD_REF_COUNT + MetaNum);
+	TeeSmc32ArgLength = ALIGN(TeeSmc32ArgLength, 8);
+	TeeSmcMetaSessionLength = sizeof(*TeeSmcMetaSession);
 
-	TeeSmc32Arg = (t_teesmc32_arg *)OpteeClientMemAlloc(TeeSmc32ArgLength);
+	/* The meta session follows the argument block */
+	TeeSmc32Arg = (t_teesmc32_arg *)
+		TeeSmc32ArgAlloc(TeeSmc32ArgLength + TeeSmcMetaSessionLength);
 
 	if (TeeSmc32Arg == NULL) {
 		TeecResult = TEEC_ERROR_OUT_OF_MEMORY;
 		goto Exit;
 	}
 
-	memset(TeeSmc32Arg, 0, TeeSmc32ArgLength);
-
-	TeeSmcMetaSessionLength = sizeof(*TeeSmcMetaSession);
+	memset(TeeSmc32Arg, 0, TeeSmc32ArgLength + TeeSmcMetaSessionLength);
 
 	TeeSmcMetaSession = (t_teesmc_meta_open_session *)
-		OpteeClientMemAlloc(TeeSmcMetaSessionLength);
-
-	if (TeeSmcMetaSession == NULL) {
-		TeecResult = TEEC_ERROR_OUT_OF_MEMORY;
-		goto Exit;
-	}
-
-	memset(TeeSmcMetaSession, 0, TeeSmcMetaSessionLength);
+		((uint8_t *)TeeSmc32Arg + TeeSmc32ArgLength);
 
 	TeeSmc32Arg->cmd = TEESMC_CMD_OPEN_SESSION;
 	TeeSmc32Arg->num_params = TEEC_CONFIG_PAYLOAD_REF_COUNT + MetaNum;
@@ -129,10 +161,7 @@ TEEC_Result TEEC_SMC_OpenSession(TEEC_Context *context,
 
 Exit:
 	if (TeeSmc32Arg != NULL)
-		OpteeClientMemFree(TeeSmc32Arg);
-
-	if (TeeSmcMetaSession != NULL)
-		OpteeClientMemFree(TeeSmcMetaSession);
+		TeeSmc32ArgFree(TeeSmc32Arg);
 
 	return TeecResult;
 }
@@ -158,15 +187,13 @@ TEEC_Result TEEC_SMC_CloseSession(TEEC_Session *session,
 	TeeSmc32ArgLength =
 		TEESMC32_GET_ARG_SIZE(TEEC_CONFIG_PAYLOAD_REF_COUNT);
 
-	TeeSmc32Arg = (t_teesmc32_arg *)OpteeClientMemAlloc(TeeSmc32ArgLength);
+	TeeSmc32Arg = (t_teesmc32_arg *)TeeSmc32ArgAlloc(TeeSmc32ArgLength);
 
 	if (TeeSmc32Arg == NULL) {
 		TeecResult = TEEC_ERROR_OUT_OF_MEMORY;
 		goto Exit;
 	}
 
-	memset(TeeSmc32Arg, 0, TeeSmc32ArgLength);
-
 	TeeSmc32Arg->cmd = TEESMC_CMD_CLOSE_SESSION;
 	TeeSmc32Arg->session = session->id;
 
@@ -182,7 +209,7 @@ TEEC_Result TEEC_SMC_CloseSession(TEEC_Session *session,
 
 Exit:
 	if (TeeSmc32Arg != NULL)
-		OpteeClientMemFree(TeeSmc32Arg);
+		TeeSmc32ArgFree(TeeSmc32Arg);
 
 	return TeecResult;
 }
@@ -206,15 +233,13 @@ TEEC_Result TEEC_SMC_InvokeCommand(TEEC_Session *session,
 	TeeSmc32ArgLength =
 		TEESMC32_GET_ARG_SIZE(TEEC_CONFIG_PAYLOAD_REF_COUNT);
 
-	TeeSmc32Arg = (t_teesmc32_arg *)OpteeClientMemAlloc(TeeSmc32ArgLength);
+	TeeSmc32Arg = (t_teesmc32_arg *)TeeSmc32ArgAlloc(TeeSmc32ArgLength);
 
 	if (TeeSmc32Arg == NULL) {
 		TeecResult = TEEC_ERROR_OUT_OF_MEMORY;
 		goto Exit;
 	}
 
-	memset(TeeSmc32Arg, 0, TeeSmc32ArgLength);
-
 	TeeSmc32Arg->cmd = TEESMC_CMD_INVOKE_COMMAND;
 	TeeSmc32Arg->ta_func = cmd_id;
 	TeeSmc32Arg->session = session->id;
@@ -237,7 +262,7 @@ TEEC_Result TEEC_SMC_InvokeCommand(TEEC_Session *session,
 
 Exit:
 	if (TeeSmc32Arg != NULL)
-		OpteeClientMemFree(TeeSmc32Arg);
+		TeeSmc32ArgFree(TeeSmc32Arg);
 
 
 	return TeecResult;
@@ -288,6 +313,35 @@ void SetTeeSmc32Params(TEEC_Operation *operation,
 			(uint32_t)(size_t)operation->params[ParamCount].tmpref.buffer;
 			TeeSmc32Param[ParamCount].u.memref.size =
 				operation->params[ParamCount].tmpref.size;
+		} else if (attr == TEEC_MEMREF_WHOLE ||
+			   attr == TEEC_MEMREF_PARTIAL_INPUT ||
+			   attr == TEEC_MEMREF_PARTIAL_OUTPUT ||
+			   attr == TEEC_MEMREF_PARTIAL_INOUT) {
+			TEEC_RegisteredMemoryReference *memref =
+				&operation->params[ParamCount].memref;
+			TEEC_SharedMemory *parent = memref->parent;
+			uint8_t *buf = parent->alloc_buffer ?
+				       parent->alloc_buffer : parent->buffer;
+			size_t offset = 0, size = parent->size;
+
+			if (attr == TEEC_MEMREF_WHOLE) {
+				attr = TEEC_MEMREF_PARTIAL_INOUT;
+			} else {
+				offset = memref->offset;
+				size = memref->size;
+			}
+			/* A registered buffer outside shared memory is copied */
+			if (parent->alloc_buffer &&
+			    attr != TEEC_MEMREF_PARTIAL_OUTPUT)
+				memcpy(buf + offset,
+				       (uint8_t *)parent->buffer + offset, size);
+
+			TeeSmc32Param[ParamCount].attr = attr +
+				(OPTEE_MSG_ATTR_TYPE_TMEM_INPUT_V2 -
+				 TEEC_MEMREF_PARTIAL_INPUT);
+			TeeSmc32Param[ParamCount].u.memref.buf_ptr =
+				(uint32_t)(size_t)(buf + offset);
+			TeeSmc32Param[ParamCount].u.memref.size = size;
 		} else {
 			TeeSmc32Param[ParamCount].attr = attr;
 			TeeSmc32Param[ParamCount].u.value.a =
@@ -315,6 +369,34 @@ void GetTeeSmc32Params(t_teesmc32_param *TeeSmc32Param,
 	for (ParamCount = 0;
 	ParamCount < TEEC_CONFIG_PAYLOAD_REF_COUNT;
 	ParamCount++) {
+		uint32_t attr =
+			TEEC_PARAM_TYPE_GET(operation->paramTypes, ParamCount);
+
+		if (attr == TEEC_MEMREF_WHOLE ||
+		    attr == TEEC_MEMREF_PARTIAL_INPUT ||
+		    attr == TEEC_MEMREF_PARTIAL_OUTPUT ||
+		    attr == TEEC_MEMREF_PARTIAL_INOUT) {
+			TEEC_RegisteredMemoryReference *memref =
+				&operation->params[ParamCount].memref;
+			TEEC_SharedMemory *parent = memref->parent;
+			size_t offset = attr == TEEC_MEMREF_WHOLE ?
+					0 : memref->offset;
+			size_t size = TeeSmc32Param[ParamCount].u.memref.size;
+
+			if (attr == TEEC_MEMREF_PARTIAL_INPUT)
+				continue;
+			if (attr == TEEC_MEMREF_WHOLE)
+				size = min(size, parent->size);
+			else
+				size = min(size, memref->size);
+			if (parent->alloc_buffer)
+				memcpy((uint8_t *)parent->buffer + offset,
+				       (uint8_t *)parent->alloc_buffer + offset,
+				       size);
+			memref->size = TeeSmc32Param[ParamCount].u.memref.size;
+			continue;
+		}
+
 		operation->params[ParamCount].value.a =
 			TeeSmc32Param[ParamCount].u.value.a;
 		operation->params[ParamCount].value.b =
@@ -47,7 +47,7 @@ static int rpmb_data_req(struct s_rpmb *req_frm,
 		break;
 	}
 	case TEE_RPC_RPMB_MSG_TYPE_REQ_AUTH_DATA_WRITE: {
-		ret = do_authenticatedwrite(req_packets);
+		ret = do_authenticatedwrite(req_packets, req_nfrm);
 		break;
 	}
 	case TEE_RPC_RPMB_MSG_TYPE_REQ_AUTH_DATA_READ: {
@@ -82,7 +82,8 @@ static int rpmb_get_dev_info(struct tee_rpc_rpmb_dev_info *info)
 
 	memcpy(info->cid, cid_val, sizeof(info->cid));
 
-	info->rel_wr_sec_c = 1;
+	/* OP-TEE then writes up to twice as many frames in one request */
+	info->rel_wr_sec_c = mmc->rel_wr_sec_c ? mmc->rel_wr_sec_c : 1;
 	info->rpmb_size_mult = (uint8_t)(mmc->capacity_rpmb / (128 * 1024));
 	info->ret_code = 0;
 
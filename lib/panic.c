@@ -10,6 +10,7 @@
  */
 
 #include <common.h>
+#include <console.h>
 #if !defined(CONFIG_PANIC_HANG)
 #include <command.h>
 #endif
@@ -19,6 +20,8 @@ static void panic_finish(void) __attribute__ ((noreturn));
 static void panic_finish(void)
 {
 	putc('\n');
+	console_quiet_exit();
+	flushc();
 #if defined(CONFIG_PANIC_HANG)
 	hang();
 #else
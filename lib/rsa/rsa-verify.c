@@ -32,6 +32,12 @@
 #define OTP_RSA4096_ENABLE_VALUE	0x30
 #endif
 
+#if !defined(USE_HOSTCC)
+#if CONFIG_IS_ENABLED(RSA_VERIFY_CACHE)
+#define RSA_VERIFIED_CACHE
+#endif
+#endif
+
 /* Default otp value for enable secureboot */
 #ifndef OTP_SECURE_BOOT_ENABLE_VALUE
 #define OTP_SECURE_BOOT_ENABLE_VALUE	0xff
@@ -166,6 +172,88 @@ out:
 #endif
 #endif
 
+#ifdef RSA_VERIFIED_CACHE
+/*
+ * A FIT configuration is verified more than once in a boot, e.g. when
+ * U-Boot reads the resource image and the kernel dtb from the boot FIT and
+ * again in bootm. The modular exponentiation is the slow part of that, the
+ * more so with RSA-4096, so a signature which verified is not checked
+ * again against the same hash with the same key.
+ *
+ * An entry is found by the hash (with the checksum algo of the signature)
+ * of the key and the signature, so a different key at the same address,
+ * e.g. after gd->fdt_blob has changed, can't match it.
+ */
+#define RSA_VERIFIED_MAX	4
+
+struct rsa_verified {
+	const struct checksum_algo *checksum;
+	const struct padding_algo *padding;
+	uint8_t hash[FIT_MAX_HASH_LEN];	/* of the signed data */
+	uint8_t id[FIT_MAX_HASH_LEN];	/* of the key and the signature */
+};
+
+static struct rsa_verified rsa_verified[RSA_VERIFIED_MAX];
+static int rsa_verified_count, rsa_verified_next;
+
+static int rsa_verified_id(struct image_sign_info *info, struct key_prop *prop,
+			   const uint8_t *sig, uint32_t sig_len, uint8_t *id)
+{
+	struct image_region region[4];
+	int count = 0;
+
+	region[count].data = prop->modulus;
+	region[count++].size = prop->num_bits / 8;
+	if (prop->public_exponent) {
+		region[count].data = prop->public_exponent;
+		region[count++].size = prop->exp_len;
+	}
+	if (prop->public_exponent_BN) {
+		region[count].data = prop->public_exponent_BN;
+		region[count++].size = prop->num_bits / 8;
+	}
+	region[count].data = sig;
+	region[count++].size = sig_len;
+
+	return info->checksum->calculate(info->checksum->name, region, count,
+					 id);
+}
+
+static bool rsa_verified_find(struct image_sign_info *info,
+			      const uint8_t *hash, const uint8_t *id)
+{
+	int len = info->checksum->checksum_len;
+	struct rsa_verified *v;
+	int i;
+
+	for (i = 0; i < rsa_verified_count; i++) {
+		v = &rsa_verified[i];
+		if (v->checksum == info->checksum &&
+		    v->padding == info->padding &&
+		    !memcmp(v->hash, hash, len) && !memcmp(v->id, id, len))
+			return true;
+	}
+
+	return false;
+}
+
+static void rsa_verified_add(struct image_sign_info *info,
+			     const uint8_t *hash, const uint8_t *id)
+{
+	int len = info->checksum->checksum_len;
+	struct rsa_verified *v = &rsa_verified[rsa_verified_next];
+
+	v->checksum = info->checksum;
+	v->padding = info->padding;
+	memcpy(v->hash, hash, len);
+	memcpy(v->id, id, len);
+
+	rsa_verified_next = (rsa_verified_next + 1) % RSA_VERIFIED_MAX;
+	if (rsa_verified_count < RSA_VERIFIED_MAX)
+		rsa_verified_count++;
+}
+#endif
+
 int padding_pkcs_15_verify(struct image_sign_info *info,
 			   uint8_t *msg, int msg_len,
 			   const uint8_t *hash, int hash_len)
@@ -422,6 +510,18 @@ static int rsa_verify_key(struct image_sign_info *info,
 
 	uint8_t buf[sig_len];
 
+#ifdef RSA_VERIFIED_CACHE
+	uint8_t id[FIT_MAX_HASH_LEN];
+	/* id, and the hash and id in rsa_verified[], hold checksum_len */
+	bool have_id = info->checksum->checksum_len <= sizeof(id) &&
+		       !rsa_verified_id(info, prop, sig, sig_len, id);
+
+	if (have_id && rsa_verified_find(info, hash, id)) {
+		debug("RSA: signature verified before\n");
+		return 0;
+	}
+#endif
+
 #if !defined(USE_HOSTCC)
 #if CONFIG_IS_ENABLED(FIT_HW_CRYPTO)
 	ret = rsa_mod_exp_hw(prop, sig, sig_len, key_len, buf);
@@ -450,6 +550,11 @@ static int rsa_verify_key(struct image_sign_info *info,
 		return ret;
 	}
 
+#ifdef RSA_VERIFIED_CACHE
+	if (have_id)
+		rsa_verified_add(info, hash, id);
+#endif
+
 	return 0;
 }
 
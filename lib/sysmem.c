@@ -325,7 +325,6 @@ static void *sysmem_alloc_align_base(enum memblk_id id,
 	struct memblk_attr attr;
 	struct memblock *mem;
 	struct memcheck *check;
-	struct list_head *node;
 	const char *name;
 	phys_addr_t paddr;
 	phys_addr_t alloc_base;
@@ -454,36 +453,34 @@ static void *sysmem_alloc_align_base(enum memblk_id id,
 		 name, (ulong)base, (ulong)(base + size));
 
 	/* Already allocated ? */
-	list_for_each(node, &sysmem->allocated_head) {
-		mem = list_entry(node, struct memblock, node);
-		SYSMEM_D("Has allcated: %s, 0x%08lx - 0x%08lx\n",
-			 mem->attr.name, (ulong)mem->base,
-			 (ulong)(mem->base + mem->size));
-		if (!strcmp(mem->attr.name, name)) {
-			/* Allow double alloc for same but smaller region */
-			if (mem->base <= base && mem->size >= size)
-				return (void *)base;
+	mem = memblk_tree_find_name(&sysmem->allocated_tree, name);
+	if (mem) {
+		/* Allow double alloc for same but smaller region */
+		if (mem->base <= base && mem->size >= size)
+			return (void *)base;
 
-			SYSMEM_E("Failed to double alloc for existence \"%s\"\n", name);
-			goto out;
-		} else if (sysmem_is_overlap(mem->base, mem->size, base, size)) {
-			if (attr.flags & F_FAIL_WARNING)
-				SYSMEM_W("**Maybe** \"%s\" (0x%08lx - 0x%08lx) alloc is "
-					 "overlap with existence \"%s\" (0x%08lx - "
-					 "0x%08lx)\n",
-					 name, (ulong)base, (ulong)(base + size),
-					 mem->attr.name, (ulong)mem->base,
-					 (ulong)(mem->base + mem->size));
+		SYSMEM_E("Failed to double alloc for existence \"%s\"\n", name);
+		goto out;
+	}
 
-			else
-				SYSMEM_E("\"%s\" (0x%08lx - 0x%08lx) alloc is "
-					 "overlap with existence \"%s\" (0x%08lx - "
-					 "0x%08lx)\n",
-					 name, (ulong)base, (ulong)(base + size),
-					 mem->attr.name, (ulong)mem->base,
-					 (ulong)(mem->base + mem->size));
-			goto out;
-		}
+	mem = memblk_tree_overlap(&sysmem->allocated_tree, base, size);
+	if (mem) {
+		if (attr.flags & F_FAIL_WARNING)
+			SYSMEM_W("**Maybe** \"%s\" (0x%08lx - 0x%08lx) alloc is "
+				 "overlap with existence \"%s\" (0x%08lx - "
+				 "0x%08lx)\n",
+				 name, (ulong)base, (ulong)(base + size),
+				 mem->attr.name, (ulong)mem->base,
+				 (ulong)(mem->base + mem->size));
+
+		else
+			SYSMEM_E("\"%s\" (0x%08lx - 0x%08lx) alloc is "
+				 "overlap with existence \"%s\" (0x%08lx - "
+				 "0x%08lx)\n",
+				 name, (ulong)base, (ulong)(base + size),
+				 mem->attr.name, (ulong)mem->base,
+				 (ulong)(mem->base + mem->size));
+		goto out;
 	}
 
 	/* Add overflow check magic ? */
@@ -519,6 +516,7 @@ static void *sysmem_alloc_align_base(enum memblk_id id,
 			mem->attr = attr;
 			sysmem->allocated_cnt++;
 			list_add_tail(&mem->node, &sysmem->allocated_head);
+			memblk_tree_insert(&sysmem->allocated_tree, mem);
 
 			/* Add overflow check magic */
 			if (mem->attr.flags & F_OFC) {
@@ -684,12 +682,17 @@ int sysmem_free(phys_addr_t base)
 	if (!sysmem_has_init())
 		return -ENOSYS;
 
-	/* Find existence */
-	list_for_each(node, &sysmem->allocated_head) {
-		mem = list_entry(node, struct memblock, node);
-		if (mem->base == base || mem->orig_base == base) {
-			found = 1;
-			break;
+	/* Find existence, by the original base only if it was moved */
+	mem = memblk_tree_find_base(&sysmem->allocated_tree, base);
+	if (mem) {
+		found = 1;
+	} else {
+		list_for_each(node, &sysmem->allocated_head) {
+			mem = list_entry(node, struct memblock, node);
+			if (mem->orig_base == base) {
+				found = 1;
+				break;
+			}
 		}
 	}
 
@@ -706,6 +709,7 @@ int sysmem_free(phys_addr_t base)
 			 (ulong)(mem->base + mem->size));
 		sysmem->allocated_cnt--;
 		list_del(&mem->node);
+		memblk_tree_erase(&sysmem->allocated_tree, mem);
 		free(mem);
 	} else {
 		SYSMEM_E("Failed to free \"%s\" at 0x%08lx\n",
@@ -729,6 +733,7 @@ int sysmem_init(void)
 
 	lmb_init(&sysmem->lmb);
 	INIT_LIST_HEAD(&sysmem->allocated_head);
+	sysmem->allocated_tree = MEMBLK_TREE_INIT;
 	INIT_LIST_HEAD(&sysmem->kmem_resv_head);
 	sysmem->allocated_cnt = 0;
 	sysmem->kmem_resv_cnt = 0;
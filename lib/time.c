@@ -6,6 +6,7 @@
  */
 
 #include <common.h>
+#include <console.h>
 #include <dm.h>
 #include <errno.h>
 #include <timer.h>
@@ -167,6 +168,12 @@ void udelay(unsigned long usec)
 	do {
 		WATCHDOG_RESET();
 		kv = usec > CONFIG_WD_PERIOD ? CONFIG_WD_PERIOD : usec;
+#if CONFIG_IS_ENABLED(CONSOLE_TX_BUFFER)
+		/* Keep the UART busy with the buffered output while we wait */
+		console_tx_poll();
+		if (kv > CONFIG_CONSOLE_TX_POLL_US)
+			kv = CONFIG_CONSOLE_TX_POLL_US;
+#endif
 		__udelay (kv);
 		usec -= kv;
 	} while(usec);
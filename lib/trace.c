@@ -37,10 +37,51 @@ struct trace_hdr {
 	int depth;
 	int depth_limit;
 	int max_depth;
+
+	/* Calls are only recorded for functions in [filter_lo, filter_hi) */
+	uintptr_t filter_lo;
+	uintptr_t filter_hi;
+#ifdef CONFIG_TRACE_RING
+	ulong ftrace_pos;	/* Next record, the oldest once it wrapped */
+#endif
 };
 
 static struct trace_hdr *hdr;	/* Pointer to start of trace buffer */
 
+#ifdef CONFIG_ARM64
+/* 2^32 * 1000000 / timer frequency */
+static u64 trace_us_mult __attribute__((section(".data")));
+
+static void __attribute__((no_instrument_function)) trace_timer_init(void)
+{
+	ulong freq = get_tbclk();
+
+	trace_us_mult = freq ? ((u64)1000000 << 32) / freq : 0;
+}
+
+/*
+ * Read the generic timer directly: timer_get_us() takes a few calls, which
+ * are instrumented themselves, so tracing them would double the records.
+ */
+static inline ulong __attribute__((no_instrument_function))
+		trace_timestamp(void)
+{
+	u64 cnt;
+
+	asm volatile("mrs %0, cntvct_el0" : "=r" (cnt));
+
+	return ((unsigned __int128)cnt * trace_us_mult) >> 32;
+}
+#else
+static inline void trace_timer_init(void) {}
+
+static inline ulong __attribute__((no_instrument_function))
+		trace_timestamp(void)
+{
+	return timer_get_us();
+}
+#endif
+
 static inline uintptr_t __attribute__((no_instrument_function))
 		func_ptr_to_num(void *func_ptr)
 {
@@ -60,17 +101,30 @@ static inline uintptr_t __attribute__((no_instrument_function))
 static void __attribute__((no_instrument_function)) add_ftrace(void *func_ptr,
 				void *caller, ulong flags)
 {
+	uintptr_t func = func_ptr_to_num(func_ptr);
+	struct trace_call *rec;
+
 	if (hdr->depth > hdr->depth_limit) {
 		hdr->ftrace_too_deep_count++;
 		return;
 	}
-	if (hdr->ftrace_count < hdr->ftrace_size) {
-		struct trace_call *rec = &hdr->ftrace[hdr->ftrace_count];
-
-		rec->func = func_ptr_to_num(func_ptr);
-		rec->caller = func_ptr_to_num(caller);
-		rec->flags = flags | (timer_get_us() & FUNCF_TIMESTAMP_MASK);
+	if (hdr->filter_hi && (func < hdr->filter_lo || func >= hdr->filter_hi))
+		return;
+#ifdef CONFIG_TRACE_RING
+	/* Record 0 keeps the text base, the rest wraps around */
+	rec = &hdr->ftrace[hdr->ftrace_pos];
+	if (++hdr->ftrace_pos >= hdr->ftrace_size)
+		hdr->ftrace_pos = 1;
+#else
+	if (hdr->ftrace_count >= hdr->ftrace_size) {
+		hdr->ftrace_count++;
+		return;
 	}
+	rec = &hdr->ftrace[hdr->ftrace_count];
+#endif
+	rec->func = func;
+	rec->caller = func_ptr_to_num(caller);
+	rec->flags = flags | (trace_timestamp() & FUNCF_TIMESTAMP_MASK);
 	hdr->ftrace_count++;
 }
 
@@ -84,6 +138,30 @@ static void __attribute__((no_instrument_function)) add_textbase(void)
 		rec->flags = FUNCF_TEXTBASE;
 	}
 	hdr->ftrace_count++;
+#ifdef CONFIG_TRACE_RING
+	/* The ring starts over, behind the text base in record 0 */
+	if (hdr->ftrace_size) {
+		hdr->ftrace[0].func = CONFIG_SYS_TEXT_BASE;
+		hdr->ftrace[0].caller = 0;
+		hdr->ftrace[0].flags = FUNCF_TEXTBASE;
+		hdr->ftrace_count = 1;
+	}
+	hdr->ftrace_pos = 1;
+#endif
+}
+
+/* The n-th call record, counting from the oldest */
+static struct trace_call *trace_get_call(ulong rec)
+{
+#ifdef CONFIG_TRACE_RING
+	/* Once wrapped, the oldest is the next to be written */
+	if (rec && hdr->ftrace_count > hdr->ftrace_size) {
+		rec += hdr->ftrace_pos - 1;
+		if (rec >= hdr->ftrace_size)
+			rec -= hdr->ftrace_size - 1;
+	}
+#endif
+	return &hdr->ftrace[rec];
 }
 
 /**
@@ -208,7 +286,7 @@ int trace_list_calls(void *buff, int buff_size, unsigned *needed)
 		count = hdr->ftrace_size;
 	for (rec = upto = 0; rec < count; rec++) {
 		if (ptr + sizeof(struct trace_call) < end) {
-			struct trace_call *call = &hdr->ftrace[rec];
+			struct trace_call *call = trace_get_call(rec);
 			struct trace_call *out = ptr;
 
 			out->func = call->func * FUNC_SITE_SIZE;
@@ -232,6 +310,52 @@ int trace_list_calls(void *buff, int buff_size, unsigned *needed)
 	return 0;
 }
 
+int trace_list_chrome(void *buff, int buff_size, unsigned int *needed)
+{
+	char *ptr = buff, *end = buff ? buff + buff_size : NULL;
+	char line[96];
+	ulong rec, count, stamp, prev = 0;
+	u64 ts = 0;
+	int len;
+
+	/* Record 0 is the text base, not a call */
+	count = min(hdr->ftrace_count, hdr->ftrace_size);
+	for (rec = 0; rec <= count; rec++) {
+		struct trace_call *call;
+
+		if (!rec) {
+			len = snprintf(line, sizeof(line), "{\"traceEvents\":[");
+		} else if (rec == count) {
+			len = snprintf(line, sizeof(line), "\n]}\n");
+		} else {
+			call = trace_get_call(rec);
+			stamp = call->flags & FUNCF_TIMESTAMP_MASK;
+			/* Timestamps are 30 bits of microseconds, unwrap them */
+			if (rec > 1)
+				ts += (stamp - prev) & FUNCF_TIMESTAMP_MASK;
+			prev = stamp;
+			/* Link addresses, for System.map or addr2line */
+			len = snprintf(line, sizeof(line),
+				       "%s\n{\"name\":\"0x%08lx\",\"ph\":\"%c\",\"ts\":%llu,\"pid\":0,\"tid\":0}",
+				       rec > 1 ? "," : "",
+				       (ulong)CONFIG_SYS_TEXT_BASE +
+				       call->func * FUNC_SITE_SIZE,
+				       TRACE_CALL_TYPE(call) == FUNCF_ENTRY ?
+				       'B' : 'E', ts);
+		}
+		if (ptr + len < end)
+			memcpy(ptr, line, len);
+		ptr += len;
+	}
+
+	/* Work out how must of the buffer we used */
+	*needed = ptr - (char *)buff;
+	if (ptr >= end)
+		return -1;
+	*ptr = '\0';
+	return 0;
+}
+
 /* Print basic information about tracing */
 void trace_print_stats(void)
 {
@@ -255,8 +379,13 @@ void trace_print_stats(void)
 	print_grouped_ull(count, 10);
 	puts(" traced function calls");
 	if (hdr->ftrace_count > hdr->ftrace_size) {
+#ifdef CONFIG_TRACE_RING
+		printf(" (%lu older ones overwritten)",
+		       hdr->ftrace_count - hdr->ftrace_size);
+#else
 		printf(" (%lu dropped due to overflow)",
 		       hdr->ftrace_count - hdr->ftrace_size);
+#endif
 	}
 	puts("\n");
 	printf("%15d maximum observed call depth\n", hdr->max_depth);
@@ -270,6 +399,26 @@ void __attribute__((no_instrument_function)) trace_set_enabled(int enabled)
 	trace_enabled = enabled != 0;
 }
 
+int trace_set_filter(ulong start, ulong end)
+{
+	if (!trace_inited)
+		return -1;
+	if (start >= end) {
+		hdr->filter_lo = 0;
+		hdr->filter_hi = 0;
+		return 0;
+	}
+	if (start < CONFIG_SYS_TEXT_BASE)
+		return -1;
+
+	/* As System.map gives them, before relocation */
+	hdr->filter_lo = (start - CONFIG_SYS_TEXT_BASE) / FUNC_SITE_SIZE;
+	hdr->filter_hi = DIV_ROUND_UP(end - CONFIG_SYS_TEXT_BASE,
+				      FUNC_SITE_SIZE);
+
+	return 0;
+}
+
 /**
  * Init the tracing system ready for used, and enable it
  *
@@ -316,6 +465,7 @@ int __attribute__((no_instrument_function)) trace_init(void *buff,
 
 	if (was_disabled)
 		memset(hdr, '\0', needed);
+	trace_timer_init();
 	hdr->func_count = func_count;
 	hdr->call_accum = (uintptr_t *)(hdr + 1);
 
@@ -351,6 +501,7 @@ int __attribute__((no_instrument_function)) trace_early_init(void)
 	}
 
 	memset(hdr, '\0', needed);
+	trace_timer_init();
 	hdr->call_accum = (uintptr_t *)(hdr + 1);
 	hdr->func_count = func_count;
 
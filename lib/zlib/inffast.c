@@ -66,7 +66,11 @@
       requires strm->avail_out >= 258 for each loop to avoid checking for
       output space.
  */
+#if CONFIG_IS_ENABLED(ZLIB_INFLATE_ARM64)
+local void inflate_fast_generic(z_streamp strm, unsigned start)
+#else
 void inflate_fast(z_streamp strm, unsigned start)
+#endif
 /* start: inflate()'s starting value for strm->avail_out */
 {
     struct inflate_state FAR *state;
@@ -353,4 +357,284 @@ void inflate_fast(z_streamp strm, unsigned start)
    - Moving len -= 3 statement into middle of loop
  */
 
+#if CONFIG_IS_ENABLED(ZLIB_INFLATE_ARM64)
+/*
+   AArch64 variant of inflate_fast(), as in Chromium's inffast_chunk.c:
+
+    - The bit accumulator is 64 bits wide and refilled with one unaligned
+      8 byte load per code, which leaves at least 56 bits: enough for the
+      longest length/distance pair (48 bits) without another check. So it
+      needs 8 bytes of input left instead of 6.
+
+    - Matches in the output are copied 16 bytes at a time with NEON loads
+      and stores when the distance allows it, 8 bytes at a time otherwise,
+      a short distance being widened to a multiple of itself first. The
+      last chunk may write up to 15 bytes past the match, which are written
+      again later, so it needs 258 + 15 bytes of output space.
+
+   -mstrict-align keeps the compiler from emitting unaligned accesses, so
+   these are done with inline assembly, and only while the data cache is
+   on: unaligned accesses fault on Device memory, i.e. with the MMU off.
+ */
+#define INFLATE_CHUNK_IN	8
+#define INFLATE_CHUNK_OUT	(258 + 15)
+
+static inline unsigned long inflate_load64(const unsigned char *p)
+{
+    unsigned long v;
+
+    __asm__("ldr %0, [%1]" : "=r"(v) : "r"(p), "m"(*(const char (*)[8])p));
+    return v;
+}
+
+static inline void inflate_copy8(unsigned char *out, const unsigned char *from)
+{
+    unsigned long v;
+
+    __asm__ __volatile__("ldr %0, [%1]\n\tstr %0, [%2]"
+                         : "=&r"(v) : "r"(from), "r"(out) : "memory");
+}
+
+static inline void inflate_copy16(unsigned char *out,
+                                  const unsigned char *from)
+{
+    __asm__ __volatile__("ldr q16, [%0]\n\tstr q16, [%1]"
+                         : : "r"(from), "r"(out) : "v16", "memory");
+}
+
+/* Copy len (> 0) bytes from dist back, writing up to 15 more */
+static inline unsigned char *inflate_chunk_copy(unsigned char *out,
+                                                unsigned dist, unsigned len)
+{
+    unsigned char *end = out + len;
+    const unsigned char *from = out - dist;
+    unsigned wide, i;
+
+    if (dist >= 16) {
+        do {
+            inflate_copy16(out, from);
+            out += 16;
+            from += 16;
+        } while (out < end);
+        return end;
+    }
+
+    if (dist < 8) {
+        /* Lay the pattern out once, it repeats every multiple of dist */
+        wide = dist;
+        while (wide < 8)
+            wide += dist;
+        for (i = 0; i < wide && out < end; i++)
+            *out++ = *from++;
+        from = out - wide;
+    }
+    while (out < end) {
+        inflate_copy8(out, from);
+        out += 8;
+        from += 8;
+    }
+    return end;
+}
+
+local void inflate_fast_chunk(z_streamp strm, unsigned start)
+{
+    struct inflate_state FAR *state;
+    unsigned char FAR *in;      /* local strm->next_in */
+    unsigned char FAR *last;    /* while in < last, enough input available */
+    unsigned char FAR *out;     /* local strm->next_out */
+    unsigned char FAR *beg;     /* inflate()'s initial strm->next_out */
+    unsigned char FAR *end;     /* while out < end, enough space available */
+#ifdef INFLATE_STRICT
+    unsigned dmax;              /* maximum distance from zlib header */
+#endif
+    unsigned wsize;             /* window size or zero if not using window */
+    unsigned whave;             /* valid bytes in the window */
+    unsigned write;             /* window write index */
+    unsigned char FAR *window;  /* allocated sliding window, if wsize != 0 */
+    unsigned long hold;         /* local strm->hold, 64 bits */
+    unsigned bits;              /* local strm->bits */
+    code const FAR *lcode;      /* local strm->lencode */
+    code const FAR *dcode;      /* local strm->distcode */
+    unsigned lmask;             /* mask for first level of length codes */
+    unsigned dmask;             /* mask for first level of distance codes */
+    code this;                  /* retrieved table entry */
+    unsigned op;                /* code bits, operation, extra bits, or */
+                                /*  window position, window bytes to copy */
+    unsigned len;               /* match length, unused bytes */
+    unsigned dist;              /* match distance */
+    unsigned char FAR *from;    /* where to copy match from */
+
+    /* copy state to local variables */
+    state = (struct inflate_state FAR *)strm->state;
+    in = strm->next_in;
+    last = in + (strm->avail_in - (INFLATE_CHUNK_IN - 1));
+    if (in > last) {
+        /* as in inflate_fast(), for avail_in past the top of memory */
+        strm->avail_in = 0xffffffff - (uintptr_t)in;
+        last = in + (strm->avail_in - (INFLATE_CHUNK_IN - 1));
+    }
+    out = strm->next_out;
+    beg = out - (start - strm->avail_out);
+    end = out + (strm->avail_out - (INFLATE_CHUNK_OUT - 1));
+#ifdef INFLATE_STRICT
+    dmax = state->dmax;
+#endif
+    wsize = state->wsize;
+    whave = state->whave;
+    write = state->write;
+    window = state->window;
+    hold = state->hold;
+    bits = state->bits;
+    lcode = state->lencode;
+    dcode = state->distcode;
+    lmask = (1U << state->lenbits) - 1;
+    dmask = (1U << state->distbits) - 1;
+
+    /* decode literals and length/distances until end-of-block or not enough
+       input data or output space */
+    do {
+        /* 56 to 63 bits, whole bytes only being taken from in */
+        hold |= inflate_load64(in) << bits;
+        in += (63 - bits) >> 3;
+        bits |= 56;
+
+        this = lcode[hold & lmask];
+      dolen:
+        op = (unsigned)(this.bits);
+        hold >>= op;
+        bits -= op;
+        op = (unsigned)(this.op);
+        if (op == 0) {                          /* literal */
+            Tracevv((stderr, this.val >= 0x20 && this.val < 0x7f ?
+                    "inflate:         literal '%c'\n" :
+                    "inflate:         literal 0x%02x\n", this.val));
+            *out++ = (unsigned char)(this.val);
+        }
+        else if (op & 16) {                     /* length base */
+            len = (unsigned)(this.val);
+            op &= 15;                           /* number of extra bits */
+            len += (unsigned)hold & ((1U << op) - 1);
+            hold >>= op;
+            bits -= op;
+            Tracevv((stderr, "inflate:         length %u\n", len));
+            this = dcode[hold & dmask];
+          dodist:
+            op = (unsigned)(this.bits);
+            hold >>= op;
+            bits -= op;
+            op = (unsigned)(this.op);
+            if (op & 16) {                      /* distance base */
+                dist = (unsigned)(this.val);
+                op &= 15;                       /* number of extra bits */
+                dist += (unsigned)hold & ((1U << op) - 1);
+#ifdef INFLATE_STRICT
+                if (dist > dmax) {
+                    strm->msg = (char *)"invalid distance too far back";
+                    state->mode = BAD;
+                    break;
+                }
+#endif
+                hold >>= op;
+                bits -= op;
+                Tracevv((stderr, "inflate:         distance %u\n", dist));
+                op = (unsigned)(out - beg);     /* max distance in output */
+                if (dist <= op) {               /* copy direct from output */
+                    out = inflate_chunk_copy(out, dist, len);
+                    continue;
+                }
+
+                /* some from the window, byte by byte as it is rare */
+                op = dist - op;                 /* distance back in window */
+                if (op > whave) {
+                    strm->msg = (char *)"invalid distance too far back";
+                    state->mode = BAD;
+                    break;
+                }
+                from = window;
+                if (write == 0) {               /* very common case */
+                    from += wsize - op;
+                }
+                else if (write < op) {          /* wrap around window */
+                    from += wsize + write - op;
+                    op -= write;
+                    if (op < len) {             /* some from end of window */
+                        len -= op;
+                        do {
+                            *out++ = *from++;
+                        } while (--op);
+                        from = window;
+                        op = write;
+                    }
+                }
+                else {                          /* contiguous in window */
+                    from += write - op;
+                }
+                if (op < len) {                 /* some from window */
+                    len -= op;
+                    do {
+                        *out++ = *from++;
+                    } while (--op);
+                    out = inflate_chunk_copy(out, dist, len);
+                }
+                else {
+                    do {
+                        *out++ = *from++;
+                    } while (--len);
+                }
+            }
+            else if ((op & 64) == 0) {          /* 2nd level distance code */
+                this = dcode[this.val + (hold & ((1U << op) - 1))];
+                goto dodist;
+            }
+            else {
+                strm->msg = (char *)"invalid distance code";
+                state->mode = BAD;
+                break;
+            }
+        }
+        else if ((op & 64) == 0) {              /* 2nd level length code */
+            this = lcode[this.val + (hold & ((1U << op) - 1))];
+            goto dolen;
+        }
+        else if (op & 32) {                     /* end-of-block */
+            Tracevv((stderr, "inflate:         end of block\n"));
+            state->mode = TYPE;
+            break;
+        }
+        else {
+            strm->msg = (char *)"invalid literal/length code";
+            state->mode = BAD;
+            break;
+        }
+    } while (in < last && out < end);
+
+    /* return unused bytes */
+    len = bits >> 3;
+    in -= len;
+    bits -= len << 3;
+    hold &= (1UL << bits) - 1;
+
+    /* update state and return */
+    strm->next_in = in;
+    strm->next_out = out;
+    strm->avail_in = (unsigned)(in < last ?
+        (INFLATE_CHUNK_IN - 1) + (last - in) :
+        (INFLATE_CHUNK_IN - 1) - (in - last));
+    strm->avail_out = (unsigned)(out < end ?
+        (INFLATE_CHUNK_OUT - 1) + (end - out) :
+        (INFLATE_CHUNK_OUT - 1) - (out - end));
+    state->hold = hold;
+    state->bits = bits;
+}
+
+void inflate_fast(z_streamp strm, unsigned start)
+{
+    if (strm->avail_in >= INFLATE_CHUNK_IN &&
+        strm->avail_out >= INFLATE_CHUNK_OUT && dcache_status())
+        inflate_fast_chunk(strm, start);
+    else
+        inflate_fast_generic(strm, start);
+}
+#endif /* ZLIB_INFLATE_ARM64 */
+
 #endif /* !ASMINF */
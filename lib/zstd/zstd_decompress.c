@@ -0,0 +1,1079 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Copyright (c) 2024 Rockchip Electronics Co., Ltd
+ *
+ * Zstandard decoder for whole frames in memory, see RFC 8878. The output
+ * is one flat buffer, so matches are copied from what is already there and
+ * no window is kept. Dictionaries are not supported.
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <asm/unaligned.h>
+#include <u-boot/zstd.h>
+
+#define ZSTD_BLOCK_MAX		(128 * 1024)
+
+#define ZSTD_BLOCK_RAW		0
+#define ZSTD_BLOCK_RLE		1
+#define ZSTD_BLOCK_COMPRESSED	2
+
+#define ZSTD_LIT_RAW		0
+#define ZSTD_LIT_RLE		1
+#define ZSTD_LIT_COMPRESSED	2
+#define ZSTD_LIT_TREELESS	3
+
+#define ZSTD_SEQ_PREDEFINED	0
+#define ZSTD_SEQ_RLE		1
+#define ZSTD_SEQ_COMPRESSED	2
+#define ZSTD_SEQ_REPEAT		3
+
+#define ZSTD_HUF_LOG_MAX	11
+#define ZSTD_HUF_WEIGHT_LOG_MAX	6
+#define ZSTD_LL_LOG_MAX		9
+#define ZSTD_ML_LOG_MAX		9
+#define ZSTD_OF_LOG_MAX		8
+#define ZSTD_LL_MAX		35
+#define ZSTD_ML_MAX		52
+#define ZSTD_OF_MAX		31
+#define ZSTD_FSE_SYMS		64
+
+struct zstd_huf {
+	u8 sym;
+	u8 nbits;
+};
+
+struct zstd_fse {
+	u16 base;	/* next state, less the bits read */
+	u8 sym;
+	u8 nbits;
+};
+
+struct zstd_seq_table {
+	struct zstd_fse *dt;
+	unsigned int log;
+	bool valid;	/* for ZSTD_SEQ_REPEAT */
+};
+
+struct zstd_ctx {
+	struct zstd_huf huf[1 << ZSTD_HUF_LOG_MAX];
+	unsigned int huf_log;	/* 0 until a block has a Huffman tree */
+	struct zstd_fse ll_dt[1 << ZSTD_LL_LOG_MAX];
+	struct zstd_fse ml_dt[1 << ZSTD_ML_LOG_MAX];
+	struct zstd_fse of_dt[1 << ZSTD_OF_LOG_MAX];
+	struct zstd_seq_table ll, ml, of;
+	u32 rep[3];
+	u8 lits[ZSTD_BLOCK_MAX];
+};
+
+/* Backward bitstream, read from its end, the first bit being marked */
+struct zstd_bits {
+	const u8 *start;
+	const u8 *ptr;
+	u64 bits;
+	unsigned int used;	/* from the top of @bits */
+};
+
+static const s16 zstd_ll_default[ZSTD_LL_MAX + 1] = {
+	4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1,
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1,
+	-1, -1, -1, -1
+};
+
+static const s16 zstd_ml_default[ZSTD_ML_MAX + 1] = {
+	1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1,
+	-1, -1, -1, -1, -1
+};
+
+static const s16 zstd_of_default[] = {
+	1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1
+};
+
+static const u32 zstd_ll_base[ZSTD_LL_MAX + 1] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+	16, 18, 20, 22, 24, 28, 32, 40, 48, 64, 128, 256, 512, 1024, 2048, 4096,
+	8192, 16384, 32768, 65536
+};
+
+static const u8 zstd_ll_bits[ZSTD_LL_MAX + 1] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 2, 2, 3, 3, 4, 6, 7, 8, 9, 10, 11, 12,
+	13, 14, 15, 16
+};
+
+static const u32 zstd_ml_base[ZSTD_ML_MAX + 1] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18,
+	19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34,
+	35, 37, 39, 41, 43, 47, 51, 59, 67, 83, 99, 131, 259, 515, 1027, 2051,
+	4099, 8195, 16387, 32771, 65539
+};
+
+static const u8 zstd_ml_bits[ZSTD_ML_MAX + 1] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1, 1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 7, 8, 9, 10, 11,
+	12, 13, 14, 15, 16
+};
+
+static inline unsigned int zstd_highbit(u32 v)
+{
+	return 31 - __builtin_clz(v);
+}
+
+static int zstd_bits_init(struct zstd_bits *b, const u8 *src, size_t len)
+{
+	size_t i;
+	u8 last;
+
+	if (!len || !src[len - 1])
+		return -EPROTO;
+
+	last = src[len - 1];
+	b->start = src;
+	if (len >= sizeof(u64)) {
+		b->ptr = src + len - sizeof(u64);
+		b->bits = get_unaligned_le64(b->ptr);
+		b->used = 0;
+	} else {
+		b->ptr = src;
+		b->bits = 0;
+		for (i = 0; i < len; i++)
+			b->bits |= (u64)src[i] << (8 * i);
+		b->used = (sizeof(u64) - len) * 8;
+	}
+	/* The padding and the start marker */
+	b->used += 8 - zstd_highbit(last);
+
+	return 0;
+}
+
+/* Past the start there are zeroes, caught by zstd_bits_done() after */
+static inline u64 zstd_bits_peek(struct zstd_bits *b, unsigned int n)
+{
+	return b->bits << (b->used & 63) >> 1 >> (63 - n);
+}
+
+static inline u64 zstd_bits_read(struct zstd_bits *b, unsigned int n)
+{
+	u64 v = zstd_bits_peek(b, n);
+
+	b->used += n;
+
+	return v;
+}
+
+/* Refill to at least 57 bits unless at the start, false once past it */
+static inline bool zstd_bits_reload(struct zstd_bits *b)
+{
+	size_t n;
+
+	if (b->used > 64)
+		return false;
+
+	n = min_t(size_t, b->used >> 3, b->ptr - b->start);
+	if (n) {
+		b->ptr -= n;
+		b->used -= n * 8;
+		b->bits = get_unaligned_le64(b->ptr);
+	}
+
+	return true;
+}
+
+static inline bool zstd_bits_done(struct zstd_bits *b)
+{
+	return b->ptr == b->start && b->used == 64;
+}
+
+static u32 zstd_fwd_bits(const u8 *src, size_t len, size_t pos,
+			 unsigned int n)
+{
+	size_t i = pos >> 3;
+	u32 v = 0;
+	int k;
+
+	/* Up to 25 bits, from at most 4 bytes; zeroes past the end */
+	for (k = 0; k < 4 && i + k < len; k++)
+		v |= (u32)src[i + k] << (8 * k);
+
+	return (v >> (pos & 7)) & ((1u << n) - 1);
+}
+
+static int zstd_fse_build(struct zstd_fse *dt, const s16 *norm,
+			  unsigned int nsym, unsigned int log)
+{
+	u16 next[ZSTD_FSE_SYMS];
+	u32 size = 1 << log, high = size - 1;
+	u32 step = (size >> 1) + (size >> 3) + 3;
+	u32 pos = 0, s, u, ns;
+	int i;
+
+	for (s = 0; s < nsym; s++) {
+		if (norm[s] == -1) {
+			dt[high--].sym = s;
+			next[s] = 1;
+		} else {
+			next[s] = norm[s];
+		}
+	}
+
+	for (s = 0; s < nsym; s++) {
+		for (i = 0; i < norm[s]; i++) {
+			dt[pos].sym = s;
+			do {
+				pos = (pos + step) & (size - 1);
+			} while (pos > high);
+		}
+	}
+	if (pos)
+		return -EPROTO;
+
+	for (u = 0; u < size; u++) {
+		ns = next[dt[u].sym]++;
+		dt[u].nbits = log - zstd_highbit(ns);
+		dt[u].base = (ns << dt[u].nbits) - size;
+	}
+
+	return 0;
+}
+
+static void zstd_fse_rle(struct zstd_fse *dt, u8 sym)
+{
+	dt[0].sym = sym;
+	dt[0].nbits = 0;
+	dt[0].base = 0;
+}
+
+/* Read an FSE table description, returns the bytes it takes */
+static int zstd_fse_read(struct zstd_fse *dt, unsigned int *logp,
+			 unsigned int max_log, unsigned int max_sym,
+			 const u8 *src, size_t len)
+{
+	s16 norm[ZSTD_FSE_SYMS];
+	int remaining, threshold, max, count;
+	unsigned int log, nbits, sym = 0, rep, i;
+	size_t pos = 4, used;
+	int ret;
+
+	if (!len)
+		return -EPROTO;
+
+	log = (src[0] & 0xf) + 5;
+	if (log > max_log)
+		return -EPROTO;
+
+	remaining = (1 << log) + 1;
+	threshold = 1 << log;
+	nbits = log + 1;
+	while (remaining > 1 && sym <= max_sym) {
+		max = 2 * threshold - 1 - remaining;
+		count = zstd_fwd_bits(src, len, pos, nbits - 1);
+		if (count < max) {
+			pos += nbits - 1;
+		} else {
+			count = zstd_fwd_bits(src, len, pos, nbits);
+			if (count >= threshold)
+				count -= max;
+			pos += nbits;
+		}
+
+		/* Probabilities are coded plus one, -1 for "less than 1" */
+		count--;
+		remaining -= count < 0 ? -count : count;
+		norm[sym++] = count;
+		if (!count) {
+			do {
+				rep = zstd_fwd_bits(src, len, pos, 2);
+				pos += 2;
+				for (i = 0; i < rep; i++) {
+					if (sym > max_sym)
+						return -EPROTO;
+					norm[sym++] = 0;
+				}
+			} while (rep == 3);
+		}
+
+		while (remaining < threshold) {
+			nbits--;
+			threshold >>= 1;
+		}
+	}
+
+	used = (pos + 7) >> 3;
+	if (remaining != 1 || used > len)
+		return -EPROTO;
+
+	ret = zstd_fse_build(dt, norm, sym, log);
+	if (ret)
+		return ret;
+	*logp = log;
+
+	return used;
+}
+
+/* Read a Huffman tree description, returns the bytes it takes */
+static int zstd_huf_read(struct zstd_ctx *zc, const u8 *src, size_t len)
+{
+	struct zstd_fse dt[1 << ZSTD_HUF_WEIGHT_LOG_MAX];
+	struct zstd_bits b;
+	u32 start[ZSTD_HUF_LOG_MAX + 2] = { 0 };
+	u8 w[256];
+	unsigned int n = 0, i, j, log, s1, s2;
+	u32 sum = 0, left, pos;
+	size_t used;
+	int ret;
+
+	if (!len)
+		return -EPROTO;
+
+	if (src[0] >= 128) {
+		/* Weights as 4 bits each */
+		n = src[0] - 127;
+		used = 1 + (n + 1) / 2;
+		if (used > len)
+			return -EPROTO;
+		for (i = 0; i < n; i++)
+			w[i] = i & 1 ? src[1 + i / 2] & 0xf : src[1 + i / 2] >> 4;
+	} else {
+		/* Weights FSE coded, with two interleaved states */
+		used = 1 + src[0];
+		if (src[0] == 0 || used > len)
+			return -EPROTO;
+		ret = zstd_fse_read(dt, &log, ZSTD_HUF_WEIGHT_LOG_MAX,
+				    ZSTD_HUF_LOG_MAX, src + 1, src[0]);
+		if (ret < 0)
+			return ret;
+		if (zstd_bits_init(&b, src + 1 + ret, src[0] - ret))
+			return -EPROTO;
+
+		s1 = zstd_bits_read(&b, log);
+		s2 = zstd_bits_read(&b, log);
+		zstd_bits_reload(&b);
+		for (;;) {
+			if (n > 252)
+				return -EPROTO;
+			w[n++] = dt[s1].sym;
+			s1 = dt[s1].base + zstd_bits_read(&b, dt[s1].nbits);
+			if (!zstd_bits_reload(&b)) {
+				w[n++] = dt[s2].sym;
+				break;
+			}
+			w[n++] = dt[s2].sym;
+			s2 = dt[s2].base + zstd_bits_read(&b, dt[s2].nbits);
+			if (!zstd_bits_reload(&b)) {
+				w[n++] = dt[s1].sym;
+				break;
+			}
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		if (w[i] > ZSTD_HUF_LOG_MAX)
+			return -EPROTO;
+		if (w[i])
+			sum += 1 << (w[i] - 1);
+	}
+	if (!sum)
+		return -EPROTO;
+
+	/* The last weight is implied, making the sum a power of 2 */
+	log = zstd_highbit(sum) + 1;
+	left = (1 << log) - sum;
+	if (log > ZSTD_HUF_LOG_MAX || (left & (left - 1)))
+		return -EPROTO;
+	w[n++] = zstd_highbit(left) + 1;
+
+	/* Codes by weight then symbol, longest first */
+	for (i = 0; i < n; i++)
+		if (w[i])
+			start[w[i]] += 1 << (w[i] - 1);
+	for (i = 1, pos = 0; i <= log; i++) {
+		u32 cnt = start[i];
+
+		start[i] = pos;
+		pos += cnt;
+	}
+	for (i = 0; i < n; i++) {
+		if (!w[i])
+			continue;
+		for (j = 0; j < 1 << (w[i] - 1); j++) {
+			zc->huf[start[w[i]] + j].sym = i;
+			zc->huf[start[w[i]] + j].nbits = log + 1 - w[i];
+		}
+		start[w[i]] += 1 << (w[i] - 1);
+	}
+	zc->huf_log = log;
+
+	return used;
+}
+
+static int zstd_huf_stream(struct zstd_ctx *zc, const u8 *src, size_t len,
+			   u8 *out, size_t n)
+{
+	const struct zstd_huf *h;
+	const unsigned int log = zc->huf_log;
+	struct zstd_bits b;
+	u8 *end = out + n;
+
+	if (zstd_bits_init(&b, src, len))
+		return -EPROTO;
+
+	/* 4 codes of up to 11 bits per reload */
+	while (end - out >= 4) {
+		zstd_bits_reload(&b);
+		h = &zc->huf[zstd_bits_peek(&b, log)];
+		*out++ = h->sym;
+		b.used += h->nbits;
+		h = &zc->huf[zstd_bits_peek(&b, log)];
+		*out++ = h->sym;
+		b.used += h->nbits;
+		h = &zc->huf[zstd_bits_peek(&b, log)];
+		*out++ = h->sym;
+		b.used += h->nbits;
+		h = &zc->huf[zstd_bits_peek(&b, log)];
+		*out++ = h->sym;
+		b.used += h->nbits;
+	}
+	zstd_bits_reload(&b);
+	while (out < end) {
+		h = &zc->huf[zstd_bits_peek(&b, log)];
+		*out++ = h->sym;
+		b.used += h->nbits;
+	}
+	zstd_bits_reload(&b);
+
+	return zstd_bits_done(&b) ? 0 : -EPROTO;
+}
+
+static int zstd_huf_decode(struct zstd_ctx *zc, const u8 *src, size_t len,
+			   u8 *out, size_t n, bool four)
+{
+	size_t s[4], seg;
+	int i, ret;
+
+	if (!four)
+		return zstd_huf_stream(zc, src, len, out, n);
+
+	/* A jump table of the first three stream sizes */
+	if (len < 6)
+		return -EPROTO;
+	s[0] = get_unaligned_le16(src);
+	s[1] = get_unaligned_le16(src + 2);
+	s[2] = get_unaligned_le16(src + 4);
+	src += 6;
+	len -= 6;
+	if (s[0] + s[1] + s[2] > len)
+		return -EPROTO;
+	s[3] = len - s[0] - s[1] - s[2];
+
+	seg = (n + 3) / 4;
+	if (seg * 3 > n)
+		return -EPROTO;
+	for (i = 0; i < 4; i++) {
+		ret = zstd_huf_stream(zc, src, s[i], out,
+				      i < 3 ? seg : n - 3 * seg);
+		if (ret)
+			return ret;
+		src += s[i];
+		out += seg;
+	}
+
+	return 0;
+}
+
+/* Decode the literals section, returns the bytes it takes */
+static int zstd_literals(struct zstd_ctx *zc, const u8 *src, size_t len,
+			 const u8 **lits, size_t *nlits)
+{
+	unsigned int type = src[0] & 3, format = (src[0] >> 2) & 3;
+	size_t hs, size, csize;
+	bool four = true;
+	int ret;
+
+	if (type == ZSTD_LIT_RAW || type == ZSTD_LIT_RLE) {
+		hs = format == 1 ? 2 : format == 3 ? 3 : 1;
+		if (hs > len)
+			return -EPROTO;
+		if (format == 1)
+			size = (src[0] >> 4) + (src[1] << 4);
+		else if (format == 3)
+			size = (src[0] >> 4) + (src[1] << 4) + (src[2] << 12);
+		else
+			size = src[0] >> 3;
+		if (size > ZSTD_BLOCK_MAX)
+			return -EPROTO;
+
+		*nlits = size;
+		if (type == ZSTD_LIT_RAW) {
+			if (size > len - hs)
+				return -EPROTO;
+			*lits = src + hs;
+			return hs + size;
+		}
+
+		if (hs >= len)
+			return -EPROTO;
+		memset(zc->lits, src[hs], size);
+		*lits = zc->lits;
+		return hs + 1;
+	}
+
+	hs = format < 2 ? 3 : format + 2;
+	if (hs > len)
+		return -EPROTO;
+	switch (format) {
+	case 0:
+		four = false;
+		/* fall through */
+	case 1:
+		size = (src[0] >> 4) | ((src[1] & 0x3f) << 4);
+		csize = (src[1] >> 6) | (src[2] << 2);
+		break;
+	case 2:
+		size = (src[0] >> 4) | (src[1] << 4) | ((src[2] & 3) << 12);
+		csize = (src[2] >> 2) | (src[3] << 6);
+		break;
+	default:
+		size = (src[0] >> 4) | (src[1] << 4) | ((src[2] & 0x3f) << 12);
+		csize = (src[2] >> 6) | (src[3] << 2) | (src[4] << 10);
+		break;
+	}
+	if (size > ZSTD_BLOCK_MAX || csize > len - hs)
+		return -EPROTO;
+
+	src += hs;
+	if (type == ZSTD_LIT_COMPRESSED) {
+		ret = zstd_huf_read(zc, src, csize);
+		if (ret < 0)
+			return ret;
+	} else if (!zc->huf_log) {
+		/* Treeless, without a previous tree */
+		return -EPROTO;
+	} else {
+		ret = 0;
+	}
+
+	ret = zstd_huf_decode(zc, src + ret, csize - ret, zc->lits, size, four);
+	if (ret)
+		return ret;
+
+	*lits = zc->lits;
+	*nlits = size;
+
+	return hs + csize;
+}
+
+/* Set up a sequence code table, returns the bytes its description takes */
+static int zstd_seq_table(struct zstd_seq_table *t, unsigned int mode,
+			  const s16 *def, unsigned int def_sym,
+			  unsigned int def_log,
+			  unsigned int max_log, unsigned int max_sym,
+			  const u8 *src, size_t len)
+{
+	int ret;
+
+	switch (mode) {
+	case ZSTD_SEQ_PREDEFINED:
+		ret = zstd_fse_build(t->dt, def, def_sym, def_log);
+		if (ret)
+			return ret;
+		t->log = def_log;
+		break;
+	case ZSTD_SEQ_RLE:
+		if (!len || src[0] > max_sym)
+			return -EPROTO;
+		zstd_fse_rle(t->dt, src[0]);
+		t->log = 0;
+		t->valid = true;
+		return 1;
+	case ZSTD_SEQ_COMPRESSED:
+		ret = zstd_fse_read(t->dt, &t->log, max_log, max_sym, src, len);
+		if (ret < 0)
+			return ret;
+		t->valid = true;
+		return ret;
+	default:
+		if (!t->valid)
+			return -EPROTO;
+		return 0;
+	}
+	t->valid = true;
+
+	return 0;
+}
+
+static inline void zstd_copy_match(u8 *op, size_t offset, size_t len)
+{
+	const u8 *m = op - offset;
+
+	if (offset >= 8) {
+		while (len >= 8) {
+			memcpy(op, m, 8);
+			op += 8;
+			m += 8;
+			len -= 8;
+		}
+	}
+	while (len--)
+		*op++ = *m++;
+}
+
+static int zstd_sequences(struct zstd_ctx *zc, const u8 *src, size_t len,
+			  const u8 *lits, size_t nlits, u8 *fstart, u8 **opp,
+			  u8 *oend)
+{
+	const u8 *lend = lits + nlits;
+	const u8 *end = src + len;
+	const struct zstd_fse *e;
+	struct zstd_bits b;
+	unsigned int nseq, modes, ls, ms, os, i, c;
+	size_t ll, ml, offset;
+	u8 *op = *opp;
+	u32 ov;
+	int ret;
+
+	if (!len)
+		return -EPROTO;
+
+	nseq = src[0];
+	if (nseq >= 128) {
+		if (nseq == 255) {
+			if (len < 3)
+				return -EPROTO;
+			nseq = get_unaligned_le16(src + 1) + 0x7f00;
+			src += 3;
+		} else {
+			if (len < 2)
+				return -EPROTO;
+			nseq = ((nseq - 128) << 8) + src[1];
+			src += 2;
+		}
+	} else {
+		src++;
+	}
+
+	if (!nseq) {
+		if (src != end)
+			return -EPROTO;
+		goto last_lits;
+	}
+
+	if (src >= end)
+		return -EPROTO;
+	modes = *src++;
+	if (modes & 3)
+		return -EPROTO;
+
+	ret = zstd_seq_table(&zc->ll, modes >> 6, zstd_ll_default,
+			     ARRAY_SIZE(zstd_ll_default), 6,
+			     ZSTD_LL_LOG_MAX, ZSTD_LL_MAX, src, end - src);
+	if (ret < 0)
+		return ret;
+	src += ret;
+	ret = zstd_seq_table(&zc->of, (modes >> 4) & 3, zstd_of_default,
+			     ARRAY_SIZE(zstd_of_default), 5,
+			     ZSTD_OF_LOG_MAX, ZSTD_OF_MAX, src, end - src);
+	if (ret < 0)
+		return ret;
+	src += ret;
+	ret = zstd_seq_table(&zc->ml, (modes >> 2) & 3, zstd_ml_default,
+			     ARRAY_SIZE(zstd_ml_default), 6,
+			     ZSTD_ML_LOG_MAX, ZSTD_ML_MAX, src, end - src);
+	if (ret < 0)
+		return ret;
+	src += ret;
+
+	if (zstd_bits_init(&b, src, end - src))
+		return -EPROTO;
+	ls = zstd_bits_read(&b, zc->ll.log);
+	os = zstd_bits_read(&b, zc->of.log);
+	ms = zstd_bits_read(&b, zc->ml.log);
+	zstd_bits_reload(&b);
+
+	for (i = 0; i < nseq; i++) {
+		/* Offset, match length then literals length bits */
+		c = zc->of.dt[os].sym;
+		ov = (1u << c) + zstd_bits_read(&b, c);
+		zstd_bits_reload(&b);
+		c = zc->ml.dt[ms].sym;
+		ml = zstd_ml_base[c] + zstd_bits_read(&b, zstd_ml_bits[c]);
+		c = zc->ll.dt[ls].sym;
+		ll = zstd_ll_base[c] + zstd_bits_read(&b, zstd_ll_bits[c]);
+		zstd_bits_reload(&b);
+
+		if (ov > 3) {
+			offset = ov - 3;
+			zc->rep[2] = zc->rep[1];
+			zc->rep[1] = zc->rep[0];
+			zc->rep[0] = offset;
+		} else {
+			/* Repeat offsets, shifted by one without literals */
+			c = ov - 1 + !ll;
+			if (!c) {
+				offset = zc->rep[0];
+			} else {
+				offset = c == 3 ? zc->rep[0] - 1 : zc->rep[c];
+				if (c != 1)
+					zc->rep[2] = zc->rep[1];
+				zc->rep[1] = zc->rep[0];
+				zc->rep[0] = offset;
+			}
+		}
+
+		if (i + 1 < nseq) {
+			e = &zc->ll.dt[ls];
+			ls = e->base + zstd_bits_read(&b, e->nbits);
+			e = &zc->ml.dt[ms];
+			ms = e->base + zstd_bits_read(&b, e->nbits);
+			e = &zc->of.dt[os];
+			os = e->base + zstd_bits_read(&b, e->nbits);
+			zstd_bits_reload(&b);
+		}
+
+		if (ll > lend - lits)
+			return -EPROTO;
+		if (ll + ml > oend - op)
+			return -ENOBUFS;
+		memcpy(op, lits, ll);
+		op += ll;
+		lits += ll;
+
+		if (!offset || offset > op - fstart)
+			return -EPROTO;
+		zstd_copy_match(op, offset, ml);
+		op += ml;
+	}
+
+	if (!zstd_bits_done(&b))
+		return -EPROTO;
+
+last_lits:
+	if (lend - lits > oend - op)
+		return -ENOBUFS;
+	memcpy(op, lits, lend - lits);
+	*opp = op + (lend - lits);
+
+	return 0;
+}
+
+static int zstd_block(struct zstd_ctx *zc, const u8 *src, size_t len,
+		      u8 *fstart, u8 **opp, u8 *oend)
+{
+	const u8 *lits;
+	size_t nlits;
+	int ret;
+
+	if (!len)
+		return -EPROTO;
+
+	ret = zstd_literals(zc, src, len, &lits, &nlits);
+	if (ret < 0)
+		return ret;
+
+	return zstd_sequences(zc, src + ret, len - ret, lits, nlits, fstart,
+			      opp, oend);
+}
+
+#define XXH_PRIME64_1	0x9E3779B185EBCA87ULL
+#define XXH_PRIME64_2	0xC2B2AE3D27D4EB4FULL
+#define XXH_PRIME64_3	0x165667B19E3779F9ULL
+#define XXH_PRIME64_4	0x85EBCA77C2B2AE63ULL
+#define XXH_PRIME64_5	0x27D4EB2F165667C5ULL
+
+static inline u64 xxh64_rotl(u64 v, unsigned int n)
+{
+	return (v << n) | (v >> (64 - n));
+}
+
+static inline u64 xxh64_round(u64 acc, u64 v)
+{
+	acc += v * XXH_PRIME64_2;
+
+	return xxh64_rotl(acc, 31) * XXH_PRIME64_1;
+}
+
+static inline u64 xxh64_merge(u64 acc, u64 v)
+{
+	acc ^= xxh64_round(0, v);
+
+	return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+/* XXH64 with seed 0, of which frames keep the low 32 bits */
+static u64 xxh64(const u8 *p, size_t len)
+{
+	const u8 *end = p + len;
+	u64 v1, v2, v3, v4, h;
+
+	if (len >= 32) {
+		v1 = XXH_PRIME64_1 + XXH_PRIME64_2;
+		v2 = XXH_PRIME64_2;
+		v3 = 0;
+		v4 = -XXH_PRIME64_1;
+		do {
+			v1 = xxh64_round(v1, get_unaligned_le64(p));
+			v2 = xxh64_round(v2, get_unaligned_le64(p + 8));
+			v3 = xxh64_round(v3, get_unaligned_le64(p + 16));
+			v4 = xxh64_round(v4, get_unaligned_le64(p + 24));
+			p += 32;
+		} while (end - p >= 32);
+
+		h = xxh64_rotl(v1, 1) + xxh64_rotl(v2, 7) +
+		    xxh64_rotl(v3, 12) + xxh64_rotl(v4, 18);
+		h = xxh64_merge(h, v1);
+		h = xxh64_merge(h, v2);
+		h = xxh64_merge(h, v3);
+		h = xxh64_merge(h, v4);
+	} else {
+		h = XXH_PRIME64_5;
+	}
+
+	h += len;
+	for (; end - p >= 8; p += 8) {
+		h ^= xxh64_round(0, get_unaligned_le64(p));
+		h = xxh64_rotl(h, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+	}
+	if (end - p >= 4) {
+		h ^= (u64)get_unaligned_le32(p) * XXH_PRIME64_1;
+		h = xxh64_rotl(h, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+		p += 4;
+	}
+	for (; p < end; p++) {
+		h ^= *p * XXH_PRIME64_5;
+		h = xxh64_rotl(h, 11) * XXH_PRIME64_1;
+	}
+
+	h ^= h >> 33;
+	h *= XXH_PRIME64_2;
+	h ^= h >> 29;
+	h *= XXH_PRIME64_3;
+	h ^= h >> 32;
+
+	return h;
+}
+
+struct zstd_frame {
+	const u8 *data;		/* the first block header */
+	u64 content_size;	/* or -1ULL */
+	bool checksum;
+};
+
+static int zstd_frame_header(const u8 *src, size_t len, struct zstd_frame *f)
+{
+	static const u8 did_size[] = { 0, 1, 2, 4 };
+	static const u8 fcs_size[] = { 1, 2, 4, 8 };
+	const u8 *p = src + 5;
+	unsigned int fhd, ds, fs;
+	u32 did = 0;
+
+	if (len < 5 || get_unaligned_le32(src) != ZSTD_MAGIC)
+		return -EINVAL;
+
+	fhd = src[4];
+	if (fhd & 0x08)
+		return -EINVAL;
+
+	ds = did_size[fhd & 3];
+	fs = fcs_size[fhd >> 6];
+	/* No content size unless a single segment, instead of the window */
+	if (!(fhd & 0x20)) {
+		p++;
+		if (!(fhd >> 6))
+			fs = 0;
+	}
+	if (p - src + ds + fs > len)
+		return -EPROTO;
+
+	switch (ds) {
+	case 1:
+		did = *p;
+		break;
+	case 2:
+		did = get_unaligned_le16(p);
+		break;
+	case 4:
+		did = get_unaligned_le32(p);
+		break;
+	}
+	if (did)
+		return -EPROTONOSUPPORT;
+	p += ds;
+
+	switch (fs) {
+	case 0:
+		f->content_size = -1ULL;
+		break;
+	case 1:
+		f->content_size = *p;
+		break;
+	case 2:
+		f->content_size = get_unaligned_le16(p) + 256;
+		break;
+	case 4:
+		f->content_size = get_unaligned_le32(p);
+		break;
+	default:
+		f->content_size = get_unaligned_le64(p);
+		break;
+	}
+	f->data = p + fs;
+	f->checksum = fhd & 0x04;
+
+	return 0;
+}
+
+static int zstd_frame(struct zstd_ctx *zc, const u8 **srcp, const u8 *send,
+		      u8 **opp, u8 *oend)
+{
+	struct zstd_frame f;
+	const u8 *p;
+	u8 *fstart = *opp, *op = *opp;
+	unsigned int type;
+	bool last;
+	u32 bh;
+	size_t size;
+	int ret;
+
+	ret = zstd_frame_header(*srcp, send - *srcp, &f);
+	if (ret)
+		return ret;
+
+	zc->huf_log = 0;
+	zc->ll.valid = false;
+	zc->ml.valid = false;
+	zc->of.valid = false;
+	zc->rep[0] = 1;
+	zc->rep[1] = 4;
+	zc->rep[2] = 8;
+
+	p = f.data;
+	do {
+		if (send - p < 3)
+			return -EPROTO;
+		bh = p[0] | (p[1] << 8) | (p[2] << 16);
+		p += 3;
+		last = bh & 1;
+		type = (bh >> 1) & 3;
+		size = bh >> 3;
+
+		switch (type) {
+		case ZSTD_BLOCK_RAW:
+			if (size > send - p)
+				return -EPROTO;
+			if (size > oend - op)
+				return -ENOBUFS;
+			memcpy(op, p, size);
+			op += size;
+			p += size;
+			break;
+		case ZSTD_BLOCK_RLE:
+			if (p >= send || size > ZSTD_BLOCK_MAX)
+				return -EPROTO;
+			if (size > oend - op)
+				return -ENOBUFS;
+			memset(op, *p, size);
+			op += size;
+			p++;
+			break;
+		case ZSTD_BLOCK_COMPRESSED:
+			if (size > send - p || size > ZSTD_BLOCK_MAX)
+				return -EPROTO;
+			ret = zstd_block(zc, p, size, fstart, &op, oend);
+			*opp = op;
+			if (ret)
+				return ret;
+			p += size;
+			break;
+		default:
+			return -EPROTO;
+		}
+		*opp = op;
+	} while (!last);
+
+	if (f.content_size != -1ULL && f.content_size != op - fstart)
+		return -EPROTO;
+
+	if (f.checksum) {
+		if (send - p < 4)
+			return -EPROTO;
+		if ((u32)xxh64(fstart, op - fstart) != get_unaligned_le32(p))
+			return -EPROTO;
+		p += 4;
+	}
+	*srcp = p;
+
+	return 0;
+}
+
+bool zstd_is_valid_header(const unsigned char *h)
+{
+	return get_unaligned_le32(h) == ZSTD_MAGIC;
+}
+
+u64 zstd_get_content_size(const void *src, size_t srcn)
+{
+	struct zstd_frame f;
+
+	if (zstd_frame_header(src, srcn, &f) || f.content_size == -1ULL)
+		return 0;
+
+	return f.content_size;
+}
+
+int zstd_decompress(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	const u8 *p = src, *end = p + srcn;
+	u8 *op = dst, *oend;
+	struct zstd_ctx *zc;
+	int frames = 0;
+	u32 magic, size;
+	size_t avail;
+	int ret = 0;
+
+	/* ~0 is "no limit" to some callers, keep the end from wrapping */
+	avail = min_t(size_t, *dstn, ~0UL - (ulong)dst);
+	oend = op + min_t(size_t, avail, LONG_MAX);
+
+	zc = malloc(sizeof(*zc));
+	if (!zc)
+		return -ENOMEM;
+	zc->ll.dt = zc->ll_dt;
+	zc->ml.dt = zc->ml_dt;
+	zc->of.dt = zc->of_dt;
+
+	while (end - p >= 4) {
+		magic = get_unaligned_le32(p);
+		if ((magic & 0xfffffff0) == ZSTD_SKIP_MAGIC) {
+			if (end - p < 8) {
+				ret = -EPROTO;
+				break;
+			}
+			size = get_unaligned_le32(p + 4);
+			if (size > end - p - 8) {
+				ret = -EPROTO;
+				break;
+			}
+			p += 8 + size;
+			continue;
+		}
+
+		/* Whatever follows the frames, e.g. padding, is left alone */
+		if (magic != ZSTD_MAGIC)
+			break;
+
+		ret = zstd_frame(zc, &p, end, &op, oend);
+		if (ret)
+			break;
+		frames++;
+	}
+
+	if (!ret && !frames)
+		ret = -EINVAL;
+	free(zc);
+	*dstn = op - (u8 *)dst;
+
+	return ret;
+}
@@ -348,6 +348,27 @@ int eth_send(void *packet, int length)
 	return ret;
 }
 
+#ifdef CONFIG_MCAST_TFTP
+int eth_mcast_join(struct in_addr mcast_ip, int join)
+{
+	struct udevice *current = eth_get_dev();
+	u8 mcast_mac[ARP_HLEN];
+
+	if (!current || !eth_get_ops(current)->mcast)
+		return -ENOSYS;
+
+	/* 01:00:5e followed by the low 23 bits of the group address */
+	mcast_mac[5] = htonl(mcast_ip.s_addr) & 0xff;
+	mcast_mac[4] = (htonl(mcast_ip.s_addr) >> 8) & 0xff;
+	mcast_mac[3] = (htonl(mcast_ip.s_addr) >> 16) & 0x7f;
+	mcast_mac[2] = 0x5e;
+	mcast_mac[1] = 0x0;
+	mcast_mac[0] = 0x1;
+
+	return eth_get_ops(current)->mcast(current, mcast_mac, join);
+}
+#endif
+
 int eth_rx(void)
 {
 	struct udevice *current;
@@ -363,13 +384,18 @@ int eth_rx(void)
 	if (!device_active(current))
 		return -EINVAL;
 
-	/* Process up to 32 packets at one time */
+	/* Drain up to CONFIG_NET_RX_BATCH packets at one time */
 	flags = ETH_RECV_CHECK_DEVICE;
-	for (i = 0; i < 32; i++) {
+	for (i = 0; i < CONFIG_NET_RX_BATCH; i++) {
 		ret = eth_get_ops(current)->recv(current, flags, &packet);
 		flags = 0;
-		if (ret > 0)
+		if (ret > 0) {
+			net_rx_csum_ok = eth_get_ops(current)->rx_csum_ok &&
+				eth_get_ops(current)->rx_csum_ok(current, packet,
+								 ret);
 			net_process_received_packet(packet, ret);
+			net_rx_csum_ok = false;
+		}
 		if (ret >= 0 && eth_get_ops(current)->free_pkt)
 			eth_get_ops(current)->free_pkt(current, packet, ret);
 		if (ret <= 0)
@@ -489,6 +515,8 @@ static int eth_post_probe(struct udevice *dev)
 			ops->write_hwaddr += gd->reloc_off;
 		if (ops->read_rom_hwaddr)
 			ops->read_rom_hwaddr += gd->reloc_off;
+		if (ops->rx_csum_ok)
+			ops->rx_csum_ok += gd->reloc_off;
 
 		reloc_done++;
 	}
@@ -29,7 +29,18 @@ struct __attribute__((packed)) fastboot_header {
 	unsigned short seq;
 };
 
+/*
+ * The host uses the smaller of this and its own limit (8KB for AOSP
+ * fastboot) for every packet, and only sends the next one once the last
+ * is answered, so the download rate goes with the packet size. Anything
+ * above the MTU arrives as IP fragments.
+ */
+#if defined(CONFIG_IP_DEFRAG) && \
+	(!defined(CONFIG_NET_MAXDEFRAG) || CONFIG_NET_MAXDEFRAG >= 8192 + 28)
+#define PACKET_SIZE 8192
+#else
 #define PACKET_SIZE 1024
+#endif
 #define FASTBOOT_HEADER_SIZE sizeof(struct fastboot_header)
 #define DATA_SIZE (PACKET_SIZE - FASTBOOT_HEADER_SIZE)
 #define FASTBOOT_VERSION "0.4"
@@ -39,6 +50,9 @@ static unsigned short fb_sequence_number = 1;
 static const unsigned short fb_packet_size = PACKET_SIZE;
 static const unsigned short fb_udp_version = 1;
 
+/* Command text of the current packet, NUL terminated */
+static char fastboot_cmd[DATA_SIZE + 1];
+
 /* Keep track of last packet for resubmission */
 static uchar last_packet[PACKET_SIZE];
 static unsigned int last_packet_len = 0;
@@ -474,7 +488,7 @@ static void fastboot_handler(uchar *packet, unsigned dport, struct in_addr sip,
 		unsigned sport, unsigned len)
 {
 	struct fastboot_header fb_header;
-	char fastboot_data[DATA_SIZE] = {0};
+	char *fastboot_data = fastboot_cmd;
 	unsigned int fastboot_data_len = 0;
 
 	if (dport != fastboot_our_port) {
@@ -500,8 +514,12 @@ static void fastboot_handler(uchar *packet, unsigned dport, struct in_addr sip,
 	case FASTBOOT_INIT:
 	case FASTBOOT_FASTBOOT:
 		fastboot_data_len = len;
-		if (len > 0) {
-			memcpy(fastboot_data, packet, len);
+		/* Image data is copied once, from the packet to the buffer */
+		if (cmd_string && !strcmp("download", cmd_string)) {
+			fastboot_data = (char *)packet;
+		} else {
+			memcpy(fastboot_cmd, packet, len);
+			fastboot_cmd[len] = '\0';
 		}
 		if (fb_header.seq == fb_sequence_number) {
 			fastboot_send(fb_header, fastboot_data, fastboot_data_len, 0);
@@ -144,6 +144,8 @@ struct in_addr	net_server_ip;
 uchar *net_rx_packet;
 /* Current rx packet length */
 int		net_rx_packet_len;
+/* The MAC has verified the checksums of the packet being processed */
+bool		net_rx_csum_ok;
 /* IP packet ID */
 static unsigned	net_ip_id;
 /* Ethernet bcast address */
@@ -394,29 +396,11 @@ void net_init(void)
  *	Main network processing loop.
  */
 
-int net_loop(enum proto_t protocol)
-{
-	int ret = -EINVAL;
+static enum proto_t net_loop_protocol;
 
-	net_restarted = 0;
-	net_dev_exists = 0;
-	net_try_count = 1;
-	debug_cond(DEBUG_INT_STATE, "--- net_loop Entry\n");
-
-	bootstage_mark_name(BOOTSTAGE_ID_ETH_START, "eth_start");
-	net_init();
-	if (eth_is_on_demand_init() || protocol != NETCONS) {
-		eth_halt();
-		eth_set_current();
-		ret = eth_init();
-		if (ret < 0) {
-			eth_halt();
-			return ret;
-		}
-	} else {
-		eth_init_state_only();
-	}
-restart:
+/* (Re)start the protocol, at first and on NETLOOP_RESTART */
+static int net_loop_begin(void)
+{
 #ifdef CONFIG_USB_KEYBOARD
 	net_busy_flag = 0;
 #endif
@@ -430,7 +414,7 @@ restart:
 	debug_cond(DEBUG_INT_STATE, "--- net_loop Init\n");
 	net_init_loop();
 
-	switch (net_check_prereq(protocol)) {
+	switch (net_check_prereq(net_loop_protocol)) {
 	case 1:
 		/* network not configured */
 		eth_halt();
@@ -443,13 +427,13 @@ restart:
 	case 0:
 		net_dev_exists = 1;
 		net_boot_file_size = 0;
-		switch (protocol) {
+		switch (net_loop_protocol) {
 		case TFTPGET:
 #ifdef CONFIG_CMD_TFTPPUT
 		case TFTPPUT:
 #endif
 			/* always use ARP to get server ethernet address */
-			tftp_start(protocol);
+			tftp_start(net_loop_protocol);
 			break;
 #ifdef CONFIG_CMD_TFTPSRV
 		case TFTPSRV:
@@ -541,113 +525,145 @@ restart:
 	net_busy_flag = 1;
 #endif
 
-	/*
-	 *	Main packet reception loop.  Loop receiving packets until
-	 *	someone sets `net_state' to a state that terminates.
-	 */
-	for (;;) {
-		WATCHDOG_RESET();
-#ifdef CONFIG_SHOW_ACTIVITY
-		show_activity(1);
-#endif
-		if (arp_timeout_check() > 0)
-			time_start = get_timer(0);
+	return 0;
+}
 
-		/*
-		 *	Check the ethernet for a new packet.  The ethernet
-		 *	receive routine will process it.
-		 *	Most drivers return the most recent packet size, but not
-		 *	errors that may have happened.
-		 */
-		eth_rx();
+int net_loop_start(enum proto_t protocol)
+{
+	int ret;
 
-		/*
-		 *	Abort if ctrl-c was pressed.
-		 */
-		if (ctrlc()) {
-			/* cancel any ARP that may not have completed */
-			net_arp_wait_packet_ip.s_addr = 0;
+	net_restarted = 0;
+	net_dev_exists = 0;
+	net_try_count = 1;
+	debug_cond(DEBUG_INT_STATE, "--- net_loop Entry\n");
 
-			net_cleanup_loop();
+	bootstage_mark_name(BOOTSTAGE_ID_ETH_START, "eth_start");
+	net_init();
+	if (eth_is_on_demand_init() || protocol != NETCONS) {
+		eth_halt();
+		eth_set_current();
+		ret = eth_init();
+		if (ret < 0) {
 			eth_halt();
-			/* Invalidate the last protocol */
-			eth_set_last_protocol(BOOTP);
-
-			puts("\nAbort\n");
-			/* include a debug print as well incase the debug
-			   messages are directed to stderr */
-			debug_cond(DEBUG_INT_STATE, "--- net_loop Abort!\n");
-			ret = -EINTR;
-			goto done;
+			return ret;
 		}
+	} else {
+		eth_init_state_only();
+	}
 
-		/*
-		 *	Check for a timeout, and run the timeout handler
-		 *	if we have one.
-		 */
-		if (time_handler &&
-		    ((get_timer(0) - time_start) > time_delta)) {
-			thand_f *x;
+	net_loop_protocol = protocol;
+
+	return net_loop_begin();
+}
+
+int net_loop_poll(void)
+{
+	int ret = -EINVAL;
+
+	WATCHDOG_RESET();
+#ifdef CONFIG_SHOW_ACTIVITY
+	show_activity(1);
+#endif
+	if (arp_timeout_check() > 0)
+		time_start = get_timer(0);
+
+	/*
+	 *	Check the ethernet for a new packet.  The ethernet
+	 *	receive routine will process it.
+	 *	Most drivers return the most recent packet size, but not
+	 *	errors that may have happened.
+	 */
+	eth_rx();
+
+	/*
+	 *	Abort if ctrl-c was pressed.
+	 */
+	if (ctrlc()) {
+		/* cancel any ARP that may not have completed */
+		net_arp_wait_packet_ip.s_addr = 0;
+
+		net_cleanup_loop();
+		eth_halt();
+		/* Invalidate the last protocol */
+		eth_set_last_protocol(BOOTP);
+
+		puts("\nAbort\n");
+		/* include a debug print as well incase the debug
+		   messages are directed to stderr */
+		debug_cond(DEBUG_INT_STATE, "--- net_loop Abort!\n");
+		ret = -EINTR;
+		goto done;
+	}
+
+	/*
+	 *	Check for a timeout, and run the timeout handler
+	 *	if we have one.
+	 */
+	if (time_handler &&
+	    ((get_timer(0) - time_start) > time_delta)) {
+		thand_f *x;
 
 #if defined(CONFIG_MII) || defined(CONFIG_CMD_MII)
 #if	defined(CONFIG_SYS_FAULT_ECHO_LINK_DOWN)	&& \
 	defined(CONFIG_LED_STATUS)			&& \
 	defined(CONFIG_LED_STATUS_RED)
-			/*
-			 * Echo the inverted link state to the fault LED.
-			 */
-			if (miiphy_link(eth_get_dev()->name,
-					CONFIG_SYS_FAULT_MII_ADDR))
-				status_led_set(CONFIG_LED_STATUS_RED,
-					       CONFIG_LED_STATUS_OFF);
-			else
-				status_led_set(CONFIG_LED_STATUS_RED,
-					       CONFIG_LED_STATUS_ON);
+		/*
+		 * Echo the inverted link state to the fault LED.
+		 */
+		if (miiphy_link(eth_get_dev()->name,
+				CONFIG_SYS_FAULT_MII_ADDR))
+			status_led_set(CONFIG_LED_STATUS_RED,
+				       CONFIG_LED_STATUS_OFF);
+		else
+			status_led_set(CONFIG_LED_STATUS_RED,
+				       CONFIG_LED_STATUS_ON);
 #endif /* CONFIG_SYS_FAULT_ECHO_LINK_DOWN, ... */
 #endif /* CONFIG_MII, ... */
-			debug_cond(DEBUG_INT_STATE, "--- net_loop timeout\n");
-			x = time_handler;
-			time_handler = (thand_f *)0;
-			(*x)();
-		}
+		debug_cond(DEBUG_INT_STATE, "--- net_loop timeout\n");
+		x = time_handler;
+		time_handler = (thand_f *)0;
+		(*x)();
+	}
 
-		if (net_state == NETLOOP_FAIL)
-			ret = net_start_again();
-
-		switch (net_state) {
-		case NETLOOP_RESTART:
-			net_restarted = 1;
-			goto restart;
-
-		case NETLOOP_SUCCESS:
-			net_cleanup_loop();
-			if (net_boot_file_size > 0) {
-				printf("Bytes transferred = %d (%x hex)\n",
-				       net_boot_file_size, net_boot_file_size);
-				env_set_hex("filesize", net_boot_file_size);
-				env_set_hex("fileaddr", load_addr);
-			}
-			if (protocol != NETCONS)
-				eth_halt();
-			else
-				eth_halt_state_only();
-
-			eth_set_last_protocol(protocol);
-
-			ret = net_boot_file_size;
-			debug_cond(DEBUG_INT_STATE, "--- net_loop Success!\n");
-			goto done;
-
-		case NETLOOP_FAIL:
-			net_cleanup_loop();
-			/* Invalidate the last protocol */
-			eth_set_last_protocol(BOOTP);
-			debug_cond(DEBUG_INT_STATE, "--- net_loop Fail!\n");
-			goto done;
-
-		case NETLOOP_CONTINUE:
-			continue;
+	if (net_state == NETLOOP_FAIL)
+		ret = net_start_again();
+
+	switch (net_state) {
+	case NETLOOP_RESTART:
+		net_restarted = 1;
+		ret = net_loop_begin();
+		if (ret < 0)
+			return ret;
+		return -EAGAIN;
+
+	case NETLOOP_SUCCESS:
+		net_cleanup_loop();
+		if (net_boot_file_size > 0) {
+			printf("Bytes transferred = %d (%x hex)\n",
+			       net_boot_file_size, net_boot_file_size);
+			env_set_hex("filesize", net_boot_file_size);
+			env_set_hex("fileaddr", load_addr);
 		}
+		if (net_loop_protocol != NETCONS)
+			eth_halt();
+		else
+			eth_halt_state_only();
+
+		eth_set_last_protocol(net_loop_protocol);
+
+		ret = net_boot_file_size;
+		debug_cond(DEBUG_INT_STATE, "--- net_loop Success!\n");
+		goto done;
+
+	case NETLOOP_FAIL:
+		net_cleanup_loop();
+		/* Invalidate the last protocol */
+		eth_set_last_protocol(BOOTP);
+		debug_cond(DEBUG_INT_STATE, "--- net_loop Fail!\n");
+		goto done;
+
+	case NETLOOP_CONTINUE:
+		return -EAGAIN;
 	}
 
 done:
@@ -662,6 +678,25 @@ done:
 	return ret;
 }
 
+int net_loop(enum proto_t protocol)
+{
+	int ret;
+
+	ret = net_loop_start(protocol);
+	if (ret < 0)
+		return ret;
+
+	/*
+	 *	Main packet reception loop.  Loop receiving packets until
+	 *	someone sets `net_state' to a state that terminates.
+	 */
+	do {
+		ret = net_loop_poll();
+	} while (ret == -EAGAIN);
+
+	return ret;
+}
+
 /**********************************************************************/
 
 static void start_again_timeout_handler(void)
@@ -1169,7 +1204,8 @@ void net_process_received_packet(uchar *in_packet, int len)
 		if ((ip->ip_hl_v & 0x0f) > 0x05)
 			return;
 		/* Check the Checksum of the header */
-		if (!ip_checksum_ok((uchar *)ip, IP_HDR_SIZE)) {
+		if (!net_rx_csum_ok &&
+		    !ip_checksum_ok((uchar *)ip, IP_HDR_SIZE)) {
 			debug("checksum bad\n");
 			return;
 		}
@@ -1178,12 +1214,15 @@ void net_process_received_packet(uchar *in_packet, int len)
 		if (net_ip.s_addr && dst_ip.s_addr != net_ip.s_addr &&
 		    dst_ip.s_addr != 0xFFFFFFFF) {
 #ifdef CONFIG_MCAST_TFTP
-			if (net_mcast_addr != dst_ip)
+			if (net_mcast_addr.s_addr != dst_ip.s_addr)
 #endif
 				return;
 		}
 		/* Read source IP address for later use */
 		src_ip = net_read_ip(&ip->ip_src);
+		/* A MAC can only vouch for the payload of a whole datagram */
+		if (ip->ip_off & htons(IP_OFFS | IP_FLAGS_MFRAG))
+			net_rx_csum_ok = false;
 		/*
 		 * The function returns the unchanged packet if it's not
 		 * a fragment, and either the complete packet or NULL if
@@ -1225,7 +1264,7 @@ void net_process_received_packet(uchar *in_packet, int len)
 			   &dst_ip, &src_ip, len);
 
 #ifdef CONFIG_UDP_CHECKSUM
-		if (ip->udp_xsum != 0) {
+		if (!net_rx_csum_ok && ip->udp_xsum != 0) {
 			ulong   xsum;
 			ushort *sumptr;
 			ushort  sumlen;
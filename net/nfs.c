@@ -42,15 +42,32 @@
 # define NFS_TIMEOUT CONFIG_NFS_TIMEOUT
 #endif
 
+#ifndef CONFIG_NFS_READ_WINDOW
+# define NFS_READ_WINDOW 1
+#else
+# define NFS_READ_WINDOW CONFIG_NFS_READ_WINDOW
+#endif
+/* Enough of a READ reply to hold the RPC header and file attributes */
+#define NFS_READ_HDR_LEN 256
+
 #define NFS_RPC_ERR	1
 #define NFS_RPC_DROP	124
 
 static int fs_mounted;
 static unsigned long rpc_id;
-static int nfs_offset = -1;
-static int nfs_len;
 static ulong nfs_timeout = NFS_TIMEOUT;
 
+/* An outstanding READ call, free while len is 0 */
+struct nfs_read_slot {
+	unsigned long xid;
+	int offset;
+	int len;
+};
+
+static struct nfs_read_slot nfs_read_slots[NFS_READ_WINDOW];
+static int nfs_read_next;	/* offset of the next new READ */
+static bool nfs_read_eof;	/* no new READs past nfs_read_next */
+
 static char dirfh[NFS_FHSIZE];	/* NFSv2 / NFSv3 file handle of directory */
 static char filefh[NFS3_FHSIZE]; /* NFSv2 / NFSv3 file handle */
 static int filefh3_length;	/* (variable) length of filefh when NFSv3 */
@@ -386,6 +403,57 @@ static void nfs_read_req(int offset, int readlen)
 	rpc_req(PROG_NFS, NFS_READ, data, len);
 }
 
+static void nfs_read_issue(struct nfs_read_slot *slot, int offset, int len)
+{
+	nfs_read_req(offset, len);
+	slot->xid = rpc_id;
+	slot->offset = offset;
+	slot->len = len;
+}
+
+/* Keep NFS_READ_WINDOW READs in flight until the end of the file */
+static void nfs_read_fill(void)
+{
+	struct nfs_read_slot *slot;
+
+	for (slot = nfs_read_slots;
+	     slot < nfs_read_slots + NFS_READ_WINDOW && !nfs_read_eof; slot++) {
+		if (slot->len)
+			continue;
+		nfs_read_issue(slot, nfs_read_next, NFS_READ_SIZE);
+		nfs_read_next += NFS_READ_SIZE;
+	}
+}
+
+/*
+ * Resend all outstanding READs, with new xids so that late replies to the
+ * old ones are dropped, then fill the window up again.
+ */
+static void nfs_read_send(void)
+{
+	struct nfs_read_slot *slot;
+
+	for (slot = nfs_read_slots;
+	     slot < nfs_read_slots + NFS_READ_WINDOW; slot++) {
+		if (slot->len)
+			nfs_read_issue(slot, slot->offset, slot->len);
+	}
+
+	nfs_read_fill();
+}
+
+static bool nfs_read_busy(void)
+{
+	int i;
+
+	for (i = 0; i < NFS_READ_WINDOW; i++) {
+		if (nfs_read_slots[i].len)
+			return true;
+	}
+
+	return false;
+}
+
 /**************************************************************************
 RPC request dispatcher
 **************************************************************************/
@@ -416,7 +484,7 @@ static void nfs_send(void)
 		nfs_lookup_req(nfs_filename);
 		break;
 	case STATE_READ_REQ:
-		nfs_read_req(nfs_offset, nfs_len);
+		nfs_read_send();
 		break;
 	case STATE_READLINK_REQ:
 		nfs_readlink_req();
@@ -652,19 +720,31 @@ static int nfs_readlink_reply(uchar *pkt, unsigned len)
 	return 0;
 }
 
+/*
+ * Only the header is copied out for parsing, the data is stored straight
+ * from the packet. Replies may come in any order, each is matched to its
+ * READ by xid and stored at that READ's offset.
+ */
 static int nfs_read_reply(uchar *pkt, unsigned len)
 {
 	struct rpc_t rpc_pkt;
-	int rlen;
+	struct nfs_read_slot *slot;
+	unsigned long xid;
+	int rlen, eof = 0;
 	uchar *data_ptr;
 
 	debug("%s\n", __func__);
 
-	memcpy(&rpc_pkt.u.data[0], pkt, sizeof(rpc_pkt.u.reply));
+	memcpy(&rpc_pkt.u.data[0], pkt,
+	       min_t(unsigned int, len, NFS_READ_HDR_LEN));
 
-	if (ntohl(rpc_pkt.u.reply.id) > rpc_id)
-		return -NFS_RPC_ERR;
-	else if (ntohl(rpc_pkt.u.reply.id) < rpc_id)
+	xid = ntohl(rpc_pkt.u.reply.id);
+	for (slot = nfs_read_slots;
+	     slot < nfs_read_slots + NFS_READ_WINDOW; slot++) {
+		if (slot->len && slot->xid == xid)
+			break;
+	}
+	if (slot == nfs_read_slots + NFS_READ_WINDOW)
 		return -NFS_RPC_DROP;
 
 	if (rpc_pkt.u.reply.rstatus  ||
@@ -678,10 +758,10 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 		return -ntohl(rpc_pkt.u.reply.data[0]);
 	}
 
-	if ((nfs_offset != 0) && !((nfs_offset) %
+	if ((slot->offset != 0) && !((slot->offset) %
 			(NFS_READ_SIZE / 2 * 10 * HASHES_PER_LINE)))
 		puts("\n\t ");
-	if (!(nfs_offset % ((NFS_READ_SIZE / 2) * 10)))
+	if (!(slot->offset % ((NFS_READ_SIZE / 2) * 10)))
 		putc('#');
 
 	if (supported_nfs_versions & NFSV2_FLAG) {
@@ -693,6 +773,7 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 
 		/* count value */
 		rlen = ntohl(rpc_pkt.u.reply.data[1 + nfsv3_data_offset]);
+		eof = ntohl(rpc_pkt.u.reply.data[2 + nfsv3_data_offset]);
 		/* Skip unused values :
 			EOF:		32 bits value,
 			data_size:	32 bits value,
@@ -701,9 +782,21 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 			&(rpc_pkt.u.reply.data[4 + nfsv3_data_offset]);
 	}
 
-	if (store_block(data_ptr, nfs_offset, rlen))
+	data_ptr = pkt + (data_ptr - rpc_pkt.u.data);
+	if (rlen < 0 || rlen > slot->len || data_ptr + rlen > pkt + len)
+		return -NFS_RPC_DROP;
+
+	if (store_block(data_ptr, slot->offset, rlen))
 			return -9999;
 
+	/* Servers may return less than asked for, ask for the rest */
+	if (!rlen || eof)
+		nfs_read_eof = true;
+	if (rlen && rlen < slot->len && !eof)
+		nfs_read_issue(slot, slot->offset + rlen, slot->len - rlen);
+	else
+		slot->len = 0;
+
 	return rlen;
 }
 
@@ -796,8 +889,9 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			nfs_send();
 		} else {
 			nfs_state = STATE_READ_REQ;
-			nfs_offset = 0;
-			nfs_len = NFS_READ_SIZE;
+			memset(nfs_read_slots, 0, sizeof(nfs_read_slots));
+			nfs_read_next = 0;
+			nfs_read_eof = false;
 			nfs_send();
 		}
 		break;
@@ -822,16 +916,17 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 
 	case STATE_READ_REQ:
 		rlen = nfs_read_reply(pkt, len);
+		if (rlen == -NFS_RPC_DROP)
+			break;
 		net_set_timeout_handler(nfs_timeout, nfs_timeout_handler);
-		if (rlen > 0) {
-			nfs_offset += rlen;
-			nfs_send();
+		if (rlen >= 0 && (!nfs_read_eof || nfs_read_busy())) {
+			nfs_read_fill();
 		} else if ((rlen == -NFSERR_ISDIR) || (rlen == -NFSERR_INVAL)) {
 			/* symbolic link */
 			nfs_state = STATE_READLINK_REQ;
 			nfs_send();
 		} else {
-			if (!rlen)
+			if (rlen >= 0)
 				nfs_download_state = NETLOOP_SUCCESS;
 			if (rlen < 0)
 				debug("NFS READ error (%d)\n", rlen);
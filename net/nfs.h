@@ -39,10 +39,16 @@
 /*
  * Block size used for NFS read accesses.  A RPC reply packet (including  all
  * headers) must fit within a single Ethernet frame to avoid fragmentation.
- * However, if CONFIG_IP_DEFRAG is set, a bigger value could be used.  In any
- * case, most NFS servers are optimized for a power of 2.
+ * However, if CONFIG_IP_DEFRAG is set, a bigger value is used as long as
+ * the reply fits in the reassembly buffer.  In any case, most NFS servers
+ * are optimized for a power of 2.
  */
+#if defined(CONFIG_IP_DEFRAG) && \
+	(!defined(CONFIG_NET_MAXDEFRAG) || CONFIG_NET_MAXDEFRAG >= 8192 + 512)
+#define NFS_READ_SIZE	8192
+#else
 #define NFS_READ_SIZE	1024	/* biggest power of two that fits Ether frame */
+#endif
 
 /* Values for Accept State flag on RPC answers (See: rfc1831) */
 enum rpc_accept_stat {
@@ -8,6 +8,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <dm.h>
 #include <efi_loader.h>
 #include <mapmem.h>
 #include <net.h>
@@ -134,6 +135,23 @@ static char tftp_filename[MAX_LEN];
 static unsigned short tftp_block_size = TFTP_BLOCK_SIZE;
 static unsigned short tftp_block_size_option = TFTP_MTU_BLOCKSIZE;
 
+/*
+ * RFC 7440 windowsize, the number of DATA blocks the server sends per
+ * ACK. 1, the default, gives plain lock-step TFTP.
+ */
+#ifdef CONFIG_TFTP_WINDOWSIZE
+#define TFTP_WINDOWSIZE CONFIG_TFTP_WINDOWSIZE
+#else
+#define TFTP_WINDOWSIZE 1
+#endif
+
+static unsigned short tftp_window_size = 1;
+static unsigned short tftp_window_size_option = TFTP_WINDOWSIZE;
+/* blocks received in order since the last ACK */
+static unsigned short tftp_window_pos;
+/* 1 once a gap in the window has been reported */
+static int tftp_window_nacked;
+
 #ifdef CONFIG_MCAST_TFTP
 #include <malloc.h>
 #define MTFTP_BITMAPSIZE	0x1000
@@ -151,7 +169,7 @@ static void parse_multicast_oack(char *pkt, int len);
 
 static void mcast_cleanup(void)
 {
-	if (net_mcast_addr)
+	if (net_mcast_addr.s_addr)
 		eth_mcast_join(net_mcast_addr, 0);
 	if (tftp_mcast_bitmap)
 		free(tftp_mcast_bitmap);
@@ -162,6 +180,23 @@ static void mcast_cleanup(void)
 	tftp_mcast_ending_block = -1;
 }
 
+static int mcast_capable(void)
+{
+#ifdef CONFIG_DM_ETH
+	return eth_get_dev() && eth_get_ops(eth_get_dev())->mcast;
+#else
+	return eth_get_dev() && eth_get_dev()->mcast;
+#endif
+}
+
+/* Every block up to the last one, once its number is known, is in */
+static int mcast_have_all(void)
+{
+	return ext2_find_next_zero_bit(tftp_mcast_bitmap,
+				       tftp_mcast_bitmap_size * 8, 0) >=
+	       tftp_mcast_ending_block;
+}
+
 #endif	/* CONFIG_MCAST_TFTP */
 
 static inline void store_block(int block, uchar *src, unsigned len)
@@ -372,11 +407,15 @@ static void tftp_send(void)
 		/* try for more effic. blk size */
 		pkt += sprintf((char *)pkt, "blksize%c%d%c",
 				0, tftp_block_size_option, 0);
+		/* and several blocks per ACK, only the RRQ side does that */
+		if (tftp_state == STATE_SEND_RRQ && tftp_window_size_option > 1)
+			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
+					0, tftp_window_size_option, 0);
 #ifdef CONFIG_MCAST_TFTP
 		/* Check all preconditions before even trying the option */
 		if (!tftp_mcast_disabled) {
 			tftp_mcast_bitmap = malloc(tftp_mcast_bitmap_size);
-			if (tftp_mcast_bitmap && eth_get_dev()->mcast) {
+			if (tftp_mcast_bitmap && mcast_capable()) {
 				free(tftp_mcast_bitmap);
 				tftp_mcast_bitmap = NULL;
 				pkt += sprintf((char *)pkt, "multicast%c%c",
@@ -445,6 +484,25 @@ static void tftp_send(void)
 			    tftp_remote_port, tftp_our_port, len);
 }
 
+/*
+ * A block of the window got lost, so the blocks after it arrive out of
+ * order. ACK the last block received in order, which makes the server
+ * send the window again from there. The rest of the broken window is
+ * dropped without more ACKs, so the server does not restart it for
+ * every one of them.
+ */
+static void tftp_window_nack(ushort last)
+{
+	if (tftp_window_nacked)
+		return;
+
+	debug("TFTP window gap after block %u\n", last);
+	tftp_window_nacked = 1;
+	tftp_window_pos = 0;
+	tftp_cur_block = last;
+	tftp_send();
+}
+
 #ifdef CONFIG_CMD_TFTPPUT
 static void icmp_handler(unsigned type, unsigned code, unsigned dest,
 			 struct in_addr sip, unsigned src, uchar *pkt,
@@ -548,12 +606,38 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 				      (char *)pkt + i + 6, tftp_tsize);
 			}
 #endif
+			if (strcmp((char *)pkt + i, "windowsize") == 0) {
+				tftp_window_size = (unsigned short)
+					simple_strtoul((char *)pkt + i + 11,
+						       NULL, 10);
+				/* The server may only lower it */
+				tftp_window_size = clamp_t(unsigned short,
+						tftp_window_size, 1,
+						tftp_window_size_option);
+				debug("Windowsize ack: %s, %d\n",
+				      (char *)pkt + i + 11, tftp_window_size);
+			}
 		}
 #ifdef CONFIG_MCAST_TFTP
 		parse_multicast_oack((char *)pkt, len - 1);
-		if ((tftp_mcast_active) && (!tftp_mcast_master_client))
+		/* Multicast blocks come in any order */
+		if (tftp_mcast_active)
+			tftp_window_size = 1;
+		if ((tftp_mcast_active) && (!tftp_mcast_master_client)) {
 			tftp_state = STATE_DATA;	/* passive.. */
-		else
+		} else if (tftp_mcast_active && mcast_have_all()) {
+			/*
+			 * Made master-client with nothing left to ask for, so
+			 * only ACK the last block for the server to move on.
+			 */
+			tftp_state = STATE_DATA;
+			tftp_cur_block = tftp_mcast_ending_block;
+			tftp_send();
+			puts("\nMulticast tftp done\n");
+			mcast_cleanup();
+			net_set_state(NETLOOP_SUCCESS);
+			break;
+		} else
 #endif
 #ifdef CONFIG_CMD_TFTPPUT
 		if (tftp_put_active) {
@@ -568,6 +652,20 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		if (len < 2)
 			return;
 		len -= 2;
+
+		/* Windowed, anything but the next block means one got lost */
+		if (tftp_window_size > 1 &&
+		    (tftp_state == STATE_OACK || tftp_state == STATE_DATA)) {
+			ushort last = tftp_state == STATE_OACK ?
+				      0 : tftp_prev_block;
+
+			if (ntohs(*(__be16 *)pkt) != (ushort)(last + 1)) {
+				tftp_window_nack(last);
+				break;
+			}
+			tftp_window_nacked = 0;
+		}
+
 		tftp_cur_block = ntohs(*(__be16 *)pkt);
 
 		update_block_number();
@@ -595,6 +693,7 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 				net_start_again();
 				break;
 			}
+			tftp_window_pos = 0;
 		}
 
 		if (tftp_cur_block == tftp_prev_block) {
@@ -638,7 +737,12 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			}
 		}
 #endif
-		tftp_send();
+		/* Once per window, and for the last block */
+		if (++tftp_window_pos >= tftp_window_size ||
+		    len < tftp_block_size) {
+			tftp_window_pos = 0;
+			tftp_send();
+		}
 
 #ifdef CONFIG_MCAST_TFTP
 		if (tftp_mcast_active) {
@@ -690,6 +794,8 @@ static void tftp_timeout_handler(void)
 	} else {
 		puts("T ");
 		net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
+		/* The ACK of the last block has the server resend from there */
+		tftp_window_pos = 0;
 		if (tftp_state != STATE_RECV_WRQ)
 			tftp_send();
 	}
@@ -710,6 +816,10 @@ void tftp_start(enum proto_t protocol)
 	if (ep != NULL)
 		tftp_block_size_option = simple_strtol(ep, NULL, 10);
 
+	ep = env_get("tftpwindowsize");
+	if (ep != NULL)
+		tftp_window_size_option = simple_strtol(ep, NULL, 10);
+
 	ep = env_get("tftptimeout");
 	if (ep != NULL)
 		timeout_ms = simple_strtol(ep, NULL, 10);
@@ -731,8 +841,8 @@ void tftp_start(enum proto_t protocol)
 	}
 #endif
 
-	debug("TFTP blocksize = %i, timeout = %ld ms\n",
-	      tftp_block_size_option, timeout_ms);
+	debug("TFTP blocksize = %i, windowsize = %i, timeout = %ld ms\n",
+	      tftp_block_size_option, tftp_window_size_option, timeout_ms);
 
 	tftp_remote_ip = net_server_ip;
 	if (net_boot_file_name[0] == '\0') {
@@ -837,6 +947,10 @@ void tftp_start(enum proto_t protocol)
 	memset(net_server_ethaddr, 0, 6);
 	/* Revert tftp_block_size to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	/* Lock-step until the server agrees to a window */
+	tftp_window_size = 1;
+	tftp_window_pos = 0;
+	tftp_window_nacked = 0;
 #ifdef CONFIG_MCAST_TFTP
 	mcast_cleanup();
 #endif
@@ -866,6 +980,8 @@ void tftp_start_server(void)
 
 	/* Revert tftp_block_size to dflt */
 	tftp_block_size = TFTP_BLOCK_SIZE;
+	tftp_window_size = 1;
+	tftp_window_pos = 0;
 	tftp_cur_block = 0;
 	tftp_our_port = WELL_KNOWN_PORT;
 
@@ -951,6 +1067,14 @@ static void parse_multicast_oack(char *pkt, int len)
 		/* I malloc instead of pre-declare; so that if the file ends
 		 * up being too big for this bitmap I can retry
 		 */
+#ifdef CONFIG_TFTP_TSIZE
+		/* Or rather, size it for the file and never have to */
+		if (tftp_tsize)
+			tftp_mcast_bitmap_size = max_t(int,
+				tftp_mcast_bitmap_size,
+				ALIGN(tftp_tsize / tftp_block_size / 8 + 1,
+				      sizeof(*tftp_mcast_bitmap)));
+#endif
 		tftp_mcast_bitmap = malloc(tftp_mcast_bitmap_size);
 		if (!tftp_mcast_bitmap) {
 			printf("No bitmap, no multicast. Sorry.\n");
@@ -0,0 +1,167 @@
+# (C) Copyright 2024 Rockchip Electronics Co., Ltd
+#
+# SPDX-License-Identifier:	GPL-2.0+
+
+# Boot time regression test. The target is booted several times, the
+# "bootstage report" of each boot is collected and the median and a high
+# percentile of every stage are compared against a stored baseline.
+
+import json
+import os
+import pytest
+import re
+
+"""
+Note: The defaults suit any board with CONFIG_CMD_BOOTSTAGE. They can be
+changed from the boardenv_* file:
+
+env__bootstage_perf = {
+    # Number of boots to measure
+    "boots": 10,
+    # Baseline to compare against, by default in the persistent data
+    # directory, named after the board type and identity
+    "baseline": "/path/to/bootstage-baseline.json",
+    # Write the results of this run as the new baseline instead of comparing
+    "update_baseline": False,
+    # A stage regresses if its median grows by more than median_pct percent
+    # or its percentile by more than percentile_pct percent, and by more
+    # than min_delta_us in either case, which keeps short stages quiet
+    "percentile": 90,
+    "median_pct": 5,
+    "percentile_pct": 10,
+    "min_delta_us": 1000,
+    # Stages to compare, all those in the baseline if missing. Records
+    # from bootstage_mark_name() show up under their name, accumulated
+    # ones with an "accum:" prefix
+    "stages": ["main_loop", "accum:dm_r"],
+    # Commands run after each boot before the report, e.g. to take the
+    # phases of a boot script into the report
+    "commands": [],
+}
+
+The results of each run go to bootstage-perf.json in the result directory,
+which can be copied over the baseline once a change is accepted.
+"""
+
+re_mark = re.compile(r'^\s*([\d,]+)\s+([\d,]+)\s+(.+?)\s*$')
+re_accum = re.compile(r'^\s*([\d,]+)\s+(.+?)\s*$')
+
+def parse_report(output):
+    """Parse the output of "bootstage report".
+
+    Args:
+        output: The text the command printed.
+
+    Returns:
+        A dict with the time of each stage in microseconds: the time since
+        reset of the marks, and the total of the accumulated records, which
+        are prefixed with "accum:".
+    """
+
+    stages = {}
+    section = None
+    for line in output.splitlines():
+        if line.startswith('Timer summary'):
+            section = 'mark'
+            continue
+        if line.startswith('Accumulated time'):
+            section = 'accum'
+            continue
+        if not line.strip():
+            section = None
+            continue
+        if section == 'mark':
+            m = re_mark.match(line)
+            if m:
+                stages[m.group(3)] = int(m.group(1).replace(',', ''))
+        elif section == 'accum':
+            m = re_accum.match(line)
+            if m:
+                stages['accum:' + m.group(2)] = \
+                    int(m.group(1).replace(',', ''))
+    return stages
+
+def percentile(values, pct):
+    """Return the nearest rank percentile of a list of numbers."""
+
+    values = sorted(values)
+    return values[(len(values) - 1) * pct // 100]
+
+def summarize(boots, pct):
+    """Return the median and percentile of each stage over all boots.
+
+    Stages missing from some boots are summarized over those they are in.
+    """
+
+    times = {}
+    for boot in boots:
+        for name, us in boot.items():
+            times.setdefault(name, []).append(us)
+    return dict((name, {'median': percentile(v, 50),
+                        'percentile': percentile(v, pct),
+                        'count': len(v)})
+                for name, v in times.items())
+
+def regressions(result, baseline, cfg):
+    """List the stages of result that are slower than in baseline."""
+
+    stages = cfg.get('stages') or sorted(baseline.keys())
+    min_delta = cfg.get('min_delta_us', 1000)
+    bad = []
+    for name in stages:
+        if name not in baseline:
+            continue
+        if name not in result:
+            bad.append('%s: missing, it was in the baseline' % name)
+            continue
+        for key, limit in (('median', cfg.get('median_pct', 5)),
+                           ('percentile', cfg.get('percentile_pct', 10))):
+            old = baseline[name][key]
+            new = result[name][key]
+            if new - old > min_delta and new * 100 > old * (100 + limit):
+                bad.append('%s: %s %d us, baseline %d us (+%d%%)' %
+                           (name, key, new, old,
+                            (new - old) * 100 // max(old, 1)))
+    return bad
+
+@pytest.mark.buildconfigspec('cmd_bootstage')
+def test_bootstage_perf(u_boot_console):
+    """Boot repeatedly and compare the bootstage report with a baseline."""
+
+    cons = u_boot_console
+    cfg = cons.config.env.get('env__bootstage_perf', {})
+    nboots = cfg.get('boots', 5)
+    pct = cfg.get('percentile', 90)
+    baseline_file = cfg.get('baseline', os.path.join(
+        cons.config.persistent_data_dir, 'bootstage-baseline-%s-%s.json' %
+        (cons.config.board_type, cons.config.board_identity)))
+
+    boots = []
+    for i in range(nboots):
+        cons.restart_uboot()
+        for cmd in cfg.get('commands', []):
+            cons.run_command(cmd)
+        output = cons.run_command('bootstage report')
+        stages = parse_report(output)
+        assert stages, 'no stages in the bootstage report'
+        boots.append(stages)
+
+    result = summarize(boots, pct)
+    cons.log.info('%-32s %10s %10s' % ('Stage', 'Median(us)', 'P%d(us)' % pct))
+    for name in sorted(result.keys()):
+        cons.log.info('%-32s %10d %10d' % (name, result[name]['median'],
+                                           result[name]['percentile']))
+
+    with open(os.path.join(cons.config.result_dir, 'bootstage-perf.json'),
+              'w') as fh:
+        json.dump(result, fh, indent=2, sort_keys=True)
+
+    if cfg.get('update_baseline', False) or not os.path.exists(baseline_file):
+        with open(baseline_file, 'w') as fh:
+            json.dump(result, fh, indent=2, sort_keys=True)
+        pytest.skip('baseline written to %s' % baseline_file)
+
+    with open(baseline_file) as fh:
+        baseline = json.load(fh)
+    bad = regressions(result, baseline, cfg)
+    assert not bad, 'boot time regressions:\n' + '\n'.join(bad)
@@ -0,0 +1,209 @@
+#!/usr/bin/python
+#
+# (C) Copyright 2024 Rockchip Electronics Co., Ltd
+#
+# SPDX-License-Identifier:	GPL-2.0+
+#
+
+"""Cut an SPL device tree down to the nodes its drivers can use
+
+fdtgrep keeps every node marked u-boot,dm-pre-reloc, including those that
+no driver linked into this SPL binds to. Such nodes only cost SPL the time
+to load and scan them. The driver side is taken from the SPL binary itself:
+every compatible string a driver matches is in its of_match table, so a
+node none of whose compatible strings is in the binary can't be bound.
+
+A node is kept if:
+   - a compatible string of it is in the binary and it is not disabled
+   - it is a parent of a kept node
+   - it has no compatible string and its parent is kept, like the
+     partitions of a flash or the pin groups of a pin controller
+   - a kept node refers to it by phandle
+   - it is /chosen, /config or /aliases, or the stdout-path of /chosen
+
+Aliases of nodes which are dropped are dropped too.
+"""
+
+import struct
+
+import fdt
+
+# Nodes which are always kept, with their subnodes
+KEEP_PATHS = ['/chosen', '/config', '/aliases']
+
+# Properties which hold no phandles
+PROP_NO_PHANDLE = ['compatible', 'reg', 'status', 'phandle', 'linux,phandle']
+
+def node_compats(node):
+    """Get the compatible strings of a node
+
+    Args:
+        node: Node object
+
+    Returns:
+        List of compatible strings, empty if there are none
+    """
+    prop = node.props.get('compatible')
+    if not prop:
+        return []
+    if isinstance(prop.value, list):
+        return prop.value
+    return [prop.value]
+
+def node_disabled(node):
+    """Check whether a node has a status other than "okay" """
+    status = node.props.get('status')
+    return status is not None and status.value not in ('okay', 'ok')
+
+class DtbPrune:
+    """Works out which nodes of a device tree an SPL binary can use
+
+    Properties:
+        _fdt: Fdt object of the device tree
+        _binary: Contents of the SPL binary, without its device tree
+        _keep: Set of the paths of the nodes to keep
+    """
+    def __init__(self, dtb_fname, binary_fname):
+        self._fdt = fdt.FdtScan(dtb_fname)
+        with open(binary_fname, 'rb') as fd:
+            self._binary = fd.read()
+        self._keep = set()
+
+    def in_binary(self, compat):
+        """Check whether a compatible string is in the binary"""
+        return (compat.encode('utf-8') + b'\0') in self._binary
+
+    def keep(self, node):
+        """Keep a node, its parents and the nodes it refers to
+
+        Args:
+            node: Node object to keep
+        """
+        todo = [node]
+        while todo:
+            node = todo.pop()
+            if node.path in self._keep:
+                continue
+            self._keep.add(node.path)
+            if node.parent:
+                todo.append(node.parent)
+            todo += self.phandle_targets(node)
+            for subnode in node.subnodes:
+                if not node_compats(subnode):
+                    todo.append(subnode)
+
+    def phandle_targets(self, node):
+        """Get the nodes a node may refer to by phandle
+
+        Any cell of a property that happens to equal a phandle counts, so
+        this may keep a node too many but never one too few.
+
+        Args:
+            node: Node object
+
+        Returns:
+            List of Node objects
+        """
+        targets = []
+        for pname, prop in node.props.items():
+            if pname in PROP_NO_PHANDLE or pname[0] == '#':
+                continue
+            data = prop.bytes
+            if not data or len(data) % 4:
+                continue
+            for cell in struct.unpack('>%dI' % (len(data) // 4), data):
+                target = self._fdt.phandle_to_node.get(cell)
+                if target:
+                    targets.append(target)
+        return targets
+
+    def resolve_alias(self, name):
+        """Get a node from an alias or a path, or None"""
+        if not name.startswith('/'):
+            aliases = self._fdt.GetNode('/aliases')
+            prop = aliases.props.get(name) if aliases else None
+            if not prop:
+                return None
+            name = prop.value
+        return self._fdt.GetNode(name.rstrip('\0'))
+
+    def scan(self):
+        """Work out which nodes to keep"""
+        for path in KEEP_PATHS:
+            node = self._fdt.GetNode(path)
+            if node:
+                self.keep(node)
+
+        chosen = self._fdt.GetNode('/chosen')
+        stdout = chosen.props.get('stdout-path') if chosen else None
+        if stdout and not isinstance(stdout.value, list):
+            node = self.resolve_alias(stdout.value.split(':')[0])
+            if node:
+                self.keep(node)
+
+        self.scan_node(self._fdt.GetRoot())
+
+    def scan_node(self, root):
+        """Keep the nodes under a node which a driver can bind to"""
+        for node in root.subnodes:
+            compats = node_compats(node)
+            if (compats and not node_disabled(node) and
+                    any(self.in_binary(compat) for compat in compats)):
+                self.keep(node)
+            self.scan_node(node)
+
+    def prune(self):
+        """Delete the nodes which are not kept, and aliases to them
+
+        Returns:
+            List of the paths of the deleted nodes
+        """
+        self._keep.add('/')
+        dropped = []
+        self.collect_dropped(self._fdt.GetRoot(), dropped)
+        for node in dropped:
+            node.Delete()
+
+        paths = [node.path for node in dropped]
+        aliases = self._fdt.GetNode('/aliases')
+        if aliases:
+            for name, prop in list(aliases.props.items()):
+                if isinstance(prop.value, list):
+                    continue
+                target = prop.value.rstrip('\0')
+                if any(target == path or target.startswith(path + '/')
+                       for path in paths):
+                    aliases.DeleteProp(name)
+        self._fdt.Pack()
+        return paths
+
+    def collect_dropped(self, root, dropped):
+        """List the topmost nodes under a node which are not kept"""
+        for node in root.subnodes:
+            if node.path in self._keep:
+                self.collect_dropped(node, dropped)
+            else:
+                dropped.append(node)
+
+    def write(self, fname):
+        """Write the pruned device tree to a file"""
+        with open(fname, 'wb') as fd:
+            fd.write(self._fdt.GetFdt())
+
+def run_prune(dtb_file, binary_file, output):
+    """Cut a device tree down to the nodes an SPL binary can use
+
+    Args:
+        dtb_file: Filename of the device tree made by fdtgrep
+        binary_file: Filename of the SPL binary, without a device tree
+        output: Filename of the pruned device tree
+    """
+    if not binary_file:
+        raise ValueError('Please specify the SPL binary with -b')
+    if not output or output == '-':
+        raise ValueError('Please specify an output file with -o')
+
+    prune = DtbPrune(dtb_file, binary_file)
+    prune.scan()
+    prune.prune()
+    prune.write(output)
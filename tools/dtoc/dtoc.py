@@ -24,6 +24,10 @@ This tool is used in U-Boot to provide device tree data to SPL without
 increasing the code size of SPL. This supports the CONFIG_SPL_OF_PLATDATA
 options. For more information about the use of this options and tool please
 see doc/driver-model/of-plat.txt
+
+The 'prune' command instead writes a copy of the device tree without the
+nodes that no driver in a given SPL binary can bind to, for
+CONFIG_SPL_OF_PRUNE.
 """
 
 from optparse import OptionParser
@@ -36,6 +40,7 @@ our_path = os.path.dirname(os.path.realpath(__file__))
 sys.path.append(os.path.join(our_path, '../patman'))
 
 import dtb_platdata
+import dtb_prune
 
 def run_tests():
     """Run all the test we have for dtoc"""
@@ -57,6 +62,8 @@ if __name__ != '__main__':
     sys.exit(1)
 
 parser = OptionParser()
+parser.add_option('-b', '--binary', action='store',
+                  help='Specify the SPL binary for the prune command')
 parser.add_option('-d', '--dtb-file', action='store',
                   help='Specify the .dtb input file')
 parser.add_option('--include-disabled', action='store_true',
@@ -71,6 +78,9 @@ parser.add_option('-t', '--test', action='store_true', dest='test',
 if options.test:
     run_tests()
 
+elif args and args[0] == 'prune':
+    dtb_prune.run_prune(options.dtb_file, options.binary, options.output)
+
 else:
     dtb_platdata.run_steps(args, options.dtb_file, options.include_disabled,
                            options.output)
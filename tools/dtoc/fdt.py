@@ -257,6 +257,17 @@ class Node:
         del self.props[prop_name]
         self._fdt.Invalidate()
 
+    def Delete(self):
+        """Delete this node and its subnodes
+
+        The node is removed from its parent and the offset cache is
+        invalidated.
+        """
+        CheckErr(libfdt.fdt_del_node(self._fdt.GetFdt(), self.Offset()),
+                 "Node '%s': delete" % self.path)
+        self.parent.subnodes.remove(self)
+        self._fdt.Invalidate()
+
 class Fdt:
     """Provides simple access to a flat device tree blob using libfdts.
 
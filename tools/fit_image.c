@@ -452,6 +452,204 @@ err_buf:
 	return -1;
 }
 
+#define FIT_EXT_MAX_IMAGES	64
+
+/* A component image in the external data area */
+struct fit_ext_image {
+	const char *name;	/* image node name */
+	int buf_off;		/* where fit_extract_data() stashed the data */
+	int len;
+	unsigned int off;	/* data-offset or data-position */
+};
+
+static int fit_ext_find(struct fit_ext_image *ext, int count,
+			const char *name)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (!strcmp(ext[i].name, name))
+			return i;
+	}
+
+	return -1;
+}
+
+/* The image has data, in the FIT or already moved out of it */
+static bool fit_ext_has_data(const void *fdt, int node)
+{
+	return fdt_getprop(fdt, node, FIT_DATA_PROP, NULL) ||
+	       fdt_getprop(fdt, node, FIT_DATA_SIZE_PROP, NULL);
+}
+
+/* Append the data images named by @prop of a configuration, in order */
+static int fit_ext_add_prop(const void *fdt, int images, int conf,
+			    const char *prop, struct fit_ext_image *ext,
+			    int count, int max, bool *uboot)
+{
+	const char *name, *os;
+	int i, node;
+
+	for (i = 0;
+	     (name = fdt_stringlist_get(fdt, conf, prop, i, NULL));
+	     i++) {
+		node = fdt_subnode_offset(fdt, images, name);
+		if (node < 0 || !fit_ext_has_data(fdt, node))
+			continue;
+		os = fdt_getprop(fdt, node, FIT_OS_PROP, NULL);
+		if (uboot && os && !strcasecmp(os, "u-boot"))
+			*uboot = true;
+		if (fit_ext_find(ext, count, name) >= 0 || count == max)
+			continue;
+		ext[count].name = name;
+		count++;
+	}
+
+	return count;
+}
+
+/*
+ * Append the data images of a configuration in the order the loaders read
+ * them: SPL takes the firmware, then the loadables, with the FDT after the
+ * first U-Boot image; U-Boot boots the FDT, kernel and ramdisk.
+ */
+static int fit_ext_add_conf(const void *fdt, int images, int conf,
+			    struct fit_ext_image *ext, int count, int max)
+{
+	static const char *const rest[] = {
+		FIT_FDT_PROP, FIT_KERNEL_PROP, FIT_RAMDISK_PROP,
+		FIT_MULTI_PROP, FIT_FPGA_PROP, FIT_SETUP_PROP,
+		FIT_STANDALONE_PROP,
+	};
+	bool uboot = false, spl;
+	const char *name;
+	int i;
+
+	spl = fdt_getprop(fdt, conf, FIT_FIRMWARE_PROP, NULL) ||
+	      fdt_getprop(fdt, conf, FIT_LOADABLE_PROP, NULL);
+	if (spl) {
+		count = fit_ext_add_prop(fdt, images, conf, FIT_FIRMWARE_PROP,
+					 ext, count, max, &uboot);
+		if (uboot)
+			count = fit_ext_add_prop(fdt, images, conf,
+						 FIT_FDT_PROP, ext, count, max,
+						 NULL);
+		for (i = 0;
+		     (name = fdt_stringlist_get(fdt, conf, FIT_LOADABLE_PROP,
+						i, NULL));
+		     i++) {
+			int node = fdt_subnode_offset(fdt, images, name);
+			const char *os;
+
+			if (node < 0 || !fit_ext_has_data(fdt, node))
+				continue;
+			if (fit_ext_find(ext, count, name) < 0 && count < max)
+				ext[count++].name = name;
+			os = fdt_getprop(fdt, node, FIT_OS_PROP, NULL);
+			if (!uboot && os && !strcasecmp(os, "u-boot")) {
+				uboot = true;
+				count = fit_ext_add_prop(fdt, images, conf,
+							 FIT_FDT_PROP, ext,
+							 count, max, NULL);
+			}
+		}
+	}
+	for (i = 0; i < ARRAY_SIZE(rest); i++)
+		count = fit_ext_add_prop(fdt, images, conf, rest[i], ext,
+					 count, max, NULL);
+
+	return count;
+}
+
+/*
+ * Work out the order of the external data: the images of the default
+ * configuration, those of the other configurations, then the rest in node
+ * order. Without -B the data stays in node order, as it always was.
+ */
+static int fit_ext_order(struct image_tool_params *params, const void *fdt,
+			 int images, struct fit_ext_image *ext, int max)
+{
+	const char *def = NULL;
+	int confs, conf, node;
+	int count = 0;
+
+	confs = fdt_path_offset(fdt, FIT_CONFS_PATH);
+	if (params->external_align && confs >= 0) {
+		def = fdt_getprop(fdt, confs, FIT_DEFAULT_PROP, NULL);
+		conf = def ? fdt_subnode_offset(fdt, confs, def) : -1;
+		if (conf >= 0)
+			count = fit_ext_add_conf(fdt, images, conf, ext, count,
+						 max);
+		fdt_for_each_subnode(conf, fdt, confs)
+			count = fit_ext_add_conf(fdt, images, conf, ext, count,
+						 max);
+	}
+
+	fdt_for_each_subnode(node, fdt, images) {
+		const char *name = fit_get_name(fdt, node, NULL);
+
+		if (!fdt_getprop(fdt, node, FIT_DATA_PROP, NULL) ||
+		    fit_ext_find(ext, count, name) >= 0)
+			continue;
+		if (count == max)
+			return -E2BIG;
+		ext[count++].name = name;
+	}
+
+	return count;
+}
+
+/*
+ * Record in each configuration the span of the external data it uses, so
+ * that a loader can read all of it at once: data-extent = <offset size>,
+ * from the start of the FIT like data-position.
+ */
+static int fit_ext_set_extents(void *fdt, int images,
+			       struct fit_ext_image *ext, int count,
+			       unsigned int base, bool placeholder)
+{
+	struct fit_ext_image order[FIT_EXT_MAX_IMAGES];
+	unsigned int start, end;
+	fdt32_t extent[2];
+	int confs, conf, n, i, j;
+	int ret;
+
+	confs = fdt_path_offset(fdt, FIT_CONFS_PATH);
+	if (confs < 0)
+		return 0;
+
+	fdt_for_each_subnode(conf, fdt, confs) {
+		start = ~0U;
+		end = 0;
+		n = fit_ext_add_conf(fdt, images, conf, order, 0,
+				     FIT_EXT_MAX_IMAGES);
+		for (i = 0; i < n; i++) {
+			j = fit_ext_find(ext, count, order[i].name);
+			if (j < 0)
+				continue;
+			if (base + ext[j].off < start)
+				start = base + ext[j].off;
+			if (base + ext[j].off + ext[j].len > end)
+				end = base + ext[j].off + ext[j].len;
+		}
+		if (!end)
+			continue;
+		extent[0] = cpu_to_fdt32(start);
+		extent[1] = cpu_to_fdt32(end - start);
+		if (placeholder)
+			ret = fdt_setprop(fdt, conf, FIT_DATA_EXTENT_PROP,
+					  extent, sizeof(extent));
+		else
+			ret = fdt_setprop_inplace(fdt, conf,
+						  FIT_DATA_EXTENT_PROP,
+						  extent, sizeof(extent));
+		if (ret)
+			return -EPERM;
+	}
+
+	return 0;
+}
+
 /**
  * fit_extract_data() - Move all data outside the FIT
  *
@@ -460,22 +658,31 @@ err_buf:
  * using an offset into that area. The 'data' properties turn into
  * 'data-offset' properties.
  *
+ * With -B the images are placed in the order the loaders read them, each
+ * on a multiple of the given alignment from the start of the FIT, and
+ * every configuration gets a 'data-extent' property with the span of its
+ * data, for one sequential read from storage.
+ *
  * This function cannot cope with FITs with 'data-offset' properties. All
  * data must be in 'data' properties on entry.
  */
 static int fit_extract_data(struct image_tool_params *params, const char *fname)
 {
-	void *buf;
-	int buf_ptr;
+	struct fit_ext_image ext[FIT_EXT_MAX_IMAGES];
+	unsigned int base, pos;
+	void *buf, *out = NULL;
+	int buf_ptr, out_size;
 	int fit_size, new_size;
 	int fd;
 	struct stat sbuf;
 	void *fdt;
 	int ret;
 	int images;
-	int node;
+	int count = 0, i;
 
-	fd = mmap_fdt(params->cmdname, fname, 0x400, &fdt, &sbuf, false);
+	fd = mmap_fdt(params->cmdname, fname,
+		      params->external_align ? 0x1000 : 0x400, &fdt, &sbuf,
+		      false);
 	if (fd < 0)
 		return -EIO;
 	fit_size = fdt_totalsize(fdt);
@@ -494,17 +701,39 @@ static int fit_extract_data(struct image_tool_params *params, const char *fname)
 		ret = -EINVAL;
 		goto err_munmap;
 	}
+	count = fit_ext_order(params, fdt, images, ext, FIT_EXT_MAX_IMAGES);
+	if (count < 0) {
+		printf("Failed: more than %d images with external data\n",
+		       FIT_EXT_MAX_IMAGES);
+		ret = count;
+		goto err_munmap;
+	}
 
-	for (node = fdt_first_subnode(fdt, images);
-	     node >= 0;
-	     node = fdt_next_subnode(fdt, node)) {
+	/* The FDT is about to change under the names */
+	for (i = 0; i < count; i++) {
+		ext[i].name = strdup(ext[i].name);
+		if (!ext[i].name) {
+			count = i;
+			ret = -ENOMEM;
+			goto err_munmap;
+		}
+	}
+
+	/*
+	 * Stash the data and put placeholders in its place, the offsets are
+	 * only known once the FIT is packed
+	 */
+	for (i = 0; i < count; i++) {
 		const char *data;
-		int len;
+		int node, len;
 
+		node = fdt_subnode_offset(fdt, images, ext[i].name);
 		data = fdt_getprop(fdt, node, "data", &len);
-		if (!data)
-			continue;
 		memcpy(buf + buf_ptr, data, len);
+		ext[i].buf_off = buf_ptr;
+		ext[i].len = len;
+		ext[i].off = 0;
+		buf_ptr += FIT_ALIGN(len);
 		debug("Extracting data size %x\n", len);
 
 		ret = fdt_delprop(fdt, node, "data");
@@ -512,25 +741,65 @@ static int fit_extract_data(struct image_tool_params *params, const char *fname)
 			ret = -EPERM;
 			goto err_munmap;
 		}
-		if (params->external_offset > 0) {
-			/* An external offset positions the data absolutely. */
-			fdt_setprop_u32(fdt, node, "data-position",
-					params->external_offset + buf_ptr);
-		} else {
-			fdt_setprop_u32(fdt, node, "data-offset", buf_ptr);
-		}
+		fdt_setprop_u32(fdt, node, params->external_offset > 0 ?
+				"data-position" : "data-offset", 0);
 		fdt_setprop_u32(fdt, node, "data-size", len);
-
-		buf_ptr += FIT_ALIGN(len);
+	}
+	if (params->external_align) {
+		ret = fit_ext_set_extents(fdt, images, ext, count, 0, true);
+		if (ret)
+			goto err_munmap;
 	}
 
 	/* Pack the FDT and place the data after it */
 	fdt_pack(fdt);
 
 	debug("Size reduced from %x to %x\n", fit_size, fdt_totalsize(fdt));
-	debug("External data size %x\n", buf_ptr);
 	new_size = fdt_totalsize(fdt);
 	new_size = FIT_ALIGN(new_size);
+
+	/*
+	 * An external offset positions the data absolutely, otherwise it is
+	 * relative to the end of the FIT. Either way the alignment is from
+	 * the start of the FIT, which is where the storage blocks start.
+	 */
+	base = params->external_offset > 0 ? 0 : new_size;
+	pos = params->external_offset > 0 ? params->external_offset : new_size;
+	for (i = 0; i < count; i++) {
+		int node = fdt_subnode_offset(fdt, images, ext[i].name);
+
+		if (params->external_align)
+			pos = ALIGN(pos, params->external_align);
+		ext[i].off = pos - base;
+		fdt_setprop_inplace_u32(fdt, node,
+					params->external_offset > 0 ?
+					"data-position" : "data-offset",
+					ext[i].off);
+		pos += FIT_ALIGN(ext[i].len);
+	}
+	if (params->external_align) {
+		ret = fit_ext_set_extents(fdt, images, ext, count,
+					  params->external_offset > 0 ? 0 :
+					  new_size, false);
+		if (ret)
+			goto err_munmap;
+	}
+
+	/* The external data, with the padding between images */
+	base = params->external_offset > 0 ? params->external_offset : new_size;
+	out_size = pos - base;
+	debug("External data size %x\n", out_size);
+	out = calloc(1, out_size ? out_size : 1);
+	if (!out) {
+		ret = -ENOMEM;
+		goto err_munmap;
+	}
+	for (i = 0; i < count; i++) {
+		unsigned int at = ext[i].off -
+			(params->external_offset > 0 ? base : 0);
+
+		memcpy(out + at, buf + ext[i].buf_off, ext[i].len);
+	}
 	munmap(fdt, sbuf.st_size);
 
 	if (ftruncate(fd, new_size)) {
@@ -556,22 +825,28 @@ static int fit_extract_data(struct image_tool_params *params, const char *fname)
 		ret = -EIO;
 		goto err;
 	}
-	if (write(fd, buf, buf_ptr) != buf_ptr) {
+	if (write(fd, out, out_size) != out_size) {
 		debug("%s: Failed to write external data to file %s\n",
 		      __func__, strerror(errno));
 		ret = -EIO;
 		goto err;
 	}
+	free(out);
 	free(buf);
 	close(fd);
+	while (count--)
+		free((char *)ext[count].name);
 	return 0;
 
 err_munmap:
 	munmap(fdt, sbuf.st_size);
 err:
+	free(out);
 	if (buf)
 		free(buf);
 	close(fd);
+	while (count-- > 0)
+		free((char *)ext[count].name);
 	return ret;
 }
 
@@ -874,6 +1149,9 @@ static int fit_extract_contents(void *ptr, struct image_tool_params *params)
 
 static int fit_check_params(struct image_tool_params *params)
 {
+	/* -B lays out the external data, which needs -E */
+	if (params->external_align && !params->external_data)
+		return 1;
 	if (params->auto_its)
 		return 0;
 	return	((params->dflag && (params->fflag || params->lflag)) ||
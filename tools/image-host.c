@@ -13,6 +13,181 @@
 #include <bootm.h>
 #include <image.h>
 #include <version.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define FIT_HASH_MAX_THREADS	16
+
+/**
+ * struct fit_hash_job - hash of an image node, computed before it is stored
+ *
+ * All hashes of a FIT are worked out on several threads before the first
+ * one goes into the blob, since storing a value moves the data around.
+ * They are kept for the next fit_add_verification_data() call: mkimage
+ * calls it again on the same images each time the blob has to grow.
+ *
+ * @image_name:	Name of the image node
+ * @node_name:	Name of the hash node
+ * @algo:	Hash algorithm
+ * @data:	Image data, only valid until the blob changes
+ * @size:	Size of the image data
+ * @value:	Hash value
+ * @value_len:	Length of @value
+ * @ret:	Result of calculate_hash()
+ * @done:	@value and @ret are set
+ */
+struct fit_hash_job {
+	char *image_name;
+	char *node_name;
+	char *algo;
+	const void *data;
+	size_t size;
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int value_len;
+	int ret;
+	bool done;
+};
+
+static struct fit_hash_job *fit_hash_jobs;
+static int fit_hash_count;
+static int fit_hash_next;
+static pthread_mutex_t fit_hash_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct fit_hash_job *fit_hash_find(const char *image_name,
+					  const char *node_name,
+					  const char *algo, size_t size)
+{
+	struct fit_hash_job *job;
+	int i;
+
+	for (i = 0; i < fit_hash_count; i++) {
+		job = &fit_hash_jobs[i];
+		if (job->size == size && !strcmp(job->image_name, image_name) &&
+		    !strcmp(job->node_name, node_name) &&
+		    !strcmp(job->algo, algo))
+			return job;
+	}
+
+	return NULL;
+}
+
+static int fit_hash_add(const char *image_name, const char *node_name,
+			const char *algo, const void *data, size_t size)
+{
+	struct fit_hash_job *jobs, *job;
+
+	if (fit_hash_find(image_name, node_name, algo, size))
+		return 0;
+
+	jobs = realloc(fit_hash_jobs, (fit_hash_count + 1) * sizeof(*jobs));
+	if (!jobs)
+		return -ENOMEM;
+	fit_hash_jobs = jobs;
+	job = &jobs[fit_hash_count];
+	memset(job, '\0', sizeof(*job));
+	job->image_name = strdup(image_name);
+	job->node_name = strdup(node_name);
+	job->algo = strdup(algo);
+	if (!job->image_name || !job->node_name || !job->algo)
+		return -ENOMEM;
+	job->data = data;
+	job->size = size;
+	fit_hash_count++;
+
+	return 0;
+}
+
+static void *fit_hash_worker(void *arg)
+{
+	struct fit_hash_job *job;
+
+	for (;;) {
+		pthread_mutex_lock(&fit_hash_lock);
+		while (fit_hash_next < fit_hash_count &&
+		       fit_hash_jobs[fit_hash_next].done)
+			fit_hash_next++;
+		job = fit_hash_next < fit_hash_count ?
+			&fit_hash_jobs[fit_hash_next++] : NULL;
+		pthread_mutex_unlock(&fit_hash_lock);
+		if (!job)
+			break;
+
+		job->ret = calculate_hash(job->data, job->size, job->algo,
+					  job->value, &job->value_len);
+	}
+
+	return NULL;
+}
+
+/**
+ * fit_hash_images() - compute the hashes of all images of a FIT
+ *
+ * Hashes already computed by an earlier call for the same image, hash node,
+ * algorithm and data size are reused. The others are spread over one
+ * thread per CPU.
+ *
+ * @fit:		FIT blob, which must not change until this returns
+ * @images_noffset:	Offset of the images node
+ * @return 0 if OK, -ve on error. Errors of the hashes themselves are left
+ * for fit_image_process_hash() to report.
+ */
+static int fit_hash_images(void *fit, int images_noffset)
+{
+	pthread_t threads[FIT_HASH_MAX_THREADS];
+	int image_noffset, noffset;
+	int first = fit_hash_count;
+	int nthreads, i, ret;
+	const char *image_name, *node_name;
+	const void *data;
+	size_t size;
+	char *algo;
+	long ncpus;
+
+	for (image_noffset = fdt_first_subnode(fit, images_noffset);
+	     image_noffset >= 0;
+	     image_noffset = fdt_next_subnode(fit, image_noffset)) {
+		if (fit_image_get_data(fit, image_noffset, &data, &size))
+			continue;
+		image_name = fit_get_name(fit, image_noffset, NULL);
+		for (noffset = fdt_first_subnode(fit, image_noffset);
+		     noffset >= 0;
+		     noffset = fdt_next_subnode(fit, noffset)) {
+			node_name = fit_get_name(fit, noffset, NULL);
+			if (strncmp(node_name, FIT_HASH_NODENAME,
+				    strlen(FIT_HASH_NODENAME)) ||
+			    fit_image_hash_get_algo(fit, noffset, &algo))
+				continue;
+			ret = fit_hash_add(image_name, node_name, algo, data,
+					   size);
+			if (ret)
+				return ret;
+		}
+	}
+
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	nthreads = fit_hash_count - first;
+	if (nthreads > FIT_HASH_MAX_THREADS)
+		nthreads = FIT_HASH_MAX_THREADS;
+	if (ncpus > 0 && ncpus < nthreads)
+		nthreads = ncpus;
+
+	fit_hash_next = first;
+	for (i = 0; i < nthreads - 1; i++) {
+		if (pthread_create(&threads[i], NULL, fit_hash_worker, NULL))
+			break;
+	}
+	/* This thread takes its share too, and all of them if none started */
+	fit_hash_worker(NULL);
+	while (i--)
+		pthread_join(threads[i], NULL);
+
+	for (i = first; i < fit_hash_count; i++) {
+		fit_hash_jobs[i].data = NULL;
+		fit_hash_jobs[i].done = true;
+	}
+
+	return 0;
+}
 
 /**
  * fit_set_hash_value - set hash value in requested has node
@@ -61,7 +236,9 @@ static int fit_image_process_hash(void *fit, const char *image_name,
 		int noffset, const void *data, size_t size)
 {
 	uint8_t value[FIT_MAX_HASH_LEN];
+	struct fit_hash_job *job;
 	const char *node_name;
+	uint8_t *hash = value;
 	int value_len;
 	char *algo;
 	int ret;
@@ -74,13 +251,22 @@ static int fit_image_process_hash(void *fit, const char *image_name,
 		return -ENOENT;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
+	/* Normally fit_hash_images() has done it already */
+	job = fit_hash_find(image_name, node_name, algo, size);
+	if (job && job->done) {
+		ret = job->ret;
+		hash = job->value;
+		value_len = job->value_len;
+	} else {
+		ret = calculate_hash(data, size, algo, value, &value_len);
+	}
+	if (ret) {
 		printf("Unsupported hash algorithm (%s) for '%s' hash node in '%s' image node\n",
 		       algo, node_name, image_name);
 		return -EPROTONOSUPPORT;
 	}
 
-	ret = fit_set_hash_value(fit, noffset, value, value_len);
+	ret = fit_set_hash_value(fit, noffset, hash, value_len);
 	if (ret) {
 		printf("Can't set hash value for '%s' hash node in '%s' image node\n",
 		       node_name, image_name);
@@ -694,6 +880,10 @@ int fit_add_verification_data(const char *keydir, void *keydest, void *fit,
 		return images_noffset;
 	}
 
+	ret = fit_hash_images(fit, images_noffset);
+	if (ret)
+		return ret;
+
 	/* Process its subnodes, print out component images details */
 	for (noffset = fdt_first_subnode(fit, images_noffset);
 	     noffset >= 0;
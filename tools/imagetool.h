@@ -77,6 +77,7 @@ struct image_tool_params {
 	bool external_data;	/* Store data outside the FIT */
 	bool quiet;		/* Don't output text in normal operation */
 	unsigned int external_offset;	/* Add padding to external data */
+	unsigned int external_align;	/* Lay external data out for reads */
 	const char *engine_id;	/* Engine to use for signing */
 	char *extraparams;	/* Extra parameters for img creation (-X) */
 };
@@ -0,0 +1,279 @@
+/*
+ * (C) Copyright 2024 Rockchip Electronics Co., Ltd
+ *
+ * SPDX-License-Identifier:     GPL-2.0+
+ *
+ * Convert a BMP logo to a raw logo, see <rk_logo.h>, for U-Boot to scan
+ * out without decoding it. Put the output in resource.img under the name
+ * of the BMP it replaces, e.g. logo.bmp.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <rk_logo.h>
+
+#define RK_BLK_SIZE	512
+#define ALIGN(x, y)	(((x) + (y) - 1) & ~((y) - 1))
+
+struct bmp_header {
+	/* Header */
+	char signature[2];
+	uint32_t	file_size;
+	uint32_t	reserved;
+	uint32_t	data_offset;
+	/* InfoHeader */
+	uint32_t	size;
+	int32_t		width;
+	int32_t		height;
+	uint16_t	planes;
+	uint16_t	bit_count;
+	uint32_t	compression;
+	uint32_t	image_size;
+	uint32_t	x_pixels_per_m;
+	uint32_t	y_pixels_per_m;
+	uint32_t	colors_used;
+	uint32_t	colors_important;
+	/* ColorTable */
+} __attribute__((packed));
+
+static const char *PROG;
+
+static void usage(void)
+{
+	printf("Usage: %s [options] <input.bmp> <output>\n\n", PROG);
+	printf("\t --bpp 16|24|32");
+	printf("\t\t Pixel format: RGB565, RGB888 or ARGB8888 (default 32)\n");
+	printf("\t --rotate 0|90|180|270");
+	printf("\t Rotate clockwise, as logo,rotate does (default 0)\n");
+	printf("\t --lz4");
+	printf("\t\t\t Compress the pixels with the lz4 command\n");
+}
+
+static void *read_file(const char *path, long *size)
+{
+	FILE *f;
+	void *buf;
+
+	f = fopen(path, "rb");
+	if (!f)
+		return NULL;
+	fseek(f, 0, SEEK_END);
+	*size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	buf = malloc(*size);
+	if (buf && fread(buf, 1, *size, f) != *size) {
+		free(buf);
+		buf = NULL;
+	}
+	fclose(f);
+
+	return buf;
+}
+
+/* The B, G, R bytes of pixel (x, y), counted top-down */
+static const uint8_t *bmp_pixel(const uint8_t *bmp, const struct bmp_header *hdr,
+				int x, int y)
+{
+	const uint8_t *bits = bmp + hdr->data_offset;
+	const uint8_t *palette = bmp + 14 + hdr->size;
+	int bytes = hdr->bit_count / 8;
+	int height = abs(hdr->height);
+	int stride = ALIGN(hdr->width * hdr->bit_count, 32) / 8;
+
+	if (hdr->height > 0)
+		y = height - 1 - y;
+	bits += (long)y * stride + (long)x * bytes;
+
+	return hdr->bit_count == 8 ? palette + *bits * 4 : bits;
+}
+
+static void put_pixel(uint8_t *dst, const uint8_t *bgr, int bpp)
+{
+	uint16_t rgb565;
+
+	switch (bpp) {
+	case 16:
+		rgb565 = ((bgr[2] >> 3) << 11) | ((bgr[1] >> 2) << 5) |
+			 (bgr[0] >> 3);
+		dst[0] = rgb565;
+		dst[1] = rgb565 >> 8;
+		break;
+	case 24:
+		memcpy(dst, bgr, 3);
+		break;
+	default:
+		memcpy(dst, bgr, 3);
+		dst[3] = 0xff;
+		break;
+	}
+}
+
+static int compress_lz4(const char *out, uint8_t **data, uint32_t *size)
+{
+	char raw[1024], lz4[1024], cmd[4096];
+	FILE *f;
+	long len;
+	int ret;
+
+	snprintf(raw, sizeof(raw), "%s.raw.tmp", out);
+	snprintf(lz4, sizeof(lz4), "%s.lz4.tmp", out);
+	f = fopen(raw, "wb");
+	if (!f)
+		return -errno;
+	ret = fwrite(*data, 1, *size, f) != *size;
+	fclose(f);
+	if (ret)
+		return -EIO;
+
+	/* U-Boot's ulz4fn() takes frames of independent blocks */
+	snprintf(cmd, sizeof(cmd), "lz4 -q -f -9 --no-frame-crc '%s' '%s'",
+		 raw, lz4);
+	ret = system(cmd);
+	unlink(raw);
+	if (ret) {
+		fprintf(stderr, "%s: '%s' failed\n", PROG, cmd);
+		unlink(lz4);
+		return -EINVAL;
+	}
+
+	free(*data);
+	*data = read_file(lz4, &len);
+	unlink(lz4);
+	if (!*data)
+		return -EIO;
+	*size = len;
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct rk_raw_logo_header raw;
+	const struct bmp_header *hdr;
+	const char *in = NULL, *out = NULL;
+	int bpp = 32, rotate = 0, lz4 = 0;
+	int width, height, rwidth, rheight, x, y, rx, ry;
+	uint32_t stride, size;
+	uint8_t *bmp, *data, pad[RK_BLK_SIZE] = { 0 };
+	long len;
+	FILE *f;
+	int i;
+
+	PROG = argv[0];
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--bpp") && i + 1 < argc) {
+			bpp = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--rotate") && i + 1 < argc) {
+			rotate = atoi(argv[++i]);
+		} else if (!strcmp(argv[i], "--lz4")) {
+			lz4 = 1;
+		} else if (!in) {
+			in = argv[i];
+		} else if (!out) {
+			out = argv[i];
+		} else {
+			usage();
+			return 1;
+		}
+	}
+	if (!in || !out || (bpp != 16 && bpp != 24 && bpp != 32) ||
+	    (rotate != 0 && rotate != 90 && rotate != 180 && rotate != 270)) {
+		usage();
+		return 1;
+	}
+
+	bmp = read_file(in, &len);
+	if (!bmp || len < sizeof(*hdr)) {
+		fprintf(stderr, "%s: can't read %s\n", PROG, in);
+		return 1;
+	}
+	hdr = (const struct bmp_header *)bmp;
+	if (memcmp(hdr->signature, "BM", 2) || hdr->compression ||
+	    (hdr->bit_count != 8 && hdr->bit_count != 24 &&
+	     hdr->bit_count != 32)) {
+		fprintf(stderr, "%s: %s is not an uncompressed 8, 24 or 32 bits BMP\n",
+			PROG, in);
+		return 1;
+	}
+	width = hdr->width;
+	height = abs(hdr->height);
+	if (hdr->data_offset +
+	    (long)ALIGN(width * hdr->bit_count, 32) / 8 * height > len) {
+		fprintf(stderr, "%s: %s is truncated\n", PROG, in);
+		return 1;
+	}
+
+	rwidth = rotate % 180 ? height : width;
+	rheight = rotate % 180 ? width : height;
+	stride = ALIGN(rwidth * bpp, 32) / 8;
+	size = stride * rheight;
+	data = calloc(1, size);
+	if (!data)
+		return 1;
+
+	/* Clockwise, as rockchip_logo_rotate() does it */
+	for (y = 0; y < height; y++) {
+		for (x = 0; x < width; x++) {
+			switch (rotate) {
+			case 90:
+				rx = height - 1 - y;
+				ry = x;
+				break;
+			case 180:
+				rx = width - 1 - x;
+				ry = height - 1 - y;
+				break;
+			case 270:
+				rx = y;
+				ry = width - 1 - x;
+				break;
+			default:
+				rx = x;
+				ry = y;
+				break;
+			}
+			put_pixel(data + ry * stride + rx * bpp / 8,
+				  bmp_pixel(bmp, hdr, x, y), bpp);
+		}
+	}
+
+	if (lz4 && compress_lz4(out, &data, &size))
+		return 1;
+
+	memset(&raw, 0, sizeof(raw));
+	memcpy(raw.magic, RK_RAW_LOGO_MAGIC, sizeof(raw.magic));
+	raw.width = rwidth;
+	raw.height = rheight;
+	raw.bpp = bpp;
+	raw.rotate = rotate;
+	raw.stride = stride;
+	raw.flags = lz4 ? RK_RAW_LOGO_LZ4 : 0;
+	/* Block aligned, for U-Boot to read the pixels where they go */
+	raw.data_offset = RK_BLK_SIZE;
+	raw.data_size = size;
+
+	f = fopen(out, "wb");
+	if (!f) {
+		fprintf(stderr, "%s: can't create %s\n", PROG, out);
+		return 1;
+	}
+	memcpy(pad, &raw, sizeof(raw));
+	if (fwrite(pad, 1, RK_BLK_SIZE, f) != RK_BLK_SIZE ||
+	    fwrite(data, 1, size, f) != size) {
+		fprintf(stderr, "%s: can't write %s\n", PROG, out);
+		fclose(f);
+		return 1;
+	}
+	fclose(f);
+
+	printf("%s: %dx%d, %d bpp, rotated %d, %u bytes%s\n", out, rwidth,
+	       rheight, bpp, rotate, size, lz4 ? " (lz4)" : "");
+	free(data);
+	free(bmp);
+
+	return 0;
+}
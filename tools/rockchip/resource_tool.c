@@ -5,12 +5,15 @@
 
 #include <errno.h>
 #include <memory.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
 
 /**
  * \brief	   SHA-1 context structure
@@ -614,6 +617,38 @@ typedef struct {
 	uint32_t content_size;   /* bytes, size of resource content. */
 } index_tbl_entry;
 
+/* sync with arch/arm/include/asm/arch-rockchip/rk_hwid.h */
+#define HWID_INDEX_FILE "hwid-dtb.idx"
+#define HWID_INDEX_MAGIC "HWID"
+#define HWID_INDEX_VERSION 0
+#define HWID_INDEX_MAX_CONDS 8
+#define HWID_COND_ADC 1
+#define HWID_COND_GPIO 2
+#define HWID_KEY_ADC_CTRL "#_"
+#define HWID_KEY_ADC_CH "_ch"
+#define HWID_KEY_GPIO "#gpio"
+
+typedef struct {
+	char adc_ctrl[32]; /* adc controller name */
+	uint8_t type;
+	uint8_t id;       /* adc channel, or gpio port */
+	uint8_t bank;     /* gpio only */
+	uint8_t pin;      /* gpio only */
+	uint32_t value;   /* adc value, or gpio level */
+} hwid_index_cond;
+
+typedef struct {
+	char name[MAX_INDEX_ENTRY_PATH_LEN]; /* entry path */
+	uint32_t nr_conds;
+	hwid_index_cond conds[HWID_INDEX_MAX_CONDS];
+} hwid_index_dtb;
+
+typedef struct {
+	char magic[4]; /* tag, "HWID" */
+	uint16_t version;
+	uint16_t nr_dtbs;
+} hwid_index_header;
+
 #define OPT_VERBOSE "--verbose"
 #define OPT_HELP "--help"
 #define OPT_VERSION "--version"
@@ -1434,7 +1469,9 @@ static int write_file(int offset_block, const char *src_path,
 	if (!write_data(offset_block, buf, file_size))
 		goto end;
 
-	if (hash_size == 20)
+	if (!hash_size)
+		; /* hashed by hash_files() */
+	else if (hash_size == 20)
 		sha1_csum((const unsigned char *)buf, file_size,
 			  (unsigned char *)hash);
 	else if (hash_size == 32)
@@ -1453,6 +1490,254 @@ end:
 	return ret;
 }
 
+#define MAX_HASH_THREADS 16
+
+typedef struct {
+	const char *path;
+	char hash[20];	/* sha1 */
+	int ret;	/* file size, or -1 */
+} hash_job;
+
+static hash_job *hash_jobs;
+static int hash_job_num;
+static int hash_job_next;
+static pthread_mutex_t hash_job_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void *hash_worker(void *arg)
+{
+	hash_job *job;
+	FILE *file;
+	char *buf;
+	int size;
+
+	for (;;) {
+		pthread_mutex_lock(&hash_job_lock);
+		job = hash_job_next < hash_job_num ?
+			&hash_jobs[hash_job_next++] : NULL;
+		pthread_mutex_unlock(&hash_job_lock);
+		if (!job)
+			break;
+
+		job->ret = -1;
+		size = get_file_size(job->path);
+		if (size < 0)
+			continue;
+		buf = calloc(size ? size : 1, 1);
+		file = fopen(job->path, "rb");
+		if (buf && file && (!size || fread(buf, size, 1, file))) {
+			sha1_csum((const unsigned char *)buf, size,
+				  (unsigned char *)job->hash);
+			job->ret = size;
+		} else {
+			LOGE("Failed to read:%s", job->path);
+		}
+		if (file)
+			fclose(file);
+		free(buf);
+	}
+
+	return NULL;
+}
+
+/*
+ * Hash all files to pack up front, one thread per cpu, so that the
+ * images of a resource with many dtbs and logos are hashed concurrently.
+ * write_file() then only copies them.
+ */
+static bool hash_files(int file_num, const char **files, hash_job *jobs)
+{
+	pthread_t threads[MAX_HASH_THREADS];
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	int threads_num = file_num;
+	int i;
+
+	if (threads_num > MAX_HASH_THREADS)
+		threads_num = MAX_HASH_THREADS;
+	if (cpus > 0 && cpus < threads_num)
+		threads_num = cpus;
+
+	for (i = 0; i < file_num; i++)
+		jobs[i].path = files[i];
+	hash_jobs = jobs;
+	hash_job_num = file_num;
+	hash_job_next = 0;
+
+	for (i = 0; i < threads_num - 1; i++) {
+		if (pthread_create(&threads[i], NULL, hash_worker, NULL))
+			break;
+	}
+	/* This thread hashes too, and all files if no thread started */
+	hash_worker(NULL);
+	while (i--)
+		pthread_join(threads[i], NULL);
+
+	for (i = 0; i < file_num; i++) {
+		if (jobs[i].ret < 0)
+			return false;
+	}
+
+	return true;
+}
+
+static const char *get_entry_path(const char *file, bool *foundFdt)
+{
+	const char *path = file;
+
+	if (root_path[0]) {
+		if (!strncmp(path, root_path, strlen(root_path))) {
+			path += strlen(root_path);
+			if (path[0] == '/')
+				path++;
+		}
+	}
+	path = fix_path(path);
+	if (!strcmp(file + strlen(file) - strlen(DTD_SUBFIX), DTD_SUBFIX)) {
+		if (!*foundFdt) {
+			/* use default path. */
+			LOGD("mod fdt path:%s -> %s...", file, FDT_PATH);
+			path = FDT_PATH;
+			*foundFdt = true;
+		}
+	}
+
+	return path;
+}
+
+/*
+ * Parse the adc conditions of a hwid dtb name the way U-Boot does, i.e.
+ * ...#_[controller]_ch[channel]=[value]...dtb. Returns false if U-Boot
+ * would not take the name, so none of its adc conditions can match.
+ */
+static bool parse_hwid_adc(const char *name, hwid_index_dtb *dtb)
+{
+	const char *cell, *tail, *p;
+	hwid_index_cond *cond;
+	size_t len;
+
+	if (!strstr(name, HWID_KEY_ADC_CTRL) || !strstr(name, HWID_KEY_ADC_CH))
+		return false;
+
+	cell = strstr(name, HWID_KEY_ADC_CTRL);
+	while (cell) {
+		tail = strstr(cell, HWID_KEY_ADC_CH);
+		if (!tail || dtb->nr_conds >= HWID_INDEX_MAX_CONDS)
+			return false;
+		len = tail - cell - strlen(HWID_KEY_ADC_CTRL);
+		if (len >= sizeof(cond->adc_ctrl))
+			return false;
+
+		p = tail + strlen(HWID_KEY_ADC_CH);
+		if (!(p[0] >= '0' && p[0] <= '9' && p[1] == '='))
+			return false;
+
+		cond = &dtb->conds[dtb->nr_conds++];
+		memcpy(cond->adc_ctrl, cell + strlen(HWID_KEY_ADC_CTRL), len);
+		cond->type = HWID_COND_ADC;
+		cond->id = p[0] - '0';
+		cond->value = switch_int(strtoul(p + 2, NULL, 10));
+
+		p += 2;
+		while (*p >= '0' && *p <= '9')
+			p++;
+		cell = strstr(p, HWID_KEY_ADC_CTRL);
+	}
+
+	return true;
+}
+
+/* Same for the gpio conditions, ...#gpio[pin]=[level]...dtb */
+static bool parse_hwid_gpio(const char *name, hwid_index_dtb *dtb)
+{
+	const char *cell, *p;
+	hwid_index_cond *cond;
+
+	cell = strstr(name, HWID_KEY_GPIO);
+	if (!cell)
+		return false;
+
+	while (cell) {
+		p = cell + strlen(HWID_KEY_GPIO);
+		if (!(p[0] >= '0' && p[0] <= '9' && p[1] >= 'a' && p[1] <= 'd' &&
+		      p[2] >= '0' && p[2] <= '9' && p[3] == '=' &&
+		      p[4] >= '0' && p[4] <= '9'))
+			return false;
+		if (dtb->nr_conds >= HWID_INDEX_MAX_CONDS ||
+		    p[2] - '0' > 7)
+			return false;
+
+		cond = &dtb->conds[dtb->nr_conds++];
+		cond->type = HWID_COND_GPIO;
+		cond->id = p[0] - '0';
+		cond->bank = p[1] - 'a';
+		cond->pin = p[2] - '0';
+		cond->value = switch_int(p[4] - '0');
+		cell = strstr(p, HWID_KEY_GPIO);
+	}
+
+	return true;
+}
+
+/*
+ * Build the hwid index of the dtbs in @files, in table order like U-Boot
+ * probes them. Returns the index size, 0 if there is no hwid dtb.
+ */
+static size_t build_hwid_index(const int file_num, const char **files,
+			       void **index)
+{
+	hwid_index_header *hdr;
+	hwid_index_dtb *dtb, tmp;
+	bool foundFdt = false;
+	const char *path;
+	int i, nr = 0;
+	bool adc, gpio;
+
+	hdr = calloc(1, sizeof(*hdr) + file_num * sizeof(*dtb));
+	if (!hdr)
+		return 0;
+	dtb = (hwid_index_dtb *)(hdr + 1);
+
+	for (i = 0; i < file_num; i++) {
+		path = get_entry_path(files[i], &foundFdt);
+		if (strcmp(path + strlen(path) - strlen(DTD_SUBFIX), DTD_SUBFIX))
+			continue;
+
+		/* Conditions that can't match are dropped by type */
+		memset(&tmp, 0, sizeof(tmp));
+		adc = parse_hwid_adc(path, &tmp);
+		if (!adc)
+			tmp.nr_conds = 0;
+		gpio = parse_hwid_gpio(path, &tmp);
+		if (!gpio) {
+			int j, n = 0;
+
+			for (j = 0; j < tmp.nr_conds; j++) {
+				if (tmp.conds[j].type == HWID_COND_ADC)
+					tmp.conds[n++] = tmp.conds[j];
+			}
+			tmp.nr_conds = n;
+		}
+		if (!tmp.nr_conds)
+			continue;
+
+		snprintf(tmp.name, sizeof(tmp.name), "%s", path);
+		LOGD("hwid dtb:%s, conds:%d", tmp.name, tmp.nr_conds);
+		tmp.nr_conds = switch_int(tmp.nr_conds);
+		dtb[nr++] = tmp;
+	}
+
+	if (!nr) {
+		free(hdr);
+		return 0;
+	}
+
+	memcpy(hdr->magic, HWID_INDEX_MAGIC, sizeof(hdr->magic));
+	hdr->version = switch_short(HWID_INDEX_VERSION);
+	hdr->nr_dtbs = switch_short(nr);
+	*index = hdr;
+
+	return sizeof(*hdr) + nr * sizeof(*dtb);
+}
+
 static bool write_header(const int file_num)
 {
 	LOGD("try to write header...");
@@ -1470,7 +1755,8 @@ static bool write_header(const int file_num)
 	return write_data(0, &hdr, sizeof(hdr));
 }
 
-static bool write_index_tbl(const int file_num, const char **files)
+static bool write_index_tbl(const int file_num, const char **files,
+			    void *hwid_index, size_t hwid_index_size)
 {
 	LOGD("try to write index table...");
 	bool ret = false;
@@ -1479,57 +1765,73 @@ static bool write_index_tbl(const int file_num, const char **files)
 	        header.header_size + header.tbl_entry_size * header.tbl_entry_num;
 	index_tbl_entry entry;
 	char hash[20];	/* sha1 */
-	int i;
+	hash_job *jobs;
+	int i, slot = 0;
 
 	memcpy(entry.tag, INDEX_TBL_ENTR_TAG, sizeof(entry.tag));
-	for (i = 0; i < file_num; i++) {
+
+	jobs = calloc(file_num ? file_num : 1, sizeof(*jobs));
+	if (!jobs || !hash_files(file_num, files, jobs))
+		goto end;
+
+	/* The hwid index goes first, so U-Boot reads it with the table */
+	if (hwid_index_size) {
+		if (!write_data(offset, hwid_index, hwid_index_size))
+			goto end;
+
+		sha1_csum((const unsigned char *)hwid_index, hwid_index_size,
+			  (unsigned char *)hash);
+		memcpy(entry.hash, hash, sizeof(hash));
+		entry.hash_size = sizeof(hash);
+		entry.content_size = hwid_index_size;
+		entry.content_offset = offset;
+		fix_entry(&entry);
+		memset(entry.path, 0, sizeof(entry.path));
+		snprintf(entry.path, sizeof(entry.path), "%s", HWID_INDEX_FILE);
+		offset += fix_blocks(hwid_index_size);
+		if (!write_data(header.header_size, &entry, sizeof(entry)))
+			goto end;
+		slot++;
+	}
+
+	for (i = 0; i < file_num; i++, slot++) {
 		size_t file_size = get_file_size(files[i]);
 		if (file_size < 0)
 			goto end;
 		entry.content_size = file_size;
 		entry.content_offset = offset;
 
-		if (write_file(offset, files[i], hash, sizeof(hash)) < 0)
+		if ((size_t)jobs[i].ret != file_size) {
+			LOGE("%s changed while packing", files[i]);
+			goto end;
+		}
+		if (write_file(offset, files[i], NULL, 0) < 0)
 			goto end;
 
-		memcpy(entry.hash, hash, sizeof(hash));
-		entry.hash_size = sizeof(hash);
+		memcpy(entry.hash, jobs[i].hash, sizeof(jobs[i].hash));
+		entry.hash_size = sizeof(jobs[i].hash);
 
 		LOGD("try to write index entry(%s)...", files[i]);
 
 		/* switch for le. */
 		fix_entry(&entry);
 		memset(entry.path, 0, sizeof(entry.path));
-		const char *path = files[i];
-		if (root_path[0]) {
-			if (!strncmp(path, root_path, strlen(root_path))) {
-				path += strlen(root_path);
-				if (path[0] == '/')
-					path++;
-			}
-		}
-		path = fix_path(path);
-		if (!strcmp(files[i] + strlen(files[i]) - strlen(DTD_SUBFIX), DTD_SUBFIX)) {
-			if (!foundFdt) {
-				/* use default path. */
-				LOGD("mod fdt path:%s -> %s...", files[i], FDT_PATH);
-				path = FDT_PATH;
-				foundFdt = true;
-			}
-		}
+		const char *path = get_entry_path(files[i], &foundFdt);
 		snprintf(entry.path, sizeof(entry.path), "%s", path);
 		offset += fix_blocks(file_size);
-		if (!write_data(header.header_size + i * header.tbl_entry_size, &entry,
+		if (!write_data(header.header_size + slot * header.tbl_entry_size, &entry,
 		                sizeof(entry)))
 			goto end;
 	}
 	ret = true;
 end:
+	free(jobs);
 	return ret;
 }
 
 static int pack_image(int file_num, const char **files)
 {
+	void *hwid_index = NULL;
 	bool ret = false;
 	FILE *image_file = fopen(image_path, "wb");
 	if (!image_file) {
@@ -1542,6 +1844,7 @@ static int pack_image(int file_num, const char **files)
 	int i = 0;
 	int pos = 0;
 	const char *tmp;
+	size_t hwid_index_size;
 	for (i = 0; i < file_num; i++) {
 		if (!strcmp(files[i] + strlen(files[i]) - strlen(DTD_SUBFIX), DTD_SUBFIX)) {
 			/* dtb files for kernel. */
@@ -1558,17 +1861,20 @@ static int pack_image(int file_num, const char **files)
 		}
 	}
 
-	if (!write_header(file_num)) {
+	hwid_index_size = build_hwid_index(file_num, files, &hwid_index);
+
+	if (!write_header(file_num + !!hwid_index_size)) {
 		LOGE("Failed to write header!");
 		goto end;
 	}
-	if (!write_index_tbl(file_num, files)) {
+	if (!write_index_tbl(file_num, files, hwid_index, hwid_index_size)) {
 		LOGE("Failed to write index table!");
 		goto end;
 	}
 	printf("Pack to %s successed!\n", image_path);
 	ret = true;
 end:
+	free(hwid_index);
 	return ret ? 0 : -1;
 }
 
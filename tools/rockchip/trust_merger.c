@@ -6,6 +6,7 @@
  *
  * SPDX-License-Identifier:	GPL-2.0+
  */
+#include <pthread.h>
 #include <sys/stat.h>
 #include <u-boot/sha256.h>
 #include "trust_merger.h"
@@ -524,6 +525,21 @@ static bool bl3xHash256(uint8_t *pHash, uint8_t *pData, uint32_t nDataSize)
 	return true;
 }
 
+/* The bl3x images of a trust are hashed at the same time, one per thread */
+typedef struct {
+	uint8_t *pHash;
+	uint8_t *pData;
+	uint32_t nDataSize;
+} bl3x_hash_job;
+
+static void *bl3xHashThread(void *arg)
+{
+	bl3x_hash_job *job = arg;
+
+	bl3xHash256(job->pHash, job->pData, job->nDataSize);
+	return NULL;
+}
+
 static bool mergetrust(void)
 {
 	FILE *outFile = NULL;
@@ -671,32 +687,46 @@ static bool mergetrust(void)
 	memcpy(pbuf, gBuf, TRUST_HEADER_SIZE);
 	pbuf += TRUST_HEADER_SIZE;
 
-	uint8_t *pHashData = NULL;
+	bl3x_hash_job hashJobs[32];
+	pthread_t hashThreads[32];
+	bool hashThreaded[32];
 	pComponentData = (COMPONENT_DATA *)(outBuf + sizeof(TRUST_HEADER));
 
-	/* save trust bl3x bin */
+	/* save trust bl3x bin, straight into its place in outBuf */
 	pEntry = (bl_entry_t *)pMetaBuf;
 	for (i = 0; i < nComponentNum; i++) {
 		FILE *inFile = fopen(pEntry->path, "rb");
 		if (!inFile)
 			goto end;
 
-		memset(gBuf, 0, pEntry->align_size);
 		fseek(inFile, pEntry->offset, SEEK_SET);
-		if (!fread(gBuf, pEntry->size, 1, inFile))
+		if (!fread(pbuf, pEntry->size, 1, inFile)) {
+			fclose(inFile);
 			goto end;
+		}
 		fclose(inFile);
 
-		/* bl3x bin hash256 */
-		pHashData = (uint8_t *)&pComponentData->HashData[0];
-		bl3xHash256(pHashData, gBuf, pEntry->align_size);
-		memcpy(pbuf, gBuf, pEntry->align_size);
+		hashJobs[i].pHash = (uint8_t *)&pComponentData->HashData[0];
+		hashJobs[i].pData = pbuf;
+		hashJobs[i].nDataSize = pEntry->align_size;
 
 		pComponentData++;
 		pbuf += pEntry->align_size;
 		pEntry++;
 	}
 
+	/* bl3x bin hash256, hashed inline if a thread can't be started */
+	for (i = 0; i < nComponentNum; i++) {
+		hashThreaded[i] = !pthread_create(&hashThreads[i], NULL,
+						  bl3xHashThread, &hashJobs[i]);
+		if (!hashThreaded[i])
+			bl3xHashThread(&hashJobs[i]);
+	}
+	for (i = 0; i < nComponentNum; i++) {
+		if (hashThreaded[i])
+			pthread_join(hashThreads[i], NULL);
+	}
+
 	/* copy other (g_trust_max_num - 1) backup bin */
 	for (n = 1; n < g_trust_max_num; n++) {
 		memcpy(outBuf + g_trust_max_size * n, outBuf, g_trust_max_size);